@@ -0,0 +1,86 @@
+// Repository: Retrovue-playout
+// Component: Asset Registry
+// Purpose: Interns asset URIs into small integer ids carried by frame metadata.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_ASSET_REGISTRY_H_
+#define RETROVUE_BUFFER_ASSET_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace retrovue::buffer
+{
+
+  // AssetId names an interned asset URI; kNoAsset is the empty URI.
+  using AssetId = uint32_t;
+  constexpr AssetId kNoAsset = 0;
+
+  // AssetRegistry maps asset URIs to ids and back. Producers intern their
+  // URI once, when configured, and stamp the id on every frame, so frame
+  // metadata never copies a string. Ids stay valid for the life of the
+  // process: the registry grows by one entry per distinct URI played.
+  //
+  // Thread Model: thread-safe; lookups take a lock, so keep them off the
+  // per-frame path.
+  class AssetRegistry
+  {
+  public:
+    static AssetRegistry &Global()
+    {
+      static AssetRegistry *registry = new AssetRegistry();  // Outlives static destructors
+      return *registry;
+    }
+
+    AssetId Intern(const std::string &uri)
+    {
+      if (uri.empty())
+      {
+        return kNoAsset;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto found = ids_.find(uri);
+      if (found != ids_.end())
+      {
+        return found->second;
+      }
+      uris_.push_back(uri);
+      const auto id = static_cast<AssetId>(uris_.size());
+      ids_.emplace(uri, id);
+      return id;
+    }
+
+    // The URI of id; empty for kNoAsset and unknown ids.
+    std::string Uri(AssetId id) const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (id == kNoAsset || id > uris_.size())
+      {
+        return std::string();
+      }
+      return uris_[id - 1];
+    }
+
+    size_t size() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return uris_.size();
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, AssetId> ids_;
+    std::deque<std::string> uris_;  // uris_[id - 1]
+  };
+
+  inline AssetId InternAsset(const std::string &uri) { return AssetRegistry::Global().Intern(uri); }
+
+  inline std::string AssetUri(AssetId id) { return AssetRegistry::Global().Uri(id); }
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_ASSET_REGISTRY_H_
@@ -0,0 +1,140 @@
+// Repository: Retrovue-playout
+// Component: Channel Arena
+// Purpose: Channel-local allocator for frame and decoded picture memory.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_CHANNEL_ARENA_H_
+#define RETROVUE_BUFFER_CHANNEL_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace retrovue::buffer
+{
+
+  // ChannelArenaStats is a point-in-time view of a ChannelArena.
+  struct ChannelArenaStats
+  {
+    uint64_t bytes_in_use = 0;       // Held by live blocks (rounded sizes)
+    uint64_t bytes_cached = 0;       // Freed blocks kept for reuse
+    uint64_t peak_bytes_in_use = 0;
+    uint64_t allocations = 0;        // Blocks taken from the system
+    uint64_t reuses = 0;             // Allocations served from the cache
+    uint64_t unshared_allocations = 0;  // Blocks a shared region had no room for
+    bool released = false;           // Release() was called
+  };
+
+  // ChannelArena is the memory of one channel: its frame pools and the
+  // pictures its decoders write. Blocks are recycled by size within the
+  // channel, so channels never contend on the process allocator's locks,
+  // and large blocks are mapped on their own (mmap), so freeing them hands
+  // the pages straight back instead of leaving holes in a shared heap that
+  // fragment it over weeks of uptime.
+  //
+  // Design:
+  // - Sizes round up to a power of two below kMapThreshold, to a multiple
+  //   of it above; freed blocks wait in a free list per rounded size
+  // - Cached bytes are capped; blocks freed beyond the cap return to the system
+  // - Release() (channel stopped) frees the cache and stops caching, so
+  //   blocks still referenced (frames a sink holds) go back as they are freed
+  // - Every block records its arena: Free() needs no allocator state, and
+  //   the arena stays alive until its last block is freed
+  // - A shared arena (CreateShared()) maps its large blocks from one memfd
+  //   region instead, so a process handed SharedFd() can map the channel's
+  //   frames and read them in place (see SharedFrameExport); pages of blocks
+  //   given back to the region are punched out of the file
+  //
+  // Thread Model:
+  // - All methods are thread-safe; blocks may be freed on any thread
+  class ChannelArena : public std::enable_shared_from_this<ChannelArena>
+  {
+  public:
+    // Blocks start on this boundary
+    static constexpr size_t kAlignment = 64;
+    // Blocks from this size up are mapped separately
+    static constexpr size_t kMapThreshold = 64 * 1024;
+    static constexpr size_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+    static std::shared_ptr<ChannelArena> Create(
+        size_t max_cached_bytes = kDefaultMaxCachedBytes);
+
+    // Creates a shared arena over a memfd region of region_bytes (pages are
+    // only committed as blocks are written), the first front_bytes of which
+    // are left to the caller at SharedFront(). Blocks that do not fit are
+    // mapped privately. Null if the region cannot be created (not Linux,
+    // memfd unavailable).
+    static std::shared_ptr<ChannelArena> CreateShared(
+        size_t region_bytes, size_t front_bytes,
+        size_t max_cached_bytes = kDefaultMaxCachedBytes);
+
+    ~ChannelArena();
+
+    ChannelArena(const ChannelArena &) = delete;
+    ChannelArena &operator=(const ChannelArena &) = delete;
+
+    // Returns a kAlignment-aligned block of at least bytes, or nullptr if
+    // the system is out of memory.
+    void *Allocate(size_t bytes);
+
+    // Frees a block from Allocate() of any arena (nullptr is ignored).
+    static void Free(void *block);
+
+    // Returns cached blocks to the system.
+    void Trim();
+
+    // Trims, and frees blocks straight to the system from now on.
+    void Release();
+
+    ChannelArenaStats GetStats() const;
+
+    // The size a request of bytes is served with.
+    static size_t RoundedSize(size_t bytes);
+
+    // Shared arenas: the region's memfd (-1 for others), its size, and the
+    // caller's front_bytes (rounded up to pages) at its start.
+    int SharedFd() const { return region_fd_; }
+    size_t SharedBytes() const { return region_bytes_; }
+    void *SharedFront() const { return region_base_; }
+    size_t SharedFrontBytes() const { return region_front_; }
+
+    // Offset of p in the shared region, or -1 if it is not in it.
+    int64_t SharedOffset(const void *p) const;
+
+  private:
+    struct BlockHeader;
+
+    explicit ChannelArena(size_t max_cached_bytes);
+
+    // Takes a block of a rounded size from the region or the system, and
+    // gives it back.
+    BlockHeader *MapBlock(size_t size);
+    void UnmapBlock(BlockHeader *header);
+
+    // First fit of bytes in the region (-1 if none), and its return.
+    int64_t TakeRegion(size_t bytes);
+    void ReturnRegion(size_t offset, size_t bytes);
+
+    const size_t max_cached_bytes_;
+
+    mutable std::mutex mutex_;
+    std::map<size_t, std::vector<BlockHeader *>> free_blocks_;  // Rounded size -> blocks
+    size_t live_blocks_ = 0;
+    std::shared_ptr<ChannelArena> self_;  // Set while live_blocks_ > 0
+    ChannelArenaStats stats_;
+
+    // Shared region (set once by CreateShared())
+    int region_fd_ = -1;
+    uint8_t *region_base_ = nullptr;
+    size_t region_bytes_ = 0;
+    size_t region_front_ = 0;
+    std::mutex region_mutex_;
+    std::map<size_t, size_t> region_free_;  // Offset -> bytes, coalesced
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_CHANNEL_ARENA_H_
@@ -0,0 +1,351 @@
+// Repository: Retrovue-playout
+// Component: Frame Types
+// Purpose: Decoded video and audio frame structures shared across the pipeline.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_FRAME_H_
+#define RETROVUE_BUFFER_FRAME_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "retrovue/buffer/AssetRegistry.h"
+#include "retrovue/buffer/ChannelArena.h"
+
+namespace retrovue::buffer
+{
+
+  // FrameStage is a point on a frame's way from the file to the wire.
+  enum class FrameStage : uint8_t
+  {
+    kDemuxed,      // Its packet was read from the container
+    kDecoded,      // The decoder returned it
+    kScaled,       // Scaled and packed into its buffer frame
+    kPushed,       // Pushed into the channel's ring buffer
+    kPopped,       // Popped by the consumer (renderer or sink)
+    kEncodeStart,  // The output stage (encoder, or the renderer's present) took it
+    kEncodeEnd,    // ... and was done with it
+    kSent,         // The first TS bytes muxed after it reached the outputs
+  };
+  constexpr size_t kFrameStageCount = 8;
+
+  inline const char *FrameStageName(FrameStage stage)
+  {
+    switch (stage)
+    {
+      case FrameStage::kDemuxed: return "demuxed";
+      case FrameStage::kDecoded: return "decoded";
+      case FrameStage::kScaled: return "scaled";
+      case FrameStage::kPushed: return "pushed";
+      case FrameStage::kPopped: return "popped";
+      case FrameStage::kEncodeStart: return "encode_start";
+      case FrameStage::kEncodeEnd: return "encode_end";
+      case FrameStage::kSent: return "sent";
+    }
+    return "";
+  }
+
+  // FrameTrace holds the stage times of a sampled frame: the low 32 bits of
+  // the steady clock in microseconds (0 = stage not reached), which wrap
+  // every ~71 minutes, so take differences with StageDeltaUs(). A frame is
+  // sampled once its demux time is marked; marks on frames that are not
+  // sampled cost a branch.
+  struct FrameTrace
+  {
+    std::array<uint32_t, kFrameStageCount> stage_us{};
+
+    bool sampled() const { return At(FrameStage::kDemuxed) != 0; }
+
+    void Mark(FrameStage stage)
+    {
+      if (sampled())
+      {
+        MarkAt(stage, NowUs());
+      }
+    }
+    void MarkAt(FrameStage stage, int64_t at_us)
+    {
+      const auto low = static_cast<uint32_t>(at_us);
+      stage_us[static_cast<size_t>(stage)] = (at_us != 0 && low == 0) ? 1 : low;
+    }
+    uint32_t At(FrameStage stage) const { return stage_us[static_cast<size_t>(stage)]; }
+
+    // Microseconds from stage time from_us to to_us (negative if earlier).
+    static int64_t StageDeltaUs(uint32_t from_us, uint32_t to_us)
+    {
+      return static_cast<int32_t>(to_us - from_us);
+    }
+
+    static int64_t NowUs()
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    }
+  };
+
+  // FrameMetadata carries timing and provenance information for a decoded
+  // frame. It is trivially copyable and fits one cache line, so pushing,
+  // popping and copying frames never allocates for it; the source asset is
+  // an id interned in AssetRegistry (AssetUri() resolves it).
+  struct FrameMetadata
+  {
+    int64_t pts = 0;            // Presentation timestamp (in stream timebase units)
+    int64_t dts = 0;            // Decode timestamp (in stream timebase units)
+    double duration = 0.0;      // Frame duration in seconds
+    FrameTrace trace;           // Stage times, on the frames the producer samples
+    AssetId asset_id = kNoAsset; // Source asset
+    bool splice_point = false;  // First frame of a producer switched in (encoded as an IDR)
+    bool asset_start = false;   // First frame of the asset, aired from its start
+    bool keyframe = false;      // Compressed frames: a random access point (IDR)
+
+    FrameMetadata() = default;
+
+    FrameMetadata(int64_t p, int64_t d, double dur, AssetId asset)
+        : pts(p), dts(d), duration(dur), asset_id(asset) {}
+  };
+  static_assert(std::is_trivially_copyable_v<FrameMetadata>,
+                "FrameMetadata is copied per frame and must not allocate");
+  static_assert(sizeof(FrameMetadata) <= 64, "FrameMetadata should fit one cache line");
+
+  // PixelFormat is the sample layout of a frame's planes (all 4:2:0), kH264
+  // for a frame passed through compressed, or kDevice for a picture left in
+  // GPU memory.
+  enum class PixelFormat : uint8_t
+  {
+    kI420,  // 8-bit Y, U and V planes
+    kNV12,  // 8-bit Y plane and interleaved UV plane
+    kP010,  // 16-bit little-endian Y and interleaved UV, 10 bits in the high bits
+    kH264,  // No planes: data holds one Annex B access unit (see metadata.keyframe)
+    kDevice,  // No planes: surface holds the decoder's GPU surface
+  };
+
+  inline const char *PixelFormatName(PixelFormat format)
+  {
+    switch (format)
+    {
+      case PixelFormat::kI420: return "i420";
+      case PixelFormat::kNV12: return "nv12";
+      case PixelFormat::kP010: return "p010";
+      case PixelFormat::kH264: return "h264";
+      case PixelFormat::kDevice: return "device";
+    }
+    return "";
+  }
+
+  inline int PixelFormatPlanes(PixelFormat format)
+  {
+    switch (format)
+    {
+      case PixelFormat::kI420: return 3;
+      case PixelFormat::kNV12: return 2;
+      case PixelFormat::kP010: return 2;
+      case PixelFormat::kH264: return 0;
+      case PixelFormat::kDevice: return 0;
+    }
+    return 0;
+  }
+
+  // Plane starts and row strides of laid out frames are multiples of this,
+  // so SIMD kernels and encoders can use aligned loads on every row.
+  constexpr size_t kFrameAlignment = 64;
+  static_assert(ChannelArena::kAlignment % kFrameAlignment == 0,
+                "arena blocks must be aligned for frames");
+
+  // FrameAllocator hands out kFrameAlignment-aligned frame storage, from a
+  // channel's arena or (without one) the process heap. The arena travels
+  // with the storage when frames are moved or swapped, so a pooled frame
+  // always frees into the arena it came from.
+  template <typename T>
+  struct FrameAllocator
+  {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    // Moves copy: a moved-from frame keeps allocating from its arena
+    FrameAllocator() = default;
+    FrameAllocator(const FrameAllocator &) = default;
+    FrameAllocator &operator=(const FrameAllocator &) = default;
+    explicit FrameAllocator(std::shared_ptr<ChannelArena> channel_arena)
+        : arena(std::move(channel_arena)) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n)
+    {
+      if (!arena)
+      {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{kFrameAlignment}));
+      }
+      void *block = arena->Allocate(n * sizeof(T));
+      if (!block)
+      {
+        throw std::bad_alloc();
+      }
+      return static_cast<T *>(block);
+    }
+    void deallocate(T *p, size_t /*n*/)
+    {
+      if (arena)
+      {
+        ChannelArena::Free(p);
+        return;
+      }
+      ::operator delete(p, std::align_val_t{kFrameAlignment});
+    }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U> &other) const { return arena != other.arena; }
+
+    std::shared_ptr<ChannelArena> arena;  // Null = process heap
+  };
+
+  using FrameBytes = std::vector<uint8_t, FrameAllocator<uint8_t>>;
+
+  // FramePlane locates one plane in a frame's data. Offsets rather than
+  // pointers, so frames stay valid when copied.
+  struct FramePlane
+  {
+    size_t offset = 0;
+    int stride = 0;  // Bytes per row
+  };
+
+  // DeviceSurface is a decoded picture in GPU memory (VAAPI, CUDA or QSV),
+  // defined with FFmpeg in decode/DeviceFrames.h. It goes back to its
+  // decoder's surface pool when the last frame holding it lets go.
+  struct DeviceSurface;
+
+  // Frame holds the actual decoded frame data along with metadata. The
+  // planes of format live in data at planes[i]; Layout() places them. A
+  // frame whose planes were never laid out (stride 0) holds tightly packed
+  // I420, the layout producers wrote before planes were described.
+  struct Frame
+  {
+    FrameMetadata metadata;
+    FrameBytes data;  // Storage of the planes
+    int width;
+    int height;
+    PixelFormat format;
+    std::array<FramePlane, 3> planes;
+    std::shared_ptr<const DeviceSurface> surface;  // kDevice only; shared by copies
+
+    Frame() : width(0), height(0), format(PixelFormat::kI420) {}
+
+    // Sets format and size and places the planes, each row starting on an
+    // alignment boundary (1 = tightly packed); data grows to fit, and a
+    // pooled frame's reserve means it does not reallocate. Lets go of any
+    // surface.
+    void Layout(PixelFormat pixel_format, int frame_width, int frame_height,
+                size_t alignment = kFrameAlignment)
+    {
+      surface.reset();
+      format = pixel_format;
+      width = frame_width;
+      height = frame_height;
+      size_t offset = 0;
+      for (int i = 0; i < 3; ++i)
+      {
+        if (i >= PixelFormatPlanes(format))
+        {
+          planes[i] = FramePlane();
+          continue;
+        }
+        const size_t row_bytes = PlaneRowBytes(format, i, width);
+        const size_t stride = (row_bytes + alignment - 1) / alignment * alignment;
+        planes[i].offset = offset;
+        planes[i].stride = static_cast<int>(stride);
+        offset += stride * static_cast<size_t>(PlaneRows(i, height));
+      }
+      data.resize(offset);
+    }
+
+    uint8_t *Plane(int i) { return data.data() + PlaneOffset(i); }
+    const uint8_t *Plane(int i) const { return data.data() + PlaneOffset(i); }
+
+    int Stride(int i) const
+    {
+      if (planes[0].stride != 0)
+      {
+        return planes[i].stride;
+      }
+      return i == 0 ? width : width / 2;
+    }
+
+    // Bytes data must hold for the planes the layout describes.
+    size_t LayoutBytes() const
+    {
+      size_t bytes = 0;
+      for (int i = 0; i < PixelFormatPlanes(format); ++i)
+      {
+        bytes = std::max(bytes, PlaneOffset(i) + static_cast<size_t>(Stride(i)) *
+                                                     static_cast<size_t>(PlaneRows(i, height)));
+      }
+      return bytes;
+    }
+
+    // Bytes Layout() sizes data to for a format and size.
+    static size_t LayoutBytes(PixelFormat pixel_format, int frame_width, int frame_height,
+                              size_t alignment = kFrameAlignment)
+    {
+      size_t bytes = 0;
+      for (int i = 0; i < PixelFormatPlanes(pixel_format); ++i)
+      {
+        const size_t row_bytes = PlaneRowBytes(pixel_format, i, frame_width);
+        bytes += (row_bytes + alignment - 1) / alignment * alignment *
+                 static_cast<size_t>(PlaneRows(i, frame_height));
+      }
+      return bytes;
+    }
+
+    // Meaningful bytes in a row of plane i (samples times sample size).
+    static size_t PlaneRowBytes(PixelFormat pixel_format, int i, int frame_width)
+    {
+      const size_t sample_bytes = pixel_format == PixelFormat::kP010 ? 2 : 1;
+      if (i == 0)
+      {
+        return static_cast<size_t>(frame_width) * sample_bytes;
+      }
+      const size_t chroma_width = static_cast<size_t>(frame_width / 2);
+      return pixel_format == PixelFormat::kI420 ? chroma_width : 2 * chroma_width * sample_bytes;
+    }
+
+    static int PlaneRows(int i, int frame_height) { return i == 0 ? frame_height : frame_height / 2; }
+
+  private:
+    size_t PlaneOffset(int i) const
+    {
+      if (planes[0].stride != 0)
+      {
+        return planes[i].offset;
+      }
+      const size_t luma = static_cast<size_t>(width) * height;
+      return i == 0 ? 0 : luma + (i == 2 ? static_cast<size_t>(width / 2) * (height / 2) : 0);
+    }
+  };
+
+  // AudioFrame holds decoded audio samples (PCM) along with timing metadata.
+  struct AudioFrame
+  {
+    std::vector<uint8_t> data;   // PCM samples (interleaved, S16 format)
+    int sample_rate;             // Sample rate (e.g., 48000)
+    int channels;                // Number of channels (e.g., 2 for stereo)
+    int64_t pts_us;              // Presentation timestamp in microseconds
+    int nb_samples;              // Number of PCM samples in this frame
+
+    AudioFrame() : sample_rate(0), channels(0), pts_us(0), nb_samples(0) {}
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_FRAME_H_
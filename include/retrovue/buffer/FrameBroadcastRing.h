@@ -0,0 +1,116 @@
+// Repository: Retrovue-playout
+// Component: Frame Broadcast Ring
+// Purpose: Single-producer, multi-consumer ring that fans decoded frames out to N readers.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_FRAME_BROADCAST_RING_H_
+#define RETROVUE_BUFFER_FRAME_BROADCAST_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/buffer/FramePool.h"
+
+namespace retrovue::buffer
+{
+
+  // FrameBroadcastRing lets several consumers read the same decoded frames.
+  //
+  // Design:
+  // - Fixed-size circular buffer of FrameHandles (default: 60 frames)
+  // - One writer cursor and up to max_readers independent reader cursors
+  // - Readers receive a new reference to the shared frame; payloads are never copied
+  // - The slowest active reader sets backpressure: Push() fails when it is a full
+  //   buffer behind the writer
+  // - Sequence numbers are 64-bit and never wrap, so full/empty need no spare slot
+  //
+  // Thread Model:
+  // - Single producer (decode thread)
+  // - One thread per reader id (renderer, TS sink, recorder, ...)
+  // - AddReader()/RemoveReader() may be called while the producer is running
+  //
+  // Pool sizing: a slot keeps its frame referenced until the writer reuses it,
+  // so a producer FramePool needs capacity + one slot per reader + one in flight.
+  class FrameBroadcastRing
+  {
+  public:
+    static constexpr int kInvalidReader = -1;
+
+    // Constructs a broadcast ring with the given capacity and reader limit.
+    explicit FrameBroadcastRing(size_t capacity = 60, size_t max_readers = 4);
+
+    ~FrameBroadcastRing();
+
+    // Disable copy and move
+    FrameBroadcastRing(const FrameBroadcastRing &) = delete;
+    FrameBroadcastRing &operator=(const FrameBroadcastRing &) = delete;
+
+    // Registers a reader whose cursor starts at the current write position
+    // (it sees frames pushed from now on). Returns kInvalidReader if all
+    // reader slots are in use.
+    int AddReader();
+
+    // Unregisters a reader. Its cursor no longer holds back the producer.
+    void RemoveReader(int reader_id);
+
+    // Attempts to publish a frame to all readers.
+    // Returns true if successful, false if the slowest reader is a full buffer behind
+    // (the caller keeps the handle).
+    // Thread-safe for single producer.
+    bool Push(FrameHandle &&handle);
+
+    // Attempts to publish a by-value frame (copied once into an unpooled handle).
+    bool Push(const Frame &frame);
+
+    // Attempts to read the next frame for reader_id.
+    // Returns true if successful, false if the reader has consumed everything.
+    // Thread-safe for the thread owning reader_id.
+    bool Pop(int reader_id, FrameHandle &handle);
+
+    // Peeks at the next frame for reader_id without advancing its cursor.
+    // Returns nullptr if nothing is pending.
+    const Frame *Peek(int reader_id) const;
+
+    // Returns the number of frames pending for reader_id.
+    size_t Size(int reader_id) const;
+
+    // Returns the number of frames held back by the slowest active reader.
+    size_t MaxLag() const;
+
+    // Returns the maximum number of frames the ring can hold.
+    size_t Capacity() const { return capacity_; }
+
+    // Returns true if the slowest active reader blocks further pushes.
+    bool IsFull() const;
+
+    // Returns the number of registered readers.
+    size_t ReaderCount() const;
+
+  private:
+    // Each cursor lives on its own cache line so readers do not false-share.
+    struct alignas(64) ReaderCursor
+    {
+      std::atomic<uint64_t> read_seq{0};
+      std::atomic<bool> active{false};
+    };
+
+    bool IsValidReader(int reader_id) const;
+
+    // Returns the smallest read sequence among active readers, or the write
+    // sequence when no reader is registered.
+    uint64_t MinReadSeq(uint64_t write_seq) const;
+
+    const size_t capacity_;
+    const size_t max_readers_;
+    std::unique_ptr<FrameHandle[]> slots_;
+    std::unique_ptr<ReaderCursor[]> readers_;
+
+    alignas(64) std::atomic<uint64_t> write_seq_;
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_FRAME_BROADCAST_RING_H_
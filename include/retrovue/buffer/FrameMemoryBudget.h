@@ -0,0 +1,74 @@
+// Repository: Retrovue-playout
+// Component: Frame Memory Budget
+// Purpose: Process-wide cap on the frame memory reserved by channel buffers.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_FRAME_MEMORY_BUDGET_H_
+#define RETROVUE_BUFFER_FRAME_MEMORY_BUDGET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace retrovue::buffer
+{
+
+  // Bytes of one decoded YUV420 frame.
+  constexpr size_t Yuv420FrameBytes(int width, int height)
+  {
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * 3 / 2;
+  }
+
+  // Frames needed to hold latency_ms of video at fps (rounded up, at least 1).
+  size_t DepthForLatency(int64_t latency_ms, double fps);
+
+  // FrameMemoryBudgetStats is a snapshot of a FrameMemoryBudget.
+  struct FrameMemoryBudgetStats
+  {
+    size_t limit_bytes = 0;     // 0 = unlimited
+    size_t reserved_bytes = 0;  // Held by current reservations
+    uint64_t refusals = 0;      // Reservations that did not fit
+  };
+
+  // FrameMemoryBudget accounts the frame memory channels reserve for their
+  // buffers against one process-wide limit, so adding a channel or deepening
+  // a buffer fails up front instead of exhausting host memory later.
+  //
+  // Thread Model:
+  // - All methods are thread-safe
+  class FrameMemoryBudget
+  {
+  public:
+    // limit_bytes: total frame memory channels may reserve (0 = unlimited)
+    explicit FrameMemoryBudget(size_t limit_bytes = 0);
+
+    FrameMemoryBudget(const FrameMemoryBudget &) = delete;
+    FrameMemoryBudget &operator=(const FrameMemoryBudget &) = delete;
+
+    // Reserves bytes. Returns false (reserving nothing) if they do not fit.
+    bool Reserve(size_t bytes);
+
+    // Moves a reservation from old_bytes to new_bytes. Shrinking always
+    // succeeds; growing returns false (keeping old_bytes) if it does not fit.
+    bool Resize(size_t old_bytes, size_t new_bytes);
+
+    // Returns bytes from an earlier Reserve() or Resize().
+    void Release(size_t bytes);
+
+    // Bytes a new reservation could take (SIZE_MAX when unlimited).
+    size_t Available() const;
+
+    size_t limit_bytes() const { return limit_bytes_; }
+
+    FrameMemoryBudgetStats GetStats() const;
+
+  private:
+    const size_t limit_bytes_;
+    mutable std::mutex mutex_;
+    size_t reserved_bytes_ = 0;
+    uint64_t refusals_ = 0;
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_FRAME_MEMORY_BUDGET_H_
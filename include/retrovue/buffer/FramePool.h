@@ -0,0 +1,139 @@
+// Repository: Retrovue-playout
+// Component: Frame Pool
+// Purpose: Preallocated, reference-counted frame storage shared by producers and consumers.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_FRAME_POOL_H_
+#define RETROVUE_BUFFER_FRAME_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "retrovue/buffer/Frame.h"
+
+namespace retrovue::buffer
+{
+
+  class FramePool;
+
+  // FrameSlot is the unit of storage handed out by FramePool.
+  // Slots are owned by the pool; FrameHandle tracks references to them.
+  struct FrameSlot
+  {
+    Frame frame;
+    std::atomic<uint32_t> refs;
+    std::shared_ptr<FramePool> owner; // Keeps the pool alive while the slot is in use.
+
+    FrameSlot() : refs(0) {}
+  };
+
+  // FrameHandle is a reference-counted pointer to a pooled frame.
+  //
+  // Copying a handle adds a reference; the slot returns to its pool when the
+  // last handle is released. Handles are cheap to move and are the unit
+  // FrameRingBuffer passes between producer and consumer without copying
+  // the frame payload.
+  class FrameHandle
+  {
+  public:
+    FrameHandle() = default;
+    ~FrameHandle() { Reset(); }
+
+    FrameHandle(const FrameHandle &other);
+    FrameHandle &operator=(const FrameHandle &other);
+    FrameHandle(FrameHandle &&other) noexcept : slot_(other.slot_) { other.slot_ = nullptr; }
+    FrameHandle &operator=(FrameHandle &&other) noexcept;
+
+    // Wraps an existing frame in an unpooled handle (payload is moved, not copied).
+    // The slot is heap allocated and freed when the last reference is released.
+    static FrameHandle Adopt(Frame &&frame);
+
+    // Releases this reference. The handle becomes empty.
+    void Reset();
+
+    Frame *get() const { return slot_ ? &slot_->frame : nullptr; }
+    Frame &operator*() const { return slot_->frame; }
+    Frame *operator->() const { return &slot_->frame; }
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    // Returns the number of live references (0 for an empty handle).
+    uint32_t use_count() const
+    {
+      return slot_ ? slot_->refs.load(std::memory_order_acquire) : 0;
+    }
+
+  private:
+    friend class FramePool;
+    explicit FrameHandle(FrameSlot *slot) : slot_(slot) {}
+
+    FrameSlot *slot_ = nullptr;
+  };
+
+  // FramePool hands out preallocated frame buffers so producers can decode
+  // directly into memory that the consumer later reads in place.
+  //
+  // Design:
+  // - Fixed number of slots, each with a payload vector reserved up front
+  // - Acquire() never allocates; returns an empty handle when exhausted
+  // - Slots return to the free list when their last handle is released
+  // - Payload capacity is retained across reuse, so steady state is allocation-free
+  // - Payloads come from the channel's ChannelArena when given one
+  //
+  // Thread Model:
+  // - Acquire() and release may happen on different threads
+  // - The pool stays alive until every outstanding handle is released
+  class FramePool : public std::enable_shared_from_this<FramePool>
+  {
+  public:
+    // Creates a pool of slot_count frames, each reserving frame_bytes of payload
+    // from arena (the process heap if null).
+    static std::shared_ptr<FramePool> Create(size_t slot_count, size_t frame_bytes,
+                                             std::shared_ptr<ChannelArena> arena = nullptr);
+
+    ~FramePool();
+
+    // Disable copy and move
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // Acquires a free slot. Returns an empty handle if the pool is exhausted.
+    // The frame's payload keeps whatever size it had on its previous use.
+    FrameHandle Acquire();
+
+    // Returns the total number of slots.
+    size_t SlotCount() const { return slots_.size(); }
+
+    // Returns the number of slots currently free.
+    size_t Available() const;
+
+    // Returns the number of Acquire() calls that found the pool exhausted.
+    uint64_t ExhaustedCount() const { return exhausted_count_.load(std::memory_order_relaxed); }
+
+    // Calls visit(payload, capacity) for each slot's reserved payload storage,
+    // e.g. to place the pool on a NUMA node. Call before slots are acquired.
+    void ForEachPayload(const std::function<void(void *, size_t)> &visit);
+
+  private:
+    friend class FrameHandle;
+
+    FramePool(size_t slot_count, size_t frame_bytes, const std::shared_ptr<ChannelArena> &arena);
+
+    // Called by FrameHandle when a slot's last reference is dropped.
+    static void Release(FrameSlot *slot);
+
+    std::vector<std::unique_ptr<FrameSlot>> slots_;
+
+    mutable std::mutex free_mutex_;
+    std::vector<FrameSlot *> free_slots_;
+
+    std::atomic<uint64_t> exhausted_count_;
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_FRAME_POOL_H_
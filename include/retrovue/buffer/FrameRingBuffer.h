@@ -6,61 +6,58 @@
 #ifndef RETROVUE_BUFFER_FRAME_RING_BUFFER_H_
 #define RETROVUE_BUFFER_FRAME_RING_BUFFER_H_
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
-#include <string>
-#include <vector>
+#include <span>
+
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/buffer/FramePool.h"
 
 namespace retrovue::buffer
 {
 
-  // FrameMetadata carries timing and provenance information for a decoded frame.
-  struct FrameMetadata
-  {
-    int64_t pts;           // Presentation timestamp (in stream timebase units)
-    int64_t dts;           // Decode timestamp (in stream timebase units)
-    double duration;       // Frame duration in seconds
-    std::string asset_uri; // Source asset identifier
-
-    FrameMetadata()
-        : pts(0), dts(0), duration(0.0) {}
+  // Number of buckets in the occupancy histogram; bucket i counts pushes that
+  // left the buffer at most (i + 1) / kOccupancyBuckets full.
+  constexpr size_t kOccupancyBuckets = 8;
 
-    FrameMetadata(int64_t p, int64_t d, double dur, const std::string &uri)
-        : pts(p), dts(d), duration(dur), asset_uri(uri) {}
-  };
-
-  // Frame holds the actual decoded frame data along with metadata.
-  struct Frame
+  // BufferStats is a snapshot of the video ring's built-in instrumentation.
+  struct BufferStats
   {
-    FrameMetadata metadata;
-    std::vector<uint8_t> data; // Raw frame data (YUV420, etc.)
-    int width;
-    int height;
+    uint64_t frames_pushed = 0;     // Successful video pushes
+    uint64_t frames_popped = 0;     // Frames handed to the consumer
+    uint64_t frames_discarded = 0;  // Frames dropped via Discard*()
+    uint64_t push_failures = 0;     // Pushes rejected because the buffer was full
+    size_t high_water_frames = 0;   // Deepest occupancy since the last reset
+    size_t low_water_frames = 0;    // Shallowest occupancy after a pop since the last reset
+    uint64_t residency_total_us = 0;  // Sum of push-to-pop time over popped frames
+    uint64_t residency_max_us = 0;    // Longest push-to-pop time since the last reset
+    uint64_t occupancy_sum_frames = 0;  // Sum of occupancy samples (one per push)
+    std::array<uint64_t, kOccupancyBuckets> occupancy_histogram{};
 
-    Frame() : width(0), height(0) {}
-  };
-
-  // AudioFrame holds decoded audio samples (PCM) along with timing metadata.
-  struct AudioFrame
-  {
-    std::vector<uint8_t> data;   // PCM samples (interleaved, S16 format)
-    int sample_rate;             // Sample rate (e.g., 48000)
-    int channels;                // Number of channels (e.g., 2 for stereo)
-    int64_t pts_us;              // Presentation timestamp in microseconds
-    int nb_samples;              // Number of PCM samples in this frame
-
-    AudioFrame() : sample_rate(0), channels(0), pts_us(0), nb_samples(0) {}
+    double AverageResidencyUs() const
+    {
+      return frames_popped ? static_cast<double>(residency_total_us) / frames_popped : 0.0;
+    }
   };
 
   // FrameRingBuffer is a lock-free circular buffer for producer-consumer frame streaming.
   //
   // Design:
-  // - Fixed-size circular buffer (default: 60 frames)
+  // - Fixed-size circular buffer (default: 60 frames), with an adjustable
+  //   depth limit below that size so the usable depth can change at runtime
   // - Atomic read/write indices for thread safety
   // - Non-blocking push/pop operations
   // - Returns success/failure instead of blocking
+  // - Cheap built-in instrumentation (water marks, push failures, push-to-pop
+  //   residency, occupancy histogram) read via GetStats()
+  // - Optional blocking waits (WaitForSpace/WaitForFrame) that wake as soon as
+  //   the other side moves an index, instead of sleep-polling with a backoff
   // - Supports both video frames and audio frames
+  // - Video frames may be pushed by value (copied) or as pooled FrameHandles
+  //   (moved; the payload is never copied between producer and consumer)
   //
   // Thread Model:
   // - Single producer (decode thread)
@@ -87,6 +84,19 @@ namespace retrovue::buffer
     // Thread-safe for single producer.
     bool Push(const Frame &frame);
 
+    // Attempts to push a pooled video frame into the buffer without copying
+    // its payload. On success the handle is moved into the buffer and left
+    // empty; on failure (buffer full) the caller keeps the handle.
+    // Thread-safe for single producer.
+    bool Push(FrameHandle &&handle);
+
+    // Pushes as many of frames (in order) as fit, publishing them with a single
+    // index update so the consumer never sees a partial batch. Pushed handles
+    // are left empty; the rest stay with the caller.
+    // Returns the number of frames pushed.
+    // Thread-safe for single producer.
+    size_t PushBatch(std::span<FrameHandle> frames);
+
     // Attempts to push an audio frame into the buffer.
     // Returns true if successful, false if buffer is full.
     // Thread-safe for single producer.
@@ -97,6 +107,12 @@ namespace retrovue::buffer
     // Thread-safe for single consumer.
     bool Pop(Frame &frame);
 
+    // Attempts to pop a video frame as a handle, without copying its payload.
+    // Frames that were pushed by value are adopted into an unpooled handle.
+    // Returns true if successful, false if buffer is empty.
+    // Thread-safe for single consumer.
+    bool Pop(FrameHandle &handle);
+
     // Attempts to pop an audio frame from the buffer.
     // Returns true if successful, false if buffer is empty.
     // Thread-safe for single consumer.
@@ -108,6 +124,29 @@ namespace retrovue::buffer
     // Note: The returned pointer is only valid until the next Pop() or Push().
     const Frame* Peek() const;
 
+    // Peeks at up to out.size() queued video frames, oldest first, without
+    // removing them. Returns the number of pointers written.
+    // Thread-safe for single consumer.
+    // Note: The pointers are only valid until the next Pop()/Discard*()/PopBatch().
+    size_t PeekRange(std::span<const Frame *> out) const;
+
+    // Pops up to out.size() video frames as handles with a single index update.
+    // Returns the number of frames popped.
+    // Thread-safe for single consumer.
+    size_t PopBatch(std::span<FrameHandle> out);
+
+    // Drops up to count queued video frames with a single index update.
+    // No payload is copied; pooled frames are returned to their pool.
+    // Returns the number of frames dropped.
+    // Thread-safe for single consumer.
+    size_t Discard(size_t count);
+
+    // Drops queued video frames whose PTS is earlier than pts, stopping at the
+    // first frame at or after it. Single index update, no payload copies.
+    // Returns the number of frames dropped.
+    // Thread-safe for single consumer.
+    size_t DiscardUntilPts(int64_t pts);
+
     // Peeks at the next audio frame without removing it.
     // Returns pointer to audio frame if available, nullptr if buffer is empty.
     // Thread-safe for single consumer.
@@ -118,8 +157,16 @@ namespace retrovue::buffer
     // This is an approximate count due to concurrent access.
     size_t Size() const;
 
-    // Returns the maximum capacity of the buffer.
-    size_t Capacity() const { return capacity_; }
+    // Returns the maximum number of frames the buffer can hold.
+    size_t Capacity() const { return capacity_ - 1; }
+
+    // Limits video depth to depth frames (clamped to [1, Capacity()]); pushes
+    // fail once the buffer holds that many. Lowering it drops nothing: frames
+    // above the new limit drain normally. Safe from any thread.
+    void SetDepthLimit(size_t depth);
+
+    // Returns the current depth limit (Capacity() unless lowered).
+    size_t DepthLimit() const { return depth_limit_.load(std::memory_order_acquire); }
 
     // Returns true if the buffer is empty.
     bool IsEmpty() const;
@@ -127,13 +174,65 @@ namespace retrovue::buffer
     // Returns true if the buffer is full.
     bool IsFull() const;
 
-    // Clears all frames from the buffer.
+    // Returns a snapshot of the buffer's counters. Safe to call from any thread;
+    // individual fields are read independently.
+    BufferStats GetStats() const;
+
+    // Push-to-pop time of the last frame popped. Consumer thread only.
+    uint64_t LastPopResidencyUs() const { return last_pop_residency_us_; }
+
+    // Restarts water-mark and max-residency tracking from the current depth
+    // (e.g. once a channel reaches steady state). Counters are unaffected.
+    void ResetWaterMarks();
+
+    // Blocks until the buffer has room for a video frame or the deadline passes.
+    // Returns true if space is available, false on timeout or WakeWaiters().
+    // Intended for the single producer; wakes on the consumer's next pop.
+    bool WaitForSpace(std::chrono::steady_clock::time_point deadline);
+
+    // Blocks until a video frame is available or the deadline passes.
+    // Returns true if a frame is available, false on timeout or WakeWaiters().
+    // Intended for the single consumer; wakes on the producer's next push.
+    bool WaitForFrame(std::chrono::steady_clock::time_point deadline);
+
+    // Wakes any thread blocked in WaitForSpace()/WaitForFrame() (e.g. on stop).
+    void WakeWaiters();
+
+    // Clears all frames from the buffer, releasing any pooled handles it holds.
     // Not thread-safe - caller must ensure no concurrent access.
     void Clear();
 
   private:
+    // A video slot holds either a by-value frame or a pooled handle.
+    struct VideoSlot
+    {
+      Frame frame;
+      FrameHandle handle;
+      int64_t enqueue_ns = 0;  // steady_clock time of the push (for residency)
+
+      const Frame *get() const { return handle ? handle.get() : &frame; }
+    };
+
+    // Records occupancy and water marks after a successful push (producer side).
+    void RecordPush(size_t depth);
+
+    // Records residency and low water mark for a popped slot (consumer side).
+    void RecordPop(const VideoSlot &slot, int64_t now_ns, size_t depth);
+
+    // Advances the read index from current_read by count slots, releasing
+    // any pooled handles in the skipped slots.
+    void AdvanceRead(uint32_t current_read, size_t count);
+
+    // True if a video frame fits with read and write at these indices.
+    bool HasRoom(uint32_t write, uint32_t read) const;
+
+    // Wake blocked waiters after an index update (no-op when none are blocked).
+    void NotifyFrameWaiters();
+    void NotifySpaceWaiters();
+
     const size_t capacity_;
-    std::unique_ptr<Frame[]> buffer_;
+    std::unique_ptr<VideoSlot[]> buffer_;
+    std::atomic<size_t> depth_limit_;
 
     // Audio frame buffer (separate from video buffer)
     std::unique_ptr<AudioFrame[]> audio_buffer_;
@@ -143,6 +242,34 @@ namespace retrovue::buffer
     // Atomic indices for lock-free operation
     std::atomic<uint32_t> write_index_;
     std::atomic<uint32_t> read_index_;
+
+    // Blocked waiter counts; index updates only issue a wake when non-zero,
+    // so the non-blocking path never enters the kernel.
+    std::atomic<uint32_t> space_waiters_;
+    std::atomic<uint32_t> frame_waiters_;
+    std::atomic<uint32_t> wake_generation_;  // Bumped by WakeWaiters()
+
+    // Instrumentation, split by writer so producer and consumer counters do
+    // not share a cache line. Each field has a single writer.
+    struct alignas(64) ProducerCounters
+    {
+      std::atomic<uint64_t> frames_pushed{0};
+      std::atomic<uint64_t> push_failures{0};
+      std::atomic<uint64_t> high_water{0};
+      std::atomic<uint64_t> occupancy_sum{0};
+      std::array<std::atomic<uint64_t>, kOccupancyBuckets> occupancy_histogram{};
+    };
+    struct alignas(64) ConsumerCounters
+    {
+      std::atomic<uint64_t> frames_popped{0};
+      std::atomic<uint64_t> frames_discarded{0};
+      std::atomic<uint64_t> low_water{0};
+      std::atomic<uint64_t> residency_total_us{0};
+      std::atomic<uint64_t> residency_max_us{0};
+    };
+    ProducerCounters producer_counters_;
+    ConsumerCounters consumer_counters_;
+    uint64_t last_pop_residency_us_ = 0;  // Consumer thread only
   };
 
 } // namespace retrovue::buffer
@@ -0,0 +1,211 @@
+// Repository: Retrovue-playout
+// Component: Shared Frame Export
+// Purpose: Publishes a channel's decoded frames in shared memory for co-located readers.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_BUFFER_SHARED_FRAME_EXPORT_H_
+#define RETROVUE_BUFFER_SHARED_FRAME_EXPORT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "retrovue/buffer/ChannelArena.h"
+#include "retrovue/buffer/FramePool.h"
+
+namespace retrovue::buffer
+{
+
+  // Layout of an export's shared memory, as readers map it. Offsets are
+  // from the start of the region; the header sits at offset 0 and its
+  // slots follow it.
+  constexpr uint32_t kSharedFrameMagic = 0x58465652;  // "RVFX"
+  constexpr uint32_t kSharedFrameVersion = 1;
+
+  // SharedFrameSlot describes one published frame. Its sequence is a
+  // seqlock: odd while the slot is being replaced, 2n + 2 once frame n is
+  // in it.
+  struct SharedFrameSlot
+  {
+    std::atomic<uint64_t> sequence;
+    uint64_t data_offset;          // The frame's payload in the region
+    uint64_t plane_offsets[3];     // From data_offset
+    int32_t strides[3];
+    int32_t width;
+    int32_t height;
+    uint32_t format;               // PixelFormat (kI420, kNV12 or kP010)
+    int64_t pts;
+    int64_t dts;
+    double duration;
+    uint32_t asset_id;
+    uint8_t splice_point;
+    uint8_t asset_start;
+    uint8_t reserved[2];
+  };
+
+  struct SharedFrameHeader
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_bytes;           // sizeof(SharedFrameSlot)
+    uint64_t region_bytes;
+    int32_t channel_id;
+    uint32_t reserved;
+    alignas(64) std::atomic<uint64_t> published;  // Frames published so far
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "shared frame sequences must be lock-free across processes");
+  static_assert(sizeof(AssetId) <= sizeof(uint32_t), "asset ids must fit in a slot");
+
+  // SharedFrameExportStats is a point-in-time view of a SharedFrameExport.
+  struct SharedFrameExportStats
+  {
+    uint64_t published = 0;        // Frames readers can see
+    uint64_t not_shared = 0;       // Frames skipped: not in the region, or no planes
+    uint64_t readers_connected = 0;  // Region handed to a reader over the socket
+  };
+
+  // SharedFrameExport makes a channel's decoded frames readable by other
+  // processes on the host (ad detection, captions QA), so they map the
+  // frames instead of decoding the channel's output again.
+  //
+  // Design:
+  // - The channel's frames come from a shared ChannelArena, so their
+  //   payloads already live in the arena's memfd; Publish() writes a slot
+  //   describing the pooled frame where it is and never copies its pixels
+  // - The export keeps a reference to each of the last slot_count frames,
+  //   so a frame's payload is not reused while its slot still names it;
+  //   the producer's pool needs slot_count more slots for it
+  // - Readers are never waited for: each keeps its own cursor
+  //   (SharedFrameReader), checks a slot's sequence before and after
+  //   reading the frame, and skips ahead when it falls slot_count behind
+  // - Listen() hands each process that connects to a Unix socket a
+  //   read-only descriptor of the region (SCM_RIGHTS); they map it
+  //   read-only and cannot write the channel's frames
+  //
+  // Thread Model:
+  // - Publish() from one thread (the channel's renderer)
+  // - GetStats() from any thread
+  class SharedFrameExport
+  {
+  public:
+    static constexpr size_t kDefaultSlots = 8;
+
+    // Bytes of the region the header and slot_count slots take, for
+    // ChannelArena::CreateShared()'s front_bytes.
+    static size_t FrontBytes(size_t slot_count);
+
+    // Writes the header into arena's front, which must be shared and at
+    // least FrontBytes(slot_count).
+    SharedFrameExport(std::shared_ptr<ChannelArena> arena, int32_t channel_id,
+                      size_t slot_count = kDefaultSlots);
+    ~SharedFrameExport();
+
+    SharedFrameExport(const SharedFrameExport &) = delete;
+    SharedFrameExport &operator=(const SharedFrameExport &) = delete;
+
+    // False if the arena is not shared or too small for the slots.
+    bool IsValid() const { return header_ != nullptr; }
+
+    // Starts handing the region out on a Unix socket at socket_path.
+    bool Listen(const std::string &socket_path);
+
+    // Stops listening and removes the socket. Mapped readers keep the
+    // region; frames stop being published once the export is gone.
+    void Stop();
+
+    // Publishes frame by reference; false (and nothing published) if its
+    // payload is not in the region or it has no planes (kH264, kDevice).
+    bool Publish(const FrameHandle &frame);
+
+    SharedFrameExportStats GetStats() const;
+
+  private:
+    void AcceptLoop();
+    void HandOff(int client_fd);
+
+    const std::shared_ptr<ChannelArena> arena_;
+    SharedFrameHeader *header_ = nullptr;
+    SharedFrameSlot *slots_ = nullptr;
+    std::vector<FrameHandle> held_;  // The frame each slot names
+    uint64_t next_ = 0;              // Frames published (Publish() thread)
+
+    std::mutex listen_mutex_;
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    std::thread accept_thread_;
+    std::atomic<bool> listening_{false};
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> not_shared_{0};
+    std::atomic<uint64_t> readers_connected_{0};
+  };
+
+  // SharedFrameView is a frame a SharedFrameReader found: its planes point
+  // into the mapped region and stay readable until the export replaces the
+  // slot, which SharedFrameReader::Valid() tells.
+  struct SharedFrameView
+  {
+    uint64_t index = 0;            // Frame number, from 0 at the export's start
+    const uint8_t *planes[3] = {};
+    int strides[3] = {};
+    int width = 0;
+    int height = 0;
+    PixelFormat format = PixelFormat::kI420;
+    FrameMetadata metadata;        // Timing and asset (no trace)
+  };
+
+  // SharedFrameReader follows an export from another process (or a test):
+  // it maps the region read-only and walks its slots with a cursor of its
+  // own, which the channel never waits for.
+  //
+  // Thread Model: one thread per reader.
+  class SharedFrameReader
+  {
+  public:
+    SharedFrameReader() = default;
+    ~SharedFrameReader();
+
+    SharedFrameReader(const SharedFrameReader &) = delete;
+    SharedFrameReader &operator=(const SharedFrameReader &) = delete;
+
+    // Receives the region from an export's socket and opens it.
+    bool Connect(const std::string &socket_path);
+
+    // Maps the region behind fd (taking ownership of it); the cursor starts
+    // at the newest frame.
+    bool Open(int fd);
+
+    // The next frame after the cursor, skipping ahead (counted in Lost())
+    // when the export has overwritten it. False if there is none yet.
+    bool Next(SharedFrameView *view);
+
+    // True while view's slot still holds its frame. Check it after reading
+    // the pixels: false means they may have been overwritten meanwhile.
+    bool Valid(const SharedFrameView &view) const;
+
+    int32_t channel_id() const { return header_ ? header_->channel_id : -1; }
+    uint64_t Lost() const { return lost_; }
+
+  private:
+    void Close();
+
+    int fd_ = -1;
+    const uint8_t *base_ = nullptr;
+    size_t bytes_ = 0;
+    const SharedFrameHeader *header_ = nullptr;
+    const SharedFrameSlot *slots_ = nullptr;
+    uint64_t cursor_ = 0;  // Next frame to read
+    uint64_t lost_ = 0;
+  };
+
+} // namespace retrovue::buffer
+
+#endif // RETROVUE_BUFFER_SHARED_FRAME_EXPORT_H_
@@ -0,0 +1,111 @@
+// Repository: Retrovue-playout
+// Component: Asset Probe Cache
+// Purpose: Process-wide cache of container probe results keyed by path and mtime.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_ASSET_PROBE_CACHE_H_
+#define RETROVUE_DECODE_ASSET_PROBE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "retrovue/decode/KeyframeIndex.h"
+
+// Forward declarations for FFmpeg types (avoids pulling in FFmpeg headers here)
+struct AVFormatContext;
+struct AVCodecParameters;
+
+namespace retrovue::decode {
+
+// ProbedStream is what avformat_find_stream_info() learned about one stream.
+struct ProbedStream {
+  std::shared_ptr<const AVCodecParameters> codecpar;  // Includes extradata
+  int time_base_num = 0;
+  int time_base_den = 1;
+  int64_t start_time = 0;  // Stream time base
+  int64_t duration = 0;    // Stream time base
+  int64_t nb_frames = 0;
+  int avg_frame_rate_num = 0;
+  int avg_frame_rate_den = 1;
+  int r_frame_rate_num = 0;
+  int r_frame_rate_den = 1;
+};
+
+// ProbeSnapshot is the probed stream layout of one asset.
+struct ProbeSnapshot {
+  std::vector<ProbedStream> streams;
+  int64_t start_time = 0;  // AV_TIME_BASE units
+  int64_t duration = 0;    // AV_TIME_BASE units
+  int64_t bit_rate = 0;
+};
+
+// ProbeCacheStats is a point-in-time view of cache effectiveness.
+struct ProbeCacheStats {
+  uint64_t hits = 0;       // Probes answered from the cache
+  uint64_t misses = 0;     // Probes that ran avformat_find_stream_info()
+  uint64_t stale = 0;      // Entries dropped because the asset changed
+  uint64_t evictions = 0;  // Entries dropped to stay within max_entries
+  size_t entries = 0;
+};
+
+// AssetProbeCache lets repeat opens of the same asset skip the slow
+// avformat_find_stream_info() pass, which decodes frames from every stream.
+//
+// Entries are keyed by asset path and validated against size+mtime, so an
+// asset replaced on disk is re-probed. Least recently used entries are
+// evicted past max_entries. Only local files are cached; URLs always probe.
+//
+// Thread-safe: one process-wide instance is shared by every channel.
+class AssetProbeCache {
+ public:
+  static constexpr size_t kDefaultMaxEntries = 256;
+
+  // Returns the process-wide cache.
+  static AssetProbeCache& Instance();
+
+  explicit AssetProbeCache(size_t max_entries = kDefaultMaxEntries);
+
+  AssetProbeCache(const AssetProbeCache&) = delete;
+  AssetProbeCache& operator=(const AssetProbeCache&) = delete;
+
+  // Drop-in replacement for avformat_find_stream_info() on a context just
+  // opened with avformat_open_input(). Restores a cached probe when the
+  // container's header agrees with it, otherwise probes and caches the
+  // result. Returns false if probing failed.
+  bool ProbeInput(const std::string& asset_path, AVFormatContext* format_ctx);
+
+  // Returns the cached snapshot for an asset, or nullptr if absent or stale.
+  std::shared_ptr<const ProbeSnapshot> Lookup(const std::string& asset_path,
+                                              const AssetStamp& stamp);
+
+  // Caches a snapshot for an asset, replacing any previous entry.
+  void Insert(const std::string& asset_path, const AssetStamp& stamp,
+              std::shared_ptr<const ProbeSnapshot> snapshot);
+
+  void Clear();
+
+  ProbeCacheStats GetStats() const;
+
+ private:
+  struct Entry {
+    AssetStamp stamp;
+    std::shared_ptr<const ProbeSnapshot> snapshot;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  const size_t max_entries_;
+  mutable std::mutex mutex_;
+  std::list<std::string> lru_;  // Most recently used first
+  std::unordered_map<std::string, Entry> entries_;
+  ProbeCacheStats stats_;
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_ASSET_PROBE_CACHE_H_
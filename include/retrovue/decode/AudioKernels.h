@@ -0,0 +1,45 @@
+// Repository: Retrovue-playout
+// Component: Audio Kernels
+// Purpose: SIMD (AVX2/NEON) kernels for PCM conversion, gain ramping and 5.1 downmix.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_AUDIO_KERNELS_H_
+#define RETROVUE_DECODE_AUDIO_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace retrovue::decode {
+
+// The kernels below dispatch on ActiveKernelIsa() (see PlaneKernels.h), so
+// SetKernelIsa() switches them with the plane kernels. Every ISA runs the
+// same float operations in the same order; results match the scalar code
+// unless the compiler fuses its multiply-adds (-ffp-contract), which moves
+// a sample by at most one rounding step.
+
+// src S16 samples -> dst floats in [-1, 1): sample / 32768.
+void S16ToFloat(float* dst, const int16_t* src, size_t samples);
+
+// Converts frames of interleaved float samples to S16 with a gain ramp:
+// every sample of frame i is scaled by gain + gain_step * i, then rounded
+// (to nearest, ties to even) and saturated.
+void FloatToS16Ramped(int16_t* dst, const float* src, size_t frames, int channels, float gain,
+                      float gain_step);
+
+// 5.1 -> stereo gains; the LFE channel is dropped.
+struct DownmixCoefficients {
+  float center = 0.70710678f;    // -3 dB
+  float surround = 0.70710678f;  // -3 dB
+  float scale = 0.41421356f;     // 1 / (1 + center + surround): full scale never clips
+};
+
+// Downmixes frames of interleaved 5.1 (FL FR FC LFE SL SR, the FFmpeg order)
+// into interleaved stereo: L = scale * (FL + center * FC + surround * SL),
+// and R alike. dst may alias src (stereo frame i ends before 5.1 frame i
+// starts being read).
+void Downmix51ToStereo(float* dst, const float* src, size_t frames,
+                       const DownmixCoefficients& coefficients);
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_AUDIO_KERNELS_H_
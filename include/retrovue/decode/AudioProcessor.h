@@ -0,0 +1,174 @@
+// Repository: Retrovue-playout
+// Component: Audio Processor
+// Purpose: In-pipeline 5.1 downmix, loudness measurement and normalization of PCM audio.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_AUDIO_PROCESSOR_H_
+#define RETROVUE_DECODE_AUDIO_PROCESSOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "retrovue/buffer/Frame.h"
+
+namespace retrovue::decode {
+
+// LoudnessMeter measures loudness per ITU-R BS.1770-4, the measure EBU R128
+// and ATSC A/85 specify: the K-weighted mean square of each channel, summed
+// with the surround channels at +1.5 dB and LFE dropped, over 400 ms blocks
+// every 100 ms. Integrated loudness gates blocks at -70 LUFS, then at 10 LU
+// below the loudness of the blocks left.
+//
+// Blocks are kept in a histogram of 0.1 LU bins, so integrated loudness
+// over weeks of air takes constant memory; the relative gate is placed to
+// the bin. Loudness with nothing measured yet is -infinity.
+//
+// Two measures run off the same filtered samples: input, as added, and
+// output, as scaled by the gain the caller applies afterwards.
+//
+// Thread Model: not thread-safe; one thread adds and reads.
+class LoudnessMeter {
+ public:
+  static constexpr double kAbsoluteGateLufs = -70.0;
+  static constexpr double kRelativeGateLu = -10.0;
+
+  // channels in FFmpeg order (5.1: FL FR FC LFE SL SR); window_ms is the
+  // span WindowLufs() covers.
+  LoudnessMeter(int sample_rate, int channels, int64_t window_ms);
+
+  // Adds frames of interleaved samples. Their energy counts gain_squared
+  // times in the output measure (the mean square of the gain applied to
+  // them; 1 = none).
+  void Add(const float* samples, size_t frames, double gain_squared = 1.0);
+
+  // Gated loudness of everything added, of the input and of the output.
+  double IntegratedLufs() const { return input_.IntegratedLufs(); }
+  double OutputIntegratedLufs() const { return output_.IntegratedLufs(); }
+
+  // Gated input loudness of the last window_ms.
+  double WindowLufs() const { return window_lufs_; }
+
+  // Input loudness of the last 400 ms block.
+  double MomentaryLufs() const { return momentary_lufs_; }
+
+  int sample_rate() const { return sample_rate_; }
+  int channels() const { return channels_; }
+
+ private:
+  // Gated blocks by loudness, for integrated loudness.
+  class GateHistogram {
+   public:
+    void Add(double mean_square);
+    double IntegratedLufs() const;
+
+   private:
+    static constexpr int kBins = 750;  // -70 .. +5 LUFS
+    std::array<uint64_t, kBins> counts_{};
+    std::array<double, kBins> energy_{};
+  };
+
+  struct Biquad {
+    double b0 = 0, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+  };
+
+  void CloseSubBlock();
+
+  const int sample_rate_;
+  const int channels_;
+  const size_t sub_block_frames_;  // 100 ms
+  std::vector<double> weights_;    // Per channel
+  Biquad shelf_;                   // K-weighting stage 1: high-frequency shelf
+  Biquad high_pass_;               // Stage 2: RLB high-pass
+  std::vector<double> state_;      // Per channel: shelf z1 z2, high-pass z1 z2
+
+  size_t sub_block_filled_ = 0;
+  double sub_input_ = 0.0;
+  double sub_output_ = 0.0;
+  std::array<double, 4> last_input_{};  // The last four sub-blocks make a block
+  std::array<double, 4> last_output_{};
+  uint64_t sub_blocks_ = 0;
+
+  GateHistogram input_;
+  GateHistogram output_;
+  std::vector<double> window_;  // Input block mean squares, a ring
+  size_t window_next_ = 0;
+  size_t window_size_ = 0;
+  double window_lufs_ = -std::numeric_limits<double>::infinity();
+  double momentary_lufs_ = -std::numeric_limits<double>::infinity();
+};
+
+// AudioProcessingConfig configures a channel's AudioProcessor.
+struct AudioProcessingConfig {
+  bool enabled = false;
+  bool downmix = true;               // 5.1 frames come out stereo (for a stereo track)
+  bool normalize = true;             // Else measure only
+  double target_lufs = -24.0;        // ATSC A/85 (EBU R128: -23)
+  double max_boost_db = 12.0;        // Gain limits
+  double max_cut_db = 20.0;
+  double ramp_db_per_second = 3.0;   // Fastest the gain moves
+  int64_t window_ms = 10000;         // Input loudness the gain follows
+};
+
+// AudioProcessorStats is a point-in-time view of an AudioProcessor.
+struct AudioProcessorStats {
+  uint64_t frames = 0;             // AudioFrames processed
+  uint64_t downmixed_frames = 0;
+  uint64_t invalid_frames = 0;     // Left as they were (size mismatch, no samples)
+  double integrated_lufs = -std::numeric_limits<double>::infinity();  // Output, since start
+  double input_integrated_lufs = -std::numeric_limits<double>::infinity();
+  double window_lufs = -std::numeric_limits<double>::infinity();      // Input, over window_ms
+  double gain_db = 0.0;            // Gain at the end of the last frame
+};
+
+// AudioProcessor is the audio stage between a channel's producer and its
+// encoder: it downmixes 5.1 to stereo, measures loudness and normalizes it
+// to a target, in place of a downstream pass that decodes and re-encodes
+// the audio again.
+//
+// Design:
+// - Frames are worked in chunks of kChunkFrames: S16 -> float, downmix,
+//   measure, then gain and back to S16, with the SIMD kernels of
+//   AudioKernels.h; a chunk's working set stays in L1
+// - Normalization is feed-forward: the gain follows the target minus the
+//   gated input loudness of the last window_ms, within the gain limits,
+//   moving at most ramp_db_per_second and ramping linearly across each
+//   chunk, so it never steps. Gated-out stretches (silence) hold the gain
+// - The output measure is what airs; it is the value exported as a metric
+// - A change of sample rate or channel count restarts the measurement
+//
+// Thread Model: Process() from one thread (the sink's encode thread);
+// GetStats() from any thread.
+class AudioProcessor {
+ public:
+  static constexpr size_t kChunkFrames = 1024;
+
+  explicit AudioProcessor(const AudioProcessingConfig& config);
+
+  AudioProcessor(const AudioProcessor&) = delete;
+  AudioProcessor& operator=(const AudioProcessor&) = delete;
+
+  // Processes frame in place (a downmixed frame comes out with 2 channels).
+  // Returns false, leaving it as it is, if its samples do not match its
+  // layout.
+  bool Process(buffer::AudioFrame& frame);
+
+  AudioProcessorStats GetStats() const;
+
+ private:
+  const AudioProcessingConfig config_;
+  std::unique_ptr<LoudnessMeter> meter_;
+  std::vector<float> scratch_;
+  double gain_db_ = 0.0;
+
+  mutable std::mutex mutex_;
+  AudioProcessorStats stats_;
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_AUDIO_PROCESSOR_H_
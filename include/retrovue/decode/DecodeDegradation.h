@@ -0,0 +1,33 @@
+// Repository: Retrovue-playout
+// Component: Decode Degradation
+// Purpose: Graded decode shortcuts a producer takes when the host is overloaded.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_DECODE_DEGRADATION_H_
+#define RETROVUE_DECODE_DECODE_DEGRADATION_H_
+
+namespace retrovue::decode {
+
+// DecodeDegradation trades a channel's picture quality for decode CPU, each
+// level including the ones before it (see runtime::LoadShedder).
+//
+// - kNone: full decode.
+// - kFastDecode: skip the deblocking filter and non-reference IDCT; small
+//   artifacts, frame rate kept.
+// - kSkipNonReference: drop frames no other frame predicts from (B-frames on
+//   most streams); the channel plays at a reduced frame rate.
+// - kKeyframesOnly: decode keyframes only; the picture freezes between them
+//   but the channel stays on schedule.
+enum class DecodeDegradation {
+  kNone = 0,
+  kFastDecode = 1,
+  kSkipNonReference = 2,
+  kKeyframesOnly = 3,
+};
+
+// Deepest level, for stepping through them.
+constexpr DecodeDegradation kMaxDecodeDegradation = DecodeDegradation::kKeyframesOnly;
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_DECODE_DEGRADATION_H_
@@ -0,0 +1,26 @@
+// Repository: Retrovue-playout
+// Component: Decode Threading
+// Purpose: Decoder threading model shared by the decode and producer configs.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_DECODE_THREADING_H_
+#define RETROVUE_DECODE_DECODE_THREADING_H_
+
+namespace retrovue::decode {
+
+// DecodeThreadType selects how libavcodec parallelizes decoding.
+//
+// - kFrame: whole frames decode in parallel. Best throughput, but adds one
+//   frame of latency per thread.
+// - kSlice: threads split each frame. No added latency, but only helps
+//   streams encoded with multiple slices.
+// - kAuto: let libavcodec enable whichever the codec supports.
+enum class DecodeThreadType {
+  kAuto = 0,
+  kFrame = 1,
+  kSlice = 2,
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_DECODE_THREADING_H_
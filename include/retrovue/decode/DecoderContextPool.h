@@ -0,0 +1,148 @@
+// Repository: Retrovue-playout
+// Component: Decoder Context Pool
+// Purpose: Process-wide pool of warm codec and scaler contexts reused across assets.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_DECODER_CONTEXT_POOL_H_
+#define RETROVUE_DECODE_DECODER_CONTEXT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+
+#include "retrovue/decode/DecodeThreading.h"
+
+// Forward declarations for FFmpeg types (avoids pulling in FFmpeg headers here)
+struct AVCodecContext;
+struct AVCodecParameters;
+struct SwsContext;
+
+namespace retrovue::decode {
+
+// DecoderKey identifies software decoder contexts that are interchangeable:
+// same codec, geometry, pixel format, profile, extradata and threading.
+struct DecoderKey {
+  int codec_id = 0;
+  int width = 0;
+  int height = 0;
+  int pix_fmt = -1;
+  int profile = 0;
+  uint64_t extradata_hash = 0;  // FNV-1a of the parameter sets (SPS/PPS, ...)
+  int thread_count = 0;         // 0 = auto
+  DecodeThreadType thread_type = DecodeThreadType::kFrame;
+
+  bool operator==(const DecoderKey& other) const {
+    return codec_id == other.codec_id && width == other.width &&
+           height == other.height && pix_fmt == other.pix_fmt &&
+           profile == other.profile && extradata_hash == other.extradata_hash &&
+           thread_count == other.thread_count && thread_type == other.thread_type;
+  }
+  bool operator!=(const DecoderKey& other) const { return !(*this == other); }
+};
+
+// ScalerKey fully describes a SwsContext.
+struct ScalerKey {
+  int src_width = 0;
+  int src_height = 0;
+  int src_format = -1;
+  int dst_width = 0;
+  int dst_height = 0;
+  int dst_format = -1;
+  int flags = 0;
+
+  bool operator==(const ScalerKey& other) const {
+    return src_width == other.src_width && src_height == other.src_height &&
+           src_format == other.src_format && dst_width == other.dst_width &&
+           dst_height == other.dst_height && dst_format == other.dst_format &&
+           flags == other.flags;
+  }
+  bool operator!=(const ScalerKey& other) const { return !(*this == other); }
+};
+
+// DecoderPoolStats is a point-in-time view of pool effectiveness.
+struct DecoderPoolStats {
+  uint64_t decoder_hits = 0;    // Opens served by a warm context
+  uint64_t decoder_misses = 0;  // Opens that ran avcodec_open2()
+  uint64_t scaler_hits = 0;
+  uint64_t scaler_misses = 0;
+  uint64_t evictions = 0;       // Idle contexts freed to stay within limits
+  size_t idle_decoders = 0;
+  size_t idle_scalers = 0;
+};
+
+// DecoderContextPool removes the decoder open cost at program boundaries.
+// Opening a codec context is cheap for simple codecs but can take hundreds
+// of milliseconds for HEVC with frame threading (thread pool and per-thread
+// frame contexts), and with many channels those spikes line up on the hour.
+//
+// A producer checks a context out when it opens an asset and returns it on
+// close. Returned decoders are flushed (avcodec_flush_buffers) and kept idle
+// for the next asset with the same DecoderKey; otherwise the caller opens a
+// fresh one as before. Only software decoders are pooled: hardware contexts
+// are bound to a device and callbacks of the producer that opened them.
+//
+// Idle contexts still hold their thread pools and frame buffers, so both
+// idle lists are bounded and least recently returned contexts are freed.
+//
+// Thread-safe: one process-wide instance is shared by every channel.
+class DecoderContextPool {
+ public:
+  static constexpr size_t kDefaultMaxIdleDecoders = 8;
+  static constexpr size_t kDefaultMaxIdleScalers = 16;
+
+  // Returns the process-wide pool.
+  static DecoderContextPool& Instance();
+
+  explicit DecoderContextPool(size_t max_idle_decoders = kDefaultMaxIdleDecoders,
+                              size_t max_idle_scalers = kDefaultMaxIdleScalers);
+  ~DecoderContextPool();
+
+  DecoderContextPool(const DecoderContextPool&) = delete;
+  DecoderContextPool& operator=(const DecoderContextPool&) = delete;
+
+  // Builds the key for a decoder opened from codecpar with this threading.
+  static DecoderKey MakeDecoderKey(const AVCodecParameters* codecpar,
+                                   int thread_count, DecodeThreadType thread_type);
+
+  // Returns an idle, flushed and opened context for key, or nullptr if there
+  // is none (the caller then opens its own and later returns it here).
+  AVCodecContext* AcquireDecoder(const DecoderKey& key);
+
+  // Takes ownership of *ctx (set to nullptr): it is kept idle for reuse, or
+  // freed if the pool is full.
+  void ReleaseDecoder(const DecoderKey& key, AVCodecContext** ctx);
+
+  // Returns an idle scaler for key, or a newly created one; nullptr only if
+  // sws_getContext() fails.
+  SwsContext* AcquireScaler(const ScalerKey& key);
+
+  // Takes ownership of *ctx (set to nullptr), as ReleaseDecoder().
+  void ReleaseScaler(const ScalerKey& key, SwsContext** ctx);
+
+  // Frees every idle context.
+  void Clear();
+
+  DecoderPoolStats GetStats() const;
+
+ private:
+  struct IdleDecoder {
+    DecoderKey key;
+    AVCodecContext* ctx;
+  };
+  struct IdleScaler {
+    ScalerKey key;
+    SwsContext* ctx;
+  };
+
+  const size_t max_idle_decoders_;
+  const size_t max_idle_scalers_;
+  mutable std::mutex mutex_;
+  std::list<IdleDecoder> idle_decoders_;  // Most recently returned first
+  std::list<IdleScaler> idle_scalers_;
+  DecoderPoolStats stats_;
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_DECODER_CONTEXT_POOL_H_
@@ -0,0 +1,63 @@
+// Repository: Retrovue-playout
+// Component: Device Frames
+// Purpose: GPU surfaces carried through the frame ring, and the shared devices they live on.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_DEVICE_FRAMES_H_
+#define RETROVUE_DECODE_DEVICE_FRAMES_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "retrovue/buffer/Frame.h"
+
+// Forward declarations for FFmpeg types (avoids pulling in FFmpeg headers here)
+struct AVBufferRef;
+struct AVFrame;
+
+namespace retrovue::buffer {
+
+// A reference to a hardware-decoded AVFrame (format VAAPI, CUDA or QSV).
+// Every frame holding it shares it; the last one lets the decoder reuse the
+// surface.
+struct DeviceSurface {
+  AVFrame* frame = nullptr;
+  std::shared_ptr<std::atomic<int>> in_flight;  // The producer's count of surfaces out
+
+  DeviceSurface() = default;
+  ~DeviceSurface();
+
+  DeviceSurface(const DeviceSurface&) = delete;
+  DeviceSurface& operator=(const DeviceSurface&) = delete;
+};
+
+}  // namespace retrovue::buffer
+
+namespace retrovue::decode {
+
+// Returns a new reference to the process's hardware device of type (an
+// AVHWDeviceType) on device ("" = the default), opening it on first use; null
+// if it cannot be opened. Decoders and encoders on the same device context
+// share surfaces, so a frame decoded on the GPU is encoded from there.
+AVBufferRef* AcquireSharedHwDevice(int type, const std::string& device);
+
+// Lays frame out as kDevice holding a new reference to surface (a hardware
+// frame), counted in in_flight until released. False if it cannot be
+// referenced.
+bool WrapDeviceSurface(const AVFrame* surface, std::shared_ptr<std::atomic<int>> in_flight,
+                       buffer::Frame* frame);
+
+// The hardware AVFrame of a kDevice frame, or null.
+const AVFrame* DeviceSurfaceFrame(const buffer::Frame& frame);
+
+// Copies a kDevice frame's picture into out's planes at its size, as NV12
+// (P010 for 10-bit surfaces), keeping metadata; any other frame is copied
+// as is. out may be the frame itself, which then lets go of its surface.
+// False if the surface cannot be read back. For the consumers that need
+// the pixels on the CPU (overlays, renditions, thumbnails, preview).
+bool DownloadDeviceFrame(const buffer::Frame& frame, buffer::Frame* out);
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_DEVICE_FRAMES_H_
@@ -7,16 +7,26 @@
 #define RETROVUE_DECODE_FFMPEG_DECODER_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
+#include "retrovue/buffer/ChannelArena.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/decode/DecodeDegradation.h"
+#include "retrovue/decode/DecodeThreading.h"
+#include "retrovue/decode/DecoderContextPool.h"
+#include "retrovue/decode/ReadAheadFile.h"
+#include "retrovue/telemetry/ChannelCpu.h"
 
 // Forward declarations for FFmpeg types (avoids pulling in FFmpeg headers here)
 struct AVFormatContext;
+struct AVCodec;
 struct AVCodecContext;
+struct AVCodecParameters;
 struct AVFrame;
 struct AVPacket;
+struct AVIOContext;
 struct SwsContext;
 struct SwrContext;
 
@@ -29,12 +39,22 @@ struct DecoderConfig {
   int target_height;            // Target output height (for scaling)
   bool hw_accel_enabled;        // Enable hardware acceleration if available
   int max_decode_threads;       // Maximum decoder threads (0 = auto)
+  DecodeThreadType thread_type; // Frame vs slice threading
+  size_t read_ahead_bytes;      // Prefetch window for local files (0 = read directly)
+  std::shared_ptr<runtime::IoRing> io_ring;  // Read-ahead reads on a shared io_uring (optional)
+  bool reuse_decoder_contexts;  // Check decoder/scaler out of DecoderContextPool
+  std::shared_ptr<buffer::ChannelArena> arena;  // Decoded picture memory (null = FFmpeg's)
+  int64_t start_offset_us;      // Seek here on open (keyframe at or before; 0 = start)
   
   DecoderConfig()
       : target_width(1920),
         target_height(1080),
         hw_accel_enabled(false),
-        max_decode_threads(0) {}
+        max_decode_threads(0),
+        thread_type(DecodeThreadType::kFrame),
+        read_ahead_bytes(0),
+        reuse_decoder_contexts(true),
+        start_offset_us(0) {}
 };
 
 // DecoderStats tracks decoding performance and errors.
@@ -44,13 +64,17 @@ struct DecoderStats {
   uint64_t decode_errors;
   double average_decode_time_ms;
   double current_fps;
+  uint64_t read_stalls;         // Reads that found the prefetch window empty
+  double read_stall_seconds;    // Time the demuxer spent blocked on storage
   
   DecoderStats()
       : frames_decoded(0),
         frames_dropped(0),
         decode_errors(0),
         average_decode_time_ms(0.0),
-        current_fps(0.0) {}
+        current_fps(0.0),
+        read_stalls(0),
+        read_stall_seconds(0.0) {}
 };
 
 // FFmpegDecoder decodes video files using libavformat and libavcodec.
@@ -91,8 +115,24 @@ class FFmpegDecoder {
 
   // Decodes the next frame and pushes it to the output buffer.
   // Returns true if frame decoded successfully, false on error or EOF.
+  // When a frame pool is set, frames are decoded directly into pool slots
+  // and handed to the buffer without copying.
   bool DecodeNextFrame(buffer::FrameRingBuffer& output_buffer);
 
+  // Sets the pool that decoded frames are written into (nullptr = by-value frames).
+  void SetFramePool(std::shared_ptr<buffer::FramePool> pool) { frame_pool_ = std::move(pool); }
+
+  // Called with every pooled frame and every audio frame once the output
+  // buffer took it, on the decoding thread (e.g. to feed more buffers).
+  using FrameTap = std::function<void(const buffer::FrameHandle& frame)>;
+  using AudioTap = std::function<void(const buffer::AudioFrame& frame)>;
+  void SetFrameTap(FrameTap tap) { frame_tap_ = std::move(tap); }
+  void SetAudioTap(AudioTap tap) { audio_tap_ = std::move(tap); }
+
+  // Charges decode and scale time of each frame to meter (nullptr = off).
+  // The meter belongs to the decoding thread's owner.
+  void SetCpuMeter(telemetry::StageCpuMeter* meter) { cpu_meter_ = meter; }
+
   // Decodes the next audio frame and pushes it to the output buffer.
   // Returns true if audio frame decoded successfully, false on error or EOF.
   bool DecodeNextAudioFrame(buffer::FrameRingBuffer& output_buffer);
@@ -109,6 +149,11 @@ class FFmpegDecoder {
   // Gets current decoder statistics.
   const DecoderStats& GetStats() const { return stats_; }
 
+  // Takes the decode shortcuts of level from the next packet on (and on
+  // every later Open()). Decode thread only.
+  void SetDegradation(DecodeDegradation level);
+  DecodeDegradation degradation() const { return degradation_; }
+
   // Gets video stream information.
   int GetVideoWidth() const;
   int GetVideoHeight() const;
@@ -125,9 +170,15 @@ class FFmpegDecoder {
   // Initializes the codec and codec context.
   bool InitializeCodec();
 
+  // Allocates and opens codec_ctx_ when the pool has no warm context.
+  bool OpenCodec(const AVCodec* codec, const AVCodecParameters* codecpar);
+
   // Initializes the audio codec and codec context.
   bool InitializeAudioCodec();
 
+  // Sets codec_ctx_'s discard levels for level.
+  void ApplyDegradation(DecodeDegradation level);
+
   // Initializes the scaler for resolution conversion.
   bool InitializeScaler();
 
@@ -146,11 +197,23 @@ class FFmpegDecoder {
   // Converts AVFrame to our AudioFrame format (PCM S16 interleaved).
   bool ConvertAudioFrame(AVFrame* av_frame, buffer::AudioFrame& output_frame);
 
+  // Routes demuxer reads through a ReadAheadFile. Leaves the format context
+  // on plain file I/O if the input cannot be prefetched (URLs, devices).
+  void AttachReadAhead();
+
+  // Releases the read-ahead layer (after the format context is closed).
+  void ReleaseReadAhead();
+
   // Updates decoder statistics.
   void UpdateStats(double decode_time_ms);
 
   DecoderConfig config_;
+  buffer::AssetId asset_id_;  // config_.input_uri, interned
   DecoderStats stats_;
+  std::shared_ptr<buffer::FramePool> frame_pool_;
+  telemetry::StageCpuMeter* cpu_meter_ = nullptr;
+  FrameTap frame_tap_;
+  AudioTap audio_tap_;
 
   // FFmpeg contexts (opaque pointers)
   AVFormatContext* format_ctx_;
@@ -161,7 +224,13 @@ class FFmpegDecoder {
   AVFrame* audio_frame_;
   AVPacket* packet_;
   SwsContext* sws_ctx_;
+  ScalerKey scaler_key_;        // What sws_ctx_ was created for
+  DecoderKey decoder_key_;      // Pool key of codec_ctx_
+  bool decoder_pooled_;         // codec_ctx_ goes back to the pool on Close()
+  DecodeDegradation degradation_ = DecodeDegradation::kNone;
   SwrContext* swr_ctx_;  // Audio resampler
+  std::unique_ptr<ReadAheadFile> read_ahead_;  // Null unless read_ahead_bytes > 0
+  AVIOContext* io_ctx_;  // Custom I/O over read_ahead_
 
   int video_stream_index_;
   int audio_stream_index_;
@@ -175,6 +244,14 @@ class FFmpegDecoder {
   double audio_time_base_;
 };
 
+// Runs FFmpeg's one-time setup (network protocols), looks up the demuxers,
+// parsers and decoders playout uses, and leaves scalers from the common
+// source sizes to target_width x target_height idle in DecoderContextPool,
+// so the first channel start does not pay for any of it. Safe from any
+// thread. Returns how many of the common decoders were found (0 without
+// FFmpeg).
+int WarmUpDecoding(int target_width = 1920, int target_height = 1080);
+
 }  // namespace retrovue::decode
 
 #endif  // RETROVUE_DECODE_FFMPEG_DECODER_H_
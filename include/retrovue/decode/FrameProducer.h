@@ -9,15 +9,28 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "retrovue/buffer/ChannelArena.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/decode/DecodeDegradation.h"
+#include "retrovue/decode/DecodeThreading.h"
+#include "retrovue/decode/ReadAheadFile.h"
+#include "retrovue/runtime/ChannelPlacement.h"
+#include "retrovue/telemetry/ChannelCpu.h"
 
 namespace retrovue::timing {
 class MasterClock;
 }
 
+namespace retrovue::runtime {
+class TaskExecutor;
+class TaskLoop;
+}  // namespace retrovue::runtime
+
 namespace retrovue::decode {
 
 namespace timing = ::retrovue::timing;
@@ -31,6 +44,16 @@ struct ProducerConfig {
   bool stub_mode;              // If true, generate fake frames instead of decoding
   bool hw_accel_enabled;       // Enable hardware acceleration (passed to FFmpegDecoder)
   int max_decode_threads;      // Maximum decoder threads (0 = auto)
+  DecodeThreadType decode_thread_type;  // Frame vs slice threading
+  size_t read_ahead_bytes;     // Prefetch window for local files (0 = read directly)
+  ReadStallCallback on_read_stall;  // Reports read-ahead stalls (decode thread)
+  std::shared_ptr<runtime::IoRing> io_ring;  // Read-ahead reads on a shared io_uring (optional)
+  runtime::ChannelPlacement placement;  // Producer thread CPUs and frame memory node
+  int32_t channel_id;          // Names the producer thread (-1 = untagged)
+  std::shared_ptr<telemetry::ChannelCpuAccount> cpu_account;  // Charged decode/scale CPU time (optional)
+  std::shared_ptr<buffer::ChannelArena> arena;  // Frame and decoded picture memory (null = heap)
+  int64_t start_offset_us;     // Media time to start from (0 = the beginning)
+  size_t frame_pool_extra_slots;  // Pool slots beyond the ring's, for frames a tap holds
   
   ProducerConfig()
       : target_width(1920),
@@ -38,7 +61,12 @@ struct ProducerConfig {
         target_fps(30.0),
         stub_mode(false),  // Phase 3: default to real decode
         hw_accel_enabled(false),
-        max_decode_threads(0) {}
+        max_decode_threads(0),
+        decode_thread_type(DecodeThreadType::kFrame),
+        read_ahead_bytes(0),
+        channel_id(-1),
+        start_offset_us(0),
+        frame_pool_extra_slots(0) {}
 };
 
 // Forward declaration
@@ -52,9 +80,22 @@ class FFmpegDecoder;
 // - Automatic decoder initialization and error recovery
 //
 // Thread Model:
-// - Producer runs in its own thread
+// - Producer runs in its own thread, or as a chain of tasks on a shared
+//   runtime::TaskExecutor when one is set (real clocks only)
+// - config.placement pins the producer thread (and the decoder threads it
+//   starts) and binds the frame pool to its NUMA node; tasks on a shared
+//   executor are not pinned, only the pool is bound
 // - Continuously produces frames until stopped
 // - Backs off when ring buffer is full
+// - Frames are produced into a FramePool sized to the ring buffer, so the
+//   payload is written once and never copied on its way to the consumer;
+//   the pool follows the ring's depth limit, replaced between frames when
+//   the limit changes (the old pool is freed once its frames are consumed)
+// - More buffers can be fed from the same decode (AddOutput(), simulcast):
+//   each gets its own copy of every frame, as sinks draw on frames in
+//   place. The first output paces production and sizes the pool; the
+//   others drop frames they have no room for. Removing the first makes the
+//   next one the pacing output
 //
 // Lifecycle:
 // 1. Construct with config and ring buffer reference
@@ -74,7 +115,11 @@ class FrameProducer {
   FrameProducer(const FrameProducer&) = delete;
   FrameProducer& operator=(const FrameProducer&) = delete;
 
-  // Starts the decode thread.
+  // Runs production on executor's work lane instead of a thread of its
+  // own (from the next Start()). Fake or missing clocks keep the thread.
+  void SetExecutor(std::shared_ptr<runtime::TaskExecutor> executor);
+
+  // Starts the decode thread (or task chain).
   // Returns true if started successfully, false if already running.
   bool Start();
 
@@ -88,6 +133,21 @@ class FrameProducer {
   // Forces the producer to stop immediately (used when teardown times out).
   void ForceStop();
 
+  // Feeds ring every frame produced from now on, after the buffer given at
+  // construction. Returns false if ring is an output already.
+  bool AddOutput(buffer::FrameRingBuffer& ring);
+
+  // Stops feeding ring; once it returns the producer no longer touches it.
+  // Returns the outputs left (with none the producer idles).
+  size_t RemoveOutput(buffer::FrameRingBuffer& ring);
+
+  size_t OutputCount() const;
+
+  // Frames outputs after the first had no room for.
+  uint64_t GetFollowerDrops() const {
+    return follower_drops_.load(std::memory_order_relaxed);
+  }
+
   // Returns true if the producer is currently running.
   bool IsRunning() const { return running_.load(std::memory_order_acquire); }
 
@@ -101,25 +161,100 @@ class FrameProducer {
     return buffer_full_count_.load(std::memory_order_acquire);
   }
 
+  // Returns the CPU time of the producer thread so far (decoder worker
+  // threads not included).
+  uint64_t GetThreadCpuNs() const {
+    return thread_cpu_ns_.load(std::memory_order_relaxed);
+  }
+
+  // Asks the decoder to take the shortcuts of level from its next frame on
+  // (see DecodeDegradation). Safe from any thread; stub frames ignore it.
+  void SetDegradation(DecodeDegradation level) {
+    degradation_.store(level, std::memory_order_relaxed);
+  }
+  DecodeDegradation GetDegradation() const {
+    return degradation_.load(std::memory_order_relaxed);
+  }
+
+  // Frame memory a producer with config reserves for a ring of depth frames.
+  static size_t FramePoolBytes(const ProducerConfig& config, size_t depth);
+
  private:
+  // How long to wait before the next production step.
+  struct Backoff {
+    enum class Kind {
+      kNone,         // Produce again at once
+      kUntilUtc,     // Until MasterClock time `us`
+      kForUs,        // For `us` microseconds
+      kBufferSpace,  // Until the consumer frees a slot, at most `us`
+    };
+    Kind kind = Kind::kNone;
+    int64_t us = 0;
+  };
+
   // Main decode loop (runs in producer thread).
   void ProduceLoop();
 
+  // Opens the decoder (falls back to stub mode if it cannot).
+  void BeginProduction();
+
+  // Closes the decoder and marks the producer stopped.
+  void EndProduction();
+
+  // One pass of the decode loop: teardown checks, then one frame.
+  Backoff ProduceStep();
+
+  // ProduceStep() as a TaskLoop step; returns the system time of the next.
+  int64_t RunTaskStep();
+
+  // Blocks the producer thread for backoff.
+  void Wait(const Backoff& backoff);
+
   // Stub implementation: generates fake frames.
-  void ProduceStubFrame();
+  Backoff ProduceStubFrame();
 
   // Real decode implementation using FFmpegDecoder.
-  void ProduceRealFrame();
+  Backoff ProduceRealFrame();
+
+  // Forwards read-ahead stalls since the last report to on_read_stall.
+  void ReportReadStalls();
+
+  // Creates a frame pool for a ring of depth frames, on the placement's node.
+  std::shared_ptr<buffer::FramePool> CreateFramePool(size_t depth) const;
+
+  // Replaces the frame pool if the ring's depth limit changed (producer side).
+  void MatchPoolToBufferDepth();
+
+  // Pushes a produced frame to the outputs after the first (outputs_mutex_ held).
+  void ForwardFrame(const buffer::FrameHandle& frame);
+  void ForwardAudioFrame(const buffer::AudioFrame& frame);
+
+  // Wakes the producer wherever it waits for buffer space.
+  void WakeOutputs();
 
   ProducerConfig config_;
-  buffer::FrameRingBuffer& output_buffer_;
+  buffer::AssetId asset_id_;  // config_.asset_uri, interned
+  // Buffers fed, the pacing one first. The producer holds outputs_mutex_
+  // through each step; waiting_on_ is the buffer it waits on for space.
+  mutable std::mutex outputs_mutex_;
+  std::vector<buffer::FrameRingBuffer*> outputs_;
+  std::atomic<buffer::FrameRingBuffer*> waiting_on_{nullptr};
+  std::atomic<uint64_t> follower_drops_{0};
+  std::shared_ptr<buffer::FramePool> frame_pool_;
+  size_t pool_depth_ = 0;  // Ring depth frame_pool_ was sized for
   
   std::atomic<bool> running_;
   std::atomic<bool> stop_requested_;
   std::atomic<uint64_t> frames_produced_;
   std::atomic<uint64_t> buffer_full_count_;
+  std::atomic<uint64_t> thread_cpu_ns_{0};
+  telemetry::StageCpuMeter cpu_meter_;  // Producer thread (or task step) only
+  std::atomic<DecodeDegradation> degradation_{DecodeDegradation::kNone};
   
   std::unique_ptr<std::thread> producer_thread_;
+  std::shared_ptr<runtime::TaskExecutor> executor_;
+  std::unique_ptr<runtime::TaskLoop> task_loop_;
+  bool task_begun_ = false;  // BeginProduction() ran for the current task chain
   std::unique_ptr<FFmpegDecoder> decoder_;
   std::shared_ptr<timing::MasterClock> master_clock_;
 
@@ -131,6 +266,10 @@ class FrameProducer {
   int64_t stub_pts_counter_;
   int64_t frame_interval_us_;
   int64_t next_stub_deadline_utc_;
+
+  // Read-ahead stall totals already passed to on_read_stall
+  uint64_t reported_read_stalls_;
+  double reported_read_stall_seconds_;
 };
 
 }  // namespace retrovue::decode
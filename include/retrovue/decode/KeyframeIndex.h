@@ -0,0 +1,101 @@
+// Repository: Retrovue-playout
+// Component: Keyframe Index
+// Purpose: Persistent per-asset keyframe index for fast mid-asset starts.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_KEYFRAME_INDEX_H_
+#define RETROVUE_DECODE_KEYFRAME_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace retrovue::decode {
+
+// KeyframeEntry locates one keyframe of the indexed video stream.
+struct KeyframeEntry {
+  int64_t pts_us;     // Presentation time in microseconds (stream time base)
+  int64_t timestamp;  // Same instant in stream time-base units (for seeking)
+  int64_t byte_pos;   // Packet offset in the file, or -1 if unknown
+};
+
+// AssetStamp identifies the asset version an index was built from. A sidecar
+// whose stamp no longer matches the file on disk is ignored and rebuilt.
+struct AssetStamp {
+  uint64_t size_bytes = 0;
+  int64_t mtime_ns = 0;
+
+  bool operator==(const AssetStamp& other) const {
+    return size_bytes == other.size_bytes && mtime_ns == other.mtime_ns;
+  }
+  bool operator!=(const AssetStamp& other) const { return !(*this == other); }
+};
+
+// KeyframeIndex maps media time to the keyframe a decoder must start from.
+//
+// Built once from the demuxer (container index, or a packet scan when the
+// container has none), then saved as a sidecar so later opens of the same
+// asset can seek straight to the right GOP.
+//
+// Sidecar layout (native byte order): magic "RVKI", format version, stream
+// index, asset size, asset mtime, entry count, then the entries.
+//
+// Not thread-safe; each producer owns its own instance.
+class KeyframeIndex {
+ public:
+  // Sidecar file name suffix appended to the asset file name.
+  static constexpr const char* kSidecarSuffix = ".rvidx";
+
+  KeyframeIndex() = default;
+
+  // Returns the sidecar path for an asset. Empty index_dir places the sidecar
+  // next to the asset; otherwise it goes in index_dir under the asset's file
+  // name.
+  static std::string SidecarPathFor(const std::string& asset_path,
+                                    const std::string& index_dir = "");
+
+  // Reads size and mtime of a local file. Returns false if it cannot be
+  // stat'ed (e.g. a network URI).
+  static bool StatAsset(const std::string& asset_path, AssetStamp* stamp);
+
+  // Loads a sidecar. Returns false (leaving the index empty) if the file is
+  // missing, malformed, or was built from a different asset version or
+  // stream.
+  bool Load(const std::string& sidecar_path, const AssetStamp& expected_stamp,
+            int expected_stream_index);
+
+  // Writes the sidecar via a temporary file and rename, so readers never see
+  // a partial index. Returns false on I/O failure.
+  bool Save(const std::string& sidecar_path) const;
+
+  // Appends a keyframe. Entries may arrive out of order; Finalize() sorts.
+  void Add(const KeyframeEntry& entry);
+
+  // Sorts entries by time and drops duplicates. Call after the last Add().
+  void Finalize();
+
+  // Returns the last keyframe at or before pts_us, the first keyframe if
+  // pts_us precedes every entry, or nullptr if the index is empty.
+  const KeyframeEntry* FindAtOrBefore(int64_t pts_us) const;
+
+  void Clear();
+
+  bool empty() const { return entries_.empty(); }
+  size_t size() const { return entries_.size(); }
+  const std::vector<KeyframeEntry>& entries() const { return entries_; }
+
+  void set_stamp(const AssetStamp& stamp) { stamp_ = stamp; }
+  const AssetStamp& stamp() const { return stamp_; }
+
+  void set_stream_index(int stream_index) { stream_index_ = stream_index; }
+  int stream_index() const { return stream_index_; }
+
+ private:
+  std::vector<KeyframeEntry> entries_;
+  AssetStamp stamp_;
+  int stream_index_ = -1;
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_KEYFRAME_INDEX_H_
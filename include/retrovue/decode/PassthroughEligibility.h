@@ -0,0 +1,55 @@
+// Repository: Retrovue-playout
+// Component: Passthrough Eligibility
+// Purpose: Decides whether a source video stream can be muxed without re-encoding.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_PASSTHROUGH_ELIGIBILITY_H_
+#define RETROVUE_DECODE_PASSTHROUGH_ELIGIBILITY_H_
+
+#include <cstdint>
+
+#include "retrovue/decode/KeyframeIndex.h"
+
+namespace retrovue::decode {
+
+// PassthroughProfile is what a channel's encoder would produce. A source
+// stream within it can be sent to the muxer as it is (compressed-domain
+// remux), skipping decode and encode.
+struct PassthroughProfile {
+  int max_profile = 100;           // H.264 profile_idc: 66 Baseline, 77 Main, 100 High
+  int max_level = 41;              // level_idc (41 = 4.1)
+  int width = 1920;
+  int height = 1080;
+  double fps = 30.0;
+  int64_t max_gop_us = 2'000'000;  // Longest keyframe interval (join time, HLS segments)
+};
+
+// SourceStream describes a source video stream: codec parameters as
+// probed, and its keyframe spacing from the keyframe index.
+struct SourceStream {
+  bool h264 = false;
+  int profile = -1;         // profile_idc, with or without FFmpeg's constraint flags
+  int level = -1;           // level_idc
+  int width = 0;
+  int height = 0;
+  int sar_num = 0;          // Sample aspect ratio (0 = unknown, taken as square)
+  int sar_den = 0;
+  bool interlaced = false;  // Field-coded (any field order other than progressive)
+  double fps = 0.0;         // Average frame rate (0 = unknown)
+  int reorder_depth = 0;    // Frames of B-frame reordering (AVCodecParameters::video_delay)
+  int64_t max_gop_us = -1;  // Longest keyframe interval (-1 = unknown)
+};
+
+// Returns nullptr when source can be passed through to a channel encoding
+// profile, or the first reason it cannot (for logs and producer events).
+// Sources with B-frames never pass: the sink paces and stamps frames in
+// presentation order, so packets must arrive in it.
+const char* PassthroughMismatch(const SourceStream& source, const PassthroughProfile& profile);
+
+// Longest interval between consecutive keyframes of index in microseconds
+// (-1 with fewer than two keyframes), ignoring the last GOP's open end.
+int64_t LongestKeyframeInterval(const KeyframeIndex& index);
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_PASSTHROUGH_ELIGIBILITY_H_
@@ -0,0 +1,116 @@
+// Repository: Retrovue-playout
+// Component: Plane Kernels
+// Purpose: SIMD (AVX2/NEON) kernels for YUV plane copy, scaling, chroma conversion and blending.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_PLANE_KERNELS_H_
+#define RETROVUE_DECODE_PLANE_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "retrovue/buffer/Frame.h"
+
+// Forward declaration for FFmpeg type (avoids pulling in FFmpeg headers here)
+struct AVFrame;
+
+namespace retrovue::decode {
+
+// Instruction set a kernel implementation targets.
+enum class KernelIsa {
+  kScalar,
+  kAvx2,  // x86-64, selected at runtime when the CPU supports it
+  kNeon,  // AArch64 (always present)
+};
+
+// Returns the implementation every kernel below dispatches to. Picked once
+// from the host CPU on first use.
+KernelIsa ActiveKernelIsa();
+
+// Returns a short name for logs ("scalar", "avx2", "neon").
+const char* KernelIsaName(KernelIsa isa);
+
+// Overrides the dispatched implementation (tests and benchmarks).
+// Returns false, leaving dispatch unchanged, if the CPU cannot run isa.
+bool SetKernelIsa(KernelIsa isa);
+
+// Copies rows of row_bytes between strided planes, as a single memcpy when
+// neither side has row padding.
+void CopyPlane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+               int row_bytes, int rows);
+
+// NV12 -> I420 chroma: splits an interleaved UV plane of width sample pairs
+// per row into separate U and V planes.
+void SplitUVPlane(uint8_t* dst_u, int dst_u_stride, uint8_t* dst_v, int dst_v_stride,
+                  const uint8_t* src_uv, int src_stride, int width, int rows);
+
+// I420 -> NV12 chroma: interleaves U and V planes into one UV plane.
+void MergeUVPlane(uint8_t* dst_uv, int dst_stride, const uint8_t* src_u, int src_u_stride,
+                  const uint8_t* src_v, int src_v_stride, int width, int rows);
+
+// P010 -> 8 bits: keeps the high byte of each of samples 16-bit samples per
+// row (little-endian).
+void NarrowP010Plane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+                     int samples, int rows);
+
+// Composites a premultiplied overlay plane onto dst in place, over width
+// samples of rows rows: dst = src + dst * (255 - alpha) / 255, saturated.
+// alpha holds one value per sample (repeated for interleaved chroma).
+void BlendPremultipliedPlane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+                             const uint8_t* alpha, int alpha_stride, int width, int rows);
+
+// Bilinear resize of one 8-bit plane (pixel centers aligned, edges clamped).
+// Two-tap filtering only suits ratios up to 2:1; see CanPackI420().
+void ScalePlane(uint8_t* dst, int dst_stride, int dst_width, int dst_height,
+                const uint8_t* src, int src_stride, int src_width, int src_height);
+
+// Chroma layouts PackI420() accepts.
+enum class PlanarLayout {
+  kI420,  // planes[0..2] = Y, U, V
+  kNV12,  // planes[0..1] = Y, interleaved UV
+  kP010,  // planes[0..1] = Y, interleaved UV; 16-bit samples, 10 bits in the high bits
+};
+
+// PlanarImage describes a 4:2:0 source image in caller-owned memory.
+struct PlanarImage {
+  PlanarLayout layout = PlanarLayout::kI420;
+  const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+  int strides[3] = {0, 0, 0};
+  int width = 0;
+  int height = 0;
+};
+
+// Fills image from a decoded frame. Returns false unless the frame is
+// yuv420p, nv12 or p010le in system memory.
+bool DescribeFrame(const AVFrame* frame, PlanarImage* image);
+
+// Fills image from the planes of a buffer frame. Returns false if the frame
+// has no size, is compressed or on the GPU, or its data is too small for
+// its layout.
+bool DescribeFrame(const buffer::Frame& frame, PlanarImage* image);
+
+// Returns true if image is tightly packed I420 (Y, then U, then V, no row
+// padding), the layout PackI420() writes to a single buffer.
+bool IsPackedI420(const PlanarImage& image);
+
+// Returns true if PackI420() can produce dst_width x dst_height from src
+// without quality loss versus swscale: same size, or a downscale of at most
+// 2:1 on each axis. Upscales and steeper downscales should use swscale.
+bool CanPackI420(const PlanarImage& src, int dst_width, int dst_height);
+
+// Writes src as I420 (chroma planes are dst_width/2 x dst_height/2) into
+// the strided planes dst, scaling, converting the chroma layout and
+// narrowing 10-bit samples as needed.
+void PackI420(const PlanarImage& src, int dst_width, int dst_height, uint8_t* const dst[3],
+              const int dst_strides[3]);
+
+// As above, into tightly packed I420 (Y, then U, then V) at dst.
+void PackI420(const PlanarImage& src, int dst_width, int dst_height, uint8_t* dst);
+
+// Copies src unchanged (same size and pixel format) into dst, laid out with
+// aligned planes.
+void CopyToFrame(const PlanarImage& src, buffer::Frame* dst);
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_PLANE_KERNELS_H_
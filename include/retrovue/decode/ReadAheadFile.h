@@ -0,0 +1,141 @@
+// Repository: Retrovue-playout
+// Component: Read-Ahead File
+// Purpose: Background-prefetching file reader that backs a custom AVIOContext.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_DECODE_READ_AHEAD_FILE_H_
+#define RETROVUE_DECODE_READ_AHEAD_FILE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Forward declaration for FFmpeg type (avoids pulling in FFmpeg headers here)
+struct AVIOContext;
+
+namespace retrovue::runtime {
+class IoRing;
+}  // namespace retrovue::runtime
+
+namespace retrovue::decode {
+
+// ReadAheadStats tracks how often the demuxer out-ran storage.
+struct ReadAheadStats {
+  uint64_t bytes_read = 0;     // Bytes handed to the demuxer
+  uint64_t stalls = 0;         // Reads that found the prefetch window empty
+  uint64_t stall_time_us = 0;  // Time spent blocked in those reads
+  uint64_t seeks = 0;          // Seeks that fell outside the window
+};
+
+// Callback reporting stall increments (count, seconds) since the last call.
+using ReadStallCallback = std::function<void(uint64_t stalls, double stall_seconds)>;
+
+// ReadAheadFile keeps a window of compressed data in memory ahead of the
+// demuxer, so storage hiccups (NFS, busy disks) are absorbed by the window
+// instead of blocking the decode thread.
+//
+// Design:
+// - A fill thread reads chunk_bytes at a time into a ring of window_bytes
+// - Read() copies out of the ring and only blocks when the ring is empty
+// - Forward seeks inside the window just skip buffered bytes; any other
+//   seek discards the window and refills from the new offset
+// - Reads that block after the window has been primed count as stalls
+//   (the first fill after Open() or a seek does not)
+// - With an IoRing there is no fill thread: reads are queued on the ring,
+//   each completion queues the next, and one starts again once
+//   chunk_bytes are free. The window is registered with the IoRing, so
+//   reads land in it without a per-read page lookup
+//
+// Thread Model:
+// - Read()/Seek() from one consumer thread (the demuxer)
+// - GetStats() from any thread
+// - With an IoRing, completions on its completion thread
+class ReadAheadFile {
+ public:
+  static constexpr size_t kDefaultChunkBytes = 256 * 1024;
+
+  // A null or closed io_ring reads with a fill thread.
+  explicit ReadAheadFile(size_t window_bytes,
+                         size_t chunk_bytes = kDefaultChunkBytes,
+                         std::shared_ptr<runtime::IoRing> io_ring = nullptr);
+
+  ~ReadAheadFile();
+
+  // Disable copy and move
+  ReadAheadFile(const ReadAheadFile&) = delete;
+  ReadAheadFile& operator=(const ReadAheadFile&) = delete;
+
+  // Opens a local file and starts prefetching from offset 0.
+  // Returns false if the file cannot be opened.
+  bool Open(const std::string& path);
+
+  // Stops the fill thread (or waits for the read in flight) and closes the
+  // file.
+  void Close();
+
+  // Copies up to size bytes from the current position. Returns the number of
+  // bytes copied, 0 at end of file, or -1 on a read error.
+  int64_t Read(uint8_t* dst, size_t size);
+
+  // Repositions the read offset (SEEK_SET, SEEK_CUR or SEEK_END).
+  // Returns the new offset, or -1 if it is out of range.
+  int64_t Seek(int64_t offset, int whence);
+
+  // Returns the file size in bytes.
+  int64_t Size() const { return file_size_; }
+
+  // Returns the number of bytes currently buffered ahead of the reader.
+  size_t Buffered() const;
+
+  ReadAheadStats GetStats() const;
+
+  // Returns an AVIOContext that reads through this file, or nullptr without
+  // FFmpeg. The context must be released with FreeIOContext() before this
+  // object is destroyed.
+  AVIOContext* CreateIOContext();
+  static void FreeIOContext(AVIOContext** io_ctx);
+
+ private:
+  void FillLoop();
+
+  // IoRing reads: queues the next one if none is in flight and a chunk of
+  // the window is free (mutex_ held; the caller submits).
+  void QueueReadLocked();
+  void OnReadComplete(uint64_t generation, int64_t offset, size_t length, int32_t result);
+
+  const size_t capacity_;
+  const size_t chunk_bytes_;
+  std::unique_ptr<uint8_t[]> ring_;
+
+  std::ifstream file_;  // Fill thread only (after Open)
+  const std::shared_ptr<runtime::IoRing> io_ring_;  // Null = fill thread
+  int fd_ = -1;                                     // IoRing reads
+  int buffer_index_ = -1;                           // ring_ registered with io_ring_
+  int64_t file_size_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable data_cv_;   // Signals the reader
+  std::condition_variable space_cv_;  // Signals the fill thread
+  size_t head_ = 0;          // Ring index of the next byte to read
+  size_t buffered_ = 0;      // Bytes ready after head_
+  int64_t read_offset_ = 0;  // File offset of head_
+  uint64_t generation_ = 0;  // Bumped on each window reset
+  bool primed_ = false;      // Window has been filled since the last reset
+  bool eof_ = false;
+  bool error_ = false;
+  bool stop_ = false;
+  bool read_in_flight_ = false;  // IoRing reads
+  ReadAheadStats stats_;
+
+  std::thread fill_thread_;
+};
+
+}  // namespace retrovue::decode
+
+#endif  // RETROVUE_DECODE_READ_AHEAD_FILE_H_
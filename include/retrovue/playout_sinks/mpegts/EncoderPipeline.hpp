@@ -6,32 +6,124 @@
 #ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_ENCODER_PIPELINE_HPP_
 #define RETROVUE_PLAYOUT_SINKS_MPEGTS_ENCODER_PIPELINE_HPP_
 
+#include "retrovue/buffer/AssetRegistry.h"
 #include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+#include "retrovue/playout_sinks/mpegts/MuxInterleaver.hpp"
+#include "retrovue/playout_sinks/mpegts/SilentAacCache.hpp"
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+#include "retrovue/playout_sinks/mpegts/TsFillerClip.hpp"
+#include "retrovue/playout_sinks/mpegts/TsPacketInspector.hpp"
+#include "retrovue/telemetry/EncoderTelemetry.h"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <functional>
-#include <map>
 
 #ifdef RETROVUE_FFMPEG_AVAILABLE
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
 #include <libavutil/imgutils.h>
+#include <libswresample/swresample.h>
 #include <libswscale/swscale.h>
 }
 #endif
 
 namespace retrovue::buffer {
 struct Frame;
+struct AudioFrame;
+class FrameHandle;
 }  // namespace retrovue::buffer
 
 namespace retrovue::playout_sinks::mpegts {
 
+// One coded GOP of the main video: complexity is its bits times their
+// quantizer step per second, what it would cost at a common quality (bits
+// alone when the encoder does not report QP).
+struct GopComplexity {
+  double complexity = 0.0;
+  int64_t bits = 0;
+  int frames = 0;
+  int64_t duration_us = 0;
+};
+
+// Receives each completed GOP's complexity. Called on the encode thread.
+using GopComplexityCallback = std::function<void(const GopComplexity& gop)>;
+
+// Returns a short name for logs ("software", "nvenc", "qsv", "vaapi", "auto").
+const char* EncoderBackendName(EncoderBackend backend);
+
 // EncoderPipeline owns FFmpeg encoder and muxer handles.
 // It initializes the encoder in open(), encodes frames via encodeFrame(),
 // and closes the muxer on close().
+//
+// The video encoder is opened on the first frame (its size is needed for
+// hardware surfaces) with config.encoder_backend, falling back to software
+// encode when the device or encoder is unavailable. NVENC takes frames from
+// system memory; QSV and VAAPI frames are converted to NV12 and uploaded to
+// a device surface pool.
+//
+// Pooled frames passed as a FrameHandle skip the copy into the encoder's
+// own frame when the encoder takes I420 from system memory and the planes
+// are aligned: the payload is wrapped in a read-only AVBufferRef holding a
+// handle reference, and the slot returns to its pool when the codec drops
+// the picture.
+//
+// Unless config.underflow_policy is SKIP, opening the video encoder also
+// pre-encodes a black clip (an IDR and gop_size - 1 P-frames) with a second
+// encoder configured like this one. EmitFiller() splices a frame of it into
+// the stream with only a timestamp patch, so underflow filler costs no
+// encode.
+//
+// With config.enable_audio the stream carries an audio track. For
+// AudioSource::PRODUCER, encodeAudioFrame() resamples the producers' PCM
+// and encodes it (AAC or AC-3), padding gaps with silence; otherwise the
+// silent AAC access unit SilentAacCache holds for the configured layout is
+// muxed with fresh timestamps to keep pace with video, so silence costs no
+// encode either.
+//
+// Each coded GOP of the main video is reported to the GopComplexityCallback
+// as it completes (on the next keyframe), and SetVideoBitrate() changes the
+// encoder's rate between frames, which is all a statmux needs of it.
+//
+// Every packet goes through a MuxInterleaver clocked by the video frames
+// being encoded, so A/V interleaving delay before the muxer is about one
+// frame and visible in GetMuxStats().
+//
+// With config.native_mux (and a write callback) the interleaved packets go
+// to a TSMuxer instead of libavformat's mpegts muxer; format_ctx_ still
+// holds the stream parameters. The native muxer tracks continuity counters
+// as it builds packets, so its output skips the TsPacketInspector pass and
+// GetTsStats() stays at zero.
+//
+// With config.ts_cache (native mux only), EmitCachedFrame() splices the
+// cached airing of an asset in place of its frames: from the asset's first
+// frame (asset_start), each frame is sent as the matching frame of the
+// cached clip, re-timed, audio included, so the asset costs no encode. An
+// asset that is not cached is recorded as it airs: the interleaver's
+// packets from its first frame (forced to an IDR) are muxed a second time,
+// rebased to PTS 0, into a clip that goes into the cache once the asset
+// ends without a gap. Renditions are encoded as before.
+//
+// Compressed frames (PixelFormat::kH264, from a passthrough producer) are
+// not encoded: each access unit goes to the interleaver as a packet at the
+// frame's time, with the audio muxed as for encoded frames. A frame lost
+// before the pipeline (late or queue drop) holds output until the next
+// keyframe, since its successors reference it; the first encoded frame
+// after compressed ones is an IDR.
+//
+// Device frames (PixelFormat::kDevice, from a producer with device_frames)
+// are sent to an encoder on their own device as they are: VAAPI surfaces
+// to the VA-API encoder, CUDA to NVENC, QSV to QSV. The encoder opens on
+// the device of the first one (reopening, with an IDR, if they arrive at
+// an encoder opened for system memory) and uploads any system-memory
+// frames that follow into its own surfaces there. 10-bit surfaces, other
+// configured backends, or a device encoder that will not open get each
+// frame downloaded instead (GetDeviceDownloads()).
 class EncoderPipeline {
  public:
   explicit EncoderPipeline(const MpegTSPlayoutSinkConfig& config);
@@ -63,6 +155,17 @@ class EncoderPipeline {
   // Returns true on success, false on failure (non-fatal errors may be logged and continue)
   virtual bool encodeFrame(const retrovue::buffer::Frame& frame, int64_t pts90k);
 
+  // Encode a pooled frame, in place when possible (see the class comment);
+  // otherwise the same as encodeFrame(*handle, pts90k).
+  virtual bool encodeFrame(const retrovue::buffer::FrameHandle& handle, int64_t pts90k);
+
+  // Encode producer audio (PCM S16 interleaved, any rate and channel
+  // count) into the audio track; call with the frames up to the end of the
+  // next video frame before encoding it. Audio before the first video frame
+  // is dropped. Returns false on invalid input or an encode error; true
+  // (ignored) when the track is silent or disabled.
+  virtual bool encodeAudioFrame(const retrovue::buffer::AudioFrame& audio);
+
   // Close muxer and encoder, releasing all resources.
   // Safe to call multiple times.
   virtual void close();
@@ -70,6 +173,78 @@ class EncoderPipeline {
   // Check if encoder is initialized and ready.
   virtual bool IsInitialized() const;
 
+  // Returns the backend the video encoder opened with (SOFTWARE until the
+  // first frame has been encoded).
+  EncoderBackend GetActiveBackend() const;
+
+  // Returns the TS packet inspector counters for this muxer session.
+  TsInspectorStats GetTsStats() const;
+
+  // Returns the A/V interleaving queue counters. Safe to call from any thread.
+  MuxQueueStats GetMuxStats() const;
+
+  // Makes the next encoded frame a keyframe (a client joined mid-stream).
+  // Safe to call from any thread.
+  void RequestKeyframe();
+
+  // Changes the video bitrate from the next frame (an MPTS statmux
+  // allocation, or the rate fitted to the clients with adaptive_bitrate),
+  // for encoders that reconfigure on the fly; 0 = back to config.bitrate.
+  // Safe to call from any thread.
+  void SetVideoBitrate(int64_t bps) { video_bitrate_.store(bps, std::memory_order_relaxed); }
+
+  // Receives each GOP's complexity (null = off). Call before open().
+  void SetGopComplexityCallback(GopComplexityCallback callback) {
+    on_gop_complexity_ = std::move(callback);
+  }
+
+  // Emits one pre-encoded underflow filler frame presenting at pts90k.
+  // BLACK_FRAME plays the black clip from its IDR; FRAME_FREEZE sends its
+  // all-skip P-frames, which repeat the last picture the client decoded.
+  // The next encoded frame is forced to a keyframe. Returns false if there
+  // is no filler (SKIP, stub mode, or no frame encoded yet).
+  bool EmitFiller(int64_t pts90k);
+
+  // Sends frame, presenting at pts90k, from the TS asset cache (see the
+  // class comment), or starts or ends recording its asset. Call before
+  // encoding the frame and its audio: returns true if it was sent from the
+  // cache (skip both), false if it must be encoded. A repeat (frame sent
+  // before, at an earlier tick) does not start its asset's airing again.
+  bool EmitCachedFrame(const retrovue::buffer::Frame& frame, int64_t pts90k,
+                       bool repeat = false);
+
+  // Names the overlays the sink composites onto the frames that follow
+  // (empty = none). Cached airings are keyed by it as well, so a change of
+  // overlays ends a recording or cached run.
+  void SetOverlayKey(const std::string& key) {
+    if (key != overlay_key_) {
+      overlay_key_ = key;
+    }
+  }
+
+  // Frames sent from the TS asset cache. Safe to call from any thread.
+  uint64_t GetCachedFrames() const { return cached_frames_.load(std::memory_order_relaxed); }
+
+  // Compressed frames muxed as they came, and those dropped waiting for a
+  // keyframe. Safe to call from any thread.
+  uint64_t GetPassthroughFrames() const {
+    return passthrough_frames_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetPassthroughSkips() const {
+    return passthrough_skips_.load(std::memory_order_relaxed);
+  }
+
+  // Device frames encoded from their GPU surface, and those downloaded for
+  // an encoder that could not take them. Safe to call from any thread.
+  uint64_t GetDeviceFrames() const { return device_frames_.load(std::memory_order_relaxed); }
+  uint64_t GetDeviceDownloads() const {
+    return device_downloads_.load(std::memory_order_relaxed);
+  }
+
+  // Threads the software encoder runs with from the config encoder_threads
+  // budget (0 = not in it). Safe to call from any thread.
+  int GetEncoderThreads() const { return encoder_threads_.load(std::memory_order_relaxed); }
+
  private:
 #ifdef RETROVUE_FFMPEG_AVAILABLE
   // FFmpeg encoder context
@@ -86,6 +261,9 @@ class EncoderPipeline {
   
   // Input frame buffer (for pixel format conversion)
   AVFrame* input_frame_;
+
+  // Borrows a pooled frame's payload for one send (owns no pixel buffers)
+  AVFrame* wrapped_frame_ = nullptr;
   
   // Packet buffer (reused for each encoded packet)
   AVPacket* packet_;
@@ -99,6 +277,22 @@ class EncoderPipeline {
   
   // Input pixel format (defaults to YUV420P)
   AVPixelFormat input_pix_fmt_;
+
+  // System-memory format of frame_ (NV12 when uploading to a device)
+  AVPixelFormat encoder_sw_pix_fmt_;
+
+  // Hardware encode (QSV/VAAPI): device and the surface frame_ is uploaded into
+  AVBufferRef* hw_device_ctx_;
+  AVFrame* hw_frame_;
+
+  // Device frames (PixelFormat::kDevice): the frames context of the one the
+  // encoder is opening for (borrowed), whether it is on their device, the
+  // reference sent for one, and the download of those it cannot take
+  AVBufferRef* surface_frames_ = nullptr;
+  bool device_input_ = false;
+  bool surface_encoder_failed_ = false;  // Until close()
+  AVFrame* surface_frame_ = nullptr;
+  retrovue::buffer::Frame downloaded_frame_;
   
   // Flag to track if swscale context needs to be recreated
   bool sws_ctx_valid_;
@@ -117,36 +311,12 @@ class EncoderPipeline {
   int (*avio_write_callback_)(void* opaque, uint8_t* buf, int buf_size);  // C-style callback
   AVIOContext* custom_avio_ctx_;
   
-  struct ContinuityState {
-    uint8_t last_cc = 0;
-    bool initialized = false;
-  };
-  struct ContinuityTestState {
-    uint8_t last_cc = 0;
-    bool initialized = false;
-  };
-
-  // TS packet tracking and validation
-  // Continuity counter per PID (video PID typically 256)
-  std::map<uint16_t, ContinuityState> continuity_counters_;
-  uint64_t continuity_corrections_ = 0;
-  std::map<uint16_t, ContinuityTestState> continuity_test_counters_;
-  uint64_t continuity_test_packets_ = 0;
-  uint64_t continuity_test_mismatches_ = 0;
-  std::map<uint16_t, uint64_t> continuity_test_pid_packets_;
-  std::map<uint16_t, uint64_t> continuity_test_pid_mismatches_;
-  
   // Last PTS/DTS for monotonicity validation
   int64_t last_pts_90k_;
   int64_t last_dts_90k_;
   bool last_pts_valid_;
   bool last_dts_valid_;
   
-  // PCR tracking (last PCR value and time)
-  int64_t last_pcr_90k_;
-  int64_t last_pcr_packet_time_us_;
-  bool last_pcr_valid_;
-  
   // Packet alignment buffer (for ensuring 188-byte TS packet boundaries)
   std::vector<uint8_t> packet_alignment_buffer_;
   
@@ -155,11 +325,181 @@ class EncoderPipeline {
   int64_t last_packet_time_us_;
   static constexpr int64_t kStallTimeoutUs = 1'000'000;  // 1 second
   
+  // Opens the video encoder for width x height: the configured backend,
+  // then software. Replaces any encoder already open.
+  bool OpenVideoEncoder(int width, int height);
+
+  // Allocates codec_ctx_ for backend and opens it; false (with nothing left
+  // allocated) if the encoder or its device is unavailable.
+  bool TryOpenEncoder(EncoderBackend backend, int width, int height);
+
+  // Creates the device and NV12 surface pool that QSV/VAAPI encode from,
+  // on the device of surface_frames_ when it is one for backend (NVENC too).
+  bool InitHardwareFrames(EncoderBackend backend, int width, int height);
+
+  // With config.adaptive_bitrate, caps the rate at bit_rate with a one-second
+  // VBV, so a lowered rate holds over each second a client's path carries
+  // (set from the open on: encoders cannot turn the VBV on mid-stream).
+  void ApplyVbv();
+
+  // With config.encoder_threads, sets the software encoder's threads and
+  // slices from the budget, joining it (again, at a new size) first.
+  void ApplyThreadBudget(int width, int height);
+  void LeaveThreadBudget();
+
+  // A new allocation is waiting and the next frame starts a GOP anyway, so
+  // reopening with it costs no extra IDR.
+  bool ThreadReopenDue() const;
+
+  // Whether a device frame's surface can be encoded where it is.
+  bool CanEncodeSurface(const AVFrame* surface) const;
+
+  // Encodes a device frame from a download into system memory.
+  bool EncodeDownloaded(const retrovue::buffer::Frame& frame, int64_t pts90k);
+
+  // Frees codec_ctx_ and any hardware encode state.
+  void CloseVideoEncoder();
+
+  // Encodes frame; handle, if set, owns frame and allows the in-place send.
+  bool EncodeInput(const retrovue::buffer::Frame& frame,
+                   const retrovue::buffer::FrameHandle* handle, int64_t pts90k);
+
+  // Whether frame's planes meet the encoder's format and alignment for an
+  // in-place send.
+  bool CanWrapFrame(const retrovue::buffer::Frame& frame) const;
+
+  // Points wrapped_frame_ at handle's payload; false if the buffer could
+  // not be allocated.
+  bool WrapFrame(const retrovue::buffer::FrameHandle& handle);
+
+  // Muxes silent audio frames up to until_90k (the end of the video frame
+  // at pts90k); restarts the audio clock at pts90k if it drifted away.
+  void MuxSilentAudio(int64_t pts90k, int64_t until_90k);
+
+  // Opens the producer audio encoder and its stream; false (with nothing
+  // left allocated) if the codec is unavailable.
+  bool OpenAudioEncoder(const MpegTSPlayoutSinkConfig& config);
+
+  // Frees the audio encoder, FIFO and resampler.
+  void CloseAudioEncoder();
+
+  // (Re)creates the resampler for S16 input at in_rate / in_channels.
+  bool ConfigureResampler(int in_rate, int in_channels);
+
+  // Input-timeline time the audio track reaches (encoded plus queued samples).
+  int64_t AudioEnd90k() const;
+
+  // Queues samples of silence (at most a second) onto the audio FIFO.
+  void WriteSilence(int64_t samples);
+
+  // Pads the producer audio track with silence up to until_90k.
+  void PadAudio(int64_t until_90k);
+
+  // Encodes every whole encoder frame in the audio FIFO.
+  bool EncodeQueuedAudio();
+
+  // Sends frame (null flushes) to the audio encoder and queues its packets.
+  bool SendAudio(AVFrame* frame);
+
+  // Writes queued packets due at clock_90k, logging muxer errors.
+  void DrainMuxQueue(int64_t clock_90k);
+
+  // Reports an encoded video packet's size, picture type and QP to the
+  // encoder telemetry.
+  void RecordVideoPacket(const AVPacket* packet);
+
+  // Native muxing (config.native_mux): opens native_muxer_ for the streams
+  // in format_ctx_, writing through avio_write_callback_.
+  bool OpenNativeMuxer();
+  static int NativeMuxThunk(void* opaque, AVPacket* packet);
+  static int NativeWriteThunk(void* opaque, uint8_t* buf, int buf_size);
+  std::unique_ptr<TSMuxer> native_muxer_;
+
+  // Audio track (config.enable_audio): its stream and the audio clock
+  // (samples encoded or muxed since audio_start_90k_)
+  AVStream* audio_stream_ = nullptr;
+  bool audio_started_ = false;
+  int64_t audio_start_90k_ = 0;
+  int64_t audio_samples_ = 0;
+  int64_t last_audio_dts_ = 0;
+  bool last_audio_dts_valid_ = false;
+
+  // Silent audio: the cached track and one padded copy of its access unit
+  // shared by every packet
+  std::shared_ptr<const SilentAacTrack> silent_audio_;
+  AVBufferRef* audio_unit_ = nullptr;
+  bool mux_silent_audio_ = true;  // False for the filler encoder (PMT entry only)
+
+  // Producer audio: encoder, its input frame, FIFO of resampled planar
+  // samples, and the resampler from the producers' S16 layout
+  AVCodecContext* audio_codec_ctx_ = nullptr;
+  AVFrame* audio_frame_ = nullptr;
+  AVAudioFifo* audio_fifo_ = nullptr;
+  SwrContext* swr_ctx_ = nullptr;
+  int swr_in_rate_ = 0;
+  int swr_in_channels_ = 0;
+  std::vector<float> audio_convert_;  // Resampler output, one plane per channel
+  std::vector<float> audio_silence_;  // One encoder frame of zeros
+
+  // Pre-encodes filler_ at width x height (no-op for SKIP).
+  void BuildFiller(int width, int height);
+
+  // Underflow filler: the clip, the next clip frame to emit, and whether
+  // filler was emitted since the last encoded frame
+  TsFillerClip filler_;
+  size_t filler_next_ = 0;
+  bool filler_active_ = false;
+  std::vector<uint8_t> filler_buffer_;  // Re-timed frame being emitted
+
+  // TS asset cache (config.ts_cache): an airing being recorded, and one
+  // being sent from the cache
+  struct CacheRecord {
+    std::string uri;
+    std::string profile;
+    std::string overlays;        // Overlay key it was recorded with
+    retrovue::buffer::AssetId asset = retrovue::buffer::kNoAsset;
+    int64_t start_90k = 0;       // Input PTS of the asset's first frame
+    int64_t next_pts90k = 0;     // Expected PTS of its next frame
+    TSMuxer muxer;               // Muxes the copy, rebased to PTS 0, into ts
+    std::vector<uint8_t> ts;
+  };
+  struct CachedRun {
+    std::shared_ptr<const TsFillerClip> clip;
+    std::string overlays;        // Overlay key of the airings it replays
+    retrovue::buffer::AssetId asset = retrovue::buffer::kNoAsset;
+    int64_t start_90k = 0;       // Input PTS the clip's first frame presents at
+    size_t next = 0;             // Next clip frame to send
+  };
+
+  // Profile the cached clips of this encoder are keyed by: the stream's
+  // codecs and their settings at width x height, and the overlays.
+  std::string CacheProfile(int width, int height) const;
+  MuxerConfig NativeMuxerConfig() const;
+
+  // Starts recording uri's airing from its first frame at pts90k.
+  void BeginCacheRecord(const std::string& uri, const std::string& profile,
+                        retrovue::buffer::AssetId asset, int64_t pts90k);
+  // Ends the recording at end_90k, into the cache if keep.
+  void FinishCacheRecord(int64_t end_90k, bool keep);
+  // Leaves a cached run at end_90k: the next frame is encoded as an IDR
+  // and the audio track continues after the clip's.
+  void EndCachedRun(int64_t end_90k);
+  // Interleaver tap: the recording's copy of each muxed packet.
+  static void RecordMuxedPacket(void* opaque, const AVPacket* packet);
+
+  std::unique_ptr<CacheRecord> cache_record_;
+  std::unique_ptr<CachedRun> cached_run_;
+  bool cache_resync_ = false;  // A cached run ended since the last encoded frame
+  std::vector<uint8_t> cache_buffer_;  // Re-timed clip frames being sent
+
+  // Queues a compressed frame's access unit for the muxer at pts90k.
+  bool MuxCompressedFrame(const retrovue::buffer::Frame& frame, int64_t pts90k);
+
+  bool passthrough_active_ = false;  // The last frame was muxed compressed
+  bool passthrough_wait_keyframe_ = true;  // Compressed frames are dropped up to a keyframe
+
   // Helper methods for TS packet parsing and validation
   void ProcessTSPackets(uint8_t* data, size_t size);
-  uint8_t ExtractContinuityCounter(const uint8_t* ts_packet);
-  uint16_t ExtractPID(const uint8_t* ts_packet);
-  bool ExtractPCR(const uint8_t* ts_packet, int64_t& pcr_90k);
   bool ValidatePacketAlignment(const uint8_t* data, size_t size);
   
   // Write callback wrapper that ensures packet alignment
@@ -170,6 +510,45 @@ class EncoderPipeline {
 
   const MpegTSPlayoutSinkConfig& config_;
   bool initialized_;
+  EncoderBackend active_backend_;
+
+  // Continuity repair and sampled validation of every muxed TS packet
+  TsPacketInspector ts_inspector_;
+
+  // Every encoded packet, in DTS order, on its way to the muxer
+  MuxInterleaver mux_queue_;
+
+  std::atomic<bool> keyframe_requested_{false};
+  std::atomic<int64_t> video_bitrate_{0};  // SetVideoBitrate(); 0 = config bitrate
+  std::atomic<uint64_t> cached_frames_{0};
+  std::atomic<uint64_t> passthrough_frames_{0};
+  std::atomic<uint64_t> passthrough_skips_{0};
+  std::atomic<uint64_t> device_frames_{0};
+  std::atomic<uint64_t> device_downloads_{0};
+  std::string overlay_key_;  // SetOverlayKey(); encode thread only
+
+  // Charges encode and mux CPU time to the channel (config cpu_account)
+  retrovue::telemetry::StageCpuMeter cpu_meter_;
+
+  // config encoder_telemetry, from open(); null = not recorded
+  retrovue::telemetry::EncoderTelemetry* telemetry_ = nullptr;
+
+  // The GOP being coded, for on_gop_complexity_ (encode thread)
+  GopComplexityCallback on_gop_complexity_;
+  double gop_weighted_bits_ = 0.0;  // Bits times quantizer step
+  int64_t gop_bits_ = 0;
+  int gop_frames_ = 0;
+
+  // The software encoder's share of config encoder_threads: its id there
+  // (0 = not in it), the size it joined at, its threads, a newer allocation
+  // from the budget's callback (0 = none), and the frames since the encoder's
+  // last keyframe (encode thread, except the atomics)
+  uint64_t thread_budget_id_ = 0;
+  int thread_budget_width_ = 0;
+  int thread_budget_height_ = 0;
+  std::atomic<int> encoder_threads_{0};
+  std::atomic<int> pending_threads_{0};
+  int frames_since_key_ = 0;
 };
 
 }  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,113 @@
+// Repository: Retrovue-playout
+// Component: Encoder Thread Budget
+// Purpose: Shares the host's cores among every channel's software video encoder.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_ENCODER_THREAD_BUDGET_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_ENCODER_THREAD_BUDGET_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// What an encoder asks the budget for.
+struct EncoderThreadRequest {
+  int32_t channel_id = -1;
+  int width = 0;
+  int height = 0;
+  double fps = 30.0;
+  int priority = 1;  // Weight against the other encoders (1 = normal)
+};
+
+// Threads, and slices (one per thread), an encoder is opened with.
+struct EncoderThreadAllocation {
+  int threads = 1;
+  int slices = 1;
+};
+
+struct EncoderThreadShare {
+  uint64_t id = 0;
+  int32_t channel_id = -1;
+  int width = 0;
+  int height = 0;
+  int priority = 1;
+  int threads = 0;                 // Current allocation (slices the same)
+};
+
+// EncoderThreadBudgetStats is a point-in-time view of the budget.
+struct EncoderThreadBudgetStats {
+  int total_threads = 0;           // Shared among the encoders
+  int allocated_threads = 0;       // Sum of the allocations (above total: oversubscribed)
+  uint64_t rebalances = 0;         // Encoders added or removed
+  uint64_t reallocations = 0;      // Encoders told of a new allocation
+  std::vector<EncoderThreadShare> encoders;  // In the order they were added
+};
+
+// EncoderThreadBudget gives each software video encoder of the process its
+// thread count, instead of every libx264/libx265 sizing itself to the whole
+// host: 40 encoders on 32 cores would otherwise run over a thousand threads
+// fighting for the same cores.
+//
+// Every encoder gets one thread. The rest of total_threads (the host's
+// cores by default) go one at a time to the encoder with the most work per
+// thread - pixel rate times priority - so all of them get about the same
+// per-thread load. An encoder takes no more than one thread per
+// kRowsPerThread lines of picture (nor kMaxThreads): slices thinner than
+// that cost more in lost prediction than another thread gains. Threads are
+// sliced (one slice each), the only threading that adds no latency.
+//
+// The budget is shared out again whenever an encoder is added or removed
+// (a channel starting, stopping or changing resolution), and each encoder
+// whose allocation moved is told through its ThreadsCallback; the encoder
+// reopens with it where its next GOP would start anyway.
+//
+// Thread Model: all methods are thread-safe. Callbacks run on the calling
+// thread under the budget's lock and must not call back into it.
+class EncoderThreadBudget {
+ public:
+  using ThreadsCallback = std::function<void(EncoderThreadAllocation allocation)>;
+
+  static constexpr int kRowsPerThread = 64;
+  static constexpr int kMaxThreads = 16;
+
+  // total_threads: 0 = the host's hardware threads.
+  explicit EncoderThreadBudget(int total_threads = 0);
+
+  EncoderThreadBudget(const EncoderThreadBudget&) = delete;
+  EncoderThreadBudget& operator=(const EncoderThreadBudget&) = delete;
+
+  // Adds an encoder and returns its id. on_change is called at once with
+  // its first allocation, and whenever it changes, up to RemoveEncoder().
+  uint64_t AddEncoder(const EncoderThreadRequest& request, ThreadsCallback on_change);
+  void RemoveEncoder(uint64_t id);
+
+  EncoderThreadBudgetStats GetStats() const;
+
+ private:
+  struct Encoder {
+    uint64_t id;
+    EncoderThreadRequest request;
+    ThreadsCallback on_change;
+    double weight;  // Pixel rate times priority
+    int cap;
+    int threads = 0;
+  };
+
+  // Shares the threads out and tells the encoders that moved.
+  void RebalanceLocked();
+
+  const int total_threads_;
+
+  mutable std::mutex mutex_;
+  std::vector<Encoder> encoders_;  // In the order they were added
+  uint64_t next_id_ = 1;
+  uint64_t rebalances_ = 0;
+  uint64_t reallocations_ = 0;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_ENCODER_THREAD_BUDGET_HPP_
@@ -0,0 +1,95 @@
+// Repository: Retrovue-playout
+// Component: Frame Cadence
+// Purpose: Maps source frames onto the output frame-rate grid with drop/repeat patterns.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_FRAME_CADENCE_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_FRAME_CADENCE_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// FrameCadenceStats is a point-in-time view of a FrameCadence.
+struct FrameCadenceStats {
+  uint64_t ticks = 0;          // Output frames on the grid
+  uint64_t repeats = 0;        // Of those, the previous frame shown again
+  uint64_t drops = 0;          // Source frames no tick showed
+  uint64_t reanchors = 0;      // Grid restarted at a timeline jump
+  int64_t max_error_us = 0;    // Farthest a shown frame was from its tick
+  int64_t mean_error_us = 0;   // Mean distance of shown frames from their ticks
+};
+
+// FrameCadence resamples frames of any rate onto the output grid, one tick
+// every 1 / output_fps from the first frame's PTS. Each tick shows the
+// frame nearest to it, the latest presenting by kNearTicks of a tick after
+// it: a frame the next one replaces by then is dropped, and a tick no new
+// frame reaches shows the previous one again. That gives 23.976 fps the
+// 3:2 pulldown cadence at 29.97 (every fourth frame twice, as whole frames:
+// the output is progressive), 25 fps one repeat in six, 59.94 fps every
+// other frame dropped and 50 fps two frames in five.
+//
+// The caller keeps the frames; FrameCadence only sees their PTS (in
+// microseconds). A front frame more than kReanchorTicks off the grid (a
+// timeline jump) starts the grid again at it.
+//
+// Thread Model: one thread (the sink's pacing thread); GetStats() from any
+// thread.
+class FrameCadence {
+ public:
+  enum class Action {
+    kShow,    // Show the front frame at the tick
+    kDrop,    // Drop the front frame: the one after it is nearer the tick
+    kRepeat,  // Show the previous frame again at the tick
+  };
+
+  static constexpr double kNearTicks = 0.45;  // Nearest frame, off the usual ties
+  static constexpr int64_t kReanchorTicks = 4;
+
+  explicit FrameCadence(double output_fps);
+
+  // Forgets the grid; the next frame anchors a new one.
+  void Reset();
+
+  // The PTS of the tick the front frame (front_pts) is due for.
+  int64_t Tick(int64_t front_pts);
+
+  // What the tick gets, given the front frame and (next_pts non-null) the
+  // one behind it. can_repeat: there is a previous frame to show.
+  Action Decide(int64_t front_pts, const int64_t* next_pts, bool can_repeat) const;
+
+  // The tick was filled by frame_pts (kShow) or a repeat, and the grid
+  // moves to the next one.
+  void Shown(int64_t frame_pts);
+  void Repeated();
+
+  // A front frame was dropped (kDrop).
+  void Dropped();
+
+  // Late: moves the grid to its first tick at or after pts.
+  void SkipTo(int64_t pts);
+
+  FrameCadenceStats GetStats() const;
+
+ private:
+  int64_t TickAt(int64_t index) const;
+  void Anchor(int64_t pts);
+
+  const double tick_us_;
+  bool anchored_ = false;
+  int64_t origin_pts_ = 0;
+  int64_t index_ = 0;  // Ticks filled since origin_pts_
+
+  std::atomic<uint64_t> ticks_{0};
+  std::atomic<uint64_t> repeats_{0};
+  std::atomic<uint64_t> drops_{0};
+  std::atomic<uint64_t> reanchors_{0};
+  std::atomic<int64_t> max_error_us_{0};
+  std::atomic<uint64_t> shown_{0};
+  std::atomic<int64_t> error_total_us_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_FRAME_CADENCE_HPP_
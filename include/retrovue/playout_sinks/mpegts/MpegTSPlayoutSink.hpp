@@ -7,18 +7,32 @@
 #define RETROVUE_PLAYOUT_SINKS_MPEGTS_MPEGTS_PLAYOUT_SINK_HPP_
 
 #include "retrovue/playout_sinks/IPlayoutSink.h"
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+#include "retrovue/playout_sinks/mpegts/FrameCadence.hpp"
 #include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+#include "retrovue/playout_sinks/mpegts/RenditionLadder.hpp"
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+#include "retrovue/playout_sinks/mpegts/TsHlsSegmenter.hpp"
 #include "retrovue/playout_sinks/mpegts/TsOutputSink.h"
+#include "retrovue/playout_sinks/mpegts/TsPacer.hpp"
+#include "retrovue/playout_sinks/mpegts/TsPacketInspector.hpp"
+#include "retrovue/playout_sinks/mpegts/TsRateAdapter.hpp"
+#include "retrovue/playout_sinks/mpegts/TsSlabRing.hpp"
+#include "retrovue/playout_sinks/mpegts/TsSrtOutput.hpp"
+#include "retrovue/playout_sinks/mpegts/TsUdpOutput.hpp"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/telemetry/MetricsHTTPServer.h"
 #include "retrovue/timing/MasterClock.h"
 
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <cstdint>
 #include <deque>
+#include <optional>
 #include <vector>
 
 namespace retrovue::playout_sinks::mpegts {
@@ -27,23 +41,6 @@ namespace retrovue::playout_sinks::mpegts {
 class PTSController;
 class EncoderPipeline;
 
-// Packet type for encoded packets
-enum class PacketType {
-  AUDIO,
-  VIDEO
-};
-
-// Encoded packet structure for output queue
-struct EncodedPacket {
-  PacketType type;
-  std::vector<uint8_t> data;
-  int64_t pts90k;
-  
-  EncodedPacket() : type(PacketType::VIDEO), pts90k(0) {}
-  EncodedPacket(PacketType type, std::vector<uint8_t> data, int64_t pts90k) 
-    : type(type), data(std::move(data)), pts90k(pts90k) {}
-};
-
 // Internal state machine states
 enum class InternalState {
   Idle,              // Initial state, not started
@@ -60,6 +57,87 @@ enum class InternalState {
 //
 // Critical: MasterClock never pushes ticks or callbacks.
 // The sink calls master_clock_->now_utc_us() whenever it needs the current time.
+//
+// Thread Model:
+// - Worker thread: timing loop (pacing, late-frame drops, output backpressure)
+// - Encode thread: encodes and muxes the frames the worker hands over through
+//   a queue of config.encode_queue_depth frame handles, so a slow encode (IDR,
+//   scene cut) does not delay pacing; when the encoder falls behind, the
+//   oldest queued frame is dropped
+// - Output thread: takes the muxed bytes from a lock-free ring of fixed
+//   slabs (TsSlabRing) and hands them to the clients (or the pacer), so the
+//   encoder never waits on the fanout
+// - Accept thread (TCP mode, or TsOutputSink's in UDS mode): accepts clients
+//   into the fanout
+// - One sender thread per client (TsFanout): every client reads the same
+//   encoder output from its own bounded queue, so a slow client cannot
+//   stall the encoder or the other clients
+//
+// The encoder runs while at least one client is connected: it opens for the
+// first client and closes when the last one leaves. A client joining a
+// running stream starts at the next PAT, and the encoder is asked for a
+// keyframe so the new client can start decoding promptly.
+//
+// With config.warm_start the encoder instead opens in start() and runs
+// whether or not anyone is connected, and the fanout caches the latest GOP:
+// a client that connects is sent PAT/PMT and that GOP at once, then the live
+// stream, so it tunes in without waiting for an encoder open or a keyframe.
+//
+// With config.hibernate_after_ms set, a sink that has had no client (on
+// the main output or any rendition) for that long hibernates: queued frames
+// are discarded, config.on_hibernate pauses the producer, and the worker
+// only watches for clients (waiting on the listen socket). The first client
+// wakes it at once: the encoder opens as usual, stale frames are dropped,
+// and on_hibernate resumes the producer at the schedule-correct position.
+// The encoder is closed throughout, its configuration and caches kept.
+// Sinks whose encoder runs without clients never hibernate.
+//
+// A producer switch reaches the sink as a frame marked splice_point (the
+// first frame of the producer switched in). That frame is encoded as an IDR
+// on the main output and every rendition, so decoders downstream see a
+// clean picture on the first new frame. The muxer is not reset across the
+// switch: continuity counters and PCR run on. A splice frame dropped as
+// late, or behind in the encode queue, passes its mark to the next frame.
+//
+// With config.ts_cache set (native_mux only), an asset aired from its first
+// frame (frames marked asset_start) is recorded into the shared cache as
+// muxed, and later airings of it with the same encoder profile are spliced
+// from there, re-timed, instead of encoded; renditions still encode.
+//
+// With config.overlays set, the overlay set on air (by its schedule, at the
+// frame's emit time) is blended into each frame on the encode thread before
+// the main output or any rendition encodes it. Compressed frames cannot take
+// overlays and go out without them.
+//
+// With config.audio_processing enabled, producer audio goes through an
+// AudioProcessor on the encode thread before any output encodes it: 5.1 is
+// downmixed for a stereo track and loudness is normalized to the target.
+// The output's integrated loudness and gain are recorded in the encoder
+// telemetry, whether or not a client is connected.
+//
+// Compressed frames (PixelFormat::kH264, from a producer in passthrough)
+// are muxed as they are, re-timed like encoded ones, when the channel
+// encodes H.264; after encoded or filler output the stream resumes on the
+// next keyframe. Renditions need decoded frames and are not fed by them.
+//
+// With config.udp_port set, the stream is also sent as UDP or RTP datagrams
+// (TsUdpOutput) to a unicast address or multicast group, and the encoder
+// runs from start() as there is always a receiver.
+//
+// With config.srt_port set, the stream is also carried over an SRT link
+// (TsSrtOutput), as caller or listener, with its own queue so a congested
+// link never holds up the other outputs; the encoder runs from start() here
+// too, and link stats go to config.on_srt_stats.
+//
+// With config.hls_port set, the stream is also cut into HLS (and LL-HLS
+// partial) segments on its IDRs (TsHlsSegmenter), held in memory and served
+// over HTTP on that port, so players need no packager; the encoder runs
+// from start().
+//
+// With config.renditions set, the encode thread also feeds a RenditionLadder:
+// each rendition is scaled from the same frame, encoded while it has
+// clients, and served on its own socket, with keyframes requested across
+// the main output and every rendition together.
 class MpegTSPlayoutSink : public IPlayoutSink {
  public:
   // Constructs sink with frame buffer, master clock, and configuration.
@@ -105,6 +183,35 @@ class MpegTSPlayoutSink : public IPlayoutSink {
     uint64_t network_errors = 0;
     uint64_t buffer_underruns = 0;
     uint64_t late_frame_drops = 0;
+    uint64_t encode_queue_drops = 0;  // Frames dropped because the encoder fell behind
+    uint64_t filler_frames = 0;       // Pre-encoded underflow filler frames emitted
+    uint64_t cached_frames = 0;       // Frames spliced from cached airings (ts_cache)
+    uint64_t passthrough_frames = 0;  // Compressed frames muxed without encoding
+    uint64_t passthrough_skips = 0;   // Compressed frames dropped waiting for a keyframe
+    uint64_t device_frames = 0;       // GPU surfaces encoded without a download
+    uint64_t device_downloads = 0;    // GPU surfaces read back to system memory
+    int encoder_threads = 0;          // Encoder threads from encoder_threads (0 = not in it)
+    uint64_t audio_frames = 0;        // Producer AudioFrames taken from the buffer (PRODUCER audio)
+    uint64_t output_gop_skips = 0;    // Muxer writes discarded after a ring drop, up to the next keyframe
+    bool hibernating = false;         // Idle: producer paused until a client connects
+    uint64_t hibernations = 0;        // Times the sink hibernated
+    uint64_t splices = 0;             // Producer switches, each started on an IDR
+    TsAssetCacheStats ts_cache;       // Shared cache of pre-encoded airings (ts_cache set)
+    EncoderThreadBudgetStats encoder_thread_budget;  // Every channel's encoder threads
+    decode::OverlayCompositorStats overlays;  // Overlay compositing (overlays set)
+    decode::AudioProcessorStats audio_processing;  // Downmix and loudness (audio_processing)
+    TsInspectorStats ts;              // Muxed packet repair/validation (current session)
+    MuxQueueStats mux;                // A/V interleaving ahead of the muxer (current session)
+    TsFanoutStats fanout;             // Connected clients and slow-client handling
+    TsPacerStats pacer;               // CBR pacing (cbr_mux_rate > 0)
+    TsSlabRingStats output;           // Encoder -> clients output ring
+    TsUdpOutputStats udp;             // UDP/RTP output (udp_port > 0)
+    TsSrtOutputStats srt;             // SRT output (srt_port > 0)
+    TsHlsSegmenterStats hls;          // HLS segmenter (hls_port > 0)
+    TsRateAdapterStats rate_adapter;  // Video bitrate fitted to the clients (adaptive_bitrate)
+    FrameCadenceStats cadence;        // Frame-rate conversion (frame_rate_conversion)
+    std::vector<RenditionStats> renditions;  // ABR ladder outputs, largest first
+    retrovue::telemetry::EncoderTelemetrySnapshot encoder;  // Encode time, frame sizes, QP, PCR, output
   };
   SinkStats getStats() const;
 
@@ -115,17 +222,51 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   void workerLoop();
 
   // Process a single frame (encode, mux, send).
-  // frame: Decoded frame from buffer
+  // frame: Decoded frame from buffer (the encoder may send it in place)
+  // audio: Producer audio up to the end of frame, processed (audio_processing)
+  //        and encoded first
   // master_time_us: Current MasterClock time
   // pts90k: PTS in 90kHz units
   // frame_number: Frame sequence number for logging
   // drift_us: Timing drift in microseconds
-  void processFrame(const retrovue::buffer::Frame& frame, int64_t master_time_us,
-                    int64_t pts90k, uint64_t frame_number, int64_t drift_us);
-
-  // Handle buffer underflow (empty buffer).
+  // repeat: frame was processed before, at an earlier tick (cadence): it
+  //         starts no splice or airing and keeps the overlays it has
+  void processFrame(const retrovue::buffer::FrameHandle& frame,
+                    std::vector<retrovue::buffer::AudioFrame>& audio,
+                    int64_t master_time_us, int64_t pts90k, uint64_t frame_number,
+                    int64_t drift_us, bool repeat = false);
+
+  // Pops buffered audio frames presenting before pts_us into audio (worker).
+  void popAudioUntil(int64_t pts_us, std::vector<retrovue::buffer::AudioFrame>* audio);
+
+  // Emits one pre-encoded filler frame at pts90k on the main output and
+  // every open rendition (encode thread, or worker when not queued).
+  void processFiller(int64_t pts90k);
+
+  // Hands a due frame to the encode thread, or processes it inline when
+  // config_.encode_queue_depth is 0.
+  void submitFrame(retrovue::buffer::FrameHandle frame,
+                   std::vector<retrovue::buffer::AudioFrame> audio, int64_t master_time_us,
+                   int64_t pts90k, uint64_t frame_number, int64_t drift_us,
+                   bool repeat = false);
+
+  // Encode thread: processes submitted frames in order until stopped, then
+  // finishes whatever is still queued.
+  void encodeLoop();
+
+  // Drops frames not yet encoded (client gone).
+  void clearEncodeQueue();
+
+  // Hands an encoded sampled frame's trace to the output thread, which adds
+  // the send time in completeFrameTrace() and reports it through
+  // config_.on_frame_trace.
+  void traceEncodedFrame(const retrovue::buffer::FrameTrace& trace, uint64_t output_bytes);
+  void completeFrameTrace();
+
+  // Handle buffer underflow (empty buffer): once a frame slot is missed by
+  // more than the late tolerance, queues pre-encoded filler for it per
+  // config_.underflow_policy (see EncoderPipeline::EmitFiller()).
   // master_time_us: Current MasterClock time
-  // TODO: Implement underflow policy (frame freeze/black/skip)
   void handleBufferUnderflow(int64_t master_time_us);
 
   // Handle buffer overflow (drop late frames).
@@ -147,27 +288,44 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   // TODO: Implement TCP accept loop
   void acceptThread();
 
-  // Send data to TCP socket (non-blocking).
-  // Returns true on success, false on failure (including EAGAIN).
-  // TODO: Implement non-blocking socket send
+  // Queue data for every connected client (never blocks).
+  // Returns false if no client is connected.
   bool sendToSocket(const uint8_t* data, size_t size);
   
-  // Try to drain output queue (send pending packets).
-  // Returns number of packets successfully sent.
-  // Non-blocking: returns immediately if socket would block.
-  size_t drainOutputQueue();
-  
-  // Queue an encoded packet for sending.
-  // Returns true if queued, false if queue overflow (packet dropped).
-  bool queueEncodedPacket(PacketType type, std::vector<uint8_t> data, int64_t pts90k);
-  
-  // Handle client disconnect (cleanup and prepare for reconnect).
+  // Output thread: hands output_ring_ slabs to the clients (or the pacer)
+  // in order until stopped and drained.
+  void outputLoop();
+
+  // Waits (bounded) for the output thread to empty output_ring_.
+  void waitOutputDrained();
+
+  // Handle the last client leaving (close encoder, prepare for reconnect).
   void handleClientDisconnect();
   
-  // Try to accept a new client connection (non-blocking).
-  // Returns true if client connected, false otherwise.
+  // Accept pending TCP client connections into the fanout (non-blocking).
+  // Returns true if any client was added.
   bool tryAcceptClient();
+
+  // Worker thread: opens the encoder for the first client, requests a
+  // keyframe when another joins, and closes it when the last one leaves
+  // (nothing to do once a warm start has opened the encoder).
+  void updateSubscribers();
   
+  // Worker thread: enters hibernation once no client has been connected for
+  // config_.hibernate_after_ms, and leaves it when one connects. Returns true
+  // while hibernating (the worker then skips the frame path).
+  bool updateHibernation(int64_t now_us);
+
+  // True if a client is connected to the main output or any rendition.
+  bool hasClients() const;
+
+  // Hibernating worker: waits (bounded) for a connection on the listen
+  // socket, or sleeps briefly when clients arrive through another socket.
+  void waitForClient();
+
+  // Drops every queued frame and audio frame (worker thread).
+  void discardBufferedFrames();
+
   // Initialize encoder pipeline for new client.
   // Returns true on success, false on failure.
   bool initializeEncoderForClient();
@@ -187,22 +345,118 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   std::thread worker_thread_;
   std::thread accept_thread_;  // Optional: for accepting TCP clients
 
-  // TCP socket (used when ts_socket_path is empty)
+  // TCP listen socket (used when ts_socket_path is empty)
   int listen_fd_;
-  int client_fd_;
-  std::atomic<bool> client_connected_;
-  
+  std::atomic<bool> client_connected_;  // Encoder open (for a client, or warm_start)
+  uint64_t subscribers_seen_ = 0;       // fanout_ subscribers_total at last check (worker)
+  int64_t idle_since_us_ = -1;          // MasterClock time the last client left (worker; -1 = connected)
+  std::atomic<bool> hibernating_{false};
+  std::atomic<uint64_t> hibernations_{0};
+  bool splice_carry_ = false;           // A dropped splice frame's mark, for the next frame (worker)
+  std::atomic<uint64_t> splices_{0};
+  std::atomic<uint64_t> device_downloads_{0};  // For overlays and renditions
+
+  // Connected clients (TCP or UDS), all fed from the one encoder output
+  TsFanout fanout_;
+
   // Unix Domain Socket sink (used when ts_socket_path is set)
   std::unique_ptr<TsOutputSink> ts_output_sink_;
 
   // Subsystems
   std::unique_ptr<PTSController> pts_controller_;
   std::unique_ptr<EncoderPipeline> encoder_pipeline_;
-
-  // Output queue for encoded packets
-  std::deque<EncodedPacket> output_queue_;
-  mutable std::mutex output_queue_mutex_;
-  std::atomic<uint64_t> packets_dropped_{0};  // Packets dropped due to queue overflow
+  std::mutex encoder_mutex_;  // Serializes encoder open/close/encode across threads
+
+  // ABR renditions encoded from the same frames (null without config_.renditions)
+  std::unique_ptr<RenditionLadder> rendition_ladder_;
+
+  // Downmix and loudness normalization of producer audio (null unless
+  // config_.audio_processing.enabled)
+  std::unique_ptr<decode::AudioProcessor> audio_processor_;
+
+  // CBR pacing between the muxer and the clients (null unless cbr_mux_rate > 0)
+  std::unique_ptr<TsPacer> ts_pacer_;
+
+  // UDP/RTP output alongside the clients (null unless udp_port > 0)
+  std::unique_ptr<TsUdpOutput> udp_output_;
+
+  // SRT contribution link alongside the clients (null unless srt_port > 0)
+  std::unique_ptr<TsSrtOutput> srt_output_;
+
+  // In-memory HLS segments and their HTTP server (null unless hls_port > 0)
+  std::unique_ptr<TsHlsSegmenter> hls_segmenter_;
+  std::unique_ptr<telemetry::MetricsHTTPServer> hls_server_;
+
+  // Fits the video bitrate to the slowest client (null unless
+  // adaptive_bitrate and the clients are the only output)
+  std::unique_ptr<TsRateAdapter> rate_adapter_;
+
+  // True once start() joined config_.mpts as a program (until stop())
+  bool mpts_joined_ = false;
+
+  // True if the encoder runs from start() whether or not clients are
+  // connected (warm_start, or a UDP, SRT, HLS or MPTS output that always has
+  // a receiver).
+  bool encodesWithoutClients() const {
+    return config_.warm_start || udp_output_ != nullptr || srt_output_ != nullptr ||
+           hls_segmenter_ != nullptr || config_.mpts != nullptr;
+  }
+
+  // Creates the UDP, SRT and HLS outputs the config asks for, and the rate
+  // adapter (constructors).
+  void createNetworkOutputs();
+
+  // Starts the pacer, writing ahead for UDP kernel pacing when it is on.
+  bool startPacer();
+
+  // Adds this channel to config_.mpts and hands the encoder's rate to its
+  // statmux (start()).
+  bool joinMpts();
+
+  // TsPacer output (and the output thread without one): packets to the
+  // clients. With UDP kernel pacing the pacer writes ahead, with each
+  // packet's slot time for the launch times.
+  static int pacedWriteCallback(void* opaque, uint8_t* buf, int buf_size);
+  static int pacedTimedWriteCallback(void* opaque, uint8_t* buf, int buf_size,
+                                     const int64_t* slot_utc_us);
+  int emitTsBytes(const uint8_t* buf, int buf_size, const int64_t* slot_utc_us = nullptr);
+
+  // Encode stage (worker -> encode thread)
+  struct EncodeJob {
+    retrovue::buffer::FrameHandle frame;  // Empty: underflow filler at pts90k
+    std::vector<retrovue::buffer::AudioFrame> audio;  // Producer audio up to the frame's end
+    int64_t master_time_us;
+    int64_t pts90k;
+    uint64_t frame_number;
+    int64_t drift_us;
+    bool repeat = false;  // The previous frame again (cadence), by reference
+  };
+  std::thread encode_thread_;
+  std::mutex encode_mutex_;
+  std::condition_variable encode_cv_;
+  std::deque<EncodeJob> encode_queue_;
+  bool encode_stop_ = false;  // Guarded by encode_mutex_
+  std::atomic<uint64_t> encode_queue_drops_{0};
+
+  // Muxed output (encode thread -> output thread)
+  TsSlabRing output_ring_;
+  std::thread output_thread_;
+  std::atomic<bool> output_stop_{false};
+  // A write was dropped mid-GOP: discard writes up to the next keyframe
+  std::atomic<bool> output_resync_{false};
+  std::atomic<uint64_t> output_gop_skips_{0};
+
+  // Sampled frame whose first output bytes the output thread waits for
+  // (encode thread -> output thread; one at a time, a newer one reports the
+  // older without its send time)
+  struct PendingTrace {
+    retrovue::buffer::FrameTrace trace;
+    uint64_t output_bytes = 0;  // output_ring_ bytes written before its encode
+  };
+  std::mutex trace_mutex_;
+  std::optional<PendingTrace> pending_trace_;
+  std::atomic<bool> trace_pending_{false};
+  uint64_t gop_resyncs_seen_ = 0;          // fanout_ gop_resyncs at last check (worker)
 
   // Playout timing state
   // sink_start_time_utc_us is recorded at start() to establish program start time
@@ -210,6 +464,20 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   int64_t sink_start_time_utc_us_{0};
   bool sink_start_time_recorded_{false};
 
+  // Next frame slot underflow filler would fill (worker thread)
+  bool filler_slot_valid_{false};
+  int64_t filler_slot_time_us_{0};   // Target time of the slot
+  int64_t filler_slot_pts90k_{0};
+  std::atomic<uint64_t> filler_frames_{0};
+
+  // Decoded frames resampled onto the target_fps grid (null unless
+  // config_.frame_rate_conversion); the frame the last tick showed is held
+  // for repeats (worker thread)
+  std::unique_ptr<FrameCadence> cadence_;
+  retrovue::buffer::FrameHandle cadence_last_;
+  const retrovue::buffer::Frame* composited_frame_ = nullptr;  // Last overlaid (encode thread)
+  std::atomic<uint64_t> audio_frames_{0};
+
   // Statistics (atomic for thread safety)
   std::atomic<uint64_t> frames_sent_;
   std::atomic<uint64_t> frames_dropped_;
@@ -221,10 +489,13 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   std::atomic<uint64_t> dropped_packets_{0};  // Packets dropped due to EAGAIN
 
  public:
-  // FE-017: Write all bytes atomically (blocks until complete or error)
-  // This ensures TS packets are never split, preserving continuity counters
-  // Returns number of bytes written, or -1 on error
-  int writeAllBlocking(uint8_t* buf, int buf_size);
+  // Queues muxed TS bytes for the output thread, which hands them to every
+  // connected client (via the pacer with cbr_mux_rate); each client's
+  // sender writes whole packets in order (FE-017). Never blocks.
+  // After a write that does not fit, the rest of the GOP is discarded and
+  // an IDR requested, so clients resume cleanly at the next keyframe.
+  // Returns buf_size, or -1 if the output ring is full (bytes dropped)
+  int publishTsBytes(uint8_t* buf, int buf_size);
 };
 
 // C-style callback for FFmpeg AVIO (must be in global scope or extern "C")
@@ -6,31 +6,174 @@
 #ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_MPEGTS_PLAYOUT_SINK_CONFIG_HPP_
 #define RETROVUE_PLAYOUT_SINKS_MPEGTS_MPEGTS_PLAYOUT_SINK_CONFIG_HPP_
 
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/decode/AudioProcessor.h"
+#include "retrovue/decode/OverlayCompositor.h"
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+#include "retrovue/playout_sinks/mpegts/TsAssetCache.hpp"
+#include "retrovue/playout_sinks/mpegts/TsMptsMux.hpp"
+#include "retrovue/playout_sinks/mpegts/TsSrtOutput.hpp"
+#include "retrovue/runtime/IoRing.h"
+#include "retrovue/telemetry/ChannelCpu.h"
+#include "retrovue/telemetry/EncoderTelemetry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace retrovue::playout_sinks::mpegts {
 
-// Underflow policy when buffer is empty
+// Underflow policy when buffer is empty. FRAME_FREEZE and BLACK_FRAME emit
+// pre-encoded filler frames (see EncoderPipeline::EmitFiller()).
 enum class UnderflowPolicy {
   FRAME_FREEZE,  // Repeat last frame (default)
   BLACK_FRAME,   // Output black frame
   SKIP           // Skip output
 };
 
+// Video encoder implementation. Hardware backends fall back to SOFTWARE
+// when their device or encoder is unavailable.
+enum class EncoderBackend {
+  SOFTWARE,  // libx264 / libx265 (default)
+  NVENC,     // NVIDIA (h264_nvenc / hevc_nvenc)
+  QSV,       // Intel Quick Sync (h264_qsv / hevc_qsv)
+  VAAPI,     // VA-API (h264_vaapi / hevc_vaapi)
+  AUTO       // First available of NVENC, QSV, VAAPI, then SOFTWARE
+};
+
+// Output video codec
+enum class VideoCodec {
+  H264,
+  HEVC
+};
+
+// What to do with a subscriber whose send queue is full
+enum class SlowClientPolicy {
+  EVICT,       // Disconnect it; it can reconnect and rejoin (default)
+  DROP_OLDEST  // Drop its oldest queued GOPs; it resumes at a keyframe (CC gap, no corrupt frames)
+};
+
+// Pauses (hibernating = true) or resumes the channel's producer, e.g. bound
+// to VideoFileProducer::Hibernate() / Wake(). Called on the sink's worker
+// thread.
+using HibernateCallback = std::function<void(bool hibernating)>;
+
+// Receives the trace of a sampled frame (see buffer::FrameTrace) once the
+// first TS bytes muxed after its encode reached the outputs, e.g. bound to
+// MetricsExporter::RecordFrameTrace(). Called on the sink's encode or
+// output thread.
+using FrameTraceCallback = std::function<void(const retrovue::buffer::FrameTrace& trace)>;
+
+// One extra output of the ABR ladder, encoded from the same frames as the
+// main output
+struct RenditionConfig {
+  int width = 1280;                   // Even; shrunk to fit a smaller source
+  int height = 720;
+  int bitrate = 3000000;              // 0 = the main bitrate's share by pixels; capped at the main bitrate
+  std::string ts_socket_path;         // Unix domain socket clients read this rendition from
+};
+
+// Where the audio track's samples come from (with enable_audio)
+enum class AudioSource {
+  SILENT,   // Pre-encoded silent AAC (default; no audio encode)
+  PRODUCER  // Producers' AudioFrames, encoded with audio_codec
+};
+
+// Output audio codec for AudioSource::PRODUCER (silence is always AAC)
+enum class AudioCodec {
+  AAC,
+  AC3
+};
+
 // Configuration for MpegTSPlayoutSink
 // POD struct - immutable after construction
 struct MpegTSPlayoutSinkConfig {
   int port = 9000;                    // TCP server port (used if ts_socket_path is empty)
   std::string bind_host = "127.0.0.1"; // TCP bind address (default: localhost)
   std::string ts_socket_path;         // Unix domain socket path for TS output (if empty, use TCP)
+  bool ts_socket_pipe = false;        // Hand socket clients a pipe the stream is vmsplice()d into
   double target_fps = 30.0;           // Target frame rate
+  bool frame_rate_conversion = false;  // Resample decoded frames onto target_fps (drop/repeat)
   int bitrate = 5000000;              // Encoding bitrate (5 Mbps)
   int gop_size = 30;                  // GOP size (1 second at 30fps)
+  bool fixed_gop = false;             // Keyframes only every gop_size frames or on request (no scene cuts)
   bool stub_mode = false;             // Use stub mode (no real encoding)
+  EncoderBackend encoder_backend = EncoderBackend::SOFTWARE;  // Video encoder implementation
+  VideoCodec video_codec = VideoCodec::H264;  // Output video codec
+  std::string hw_device;              // Encoder device (e.g. "/dev/dri/renderD128"); empty = default
+  std::string encoder_preset;         // Software encoder preset (e.g. "veryfast"); empty = ultrafast
   UnderflowPolicy underflow_policy = UnderflowPolicy::FRAME_FREEZE;
-  bool enable_audio = false;          // Enable silent AAC audio
-  size_t max_output_queue_packets = 100;  // Max packets in output queue before dropping
-  size_t output_queue_high_water_mark = 80;  // High water mark: encode new frames only if queue below this
+  bool enable_audio = false;          // Enable the audio track
+  AudioSource audio_source = AudioSource::SILENT;  // Silence (see SilentAacCache) or producer audio
+  AudioCodec audio_codec = AudioCodec::AAC;        // PRODUCER only
+  int audio_sample_rate = 48000;      // Output audio layout (producer audio is resampled to it)
+  int audio_channels = 2;
+  int audio_bitrate = 128000;         // PRODUCER only
+  decode::AudioProcessingConfig audio_processing;  // PRODUCER only: downmix and loudness normalization (off by default)
+  size_t max_output_queue_packets = 100;  // Unused: the output ring is sized in bytes (output_queue_bytes)
+  size_t output_queue_high_water_mark = 80;  // Unused: see output_queue_high_water_bytes
+  size_t output_queue_bytes = 1024 * 1024;   // Encoder -> clients ring; writes that do not fit are dropped
+  size_t output_queue_high_water_bytes = 768 * 1024;  // Encode new frames only while the ring holds less
+  size_t encode_queue_depth = 4;      // Frames handed to the encode thread (0 = encode on the worker thread)
+  uint32_t ts_validation_interval = 1;  // Validate every Nth muxer write (CC stats, PCR cadence); 0 = off
+  bool native_mux = false;            // Mux with TSMuxer instead of libavformat (no inspector pass)
+  std::shared_ptr<TsAssetCache> ts_cache;  // Cached airings spliced instead of encoded (null = off; native_mux only)
+  int64_t ts_cache_max_asset_ms = 120000;  // Record airings of assets up to this long into ts_cache
+  std::shared_ptr<decode::OverlayCompositor> overlays;  // Station bug etc. burned into frames before encode (null = off)
+  size_t max_subscribers = 8;         // Clients served from the one encoder output
+  size_t subscriber_queue_bytes = 2 * 1024 * 1024;  // Per-client send queue (~3 s at 5 Mbps)
+  SlowClientPolicy slow_client_policy = SlowClientPolicy::EVICT;
+  int64_t subscriber_max_lag_ms = 0;  // Also apply the policy to clients this far behind (0 = bytes only)
+  size_t send_batch_bytes = 256 * 1024;  // Most bytes a client sender gathers into one sendmsg()
+  int64_t send_batch_delay_us = 0;    // Latency budget: wait this long for more bytes per send
+  bool adaptive_bitrate = false;      // Fit the video bitrate to the slowest client (clients the only output)
+  int64_t adaptive_min_bitrate = 0;   // Adaptive floor (0 = bitrate / 4)
+  std::shared_ptr<runtime::IoRing> io_ring;  // Completion-driven client sends, shared by every channel (null = sender threads)
+  bool warm_start = false;            // Encode from start(); new clients get the cached GOP
+  int64_t hibernate_after_ms = 0;     // Hibernate after this long without clients (0 = never; not with outputs that keep the encoder running)
+  HibernateCallback on_hibernate;     // Pauses and resumes the producer around hibernation
+  FrameTraceCallback on_frame_trace;  // Sampled frames' traces, through encode and send
+  int32_t channel_id = -1;            // Names the sink's threads (rv<channel>-encode, ...)
+  std::shared_ptr<retrovue::telemetry::ChannelCpuAccount> cpu_account;  // Encode, mux and send CPU time (optional)
+  std::shared_ptr<retrovue::telemetry::EncoderTelemetry> encoder_telemetry;  // Encode and output measurements (null = the sink's own)
+  std::shared_ptr<EncoderThreadBudget> encoder_threads;  // Software encoder threads, shared by every channel (null = the encoder's own count)
+  int encoder_priority = 1;           // The channel's weight in encoder_threads (1 = normal)
+  int64_t cbr_mux_rate = 0;           // Constant output rate in bps, null-stuffed (0 = send as muxed)
+  size_t cbr_burst_packets = 7;       // Packets per paced write (7 = one 1316-byte datagram)
+  int64_t cbr_max_queue_ms = 500;     // Pacer backlog before it sends above cbr_mux_rate
+  std::string udp_host;               // UDP/RTP output: IPv4 unicast or multicast group (keeps the encoder running)
+  int udp_port = 0;                   // UDP/RTP output port (0 = off)
+  bool udp_rtp = false;               // RTP (payload type 33) instead of raw UDP datagrams
+  int udp_ttl = 16;                   // Multicast TTL (unicast: IP TTL)
+  std::string udp_interface;          // Local IPv4 address for multicast; empty = routing default
+  int udp_fec_columns = 0;            // SMPTE 2022-1 FEC L (RTP only; 0 = off), on udp_port + 2
+  int udp_fec_rows = 0;               // SMPTE 2022-1 FEC D (4-20)
+  bool udp_fec_row = false;           // Also send row FEC, on udp_port + 4
+  bool udp_txtime = false;            // Kernel pacing (SO_TXTIME; needs cbr_mux_rate and an etf/fq qdisc)
+  bool udp_txtime_monotonic = false;  // CLOCK_MONOTONIC launch times (fq) instead of CLOCK_TAI (etf)
+  int64_t udp_txtime_lead_us = 2000;  // Pacer writes this far ahead of the launch times
+  std::string srt_host;               // SRT output: remote host (caller) or local address (listener)
+  int srt_port = 0;                   // SRT output port (0 = off; keeps the encoder running)
+  bool srt_listener = false;          // Wait for the remote end to call instead of calling it
+  int srt_latency_ms = 120;           // SRT latency (retransmission window)
+  std::string srt_passphrase;         // AES encryption; empty = off, else 10-79 characters
+  int srt_key_length = 0;             // AES key bytes: 16, 24 or 32 (0 = SRT default)
+  std::string srt_stream_id;          // Caller only: stream ID for the remote end
+  int64_t srt_stats_interval_ms = 1000;  // How often link stats are sampled
+  SrtStatsCallback on_srt_stats;      // Link stats sink (link thread), e.g. the MetricsExporter
+  int hls_port = 0;                   // HLS output: HTTP port (0 = off; keeps the encoder running)
+  std::string hls_path = "/hls";      // URL prefix: <hls_path>/index.m3u8
+  int64_t hls_segment_ms = 2000;      // Segments end on the first IDR after this (match gop_size)
+  int64_t hls_part_ms = 333;          // LL-HLS partial segments (0 = plain HLS)
+  size_t hls_window_segments = 6;     // Segments held in memory and listed
+  std::vector<RenditionConfig> renditions;  // ABR ladder outputs besides the main one (implies fixed_gop)
+  std::shared_ptr<TsMptsMux> mpts;    // Statmuxed MPTS joined as a program (null = off; native_mux only; keeps the encoder running)
+  uint16_t mpts_program = 0;          // Program number in the MPTS (1-255)
+  int64_t mpts_min_bitrate = 0;       // Video allocation floor (0 = bitrate / 2)
+  int64_t mpts_max_bitrate = 0;       // Video allocation ceiling (0 = bitrate * 2)
 };
 
 }  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,112 @@
+// Repository: Retrovue-playout
+// Component: Mux Interleaver
+// Purpose: Bounded, clock-driven A/V packet interleaving in front of the TS muxer.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_MUX_INTERLEAVER_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_MUX_INTERLEAVER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Forward declarations for FFmpeg types (avoids pulling in FFmpeg headers here)
+struct AVFormatContext;
+struct AVPacket;
+
+namespace retrovue::playout_sinks::mpegts {
+
+// MuxQueueStats is a point-in-time view of the interleaving queue.
+struct MuxQueueStats {
+  size_t depth = 0;              // Packets waiting now
+  size_t peak_depth = 0;         // Most packets ever waiting at once
+  uint64_t packets_written = 0;
+  uint64_t forced_writes = 0;    // Written ahead of the clock because the queue was full
+  int64_t last_hold_us = 0;      // Wall time the last written packet waited
+  int64_t max_hold_us = 0;
+};
+
+// MuxInterleaver orders the encoders' packets by DTS and hands them to the
+// muxer with av_write_frame() (or a native muxer's write function), so libavformat's own interleaving queue
+// (which holds a stream's packets until every other stream has caught up,
+// up to max_interleave_delta) never comes into play.
+//
+// The mux clock is the video input timeline: Drain(clock) writes every
+// queued packet with a DTS at or before it. A packet ahead of the clock
+// waits for the next Drain(), so with audio fed up to the end of each video
+// frame the queue holds about one frame. A stream that stops (an audio gap)
+// never holds the other back; a stream running far ahead is bounded by
+// max_packets, past which the oldest packets are written early.
+//
+// Packets must carry timestamps in the same time base on every stream
+// (the TS muxer's 90 kHz). Queued packets are recycled, so steady state
+// does not allocate.
+//
+// Thread Model: Push(), Drain() and Clear() from the encoding thread;
+// GetStats() from any thread.
+class MuxInterleaver {
+ public:
+  static constexpr size_t kDefaultMaxPackets = 64;
+
+  // Writes one packet to a muxer other than libavformat's (it keeps its
+  // reference); returns 0 or a negative AVERROR.
+  using WriteFn = int (*)(void* opaque, AVPacket* packet);
+
+  // Sees each packet just before it is written (it must not keep it).
+  using TapFn = void (*)(void* opaque, const AVPacket* packet);
+
+  explicit MuxInterleaver(size_t max_packets = kDefaultMaxPackets);
+  ~MuxInterleaver();
+
+  MuxInterleaver(const MuxInterleaver&) = delete;
+  MuxInterleaver& operator=(const MuxInterleaver&) = delete;
+
+  // Queues packet in DTS order, taking its reference (packet is left
+  // blank). Returns false if no packet could be allocated.
+  bool Push(AVPacket* packet);
+
+  // Writes the packets due at clock_90k (INT64_MAX flushes the queue), in
+  // DTS order. Returns the first muxer error, or 0; a failed packet is
+  // dropped and the rest are still written.
+  int Drain(AVFormatContext* format_ctx, int64_t clock_90k);
+
+  // As above, handing each packet to write.
+  int Drain(WriteFn write, void* opaque, int64_t clock_90k);
+
+  // Drops every queued packet (muxer closing without a header).
+  void Clear();
+
+  // Shows every packet Drain() writes to tap as well (null = none), e.g. to
+  // mux a copy of part of the stream.
+  void SetTap(TapFn tap, void* opaque) {
+    tap_ = tap;
+    tap_opaque_ = opaque;
+  }
+
+  MuxQueueStats GetStats() const;
+
+ private:
+  struct Entry {
+    AVPacket* packet;
+    int64_t queued_us;  // Steady clock
+  };
+
+  const size_t max_packets_;
+  std::deque<Entry> queue_;        // DTS order; ties keep arrival order
+  std::vector<AVPacket*> spare_;   // Blank packets for reuse
+  TapFn tap_ = nullptr;
+  void* tap_opaque_ = nullptr;
+
+  std::atomic<size_t> depth_{0};
+  std::atomic<size_t> peak_depth_{0};
+  std::atomic<uint64_t> packets_written_{0};
+  std::atomic<uint64_t> forced_writes_{0};
+  std::atomic<int64_t> last_hold_us_{0};
+  std::atomic<int64_t> max_hold_us_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_MUX_INTERLEAVER_HPP_
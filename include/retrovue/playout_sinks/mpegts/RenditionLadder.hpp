@@ -0,0 +1,134 @@
+// Repository: Retrovue-playout
+// Component: Rendition Ladder
+// Purpose: Encodes lower-resolution ABR renditions from the sink's decoded frames.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_LADDER_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_LADDER_HPP_
+
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/playout_sinks/mpegts/EncoderPipeline.hpp"
+#include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+#include "retrovue/playout_sinks/mpegts/RenditionPlan.hpp"
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+#include "retrovue/playout_sinks/mpegts/TsOutputSink.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// RenditionStats is a point-in-time view of one ladder rendition.
+struct RenditionStats {
+  int width = 0;                 // As encoded (see PlanRenditionLadder())
+  int height = 0;
+  int bitrate = 0;
+  bool clamped = false;          // Shrunk to the source, or bitrate capped
+  bool encoding = false;         // Encoder open (at least one client connected)
+  uint64_t frames_encoded = 0;
+  uint64_t encoding_errors = 0;
+  TsFanoutStats fanout;
+};
+
+// RenditionLadder encodes config.renditions alongside the sink's main
+// output, from the same decoded frames: one decode, one encoder per
+// rendition, each serving its own Unix domain socket through a TsFanout.
+//
+// Frames are scaled once per rendition through a cascade: renditions are
+// ordered largest first, and each one is downscaled from the nearest larger
+// rendition that PackI420() can reach at 2:1 or less, falling back to the
+// source frame. A rendition's image is only produced while it, or a
+// rendition scaled from it, has clients. Sizes and bitrates are resolved
+// against the main output's bitrate and, from the first frame on (and
+// again whenever it changes), the input frame's size; see
+// PlanRenditionLadder().
+//
+// Every rendition encodes with fixed_gop and the main output's gop_size,
+// and keyframe requests go to all renditions at once, so IDRs land on the
+// same frames across the ladder and players can switch at GOP boundaries.
+//
+// Thread Model: UpdateOutputs(), EncodeAudio(), EncodeFrame() and
+// EmitFiller() from the sink's encode thread; Start() and Stop() while that
+// thread is not running; RequestKeyframe() and GetStats() from any thread.
+class RenditionLadder {
+ public:
+  // config: The sink's configuration; renditions must be non-empty.
+  explicit RenditionLadder(const MpegTSPlayoutSinkConfig& config);
+  ~RenditionLadder();
+
+  RenditionLadder(const RenditionLadder&) = delete;
+  RenditionLadder& operator=(const RenditionLadder&) = delete;
+
+  // Validates the renditions and starts listening on their sockets.
+  bool Start();
+
+  // Closes the encoders, flushes their trailers and disconnects clients.
+  void Stop();
+
+  // Opens the encoder of each rendition that gained its first client and
+  // closes those that lost their last. Returns true (after requesting a
+  // keyframe on every rendition) if any rendition opened or gained a
+  // client, so the caller can align the main output's keyframe too.
+  bool UpdateOutputs();
+
+  // Makes the next frame a keyframe on every rendition.
+  void RequestKeyframe();
+
+  // Scales frame (packed I420) and encodes it on every open rendition.
+  void EncodeFrame(const buffer::Frame& frame, int64_t pts90k);
+
+  // Encodes producer audio on every open rendition; call before
+  // EncodeFrame() with the frames up to its end.
+  void EncodeAudio(const buffer::AudioFrame& audio);
+
+  // Emits pre-encoded underflow filler at pts90k on every open rendition.
+  void EmitFiller(int64_t pts90k);
+
+  std::vector<RenditionStats> GetStats() const;
+
+ private:
+  struct Rendition {
+    // Declared before encoder, which keeps a reference to it
+    MpegTSPlayoutSinkConfig config;
+    RenditionConfig output;
+    std::unique_ptr<TsFanout> fanout;
+    std::unique_ptr<TsOutputSink> output_sink;
+    std::unique_ptr<EncoderPipeline> encoder;
+    RenditionRung rung;        // Size, bitrate and cascade source (encode thread only)
+    buffer::Frame frame;       // Scaled image, preallocated
+    bool needed = false;       // Scaled this frame (encoding or feeding another)
+    bool open = false;         // Encoder open (encode thread only)
+    uint64_t subscribers_seen = 0;
+    uint64_t gop_resyncs_seen = 0;
+    std::atomic<bool> encoding{false};
+    std::atomic<int> width{0};
+    std::atomic<int> height{0};
+    std::atomic<int> bitrate{0};
+    std::atomic<bool> clamped{false};
+    std::atomic<uint64_t> frames_encoded{0};
+    std::atomic<uint64_t> encoding_errors{0};
+  };
+
+  // EncoderPipeline write callback: forwards muxed bytes to the rendition's
+  // socket clients.
+  static int WriteThunk(void* opaque, uint8_t* buf, int buf_size);
+
+  // Resolves every rendition against a source_width x source_height input
+  // (0 = not yet known), sizing its frame for the rung.
+  void Plan(int source_width, int source_height);
+
+  // Scales frame into every needed rendition, largest first.
+  void ScaleCascade(const buffer::Frame& frame);
+
+  const std::vector<RenditionConfig> outputs_;  // As configured
+  const int source_bitrate_;
+  int source_width_ = 0;   // Input frame size planned for (encode thread only)
+  int source_height_ = 0;
+  std::vector<std::unique_ptr<Rendition>> renditions_;  // Largest first
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_LADDER_HPP_
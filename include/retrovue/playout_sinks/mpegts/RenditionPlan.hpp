@@ -0,0 +1,47 @@
+// Repository: Retrovue-playout
+// Component: Rendition Plan
+// Purpose: Resolves the ABR ladder's rung sizes, bitrates and scale cascade against the source.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_PLAN_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_PLAN_HPP_
+
+#include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// One rendition as encoded from a given source.
+struct RenditionRung {
+  size_t index = 0;      // Position in config.renditions
+  int width = 0;
+  int height = 0;
+  int bitrate = 0;
+  int source = -1;       // Rung scaled from (-1 = the source frame)
+  bool clamped = false;  // Shrunk to fit the source, or its bitrate capped
+};
+
+// Lowest bitrate a rendition derives from its share of the source.
+inline constexpr int kMinRenditionBitrate = 200'000;
+
+// Resolves renditions against a source_width x source_height frame
+// encoded at source_bitrate, largest configured size first (ties keep
+// their order):
+// - A rung wider or taller than the source shrinks to fit inside it,
+//   keeping its aspect ratio, rounded down to even (at least 2x2)
+// - A bitrate of 0 is the source bitrate times the rung's share of the
+//   source pixels, at least kMinRenditionBitrate; any bitrate is capped at
+//   source_bitrate
+// - Each rung scales from the nearest larger rung PackI420() reaches at
+//   2:1 or less, else from the source frame
+// With the source size not yet known (0), sizes are kept and derived
+// bitrates take the largest rung as the source size.
+std::vector<RenditionRung> PlanRenditionLadder(const std::vector<RenditionConfig>& renditions,
+                                               int source_width, int source_height,
+                                               int source_bitrate);
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_RENDITION_PLAN_HPP_
@@ -0,0 +1,76 @@
+// Repository: Retrovue-playout
+// Component: Silent AAC Cache
+// Purpose: Process-wide cache of pre-encoded silent AAC access units.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_SILENT_AAC_CACHE_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_SILENT_AAC_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Forward declaration for FFmpeg types (avoids pulling in FFmpeg headers here)
+struct AVCodecParameters;
+
+namespace retrovue::playout_sinks::mpegts {
+
+// SilentAacTrack is one encoded silent AAC stream layout: the parameters to
+// add the track to a muxer with, and the access unit that repeats.
+struct SilentAacTrack {
+  std::shared_ptr<const AVCodecParameters> codecpar;  // AAC-LC, includes extradata
+  std::vector<uint8_t> access_unit;  // One raw AAC frame of silence (no ADTS header)
+  int sample_rate = 0;
+  int channels = 0;
+  int frame_size = 0;                // Samples per access unit
+};
+
+// SilentAacCacheStats is a point-in-time view of cache use.
+struct SilentAacCacheStats {
+  uint64_t hits = 0;       // Tracks served from the cache
+  uint64_t encodes = 0;    // Tracks encoded on first use
+  uint64_t failures = 0;   // Layouts the AAC encoder could not produce
+  size_t entries = 0;
+};
+
+// SilentAacCache keeps the silent track of every sample rate / channel
+// count in use, so channels with enable_audio mux the same access unit
+// over and over instead of each running an AAC encoder on zeros.
+//
+// Silence encodes to the same frame once the encoder is past its priming
+// frames; Get() encodes a short run of silence on the first request for a
+// layout and keeps the last access unit. The caller re-timestamps it.
+//
+// Thread-safe: one process-wide instance is shared by every channel.
+class SilentAacCache {
+ public:
+  // Returns the process-wide cache.
+  static SilentAacCache& Instance();
+
+  SilentAacCache() = default;
+
+  SilentAacCache(const SilentAacCache&) = delete;
+  SilentAacCache& operator=(const SilentAacCache&) = delete;
+
+  // Returns the silent track for sample_rate and channels, encoding it on
+  // first use; nullptr if no AAC encoder can produce that layout (a
+  // failure is not cached, so a later call retries).
+  std::shared_ptr<const SilentAacTrack> Get(int sample_rate, int channels);
+
+  void Clear();
+
+  SilentAacCacheStats GetStats() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::pair<int, int>, std::shared_ptr<const SilentAacTrack>> tracks_;
+  SilentAacCacheStats stats_;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_SILENT_AAC_CACHE_HPP_
@@ -1,41 +1,116 @@
 // Repository: Retrovue-playout
 // Component: MPEG-TS Muxer
-// Purpose: Wraps FFmpeg MPEG-TS muxing for MpegTSPlayoutSink.
+// Purpose: Native MPEG-TS muxing (PES, PAT/PMT, PCR) for the MPEG-TS sinks.
 // Copyright (c) 2025 RetroVue
 
 #ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MUXER_H_
 #define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MUXER_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <vector>
 
 namespace retrovue::playout_sinks::mpegts {
 
-// Forward declaration
-struct MuxerConfig;
+// Elementary stream types carried in the PMT (ISO/IEC 13818-1, ATSC A/52).
+constexpr uint8_t kTsStreamTypeH264 = 0x1B;
+constexpr uint8_t kTsStreamTypeHevc = 0x24;
+constexpr uint8_t kTsStreamTypeAac = 0x0F;  // ADTS
+constexpr uint8_t kTsStreamTypeAc3 = 0x81;
 
-// TSMuxer wraps FFmpeg MPEG-TS muxing.
-// Packages H.264 packets into MPEG-TS transport stream format.
+// CRC-32/MPEG-2 of a PSI section (polynomial 0x04C11DB7, no reflection).
+uint32_t Crc32Mpeg(const uint8_t* data, size_t size);
+
+// Muxer configuration. PIDs and program numbers default to libavformat's,
+// so either muxer produces the same stream layout.
+struct MuxerConfig {
+  bool enable_audio = false;   // Add an audio elementary stream to the PMT
+  bool stub_mode = false;      // Write packet data unmuxed (no TS framing)
+
+  uint8_t video_stream_type = kTsStreamTypeH264;
+  uint8_t audio_stream_type = kTsStreamTypeAac;
+  // AAC AudioSpecificConfig; raw AAC access units get ADTS headers built
+  // from it (packets already carrying ADTS pass through)
+  std::vector<uint8_t> audio_specific_config;
+
+  uint16_t transport_stream_id = 1;
+  uint16_t program_number = 1;
+  uint16_t pmt_pid = 0x1000;
+  uint16_t video_pid = 0x100;  // Also the PCR PID
+  uint16_t audio_pid = 0x101;
+
+  int64_t pcr_interval_us = 30000;   // Minimum spacing of PCRs in stream time
+  int64_t psi_interval_us = 100000;  // PAT/PMT repeat (also before every keyframe)
+  int64_t mux_delay_us = 200000;     // PTS/DTS lead over the PCR (decoder buffering)
+};
+
+// Elementary streams of the muxer's single program.
+enum class TsStream {
+  kVideo,
+  kAudio,
+};
+
+// TSMuxer packages encoded access units into an MPEG-TS transport stream.
+//
+// Each access unit becomes one PES packet split over 188-byte TS packets,
+// written straight into a preallocated chunk of whole packets that goes to
+// the output when it fills or on Flush(); steady state does not allocate.
+// Continuity counters are kept per PID as packets are built, so the output
+// needs no repair pass. H.264/HEVC access units get an access unit
+// delimiter if they lack one; raw AAC gets an ADTS header.
+//
+// Timing: PTS/DTS are written mux_delay_us ahead of the input timestamps
+// and the PCR carries the input DTS, so the decoder buffers mux_delay_us.
+// A PCR goes out on the video PID once pcr_interval_us of stream time has
+// passed - in the first packet of a video PES, or in an adaptation-only
+// packet ahead of an audio PES. PAT/PMT precede every keyframe, and any
+// video PES once psi_interval_us has passed.
+//
+// Thread Model: not thread-safe; owned by one encoding thread.
 class TSMuxer {
  public:
+  // Output callback (same shape as an AVIO write callback). Returns
+  // buf_size on success, a negative value on failure.
+  using WriteCallback = int (*)(void* opaque, uint8_t* buf, int buf_size);
+
+  static constexpr size_t kPacketSize = 188;
+  static constexpr size_t kChunkPackets = 64;  // Packets per output write
+
   TSMuxer();
   virtual ~TSMuxer();
 
+  TSMuxer(const TSMuxer&) = delete;
+  TSMuxer& operator=(const TSMuxer&) = delete;
+
   // Initialize muxer with configuration
   // output_fd: File descriptor for output (TCP socket)
   // Returns true on success, false on failure
   virtual bool Initialize(const MuxerConfig& config, int output_fd);
 
-  // Cleanup muxer resources
+  // Initialize muxer writing through a callback instead of a descriptor.
+  bool Initialize(const MuxerConfig& config, void* opaque, WriteCallback write);
+
+  // Cleanup muxer resources (flushes buffered packets first)
   virtual void Cleanup();
 
-  // Mux an encoded H.264 packet into MPEG-TS
-  // packet_data: H.264 encoded packet data
-  // pts_us: Presentation timestamp in microseconds
+  // Mux an encoded H.264 packet into MPEG-TS and write it out
+  // packet_data: H.264 encoded packet data (Annex B)
+  // pts_us: Presentation timestamp in microseconds (DTS = PTS, no B-frames)
   // Returns true on success, false on failure
   virtual bool MuxPacket(const std::vector<uint8_t>& packet_data, int64_t pts_us);
 
+  // Muxes one access unit of stream at pts90k/dts90k (90 kHz). Packets are
+  // buffered until a chunk fills or Flush(). Returns false on a write error.
+  bool MuxFrame(TsStream stream, const uint8_t* data, size_t size, int64_t pts90k,
+                int64_t dts90k, bool keyframe);
+
+  // Splices already-muxed packets (e.g. pre-encoded filler from a muxer
+  // with the same configuration) into the output: continuity counters on
+  // this muxer's PIDs are rewritten to follow its own, and PCR/PSI timing
+  // continues from the spliced packets. Trailing bytes short of a whole
+  // packet are dropped.
+  bool WriteMuxed(uint8_t* data, size_t size);
+
   // Write any buffered MPEG-TS data
   // Returns true on success, false on failure
   virtual bool Flush();
@@ -48,24 +123,56 @@ class TSMuxer {
   // Check if muxer is initialized
   bool IsInitialized() const { return is_initialized_; }
 
+  // True if data (Annex B H.264) contains an IDR slice or SPS.
+  static bool IsH264Keyframe(const uint8_t* data, size_t size);
+
  protected:
   bool is_initialized_ = false;
   int output_fd_ = -1;
 
  private:
-  
-  // TODO: Add FFmpeg muxer state (AVFormatContext, etc.)
-  // struct MuxerState;
-  // std::unique_ptr<MuxerState> muxer_state_;
-};
-
-// Muxer configuration
-struct MuxerConfig {
-  bool enable_audio = false;  // Enable silent AAC audio track
-  bool stub_mode = false;      // Use stub muxing (no real FFmpeg)
+  // Returns the next packet slot in the chunk, writing it out when full.
+  uint8_t* NextPacket();
+
+  // Writes the buffered chunk to the output.
+  bool EmitChunk();
+  bool WriteOut(const uint8_t* data, size_t size);
+
+  // Counter of one of this muxer's PIDs, or nullptr for any other PID.
+  uint8_t* Counter(uint16_t pid);
+
+  // Builds the PAT and PMT sections for config_.
+  void BuildTables();
+  void WritePsi(uint16_t pid, const uint8_t* section, size_t size);
+  void WriteTables();
+  void WritePcrPacket(int64_t clock_90k);
+
+  // Splits a PES (header followed by prefix, then data) over TS packets.
+  void WritePes(uint16_t pid, const uint8_t* header, size_t header_size, const uint8_t* data,
+                size_t size, bool pcr, int64_t clock_90k, bool random_access);
+
+  MuxerConfig config_;
+  void* opaque_ = nullptr;
+  WriteCallback write_ = nullptr;
+
+  std::vector<uint8_t> chunk_;  // kChunkPackets whole packets
+  size_t chunk_packets_ = 0;    // Filled so far
+  bool write_failed_ = false;   // Since the last Flush()
+
+  std::vector<uint8_t> pat_;    // Sections, CRC included
+  std::vector<uint8_t> pmt_;
+
+  uint8_t pat_cc_ = 0;
+  uint8_t pmt_cc_ = 0;
+  uint8_t video_cc_ = 0;
+  uint8_t audio_cc_ = 0;
+
+  bool pcr_valid_ = false;
+  int64_t last_pcr_90k_ = 0;    // Input clock of the last PCR
+  bool psi_valid_ = false;
+  int64_t last_psi_90k_ = 0;
 };
 
 }  // namespace retrovue::playout_sinks::mpegts
 
 #endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MUXER_H_
-
@@ -0,0 +1,106 @@
+// Repository: Retrovue-playout
+// Component: TS Asset Cache
+// Purpose: Pre-encoded airings of repeatedly aired assets, per encoder profile.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_ASSET_CACHE_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_ASSET_CACHE_HPP_
+
+#include "retrovue/playout_sinks/mpegts/TsFillerClip.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsAssetCacheStats is a point-in-time view of cache use.
+struct TsAssetCacheStats {
+  uint64_t hits = 0;         // Airings served from the cache
+  uint64_t misses = 0;
+  uint64_t inserts = 0;      // Airings recorded into the cache
+  uint64_t disk_loads = 0;   // Entries read from the cache directory
+  uint64_t evictions = 0;    // Entries dropped to stay within capacity
+  size_t entries = 0;
+  size_t size_bytes = 0;
+};
+
+// TsAssetCache keeps the muxed TS of whole airings of short, often repeated
+// assets (commercials, promos, bumpers), keyed by asset URI and the encoder
+// profile they were encoded with, so an EncoderPipeline with the same
+// profile can splice an airing's packets instead of encoding its frames
+// again (see EncoderPipeline::EmitCachedFrame()). An entry is recorded from
+// the muxer's input the first time its asset airs from the start; the
+// asset file's size and modification time are part of the key, so a
+// replaced file is recorded anew.
+//
+// Entries are TsFillerClips: one run of packets per video frame, re-timed
+// as they are emitted. The least recently used entries are evicted past
+// capacity_bytes. With a directory, inserted entries are also written
+// there (FileName() under it) and misses are looked up there, so recorded
+// airings survive restarts and can be prepared ahead of time: any clip
+// muxed with TSMuxer's stream layout and its first frame at PTS 0 will do.
+//
+// Thread-safe: one cache is shared by every channel that sets it in
+// MpegTSPlayoutSinkConfig::ts_cache. Lookups take a lock, and at most one
+// happens per airing.
+class TsAssetCache {
+ public:
+  static constexpr size_t kDefaultCapacityBytes = 512 * 1024 * 1024;
+
+  explicit TsAssetCache(size_t capacity_bytes = kDefaultCapacityBytes,
+                        std::string directory = "");
+
+  TsAssetCache(const TsAssetCache&) = delete;
+  TsAssetCache& operator=(const TsAssetCache&) = delete;
+
+  // The cached airing of uri encoded with profile, or nullptr.
+  std::shared_ptr<const TsFillerClip> Find(const std::string& uri, const std::string& profile);
+
+  // Caches an airing of uri encoded with profile (replacing an older one).
+  // Clips larger than the capacity are not kept.
+  void Insert(const std::string& uri, const std::string& profile,
+              std::shared_ptr<const TsFillerClip> clip);
+
+  void Clear();
+
+  size_t capacity_bytes() const { return capacity_bytes_; }
+
+  TsAssetCacheStats GetStats() const;
+
+  // File name (in the cache directory) of the airing of uri with profile.
+  static std::string FileName(const std::string& uri, const std::string& profile);
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const TsFillerClip> clip;
+  };
+
+  // Key of uri with profile: the file's size and mtime are included.
+  static std::string MakeKey(const std::string& uri, const std::string& profile);
+
+  // Adds an entry in front and evicts from the back (mutex_ held).
+  void InsertLocked(std::string key, std::shared_ptr<const TsFillerClip> clip);
+
+  // Reads and writes FileName() files in directory_ (off the lock).
+  std::shared_ptr<const TsFillerClip> LoadFile(const std::string& path) const;
+  void SaveFile(const std::string& path, const TsFillerClip& clip) const;
+
+  const size_t capacity_bytes_;
+  const std::string directory_;
+
+  mutable std::mutex mutex_;
+  std::list<Entry> lru_;  // Most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t size_bytes_ = 0;
+  TsAssetCacheStats stats_;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_ASSET_CACHE_HPP_
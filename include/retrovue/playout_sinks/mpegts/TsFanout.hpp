@@ -0,0 +1,271 @@
+// Repository: Retrovue-playout
+// Component: TS Fanout
+// Purpose: Delivers one encoder's MPEG-TS output to several connected clients.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FANOUT_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FANOUT_HPP_
+
+#include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace retrovue::runtime {
+class IoRing;
+}  // namespace retrovue::runtime
+
+namespace retrovue::playout_sinks::mpegts {
+
+// Muxed TS bytes, written once and shared read-only by every subscriber
+// queue that holds them.
+using TsChunk = std::shared_ptr<const std::vector<uint8_t>>;
+
+// TsFanoutStats is a point-in-time view of the fanout.
+struct TsFanoutStats {
+  size_t subscribers = 0;         // Currently connected
+  uint64_t subscribers_total = 0; // Ever accepted
+  uint64_t rejected = 0;          // Refused because max_subscribers were connected
+  uint64_t evictions = 0;         // Disconnected by SlowClientPolicy::EVICT
+  uint64_t lag_evictions = 0;     // Of those, for data queued longer than max_lag_ms
+  size_t draining = 0;            // Disconnected pipe subscribers whose pipe is still unread
+  uint64_t chunks_dropped = 0;    // Dropped by SlowClientPolicy::DROP_OLDEST
+  uint64_t gop_resyncs = 0;       // DROP_OLDEST cuts, each resuming the client at a keyframe
+  uint64_t send_failures = 0;     // Clients lost to a failed send (closed, reset)
+  uint64_t bytes_published = 0;
+  uint64_t bytes_sent = 0;        // Written to client sockets, all clients
+  uint64_t send_syscalls = 0;     // Gathered writes (bytes_sent / send_syscalls = bytes per call;
+                                  // with an IoRing, sendmsg operations submitted)
+  size_t max_batch_chunks = 0;    // Most queued chunks gathered into one write
+  uint64_t cached_joins = 0;      // Subscribers started from the GOP cache
+  size_t gop_cache_bytes = 0;     // Bytes cached from the latest keyframe on
+  size_t max_queued_bytes = 0;    // Longest client queue
+  double send_buffer_ratio = 0.0; // Fullest client socket send buffer (unsent / SO_SNDBUF)
+};
+
+// TsFanout serves one encoder output to up to max_subscribers clients, so
+// two viewers (or a recorder and a restreamer) share one encode.
+//
+// Publish() copies the muxer's bytes once into a refcounted TsChunk and
+// queues a reference for each subscriber; it never waits on a client. Each
+// subscriber has its own sender thread that writes its queue to a blocking
+// socket, so whole TS packets are written in order (FE-017) and a stalled
+// client holds up only itself. A subscriber whose queue would exceed
+// queue_bytes is handled by the SlowClientPolicy. DROP_OLDEST drops whole
+// GOPs: the oldest bytes, then everything up to the next queued keyframe
+// (or, with none queued, new chunks until one brings a keyframe), so the
+// client resumes on an IDR instead of decoding a broken GOP. gop_resyncs
+// counts those cuts; the owner should request a keyframe when it rises.
+//
+// With max_lag_ms > 0 the policy also applies to a subscriber whose oldest
+// queued chunk has waited longer than that, so a reader that falls behind
+// is cut off (or skipped ahead) after the same delay whatever the bitrate.
+//
+// A sender writes everything queued for it (up to send_batch_bytes and
+// kMaxBatchChunks chunks) with one gathered sendmsg(). With
+// send_batch_delay_us > 0 it also waits that long after the first chunk,
+// unless send_batch_bytes are queued sooner, so a stream of small writes
+// costs fewer syscalls at the price of that much added latency.
+//
+// With an IoRing, socket subscribers have no sender thread: their sends are
+// completion-driven. Publish() queues a gathered sendmsg on the ring for
+// each idle subscriber and submits them all with one io_uring_enter(), and
+// a completion sends (or resubmits the rest of a short write) from the
+// ring's completion thread; while a send is in flight the next batch
+// gathers behind it, so send_batch_delay_us does not apply. Pipe
+// subscribers keep their sender thread (vmsplice has no ring operation).
+//
+// A subscriber that joins mid-stream receives nothing until the next PAT,
+// so its first packet starts a PAT/PMT sequence; the caller should also
+// request a keyframe so the client can decode promptly.
+//
+// With a GOP cache (gop_cache_bytes > 0), Publish() also keeps the chunks
+// from the most recent keyframe on (found by the random access indicator),
+// even with no subscribers. A new subscriber is then sent the latest
+// PAT/PMT and the cached GOP straight away, followed by the live stream,
+// so it can start decoding without waiting for the next keyframe. A GOP
+// larger than the cache is dropped, and joins wait for a PAT until the
+// next keyframe.
+//
+// A pipe subscriber takes fd as the write end of a pipe and its sender
+// vmsplice()s the queued chunks into it instead of copying them into a
+// socket buffer, so a local consumer that splice()s or read()s the pipe
+// costs one copy less. The pipe then references the chunks' memory, so a
+// sender keeps each chunk until the pipe has been read past it, and a pipe
+// subscriber that disconnects with unread data is kept (draining) until its
+// reader catches up or closes. The consumer must not splice the pipe on to
+// a socket: those pages can be sent after the chunk is released.
+//
+// Thread-safe: Publish() from the muxer's write thread; AddSubscriber(),
+// SubscriberCount() and GetStats() from any thread.
+class TsFanout {
+ public:
+  static constexpr size_t kMaxBatchChunks = 64;  // iovecs per gathered write
+
+  TsFanout(size_t max_subscribers, size_t queue_bytes, SlowClientPolicy policy,
+           size_t gop_cache_bytes = 0, size_t send_batch_bytes = 256 * 1024,
+           int64_t send_batch_delay_us = 0, int64_t max_lag_ms = 0,
+           std::shared_ptr<runtime::IoRing> io_ring = nullptr);
+  ~TsFanout();
+
+  TsFanout(const TsFanout&) = delete;
+  TsFanout& operator=(const TsFanout&) = delete;
+
+  // Takes ownership of a connected socket (set to blocking by the caller),
+  // or with pipe of a pipe's write end. Returns false, with fd closed, when
+  // max_subscribers are connected.
+  bool AddSubscriber(int fd, const std::string& label, bool pipe = false);
+
+  // Queues size bytes (whole TS packets) for every subscriber, and updates
+  // the GOP cache.
+  void Publish(const uint8_t* data, size_t size);
+
+  // Publishes the count buffers of parts as one contiguous write.
+  void Publish(const struct iovec* parts, size_t count);
+
+  // Subscribers still connected.
+  size_t SubscriberCount() const;
+
+  // Offset of the first video keyframe packet in size bytes of whole TS
+  // packets, or size if there is none.
+  static size_t KeyframeOffset(const uint8_t* data, size_t size);
+
+  // Queues trailer (may be null) for every subscriber, waits up to timeout_ms
+  // for the queues to drain, then disconnects everyone.
+  void CloseAll(const uint8_t* trailer, size_t trailer_size, int64_t timeout_ms);
+
+  TsFanoutStats GetStats() const;
+
+  size_t max_subscribers() const { return max_subscribers_; }
+
+ private:
+  // A chunk reference in a subscriber queue
+  struct Queued {
+    TsChunk chunk;
+    size_t offset = 0;                              // Start of the unsent bytes
+    size_t keyframe = 0;                            // First keyframe at or after offset, else size
+    std::chrono::steady_clock::time_point queued;   // For the lag limit
+  };
+
+  struct Subscriber {
+    int fd = -1;
+    std::string label;
+    std::thread sender;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Queued> queue;
+    size_t queued_bytes = 0;     // Guarded by mutex
+    bool joined = false;         // Has seen a PAT (guarded by mutex_)
+    bool closing = false;        // Stop after the queue drains (guarded by mutex)
+    bool disconnected = false;   // Stop now (guarded by mutex)
+    bool resync = false;         // GOP cut: skip chunks until a keyframe (guarded by mutex)
+    std::atomic<bool> finished{false};  // Sender has exited
+    bool pipe = false;
+    // Pipe only: chunks still referenced by the pipe, with the spliced byte
+    // count at their end; sender thread only until finished
+    std::deque<std::pair<TsChunk, uint64_t>> pinned;
+    uint64_t spliced = 0;
+    // Completion-driven (io_ring_, sockets): the batch in flight, guarded
+    // by mutex
+    bool completion = false;
+    bool in_flight = false;
+    std::vector<TsChunk> batch;
+    std::vector<struct iovec> iov;
+    size_t iov_next = 0;  // First iovec not yet fully sent
+    size_t batch_bytes = 0;
+    struct msghdr message {};
+  };
+
+  void SendLoop(Subscriber* subscriber);
+
+  // Completion-driven subscribers: takes the next batch off the queue and
+  // queues its send (subscriber.mutex held). Returns true once the
+  // subscriber is done (drained while closing, disconnected or failed); the
+  // caller then sets finished, after releasing the mutex.
+  bool SendNextLocked(Subscriber& subscriber);
+
+  // Queues the unsent part of the batch (subscriber.mutex held); false if
+  // the ring refused it.
+  bool QueueBatchLocked(Subscriber& subscriber);
+
+  // Completion of a subscriber's sendmsg (ring completion thread).
+  void OnSendComplete(Subscriber& subscriber, int32_t result);
+
+  // Starts an idle completion-driven subscriber on its queue, or finishes
+  // it; no-op for threaded subscribers (mutex_ held).
+  void Kick(Subscriber& subscriber);
+
+  // Queues [offset, size) of chunk at now, applying the slow-client policy;
+  // keyframe is KeyframeOffset() of the chunk. Returns false if the
+  // subscriber was evicted.
+  bool Enqueue(Subscriber& subscriber, const TsChunk& chunk, size_t offset, size_t keyframe,
+               std::chrono::steady_clock::time_point now);
+
+  // Disconnects subscriber immediately: unblocks its sender and discards
+  // its queue.
+  static void Disconnect(Subscriber& subscriber);
+
+  // Joins and removes subscribers whose sender has exited (mutex_ held).
+  void ReapLocked();
+
+  // Pipe subscribers: vmsplice()s iov, waking up for Disconnect(); false
+  // once the reader is gone or the subscriber is closing.
+  bool SpliceAll(Subscriber& subscriber, struct iovec* iov, size_t count);
+
+  // Releases the pinned chunks the pipe reader has consumed. True once none
+  // are left or the reader has closed.
+  static bool ReleaseSpliced(Subscriber& subscriber);
+
+  // Closes finished subscriber, or moves it to draining_ while its pipe
+  // still references pinned chunks (mutex_ held).
+  void RetireLocked(std::unique_ptr<Subscriber> subscriber);
+
+  // Starts a new cached GOP at a keyframe in chunk, extends the current one,
+  // or drops it when it outgrows the cache (mutex_ held).
+  void UpdateGopCacheLocked(const TsChunk& chunk);
+
+  const size_t max_subscribers_;
+  const size_t queue_bytes_;
+  const SlowClientPolicy policy_;
+  const size_t gop_cache_bytes_;
+  const size_t send_batch_bytes_;
+  const int64_t send_batch_delay_us_;
+  const std::chrono::milliseconds max_lag_;  // Zero = no lag limit
+  const std::shared_ptr<runtime::IoRing> io_ring_;  // Null or closed = sender threads
+
+  mutable std::mutex mutex_;
+  std::list<std::unique_ptr<Subscriber>> subscribers_;
+  std::list<std::unique_ptr<Subscriber>> draining_;  // Finished pipe subscribers
+  TsFanoutStats stats_;  // Guarded by mutex_ (subscribers filled in by GetStats)
+  std::atomic<uint64_t> send_failures_{0};  // Counted by the senders
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> send_syscalls_{0};
+  std::atomic<size_t> max_batch_chunks_{0};
+
+  // GOP cache (guarded by mutex_): the latest PAT and PMT packets, and the
+  // chunks (with start offset) from the latest keyframe on
+  std::vector<uint8_t> pat_packet_;
+  std::vector<uint8_t> pmt_packet_;
+  uint16_t pmt_pid_ = 0;
+  bool pmt_pid_known_ = false;
+  TsChunk gop_prefix_;  // PAT/PMT sent first when the GOP does not start with them
+  std::deque<std::pair<TsChunk, size_t>> gop_cache_;
+  size_t gop_cache_size_ = 0;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FANOUT_HPP_
@@ -0,0 +1,78 @@
+// Repository: Retrovue-playout
+// Component: TS Filler Clip
+// Purpose: Pre-muxed frames (underflow filler, cached airings), re-timed on emit.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FILLER_CLIP_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FILLER_CLIP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsFillerClip holds a muxed clip (an IDR followed by P-frames, as produced
+// by EncoderPipeline) split into one run of TS packets per video frame, so
+// the sink can emit underflow filler, or a cached airing of an asset (see
+// TsAssetCache), without encoding anything. Packets of other streams (the
+// audio of a cached airing) go with the video frame they follow.
+//
+// AppendFrame() copies a frame's packets and moves every PES timestamp and
+// PCR by one offset so the frame presents at the requested time. Times are
+// on the encoder's input timeline, like EncoderPipeline::encodeFrame()'s
+// pts90k; the muxer's delay is carried over from the clip. Continuity
+// counters are left as muxed; the caller's TsPacketInspector (or TSMuxer's
+// WriteMuxed()) rewrites them to follow the stream the clip is spliced
+// into.
+//
+// Not thread-safe to load; a loaded clip is read-only, so clips shared by
+// TsAssetCache are emitted by several pipelines at once.
+class TsFillerClip {
+ public:
+  TsFillerClip() = default;
+
+  // Splits ts (whole packets) into frames at each video PES start, keeping
+  // the PAT/PMT that precede it. Returns false, leaving the clip empty, if
+  // no video frame with a PTS is found. The clip's first frame must have
+  // been encoded at PTS 0.
+  bool Load(std::vector<uint8_t> ts);
+
+  void Clear();
+
+  bool empty() const { return frames_.empty(); }
+  size_t frame_count() const { return frames_.size(); }
+  size_t size_bytes() const { return ts_.size(); }
+
+  // The muxed clip, as loaded.
+  const std::vector<uint8_t>& bytes() const { return ts_; }
+
+  // When frame index presents, relative to the first frame (90 kHz).
+  int64_t FrameOffset90k(size_t index) const { return frames_[index].pts90k - mux_delay_90k_; }
+
+  // The last frame presenting at or before offset90k + tolerance90k after
+  // the first; frame_count() if offset90k is more than tolerance90k past
+  // the last frame.
+  size_t FindFrame(int64_t offset90k, int64_t tolerance90k) const;
+
+  // Appends frame index, re-timed to present at pts90k, to out. Returns
+  // the frame's new DTS (input timeline).
+  int64_t AppendFrame(size_t index, int64_t pts90k, std::vector<uint8_t>* out) const;
+
+ private:
+  struct FrameRun {
+    size_t offset = 0;  // Bytes into ts_
+    size_t size = 0;
+    int64_t pts90k = 0;
+    int64_t dts90k = 0;
+  };
+
+  std::vector<uint8_t> ts_;
+  std::vector<FrameRun> frames_;
+  uint16_t video_pid_ = 0;
+  int64_t mux_delay_90k_ = 0;  // Muxed PTS of the frame encoded at PTS 0
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_FILLER_CLIP_HPP_
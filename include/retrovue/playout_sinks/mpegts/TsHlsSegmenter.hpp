@@ -0,0 +1,170 @@
+// Repository: Retrovue-playout
+// Component: TS HLS Segmenter
+// Purpose: Cuts the muxed TS into in-memory HLS/LL-HLS segments and serves them.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_HLS_SEGMENTER_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_HLS_SEGMENTER_HPP_
+
+#include "retrovue/telemetry/MetricsHTTPServer.h"
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// Segmenting and playlist parameters of a TsHlsSegmenter.
+struct HlsSegmenterConfig {
+  std::string path = "/hls";    // URL prefix: <path>/index.m3u8, segments below it
+  int64_t segment_ms = 2000;    // A segment ends at the first IDR after this long
+  int64_t part_ms = 333;        // LL-HLS partial segment target (0 = plain HLS)
+  size_t window_segments = 6;   // Complete segments kept (and listed)
+};
+
+// TsHlsSegmenterStats is a point-in-time view of the segmenter.
+struct TsHlsSegmenterStats {
+  uint64_t segments = 0;          // Segments completed
+  uint64_t parts = 0;             // Partial segments published
+  uint64_t media_sequence = 0;    // Oldest segment in the playlist
+  uint64_t discontinuities = 0;   // Timestamp jumps marked EXT-X-DISCONTINUITY
+  size_t stored_bytes = 0;        // Segments and parts held in memory
+  uint64_t playlist_requests = 0;
+  uint64_t blocked_requests = 0;  // Playlist or part requests held for new media
+  uint64_t media_requests = 0;    // Segment and part requests served
+};
+
+// TsHlsSegmenter turns the sink's muxed TS into an HLS stream held in
+// memory, so players are served straight from the playout process without
+// a packager, files or an extra process per channel.
+//
+// Segments start at the video IDRs the encoder already produces (the
+// random access indicator of a video PES): a segment ends at the first IDR
+// at least segment_ms after its start, so with fixed_gop and a gop_size of
+// segment_ms every segment is one GOP. Each segment starts with PAT/PMT.
+// Durations come from the video DTS.
+//
+// With part_ms, segments are also published as LL-HLS partial segments
+// while they are being cut: a part ends at the last video frame that keeps
+// it within part_ms, and a part starting on an IDR is INDEPENDENT. The
+// playlist advertises blocking reloads (_HLS_msn/_HLS_part) and a preload
+// hint for the next part; both are held until the media exists, so a
+// player learns of every part as soon as it is cut. Parts are kept for the
+// last three segments only.
+//
+// The store is bounded: window_segments complete segments and the one being
+// cut. Bodies are shared, so a response never copies a segment.
+//
+// Thread Model: Write() from the sink's output thread; HandleRequest() from
+// HTTP connection threads, where it may block; Open() while Write() is not
+// running; Close() from any thread.
+class TsHlsSegmenter {
+ public:
+  static constexpr size_t kPacketSize = 188;
+
+  explicit TsHlsSegmenter(const HlsSegmenterConfig& config);
+
+  TsHlsSegmenter(const TsHlsSegmenter&) = delete;
+  TsHlsSegmenter& operator=(const TsHlsSegmenter&) = delete;
+
+  // Appends size bytes of whole TS packets (null packets are skipped).
+  void Write(const uint8_t* data, size_t size);
+  void Write(const struct iovec* parts, size_t count);
+
+  // Accepts requests again after Close(); the stream resumes at the next
+  // IDR behind an EXT-X-DISCONTINUITY. Call while Write() is not running.
+  void Open();
+
+  // Releases held requests; they and later ones are answered 503.
+  void Close();
+
+  // Serves <path>/index.m3u8, seg<N>.ts and part<N>.<I>.ts.
+  bool HandleRequest(const telemetry::HttpRequest& request, telemetry::HttpResponse& response);
+
+  TsHlsSegmenterStats GetStats() const;
+
+ private:
+  using Body = std::shared_ptr<const std::string>;
+
+  struct Part {
+    Body data;
+    double duration = 0.0;
+    bool independent = false;
+  };
+
+  struct Segment {
+    uint64_t sequence = 0;
+    bool discontinuity = false;
+    bool complete = false;
+    double duration = 0.0;
+    Body data;                  // Set when complete
+    std::vector<Part> parts;    // Dropped once the segment leaves the part window
+  };
+
+  static constexpr size_t kPartWindowSegments = 3;
+
+  void WritePacket(const uint8_t* packet);
+
+  // Cutting (output thread)
+  void OpenSegment(bool discontinuity);
+  void ClosePart();
+  void CloseSegment();
+  void FlushPsi();
+
+  // Call with mutex_ held.
+  std::string RenderPlaylistLocked() const;
+  bool ReachedLocked(uint64_t msn, int64_t part) const;
+  const Segment* FindLocked(uint64_t sequence) const;
+  std::chrono::milliseconds HoldTimeout() const;
+
+  const HlsSegmenterConfig config_;
+  const int64_t segment_90k_;
+  const int64_t part_90k_;
+
+  // Parser and cutter state (output thread)
+  uint16_t pmt_pid_ = 0x1FFF;
+  uint16_t video_pid_ = 0x1FFF;
+  std::string pat_packet_;
+  std::string pmt_packet_;
+  std::string psi_pending_;     // PAT/PMT held until the next media packet
+  bool started_ = false;        // Cutting from the first IDR on
+  bool discontinuity_pending_ = false;
+  int64_t last_dts_ = 0;
+  int64_t frame_90k_ = 0;       // Duration of the last video frame
+  int64_t media_90k_ = 0;       // Video time since the first IDR
+  int64_t segment_start_90k_ = 0;
+  int64_t part_start_90k_ = 0;
+  bool part_independent_ = false;
+  std::string part_bytes_;
+  std::string segment_bytes_;
+
+  // Store (shared with the HTTP threads)
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<Segment> segments_;  // Oldest first; the last one may be in progress
+  uint64_t next_sequence_ = 0;
+  uint64_t discontinuity_sequence_ = 0;
+  double longest_segment_ = 0.0;
+  size_t stored_bytes_ = 0;
+  bool closed_ = false;
+
+  std::atomic<uint64_t> segments_total_{0};
+  std::atomic<uint64_t> parts_total_{0};
+  std::atomic<uint64_t> discontinuities_{0};
+  std::atomic<uint64_t> playlist_requests_{0};
+  std::atomic<uint64_t> blocked_requests_{0};
+  std::atomic<uint64_t> media_requests_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_HLS_SEGMENTER_HPP_
@@ -0,0 +1,186 @@
+// Repository: Retrovue-playout
+// Component: TS MPTS Multiplexer
+// Purpose: Statistically multiplexes several channels into one multi-program transport stream.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MPTS_MUX_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MPTS_MUX_HPP_
+
+#include "retrovue/playout_sinks/mpegts/TsPacer.hpp"
+#include "retrovue/playout_sinks/mpegts/TsUdpOutput.hpp"
+#include "retrovue/timing/MasterClock.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// PIDs of program n (1-255) in an MPTS, so programs muxed apart never
+// collide: PMT 0x1000 + n, video (and PCR) 0x100 + 2n, audio 0x101 + 2n.
+struct MptsProgramPids {
+  uint16_t pmt_pid;
+  uint16_t video_pid;
+  uint16_t audio_pid;
+};
+inline MptsProgramPids MptsPidsForProgram(uint16_t program_number) {
+  return {static_cast<uint16_t>(0x1000 + program_number),
+          static_cast<uint16_t>(0x100 + 2 * program_number),
+          static_cast<uint16_t>(0x101 + 2 * program_number)};
+}
+
+// Shared transport stream and its destination.
+struct MptsConfig {
+  int64_t total_rate_bps = 0;      // Whole transport stream, null-stuffed
+  size_t burst_packets = 7;        // Packets per paced write
+  int64_t max_queue_ms = 500;      // Backlog before sending above the rate
+  uint16_t transport_stream_id = 1;
+  UdpOutputConfig udp;             // Where the MPTS goes (udp.txtime applies)
+};
+
+// One channel's program in the MPTS.
+struct MptsProgramConfig {
+  uint16_t program_number = 0;     // 1-255
+  int64_t min_video_bps = 0;       // Allocation floor
+  int64_t max_video_bps = 0;       // Allocation ceiling
+  int64_t overhead_bps = 0;        // Audio and PSI carried beside the video
+};
+
+struct MptsProgramStats {
+  uint16_t program_number = 0;
+  int64_t video_bps = 0;           // Current allocation
+  double complexity = 0.0;         // Smoothed, in the encoders' units
+  uint64_t gops = 0;               // Complexity reports
+  uint64_t bytes = 0;              // TS bytes muxed
+};
+
+// TsMptsMuxStats is a point-in-time view of the multiplexer.
+struct TsMptsMuxStats {
+  int64_t video_budget_bps = 0;    // Shared among the programs' video
+  uint64_t allocations = 0;        // Reallocations (one per reported GOP)
+  uint64_t pat_packets = 0;        // The MPTS's own PATs sent
+  TsPacerStats pacer;
+  TsUdpOutputStats udp;
+  std::vector<MptsProgramStats> programs;  // In program number order
+};
+
+// TsMptsMux carries several channels of one process in a single transport
+// stream of total_rate_bps, and shares that rate among their video
+// encoders instead of giving each channel a fixed bitrate for its worst
+// case.
+//
+// Multiplexing: each channel muxes its own program with the PIDs of
+// MptsPidsForProgram() (the sink's native muxer does this when it joins)
+// and Push()es its output here. The channels' PATs are dropped and the
+// multiplexer sends one PAT listing every program (every kPatIntervalUs,
+// and at once when a program joins or leaves, with a new version); PMTs
+// and elementary streams pass through. One TsPacer sends the combined
+// stream at total_rate_bps, null-stuffed, restamping each program's PCRs
+// on its own line against the shared schedule, to one TsUdpOutput.
+//
+// Statistical multiplexing: each encoder reports its complexity once per
+// GOP (bits times quantizer step per second: what the GOP would cost at a
+// common quality). On every report the video budget - total_rate_bps less
+// kMuxOverheadPercent for TS/PES headers and every program's
+// overhead_bps - is shared out: each program gets its min_video_bps, and
+// the rest in proportion to its smoothed complexity, capped at
+// max_video_bps with the excess going to the others. A program without a
+// report yet weighs as the average. A program whose allocation moved more
+// than kMinChangePercent is told through its BitrateCallback; encoders
+// that reconfigure on the fly (libx264, NVENC) change rate from the next
+// frame.
+//
+// Thread Model: all methods are thread-safe. Push() and ReportComplexity()
+// come from the channels' output and encode threads; callbacks run on the
+// reporting thread under the multiplexer's lock and must not call back
+// into it.
+class TsMptsMux {
+ public:
+  using BitrateCallback = std::function<void(int64_t video_bps)>;
+
+  static constexpr size_t kMaxPrograms = 42;  // As many as one PAT packet lists
+  static constexpr int64_t kPatIntervalUs = 100'000;
+  static constexpr int64_t kMuxOverheadPercent = 5;
+  static constexpr int64_t kMinChangePercent = 2;
+  static constexpr double kComplexitySmoothing = 0.5;  // Weight of the newest GOP
+
+  TsMptsMux(const MptsConfig& config, std::shared_ptr<retrovue::timing::MasterClock> clock);
+  ~TsMptsMux();
+
+  TsMptsMux(const TsMptsMux&) = delete;
+  TsMptsMux& operator=(const TsMptsMux&) = delete;
+
+  // Opens the output and starts pacing.
+  bool Start();
+
+  // Sends what is queued and closes the output.
+  void Stop();
+
+  // Adds a program; false if its number is taken or out of range, its
+  // limits are inconsistent, kMaxPrograms are in, or the programs' floors
+  // no longer fit the budget. set_bitrate is called at once with its first
+  // allocation.
+  bool AddProgram(const MptsProgramConfig& program, BitrateCallback set_bitrate);
+  void RemoveProgram(uint16_t program_number);
+
+  // Queues a program's TS output; trailing bytes short of a packet wait for
+  // its next call. Ignored for a program that was not added.
+  void Push(uint16_t program_number, const uint8_t* data, size_t size);
+
+  // A program's video completed a GOP of this complexity (per second).
+  void ReportComplexity(uint16_t program_number, double complexity);
+
+  TsMptsMuxStats GetStats() const;
+
+ private:
+  struct Program {
+    MptsProgramConfig config;
+    MptsProgramPids pids;
+    BitrateCallback set_bitrate;
+    std::vector<uint8_t> partial;  // Bytes short of a packet
+    double complexity = 0.0;       // 0 = no report yet
+    int64_t video_bps = 0;
+    uint64_t gops = 0;
+    uint64_t bytes = 0;
+  };
+
+  static int PacedWriteThunk(void* opaque, uint8_t* buf, int buf_size);
+  static int PacedTimedWriteThunk(void* opaque, uint8_t* buf, int buf_size,
+                                  const int64_t* slot_utc_us);
+
+  Program* FindLocked(uint16_t program_number);
+
+  // Video rate left for the programs once PSI, TS and their overheads are
+  // taken out.
+  int64_t VideoBudgetLocked() const;
+
+  // Shares the budget out and tells the programs that moved.
+  void ReallocateLocked();
+
+  // Queues a PAT of every program when it is due (or forced).
+  void MaybeSendPatLocked(bool force);
+
+  // Queues whole packets, without the channels' PATs.
+  void PushPacketsLocked(const uint8_t* data, size_t size);
+
+  const MptsConfig config_;
+  const std::shared_ptr<retrovue::timing::MasterClock> clock_;
+  TsUdpOutput udp_output_;
+  TsPacer pacer_;
+
+  mutable std::mutex mutex_;
+  std::vector<Program> programs_;  // In program number order
+  bool running_ = false;
+  uint8_t pat_version_ = 0;
+  uint8_t pat_continuity_ = 0;
+  int64_t last_pat_us_ = 0;
+  uint64_t allocations_ = 0;
+  uint64_t pat_packets_ = 0;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_MPTS_MUX_HPP_
@@ -12,15 +12,28 @@
 #include <mutex>
 #include <thread>
 
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+
 namespace retrovue::playout_sinks::mpegts {
 
 // TsOutputSink wraps a Unix Domain Socket (AF_UNIX, SOCK_STREAM) for outputting
 // MPEG-TS packets. Air acts as the server (binds/listens), ChannelManager connects as client.
+// Each accepted client becomes a subscriber of the fanout, so several
+// clients (e.g. ChannelManager and a recorder) can read the same stream.
+//
+// In pipe mode each client is instead sent the read end of a new pipe
+// (one byte with SCM_RIGHTS), its socket is closed, and the stream is
+// vmsplice()d into the pipe for the client to splice() to a file or read();
+// see TsFanout for the limits of that zero-copy path.
 class TsOutputSink {
  public:
+  static constexpr int kPipeBytes = 1024 * 1024;  // Requested pipe capacity
+
   // Constructs a TS output sink with the given socket path.
   // socket_path: Path to Unix domain socket (e.g., /var/run/retrovue/air/channel_1.sock)
-  explicit TsOutputSink(const std::string& socket_path);
+  // fanout: Receives accepted clients; must outlive the sink
+  // pipe_mode: Hand clients a pipe instead of writing to their socket
+  TsOutputSink(const std::string& socket_path, TsFanout& fanout, bool pipe_mode = false);
   
   ~TsOutputSink();
 
@@ -39,17 +52,18 @@ class TsOutputSink {
   // Returns true on success, false on failure.
   bool Start();
 
-  // Stop accepting connections and close sockets.
+  // Stop accepting connections and close the listen socket. Connected
+  // clients belong to the fanout and are closed by its owner.
   void Stop();
 
-  // Write TS data to the connected client.
+  // Queue TS data for every connected client.
   // data: Pointer to TS packet data
   // size: Number of bytes to write
-  // Returns true if all bytes were written, false on error or no client connected.
-  // This method is thread-safe and uses blocking socket (ensures atomic packet writes).
+  // Returns false if no client is connected. Never blocks on a client; each
+  // client's sender writes whole packets to its blocking socket in order.
   bool Write(const uint8_t* data, size_t size);
 
-  // Check if a client is currently connected.
+  // Check if at least one client is connected.
   bool IsClientConnected() const;
 
   // Get the socket path.
@@ -59,20 +73,21 @@ class TsOutputSink {
   // Accept thread function (handles client connections).
   void AcceptThread();
 
-  // Try to accept a new client connection (non-blocking).
-  // Returns true if client connected, false otherwise.
+  // Accept pending client connections (non-blocking).
+  // Returns true if any client was added to the fanout.
   bool TryAcceptClient();
 
-  // Handle client disconnect (cleanup and prepare for reconnect).
-  void HandleClientDisconnect();
+  // Pipe mode: passes a new pipe's read end to client_fd and closes it.
+  // Returns the write end, or -1 on failure.
+  int HandOffPipe(int client_fd);
 
   // Cleanup socket resources.
   void CleanupSocket();
 
   std::string socket_path_;
+  TsFanout& fanout_;
+  const bool pipe_mode_;
   int listen_fd_;
-  int client_fd_;
-  std::atomic<bool> client_connected_;
   std::atomic<bool> running_;
   std::atomic<bool> stop_requested_;
   std::thread accept_thread_;
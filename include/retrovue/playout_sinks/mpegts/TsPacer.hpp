@@ -0,0 +1,178 @@
+// Repository: Retrovue-playout
+// Component: TS Pacer
+// Purpose: Constant-bitrate output pacing with null stuffing and PCR restamping.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACER_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACER_HPP_
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsPacerStats is a point-in-time view of the pacer.
+struct TsPacerStats {
+  int64_t rate_bps = 0;
+  uint64_t packets_sent = 0;          // Muxed packets sent
+  uint64_t null_packets = 0;          // Stuffing sent to hold the rate
+  uint64_t overrun_packets = 0;       // Sent above the rate because the backlog was full
+  uint64_t pcr_restamps = 0;
+  uint64_t pcr_discontinuities = 0;   // PCR re-anchored (input timeline jumped)
+  uint64_t schedule_resets = 0;       // Schedule restarted after a stall
+  size_t queue_packets = 0;           // Backlog now
+  size_t peak_queue_packets = 0;
+  size_t max_burst_packets = 0;       // Most packets written back to back
+  int64_t last_late_us = 0;           // Write time behind the CBR schedule
+  int64_t max_late_us = 0;
+};
+
+// TsPacer sits between the muxer and the clients and turns bursty muxer
+// output into a constant-bitrate stream.
+//
+// Push() queues whole TS packets. A pacing thread sends them on a token
+// bucket filled at rate_bps from the MasterClock: every burst_packets
+// worth of tokens it writes that many packets, muxed ones first and null
+// packets (PID 0x1FFF) for the rest, so the output rate holds whether or
+// not the encoder produced anything. burst_packets is the configured
+// burstiness; the measured one (largest back-to-back write, and how far a
+// write trailed the schedule) is in GetStats().
+//
+// PCRs are restamped with the time of their packet's slot in the schedule,
+// against an offset taken from the first PCR on their PID, so the PCR follows the
+// constant-rate delivery instead of the muxer's bursts. If a PCR strays
+// more than kPcrReanchorUs from that line (a new encoder session, or the
+// input drifting) the offset is taken again and the packet is flagged as a
+// discontinuity.
+//
+// A backlog beyond max_queue_ms at the rate is sent at once rather than
+// dropped (counted as overruns): rate_bps must exceed the muxed bitrate.
+// The pacer idles, sending nothing, until the first packet after Start()
+// or Reset().
+//
+// With SetTimedWrite() each burst is written lead_us before its first slot,
+// together with every packet's slot time, so an output that hands launch
+// times to the kernel (SO_TXTIME) has the NIC's queue discipline put the
+// packets on the wire on schedule, free of the pacing thread's wake-up
+// jitter. SetLeadUs(0) goes back to writing on schedule.
+//
+// Thread Model: Push() and Reset() from the owner's output path (not
+// concurrently with one another), Start() and Stop() from the owner;
+// GetStats() from any thread. write is called on
+// the pacing thread.
+class TsPacer {
+ public:
+  using WriteCallback = int (*)(void* opaque, uint8_t* buf, int buf_size);
+  // slot_utc_us[i]: MasterClock time packet i is due on the wire.
+  using TimedWriteCallback = int (*)(void* opaque, uint8_t* buf, int buf_size,
+                                     const int64_t* slot_utc_us);
+
+  static constexpr size_t kPacketSize = 188;
+  static constexpr int64_t kPcrReanchorUs = 100'000;
+  static constexpr int64_t kStallResetUs = 500'000;  // Behind schedule: restart it
+
+  // rate_bps: output rate; burst_packets: packets per paced write;
+  // max_queue_ms: backlog (at rate_bps) before sending above the rate.
+  TsPacer(std::shared_ptr<retrovue::timing::MasterClock> clock, int64_t rate_bps,
+          size_t burst_packets, int64_t max_queue_ms, void* opaque, WriteCallback write);
+  ~TsPacer();
+
+  TsPacer(const TsPacer&) = delete;
+  TsPacer& operator=(const TsPacer&) = delete;
+
+  bool Start();
+
+  // Writes through write instead, lead_us ahead of the schedule (before
+  // Start()).
+  void SetTimedWrite(TimedWriteCallback write, int64_t lead_us);
+
+  // Changes the lead from any thread; 0 = write on schedule.
+  void SetLeadUs(int64_t lead_us) { lead_us_.store(lead_us, std::memory_order_relaxed); }
+
+  // Sends the backlog (without stuffing) and stops the pacing thread.
+  void Stop();
+
+  // Queues data; trailing bytes short of a packet wait for the next call.
+  void Push(const uint8_t* data, size_t size);
+
+  // Drops the backlog and idles until the next Push() (muxer closed).
+  void Reset();
+
+  TsPacerStats GetStats() const;
+
+ private:
+  void PaceLoop();
+
+  // Microseconds from the schedule's start to packet slot n.
+  int64_t SlotUs(uint64_t n) const;
+
+  // Fills out_ (and with timed writes out_slot_us_) with count packets for
+  // slots from first_slot on (caller holds mutex_).
+  void TakeLocked(size_t count, uint64_t first_slot);
+
+  // Rewrites packet's PCR, if it has one, for the slot sent at slot_us.
+  void RestampPcr(uint8_t* packet, int64_t slot_us);
+
+  // Writes out_ (pacing thread, mutex_ not held).
+  void WriteOut();
+
+  const std::shared_ptr<retrovue::timing::MasterClock> clock_;
+  const int64_t rate_bps_;
+  const size_t burst_packets_;
+  const size_t queue_limit_packets_;
+  void* const opaque_;
+  const WriteCallback write_;
+  TimedWriteCallback timed_write_ = nullptr;
+  std::atomic<int64_t> lead_us_{0};
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;
+  bool running_ = false;     // Guarded by mutex_
+  bool stopping_ = false;
+
+  // Backlog: whole packets from queue_head_ on; partial_ holds a split one
+  std::vector<uint8_t> queue_;
+  size_t queue_head_ = 0;
+  std::vector<uint8_t> partial_;
+
+  // Schedule (pacing thread, and Reset() under mutex_)
+  bool scheduled_ = false;
+  int64_t schedule_start_us_ = 0;
+  uint64_t slots_sent_ = 0;
+
+  // PCR lines, one per PCR PID (one per program of an MPTS): restamped
+  // PCR = slot time (27 MHz) + offset_27m
+  struct PcrLine {
+    uint16_t pid;
+    int64_t offset_27m;
+  };
+  std::vector<PcrLine> pcr_lines_;
+
+  std::vector<uint8_t> out_;  // Packets being written (pacing thread)
+  std::vector<int64_t> out_slot_us_;
+
+  std::atomic<uint64_t> packets_sent_{0};
+  std::atomic<uint64_t> null_packets_{0};
+  std::atomic<uint64_t> overrun_packets_{0};
+  std::atomic<uint64_t> pcr_restamps_{0};
+  std::atomic<uint64_t> pcr_discontinuities_{0};
+  std::atomic<uint64_t> schedule_resets_{0};
+  std::atomic<size_t> queue_packets_{0};
+  std::atomic<size_t> peak_queue_packets_{0};
+  std::atomic<size_t> max_burst_packets_{0};
+  std::atomic<int64_t> last_late_us_{0};
+  std::atomic<int64_t> max_late_us_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACER_HPP_
@@ -0,0 +1,123 @@
+// Repository: Retrovue-playout
+// Component: TS Packet Inspector
+// Purpose: Continuity counter repair and sampled validation of muxed MPEG-TS packets.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACKET_INSPECTOR_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACKET_INSPECTOR_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "retrovue/telemetry/EncoderTelemetry.h"
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsInspectorStats is a point-in-time view of the inspector's counters.
+struct TsInspectorStats {
+  uint64_t packets = 0;                 // Packets inspected (every packet is CC-repaired)
+  uint64_t sync_errors = 0;             // Bytes skipped resynchronising on 0x47
+  uint64_t continuity_corrections = 0;  // CC fields rewritten in place
+  uint64_t validated_packets = 0;       // Packets in sampled buffers
+  uint64_t continuity_mismatches = 0;   // Raw (pre-repair) CC gaps in sampled buffers
+  uint64_t pcr_cadence_warnings = 0;    // PCR spacing outside 20-60 ms of wall time
+};
+
+// TsPacketInspector runs over every buffer the muxer writes, before it
+// leaves the pipeline.
+//
+// Repair runs on every packet: the CC of each payload packet is rewritten
+// to follow the previous one on its PID, and adaptation-only packets repeat
+// it (a discontinuity indicator restarts the PID). Validation - raw CC gap
+// statistics and PCR cadence against wall time - is observational, so it
+// can be sampled: with validation_interval N only every Nth buffer is
+// validated, and per-PID validation state restarts at each sampled buffer
+// so skipped buffers do not count as gaps.
+//
+// Per-PID state lives in flat 8192-entry tables indexed by the 13-bit PID,
+// so the hot path has no lookups or allocation. Sync bytes of a whole
+// buffer are checked in one pass first; only a buffer with a bad sync byte
+// takes the byte-by-byte resync path.
+//
+// Thread Model: Process(), Reset() and the per-PID getters from the
+// muxer's write thread (or after it has stopped); GetStats() from any thread.
+class TsPacketInspector {
+ public:
+  static constexpr size_t kPacketSize = 188;
+  static constexpr size_t kPidCount = 8192;
+  static constexpr uint16_t kNullPid = 0x1FFF;
+
+  // validation_interval: validate every Nth buffer (0 = never, 1 = all).
+  explicit TsPacketInspector(uint32_t validation_interval = 1);
+
+  TsPacketInspector(const TsPacketInspector&) = delete;
+  TsPacketInspector& operator=(const TsPacketInspector&) = delete;
+
+  // Forgets all PID state and zeroes the counters (new muxer session).
+  void Reset();
+
+  // Repairs continuity counters in place and validates sampled buffers.
+  // Trailing bytes short of a whole packet are left untouched.
+  void Process(uint8_t* data, size_t size);
+
+  TsInspectorStats GetStats() const;
+
+  // Reports the PCRs of validated buffers (spacing and jitter against wall
+  // time) to telemetry; null stops. Set before the muxer starts writing.
+  void SetTelemetry(retrovue::telemetry::EncoderTelemetry* telemetry) { telemetry_ = telemetry; }
+
+  // Per-PID counts from sampled buffers.
+  uint64_t GetPidPackets(uint16_t pid) const;
+  uint64_t GetPidMismatches(uint16_t pid) const;
+
+  // Prints the totals and the PIDs with the highest mismatch rates.
+  void LogSummary() const;
+
+  // True if size is a whole number of packets, each starting with 0x47.
+  static bool SyncBytesValid(const uint8_t* data, size_t size);
+
+  // PCR base (90 kHz) of a packet's adaptation field, if it carries one.
+  static bool ExtractPCR(const uint8_t* ts_packet, int64_t& pcr_90k);
+
+ private:
+  static constexpr uint8_t kNoCc = 0xFF;  // PID not seen yet
+
+  // Repairs (and, when validate, checks) one packet with a good sync byte.
+  void InspectPacket(uint8_t* ts_packet, bool validate);
+
+  void CheckPcrCadence(int64_t pcr_90k);
+
+  const uint32_t validation_interval_;
+  uint64_t buffers_ = 0;
+  bool last_buffer_validated_ = false;
+
+  // Repair state: last CC written per PID
+  std::vector<uint8_t> cc_;
+  // Validation state: last raw CC per PID, and per-PID counts
+  std::vector<uint8_t> raw_cc_;
+  std::vector<uint64_t> pid_packets_;
+  std::vector<uint64_t> pid_mismatches_;
+
+  // PCR cadence state
+  int64_t last_pcr_90k_ = 0;
+  int64_t last_pcr_time_us_ = 0;
+  bool last_pcr_valid_ = false;
+  retrovue::telemetry::EncoderTelemetry* telemetry_ = nullptr;
+
+  // Per-buffer tallies, published to the atomics at the end of Process()
+  TsInspectorStats pending_;
+  uint64_t correction_log_count_ = 0;
+
+  std::atomic<uint64_t> packets_{0};
+  std::atomic<uint64_t> sync_errors_{0};
+  std::atomic<uint64_t> continuity_corrections_{0};
+  std::atomic<uint64_t> validated_packets_{0};
+  std::atomic<uint64_t> continuity_mismatches_{0};
+  std::atomic<uint64_t> pcr_cadence_warnings_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_PACKET_INSPECTOR_HPP_
@@ -0,0 +1,95 @@
+// Repository: Retrovue-playout
+// Component: TS Rate Adapter
+// Purpose: Fits the video bitrate to the throughput the slowest TCP client sustains.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_RATE_ADAPTER_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_RATE_ADAPTER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsRateAdapterStats is a point-in-time view of a TsRateAdapter.
+struct TsRateAdapterStats {
+  int64_t video_bps = 0;          // Rate asked of the encoder now
+  int64_t throughput_bps = 0;     // Slowest client's estimated throughput (last congested sample)
+  uint64_t decreases = 0;         // Rate lowered for a congested client
+  uint64_t increases = 0;         // Rate raised back after the path recovered
+  uint64_t congested_samples = 0; // Samples in which the slowest client fell behind
+};
+
+// TsRateAdapter lowers the encoder's video bitrate when a TCP client's path
+// cannot carry the stream, before its queue fills and the fanout drops or
+// evicts, and raises it again once the path recovers.
+//
+// Sample() is fed the fanout's stats once per interval. The slowest
+// client's throughput is what was published over the interval less the
+// growth of the longest queue; that client is congested when its queue
+// grows beyond kBacklogMs of stream with a full socket send buffer, or when
+// the fanout dropped, resynced or evicted. The new rate then is kHeadroom
+// of that throughput, less what drains the backlog in kDrainMs, less the
+// overhead (audio, TS and PES headers), and never under min_bps. After
+// kRecoverSamples clear samples in a row the rate steps up by kStepUp, up
+// to max_bps. A change smaller than kMinChange is not worth a
+// reconfiguration and is skipped.
+//
+// One encode serves every client, so the slowest one sets the rate.
+//
+// Thread Model: Sample() and Reset() from one thread (the sink's output
+// thread); GetStats() from any thread.
+class TsRateAdapter {
+ public:
+  static constexpr int64_t kBacklogMs = 250;
+  static constexpr int64_t kDrainMs = 2000;
+  static constexpr double kHeadroom = 0.85;
+  static constexpr double kStepUp = 1.10;
+  static constexpr double kMinChange = 0.05;
+  static constexpr int kRecoverSamples = 5;
+  static constexpr double kFullSendBuffer = 0.9;  // send_buffer_ratio of a blocked socket
+
+  // max_bps: the configured video bitrate; overhead_bps: the rest of the
+  // stream (audio, PSI), on top of video.
+  TsRateAdapter(int64_t max_bps, int64_t min_bps, int64_t overhead_bps);
+
+  // Takes a sample elapsed_us after the last one. Returns the video bitrate
+  // to switch the encoder to, or 0 to leave it.
+  int64_t Sample(const TsFanoutStats& fanout, int64_t elapsed_us);
+
+  // Forgets the clients (no subscribers, or a new session); the next
+  // Sample() only takes a baseline. Returns max_bps if the rate was lowered,
+  // else 0.
+  int64_t Reset();
+
+  TsRateAdapterStats GetStats() const;
+
+ private:
+  // The video rate carrying total_bps of stream, within [min_bps_, max_bps_].
+  int64_t VideoRate(double total_bps) const;
+  int64_t Apply(int64_t video_bps);
+
+  const int64_t max_bps_;
+  const int64_t min_bps_;
+  const int64_t overhead_bps_;
+
+  bool have_baseline_ = false;
+  uint64_t last_published_ = 0;
+  size_t last_queued_ = 0;
+  uint64_t last_losses_ = 0;
+  int clear_samples_ = 0;
+  int64_t video_bps_;
+
+  std::atomic<int64_t> video_bps_stat_;
+  std::atomic<int64_t> throughput_bps_{0};
+  std::atomic<uint64_t> decreases_{0};
+  std::atomic<uint64_t> increases_{0};
+  std::atomic<uint64_t> congested_samples_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_RATE_ADAPTER_HPP_
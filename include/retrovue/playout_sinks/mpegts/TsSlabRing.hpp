@@ -0,0 +1,122 @@
+// Repository: Retrovue-playout
+// Component: TS Slab Ring
+// Purpose: Lock-free single-producer queue of muxed TS bytes in recycled slabs.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SLAB_RING_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SLAB_RING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsSlabRingStats is a point-in-time view of the ring.
+struct TsSlabRingStats {
+  size_t capacity_bytes = 0;
+  size_t queued_bytes = 0;        // Written and not yet consumed
+  size_t peak_queued_bytes = 0;
+  uint64_t bytes_written = 0;
+  uint64_t writes_dropped = 0;    // Writes that did not fit (dropped whole)
+  uint64_t bytes_dropped = 0;
+};
+
+// TsSlabRing carries muxed TS bytes from one producer thread to one
+// consumer thread without locks or allocation.
+//
+// Storage is slab_count fixed-size slabs (a whole number of 188-byte
+// packets each), allocated once. Write() copies into the slabs after the
+// last one written and publishes them with one release store; the consumer
+// reads them in order through Front() and hands each one back with Pop(),
+// which returns it to the producer for reuse, so the ring itself is the
+// free list. A write is split over as many slabs as it needs and always
+// ends its last slab, so data is never held back waiting for more. A write
+// that does not fit in the free slabs is dropped whole, which keeps the
+// output on packet boundaries.
+//
+// Thread Model: Write() and Wake() from the producer; Front(), Peek(),
+// Pop(), Wait() and Discard() from the consumer; QueuedBytes() and
+// GetStats() from any thread.
+class TsSlabRing {
+ public:
+  static constexpr size_t kPacketSize = 188;
+
+  struct Slab {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+  };
+
+  // slab_bytes is rounded down to whole packets (at least one);
+  // capacity_bytes sets the slab count (at least two).
+  TsSlabRing(size_t slab_bytes, size_t capacity_bytes);
+
+  TsSlabRing(const TsSlabRing&) = delete;
+  TsSlabRing& operator=(const TsSlabRing&) = delete;
+
+  // Queues size bytes. Returns false (nothing queued) if they do not fit.
+  bool Write(const uint8_t* data, size_t size);
+
+  // Oldest unconsumed slab, or nullptr if the ring is empty.
+  const Slab* Front() const;
+
+  // Releases the slab returned by Front().
+  void Pop();
+
+  // Up to max of the oldest unconsumed slabs, in order (for gathered
+  // writes). Returns how many were stored in slabs.
+  size_t Peek(const Slab** slabs, size_t max) const;
+
+  // Releases the oldest count slabs (at most what Peek() returned).
+  void Pop(size_t count);
+
+  // Releases everything written so far.
+  void Discard();
+
+  // Blocks until a slab is queued or Wake() is called.
+  void Wait();
+
+  // Wakes a consumer blocked in Wait().
+  void Wake();
+
+  size_t QueuedBytes() const { return queued_bytes_.load(std::memory_order_relaxed); }
+
+  // Bytes the consumer has popped since construction (low, never high,
+  // while a write is under way).
+  uint64_t BytesConsumed() const {
+    const uint64_t written = bytes_written_.load(std::memory_order_relaxed);
+    const uint64_t queued = queued_bytes_.load(std::memory_order_relaxed);
+    return written > queued ? written - queued : 0;
+  }
+  uint64_t BytesWritten() const { return bytes_written_.load(std::memory_order_relaxed); }
+  size_t slab_bytes() const { return slab_bytes_; }
+
+  TsSlabRingStats GetStats() const;
+
+ private:
+  struct SlabStorage {
+    std::vector<uint8_t> bytes;  // slab_bytes_, allocated once
+    Slab view;                   // Filled by the producer before publishing
+  };
+
+  const size_t slab_bytes_;
+  std::vector<SlabStorage> slabs_;
+
+  // Slab sequence numbers (modulo slabs_.size() for the index); the
+  // producer owns write_seq_ and the consumer read_seq_
+  alignas(64) std::atomic<uint64_t> write_seq_{0};
+  alignas(64) std::atomic<uint64_t> read_seq_{0};
+
+  alignas(64) std::atomic<uint32_t> signal_{0};  // Bumped on every Write() and Wake()
+
+  std::atomic<size_t> queued_bytes_{0};
+  std::atomic<size_t> peak_queued_bytes_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::atomic<uint64_t> writes_dropped_{0};
+  std::atomic<uint64_t> bytes_dropped_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SLAB_RING_HPP_
@@ -0,0 +1,153 @@
+// Repository: Retrovue-playout
+// Component: TS SRT Output
+// Purpose: Sends MPEG-TS over an SRT contribution link (caller or listener).
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SRT_OUTPUT_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SRT_OUTPUT_HPP_
+
+#include "retrovue/playout_sinks/mpegts/TsSlabRing.hpp"
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// TsSrtOutputStats is a point-in-time view of the link. The link fields
+// come from SRT's own statistics, sampled every stats interval.
+struct TsSrtOutputStats {
+  bool connected = false;
+  uint64_t connections = 0;         // Peers connected since Open()
+  uint64_t bytes_sent = 0;          // TS bytes handed to SRT
+  uint64_t messages_sent = 0;       // Live-mode messages (up to 7 packets each)
+  uint64_t queue_drops = 0;         // Writes dropped because the link queue was full
+  uint64_t retransmits = 0;         // Packets retransmitted (all connections)
+  uint64_t packets_lost = 0;        // Packets the receiver reported lost (all connections)
+  uint64_t sender_drops = 0;        // Packets SRT dropped as too late to deliver (all connections)
+  double rtt_ms = 0.0;              // Smoothed round-trip time (current connection)
+  double send_rate_mbps = 0.0;      // Sending rate, retransmissions included
+  size_t send_buffer_bytes = 0;     // Unacknowledged bytes in SRT's send buffer
+  int send_buffer_ms = 0;           // Time span of those bytes
+  double send_buffer_fill = 0.0;    // Share of the send buffer in use (0-1)
+};
+
+// Called from the link thread with every stats sample.
+using SrtStatsCallback = std::function<void(const TsSrtOutputStats& stats)>;
+
+// Endpoint and link parameters of a TsSrtOutput.
+struct SrtOutputConfig {
+  std::string host;              // Caller: remote host; listener: local address (empty = any)
+  int port = 0;
+  bool listener = false;         // Wait for the remote end to call instead of calling it
+  int latency_ms = 120;          // SRT receiver latency (the retransmission window)
+  std::string passphrase;        // AES encryption; empty = off, else 10-79 characters
+  int key_length = 0;            // AES key bytes: 16, 24 or 32 (0 = SRT default)
+  std::string stream_id;         // Caller only: SRTO_STREAMID for the remote end
+  size_t queue_bytes = 2 * 1024 * 1024;  // Muxed bytes held for the link thread
+  int64_t stats_interval_ms = 1000;
+  SrtStatsCallback on_stats;     // Optional
+};
+
+// TsSrtOutput carries the TS stream over one SRT live-mode connection,
+// for contribution links over networks that lose and reorder packets.
+//
+// As caller it connects to host:port and reconnects after a failure; as
+// listener it binds host:port in Open() (so a busy port fails start-up)
+// and serves one remote caller at a time. Each queued slab (7 packets,
+// SRT's live payload size) goes out as one message; SRT retransmits lost
+// packets within latency_ms and drops what can no longer arrive in time.
+//
+// Send() only copies into the output's own slab ring, so a congested link
+// never holds up the other outputs: when the ring is full a write is
+// dropped whole (queue_drops). While no peer is connected nothing is
+// queued, and a new connection starts from live data.
+//
+// Requires libsrt (RETROVUE_SRT_AVAILABLE); without it Open() fails.
+//
+// Thread Model: Send() from one output thread; a link thread connects and
+// sends; Open() and Close() while the output thread is not sending.
+// GetStats() from any thread; on_stats runs on the link thread.
+class TsSrtOutput {
+ public:
+  static constexpr size_t kPacketSize = 188;
+  static constexpr size_t kPayloadSize = 7 * kPacketSize;  // SRT live payload (1316)
+
+  explicit TsSrtOutput(const SrtOutputConfig& config);
+  ~TsSrtOutput();
+
+  TsSrtOutput(const TsSrtOutput&) = delete;
+  TsSrtOutput& operator=(const TsSrtOutput&) = delete;
+
+  // Validates the configuration, binds the listener (listener mode) and
+  // starts the link thread.
+  bool Open();
+  void Close();
+
+  // Queues size bytes of whole TS packets. Returns false if they were
+  // dropped (closed, not connected or queue full).
+  bool Send(const uint8_t* data, size_t size);
+
+  // Queues count buffers in order.
+  bool Send(const struct iovec* parts, size_t count);
+
+  TsSrtOutputStats GetStats() const;
+
+ private:
+  static constexpr int kWaitSliceMs = 100;     // Bound on each wait, for Close()
+  static constexpr int64_t kReconnectDelayMs = 1000;
+
+  void LinkLoop();
+
+  // Establish a peer (bounded by kWaitSliceMs per call); false = not yet.
+  bool ConnectPeer();
+  bool AcceptPeer();
+
+  // Sends one slab, waiting for send buffer space; false = link broken.
+  bool SendSlab(const TsSlabRing::Slab& slab);
+
+  // Waits for events on sock; returns the events seen (0 on timeout).
+  int WaitEvents(int sock, int events, int timeout_ms);
+
+  bool ApplyOptions(int sock, bool caller);
+  void SampleStats();
+  void DropPeer(const char* reason);
+
+  SrtOutputConfig config_;
+  TsSlabRing ring_;
+
+  bool open_ = false;
+  std::thread link_thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> connected_{false};
+
+  // SRTSOCKET handles (libsrt uses int); owned by the link thread once open
+  int listen_sock_ = -1;
+  int peer_sock_ = -1;
+  int eid_ = -1;              // SRT epoll for the bounded waits
+  bool connecting_ = false;   // Caller: peer_sock_ has a connect in progress
+  std::chrono::steady_clock::time_point next_connect_{};
+  std::chrono::steady_clock::time_point next_stats_{};
+
+  std::atomic<uint64_t> connections_{0};
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> messages_sent_{0};
+
+  // Link statistics: totals of closed connections plus the last sample
+  mutable std::mutex link_mutex_;
+  TsSrtOutputStats link_;
+  uint64_t closed_retransmits_ = 0;
+  uint64_t closed_packets_lost_ = 0;
+  uint64_t closed_sender_drops_ = 0;
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_SRT_OUTPUT_HPP_
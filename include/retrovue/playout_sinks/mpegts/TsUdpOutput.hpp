@@ -0,0 +1,227 @@
+// Repository: Retrovue-playout
+// Component: TS UDP Output
+// Purpose: Sends MPEG-TS over UDP or RTP (unicast/multicast) with optional SMPTE 2022-1 FEC.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_UDP_OUTPUT_HPP_
+#define RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_UDP_OUTPUT_HPP_
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+// Destination and framing of a TsUdpOutput.
+struct UdpOutputConfig {
+  std::string host;            // IPv4 unicast address or multicast group
+  int port = 0;
+  bool rtp = false;            // RTP/AVP payload type 33 instead of raw UDP
+  int ttl = 16;                // Multicast TTL (unicast: IP TTL)
+  std::string interface_address;  // Local IPv4 address for multicast; empty = routing default
+  // SMPTE 2022-1 FEC (RTP only): column FEC over an L x D matrix on
+  // port + 2, and with fec_row also row FEC on port + 4. 0 = off.
+  int fec_columns = 0;         // L: 1-20
+  int fec_rows = 0;            // D: 4-20 (L x D <= 100)
+  bool fec_row = false;
+  // Kernel pacing: timed sends carry SO_TXTIME launch times, on CLOCK_TAI
+  // for the etf qdisc or with txtime_monotonic CLOCK_MONOTONIC for fq.
+  bool txtime = false;
+  bool txtime_monotonic = false;
+  int64_t txtime_lead_us = 2000;  // How far ahead of launch datagrams reach the kernel
+};
+
+// TsUdpOutputStats is a point-in-time view of the output.
+struct TsUdpOutputStats {
+  uint64_t datagrams_sent = 0;   // Media datagrams
+  uint64_t bytes_sent = 0;       // Media TS bytes
+  uint64_t fec_packets_sent = 0;
+  uint64_t send_syscalls = 0;    // sendmmsg() calls (datagrams per call = ratio)
+  uint64_t send_errors = 0;      // Datagrams the kernel refused
+  bool txtime_active = false;    // Launch times are being set (SO_TXTIME)
+  uint64_t txtime_missed = 0;    // Datagrams the qdisc dropped past their launch time
+  uint64_t txtime_samples = 0;   // Transmit timestamps measured
+  int64_t txtime_last_error_us = 0;  // Transmit time minus requested launch time
+  int64_t txtime_max_error_us = 0;   // Largest magnitude
+};
+
+// TsUdpOutput sends the TS stream as datagrams of up to 7 packets
+// (1316 bytes), the usual IPTV framing, to one unicast address or
+// multicast group, raw or with an RTP header (RFC 3551 MP2T, 90 kHz
+// timestamps from the MasterClock).
+//
+// Send() builds each datagram in a preallocated slot and hands every
+// datagram of the call to the kernel with as few sendmmsg() calls as the
+// batch size allows; packets left over from a call too short for a full
+// datagram go out in a shorter one rather than waiting for the next call.
+//
+// With fec_columns and fec_rows set (RTP only), SMPTE 2022-1 XOR FEC is
+// computed as the media is sent: one column FEC packet per column once an
+// L x D matrix fills, and with fec_row one row FEC packet per L media
+// packets, each stream on its own port as the standard expects.
+//
+// With txtime, Send() with packet times gives each datagram its first
+// packet's due time as an SO_TXTIME launch time, translated from the
+// MasterClock to the qdisc's clock, and the etf or fq qdisc releases it
+// then: the caller (TsPacer) hands datagrams over txtime_lead_us early
+// instead of waking on every slot. Every kTimestampInterval-th datagram
+// also asks for a software transmit timestamp, read back from the error
+// queue, so the stats show how far the achieved send time is from the
+// requested one. A kernel that rejects SO_TXTIME, or datagrams measured
+// leaving early (no etf/fq qdisc on the route's device), turn launch times
+// off: TxTimeActive() then goes false and the caller paces in user space.
+//
+// Thread Model: not thread-safe; Send() from one output thread, Open() and
+// Close() while it is not sending. GetStats() and TxTimeActive() from any
+// thread.
+class TsUdpOutput {
+ public:
+  static constexpr size_t kPacketSize = 188;
+  static constexpr size_t kPacketsPerDatagram = 7;
+  static constexpr size_t kMaxBatch = 64;  // Datagrams per sendmmsg()
+  static constexpr uint64_t kTimestampInterval = 64;  // Datagrams per transmit timestamp
+
+  TsUdpOutput(const UdpOutputConfig& config,
+              std::shared_ptr<retrovue::timing::MasterClock> clock);
+  ~TsUdpOutput();
+
+  TsUdpOutput(const TsUdpOutput&) = delete;
+  TsUdpOutput& operator=(const TsUdpOutput&) = delete;
+
+  // Validates the configuration and opens the socket.
+  bool Open();
+  void Close();
+
+  // Sends size bytes of whole TS packets (a trailing partial packet is
+  // dropped). Returns false if the socket is closed or a send failed.
+  bool Send(const uint8_t* data, size_t size);
+
+  // Sends count buffers of whole packets in one batch, each split into
+  // datagrams on its own.
+  bool Send(const struct iovec* parts, size_t count);
+
+  // Sends size bytes of whole packets, packet i due on the wire at
+  // packet_utc_us[i] (MasterClock time): the launch times with txtime, and
+  // the RTP timestamps.
+  bool Send(const uint8_t* data, size_t size, const int64_t* packet_utc_us);
+
+  // Launch times are being set; false once the output has fallen back.
+  bool TxTimeActive() const { return txtime_active_.load(std::memory_order_relaxed); }
+
+  TsUdpOutputStats GetStats() const;
+
+ private:
+  static constexpr size_t kRtpHeaderSize = 12;
+  static constexpr size_t kFecHeaderSize = 16;
+  static constexpr size_t kMaxPayload = kPacketSize * kPacketsPerDatagram;
+  static constexpr size_t kSlotSize = kRtpHeaderSize + kFecHeaderSize + kMaxPayload;
+  static constexpr size_t kControlSize = 64;  // SCM_TXTIME + SO_TIMESTAMPING messages
+  static constexpr size_t kSampleRing = 64;   // Timestamp requests awaiting their report
+  static constexpr int kEarlySamplesToFallBack = 8;
+
+  // XOR of the protected packets' recovery fields and payloads.
+  struct FecAccumulator {
+    std::vector<uint8_t> payload;  // kMaxPayload
+    uint16_t sn_base = 0;
+    uint16_t length_recovery = 0;
+    uint8_t pt_recovery = 0;
+    uint32_t ts_recovery = 0;
+    size_t max_length = 0;
+    size_t count = 0;
+  };
+
+  // Queues the datagrams of one buffer into the batch; with packet_utc_us
+  // each datagram takes its launch time and RTP timestamp from its first
+  // packet's.
+  void QueueMedia(const uint8_t* data, size_t size, uint32_t ts,
+                  const int64_t* packet_utc_us = nullptr);
+
+  // Next free slot in the batch, sending the batch first when full.
+  // With sample, the datagram asks for a transmit timestamp.
+  uint8_t* NextSlot(const sockaddr_in* destination, size_t size, bool sample = false);
+  bool FlushBatch();
+
+  // Sets the batch's last datagram's control messages: its launch time, and
+  // a transmit timestamp request when sample is set.
+  void SetControl(bool sample);
+
+  // Reads transmit timestamps and launch time errors off the error queue.
+  void DrainErrorQueue();
+
+  void WriteRtpHeader(uint8_t* header, uint8_t payload_type, uint16_t seq, uint32_t ts);
+
+  // Folds a media payload sent with seq/ts into the FEC accumulators and
+  // queues any FEC packets that completed.
+  void AccumulateFec(const uint8_t* payload, size_t size, uint16_t seq, uint32_t ts);
+  void QueueFecPacket(FecAccumulator& fec, const sockaddr_in* destination, bool row,
+                      uint16_t* seq);
+  static void Fold(FecAccumulator& fec, const uint8_t* payload, size_t size, uint16_t seq,
+                   uint32_t ts);
+
+  UdpOutputConfig config_;
+  std::shared_ptr<retrovue::timing::MasterClock> clock_;
+  int fd_ = -1;
+  bool fec_enabled_ = false;
+
+  sockaddr_in media_addr_{};
+  sockaddr_in column_addr_{};
+  sockaddr_in row_addr_{};
+
+  // Batch of datagrams awaiting sendmmsg()
+  std::vector<uint8_t> slots_;  // kMaxBatch * kSlotSize
+  std::vector<struct iovec> iov_;
+  std::vector<struct mmsghdr> messages_;
+  std::vector<uint8_t> control_;  // kMaxBatch * kControlSize
+  std::vector<bool> sampled_;     // Datagram asks for a transmit timestamp
+  size_t batch_count_ = 0;
+  size_t batch_media_ = 0;      // Media datagrams in the batch
+  size_t batch_media_bytes_ = 0;
+  bool send_failed_ = false;    // A sendmmsg() failed during this Send()
+
+  uint16_t media_seq_ = 0;
+  uint16_t column_seq_ = 0;
+  uint16_t row_seq_ = 0;
+  uint32_t ssrc_ = 0;
+
+  std::vector<FecAccumulator> columns_;  // L accumulators
+  FecAccumulator row_;
+  size_t matrix_index_ = 0;              // Media packets into the current matrix
+
+  // Launch times: MasterClock time -> qdisc clock (txtime_clock_) and
+  // CLOCK_REALTIME (transmit timestamps), sampled per Send()
+  int txtime_clock_ = 0;
+  int64_t txtime_offset_ns_ = 0;
+  int64_t realtime_offset_ns_ = 0;
+  int64_t launch_utc_us_ = 0;  // Of the datagram being queued; 0 = none
+  uint64_t media_datagrams_ = 0;
+  uint32_t samples_requested_ = 0;  // Matches the kernel's timestamp key
+  uint32_t samples_reported_ = 0;
+  uint64_t timed_sends_ = 0;
+  std::vector<int64_t> sample_requested_ns_;  // kSampleRing, by key (CLOCK_REALTIME)
+  int early_samples_ = 0;
+
+  std::atomic<bool> txtime_active_{false};
+  std::atomic<uint64_t> txtime_missed_{0};
+  std::atomic<uint64_t> txtime_samples_{0};
+  std::atomic<int64_t> txtime_last_error_us_{0};
+  std::atomic<int64_t> txtime_max_error_us_{0};
+
+  std::atomic<uint64_t> datagrams_sent_{0};
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> fec_packets_sent_{0};
+  std::atomic<uint64_t> send_syscalls_{0};
+  std::atomic<uint64_t> send_errors_{0};
+};
+
+}  // namespace retrovue::playout_sinks::mpegts
+
+#endif  // RETROVUE_PLAYOUT_SINKS_MPEGTS_TS_UDP_OUTPUT_HPP_
@@ -6,6 +6,8 @@
 #ifndef RETROVUE_PRODUCERS_IPRODUCER_H_
 #define RETROVUE_PRODUCERS_IPRODUCER_H_
 
+#include <cstdint>
+
 namespace retrovue::producers
 {
 
@@ -28,6 +30,34 @@ namespace retrovue::producers
     virtual bool isRunning() const = 0;
   };
 
+  // ISwitchableProducer is implemented by producers that can be loaded into
+  // the preview slot in shadow mode and switched to live with continuous PTS.
+  class ISwitchableProducer : public IProducer
+  {
+  public:
+    // While enabled, the producer prepares its first frames without writing
+    // to the output buffer. Disabling it starts delivery.
+    virtual void SetShadowDecodeMode(bool enabled) = 0;
+
+    // Returns true once the producer can start delivery without a stall.
+    virtual bool IsShadowDecodeReady() const = 0;
+
+    // Returns the PTS the next delivered frame will carry.
+    virtual int64_t GetNextPTS() const = 0;
+
+    // Offsets PTS so the next delivered frame carries target_pts.
+    virtual void AlignPTS(int64_t target_pts) = 0;
+
+    // Holds delivery before the first frame at or past out_pts (0 clears it),
+    // so a scheduled switch takes over on that frame. Returns false if the
+    // producer cannot hold at an out point.
+    virtual bool SetOutPoint(int64_t out_pts)
+    {
+      (void)out_pts;
+      return false;
+    }
+  };
+
 } // namespace retrovue::producers
 
 #endif // RETROVUE_PRODUCERS_IPRODUCER_H_
@@ -0,0 +1,147 @@
+// Repository: Retrovue-playout
+// Component: Playlist Producer
+// Purpose: Plays an ordered list of assets gaplessly, pre-opening the next item.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PRODUCERS_PLAYLIST_PLAYLIST_PRODUCER_H_
+#define RETROVUE_PRODUCERS_PLAYLIST_PLAYLIST_PRODUCER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "retrovue/producers/IProducer.h"
+
+namespace retrovue::producers::playlist
+{
+
+  // Event callback for producer events (same shape as the item producers')
+  using PlaylistEventCallback =
+      std::function<void(const std::string &event_type, const std::string &message)>;
+
+  // Creates the producer for one playlist item. The producer must write to the
+  // playlist's output buffer and report end of asset as an "eof" event through
+  // on_event. Returns nullptr if the asset cannot be played.
+  using PlaylistItemFactory = std::function<std::unique_ptr<ISwitchableProducer>(
+      const std::string &asset_uri, PlaylistEventCallback on_event)>;
+
+  // PlaylistConfig holds configuration for the playlist producer.
+  struct PlaylistConfig
+  {
+    std::vector<std::string> asset_uris;  // Items, in play order
+  };
+
+  // PlaylistProducer plays several assets back to back on one channel without
+  // a cold start at each boundary.
+  //
+  // Design:
+  // - While item N plays, item N+1 is already started in shadow mode: its
+  //   file is open, probed and decoding into its shadow preroll, then it
+  //   holds (see VideoFileProducer::SetShadowDecodeMode)
+  // - When item N reports "eof", it is stopped, item N+1 is aligned to N's
+  //   GetNextPTS() and leaves shadow mode, splicing its preroll into the
+  //   buffer, and item N+2 is opened in the background
+  // - PTS therefore stays continuous across every boundary
+  // - Items that fail to open are skipped ("error" event)
+  // - "item_started" (message = item index) marks each boundary; "eof" is
+  //   emitted after the last item
+  //
+  // The playlist is itself an ISwitchableProducer, so it can sit in the
+  // preview slot and be switched to live like a single asset.
+  //
+  // Thread Model:
+  // - start()/stop() and the switch hooks from the control thread
+  // - One transition thread performs the item handoffs
+  class PlaylistProducer : public retrovue::producers::ISwitchableProducer
+  {
+  public:
+    PlaylistProducer(
+        const PlaylistConfig &config,
+        PlaylistItemFactory item_factory,
+        PlaylistEventCallback event_callback = nullptr);
+
+    ~PlaylistProducer();
+
+    // Disable copy and move
+    PlaylistProducer(const PlaylistProducer &) = delete;
+    PlaylistProducer &operator=(const PlaylistProducer &) = delete;
+
+    // IProducer interface
+    // start() opens the first playable item and pre-opens the one after it.
+    // Returns false if no item can be opened.
+    bool start() override;
+    void stop() override;
+    bool isRunning() const override;
+
+    // ISwitchableProducer interface (applies to the current item)
+    void SetShadowDecodeMode(bool enabled) override;
+    bool IsShadowDecodeReady() const override;
+    int64_t GetNextPTS() const override;
+    void AlignPTS(int64_t target_pts) override;
+
+    // Returns the index of the item currently playing (or staged).
+    size_t GetCurrentIndex() const;
+
+    // Returns the number of item boundaries crossed.
+    uint64_t GetTransitionCount() const;
+
+    // Returns the number of boundaries where the next item was not yet ready
+    // and playback waited for it.
+    uint64_t GetLateTransitionCount() const;
+
+  private:
+    // One opened playlist item.
+    struct Item
+    {
+      std::unique_ptr<ISwitchableProducer> producer;
+      size_t index = 0;
+      uint64_t serial = 0;  // Tags the item's events
+    };
+
+    // Opens the first playable item at or after index, started in shadow
+    // mode. Returns an empty item when none is left.
+    Item OpenItem(size_t index);
+
+    // Transition thread: hands off from the current item at each "eof".
+    void TransitionLoop();
+
+    // Routes an item's events; serial identifies which item sent it.
+    void OnItemEvent(uint64_t serial, const std::string &event_type, const std::string &message);
+
+    void EmitEvent(const std::string &event_type, const std::string &message);
+
+    PlaylistConfig config_;
+    PlaylistItemFactory item_factory_;
+    PlaylistEventCallback event_callback_;
+
+    // Items and shadow state (control thread and transition thread)
+    mutable std::mutex items_mutex_;
+    Item current_;
+    Item next_;
+    bool shadow_mode_ = false;
+    std::atomic<uint64_t> next_serial_;
+
+    // Item events (never held while calling into an item, which may be
+    // blocked emitting an event)
+    std::mutex event_mutex_;
+    std::condition_variable event_cv_;
+    uint64_t eof_serial_ = 0;  // Serial of the last item that reported eof
+    bool stop_requested_ = false;
+
+    std::atomic<bool> running_;
+    std::atomic<size_t> current_index_;
+    std::atomic<uint64_t> transitions_;
+    std::atomic<uint64_t> late_transitions_;
+    std::unique_ptr<std::thread> transition_thread_;
+  };
+
+} // namespace retrovue::producers::playlist
+
+#endif // RETROVUE_PRODUCERS_PLAYLIST_PLAYLIST_PRODUCER_H_
@@ -0,0 +1,208 @@
+// Repository: Retrovue-playout
+// Component: Raw File Producer
+// Purpose: Plays pre-decoded YUV420/PCM clips from a memory-mapped file.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PRODUCERS_RAW_FILE_RAW_FILE_PRODUCER_H_
+#define RETROVUE_PRODUCERS_RAW_FILE_RAW_FILE_PRODUCER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "retrovue/buffer/FramePool.h"
+#include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/producers/IProducer.h"
+
+namespace retrovue::producers::raw_file
+{
+
+  // On-disk header of a raw clip (.rvraw), little-endian.
+  //
+  // Layout:
+  // - RawClipHeader (header_bytes long)
+  // - frame_count tightly packed I420 frames of width x height
+  // - audio_samples interleaved S16 sample frames at audio_offset (optional)
+  struct RawClipHeader
+  {
+    char magic[8];          // kRawClipMagic
+    uint32_t version;       // kRawClipVersion
+    uint32_t header_bytes;  // Offset of the first video frame
+    uint32_t width;
+    uint32_t height;
+    uint32_t fps_num;       // Frame rate as a fraction (e.g. 30000/1001)
+    uint32_t fps_den;
+    uint64_t frame_count;
+    uint32_t sample_rate;   // 0 = no audio
+    uint32_t channels;
+    uint64_t audio_samples; // Samples per channel
+    uint64_t audio_offset;  // Byte offset of the PCM block
+  };
+  static_assert(sizeof(RawClipHeader) == 64, "RawClipHeader is an on-disk format");
+
+  constexpr char kRawClipMagic[8] = {'R', 'V', 'R', 'A', 'W', 'Y', 'U', 'V'};
+  constexpr uint32_t kRawClipVersion = 1;
+
+  // Returns the size of one I420 frame in a clip with this header.
+  size_t RawClipFrameBytes(const RawClipHeader &header);
+
+  // Returns true if the file starts with a raw clip header (used by producer
+  // factories to route station IDs, slates and bumpers to RawFileProducer).
+  bool IsRawClip(const std::string &path);
+
+  // RawClipWriter converts decoded frames into a raw clip. Audio is held in
+  // memory and written after the video on Finish(), so it suits the short
+  // clips this format is meant for.
+  class RawClipWriter
+  {
+  public:
+    RawClipWriter() = default;
+    ~RawClipWriter();
+
+    // Disable copy and move
+    RawClipWriter(const RawClipWriter &) = delete;
+    RawClipWriter &operator=(const RawClipWriter &) = delete;
+
+    // Creates path. sample_rate 0 writes a video-only clip.
+    bool Open(const std::string &path, int width, int height, int fps_num, int fps_den,
+              int sample_rate = 0, int channels = 0);
+
+    // Appends one I420 frame; its size must match the clip geometry.
+    bool AppendFrame(const buffer::Frame &frame);
+
+    // Appends interleaved S16 samples (sample_count per channel).
+    void AppendAudio(const int16_t *samples, size_t sample_count);
+
+    // Writes the audio block and the final header, then closes the file.
+    bool Finish();
+
+  private:
+    std::FILE *file_ = nullptr;
+    RawClipHeader header_{};
+    std::vector<int16_t> audio_;
+  };
+
+  // RawProducerConfig holds configuration for the raw file producer.
+  struct RawProducerConfig
+  {
+    std::string asset_uri;        // Path to a .rvraw clip
+    size_t prefault_frames;       // Frames paged in ahead of playback (madvise WILLNEED)
+
+    RawProducerConfig()
+        : prefault_frames(30) {}
+  };
+
+  // Event callback for producer events (for test harness)
+  using RawProducerEventCallback =
+      std::function<void(const std::string &event_type, const std::string &message)>;
+
+  // RawFileProducer plays short, frequently repeated clips (station IDs,
+  // slates, bumpers) that were decoded once into a raw clip.
+  //
+  // Design:
+  // - The clip is mmapped read-only; frames are copied straight from the page
+  //   cache into pooled frames, so there is no decode or scale cost
+  // - Output geometry and frame rate come from the clip header, which must
+  //   match the channel (clips are rendered per channel format)
+  // - Delivery is paced by output buffer backpressure, like VideoFileProducer
+  // - Audio is sliced per frame from the PCM block and pushed alongside; it is
+  //   dropped (and counted) if the audio ring is full
+  // - Shadow mode only pages in the first frames, so the producer is ready as
+  //   soon as start() has mapped and validated the file
+  //
+  // Thread Model:
+  // - start()/stop() and the switch hooks from the control thread
+  // - One producer thread delivers frames
+  class RawFileProducer : public retrovue::producers::ISwitchableProducer
+  {
+  public:
+    RawFileProducer(
+        const RawProducerConfig &config,
+        buffer::FrameRingBuffer &output_buffer,
+        RawProducerEventCallback event_callback = nullptr);
+
+    ~RawFileProducer();
+
+    // Disable copy and move
+    RawFileProducer(const RawFileProducer &) = delete;
+    RawFileProducer &operator=(const RawFileProducer &) = delete;
+
+    // IProducer interface
+    // start() maps and validates the clip; returns false if it is unreadable.
+    bool start() override;
+    void stop() override;
+    bool isRunning() const override;
+
+    // ISwitchableProducer interface
+    void SetShadowDecodeMode(bool enabled) override;
+    bool IsShadowDecodeReady() const override;
+    int64_t GetNextPTS() const override;
+    void AlignPTS(int64_t target_pts) override;
+
+    // Returns the header of the mapped clip (zeroed before start()).
+    RawClipHeader GetClipHeader() const;
+
+    // Returns the number of video frames delivered to the output buffer.
+    uint64_t GetFramesProduced() const;
+
+    // Returns the number of audio chunks dropped because the audio ring was full.
+    uint64_t GetAudioDropped() const;
+
+  private:
+    void ProduceLoop();
+
+    // Copies frame index into a pooled frame and pushes it with its audio.
+    bool DeliverFrame(uint64_t index);
+
+    // Maps the clip and validates its header against the file size.
+    bool MapClip();
+    void UnmapClip();
+
+    // Asks the kernel to page in frames [first, first + count) ahead of use.
+    void PrefaultFrames(uint64_t first, uint64_t count) const;
+
+    // Media time of frame index, in microseconds.
+    int64_t FramePtsUs(uint64_t index) const;
+
+    // Sample offset (per channel) where frame index's audio starts.
+    uint64_t FrameAudioStart(uint64_t index) const;
+
+    void EmitEvent(const std::string &event_type, const std::string &message);
+
+    RawProducerConfig config_;
+    buffer::AssetId asset_id_;  // config_.asset_uri, interned
+    buffer::FrameRingBuffer &output_buffer_;
+    RawProducerEventCallback event_callback_;
+
+    // Mapping (set by start(), released by stop())
+    const uint8_t *map_base_ = nullptr;
+    size_t map_bytes_ = 0;
+    RawClipHeader header_{};
+    std::shared_ptr<buffer::FramePool> frame_pool_;
+    size_t pool_frame_bytes_ = 0;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<uint64_t> frames_produced_;
+    std::atomic<uint64_t> audio_dropped_;
+    std::unique_ptr<std::thread> producer_thread_;
+
+    // Shadow mode and PTS alignment
+    mutable std::mutex shadow_mutex_;
+    std::condition_variable shadow_cv_;
+    bool shadow_mode_ = false;
+    uint64_t next_frame_ = 0;     // Next frame index to deliver (guarded by shadow_mutex_)
+    int64_t pts_offset_us_ = 0;   // Added to media time (guarded by shadow_mutex_)
+  };
+
+} // namespace retrovue::producers::raw_file
+
+#endif // RETROVUE_PRODUCERS_RAW_FILE_RAW_FILE_PRODUCER_H_
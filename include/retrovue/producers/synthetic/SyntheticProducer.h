@@ -0,0 +1,162 @@
+// Repository: Retrovue-playout
+// Component: Synthetic Producer
+// Purpose: Load generator that plays a moving test pattern from precomputed frame templates.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PRODUCERS_SYNTHETIC_SYNTHETIC_PRODUCER_H_
+#define RETROVUE_PRODUCERS_SYNTHETIC_SYNTHETIC_PRODUCER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "retrovue/buffer/FramePool.h"
+#include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/producers/IProducer.h"
+
+namespace retrovue::producers::synthetic
+{
+
+  // How hard the pattern is to encode, from cheapest to most expensive.
+  enum class SyntheticComplexity
+  {
+    kStatic,  // Colour bars with a small moving box: mostly skip blocks
+    kMotion,  // Whole frame scrolls diagonally: every block changes, predictably
+    kNoise,   // Fresh noise over the bars in every frame: worst-case bitrate
+  };
+
+  // SyntheticProducerConfig holds configuration for the synthetic producer.
+  struct SyntheticProducerConfig
+  {
+    int width;                        // Output width (even)
+    int height;                       // Output height (even)
+    double target_fps;                // Delivery rate and PTS spacing
+    SyntheticComplexity complexity;
+    size_t template_count;            // Distinct frames before the pattern repeats
+    uint64_t frame_limit;             // Frames to deliver before "eof" (0 = endless)
+    bool realtime;                    // Pace at target_fps; false = as fast as the buffer drains
+    std::string asset_uri;            // Reported in frame metadata
+
+    SyntheticProducerConfig()
+        : width(1920),
+          height(1080),
+          target_fps(30.0),
+          complexity(SyntheticComplexity::kMotion),
+          template_count(30),
+          frame_limit(0),
+          realtime(true),
+          asset_uri("synthetic://pattern") {}
+  };
+
+  // Event callback for producer events (for test harness)
+  using SyntheticProducerEventCallback =
+      std::function<void(const std::string &event_type, const std::string &message)>;
+
+  // Precomputed I420 frames of one pattern, shared read-only by every
+  // producer with the same geometry, complexity and template count.
+  struct SyntheticTemplates
+  {
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<uint8_t>> frames;
+  };
+
+  // Returns the templates for config, rendering them on first use. Producers
+  // hold a reference, so 100 channels on one profile share one set.
+  std::shared_ptr<const SyntheticTemplates> GetSyntheticTemplates(
+      const SyntheticProducerConfig &config);
+
+  // SyntheticProducer stands in for a real asset when capacity-testing the
+  // sink, encoder and telemetry paths with many channels and no media.
+  //
+  // Design:
+  // - The pattern is rendered once into template_count templates at start();
+  //   each frame is a single copy from a template into a pooled frame, so the
+  //   steady state does no rendering and no allocation
+  // - The complexity profile sets how much of each frame changes, and so the
+  //   bitrate the encoder has to produce
+  // - Realtime mode paces delivery on a steady clock at target_fps; otherwise
+  //   delivery is paced by output buffer backpressure, like RawFileProducer
+  // - Shadow mode holds delivery until the switch; the producer is ready as
+  //   soon as start() has rendered the templates
+  //
+  // Thread Model:
+  // - start()/stop() and the switch hooks from the control thread
+  // - One producer thread delivers frames
+  class SyntheticProducer : public retrovue::producers::ISwitchableProducer
+  {
+  public:
+    SyntheticProducer(
+        const SyntheticProducerConfig &config,
+        buffer::FrameRingBuffer &output_buffer,
+        SyntheticProducerEventCallback event_callback = nullptr);
+
+    ~SyntheticProducer();
+
+    // Disable copy and move
+    SyntheticProducer(const SyntheticProducer &) = delete;
+    SyntheticProducer &operator=(const SyntheticProducer &) = delete;
+
+    // IProducer interface
+    // start() renders (or reuses) the templates; returns false if the
+    // configuration is invalid.
+    bool start() override;
+    void stop() override;
+    bool isRunning() const override;
+
+    // ISwitchableProducer interface
+    void SetShadowDecodeMode(bool enabled) override;
+    bool IsShadowDecodeReady() const override;
+    int64_t GetNextPTS() const override;
+    void AlignPTS(int64_t target_pts) override;
+
+    // Returns the number of video frames delivered to the output buffer.
+    uint64_t GetFramesProduced() const;
+
+    // Returns the number of realtime frames delivered after their deadline
+    // because the output buffer was full.
+    uint64_t GetLateFrames() const;
+
+  private:
+    void ProduceLoop();
+
+    // Copies the template for frame index into a pooled frame and pushes it.
+    bool DeliverFrame(uint64_t index);
+
+    // Media time of frame index, in microseconds.
+    int64_t FramePtsUs(uint64_t index) const;
+
+    void EmitEvent(const std::string &event_type, const std::string &message);
+
+    SyntheticProducerConfig config_;
+    buffer::AssetId asset_id_;  // config_.asset_uri, interned
+    buffer::FrameRingBuffer &output_buffer_;
+    SyntheticProducerEventCallback event_callback_;
+
+    std::shared_ptr<const SyntheticTemplates> templates_;
+    std::shared_ptr<buffer::FramePool> frame_pool_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<uint64_t> frames_produced_;
+    std::atomic<uint64_t> late_frames_;
+    std::unique_ptr<std::thread> producer_thread_;
+
+    // Shadow mode and PTS alignment
+    mutable std::mutex shadow_mutex_;
+    std::condition_variable shadow_cv_;
+    bool shadow_mode_ = false;
+    uint64_t next_frame_ = 0;     // Next frame index to deliver (guarded by shadow_mutex_)
+    int64_t pts_offset_us_ = 0;   // Added to media time (guarded by shadow_mutex_)
+  };
+
+} // namespace retrovue::producers::synthetic
+
+#endif // RETROVUE_PRODUCERS_SYNTHETIC_SYNTHETIC_PRODUCER_H_
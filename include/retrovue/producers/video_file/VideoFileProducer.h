@@ -6,16 +6,26 @@
 #ifndef RETROVUE_PRODUCERS_VIDEO_FILE_VIDEO_FILE_PRODUCER_H_
 #define RETROVUE_PRODUCERS_VIDEO_FILE_VIDEO_FILE_PRODUCER_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/decode/DecodeThreading.h"
+#include "retrovue/decode/DecoderContextPool.h"
+#include "retrovue/decode/KeyframeIndex.h"
+#include "retrovue/decode/PassthroughEligibility.h"
+#include "retrovue/decode/ReadAheadFile.h"
 #include "retrovue/producers/IProducer.h"
+#include "retrovue/telemetry/ChannelCpu.h"
 
 namespace retrovue::timing
 {
@@ -24,14 +34,28 @@ namespace retrovue::timing
 
 // Forward declarations for FFmpeg types (opaque pointers)
 struct AVFormatContext;
+struct AVCodec;
 struct AVCodecContext;
+struct AVCodecParameters;
 struct AVFrame;
 struct AVPacket;
+struct AVBufferRef;
+struct AVBSFContext;
+struct AVIOContext;
 struct SwsContext;
+struct SwrContext;
 
 namespace retrovue::producers::video_file
 {
 
+  // Decoded audio leaves the producer as 48 kHz stereo S16 in blocks of one
+  // AAC frame, so the encoder consumes whole ring entries. 5.1 sources stay
+  // 5.1 (kAudioSurroundChannels), for the sink's downmix.
+  constexpr int kAudioOutputSampleRate = 48000;
+  constexpr int kAudioOutputChannels = 2;
+  constexpr int kAudioSurroundChannels = 6;
+  constexpr int kAudioBlockSamples = 1024;
+
   // Producer state machine
   enum class ProducerState
   {
@@ -50,13 +74,54 @@ namespace retrovue::producers::video_file
     double target_fps;           // Target frames per second (e.g., 30.0)
     bool stub_mode;              // If true, generate fake frames instead of decoding
     int tcp_port;                // TCP port for FFmpeg streaming (stub mode)
+    bool hw_accel_enabled;       // Try hardware decode first, falling back to software
+    std::string hw_device_type;  // "vaapi", "cuda" (NVDEC), "qsv"; empty = try each in turn
+    std::string hw_device;       // Device node/index (e.g. "/dev/dri/renderD128"); empty = default
+    int decode_threads;          // Decoder thread budget for this channel (0 = one per core)
+    decode::DecodeThreadType decode_thread_type;  // Frame vs slice threading
+    bool pipelined_decode;       // Run demux and decode on their own threads (staged mode)
+    size_t packet_queue_depth;   // Compressed packets buffered ahead of decode (staged mode)
+    size_t frame_queue_depth;    // Decoded frames buffered ahead of scaling (staged mode)
+    int64_t start_offset_us;     // Join-in-progress: first frame emitted at this media offset
+    bool keyframe_index_enabled; // Load/build the keyframe index sidecar on open
+    std::string keyframe_index_dir;  // Sidecar directory; empty = next to the asset
+    size_t read_ahead_bytes;     // Prefetch window for local files (0 = read directly)
+    size_t shadow_preroll_frames;  // Frames staged in shadow mode for the switch (min 1)
+    bool reuse_decoder_contexts;   // Check software decoders/scalers out of DecoderContextPool
+    bool audio_enabled;            // Decode the first audio stream into the audio lane
+    bool high_bit_depth;           // Keep 10-bit sources at 10 bits (P010) instead of narrowing to I420
+    bool device_frames;            // Hardware frames at target size stay on the GPU
+    size_t device_frame_surfaces;  // kDevice frames out at once; more are downloaded
+    bool passthrough;              // Send sources matching passthrough_profile as compressed frames
+    decode::PassthroughProfile passthrough_profile;  // Channel encoder profile (size and rate from the targets)
+    uint32_t trace_sample_interval;  // Trace every Nth video packet's frame through the pipeline (0 = off)
+    int32_t channel_id;              // Names the producer's threads (-1 = untagged)
+    std::shared_ptr<telemetry::ChannelCpuAccount> cpu_account;  // Charged decode/scale CPU time (optional)
 
     ProducerConfig()
         : target_width(1920),
           target_height(1080),
           target_fps(30.0),
           stub_mode(false),
-          tcp_port(12345) {}
+          tcp_port(12345),
+          hw_accel_enabled(false),
+          decode_threads(0),
+          decode_thread_type(decode::DecodeThreadType::kAuto),
+          pipelined_decode(false),
+          packet_queue_depth(256),
+          frame_queue_depth(8),
+          start_offset_us(0),
+          keyframe_index_enabled(true),
+          read_ahead_bytes(0),
+          shadow_preroll_frames(15),
+          reuse_decoder_contexts(true),
+          audio_enabled(true),
+          high_bit_depth(false),
+          device_frames(false),
+          device_frame_surfaces(16),
+          passthrough(false),
+          trace_sample_interval(30),
+          channel_id(-1) {}
   };
 
   // Event callback for producer events (for test harness)
@@ -69,15 +134,34 @@ namespace retrovue::producers::video_file
   // - Read video files (MP4, MKV, MOV, etc.)
   // - Decode frames internally using libavformat/libavcodec
   // - Scale frames to target resolution
-  // - Convert to YUV420 planar format
+  // - Pass I420/NV12 (and with high_bit_depth, P010) pictures at the target
+  //   size through in their own layout; convert the rest to I420
   // - Push decoded frames to FrameRingBuffer
+  // - Decode and resample the first audio stream into the buffer's audio lane
+  //   in fixed kAudioBlockSamples blocks (dropped and counted when it is full)
   // - Handle backpressure and errors gracefully
   //
+  // With config.passthrough, an H.264 source that already matches the
+  // channel's encoder profile (decode::PassthroughMismatch()) is not decoded:
+  // its packets leave as compressed frames (PixelFormat::kH264, Annex B),
+  // paced, staged and spliced like decoded ones, and the sink muxes them
+  // as they are. Playback starts on a keyframe (joins and wakes on the first
+  // one at or after the target), audio is still decoded, and packets that
+  // turn out to need reordering fall back to decoding from there.
+  //
+  // With config.device_frames and hardware decode, pictures already at the
+  // target size are not downloaded: each frame holds its GPU surface
+  // (PixelFormat::kDevice) on the process's shared device, so an encoder
+  // on that device codes it where it is. The decoder gets
+  // device_frame_surfaces extra surfaces for the frames in the ring; while
+  // that many are out, and for pictures that need scaling, frames are
+  // downloaded as without it (GetDeviceFrameDownloads()).
+  //
   // Architecture:
   // - Self-contained: performs both reading and decoding internally
-  // - Outputs only decoded frames (never encoded packets)
+  // - Outputs decoded frames, or compressed ones in passthrough
   // - Internal decoder subsystem: demuxer, decoder, scaler, frame assembly
-  class VideoFileProducer : public retrovue::producers::IProducer
+  class VideoFileProducer : public retrovue::producers::ISwitchableProducer
   {
   public:
     // Constructs a producer with the given configuration and output buffer.
@@ -116,23 +200,72 @@ namespace retrovue::producers::video_file
     // Returns current producer state.
     ProducerState GetState() const;
 
+    // Returns storage read-ahead statistics (all zero when read-ahead is off).
+    decode::ReadAheadStats GetReadAheadStats() const;
+
+    // Returns true if the open decoder is using a hardware device.
+    bool IsHardwareDecodeActive() const;
+
+    // Returns true while video packets are passed through undecoded.
+    bool IsPassthroughActive() const;
+
+    // Returns the number of audio blocks pushed to the audio lane.
+    uint64_t GetAudioBlocksProduced() const;
+
+    // Returns the number of audio blocks dropped because the audio lane was full.
+    uint64_t GetAudioBlocksDropped() const;
+
+    // Returns the number of frames pushed as GPU surfaces (device_frames).
+    uint64_t GetDeviceFramesProduced() const;
+
+    // Returns the number of device_frames pictures downloaded instead
+    // (scaled, or no surface to spare).
+    uint64_t GetDeviceFrameDownloads() const;
+
     // Shadow decode mode support (for seamless switching)
-    // Sets shadow decode mode (decodes frames but does not write to buffer).
-    void SetShadowDecodeMode(bool enabled);
+    // Sets shadow decode mode. While enabled, decoded frames are staged in a
+    // private preroll ring (up to config.shadow_preroll_frames) instead of the
+    // output buffer, and decoding pauses once the ring is full. Disabling it
+    // splices the staged frames into the output buffer ahead of anything
+    // decoded afterwards, so the buffer starts the switch pre-filled.
+    void SetShadowDecodeMode(bool enabled) override;
 
     // Returns true if shadow decode mode is enabled.
     bool IsShadowDecodeMode() const;
 
     // Returns true if shadow decode is ready (first frame decoded and cached).
-    bool IsShadowDecodeReady() const;
+    bool IsShadowDecodeReady() const override;
+
+    // Returns the number of frames currently staged in the preroll ring.
+    size_t GetShadowPrerollDepth() const;
 
     // Gets the next PTS that will be used for the next frame (for PTS alignment).
-    // Returns the PTS that the next decoded frame will have.
-    int64_t GetNextPTS() const;
+    // Returns the PTS that the next decoded frame will have (the oldest staged
+    // frame while preroll frames are pending).
+    int64_t GetNextPTS() const override;
 
     // Aligns PTS to continue from a target PTS (for seamless switching).
-    // Sets the PTS offset so that the next frame will have target_pts.
-    void AlignPTS(int64_t target_pts);
+    // Sets the PTS offset so that the next frame will have target_pts. Staged
+    // preroll frames are re-stamped to continue from target_pts.
+    void AlignPTS(int64_t target_pts) override;
+
+    // Scheduled switches: the producer holds (decoder open) once its next
+    // frame would carry out_pts or later; GetNextPTS() then reports the out
+    // point reached. 0 clears the out point and resumes delivery.
+    bool SetOutPoint(int64_t out_pts) override;
+
+    // Hibernation (idle channels): Hibernate() pauses decoding after the
+    // current frame, with the decoder left open (staged decode threads are
+    // stopped), and uses the pause to build a missing keyframe index. Wake()
+    // resumes at the schedule-correct position: the media time the producer
+    // had reached plus the time spent hibernating, decoded forward from the
+    // keyframe at or before it. Stub mode skips the same number of frames.
+    // Ignored in shadow decode mode. Callable from any thread.
+    void Hibernate();
+    void Wake();
+
+    // Returns true while the producer is held in hibernation.
+    bool IsHibernating() const;
 
   private:
     // Main production loop (runs in producer thread).
@@ -144,16 +277,121 @@ namespace retrovue::producers::video_file
     // Real decode implementation: reads, decodes, scales, and assembles frames.
     bool ProduceRealFrame();
 
+    // Passthrough: reads the next packet and emits a video packet as a
+    // compressed frame. InitializePassthrough() checks the source against
+    // the channel profile and opens the Annex B filter; FallBackToDecode()
+    // decodes from the current position on.
+    bool ProducePassthroughFrame();
+    bool InitializePassthrough();
+    void FallBackToDecode(const char* reason);
+    void ClosePassthrough();
+
+    // Stamps, paces and pushes (or stages, in shadow mode) an assembled
+    // frame whose metadata.pts is media time.
+    bool PushFrame(buffer::FrameHandle handle);
+
     // Internal decoder subsystem initialization.
     bool InitializeDecoder();
     void CloseDecoder();
 
+    // Attaches a hardware device context to codec_ctx_ when the codec supports
+    // one of the requested device types. Returns false to decode in software.
+    bool InitializeHardwareDecoder();
+
+    // Allocates and opens codec_ctx_ for codecpar (hardware first when
+    // enabled). Used when the decoder pool has no warm context.
+    bool OpenCodec(const AVCodec* codec, const AVCodecParameters* codecpar);
+
+    // Applies the configured thread budget and threading model to codec_ctx_.
+    void ConfigureDecoderThreads();
+
+    // Points sws_ctx_ at a scaler for key, returning the previous one to the
+    // pool if it differs. ReleaseScaler() returns (or frees) sws_ctx_.
+    bool UseScaler(const decode::ScalerKey& key);
+    void ReleaseScaler();
+
+    // Opens the first audio stream and a resampler to the output format.
+    // Returns false (video-only playout) if there is none or it cannot open.
+    bool InitializeAudioDecoder();
+    void CloseAudioDecoder();
+
+    // Audio path (producer thread): decodes a packet (nullptr drains the
+    // decoder), resamples into audio_block_ and emits every full block.
+    // FlushAudio() drains decoder and resampler at end of stream and emits
+    // the last block padded with silence.
+    void DecodeAudioPacket(const AVPacket* packet);
+    void ResampleAudio(const AVFrame* frame);
+    void EmitAudioBlock();
+    void DrainAudioPackets();
+    void FlushAudio();
+
+    // Loads the asset's keyframe index sidecar, or builds it from the
+    // container index (or, with scan_packets, a packet scan) and saves it
+    // for the next open.
+    void LoadOrBuildKeyframeIndex(bool scan_packets);
+
+    // Seeks to the keyframe at or before config_.start_offset_us and arms
+    // frame skipping up to the offset.
+    void SeekToStartOffset();
+
+    // Seeks to the keyframe at or before target_pts_us (stream time) and
+    // arms frame and audio skipping up to it. Returns the keyframe's PTS.
+    int64_t SeekToMediaTime(int64_t target_pts_us);
+
+    // Holds the producer thread from Hibernate() until Wake() or stop, then
+    // repositions decoding (see Wake()).
+    void HoldWhileHibernating();
+
+    // Media clock for hibernation: MasterClock time, or steady time without one.
+    int64_t HibernationNowUs() const;
+
+    // Staged decode (pipelined_decode): a demux thread feeds a bounded packet
+    // queue, a decode thread feeds a bounded frame queue, and the producer
+    // thread scales, assembles and pushes. The queues absorb storage stalls
+    // and bursts of expensive frames.
+    struct DecodePipeline;
+    void StartPipeline();
+    void StopPipeline();
+    void DemuxLoop();
+    void DecodeLoop();
+
+    // Outcome of fetching the next decoded picture into frame_.
+    enum class FetchResult
+    {
+      kFrame,        // frame_ holds a new picture
+      kRetry,        // Nothing yet (packet skipped, decoder wants input, stage queue empty)
+      kEndOfStream,  // No more pictures
+      kError         // Read or decode error
+    };
+
     // Internal decoder operations.
-    bool ReadPacket();
-    bool DecodePacket();
+    FetchResult FetchSerialFrame();     // Demux + decode inline on the producer thread
+    FetchResult FetchPipelinedFrame();  // Take the next frame from the decode stage
     bool ScaleFrame();
+    bool AllocateScaledFrame(int pix_fmt);  // (Re)allocates scaled_frame_ at the target size
     bool AssembleFrame(buffer::Frame& frame);
 
+    // Frame tracing: packets sampled at demux keep their demux and decode
+    // times here, keyed by stream PTS, until their frame is assembled.
+    // StampDemuxed() runs where packets are read, StampDecoded() where frames
+    // are decoded, TakeTrace() on the producer thread. Frames of unsampled
+    // packets skip the lock.
+    void StampDemuxed(const AVPacket* packet);
+    void StampDecoded(const AVFrame* frame);
+    void TakeTrace(const AVFrame* frame, buffer::FrameTrace& trace);
+
+    // Shadow preroll: stages a decoded frame (stamping its PTS with the current
+    // offset), and splices staged frames (then staged audio) into the output
+    // buffer after the switch. SpliceShadowPreroll() returns false while frames remain staged
+    // because the output buffer is full. ShadowStaging() is true in shadow mode
+    // and while a preroll waits to be spliced: frames decoded across the
+    // switch are staged behind it, so they cannot overtake it.
+    void StageShadowFrame(buffer::FrameHandle handle, int64_t base_pts_us);
+    bool ShadowStaging() const;
+    bool SpliceShadowPreroll();
+    void SpliceShadowAudio();  // Caller holds shadow_decode_mutex_
+    size_t ShadowPrerollTarget() const;
+
     // Emits producer event through callback.
     void EmitEvent(const std::string &event_type, const std::string &message = "");
 
@@ -161,7 +399,10 @@ namespace retrovue::producers::video_file
     void SetState(ProducerState new_state);
 
     ProducerConfig config_;
+    buffer::AssetId asset_id_;  // config_.asset_uri, interned
+    bool asset_start_pending_ = false;  // The next frame assembled is the asset's first (decode thread)
     buffer::FrameRingBuffer &output_buffer_;
+    std::shared_ptr<buffer::FramePool> frame_pool_;  // Decoded frames are assembled in place
     std::shared_ptr<timing::MasterClock> master_clock_;
     ProducerEventCallback event_callback_;
 
@@ -175,6 +416,7 @@ namespace retrovue::producers::video_file
     std::chrono::milliseconds drain_timeout_;
 
     std::unique_ptr<std::thread> producer_thread_;
+    telemetry::StageCpuMeter cpu_meter_;  // Producer thread only
 
     // Internal decoder subsystem (FFmpeg)
     AVFormatContext* format_ctx_;
@@ -183,15 +425,67 @@ namespace retrovue::producers::video_file
     AVFrame* scaled_frame_;
     AVPacket* packet_;
     SwsContext* sws_ctx_;
+    decode::ScalerKey scaler_key_;    // What sws_ctx_ was created for
+    decode::DecoderKey decoder_key_;  // Pool key of codec_ctx_
+    bool decoder_pooled_;             // codec_ctx_ goes back to the pool on close
+    const AVFrame* assemble_source_;  // Planes AssembleFrame() copies or packs (scaled_frame_,
+                                      // or the decoded frame when no scaling is needed)
+    AVBufferRef* hw_device_ctx_;  // Hardware device (null when decoding in software)
+    AVBSFContext* passthrough_bsf_;  // To Annex B (null unless passing through)
+    std::atomic<bool> passthrough_active_;
+    bool passthrough_wait_keyframe_;  // Packets are dropped up to a keyframe at or after seek_target_pts_us_
+    int64_t passthrough_last_pts_us_;  // Media PTS of the last packet sent (-1 = none since the seek)
+    AVFrame* hw_transfer_frame_;  // System-memory copy of a GPU frame for the scaler
+    int hw_pix_fmt_;              // AVPixelFormat the hardware decoder outputs
+    std::atomic<bool> hw_decode_active_;
+    bool device_source_;  // AssembleFrame() wraps frame_'s surface (decode thread)
+    std::shared_ptr<std::atomic<int>> device_frames_in_flight_;  // Surfaces held by frames
+    std::atomic<uint64_t> device_frames_produced_;
+    std::atomic<uint64_t> device_frame_downloads_;
+
+    // Audio decode (producer thread only)
+    AVCodecContext* audio_codec_ctx_;
+    AVFrame* audio_frame_;
+    SwrContext* swr_ctx_;
+    int audio_stream_index_;      // -1 = no audio
+    double audio_time_base_;
+    std::vector<uint8_t> audio_scratch_;  // Resampler output, grown once to the largest packet
+    buffer::AudioFrame audio_block_;      // Block being filled (preallocated)
+    int audio_block_fill_;                // Samples in audio_block_
+    int64_t audio_base_pts_us_;           // Media PTS of the first emitted sample (-1 = unset)
+    int64_t audio_samples_emitted_;       // Samples in emitted blocks since audio_base_pts_us_
+    int64_t audio_skip_until_us_;         // Join-in-progress: audio before this is dropped (-1 = none)
+    std::atomic<uint64_t> audio_blocks_produced_;
+    std::atomic<uint64_t> audio_blocks_dropped_;
+    std::unique_ptr<DecodePipeline> pipeline_;  // Non-null while staged decode runs
+    std::unique_ptr<decode::ReadAheadFile> read_ahead_;  // Null unless read_ahead_bytes > 0
+    AVIOContext* io_ctx_;  // Custom I/O over read_ahead_
+    mutable std::mutex read_ahead_mutex_;  // Guards read_ahead_ for GetReadAheadStats()
+    decode::KeyframeIndex keyframe_index_;
+    int64_t seek_target_pts_us_;  // Decoded frames before this are dropped (-1 = none)
     int video_stream_index_;
     bool decoder_initialized_;
     bool eof_reached_;
     double time_base_;  // Stream time base for PTS/DTS conversion
-    int64_t last_pts_us_;  // For PTS monotonicity enforcement
+    int64_t last_pts_us_;  // Last emitted PTS, offset applied (monotonicity, GetNextPTS)
     int64_t last_decoded_frame_pts_us_;  // PTS of last decoded frame (for EOF pacing)
     int64_t first_frame_pts_us_;  // PTS of first frame (for establishing time mapping)
     int64_t playback_start_utc_us_;  // UTC time when first frame was decoded (for pacing)
 
+    // Frame tracing (see StampDemuxed())
+    struct PacketTrace
+    {
+      int64_t pts;         // Stream time base
+      int64_t demuxed_us;  // 0 = free
+      int64_t decoded_us;
+    };
+    static constexpr size_t kPendingTraces = 8;
+    std::mutex trace_mutex_;
+    std::array<PacketTrace, kPendingTraces> pending_traces_;
+    size_t next_pending_trace_;                 // Oldest entry, replaced next
+    std::atomic<size_t> pending_trace_count_;   // Entries in use
+    uint64_t video_packets_;                    // Read so far (demux side)
+
     // State for stub frame generation
     std::atomic<int64_t> stub_pts_counter_;
     int64_t frame_interval_us_;
@@ -200,9 +494,19 @@ namespace retrovue::producers::video_file
     // Shadow decode mode support
     std::atomic<bool> shadow_decode_mode_;
     std::atomic<bool> shadow_decode_ready_;
-    std::mutex shadow_decode_mutex_;
-    std::unique_ptr<buffer::Frame> cached_first_frame_;  // First decoded frame (cached in shadow mode)
+    mutable std::mutex shadow_decode_mutex_;  // Guards the preroll ring and PTS offset
+    std::condition_variable shadow_decode_cv_;  // Wakes a held producer at the switch
+    std::vector<buffer::FrameHandle> shadow_preroll_;  // Staged frames, oldest first
+    std::vector<buffer::AudioFrame> shadow_audio_;     // Audio decoded with the preroll
+    bool shadow_splice_started_;  // Time map already rebased for the current splice
+    std::atomic<int64_t> out_point_pts_us_;  // Hold before this PTS (0 = none)
     int64_t pts_offset_us_;  // PTS offset for alignment (added to frame PTS)
+
+    // Hibernation
+    std::atomic<bool> hibernate_requested_;
+    std::atomic<bool> hibernating_;  // Producer thread held in HoldWhileHibernating()
+    std::mutex hibernate_mutex_;
+    std::condition_variable hibernate_cv_;  // Wakes the held producer (Wake(), stop)
   };
 
 } // namespace retrovue::producers::video_file
@@ -9,13 +9,20 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
 
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/renderer/FrameSink.h"
+#include "retrovue/runtime/ChannelPlacement.h"
+#include "retrovue/telemetry/ChannelCpu.h"
+#include "retrovue/telemetry/HdrHistogram.h"
+
 namespace retrovue::telemetry {
 struct ChannelMetrics;
+class ChannelSlot;
 class MetricsExporter;
 }  // namespace retrovue::telemetry
 
@@ -27,12 +34,26 @@ namespace retrovue::producers {
 class IProducer;
 }  // namespace retrovue::producers
 
+namespace retrovue::runtime {
+class TaskExecutor;
+class TaskLoop;
+}  // namespace retrovue::runtime
+
 namespace retrovue::renderer {
 
 // RenderMode specifies the rendering output type.
 enum class RenderMode {
   HEADLESS = 0,  // No display output (production mode)
   PREVIEW = 1,   // Preview window (debug/development mode)
+  SINK = 2,      // Frames go straight to RenderConfig::sink (no separate consumer)
+};
+
+// CatchUpPolicy says how a clocked renderer recovers when it falls behind
+// the MasterClock (a frame popped more than 8 ms past its deadline).
+enum class CatchUpPolicy {
+  kDropEach = 0,   // Drop late frames one per pop while the buffer holds a backlog
+  kSkipToNow = 1,  // Drop every frame already due in one batch, resuming at the newest
+  kSpeedUp = 2,    // Drop nothing; present ahead of schedule until the lag is earned back
 };
 
 // RenderConfig holds configuration for the renderer.
@@ -42,13 +63,27 @@ struct RenderConfig {
   int window_height;
   std::string window_title;
   bool vsync_enabled;
+  int preview_width;      // Preview texture size (0 = window size); see PreviewRenderer
+  int preview_height;
+  double preview_max_fps;  // Preview presentation cap (0 = every frame)
+  runtime::ChannelPlacement placement;  // Render thread CPUs and pacing priority
+  std::shared_ptr<FrameSink> sink;      // Output written by the render loop (SINK mode)
+  CatchUpPolicy catch_up;       // Recovery from falling behind the clock
+  double catch_up_ppm;          // kSpeedUp: lag earned back per frame, in ppm of its duration
+  int64_t catch_up_max_lag_us;  // kSpeedUp: larger lags are skipped as kSkipToNow
   
   RenderConfig()
       : mode(RenderMode::HEADLESS),
         window_width(1920),
         window_height(1080),
         window_title("RetroVue Playout Preview"),
-        vsync_enabled(true) {}
+        vsync_enabled(true),
+        preview_width(0),
+        preview_height(0),
+        preview_max_fps(0.0),
+        catch_up(CatchUpPolicy::kDropEach),
+        catch_up_ppm(50'000.0),
+        catch_up_max_lag_us(250'000) {}
 };
 
 // RenderStats tracks rendering performance and frame timing.
@@ -57,6 +92,9 @@ struct RenderStats {
   uint64_t frames_skipped;
   uint64_t frames_dropped;
   uint64_t corrections_total;
+  uint64_t underruns;  // Times the buffer ran empty after a frame (skips count each poll)
+  uint64_t catch_up_skips;  // Batched drops (kSkipToNow, and kSpeedUp past its lag limit)
+  int64_t catch_up_lag_us;  // kSpeedUp: lag behind the deadlines still to earn back
   double average_render_time_ms;
   double current_render_fps;
   double frame_gap_ms;  // Time since last frame
@@ -66,23 +104,39 @@ struct RenderStats {
         frames_skipped(0),
         frames_dropped(0),
         corrections_total(0),
+        underruns(0),
+        catch_up_skips(0),
+        catch_up_lag_us(0),
         average_render_time_ms(0.0),
         current_render_fps(0.0),
         frame_gap_ms(0.0) {}
 };
 
+// FrameTimingStats are the per-frame timing distributions of a renderer,
+// in microseconds (see telemetry::HdrHistogram).
+struct FrameTimingStats {
+  telemetry::HdrHistogram pacing_error_us;  // |render start - frame deadline| (clocked renderers)
+  telemetry::HdrHistogram latency_us;       // Ring push to render done
+  telemetry::HdrHistogram slack_us;         // Frame deadline - pop time (0 if late; clocked)
+  uint64_t render_cpu_ns = 0;               // CPU time of the render thread
+};
+
 // FrameRenderer consumes frames from the ring buffer and renders them.
 //
 // Design:
-// - Abstract base class with two concrete implementations:
+// - Abstract base class with three concrete implementations:
 //   - HeadlessRenderer: Consumes frames without display (production)
 //   - PreviewRenderer: Opens SDL2/OpenGL window (debug/development)
+//   - SinkRenderer: Writes frames to a FrameSink (production output)
 // - Runs in dedicated render thread
 // - Frame timing driven by metadata.pts
 // - Back-pressure handling when buffer empty
 //
 // Thread Model:
-// - Renderer runs in its own thread
+// - Renderer runs in its own thread, or (headless, real clock) as a chain of
+//   pacing-lane tasks on a shared runtime::TaskExecutor when one is set
+// - config.placement pins the render thread and may raise it to SCHED_FIFO
+//   (own thread only; pacing tasks run at the scheduler's priority)
 // - Pops frames from FrameRingBuffer (thread-safe)
 // - Independent from decode thread
 //
@@ -95,7 +149,17 @@ class FrameRenderer {
  public:
   virtual ~FrameRenderer();
 
-  // Starts the render thread.
+  // Renders on executor's pacing lane instead of a thread of its own (from
+  // the next Start()). Preview windows and fake clocks keep the thread.
+  void SetExecutor(std::shared_ptr<runtime::TaskExecutor> executor);
+
+  // Called on the render thread with each frame about to be rendered, as
+  // the pooled handle (taps keep a reference rather than copy). Must be
+  // cheap; set before Start().
+  using FrameTap = std::function<void(const buffer::FrameHandle& frame)>;
+  void SetFrameTap(FrameTap tap);
+
+  // Starts the render thread (or task chain).
   // Returns true if started successfully.
   bool Start();
 
@@ -108,6 +172,9 @@ class FrameRenderer {
   // Gets current render statistics.
   const RenderStats& GetStats() const { return stats_; }
 
+  // Snapshot of the per-frame timing distributions. Safe from any thread.
+  FrameTimingStats GetTimingStats() const;
+
   // Sets the producer (for switching between preview and live).
   // This is called when switching producers to update the renderer's reference.
   void setProducer(producers::IProducer* producer);
@@ -135,6 +202,34 @@ class FrameRenderer {
   // Main render loop (runs in render thread).
   void RenderLoop();
 
+  // Initializes the subclass and the frame clock; false if Initialize() failed.
+  bool BeginRender();
+
+  // Cleans up the subclass and marks the renderer stopped.
+  void EndRender();
+
+  // Renders a popped frame and updates stats and metrics.
+  void PresentFrame(const buffer::Frame& frame, uint64_t residency_us,
+                    std::chrono::steady_clock::time_point popped_at, int64_t frame_start_utc,
+                    std::chrono::steady_clock::time_point frame_start_fallback,
+                    double frame_gap_ms);
+
+  // Applies config_.catch_up to a frame popped gap_us before its deadline
+  // (negative if late) and records its slack. Returns true if the frame is
+  // dropped; otherwise the frame is due at its deadline + catch_up_lag_us.
+  bool CatchUp(const buffer::Frame& frame, int64_t gap_us);
+
+  // Drops the popped frame and all queued frames already due but the
+  // newest, in one discard. Returns false (dropping nothing) if no queued
+  // frame is due, as the popped frame is then the one nearest now.
+  bool SkipToNow();
+
+  // One render-loop pass as a TaskLoop step: pops a frame and comes back at
+  // its deadline, or presents the frame it holds. Returns the system time
+  // of the next step.
+  int64_t RunTaskStep();
+  int64_t RenderTaskStep();
+
   // Subclass-specific initialization.
   // Called once before render loop starts.
   virtual bool Initialize() = 0;
@@ -151,18 +246,42 @@ class FrameRenderer {
   void UpdateStats(double render_time_ms, double frame_gap_ms);
   void PublishMetrics(double frame_gap_ms);
 
+  // Counts an empty pop; the first after a frame starts an underrun, which
+  // is published at once.
+  void NoteBufferEmpty();
+
   RenderConfig config_;
   buffer::FrameRingBuffer& input_buffer_;
   RenderStats stats_;
 
   std::shared_ptr<timing::MasterClock> clock_;
   std::shared_ptr<telemetry::MetricsExporter> metrics_;
+  std::shared_ptr<telemetry::ChannelSlot> metrics_slot_;  // Per-frame metrics (lock-free)
   int32_t channel_id_;
 
   std::atomic<bool> running_;
   std::atomic<bool> stop_requested_;
   std::unique_ptr<std::thread> render_thread_;
-  
+  std::shared_ptr<runtime::TaskExecutor> executor_;
+  std::unique_ptr<runtime::TaskLoop> task_loop_;
+  FrameTap frame_tap_;
+  bool task_begun_ = false;  // BeginRender() succeeded for the current task chain
+  bool starved_ = true;      // No frame since the buffer was last empty (or yet)
+
+  // Frame a task step popped and holds until its deadline
+  buffer::FrameHandle pending_;
+  uint64_t pending_residency_us_ = 0;
+  std::chrono::steady_clock::time_point pending_popped_at_;
+  int64_t pending_start_utc_ = 0;
+  double pending_gap_ms_ = 0.0;
+
+  // Per-frame timing (recorded on the render thread)
+  telemetry::HdrHistogram pacing_error_us_;
+  telemetry::HdrHistogram latency_us_;
+  telemetry::HdrHistogram slack_us_;
+  std::atomic<uint64_t> render_cpu_ns_{0};
+  telemetry::StageCpuMeter cpu_meter_;  // Render thread (or task step) only
+
   int64_t last_pts_;
   int64_t last_frame_time_utc_;
   std::chrono::steady_clock::time_point fallback_last_frame_time_;
@@ -185,8 +304,38 @@ class HeadlessRenderer : public FrameRenderer {
   void Cleanup() override;
 };
 
+// SinkRenderer makes the render loop the output's only consumer: it pops
+// and paces frames as any renderer does and writes each to the FrameSink of
+// RenderConfig::sink, so the sink needs no thread, pacing loop or pop of its
+// own, and RenderStats time the sink writes. Sink writes may block, so it
+// always renders on its own thread.
+class SinkRenderer : public FrameRenderer {
+ public:
+  SinkRenderer(const RenderConfig& config,
+               buffer::FrameRingBuffer& input_buffer,
+               const std::shared_ptr<timing::MasterClock>& clock,
+               const std::shared_ptr<telemetry::MetricsExporter>& metrics,
+               int32_t channel_id);
+  ~SinkRenderer() override;
+
+ protected:
+  bool Initialize() override;
+  void RenderFrame(const buffer::Frame& frame) override;
+  void Cleanup() override;
+
+ private:
+  std::shared_ptr<FrameSink> sink_;
+};
+
 // PreviewRenderer displays frames in an SDL2 window.
-// Used for development and debugging.
+// Used for development and operator monitoring.
+//
+// Frames are uploaded to a streaming IYUV texture at the preview size
+// (RenderConfig::preview_width/height), downscaled on the way in by the
+// SIMD plane kernels, at most 2:1 so the two-tap filter stays clean; the
+// GPU scales the rest to the window and converts YUV to RGB, so the CPU
+// does no colorspace conversion. preview_max_fps caps how often a frame is
+// uploaded and presented; every frame is still consumed at the channel rate.
 class PreviewRenderer : public FrameRenderer {
  public:
   PreviewRenderer(const RenderConfig& config,
@@ -206,6 +355,15 @@ class PreviewRenderer : public FrameRenderer {
   void* window_;      // SDL_Window*
   void* renderer_;    // SDL_Renderer*
   void* texture_;     // SDL_Texture*
+  int texture_width_ = 0;
+  int texture_height_ = 0;
+  std::chrono::steady_clock::time_point last_present_;
+  uint64_t frames_presented_ = 0;
+  uint64_t frames_not_presented_ = 0;  // Skipped by preview_max_fps
+  buffer::Frame downloaded_;           // kDevice frames, read back
+
+  // (Re)creates texture_ for frame_width x frame_height frames.
+  bool EnsureTexture(int frame_width, int frame_height);
 };
 
 }  // namespace retrovue::renderer
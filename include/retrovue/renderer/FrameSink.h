@@ -0,0 +1,39 @@
+// Repository: Retrovue-playout
+// Component: Frame Sink
+// Purpose: Output stage driven directly by the render loop.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RENDERER_FRAME_SINK_H_
+#define RETROVUE_RENDERER_FRAME_SINK_H_
+
+#include <cstdint>
+
+#include "retrovue/buffer/FrameRingBuffer.h"
+
+namespace retrovue::renderer {
+
+// FrameSink is an output (encoder, network stream, SDI card) that takes its
+// frames from a renderer in RenderMode::SINK instead of consuming the ring
+// buffer on a thread of its own. The render loop pops each frame, paces it
+// to its deadline and hands it to WriteFrame(), so the sink needs no timing
+// loop and the render stats, latency and late drops measure the sink writes.
+//
+// Thread Model: every call comes from the channel's render thread.
+class FrameSink {
+ public:
+  virtual ~FrameSink() = default;
+
+  // Called once before the first frame; false aborts the render loop.
+  virtual bool Open() { return true; }
+
+  // Writes a frame that is due now. deadline_utc_us is its MasterClock
+  // deadline (0 without a clock). The frame is valid only for the call.
+  virtual void WriteFrame(const buffer::Frame& frame, int64_t deadline_utc_us) = 0;
+
+  // Called once after the last frame.
+  virtual void Close() {}
+};
+
+}  // namespace retrovue::renderer
+
+#endif  // RETROVUE_RENDERER_FRAME_SINK_H_
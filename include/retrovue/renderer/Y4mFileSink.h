@@ -0,0 +1,67 @@
+// Repository: Retrovue-playout
+// Component: Y4M File Sink
+// Purpose: Writes rendered frames to a YUV4MPEG2 file (offline renders).
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RENDERER_Y4M_FILE_SINK_H_
+#define RETROVUE_RENDERER_Y4M_FILE_SINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "retrovue/renderer/FrameSink.h"
+
+namespace retrovue::renderer {
+
+// Y4mFileSinkStats counts what a Y4mFileSink wrote.
+struct Y4mFileSinkStats {
+  uint64_t frames_written = 0;
+  uint64_t bytes_written = 0;   // Header and frame markers included
+  uint64_t frames_rejected = 0; // Not packed YUV420 of the stream's size
+  bool write_failed = false;    // The file refused a write (disk full, closed pipe)
+};
+
+// Y4mFileSink writes every frame the render loop hands it, in order and
+// unchanged, to a YUV4MPEG2 (.y4m) stream: a header carrying the first
+// frame's size and rate, then "FRAME" and the packed YUV420 planes per
+// frame. Two renders of the same input produce identical files, so
+// outputs can be compared bit for bit, and the stream can be piped into
+// an encoder (path "-" writes to stdout), e.g. ffmpeg -i - -f mpegts.
+//
+// Thread Model: Open(), WriteFrame() and Close() from the render thread;
+// GetStats() from any thread.
+class Y4mFileSink : public FrameSink {
+ public:
+  explicit Y4mFileSink(std::string path);
+  ~Y4mFileSink() override;
+
+  Y4mFileSink(const Y4mFileSink&) = delete;
+  Y4mFileSink& operator=(const Y4mFileSink&) = delete;
+
+  bool Open() override;
+  void WriteFrame(const buffer::Frame& frame, int64_t deadline_utc_us) override;
+  void Close() override;
+
+  Y4mFileSinkStats GetStats() const;
+
+ private:
+  bool Write(const void* data, size_t size);
+
+  const std::string path_;
+  std::FILE* file_ = nullptr;
+  int width_ = 0;   // Stream size, from the first frame (0 = header not written)
+  int height_ = 0;
+  std::vector<uint8_t> packed_;  // Frames not already packed I420, converted
+  buffer::Frame downloaded_;     // kDevice frames, read back
+  std::atomic<uint64_t> frames_written_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::atomic<uint64_t> frames_rejected_{0};
+  std::atomic<bool> write_failed_{false};
+};
+
+}  // namespace retrovue::renderer
+
+#endif  // RETROVUE_RENDERER_Y4M_FILE_SINK_H_
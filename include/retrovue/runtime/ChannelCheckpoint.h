@@ -0,0 +1,96 @@
+// Repository: Retrovue-playout
+// Component: Channel Checkpoint
+// Purpose: Memory-mapped record of where each channel is, for resuming after a crash.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_CHANNEL_CHECKPOINT_H_
+#define RETROVUE_RUNTIME_CHANNEL_CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "retrovue/runtime/PlayoutEngine.h"
+
+namespace retrovue::runtime {
+
+// ChannelCheckpoint is where a running channel was at its last checkpoint.
+struct ChannelCheckpoint {
+  int32_t channel_id = 0;
+  std::string plan_handle;
+  int64_t timeline_origin_utc_us = 0;  // UTC its PTS 0 is due
+  int64_t start_offset_us = 0;         // Media offset its producer started from
+  int64_t pts_us = 0;                  // Timeline position (PTS due) when written
+  int64_t written_utc_us = 0;
+  uint64_t frames_produced = 0;
+};
+
+// ChannelCheckpointFile keeps a fixed-size slot per channel in a shared
+// memory mapping of a file, so a checkpoint is a few stores into the page
+// cache with no system call, and what was written survives the process
+// dying at any point (not the host: nothing is synced to disk).
+//
+// Each slot is guarded by a sequence count, odd while it is written; a slot
+// torn by a crash mid-write reads as absent rather than as a mix of two
+// checkpoints.
+//
+// Format: a 64-byte header ("RVCHKPT1", slot count and size), then the
+// slots, in host byte order. A file with another header is replaced.
+//
+// Thread Model: all methods are thread-safe.
+class ChannelCheckpointFile {
+ public:
+  static constexpr size_t kDefaultSlots = 256;
+  static constexpr size_t kMaxPlanBytes = 448;  // Longer plan handles are not checkpointed
+
+  explicit ChannelCheckpointFile(std::string path, size_t slots = kDefaultSlots);
+  ~ChannelCheckpointFile();
+
+  ChannelCheckpointFile(const ChannelCheckpointFile&) = delete;
+  ChannelCheckpointFile& operator=(const ChannelCheckpointFile&) = delete;
+
+  // Maps the file, creating it if needed, and keeps the checkpoints in it.
+  // False (every call below then fails) if it cannot be opened or mapped.
+  bool Open();
+
+  // Records (or replaces) the channel's checkpoint; false if the file is not
+  // open, every slot is taken or the plan handle is too long.
+  bool Write(const ChannelCheckpoint& checkpoint);
+
+  // The channel's last checkpoint; false if there is none (or it is torn).
+  bool Read(int32_t channel_id, ChannelCheckpoint& checkpoint) const;
+
+  // Every channel's checkpoint, in channel id order.
+  std::vector<ChannelCheckpoint> ReadAll() const;
+
+  // Frees the channel's slot.
+  void Clear(int32_t channel_id);
+
+  const std::string& path() const { return path_; }
+
+ private:
+  struct Slot;
+
+  Slot* SlotAt(size_t index) const;
+
+  const std::string path_;
+  const size_t slot_count_;
+  mutable std::mutex mutex_;
+  uint8_t* mapping_ = nullptr;
+  size_t mapping_bytes_ = 0;
+  std::unordered_map<int32_t, size_t> slots_;  // Slot of each recorded channel
+  std::vector<size_t> free_slots_;
+};
+
+// Resumes request from checkpoint: a channel started on its host's own
+// timeline takes the checkpoint's origin, so it starts at the point of the
+// plan due now instead of at the beginning. Returns false, leaving request
+// as it is, for another channel or plan, or a request that names an origin.
+bool ResumeFromCheckpoint(const ChannelCheckpoint& checkpoint, ChannelStartRequest& request);
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_CHANNEL_CHECKPOINT_H_
@@ -0,0 +1,69 @@
+// Repository: Retrovue-playout
+// Component: Channel Manifest
+// Purpose: On-disk record of running channels, restored after a restart.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_CHANNEL_MANIFEST_H_
+#define RETROVUE_RUNTIME_CHANNEL_MANIFEST_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "retrovue/runtime/PlayoutEngine.h"
+
+namespace retrovue::runtime {
+
+// ChannelManifest keeps the start request of every running channel in a
+// file, so a restarted process can bring the same channels back (see
+// PlayoutEngine::RestoreChannels). Each change rewrites the file through a
+// temporary and a rename, so a crash leaves either the old or the new
+// manifest, never a torn one.
+//
+// Format: a "retrovue-channel-manifest 1" line, then a line per channel of
+// space-separated key=value fields (channel, plan, port, uds, cpus, numa,
+// pacing_priority, priority, latency_ms, width, height) with values
+// percent-encoded.
+// Unknown keys are ignored.
+//
+// Thread Model: all methods are thread-safe.
+class ChannelManifest {
+ public:
+  explicit ChannelManifest(std::string path);
+
+  ChannelManifest(const ChannelManifest&) = delete;
+  ChannelManifest& operator=(const ChannelManifest&) = delete;
+
+  // Reads the file into the manifest and returns its channels in id order.
+  // A missing file is an empty manifest; false if the file cannot be read or
+  // parsed (the manifest is then left empty).
+  bool Load(std::vector<ChannelStartRequest>& channels);
+
+  // Records (or replaces) a channel, removes one, or edits one in place
+  // (no-op for a channel not recorded). Each returns false if the file
+  // could not be written; the in-memory manifest is changed regardless.
+  bool Put(const ChannelStartRequest& channel);
+  bool Remove(int32_t channel_id);
+  bool Update(int32_t channel_id, const std::function<void(ChannelStartRequest&)>& edit);
+
+  const std::string& path() const { return path_; }
+
+ private:
+  bool WriteLocked() const;
+
+  const std::string path_;
+  mutable std::mutex mutex_;
+  std::map<int32_t, ChannelStartRequest> channels_;
+};
+
+// Manifest line for channel (without the newline), and back. Parse returns
+// false for a line without a valid channel id.
+std::string FormatManifestEntry(const ChannelStartRequest& channel);
+bool ParseManifestEntry(const std::string& line, ChannelStartRequest& channel);
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_CHANNEL_MANIFEST_H_
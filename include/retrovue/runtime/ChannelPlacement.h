@@ -0,0 +1,78 @@
+// Repository: Retrovue-playout
+// Component: Channel Placement
+// Purpose: CPU affinity, NUMA node and real-time priority of a channel's threads.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_CHANNEL_PLACEMENT_H_
+#define RETROVUE_RUNTIME_CHANNEL_PLACEMENT_H_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace retrovue::runtime {
+
+// ChannelPlacement says where a channel's threads run and its frames live.
+struct ChannelPlacement {
+  std::vector<int> cpus;    // CPUs the threads may run on (empty = the node's, or any)
+  int numa_node = -1;       // Node for threads and frame memory (-1 = none)
+  int pacing_priority = 0;  // SCHED_FIFO priority of the pacing (render) thread (0 = normal)
+
+  bool IsDefault() const { return cpus.empty() && numa_node < 0 && pacing_priority <= 0; }
+};
+
+// PlacementPolicy places channels that ask for no placement of their own.
+struct PlacementPolicy {
+  bool pack_numa_nodes = false;  // Spread channels over NUMA nodes, pinned to their node's CPUs
+  int pacing_priority = 0;       // SCHED_FIFO priority of render threads (0 = normal)
+};
+
+// ChannelPlacer completes channel placements from a policy and counts the
+// channels on each NUMA node, so packing puts each new channel on the node
+// with the fewest (the lowest-numbered on a tie). Thread-safe.
+class ChannelPlacer {
+ public:
+  ChannelPlacer(const PlacementPolicy& policy, std::vector<std::vector<int>> node_cpus);
+
+  // Fills resolved from requested: the policy's pacing priority if none is
+  // given, a packed node if neither CPUs nor node are given, and the node's
+  // CPUs if only a node is given. Counts the channel against its node.
+  // Returns false (counting nothing) if requested names an unknown node.
+  bool Acquire(const ChannelPlacement& requested, ChannelPlacement& resolved);
+
+  // Uncounts a placement returned by Acquire().
+  void Release(const ChannelPlacement& resolved);
+
+  size_t node_count() const { return node_cpus_.size(); }
+  int ChannelsOnNode(int node) const;
+
+ private:
+  const PlacementPolicy policy_;
+  const std::vector<std::vector<int>> node_cpus_;
+  mutable std::mutex mutex_;
+  std::vector<int> channels_per_node_;
+};
+
+// CPUs of each NUMA node, from /sys/devices/system/node. Hosts without NUMA
+// information report one node holding every CPU.
+std::vector<std::vector<int>> NumaNodeCpus();
+
+// Parses a Linux CPU list ("0-3,8,10-11").
+std::vector<int> ParseCpuList(const char* list);
+
+// Applies placement to the calling thread: pins it to placement.cpus,
+// prefers placement.numa_node for its new allocations, and raises pacing
+// threads to SCHED_FIFO at placement.pacing_priority. Threads it starts
+// afterwards (decoder workers) inherit the affinity and memory policy.
+// Each failing step is logged under `who` and skipped; returns false if any
+// failed. Not supported off Linux (returns false unless placement is default).
+bool ApplyChannelPlacement(const ChannelPlacement& placement, bool pacing_thread,
+                           const char* who);
+
+// Binds [data, data + bytes) to numa_node, moving pages already touched.
+// Returns false if the kernel refused (or off Linux).
+bool BindMemoryToNode(void* data, std::size_t bytes, int numa_node);
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_CHANNEL_PLACEMENT_H_
@@ -0,0 +1,146 @@
+// Repository: Retrovue-playout
+// Component: IO Ring
+// Purpose: Process-wide io_uring instance for completion-driven socket sends and file reads.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_IO_RING_H_
+#define RETROVUE_RUNTIME_IO_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+struct msghdr;
+
+namespace retrovue::runtime {
+
+// IoRingStats is a point-in-time view of an IoRing.
+struct IoRingStats {
+  uint64_t submitted = 0;    // Operations queued
+  uint64_t completed = 0;
+  uint64_t enter_calls = 0;  // io_uring_enter() calls that submitted (submitted / enter_calls
+                             // = operations per call)
+  size_t in_flight = 0;
+  size_t registered_buffers = 0;
+};
+
+// IoRing is one io_uring shared by every channel: the TS fanouts queue
+// their subscribers' gathered sends on it and the read-ahead windows their
+// file reads, instead of each blocking a thread of its own in a system call.
+//
+// Design:
+// - Queue*() only fills in a submission entry; Submit() hands everything
+//   queued since to the kernel with a single io_uring_enter(), so a caller
+//   with several operations to start (a fanout with several subscribers)
+//   pays for one system call
+// - One completion thread waits for completions and runs each operation's
+//   callback, then submits whatever those callbacks queued; callbacks must
+//   not block
+// - Buffers registered with RegisterBuffer() are pinned once, and reads into
+//   them (READ_FIXED) skip the per-operation page lookup
+// - Raw system calls against <linux/io_uring.h>, so there is no liburing
+//   dependency. Open() fails where io_uring is unavailable (older kernels,
+//   seccomp profiles that block it); callers then fall back to their
+//   blocking paths
+//
+// Everything that queued an operation must wait for its callback before it
+// frees the memory or file the operation uses.
+//
+// Thread Model: all methods are thread-safe.
+class IoRing {
+ public:
+  static constexpr unsigned kDefaultEntries = 256;
+  static constexpr unsigned kMaxRegisteredBuffers = 64;
+
+  // Runs on the completion thread with the operation's result: bytes
+  // transferred, or -errno.
+  using Completion = std::function<void(int32_t result)>;
+
+  explicit IoRing(unsigned entries = kDefaultEntries);
+  ~IoRing();
+
+  IoRing(const IoRing&) = delete;
+  IoRing& operator=(const IoRing&) = delete;
+
+  // Sets up the ring and starts the completion thread. False (every Queue*()
+  // then fails) if io_uring is unavailable.
+  bool Open();
+
+  bool IsOpen() const { return ring_fd_ >= 0; }
+
+  // Queues sendmsg(fd, message, flags); message and what it points at must
+  // stay valid until done runs. False if the ring is not open.
+  bool QueueSendmsg(int fd, const struct msghdr* message, int flags, Completion done);
+
+  // Queues pread(fd, buffer, length, offset), from a registered buffer when
+  // buffer_index is one (and buffer lies within it). False if the ring is
+  // not open.
+  bool QueueRead(int fd, void* buffer, size_t length, int64_t offset, Completion done,
+                 int buffer_index = -1);
+
+  // Submits everything queued.
+  void Submit();
+
+  // Registers [base, base + length) for fixed reads. Returns its index, or
+  // -1 if it cannot be registered (no slot free, pinned memory limit).
+  int RegisterBuffer(void* base, size_t length);
+  void UnregisterBuffer(int index);
+
+  IoRingStats GetStats() const;
+
+ private:
+  // Next free submission entry, flushing the queue when it is full (mutex_
+  // held); null if the ring is closed.
+  struct io_uring_sqe* NextSqeLocked();
+  void SubmitLocked();
+  void CompletionLoop();
+
+  const unsigned requested_entries_;
+  int ring_fd_ = -1;
+
+  // Mappings of the kernel's rings
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_bytes_ = 0;
+  void* cq_ring_ = nullptr;  // sq_ring_ with a single mapping
+  size_t cq_ring_bytes_ = 0;
+  struct io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_bytes_ = 0;
+
+  // Submission queue (guarded by mutex_)
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned pending_ = 0;      // Queued, not yet published to the kernel
+  unsigned unsubmitted_ = 0;  // Published, not yet consumed by io_uring_enter()
+  bool closing_ = false;
+
+  // Completion queue (completion thread only)
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  mutable std::mutex mutex_;
+  std::thread completion_thread_;
+
+  std::mutex buffers_mutex_;
+  bool buffers_supported_ = false;
+  std::vector<bool> buffer_used_;  // Guarded by buffers_mutex_
+
+  std::atomic<uint64_t> submitted_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<uint64_t> enter_calls_{0};
+  std::atomic<size_t> registered_buffers_{0};
+};
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_IO_RING_H_
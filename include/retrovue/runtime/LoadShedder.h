@@ -0,0 +1,94 @@
+// Repository: Retrovue-playout
+// Component: Load Shedder
+// Purpose: Degrades low-priority channels first when the host falls behind.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_LOAD_SHEDDER_H_
+#define RETROVUE_RUNTIME_LOAD_SHEDDER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "retrovue/decode/DecodeDegradation.h"
+
+namespace retrovue::runtime {
+
+// LoadShedPolicy says when the engine sheds decode load and from whom.
+struct LoadShedPolicy {
+  bool enabled = false;
+  int32_t protected_priority = 1;  // Channels at or above this priority never degrade
+  int64_t min_slack_ms = 100;     // Full-quality channels with frames this close to
+                                  // their render time count as falling behind (0 = off)
+  int recovery_samples = 10;      // Clean samples in a row before a level is given back
+  std::chrono::milliseconds interval{500};  // Time between samples
+};
+
+// ChannelLoadSample is one channel's pacing at a sample. The totals are
+// lifetime counters (see telemetry::ChannelMetrics); the shedder looks at
+// how they moved since the channel's previous sample.
+struct ChannelLoadSample {
+  int32_t channel_id = 0;
+  int32_t priority = 0;                   // Higher keeps quality longer
+  uint64_t late_frames_total = 0;         // Frames the renderer dropped as late
+  uint64_t underruns_total = 0;           // Times the renderer found the buffer empty
+  double buffer_residency_seconds_sum = 0.0;  // Time frames waited to be rendered
+  uint64_t buffer_residency_count = 0;
+};
+
+// LoadShedDecision moves a channel to a new degradation level.
+struct LoadShedDecision {
+  int32_t channel_id = 0;
+  decode::DecodeDegradation level = decode::DecodeDegradation::kNone;
+};
+
+// LoadShedder turns periodic pacing samples of every running channel into
+// graded degradation. A sample is overloaded when any channel, whatever its
+// priority, dropped late frames or underran since its last sample, or a
+// full-quality channel's frames reached the renderer with less than
+// min_slack_ms to spare. On an overloaded sample the lowest-priority tier
+// that can still degrade (below protected_priority) steps one level deeper
+// (see decode::DecodeDegradation), so a tier reaches keyframes-only before
+// the next tier up is touched. After recovery_samples clean samples in a
+// row the highest degraded tier steps one level back.
+//
+// Thread Model: not thread-safe; the engine samples from one thread.
+class LoadShedder {
+ public:
+  explicit LoadShedder(const LoadShedPolicy& policy);
+
+  // Takes one sample of every running channel (channels missing from it are
+  // forgotten) and returns the channels whose level changes.
+  std::vector<LoadShedDecision> Evaluate(const std::vector<ChannelLoadSample>& samples);
+
+  // Current level of a channel (kNone if unknown).
+  decode::DecodeDegradation LevelOf(int32_t channel_id) const;
+
+  // Whether the last sample was overloaded.
+  bool overloaded() const { return overloaded_; }
+
+ private:
+  struct Channel {
+    int32_t priority = 0;
+    ChannelLoadSample last;
+    decode::DecodeDegradation level = decode::DecodeDegradation::kNone;
+  };
+
+  // Whether the channel fell behind between last and sample.
+  bool FellBehind(const Channel& channel, const ChannelLoadSample& sample) const;
+
+  // Steps every channel of the chosen tier one level; returns the changes.
+  std::vector<LoadShedDecision> Escalate();
+  std::vector<LoadShedDecision> Relax();
+
+  const LoadShedPolicy policy_;
+  std::unordered_map<int32_t, Channel> channels_;
+  int clean_samples_ = 0;
+  bool overloaded_ = false;
+};
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_LOAD_SHEDDER_H_
@@ -12,6 +12,7 @@
 #include <thread>
 #include <vector>
 
+#include "retrovue/telemetry/WindowedHistogram.h"
 #include "retrovue/timing/MasterClock.h"
 
 namespace retrovue::runtime {
@@ -45,8 +46,9 @@ class OrchestrationLoop {
   };
 
   struct Stats {
-    std::vector<double> tick_skew_ms;
-    std::vector<double> latency_ms;
+    // |tick start - deadline| and producer->renderer latency, in microseconds
+    telemetry::HistogramViews tick_skew_us;
+    telemetry::HistogramViews latency_us;
     std::map<BackPressureEvent, std::size_t> backpressure_events;
     std::map<BackPressureEvent, std::vector<double>> backpressure_recovery_ms;
     bool starvation_detected = false;
@@ -85,7 +87,6 @@ class OrchestrationLoop {
   void RecordTickSkew(double skew_ms);
   void RecordLatency(double latency_ms);
   void HandleBackPressure(const TickResult& result);
-  static double ComputePercentile(const std::vector<double>& values, double percentile);
 
   Config config_;
   std::shared_ptr<timing::MasterClock> clock_;
@@ -95,6 +96,11 @@ class OrchestrationLoop {
   std::atomic<std::uint64_t> tick_index_;
   std::unique_ptr<std::thread> thread_;
 
+  // Recorded lock-free by the loop thread; everything else in stats_ is
+  // guarded by metrics_mutex_
+  telemetry::WindowedHistogram tick_skew_us_;
+  telemetry::WindowedHistogram latency_us_;
+
   mutable std::mutex metrics_mutex_;
   Stats stats_;
   std::optional<PendingBackPressure> pending_backpressure_;
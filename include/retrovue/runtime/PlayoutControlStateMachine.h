@@ -1,6 +1,9 @@
 #ifndef RETROVUE_RUNTIME_PLAYOUT_CONTROL_STATE_MACHINE_H_
 #define RETROVUE_RUNTIME_PLAYOUT_CONTROL_STATE_MACHINE_H_
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <optional>
@@ -44,6 +47,7 @@ class PlayoutControlStateMachine {
     kStopping = 5,
     kError = 6,
   };
+  static constexpr std::size_t kStateCount = 7;
 
   struct MetricsSnapshot {
     std::map<std::pair<State, State>, uint64_t> transitions;
@@ -58,12 +62,16 @@ class PlayoutControlStateMachine {
     double resume_latency_p95_ms = 0.0;
     double seek_latency_p95_ms = 0.0;
     double stop_latency_p95_ms = 0.0;
+    double switch_latency_p95_ms = 0.0;
     double pause_deviation_p95_ms = 0.0;
     double last_pause_latency_ms = 0.0;
     double last_resume_latency_ms = 0.0;
     double last_seek_latency_ms = 0.0;
     double last_stop_latency_ms = 0.0;
+    double last_switch_latency_ms = 0.0;
     double last_pause_deviation_ms = 0.0;
+    uint64_t switch_total = 0;
+    int64_t last_switch_pts_us = 0;  // PTS of the first frame of the last switch
     State state = State::kIdle;
   };
 
@@ -99,9 +107,21 @@ class PlayoutControlStateMachine {
   void OnExternalTimeout(int64_t event_utc_us);
   void OnQueueOverflow();
 
-  [[nodiscard]] State state() const;
+  // Lock-free: the state, transition counts and counters are atomics, so
+  // the orchestration tick and readers never wait on a command in progress.
+  [[nodiscard]] State state() const { return state_.load(std::memory_order_acquire); }
+  [[nodiscard]] uint64_t TransitionCount(State from, State to) const;
+  [[nodiscard]] uint64_t IllegalTransitionCount(State from, State attempted_to) const;
   [[nodiscard]] MetricsSnapshot Snapshot() const;
 
+  // Lower-case name of a state ("playing", ...).
+  static const char* StateName(State state);
+
+  // Called on every state change, under the state machine's lock: it must
+  // not block or call back into the state machine.
+  using TransitionListener = std::function<void(State from, State to, int64_t event_utc_us)>;
+  void setTransitionListener(TransitionListener listener);
+
   // Dual-producer slot management
   // Sets a factory function for creating producers (must be called before loadPreviewAsset).
   // The factory receives (path, assetId, ringBuffer, clock) and returns a producer.
@@ -124,8 +144,15 @@ class PlayoutControlStateMachine {
   // Switches preview slot to live slot.
   // Stops live producer, flushes renderer, resets timestamps, and swaps producers.
   // Requires: renderer pointer for flushing (can be nullptr if not available).
+  // target_pts_us schedules the switch (0 = at the live producer's next frame):
+  // the live producer holds at that out point, blocking this call until it
+  // gets there, and the preview's first frame carries target_pts_us. Either
+  // way the first preview frame is marked as a splice point (an IDR at the
+  // sink). Switch latency runs from the switch being due to the preview
+  // taking over.
   // Returns true on success, false on failure.
-  bool activatePreviewAsLive(renderer::FrameRenderer* renderer = nullptr);
+  bool activatePreviewAsLive(renderer::FrameRenderer* renderer = nullptr,
+                             int64_t target_pts_us = 0);
 
   // Gets the preview slot (const access).
   const ProducerSlot& getPreviewSlot() const;
@@ -146,24 +173,39 @@ class PlayoutControlStateMachine {
   constexpr static double kSeekLatencyThresholdMs = 250.0;
   constexpr static double kStopLatencyThresholdMs = 500.0;
   constexpr static std::size_t kReadinessThresholdFrames = 3;
+  // A scheduled switch fails if the live producer has not reached its out
+  // point this long after the media time to it has passed
+  constexpr static int64_t kOutPointSlackUs = 1'000'000;
+
+  // Counts per (from, to); illegal attempts count in both matrices
+  using TransitionMatrix = std::array<std::array<std::atomic<uint64_t>, kStateCount>, kStateCount>;
 
+  static uint64_t Count(const TransitionMatrix& matrix, State from, State to) {
+    return matrix[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)].load(
+        std::memory_order_relaxed);
+  }
+
+  // Guards commands, slots and latency samples. State changes happen under
+  // it; reads of the atomics below do not take it.
   mutable std::mutex mutex_;
 
-  State state_;
+  std::atomic<State> state_;
   std::unordered_map<std::string, int64_t> processed_commands_;
   int64_t current_pts_us_;
-  std::map<std::pair<State, State>, uint64_t> transitions_;
-  uint64_t illegal_transition_total_;
-  uint64_t latency_violation_total_;
-  uint64_t timeout_total_;
-  uint64_t queue_overflow_total_;
-  uint64_t recover_total_;
-  uint64_t consistency_failure_total_;
-  uint64_t late_seek_total_;
+  TransitionMatrix transitions_{};
+  TransitionMatrix illegal_transitions_{};
+  std::atomic<uint64_t> latency_violation_total_{0};
+  std::atomic<uint64_t> timeout_total_{0};
+  std::atomic<uint64_t> queue_overflow_total_{0};
+  std::atomic<uint64_t> recover_total_{0};
+  std::atomic<uint64_t> consistency_failure_total_{0};
+  std::atomic<uint64_t> late_seek_total_{0};
   std::vector<double> pause_latencies_ms_;
   std::vector<double> resume_latencies_ms_;
   std::vector<double> seek_latencies_ms_;
   std::vector<double> stop_latencies_ms_;
+  std::vector<double> switch_latencies_ms_;
+  int64_t last_switch_pts_us_;
   std::vector<double> pause_deviation_ms_;
 
   // Dual-producer slots
@@ -172,6 +214,8 @@ class PlayoutControlStateMachine {
 
   // Producer factory (set by playout_service)
   ProducerFactory producer_factory_;
+
+  TransitionListener transition_listener_;
 };
 
 }  // namespace retrovue::runtime
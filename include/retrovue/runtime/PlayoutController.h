@@ -6,15 +6,16 @@
 #ifndef RETROVUE_RUNTIME_PLAYOUT_CONTROLLER_H_
 #define RETROVUE_RUNTIME_PLAYOUT_CONTROLLER_H_
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <optional>
+#include <vector>
 
-namespace retrovue::runtime {
+#include "retrovue/runtime/PlayoutEngine.h"
 
-// Forward declaration
-class PlayoutEngine;
+namespace retrovue::runtime {
 
 // Result structure for controller operations
 struct ControllerResult {
@@ -50,7 +51,11 @@ class PlayoutController {
       int32_t channel_id,
       const std::string& plan_handle,
       int32_t port,
-      const std::optional<std::string>& uds_path = std::nullopt);
+      const std::optional<std::string>& uds_path = std::nullopt,
+      const ChannelPlacement& placement = ChannelPlacement(),
+      const ChannelBufferOptions& buffer = ChannelBufferOptions(),
+      int32_t priority = 0,
+      int64_t timeline_origin_utc_us = 0);
   
   // Stop a channel gracefully
   ControllerResult StopChannel(int32_t channel_id);
@@ -67,6 +72,22 @@ class PlayoutController {
   ControllerResult UpdatePlan(
       int32_t channel_id,
       const std::string& plan_handle);
+
+  // Change an active channel's buffer latency
+  ControllerResult ResizeBuffer(int32_t channel_id, int64_t latency_ms);
+
+  // Batch operations: the engine runs the channels in parallel; one result
+  // per entry, in request order
+  std::vector<ControllerResult> StartChannels(const std::vector<ChannelStartRequest>& requests);
+  std::vector<ControllerResult> StopChannels(const std::vector<int32_t>& channel_ids);
+  std::vector<ControllerResult> LoadPreviews(const std::vector<ChannelPreviewRequest>& requests);
+
+  // Host capacity and running channels (see PlayoutEngine::GetHostCapacity)
+  HostCapacityReport GetHostCapacity();
+
+  // Push feed of channel status changes (see PlayoutEngine::WatchChannels)
+  std::shared_ptr<telemetry::ChannelWatch> WatchChannels(const std::vector<int32_t>& channel_ids,
+                                                         std::chrono::milliseconds min_interval);
   
  private:
   // Domain engine that contains the tested implementation
@@ -6,23 +6,50 @@
 #ifndef RETROVUE_RUNTIME_PLAYOUT_ENGINE_H_
 #define RETROVUE_RUNTIME_PLAYOUT_ENGINE_H_
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <optional>
 #include <unordered_map>
+#include <vector>
+
+#include "retrovue/buffer/FrameMemoryBudget.h"
+#include "retrovue/renderer/FrameRenderer.h"
+#include "retrovue/runtime/ChannelPlacement.h"
+#include "retrovue/runtime/LoadShedder.h"
+#include "retrovue/telemetry/HostCpu.h"
 
 namespace retrovue::timing {
 class MasterClock;
 }
 
 namespace retrovue::telemetry {
+class ChannelWatch;
 class MetricsExporter;
+class ThumbnailGenerator;
+}
+
+namespace retrovue::decode {
+struct ProducerConfig;
+}
+
+namespace retrovue::playout_sinks::mpegts {
+class EncoderThreadBudget;
 }
 
 namespace retrovue::runtime {
 
+class ChannelCheckpointFile;
+class ChannelManifest;
+class IoRing;
+class TaskExecutor;
+
 // Domain result structure
 struct EngineResult {
   bool success;
@@ -30,6 +57,7 @@ struct EngineResult {
   
   // For LoadPreview
   bool shadow_decode_started = false;
+  bool decode_shared = false;  // Joined another channel's decode of the asset
   
   // For SwitchToLive
   bool pts_contiguous = false;
@@ -39,13 +67,127 @@ struct EngineResult {
       : success(s), message(msg) {}
 };
 
+// DecodeThreadBudget bounds decoder threads across every channel in the process.
+struct DecodeThreadBudget {
+  int max_total_threads = 0;    // Process-wide cap (0 = hardware concurrency)
+  int per_channel_threads = 2;  // Threads requested per producer before capping
+};
+
+// BufferPolicy sizes channel ring buffers by latency within a process-wide
+// frame memory budget.
+struct BufferPolicy {
+  int64_t latency_ms = 2000;       // Default buffer depth as time (60 frames at 30 fps)
+  size_t min_frames = 6;           // Shallowest buffer a channel may be given
+  size_t max_frames = 300;         // Deepest buffer a channel may grow to
+  size_t memory_budget_bytes = 0;  // Frame memory across all channels (0 = unlimited)
+};
+
+// ChannelBufferOptions adjusts one channel's buffer within the BufferPolicy.
+struct ChannelBufferOptions {
+  int64_t latency_ms = 0;  // Buffer depth as time (0 = policy default)
+  int width = 0;           // Decoded frame size (0 = 1920x1080)
+  int height = 0;
+};
+
+// ChannelStartRequest is one channel of a StartChannels() batch.
+struct ChannelStartRequest {
+  int32_t channel_id = 0;
+  std::string plan_handle;
+  int32_t port = 0;
+  std::optional<std::string> uds_path;
+  ChannelPlacement placement;
+  ChannelBufferOptions buffer;
+  int32_t priority = 0;  // Load shedding order, higher degrades later (see LoadShedder)
+  int64_t timeline_origin_utc_us = 0;  // UTC its PTS 0 is due (0 = this host's timeline)
+};
+
+// ChannelPreviewRequest is one channel of a LoadPreviews() batch.
+struct ChannelPreviewRequest {
+  int32_t channel_id = 0;
+  std::string asset_path;
+};
+
+// ChannelBufferReport describes a channel's ring buffer and its memory.
+struct ChannelBufferReport {
+  size_t depth_limit_frames = 0;  // Frames the buffer may hold
+  size_t depth_frames = 0;        // Frames it holds now
+  size_t frame_bytes = 0;         // Bytes per decoded frame
+  size_t reserved_bytes = 0;      // Frame memory reserved against the budget
+  size_t used_bytes = 0;          // Of that, held by queued frames
+  int64_t latency_ms = 0;         // Latency target the depth was derived from
+};
+
+// ChannelTimingReport is a snapshot of a channel's per-frame timing and the
+// CPU time of its pacing threads (producer and renderer).
+struct ChannelTimingReport {
+  renderer::FrameTimingStats render;
+  uint64_t producer_cpu_ns = 0;
+  uint64_t frames_produced = 0;
+  bool producer_running = false;  // False once the live producer stopped (end of input)
+};
+
+// FrameExportPolicy opts channels into shared-memory frame export
+// (buffer::SharedFrameExport), for analytics processes on the same host.
+struct FrameExportPolicy {
+  std::string socket_dir = "/run/retrovue";  // Channel N listens on <socket_dir>/frames-N.sock
+  std::vector<int32_t> channel_ids;          // Channels exported
+  bool all_channels = false;                 // Export every channel instead
+  size_t slots = 8;                          // Frames each export holds for its readers
+};
+
+// HostCapacityPolicy is what this host offers the coordinator that places
+// channels across hosts.
+struct HostCapacityPolicy {
+  std::string host_id;    // Reported name (empty = the hostname)
+  int encoder_slots = 0;  // Channels the host encodes at once (0 = unlimited)
+};
+
+// HostChannelReport is a running channel as a coordinator sees it: enough
+// to start it on another host on the same timeline.
+struct HostChannelReport {
+  int32_t channel_id = 0;
+  std::string plan_handle;
+  int32_t priority = 0;
+  int64_t timeline_origin_utc_us = 0;  // UTC its PTS 0 is due
+  int decode_threads = 0;              // Of its producers (shared ones: of each channel)
+  size_t reserved_bytes = 0;           // Frame memory reserved for its buffer
+};
+
+// HostCapacityReport advertises what the host runs and what it has left.
+struct HostCapacityReport {
+  std::string host_id;
+  int cpu_cores = 0;
+  double cpu_busy_ratio = 0.0;  // Host CPU time in use since the previous report (0..1)
+  int decode_threads_total = 0;
+  int decode_threads_in_use = 0;
+  int encoder_slots_total = 0;  // 0 = unlimited
+  int encoder_slots_in_use = 0;
+  size_t memory_budget_bytes = 0;  // Frame memory limit (0 = unlimited)
+  size_t memory_reserved_bytes = 0;
+  bool clock_disciplined = false;  // Timelines line up with other hosts on the reference
+  bool clock_locked = false;
+  int64_t clock_offset_us = 0;     // Reference minus this host at the last sample
+  std::vector<HostChannelReport> channels;  // By channel id
+};
+
 // PlayoutEngine provides domain-level channel lifecycle management.
 // This is the authoritative implementation that has been tested via contract tests.
+//
+// With an executor, every channel's producers and renderer run as tasks on
+// it instead of threads of their own (see TaskExecutor); the executor must
+// outlive the engine.
 class PlayoutEngine {
  public:
   PlayoutEngine(
       std::shared_ptr<telemetry::MetricsExporter> metrics_exporter,
-      std::shared_ptr<timing::MasterClock> master_clock);
+      std::shared_ptr<timing::MasterClock> master_clock,
+      const DecodeThreadBudget& decode_budget = DecodeThreadBudget(),
+      size_t read_ahead_bytes = 0,
+      std::shared_ptr<TaskExecutor> executor = nullptr,
+      const PlacementPolicy& placement_policy = PlacementPolicy(),
+      const BufferPolicy& buffer_policy = BufferPolicy(),
+      const LoadShedPolicy& shed_policy = LoadShedPolicy(),
+      const HostCapacityPolicy& capacity_policy = HostCapacityPolicy());
   
   ~PlayoutEngine();
   
@@ -54,14 +196,31 @@ class PlayoutEngine {
   PlayoutEngine& operator=(const PlayoutEngine&) = delete;
   
   // Domain methods - these are the tested implementations
+  // placement pins the channel's producer and render threads and places its
+  // frame memory; unset fields fall back to the engine's PlacementPolicy.
+  // buffer sets the ring depth (as latency) and frame size; the start fails
+  // if even the policy's minimum depth does not fit the memory budget.
+  // priority orders the channel for load shedding (see LoadShedPolicy).
+  // timeline_origin_utc_us puts PTS 0 at that UTC instead of on this host's
+  // timeline, and starts the plan at the point due now: given the origin
+  // another host reports for the channel (GetHostCapacity()), the channel
+  // runs in step with it, frame for frame, so it can be moved there without
+  // a break. Each running channel takes an encoder slot.
   EngineResult StartChannel(
       int32_t channel_id,
       const std::string& plan_handle,
       int32_t port,
-      const std::optional<std::string>& uds_path = std::nullopt);
+      const std::optional<std::string>& uds_path = std::nullopt,
+      const ChannelPlacement& placement = ChannelPlacement(),
+      const ChannelBufferOptions& buffer = ChannelBufferOptions(),
+      int32_t priority = 0,
+      int64_t timeline_origin_utc_us = 0);
   
   EngineResult StopChannel(int32_t channel_id);
   
+  // A preview of an asset another channel has just opened at the same
+  // frame size, with no frame decoded yet, joins that decode instead of
+  // opening its own (simulcast; see LoadPreviews()).
   EngineResult LoadPreview(
       int32_t channel_id,
       const std::string& asset_path);
@@ -71,17 +230,244 @@ class PlayoutEngine {
   EngineResult UpdatePlan(
       int32_t channel_id,
       const std::string& plan_handle);
+
+  // Batch operations run the single-channel operation for every entry, up
+  // to kBatchParallelism channels at a time, and return one result per
+  // entry in request order. Entries succeed or fail independently. Entries
+  // naming the same channel serialize on it, in no set order.
+  // LoadPreviews() decodes an asset once for every entry airing it: the
+  // first entry opens it and the others join before it starts.
+  std::vector<EngineResult> StartChannels(const std::vector<ChannelStartRequest>& requests);
+  std::vector<EngineResult> StopChannels(const std::vector<int32_t>& channel_ids);
+  std::vector<EngineResult> LoadPreviews(const std::vector<ChannelPreviewRequest>& requests);
+
+  // Channels of a batch in flight at once. Starts mostly wait (asset open,
+  // readiness), so this is well above the core count.
+  static constexpr size_t kBatchParallelism = 32;
+
+  // Re-sizes a running channel's buffer to latency_ms (0 = policy default)
+  // without interrupting it. Growing fails if it does not fit the budget;
+  // shrinking drops nothing, the buffer drains down to the new depth.
+  EngineResult ResizeChannelBuffer(int32_t channel_id, int64_t latency_ms);
+
+  // Returns the decoder threads currently granted to live and preview producers.
+  int DecodeThreadsInUse() const;
+
+  // Fills report for a running channel; false if it is not running.
+  bool GetChannelTiming(int32_t channel_id, ChannelTimingReport& report) const;
+
+  // Placement a running channel was started with, after the policy applied.
+  bool GetChannelPlacement(int32_t channel_id, ChannelPlacement& placement) const;
+
+  // Fills report for a running channel; false if it is not running.
+  bool GetChannelBuffer(int32_t channel_id, ChannelBufferReport& report) const;
+
+  // Opens a push feed of channel status (state transitions, buffer depth,
+  // underruns, late frames); see telemetry::MetricsExporter::WatchChannels.
+  std::shared_ptr<telemetry::ChannelWatch> WatchChannels(const std::vector<int32_t>& channel_ids,
+                                                         std::chrono::milliseconds min_interval);
+
+  // Decode degradation load shedding has put a running channel at; false if
+  // it is not running.
+  bool GetChannelDegradation(int32_t channel_id, decode::DecodeDegradation& level) const;
+
+  // What the host runs and has left, for a coordinator placing channels.
+  // The CPU share is measured since the previous call (since boot on the
+  // first).
+  HostCapacityReport GetHostCapacity();
+
+  // Process-wide frame memory accounting.
+  buffer::FrameMemoryBudgetStats GetBufferBudgetStats() const { return buffer_budget_.GetStats(); }
+
+  // Persists the running channel set to manifest: starts record the request,
+  // plan updates and buffer resizes amend it, StopChannel() drops it.
+  // Channels stopped by the engine's destruction stay recorded. Set it
+  // before the first start.
+  void SetChannelManifest(std::shared_ptr<ChannelManifest> manifest);
+
+  // Checkpoints every running channel to checkpoints each interval (its
+  // timeline origin, position and plan), and clears a channel's checkpoint
+  // when StopChannel() stops it. RestoreChannels() then resumes channels
+  // started on this host's timeline at the point of their plan due now,
+  // instead of from the beginning: the producer seeks to the keyframe at or
+  // before it (KeyframeIndex), every channel in parallel. Set it before the
+  // first start; checkpoints must already be open.
+  static constexpr std::chrono::milliseconds kDefaultCheckpointInterval{250};
+  void SetChannelCheckpoints(std::shared_ptr<ChannelCheckpointFile> checkpoints,
+                             std::chrono::milliseconds interval = kDefaultCheckpointInterval);
+
+  // Makes each channel started afterwards render straight into the sink
+  // factory returns for it (renderer::RenderMode::SINK), so the output is
+  // the channel's only consumer. A null sink keeps the channel headless.
+  using ChannelSinkFactory =
+      std::function<std::shared_ptr<renderer::FrameSink>(int32_t channel_id, int32_t port)>;
+  void SetChannelSinkFactory(ChannelSinkFactory factory);
+
+  // Taps each channel started afterwards for confidence thumbnails (the
+  // renderer offers every frame it renders; see telemetry::ThumbnailTap).
+  void SetThumbnailGenerator(std::shared_ptr<telemetry::ThumbnailGenerator> thumbnails);
+
+  // Queues the read-ahead reads of each channel started afterwards on
+  // io_ring, shared with the other channels (and their sinks), instead of
+  // giving each producer a fill thread.
+  void SetIoRing(std::shared_ptr<IoRing> io_ring);
+
+  // Software video encoder threads shared by every channel's sink: a
+  // ChannelSinkFactory building MpegTS sinks gives each this budget as its
+  // config's encoder_threads, so the channels share the host's cores
+  // instead of each encoder sizing itself to all of them. Null = none.
+  void SetEncoderThreadBudget(
+      std::shared_ptr<playout_sinks::mpegts::EncoderThreadBudget> encoder_threads);
+  std::shared_ptr<playout_sinks::mpegts::EncoderThreadBudget> GetEncoderThreadBudget() const {
+    return encoder_threads_;
+  }
+
+  // Exports the decoded frames of the channels policy names, for those
+  // started afterwards: their frame memory is a shared arena, and each
+  // frame the renderer pops is published there by reference for readers
+  // that connect to the channel's socket.
+  void SetFrameExportPolicy(FrameExportPolicy policy);
+
+  // Starts every channel the manifest records, as one StartChannels() batch,
+  // and returns their results in manifest (channel id) order. Each channel
+  // reports BUFFERING as soon as it is queued and READY (or ERROR_STATE)
+  // once its own start finishes. Failed channels stay recorded for the next
+  // restore. Empty without a manifest. With checkpoints, each channel
+  // resumes where its timeline is now (see SetChannelCheckpoints()).
+  std::vector<EngineResult> RestoreChannels();
   
  private:
-  std::shared_ptr<telemetry::MetricsExporter> metrics_exporter_;
-  std::shared_ptr<timing::MasterClock> master_clock_;
-  
   // Forward declaration for internal channel state
   struct ChannelState;
+
+  // A producer and its decode threads, shared by the channels it feeds.
+  struct Feed;
+
+  // Takes ring onto the registered feed for key if it has not produced a
+  // frame yet; nullptr if there is none to join.
+  std::shared_ptr<Feed> JoinFeed(const std::string& key, buffer::FrameRingBuffer& ring);
+
+  // Detaches the channel from feed and resets it. The last channel stops the
+  // producer (draining its buffer first if drain) and returns its threads.
+  void ReleaseFeed(ChannelState& state, std::shared_ptr<Feed>& feed, bool drain);
+
+  // LoadPreview(); with held, a feed the preview opens is registered but
+  // not started, and handed back for the caller to start.
+  EngineResult LoadPreviewImpl(int32_t channel_id, const std::string& asset_path,
+                               std::shared_ptr<Feed>* held);
+
+  // Reserves a producer's decode thread budget within the process-wide cap
+  // (always at least one thread); ReleaseDecodeThreads() returns it.
+  int ReserveDecodeThreads();
+  void ReleaseDecodeThreads(int threads);
+
+  // Takes a starting channel's encoder slot; false if all are taken.
+  bool AcquireEncoderSlot();
+  void ReleaseEncoderSlot();
+
+  // Channel map helpers; each holds channels_mutex_ only for the lookup.
+  std::shared_ptr<ChannelState> FindChannel(int32_t channel_id) const;
+  void EraseChannel(const ChannelState& state);  // Only if still mapped to state
+
+  // With shedding enabled, samples every running channel each policy
+  // interval and applies the LoadShedder's decisions.
+  void ShedLoop();
+
+  // Writes every running channel's checkpoint each checkpoint interval.
+  void CheckpointLoop();
+
+  // Writes the channel's checkpoint. Call with state.mutex held.
+  void WriteCheckpoint(const ChannelState& state);
+
+  // Runs op(0) .. op(count - 1) on up to kBatchParallelism threads.
+  static std::vector<EngineResult> RunBatch(size_t count,
+                                            const std::function<EngineResult(size_t)>& op);
+
+  // Stops the channel; forget also drops it from the manifest.
+  EngineResult StopChannelImpl(int32_t channel_id, bool forget);
+
+  // Builds and starts the channel's components. Call with state.mutex held.
+  EngineResult StartChannelLocked(ChannelState& state);
+
+  // Depth for latency_ms (0 = policy default), clamped to the policy's bounds.
+  size_t BufferDepthFor(int64_t latency_ms) const;
+
+  // Frame memory of the channel's producer pools for a buffer of depth
+  // frames (each running producer, live and preview, has its own pool).
+  size_t ChannelBufferBytes(const ChannelState& state, size_t depth, int producers) const;
+
+  // Reserves frame memory for the channel's buffer, shrinking it (down to
+  // the policy minimum) to fit the budget. Call with state.mutex held.
+  bool ReserveChannelBuffer(ChannelState& state, std::string& error);
+
+  // Returns the reservation and clears the channel's telemetry of it.
+  void ReleaseChannelBuffer(ChannelState& state);
+
+  // Publishes the channel's buffer reservation to telemetry.
+  void RecordChannelBuffer(const ChannelState& state) const;
+
+  // Applies the storage read-ahead window, tags the producer with its
+  // channel and routes its read stalls and CPU time to the channel's
+  // telemetry.
+  void ConfigureProducerIO(decode::ProducerConfig& config, int32_t channel_id) const;
+
+  // True if the frame export policy names the channel.
+  bool ExportsFrames(int32_t channel_id) const;
+
+  std::shared_ptr<telemetry::MetricsExporter> metrics_exporter_;
+  std::shared_ptr<timing::MasterClock> master_clock_;
   
-  // Channel management (thread-safe)
+  // Channel management (thread-safe). channels_mutex_ guards only the map;
+  // each channel's operations serialize on its own ChannelState::mutex, so a
+  // slow start or stop on one channel does not hold up the others.
   mutable std::mutex channels_mutex_;
-  std::unordered_map<int32_t, std::unique_ptr<ChannelState>> channels_;
+  std::unordered_map<int32_t, std::shared_ptr<ChannelState>> channels_;
+
+  // Decoder thread accounting (decode_threads_in_use_ guarded by budget_mutex_)
+  DecodeThreadBudget decode_budget_;
+  mutable std::mutex budget_mutex_;
+  int decode_threads_in_use_ = 0;
+
+  // Encoder slots (encoder_slots_in_use_ guarded by budget_mutex_)
+  HostCapacityPolicy capacity_policy_;
+  int encoder_slots_in_use_ = 0;
+  std::mutex host_cpu_mutex_;
+  telemetry::HostCpuTimes host_cpu_;  // At the previous GetHostCapacity() (guarded)
+
+  // Preview feeds open to joining, by asset and frame size
+  std::mutex feeds_mutex_;
+  std::unordered_map<std::string, std::weak_ptr<Feed>> feeds_;
+
+  size_t read_ahead_bytes_;  // Prefetch window per producer (0 = read directly)
+  std::shared_ptr<IoRing> io_ring_;  // Read-ahead reads (optional)
+  FrameExportPolicy frame_export_policy_;
+  std::shared_ptr<TaskExecutor> executor_;  // Shared component executor (optional)
+  ChannelPlacer placer_;  // Per-channel CPU and NUMA placement
+
+  BufferPolicy buffer_policy_;
+  buffer::FrameMemoryBudget buffer_budget_;  // Frame memory across channels
+
+  std::shared_ptr<ChannelManifest> manifest_;  // Persisted channel set (optional)
+
+  // Channel checkpoints (optional), written by checkpoint_thread_
+  std::shared_ptr<ChannelCheckpointFile> checkpoints_;
+  std::chrono::milliseconds checkpoint_interval_{kDefaultCheckpointInterval};
+  std::mutex checkpoint_mutex_;
+  std::condition_variable checkpoint_cv_;
+  bool checkpoint_stop_ = false;  // Guarded by checkpoint_mutex_
+  std::thread checkpoint_thread_;
+  ChannelSinkFactory sink_factory_;            // Channel outputs (optional)
+  // Handed to the sinks sink_factory_ builds (optional)
+  std::shared_ptr<playout_sinks::mpegts::EncoderThreadBudget> encoder_threads_;
+  std::shared_ptr<telemetry::ThumbnailGenerator> thumbnails_;  // Optional
+
+  // Load shedding (the shedder is used by shed_thread_ only)
+  LoadShedPolicy shed_policy_;
+  LoadShedder shedder_;
+  std::mutex shed_mutex_;
+  std::condition_variable shed_cv_;
+  bool shed_stop_ = false;  // Guarded by shed_mutex_
+  std::thread shed_thread_;
 };
 
 }  // namespace retrovue::runtime
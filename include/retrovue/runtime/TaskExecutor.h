@@ -0,0 +1,176 @@
+// Repository: Retrovue-playout
+// Component: Task Executor
+// Purpose: Shared work-stealing pool that runs channel components as tasks.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_RUNTIME_TASK_EXECUTOR_H_
+#define RETROVUE_RUNTIME_TASK_EXECUTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace retrovue::timing {
+class DeadlineScheduler;
+}  // namespace retrovue::timing
+
+namespace retrovue::runtime {
+
+// TaskExecutorStats is a point-in-time view of a TaskExecutor.
+struct TaskExecutorStats {
+  size_t workers = 0;
+  uint64_t tasks_run = 0;      // Work-lane tasks run
+  uint64_t steals = 0;         // Of those, taken from another worker's queue
+  uint64_t pacing_tasks = 0;   // Pacing-lane tasks posted
+  uint64_t timed_tasks = 0;    // Tasks posted through PostAt()
+  size_t queued = 0;           // Work-lane tasks waiting
+};
+
+// TaskExecutor runs the producers and renderers of every channel as tasks
+// on one shared pool instead of a thread per component per channel, so the
+// thread count is set by the core count rather than the channel count.
+//
+// Lanes:
+// - kWork: a work-stealing pool (a worker per core by default). Each worker
+//   has its own queue; it runs its newest task first and, when idle, steals
+//   the oldest task of another worker. Tasks posted from outside the pool
+//   go round-robin. Decode and other throughput work goes here.
+// - kPacing: the threads of the shared DeadlineScheduler (optionally pinned
+//   and at real-time priority, see DeadlineScheduler::Config). Pacing tasks
+//   run on the dispatching thread at their deadline, so frame pacing never
+//   queues behind decode work. They must be short.
+//
+// Timed tasks (PostAt) take a DeadlineScheduler timer; when it fires a
+// work-lane task is queued to the pool and a pacing task runs in place.
+//
+// Thread Model: Post(), PostAt(), Cancel() and GetStats() from any thread;
+// Start() and Stop() from the owning thread. Stop() runs what is queued and
+// then refuses posts, which ends any TaskLoop still running; the executor
+// must outlive its timed tasks.
+class TaskExecutor {
+ public:
+  enum class Lane {
+    kWork,
+    kPacing,
+  };
+
+  using Task = std::function<void()>;
+  using TimerId = uint64_t;
+
+  struct Config {
+    size_t workers = 0;  // Work-lane threads (0 = hardware concurrency)
+  };
+
+  // The scheduler runs pacing and timed tasks; the executor starts it if it
+  // is not running and stops it only if it started it.
+  TaskExecutor(const Config& config, std::shared_ptr<timing::DeadlineScheduler> scheduler);
+  ~TaskExecutor();
+
+  TaskExecutor(const TaskExecutor&) = delete;
+  TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+  bool Start();
+  void Stop();
+  bool running() const { return running_.load(std::memory_order_acquire); }
+
+  // Queues task to run as soon as a thread of lane is free. Returns false if
+  // the executor is not running.
+  bool Post(Task task, Lane lane = Lane::kWork);
+
+  // Queues task on lane at system_utc_us (the host wall clock, see
+  // timing::MasterClock::ToSystemUtcUs). Returns 0 if not running.
+  TimerId PostAt(int64_t system_utc_us, Task task, Lane lane = Lane::kWork);
+
+  // Withdraws a PostAt() task whose time has not come. Returns false if it
+  // already ran or was queued.
+  bool Cancel(TimerId id);
+
+  TaskExecutorStats GetStats() const;
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;  // Owner takes the back, thieves the front
+    std::thread thread;
+  };
+
+  void WorkerLoop(size_t index);
+  bool TakeTask(size_t index, Task& task);
+
+  const Config config_;
+  std::shared_ptr<timing::DeadlineScheduler> scheduler_;
+  bool owns_scheduler_run_ = false;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> running_{false};
+  std::atomic<size_t> next_worker_{0};
+
+  // Sleeping workers wait here for queued_ to become non-zero
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  std::atomic<size_t> queued_{0};
+  bool stop_ = false;
+
+  std::atomic<uint64_t> tasks_run_{0};
+  std::atomic<uint64_t> steals_{0};
+  std::atomic<uint64_t> pacing_tasks_{0};
+  std::atomic<uint64_t> timed_tasks_{0};
+};
+
+// TaskLoop drives a component's loop as a chain of executor tasks: each run
+// calls step once, and step returns when it wants to run next (system UTC
+// microseconds, kNow, or kDone). Runs of one loop never overlap.
+//
+// Stop() stops the chain: a run already queued sees the stop and ends it,
+// a timed run not yet due is cancelled. Either way on_done runs exactly
+// once (on an executor thread or in Stop()) before Stop() returns.
+class TaskLoop {
+ public:
+  static constexpr int64_t kNow = 0;
+  static constexpr int64_t kDone = -1;
+
+  using Step = std::function<int64_t()>;
+
+  TaskLoop(TaskExecutor& executor, TaskExecutor::Lane lane, Step step,
+           std::function<void()> on_done);
+  ~TaskLoop();
+
+  TaskLoop(const TaskLoop&) = delete;
+  TaskLoop& operator=(const TaskLoop&) = delete;
+
+  // Queues the first run. Returns false if the executor is not running.
+  bool Start();
+
+  // Ends the chain and blocks until on_done has run.
+  void Stop();
+
+  bool done() const;
+
+ private:
+  void Run();
+  void Schedule(int64_t system_utc_us);
+  void Finish();
+
+  TaskExecutor& executor_;
+  const TaskExecutor::Lane lane_;
+  const Step step_;
+  const std::function<void()> on_done_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable done_cv_;
+  bool started_ = false;
+  bool stopping_ = false;
+  bool finishing_ = false;  // on_done claimed
+  bool done_ = false;       // on_done returned
+  TaskExecutor::TimerId timer_ = 0;  // Pending timed run, if any
+};
+
+}  // namespace retrovue::runtime
+
+#endif  // RETROVUE_RUNTIME_TASK_EXECUTOR_H_
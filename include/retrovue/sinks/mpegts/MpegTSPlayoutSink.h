@@ -9,6 +9,7 @@
 #include "retrovue/sinks/IPlayoutSink.h"
 #include "retrovue/sinks/mpegts/SinkConfig.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/renderer/FrameSink.h"
 #include "retrovue/timing/MasterClock.h"
 
 #include <atomic>
@@ -21,9 +22,11 @@ namespace retrovue::sinks::mpegts {
 
 // MpegTSPlayoutSink consumes decoded frames from FrameRingBuffer,
 // encodes them to H.264, muxes to MPEG-TS, and streams over TCP socket.
-// The sink owns its timing loop and continuously queries MasterClock
-// to determine when to output frames.
-class MpegTSPlayoutSink : public IPlayoutSink {
+// Started with start(), the sink owns its timing loop and continuously
+// queries MasterClock to determine when to output frames. As a
+// renderer::FrameSink (RenderMode::SINK) it has no thread of its own: the
+// channel's render loop opens it, writes each due frame and closes it.
+class MpegTSPlayoutSink : public IPlayoutSink, public renderer::FrameSink {
  public:
   MpegTSPlayoutSink(
       const SinkConfig& config,
@@ -38,6 +41,11 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   void stop() override;
   bool isRunning() const override;
 
+  // renderer::FrameSink interface (use instead of start()/stop())
+  bool Open() override;
+  void WriteFrame(const buffer::Frame& frame, int64_t deadline_utc_us) override;
+  void Close() override;
+
   // Statistics
   uint64_t getFramesSent() const { return frames_sent_.load(); }
   uint64_t getFramesDropped() const { return frames_dropped_.load(); }
@@ -47,6 +55,9 @@ class MpegTSPlayoutSink : public IPlayoutSink {
   uint64_t getBufferEmptyCount() const { return buffer_empty_count_.load(); }
 
  private:
+  // Opens socket, encoder and muxer; false (everything closed) on failure
+  bool OpenOutput();
+
   // Worker thread that owns the timing loop
   void WorkerLoop();
 
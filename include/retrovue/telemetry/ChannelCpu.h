@@ -0,0 +1,147 @@
+// Repository: Retrovue-playout
+// Component: Channel CPU Accounting
+// Purpose: Thread CPU time of each channel, split by pipeline stage, and thread naming.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_CHANNEL_CPU_H_
+#define RETROVUE_TELEMETRY_CHANNEL_CPU_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "retrovue/telemetry/ThreadCpu.h"
+
+namespace retrovue::telemetry {
+
+// CpuStage is the pipeline stage a channel's CPU time is charged to.
+enum class CpuStage : uint8_t {
+  kDecode,  // Demux and decode
+  kScale,   // Scale and pack into frames
+  kEncode,  // Video and audio encode
+  kMux,     // MPEG-TS mux
+  kSend,    // Socket output
+  kRender,  // Pacing and presentation
+};
+
+constexpr size_t kCpuStageCount = 6;
+
+inline const char* CpuStageName(CpuStage stage) {
+  switch (stage) {
+    case CpuStage::kDecode:
+      return "decode";
+    case CpuStage::kScale:
+      return "scale";
+    case CpuStage::kEncode:
+      return "encode";
+    case CpuStage::kMux:
+      return "mux";
+    case CpuStage::kSend:
+      return "send";
+    case CpuStage::kRender:
+      return "render";
+  }
+  return "unknown";
+}
+
+// ChannelCpuAccount sums the thread CPU time a channel's stages used. Each
+// stage counts on its own cache line, since different threads charge
+// different stages. Thread-safe. Get a channel's account from
+// MetricsExporter::AcquireChannelCpu().
+class ChannelCpuAccount {
+ public:
+  void Add(CpuStage stage, uint64_t ns) {
+    stages_[static_cast<size_t>(stage)].ns.fetch_add(ns, std::memory_order_relaxed);
+  }
+
+  uint64_t Get(CpuStage stage) const {
+    return stages_[static_cast<size_t>(stage)].ns.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Total() const {
+    uint64_t total = 0;
+    for (const Counter& counter : stages_) {
+      total += counter.ns.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+ private:
+  struct alignas(64) Counter {
+    std::atomic<uint64_t> ns{0};
+  };
+  std::array<Counter, kCpuStageCount> stages_{};
+};
+
+// StageCpuMeter charges the CPU time of the thread using it to the stages
+// of a channel's account: Charge(stage) adds what the thread used since its
+// last Charge() or Restart() (since the thread started, on a dedicated
+// thread's first charge), so a thread that runs several stages brackets
+// each with one clock read. Code running as tasks on shared threads calls
+// Restart() when a task step begins. Without an account it reads no clock.
+//
+// Thread Model: one thread at a time.
+class StageCpuMeter {
+ public:
+  StageCpuMeter() = default;
+  explicit StageCpuMeter(std::shared_ptr<ChannelCpuAccount> account)
+      : account_(std::move(account)) {}
+
+  void SetAccount(std::shared_ptr<ChannelCpuAccount> account) {
+    account_ = std::move(account);
+    last_ns_ = 0;
+  }
+
+  bool active() const { return account_ != nullptr; }
+
+  void Restart() {
+    if (account_) {
+      last_ns_ = ThreadCpuTimeNs();
+    }
+  }
+
+  void Charge(CpuStage stage) {
+    if (!account_) {
+      return;
+    }
+    const uint64_t now_ns = ThreadCpuTimeNs();
+    if (now_ns > last_ns_) {
+      account_->Add(stage, now_ns - last_ns_);
+    }
+    last_ns_ = now_ns;
+  }
+
+ private:
+  std::shared_ptr<ChannelCpuAccount> account_;
+  uint64_t last_ns_ = 0;
+};
+
+// Names the calling thread "rv<channel>-<role>" (just role for a negative
+// channel id), so top -H, perf and debuggers show which channel and stage it
+// works for. Linux keeps the first 15 characters; no-op elsewhere.
+inline void NameCurrentThread(int32_t channel_id, const char* role) {
+#ifdef __linux__
+  char name[16];
+  if (channel_id >= 0) {
+    std::snprintf(name, sizeof(name), "rv%d-%s", static_cast<int>(channel_id), role);
+  } else {
+    std::snprintf(name, sizeof(name), "rv-%s", role);
+  }
+  pthread_setname_np(pthread_self(), name);
+#else
+  (void)channel_id;
+  (void)role;
+#endif
+}
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_CHANNEL_CPU_H_
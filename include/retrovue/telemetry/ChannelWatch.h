@@ -0,0 +1,111 @@
+// Repository: Retrovue-playout
+// Component: Channel Watch
+// Purpose: Pushes channel status changes to a watcher, coalesced per channel.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_CHANNEL_WATCH_H_
+#define RETROVUE_TELEMETRY_CHANNEL_WATCH_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "retrovue/telemetry/MetricsExporter.h"
+
+namespace retrovue::telemetry {
+
+// ChannelStatus is the part of a channel's telemetry that watchers follow.
+struct ChannelStatus {
+  int32_t channel_id = 0;
+  int64_t timestamp_us = 0;       // System UTC the exporter saw the latest change
+  ChannelState state = ChannelState::STOPPED;
+  std::string control_state;      // PlayoutControlStateMachine state ("playing", ...)
+  uint64_t buffer_depth_frames = 0;
+  uint64_t underruns_total = 0;   // Times the renderer found the buffer empty
+  uint64_t late_frames_total = 0; // Frames dropped as too late to present
+  bool removed = false;           // The channel's metrics were removed
+};
+
+// ChannelStatusEvent is one delivery of a watch: the channel's latest status
+// and what changed since the watcher's previous event for that channel.
+struct ChannelStatusEvent {
+  ChannelStatus status;
+  bool state_changed = false;  // State, control state or removal (always set on the first event)
+  uint64_t underruns = 0;      // New since the previous event
+  uint64_t late_frames = 0;
+  uint64_t coalesced = 0;      // Updates folded into this event
+};
+
+// ChannelWatch queues the status changes of some channels for one watcher.
+// Updates of a channel are coalesced to at most one event per min_interval,
+// carrying the newest values; a channel's first event, a state change and
+// a removal are due at once (taking the pending update with them), so
+// failover never waits out the interval.
+//
+// Thread Model: Offer() from the exporter; Poll() and Next() from the
+// watcher; Close() from any thread.
+class ChannelWatch {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // channel_ids empty = every channel.
+  ChannelWatch(std::vector<int32_t> channel_ids, std::chrono::milliseconds min_interval);
+
+  ChannelWatch(const ChannelWatch&) = delete;
+  ChannelWatch& operator=(const ChannelWatch&) = delete;
+
+  bool Watches(int32_t channel_id) const;
+
+  // Folds status into its channel's pending event; ignored if nothing the
+  // watch follows changed, or once closed.
+  void Offer(const ChannelStatus& status);
+
+  // Takes the next due event without blocking. Otherwise returns false and
+  // sets next_due to when the next pending event will be due
+  // (Clock::time_point::max() if none is pending).
+  bool Poll(ChannelStatusEvent& event, Clock::time_point& next_due);
+
+  // Waits up to timeout for the next due event. False on timeout and once
+  // closed.
+  bool Next(ChannelStatusEvent& event, std::chrono::milliseconds timeout);
+
+  // on_ready runs (on the Offer() thread, outside the watch's lock) when an
+  // event may have become due, for watchers that Poll() several watches.
+  // It must not block or call back into the exporter.
+  void SetReadyCallback(std::function<void()> on_ready);
+
+  // Ends the watch; the exporter drops it on its next update.
+  void Close();
+  bool closed() const;
+
+ private:
+  struct Channel {
+    ChannelStatus latest;
+    ChannelStatus sent;      // As of the previous event
+    bool has_sent = false;
+    bool pending = false;
+    uint64_t coalesced = 0;
+    Clock::time_point sent_at;
+  };
+
+  static bool Urgent(const Channel& channel);
+  bool TakeDueLocked(Clock::time_point now, ChannelStatusEvent& event, Clock::time_point& next_due);
+
+  const std::vector<int32_t> channel_ids_;  // Sorted
+  const std::chrono::milliseconds min_interval_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable ready_cv_;
+  std::map<int32_t, Channel> channels_;
+  std::function<void()> on_ready_;
+  bool closed_ = false;
+};
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_CHANNEL_WATCH_H_
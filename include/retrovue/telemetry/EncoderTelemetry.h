@@ -0,0 +1,153 @@
+// Repository: Retrovue-playout
+// Component: Encoder Telemetry
+// Purpose: Per-frame encoder and output-path measurements of a channel's sink.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_ENCODER_TELEMETRY_H_
+#define RETROVUE_TELEMETRY_ENCODER_TELEMETRY_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "retrovue/telemetry/HdrHistogram.h"
+
+namespace retrovue::telemetry {
+
+// PictureType is the coded type of an encoded video frame.
+enum class PictureType : uint8_t {
+  kI,
+  kP,
+  kB,
+};
+
+constexpr size_t kPictureTypeCount = 3;
+
+inline const char* PictureTypeName(PictureType type) {
+  switch (type) {
+    case PictureType::kI:
+      return "I";
+    case PictureType::kP:
+      return "P";
+    case PictureType::kB:
+      return "B";
+  }
+  return "unknown";
+}
+
+// Histogram ranges: values above are counted as the highest
+constexpr int64_t kMaxEncodeUs = 10'000'000;
+constexpr int64_t kMaxFrameBytes = 16 * 1024 * 1024;
+constexpr int64_t kMaxQp = 127;
+constexpr int64_t kMaxPcrUs = 1'000'000;
+
+// EncoderTelemetrySnapshot is a point-in-time copy of EncoderTelemetry.
+struct EncoderTelemetrySnapshot {
+  int64_t configured_bitrate_bps = 0;
+  int64_t realized_bitrate_bps = 0;  // Muxed output over the last sample interval
+  uint64_t output_bytes = 0;         // Muxed TS bytes handed to the outputs
+  uint64_t output_queue_bytes = 0;   // Muxed bytes waiting for the outputs
+  double send_buffer_ratio = 0.0;    // Fullest client socket send buffer (0-1)
+  bool audio_measured = false;       // Audio processing set the two below
+  double audio_integrated_lufs = -std::numeric_limits<double>::infinity();  // Output, gated
+  double audio_gain_db = 0.0;        // Current normalization gain
+  HdrHistogram encode_us{kMaxEncodeUs};
+  std::array<HdrHistogram, kPictureTypeCount> frame_bytes{
+      HdrHistogram(kMaxFrameBytes), HdrHistogram(kMaxFrameBytes), HdrHistogram(kMaxFrameBytes)};
+  std::array<HdrHistogram, kPictureTypeCount> qp{HdrHistogram(kMaxQp), HdrHistogram(kMaxQp),
+                                                 HdrHistogram(kMaxQp)};
+  HdrHistogram pcr_interval_us{kMaxPcrUs};
+  HdrHistogram pcr_jitter_us{kMaxPcrUs};  // |PCR advance - wall time advance|
+};
+
+// EncoderTelemetry collects what the encoder and output path of one channel
+// measure per frame and per PCR: encode time, coded frame sizes and QP by
+// picture type, PCR spacing, and (sampled by the sink's output thread)
+// realized bitrate, output queue bytes and client send buffer fill. Every
+// record is a relaxed atomic store or a histogram increment, so it runs on
+// the encode path; readers take snapshots when metrics are read.
+//
+// Thread Model: records and Snapshot() from any thread. Get a channel's
+// telemetry from MetricsExporter::AcquireEncoderTelemetry() and hand it to
+// the sink (MpegTSPlayoutSinkConfig::encoder_telemetry).
+class EncoderTelemetry {
+ public:
+  void SetConfiguredBitrate(int64_t bps) {
+    configured_bitrate_bps_.store(bps, std::memory_order_relaxed);
+  }
+
+  // Wall time one input frame took through the encoder and muxer.
+  void RecordEncode(int64_t encode_us) { snapshot_.encode_us.Record(encode_us); }
+
+  // A coded video frame; qp < 0 when the encoder does not report it.
+  void RecordFrame(PictureType type, size_t bytes, int qp) {
+    const auto index = static_cast<size_t>(type);
+    snapshot_.frame_bytes[index].Record(static_cast<int64_t>(bytes));
+    if (qp >= 0) {
+      snapshot_.qp[index].Record(qp);
+    }
+  }
+
+  // Spacing of consecutive PCRs in stream time (interval_us < 0 when the
+  // PCR before was not seen), and how far the PCR advance strayed from the
+  // wall time between their muxing.
+  void RecordPcr(int64_t interval_us, int64_t jitter_us) {
+    if (interval_us >= 0) {
+      snapshot_.pcr_interval_us.Record(interval_us);
+    }
+    snapshot_.pcr_jitter_us.Record(jitter_us < 0 ? -jitter_us : jitter_us);
+  }
+
+  void AddOutputBytes(uint64_t bytes) { output_bytes_.fetch_add(bytes, std::memory_order_relaxed); }
+
+  // Output gauges, sampled by the sink's output thread.
+  void SetOutputGauges(int64_t realized_bitrate_bps, uint64_t queue_bytes,
+                       double send_buffer_ratio) {
+    realized_bitrate_bps_.store(realized_bitrate_bps, std::memory_order_relaxed);
+    output_queue_bytes_.store(queue_bytes, std::memory_order_relaxed);
+    send_buffer_ppm_.store(static_cast<uint32_t>(send_buffer_ratio * 1e6),
+                           std::memory_order_relaxed);
+  }
+
+  // Audio loudness, set by the sink's audio processing.
+  void SetAudioLoudness(double integrated_lufs, double gain_db) {
+    audio_integrated_lufs_.store(integrated_lufs, std::memory_order_relaxed);
+    audio_gain_db_.store(gain_db, std::memory_order_relaxed);
+    audio_measured_.store(true, std::memory_order_relaxed);
+  }
+
+  uint64_t output_bytes() const { return output_bytes_.load(std::memory_order_relaxed); }
+  uint64_t encoded_frames() const { return snapshot_.encode_us.Count(); }
+
+  EncoderTelemetrySnapshot Snapshot() const {
+    EncoderTelemetrySnapshot snapshot = snapshot_;
+    snapshot.configured_bitrate_bps = configured_bitrate_bps_.load(std::memory_order_relaxed);
+    snapshot.realized_bitrate_bps = realized_bitrate_bps_.load(std::memory_order_relaxed);
+    snapshot.output_bytes = output_bytes_.load(std::memory_order_relaxed);
+    snapshot.output_queue_bytes = output_queue_bytes_.load(std::memory_order_relaxed);
+    snapshot.send_buffer_ratio =
+        static_cast<double>(send_buffer_ppm_.load(std::memory_order_relaxed)) / 1e6;
+    snapshot.audio_measured = audio_measured_.load(std::memory_order_relaxed);
+    snapshot.audio_integrated_lufs = audio_integrated_lufs_.load(std::memory_order_relaxed);
+    snapshot.audio_gain_db = audio_gain_db_.load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+ private:
+  // The histograms, recorded in place; the scalar fields are unused here
+  EncoderTelemetrySnapshot snapshot_;
+  std::atomic<int64_t> configured_bitrate_bps_{0};
+  std::atomic<int64_t> realized_bitrate_bps_{0};
+  std::atomic<uint64_t> output_bytes_{0};
+  std::atomic<uint64_t> output_queue_bytes_{0};
+  std::atomic<uint32_t> send_buffer_ppm_{0};
+  std::atomic<bool> audio_measured_{false};
+  std::atomic<double> audio_integrated_lufs_{-std::numeric_limits<double>::infinity()};
+  std::atomic<double> audio_gain_db_{0.0};
+};
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_ENCODER_TELEMETRY_H_
@@ -0,0 +1,78 @@
+// Repository: Retrovue-playout
+// Component: HDR Histogram
+// Purpose: Fixed-memory, lock-free latency histogram with percentile queries.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_HDR_HISTOGRAM_H_
+#define RETROVUE_TELEMETRY_HDR_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace retrovue::telemetry {
+
+// HdrHistogram counts non-negative integer values (typically microseconds)
+// in log-linear buckets, HdrHistogram style: every power-of-two range is
+// split into the same number of linear sub-buckets, so any recorded value
+// is known to within 10^-significant_digits of itself however large it is.
+//
+// Memory is fixed at construction (about 20 KiB for 1 us to 60 s at two
+// significant digits) and Record() is a few instructions and one relaxed
+// atomic increment, so it can run on every frame of every channel. Values
+// above highest_value are counted as highest_value.
+//
+// Copies are snapshots; Add() and Subtract() combine them, e.g. to merge
+// channels or to take the difference of two snapshots over an interval.
+//
+// Thread Model: Record() from any number of threads; queries and snapshots
+// from any thread (concurrent records may or may not be included).
+class HdrHistogram {
+ public:
+  explicit HdrHistogram(int64_t highest_value = 60'000'000, int significant_digits = 2);
+
+  HdrHistogram(const HdrHistogram& other);
+  HdrHistogram& operator=(const HdrHistogram& other);
+
+  void Record(int64_t value) { RecordCount(value, 1); }
+  void RecordCount(int64_t value, uint64_t count);
+
+  // Adds (subtracts) the counts of a histogram with the same layout.
+  // Returns false if the layouts differ.
+  bool Add(const HdrHistogram& other);
+  bool Subtract(const HdrHistogram& other);
+
+  void Reset();
+
+  uint64_t Count() const;
+  int64_t Max() const;    // Highest value recorded (exact, unless over highest_value)
+  double Mean() const;    // From bucket midpoints
+
+  // Smallest value v such that percentile% of the recorded values are <= v
+  // (to the histogram's precision). 0 when empty.
+  int64_t ValueAtPercentile(double percentile) const;
+
+  int64_t highest_value() const { return highest_value_; }
+  int significant_digits() const { return significant_digits_; }
+
+ private:
+  size_t IndexOf(int64_t value) const;
+  int64_t LowestAt(size_t index) const;
+  int64_t HighestAt(size_t index) const;
+  bool SameLayout(const HdrHistogram& other) const;
+
+  int64_t highest_value_;
+  int significant_digits_;
+  int sub_bucket_half_magnitude_;
+  int64_t sub_bucket_half_count_;
+  int64_t sub_bucket_mask_;
+  size_t counts_length_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<uint64_t> total_{0};
+  std::atomic<int64_t> max_{0};
+};
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_HDR_HISTOGRAM_H_
@@ -0,0 +1,56 @@
+// Repository: Retrovue-playout
+// Component: Host CPU Time
+// Purpose: Reads how much CPU time the whole host has spent busy.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_HOST_CPU_H_
+#define RETROVUE_TELEMETRY_HOST_CPU_H_
+
+#include <cstdint>
+#include <cstdio>
+
+namespace retrovue::telemetry {
+
+// HostCpuTimes are the host's CPU time counters since boot, summed over
+// every CPU, in clock ticks.
+struct HostCpuTimes {
+  uint64_t busy = 0;   // Not idle or waiting for I/O
+  uint64_t total = 0;
+};
+
+// Fills times from /proc/stat; false if the platform cannot tell.
+inline bool ReadHostCpuTimes(HostCpuTimes* times) {
+#ifdef __linux__
+  FILE* stat = std::fopen("/proc/stat", "r");
+  if (!stat) {
+    return false;
+  }
+  unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0,
+                     softirq = 0, steal = 0;
+  const int fields = std::fscanf(stat, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &user,
+                                 &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+  std::fclose(stat);
+  if (fields < 4) {
+    return false;
+  }
+  times->busy = user + nice + system + irq + softirq + steal;
+  times->total = times->busy + idle + iowait;
+  return true;
+#else
+  (void)times;
+  return false;
+#endif
+}
+
+// Fraction of the host's CPU time spent busy between two readings (0..1).
+inline double HostCpuBusyRatio(const HostCpuTimes& before, const HostCpuTimes& after) {
+  if (after.total <= before.total) {
+    return 0.0;
+  }
+  const uint64_t busy = after.busy >= before.busy ? after.busy - before.busy : 0;
+  return static_cast<double>(busy) / static_cast<double>(after.total - before.total);
+}
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_HOST_CPU_H_
@@ -6,9 +6,11 @@
 #ifndef RETROVUE_TELEMETRY_METRICS_EXPORTER_H_
 #define RETROVUE_TELEMETRY_METRICS_EXPORTER_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -17,10 +19,20 @@
 #include <thread>
 #include <vector>
 
+#include "retrovue/buffer/ChannelArena.h"
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/telemetry/ChannelCpu.h"
+#include "retrovue/telemetry/EncoderTelemetry.h"
+#include "retrovue/telemetry/HdrHistogram.h"
+#include "retrovue/telemetry/MetricsHTTPServer.h"
+#include "retrovue/telemetry/WindowedHistogram.h"
+
 namespace retrovue::telemetry {
 
-// Forward declaration
+// Forward declarations
 class MetricsHTTPServer;
+class ChannelWatch;
+struct ChannelStatus;
 
 // ChannelState represents the current state of a playout channel.
 enum class ChannelState {
@@ -33,20 +45,135 @@ enum class ChannelState {
 // Convert ChannelState to string for metrics output.
 const char* ChannelStateToString(ChannelState state);
 
+// Number of occupancy histogram buckets reported per channel; must match
+// buffer::kOccupancyBuckets. Bucket i has upper bound (i + 1) / 8 of capacity.
+constexpr size_t kBufferOccupancyBuckets = 8;
+
+// SrtLinkMetrics is the state of a channel's SRT contribution link (see
+// playout_sinks::mpegts::TsSrtOutputStats).
+struct SrtLinkMetrics {
+  bool connected = false;
+  double rtt_seconds = 0.0;
+  uint64_t retransmits_total = 0;
+  uint64_t packets_lost_total = 0;
+  uint64_t send_drops_total = 0;     // Packets dropped as too late to deliver
+  uint64_t bytes_sent_total = 0;     // TS bytes sent (the stream's bitrate, via rate())
+  double send_buffer_ratio = 0.0;    // Send buffer fill (0-1)
+  double send_buffer_seconds = 0.0;  // Time span of the unacknowledged data
+  double send_rate_bps = 0.0;
+};
+
 // ChannelMetrics holds per-channel telemetry data.
+// Ring buffer memory of a channel. Set by the engine when the buffer is
+// sized or resized.
+struct BufferMemoryMetrics {
+  uint64_t depth_limit_frames = 0;  // Frames the buffer may hold
+  uint64_t frame_bytes = 0;         // Bytes per decoded frame
+  uint64_t reserved_bytes = 0;      // Frame memory reserved against the budget
+};
+
 struct ChannelMetrics {
   ChannelState state;
   uint64_t buffer_depth_frames;
   double frame_gap_seconds;
   uint64_t decode_failure_count;
   uint64_t corrections_total;
+  uint64_t underruns_total;    // Renderer found the buffer empty (episodes)
+  uint64_t late_frames_total;  // Renderer dropped frames as too late
+
+  // Ring buffer instrumentation (see buffer::BufferStats).
+  uint64_t buffer_high_water_frames;
+  uint64_t buffer_low_water_frames;
+  uint64_t buffer_push_failures_total;
+  double buffer_residency_seconds_sum;
+  uint64_t buffer_residency_count;
+  double buffer_residency_seconds_max;
+  std::array<uint64_t, kBufferOccupancyBuckets> buffer_occupancy_buckets;
+  double buffer_occupancy_ratio_sum;
+
+  // Storage read-ahead (see decode::ReadAheadStats). Accumulated by the
+  // exporter from RecordReadStalls(); SubmitChannelMetrics() keeps them.
+  uint64_t read_stalls_total;
+  double read_stall_seconds_total;
+
+  // SRT link, when the channel has one. Set by the exporter from
+  // RecordSrtLinkStats(); SubmitChannelMetrics() keeps it.
+  std::optional<SrtLinkMetrics> srt_link;
+
+  // Buffer memory. Set by the exporter from RecordBufferMemory();
+  // SubmitChannelMetrics() keeps it.
+  BufferMemoryMetrics buffer_memory;
+
+  // PlayoutControlStateMachine state ("playing", ...). Set by the exporter
+  // from RecordControlState(); SubmitChannelMetrics() keeps it.
+  std::string control_state;
   
   ChannelMetrics()
       : state(ChannelState::STOPPED),
         buffer_depth_frames(0),
         frame_gap_seconds(0.0),
         decode_failure_count(0),
-        corrections_total(0) {}
+        corrections_total(0),
+        underruns_total(0),
+        late_frames_total(0),
+        buffer_high_water_frames(0),
+        buffer_low_water_frames(0),
+        buffer_push_failures_total(0),
+        buffer_residency_seconds_sum(0.0),
+        buffer_residency_count(0),
+        buffer_residency_seconds_max(0.0),
+        buffer_occupancy_buckets{},
+        buffer_occupancy_ratio_sum(0.0),
+        read_stalls_total(0),
+        read_stall_seconds_total(0.0) {}
+};
+
+// FrameStageLatency aggregates a channel's sampled frame traces: how long
+// frames took to reach each stage from the stage before it (the last one
+// they reached; stage_us[kDemuxed] stays empty), and from the first stage
+// they reached to the last.
+struct FrameStageLatency {
+  uint64_t frames = 0;
+  std::array<HdrHistogram, buffer::kFrameStageCount> stage_us;
+  HdrHistogram total_us;
+};
+
+// ChannelSlot holds the metrics a channel's hot path refreshes on every
+// frame (buffer depth and instrumentation, frame gap, renderer totals) in
+// relaxed atomics, on cache lines no other channel shares. Record() takes
+// no lock, queues nothing and wakes no one; the exporter reads the slot only
+// when metrics are read (scrapes, GetChannelMetrics(), watches), so the
+// cost of telemetry is a few uncontended stores per frame.
+//
+// Thread Model: Record() and Load() from any thread. A reader racing a
+// Record() may see some of its fields and not others. Get a channel's slot
+// from MetricsExporter::AcquireChannelSlot().
+class alignas(64) ChannelSlot {
+ public:
+  // Stores the hot-path fields of metrics; the rest are ignored.
+  void Record(const ChannelMetrics& metrics);
+
+  // Copies the recorded fields over metrics; false (leaving metrics as it
+  // is) until the first Record().
+  bool Load(ChannelMetrics& metrics) const;
+
+  uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> records_{0};
+  std::atomic<uint64_t> buffer_depth_frames_{0};
+  std::atomic<double> frame_gap_seconds_{0.0};
+  std::atomic<uint64_t> corrections_total_{0};
+  std::atomic<uint64_t> underruns_total_{0};
+  std::atomic<uint64_t> late_frames_total_{0};
+  std::atomic<uint64_t> buffer_high_water_frames_{0};
+  std::atomic<uint64_t> buffer_low_water_frames_{0};
+  std::atomic<uint64_t> buffer_push_failures_total_{0};
+  std::atomic<double> buffer_residency_seconds_sum_{0.0};
+  std::atomic<uint64_t> buffer_residency_count_{0};
+  std::atomic<double> buffer_residency_seconds_max_{0.0};
+  std::array<std::atomic<uint64_t>, kBufferOccupancyBuckets> buffer_occupancy_buckets_{};
+  std::atomic<double> buffer_occupancy_ratio_sum_{0.0};
 };
 
 // MetricsExporter serves Prometheus metrics at an HTTP endpoint.
@@ -61,12 +188,53 @@ struct ChannelMetrics {
 // - retrovue_playout_buffer_depth_frames{channel="N"} - gauge
 // - retrovue_playout_frame_gap_seconds{channel="N"} - gauge
 // - retrovue_playout_decode_failure_count{channel="N"} - counter
+// - retrovue_playout_buffer_underrun_total{channel="N"} - counter
+// - retrovue_playout_late_frames_total{channel="N"} - counter
+// - retrovue_playout_buffer_{high,low}_water_frames{channel="N"} - gauge
+// - retrovue_playout_buffer_push_failures_total{channel="N"} - counter
+// - retrovue_playout_buffer_residency_seconds{channel="N"} - summary (sum/count) + _max gauge
+// - retrovue_playout_buffer_occupancy_ratio{channel="N"} - histogram
+// - retrovue_playout_buffer_{depth_limit_frames,reserved_bytes,used_bytes}{channel="N"} - gauge
+// - retrovue_playout_buffer_memory_budget_bytes - gauge (when a budget is set)
+// - retrovue_playout_read_stalls_total{channel="N"} - counter
+// - retrovue_playout_read_stall_seconds_total{channel="N"} - counter
+// - retrovue_playout_srt_{connected,rtt_seconds,send_buffer_ratio,
+//   send_buffer_seconds,send_rate_bps}{channel="N"} - gauge (channels with an SRT link)
+// - retrovue_playout_srt_{retransmits,packets_lost,send_drops,bytes_sent}_total{channel="N"} - counter
+// - retrovue_playout_frame_stage_latency_seconds{channel="N",stage="S"} - summary
+//   (sampled frames, from the stage before; see RecordFrameTrace())
+// - retrovue_playout_frame_pipeline_latency_seconds{channel="N"} - summary
+// - retrovue_channel_cpu_seconds_total{channel="N",stage="S"} - counter
+//   (thread CPU time charged through AcquireChannelCpu())
+// - retrovue_channel_memory_bytes{channel="N",state="in_use|cached"} - gauge
+// - retrovue_channel_memory_peak_bytes{channel="N"} - gauge
+// - retrovue_channel_memory_allocations_total{channel="N",source="system|reused"} - counter
+//   (the channel's arena, see SetChannelArena())
+// - retrovue_encoder_{encode_seconds,pcr_interval_seconds,pcr_jitter_seconds}{channel="N"} - summary
+// - retrovue_encoder_{frame_size_bytes,qp}{channel="N",picture="I|P|B"} - summary
+// - retrovue_encoder_{configured,realized}_bitrate_bps{channel="N"} - gauge
+// - retrovue_encoder_output_bytes_total{channel="N"} - counter
+// - retrovue_encoder_{output_queue_bytes,send_buffer_ratio}{channel="N"} - gauge
+//   (recorded by the sink through AcquireEncoderTelemetry())
+// - retrovue_audio_{integrated_lufs,gain_db}{channel="N"} - gauge
+//   (with the sink's audio processing on, once it has measured)
+// - retrovue_metrics_slot_records_total - counter (ChannelSlot::Record() calls)
 //
 // Usage:
 // 1. Construct with port number
 // 2. Call Start() to begin serving metrics
-// 3. Update metrics using SubmitChannelMetrics()
+// 3. Update metrics using SubmitChannelMetrics(), or per frame through a
+//    ChannelSlot (AcquireChannelSlot())
 // 4. Call Stop() to shutdown server
+//
+// Rare updates (channel state, removals, descriptors, per-link stats) go
+// through an event queue drained by a worker thread; per-frame figures go
+// to channel slots and delivery status to per-transport atomics, merged
+// only when metrics are read.
+//
+// Watchers (WatchChannels) are pushed status changes as the exporter
+// stores them, instead of polling or scraping; slot changes reach them
+// within 50 ms while the exporter runs.
 class MetricsExporter {
  public:
   enum class Transport {
@@ -79,6 +247,8 @@ class MetricsExporter {
     uint64_t deliveries = 0;
     uint64_t failures = 0;
     double latency_p95_ms = 0.0;
+    double latency_p95_1m_ms = 0.0;
+    double latency_p95_5m_ms = 0.0;
   };
 
   struct Snapshot {
@@ -105,22 +275,91 @@ class MetricsExporter {
   // Stops the metrics HTTP server.
   void Stop();
 
+  // Serves paths under prefix from the metrics HTTP server (see
+  // MetricsHTTPServer::AddHandler). Must be called before Start(); ignored
+  // without HTTP.
+  void AddHttpHandler(const std::string& prefix, HttpHandler handler);
+
   // Returns true if the exporter is currently running.
   bool IsRunning() const { return running_.load(std::memory_order_acquire); }
 
-  // Updates metrics for a specific channel.
+  // Updates metrics for a specific channel. The hot-path fields also
+  // replace what the channel's slot holds, if it has one.
   bool SubmitChannelMetrics(int32_t channel_id, const ChannelMetrics& metrics);
 
+  // The channel's slot for per-frame updates (created on first use, kept
+  // until the channel is removed). Its recorded fields override those of
+  // submitted snapshots from then on.
+  std::shared_ptr<ChannelSlot> AcquireChannelSlot(int32_t channel_id);
+
+  // The channel's CPU account, charged by its threads per stage (created on
+  // first use, kept until the channel is removed).
+  std::shared_ptr<ChannelCpuAccount> AcquireChannelCpu(int32_t channel_id);
+
+  // CPU time per stage (indexed by CpuStage) charged to a channel; false if
+  // it has no account.
+  bool GetChannelCpu(int32_t channel_id, std::array<uint64_t, kCpuStageCount>& cpu_ns) const;
+
+  // Reports the channel's memory arena in scrapes (replacing an earlier
+  // one) until the channel is removed; once released it still shows the
+  // blocks the channel's frames hold.
+  void SetChannelArena(int32_t channel_id, std::shared_ptr<const buffer::ChannelArena> arena);
+
+  // The channel's encoder telemetry, recorded by its sink (created on first
+  // use, kept until the channel is removed).
+  std::shared_ptr<EncoderTelemetry> AcquireEncoderTelemetry(int32_t channel_id);
+
+  // A snapshot of a channel's encoder telemetry; false if it has none.
+  bool GetEncoderTelemetry(int32_t channel_id, EncoderTelemetrySnapshot& snapshot) const;
+
+  // Adds storage read stalls to a channel's running totals. Safe to call
+  // from decode threads; the totals survive SubmitChannelMetrics().
+  void RecordReadStalls(int32_t channel_id, uint64_t stalls, double stall_seconds);
+
+  // Replaces a channel's SRT link state. Safe to call from the link thread;
+  // the state survives SubmitChannelMetrics().
+  void RecordSrtLinkStats(int32_t channel_id, const SrtLinkMetrics& link);
+
+  // Replaces a channel's buffer memory figures; they survive
+  // SubmitChannelMetrics(). Used bytes follow from the reported depth.
+  void RecordBufferMemory(int32_t channel_id, const BufferMemoryMetrics& memory);
+
+  // Sets the process-wide frame memory budget reported (0 = unlimited, not reported).
+  void SetBufferMemoryBudget(uint64_t limit_bytes) {
+    buffer_memory_budget_bytes_.store(limit_bytes, std::memory_order_relaxed);
+  }
+
+  // Replaces a channel's control state name; it survives
+  // SubmitChannelMetrics(). Safe to call under the state machine's lock.
+  void RecordControlState(int32_t channel_id, const std::string& control_state);
+
+  // Adds a sampled frame's trace (see buffer::FrameTrace) to its channel's
+  // stage latencies. Called by the frame's last stage (the renderer, or the
+  // TS sink once the frame's output is sent); frames not sampled are
+  // ignored.
+  void RecordFrameTrace(int32_t channel_id, const buffer::FrameTrace& trace);
+
+  // A channel's stage latencies; false if it has recorded no trace.
+  bool GetFrameStageLatency(int32_t channel_id, FrameStageLatency& latency) const;
+
   // Removes metrics for a channel (when channel stops).
   void SubmitChannelRemoval(int32_t channel_id);
 
+  // Opens a watch over channel_ids (empty = every channel). It starts with
+  // the current status of each watched channel, then gets every change to
+  // state, buffer depth, underruns and late frames as the exporter stores
+  // it, coalesced per channel to one event per min_interval (see
+  // ChannelWatch). Close the watch to end it.
+  std::shared_ptr<ChannelWatch> WatchChannels(const std::vector<int32_t>& channel_ids,
+                                              std::chrono::milliseconds min_interval);
+
   // Registers or updates a metric descriptor with semantic version.
   void RegisterMetricDescriptor(const std::string& name, const std::string& version);
 
   // Marks a descriptor as deprecated.
   void DeprecateMetricDescriptor(const std::string& name);
 
-  // Records delivery status for a transport.
+  // Records delivery status for a transport. Lock-free.
   void RecordDeliveryStatus(Transport transport, bool success, double latency_ms);
 
   // Gets the current metrics for a channel.
@@ -140,7 +379,11 @@ class MetricsExporter {
       kRemoveChannel,
       kRegisterDescriptor,
       kDeprecateDescriptor,
-      kRecordTransport,
+      kRecordReadStalls,
+      kRecordSrtLink,
+      kRecordBufferMemory,
+      kRecordControlState,
+      kRecordFrameTrace,
     };
 
     Type type;
@@ -148,9 +391,12 @@ class MetricsExporter {
     ChannelMetrics channel_metrics;
     std::string descriptor_name;
     std::string descriptor_version;
-    Transport transport = Transport::kGrpcStream;
-    bool transport_success = true;
-    double transport_latency_ms = 0.0;
+    uint64_t read_stalls = 0;
+    double read_stall_seconds = 0.0;
+    SrtLinkMetrics srt_link;
+    BufferMemoryMetrics buffer_memory;
+    std::string control_state;
+    buffer::FrameTrace frame_trace;
   };
 
   class EventQueue {
@@ -171,9 +417,39 @@ class MetricsExporter {
   // Generates Prometheus-format metrics text.
   std::string GenerateMetricsText() const;
 
+  // Changes whenever GenerateMetricsText() would: on processed events,
+  // deliveries, slot records and each turn of the windowed histograms'
+  // slots (the HTTP server serves its cached text until it does).
+  uint64_t MetricsVersion() const;
+
   void WorkerLoop();
   void ProcessEvent(const Event& event);
-  static double ComputePercentile(const std::vector<double>& values, double percentile);
+
+  // Stores a channel snapshot, carrying over exporter-owned counters.
+  // Call with metrics_mutex_ held.
+  void StoreChannelMetricsLocked(int32_t channel_id, const ChannelMetrics& metrics);
+
+  // A channel's stored metrics with its slot's fields applied; false if the
+  // channel has neither. Call with metrics_mutex_ held.
+  bool LoadChannelLocked(int32_t channel_id, ChannelMetrics& metrics) const;
+
+  // Every channel, as LoadChannelLocked(). Call with metrics_mutex_ held.
+  std::map<int32_t, ChannelMetrics> LoadChannelsLocked() const;
+
+  // Offers channels whose slots were recorded since the last call to the
+  // watches. Call with metrics_mutex_ held.
+  void PublishSlotChangesLocked();
+
+  // Call with metrics_mutex_ held.
+  void AddFrameTraceLocked(int32_t channel_id, const buffer::FrameTrace& trace);
+
+  // Call with metrics_mutex_ held.
+  void AddReadStallsLocked(int32_t channel_id, uint64_t stalls, double stall_seconds);
+
+  // Offers the channel's stored status (or its removal) to the watches,
+  // dropping closed ones. Call with metrics_mutex_ held.
+  void PublishStatusLocked(int32_t channel_id);
+  void PublishRemovalLocked(int32_t channel_id);
 
   int port_;
   const bool enable_http_;
@@ -183,6 +459,7 @@ class MetricsExporter {
   std::unique_ptr<MetricsHTTPServer> http_server_;
 
   std::atomic<uint64_t> queue_overflow_total_;
+  std::atomic<uint64_t> buffer_memory_budget_bytes_{0};
   EventQueue event_queue_;
   std::atomic<uint64_t> submitted_events_;
   std::atomic<uint64_t> processed_events_;
@@ -193,15 +470,28 @@ class MetricsExporter {
   // Channel metrics storage (protected by mutex)
   mutable std::mutex metrics_mutex_;
   std::map<int32_t, ChannelMetrics> channel_metrics_;
+  std::map<int32_t, FrameStageLatency> frame_latency_;
   std::map<std::string, std::string> descriptor_versions_;
   std::map<std::string, bool> descriptor_deprecated_;
+  std::vector<std::weak_ptr<ChannelWatch>> watches_;
 
-  struct TransportData {
-    uint64_t deliveries = 0;
-    uint64_t failures = 0;
-    std::vector<double> latencies_ms;
+  struct SlotEntry {
+    std::shared_ptr<ChannelSlot> slot;
+    uint64_t published_records = 0;  // records() when the watches were last offered it
+  };
+  std::map<int32_t, SlotEntry> channel_slots_;
+  std::map<int32_t, std::shared_ptr<ChannelCpuAccount>> channel_cpu_;
+  std::map<int32_t, std::shared_ptr<const buffer::ChannelArena>> channel_arenas_;
+  std::map<int32_t, std::shared_ptr<EncoderTelemetry>> encoder_telemetry_;
+
+  // Written by any thread without a lock, on lines of their own
+  struct alignas(64) TransportData {
+    std::atomic<uint64_t> deliveries{0};
+    std::atomic<uint64_t> failures{0};
+    WindowedHistogram latency_us;  // Fixed memory, with 1m / 5m views
   };
-  std::map<Transport, TransportData> transport_data_;
+  static constexpr size_t kTransports = 3;
+  std::array<TransportData, kTransports> transport_data_;
 };
 
 }  // namespace retrovue::telemetry
@@ -7,39 +7,87 @@
 #define RETROVUE_TELEMETRY_METRICS_HTTP_SERVER_H_
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace retrovue::telemetry {
 
-// MetricsCallback is called to generate metrics text for each request.
+// MetricsCallback generates the metrics text (see SetMetricsCacheInterval()
+// for how often).
 using MetricsCallback = std::function<std::string()>;
 
-// MetricsHTTPServer serves Prometheus metrics over HTTP.
+// MetricsVersionCallback returns a number that changes whenever the data
+// behind the metrics text does. Called on the server thread; must be cheap.
+using MetricsVersionCallback = std::function<uint64_t()>;
+
+// HttpRequest is a parsed GET request line.
+struct HttpRequest {
+  std::string path;                          // Without the query string
+  std::map<std::string, std::string> query;  // Decoded query parameters
+};
+
+// HttpResponse is filled in by a handler. The body is shared so handlers
+// can serve stored buffers without copying them.
+struct HttpResponse {
+  int status = 200;
+  std::string content_type = "text/plain";
+  std::string cache_control;                 // Omitted when empty
+  std::shared_ptr<const std::string> body;
+};
+
+// HttpHandler serves the paths under its prefix; returning false answers
+// 404. Handlers run on handler threads and may block (long polling).
+using HttpHandler = std::function<bool(const HttpRequest& request, HttpResponse& response)>;
+
+// HttpServerStats counts a server's work.
+struct HttpServerStats {
+  uint64_t connections_accepted = 0;
+  uint64_t connections_rejected = 0;  // Over the connection or handler thread limit (503)
+  uint64_t requests = 0;
+  uint64_t metrics_generated = 0;     // Metrics texts built by the callback
+  uint64_t metrics_cached = 0;        // Metrics requests served a cached text
+  uint64_t gzip_responses = 0;
+};
+
+// MetricsHTTPServer serves Prometheus metrics over HTTP, and whatever else
+// is registered with AddHandler() (the HLS segmenter's playlists and
+// segments).
 //
 // Features:
-// - Simple HTTP/1.1 server
+// - HTTP/1.1 with keep-alive and pipelining
 // - GET /metrics endpoint
-// - Prometheus text exposition format
-// - Non-blocking accept with select()
-// - Thread-safe metric updates via callback
+// - Prometheus text exposition format, gzip-encoded for clients that accept it
+// - Cached metrics text (see SetMetricsCacheInterval())
+// - Prefix-routed handlers with query parsing
 //
 // Design:
-// - Runs in dedicated server thread
-// - Calls user-provided callback to generate metrics
-// - Returns 200 OK with text/plain for /metrics
-// - Returns 404 for other paths
+// - One event loop (epoll on Linux, poll() elsewhere) reads requests and
+//   writes responses for every connection with non-blocking sockets, so
+//   slow or concurrent clients do not queue behind each other
+// - /metrics is answered on the loop from the cached text
+// - Registered handlers run on a thread per request (up to kMaxHandlers,
+//   then 503), so a handler holding a request open stalls only its own
+//   connection; the loop sends the response when the handler returns
+// - Returns 404 for unknown paths; idle connections close after 5 s
 //
 // Thread Model:
 // - Server runs in its own thread
-// - Accepts connections and handles requests
-// - Callback is called on server thread
+// - The metrics and version callbacks are called on the server thread
+// - Handlers are called on handler threads
 //
 // Usage:
 // 1. Construct with port number
-// 2. Set metrics callback with SetMetricsCallback()
+// 2. Set metrics callback with SetMetricsCallback() and/or AddHandler()
 // 3. Call Start() to begin serving
 // 4. Call Stop() to shutdown
 class MetricsHTTPServer {
@@ -58,6 +106,20 @@ class MetricsHTTPServer {
   // Must be called before Start().
   void SetMetricsCallback(MetricsCallback callback);
 
+  // Lets the server tell whether the metrics text changed: a cached text is
+  // served as long as the version stays the same. Must be called before
+  // Start(); without one, the text is taken as changed on every request.
+  void SetMetricsVersionCallback(MetricsVersionCallback callback);
+
+  // The metrics text is regenerated at most once per interval (default
+  // 1 s), and only when its version changed; 0 regenerates on every change.
+  // Must be called before Start().
+  void SetMetricsCacheInterval(std::chrono::milliseconds interval);
+
+  // Routes requests whose path starts with prefix to handler (the longest
+  // matching prefix wins). Must be called before Start().
+  void AddHandler(const std::string& prefix, HttpHandler handler);
+
   // Starts the HTTP server.
   // Returns true if started successfully.
   bool Start();
@@ -71,18 +133,59 @@ class MetricsHTTPServer {
   // Gets the port number server is listening on.
   int GetPort() const { return port_; }
 
+  HttpServerStats GetStats() const;
+
  private:
+  static constexpr size_t kMaxConnections = 1024;
+  static constexpr size_t kMaxHandlers = 32;
+
+  struct Client;  // A connection's state (server thread only)
+
+  struct HandlerThread {
+    std::thread thread;
+    std::atomic<bool> done{false};
+  };
+
+  // A handler's response, for the loop to send
+  struct Completion {
+    uint64_t client_id = 0;
+    HttpResponse response;
+  };
+
   // Main server loop (runs in server thread).
   void ServerLoop();
 
-  // Handles a single client connection.
-  void HandleConnection(int client_socket);
+  // Answers the complete requests buffered on client, in order, until one
+  // goes to a handler thread. Returns false if the client is to be closed.
+  bool ServeRequests(Client& client);
+
+  // Queues response on client, with the connection's keep-alive state; gzip
+  // marks a gzip-encoded body.
+  void QueueResponse(Client& client, const HttpResponse& response, bool gzip);
+
+  // Sends what client has queued; false if the client went away or is done.
+  bool FlushClient(Client& client);
+
+  // Parses the HTTP request line into path and query.
+  HttpRequest ParseRequest(const std::string& request);
+
+  // The registered handler for path (longest prefix), or nullptr.
+  const HttpHandler* FindHandler(const std::string& path) const;
+
+  // Generates HTTP response (paths without a handler).
+  HttpResponse GenerateResponse(const HttpRequest& request);
+
+  // The metrics text (gzip-encoded with gzip), regenerated if due.
+  std::shared_ptr<const std::string> MetricsBody(bool gzip);
+
+  // Runs a handler on its own thread; false at kMaxHandlers.
+  bool StartHandler(const HttpHandler& handler, HttpRequest request, uint64_t client_id);
 
-  // Parses HTTP request and returns path.
-  std::string ParseRequest(const std::string& request);
+  // Joins finished handler threads (all of them with wait_all).
+  void ReapHandlers(bool wait_all);
 
-  // Generates HTTP response.
-  std::string GenerateResponse(const std::string& path);
+  // Wakes the loop (a handler finished).
+  void Wake();
 
   int port_;
   std::atomic<bool> running_;
@@ -90,6 +193,29 @@ class MetricsHTTPServer {
   
   std::unique_ptr<std::thread> server_thread_;
   MetricsCallback metrics_callback_;
+  MetricsVersionCallback metrics_version_callback_;
+  std::chrono::milliseconds metrics_cache_interval_{1000};
+  std::vector<std::pair<std::string, HttpHandler>> handlers_;
+
+  // Server thread only
+  std::unordered_map<uint64_t, std::unique_ptr<Client>> clients_;
+  std::list<HandlerThread> handler_threads_;  // (and Stop() after the loop)
+  std::shared_ptr<const std::string> metrics_text_;
+  std::shared_ptr<const std::string> metrics_gzip_;  // metrics_text_, encoded on demand
+  uint64_t metrics_version_ = 0;
+  std::chrono::steady_clock::time_point metrics_generated_at_;
+
+  std::mutex completions_mutex_;
+  std::vector<Completion> completions_;
+  int wake_read_ = -1;   // Self-pipe the loop polls (POSIX)
+  int wake_write_ = -1;
+
+  std::atomic<uint64_t> connections_accepted_{0};
+  std::atomic<uint64_t> connections_rejected_{0};
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint64_t> metrics_generated_{0};
+  std::atomic<uint64_t> metrics_cached_{0};
+  std::atomic<uint64_t> gzip_responses_{0};
   
   // Server socket (platform-specific)
   int server_socket_;
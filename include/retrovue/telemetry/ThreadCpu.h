@@ -0,0 +1,45 @@
+// Repository: Retrovue-playout
+// Component: Thread CPU Time
+// Purpose: Reads the CPU time consumed by the calling thread.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_THREAD_CPU_H_
+#define RETROVUE_TELEMETRY_THREAD_CPU_H_
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace retrovue::telemetry {
+
+// CPU time (user + system) of the calling thread in nanoseconds; 0 if the
+// platform cannot tell.
+inline uint64_t ThreadCpuTimeNs() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+    return 0;
+  }
+  const auto ticks = [](const FILETIME& t) {
+    return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+  };
+  return (ticks(kernel) + ticks(user)) * 100;  // 100 ns units
+#else
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_THREAD_CPU_H_
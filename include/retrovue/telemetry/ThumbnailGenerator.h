@@ -0,0 +1,162 @@
+// Repository: Retrovue-playout
+// Component: Thumbnail Generator
+// Purpose: Low-rate per-channel confidence thumbnails served over HTTP.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_THUMBNAIL_GENERATOR_H_
+#define RETROVUE_TELEMETRY_THUMBNAIL_GENERATOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "retrovue/buffer/FramePool.h"
+
+namespace retrovue::telemetry {
+
+struct HttpRequest;
+struct HttpResponse;
+class ThumbnailGenerator;
+
+// ThumbnailConfig sets how often and how large channel thumbnails are.
+struct ThumbnailConfig {
+  std::chrono::milliseconds interval{5000};  // Time between thumbnails of a channel
+  int max_width = 320;                       // Thumbnails fit in this box, aspect kept
+  int max_height = 180;
+  int quality = 75;                          // JPEG quality, 1 (smallest) to 100 (best)
+};
+
+// Thumbnail is the newest image of a channel.
+struct Thumbnail {
+  std::shared_ptr<const std::string> image;  // Encoded file (shared with HTTP responses)
+  std::string content_type;                  // "image/jpeg" ("image/bmp" without FFmpeg)
+  int width = 0;
+  int height = 0;
+  int64_t pts = 0;                           // Of the frame it shows
+  std::chrono::system_clock::time_point captured;
+};
+
+// ThumbnailStats counts the generator's work.
+struct ThumbnailStats {
+  uint64_t generated = 0;
+  uint64_t failed = 0;  // Frames that could not be scaled or encoded
+};
+
+// ThumbnailTap sits on a channel's decoded frame path (the renderer offers
+// it each frame it pops). Offer() costs a clock read and a compare until a
+// thumbnail is due; then it keeps a reference to the pooled frame (no copy)
+// and queues it to the generator. A channel never has more than one frame
+// queued. Thread-safe; holds the generator weakly. Create with
+// ThumbnailGenerator::AddChannel().
+class ThumbnailTap : public std::enable_shared_from_this<ThumbnailTap> {
+ public:
+  ThumbnailTap(std::weak_ptr<ThumbnailGenerator> generator, int32_t channel_id,
+               std::chrono::milliseconds interval);
+
+  // Returns true if frame was taken for a thumbnail.
+  bool Offer(const buffer::FrameHandle& frame);
+
+  int32_t channel_id() const { return channel_id_; }
+
+ private:
+  friend class ThumbnailGenerator;
+
+  const std::weak_ptr<ThumbnailGenerator> generator_;
+  const int32_t channel_id_;
+  const int64_t interval_us_;
+  std::atomic<int64_t> next_due_us_{0};  // steady_clock
+  std::atomic<bool> busy_{false};        // A frame is queued or being encoded
+};
+
+// ThumbnailGenerator turns frames taken by its channel taps into small
+// images on one low-priority worker thread (SCHED_IDLE on Linux): it
+// downscales with the SIMD plane kernels (in 2:1 steps, then to size),
+// releases the frame, and encodes a JPEG (FFmpeg's MJPEG encoder; an
+// uncompressed BMP in builds without FFmpeg). The newest image of each
+// channel is kept for GetThumbnail() and GET /thumbnail/{channel}.
+//
+// Thread Model: every method is thread-safe. Create with
+// std::make_shared (taps hold the generator weakly); Stop() drops queued
+// frames.
+class ThumbnailGenerator : public std::enable_shared_from_this<ThumbnailGenerator> {
+ public:
+  explicit ThumbnailGenerator(const ThumbnailConfig& config);
+  ~ThumbnailGenerator();
+
+  ThumbnailGenerator(const ThumbnailGenerator&) = delete;
+  ThumbnailGenerator& operator=(const ThumbnailGenerator&) = delete;
+
+  bool Start();
+  void Stop();
+
+  // Tap for a channel's frames; its first thumbnail is taken at once.
+  std::shared_ptr<ThumbnailTap> AddChannel(int32_t channel_id);
+
+  // Forgets a channel's thumbnail (its tap stops producing new ones once
+  // released).
+  void RemoveChannel(int32_t channel_id);
+
+  // Newest thumbnail of a channel; false if it has none yet.
+  bool GetThumbnail(int32_t channel_id, Thumbnail& thumbnail) const;
+
+  // MetricsHTTPServer handler for /thumbnail/{channel}.
+  bool ServeHttp(const HttpRequest& request, HttpResponse& response) const;
+
+  ThumbnailStats GetStats() const;
+
+ private:
+  friend class ThumbnailTap;
+
+  struct Job {
+    std::shared_ptr<ThumbnailTap> tap;
+    buffer::FrameHandle frame;
+  };
+
+  // Queues a frame taken by a tap; false if the generator is not running.
+  bool Enqueue(std::shared_ptr<ThumbnailTap> tap, const buffer::FrameHandle& frame);
+
+  void WorkerLoop();
+
+  // Scales a frame (any pixel format, GPU surfaces read back) into scaled_
+  // as I420 at thumbnail size; false if the frame is empty or short.
+  bool ScaleFrame(const buffer::Frame& frame, int& width, int& height);
+
+  // Encodes scaled_ into thumbnail.
+  bool Encode(int width, int height, Thumbnail& thumbnail);
+
+  const ThumbnailConfig config_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<Job> queue_;
+  bool stop_ = false;
+  std::thread worker_;
+  std::atomic<bool> running_{false};
+
+  mutable std::mutex thumbnails_mutex_;
+  std::unordered_map<int32_t, Thumbnail> thumbnails_;
+  std::unordered_map<int32_t, std::weak_ptr<ThumbnailTap>> taps_;
+
+  // Worker-only scratch (GPU frames read back, frames converted to packed
+  // I420, scaled I420 and the 2:1 steps towards it)
+  buffer::Frame downloaded_;
+  std::vector<uint8_t> packed_;
+  std::vector<uint8_t> scaled_;
+  std::vector<uint8_t> step_a_;
+  std::vector<uint8_t> step_b_;
+
+  std::atomic<uint64_t> generated_{0};
+  std::atomic<uint64_t> failed_{0};
+};
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_THUMBNAIL_GENERATOR_H_
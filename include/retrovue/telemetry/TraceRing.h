@@ -0,0 +1,169 @@
+// Repository: Retrovue-playout
+// Component: Trace Ring
+// Purpose: Per-thread binary event rings for stall forensics, dumped as Chrome trace JSON.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_TRACE_RING_H_
+#define RETROVUE_TELEMETRY_TRACE_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace retrovue::telemetry {
+
+struct HttpRequest;
+struct HttpResponse;
+
+enum class TraceEventType : uint8_t {
+  kBegin,    // Scope opened
+  kEnd,      // Scope closed
+  kCounter,  // Value sample
+  kInstant,  // Point event
+};
+
+// TraceEvent is one recorded event. name must be a string literal (only the
+// pointer is stored).
+struct TraceEvent {
+  int64_t ts_ns = 0;  // steady_clock
+  const char* name = nullptr;
+  int64_t value = 0;  // Counters only
+  TraceEventType type = TraceEventType::kInstant;
+};
+
+// TraceConfig sizes a tracing session.
+struct TraceConfig {
+  size_t events_per_thread = 16384;  // Rounded up to a power of two; the newest are kept
+};
+
+// TraceStats counts a tracing session's events.
+struct TraceStats {
+  bool enabled = false;
+  uint64_t threads = 0;      // Threads that recorded an event
+  uint64_t recorded = 0;
+  uint64_t overwritten = 0;  // Lost to ring wraparound
+};
+
+// TraceRing holds one thread's events: the thread appends with relaxed
+// stores and never waits; Snapshot() may run on any thread at the same time
+// and drops events overwritten while it read. Created by the tracer on a
+// thread's first event of a session.
+class TraceRing {
+ public:
+  TraceRing(size_t capacity, uint64_t session, int64_t tid, std::string thread_name);
+
+  TraceRing(const TraceRing&) = delete;
+  TraceRing& operator=(const TraceRing&) = delete;
+
+  // Owner thread only.
+  void Push(TraceEventType type, const char* name, int64_t value, int64_t ts_ns);
+
+  // The events still in the ring, oldest first.
+  std::vector<TraceEvent> Snapshot() const;
+
+  uint64_t recorded() const { return head_.load(std::memory_order_acquire); }
+  size_t capacity() const { return mask_ + 1; }
+  uint64_t session() const { return session_; }
+  int64_t tid() const { return tid_; }
+  const std::string& thread_name() const { return thread_name_; }
+
+ private:
+  struct Slot {
+    std::atomic<int64_t> ts_ns{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> value{0};
+    std::atomic<uint8_t> type{0};
+  };
+
+  const size_t mask_;
+  const uint64_t session_;
+  const int64_t tid_;
+  const std::string thread_name_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> head_{0};  // Events ever pushed
+};
+
+namespace trace_internal {
+
+extern std::atomic<bool> g_enabled;
+
+// Appends to the calling thread's ring (creating it on the thread's first
+// event of the session).
+void Record(TraceEventType type, const char* name, int64_t value);
+
+}  // namespace trace_internal
+
+// True while a tracing session runs. One relaxed load: the only cost of a
+// trace point while tracing is off.
+inline bool TraceEnabled() { return trace_internal::g_enabled.load(std::memory_order_relaxed); }
+
+// Starts a tracing session, discarding the previous session's events.
+void StartTracing(const TraceConfig& config = TraceConfig());
+
+// Stops recording; the session's events stay available to DumpTraceJson().
+void StopTracing();
+
+TraceStats GetTraceStats();
+
+// The session's events in Chrome trace event JSON (chrome://tracing,
+// ui.perfetto.dev). Timestamps are microseconds since the session started;
+// scope ends whose begin was overwritten are left out.
+std::string DumpTraceJson();
+
+// MetricsHTTPServer handler for /trace: /trace/start?events=N starts a
+// session, /trace/stop stops it, /trace/status reports TraceStats, and
+// /trace returns DumpTraceJson().
+bool ServeTraceHttp(const HttpRequest& request, HttpResponse& response);
+
+// TraceScope records a scope's begin and end. A scope opened while tracing
+// was off stays unrecorded even if tracing starts before it closes.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name) : name_(TraceEnabled() ? name : nullptr) {
+    if (name_) {
+      trace_internal::Record(TraceEventType::kBegin, name_, 0);
+    }
+  }
+
+  ~TraceScope() {
+    if (name_) {
+      trace_internal::Record(TraceEventType::kEnd, name_, 0);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* const name_;
+};
+
+}  // namespace retrovue::telemetry
+
+#define RETROVUE_TRACE_CONCAT_INNER(a, b) a##b
+#define RETROVUE_TRACE_CONCAT(a, b) RETROVUE_TRACE_CONCAT_INNER(a, b)
+
+// Trace points; names must be string literals.
+#define RETROVUE_TRACE_SCOPE(name) \
+  ::retrovue::telemetry::TraceScope RETROVUE_TRACE_CONCAT(retrovue_trace_scope_, __LINE__)(name)
+
+#define RETROVUE_TRACE_COUNTER(name, value)                                                    \
+  do {                                                                                         \
+    if (::retrovue::telemetry::TraceEnabled()) {                                               \
+      ::retrovue::telemetry::trace_internal::Record(                                           \
+          ::retrovue::telemetry::TraceEventType::kCounter, name, static_cast<int64_t>(value)); \
+    }                                                                                          \
+  } while (0)
+
+#define RETROVUE_TRACE_INSTANT(name)                                 \
+  do {                                                               \
+    if (::retrovue::telemetry::TraceEnabled()) {                     \
+      ::retrovue::telemetry::trace_internal::Record(                 \
+          ::retrovue::telemetry::TraceEventType::kInstant, name, 0); \
+    }                                                                \
+  } while (0)
+
+#endif  // RETROVUE_TELEMETRY_TRACE_RING_H_
@@ -0,0 +1,81 @@
+// Repository: Retrovue-playout
+// Component: Windowed Histogram
+// Purpose: HDR histogram with lock-free recording and 1m / 5m sliding views.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_TELEMETRY_WINDOWED_HISTOGRAM_H_
+#define RETROVUE_TELEMETRY_WINDOWED_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "retrovue/telemetry/HdrHistogram.h"
+
+namespace retrovue::telemetry {
+
+// Views of a WindowedHistogram at one point in time.
+struct HistogramViews {
+  HdrHistogram total;     // Since construction (or Reset)
+  HdrHistogram last_1m;
+  HdrHistogram last_5m;
+};
+
+// WindowedHistogram keeps a running HdrHistogram plus a ring of 15 s slot
+// histograms covering the last five minutes, so stats can report both
+// lifetime and recent percentiles in fixed memory (about 450 KiB at the
+// defaults) however long the process runs.
+//
+// Record() is lock-free: the first record of a new slot claims it with a CAS
+// and clears it; records racing that rollover may land in the cleared slot
+// or be dropped from the window (never from the total). Windows are rounded
+// to whole slots and include the current, partial one.
+//
+// Thread Model: Record() from any number of threads; views from any thread.
+class WindowedHistogram {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::chrono::seconds kSlotWidth{15};
+  static constexpr std::size_t kSlots = 21;  // 5 min of full slots + the current one
+
+  explicit WindowedHistogram(int64_t highest_value = 60'000'000, int significant_digits = 2);
+
+  WindowedHistogram(const WindowedHistogram&) = delete;
+  WindowedHistogram& operator=(const WindowedHistogram&) = delete;
+
+  void Record(int64_t value) { RecordAt(value, Clock::now()); }
+  void RecordAt(int64_t value, Clock::time_point now);
+
+  // Values recorded over the last `span` (at most five minutes).
+  HdrHistogram Window(std::chrono::seconds span) const { return WindowAt(span, Clock::now()); }
+  HdrHistogram WindowAt(std::chrono::seconds span, Clock::time_point now) const;
+
+  HdrHistogram Total() const { return total_; }
+
+  HistogramViews Views() const { return ViewsAt(Clock::now()); }
+  HistogramViews ViewsAt(Clock::time_point now) const;
+
+  void Reset();
+
+ private:
+  struct Slot {
+    Slot(int64_t highest_value, int significant_digits)
+        : histogram(highest_value, significant_digits) {}
+
+    std::atomic<int64_t> interval{-1};  // Slot number the counts belong to
+    HdrHistogram histogram;
+  };
+
+  int64_t IntervalOf(Clock::time_point now) const;
+
+  const Clock::time_point origin_;
+  HdrHistogram total_;
+  std::array<std::unique_ptr<Slot>, kSlots> slots_;
+};
+
+}  // namespace retrovue::telemetry
+
+#endif  // RETROVUE_TELEMETRY_WINDOWED_HISTOGRAM_H_
@@ -0,0 +1,101 @@
+#ifndef RETROVUE_TIMING_DEADLINE_SCHEDULER_H_
+#define RETROVUE_TIMING_DEADLINE_SCHEDULER_H_
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace retrovue::timing {
+
+// DeadlineSchedulerStats is a point-in-time view of a DeadlineScheduler.
+struct DeadlineSchedulerStats {
+  WaitAccuracyStats accuracy;    // Lateness of each timer's dispatch
+  uint64_t timers_scheduled = 0;
+  uint64_t timers_fired = 0;
+  uint64_t timers_cancelled = 0;
+  uint64_t wakeups = 0;          // Worker thread wake-ups
+  uint64_t batches = 0;          // Dispatches (timers due together fire as one)
+  uint64_t max_batch = 0;        // Most timers fired in one dispatch
+  size_t pending = 0;            // Timers not yet fired
+  int64_t handoff_us = 0;        // Calibrated wake-up latency of WaitUntil() callers
+};
+
+// DeadlineScheduler is the process-wide timer service for frame deadlines:
+// a few worker threads (optionally pinned to CPUs) keep a hierarchical
+// timer wheel each and run callbacks at their deadlines (UTC microseconds,
+// the MasterClock timeline), so channels no longer each time their own
+// waits with separate sleeps and spins.
+//
+// A worker sleeps until the earliest timer of its wheel is close, then
+// spins to it and fires every timer due by then in one batch. A deadline
+// goes to shard (deadline / tick_us) % threads, so timers of different
+// channels in the same tick share a wheel and a wake-up.
+//
+// Wheel: 256 ticks at level 0, then 64 x 256 and 64 x 16384 ticks at
+// levels 1 and 2 (cascaded down as time reaches them), and an overflow
+// list beyond that (about 4.7 hours at the default 1 ms tick).
+//
+// Callbacks run on a worker thread and must be short; a callback that
+// blocks delays every later timer of its shard. Stop() fires the timers
+// still pending at once, so nothing waits on a stopped scheduler.
+//
+// Thread Model: ScheduleAt(), Cancel(), WaitUntil() and GetStats() from any
+// thread; Start() and Stop() from the owning thread.
+class DeadlineScheduler {
+ public:
+  using TimerId = uint64_t;
+  using Callback = std::function<void()>;
+
+  struct Config {
+    size_t threads = 2;
+    std::vector<int> cpus;                // Worker i is pinned to cpus[i % size] (empty = unpinned)
+    int64_t tick_us = 1'000;              // Wheel resolution
+    int64_t spin_us = kDefaultWaitSpinUs; // Busy-wait before each dispatch (0 = sleep only)
+    int priority = 0;                     // SCHED_FIFO priority of the workers (0 = normal)
+  };
+
+  explicit DeadlineScheduler(const Config& config);
+  ~DeadlineScheduler();
+
+  DeadlineScheduler(const DeadlineScheduler&) = delete;
+  DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+  bool Start();
+  void Stop();
+  bool running() const { return running_.load(std::memory_order_acquire); }
+
+  // Runs callback on a worker thread at utc_us (at once if it has passed).
+  // Returns 0 if the scheduler is not running.
+  TimerId ScheduleAt(int64_t utc_us, Callback callback);
+
+  // Removes a pending timer. Returns false if it already fired (or is
+  // firing) or was not found.
+  bool Cancel(TimerId id);
+
+  // Blocks the calling thread until utc_us. The scheduler wakes it just
+  // ahead of the deadline (by the calibrated hand-off latency) and the
+  // caller spins the rest; when not running this sleeps on its own.
+  void WaitUntil(int64_t utc_us);
+
+  DeadlineSchedulerStats GetStats() const;
+
+ private:
+  struct Shard;
+
+  void WorkerLoop(Shard& shard);
+
+  const Config config_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<bool> running_{false};
+
+  std::atomic<int64_t> handoff_us_{0};
+};
+
+}  // namespace retrovue::timing
+
+#endif  // RETROVUE_TIMING_DEADLINE_SCHEDULER_H_
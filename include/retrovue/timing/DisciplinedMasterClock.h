@@ -0,0 +1,127 @@
+#ifndef RETROVUE_TIMING_DISCIPLINED_MASTER_CLOCK_H_
+#define RETROVUE_TIMING_DISCIPLINED_MASTER_CLOCK_H_
+
+#include "retrovue/timing/MasterClock.h"
+#include "retrovue/timing/TimeReference.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace retrovue::timing {
+
+// Loop parameters of a DisciplinedMasterClock.
+struct ClockDisciplineConfig {
+  int64_t poll_interval_ms = 1'000;
+  double kp = 0.1;                   // Proportional gain: ppm per us of offset (1/s)
+  double ki = 0.0025;                // Integral gain (1/s^2); kp, ki = critically damped, ~40 s
+  double max_slew_ppm = 500.0;       // Bound on the frequency correction
+  int64_t step_threshold_us = 100'000;  // Larger offsets are stepped, not slewed
+  int64_t lock_threshold_us = 100;   // Offset within which the loop reports locked
+};
+
+// ClockDisciplineStats is a point-in-time view of the discipline loop.
+struct ClockDisciplineStats {
+  uint64_t samples = 0;
+  uint64_t failed_samples = 0;     // Reference could not be read
+  uint64_t steps = 0;              // Phase steps (first sample, large offsets)
+  int64_t offset_us = 0;           // Reference minus this clock at the last sample
+  double frequency_ppm = 0.0;      // Correction applied to the local clock rate
+  bool locked = false;
+};
+
+// DisciplinedMasterClock is the MasterClock of hosts that must agree on
+// time: its now_utc_us() is the local wall clock steered onto a reference
+// (a PTP hardware clock or chrony), so the outputs of several hosts keep the
+// same frame deadlines and PCR timeline without a hardware genlock.
+//
+// A loop thread measures the reference every poll_interval_ms and runs a PI
+// controller on the offset: the correction is slewed (frequency changes of
+// at most max_slew_ppm, so time never jumps and stays monotonic) except on
+// the first sample and after offsets beyond step_threshold_us, where it is
+// stepped. drift_ppm() reports the estimated rate error of the local clock
+// (positive = local fast); it is already applied to now_utc_us(), so
+// scheduled_to_utc_us() maps PTS with rate_ppm alone.
+//
+// Waits go to the local clock (and so to its DeadlineScheduler, if any),
+// converted to its timeline.
+//
+// Thread Model: MasterClock methods and GetStats() from any thread;
+// Start() and Stop() from the owning thread; AddSample() from one thread
+// (the loop thread while running).
+class DisciplinedMasterClock : public MasterClock {
+ public:
+  DisciplinedMasterClock(std::shared_ptr<MasterClock> local,
+                         std::shared_ptr<TimeReference> reference,
+                         const ClockDisciplineConfig& config, int64_t epoch_utc_us = 0,
+                         double rate_ppm = 0.0);
+  ~DisciplinedMasterClock() override;
+
+  DisciplinedMasterClock(const DisciplinedMasterClock&) = delete;
+  DisciplinedMasterClock& operator=(const DisciplinedMasterClock&) = delete;
+
+  // Takes the first measurement (stepping onto the reference) and starts
+  // the loop thread. Returns false if the reference cannot be read; the
+  // clock then follows the local clock.
+  bool Start();
+  void Stop();
+
+  int64_t now_utc_us() const override;
+  double now_monotonic_s() const override;
+  int64_t scheduled_to_utc_us(int64_t pts_us) const override;
+  double drift_ppm() const override;
+  void WaitUntilUtcUs(int64_t target_utc_us) const override;
+  WaitAccuracyStats wait_accuracy() const override;
+  int64_t ToSystemUtcUs(int64_t utc_us) const override;
+
+  // Feeds one measurement to the loop.
+  void AddSample(const TimeReferenceSample& sample);
+
+  void set_epoch_utc_us(int64_t epoch_utc_us) { epoch_utc_us_ = epoch_utc_us; }
+
+  ClockDisciplineStats GetStats() const;
+
+ private:
+  // Correction (us) to add to the local clock at local_utc_us.
+  double CorrectionAt(int64_t local_utc_us) const;
+  void SetCorrection(int64_t base_local_us, double base_us, double frequency_ppm);
+
+  void LoopThread();
+  bool Poll();
+
+  const std::shared_ptr<MasterClock> local_;
+  const std::shared_ptr<TimeReference> reference_;
+  const ClockDisciplineConfig config_;
+  int64_t epoch_utc_us_;
+  const double rate_ppm_;
+
+  // Correction line, published as a seqlock for now_utc_us()
+  mutable std::atomic<uint64_t> correction_seq_{0};
+  std::atomic<int64_t> base_local_us_{0};
+  std::atomic<double> base_correction_us_{0.0};
+  std::atomic<double> frequency_ppm_{0.0};
+
+  // Loop state (AddSample)
+  bool have_sample_ = false;
+  int64_t last_local_us_ = 0;
+  double integral_ppm_ = 0.0;
+  uint64_t samples_since_step_ = 0;
+
+  std::thread loop_thread_;
+  std::mutex loop_mutex_;
+  std::condition_variable loop_cv_;
+  bool stop_ = false;
+
+  std::atomic<uint64_t> samples_{0};
+  std::atomic<uint64_t> failed_samples_{0};
+  std::atomic<uint64_t> steps_{0};
+  std::atomic<int64_t> offset_us_{0};
+  std::atomic<bool> locked_{false};
+};
+
+}  // namespace retrovue::timing
+
+#endif  // RETROVUE_TIMING_DISCIPLINED_MASTER_CLOCK_H_
@@ -1,6 +1,8 @@
 #ifndef RETROVUE_TIMING_MASTER_CLOCK_H_
 #define RETROVUE_TIMING_MASTER_CLOCK_H_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <thread>
@@ -8,6 +10,26 @@
 
 namespace retrovue::timing {
 
+class DeadlineScheduler;
+
+// Default busy-wait budget at the end of SystemMasterClock waits.
+constexpr int64_t kDefaultWaitSpinUs = 50;
+
+// WaitAccuracyStats is a histogram of how late WaitUntilUtcUs() returned
+// (wake-up time minus deadline, in microseconds).
+struct WaitAccuracyStats {
+  static constexpr size_t kBuckets = 8;
+  // Upper bound of each bucket but the last, which holds the rest
+  static constexpr std::array<int64_t, kBuckets - 1> kBucketUpperUs = {1,   5,   10,  50,
+                                                                       100, 500, 1000};
+  uint64_t waits = 0;
+  std::array<uint64_t, kBuckets> buckets{};
+  int64_t late_us_sum = 0;
+  int64_t late_us_max = 0;
+  int64_t spin_budget_us = 0;       // Busy-wait window before each deadline
+  int64_t sleep_overshoot_us = 0;   // Calibrated sleep wake-up lateness, slept off early
+};
+
 // MasterClock provides monotonic and wall-clock time along with PTS to UTC mapping.
 class MasterClock {
  public:
@@ -30,7 +52,8 @@ class MasterClock {
   virtual bool is_fake() const { return false; }
 
   // Blocks until the clock reaches or exceeds target_utc_us.
-  // For real clocks, this uses sleep-based waiting.
+  // For real clocks, this uses sleep-based waiting (SystemMasterClock: an
+  // absolute-deadline sleep and a short spin, see MakeSystemMasterClock).
   // For fake clocks, this blocks on a condition variable that is woken by advance_us().
   // This method respects stop_requested_ patterns in consumers by checking periodically.
   virtual void WaitUntilUtcUs(int64_t target_utc_us) const {
@@ -46,9 +69,44 @@ class MasterClock {
       std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
     }
   }
+
+  // Accuracy of the WaitUntilUtcUs() calls so far (empty if not measured).
+  virtual WaitAccuracyStats wait_accuracy() const { return {}; }
+
+  // Maps a time on this clock to the host's wall clock, the timeline of
+  // DeadlineScheduler timers (the same for SystemMasterClock).
+  virtual int64_t ToSystemUtcUs(int64_t utc_us) const { return utc_us; }
 };
 
-std::shared_ptr<MasterClock> MakeSystemMasterClock(int64_t epoch_utc_us, double rate_ppm);
+// Creates the wall-clock MasterClock. Its WaitUntilUtcUs() sleeps to an
+// absolute deadline (clock_nanosleep(TIMER_ABSTIME)), waking early by its
+// calibrated wake-up lateness plus wait_spin_us, and busy-waits the rest, so
+// waits end within microseconds of the deadline on a loaded host.
+// wait_spin_us = 0 sleeps the whole wait (no spinning, less precise).
+// With a scheduler, waits go through DeadlineScheduler::WaitUntil() while
+// it runs, so the timing of every channel's waits is shared by its threads
+// (wait_spin_us then applies only once it has stopped).
+std::shared_ptr<MasterClock> MakeSystemMasterClock(
+    int64_t epoch_utc_us, double rate_ppm, int64_t wait_spin_us = kDefaultWaitSpinUs,
+    std::shared_ptr<DeadlineScheduler> scheduler = nullptr);
+
+// Creates the clock of an offline (faster than real time) run. Time starts
+// at epoch_utc_us and moves only when a wait asks for a later time: each
+// WaitUntilUtcUs() returns at once with the clock at its target (it never
+// goes back), so a render loop that waits for every frame's deadline runs
+// as fast as frames are decoded and presents each one exactly on time.
+// It is not a fake clock: consumers wait on it instead of sleeping. Not
+// for DeadlineScheduler or TaskExecutor timers, which run on the host's
+// wall clock.
+std::shared_ptr<MasterClock> MakeOfflineMasterClock(int64_t epoch_utc_us);
+
+// Wraps clock so that PTS 0 is due at origin_utc_us: scheduled_to_utc_us()
+// is clock's shifted by a constant (keeping its rate correction); time and
+// waits are clock's own. A channel moved between hosts whose clocks are
+// disciplined to one reference keeps its deadlines, and so its PTS and PCR
+// timeline, by taking the source host's origin.
+std::shared_ptr<MasterClock> MakeTimelineMasterClock(std::shared_ptr<MasterClock> clock,
+                                                     int64_t origin_utc_us);
 }  // namespace retrovue::timing
 
 #endif  // RETROVUE_TIMING_MASTER_CLOCK_H_
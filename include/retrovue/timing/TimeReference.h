@@ -0,0 +1,43 @@
+#ifndef RETROVUE_TIMING_TIME_REFERENCE_H_
+#define RETROVUE_TIMING_TIME_REFERENCE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace retrovue::timing {
+
+// One comparison of the local wall clock with a reference clock.
+struct TimeReferenceSample {
+  int64_t local_utc_us = 0;   // Local wall clock (system_clock) at the comparison
+  int64_t offset_us = 0;      // Reference minus local: positive = local clock behind
+};
+
+// TimeReference measures the local wall clock against an external time
+// source for DisciplinedMasterClock.
+class TimeReference {
+ public:
+  virtual ~TimeReference() = default;
+
+  // Takes one measurement; false if the reference cannot be read now.
+  virtual bool Measure(TimeReferenceSample& sample) = 0;
+
+  // For logs, e.g. "phc:/dev/ptp0".
+  virtual std::string name() const = 0;
+};
+
+// PTP hardware clock of a NIC (disciplined by ptp4l). The local clock is
+// read on both sides of each PHC read; the tightest of a few reads is kept.
+// PTP runs on TAI: tai_offset_s is subtracted (37 s since 2017; 0 for a PHC
+// kept on UTC). Returns nullptr if the device cannot be opened.
+std::shared_ptr<TimeReference> MakePhcTimeReference(const std::string& device,
+                                                    int64_t tai_offset_s = 37);
+
+// chronyd's NTP estimate of the local clock error, read with
+// `chronyc -c tracking` (the "System time" field).
+std::shared_ptr<TimeReference> MakeChronyTimeReference(
+    const std::string& command = "chronyc -c tracking");
+
+}  // namespace retrovue::timing
+
+#endif  // RETROVUE_TIMING_TIME_REFERENCE_H_
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Generates the fixed bench_pipeline corpus: H.264, HEVC and MPEG-2 at
+# SD, HD and 4K, 10 s at 30 fps, as <codec>_<size>.ts.
+# Usage: scripts/generate_bench_corpus.sh [output-dir]   (default bench_corpus)
+# Copyright (c) 2025 RetroVue
+
+set -e
+
+OUT_DIR="${1:-bench_corpus}"
+mkdir -p "$OUT_DIR"
+
+if ! command -v ffmpeg >/dev/null 2>&1; then
+    echo "[ERROR] ffmpeg not found"
+    exit 1
+fi
+
+declare -A SIZES=(
+    [sd]="720x480"
+    [hd]="1920x1080"
+    [4k]="3840x2160"
+)
+declare -A CODECS=(
+    [h264]="-c:v libx264 -preset medium -g 30 -bf 2 -x264-params threads=1"
+    [hevc]="-c:v libx265 -preset medium -g 30 -bf 2 -x265-params pools=none:log-level=error"
+    [mpeg2]="-c:v mpeg2video -q:v 4 -g 15 -bf 2"
+)
+
+for size in sd hd 4k; do
+    for codec in h264 hevc mpeg2; do
+        out="$OUT_DIR/${codec}_${size}.ts"
+        echo "Generating $out"
+        # Single-threaded, bitexact encodes so the corpus is the same everywhere
+        ffmpeg -hide_banner -loglevel error -y \
+            -f lavfi -i "testsrc2=size=${SIZES[$size]}:rate=30:duration=10" \
+            -f lavfi -i "sine=frequency=1000:sample_rate=48000:duration=10" \
+            ${CODECS[$codec]} -pix_fmt yuv420p -threads 1 \
+            -c:a aac -b:a 128k \
+            -fflags +bitexact -flags:v +bitexact -flags:a +bitexact \
+            -f mpegts "$out"
+    done
+done
+
+echo "Corpus written to $OUT_DIR"
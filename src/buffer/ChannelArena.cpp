@@ -0,0 +1,303 @@
+// Repository: Retrovue-playout
+// Component: Channel Arena
+// Purpose: Channel-local allocator for frame and decoded picture memory.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/buffer/ChannelArena.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace retrovue::buffer {
+
+// Sits in the kAlignment bytes in front of every block.
+struct ChannelArena::BlockHeader {
+  ChannelArena* arena;
+  size_t size;     // Rounded payload size
+  size_t mapped;   // Bytes mapped for the block (0 = from operator new)
+  bool shared;     // Mapped from the arena's shared region
+};
+
+namespace {
+
+size_t PageSize() {
+#ifdef __linux__
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 4096;
+#endif
+}
+
+size_t RoundUp(size_t bytes, size_t multiple) {
+  return (bytes + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+std::shared_ptr<ChannelArena> ChannelArena::Create(size_t max_cached_bytes) {
+  return std::shared_ptr<ChannelArena>(new ChannelArena(max_cached_bytes));
+}
+
+std::shared_ptr<ChannelArena> ChannelArena::CreateShared(size_t region_bytes,
+                                                         size_t front_bytes,
+                                                         size_t max_cached_bytes) {
+#ifdef __linux__
+  const size_t page = PageSize();
+  region_bytes = RoundUp(region_bytes, page);
+  const size_t front = RoundUp(front_bytes, page);
+  if (front >= region_bytes) {
+    return nullptr;
+  }
+  const int fd = memfd_create("retrovue-channel", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return nullptr;
+  }
+  // Sealed at its size: a reader's mapping can never lose pages to a truncate
+  void* base = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(region_bytes)) == 0 &&
+      fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0) {
+    base = mmap(nullptr, region_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (base == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+  auto arena = std::shared_ptr<ChannelArena>(new ChannelArena(max_cached_bytes));
+  arena->region_fd_ = fd;
+  arena->region_base_ = static_cast<uint8_t*>(base);
+  arena->region_bytes_ = region_bytes;
+  arena->region_front_ = front;
+  arena->region_free_[front] = region_bytes - front;
+  return arena;
+#else
+  (void)region_bytes;
+  (void)front_bytes;
+  (void)max_cached_bytes;
+  return nullptr;
+#endif
+}
+
+ChannelArena::ChannelArena(size_t max_cached_bytes) : max_cached_bytes_(max_cached_bytes) {}
+
+ChannelArena::~ChannelArena() {
+  // Live blocks keep the arena alive (self_), so only cached blocks are left
+  for (auto& [size, blocks] : free_blocks_) {
+    for (BlockHeader* header : blocks) {
+      UnmapBlock(header);
+    }
+  }
+#ifdef __linux__
+  if (region_base_) {
+    munmap(region_base_, region_bytes_);
+    close(region_fd_);
+  }
+#endif
+}
+
+size_t ChannelArena::RoundedSize(size_t bytes) {
+  bytes = std::max(bytes, kAlignment);
+  if (bytes < kMapThreshold) {
+    return std::bit_ceil(bytes);
+  }
+  return (bytes + kMapThreshold - 1) / kMapThreshold * kMapThreshold;
+}
+
+void* ChannelArena::Allocate(size_t bytes) {
+  if (bytes > std::numeric_limits<size_t>::max() / 2) {
+    return nullptr;
+  }
+  const size_t size = RoundedSize(bytes);
+  BlockHeader* header = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = free_blocks_.find(size);
+    if (found != free_blocks_.end() && !found->second.empty()) {
+      header = found->second.back();
+      found->second.pop_back();
+      stats_.bytes_cached -= size;
+      stats_.reuses++;
+    }
+  }
+  const bool reused = header != nullptr;
+  if (!reused) {
+    header = MapBlock(size);
+    if (!header) {
+      return nullptr;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (live_blocks_++ == 0) {
+    self_ = shared_from_this();
+  }
+  if (!reused) {
+    stats_.allocations++;
+    if (region_base_ && header->mapped > 0 && !header->shared) {
+      stats_.unshared_allocations++;
+    }
+  }
+  stats_.bytes_in_use += size;
+  stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  return reinterpret_cast<uint8_t*>(header) + kAlignment;
+}
+
+void ChannelArena::Free(void* block) {
+  if (!block) {
+    return;
+  }
+  auto* header = reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(block) - kAlignment);
+  ChannelArena* arena = header->arena;
+  // Dropped once the lock is released: the last block may take the arena with it
+  std::shared_ptr<ChannelArena> last;
+  bool cached = false;
+  {
+    std::lock_guard<std::mutex> lock(arena->mutex_);
+    arena->stats_.bytes_in_use -= header->size;
+    if (!arena->stats_.released &&
+        arena->stats_.bytes_cached + header->size <= arena->max_cached_bytes_) {
+      arena->free_blocks_[header->size].push_back(header);
+      arena->stats_.bytes_cached += header->size;
+      cached = true;
+    }
+    if (--arena->live_blocks_ == 0) {
+      last = std::move(arena->self_);
+    }
+  }
+  if (!cached) {
+    arena->UnmapBlock(header);
+  }
+}
+
+void ChannelArena::Trim() {
+  std::map<size_t, std::vector<BlockHeader*>> blocks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks.swap(free_blocks_);
+    stats_.bytes_cached = 0;
+  }
+  for (auto& [size, headers] : blocks) {
+    for (BlockHeader* header : headers) {
+      UnmapBlock(header);
+    }
+  }
+}
+
+void ChannelArena::Release() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.released = true;
+  }
+  Trim();
+}
+
+ChannelArenaStats ChannelArena::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+int64_t ChannelArena::SharedOffset(const void* p) const {
+  const auto* byte = static_cast<const uint8_t*>(p);
+  if (!region_base_ || byte < region_base_ || byte >= region_base_ + region_bytes_) {
+    return -1;
+  }
+  return byte - region_base_;
+}
+
+ChannelArena::BlockHeader* ChannelArena::MapBlock(size_t size) {
+  static_assert(sizeof(BlockHeader) <= kAlignment, "block header must fit in front of a block");
+  void* base = nullptr;
+  size_t mapped = 0;
+  bool shared = false;
+#ifdef __linux__
+  if (size >= kMapThreshold) {
+    mapped = RoundUp(size + kAlignment, PageSize());
+    const int64_t offset = region_base_ ? TakeRegion(mapped) : -1;
+    if (offset >= 0) {
+      base = region_base_ + offset;
+      shared = true;
+    } else {
+      base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED) {
+        return nullptr;
+      }
+    }
+  }
+#endif
+  if (!base) {
+    base = ::operator new(size + kAlignment, std::align_val_t{kAlignment}, std::nothrow);
+    if (!base) {
+      return nullptr;
+    }
+  }
+  auto* header = static_cast<BlockHeader*>(base);
+  header->arena = this;
+  header->size = size;
+  header->mapped = mapped;
+  header->shared = shared;
+  return header;
+}
+
+void ChannelArena::UnmapBlock(BlockHeader* header) {
+#ifdef __linux__
+  if (header->shared) {
+    ReturnRegion(SharedOffset(header), header->mapped);
+    return;
+  }
+  if (header->mapped > 0) {
+    munmap(header, header->mapped);
+    return;
+  }
+#endif
+  ::operator delete(header, std::align_val_t{kAlignment});
+}
+
+int64_t ChannelArena::TakeRegion(size_t bytes) {
+  std::lock_guard<std::mutex> lock(region_mutex_);
+  for (auto it = region_free_.begin(); it != region_free_.end(); ++it) {
+    if (it->second < bytes) {
+      continue;
+    }
+    const size_t offset = it->first;
+    const size_t left = it->second - bytes;
+    region_free_.erase(it);
+    if (left > 0) {
+      region_free_[offset + bytes] = left;
+    }
+    return static_cast<int64_t>(offset);
+  }
+  return -1;
+}
+
+void ChannelArena::ReturnRegion(size_t offset, size_t bytes) {
+#ifdef __linux__
+  // The pages go back to the system; the range reads as zeros until reused
+  fallocate(region_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+            static_cast<off_t>(bytes));
+#endif
+  std::lock_guard<std::mutex> lock(region_mutex_);
+  auto next = region_free_.lower_bound(offset);
+  if (next != region_free_.end() && offset + bytes == next->first) {
+    bytes += next->second;
+    next = region_free_.erase(next);
+  }
+  if (next != region_free_.begin()) {
+    const auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += bytes;
+      return;
+    }
+  }
+  region_free_[offset] = bytes;
+}
+
+}  // namespace retrovue::buffer
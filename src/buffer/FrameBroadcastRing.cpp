@@ -0,0 +1,156 @@
+// Repository: Retrovue-playout
+// Component: Frame Broadcast Ring
+// Purpose: Single-producer, multi-consumer frame fan-out implementation.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/buffer/FrameBroadcastRing.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace retrovue::buffer {
+
+FrameBroadcastRing::FrameBroadcastRing(size_t capacity, size_t max_readers)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      max_readers_(std::max<size_t>(max_readers, 1)),
+      slots_(new FrameHandle[std::max<size_t>(capacity, 1)]),
+      readers_(new ReaderCursor[std::max<size_t>(max_readers, 1)]),
+      write_seq_(0) {
+}
+
+FrameBroadcastRing::~FrameBroadcastRing() {
+  // Unique_ptr handles cleanup; remaining handles return to their pools.
+}
+
+int FrameBroadcastRing::AddReader() {
+  for (size_t i = 0; i < max_readers_; ++i) {
+    ReaderCursor& cursor = readers_[i];
+    bool expected = false;
+    if (!cursor.active.compare_exchange_strong(expected, true,
+                                               std::memory_order_seq_cst)) {
+      continue;  // Cursor in use
+    }
+    // Anchor at the live write position once the producer can see us. Until
+    // then the stale cursor only holds the producer back, which is safe; any
+    // push that ignored this reader has completed before the load below.
+    cursor.read_seq.store(write_seq_.load(std::memory_order_seq_cst),
+                          std::memory_order_release);
+    return static_cast<int>(i);
+  }
+  return kInvalidReader;
+}
+
+void FrameBroadcastRing::RemoveReader(int reader_id) {
+  if (!IsValidReader(reader_id)) {
+    return;
+  }
+  readers_[reader_id].active.store(false, std::memory_order_release);
+}
+
+bool FrameBroadcastRing::Push(FrameHandle&& handle) {
+  if (!handle) {
+    return false;
+  }
+
+  const uint64_t write = write_seq_.load(std::memory_order_relaxed);
+
+  // Check if the slowest reader still needs the slot we would overwrite
+  if (write - MinReadSeq(write) >= capacity_) {
+    return false;  // Buffer full - caller keeps the handle
+  }
+
+  // Replacing the handle drops the ring's reference to the frame every
+  // reader has already moved past.
+  slots_[write % capacity_] = std::move(handle);
+
+  // Publish to readers
+  write_seq_.store(write + 1, std::memory_order_release);
+
+  return true;
+}
+
+bool FrameBroadcastRing::Push(const Frame& frame) {
+  FrameHandle handle = FrameHandle::Adopt(Frame(frame));
+  return Push(std::move(handle));
+}
+
+bool FrameBroadcastRing::Pop(int reader_id, FrameHandle& handle) {
+  if (!IsValidReader(reader_id)) {
+    return false;
+  }
+
+  ReaderCursor& cursor = readers_[reader_id];
+  const uint64_t read = cursor.read_seq.load(std::memory_order_relaxed);
+
+  // Check if this reader has consumed everything
+  if (read == write_seq_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  // Take a new reference; other readers keep theirs.
+  handle = slots_[read % capacity_];
+
+  // Release the slot to the producer
+  cursor.read_seq.store(read + 1, std::memory_order_release);
+
+  return true;
+}
+
+const Frame* FrameBroadcastRing::Peek(int reader_id) const {
+  if (!IsValidReader(reader_id)) {
+    return nullptr;
+  }
+
+  const uint64_t read = readers_[reader_id].read_seq.load(std::memory_order_acquire);
+  if (read == write_seq_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return slots_[read % capacity_].get();
+}
+
+size_t FrameBroadcastRing::Size(int reader_id) const {
+  if (!IsValidReader(reader_id)) {
+    return 0;
+  }
+
+  const uint64_t read = readers_[reader_id].read_seq.load(std::memory_order_acquire);
+  const uint64_t write = write_seq_.load(std::memory_order_acquire);
+  return write > read ? static_cast<size_t>(write - read) : 0;
+}
+
+size_t FrameBroadcastRing::MaxLag() const {
+  const uint64_t write = write_seq_.load(std::memory_order_acquire);
+  return static_cast<size_t>(write - MinReadSeq(write));
+}
+
+bool FrameBroadcastRing::IsFull() const {
+  return MaxLag() >= capacity_;
+}
+
+size_t FrameBroadcastRing::ReaderCount() const {
+  size_t count = 0;
+  for (size_t i = 0; i < max_readers_; ++i) {
+    if (readers_[i].active.load(std::memory_order_acquire)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+bool FrameBroadcastRing::IsValidReader(int reader_id) const {
+  return reader_id >= 0 && static_cast<size_t>(reader_id) < max_readers_ &&
+         readers_[reader_id].active.load(std::memory_order_acquire);
+}
+
+uint64_t FrameBroadcastRing::MinReadSeq(uint64_t write_seq) const {
+  uint64_t min_read = write_seq;
+  for (size_t i = 0; i < max_readers_; ++i) {
+    const ReaderCursor& cursor = readers_[i];
+    if (cursor.active.load(std::memory_order_seq_cst)) {
+      min_read = std::min(min_read, cursor.read_seq.load(std::memory_order_acquire));
+    }
+  }
+  return min_read;
+}
+
+}  // namespace retrovue::buffer
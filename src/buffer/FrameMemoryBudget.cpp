@@ -0,0 +1,60 @@
+// Repository: Retrovue-playout
+// Component: Frame Memory Budget
+// Purpose: Process-wide cap on the frame memory reserved by channel buffers.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/buffer/FrameMemoryBudget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace retrovue::buffer {
+
+size_t DepthForLatency(int64_t latency_ms, double fps) {
+  if (latency_ms <= 0 || fps <= 0.0) {
+    return 1;
+  }
+  return std::max<size_t>(1, static_cast<size_t>(std::ceil(latency_ms * fps / 1000.0)));
+}
+
+FrameMemoryBudget::FrameMemoryBudget(size_t limit_bytes) : limit_bytes_(limit_bytes) {}
+
+bool FrameMemoryBudget::Reserve(size_t bytes) {
+  return Resize(0, bytes);
+}
+
+bool FrameMemoryBudget::Resize(size_t old_bytes, size_t new_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t others = reserved_bytes_ - std::min(old_bytes, reserved_bytes_);
+  if (new_bytes > old_bytes && limit_bytes_ > 0 && others + new_bytes > limit_bytes_) {
+    ++refusals_;
+    return false;
+  }
+  reserved_bytes_ = others + new_bytes;
+  return true;
+}
+
+void FrameMemoryBudget::Release(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  reserved_bytes_ -= std::min(bytes, reserved_bytes_);
+}
+
+size_t FrameMemoryBudget::Available() const {
+  if (limit_bytes_ == 0) {
+    return std::numeric_limits<size_t>::max();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return limit_bytes_ - std::min(reserved_bytes_, limit_bytes_);
+}
+
+FrameMemoryBudgetStats FrameMemoryBudget::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FrameMemoryBudgetStats stats;
+  stats.limit_bytes = limit_bytes_;
+  stats.reserved_bytes = reserved_bytes_;
+  stats.refusals = refusals_;
+  return stats;
+}
+
+}  // namespace retrovue::buffer
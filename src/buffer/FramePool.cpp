@@ -0,0 +1,127 @@
+// Repository: Retrovue-playout
+// Component: Frame Pool
+// Purpose: Preallocated, reference-counted frame storage implementation.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/buffer/FramePool.h"
+
+#include <utility>
+
+namespace retrovue::buffer {
+
+FrameHandle::FrameHandle(const FrameHandle& other) : slot_(other.slot_) {
+  if (slot_) {
+    slot_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other) {
+  if (this != &other) {
+    FrameHandle copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    slot_ = other.slot_;
+    other.slot_ = nullptr;
+  }
+  return *this;
+}
+
+FrameHandle FrameHandle::Adopt(Frame&& frame) {
+  auto* slot = new FrameSlot();
+  slot->frame = std::move(frame);
+  slot->refs.store(1, std::memory_order_relaxed);
+  return FrameHandle(slot);
+}
+
+void FrameHandle::Reset() {
+  FrameSlot* slot = slot_;
+  slot_ = nullptr;
+  if (!slot) {
+    return;
+  }
+  // acq_rel: the releasing thread must observe every write made through
+  // other handles before the slot is recycled.
+  if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    FramePool::Release(slot);
+  }
+}
+
+std::shared_ptr<FramePool> FramePool::Create(size_t slot_count, size_t frame_bytes,
+                                             std::shared_ptr<ChannelArena> arena) {
+  return std::shared_ptr<FramePool>(new FramePool(slot_count, frame_bytes, arena));
+}
+
+FramePool::FramePool(size_t slot_count, size_t frame_bytes,
+                     const std::shared_ptr<ChannelArena>& arena)
+    : exhausted_count_(0) {
+  slots_.reserve(slot_count);
+  free_slots_.reserve(slot_count);
+  for (size_t i = 0; i < slot_count; ++i) {
+    auto slot = std::make_unique<FrameSlot>();
+    slot->frame.data = FrameBytes(FrameAllocator<uint8_t>(arena));
+    slot->frame.data.reserve(frame_bytes);
+    free_slots_.push_back(slot.get());
+    slots_.push_back(std::move(slot));
+  }
+}
+
+void FramePool::ForEachPayload(const std::function<void(void*, size_t)>& visit) {
+  for (auto& slot : slots_) {
+    visit(slot->frame.data.data(), slot->frame.data.capacity());
+  }
+}
+
+FramePool::~FramePool() {
+  // Every slot holds a reference to the pool while in use, so all slots are
+  // free by the time the destructor runs. Unique_ptr handles cleanup.
+}
+
+FrameHandle FramePool::Acquire() {
+  FrameSlot* slot = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    if (!free_slots_.empty()) {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+    }
+  }
+
+  if (!slot) {
+    exhausted_count_.fetch_add(1, std::memory_order_relaxed);
+    return FrameHandle();
+  }
+
+  slot->owner = shared_from_this();
+  slot->refs.store(1, std::memory_order_relaxed);
+  return FrameHandle(slot);
+}
+
+size_t FramePool::Available() const {
+  std::lock_guard<std::mutex> lock(free_mutex_);
+  return free_slots_.size();
+}
+
+void FramePool::Release(FrameSlot* slot) {
+  if (!slot->owner) {
+    // Unpooled slot created by FrameHandle::Adopt().
+    delete slot;
+    return;
+  }
+
+  // Take the pool reference out of the slot first: dropping it may destroy
+  // the pool (and the slot with it), so it must be the last thing we do.
+  std::shared_ptr<FramePool> pool = std::move(slot->owner);
+  slot->frame.surface.reset();  // Back to its decoder now, not when the slot is reused
+  {
+    std::lock_guard<std::mutex> lock(pool->free_mutex_);
+    pool->free_slots_.push_back(slot);
+  }
+}
+
+}  // namespace retrovue::buffer
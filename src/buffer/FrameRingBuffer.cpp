@@ -6,17 +6,91 @@
 #include "retrovue/buffer/FrameRingBuffer.h"
 
 #include <algorithm>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#include <ctime>
+#endif
 
 namespace retrovue::buffer {
 
+namespace {
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "futex waits require a plain 32-bit atomic word");
+
+// Blocks while |word| still holds |expected|, for at most timeout_us.
+// Spurious returns are fine; callers re-check their condition.
+void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeout_us) {
+#if defined(__linux__)
+  struct timespec timeout;
+  timeout.tv_sec = static_cast<time_t>(timeout_us / 1'000'000);
+  timeout.tv_nsec = static_cast<long>((timeout_us % 1'000'000) * 1'000);
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE,
+          expected, &timeout, nullptr, 0);
+#else
+  // Portable fallback: short bounded sleep between re-checks.
+  (void)word;
+  (void)expected;
+  std::this_thread::sleep_for(
+      std::chrono::microseconds(std::min<int64_t>(timeout_us, 200)));
+#endif
+}
+
+void FutexWakeAll(std::atomic<uint32_t>& word) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE,
+          INT_MAX, nullptr, nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+int64_t SteadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Raises |mark| to |value|. Only the owning side writes the mark outside of
+// ResetWaterMarks(), so a plain load/store is sufficient.
+void RaiseTo(std::atomic<uint64_t>& mark, uint64_t value) {
+  if (value > mark.load(std::memory_order_relaxed)) {
+    mark.store(value, std::memory_order_relaxed);
+  }
+}
+
+void LowerTo(std::atomic<uint64_t>& mark, uint64_t value) {
+  if (value < mark.load(std::memory_order_relaxed)) {
+    mark.store(value, std::memory_order_relaxed);
+  }
+}
+
+int64_t MicrosUntil(std::chrono::steady_clock::time_point deadline,
+                    std::chrono::steady_clock::time_point now) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count() + 1;
+}
+}  // namespace
+
 FrameRingBuffer::FrameRingBuffer(size_t capacity)
     : capacity_(capacity + 1),  // +1 to distinguish full from empty
-      buffer_(new Frame[capacity + 1]),
+      buffer_(new VideoSlot[capacity + 1]),
+      depth_limit_(capacity),
       audio_buffer_(new AudioFrame[capacity + 1]),
       write_index_(0),
       read_index_(0),
       audio_write_index_(0),
-      audio_read_index_(0) {
+      audio_read_index_(0),
+      space_waiters_(0),
+      frame_waiters_(0),
+      wake_generation_(0) {
+  consumer_counters_.low_water.store(capacity, std::memory_order_relaxed);
 }
 
 FrameRingBuffer::~FrameRingBuffer() {
@@ -28,19 +102,86 @@ bool FrameRingBuffer::Push(const Frame& frame) {
   const uint32_t next_write = (current_write + 1) % capacity_;
   
   // Check if buffer is full
-  if (next_write == read_index_.load(std::memory_order_acquire)) {
+  const uint32_t read = read_index_.load(std::memory_order_acquire);
+  if (!HasRoom(current_write, read)) {
+    producer_counters_.push_failures.fetch_add(1, std::memory_order_relaxed);
     return false;  // Buffer full
   }
   
   // Copy frame data
-  buffer_[current_write] = frame;
+  VideoSlot& slot = buffer_[current_write];
+  slot.handle.Reset();
+  slot.frame = frame;
+  slot.enqueue_ns = SteadyNowNs();
+  
+  // Update write index
+  write_index_.store(next_write, std::memory_order_release);
+  NotifyFrameWaiters();
+  RecordPush((next_write + capacity_ - read) % capacity_);
+  
+  return true;
+}
+
+bool FrameRingBuffer::Push(FrameHandle&& handle) {
+  if (!handle) {
+    return false;
+  }
+
+  const uint32_t current_write = write_index_.load(std::memory_order_relaxed);
+  const uint32_t next_write = (current_write + 1) % capacity_;
+  
+  // Check if buffer is full
+  const uint32_t read = read_index_.load(std::memory_order_acquire);
+  if (!HasRoom(current_write, read)) {
+    producer_counters_.push_failures.fetch_add(1, std::memory_order_relaxed);
+    return false;  // Buffer full - caller keeps the handle
+  }
+  
+  // Hand over the reference (no payload copy)
+  VideoSlot& slot = buffer_[current_write];
+  slot.handle = std::move(handle);
+  slot.enqueue_ns = SteadyNowNs();
   
   // Update write index
   write_index_.store(next_write, std::memory_order_release);
+  NotifyFrameWaiters();
+  RecordPush((next_write + capacity_ - read) % capacity_);
   
   return true;
 }
 
+size_t FrameRingBuffer::PushBatch(std::span<FrameHandle> frames) {
+  const uint32_t current_write = write_index_.load(std::memory_order_relaxed);
+  const uint32_t read = read_index_.load(std::memory_order_acquire);
+
+  const int64_t now_ns = SteadyNowNs();
+  uint32_t index = current_write;
+  size_t count = 0;
+  while (count < frames.size() && frames[count]) {
+    if (!HasRoom(index, read)) {
+      break;  // Buffer full
+    }
+    const uint32_t next = (index + 1) % capacity_;
+    VideoSlot& slot = buffer_[index];
+    slot.handle = std::move(frames[count]);
+    slot.enqueue_ns = now_ns;
+    ++count;
+    index = next;
+  }
+
+  if (count < frames.size()) {
+    producer_counters_.push_failures.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (count > 0) {
+    write_index_.store(index, std::memory_order_release);
+    NotifyFrameWaiters();
+    for (size_t i = 1; i <= count; ++i) {
+      RecordPush((current_write + i + capacity_ - read) % capacity_);
+    }
+  }
+  return count;
+}
+
 const Frame* FrameRingBuffer::Peek() const {
   const uint32_t current_read = read_index_.load(std::memory_order_acquire);
   
@@ -50,27 +191,165 @@ const Frame* FrameRingBuffer::Peek() const {
   }
   
   // Return pointer to frame (non-destructive read)
-  return &buffer_[current_read];
+  return buffer_[current_read].get();
 }
 
 bool FrameRingBuffer::Pop(Frame& frame) {
   const uint32_t current_read = read_index_.load(std::memory_order_relaxed);
   
   // Check if buffer is empty
-  if (current_read == write_index_.load(std::memory_order_acquire)) {
+  const uint32_t write = write_index_.load(std::memory_order_acquire);
+  if (current_read == write) {
     return false;  // Buffer empty
   }
   
-  // Copy frame data
-  frame = buffer_[current_read];
+  VideoSlot& slot = buffer_[current_read];
+  const uint32_t next_read = (current_read + 1) % capacity_;
+  RecordPop(slot, SteadyNowNs(), (write + capacity_ - next_read) % capacity_);
+  if (slot.handle) {
+    // Pooled frame requested by value: copy out and release the reference.
+    frame = *slot.handle;
+    slot.handle.Reset();
+  } else {
+    // Swap rather than copy; the slot inherits the caller's old payload
+    // storage, which the next Push(const Frame&) reuses.
+    std::swap(frame, slot.frame);
+  }
   
   // Update read index
+  read_index_.store(next_read, std::memory_order_release);
+  NotifySpaceWaiters();
+  
+  return true;
+}
+
+bool FrameRingBuffer::Pop(FrameHandle& handle) {
+  const uint32_t current_read = read_index_.load(std::memory_order_relaxed);
+  
+  // Check if buffer is empty
+  const uint32_t write = write_index_.load(std::memory_order_acquire);
+  if (current_read == write) {
+    return false;  // Buffer empty
+  }
+  
+  VideoSlot& slot = buffer_[current_read];
   const uint32_t next_read = (current_read + 1) % capacity_;
+  RecordPop(slot, SteadyNowNs(), (write + capacity_ - next_read) % capacity_);
+  if (slot.handle) {
+    handle = std::move(slot.handle);
+  } else {
+    handle = FrameHandle::Adopt(std::move(slot.frame));
+  }
+  
+  // Update read index
   read_index_.store(next_read, std::memory_order_release);
+  NotifySpaceWaiters();
   
   return true;
 }
 
+size_t FrameRingBuffer::PeekRange(std::span<const Frame*> out) const {
+  uint32_t index = read_index_.load(std::memory_order_acquire);
+  const uint32_t write = write_index_.load(std::memory_order_acquire);
+
+  size_t count = 0;
+  while (count < out.size() && index != write) {
+    out[count++] = buffer_[index].get();
+    index = (index + 1) % capacity_;
+  }
+  return count;
+}
+
+size_t FrameRingBuffer::PopBatch(std::span<FrameHandle> out) {
+  const uint32_t current_read = read_index_.load(std::memory_order_relaxed);
+  const uint32_t write = write_index_.load(std::memory_order_acquire);
+
+  const int64_t now_ns = SteadyNowNs();
+  uint32_t index = current_read;
+  size_t count = 0;
+  while (count < out.size() && index != write) {
+    VideoSlot& slot = buffer_[index];
+    const uint32_t next = (index + 1) % capacity_;
+    RecordPop(slot, now_ns, (write + capacity_ - next) % capacity_);
+    if (slot.handle) {
+      out[count] = std::move(slot.handle);
+    } else {
+      out[count] = FrameHandle::Adopt(std::move(slot.frame));
+    }
+    ++count;
+    index = (index + 1) % capacity_;
+  }
+
+  if (count > 0) {
+    read_index_.store(index, std::memory_order_release);
+    NotifySpaceWaiters();
+  }
+  return count;
+}
+
+size_t FrameRingBuffer::Discard(size_t count) {
+  const uint32_t current_read = read_index_.load(std::memory_order_relaxed);
+  const size_t available = Size();
+  const size_t dropped = std::min(count, available);
+  AdvanceRead(current_read, dropped);
+  return dropped;
+}
+
+size_t FrameRingBuffer::DiscardUntilPts(int64_t pts) {
+  const uint32_t current_read = read_index_.load(std::memory_order_relaxed);
+  const uint32_t write = write_index_.load(std::memory_order_acquire);
+
+  uint32_t index = current_read;
+  size_t dropped = 0;
+  while (index != write && buffer_[index].get()->metadata.pts < pts) {
+    ++dropped;
+    index = (index + 1) % capacity_;
+  }
+
+  AdvanceRead(current_read, dropped);
+  return dropped;
+}
+
+void FrameRingBuffer::AdvanceRead(uint32_t current_read, size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  // By-value frames stay in their slot for reuse; only pooled references
+  // need releasing so the producer's pool is not starved.
+  uint32_t index = current_read;
+  for (size_t i = 0; i < count; ++i) {
+    buffer_[index].handle.Reset();
+    index = (index + 1) % capacity_;
+  }
+
+  read_index_.store(index, std::memory_order_release);
+  NotifySpaceWaiters();
+  consumer_counters_.frames_discarded.fetch_add(count, std::memory_order_relaxed);
+}
+
+void FrameRingBuffer::RecordPush(size_t depth) {
+  const size_t usable = depth_limit_.load(std::memory_order_relaxed);
+  const size_t bucket =
+      std::min((depth * kOccupancyBuckets - 1) / usable, kOccupancyBuckets - 1);
+
+  producer_counters_.frames_pushed.fetch_add(1, std::memory_order_relaxed);
+  producer_counters_.occupancy_sum.fetch_add(depth, std::memory_order_relaxed);
+  producer_counters_.occupancy_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+  RaiseTo(producer_counters_.high_water, depth);
+}
+
+void FrameRingBuffer::RecordPop(const VideoSlot& slot, int64_t now_ns, size_t depth) {
+  const uint64_t residency_us =
+      now_ns > slot.enqueue_ns ? static_cast<uint64_t>(now_ns - slot.enqueue_ns) / 1000 : 0;
+
+  last_pop_residency_us_ = residency_us;
+  consumer_counters_.frames_popped.fetch_add(1, std::memory_order_relaxed);
+  consumer_counters_.residency_total_us.fetch_add(residency_us, std::memory_order_relaxed);
+  RaiseTo(consumer_counters_.residency_max_us, residency_us);
+  LowerTo(consumer_counters_.low_water, depth);
+}
+
 size_t FrameRingBuffer::Size() const {
   const uint32_t write = write_index_.load(std::memory_order_acquire);
   const uint32_t read = read_index_.load(std::memory_order_acquire);
@@ -90,9 +369,17 @@ bool FrameRingBuffer::IsEmpty() const {
 bool FrameRingBuffer::IsFull() const {
   const uint32_t write = write_index_.load(std::memory_order_acquire);
   const uint32_t read = read_index_.load(std::memory_order_acquire);
-  const uint32_t next_write = (write + 1) % capacity_;
-  
-  return next_write == read;
+  return !HasRoom(write, read);
+}
+
+bool FrameRingBuffer::HasRoom(uint32_t write, uint32_t read) const {
+  const size_t depth = (write + capacity_ - read) % capacity_;
+  return depth < depth_limit_.load(std::memory_order_relaxed);
+}
+
+void FrameRingBuffer::SetDepthLimit(size_t depth) {
+  depth_limit_.store(std::clamp<size_t>(depth, 1, capacity_ - 1), std::memory_order_release);
+  NotifySpaceWaiters();  // A raised limit frees space without a pop
 }
 
 bool FrameRingBuffer::PushAudioFrame(const AudioFrame& audio_frame) {
@@ -144,11 +431,124 @@ const AudioFrame* FrameRingBuffer::PeekAudioFrame() const {
 }
 
 void FrameRingBuffer::Clear() {
+  // Return pooled frames still queued so the producer's pool is not drained.
+  for (size_t i = 0; i < capacity_; ++i) {
+    buffer_[i].handle.Reset();
+  }
+
   // Reset indices - caller must ensure no concurrent access
   write_index_.store(0, std::memory_order_release);
   read_index_.store(0, std::memory_order_release);
   audio_write_index_.store(0, std::memory_order_release);
   audio_read_index_.store(0, std::memory_order_release);
+  NotifySpaceWaiters();
+  ResetWaterMarks();
+}
+
+BufferStats FrameRingBuffer::GetStats() const {
+  BufferStats stats;
+  stats.frames_pushed = producer_counters_.frames_pushed.load(std::memory_order_relaxed);
+  stats.push_failures = producer_counters_.push_failures.load(std::memory_order_relaxed);
+  stats.high_water_frames =
+      static_cast<size_t>(producer_counters_.high_water.load(std::memory_order_relaxed));
+  stats.occupancy_sum_frames = producer_counters_.occupancy_sum.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kOccupancyBuckets; ++i) {
+    stats.occupancy_histogram[i] =
+        producer_counters_.occupancy_histogram[i].load(std::memory_order_relaxed);
+  }
+
+  stats.frames_popped = consumer_counters_.frames_popped.load(std::memory_order_relaxed);
+  stats.frames_discarded = consumer_counters_.frames_discarded.load(std::memory_order_relaxed);
+  stats.residency_total_us =
+      consumer_counters_.residency_total_us.load(std::memory_order_relaxed);
+  stats.residency_max_us = consumer_counters_.residency_max_us.load(std::memory_order_relaxed);
+  // The low mark never exceeds the high mark; before any pop it is still at
+  // its initial value (capacity), so clamp it.
+  stats.low_water_frames = std::min<size_t>(
+      static_cast<size_t>(consumer_counters_.low_water.load(std::memory_order_relaxed)),
+      stats.high_water_frames);
+  return stats;
+}
+
+void FrameRingBuffer::ResetWaterMarks() {
+  // Racy against a concurrent push/pop by design: at worst one sample is
+  // lost, which is acceptable for a diagnostic gauge.
+  const size_t depth = Size();
+  producer_counters_.high_water.store(depth, std::memory_order_relaxed);
+  consumer_counters_.low_water.store(depth, std::memory_order_relaxed);
+  consumer_counters_.residency_max_us.store(0, std::memory_order_relaxed);
+}
+
+bool FrameRingBuffer::WaitForSpace(std::chrono::steady_clock::time_point deadline) {
+  const uint32_t generation = wake_generation_.load(std::memory_order_acquire);
+  space_waiters_.fetch_add(1, std::memory_order_seq_cst);
+
+  bool ready = false;
+  while (true) {
+    const uint32_t observed_read = read_index_.load(std::memory_order_seq_cst);
+    if (HasRoom(write_index_.load(std::memory_order_relaxed), observed_read)) {
+      ready = true;
+      break;
+    }
+    if (wake_generation_.load(std::memory_order_acquire) != generation) {
+      break;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      break;
+    }
+    FutexWait(read_index_, observed_read, MicrosUntil(deadline, now));
+  }
+
+  space_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return ready;
+}
+
+bool FrameRingBuffer::WaitForFrame(std::chrono::steady_clock::time_point deadline) {
+  const uint32_t generation = wake_generation_.load(std::memory_order_acquire);
+  frame_waiters_.fetch_add(1, std::memory_order_seq_cst);
+
+  bool ready = false;
+  while (true) {
+    const uint32_t observed_write = write_index_.load(std::memory_order_seq_cst);
+    if (observed_write != read_index_.load(std::memory_order_relaxed)) {
+      ready = true;
+      break;
+    }
+    if (wake_generation_.load(std::memory_order_acquire) != generation) {
+      break;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      break;
+    }
+    FutexWait(write_index_, observed_write, MicrosUntil(deadline, now));
+  }
+
+  frame_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return ready;
+}
+
+void FrameRingBuffer::WakeWaiters() {
+  wake_generation_.fetch_add(1, std::memory_order_acq_rel);
+  FutexWakeAll(write_index_);
+  FutexWakeAll(read_index_);
+}
+
+void FrameRingBuffer::NotifyFrameWaiters() {
+  // Pairs with the seq_cst increment in WaitForFrame(): either the waiter
+  // sees the new write index, or we see the waiter and wake it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (frame_waiters_.load(std::memory_order_relaxed) != 0) {
+    FutexWakeAll(write_index_);
+  }
+}
+
+void FrameRingBuffer::NotifySpaceWaiters() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (space_waiters_.load(std::memory_order_relaxed) != 0) {
+    FutexWakeAll(read_index_);
+  }
 }
 
 }  // namespace retrovue::buffer
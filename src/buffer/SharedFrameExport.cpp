@@ -0,0 +1,401 @@
+// Repository: Retrovue-playout
+// Component: Shared Frame Export
+// Purpose: Publishes a channel's decoded frames in shared memory for co-located readers.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/buffer/SharedFrameExport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace retrovue::buffer {
+
+namespace {
+
+constexpr size_t kSlotsOffset = (sizeof(SharedFrameHeader) + 63) / 64 * 64;
+constexpr int kAcceptPollMs = 100;
+
+#ifdef __linux__
+bool FillAddress(const std::string& path, struct sockaddr_un* addr) {
+  std::memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+    return false;
+  }
+  std::memcpy(addr->sun_path, path.c_str(), path.size());
+  return true;
+}
+#endif
+
+}  // namespace
+
+size_t SharedFrameExport::FrontBytes(size_t slot_count) {
+  return kSlotsOffset + slot_count * sizeof(SharedFrameSlot);
+}
+
+SharedFrameExport::SharedFrameExport(std::shared_ptr<ChannelArena> arena, int32_t channel_id,
+                                     size_t slot_count)
+    : arena_(std::move(arena)) {
+  slot_count = std::max<size_t>(slot_count, 1);
+  if (!arena_ || arena_->SharedFd() < 0 || arena_->SharedFrontBytes() < FrontBytes(slot_count)) {
+    std::cerr << "[SharedFrameExport] Channel " << channel_id
+              << " frames are not in a shared arena large enough for the export" << std::endl;
+    return;
+  }
+  auto* front = static_cast<uint8_t*>(arena_->SharedFront());
+  header_ = new (front) SharedFrameHeader();
+  slots_ = reinterpret_cast<SharedFrameSlot*>(front + kSlotsOffset);
+  for (size_t i = 0; i < slot_count; ++i) {
+    new (slots_ + i) SharedFrameSlot();
+  }
+  header_->magic = kSharedFrameMagic;
+  header_->version = kSharedFrameVersion;
+  header_->slot_count = static_cast<uint32_t>(slot_count);
+  header_->slot_bytes = sizeof(SharedFrameSlot);
+  header_->region_bytes = arena_->SharedBytes();
+  header_->channel_id = channel_id;
+  header_->published.store(0, std::memory_order_release);
+  held_.resize(slot_count);
+}
+
+SharedFrameExport::~SharedFrameExport() { Stop(); }
+
+bool SharedFrameExport::Publish(const FrameHandle& frame) {
+  if (!header_ || !frame) {
+    return false;
+  }
+  const Frame& source = *frame;
+  const int plane_count = PixelFormatPlanes(source.format);
+  const int64_t data_offset =
+      plane_count > 0 && !source.data.empty() ? arena_->SharedOffset(source.data.data()) : -1;
+  if (data_offset < 0) {
+    not_shared_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  const uint64_t n = next_++;
+  const size_t index = static_cast<size_t>(n % held_.size());
+  SharedFrameSlot& slot = slots_[index];
+  slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  // The frame the slot named may be reused from here; its readers see the
+  // sequence move
+  held_[index] = frame;
+  slot.data_offset = static_cast<uint64_t>(data_offset);
+  for (int i = 0; i < 3; ++i) {
+    const bool used = i < plane_count;
+    slot.plane_offsets[i] = used ? static_cast<uint64_t>(source.Plane(i) - source.data.data()) : 0;
+    slot.strides[i] = used ? source.Stride(i) : 0;
+  }
+  slot.width = source.width;
+  slot.height = source.height;
+  slot.format = static_cast<uint32_t>(source.format);
+  slot.pts = source.metadata.pts;
+  slot.dts = source.metadata.dts;
+  slot.duration = source.metadata.duration;
+  slot.asset_id = static_cast<uint32_t>(source.metadata.asset_id);
+  slot.splice_point = source.metadata.splice_point;
+  slot.asset_start = source.metadata.asset_start;
+  slot.sequence.store(2 * n + 2, std::memory_order_release);
+  header_->published.store(n + 1, std::memory_order_release);
+  published_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool SharedFrameExport::Listen(const std::string& socket_path) {
+#ifdef __linux__
+  std::lock_guard<std::mutex> lock(listen_mutex_);
+  struct sockaddr_un addr;
+  if (!header_ || listen_fd_ >= 0 || !FillAddress(socket_path, &addr)) {
+    return false;
+  }
+  unlink(socket_path.c_str());
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (listen_fd_ < 0 ||
+      bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(listen_fd_, 16) < 0) {
+    std::cerr << "[SharedFrameExport] Failed to listen on " << socket_path << ": "
+              << strerror(errno) << std::endl;
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+      listen_fd_ = -1;
+    }
+    return false;
+  }
+  socket_path_ = socket_path;
+  listening_.store(true, std::memory_order_release);
+  accept_thread_ = std::thread(&SharedFrameExport::AcceptLoop, this);
+  std::cout << "[SharedFrameExport] Channel " << header_->channel_id << " frames on "
+            << socket_path << std::endl;
+  return true;
+#else
+  (void)socket_path;
+  return false;
+#endif
+}
+
+void SharedFrameExport::Stop() {
+#ifdef __linux__
+  std::lock_guard<std::mutex> lock(listen_mutex_);
+  listening_.store(false, std::memory_order_release);
+  if (accept_thread_.joinable()) {
+    accept_thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    unlink(socket_path_.c_str());
+  }
+#endif
+}
+
+void SharedFrameExport::AcceptLoop() {
+#ifdef __linux__
+  while (listening_.load(std::memory_order_acquire)) {
+    struct pollfd ready = {listen_fd_, POLLIN, 0};
+    if (poll(&ready, 1, kAcceptPollMs) <= 0) {
+      continue;
+    }
+    int client_fd;
+    while ((client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+      HandOff(client_fd);
+    }
+  }
+#endif
+}
+
+void SharedFrameExport::HandOff(int client_fd) {
+#ifdef __linux__
+  // Reopened read-only: the reader can map the frames but never write them
+  const std::string self = "/proc/self/fd/" + std::to_string(arena_->SharedFd());
+  const int read_only = open(self.c_str(), O_RDONLY | O_CLOEXEC);
+  if (read_only < 0) {
+    std::cerr << "[SharedFrameExport] Failed to reopen region read-only: " << strerror(errno)
+              << std::endl;
+    close(client_fd);
+    return;
+  }
+
+  // One byte carrying the descriptor
+  char tag = 'F';
+  struct iovec part;
+  part.iov_base = &tag;
+  part.iov_len = 1;
+  alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  std::memset(control, 0, sizeof(control));
+  struct msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &read_only, sizeof(int));
+  if (sendmsg(client_fd, &message, MSG_NOSIGNAL) == 1) {
+    readers_connected_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    std::cerr << "[SharedFrameExport] Failed to pass region to reader: " << strerror(errno)
+              << std::endl;
+  }
+  close(read_only);
+  close(client_fd);
+#else
+  (void)client_fd;
+#endif
+}
+
+SharedFrameExportStats SharedFrameExport::GetStats() const {
+  SharedFrameExportStats stats;
+  stats.published = published_.load(std::memory_order_relaxed);
+  stats.not_shared = not_shared_.load(std::memory_order_relaxed);
+  stats.readers_connected = readers_connected_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+SharedFrameReader::~SharedFrameReader() { Close(); }
+
+bool SharedFrameReader::Connect(const std::string& socket_path) {
+#ifdef __linux__
+  struct sockaddr_un addr;
+  if (!FillAddress(socket_path, &addr)) {
+    return false;
+  }
+  const int socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (socket_fd < 0) {
+    return false;
+  }
+  if (connect(socket_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    std::cerr << "[SharedFrameReader] Failed to connect to " << socket_path << ": "
+              << strerror(errno) << std::endl;
+    close(socket_fd);
+    return false;
+  }
+  char tag = 0;
+  struct iovec part;
+  part.iov_base = &tag;
+  part.iov_len = 1;
+  alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  struct msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  int fd = -1;
+  if (recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC) == 1 && tag == 'F') {
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+      std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+    }
+  }
+  close(socket_fd);
+  return fd >= 0 && Open(fd);
+#else
+  (void)socket_path;
+  return false;
+#endif
+}
+
+bool SharedFrameReader::Open(int fd) {
+  Close();
+#ifdef __linux__
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < kSlotsOffset) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  const size_t bytes = static_cast<size_t>(info.st_size);
+  void* base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  fd_ = fd;
+  base_ = static_cast<const uint8_t*>(base);
+  bytes_ = bytes;
+  const auto* header = reinterpret_cast<const SharedFrameHeader*>(base_);
+  if (header->magic != kSharedFrameMagic || header->version != kSharedFrameVersion ||
+      header->slot_bytes != sizeof(SharedFrameSlot) || header->slot_count == 0 ||
+      SharedFrameExport::FrontBytes(header->slot_count) > bytes_) {
+    std::cerr << "[SharedFrameReader] Not a frame export of this version" << std::endl;
+    Close();
+    return false;
+  }
+  header_ = header;
+  slots_ = reinterpret_cast<const SharedFrameSlot*>(base_ + kSlotsOffset);
+  const uint64_t published = header_->published.load(std::memory_order_acquire);
+  cursor_ = published > 0 ? published - 1 : 0;
+  lost_ = 0;
+  return true;
+#else
+  (void)fd;
+  return false;
+#endif
+}
+
+bool SharedFrameReader::Next(SharedFrameView* view) {
+  if (!header_) {
+    return false;
+  }
+  const uint64_t published = header_->published.load(std::memory_order_acquire);
+  const uint64_t slot_count = header_->slot_count;
+  if (published - cursor_ > slot_count) {
+    lost_ += published - slot_count - cursor_;
+    cursor_ = published - slot_count;
+  }
+  for (; cursor_ < published; ++cursor_, ++lost_) {
+    const SharedFrameSlot& slot = slots_[cursor_ % slot_count];
+    const uint64_t expected = 2 * cursor_ + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+      continue;  // Overwritten since published was read
+    }
+    const uint64_t data_offset = slot.data_offset;
+    uint64_t plane_offsets[3];
+    int strides[3];
+    for (int i = 0; i < 3; ++i) {
+      plane_offsets[i] = slot.plane_offsets[i];
+      strides[i] = slot.strides[i];
+    }
+    SharedFrameView found;
+    found.width = slot.width;
+    found.height = slot.height;
+    const uint32_t format = slot.format;
+    found.metadata.pts = slot.pts;
+    found.metadata.dts = slot.dts;
+    found.metadata.duration = slot.duration;
+    found.metadata.asset_id = static_cast<AssetId>(slot.asset_id);
+    found.metadata.splice_point = slot.splice_point != 0;
+    found.metadata.asset_start = slot.asset_start != 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected ||
+        format > static_cast<uint32_t>(PixelFormat::kP010)) {
+      continue;
+    }
+    found.format = static_cast<PixelFormat>(format);
+
+    // Every plane must lie within the mapping
+    bool inside = found.width > 0 && found.height > 0;
+    for (int i = 0; inside && i < PixelFormatPlanes(found.format); ++i) {
+      const uint64_t start = data_offset + plane_offsets[i];
+      const uint64_t end = start + static_cast<uint64_t>(strides[i]) *
+                                       static_cast<uint64_t>(Frame::PlaneRows(i, found.height));
+      inside = strides[i] > 0 && start >= data_offset && end <= bytes_;
+      found.planes[i] = base_ + start;
+      found.strides[i] = strides[i];
+    }
+    if (!inside) {
+      continue;
+    }
+    found.index = cursor_++;
+    *view = found;
+    return true;
+  }
+  return false;
+}
+
+bool SharedFrameReader::Valid(const SharedFrameView& view) const {
+  if (!header_) {
+    return false;
+  }
+  // Orders the caller's reads of the pixels before the check
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slots_[view.index % header_->slot_count].sequence.load(std::memory_order_relaxed) ==
+         2 * view.index + 2;
+}
+
+void SharedFrameReader::Close() {
+#ifdef __linux__
+  if (base_) {
+    munmap(const_cast<uint8_t*>(base_), bytes_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+#endif
+  fd_ = -1;
+  base_ = nullptr;
+  bytes_ = 0;
+  header_ = nullptr;
+  slots_ = nullptr;
+}
+
+}  // namespace retrovue::buffer
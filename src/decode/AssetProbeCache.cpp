@@ -0,0 +1,196 @@
+// Repository: Retrovue-playout
+// Component: Asset Probe Cache
+// Purpose: Process-wide cache of container probe results keyed by path and mtime.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/AssetProbeCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+#endif
+
+namespace retrovue::decode {
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+namespace {
+
+// Copies what avformat_find_stream_info() filled in for every stream.
+std::shared_ptr<const ProbeSnapshot> CaptureProbe(const AVFormatContext* format_ctx) {
+  auto snapshot = std::make_shared<ProbeSnapshot>();
+  snapshot->start_time = format_ctx->start_time;
+  snapshot->duration = format_ctx->duration;
+  snapshot->bit_rate = format_ctx->bit_rate;
+  snapshot->streams.reserve(format_ctx->nb_streams);
+  for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+    const AVStream* stream = format_ctx->streams[i];
+    std::shared_ptr<AVCodecParameters> codecpar(
+        avcodec_parameters_alloc(),
+        [](AVCodecParameters* par) { avcodec_parameters_free(&par); });
+    if (!codecpar || avcodec_parameters_copy(codecpar.get(), stream->codecpar) < 0) {
+      return nullptr;
+    }
+
+    ProbedStream probed;
+    probed.codecpar = std::move(codecpar);
+    probed.time_base_num = stream->time_base.num;
+    probed.time_base_den = stream->time_base.den;
+    probed.start_time = stream->start_time;
+    probed.duration = stream->duration;
+    probed.nb_frames = stream->nb_frames;
+    probed.avg_frame_rate_num = stream->avg_frame_rate.num;
+    probed.avg_frame_rate_den = stream->avg_frame_rate.den;
+    probed.r_frame_rate_num = stream->r_frame_rate.num;
+    probed.r_frame_rate_den = stream->r_frame_rate.den;
+    snapshot->streams.push_back(std::move(probed));
+  }
+  return snapshot;
+}
+
+// Restores a snapshot onto a freshly opened context. Refuses (leaving the
+// context untouched) unless the container header describes the same streams,
+// since demuxers that add streams while reading cannot be trusted to match.
+bool ApplyProbe(const ProbeSnapshot& snapshot, AVFormatContext* format_ctx) {
+  if ((format_ctx->ctx_flags & AVFMTCTX_NOHEADER) ||
+      format_ctx->nb_streams != snapshot.streams.size()) {
+    return false;
+  }
+  for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+    const AVStream* stream = format_ctx->streams[i];
+    const ProbedStream& probed = snapshot.streams[i];
+    if (stream->codecpar->codec_type != probed.codecpar->codec_type ||
+        stream->codecpar->codec_id != probed.codecpar->codec_id ||
+        stream->time_base.num != probed.time_base_num ||
+        stream->time_base.den != probed.time_base_den) {
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+    AVStream* stream = format_ctx->streams[i];
+    const ProbedStream& probed = snapshot.streams[i];
+    if (avcodec_parameters_copy(stream->codecpar, probed.codecpar.get()) < 0) {
+      return false;
+    }
+    stream->start_time = probed.start_time;
+    stream->duration = probed.duration;
+    stream->nb_frames = probed.nb_frames;
+    stream->avg_frame_rate = AVRational{probed.avg_frame_rate_num, probed.avg_frame_rate_den};
+    stream->r_frame_rate = AVRational{probed.r_frame_rate_num, probed.r_frame_rate_den};
+  }
+  format_ctx->start_time = snapshot.start_time;
+  format_ctx->duration = snapshot.duration;
+  format_ctx->bit_rate = snapshot.bit_rate;
+  return true;
+}
+
+}  // namespace
+#endif
+
+AssetProbeCache& AssetProbeCache::Instance() {
+  static AssetProbeCache instance;
+  return instance;
+}
+
+AssetProbeCache::AssetProbeCache(size_t max_entries)
+    : max_entries_(std::max<size_t>(max_entries, 1)) {}
+
+bool AssetProbeCache::ProbeInput(const std::string& asset_path,
+                                 AVFormatContext* format_ctx) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  AssetStamp stamp;
+  const bool cacheable = KeyframeIndex::StatAsset(asset_path, &stamp);
+  if (cacheable) {
+    std::shared_ptr<const ProbeSnapshot> snapshot = Lookup(asset_path, stamp);
+    if (snapshot) {
+      if (ApplyProbe(*snapshot, format_ctx)) {
+        return true;
+      }
+      // The header disagrees with the cached layout; count a miss instead.
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.hits--;
+      stats_.misses++;
+    }
+  }
+
+  if (avformat_find_stream_info(format_ctx, nullptr) < 0) {
+    return false;
+  }
+  if (cacheable) {
+    std::shared_ptr<const ProbeSnapshot> snapshot = CaptureProbe(format_ctx);
+    if (snapshot) {
+      Insert(asset_path, stamp, std::move(snapshot));
+    }
+  }
+  return true;
+#else
+  (void)asset_path;
+  (void)format_ctx;
+  return false;
+#endif
+}
+
+std::shared_ptr<const ProbeSnapshot> AssetProbeCache::Lookup(
+    const std::string& asset_path, const AssetStamp& stamp) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(asset_path);
+  if (it == entries_.end()) {
+    stats_.misses++;
+    return nullptr;
+  }
+  if (it->second.stamp != stamp) {
+    lru_.erase(it->second.lru_position);
+    entries_.erase(it);
+    stats_.stale++;
+    stats_.misses++;
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+  stats_.hits++;
+  return it->second.snapshot;
+}
+
+void AssetProbeCache::Insert(const std::string& asset_path,
+                             const AssetStamp& stamp,
+                             std::shared_ptr<const ProbeSnapshot> snapshot) {
+  if (!snapshot) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(asset_path);
+  if (it != entries_.end()) {
+    it->second.stamp = stamp;
+    it->second.snapshot = std::move(snapshot);
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    return;
+  }
+
+  while (entries_.size() >= max_entries_) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+  lru_.push_front(asset_path);
+  entries_.emplace(asset_path, Entry{stamp, std::move(snapshot), lru_.begin()});
+}
+
+void AssetProbeCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+}
+
+ProbeCacheStats AssetProbeCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ProbeCacheStats stats = stats_;
+  stats.entries = entries_.size();
+  return stats;
+}
+
+}  // namespace retrovue::decode
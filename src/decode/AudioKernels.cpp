@@ -0,0 +1,280 @@
+// Repository: Retrovue-playout
+// Component: Audio Kernels
+// Purpose: SIMD (AVX2/NEON) kernels for PCM conversion, gain ramping and 5.1 downmix.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/AudioKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "retrovue/decode/PlaneKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RETROVUE_AUDIO_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define RETROVUE_TARGET_AVX2
+#else
+#define RETROVUE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RETROVUE_AUDIO_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace retrovue::decode {
+
+namespace {
+
+constexpr float kS16Scale = 32768.0f;
+constexpr float kS16ToFloat = 1.0f / kS16Scale;
+
+// The vector code keeps the scalar code's operation order and never fuses a
+// multiply-add (see AudioKernels.h).
+
+// ---------------------------------------------------------------------------
+// Scalar
+
+void S16ToFloatScalar(float* dst, const int16_t* src, size_t begin, size_t samples) {
+  for (size_t i = begin; i < samples; ++i) {
+    dst[i] = static_cast<float>(src[i]) * kS16ToFloat;
+  }
+}
+
+inline int16_t ToS16(float sample, float gain) {
+  const float scaled = std::clamp(sample * gain * kS16Scale, -kS16Scale, kS16Scale - 1.0f);
+  return static_cast<int16_t>(std::nearbyint(scaled));
+}
+
+void FloatToS16RampedScalar(int16_t* dst, const float* src, size_t begin_frame, size_t frames,
+                            int channels, float gain, float gain_step) {
+  const size_t stride = static_cast<size_t>(channels);
+  for (size_t frame = begin_frame; frame < frames; ++frame) {
+    const float frame_gain = gain + gain_step * static_cast<float>(frame);
+    for (size_t ch = 0; ch < stride; ++ch) {
+      dst[frame * stride + ch] = ToS16(src[frame * stride + ch], frame_gain);
+    }
+  }
+}
+
+void Downmix51Scalar(float* dst, const float* src, size_t begin_frame, size_t frames,
+                     const DownmixCoefficients& k) {
+  for (size_t frame = begin_frame; frame < frames; ++frame) {
+    const float* in = src + frame * 6;
+    const float fl = in[0], fr = in[1], fc = in[2], sl = in[4], sr = in[5];
+    dst[frame * 2] = k.scale * ((fl + k.center * fc) + k.surround * sl);
+    dst[frame * 2 + 1] = k.scale * ((fr + k.center * fc) + k.surround * sr);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2
+
+#ifdef RETROVUE_AUDIO_KERNELS_X86
+
+RETROVUE_TARGET_AVX2 size_t S16ToFloatAvx2(float* dst, const int16_t* src, size_t samples) {
+  const __m256 scale = _mm256_set1_ps(kS16ToFloat);
+  size_t i = 0;
+  for (; i + 16 <= samples; i += 16) {
+    const __m256i s16 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(s16));
+    const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(s16, 1));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+    _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+  }
+  return i;
+}
+
+// Eight samples of the given frames -> int32, gained, scaled and saturated.
+RETROVUE_TARGET_AVX2 inline __m256i ToS16x8Avx2(const float* in, __m256i frame, float gain,
+                                                float gain_step) {
+  const __m256 frame_gain = _mm256_add_ps(
+      _mm256_set1_ps(gain), _mm256_mul_ps(_mm256_set1_ps(gain_step), _mm256_cvtepi32_ps(frame)));
+  __m256 scaled =
+      _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(in), frame_gain), _mm256_set1_ps(kS16Scale));
+  scaled = _mm256_min_ps(_mm256_max_ps(scaled, _mm256_set1_ps(-kS16Scale)),
+                         _mm256_set1_ps(kS16Scale - 1.0f));
+  return _mm256_cvtps_epi32(scaled);  // Round to nearest even (default MXCSR)
+}
+
+// Mono and stereo only: the frame of each lane follows a fixed pattern.
+RETROVUE_TARGET_AVX2 size_t FloatToS16RampedAvx2(int16_t* dst, const float* src, size_t frames,
+                                                 int channels, float gain, float gain_step) {
+  const size_t samples = frames * static_cast<size_t>(channels);
+  const __m256i lanes = channels == 1 ? _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+                                      : _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+  const __m256i half_step = _mm256_set1_epi32(8 / channels);
+  size_t i = 0;
+  for (; i + 16 <= samples; i += 16) {
+    const __m256i frame =
+        _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i / channels)), lanes);
+    const __m256i a = ToS16x8Avx2(src + i, frame, gain, gain_step);
+    const __m256i b =
+        ToS16x8Avx2(src + i + 8, _mm256_add_epi32(frame, half_step), gain, gain_step);
+    // packs works per 128-bit lane: a0-3 b0-3 a4-7 b4-7 -> a0-7 b0-7
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+  }
+  return i / channels;
+}
+
+RETROVUE_TARGET_AVX2 size_t Downmix51Avx2(float* dst, const float* src, size_t frames,
+                                          const DownmixCoefficients& k) {
+  const __m256i index = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+  const __m256 center = _mm256_set1_ps(k.center);
+  const __m256 surround = _mm256_set1_ps(k.surround);
+  const __m256 scale = _mm256_set1_ps(k.scale);
+  size_t frame = 0;
+  for (; frame + 8 <= frames; frame += 8) {
+    const float* in = src + frame * 6;
+    const __m256 fl = _mm256_i32gather_ps(in, index, 4);
+    const __m256 fr = _mm256_i32gather_ps(in + 1, index, 4);
+    const __m256 fc = _mm256_mul_ps(center, _mm256_i32gather_ps(in + 2, index, 4));
+    const __m256 sl = _mm256_i32gather_ps(in + 4, index, 4);
+    const __m256 sr = _mm256_i32gather_ps(in + 5, index, 4);
+    const __m256 left =
+        _mm256_mul_ps(scale, _mm256_add_ps(_mm256_add_ps(fl, fc), _mm256_mul_ps(surround, sl)));
+    const __m256 right =
+        _mm256_mul_ps(scale, _mm256_add_ps(_mm256_add_ps(fr, fc), _mm256_mul_ps(surround, sr)));
+    // L0 R0 L1 R1 | L4 R4 L5 R5 and L2 R2 L3 R3 | L6 R6 L7 R7
+    const __m256 lo = _mm256_unpacklo_ps(left, right);
+    const __m256 hi = _mm256_unpackhi_ps(left, right);
+    _mm256_storeu_ps(dst + frame * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(dst + frame * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  return frame;
+}
+
+#endif  // RETROVUE_AUDIO_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// NEON
+
+#ifdef RETROVUE_AUDIO_KERNELS_NEON
+
+size_t S16ToFloatNeon(float* dst, const int16_t* src, size_t samples) {
+  size_t i = 0;
+  for (; i + 8 <= samples; i += 8) {
+    const int16x8_t s16 = vld1q_s16(src + i);
+    vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16))), kS16ToFloat));
+    vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(s16)), kS16ToFloat));
+  }
+  return i;
+}
+
+size_t FloatToS16RampedNeon(int16_t* dst, const float* src, size_t frames, int channels,
+                            float gain, float gain_step) {
+  const size_t samples = frames * static_cast<size_t>(channels);
+  static const int32_t kMonoLanes[4] = {0, 1, 2, 3};
+  static const int32_t kStereoLanes[4] = {0, 0, 1, 1};
+  const int32x4_t lanes = vld1q_s32(channels == 1 ? kMonoLanes : kStereoLanes);
+  const int32x4_t half_step = vdupq_n_s32(4 / channels);
+  const float32x4_t base_gain = vdupq_n_f32(gain);
+  const float32x4_t step = vdupq_n_f32(gain_step);
+  const float32x4_t low = vdupq_n_f32(-kS16Scale);
+  const float32x4_t high = vdupq_n_f32(kS16Scale - 1.0f);
+  const auto convert = [&](const float* in, int32x4_t frame) {
+    const float32x4_t frame_gain = vaddq_f32(base_gain, vmulq_f32(step, vcvtq_f32_s32(frame)));
+    float32x4_t scaled = vmulq_n_f32(vmulq_f32(vld1q_f32(in), frame_gain), kS16Scale);
+    scaled = vminq_f32(vmaxq_f32(scaled, low), high);
+    return vqmovn_s32(vcvtnq_s32_f32(scaled));  // Round to nearest even
+  };
+  size_t i = 0;
+  for (; i + 8 <= samples; i += 8) {
+    const int32x4_t frame = vaddq_s32(vdupq_n_s32(static_cast<int32_t>(i / channels)), lanes);
+    const int16x4_t a = convert(src + i, frame);
+    const int16x4_t b = convert(src + i + 4, vaddq_s32(frame, half_step));
+    vst1q_s16(dst + i, vcombine_s16(a, b));
+  }
+  return i / channels;
+}
+
+size_t Downmix51Neon(float* dst, const float* src, size_t frames, const DownmixCoefficients& k) {
+  size_t frame = 0;
+  for (; frame + 4 <= frames; frame += 4) {
+    // Stride-3 loads of two frames each: {FL LFE}, {FR SL}, {FC SR} pairs
+    const float32x4x3_t a = vld3q_f32(src + frame * 6);
+    const float32x4x3_t b = vld3q_f32(src + frame * 6 + 12);
+    const float32x4_t fl = vuzp1q_f32(a.val[0], b.val[0]);
+    const float32x4_t fr = vuzp1q_f32(a.val[1], b.val[1]);
+    const float32x4_t sl = vuzp2q_f32(a.val[1], b.val[1]);
+    const float32x4_t fc = vmulq_n_f32(vuzp1q_f32(a.val[2], b.val[2]), k.center);
+    const float32x4_t sr = vuzp2q_f32(a.val[2], b.val[2]);
+    float32x4x2_t out;
+    out.val[0] = vmulq_n_f32(vaddq_f32(vaddq_f32(fl, fc), vmulq_n_f32(sl, k.surround)), k.scale);
+    out.val[1] = vmulq_n_f32(vaddq_f32(vaddq_f32(fr, fc), vmulq_n_f32(sr, k.surround)), k.scale);
+    vst2q_f32(dst + frame * 2, out);
+  }
+  return frame;
+}
+
+#endif  // RETROVUE_AUDIO_KERNELS_NEON
+
+}  // namespace
+
+void S16ToFloat(float* dst, const int16_t* src, size_t samples) {
+  size_t done = 0;
+  switch (ActiveKernelIsa()) {
+#ifdef RETROVUE_AUDIO_KERNELS_X86
+    case KernelIsa::kAvx2:
+      done = S16ToFloatAvx2(dst, src, samples);
+      break;
+#endif
+#ifdef RETROVUE_AUDIO_KERNELS_NEON
+    case KernelIsa::kNeon:
+      done = S16ToFloatNeon(dst, src, samples);
+      break;
+#endif
+    default:
+      break;
+  }
+  S16ToFloatScalar(dst, src, done, samples);
+}
+
+void FloatToS16Ramped(int16_t* dst, const float* src, size_t frames, int channels, float gain,
+                      float gain_step) {
+  if (channels <= 0) {
+    return;
+  }
+  size_t done = 0;
+  if (channels <= 2) {
+    switch (ActiveKernelIsa()) {
+#ifdef RETROVUE_AUDIO_KERNELS_X86
+      case KernelIsa::kAvx2:
+        done = FloatToS16RampedAvx2(dst, src, frames, channels, gain, gain_step);
+        break;
+#endif
+#ifdef RETROVUE_AUDIO_KERNELS_NEON
+      case KernelIsa::kNeon:
+        done = FloatToS16RampedNeon(dst, src, frames, channels, gain, gain_step);
+        break;
+#endif
+      default:
+        break;
+    }
+  }
+  FloatToS16RampedScalar(dst, src, done, frames, channels, gain, gain_step);
+}
+
+void Downmix51ToStereo(float* dst, const float* src, size_t frames,
+                       const DownmixCoefficients& coefficients) {
+  size_t done = 0;
+  switch (ActiveKernelIsa()) {
+#ifdef RETROVUE_AUDIO_KERNELS_X86
+    case KernelIsa::kAvx2:
+      done = Downmix51Avx2(dst, src, frames, coefficients);
+      break;
+#endif
+#ifdef RETROVUE_AUDIO_KERNELS_NEON
+    case KernelIsa::kNeon:
+      done = Downmix51Neon(dst, src, frames, coefficients);
+      break;
+#endif
+    default:
+      break;
+  }
+  Downmix51Scalar(dst, src, done, frames, coefficients);
+}
+
+}  // namespace retrovue::decode
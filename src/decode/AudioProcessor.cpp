@@ -0,0 +1,280 @@
+// Repository: Retrovue-playout
+// Component: Audio Processor
+// Purpose: In-pipeline 5.1 downmix, loudness measurement and normalization of PCM audio.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/AudioProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "retrovue/decode/AudioKernels.h"
+
+namespace retrovue::decode {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSurroundWeight = 1.41;  // +1.5 dB (BS.1770)
+constexpr double kBinsPerLu = 10.0;
+// Filter state below this is flushed, so silence does not decay into
+// denormals
+constexpr double kDenormalFloor = 1e-25;
+
+double MeanSquareToLufs(double mean_square) {
+  return mean_square > 0.0 ? -0.691 + 10.0 * std::log10(mean_square)
+                           : -std::numeric_limits<double>::infinity();
+}
+
+double DbToGain(double db) {
+  return std::pow(10.0, db / 20.0);
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// LoudnessMeter
+
+void LoudnessMeter::GateHistogram::Add(double mean_square) {
+  const double lufs = MeanSquareToLufs(mean_square);
+  if (lufs < kAbsoluteGateLufs) {
+    return;
+  }
+  const int bin = std::min(kBins - 1, static_cast<int>((lufs - kAbsoluteGateLufs) * kBinsPerLu));
+  counts_[bin]++;
+  energy_[bin] += mean_square;
+}
+
+double LoudnessMeter::GateHistogram::IntegratedLufs() const {
+  uint64_t count = 0;
+  double energy = 0.0;
+  for (int bin = 0; bin < kBins; ++bin) {
+    count += counts_[bin];
+    energy += energy_[bin];
+  }
+  if (count == 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  const double gate = MeanSquareToLufs(energy / static_cast<double>(count)) + kRelativeGateLu;
+  const int first = std::max(0, static_cast<int>((gate - kAbsoluteGateLufs) * kBinsPerLu));
+  count = 0;
+  energy = 0.0;
+  for (int bin = first; bin < kBins; ++bin) {
+    count += counts_[bin];
+    energy += energy_[bin];
+  }
+  return MeanSquareToLufs(energy / static_cast<double>(count));
+}
+
+LoudnessMeter::LoudnessMeter(int sample_rate, int channels, int64_t window_ms)
+    : sample_rate_(sample_rate),
+      channels_(channels),
+      sub_block_frames_(static_cast<size_t>(std::max(1, sample_rate / 10))),
+      weights_(static_cast<size_t>(channels), 1.0),
+      state_(static_cast<size_t>(channels) * 4, 0.0),
+      window_(static_cast<size_t>(std::max<int64_t>(1, window_ms / 100)), 0.0) {
+  if (channels == 6) {
+    weights_[3] = 0.0;  // LFE
+    weights_[4] = kSurroundWeight;
+    weights_[5] = kSurroundWeight;
+  }
+
+  // K-weighting at this sample rate (BS.1770 gives the 48 kHz coefficients;
+  // these are their analog prototypes, bilinear-transformed)
+  const double rate = static_cast<double>(sample_rate);
+  {
+    const double f0 = 1681.974450955533;
+    const double gain_db = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    const double k = std::tan(kPi * f0 / rate);
+    const double vh = std::pow(10.0, gain_db / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+    shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf_.b1 = 2.0 * (k * k - vh) / a0;
+    shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf_.a2 = (1.0 - k / q + k * k) / a0;
+  }
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+    const double k = std::tan(kPi * f0 / rate);
+    const double a0 = 1.0 + k / q + k * k;
+    high_pass_.b0 = 1.0;
+    high_pass_.b1 = -2.0;
+    high_pass_.b2 = 1.0;
+    high_pass_.a1 = 2.0 * (k * k - 1.0) / a0;
+    high_pass_.a2 = (1.0 - k / q + k * k) / a0;
+  }
+}
+
+void LoudnessMeter::Add(const float* samples, size_t frames, double gain_squared) {
+  const size_t stride = static_cast<size_t>(channels_);
+  size_t frame = 0;
+  while (frame < frames) {
+    // Up to the end of the current sub-block
+    const size_t end = std::min(frames, frame + (sub_block_frames_ - sub_block_filled_));
+    double energy = 0.0;
+    for (size_t ch = 0; ch < stride; ++ch) {
+      if (weights_[ch] == 0.0) {
+        continue;
+      }
+      double* z = state_.data() + ch * 4;
+      double channel_energy = 0.0;
+      for (size_t i = frame; i < end; ++i) {
+        // Transposed direct form II, both stages
+        const double x = samples[i * stride + ch];
+        const double s = shelf_.b0 * x + z[0];
+        z[0] = shelf_.b1 * x - shelf_.a1 * s + z[1];
+        z[1] = shelf_.b2 * x - shelf_.a2 * s;
+        const double y = high_pass_.b0 * s + z[2];
+        z[2] = high_pass_.b1 * s - high_pass_.a1 * y + z[3];
+        z[3] = high_pass_.b2 * s - high_pass_.a2 * y;
+        channel_energy += y * y;
+      }
+      for (int j = 0; j < 4; ++j) {
+        if (std::abs(z[j]) < kDenormalFloor) {
+          z[j] = 0.0;
+        }
+      }
+      energy += weights_[ch] * channel_energy;
+    }
+    sub_input_ += energy;
+    sub_output_ += energy * gain_squared;
+    sub_block_filled_ += end - frame;
+    frame = end;
+    if (sub_block_filled_ == sub_block_frames_) {
+      CloseSubBlock();
+    }
+  }
+}
+
+void LoudnessMeter::CloseSubBlock() {
+  const size_t slot = static_cast<size_t>(sub_blocks_ % last_input_.size());
+  last_input_[slot] = sub_input_;
+  last_output_[slot] = sub_output_;
+  sub_blocks_++;
+  sub_input_ = 0.0;
+  sub_output_ = 0.0;
+  sub_block_filled_ = 0;
+  if (sub_blocks_ < last_input_.size()) {
+    return;  // First block still filling
+  }
+
+  const double block_frames = static_cast<double>(sub_block_frames_ * last_input_.size());
+  double input = 0.0;
+  double output = 0.0;
+  for (size_t i = 0; i < last_input_.size(); ++i) {
+    input += last_input_[i];
+    output += last_output_[i];
+  }
+  input /= block_frames;
+  output /= block_frames;
+  momentary_lufs_ = MeanSquareToLufs(input);
+  input_.Add(input);
+  output_.Add(output);
+
+  window_[window_next_] = input;
+  window_next_ = (window_next_ + 1) % window_.size();
+  window_size_ = std::min(window_size_ + 1, window_.size());
+  // Both gates over the window, exactly
+  double energy = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < window_size_; ++i) {
+    if (MeanSquareToLufs(window_[i]) >= kAbsoluteGateLufs) {
+      energy += window_[i];
+      count++;
+    }
+  }
+  if (count == 0) {
+    window_lufs_ = -std::numeric_limits<double>::infinity();
+    return;
+  }
+  const double gate = MeanSquareToLufs(energy / static_cast<double>(count)) + kRelativeGateLu;
+  double gated_energy = 0.0;
+  size_t gated = 0;
+  for (size_t i = 0; i < window_size_; ++i) {
+    const double lufs = MeanSquareToLufs(window_[i]);
+    if (lufs >= kAbsoluteGateLufs && lufs >= gate) {
+      gated_energy += window_[i];
+      gated++;
+    }
+  }
+  window_lufs_ = MeanSquareToLufs(gated_energy / static_cast<double>(gated));
+}
+
+// ---------------------------------------------------------------------------
+// AudioProcessor
+
+AudioProcessor::AudioProcessor(const AudioProcessingConfig& config) : config_(config) {}
+
+bool AudioProcessor::Process(buffer::AudioFrame& frame) {
+  const size_t frames = static_cast<size_t>(std::max(frame.nb_samples, 0));
+  const size_t in_channels = static_cast<size_t>(std::max(frame.channels, 0));
+  if (frames == 0 || in_channels == 0 || frame.sample_rate <= 0 ||
+      frame.data.size() < frames * in_channels * sizeof(int16_t)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.invalid_frames++;
+    return false;
+  }
+  const bool downmix = config_.downmix && in_channels == 6;
+  const size_t out_channels = downmix ? 2 : in_channels;
+  if (!meter_ || meter_->sample_rate() != frame.sample_rate ||
+      meter_->channels() != static_cast<int>(out_channels)) {
+    meter_ = std::make_unique<LoudnessMeter>(frame.sample_rate, static_cast<int>(out_channels),
+                                             config_.window_ms);
+  }
+  scratch_.resize(kChunkFrames * in_channels);
+
+  // In place: a chunk's output never reaches past its own input, which is
+  // in scratch_ by then
+  int16_t* samples = reinterpret_cast<int16_t*>(frame.data.data());
+  const DownmixCoefficients coefficients;
+  for (size_t begin = 0; begin < frames; begin += kChunkFrames) {
+    const size_t count = std::min(kChunkFrames, frames - begin);
+    S16ToFloat(scratch_.data(), samples + begin * in_channels, count * in_channels);
+    if (downmix) {
+      Downmix51ToStereo(scratch_.data(), scratch_.data(), count, coefficients);
+    }
+
+    double next_db = gain_db_;
+    const double window_lufs = meter_->WindowLufs();
+    if (config_.normalize && std::isfinite(window_lufs)) {
+      const double target = std::clamp(config_.target_lufs - window_lufs, -config_.max_cut_db,
+                                       config_.max_boost_db);
+      const double max_step = config_.ramp_db_per_second * static_cast<double>(count) /
+                              static_cast<double>(frame.sample_rate);
+      next_db += std::clamp(target - gain_db_, -max_step, max_step);
+    }
+    const double gain = DbToGain(gain_db_);
+    const double next_gain = DbToGain(next_db);
+    // Mean square of the linear ramp from gain to next_gain
+    meter_->Add(scratch_.data(), count,
+                (gain * gain + gain * next_gain + next_gain * next_gain) / 3.0);
+    FloatToS16Ramped(samples + begin * out_channels, scratch_.data(), count,
+                     static_cast<int>(out_channels), static_cast<float>(gain),
+                     static_cast<float>((next_gain - gain) / static_cast<double>(count)));
+    gain_db_ = next_db;
+  }
+  if (downmix) {
+    frame.channels = 2;
+    frame.data.resize(frames * out_channels * sizeof(int16_t));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.frames++;
+  stats_.downmixed_frames += downmix ? 1 : 0;
+  stats_.integrated_lufs = meter_->OutputIntegratedLufs();
+  stats_.input_integrated_lufs = meter_->IntegratedLufs();
+  stats_.window_lufs = meter_->WindowLufs();
+  stats_.gain_db = gain_db_;
+  return true;
+}
+
+AudioProcessorStats AudioProcessor::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace retrovue::decode
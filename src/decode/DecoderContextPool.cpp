@@ -0,0 +1,187 @@
+// Repository: Retrovue-playout
+// Component: Decoder Context Pool
+// Purpose: Process-wide pool of warm codec and scaler contexts reused across assets.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/DecoderContextPool.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace retrovue::decode {
+
+namespace {
+
+void FreeDecoder(AVCodecContext* ctx) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  avcodec_free_context(&ctx);
+#else
+  (void)ctx;
+#endif
+}
+
+void FreeScaler(SwsContext* ctx) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  sws_freeContext(ctx);
+#else
+  (void)ctx;
+#endif
+}
+
+}  // namespace
+
+DecoderContextPool& DecoderContextPool::Instance() {
+  static DecoderContextPool instance;
+  return instance;
+}
+
+DecoderContextPool::DecoderContextPool(size_t max_idle_decoders, size_t max_idle_scalers)
+    : max_idle_decoders_(max_idle_decoders), max_idle_scalers_(max_idle_scalers) {}
+
+DecoderContextPool::~DecoderContextPool() { Clear(); }
+
+DecoderKey DecoderContextPool::MakeDecoderKey(const AVCodecParameters* codecpar,
+                                              int thread_count,
+                                              DecodeThreadType thread_type) {
+  DecoderKey key;
+  key.thread_count = thread_count;
+  key.thread_type = thread_type;
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  key.codec_id = codecpar->codec_id;
+  key.width = codecpar->width;
+  key.height = codecpar->height;
+  key.pix_fmt = codecpar->format;
+  key.profile = codecpar->profile;
+  // Decoders parse extradata once at open, so only identical parameter sets
+  // (same encoder settings) may share a context.
+  uint64_t hash = 1469598103934665603ull;
+  for (int i = 0; i < codecpar->extradata_size; i++) {
+    hash = (hash ^ codecpar->extradata[i]) * 1099511628211ull;
+  }
+  key.extradata_hash = hash;
+#else
+  (void)codecpar;
+#endif
+  return key;
+}
+
+AVCodecContext* DecoderContextPool::AcquireDecoder(const DecoderKey& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(idle_decoders_.begin(), idle_decoders_.end(),
+                         [&key](const IdleDecoder& idle) { return idle.key == key; });
+  if (it == idle_decoders_.end()) {
+    stats_.decoder_misses++;
+    return nullptr;
+  }
+  AVCodecContext* ctx = it->ctx;
+  idle_decoders_.erase(it);
+  stats_.decoder_hits++;
+  return ctx;
+}
+
+void DecoderContextPool::ReleaseDecoder(const DecoderKey& key, AVCodecContext** ctx) {
+  if (!ctx || !*ctx) {
+    return;
+  }
+  AVCodecContext* released = *ctx;
+  *ctx = nullptr;
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  // Drops queued packets, pending frames and any drain state, so the next
+  // asset starts from its first keyframe.
+  avcodec_flush_buffers(released);
+#endif
+
+  std::vector<AVCodecContext*> evicted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_decoders_.push_front(IdleDecoder{key, released});
+    while (idle_decoders_.size() > max_idle_decoders_) {
+      evicted.push_back(idle_decoders_.back().ctx);
+      idle_decoders_.pop_back();
+      stats_.evictions++;
+    }
+  }
+  // Freeing joins the codec's worker threads; keep it off the lock.
+  for (AVCodecContext* stale : evicted) {
+    FreeDecoder(stale);
+  }
+}
+
+SwsContext* DecoderContextPool::AcquireScaler(const ScalerKey& key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(idle_scalers_.begin(), idle_scalers_.end(),
+                           [&key](const IdleScaler& idle) { return idle.key == key; });
+    if (it != idle_scalers_.end()) {
+      SwsContext* ctx = it->ctx;
+      idle_scalers_.erase(it);
+      stats_.scaler_hits++;
+      return ctx;
+    }
+    stats_.scaler_misses++;
+  }
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  return sws_getContext(key.src_width, key.src_height,
+                        static_cast<AVPixelFormat>(key.src_format), key.dst_width,
+                        key.dst_height, static_cast<AVPixelFormat>(key.dst_format),
+                        key.flags, nullptr, nullptr, nullptr);
+#else
+  return nullptr;
+#endif
+}
+
+void DecoderContextPool::ReleaseScaler(const ScalerKey& key, SwsContext** ctx) {
+  if (!ctx || !*ctx) {
+    return;
+  }
+  SwsContext* released = *ctx;
+  *ctx = nullptr;
+
+  std::vector<SwsContext*> evicted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_scalers_.push_front(IdleScaler{key, released});
+    while (idle_scalers_.size() > max_idle_scalers_) {
+      evicted.push_back(idle_scalers_.back().ctx);
+      idle_scalers_.pop_back();
+      stats_.evictions++;
+    }
+  }
+  for (SwsContext* stale : evicted) {
+    FreeScaler(stale);
+  }
+}
+
+void DecoderContextPool::Clear() {
+  std::list<IdleDecoder> decoders;
+  std::list<IdleScaler> scalers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoders.swap(idle_decoders_);
+    scalers.swap(idle_scalers_);
+  }
+  for (const IdleDecoder& idle : decoders) {
+    FreeDecoder(idle.ctx);
+  }
+  for (const IdleScaler& idle : scalers) {
+    FreeScaler(idle.ctx);
+  }
+}
+
+DecoderPoolStats DecoderContextPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DecoderPoolStats stats = stats_;
+  stats.idle_decoders = idle_decoders_.size();
+  stats.idle_scalers = idle_scalers_.size();
+  return stats;
+}
+
+}  // namespace retrovue::decode
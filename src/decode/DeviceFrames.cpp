@@ -0,0 +1,124 @@
+// Repository: Retrovue-playout
+// Component: Device Frames
+// Purpose: GPU surfaces carried through the frame ring, and the shared devices they live on.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/DeviceFrames.h"
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "retrovue/decode/PlaneKernels.h"
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
+}
+#endif
+
+namespace retrovue::buffer {
+
+DeviceSurface::~DeviceSurface() {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  av_frame_free(&frame);
+#endif
+  if (in_flight) {
+    in_flight->fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace retrovue::buffer
+
+namespace retrovue::decode {
+
+AVBufferRef* AcquireSharedHwDevice(int type, const std::string& device) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  // Opened devices stay open for the life of the process
+  static std::mutex mutex;
+  static std::map<std::pair<int, std::string>, AVBufferRef*> devices;
+  std::lock_guard<std::mutex> lock(mutex);
+  AVBufferRef*& shared = devices[{type, device}];
+  if (!shared &&
+      av_hwdevice_ctx_create(&shared, static_cast<AVHWDeviceType>(type),
+                             device.empty() ? nullptr : device.c_str(), nullptr, 0) < 0) {
+    shared = nullptr;
+    return nullptr;
+  }
+  return av_buffer_ref(shared);
+#else
+  (void)type;
+  (void)device;
+  return nullptr;
+#endif
+}
+
+bool WrapDeviceSurface(const AVFrame* surface, std::shared_ptr<std::atomic<int>> in_flight,
+                       buffer::Frame* frame) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  auto wrapped = std::make_shared<buffer::DeviceSurface>();
+  wrapped->frame = av_frame_clone(surface);
+  if (!wrapped->frame) {
+    return false;
+  }
+  if (in_flight) {
+    in_flight->fetch_add(1, std::memory_order_relaxed);
+    wrapped->in_flight = std::move(in_flight);
+  }
+  frame->Layout(buffer::PixelFormat::kDevice, surface->width, surface->height);
+  frame->surface = std::move(wrapped);
+  return true;
+#else
+  (void)surface;
+  (void)in_flight;
+  (void)frame;
+  return false;
+#endif
+}
+
+const AVFrame* DeviceSurfaceFrame(const buffer::Frame& frame) {
+  if (frame.format != buffer::PixelFormat::kDevice || !frame.surface) {
+    return nullptr;
+  }
+  return frame.surface->frame;
+}
+
+bool DownloadDeviceFrame(const buffer::Frame& frame, buffer::Frame* out) {
+  if (frame.format != buffer::PixelFormat::kDevice) {
+    if (out != &frame) {
+      *out = frame;
+    }
+    return true;
+  }
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  // Held here: laying out frame in place releases its reference
+  const std::shared_ptr<const buffer::DeviceSurface> surface = frame.surface;
+  if (!surface || !surface->frame) {
+    return false;
+  }
+  AVFrame* system = av_frame_alloc();
+  if (!system) {
+    return false;
+  }
+  PlanarImage image;
+  if (av_hwframe_transfer_data(system, surface->frame, 0) < 0 ||
+      !DescribeFrame(system, &image)) {
+    std::cerr << "[DeviceFrames] Failed to download device frame" << std::endl;
+    av_frame_free(&system);
+    return false;
+  }
+  if (out != &frame) {
+    out->metadata = frame.metadata;
+  }
+  CopyToFrame(image, out);
+  av_frame_free(&system);
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace retrovue::decode
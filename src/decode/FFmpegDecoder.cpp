@@ -5,23 +5,31 @@
 
 #include "retrovue/decode/FFmpegDecoder.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <mutex>
+#include <utility>
 
 #ifdef RETROVUE_FFMPEG_AVAILABLE
 // FFmpeg C headers
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
+#include <libavutil/buffer.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/samplefmt.h>
 #include <libavutil/channel_layout.h>
 #include <libavutil/log.h>  // For av_log_set_level
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 #include <libswresample/swresample.h>
 }
 #endif
 
+#include "retrovue/decode/AssetProbeCache.h"
+#include "retrovue/decode/PlaneKernels.h"
+
 namespace retrovue::decode {
 
 #ifndef RETROVUE_FFMPEG_AVAILABLE
@@ -29,12 +37,15 @@ namespace retrovue::decode {
 
 FFmpegDecoder::FFmpegDecoder(const DecoderConfig& config)
     : config_(config),
+      asset_id_(buffer::InternAsset(config.input_uri)),
       format_ctx_(nullptr),
       codec_ctx_(nullptr),
       frame_(nullptr),
       scaled_frame_(nullptr),
       packet_(nullptr),
       sws_ctx_(nullptr),
+      decoder_pooled_(false),
+      io_ctx_(nullptr),
       video_stream_index_(-1),
       eof_reached_(false),
       start_time_(0),
@@ -68,6 +79,7 @@ double FFmpegDecoder::GetVideoDuration() const { return 0.0; }
 bool FFmpegDecoder::FindVideoStream() { return false; }
 bool FFmpegDecoder::FindAudioStream() { return false; }
 bool FFmpegDecoder::InitializeCodec() { return false; }
+bool FFmpegDecoder::OpenCodec(const AVCodec* codec, const AVCodecParameters* codecpar) { return false; }
 bool FFmpegDecoder::InitializeAudioCodec() { return false; }
 bool FFmpegDecoder::InitializeScaler() { return false; }
 bool FFmpegDecoder::InitializeResampler() { return false; }
@@ -75,19 +87,93 @@ bool FFmpegDecoder::ReadAndDecodeFrame(buffer::Frame& output_frame) { return fal
 bool FFmpegDecoder::ReadAndDecodeAudioFrame(buffer::AudioFrame& output_frame) { return false; }
 bool FFmpegDecoder::ConvertFrame(AVFrame* av_frame, buffer::Frame& output_frame) { return false; }
 bool FFmpegDecoder::ConvertAudioFrame(AVFrame* av_frame, buffer::AudioFrame& output_frame) { return false; }
+void FFmpegDecoder::AttachReadAhead() {}
+void FFmpegDecoder::ReleaseReadAhead() {}
 void FFmpegDecoder::UpdateStats(double decode_time_ms) {}
+void FFmpegDecoder::SetDegradation(DecodeDegradation level) { degradation_ = level; }
+void FFmpegDecoder::ApplyDegradation(DecodeDegradation level) {}
+
+int WarmUpDecoding(int target_width, int target_height) {
+  (void)target_width;
+  (void)target_height;
+  return 0;
+}
 
 #else
 // Real implementations when FFmpeg is available
 
+namespace {
+
+void FreeArenaBuffer(void* /*opaque*/, uint8_t* data) { buffer::ChannelArena::Free(data); }
+
+// get_buffer2 that decodes pictures into the channel's arena
+// (AVCodecContext::opaque) rather than FFmpeg's process-wide buffer pools.
+// Decoders that cannot take caller buffers, and hardware frames, keep
+// FFmpeg's allocator.
+int GetArenaBuffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+  auto* arena = static_cast<buffer::ChannelArena*>(ctx->opaque);
+  const auto format = static_cast<AVPixelFormat>(frame->format);
+  const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+  if (!arena || ctx->codec_type != AVMEDIA_TYPE_VIDEO || !desc ||
+      (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) || !(ctx->codec->capabilities & AV_CODEC_CAP_DR1)) {
+    return avcodec_default_get_buffer2(ctx, frame, flags);
+  }
+
+  // The same padded size and aligned rows FFmpeg's own pools give
+  int width = frame->width;
+  int height = frame->height;
+  int linesize_align[AV_NUM_DATA_POINTERS];
+  avcodec_align_dimensions2(ctx, &width, &height, linesize_align);
+  int linesizes[4];
+  if (av_image_fill_linesizes(linesizes, format, width) < 0) {
+    return avcodec_default_get_buffer2(ctx, frame, flags);
+  }
+  ptrdiff_t strides[4];
+  for (int i = 0; i < 4; ++i) {
+    const int align = std::max(linesize_align[i], static_cast<int>(buffer::kFrameAlignment));
+    linesizes[i] = (linesizes[i] + align - 1) / align * align;
+    strides[i] = linesizes[i];
+  }
+  size_t plane_sizes[4];
+  if (av_image_fill_plane_sizes(plane_sizes, format, height, strides) < 0) {
+    return avcodec_default_get_buffer2(ctx, frame, flags);
+  }
+  size_t size = 0;
+  for (size_t plane_size : plane_sizes) {
+    size += plane_size;
+  }
+
+  // Decoders may read a little past the last plane
+  auto* data = static_cast<uint8_t*>(arena->Allocate(size + buffer::kFrameAlignment));
+  if (!data) {
+    return AVERROR(ENOMEM);
+  }
+  frame->buf[0] = av_buffer_create(data, size, FreeArenaBuffer, nullptr, 0);
+  if (!frame->buf[0]) {
+    buffer::ChannelArena::Free(data);
+    return AVERROR(ENOMEM);
+  }
+  av_image_fill_pointers(frame->data, format, height, data, linesizes);
+  for (int i = 0; i < 4; ++i) {
+    frame->linesize[i] = linesizes[i];
+  }
+  frame->extended_data = frame->data;
+  return 0;
+}
+
+}  // namespace
+
 FFmpegDecoder::FFmpegDecoder(const DecoderConfig& config)
     : config_(config),
+      asset_id_(buffer::InternAsset(config.input_uri)),
       format_ctx_(nullptr),
       codec_ctx_(nullptr),
       frame_(nullptr),
       scaled_frame_(nullptr),
       packet_(nullptr),
       sws_ctx_(nullptr),
+      decoder_pooled_(false),
+      io_ctx_(nullptr),
       video_stream_index_(-1),
       eof_reached_(false),
       start_time_(0),
@@ -111,16 +197,21 @@ bool FFmpegDecoder::Open() {
     return false;
   }
 
+  if (config_.read_ahead_bytes > 0) {
+    AttachReadAhead();
+  }
+
   // Open input file
   if (avformat_open_input(&format_ctx_, config_.input_uri.c_str(), nullptr, nullptr) < 0) {
     std::cerr << "[FFmpegDecoder] Failed to open input: " << config_.input_uri << std::endl;
     avformat_free_context(format_ctx_);
     format_ctx_ = nullptr;
+    ReleaseReadAhead();
     return false;
   }
 
-  // Retrieve stream information
-  if (avformat_find_stream_info(format_ctx_, nullptr) < 0) {
+  // Retrieve stream information (cached for assets we have probed before)
+  if (!AssetProbeCache::Instance().ProbeInput(config_.input_uri, format_ctx_)) {
     std::cerr << "[FFmpegDecoder] Failed to find stream info" << std::endl;
     Close();
     return false;
@@ -165,6 +256,17 @@ bool FFmpegDecoder::Open() {
     return false;
   }
 
+  // Start part way in (a channel joining a timeline already under way); the
+  // frames before the offset are due in the past and dropped as late
+  if (config_.start_offset_us > 0) {
+    const int64_t start = format_ctx_->start_time != AV_NOPTS_VALUE ? format_ctx_->start_time : 0;
+    const int64_t target = start + config_.start_offset_us;
+    if (avformat_seek_file(format_ctx_, -1, INT64_MIN, target, target, 0) < 0) {
+      std::cerr << "[FFmpegDecoder] Failed to seek to " << config_.start_offset_us
+                << " us; decoding from the start" << std::endl;
+    }
+  }
+
   // Allocate packet
   packet_ = av_packet_alloc();
   if (!packet_) {
@@ -190,15 +292,36 @@ bool FFmpegDecoder::DecodeNextFrame(buffer::FrameRingBuffer& output_buffer) {
 
   auto start_time = std::chrono::steady_clock::now();
 
-  buffer::Frame output_frame;
-  if (!ReadAndDecodeFrame(output_frame)) {
-    return false;
-  }
+  if (frame_pool_) {
+    // Decode straight into pooled memory. An exhausted pool means every slot
+    // is still queued downstream, so treat it like a full buffer and leave
+    // the packet unread.
+    buffer::FrameHandle handle = frame_pool_->Acquire();
+    if (!handle) {
+      return false;
+    }
+    if (!ReadAndDecodeFrame(*handle)) {
+      return false;
+    }
+    const buffer::FrameHandle tapped = frame_tap_ ? handle : buffer::FrameHandle();
+    if (!output_buffer.Push(std::move(handle))) {
+      stats_.frames_dropped++;
+      return false;  // Buffer full
+    }
+    if (frame_tap_) {
+      frame_tap_(tapped);
+    }
+  } else {
+    buffer::Frame output_frame;
+    if (!ReadAndDecodeFrame(output_frame)) {
+      return false;
+    }
 
-  // Try to push to buffer
-  if (!output_buffer.Push(output_frame)) {
-    stats_.frames_dropped++;
-    return false;  // Buffer full
+    // Try to push to buffer
+    if (!output_buffer.Push(output_frame)) {
+      stats_.frames_dropped++;
+      return false;  // Buffer full
+    }
   }
 
   auto end_time = std::chrono::steady_clock::now();
@@ -213,7 +336,9 @@ bool FFmpegDecoder::DecodeNextFrame(buffer::FrameRingBuffer& output_buffer) {
 void FFmpegDecoder::Close() {
   std::cout << "[FFmpegDecoder] Closing decoder" << std::endl;
 
-  if (sws_ctx_) {
+  if (sws_ctx_ && config_.reuse_decoder_contexts) {
+    DecoderContextPool::Instance().ReleaseScaler(scaler_key_, &sws_ctx_);
+  } else if (sws_ctx_) {
     sws_freeContext(sws_ctx_);
     sws_ctx_ = nullptr;
   }
@@ -242,13 +367,22 @@ void FFmpegDecoder::Close() {
     avcodec_free_context(&audio_codec_ctx_);
   }
 
-  if (codec_ctx_) {
+  if (codec_ctx_ && decoder_pooled_) {
+    // The next asset to take the context starts at full quality, and on
+    // FFmpeg's allocator (pictures still held free into their arena)
+    ApplyDegradation(DecodeDegradation::kNone);
+    codec_ctx_->opaque = nullptr;
+    codec_ctx_->get_buffer2 = avcodec_default_get_buffer2;
+    DecoderContextPool::Instance().ReleaseDecoder(decoder_key_, &codec_ctx_);
+  } else if (codec_ctx_) {
     avcodec_free_context(&codec_ctx_);
   }
+  decoder_pooled_ = false;
 
   if (format_ctx_) {
     avformat_close_input(&format_ctx_);
   }
+  ReleaseReadAhead();
 
   video_stream_index_ = -1;
   audio_stream_index_ = -1;
@@ -329,6 +463,64 @@ bool FFmpegDecoder::InitializeCodec() {
     return false;
   }
 
+  // A warm context from an earlier asset with identical stream parameters
+  // skips avcodec_open2() (thread pool and frame context setup).
+  DecoderContextPool& pool = DecoderContextPool::Instance();
+  decoder_key_ = DecoderContextPool::MakeDecoderKey(
+      codecpar, std::max(config_.max_decode_threads, 0), config_.thread_type);
+  codec_ctx_ = config_.reuse_decoder_contexts ? pool.AcquireDecoder(decoder_key_) : nullptr;
+  if (!codec_ctx_ && !OpenCodec(codec, codecpar)) {
+    return false;
+  }
+  decoder_pooled_ = config_.reuse_decoder_contexts;
+  ApplyDegradation(degradation_);
+  if (config_.arena) {
+    // Frame threads pick the callback up with their next packet
+    codec_ctx_->opaque = config_.arena.get();
+    codec_ctx_->get_buffer2 = GetArenaBuffer;
+  }
+
+  // Allocate frames
+  frame_ = av_frame_alloc();
+  scaled_frame_ = av_frame_alloc();
+  
+  if (!frame_ || !scaled_frame_) {
+    std::cerr << "[FFmpegDecoder] Failed to allocate frames" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void FFmpegDecoder::SetDegradation(DecodeDegradation level) {
+  if (level == degradation_) {
+    return;
+  }
+  degradation_ = level;
+  if (codec_ctx_) {
+    ApplyDegradation(level);
+  }
+}
+
+void FFmpegDecoder::ApplyDegradation(DecodeDegradation level) {
+  // Discard levels are read per packet, so they apply mid-stream
+  const bool fast = level != DecodeDegradation::kNone;
+  codec_ctx_->skip_loop_filter = fast ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+  codec_ctx_->skip_idct = fast ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+  switch (level) {
+    case DecodeDegradation::kKeyframesOnly:
+      codec_ctx_->skip_frame = AVDISCARD_NONKEY;
+      break;
+    case DecodeDegradation::kSkipNonReference:
+      codec_ctx_->skip_frame = AVDISCARD_NONREF;
+      break;
+    default:
+      codec_ctx_->skip_frame = AVDISCARD_DEFAULT;
+      break;
+  }
+}
+
+bool FFmpegDecoder::OpenCodec(const AVCodec* codec, const AVCodecParameters* codecpar) {
   // Allocate codec context
   codec_ctx_ = avcodec_alloc_context3(codec);
   if (!codec_ctx_) {
@@ -346,7 +538,17 @@ bool FFmpegDecoder::InitializeCodec() {
   if (config_.max_decode_threads > 0) {
     codec_ctx_->thread_count = config_.max_decode_threads;
   }
-  codec_ctx_->thread_type = FF_THREAD_FRAME;
+  switch (config_.thread_type) {
+    case DecodeThreadType::kFrame:
+      codec_ctx_->thread_type = FF_THREAD_FRAME;
+      break;
+    case DecodeThreadType::kSlice:
+      codec_ctx_->thread_type = FF_THREAD_SLICE;
+      break;
+    case DecodeThreadType::kAuto:
+      codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+      break;
+  }
 
   // Open codec
   if (avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
@@ -354,15 +556,6 @@ bool FFmpegDecoder::InitializeCodec() {
     return false;
   }
 
-  // Allocate frames
-  frame_ = av_frame_alloc();
-  scaled_frame_ = av_frame_alloc();
-  
-  if (!frame_ || !scaled_frame_) {
-    std::cerr << "[FFmpegDecoder] Failed to allocate frames" << std::endl;
-    return false;
-  }
-
   return true;
 }
 
@@ -377,11 +570,22 @@ bool FFmpegDecoder::InitializeScaler() {
   int dst_height = config_.target_height;
   AVPixelFormat dst_format = AV_PIX_FMT_YUV420P;
 
-  // Create scaler context
-  sws_ctx_ = sws_getContext(
-      src_width, src_height, src_format,
-      dst_width, dst_height, dst_format,
-      SWS_BILINEAR, nullptr, nullptr, nullptr);
+  // Create scaler context (or reuse one another asset left in the pool)
+  scaler_key_.src_width = src_width;
+  scaler_key_.src_height = src_height;
+  scaler_key_.src_format = src_format;
+  scaler_key_.dst_width = dst_width;
+  scaler_key_.dst_height = dst_height;
+  scaler_key_.dst_format = dst_format;
+  scaler_key_.flags = SWS_BILINEAR;
+  if (config_.reuse_decoder_contexts) {
+    sws_ctx_ = DecoderContextPool::Instance().AcquireScaler(scaler_key_);
+  } else {
+    sws_ctx_ = sws_getContext(
+        src_width, src_height, src_format,
+        dst_width, dst_height, dst_format,
+        SWS_BILINEAR, nullptr, nullptr, nullptr);
+  }
 
   if (!sws_ctx_) {
     std::cerr << "[FFmpegDecoder] Failed to create scaler context" << std::endl;
@@ -572,16 +776,18 @@ bool FFmpegDecoder::ReadAndDecodeFrame(buffer::Frame& output_frame) {
     }
 
     // Successfully decoded a frame
-    return ConvertFrame(frame_, output_frame);
+    if (cpu_meter_) {
+      cpu_meter_->Charge(telemetry::CpuStage::kDecode);
+    }
+    const bool converted = ConvertFrame(frame_, output_frame);
+    if (cpu_meter_) {
+      cpu_meter_->Charge(telemetry::CpuStage::kScale);
+    }
+    return converted;
   }
 }
 
 bool FFmpegDecoder::ConvertFrame(AVFrame* av_frame, buffer::Frame& output_frame) {
-  // Scale frame
-  sws_scale(sws_ctx_, 
-            av_frame->data, av_frame->linesize, 0, codec_ctx_->height,
-            scaled_frame_->data, scaled_frame_->linesize);
-
   // Set frame metadata
   output_frame.width = config_.target_width;
   output_frame.height = config_.target_height;
@@ -593,38 +799,24 @@ bool FFmpegDecoder::ConvertFrame(AVFrame* av_frame, buffer::Frame& output_frame)
   // Use duration field (preferred) or fallback to pkt_duration for older FFmpeg versions
   int64_t frame_duration = av_frame->duration != AV_NOPTS_VALUE ? av_frame->duration : av_frame->pkt_duration;
   output_frame.metadata.duration = static_cast<double>(frame_duration) * time_base_;
-  output_frame.metadata.asset_uri = config_.input_uri;
+  output_frame.metadata.asset_id = asset_id_;
 
-  // Copy YUV420 data
+  // Packed YUV420 output
   int y_size = config_.target_width * config_.target_height;
   int uv_size = (config_.target_width / 2) * (config_.target_height / 2);
-  int total_size = y_size + 2 * uv_size;
-
-  output_frame.data.resize(total_size);
-
-  // Copy Y plane
-  uint8_t* dst = output_frame.data.data();
-  for (int y = 0; y < config_.target_height; y++) {
-    memcpy(dst + y * config_.target_width,
-           scaled_frame_->data[0] + y * scaled_frame_->linesize[0],
-           config_.target_width);
-  }
-
-  // Copy U plane
-  dst += y_size;
-  for (int y = 0; y < config_.target_height / 2; y++) {
-    memcpy(dst + y * (config_.target_width / 2),
-           scaled_frame_->data[1] + y * scaled_frame_->linesize[1],
-           config_.target_width / 2);
-  }
-
-  // Copy V plane
-  dst += uv_size;
-  for (int y = 0; y < config_.target_height / 2; y++) {
-    memcpy(dst + y * (config_.target_width / 2),
-           scaled_frame_->data[2] + y * scaled_frame_->linesize[2],
-           config_.target_width / 2);
+  output_frame.data.resize(y_size + 2 * uv_size);
+
+  // yuv420p/nv12 sources at or within 2:1 of the target go straight through
+  // the SIMD plane kernels; everything else is converted by swscale first.
+  PlanarImage image;
+  if (!DescribeFrame(av_frame, &image) ||
+      !CanPackI420(image, config_.target_width, config_.target_height)) {
+    sws_scale(sws_ctx_,
+              av_frame->data, av_frame->linesize, 0, codec_ctx_->height,
+              scaled_frame_->data, scaled_frame_->linesize);
+    DescribeFrame(scaled_frame_, &image);
   }
+  PackI420(image, config_.target_width, config_.target_height, output_frame.data.data());
 
   return true;
 }
@@ -648,6 +840,9 @@ bool FFmpegDecoder::DecodeNextAudioFrame(buffer::FrameRingBuffer& output_buffer)
     stats_.frames_dropped++;
     return false;  // Buffer full
   }
+  if (audio_tap_) {
+    audio_tap_(output_audio_frame);
+  }
 
   return true;
 }
@@ -753,9 +948,36 @@ bool FFmpegDecoder::ConvertAudioFrame(AVFrame* av_frame, buffer::AudioFrame& out
   return true;
 }
 
+void FFmpegDecoder::AttachReadAhead() {
+  auto read_ahead = std::make_unique<ReadAheadFile>(
+      config_.read_ahead_bytes, ReadAheadFile::kDefaultChunkBytes, config_.io_ring);
+  if (!read_ahead->Open(config_.input_uri)) {
+    return;  // Not a local file; libavformat opens it directly
+  }
+  io_ctx_ = read_ahead->CreateIOContext();
+  if (!io_ctx_) {
+    std::cerr << "[FFmpegDecoder] Failed to allocate read-ahead I/O context" << std::endl;
+    return;
+  }
+  read_ahead_ = std::move(read_ahead);
+  format_ctx_->pb = io_ctx_;
+  format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+}
+
+void FFmpegDecoder::ReleaseReadAhead() {
+  ReadAheadFile::FreeIOContext(&io_ctx_);
+  read_ahead_.reset();
+}
+
 void FFmpegDecoder::UpdateStats(double decode_time_ms) {
   stats_.frames_decoded++;
 
+  if (read_ahead_) {
+    const ReadAheadStats io_stats = read_ahead_->GetStats();
+    stats_.read_stalls = io_stats.stalls;
+    stats_.read_stall_seconds = static_cast<double>(io_stats.stall_time_us) / 1'000'000.0;
+  }
+
   // Update average decode time (exponential moving average)
   const double alpha = 0.1;
   stats_.average_decode_time_ms = 
@@ -767,6 +989,48 @@ void FFmpegDecoder::UpdateStats(double decode_time_ms) {
   }
 }
 
+int WarmUpDecoding(int target_width, int target_height) {
+  static std::once_flag network_once;
+  std::call_once(network_once, [] { avformat_network_init(); });
+
+  // Containers and codecs channels are scheduled with
+  for (const char* format : {"mpegts", "mov", "matroska"}) {
+    if (!av_find_input_format(format)) {
+      std::cerr << "[FFmpegDecoder] Demuxer not available: " << format << std::endl;
+    }
+  }
+  int found = 0;
+  for (const AVCodecID codec_id : {AV_CODEC_ID_H264, AV_CODEC_ID_HEVC, AV_CODEC_ID_MPEG2VIDEO,
+                                   AV_CODEC_ID_AAC, AV_CODEC_ID_AC3, AV_CODEC_ID_MP2}) {
+    if (!avcodec_find_decoder(codec_id)) {
+      continue;
+    }
+    ++found;
+    if (AVCodecParserContext* parser = av_parser_init(codec_id)) {
+      av_parser_close(parser);
+    }
+  }
+
+  // Scalers as InitializeScaler() keys them, for 1080p, 720p and SD sources
+  DecoderContextPool& pool = DecoderContextPool::Instance();
+  for (const auto [width, height] : {std::pair{1920, 1080}, std::pair{1280, 720},
+                                     std::pair{720, 480}}) {
+    ScalerKey key;
+    key.src_width = width;
+    key.src_height = height;
+    key.src_format = AV_PIX_FMT_YUV420P;
+    key.dst_width = target_width;
+    key.dst_height = target_height;
+    key.dst_format = AV_PIX_FMT_YUV420P;
+    key.flags = SWS_BILINEAR;
+    SwsContext* scaler = pool.AcquireScaler(key);
+    if (scaler) {
+      pool.ReleaseScaler(key, &scaler);
+    }
+  }
+  return found;
+}
+
 #endif  // RETROVUE_FFMPEG_AVAILABLE
 
 }  // namespace retrovue::decode
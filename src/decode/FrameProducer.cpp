@@ -11,6 +11,9 @@
 #include <cmath>
 #include <iostream>
 #include <thread>
+#include "retrovue/buffer/FrameMemoryBudget.h"
+#include "retrovue/runtime/TaskExecutor.h"
+#include "retrovue/telemetry/ThreadCpu.h"
 #include "retrovue/timing/MasterClock.h"
 
 namespace retrovue::decode {
@@ -18,6 +21,9 @@ namespace retrovue::decode {
 namespace {
 constexpr int64_t kProducerBackoffUs = 10'000;  // MC-004 recovery backoff
 constexpr int64_t kDecoderUnavailableBackoffUs = 100'000;
+// Slots beyond ring capacity: one being filled by the producer and one held
+// by the consumer while it renders or encodes.
+constexpr size_t kFramePoolHeadroom = 2;
 
 inline void WaitUntilUtc(const std::shared_ptr<timing::MasterClock>& clock,
                          int64_t target_utc_us) {
@@ -26,6 +32,10 @@ inline void WaitUntilUtc(const std::shared_ptr<timing::MasterClock>& clock,
   }
 
   // MC-003: adhere to MasterClock pacing rather than wall time.
+  if (!clock->is_fake()) {
+    clock->WaitUntilUtcUs(target_utc_us);  // Absolute sleep + spin (SystemMasterClock)
+    return;
+  }
   while (true) {
     const int64_t now = clock->now_utc_us();
     const int64_t remaining = target_utc_us - now;
@@ -50,13 +60,28 @@ inline void WaitForMicros(const std::shared_ptr<timing::MasterClock>& clock,
   }
   std::this_thread::sleep_for(std::chrono::microseconds(duration_us));
 }
+
+// MC-004: waits for the consumer to free a slot, bounded by the backoff window.
+// Wakes on the consumer's next pop instead of sleeping the whole window. Fake
+// clocks keep clock-driven pacing so deterministic tests stay deterministic.
+inline void WaitForBufferSpace(buffer::FrameRingBuffer& buffer,
+                               const std::shared_ptr<timing::MasterClock>& clock,
+                               int64_t timeout_us) {
+  if (clock && clock->is_fake()) {
+    WaitForMicros(clock, timeout_us);
+    return;
+  }
+  buffer.WaitForSpace(std::chrono::steady_clock::now() +
+                      std::chrono::microseconds(timeout_us));
+}
 }  // namespace
 
 FrameProducer::FrameProducer(const ProducerConfig& config,
                              buffer::FrameRingBuffer& output_buffer,
                              std::shared_ptr<timing::MasterClock> clock)
     : config_(config),
-      output_buffer_(output_buffer),
+      asset_id_(buffer::InternAsset(config.asset_uri)),
+      outputs_{&output_buffer},
       running_(false),
       stop_requested_(false),
       frames_produced_(0),
@@ -67,37 +92,111 @@ FrameProducer::FrameProducer(const ProducerConfig& config,
       stub_pts_counter_(0),
       frame_interval_us_(static_cast<int64_t>(
           std::max(1.0, std::round(1'000'000.0 / config_.target_fps)))),
-      next_stub_deadline_utc_(0) {
+      next_stub_deadline_utc_(0),
+      reported_read_stalls_(0),
+      reported_read_stall_seconds_(0.0) {
+  pool_depth_ = output_buffer.DepthLimit();
+  frame_pool_ = CreateFramePool(pool_depth_);
+  cpu_meter_.SetAccount(config_.cpu_account);
+  // Stub frames start on the frame boundary at or after the start offset
+  if (config_.start_offset_us > 0) {
+    const int64_t frames = (config_.start_offset_us + frame_interval_us_ - 1) / frame_interval_us_;
+    stub_pts_counter_ = frames * frame_interval_us_;
+  }
+}
+
+size_t FrameProducer::FramePoolBytes(const ProducerConfig& config, size_t depth) {
+  return (depth + kFramePoolHeadroom + config.frame_pool_extra_slots) *
+         buffer::Yuv420FrameBytes(config.target_width, config.target_height);
+}
+
+std::shared_ptr<buffer::FramePool> FrameProducer::CreateFramePool(size_t depth) const {
+  auto pool = buffer::FramePool::Create(
+      depth + kFramePoolHeadroom + config_.frame_pool_extra_slots,
+      buffer::Yuv420FrameBytes(config_.target_width, config_.target_height), config_.arena);
+  if (config_.placement.numa_node >= 0) {
+    // Frames are decoded and rendered on the channel's node; keep them there
+    bool bound = true;
+    const int node = config_.placement.numa_node;
+    pool->ForEachPayload([&bound, node](void* data, size_t bytes) {
+      bound = runtime::BindMemoryToNode(data, bytes, node) && bound;
+    });
+    if (!bound) {
+      std::cerr << "[FrameProducer] Cannot bind frame memory to NUMA node " << node << std::endl;
+    }
+  }
+  return pool;
+}
+
+void FrameProducer::MatchPoolToBufferDepth() {
+  const size_t depth = outputs_.front()->DepthLimit();
+  if (depth == pool_depth_) {
+    return;
+  }
+  // Queued frames keep the old pool alive until the consumer releases them
+  frame_pool_ = CreateFramePool(depth);
+  pool_depth_ = depth;
+  if (decoder_) {
+    decoder_->SetFramePool(frame_pool_);
+  }
+  std::cout << "[FrameProducer] Frame pool resized for a depth of " << depth << " frames"
+            << std::endl;
 }
 
 FrameProducer::~FrameProducer() {
   Stop();
 }
 
+void FrameProducer::SetExecutor(std::shared_ptr<runtime::TaskExecutor> executor) {
+  executor_ = std::move(executor);
+}
+
 bool FrameProducer::Start() {
   bool expected = false;
   if (!running_.compare_exchange_strong(expected, true)) {
     return false;  // Already running
   }
+  if (producer_thread_ && producer_thread_->joinable()) {
+    producer_thread_->join();  // Previous run ended on its own (teardown, EOF)
+  }
+  task_loop_.reset();
 
   stop_requested_.store(false, std::memory_order_release);
-  producer_thread_ = std::make_unique<std::thread>(&FrameProducer::ProduceLoop, this);
+  if (executor_ && executor_->running() && master_clock_ && !master_clock_->is_fake()) {
+    task_begun_ = false;
+    task_loop_ = std::make_unique<runtime::TaskLoop>(
+        *executor_, runtime::TaskExecutor::Lane::kWork, [this] { return RunTaskStep(); },
+        [this] { EndProduction(); });
+    if (!task_loop_->Start()) {
+      std::cerr << "[FrameProducer] Executor refused the task chain" << std::endl;
+      task_loop_.reset();
+      return false;
+    }
+  } else {
+    producer_thread_ = std::make_unique<std::thread>(&FrameProducer::ProduceLoop, this);
+  }
 
   std::cout << "[FrameProducer] Started for asset: " << config_.asset_uri << std::endl;
   return true;
 }
 
 void FrameProducer::Stop() {
-  if (!running_.load(std::memory_order_acquire)) {
+  if (!running_.load(std::memory_order_acquire) &&
+      !(producer_thread_ && producer_thread_->joinable()) && !task_loop_) {
     return;  // Not running
   }
 
   std::cout << "[FrameProducer] Stopping..." << std::endl;
   stop_requested_.store(true, std::memory_order_release);
+  WakeOutputs();
 
   if (producer_thread_ && producer_thread_->joinable()) {
     producer_thread_->join();
   }
+  if (task_loop_) {
+    task_loop_->Stop();
+    task_loop_.reset();
+  }
 
   running_.store(false, std::memory_order_release);
   std::cout << "[FrameProducer] Stopped. Total frames produced: " 
@@ -118,10 +217,81 @@ void FrameProducer::RequestTeardown(std::chrono::milliseconds drain_timeout) {
 
 void FrameProducer::ForceStop() {
   stop_requested_.store(true, std::memory_order_release);
+  WakeOutputs();
   std::cout << "[FrameProducer] Force stop requested" << std::endl;
 }
 
+bool FrameProducer::AddOutput(buffer::FrameRingBuffer& ring) {
+  std::lock_guard<std::mutex> lock(outputs_mutex_);
+  if (std::find(outputs_.begin(), outputs_.end(), &ring) != outputs_.end()) {
+    return false;
+  }
+  outputs_.push_back(&ring);
+  return true;
+}
+
+size_t FrameProducer::RemoveOutput(buffer::FrameRingBuffer& ring) {
+  size_t left = 0;
+  {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    outputs_.erase(std::remove(outputs_.begin(), outputs_.end(), &ring), outputs_.end());
+    left = outputs_.size();
+  }
+  // The producer picks its wait buffer under the lock, so it can only still
+  // be parked on ring from before
+  while (waiting_on_.load(std::memory_order_acquire) == &ring) {
+    ring.WakeWaiters();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return left;
+}
+
+size_t FrameProducer::OutputCount() const {
+  std::lock_guard<std::mutex> lock(outputs_mutex_);
+  return outputs_.size();
+}
+
+void FrameProducer::WakeOutputs() {
+  std::lock_guard<std::mutex> lock(outputs_mutex_);
+  for (buffer::FrameRingBuffer* ring : outputs_) {
+    ring->WakeWaiters();
+  }
+}
+
+void FrameProducer::ForwardFrame(const buffer::FrameHandle& frame) {
+  // Each output gets its own picture: sinks composite overlays and stamp
+  // metadata in place. A copy costs a memcpy where a decode would cost a core
+  for (size_t i = 1; i < outputs_.size(); ++i) {
+    if (outputs_[i]->IsFull() || !outputs_[i]->Push(buffer::FrameHandle::Adopt(
+                                     buffer::Frame(*frame)))) {
+      follower_drops_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void FrameProducer::ForwardAudioFrame(const buffer::AudioFrame& frame) {
+  for (size_t i = 1; i < outputs_.size(); ++i) {
+    outputs_[i]->PushAudioFrame(frame);
+  }
+}
+
 void FrameProducer::ProduceLoop() {
+  // Before the decoder opens, so its worker threads inherit the placement
+  // and the name
+  runtime::ApplyChannelPlacement(config_.placement, /*pacing_thread=*/false, "FrameProducer");
+  telemetry::NameCurrentThread(config_.channel_id, "decode");
+  cpu_meter_.Restart();
+  BeginProduction();
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    const Backoff backoff = ProduceStep();
+    cpu_meter_.Charge(telemetry::CpuStage::kDecode);  // What the decoder did not split off
+    Wait(backoff);
+    thread_cpu_ns_.store(telemetry::ThreadCpuTimeNs(), std::memory_order_relaxed);
+  }
+  EndProduction();
+}
+
+void FrameProducer::BeginProduction() {
   std::cout << "[FrameProducer] Decode loop started (stub_mode=" 
             << (config_.stub_mode ? "true" : "false") << ")" << std::endl;
 
@@ -133,8 +303,17 @@ void FrameProducer::ProduceLoop() {
     decoder_config.target_height = config_.target_height;
     decoder_config.hw_accel_enabled = config_.hw_accel_enabled;
     decoder_config.max_decode_threads = config_.max_decode_threads;
+    decoder_config.thread_type = config_.decode_thread_type;
+    decoder_config.read_ahead_bytes = config_.read_ahead_bytes;
+    decoder_config.io_ring = config_.io_ring;
+    decoder_config.arena = config_.arena;
+    decoder_config.start_offset_us = config_.start_offset_us;
 
     decoder_ = std::make_unique<FFmpegDecoder>(decoder_config);
+    decoder_->SetFramePool(frame_pool_);
+    decoder_->SetCpuMeter(&cpu_meter_);
+    decoder_->SetFrameTap([this](const buffer::FrameHandle& frame) { ForwardFrame(frame); });
+    decoder_->SetAudioTap([this](const buffer::AudioFrame& frame) { ForwardAudioFrame(frame); });
     
     if (!decoder_->Open()) {
       std::cerr << "[FrameProducer] Failed to open decoder, falling back to stub mode" 
@@ -145,57 +324,131 @@ void FrameProducer::ProduceLoop() {
       std::cout << "[FrameProducer] FFmpeg decoder initialized successfully" << std::endl;
     }
   }
+}
 
-  // Calculate frame interval based on target FPS (for stub mode)
-  while (!stop_requested_.load(std::memory_order_acquire)) {
-    if (teardown_requested_.load(std::memory_order_acquire)) {
-      const auto now = std::chrono::steady_clock::now();
-      if (now >= teardown_deadline_) {
-        std::cerr << "[FrameProducer] Teardown timeout reached; forcing stop" << std::endl;
-        stop_requested_.store(true, std::memory_order_release);
-        continue;
-      }
+void FrameProducer::EndProduction() {
+  // Cleanup decoder
+  if (decoder_) {
+    decoder_->Close();
+    decoder_.reset();
+  }
 
-      if (output_buffer_.IsEmpty()) {
-        std::cout << "[FrameProducer] Buffer drained; completing teardown" << std::endl;
-        stop_requested_.store(true, std::memory_order_release);
-        continue;
-      }
+  std::cout << "[FrameProducer] Decode loop exited" << std::endl;
+  // Lets RequestTeardown() callers see completion; Stop() still joins
+  running_.store(false, std::memory_order_release);
+}
 
-      WaitForMicros(master_clock_, 1'000);
-      continue;
+FrameProducer::Backoff FrameProducer::ProduceStep() {
+  std::lock_guard<std::mutex> lock(outputs_mutex_);
+  if (outputs_.empty()) {
+    // Every channel let go; idle until stopped
+    if (teardown_requested_.load(std::memory_order_acquire)) {
+      stop_requested_.store(true, std::memory_order_release);
+      return {};
+    }
+    return {Backoff::Kind::kForUs, kProducerBackoffUs};
+  }
+  if (teardown_requested_.load(std::memory_order_acquire)) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= teardown_deadline_) {
+      std::cerr << "[FrameProducer] Teardown timeout reached; forcing stop" << std::endl;
+      stop_requested_.store(true, std::memory_order_release);
+      return {};
     }
 
-    if (config_.stub_mode) {
-      if (master_clock_ && next_stub_deadline_utc_ == 0) {
-        next_stub_deadline_utc_ = master_clock_->now_utc_us();
-      }
-      ProduceStubFrame();
-    } else {
-      ProduceRealFrame();
-      // No artificial delay needed - real decode has its own timing
+    if (outputs_.front()->IsEmpty()) {
+      std::cout << "[FrameProducer] Buffer drained; completing teardown" << std::endl;
+      stop_requested_.store(true, std::memory_order_release);
+      return {};
     }
+
+    return {Backoff::Kind::kForUs, 1'000};
   }
 
-  // Cleanup decoder
-  if (decoder_) {
-    decoder_->Close();
-    decoder_.reset();
+  MatchPoolToBufferDepth();
+  if (config_.stub_mode) {
+    if (master_clock_ && next_stub_deadline_utc_ == 0) {
+      next_stub_deadline_utc_ = master_clock_->now_utc_us();
+    }
+    return ProduceStubFrame();
   }
+  // No artificial delay needed - real decode has its own timing
+  return ProduceRealFrame();
+}
 
-  std::cout << "[FrameProducer] Decode loop exited" << std::endl;
+int64_t FrameProducer::RunTaskStep() {
+  const uint64_t cpu_start_ns = telemetry::ThreadCpuTimeNs();
+  cpu_meter_.Restart();
+  if (!task_begun_) {
+    BeginProduction();
+    task_begun_ = true;
+  }
+  const Backoff backoff = ProduceStep();
+  cpu_meter_.Charge(telemetry::CpuStage::kDecode);
+  // Worker threads are shared, so the producer's CPU time is summed per step
+  thread_cpu_ns_.fetch_add(telemetry::ThreadCpuTimeNs() - cpu_start_ns,
+                           std::memory_order_relaxed);
+
+  if (stop_requested_.load(std::memory_order_acquire)) {
+    return runtime::TaskLoop::kDone;
+  }
+  switch (backoff.kind) {
+    case Backoff::Kind::kNone:
+      return runtime::TaskLoop::kNow;
+    case Backoff::Kind::kUntilUtc:
+      return master_clock_->ToSystemUtcUs(backoff.us);
+    case Backoff::Kind::kForUs:
+    case Backoff::Kind::kBufferSpace:
+      // No thread to park on the buffer: poll again after the backoff window
+      return master_clock_->ToSystemUtcUs(master_clock_->now_utc_us() + backoff.us);
+  }
+  return runtime::TaskLoop::kNow;
 }
 
-void FrameProducer::ProduceStubFrame() {
-  // Create a stub frame with synthetic data
-  buffer::Frame frame;
+void FrameProducer::Wait(const Backoff& backoff) {
+  switch (backoff.kind) {
+    case Backoff::Kind::kNone:
+      return;
+    case Backoff::Kind::kUntilUtc:
+      WaitUntilUtc(master_clock_, backoff.us);
+      return;
+    case Backoff::Kind::kForUs:
+      WaitForMicros(master_clock_, backoff.us);
+      return;
+    case Backoff::Kind::kBufferSpace: {
+      buffer::FrameRingBuffer* ring = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(outputs_mutex_);
+        ring = outputs_.empty() ? nullptr : outputs_.front();
+        waiting_on_.store(ring, std::memory_order_release);
+      }
+      if (ring) {
+        WaitForBufferSpace(*ring, master_clock_, backoff.us);
+      } else {
+        WaitForMicros(master_clock_, backoff.us);
+      }
+      waiting_on_.store(nullptr, std::memory_order_release);
+      return;
+    }
+  }
+}
+
+FrameProducer::Backoff FrameProducer::ProduceStubFrame() {
+  // Create a stub frame with synthetic data in pooled memory
+  buffer::FrameHandle handle = frame_pool_->Acquire();
+  if (!handle) {
+    // Every slot is still queued downstream; same recovery as a full buffer.
+    buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+    return {Backoff::Kind::kForUs, kProducerBackoffUs};
+  }
+  buffer::Frame& frame = *handle;
   
   // Set metadata
   frame.metadata.pts = stub_pts_counter_;
   frame.metadata.dts = stub_pts_counter_;
   frame.metadata.duration =
       static_cast<double>(frame_interval_us_) / 1'000'000.0;
-  frame.metadata.asset_uri = config_.asset_uri;
+  frame.metadata.asset_id = asset_id_;
   
   // Set dimensions
   frame.width = config_.target_width;
@@ -219,8 +472,10 @@ void FrameProducer::ProduceStubFrame() {
   // U and V planes: constant gray
   std::fill(frame.data.begin() + y_size, frame.data.end(), 128);
   
-  // Try to push frame into buffer
-  if (output_buffer_.Push(frame)) {
+  // Try to push frame into buffer (handle is released back to the pool on failure)
+  const buffer::FrameHandle forwarded = outputs_.size() > 1 ? handle : buffer::FrameHandle();
+  if (outputs_.front()->Push(std::move(handle))) {
+    ForwardFrame(forwarded);
     frames_produced_.fetch_add(1, std::memory_order_relaxed);
     stub_pts_counter_ += frame_interval_us_;
 
@@ -229,41 +484,42 @@ void FrameProducer::ProduceStubFrame() {
         next_stub_deadline_utc_ = master_clock_->now_utc_us();
       }
       next_stub_deadline_utc_ += frame_interval_us_;
-      WaitUntilUtc(master_clock_, next_stub_deadline_utc_);
-    } else {
-      WaitForMicros(nullptr, frame_interval_us_);
+      return {Backoff::Kind::kUntilUtc, next_stub_deadline_utc_};
     }
-  } else {
-    // MC-004: allow downstream consumer to recover before retrying.
-    buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
-    WaitForMicros(master_clock_, kProducerBackoffUs);
+    return {Backoff::Kind::kForUs, frame_interval_us_};
   }
+  // MC-004: allow downstream consumer to recover before retrying.
+  buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+  return {Backoff::Kind::kBufferSpace, kProducerBackoffUs};
 }
 
-void FrameProducer::ProduceRealFrame() {
+FrameProducer::Backoff FrameProducer::ProduceRealFrame() {
   if (!decoder_ || !decoder_->IsOpen()) {
     std::cerr << "[FrameProducer] Decoder not available" << std::endl;
-    WaitForMicros(master_clock_, kDecoderUnavailableBackoffUs);  // MC-004 recovery window
-    return;
+    return {Backoff::Kind::kForUs, kDecoderUnavailableBackoffUs};  // MC-004 recovery window
   }
 
+  decoder_->SetDegradation(degradation_.load(std::memory_order_relaxed));
+
   // Decode next frame
-  if (!decoder_->DecodeNextFrame(output_buffer_)) {
+  if (!decoder_->DecodeNextFrame(*outputs_.front())) {
     if (decoder_->IsEOF()) {
       std::cout << "[FrameProducer] End of file reached" << std::endl;
       stop_requested_.store(true, std::memory_order_release);
-    } else {
-      // Decode error or buffer full
-      const auto& stats = decoder_->GetStats();
-      if (stats.decode_errors > 0) {
-        std::cerr << "[FrameProducer] Decode errors: " << stats.decode_errors << std::endl;
-      }
-      
-      // Back off slightly on errors or full buffer
-      WaitForMicros(master_clock_, kProducerBackoffUs);  // MC-004: avoid hammering buffer
-      buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+      return {};
     }
-    return;
+    // Decode error or buffer full
+    const auto& stats = decoder_->GetStats();
+    if (stats.decode_errors > 0) {
+      std::cerr << "[FrameProducer] Decode errors: " << stats.decode_errors << std::endl;
+    }
+
+    // Back off slightly on errors or full buffer
+    buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+    if (outputs_.front()->IsFull()) {
+      return {Backoff::Kind::kBufferSpace, kProducerBackoffUs};
+    }
+    return {Backoff::Kind::kForUs, kProducerBackoffUs};  // MC-004: avoid hammering buffer
   }
 
   // Frame successfully decoded and pushed
@@ -271,7 +527,9 @@ void FrameProducer::ProduceRealFrame() {
 
   // Try to decode audio frame (audio may not be available or may be at different rate)
   // Audio decoding is non-blocking - if buffer is full or no audio, just continue
-  decoder_->DecodeNextAudioFrame(output_buffer_);
+  decoder_->DecodeNextAudioFrame(*outputs_.front());
+
+  ReportReadStalls();
 
   // Log progress periodically
   const auto& stats = decoder_->GetStats();
@@ -280,7 +538,21 @@ void FrameProducer::ProduceRealFrame() {
               << " frames, avg decode time: " << stats.average_decode_time_ms << "ms, "
               << "current fps: " << stats.current_fps << std::endl;
   }
+  return {};
 }
 
-}  // namespace retrovue::decode
+void FrameProducer::ReportReadStalls() {
+  if (!config_.on_read_stall) {
+    return;
+  }
+  const auto& stats = decoder_->GetStats();
+  if (stats.read_stalls == reported_read_stalls_) {
+    return;
+  }
+  config_.on_read_stall(stats.read_stalls - reported_read_stalls_,
+                        stats.read_stall_seconds - reported_read_stall_seconds_);
+  reported_read_stalls_ = stats.read_stalls;
+  reported_read_stall_seconds_ = stats.read_stall_seconds;
+}
 
+}  // namespace retrovue::decode
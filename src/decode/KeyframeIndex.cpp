@@ -0,0 +1,197 @@
+// Repository: Retrovue-playout
+// Component: Keyframe Index
+// Purpose: Sidecar persistence and lookup for per-asset keyframe indexes.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/KeyframeIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace retrovue::decode {
+
+namespace {
+
+constexpr char kMagic[4] = {'R', 'V', 'K', 'I'};
+constexpr uint32_t kFormatVersion = 1;
+
+// Refuses absurd entry counts from a corrupt header before allocating.
+constexpr uint64_t kMaxEntries = 1ull << 24;
+
+template <typename T>
+void WriteValue(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::ifstream& in, T* value) {
+  in.read(reinterpret_cast<char*>(value), sizeof(T));
+  return static_cast<bool>(in);
+}
+
+}  // namespace
+
+std::string KeyframeIndex::SidecarPathFor(const std::string& asset_path,
+                                          const std::string& index_dir) {
+  if (index_dir.empty()) {
+    return asset_path + kSidecarSuffix;
+  }
+  const std::filesystem::path file_name =
+      std::filesystem::path(asset_path).filename();
+  return (std::filesystem::path(index_dir) / file_name).string() + kSidecarSuffix;
+}
+
+bool KeyframeIndex::StatAsset(const std::string& asset_path, AssetStamp* stamp) {
+  std::error_code ec;
+  const std::filesystem::path path(asset_path);
+  if (!std::filesystem::is_regular_file(path, ec)) {
+    return false;
+  }
+  const uintmax_t size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return false;
+  }
+  stamp->size_bytes = static_cast<uint64_t>(size);
+  stamp->mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        mtime.time_since_epoch())
+                        .count();
+  return true;
+}
+
+bool KeyframeIndex::Load(const std::string& sidecar_path,
+                         const AssetStamp& expected_stamp,
+                         int expected_stream_index) {
+  Clear();
+
+  std::ifstream in(sidecar_path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+
+  char magic[4];
+  uint32_t version = 0;
+  int32_t stream_index = -1;
+  AssetStamp stamp;
+  uint64_t count = 0;
+  in.read(magic, sizeof(magic));
+  if (!in || !std::equal(magic, magic + 4, kMagic) ||
+      !ReadValue(in, &version) || version != kFormatVersion ||
+      !ReadValue(in, &stream_index) || !ReadValue(in, &stamp.size_bytes) ||
+      !ReadValue(in, &stamp.mtime_ns) || !ReadValue(in, &count)) {
+    std::cerr << "[KeyframeIndex] Ignoring malformed sidecar: " << sidecar_path
+              << std::endl;
+    return false;
+  }
+  if (stamp != expected_stamp || stream_index != expected_stream_index) {
+    return false;  // Stale: the asset changed since the index was built
+  }
+  if (count > kMaxEntries) {
+    std::cerr << "[KeyframeIndex] Ignoring malformed sidecar: " << sidecar_path
+              << std::endl;
+    return false;
+  }
+
+  std::vector<KeyframeEntry> entries(static_cast<size_t>(count));
+  for (KeyframeEntry& entry : entries) {
+    if (!ReadValue(in, &entry.pts_us) || !ReadValue(in, &entry.timestamp) ||
+        !ReadValue(in, &entry.byte_pos)) {
+      std::cerr << "[KeyframeIndex] Truncated sidecar: " << sidecar_path
+                << std::endl;
+      return false;
+    }
+  }
+
+  entries_ = std::move(entries);
+  stamp_ = stamp;
+  stream_index_ = stream_index;
+  return true;
+}
+
+bool KeyframeIndex::Save(const std::string& sidecar_path) const {
+  const std::string temp_path = sidecar_path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      std::cerr << "[KeyframeIndex] Cannot write sidecar: " << temp_path
+                << std::endl;
+      return false;
+    }
+    out.write(kMagic, sizeof(kMagic));
+    WriteValue(out, kFormatVersion);
+    WriteValue(out, static_cast<int32_t>(stream_index_));
+    WriteValue(out, stamp_.size_bytes);
+    WriteValue(out, stamp_.mtime_ns);
+    WriteValue(out, static_cast<uint64_t>(entries_.size()));
+    for (const KeyframeEntry& entry : entries_) {
+      WriteValue(out, entry.pts_us);
+      WriteValue(out, entry.timestamp);
+      WriteValue(out, entry.byte_pos);
+    }
+    out.flush();
+    if (!out) {
+      std::cerr << "[KeyframeIndex] Failed writing sidecar: " << temp_path
+                << std::endl;
+      out.close();
+      std::error_code ec;
+      std::filesystem::remove(temp_path, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temp_path, sidecar_path, ec);
+  if (ec) {
+    std::cerr << "[KeyframeIndex] Failed to publish sidecar " << sidecar_path
+              << ": " << ec.message() << std::endl;
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+void KeyframeIndex::Add(const KeyframeEntry& entry) {
+  entries_.push_back(entry);
+}
+
+void KeyframeIndex::Finalize() {
+  std::sort(entries_.begin(), entries_.end(),
+            [](const KeyframeEntry& a, const KeyframeEntry& b) {
+              return a.pts_us < b.pts_us;
+            });
+  entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                             [](const KeyframeEntry& a, const KeyframeEntry& b) {
+                               return a.pts_us == b.pts_us;
+                             }),
+                 entries_.end());
+}
+
+const KeyframeEntry* KeyframeIndex::FindAtOrBefore(int64_t pts_us) const {
+  if (entries_.empty()) {
+    return nullptr;
+  }
+  // First entry strictly after pts_us; the one before it is the GOP start.
+  auto it = std::upper_bound(entries_.begin(), entries_.end(), pts_us,
+                             [](int64_t value, const KeyframeEntry& entry) {
+                               return value < entry.pts_us;
+                             });
+  if (it == entries_.begin()) {
+    return &entries_.front();
+  }
+  return &*(it - 1);
+}
+
+void KeyframeIndex::Clear() {
+  entries_.clear();
+  stamp_ = AssetStamp();
+  stream_index_ = -1;
+}
+
+}  // namespace retrovue::decode
@@ -0,0 +1,223 @@
+// Repository: Retrovue-playout
+// Component: Overlay Compositor
+// Purpose: Alpha-blends scheduled logo/bug overlays onto frames in place.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/OverlayCompositor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <utility>
+
+#include "retrovue/decode/PlaneKernels.h"
+
+namespace retrovue::decode {
+
+namespace {
+
+uint8_t ClampByte(int value) { return static_cast<uint8_t>(std::clamp(value, 0, 255)); }
+
+// Fills the chroma forms derived from u, v and alpha: the 2x2 alpha
+// average and the interleaved planes.
+void FinishOverlay(OverlayImage* image) {
+  const int chroma_width = image->width / 2;
+  const int chroma_height = image->height / 2;
+  image->chroma_alpha.resize(static_cast<size_t>(chroma_width) * chroma_height);
+  image->uv.resize(static_cast<size_t>(image->width) * chroma_height);
+  image->uv_alpha.resize(image->uv.size());
+  for (int cy = 0; cy < chroma_height; ++cy) {
+    const uint8_t* a0 = image->alpha.data() + static_cast<size_t>(2 * cy) * image->width;
+    const uint8_t* a1 = a0 + image->width;
+    for (int cx = 0; cx < chroma_width; ++cx) {
+      const size_t c = static_cast<size_t>(cy) * chroma_width + cx;
+      const size_t i = static_cast<size_t>(cy) * image->width + 2 * cx;
+      const int a_sum = a0[2 * cx] + a0[2 * cx + 1] + a1[2 * cx] + a1[2 * cx + 1];
+      const uint8_t a = static_cast<uint8_t>((a_sum + 2) >> 2);
+      image->chroma_alpha[c] = a;
+      image->uv[i] = image->u[c];
+      image->uv[i + 1] = image->v[c];
+      image->uv_alpha[i] = a;
+      image->uv_alpha[i + 1] = a;
+    }
+  }
+}
+
+// Sizes image's Y, A, U and V planes for width x height, rounded down to even.
+void ResizeOverlay(int width, int height, OverlayImage* image) {
+  image->width = width & ~1;
+  image->height = height & ~1;
+  const size_t luma = static_cast<size_t>(image->width) * image->height;
+  image->y.resize(luma);
+  image->alpha.resize(luma);
+  image->u.resize(luma / 4);
+  image->v.resize(luma / 4);
+}
+
+// Blends image with its top-left corner at (x, y), both even, clipped to
+// the frame's even size.
+void BlendOverlay(const OverlayImage& image, int x, int y, buffer::Frame* frame) {
+  const int x0 = std::max(x, 0);
+  const int y0 = std::max(y, 0);
+  const int x1 = std::min(x + image.width, frame->width & ~1);
+  const int y1 = std::min(y + image.height, frame->height & ~1);
+  if (x1 <= x0 || y1 <= y0) {
+    return;
+  }
+  const int width = x1 - x0;
+  const int rows = y1 - y0;
+  const size_t sx = static_cast<size_t>(x0 - x);
+  const size_t sy = static_cast<size_t>(y0 - y);
+
+  const size_t luma_offset = sy * image.width + sx;
+  BlendPremultipliedPlane(frame->Plane(0) + static_cast<ptrdiff_t>(y0) * frame->Stride(0) + x0,
+                          frame->Stride(0), image.y.data() + luma_offset, image.width,
+                          image.alpha.data() + luma_offset, image.width, width, rows);
+
+  const int chroma_width = image.width / 2;
+  const ptrdiff_t cy0 = y0 / 2;
+  if (frame->format == buffer::PixelFormat::kNV12) {
+    const size_t offset = sy / 2 * image.width + sx;
+    BlendPremultipliedPlane(frame->Plane(1) + cy0 * frame->Stride(1) + x0, frame->Stride(1),
+                            image.uv.data() + offset, image.width, image.uv_alpha.data() + offset,
+                            image.width, width, rows / 2);
+    return;
+  }
+  const size_t offset = sy / 2 * chroma_width + sx / 2;
+  for (int i = 1; i <= 2; ++i) {
+    const std::vector<uint8_t>& chroma = i == 1 ? image.u : image.v;
+    BlendPremultipliedPlane(frame->Plane(i) + cy0 * frame->Stride(i) + x0 / 2, frame->Stride(i),
+                            chroma.data() + offset, chroma_width,
+                            image.chroma_alpha.data() + offset, chroma_width, width / 2,
+                            rows / 2);
+  }
+}
+
+}  // namespace
+
+bool OverlayFromPremultipliedRgba(const uint8_t* rgba, int stride, int width, int height,
+                                  OverlayImage* image) {
+  if (!rgba || width < 2 || height < 2) {
+    return false;
+  }
+  ResizeOverlay(width, height, image);
+  const int chroma_width = image->width / 2;
+  for (int cy = 0; cy < image->height / 2; ++cy) {
+    for (int cx = 0; cx < chroma_width; ++cx) {
+      // Premultiplied values convert linearly: the offsets scale with alpha
+      int r_sum = 0;
+      int g_sum = 0;
+      int b_sum = 0;
+      int a_sum = 0;
+      for (int dy = 0; dy < 2; ++dy) {
+        const int row = 2 * cy + dy;
+        const uint8_t* px = rgba + static_cast<ptrdiff_t>(row) * stride + 8 * cx;
+        for (int dx = 0; dx < 2; ++dx, px += 4) {
+          const size_t i = static_cast<size_t>(row) * image->width + 2 * cx + dx;
+          image->y[i] = ClampByte(((47 * px[0] + 157 * px[1] + 16 * px[2] + 128) >> 8) +
+                                  (16 * px[3] + 127) / 255);
+          image->alpha[i] = px[3];
+          r_sum += px[0];
+          g_sum += px[1];
+          b_sum += px[2];
+          a_sum += px[3];
+        }
+      }
+      const size_t c = static_cast<size_t>(cy) * chroma_width + cx;
+      image->u[c] = ClampByte(((-26 * r_sum - 86 * g_sum + 112 * b_sum + 512) >> 10) +
+                              (128 * a_sum + 510) / 1020);
+      image->v[c] = ClampByte(((112 * r_sum - 102 * g_sum - 10 * b_sum + 512) >> 10) +
+                              (128 * a_sum + 510) / 1020);
+    }
+  }
+  FinishOverlay(image);
+  return true;
+}
+
+bool OverlayFromPremultipliedYuva(const uint8_t* const planes[4], const int strides[4],
+                                  int width, int height, OverlayImage* image) {
+  if (!planes[0] || !planes[1] || !planes[2] || !planes[3] || width < 2 || height < 2) {
+    return false;
+  }
+  ResizeOverlay(width, height, image);
+  const int chroma_width = image->width / 2;
+  CopyPlane(image->y.data(), image->width, planes[0], strides[0], image->width, image->height);
+  CopyPlane(image->alpha.data(), image->width, planes[3], strides[3], image->width,
+            image->height);
+  CopyPlane(image->u.data(), chroma_width, planes[1], strides[1], chroma_width,
+            image->height / 2);
+  CopyPlane(image->v.data(), chroma_width, planes[2], strides[2], chroma_width,
+            image->height / 2);
+  FinishOverlay(image);
+  return true;
+}
+
+void OverlayCompositor::AddSet(OverlaySet set) {
+  auto shared = std::make_shared<const OverlaySet>(std::move(set));
+  std::lock_guard<std::mutex> lock(mutex_);
+  sets_[shared->name] = std::move(shared);
+}
+
+void OverlayCompositor::RemoveSet(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sets_.erase(name);
+}
+
+void OverlayCompositor::Schedule(int64_t start_utc_us, const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cues_[start_utc_us] = name;
+}
+
+void OverlayCompositor::ClearSchedule() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cues_.clear();
+}
+
+std::shared_ptr<const OverlaySet> OverlayCompositor::ActiveAt(int64_t utc_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto next = cues_.upper_bound(utc_us);
+  if (next == cues_.begin()) {
+    return nullptr;  // Before the first cue
+  }
+  // Cues before the one on air are over
+  cues_.erase(cues_.begin(), std::prev(next));
+  const auto found = sets_.find(cues_.begin()->second);
+  if (found == sets_.end() || found->second->overlays.empty()) {
+    return nullptr;
+  }
+  return found->second;
+}
+
+bool OverlayCompositor::Composite(const OverlaySet& set, buffer::Frame* frame) {
+  const bool planar = frame->format == buffer::PixelFormat::kI420 ||
+                      frame->format == buffer::PixelFormat::kNV12;
+  if (!planar || frame->width < 2 || frame->height < 2 ||
+      frame->data.size() < frame->LayoutBytes()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_skipped++;
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const OverlayPlacement& placement : set.overlays) {
+    if (placement.image) {
+      BlendOverlay(*placement.image, placement.x & ~1, placement.y & ~1, frame);
+    }
+  }
+  const int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.frames_composited++;
+  stats_.last_composite_us = elapsed_us;
+  stats_.max_composite_us = std::max(stats_.max_composite_us, elapsed_us);
+  return true;
+}
+
+OverlayCompositorStats OverlayCompositor::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace retrovue::decode
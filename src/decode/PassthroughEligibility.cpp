@@ -0,0 +1,74 @@
+// Repository: Retrovue-playout
+// Component: Passthrough Eligibility
+// Purpose: Decides whether a source video stream can be muxed without re-encoding.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/PassthroughEligibility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace retrovue::decode {
+
+namespace {
+
+// FFmpeg's FF_PROFILE_H264_CONSTRAINED and FF_PROFILE_H264_INTRA, or'ed
+// into AVCodecParameters::profile
+constexpr int kProfileFlags = (1 << 9) | (1 << 11);
+
+// Rates within this fraction of the channel's are the same rate (29.97 is
+// not 30: it drifts a frame every 33 seconds)
+constexpr double kFpsTolerance = 0.0001;
+
+}  // namespace
+
+const char* PassthroughMismatch(const SourceStream& source, const PassthroughProfile& profile) {
+  if (!source.h264) {
+    return "codec is not H.264";
+  }
+  const int profile_idc = source.profile & ~kProfileFlags;
+  if ((profile_idc != 66 && profile_idc != 77 && profile_idc != 100) ||
+      profile_idc > profile.max_profile) {
+    return "H.264 profile above the channel's";
+  }
+  if (source.level <= 0 || source.level > profile.max_level) {
+    return "H.264 level above the channel's";
+  }
+  if (source.width != profile.width || source.height != profile.height) {
+    return "resolution differs from the channel's";
+  }
+  if (source.sar_num != 0 && source.sar_num != source.sar_den) {
+    return "non-square sample aspect ratio";
+  }
+  if (source.interlaced) {
+    return "interlaced";
+  }
+  if (source.fps <= 0.0 || std::abs(source.fps - profile.fps) > profile.fps * kFpsTolerance) {
+    return "frame rate differs from the channel's";
+  }
+  if (source.reorder_depth > 0) {
+    return "has B-frames";
+  }
+  if (source.max_gop_us < 0) {
+    return "keyframe interval unknown (no keyframe index)";
+  }
+  if (source.max_gop_us > profile.max_gop_us) {
+    return "keyframe interval longer than the channel's";
+  }
+  return nullptr;
+}
+
+int64_t LongestKeyframeInterval(const KeyframeIndex& index) {
+  const std::vector<KeyframeEntry>& entries = index.entries();
+  if (entries.size() < 2) {
+    return -1;
+  }
+  int64_t longest = 0;
+  for (size_t i = 1; i < entries.size(); ++i) {
+    longest = std::max(longest, entries[i].pts_us - entries[i - 1].pts_us);
+  }
+  return longest;
+}
+
+}  // namespace retrovue::decode
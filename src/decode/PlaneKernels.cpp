@@ -0,0 +1,709 @@
+// Repository: Retrovue-playout
+// Component: Plane Kernels
+// Purpose: SIMD (AVX2/NEON) kernels for YUV plane copy, scaling, chroma conversion and blending.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/PlaneKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RETROVUE_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RETROVUE_TARGET_AVX2
+#else
+#define RETROVUE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RETROVUE_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+#endif
+
+namespace retrovue::decode {
+
+namespace {
+
+// Bilinear weights use 7 fractional bits, so a horizontally filtered sample
+// (<= 255 * 128) fits in uint16 and a full 2D tap sum in int32.
+constexpr int kWeightBits = 7;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kBlendShift = 2 * kWeightBits;
+constexpr int kBlendRound = 1 << (kBlendShift - 1);
+
+// 3:2 downscale (1080 -> 720, and its 960 -> 640 chroma): output pair k
+// samples source 3k + 0.25 and 3k + 1.75, so the taps repeat every pair.
+constexpr int kMajorWeight = kWeightOne * 3 / 4;
+constexpr int kMinorWeight = kWeightOne / 4;
+
+// Per-ISA implementations of the kernels with a vector form. Rows are
+// processed one at a time; the public functions walk the planes.
+struct KernelTable {
+  KernelIsa isa;
+  void (*split_uv_row)(uint8_t* u, uint8_t* v, const uint8_t* uv, int width);
+  void (*merge_uv_row)(uint8_t* uv, const uint8_t* u, const uint8_t* v, int width);
+  // dst[x] = (row0[x] * (128 - fy) + row1[x] * fy + round) >> 14
+  void (*blend_rows)(uint8_t* dst, const uint16_t* row0, const uint16_t* row1, int fy,
+                     int width);
+  // Horizontal pass of a 3:2 downscale; width (even) is the output width.
+  void (*filter_row_3to2)(uint16_t* dst, const uint8_t* src, int width);
+  // dst[x] = min(src[x] + dst[x] * (255 - alpha[x]) / 255 (rounded), 255)
+  void (*blend_premultiplied_row)(uint8_t* dst, const uint8_t* src, const uint8_t* alpha,
+                                  int width);
+};
+
+// ---------------------------------------------------------------------------
+// Scalar
+
+void SplitUVRowScalar(uint8_t* u, uint8_t* v, const uint8_t* uv, int width) {
+  for (int x = 0; x < width; ++x) {
+    u[x] = uv[2 * x];
+    v[x] = uv[2 * x + 1];
+  }
+}
+
+void MergeUVRowScalar(uint8_t* uv, const uint8_t* u, const uint8_t* v, int width) {
+  for (int x = 0; x < width; ++x) {
+    uv[2 * x] = u[x];
+    uv[2 * x + 1] = v[x];
+  }
+}
+
+void BlendRowsScalar(uint8_t* dst, const uint16_t* row0, const uint16_t* row1, int fy,
+                     int width) {
+  const int w0 = kWeightOne - fy;
+  for (int x = 0; x < width; ++x) {
+    dst[x] = static_cast<uint8_t>((row0[x] * w0 + row1[x] * fy + kBlendRound) >> kBlendShift);
+  }
+}
+
+void FilterRow3To2Scalar(uint16_t* dst, const uint8_t* src, int width) {
+  for (int x = 0; x < width; x += 2) {
+    const uint8_t* s = src + x / 2 * 3;
+    dst[x] = static_cast<uint16_t>(s[0] * kMajorWeight + s[1] * kMinorWeight);
+    dst[x + 1] = static_cast<uint16_t>(s[1] * kMinorWeight + s[2] * kMajorWeight);
+  }
+}
+
+void BlendPremultipliedRowScalar(uint8_t* dst, const uint8_t* src, const uint8_t* alpha,
+                                 int width) {
+  for (int x = 0; x < width; ++x) {
+    // (t + (t >> 8)) >> 8 with t = p + 128 rounds p / 255 exactly for p <= 255 * 255
+    const int t = dst[x] * (255 - alpha[x]) + 128;
+    dst[x] = static_cast<uint8_t>(std::min(src[x] + ((t + (t >> 8)) >> 8), 255));
+  }
+}
+
+constexpr KernelTable kScalarKernels = {KernelIsa::kScalar, SplitUVRowScalar,
+                                        MergeUVRowScalar, BlendRowsScalar,
+                                        FilterRow3To2Scalar, BlendPremultipliedRowScalar};
+
+// ---------------------------------------------------------------------------
+// AVX2
+
+#ifdef RETROVUE_KERNELS_X86
+RETROVUE_TARGET_AVX2 void SplitUVRowAvx2(uint8_t* u, uint8_t* v, const uint8_t* uv,
+                                         int width) {
+  const __m256i low_bytes = _mm256_set1_epi16(0x00FF);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + 2 * x));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + 2 * x + 32));
+    // packus works per 128-bit lane; the permute restores sample order.
+    const __m256i uu = _mm256_packus_epi16(_mm256_and_si256(a, low_bytes),
+                                           _mm256_and_si256(b, low_bytes));
+    const __m256i vv = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(u + x), _mm256_permute4x64_epi64(uu, 0xD8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + x), _mm256_permute4x64_epi64(vv, 0xD8));
+  }
+  SplitUVRowScalar(u + x, v + x, uv + 2 * x, width - x);
+}
+
+RETROVUE_TARGET_AVX2 void MergeUVRowAvx2(uint8_t* uv, const uint8_t* u, const uint8_t* v,
+                                         int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i uu = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x));
+    const __m256i vv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + x));
+    const __m256i lo = _mm256_unpacklo_epi8(uu, vv);
+    const __m256i hi = _mm256_unpackhi_epi8(uu, vv);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * x),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + 2 * x + 32),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  MergeUVRowScalar(uv + 2 * x, u + x, v + x, width - x);
+}
+
+// Blends 16 samples into 16 int16 results in order.
+RETROVUE_TARGET_AVX2 inline __m256i Blend16Avx2(const uint16_t* row0, const uint16_t* row1,
+                                                __m256i weights) {
+  const __m256i round = _mm256_set1_epi32(kBlendRound);
+  const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+  const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1));
+  __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), weights);
+  __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), weights);
+  lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), kBlendShift);
+  hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), kBlendShift);
+  return _mm256_packus_epi32(lo, hi);
+}
+
+RETROVUE_TARGET_AVX2 void BlendRowsAvx2(uint8_t* dst, const uint16_t* row0,
+                                        const uint16_t* row1, int fy, int width) {
+  // madd pairs (row0, row1) samples with (w0, fy).
+  const __m256i weights = _mm256_set1_epi32((fy << 16) | (kWeightOne - fy));
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i p0 = Blend16Avx2(row0 + x, row1 + x, weights);
+    const __m256i p1 = Blend16Avx2(row0 + x + 16, row1 + x + 16, weights);
+    const __m256i packed = _mm256_packus_epi16(p0, p1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                        _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  BlendRowsScalar(dst + x, row0 + x, row1 + x, fy, width - x);
+}
+
+RETROVUE_TARGET_AVX2 void FilterRow3To2Avx2(uint16_t* dst, const uint8_t* src, int width) {
+  // Each 128-bit lane turns 12 source bytes into 8 outputs: the shuffle lays
+  // out the tap pairs and maddubs applies (major, minor) / (minor, major).
+  const __m256i taps = _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                                        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+  const __m256i weights = _mm256_set1_epi32(
+      kMajorWeight | (kMinorWeight << 8) | (kMinorWeight << 16) | (kMajorWeight << 24));
+  const int src_width = width / 2 * 3;
+  int x = 0;
+  // The upper lane loads 16 bytes from offset 12; stay inside the row.
+  for (; x + 16 <= width && x / 2 * 3 + 28 <= src_width; x += 16) {
+    const uint8_t* s = src + x / 2 * 3;
+    __m256i bytes = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+    bytes = _mm256_inserti128_si256(
+        bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 12)), 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                        _mm256_maddubs_epi16(_mm256_shuffle_epi8(bytes, taps), weights));
+  }
+  FilterRow3To2Scalar(dst + x, src + x / 2 * 3, width - x);
+}
+
+RETROVUE_TARGET_AVX2 void BlendPremultipliedRowAvx2(uint8_t* dst, const uint8_t* src,
+                                                    const uint8_t* alpha, int width) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi8(-1);
+  const __m256i round = _mm256_set1_epi16(128);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + x));
+    const __m256i inv = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alpha + x)), ones);  // 255 - alpha
+    // In-lane unpack and pack, so samples come back in order
+    __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(inv, zero)),
+        round);
+    __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(inv, zero)),
+        round);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+    const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                        _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s));
+  }
+  BlendPremultipliedRowScalar(dst + x, src + x, alpha + x, width - x);
+}
+
+constexpr KernelTable kAvx2Kernels = {KernelIsa::kAvx2, SplitUVRowAvx2, MergeUVRowAvx2,
+                                      BlendRowsAvx2, FilterRow3To2Avx2,
+                                      BlendPremultipliedRowAvx2};
+
+bool CpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 1);
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  const bool avx = (regs[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;  // OS does not save YMM state
+  }
+  __cpuidex(regs, 7, 0);
+  return (regs[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif  // RETROVUE_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// NEON
+
+#ifdef RETROVUE_KERNELS_NEON
+void SplitUVRowNeon(uint8_t* u, uint8_t* v, const uint8_t* uv, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const uint8x16x2_t pairs = vld2q_u8(uv + 2 * x);
+    vst1q_u8(u + x, pairs.val[0]);
+    vst1q_u8(v + x, pairs.val[1]);
+  }
+  SplitUVRowScalar(u + x, v + x, uv + 2 * x, width - x);
+}
+
+void MergeUVRowNeon(uint8_t* uv, const uint8_t* u, const uint8_t* v, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x2_t pairs;
+    pairs.val[0] = vld1q_u8(u + x);
+    pairs.val[1] = vld1q_u8(v + x);
+    vst2q_u8(uv + 2 * x, pairs);
+  }
+  MergeUVRowScalar(uv + 2 * x, u + x, v + x, width - x);
+}
+
+void BlendRowsNeon(uint8_t* dst, const uint16_t* row0, const uint16_t* row1, int fy,
+                   int width) {
+  const uint16x4_t w0 = vdup_n_u16(static_cast<uint16_t>(kWeightOne - fy));
+  const uint16x4_t w1 = vdup_n_u16(static_cast<uint16_t>(fy));
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const uint16x8_t a = vld1q_u16(row0 + x);
+    const uint16x8_t b = vld1q_u16(row1 + x);
+    uint32x4_t lo = vmull_u16(vget_low_u16(a), w0);
+    uint32x4_t hi = vmull_u16(vget_high_u16(a), w0);
+    lo = vmlal_u16(lo, vget_low_u16(b), w1);
+    hi = vmlal_u16(hi, vget_high_u16(b), w1);
+    // Rounding narrow adds kBlendRound before the shift.
+    const uint16x8_t blended =
+        vcombine_u16(vrshrn_n_u32(lo, kBlendShift), vrshrn_n_u32(hi, kBlendShift));
+    vst1_u8(dst + x, vqmovn_u16(blended));
+  }
+  BlendRowsScalar(dst + x, row0 + x, row1 + x, fy, width - x);
+}
+
+void FilterRow3To2Neon(uint16_t* dst, const uint8_t* src, int width) {
+  const uint8x8_t major = vdup_n_u8(static_cast<uint8_t>(kMajorWeight));
+  const uint8x8_t minor = vdup_n_u8(static_cast<uint8_t>(kMinorWeight));
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    // vld3 splits 8 source triples; even and odd outputs re-interleave on store.
+    const uint8x8x3_t s = vld3_u8(src + x / 2 * 3);
+    uint16x8x2_t out;
+    out.val[0] = vmlal_u8(vmull_u8(s.val[0], major), s.val[1], minor);
+    out.val[1] = vmlal_u8(vmull_u8(s.val[1], minor), s.val[2], major);
+    vst2q_u16(dst + x, out);
+  }
+  FilterRow3To2Scalar(dst + x, src + x / 2 * 3, width - x);
+}
+
+void BlendPremultipliedRowNeon(uint8_t* dst, const uint8_t* src, const uint8_t* alpha,
+                               int width) {
+  const uint16x8_t round = vdupq_n_u16(128);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const uint8x16_t d = vld1q_u8(dst + x);
+    const uint8x16_t inv = vmvnq_u8(vld1q_u8(alpha + x));  // 255 - alpha
+    const uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(d), vget_low_u8(inv)), round);
+    const uint16x8_t hi = vaddq_u16(vmull_u8(vget_high_u8(d), vget_high_u8(inv)), round);
+    // vsra adds t >> 8 to t
+    const uint8x16_t kept = vcombine_u8(vshrn_n_u16(vsraq_n_u16(lo, lo, 8), 8),
+                                        vshrn_n_u16(vsraq_n_u16(hi, hi, 8), 8));
+    vst1q_u8(dst + x, vqaddq_u8(kept, vld1q_u8(src + x)));
+  }
+  BlendPremultipliedRowScalar(dst + x, src + x, alpha + x, width - x);
+}
+
+constexpr KernelTable kNeonKernels = {KernelIsa::kNeon, SplitUVRowNeon, MergeUVRowNeon,
+                                      BlendRowsNeon, FilterRow3To2Neon,
+                                      BlendPremultipliedRowNeon};
+#endif  // RETROVUE_KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+
+const KernelTable* DetectKernels() {
+#if defined(RETROVUE_KERNELS_X86)
+  if (CpuHasAvx2()) {
+    return &kAvx2Kernels;
+  }
+#elif defined(RETROVUE_KERNELS_NEON)
+  return &kNeonKernels;
+#endif
+  return &kScalarKernels;
+}
+
+std::atomic<const KernelTable*>& ActiveTableSlot() {
+  static std::atomic<const KernelTable*> table{DetectKernels()};
+  return table;
+}
+
+const KernelTable& Kernels() {
+  return *ActiveTableSlot().load(std::memory_order_acquire);
+}
+
+// Source tap positions for one output axis: sample i blends src[index0[i]]
+// and src[index1[i]] with weight frac[i] / 128 on the second.
+struct AxisTaps {
+  std::vector<int> index0;
+  std::vector<int> index1;
+  std::vector<int> frac;
+
+  void Compute(int src_size, int dst_size) {
+    index0.resize(dst_size);
+    index1.resize(dst_size);
+    frac.resize(dst_size);
+    const int64_t max_pos = static_cast<int64_t>(src_size - 1) << 16;
+    for (int i = 0; i < dst_size; ++i) {
+      // Center-aligned: pos = (i + 0.5) * src / dst - 0.5, in 16.16 fixed point.
+      int64_t pos = ((2 * static_cast<int64_t>(i) + 1) * src_size << 16) / (2 * dst_size) -
+                    (1 << 15);
+      pos = std::clamp<int64_t>(pos, 0, max_pos);
+      index0[i] = static_cast<int>(pos >> 16);
+      index1[i] = std::min(index0[i] + 1, src_size - 1);
+      frac[i] = static_cast<int>((pos & 0xFFFF) >> (16 - kWeightBits));
+    }
+  }
+};
+
+// Per-thread scratch so steady-state scaling does not allocate.
+struct ScaleScratch {
+  AxisTaps horizontal;
+  AxisTaps vertical;
+  std::vector<uint16_t> rows[2];
+  std::vector<uint8_t> chroma[2];
+  std::vector<uint8_t> narrow[2];  // P010 sources, narrowed to NV12
+};
+
+ScaleScratch& Scratch() {
+  thread_local ScaleScratch scratch;
+  return scratch;
+}
+
+void FilterRow(uint16_t* dst, const uint8_t* src, const AxisTaps& taps, int width) {
+  const int* index0 = taps.index0.data();
+  const int* index1 = taps.index1.data();
+  const int* frac = taps.frac.data();
+  for (int x = 0; x < width; ++x) {
+    dst[x] = static_cast<uint16_t>(src[index0[x]] * (kWeightOne - frac[x]) +
+                                   src[index1[x]] * frac[x]);
+  }
+}
+
+}  // namespace
+
+KernelIsa ActiveKernelIsa() {
+  return Kernels().isa;
+}
+
+const char* KernelIsaName(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::kAvx2:
+      return "avx2";
+    case KernelIsa::kNeon:
+      return "neon";
+    case KernelIsa::kScalar:
+      break;
+  }
+  return "scalar";
+}
+
+bool SetKernelIsa(KernelIsa isa) {
+  const KernelTable* table = nullptr;
+  switch (isa) {
+    case KernelIsa::kScalar:
+      table = &kScalarKernels;
+      break;
+    case KernelIsa::kAvx2:
+#ifdef RETROVUE_KERNELS_X86
+      if (CpuHasAvx2()) {
+        table = &kAvx2Kernels;
+      }
+#endif
+      break;
+    case KernelIsa::kNeon:
+#ifdef RETROVUE_KERNELS_NEON
+      table = &kNeonKernels;
+#endif
+      break;
+  }
+  if (!table) {
+    return false;
+  }
+  ActiveTableSlot().store(table, std::memory_order_release);
+  return true;
+}
+
+void CopyPlane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+               int row_bytes, int rows) {
+  // libc memcpy is already vectorized; the win is collapsing rows.
+  if (src_stride == row_bytes && dst_stride == row_bytes) {
+    std::memcpy(dst, src, static_cast<size_t>(row_bytes) * rows);
+    return;
+  }
+  for (int y = 0; y < rows; ++y) {
+    std::memcpy(dst + static_cast<ptrdiff_t>(y) * dst_stride,
+                src + static_cast<ptrdiff_t>(y) * src_stride, row_bytes);
+  }
+}
+
+void SplitUVPlane(uint8_t* dst_u, int dst_u_stride, uint8_t* dst_v, int dst_v_stride,
+                  const uint8_t* src_uv, int src_stride, int width, int rows) {
+  const KernelTable& kernels = Kernels();
+  for (int y = 0; y < rows; ++y) {
+    kernels.split_uv_row(dst_u + static_cast<ptrdiff_t>(y) * dst_u_stride,
+                         dst_v + static_cast<ptrdiff_t>(y) * dst_v_stride,
+                         src_uv + static_cast<ptrdiff_t>(y) * src_stride, width);
+  }
+}
+
+void MergeUVPlane(uint8_t* dst_uv, int dst_stride, const uint8_t* src_u, int src_u_stride,
+                  const uint8_t* src_v, int src_v_stride, int width, int rows) {
+  const KernelTable& kernels = Kernels();
+  for (int y = 0; y < rows; ++y) {
+    kernels.merge_uv_row(dst_uv + static_cast<ptrdiff_t>(y) * dst_stride,
+                         src_u + static_cast<ptrdiff_t>(y) * src_u_stride,
+                         src_v + static_cast<ptrdiff_t>(y) * src_v_stride, width);
+  }
+}
+
+void NarrowP010Plane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+                     int samples, int rows) {
+  // The high byte of each little-endian sample; simple enough that
+  // compilers vectorize the loop
+  for (int y = 0; y < rows; ++y) {
+    const uint8_t* in = src + static_cast<ptrdiff_t>(y) * src_stride + 1;
+    uint8_t* out = dst + static_cast<ptrdiff_t>(y) * dst_stride;
+    for (int x = 0; x < samples; ++x) {
+      out[x] = in[2 * x];
+    }
+  }
+}
+
+void BlendPremultipliedPlane(uint8_t* dst, int dst_stride, const uint8_t* src, int src_stride,
+                             const uint8_t* alpha, int alpha_stride, int width, int rows) {
+  const KernelTable& kernels = Kernels();
+  for (int y = 0; y < rows; ++y) {
+    kernels.blend_premultiplied_row(dst + static_cast<ptrdiff_t>(y) * dst_stride,
+                                    src + static_cast<ptrdiff_t>(y) * src_stride,
+                                    alpha + static_cast<ptrdiff_t>(y) * alpha_stride, width);
+  }
+}
+
+void ScalePlane(uint8_t* dst, int dst_stride, int dst_width, int dst_height,
+                const uint8_t* src, int src_stride, int src_width, int src_height) {
+  if (dst_width <= 0 || dst_height <= 0 || src_width <= 0 || src_height <= 0) {
+    return;
+  }
+  if (dst_width == src_width && dst_height == src_height) {
+    CopyPlane(dst, dst_stride, src, src_stride, dst_width, dst_height);
+    return;
+  }
+
+  const KernelTable& kernels = Kernels();
+  ScaleScratch& scratch = Scratch();
+  scratch.horizontal.Compute(src_width, dst_width);
+  scratch.vertical.Compute(src_height, dst_height);
+  for (std::vector<uint16_t>& row : scratch.rows) {
+    row.resize(static_cast<size_t>(dst_width));
+  }
+
+  // Horizontally filtered source rows live in scratch.rows[0..1]; each source
+  // row is filtered once even when consecutive output rows share it.
+  int cached[2] = {-1, -1};
+  auto slot_of = [&cached](int src_y) {
+    return cached[0] == src_y ? 0 : (cached[1] == src_y ? 1 : -1);
+  };
+  const bool three_to_two = dst_width % 2 == 0 && src_width * 2 == dst_width * 3;
+  auto fill_slot = [&](int slot, int src_y) {
+    const uint8_t* row = src + static_cast<ptrdiff_t>(src_y) * src_stride;
+    if (three_to_two) {
+      kernels.filter_row_3to2(scratch.rows[slot].data(), row, dst_width);
+    } else {
+      FilterRow(scratch.rows[slot].data(), row, scratch.horizontal, dst_width);
+    }
+    cached[slot] = src_y;
+  };
+
+  for (int y = 0; y < dst_height; ++y) {
+    const int y0 = scratch.vertical.index0[y];
+    const int y1 = scratch.vertical.index1[y];
+    int slot0 = slot_of(y0);
+    if (slot0 < 0) {
+      slot0 = slot_of(y1) == 0 ? 1 : 0;
+      fill_slot(slot0, y0);
+    }
+    int slot1 = slot_of(y1);
+    if (slot1 < 0) {
+      slot1 = 1 - slot0;
+      fill_slot(slot1, y1);
+    }
+    kernels.blend_rows(dst + static_cast<ptrdiff_t>(y) * dst_stride,
+                       scratch.rows[slot0].data(), scratch.rows[slot1].data(),
+                       scratch.vertical.frac[y], dst_width);
+  }
+}
+
+bool DescribeFrame(const AVFrame* frame, PlanarImage* image) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  if (!frame || !frame->data[0]) {
+    return false;
+  }
+  if (frame->format == AV_PIX_FMT_YUV420P) {
+    image->layout = PlanarLayout::kI420;
+  } else if (frame->format == AV_PIX_FMT_NV12) {
+    image->layout = PlanarLayout::kNV12;
+  } else if (frame->format == AV_PIX_FMT_P010LE) {
+    image->layout = PlanarLayout::kP010;
+  } else {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    image->planes[i] = frame->data[i];
+    image->strides[i] = frame->linesize[i];
+  }
+  image->width = frame->width;
+  image->height = frame->height;
+  return true;
+#else
+  (void)frame;
+  (void)image;
+  return false;
+#endif
+}
+
+bool DescribeFrame(const buffer::Frame& frame, PlanarImage* image) {
+  if (frame.width <= 0 || frame.height <= 0 || frame.data.size() < frame.LayoutBytes()) {
+    return false;
+  }
+  switch (frame.format) {
+    case buffer::PixelFormat::kI420:
+      image->layout = PlanarLayout::kI420;
+      break;
+    case buffer::PixelFormat::kNV12:
+      image->layout = PlanarLayout::kNV12;
+      break;
+    case buffer::PixelFormat::kP010:
+      image->layout = PlanarLayout::kP010;
+      break;
+    case buffer::PixelFormat::kH264:
+      return false;  // Compressed: no planes to read
+    case buffer::PixelFormat::kDevice:
+      return false;  // In GPU memory: DownloadDeviceFrame() first
+  }
+  for (int i = 0; i < 3; ++i) {
+    const bool present = i < buffer::PixelFormatPlanes(frame.format);
+    image->planes[i] = present ? frame.Plane(i) : nullptr;
+    image->strides[i] = present ? frame.Stride(i) : 0;
+  }
+  image->width = frame.width;
+  image->height = frame.height;
+  return true;
+}
+
+bool IsPackedI420(const PlanarImage& image) {
+  const size_t y_size = static_cast<size_t>(image.width) * image.height;
+  const size_t uv_size = static_cast<size_t>(image.width / 2) * (image.height / 2);
+  return image.layout == PlanarLayout::kI420 && image.strides[0] == image.width &&
+         image.strides[1] == image.width / 2 && image.strides[2] == image.width / 2 &&
+         image.planes[1] == image.planes[0] + y_size &&
+         image.planes[2] == image.planes[1] + uv_size;
+}
+
+bool CanPackI420(const PlanarImage& src, int dst_width, int dst_height) {
+  if (src.width <= 0 || src.height <= 0 || dst_width <= 0 || dst_height <= 0) {
+    return false;
+  }
+  return src.width >= dst_width && src.height >= dst_height &&
+         src.width <= 2 * dst_width && src.height <= 2 * dst_height;
+}
+
+void PackI420(const PlanarImage& src, int dst_width, int dst_height, uint8_t* const dst[3],
+              const int dst_strides[3]) {
+  const int src_chroma_width = (src.width + 1) / 2;
+  const int src_chroma_height = (src.height + 1) / 2;
+  const int dst_chroma_width = dst_width / 2;
+  const int dst_chroma_height = dst_height / 2;
+
+  if (src.layout == PlanarLayout::kP010) {
+    // Narrow to NV12 in scratch, then pack that
+    ScaleScratch& scratch = Scratch();
+    const int uv_samples = 2 * src_chroma_width;
+    scratch.narrow[0].resize(static_cast<size_t>(src.width) * src.height);
+    scratch.narrow[1].resize(static_cast<size_t>(uv_samples) * src_chroma_height);
+    NarrowP010Plane(scratch.narrow[0].data(), src.width, src.planes[0], src.strides[0],
+                    src.width, src.height);
+    NarrowP010Plane(scratch.narrow[1].data(), uv_samples, src.planes[1], src.strides[1],
+                    uv_samples, src_chroma_height);
+    PlanarImage narrowed = src;
+    narrowed.layout = PlanarLayout::kNV12;
+    narrowed.planes[0] = scratch.narrow[0].data();
+    narrowed.planes[1] = scratch.narrow[1].data();
+    narrowed.strides[0] = src.width;
+    narrowed.strides[1] = uv_samples;
+    PackI420(narrowed, dst_width, dst_height, dst, dst_strides);
+    return;
+  }
+
+  ScalePlane(dst[0], dst_strides[0], dst_width, dst_height, src.planes[0], src.strides[0],
+             src.width, src.height);
+
+  if (src.layout == PlanarLayout::kI420) {
+    ScalePlane(dst[1], dst_strides[1], dst_chroma_width, dst_chroma_height, src.planes[1],
+               src.strides[1], src_chroma_width, src_chroma_height);
+    ScalePlane(dst[2], dst_strides[2], dst_chroma_width, dst_chroma_height, src.planes[2],
+               src.strides[2], src_chroma_width, src_chroma_height);
+    return;
+  }
+
+  // NV12: deinterleave straight into the output when no scaling is needed,
+  // otherwise into scratch planes that are then scaled.
+  if (src_chroma_width == dst_chroma_width && src_chroma_height == dst_chroma_height) {
+    SplitUVPlane(dst[1], dst_strides[1], dst[2], dst_strides[2], src.planes[1], src.strides[1],
+                 dst_chroma_width, dst_chroma_height);
+    return;
+  }
+  ScaleScratch& scratch = Scratch();
+  const size_t chroma_size = static_cast<size_t>(src_chroma_width) * src_chroma_height;
+  scratch.chroma[0].resize(chroma_size);
+  scratch.chroma[1].resize(chroma_size);
+  SplitUVPlane(scratch.chroma[0].data(), src_chroma_width, scratch.chroma[1].data(),
+               src_chroma_width, src.planes[1], src.strides[1], src_chroma_width,
+               src_chroma_height);
+  ScalePlane(dst[1], dst_strides[1], dst_chroma_width, dst_chroma_height,
+             scratch.chroma[0].data(), src_chroma_width, src_chroma_width, src_chroma_height);
+  ScalePlane(dst[2], dst_strides[2], dst_chroma_width, dst_chroma_height,
+             scratch.chroma[1].data(), src_chroma_width, src_chroma_width, src_chroma_height);
+}
+
+void PackI420(const PlanarImage& src, int dst_width, int dst_height, uint8_t* dst) {
+  const int chroma_width = dst_width / 2;
+  const size_t y_size = static_cast<size_t>(dst_width) * dst_height;
+  const size_t uv_size = static_cast<size_t>(chroma_width) * (dst_height / 2);
+  uint8_t* const planes[3] = {dst, dst + y_size, dst + y_size + uv_size};
+  const int strides[3] = {dst_width, chroma_width, chroma_width};
+  PackI420(src, dst_width, dst_height, planes, strides);
+}
+
+void CopyToFrame(const PlanarImage& src, buffer::Frame* dst) {
+  buffer::PixelFormat format = buffer::PixelFormat::kI420;
+  if (src.layout == PlanarLayout::kNV12) {
+    format = buffer::PixelFormat::kNV12;
+  } else if (src.layout == PlanarLayout::kP010) {
+    format = buffer::PixelFormat::kP010;
+  }
+  dst->Layout(format, src.width, src.height);
+  for (int i = 0; i < buffer::PixelFormatPlanes(format); ++i) {
+    CopyPlane(dst->Plane(i), dst->Stride(i), src.planes[i], src.strides[i],
+              static_cast<int>(buffer::Frame::PlaneRowBytes(format, i, src.width)),
+              buffer::Frame::PlaneRows(i, src.height));
+  }
+}
+
+}  // namespace retrovue::decode
@@ -0,0 +1,375 @@
+// Repository: Retrovue-playout
+// Component: Read-Ahead File
+// Purpose: Background-prefetching file reader that backs a custom AVIOContext.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/decode/ReadAheadFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "retrovue/runtime/IoRing.h"
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+#endif
+
+namespace retrovue::decode {
+
+namespace {
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+constexpr int kIOBufferBytes = 64 * 1024;  // AVIOContext's own staging buffer
+
+int ReadPacketCallback(void* opaque, uint8_t* buf, int buf_size) {
+  auto* file = static_cast<ReadAheadFile*>(opaque);
+  const int64_t got = file->Read(buf, static_cast<size_t>(buf_size));
+  if (got < 0) {
+    return AVERROR(EIO);
+  }
+  return got == 0 ? AVERROR_EOF : static_cast<int>(got);
+}
+
+int64_t SeekCallback(void* opaque, int64_t offset, int whence) {
+  auto* file = static_cast<ReadAheadFile*>(opaque);
+  if (whence & AVSEEK_SIZE) {
+    return file->Size();
+  }
+  const int64_t position = file->Seek(offset, whence & ~AVSEEK_FORCE);
+  return position < 0 ? AVERROR(EINVAL) : position;
+}
+#endif
+
+}  // namespace
+
+ReadAheadFile::ReadAheadFile(size_t window_bytes, size_t chunk_bytes,
+                             std::shared_ptr<runtime::IoRing> io_ring)
+    : capacity_(std::max<size_t>(window_bytes, 1)),
+      chunk_bytes_(std::clamp<size_t>(chunk_bytes, 1, std::max<size_t>(window_bytes, 1))),
+      ring_(new uint8_t[std::max<size_t>(window_bytes, 1)]),
+      io_ring_(io_ring && io_ring->IsOpen() ? std::move(io_ring) : nullptr) {
+  if (io_ring_) {
+    buffer_index_ = io_ring_->RegisterBuffer(ring_.get(), capacity_);
+  }
+}
+
+ReadAheadFile::~ReadAheadFile() {
+  Close();
+  if (io_ring_) {
+    io_ring_->UnregisterBuffer(buffer_index_);
+  }
+}
+
+bool ReadAheadFile::Open(const std::string& path) {
+  Close();
+
+  std::error_code ec;
+  const uintmax_t size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  if (io_ring_) {
+    fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  } else {
+    file_.open(path, std::ios::binary);
+  }
+  if (io_ring_ ? fd_ < 0 : !file_) {
+    std::cerr << "[ReadAheadFile] Failed to open: " << path << std::endl;
+    return false;
+  }
+  file_size_ = static_cast<int64_t>(size);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    head_ = 0;
+    buffered_ = 0;
+    read_offset_ = 0;
+    generation_++;
+    primed_ = false;
+    eof_ = file_size_ == 0;
+    error_ = false;
+    stop_ = false;
+    stats_ = ReadAheadStats();
+    if (io_ring_) {
+      QueueReadLocked();
+    }
+  }
+  if (io_ring_) {
+    io_ring_->Submit();
+  } else {
+    fill_thread_ = std::thread(&ReadAheadFile::FillLoop, this);
+  }
+  return true;
+}
+
+void ReadAheadFile::Close() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+    // The read in flight lands in ring_: wait for it
+    data_cv_.wait(lock, [this] { return !read_in_flight_; });
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  space_cv_.notify_all();
+  data_cv_.notify_all();
+  if (fill_thread_.joinable()) {
+    fill_thread_.join();
+  }
+  if (file_.is_open()) {
+    file_.close();
+  }
+  file_.clear();
+}
+
+int64_t ReadAheadFile::Read(uint8_t* dst, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (buffered_ == 0 && !eof_ && !error_ && !stop_) {
+    const auto wait_start = std::chrono::steady_clock::now();
+    data_cv_.wait(lock, [this] { return buffered_ > 0 || eof_ || error_ || stop_; });
+    if (primed_) {
+      // The window ran dry mid-stream: storage fell behind the demuxer.
+      stats_.stalls++;
+      stats_.stall_time_us += static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - wait_start)
+              .count());
+    }
+  }
+  if (buffered_ == 0) {
+    return error_ ? -1 : 0;
+  }
+
+  const size_t count = std::min(size, buffered_);
+  const size_t first = std::min(count, capacity_ - head_);
+  std::memcpy(dst, ring_.get() + head_, first);
+  std::memcpy(dst + first, ring_.get(), count - first);
+  head_ = (head_ + count) % capacity_;
+  buffered_ -= count;
+  read_offset_ += static_cast<int64_t>(count);
+  stats_.bytes_read += count;
+  primed_ = true;
+  if (io_ring_) {
+    QueueReadLocked();
+    lock.unlock();
+    io_ring_->Submit();
+    return static_cast<int64_t>(count);
+  }
+  lock.unlock();
+
+  space_cv_.notify_one();
+  return static_cast<int64_t>(count);
+}
+
+int64_t ReadAheadFile::Seek(int64_t offset, int whence) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  int64_t target = offset;
+  if (whence == SEEK_CUR) {
+    target = read_offset_ + offset;
+  } else if (whence == SEEK_END) {
+    target = file_size_ + offset;
+  } else if (whence != SEEK_SET) {
+    return -1;
+  }
+  if (target < 0 || target > file_size_) {
+    return -1;
+  }
+
+  // Forward seeks inside the window (skipping an atom or an unused stream)
+  // keep the prefetched data.
+  if (target >= read_offset_ && target <= read_offset_ + static_cast<int64_t>(buffered_)) {
+    const size_t skip = static_cast<size_t>(target - read_offset_);
+    head_ = (head_ + skip) % capacity_;
+    buffered_ -= skip;
+    read_offset_ = target;
+    if (io_ring_) {
+      QueueReadLocked();
+      lock.unlock();
+      io_ring_->Submit();
+      return target;
+    }
+    lock.unlock();
+    space_cv_.notify_one();
+    return target;
+  }
+
+  head_ = 0;
+  buffered_ = 0;
+  read_offset_ = target;
+  generation_++;  // Discards any chunk the fill thread is reading
+  primed_ = false;
+  eof_ = target >= file_size_;
+  error_ = false;
+  stats_.seeks++;
+  if (io_ring_) {
+    QueueReadLocked();  // Or once the stale read in flight completes
+    lock.unlock();
+    io_ring_->Submit();
+    return target;
+  }
+  lock.unlock();
+  space_cv_.notify_one();
+  return target;
+}
+
+size_t ReadAheadFile::Buffered() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return buffered_;
+}
+
+ReadAheadStats ReadAheadFile::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ReadAheadFile::FillLoop() {
+  int64_t file_position = 0;  // Where file_ is positioned, to avoid redundant seeks
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    space_cv_.wait(lock, [this] {
+      return stop_ || (!eof_ && !error_ && buffered_ < capacity_);
+    });
+    if (stop_) {
+      break;
+    }
+
+    // Only the fill thread writes free ring space, and the reader only sees
+    // bytes once they are committed below, so the read runs unlocked.
+    const uint64_t generation = generation_;
+    const int64_t offset = read_offset_ + static_cast<int64_t>(buffered_);
+    const size_t tail = (head_ + buffered_) % capacity_;
+    const size_t length = std::min({chunk_bytes_, capacity_ - buffered_, capacity_ - tail});
+    uint8_t* dst = ring_.get() + tail;
+    lock.unlock();
+
+    if (file_position != offset) {
+      file_.clear();
+      file_.seekg(offset);
+    }
+    file_.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(length));
+    const size_t got = static_cast<size_t>(std::max<std::streamsize>(file_.gcount(), 0));
+    const bool failed = got < length && !file_.eof();
+    file_position = file_ ? offset + static_cast<int64_t>(got) : -1;
+
+    lock.lock();
+    if (generation != generation_) {
+      continue;  // Reader seeked away; this chunk is stale
+    }
+    buffered_ += got;
+    if (failed) {
+      std::cerr << "[ReadAheadFile] Read error at offset " << offset << std::endl;
+      error_ = true;
+    } else if (offset + static_cast<int64_t>(got) >= file_size_ || got < length) {
+      eof_ = true;
+    }
+    data_cv_.notify_one();
+  }
+}
+
+void ReadAheadFile::QueueReadLocked() {
+  // Whole chunks only, so a reader taking a few KB at a time does not turn
+  // into as many small reads
+  if (read_in_flight_ || stop_ || eof_ || error_ || capacity_ - buffered_ < chunk_bytes_) {
+    return;
+  }
+  const uint64_t generation = generation_;
+  const int64_t offset = read_offset_ + static_cast<int64_t>(buffered_);
+  const size_t tail = (head_ + buffered_) % capacity_;
+  const size_t length = std::min(chunk_bytes_, capacity_ - tail);
+  read_in_flight_ = true;
+  const bool queued = io_ring_->QueueRead(
+      fd_, ring_.get() + tail, length, offset,
+      [this, generation, offset, length](int32_t result) {
+        OnReadComplete(generation, offset, length, result);
+      },
+      buffer_index_);
+  if (!queued) {
+    std::cerr << "[ReadAheadFile] Cannot queue read at offset " << offset << std::endl;
+    read_in_flight_ = false;
+    error_ = true;
+    data_cv_.notify_all();
+  }
+}
+
+void ReadAheadFile::OnReadComplete(uint64_t generation, int64_t offset, size_t length,
+                                   int32_t result) {
+  // Everything under the lock, notifications included: once
+  // read_in_flight_ clears, Close() may return and this object go away
+  std::lock_guard<std::mutex> lock(mutex_);
+  read_in_flight_ = false;
+  if (stop_) {
+    data_cv_.notify_all();
+    return;
+  }
+  if (generation != generation_) {
+    QueueReadLocked();  // Reader seeked away; this chunk is stale
+    return;
+  }
+  if (result == -EINTR || result == -EAGAIN) {
+    QueueReadLocked();
+    return;
+  }
+  if (result < 0) {
+    std::cerr << "[ReadAheadFile] Read error at offset " << offset << ": "
+              << std::strerror(-result) << std::endl;
+    error_ = true;
+  } else {
+    const size_t got = std::min(static_cast<size_t>(result), length);
+    buffered_ += got;
+    if (got == 0 || offset + static_cast<int64_t>(got) >= file_size_) {
+      eof_ = true;
+    }
+  }
+  data_cv_.notify_all();
+  QueueReadLocked();
+}
+
+AVIOContext* ReadAheadFile::CreateIOContext() {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  auto* buffer = static_cast<unsigned char*>(av_malloc(kIOBufferBytes));
+  if (!buffer) {
+    return nullptr;
+  }
+  AVIOContext* io_ctx = avio_alloc_context(buffer, kIOBufferBytes, 0, this,
+                                           ReadPacketCallback, nullptr, SeekCallback);
+  if (!io_ctx) {
+    av_free(buffer);
+    return nullptr;
+  }
+  return io_ctx;
+#else
+  return nullptr;
+#endif
+}
+
+void ReadAheadFile::FreeIOContext(AVIOContext** io_ctx) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  if (io_ctx && *io_ctx) {
+    av_freep(&(*io_ctx)->buffer);
+    avio_context_free(io_ctx);
+  }
+#else
+  (void)io_ctx;
+#endif
+}
+
+}  // namespace retrovue::decode
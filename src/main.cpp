@@ -3,20 +3,38 @@
 // Purpose: Main entry point for the RetroVue playout engine.
 // Copyright (c) 2025 RetroVue
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 
+#include "playout_async_server.h"
 #include "playout_service.h"
+#include "retrovue/decode/FFmpegDecoder.h"
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+#include "retrovue/renderer/Y4mFileSink.h"
+#include "retrovue/runtime/ChannelCheckpoint.h"
+#include "retrovue/runtime/ChannelManifest.h"
+#include "retrovue/runtime/IoRing.h"
 #include "retrovue/runtime/PlayoutEngine.h"
 #include "retrovue/runtime/PlayoutController.h"
+#include "retrovue/runtime/TaskExecutor.h"
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/telemetry/ThumbnailGenerator.h"
+#include "retrovue/telemetry/TraceRing.h"
+#include "retrovue/timing/DeadlineScheduler.h"
+#include "retrovue/timing/DisciplinedMasterClock.h"
 #include "retrovue/timing/MasterClock.h"
+#include "retrovue/timing/TimeReference.h"
 
 namespace {
 
@@ -24,6 +42,29 @@ namespace {
 struct ServerConfig {
   std::string server_address = "0.0.0.0:50051";
   bool enable_reflection = true;
+  size_t grpc_queues = 2;       // Completion queues (a poller thread each)
+  size_t grpc_threads = 16;     // RPC handler threads
+  retrovue::runtime::DecodeThreadBudget decode_budget;
+  int encoder_threads = 0;      // Software encoder threads across all channels (0 = cores)
+  size_t read_ahead_bytes = 0;
+  bool io_uring = false;        // Read-ahead reads on one shared io_uring
+  size_t timer_threads = 2;     // 0 = every thread times its own waits
+  std::vector<int> timer_cpus;
+  int timer_priority = 0;       // SCHED_FIFO priority of the scheduler threads (0 = normal)
+  int executor_threads = 0;     // Shared component pool (0 = a thread per component, -1 = cores)
+  retrovue::runtime::PlacementPolicy placement;
+  retrovue::runtime::BufferPolicy buffer;
+  retrovue::runtime::LoadShedPolicy shed;
+  retrovue::runtime::HostCapacityPolicy capacity;
+  std::string clock_reference;  // "chrony", "phc:/dev/ptpN" or empty (local clock)
+  int64_t clock_tai_offset_s = 37;
+  std::string channel_manifest;  // Running channels, restored at startup (empty = none)
+  int checkpoint_interval_ms = 250;  // Channel checkpoints beside the manifest (0 = off)
+  int thumbnail_interval_s = 0;  // Channel thumbnails on /thumbnail/{id} (0 = off)
+  int thumbnail_width = 320;
+  retrovue::runtime::FrameExportPolicy frame_export;  // Channels' frames in shared memory
+  std::string offline_input;     // Render this plan offline instead of serving (empty = serve)
+  std::string offline_output = "offline.y4m";  // Offline render output ("-" = stdout)
 };
 
 ServerConfig ParseArgs(int argc, char** argv) {
@@ -38,12 +79,150 @@ ServerConfig ParseArgs(int argc, char** argv) {
       if (i + 1 < argc) {
         config.server_address = argv[++i];
       }
+    } else if (arg == "--grpc-queues" && i + 1 < argc) {
+      config.grpc_queues = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--grpc-threads" && i + 1 < argc) {
+      config.grpc_threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--decode-threads" && i + 1 < argc) {
+      config.decode_budget.max_total_threads = std::atoi(argv[++i]);
+    } else if (arg == "--decode-threads-per-channel" && i + 1 < argc) {
+      config.decode_budget.per_channel_threads = std::atoi(argv[++i]);
+    } else if (arg == "--encoder-threads" && i + 1 < argc) {
+      config.encoder_threads = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--read-ahead-mb" && i + 1 < argc) {
+      config.read_ahead_bytes = static_cast<size_t>(std::max(0, std::atoi(argv[++i]))) << 20;
+    } else if (arg == "--io-uring") {
+      config.io_uring = true;
+    } else if (arg == "--timer-threads" && i + 1 < argc) {
+      config.timer_threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+    } else if (arg == "--timer-cpus" && i + 1 < argc) {
+      std::stringstream cpus(argv[++i]);
+      std::string cpu;
+      config.timer_cpus.clear();
+      while (std::getline(cpus, cpu, ',')) {
+        if (!cpu.empty()) {
+          config.timer_cpus.push_back(std::atoi(cpu.c_str()));
+        }
+      }
+    } else if (arg == "--timer-priority" && i + 1 < argc) {
+      config.timer_priority = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--executor-threads" && i + 1 < argc) {
+      config.executor_threads = std::max(-1, std::atoi(argv[++i]));
+    } else if (arg == "--numa-pack") {
+      config.placement.pack_numa_nodes = true;
+    } else if (arg == "--pacing-priority" && i + 1 < argc) {
+      config.placement.pacing_priority = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--buffer-latency-ms" && i + 1 < argc) {
+      config.buffer.latency_ms = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--buffer-max-frames" && i + 1 < argc) {
+      config.buffer.max_frames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--buffer-memory-mb" && i + 1 < argc) {
+      config.buffer.memory_budget_bytes = static_cast<size_t>(std::max(0, std::atoi(argv[++i]))) << 20;
+    } else if (arg == "--load-shed") {
+      config.shed.enabled = true;
+    } else if (arg == "--shed-protect-priority" && i + 1 < argc) {
+      config.shed.protected_priority = std::atoi(argv[++i]);
+    } else if (arg == "--host-id" && i + 1 < argc) {
+      config.capacity.host_id = argv[++i];
+    } else if (arg == "--encoder-slots" && i + 1 < argc) {
+      config.capacity.encoder_slots = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--clock-reference" && i + 1 < argc) {
+      config.clock_reference = argv[++i];
+    } else if (arg == "--clock-tai-offset" && i + 1 < argc) {
+      config.clock_tai_offset_s = std::atoll(argv[++i]);
+    } else if (arg == "--channel-manifest" && i + 1 < argc) {
+      config.channel_manifest = argv[++i];
+    } else if (arg == "--checkpoint-interval-ms" && i + 1 < argc) {
+      config.checkpoint_interval_ms = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--thumbnail-interval" && i + 1 < argc) {
+      config.thumbnail_interval_s = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--thumbnail-width" && i + 1 < argc) {
+      config.thumbnail_width = std::max(16, std::atoi(argv[++i]));
+    } else if (arg == "--frame-export" && i + 1 < argc) {
+      const std::string channels = argv[++i];
+      config.frame_export.channel_ids.clear();
+      config.frame_export.all_channels = channels == "all";
+      std::stringstream ids(channels);
+      std::string id;
+      while (!config.frame_export.all_channels && std::getline(ids, id, ',')) {
+        if (!id.empty()) {
+          config.frame_export.channel_ids.push_back(std::atoi(id.c_str()));
+        }
+      }
+    } else if (arg == "--frame-export-dir" && i + 1 < argc) {
+      config.frame_export.socket_dir = argv[++i];
+    } else if (arg == "--frame-export-slots" && i + 1 < argc) {
+      config.frame_export.slots = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--offline" && i + 1 < argc) {
+      config.offline_input = argv[++i];
+    } else if (arg == "--offline-output" && i + 1 < argc) {
+      config.offline_output = argv[++i];
     } else if (arg == "--help" || arg == "-h") {
       std::cout << "RetroVue Playout Engine\n\n"
                 << "Usage: retrovue_playout [OPTIONS]\n\n"
                 << "Options:\n"
                 << "  -p, --port PORT        Listen port (default: 50051)\n"
                 << "  -a, --address ADDRESS  Full listen address (default: 0.0.0.0:50051)\n"
+                << "  --grpc-queues N        gRPC completion queues, one poller thread each\n"
+                << "                         (default: 2)\n"
+                << "  --grpc-threads N       RPCs handled at once (default: 16)\n"
+                << "  --decode-threads N     Decoder threads across all channels (default: cores)\n"
+                << "  --decode-threads-per-channel N\n"
+                << "                         Decoder threads per producer (default: 2)\n"
+                << "  --encoder-threads N    Software encoder threads across all channels\n"
+                << "                         (default: cores)\n"
+                << "  --read-ahead-mb N      Prefetch N MiB of each asset ahead of the demuxer\n"
+                << "                         (network storage; default: 0 = off)\n"
+                << "  --io-uring             Queue read-ahead reads on one io_uring shared by\n"
+                << "                         all channels instead of a thread each (Linux;\n"
+                << "                         default: off)\n"
+                << "  --timer-threads N      Shared deadline scheduler threads for all channels\n"
+                << "                         (default: 2; 0 = per-thread waits)\n"
+                << "  --timer-cpus LIST      Pin the scheduler threads to CPUs, e.g. 2,3\n"
+                << "  --timer-priority P     Run the scheduler threads at SCHED_FIFO priority P\n"
+                << "                         (needs CAP_SYS_NICE; default: 0 = normal)\n"
+                << "  --executor-threads N   Run producers and renderers as tasks on N shared\n"
+                << "                         workers, pacing on the scheduler threads\n"
+                << "                         (-1 = one per core; default: 0 = thread each)\n"
+                << "  --numa-pack            Spread channels over NUMA nodes, pinning each to its\n"
+                << "                         node's CPUs and frame memory (default: off)\n"
+                << "  --pacing-priority P    Run channel render threads at SCHED_FIFO priority P\n"
+                << "                         (needs CAP_SYS_NICE; default: 0 = normal)\n"
+                << "  --buffer-latency-ms MS Frame buffer depth per channel as time (default: 2000)\n"
+                << "  --buffer-max-frames N  Deepest a channel buffer may grow (default: 300)\n"
+                << "  --buffer-memory-mb N   Frame memory all channel buffers may reserve\n"
+                << "                         (default: 0 = unlimited)\n"
+                << "  --load-shed            Degrade low-priority channels' decoding first when\n"
+                << "                         channels fall behind (default: off)\n"
+                << "  --shed-protect-priority P\n"
+                << "                         Never degrade channels of priority P or above\n"
+                << "                         (default: 1)\n"
+                << "  --host-id NAME         Name in host capacity reports (default: hostname)\n"
+                << "  --encoder-slots N      Channels this host encodes at once\n"
+                << "                         (default: 0 = unlimited)\n"
+                << "  --clock-reference REF  Discipline the master clock to chrony or a PTP\n"
+                << "                         hardware clock (phc:/dev/ptp0; default: local)\n"
+                << "  --clock-tai-offset S   TAI-UTC seconds of the PTP clock (default: 37)\n"
+                << "  --channel-manifest PATH\n"
+                << "                         Record running channels in PATH and restart them\n"
+                << "                         at startup (default: none)\n"
+                << "  --checkpoint-interval-ms N\n"
+                << "                         Checkpoint channel positions to PATH.checkpoint\n"
+                << "                         every N ms, so restarted channels resume on\n"
+                << "                         schedule (default: 250; 0 = off)\n"
+                << "  --thumbnail-interval S Serve a thumbnail of each channel every S seconds\n"
+                << "                         at /thumbnail/{channel} (default: 0 = off)\n"
+                << "  --thumbnail-width W    Thumbnail width, height by aspect (default: 320)\n"
+                << "  --frame-export LIST    Publish the decoded frames of these channels (e.g.\n"
+                << "                         1,4, or all) in shared memory for analytics on\n"
+                << "                         this host (Linux; default: none)\n"
+                << "  --frame-export-dir DIR Sockets handing out the exports, frames-N.sock\n"
+                << "                         (default: /run/retrovue)\n"
+                << "  --frame-export-slots N Frames each export keeps readable (default: 8)\n"
+                << "  --offline PLAN         Render PLAN as fast as it decodes, without pacing,\n"
+                << "                         then exit (no gRPC server; reports frames/s)\n"
+                << "  --offline-output PATH  Offline render output, YUV4MPEG2 (default:\n"
+                << "                         offline.y4m; - = stdout, e.g. into ffmpeg)\n"
                 << "  -h, --help             Show this help message\n"
                 << std::endl;
       std::exit(0);
@@ -54,20 +233,121 @@ ServerConfig ParseArgs(int argc, char** argv) {
 }
 
 void RunServer(const ServerConfig& config) {
+  // FFmpeg setup and codec lookups run while the rest comes up, instead of
+  // inside the first channel start
+  std::thread warm_thread([] {
+    const auto started = std::chrono::steady_clock::now();
+    const int decoders = retrovue::decode::WarmUpDecoding();
+    std::cout << "Decoding warmed up (" << decoders << " decoders) in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - started)
+                     .count()
+              << " ms" << std::endl;
+  });
+
   // Create and start metrics exporter
   auto metrics_exporter = std::make_shared<retrovue::telemetry::MetricsExporter>(9308);
+  std::shared_ptr<retrovue::telemetry::ThumbnailGenerator> thumbnails;
+  if (config.thumbnail_interval_s > 0) {
+    retrovue::telemetry::ThumbnailConfig thumbnail_config;
+    thumbnail_config.interval = std::chrono::seconds(config.thumbnail_interval_s);
+    thumbnail_config.max_width = config.thumbnail_width;
+    thumbnail_config.max_height = config.thumbnail_width * 9 / 16;
+    thumbnails = std::make_shared<retrovue::telemetry::ThumbnailGenerator>(thumbnail_config);
+    thumbnails->Start();
+    metrics_exporter->AddHttpHandler(
+        "/thumbnail/", [thumbnails](const retrovue::telemetry::HttpRequest& request,
+                                    retrovue::telemetry::HttpResponse& response) {
+          return thumbnails->ServeHttp(request, response);
+        });
+  }
+  // Event tracing for stall forensics: /trace/start, /trace/stop, /trace
+  metrics_exporter->AddHttpHandler("/trace", retrovue::telemetry::ServeTraceHttp);
   if (!metrics_exporter->Start()) {
     std::cerr << "Failed to start metrics exporter" << std::endl;
+    warm_thread.join();
     return;
   }
 
   const auto epoch_now = std::chrono::duration_cast<std::chrono::microseconds>(
       std::chrono::system_clock::now().time_since_epoch());
-  auto master_clock = retrovue::timing::MakeSystemMasterClock(epoch_now.count(), 0.0);
+  // One deadline scheduler times the frame waits of every channel
+  std::shared_ptr<retrovue::timing::DeadlineScheduler> scheduler;
+  if (config.timer_threads > 0) {
+    retrovue::timing::DeadlineScheduler::Config timer_config;
+    timer_config.threads = config.timer_threads;
+    timer_config.cpus = config.timer_cpus;
+    timer_config.priority = config.timer_priority;
+    scheduler = std::make_shared<retrovue::timing::DeadlineScheduler>(timer_config);
+    scheduler->Start();
+  }
+  std::shared_ptr<retrovue::timing::MasterClock> master_clock =
+      retrovue::timing::MakeSystemMasterClock(epoch_now.count(), 0.0,
+                                              retrovue::timing::kDefaultWaitSpinUs, scheduler);
+
+  // Hosts feeding one multiplexer share time through the reference
+  std::shared_ptr<retrovue::timing::DisciplinedMasterClock> disciplined_clock;
+  if (!config.clock_reference.empty()) {
+    std::shared_ptr<retrovue::timing::TimeReference> reference;
+    if (config.clock_reference == "chrony") {
+      reference = retrovue::timing::MakeChronyTimeReference();
+    } else if (config.clock_reference.rfind("phc:", 0) == 0) {
+      reference = retrovue::timing::MakePhcTimeReference(config.clock_reference.substr(4),
+                                                         config.clock_tai_offset_s);
+    } else {
+      std::cerr << "Unknown clock reference: " << config.clock_reference << std::endl;
+    }
+    if (reference) {
+      disciplined_clock = std::make_shared<retrovue::timing::DisciplinedMasterClock>(
+          master_clock, reference, retrovue::timing::ClockDisciplineConfig{});
+      disciplined_clock->Start();
+      disciplined_clock->set_epoch_utc_us(disciplined_clock->now_utc_us());
+      master_clock = disciplined_clock;
+    }
+  }
+
+  // Channel components share one pool instead of a thread each
+  std::shared_ptr<retrovue::runtime::TaskExecutor> executor;
+  if (config.executor_threads != 0) {
+    if (!scheduler) {
+      std::cerr << "--executor-threads needs the deadline scheduler (--timer-threads > 0)"
+                << std::endl;
+    } else {
+      retrovue::runtime::TaskExecutor::Config executor_config;
+      executor_config.workers =
+          config.executor_threads > 0 ? static_cast<size_t>(config.executor_threads) : 0;
+      executor = std::make_shared<retrovue::runtime::TaskExecutor>(executor_config, scheduler);
+      if (!executor->Start()) {
+        executor.reset();
+      }
+    }
+  }
 
   // Create the domain engine (contains tested domain logic)
   auto engine = std::make_shared<retrovue::runtime::PlayoutEngine>(
-      metrics_exporter, master_clock);
+      metrics_exporter, master_clock, config.decode_budget, config.read_ahead_bytes, executor,
+      config.placement, config.buffer, config.shed, config.capacity);
+  engine->SetEncoderThreadBudget(
+      std::make_shared<retrovue::playout_sinks::mpegts::EncoderThreadBudget>(
+          config.encoder_threads));
+  if (!config.channel_manifest.empty()) {
+    engine->SetChannelManifest(
+        std::make_shared<retrovue::runtime::ChannelManifest>(config.channel_manifest));
+    auto checkpoints = std::make_shared<retrovue::runtime::ChannelCheckpointFile>(
+        config.channel_manifest + ".checkpoint");
+    if (config.checkpoint_interval_ms > 0 && checkpoints->Open()) {
+      engine->SetChannelCheckpoints(std::move(checkpoints),
+                                    std::chrono::milliseconds(config.checkpoint_interval_ms));
+    }
+  }
+  engine->SetThumbnailGenerator(thumbnails);
+  engine->SetFrameExportPolicy(config.frame_export);
+  if (config.io_uring) {
+    auto io_ring = std::make_shared<retrovue::runtime::IoRing>();
+    if (io_ring->Open()) {
+      engine->SetIoRing(std::move(io_ring));
+    }
+  }
   
   // Create the controller (thin adapter between gRPC and domain)
   auto controller = std::make_shared<retrovue::runtime::PlayoutController>(engine);
@@ -79,18 +359,27 @@ void RunServer(const ServerConfig& config) {
   grpc::EnableDefaultHealthCheckService(true);
   grpc::reflection::InitProtoReflectionServerBuilderPlugin();
 
-  // Build the server
-  grpc::ServerBuilder builder;
-  builder.AddListeningPort(config.server_address, grpc::InsecureServerCredentials());
-  builder.RegisterService(&service);
+  // Serve it on completion queues; handlers run on their own pool
+  retrovue::playout::PlayoutAsyncServer::Config server_config;
+  server_config.address = config.server_address;
+  server_config.completion_queues = config.grpc_queues;
+  server_config.handler_threads = config.grpc_threads;
+  retrovue::playout::PlayoutAsyncServer server(server_config, service);
+  if (!server.Start()) {
+    warm_thread.join();
+    metrics_exporter->Stop();
+    return;
+  }
+
+  // Serve while the last run's channels come back, each reporting its own
+  // readiness (GetChannelStatus, WatchChannels, /metrics)
+  std::thread restore_thread([engine] { engine->RestoreChannels(); });
 
-  // Start the server
-  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
-  
   std::cout << "==============================================================" << std::endl;
   std::cout << "RetroVue Playout Engine (Phase 3)" << std::endl;
   std::cout << "==============================================================" << std::endl;
-  std::cout << "gRPC Server: " << config.server_address << std::endl;
+  std::cout << "gRPC Server: " << config.server_address << " (async, " << config.grpc_threads
+            << " handler threads)" << std::endl;
   std::cout << "API Version: 1.0.0" << std::endl;
   std::cout << "gRPC Health Check: Enabled" << std::endl;
   std::cout << "gRPC Reflection: " << (config.enable_reflection ? "Enabled" : "Disabled") << std::endl;
@@ -104,10 +393,104 @@ void RunServer(const ServerConfig& config) {
   std::cout << "\nPress Ctrl+C to shutdown...\n" << std::endl;
 
   // Wait for the server to shutdown
-  server->Wait();
+  server.Wait();
+  restore_thread.join();
+  warm_thread.join();
   
   // Cleanup metrics exporter
   metrics_exporter->Stop();
+  if (thumbnails) {
+    thumbnails->Stop();
+  }
+  if (disciplined_clock) {
+    disciplined_clock->Stop();
+  }
+  if (executor) {
+    executor->Stop();
+  }
+  if (scheduler) {
+    scheduler->Stop();
+  }
+}
+
+// Renders config.offline_input on one channel as fast as the host decodes
+// it: the offline clock jumps to each frame's deadline instead of waiting
+// for it, so every frame is presented on time and none is dropped, and the
+// frames are written to config.offline_output. Returns the exit code.
+int RunOffline(const ServerConfig& config) {
+  if (config.offline_output == "-") {
+    // The frames own stdout; log lines go to stderr
+    std::cout.rdbuf(std::cerr.rdbuf());
+  }
+
+  auto metrics_exporter =
+      std::make_shared<retrovue::telemetry::MetricsExporter>(9308, /*enable_http=*/false);
+  if (!metrics_exporter->Start(/*start_http_server=*/false)) {
+    std::cerr << "Failed to start metrics exporter" << std::endl;
+    return 1;
+  }
+
+  const int64_t epoch_utc_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+  std::shared_ptr<retrovue::timing::MasterClock> offline_clock =
+      retrovue::timing::MakeOfflineMasterClock(epoch_utc_us);
+
+  // No executor: its timers would run on the wall clock
+  auto engine = std::make_shared<retrovue::runtime::PlayoutEngine>(
+      metrics_exporter, offline_clock, config.decode_budget, config.read_ahead_bytes, nullptr,
+      config.placement, config.buffer, config.shed, config.capacity);
+  engine->SetEncoderThreadBudget(
+      std::make_shared<retrovue::playout_sinks::mpegts::EncoderThreadBudget>(
+          config.encoder_threads));
+  auto sink = std::make_shared<retrovue::renderer::Y4mFileSink>(config.offline_output);
+  engine->SetChannelSinkFactory(
+      [sink](int32_t, int32_t) -> std::shared_ptr<retrovue::renderer::FrameSink> { return sink; });
+
+  constexpr int32_t kOfflineChannel = 0;
+  const auto started = std::chrono::steady_clock::now();
+  const auto result = engine->StartChannel(kOfflineChannel, config.offline_input, 0);
+  if (!result.success) {
+    std::cerr << "Offline render failed to start: " << result.message << std::endl;
+    metrics_exporter->Stop();
+    return 1;
+  }
+
+  // Done once the producer reached the end of its input and the renderer
+  // has taken every frame it queued
+  retrovue::runtime::ChannelTimingReport timing;
+  while (true) {
+    retrovue::runtime::ChannelBufferReport buffer;
+    if (!engine->GetChannelTiming(kOfflineChannel, timing) ||
+        !engine->GetChannelBuffer(kOfflineChannel, buffer)) {
+      break;
+    }
+    if (!timing.producer_running && buffer.depth_frames == 0) {
+      break;
+    }
+    if (sink->GetStats().write_failed) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  engine->StopChannel(kOfflineChannel);
+  const double elapsed_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  metrics_exporter->Stop();
+
+  const retrovue::renderer::Y4mFileSinkStats stats = sink->GetStats();
+  const double rendered_s =
+      static_cast<double>(offline_clock->now_utc_us() - epoch_utc_us) / 1'000'000.0;
+  std::cout << "Offline render: " << stats.frames_written << " frames (" << rendered_s
+            << " s of output) in " << elapsed_s << " s, "
+            << (elapsed_s > 0.0 ? static_cast<double>(stats.frames_written) / elapsed_s : 0.0)
+            << " frames/s, " << (elapsed_s > 0.0 ? rendered_s / elapsed_s : 0.0)
+            << "x real time -> " << config.offline_output << std::endl;
+  if (stats.frames_written != timing.frames_produced || stats.frames_rejected > 0) {
+    std::cerr << "Offline render: " << timing.frames_produced << " frames decoded, "
+              << stats.frames_rejected << " not written (frame size changed)" << std::endl;
+  }
+  return stats.write_failed ? 1 : 0;
 }
 
 }  // namespace
@@ -115,6 +498,9 @@ void RunServer(const ServerConfig& config) {
 int main(int argc, char** argv) {
   try {
     ServerConfig config = ParseArgs(argc, argv);
+    if (!config.offline_input.empty()) {
+      return RunOffline(config);
+    }
     RunServer(config);
     return 0;
   } catch (const std::exception& e) {
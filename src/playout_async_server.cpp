@@ -0,0 +1,554 @@
+// Repository: Retrovue-playout
+// Component: PlayoutControl Async gRPC Server
+// Purpose: Serves PlayoutControl on completion queues with a handler pool.
+// Copyright (c) 2025 RetroVue
+
+#include "playout_async_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+namespace retrovue
+{
+  namespace playout
+  {
+
+    namespace
+    {
+      // Calls still running this long after Shutdown() are cancelled
+      constexpr auto kShutdownGrace = std::chrono::seconds(5);
+    } // namespace
+
+    // A call in flight; its address is the completion-queue tag.
+    class PlayoutAsyncServer::Call
+    {
+    public:
+      virtual ~Call() = default;
+      virtual void Proceed(bool ok) = 0;
+    };
+
+    // UnaryCall listens for one call of an RPC. When it arrives, a listener for
+    // the next call takes its place and the handler pool runs the
+    // PlayoutControlImpl method, then finishes the call; the Finish()
+    // completion deletes it.
+    template <typename Request, typename Response>
+    class PlayoutAsyncServer::UnaryCall final : public PlayoutAsyncServer::Call
+    {
+    public:
+      using RequestMethod = void (PlayoutControl::AsyncService::*)(
+          grpc::ServerContext *, Request *, grpc::ServerAsyncResponseWriter<Response> *,
+          grpc::CompletionQueue *, grpc::ServerCompletionQueue *, void *);
+      using HandleMethod = grpc::Status (PlayoutControlImpl::*)(grpc::ServerContext *,
+                                                                const Request *, Response *);
+
+      UnaryCall(PlayoutAsyncServer *server, grpc::ServerCompletionQueue *cq,
+                RequestMethod request_method, HandleMethod handle_method)
+          : server_(server),
+            cq_(cq),
+            request_method_(request_method),
+            handle_method_(handle_method),
+            responder_(&context_)
+      {
+        (server_->service_.*request_method_)(&context_, &request_, &responder_, cq_, cq_, this);
+      }
+
+      void Proceed(bool ok) override
+      {
+        // !ok: the server shut down before a call came
+        if (finishing_ || !ok)
+        {
+          delete this;
+          return;
+        }
+        const bool dispatched = server_->Dispatch(
+            [this]
+            { new UnaryCall(server_, cq_, request_method_, handle_method_); },
+            [this]
+            {
+              const grpc::Status status =
+                  (server_->handler_.*handle_method_)(&context_, &request_, &response_);
+              finishing_ = true;
+              responder_.Finish(response_, status, this);
+            });
+        if (!dispatched)
+        {
+          delete this; // Shutting down; the server cancels the call
+        }
+      }
+
+    private:
+      PlayoutAsyncServer *server_;
+      grpc::ServerCompletionQueue *cq_;
+      const RequestMethod request_method_;
+      const HandleMethod handle_method_;
+      grpc::ServerContext context_;
+      Request request_;
+      Response response_;
+      grpc::ServerAsyncResponseWriter<Response> responder_;
+      bool finishing_ = false;
+    };
+
+    // WatchCall serves one WatchChannels stream. Once the call arrives it opens
+    // a watch and joins the watch thread, which writes its due events one at a
+    // time. The call ends when the client goes away (the done tag) or the
+    // server stops (Finish); it is deleted once neither a write, a finish nor
+    // its setup is in flight and the done tag has come.
+    class PlayoutAsyncServer::WatchCall final : public PlayoutAsyncServer::Call
+    {
+    public:
+      WatchCall(PlayoutAsyncServer *server, grpc::ServerCompletionQueue *cq)
+          : server_(server), cq_(cq), writer_(&context_), done_(this)
+      {
+        // Delivered only for calls that arrive
+        context_.AsyncNotifyWhenDone(&done_);
+        server_->service_.RequestWatchChannels(&context_, &request_, &writer_, cq_, cq_, this);
+      }
+
+      // The call arrived, or a write or finish completed.
+      void Proceed(bool ok) override
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (step_ == Step::kListening)
+        {
+          lock.unlock();
+          Open(ok);
+          return;
+        }
+        in_flight_ = false;
+        if (!ok)
+        {
+          CloseLocked(); // The client is gone; the done tag follows
+        }
+        const bool release = step_ == Step::kFinishing && done_seen_;
+        lock.unlock();
+        if (release)
+        {
+          Release();
+          return;
+        }
+        server_->WakeWatches();
+      }
+
+      // From the watch thread, under its lock: issues the next write (or,
+      // when stopping, the finish). Returns false once the call is finishing.
+      bool Pump(bool stopping, telemetry::ChannelWatch::Clock::time_point &next_due)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (step_ == Step::kFinishing)
+        {
+          return false;
+        }
+        if (in_flight_)
+        {
+          return true; // Woken again by its completion
+        }
+        if (stopping)
+        {
+          CloseLocked();
+          in_flight_ = true;
+          writer_.Finish(grpc::Status::OK, this);
+          return false;
+        }
+        telemetry::ChannelStatusEvent event;
+        telemetry::ChannelWatch::Clock::time_point due;
+        if (!watch_->Poll(event, due))
+        {
+          next_due = std::min(next_due, due);
+          return true;
+        }
+        PlayoutControlImpl::FillStatusEvent(event, &update_);
+        in_flight_ = true;
+        writer_.Write(update_, this);
+        return true;
+      }
+
+    private:
+      enum class Step
+      {
+        kListening,
+        kStreaming,
+        kFinishing,
+      };
+
+      // Its own tag, so the done notification is told apart from writes.
+      class DoneTag final : public Call
+      {
+      public:
+        explicit DoneTag(WatchCall *call) : call_(call) {}
+        void Proceed(bool) override { call_->OnDone(); }
+
+      private:
+        WatchCall *call_;
+      };
+
+      void Open(bool ok)
+      {
+        // !ok: the server shut down before a call came
+        if (!ok)
+        {
+          delete this;
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          step_ = Step::kStreaming;
+          in_flight_ = true; // Holds the call until it is set up
+        }
+        std::shared_ptr<telemetry::ChannelWatch> watch;
+        if (server_->Relisten([this]
+                              { new WatchCall(server_, cq_); }))
+        {
+          watch = server_->handler_.OpenWatch(request_);
+        }
+        if (watch)
+        {
+          watch->SetReadyCallback([server = server_]
+                                  { server->WakeWatches(); });
+          std::lock_guard<std::mutex> lock(mutex_);
+          watch_ = watch;
+        }
+        const bool added = watch && server_->AddWatch(this);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        in_flight_ = false;
+        if (done_seen_)
+        {
+          CloseLocked();
+          lock.unlock();
+          Release(); // The client left during setup
+          return;
+        }
+        if (!added)
+        {
+          CloseLocked();
+          in_flight_ = true;
+          writer_.Finish(grpc::Status(grpc::StatusCode::UNAVAILABLE, "Server is shutting down"),
+                         this);
+          return;
+        }
+        lock.unlock();
+        server_->WakeWatches(); // Its first events are already due
+      }
+
+      void OnDone()
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_seen_ = true;
+        CloseLocked();
+        const bool release = !in_flight_;
+        lock.unlock();
+        if (release)
+        {
+          Release();
+        }
+      }
+
+      void CloseLocked()
+      {
+        step_ = Step::kFinishing;
+        if (watch_)
+        {
+          watch_->Close();
+        }
+      }
+
+      void Release()
+      {
+        server_->RemoveWatch(this);
+        delete this;
+      }
+
+      PlayoutAsyncServer *server_;
+      grpc::ServerCompletionQueue *cq_;
+      grpc::ServerContext context_;
+      WatchChannelsRequest request_;
+      ChannelStatusEvent update_;
+      grpc::ServerAsyncWriter<ChannelStatusEvent> writer_;
+      DoneTag done_;
+
+      std::mutex mutex_;
+      Step step_ = Step::kListening;
+      bool in_flight_ = false; // A write, a finish or the setup
+      bool done_seen_ = false;
+      std::shared_ptr<telemetry::ChannelWatch> watch_;
+    };
+
+    PlayoutAsyncServer::PlayoutAsyncServer(const Config &config, PlayoutControlImpl &handler)
+        : config_(config), handler_(handler)
+    {
+    }
+
+    PlayoutAsyncServer::~PlayoutAsyncServer()
+    {
+      Shutdown();
+    }
+
+    bool PlayoutAsyncServer::Start()
+    {
+      if (server_)
+      {
+        return true;
+      }
+      const size_t queue_count = std::max<size_t>(1, config_.completion_queues);
+      const size_t handler_count = std::max<size_t>(1, config_.handler_threads);
+
+      grpc::ServerBuilder builder;
+      builder.AddListeningPort(config_.address, grpc::InsecureServerCredentials());
+      builder.RegisterService(&service_);
+      for (size_t i = 0; i < queue_count; ++i)
+      {
+        queues_.push_back(builder.AddCompletionQueue());
+      }
+      server_ = builder.BuildAndStart();
+      if (!server_)
+      {
+        std::cerr << "[PlayoutAsyncServer] Failed to start on " << config_.address << std::endl;
+        for (auto &cq : queues_)
+        {
+          cq->Shutdown();
+          void *tag = nullptr;
+          bool ok = false;
+          while (cq->Next(&tag, &ok))
+          {
+          }
+        }
+        queues_.clear();
+        return false;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(watches_mutex_);
+        watches_stopping_ = false;
+      }
+      watch_thread_ = std::thread([this]
+                                  { WatchLoop(); });
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accepting_ = true;
+        for (auto &cq : queues_)
+        {
+          ListenAll(cq.get());
+        }
+      }
+      for (size_t i = 0; i < handler_count; ++i)
+      {
+        handlers_.emplace_back([this]
+                               { HandlerLoop(); });
+      }
+      for (auto &cq : queues_)
+      {
+        grpc::ServerCompletionQueue *queue = cq.get();
+        pollers_.emplace_back([this, queue]
+                              { PollLoop(queue); });
+      }
+
+      std::cout << "[PlayoutAsyncServer] Serving on " << config_.address << " with "
+                << queue_count << " completion queues and " << handler_count
+                << " handler threads" << std::endl;
+      return true;
+    }
+
+    void PlayoutAsyncServer::Wait()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      shutdown_cv_.wait(lock, [this]
+                        { return shut_down_ || !server_; });
+    }
+
+    void PlayoutAsyncServer::Shutdown()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!accepting_)
+        {
+          return;
+        }
+        // Calls arriving from here on are dropped; queued handlers still run
+        accepting_ = false;
+        stop_handlers_ = true;
+      }
+      work_cv_.notify_all();
+      {
+        // Open streams finish; the watch thread exits once they have
+        std::lock_guard<std::mutex> lock(watches_mutex_);
+        watches_stopping_ = true;
+      }
+      watches_cv_.notify_all();
+
+      server_->Shutdown(std::chrono::system_clock::now() + kShutdownGrace);
+      watch_thread_.join();
+      for (auto &thread : handlers_)
+      {
+        thread.join();
+      }
+      handlers_.clear();
+
+      // Every handler has finished its call; the queues drain their last tags
+      for (auto &cq : queues_)
+      {
+        cq->Shutdown();
+      }
+      for (auto &thread : pollers_)
+      {
+        thread.join();
+      }
+      pollers_.clear();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shut_down_ = true;
+      }
+      shutdown_cv_.notify_all();
+      std::cout << "[PlayoutAsyncServer] Stopped" << std::endl;
+    }
+
+    void PlayoutAsyncServer::ListenAll(grpc::ServerCompletionQueue *cq)
+    {
+      using AsyncService = PlayoutControl::AsyncService;
+      new UnaryCall<StartChannelRequest, StartChannelResponse>(
+          this, cq, &AsyncService::RequestStartChannel, &PlayoutControlImpl::StartChannel);
+      new UnaryCall<UpdatePlanRequest, UpdatePlanResponse>(
+          this, cq, &AsyncService::RequestUpdatePlan, &PlayoutControlImpl::UpdatePlan);
+      new UnaryCall<ResizeBufferRequest, ResizeBufferResponse>(
+          this, cq, &AsyncService::RequestResizeBuffer, &PlayoutControlImpl::ResizeBuffer);
+      new UnaryCall<StopChannelRequest, StopChannelResponse>(
+          this, cq, &AsyncService::RequestStopChannel, &PlayoutControlImpl::StopChannel);
+      new UnaryCall<ApiVersionRequest, ApiVersion>(
+          this, cq, &AsyncService::RequestGetVersion, &PlayoutControlImpl::GetVersion);
+      new UnaryCall<LoadPreviewRequest, LoadPreviewResponse>(
+          this, cq, &AsyncService::RequestLoadPreview, &PlayoutControlImpl::LoadPreview);
+      new UnaryCall<SwitchToLiveRequest, SwitchToLiveResponse>(
+          this, cq, &AsyncService::RequestSwitchToLive, &PlayoutControlImpl::SwitchToLive);
+      new UnaryCall<StartChannelsRequest, StartChannelsResponse>(
+          this, cq, &AsyncService::RequestStartChannels, &PlayoutControlImpl::StartChannels);
+      new UnaryCall<StopChannelsRequest, StopChannelsResponse>(
+          this, cq, &AsyncService::RequestStopChannels, &PlayoutControlImpl::StopChannels);
+      new UnaryCall<LoadPreviewsRequest, LoadPreviewsResponse>(
+          this, cq, &AsyncService::RequestLoadPreviews, &PlayoutControlImpl::LoadPreviews);
+      new UnaryCall<HostCapacityRequest, HostCapacityResponse>(
+          this, cq, &AsyncService::RequestGetHostCapacity, &PlayoutControlImpl::GetHostCapacity);
+      new WatchCall(this, cq);
+    }
+
+    void PlayoutAsyncServer::PollLoop(grpc::ServerCompletionQueue *cq)
+    {
+      void *tag = nullptr;
+      bool ok = false;
+      // Next() returns false once the queue is shut down and drained
+      while (cq->Next(&tag, &ok))
+      {
+        static_cast<Call *>(tag)->Proceed(ok);
+      }
+    }
+
+    void PlayoutAsyncServer::HandlerLoop()
+    {
+      while (true)
+      {
+        std::function<void()> handle;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          work_cv_.wait(lock, [this]
+                        { return stop_handlers_ || !work_.empty(); });
+          if (work_.empty())
+          {
+            return;
+          }
+          handle = std::move(work_.front());
+          work_.pop_front();
+        }
+        handle();
+      }
+    }
+
+    bool PlayoutAsyncServer::Dispatch(const std::function<void()> &listen,
+                                      std::function<void()> handle)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!accepting_)
+        {
+          return false;
+        }
+        listen();
+        work_.push_back(std::move(handle));
+      }
+      work_cv_.notify_one();
+      return true;
+    }
+
+    bool PlayoutAsyncServer::Relisten(const std::function<void()> &listen)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!accepting_)
+      {
+        return false;
+      }
+      listen();
+      return true;
+    }
+
+    void PlayoutAsyncServer::WatchLoop()
+    {
+      std::unique_lock<std::mutex> lock(watches_mutex_);
+      while (true)
+      {
+        watches_wake_ = false;
+        const bool stopping = watches_stopping_;
+        auto next_due = telemetry::ChannelWatch::Clock::time_point::max();
+        watch_calls_.erase(std::remove_if(watch_calls_.begin(), watch_calls_.end(),
+                                          [&](WatchCall *call)
+                                          { return !call->Pump(stopping, next_due); }),
+                           watch_calls_.end());
+        if (stopping && watch_calls_.empty())
+        {
+          return;
+        }
+        const auto woken = [this, stopping]
+        { return watches_wake_ || watches_stopping_ != stopping; };
+        if (next_due == telemetry::ChannelWatch::Clock::time_point::max())
+        {
+          watches_cv_.wait(lock, woken);
+        }
+        else
+        {
+          watches_cv_.wait_until(lock, next_due, woken);
+        }
+      }
+    }
+
+    bool PlayoutAsyncServer::AddWatch(WatchCall *call)
+    {
+      std::lock_guard<std::mutex> lock(watches_mutex_);
+      if (watches_stopping_)
+      {
+        return false;
+      }
+      watch_calls_.push_back(call);
+      return true;
+    }
+
+    void PlayoutAsyncServer::RemoveWatch(WatchCall *call)
+    {
+      {
+        std::lock_guard<std::mutex> lock(watches_mutex_);
+        watch_calls_.erase(std::remove(watch_calls_.begin(), watch_calls_.end(), call),
+                           watch_calls_.end());
+        watches_wake_ = true;
+      }
+      watches_cv_.notify_all();
+    }
+
+    void PlayoutAsyncServer::WakeWatches()
+    {
+      {
+        std::lock_guard<std::mutex> lock(watches_mutex_);
+        watches_wake_ = true;
+      }
+      watches_cv_.notify_all();
+    }
+
+  } // namespace playout
+} // namespace retrovue
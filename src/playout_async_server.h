@@ -0,0 +1,124 @@
+// Repository: Retrovue-playout
+// Component: PlayoutControl Async gRPC Server
+// Purpose: Serves PlayoutControl on completion queues with a handler pool.
+// Copyright (c) 2025 RetroVue
+
+#ifndef RETROVUE_PLAYOUT_ASYNC_SERVER_H_
+#define RETROVUE_PLAYOUT_ASYNC_SERVER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+#include "playout.grpc.pb.h"
+#include "playout_service.h"
+
+namespace retrovue {
+namespace playout {
+
+// PlayoutAsyncServer serves PlayoutControl through the async gRPC API.
+//
+// The synchronous server parks a thread per in-flight RPC; a StartChannel
+// waits out its producer's start, so a controller bringing up hundreds of
+// channels would need as many server threads. Here a few poller threads
+// drain the completion queues and never block: each arriving call is handed
+// to a fixed handler pool, which runs the PlayoutControlImpl method and
+// finishes the call. The handler pool bounds how many RPCs run at once; the
+// batch RPCs (StartChannels, ...) start many channels from one call.
+//
+// WatchChannels streams hold no handler: one watch thread writes each
+// stream's due events, one write in flight per stream, and sleeps until a
+// watch has an event or a coalescing interval runs out.
+//
+// Thread Model: Start(), Wait() and Shutdown() from the owning thread.
+// Shutdown() may also come from another thread while Wait() blocks.
+class PlayoutAsyncServer {
+ public:
+  struct Config {
+    std::string address = "0.0.0.0:50051";
+    size_t completion_queues = 2;  // One poller thread each
+    size_t handler_threads = 16;   // RPCs running at once
+  };
+
+  // handler must outlive the server.
+  PlayoutAsyncServer(const Config& config, PlayoutControlImpl& handler);
+  ~PlayoutAsyncServer();
+
+  PlayoutAsyncServer(const PlayoutAsyncServer&) = delete;
+  PlayoutAsyncServer& operator=(const PlayoutAsyncServer&) = delete;
+
+  // Binds the address and starts the poller and handler threads. Returns
+  // false if the server cannot be built (the address is taken, ...).
+  bool Start();
+
+  // Blocks until Shutdown().
+  void Wait();
+
+  // Stops taking calls, ends the watch streams, lets running handlers
+  // finish (calls still running after a grace period are cancelled) and
+  // joins every thread.
+  void Shutdown();
+
+ private:
+  class Call;
+  template <typename Request, typename Response>
+  class UnaryCall;
+  class WatchCall;
+
+  // Posts a listener for every RPC on cq.
+  void ListenAll(grpc::ServerCompletionQueue* cq);
+
+  void PollLoop(grpc::ServerCompletionQueue* cq);
+  void HandlerLoop();
+
+  // Queues a handler and, first, a listener for the next call (via listen),
+  // atomically with respect to Shutdown(). Returns false once shut down.
+  bool Dispatch(const std::function<void()>& listen, std::function<void()> handle);
+
+  // Posts a listener for the next call unless shut down (false).
+  bool Relisten(const std::function<void()>& listen);
+
+  // Watch streams: added once open, removed before they are deleted.
+  // AddWatch() returns false once the watch thread is stopping.
+  void WatchLoop();
+  bool AddWatch(WatchCall* call);
+  void RemoveWatch(WatchCall* call);
+  void WakeWatches();
+
+  const Config config_;
+  PlayoutControlImpl& handler_;
+  PlayoutControl::AsyncService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> queues_;
+  std::vector<std::thread> pollers_;
+  std::vector<std::thread> handlers_;
+  std::thread watch_thread_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable shutdown_cv_;
+  std::deque<std::function<void()>> work_;
+  bool accepting_ = false;    // New calls are listened for and handled
+  bool stop_handlers_ = false;
+  bool shut_down_ = false;
+
+  // Lock order: watches_mutex_, then a WatchCall's own mutex
+  std::mutex watches_mutex_;
+  std::condition_variable watches_cv_;
+  std::vector<WatchCall*> watch_calls_;
+  bool watches_wake_ = false;
+  bool watches_stopping_ = false;
+};
+
+}  // namespace playout
+}  // namespace retrovue
+
+#endif  // RETROVUE_PLAYOUT_ASYNC_SERVER_H_
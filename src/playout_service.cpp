@@ -5,10 +5,12 @@
 
 #include "playout_service.h"
 
+#include <chrono>
 #include <iostream>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace retrovue
 {
@@ -18,6 +20,28 @@ namespace retrovue
     namespace
     {
       constexpr char kApiVersion[] = "1.0.0";
+
+      // How often a synchronous WatchChannels looks for cancellation
+      constexpr auto kWatchCancelPoll = std::chrono::milliseconds(100);
+
+      runtime::ChannelStartRequest ToStartRequest(const StartChannelRequest &request)
+      {
+        runtime::ChannelStartRequest start;
+        start.channel_id = request.channel_id();
+        start.plan_handle = request.plan_handle();
+        start.port = request.port();
+        start.placement.cpus.assign(request.cpu_set().begin(), request.cpu_set().end());
+        if (request.has_numa_node()) {
+          start.placement.numa_node = request.numa_node();
+        }
+        start.placement.pacing_priority = request.pacing_priority();
+        start.buffer.latency_ms = request.buffer_latency_ms();
+        start.buffer.width = request.frame_width();
+        start.buffer.height = request.frame_height();
+        start.priority = request.priority();
+        start.timeline_origin_utc_us = request.timeline_origin_utc_us();
+        return start;
+      }
     } // namespace
 
     PlayoutControlImpl::PlayoutControlImpl(
@@ -37,17 +61,17 @@ namespace retrovue
                                                   const StartChannelRequest *request,
                                                   StartChannelResponse *response)
     {
-      const int32_t channel_id = request->channel_id();
-      const std::string &plan_handle = request->plan_handle();
-      const int32_t port = request->port();
-      // UDS path is optional - check if field exists in proto
-      std::optional<std::string> uds_path = std::nullopt;
+      // UDS path is optional - not in the proto yet
+      const runtime::ChannelStartRequest start = ToStartRequest(*request);
+      const int32_t channel_id = start.channel_id;
 
       std::cout << "[StartChannel] Request received: channel_id=" << channel_id
-                << ", plan_handle=" << plan_handle << ", port=" << port << std::endl;
+                << ", plan_handle=" << start.plan_handle << ", port=" << start.port << std::endl;
 
       // Delegate to controller
-      auto result = controller_->StartChannel(channel_id, plan_handle, port, uds_path);
+      auto result = controller_->StartChannel(channel_id, start.plan_handle, start.port,
+                                              start.uds_path, start.placement, start.buffer,
+                                              start.priority, start.timeline_origin_utc_us);
       
       response->set_success(result.success);
       response->set_message(result.message);
@@ -94,6 +118,34 @@ namespace retrovue
       return grpc::Status::OK;
     }
 
+    grpc::Status PlayoutControlImpl::ResizeBuffer(grpc::ServerContext *context,
+                                                  const ResizeBufferRequest *request,
+                                                  ResizeBufferResponse *response)
+    {
+      const int32_t channel_id = request->channel_id();
+      const int64_t latency_ms = request->buffer_latency_ms();
+
+      std::cout << "[ResizeBuffer] Request received: channel_id=" << channel_id
+                << ", buffer_latency_ms=" << latency_ms << std::endl;
+
+      // Delegate to controller
+      auto result = controller_->ResizeBuffer(channel_id, latency_ms);
+
+      response->set_success(result.success);
+      response->set_message(result.message);
+
+      if (!result.success) {
+        grpc::StatusCode code = grpc::StatusCode::RESOURCE_EXHAUSTED;
+        if (result.message.find("not found") != std::string::npos) {
+          code = grpc::StatusCode::NOT_FOUND;
+        }
+        return grpc::Status(code, result.message);
+      }
+
+      std::cout << "[ResizeBuffer] " << result.message << std::endl;
+      return grpc::Status::OK;
+    }
+
     grpc::Status PlayoutControlImpl::StopChannel(grpc::ServerContext *context,
                                                  const StopChannelRequest *request,
                                                  StopChannelResponse *response)
@@ -196,6 +248,170 @@ namespace retrovue
       return grpc::Status::OK;
     }
 
+    grpc::Status PlayoutControlImpl::StartChannels(grpc::ServerContext *context,
+                                                   const StartChannelsRequest *request,
+                                                   StartChannelsResponse *response)
+    {
+      std::vector<runtime::ChannelStartRequest> starts;
+      starts.reserve(request->channels_size());
+      for (const StartChannelRequest &channel : request->channels())
+      {
+        starts.push_back(ToStartRequest(channel));
+      }
+      std::cout << "[StartChannels] Request received: " << starts.size() << " channels" << std::endl;
+
+      // Delegate to controller; entries run in parallel and fail independently
+      size_t started = 0;
+      for (const auto &result : controller_->StartChannels(starts))
+      {
+        StartChannelResponse *entry = response->add_results();
+        entry->set_success(result.success);
+        entry->set_message(result.message);
+        started += result.success ? 1 : 0;
+      }
+
+      std::cout << "[StartChannels] " << started << "/" << starts.size()
+                << " channels started" << std::endl;
+      return grpc::Status::OK;
+    }
+
+    grpc::Status PlayoutControlImpl::StopChannels(grpc::ServerContext *context,
+                                                  const StopChannelsRequest *request,
+                                                  StopChannelsResponse *response)
+    {
+      const std::vector<int32_t> channel_ids(request->channel_ids().begin(),
+                                             request->channel_ids().end());
+      std::cout << "[StopChannels] Request received: " << channel_ids.size() << " channels"
+                << std::endl;
+
+      size_t stopped = 0;
+      for (const auto &result : controller_->StopChannels(channel_ids))
+      {
+        StopChannelResponse *entry = response->add_results();
+        entry->set_success(result.success);
+        entry->set_message(result.message);
+        stopped += result.success ? 1 : 0;
+      }
+
+      std::cout << "[StopChannels] " << stopped << "/" << channel_ids.size()
+                << " channels stopped" << std::endl;
+      return grpc::Status::OK;
+    }
+
+    grpc::Status PlayoutControlImpl::LoadPreviews(grpc::ServerContext *context,
+                                                  const LoadPreviewsRequest *request,
+                                                  LoadPreviewsResponse *response)
+    {
+      std::vector<runtime::ChannelPreviewRequest> previews;
+      previews.reserve(request->previews_size());
+      for (const LoadPreviewRequest &preview : request->previews())
+      {
+        runtime::ChannelPreviewRequest load;
+        load.channel_id = preview.channel_id();
+        load.asset_path = preview.asset_path();
+        previews.push_back(std::move(load));
+      }
+      std::cout << "[LoadPreviews] Request received: " << previews.size() << " channels"
+                << std::endl;
+
+      size_t loaded = 0;
+      for (const auto &result : controller_->LoadPreviews(previews))
+      {
+        LoadPreviewResponse *entry = response->add_results();
+        entry->set_success(result.success);
+        entry->set_message(result.message);
+        entry->set_shadow_decode_started(result.shadow_decode_started);
+        loaded += result.success ? 1 : 0;
+      }
+
+      std::cout << "[LoadPreviews] " << loaded << "/" << previews.size()
+                << " previews loaded" << std::endl;
+      return grpc::Status::OK;
+    }
+
+    grpc::Status PlayoutControlImpl::GetHostCapacity(grpc::ServerContext *context,
+                                                     const HostCapacityRequest *request,
+                                                     HostCapacityResponse *response)
+    {
+      const runtime::HostCapacityReport report = controller_->GetHostCapacity();
+      response->set_host_id(report.host_id);
+      response->set_cpu_cores(report.cpu_cores);
+      response->set_cpu_busy_ratio(report.cpu_busy_ratio);
+      response->set_decode_threads_total(report.decode_threads_total);
+      response->set_decode_threads_in_use(report.decode_threads_in_use);
+      response->set_encoder_slots_total(report.encoder_slots_total);
+      response->set_encoder_slots_in_use(report.encoder_slots_in_use);
+      response->set_memory_budget_bytes(report.memory_budget_bytes);
+      response->set_memory_reserved_bytes(report.memory_reserved_bytes);
+      response->set_clock_disciplined(report.clock_disciplined);
+      response->set_clock_locked(report.clock_locked);
+      response->set_clock_offset_us(report.clock_offset_us);
+      for (const auto &channel : report.channels)
+      {
+        HostChannel *entry = response->add_channels();
+        entry->set_channel_id(channel.channel_id);
+        entry->set_plan_handle(channel.plan_handle);
+        entry->set_priority(channel.priority);
+        entry->set_timeline_origin_utc_us(channel.timeline_origin_utc_us);
+        entry->set_decode_threads(channel.decode_threads);
+        entry->set_reserved_bytes(channel.reserved_bytes);
+      }
+      return grpc::Status::OK;
+    }
+
+    grpc::Status PlayoutControlImpl::WatchChannels(grpc::ServerContext *context,
+                                                   const WatchChannelsRequest *request,
+                                                   grpc::ServerWriter<ChannelStatusEvent> *writer)
+    {
+      const auto watch = OpenWatch(*request);
+      telemetry::ChannelStatusEvent event;
+      ChannelStatusEvent message;
+      while (!context->IsCancelled())
+      {
+        if (!watch->Next(event, kWatchCancelPoll))
+        {
+          continue;
+        }
+        FillStatusEvent(event, &message);
+        if (!writer->Write(message))
+        {
+          break; // Client gone
+        }
+      }
+      watch->Close();
+      std::cout << "[WatchChannels] Watch ended" << std::endl;
+      return grpc::Status::OK;
+    }
+
+    std::shared_ptr<telemetry::ChannelWatch> PlayoutControlImpl::OpenWatch(
+        const WatchChannelsRequest &request)
+    {
+      const std::vector<int32_t> channel_ids(request.channel_ids().begin(),
+                                             request.channel_ids().end());
+      std::cout << "[WatchChannels] Watch opened: "
+                << (channel_ids.empty() ? std::string("all") : std::to_string(channel_ids.size()))
+                << " channels, min interval " << request.min_interval_ms() << " ms" << std::endl;
+      return controller_->WatchChannels(channel_ids,
+                                        std::chrono::milliseconds(request.min_interval_ms()));
+    }
+
+    void PlayoutControlImpl::FillStatusEvent(const telemetry::ChannelStatusEvent &event,
+                                             ChannelStatusEvent *message)
+    {
+      const telemetry::ChannelStatus &status = event.status;
+      message->set_channel_id(status.channel_id);
+      message->set_timestamp_us(status.timestamp_us);
+      message->set_state(telemetry::ChannelStateToString(status.state));
+      message->set_control_state(status.control_state);
+      message->set_state_changed(event.state_changed);
+      message->set_removed(status.removed);
+      message->set_buffer_depth_frames(status.buffer_depth_frames);
+      message->set_underruns(event.underruns);
+      message->set_late_frames(event.late_frames);
+      message->set_underruns_total(status.underruns_total);
+      message->set_late_frames_total(status.late_frames_total);
+      message->set_coalesced(event.coalesced);
+    }
 
   } // namespace playout
 } // namespace retrovue
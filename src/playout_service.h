@@ -19,6 +19,7 @@
 #include "playout.grpc.pb.h"
 #include "playout.pb.h"
 #include "retrovue/runtime/PlayoutController.h"
+#include "retrovue/telemetry/ChannelWatch.h"
 #include "retrovue/telemetry/MetricsExporter.h"
 #include "retrovue/timing/MasterClock.h"
 
@@ -46,6 +47,10 @@ class PlayoutControlImpl final : public PlayoutControl::Service {
                           const UpdatePlanRequest* request,
                           UpdatePlanResponse* response) override;
 
+  grpc::Status ResizeBuffer(grpc::ServerContext* context,
+                            const ResizeBufferRequest* request,
+                            ResizeBufferResponse* response) override;
+
   grpc::Status StopChannel(grpc::ServerContext* context,
                            const StopChannelRequest* request,
                            StopChannelResponse* response) override;
@@ -62,6 +67,37 @@ class PlayoutControlImpl final : public PlayoutControl::Service {
                             const SwitchToLiveRequest* request,
                             SwitchToLiveResponse* response) override;
 
+  // Batch RPCs: every entry runs (in parallel, in the engine) and reports
+  // its own outcome; the call itself fails only if it cannot run.
+  grpc::Status StartChannels(grpc::ServerContext* context,
+                             const StartChannelsRequest* request,
+                             StartChannelsResponse* response) override;
+
+  grpc::Status StopChannels(grpc::ServerContext* context,
+                            const StopChannelsRequest* request,
+                            StopChannelsResponse* response) override;
+
+  grpc::Status LoadPreviews(grpc::ServerContext* context,
+                            const LoadPreviewsRequest* request,
+                            LoadPreviewsResponse* response) override;
+
+  grpc::Status GetHostCapacity(grpc::ServerContext* context,
+                               const HostCapacityRequest* request,
+                               HostCapacityResponse* response) override;
+
+  // Streams status changes until the client cancels (synchronous server;
+  // PlayoutAsyncServer streams from OpenWatch() itself).
+  grpc::Status WatchChannels(grpc::ServerContext* context,
+                             const WatchChannelsRequest* request,
+                             grpc::ServerWriter<ChannelStatusEvent>* writer) override;
+
+  // Opens the watch a WatchChannels call streams from.
+  std::shared_ptr<telemetry::ChannelWatch> OpenWatch(const WatchChannelsRequest& request);
+
+  // Converts a watch event to its message.
+  static void FillStatusEvent(const telemetry::ChannelStatusEvent& event,
+                              ChannelStatusEvent* message);
+
  private:
   // Controller that manages all channel lifecycle operations
   std::shared_ptr<runtime::PlayoutController> controller_;
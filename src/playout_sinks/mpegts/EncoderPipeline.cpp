@@ -5,7 +5,12 @@
 
 #include "retrovue/playout_sinks/mpegts/EncoderPipeline.hpp"
 #include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+#include "retrovue/playout_sinks/mpegts/SilentAacCache.hpp"
+#include "retrovue/buffer/FramePool.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/decode/PlaneKernels.h"
+#include "retrovue/telemetry/TraceRing.h"
 
 #include <iostream>
 #include <iomanip>
@@ -14,18 +19,138 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
 
 #ifdef RETROVUE_FFMPEG_AVAILABLE
+#include <libavutil/buffer.h>
 #include <libavutil/dict.h>
 #include <libavutil/time.h>
 #include <libavutil/mathematics.h>  // For av_rescale_q
 #include <libavutil/log.h>  // For av_log_set_level
+#include <libavutil/hwcontext.h>
 #endif
 
 namespace retrovue::playout_sinks::mpegts {
 
+const char* EncoderBackendName(EncoderBackend backend) {
+  switch (backend) {
+    case EncoderBackend::SOFTWARE:
+      return "software";
+    case EncoderBackend::NVENC:
+      return "nvenc";
+    case EncoderBackend::QSV:
+      return "qsv";
+    case EncoderBackend::VAAPI:
+      return "vaapi";
+    case EncoderBackend::AUTO:
+      return "auto";
+  }
+  return "unknown";
+}
+
 #ifdef RETROVUE_FFMPEG_AVAILABLE
 
+namespace {
+
+// Surfaces in a QSV/VAAPI upload pool (QSV needs a fixed-size pool): enough
+// for the encoder's lookahead plus the frame being uploaded.
+constexpr int kHwFramePoolSize = 16;
+
+// Backend whose encoder takes hardware frames of this pixel format as they
+// are (SOFTWARE for none).
+EncoderBackend SurfaceBackend(int format) {
+  switch (format) {
+    case AV_PIX_FMT_VAAPI:
+      return EncoderBackend::VAAPI;
+    case AV_PIX_FMT_CUDA:
+      return EncoderBackend::NVENC;
+    case AV_PIX_FMT_QSV:
+      return EncoderBackend::QSV;
+    default:
+      return EncoderBackend::SOFTWARE;
+  }
+}
+
+// The device a hardware frames context lives on, and its pixel format.
+const uint8_t* FramesDevice(const AVBufferRef* frames_ref) {
+  return reinterpret_cast<const AVHWFramesContext*>(frames_ref->data)->device_ref->data;
+}
+int FramesFormat(const AVBufferRef* frames_ref) {
+  return reinterpret_cast<const AVHWFramesContext*>(frames_ref->data)->format;
+}
+
+// Backends tried, in order, for a configured backend.
+std::vector<EncoderBackend> EncoderCandidates(EncoderBackend backend) {
+  if (backend == EncoderBackend::AUTO) {
+    return {EncoderBackend::NVENC, EncoderBackend::QSV, EncoderBackend::VAAPI,
+            EncoderBackend::SOFTWARE};
+  }
+  if (backend == EncoderBackend::SOFTWARE) {
+    return {EncoderBackend::SOFTWARE};
+  }
+  return {backend, EncoderBackend::SOFTWARE};
+}
+
+// FFmpeg encoder name of a hardware backend.
+const char* HardwareEncoderName(EncoderBackend backend, bool hevc) {
+  switch (backend) {
+    case EncoderBackend::NVENC:
+      return hevc ? "hevc_nvenc" : "h264_nvenc";
+    case EncoderBackend::QSV:
+      return hevc ? "hevc_qsv" : "h264_qsv";
+    case EncoderBackend::VAAPI:
+      return hevc ? "hevc_vaapi" : "h264_vaapi";
+    default:
+      return nullptr;
+  }
+}
+
+// Plane pointer and linesize alignment a pooled frame needs to be handed to
+// the encoder in place. The system-memory encoders (libx264, libx265,
+// NVENC) copy input pictures into their own buffers, so the 16 bytes
+// malloc guarantees is enough for their SIMD loads.
+constexpr size_t kWrapAlignment = 16;
+
+// Silent audio further than this from the video clock (a gap in the feed,
+// or a timeline jump) restarts at the video's time instead of catching up.
+constexpr int64_t kAudioResyncGap90k = 90000;
+
+// Producer audio within this of where the track has got to is appended as
+// is; a larger gap is filled with silence, a larger overlap is trimmed.
+constexpr int64_t kAudioGapTolerance90k = 1800;  // 20 ms
+
+// While producer audio is missing, the track is padded with silence to
+// this far behind the video, leaving room for late audio to still fit.
+constexpr int64_t kAudioPadLag90k = 18000;  // 200 ms
+
+// AVBuffer free callback of a wrapped pooled frame: drops the encoder's
+// reference, returning the slot to its pool.
+void ReleaseFrameHandle(void* opaque, uint8_t* data) {
+  (void)data;
+  delete static_cast<retrovue::buffer::FrameHandle*>(opaque);
+}
+
+// Unrefs an AVFrame on scope exit (null: no-op).
+struct ScopedFrameUnref {
+  AVFrame* frame;
+  ~ScopedFrameUnref() {
+    if (frame) {
+      av_frame_unref(frame);
+    }
+  }
+};
+
+// Write callback that collects the filler encoder's output.
+int AppendToBuffer(void* opaque, uint8_t* buf, int buf_size) {
+  auto* out = static_cast<std::vector<uint8_t>*>(opaque);
+  out->insert(out->end(), buf, buf + buf_size);
+  return buf_size;
+}
+
+}  // namespace
+
 EncoderPipeline::EncoderPipeline(const MpegTSPlayoutSinkConfig& config)
     : config_(config),
       initialized_(false),
@@ -39,6 +164,9 @@ EncoderPipeline::EncoderPipeline(const MpegTSPlayoutSinkConfig& config)
       frame_width_(0),
       frame_height_(0),
       input_pix_fmt_(AV_PIX_FMT_YUV420P),
+      encoder_sw_pix_fmt_(AV_PIX_FMT_YUV420P),
+      hw_device_ctx_(nullptr),
+      hw_frame_(nullptr),
       sws_ctx_valid_(false),
       header_written_(false),
       muxer_opts_(nullptr),
@@ -49,16 +177,13 @@ EncoderPipeline::EncoderPipeline(const MpegTSPlayoutSinkConfig& config)
       last_dts_90k_(0),
       last_pts_valid_(false),
       last_dts_valid_(false),
-      last_pcr_90k_(0),
-      last_pcr_packet_time_us_(0),
-      last_pcr_valid_(false),
       last_write_time_us_(0),
       last_packet_time_us_(0),
-      continuity_corrections_(0),
-      continuity_test_packets_(0),
-      continuity_test_mismatches_(0) {
+      active_backend_(EncoderBackend::SOFTWARE),
+      ts_inspector_(config.ts_validation_interval) {
   time_base_.num = 1;
   time_base_.den = 90000;  // MPEG-TS timebase is 90kHz
+  cpu_meter_.SetAccount(config.cpu_account);
 }
 
 EncoderPipeline::~EncoderPipeline() {
@@ -82,15 +207,12 @@ bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config,
     return true;
   }
 
-  continuity_counters_.clear();
-  continuity_corrections_ = 0;
-  continuity_test_counters_.clear();
-  continuity_test_packets_ = 0;
-  continuity_test_mismatches_ = 0;
-  continuity_test_pid_packets_.clear();
-  continuity_test_pid_mismatches_.clear();
-  continuity_test_pid_packets_.clear();
-  continuity_test_pid_mismatches_.clear();
+  ts_inspector_.Reset();
+  telemetry_ = config_.encoder_telemetry.get();
+  ts_inspector_.SetTelemetry(telemetry_);
+  if (telemetry_) {
+    telemetry_->SetConfiguredBitrate(config_.bitrate);
+  }
 
   // Suppress FFmpeg warnings (e.g., "dts < pcr, TS is invalid") but keep errors visible
   av_log_set_level(AV_LOG_ERROR);
@@ -174,16 +296,18 @@ bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config,
     format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
   }
 
-  // Find H.264 encoder
-  const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-  if (!codec) {
-    std::cerr << "[EncoderPipeline] H.264 encoder not found" << std::endl;
+  // The software encoder is the last fallback of every backend, so it must exist
+  const AVCodecID codec_id =
+      config.video_codec == VideoCodec::HEVC ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
+  if (!avcodec_find_encoder(codec_id)) {
+    std::cerr << "[EncoderPipeline] " << (codec_id == AV_CODEC_ID_HEVC ? "HEVC" : "H.264")
+              << " encoder not found" << std::endl;
     close();
     return false;
   }
 
   // Create video stream
-  video_stream_ = avformat_new_stream(format_ctx_, codec);
+  video_stream_ = avformat_new_stream(format_ctx_, nullptr);
   if (!video_stream_) {
     std::cerr << "[EncoderPipeline] Failed to create video stream" << std::endl;
     close();
@@ -192,51 +316,52 @@ bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config,
 
   video_stream_->id = format_ctx_->nb_streams - 1;
 
-  // Allocate codec context
-  codec_ctx_ = avcodec_alloc_context3(codec);
-  if (!codec_ctx_) {
-    std::cerr << "[EncoderPipeline] Failed to allocate codec context" << std::endl;
-    close();
-    return false;
-  }
-
-  // Set codec parameters
-  // Note: Frame dimensions will be set from first frame
-  codec_ctx_->codec_id = AV_CODEC_ID_H264;
-  codec_ctx_->codec_type = AVMEDIA_TYPE_VIDEO;
-  codec_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
-  codec_ctx_->bit_rate = config.bitrate;
-  codec_ctx_->gop_size = config.gop_size;
-  codec_ctx_->max_b_frames = 0;  // No B-frames for low latency
-  codec_ctx_->time_base.num = 1;
-  codec_ctx_->time_base.den = static_cast<int>(config.target_fps);
-  codec_ctx_->framerate.num = static_cast<int>(config.target_fps);
-  codec_ctx_->framerate.den = 1;
-
   // Set stream time base to 90kHz (MPEG-TS standard)
   video_stream_->time_base.num = 1;
   video_stream_->time_base.den = 90000;
 
-  // Copy codec parameters to stream
-  ret = avcodec_parameters_from_context(video_stream_->codecpar, codec_ctx_);
-  if (ret < 0) {
-    char errbuf[AV_ERROR_MAX_STRING_SIZE];
-    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-    std::cerr << "[EncoderPipeline] Failed to copy codec parameters: " << errbuf << std::endl;
-    close();
-    return false;
+  // Audio track: the producers' audio (AudioSource::PRODUCER), else the
+  // cached silent AAC frame for this layout, muxed in step with video (see
+  // MuxSilentAudio()) so nothing is encoded per channel
+  if (config.enable_audio && config.audio_source == AudioSource::PRODUCER &&
+      !OpenAudioEncoder(config)) {
+    std::cerr << "[EncoderPipeline] Audio encoder unavailable - falling back to silent audio"
+              << std::endl;
+  }
+  if (config.enable_audio && !audio_codec_ctx_) {
+    silent_audio_ =
+        SilentAacCache::Instance().Get(config.audio_sample_rate, config.audio_channels);
+    if (silent_audio_) {
+      audio_stream_ = avformat_new_stream(format_ctx_, nullptr);
+      const size_t unit_size = silent_audio_->access_unit.size();
+      audio_unit_ = av_buffer_alloc(unit_size + AV_INPUT_BUFFER_PADDING_SIZE);
+      if (!audio_stream_ || !audio_unit_ ||
+          avcodec_parameters_copy(audio_stream_->codecpar, silent_audio_->codecpar.get()) < 0) {
+        std::cerr << "[EncoderPipeline] Failed to create audio stream" << std::endl;
+        close();
+        return false;
+      }
+      std::memcpy(audio_unit_->data, silent_audio_->access_unit.data(), unit_size);
+      std::memset(audio_unit_->data + unit_size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+      audio_stream_->id = format_ctx_->nb_streams - 1;
+      audio_stream_->time_base = AVRational{1, 90000};
+      audio_started_ = false;
+    } else {
+      std::cerr << "[EncoderPipeline] Silent AAC unavailable - continuing without audio"
+                << std::endl;
+    }
   }
 
-  // Open codec (dimensions will be set from first frame)
-  // We'll open it after we get the first frame dimensions
-  codec_ctx_->width = 0;
-  codec_ctx_->height = 0;
+  // The encoder itself (codec_ctx_) is opened on the first frame, once the
+  // dimensions are known; see OpenVideoEncoder().
 
   // Allocate frame, input frame, and packet
   frame_ = av_frame_alloc();
   input_frame_ = av_frame_alloc();
+  wrapped_frame_ = av_frame_alloc();
+  surface_frame_ = av_frame_alloc();
   packet_ = av_packet_alloc();
-  if (!frame_ || !input_frame_ || !packet_) {
+  if (!frame_ || !input_frame_ || !wrapped_frame_ || !surface_frame_ || !packet_) {
     std::cerr << "[EncoderPipeline] Failed to allocate frame, input_frame, or packet" << std::endl;
     close();
     return false;
@@ -248,9 +373,25 @@ bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config,
 }
 
 bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t pts90k) {
+  return EncodeInput(frame, nullptr, pts90k);
+}
+
+bool EncoderPipeline::encodeFrame(const retrovue::buffer::FrameHandle& handle,
+                                  int64_t pts90k) {
+  if (!handle) {
+    return false;
+  }
+  return EncodeInput(*handle, &handle, pts90k);
+}
+
+bool EncoderPipeline::EncodeInput(const retrovue::buffer::Frame& frame,
+                                  const retrovue::buffer::FrameHandle* handle,
+                                  int64_t pts90k) {
+  RETROVUE_TRACE_SCOPE("encoder.encode_frame");
   if (!initialized_) {
     return false;
   }
+  cpu_meter_.Restart();
 
   if (config_.stub_mode) {
     // Stub mode: just log
@@ -259,6 +400,14 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
     return true;
   }
 
+  // A GPU surface is coded where it is by an encoder on its device; any
+  // other encoder gets the picture downloaded
+  const AVFrame* surface = decode::DeviceSurfaceFrame(frame);
+  if (frame.format == retrovue::buffer::PixelFormat::kDevice &&
+      (!surface || !CanEncodeSurface(surface))) {
+    return EncodeDownloaded(frame, pts90k);
+  }
+
   // Stall detection: check if encoder/muxer has stalled
   auto now = std::chrono::steady_clock::now();
   int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -278,13 +427,18 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
               << "time_since_last_write=" << ((now_us - last_write_time_us_) / 1000) << "ms" << std::endl;
   }
 
-  // Check if codec needs to be opened (first frame or dimensions changed)
-  if (!codec_ctx_->width || !codec_ctx_->height || 
-      codec_ctx_->width != frame.width || codec_ctx_->height != frame.height) {
+  // Check if codec needs to be opened (first frame, dimensions changed, or
+  // device frames arriving at an encoder that is not on their device: the
+  // reopen costs one IDR; a new thread allocation waits for the next GOP)
+  const bool surface_reopen =
+      surface && (!device_input_ || FramesDevice(codec_ctx_->hw_frames_ctx) !=
+                                        FramesDevice(surface->hw_frames_ctx));
+  if (!codec_ctx_ || codec_ctx_->width != frame.width || codec_ctx_->height != frame.height ||
+      surface_reopen || ThreadReopenDue()) {
     
     // Close existing codec if already open
-    if (codec_ctx_->width > 0 && codec_ctx_->height > 0) {
-      avcodec_close(codec_ctx_);
+    if (codec_ctx_) {
+      CloseVideoEncoder();
       if (frame_->data[0]) {
         av_freep(&frame_->data[0]);
       }
@@ -302,54 +456,28 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
     }
 
     // Set dimensions
-    codec_ctx_->width = frame.width;
-    codec_ctx_->height = frame.height;
     frame_width_ = frame.width;
     frame_height_ = frame.height;
 
-    // Update stream codec parameters
-    video_stream_->codecpar->width = frame.width;
-    video_stream_->codecpar->height = frame.height;
-
-    // Re-copy codec parameters to stream (with new dimensions)
-    int ret = avcodec_parameters_from_context(video_stream_->codecpar, codec_ctx_);
-    if (ret < 0) {
-      char errbuf[AV_ERROR_MAX_STRING_SIZE];
-      av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-      std::cerr << "[EncoderPipeline] Failed to copy codec parameters: " << errbuf << std::endl;
-      return false;
-    }
-
-    // Find encoder
-    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-    if (!codec) {
-      std::cerr << "[EncoderPipeline] H.264 encoder not found" << std::endl;
+    // Open the encoder (configured backend, else software) and publish its
+    // parameters on the stream
+    surface_frames_ = surface ? surface->hw_frames_ctx : nullptr;
+    const bool opened = OpenVideoEncoder(frame.width, frame.height);
+    surface_frames_ = nullptr;
+    if (!opened) {
       return false;
     }
-
-    // Set encoder options for low latency using AVDictionary
-    // This is more reliable than av_opt_set and works with all FFmpeg versions
-    AVDictionary* opts = nullptr;
-    av_dict_set(&opts, "preset", "ultrafast", 0);
-    av_dict_set(&opts, "tune", "zerolatency", 0);
-
-    // Open codec with options
-    ret = avcodec_open2(codec_ctx_, codec, &opts);
+    int ret = avcodec_parameters_from_context(video_stream_->codecpar, codec_ctx_);
     if (ret < 0) {
       char errbuf[AV_ERROR_MAX_STRING_SIZE];
       av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-      std::cerr << "[EncoderPipeline] Failed to open codec: " << errbuf << std::endl;
-      av_dict_free(&opts);
+      std::cerr << "[EncoderPipeline] Failed to copy codec parameters: " << errbuf << std::endl;
       return false;
     }
-    
-    // Free options dictionary (options are now applied to codec context)
-    // Note: avcodec_open2 consumes the options, so we free the dictionary
-    av_dict_free(&opts);
 
     // Allocate frame buffer
     ret = av_image_alloc(frame_->data, frame_->linesize,
-                         frame.width, frame.height, AV_PIX_FMT_YUV420P, 32);
+                         frame.width, frame.height, encoder_sw_pix_fmt_, 32);
     if (ret < 0) {
       std::cerr << "[EncoderPipeline] Failed to allocate frame buffer" << std::endl;
       return false;
@@ -357,7 +485,7 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
 
     frame_->width = frame.width;
     frame_->height = frame.height;
-    frame_->format = AV_PIX_FMT_YUV420P;
+    frame_->format = encoder_sw_pix_fmt_;
 
     // Invalidate swscale context (will be recreated after input_frame_ is allocated)
     if (sws_ctx_) {
@@ -366,6 +494,14 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
     }
     sws_ctx_valid_ = false;
 
+    // Native muxing writes PAT/PMT with the first packet; no header to write
+    if (!header_written_ && config_.native_mux && avio_write_callback_) {
+      if (!OpenNativeMuxer()) {
+        return false;
+      }
+      header_written_ = true;
+    }
+
     // Write header if not already written
     if (!header_written_) {
       // Only open AVIO if using URL mode (not custom AVIO)
@@ -403,60 +539,111 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
     }
 
     std::cout << "[EncoderPipeline] Codec opened: " << frame.width << "x" << frame.height << std::endl;
+    BuildFiller(frame.width, frame.height);
   }
 
-  // Map frame data directly into AVFrame without copying (per instructions)
-  // Frame.data is YUV420 planar (Y, U, V planes stored contiguously)
-  // We need to copy planes into frame_->data[] with proper linesize
-  // since AVFrame expects separate plane pointers
-  
-  // Verify frame data size
-  size_t y_size = frame.width * frame.height;
-  size_t uv_size = (frame.width / 2) * (frame.height / 2);
-  size_t expected_size = y_size + 2 * uv_size;
-  
-  if (frame.data.size() < expected_size) {
-    std::cerr << "[EncoderPipeline] Frame data too small: got " << frame.data.size()
-              << " bytes, expected " << expected_size << " bytes" << std::endl;
-    return false;
+  // The device's encoder did not open: device frames are downloaded from
+  // here on
+  if (surface && !device_input_) {
+    std::cerr << "[EncoderPipeline] No encoder on the frames' device - downloading them"
+              << std::endl;
+    surface_encoder_failed_ = true;
+    return EncodeDownloaded(frame, pts90k);
   }
 
-  // Copy Y, U, V planes directly from frame.data into frame_->data[]
-  // Y plane: width * height bytes
-  const uint8_t* y_plane = frame.data.data();
-  for (int y = 0; y < frame.height; y++) {
-    memcpy(frame_->data[0] + y * frame_->linesize[0],
-           y_plane + y * frame.width,
-           frame.width);
+  // Passed through compressed: muxed, not encoded
+  if (frame.format == retrovue::buffer::PixelFormat::kH264) {
+    return MuxCompressedFrame(frame, pts90k);
   }
 
-  // U plane: (width/2) * (height/2) bytes
-  const uint8_t* u_plane = frame.data.data() + y_size;
-  for (int y = 0; y < frame.height / 2; y++) {
-    memcpy(frame_->data[1] + y * frame_->linesize[1],
-           u_plane + y * (frame.width / 2),
-           frame.width / 2);
+  // The frame's planes, in its own layout and strides
+  decode::PlanarImage image;
+  if (!surface && !decode::DescribeFrame(frame, &image)) {
+    std::cerr << "[EncoderPipeline] Frame data too small: got " << frame.data.size()
+              << " bytes, expected " << frame.LayoutBytes() << " bytes" << std::endl;
+    return false;
   }
 
-  // V plane: (width/2) * (height/2) bytes
-  const uint8_t* v_plane = frame.data.data() + y_size + uv_size;
-  for (int y = 0; y < frame.height / 2; y++) {
-    memcpy(frame_->data[2] + y * frame_->linesize[2],
-           v_plane + y * (frame.width / 2),
-           frame.width / 2);
-  }
+  // A GPU surface on the encoder's device is sent as it is. A pooled I420
+  // frame is sent in place; the encoder's reference keeps the slot out of
+  // the pool until it is done with the picture
+  AVFrame* encoder_input = frame_;
+  if (surface) {
+    av_frame_unref(surface_frame_);
+    if (av_frame_ref(surface_frame_, surface) < 0) {
+      return false;
+    }
+    encoder_input = surface_frame_;
+    device_frames_.fetch_add(1, std::memory_order_relaxed);
+  } else if (handle && CanWrapFrame(frame) && WrapFrame(*handle)) {
+    encoder_input = wrapped_frame_;
+  } else {
+    const int chroma_width = frame.width / 2;
+    const int chroma_height = frame.height / 2;
+    if (encoder_sw_pix_fmt_ == AV_PIX_FMT_NV12) {
+      // Device surfaces are NV12: interleave (or narrow) chroma while copying
+      if (image.layout == decode::PlanarLayout::kP010) {
+        decode::NarrowP010Plane(frame_->data[0], frame_->linesize[0], image.planes[0],
+                                image.strides[0], frame.width, frame.height);
+        decode::NarrowP010Plane(frame_->data[1], frame_->linesize[1], image.planes[1],
+                                image.strides[1], 2 * chroma_width, chroma_height);
+      } else {
+        decode::CopyPlane(frame_->data[0], frame_->linesize[0], image.planes[0],
+                          image.strides[0], frame.width, frame.height);
+        if (image.layout == decode::PlanarLayout::kNV12) {
+          decode::CopyPlane(frame_->data[1], frame_->linesize[1], image.planes[1],
+                            image.strides[1], 2 * chroma_width, chroma_height);
+        } else {
+          decode::MergeUVPlane(frame_->data[1], frame_->linesize[1], image.planes[1],
+                               image.strides[1], image.planes[2], image.strides[2],
+                               chroma_width, chroma_height);
+        }
+      }
+    } else {
+      // Copies I420; splits NV12 and narrows P010 chroma into planes
+      decode::PackI420(image, frame.width, frame.height, frame_->data, frame_->linesize);
+    }
+
+    // Set frame format explicitly
+    frame_->format = encoder_sw_pix_fmt_;
 
-  // Set frame format explicitly (already YUV420P)
-  frame_->format = AV_PIX_FMT_YUV420P;
+    // QSV/VAAPI encode from device memory: upload into a pooled surface
+    if (codec_ctx_->hw_frames_ctx) {
+      av_frame_unref(hw_frame_);
+      if (av_hwframe_get_buffer(codec_ctx_->hw_frames_ctx, hw_frame_, 0) < 0 ||
+          av_hwframe_transfer_data(hw_frame_, frame_, 0) < 0) {
+        std::cerr << "[EncoderPipeline] Failed to upload frame to encoder device" << std::endl;
+        return false;
+      }
+      encoder_input = hw_frame_;
+    }
+  }
+  ScopedFrameUnref release_wrapped{encoder_input == wrapped_frame_ ? wrapped_frame_ : nullptr};
+  ScopedFrameUnref release_surface{encoder_input == surface_frame_ ? surface_frame_ : nullptr};
 
   // Set frame PTS from pts90k (already in 90kHz units)
   // pts90k is monotonic and aligned with the producer's timeline
   // Convert from 90kHz timebase to codec timebase
   AVRational tb90k = {1, 90000};  // 90kHz timebase
-  frame_->pts = av_rescale_q(pts90k, tb90k, codec_ctx_->time_base);
+  encoder_input->pts = av_rescale_q(pts90k, tb90k, codec_ctx_->time_base);
+
+  // A client joined mid-stream, or filler, a cached airing or passed-through
+  // frames replaced the decoder's reference pictures: start a GOP it can
+  // decode from
+  bool keyframe = keyframe_requested_.exchange(false, std::memory_order_acq_rel);
+  keyframe = std::exchange(filler_active_, false) || keyframe;
+  keyframe = std::exchange(cache_resync_, false) || keyframe;
+  keyframe = std::exchange(passthrough_active_, false) || keyframe;
+  encoder_input->pict_type = keyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+  // A statmux allocation or an adapted rate: libx264 and NVENC reconfigure
+  // once bit_rate (and the VBV with it) moves
+  const int64_t allocated = video_bitrate_.load(std::memory_order_relaxed);
+  codec_ctx_->bit_rate = allocated > 0 ? allocated : config_.bitrate;
+  ApplyVbv();
 
   // Send frame to encoder
-  int send_ret = avcodec_send_frame(codec_ctx_, frame_);
+  int send_ret = avcodec_send_frame(codec_ctx_, encoder_input);
   if (send_ret < 0) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE];
     av_strerror(send_ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -480,6 +667,7 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
         }
         
         drain_attempts++;
+        RecordVideoPacket(packet_);
         
         // Write drained packet
         packet_->stream_index = video_stream_->index;
@@ -492,7 +680,7 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
                     << " pts_90k=" << packet_->pts << std::endl;
         }
         
-        int write_ret = av_interleaved_write_frame(format_ctx_, packet_);
+        int write_ret = mux_queue_.Push(packet_) ? 0 : AVERROR(ENOMEM);
         if (write_ret < 0) {
           if (write_ret == AVERROR(EAGAIN)) {
             // Muxer backpressure - drop packet and break to prevent blocking
@@ -511,7 +699,7 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
       }
       
       // Try sending frame again after draining
-      send_ret = avcodec_send_frame(codec_ctx_, frame_);
+      send_ret = avcodec_send_frame(codec_ctx_, encoder_input);
       if (send_ret == AVERROR(EAGAIN)) {
         // Still full - frame will be processed on next iteration
         return true;  // Not an error, just backpressure
@@ -554,6 +742,7 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
     }
 
     packets_processed++;
+    RecordVideoPacket(packet_);
 
     // Packet received successfully
     // Set packet stream index and timestamp
@@ -629,11 +818,9 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
                 << " pts_90k=" << packet_->pts << std::endl;
     }
 
-    // Write packet to muxer
-    // Note: Even though our callback always returns buf_size, av_interleaved_write_frame
-    // might still block internally. However, with our callback implementation,
-    // it should not block since we always pretend success.
-    int write_ret = av_interleaved_write_frame(format_ctx_, packet_);
+    // Queue packet for the muxer; MuxInterleaver writes it in DTS order with
+    // the audio once the mux clock reaches it
+    int write_ret = mux_queue_.Push(packet_) ? 0 : AVERROR(ENOMEM);
     
     if (write_ret < 0) {
       char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -665,6 +852,20 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
               << " packets (limit reached) - may have more packets to process" << std::endl;
   }
 
+  // Audio up to the end of this frame, then everything due at its time
+  if (audio_codec_ctx_) {
+    PadAudio(pts90k - kAudioPadLag90k);
+  } else {
+    MuxSilentAudio(pts90k, pts90k + static_cast<int64_t>(90000.0 / config_.target_fps));
+  }
+  cpu_meter_.Charge(retrovue::telemetry::CpuStage::kEncode);
+  DrainMuxQueue(pts90k);
+  cpu_meter_.Charge(retrovue::telemetry::CpuStage::kMux);
+  if (telemetry_) {
+    telemetry_->RecordEncode(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - now)
+                                 .count());
+  }
   return true;
 }
 
@@ -733,8 +934,8 @@ void EncoderPipeline::close() {
           last_dts_valid_ = true;
         }
         
-        // Write flushed packet (check for errors)
-        int write_ret = av_interleaved_write_frame(format_ctx_, packet_);
+        // Queue flushed packet (written with the rest before the trailer)
+        int write_ret = mux_queue_.Push(packet_) ? 0 : AVERROR(ENOMEM);
         if (write_ret < 0 && write_ret != AVERROR(EAGAIN)) {
           char errbuf[AV_ERROR_MAX_STRING_SIZE];
           av_strerror(write_ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -746,8 +947,24 @@ void EncoderPipeline::close() {
     }
   }
 
-  // Write trailer (finalizes TS stream, writes final PCR if needed)
+  // Flush the audio encoder, then everything still queued for the muxer
+  if (audio_codec_ctx_ && header_written_) {
+    EncodeQueuedAudio();
+    SendAudio(nullptr);
+  }
   if (format_ctx_ && header_written_) {
+    DrainMuxQueue(INT64_MAX);
+  }
+  mux_queue_.Clear();
+
+  const bool native_mux = native_muxer_ != nullptr;
+  if (native_mux) {
+    native_muxer_->Cleanup();
+    native_muxer_.reset();
+  }
+
+  // Write trailer (finalizes TS stream, writes final PCR if needed)
+  if (format_ctx_ && header_written_ && !native_mux) {
     int ret = av_write_trailer(format_ctx_);
     if (ret < 0) {
       char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -847,57 +1064,30 @@ void EncoderPipeline::close() {
     av_freep(&input_frame_->data[0]);
   }
   av_frame_free(&input_frame_);
+  av_frame_free(&wrapped_frame_);
+  av_frame_free(&surface_frame_);
   
   av_packet_free(&packet_);
-  avcodec_free_context(&codec_ctx_);
+  CloseVideoEncoder();
+  LeaveThreadBudget();
+  surface_encoder_failed_ = false;
   avformat_free_context(format_ctx_);
   format_ctx_ = nullptr;
-
-  if (continuity_corrections_ > 0) {
-    std::cout << "[EncoderPipeline] Continuity corrections applied: "
-              << continuity_corrections_ << std::endl;
-  }
-  if (continuity_test_packets_ > 0) {
-    double rate = static_cast<double>(continuity_test_mismatches_) /
-                  static_cast<double>(continuity_test_packets_);
-    std::cout << "[EncoderPipeline] Continuity mismatches observed (raw): "
-              << continuity_test_mismatches_ << "/" << continuity_test_packets_
-              << " (" << rate * 100.0 << "%)" << std::endl;
-
-    std::vector<std::pair<uint16_t, double>> pid_rates;
-    pid_rates.reserve(continuity_test_pid_packets_.size());
-    for (const auto& entry : continuity_test_pid_packets_) {
-      uint16_t pid = entry.first;
-      uint64_t total = entry.second;
-      uint64_t mism = continuity_test_pid_mismatches_[pid];
-      if (mism == 0 || total == 0) {
-        continue;
-      }
-      double pid_rate = static_cast<double>(mism) / static_cast<double>(total);
-      pid_rates.emplace_back(pid, pid_rate);
-    }
-    std::sort(pid_rates.begin(), pid_rates.end(),
-              [](const auto& a, const auto& b) {
-                return a.second > b.second;
-              });
-    if (!pid_rates.empty()) {
-      std::cout << "[EncoderPipeline] Top continuity mismatch PIDs:" << std::endl;
-      size_t limit = std::min<size_t>(pid_rates.size(), 5);
-      for (size_t i = 0; i < limit; ++i) {
-        uint16_t pid = pid_rates[i].first;
-        uint64_t total = continuity_test_pid_packets_[pid];
-        uint64_t mism = continuity_test_pid_mismatches_[pid];
-        std::cout << "  PID " << pid << ": " << mism << "/" << total
-                  << " (" << pid_rates[i].second * 100.0 << "%)" << std::endl;
-      }
-    }
-  }
-
-  continuity_counters_.clear();
-  continuity_corrections_ = 0;
-  continuity_test_counters_.clear();
-  continuity_test_packets_ = 0;
-  continuity_test_mismatches_ = 0;
+  filler_.Clear();
+  filler_active_ = false;
+  cache_record_.reset();  // An airing cut short is not cached
+  cached_run_.reset();
+  cache_resync_ = false;
+  passthrough_active_ = false;
+  passthrough_wait_keyframe_ = true;
+  audio_stream_ = nullptr;
+  av_buffer_unref(&audio_unit_);
+  silent_audio_.reset();
+  CloseAudioEncoder();
+  audio_started_ = false;
+  last_audio_dts_valid_ = false;
+
+  ts_inspector_.LogSummary();
   
   if (sws_ctx_) {
     sws_freeContext(sws_ctx_);
@@ -919,205 +1109,1162 @@ bool EncoderPipeline::IsInitialized() const {
   return initialized_;
 }
 
-#ifdef RETROVUE_FFMPEG_AVAILABLE
-// Note: avioWriteCallback is no longer used - we use the callback directly
+EncoderBackend EncoderPipeline::GetActiveBackend() const {
+  return active_backend_;
+}
+
+TsInspectorStats EncoderPipeline::GetTsStats() const {
+  return ts_inspector_.GetStats();
+}
+
+MuxQueueStats EncoderPipeline::GetMuxStats() const {
+  return mux_queue_.GetStats();
+}
+
+void EncoderPipeline::RequestKeyframe() {
+  keyframe_requested_.store(true, std::memory_order_release);
+}
+
+bool EncoderPipeline::OpenVideoEncoder(int width, int height) {
+  CloseVideoEncoder();
+  std::vector<EncoderBackend> candidates = EncoderCandidates(config_.encoder_backend);
+  if (surface_frames_) {
+    // Device frames: the encoder on their device first
+    const auto native = std::find(candidates.begin(), candidates.end(),
+                                  SurfaceBackend(FramesFormat(surface_frames_)));
+    if (native != candidates.end()) {
+      std::rotate(candidates.begin(), native, native + 1);
+    }
+  }
+  for (EncoderBackend backend : candidates) {
+    if (TryOpenEncoder(backend, width, height)) {
+      if (backend == EncoderBackend::SOFTWARE && config_.encoder_backend != backend) {
+        std::cerr << "[EncoderPipeline] No " << EncoderBackendName(config_.encoder_backend)
+                  << " encoder available - falling back to software encode" << std::endl;
+      }
+      active_backend_ = backend;
+      if (backend != EncoderBackend::SOFTWARE) {
+        LeaveThreadBudget();  // Hardware encoders take no host threads
+      }
+      std::cout << "[EncoderPipeline] Video encoder: " << codec_ctx_->codec->name << " ("
+                << EncoderBackendName(backend) << ")" << std::endl;
+      return true;
+    }
+  }
+  std::cerr << "[EncoderPipeline] Failed to open a video encoder" << std::endl;
+  return false;
+}
+
+bool EncoderPipeline::TryOpenEncoder(EncoderBackend backend, int width, int height) {
+  const bool hevc = config_.video_codec == VideoCodec::HEVC;
+  const AVCodec* codec =
+      backend == EncoderBackend::SOFTWARE
+          ? avcodec_find_encoder(hevc ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264)
+          : avcodec_find_encoder_by_name(HardwareEncoderName(backend, hevc));
+  if (!codec) {
+    return false;  // Not built into this FFmpeg
+  }
+
+  codec_ctx_ = avcodec_alloc_context3(codec);
+  if (!codec_ctx_) {
+    std::cerr << "[EncoderPipeline] Failed to allocate codec context" << std::endl;
+    return false;
+  }
+  codec_ctx_->width = width;
+  codec_ctx_->height = height;
+  codec_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
+  const int64_t allocated = video_bitrate_.load(std::memory_order_relaxed);
+  codec_ctx_->bit_rate = allocated > 0 ? allocated : config_.bitrate;
+  ApplyVbv();
+  codec_ctx_->gop_size = config_.gop_size;
+  gop_weighted_bits_ = 0.0;
+  gop_bits_ = 0;
+  gop_frames_ = 0;
+  frames_since_key_ = 0;
+  if (config_.fixed_gop) {
+    // No early keyframes, so renditions encoded from the same frames keep
+    // their GOPs aligned (the scene-cut options are added below)
+    codec_ctx_->keyint_min = config_.gop_size;
+  }
+  codec_ctx_->max_b_frames = 0;  // No B-frames for low latency
+  codec_ctx_->time_base.num = 1;
+  codec_ctx_->time_base.den = static_cast<int>(config_.target_fps);
+  codec_ctx_->framerate.num = static_cast<int>(config_.target_fps);
+  codec_ctx_->framerate.den = 1;
+  encoder_sw_pix_fmt_ = AV_PIX_FMT_YUV420P;
+
+  // Low-latency settings per encoder family (options an encoder does not
+  // know are left unused, not rejected)
+  AVDictionary* opts = nullptr;
+  switch (backend) {
+    case EncoderBackend::NVENC:
+      // Takes yuv420p from system memory and uploads it itself, or CUDA
+      // device frames as they are
+      if (surface_frames_ && SurfaceBackend(FramesFormat(surface_frames_)) == backend &&
+          !InitHardwareFrames(backend, width, height)) {
+        CloseVideoEncoder();
+        return false;
+      }
+      av_dict_set(&opts, "preset", "p1", 0);
+      av_dict_set(&opts, "tune", "ull", 0);
+      av_dict_set(&opts, "zerolatency", "1", 0);
+      av_dict_set(&opts, "delay", "0", 0);
+      if (config_.fixed_gop) {
+        av_dict_set(&opts, "no-scenecut", "1", 0);
+      }
+      break;
+    case EncoderBackend::QSV:
+    case EncoderBackend::VAAPI:
+      if (!InitHardwareFrames(backend, width, height)) {
+        CloseVideoEncoder();
+        return false;
+      }
+      av_dict_set(&opts, "async_depth", "1", 0);
+      if (backend == EncoderBackend::QSV) {
+        av_dict_set(&opts, "preset", "veryfast", 0);
+      }
+      break;
+    default:
+      av_dict_set(&opts, "preset",
+                  config_.encoder_preset.empty() ? "ultrafast" : config_.encoder_preset.c_str(), 0);
+      av_dict_set(&opts, "tune", "zerolatency", 0);
+      av_dict_set(&opts, "forced-idr", "1", 0);  // Requested keyframes are IDR
+      ApplyThreadBudget(width, height);
+      if (config_.fixed_gop || (hevc && encoder_threads_.load(std::memory_order_relaxed) > 0)) {
+        // libx265 takes its thread pool in its own options, not thread_count
+        std::string params = config_.fixed_gop ? "scenecut=0" : "";
+        const int threads = encoder_threads_.load(std::memory_order_relaxed);
+        if (hevc && threads > 0) {
+          params += (params.empty() ? "" : ":") + std::string("pools=") +
+                    std::to_string(threads) + ":frame-threads=1";
+        }
+        av_dict_set(&opts, hevc ? "x265-params" : "x264-params", params.c_str(), 0);
+      }
+      break;
+  }
+
+  int ret = avcodec_open2(codec_ctx_, codec, &opts);
+  av_dict_free(&opts);
+  if (ret < 0) {
+    // Typical for hardware encoders without a usable device (no GPU, no
+    // driver, session limit reached)
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    std::cerr << "[EncoderPipeline] Failed to open " << codec->name << ": " << errbuf
+              << std::endl;
+    CloseVideoEncoder();
+    return false;
+  }
+  return true;
+}
 
-// Extract PID from TS packet (bytes 1-2)
-uint16_t EncoderPipeline::ExtractPID(const uint8_t* ts_packet) {
-  if (!ts_packet || ts_packet[0] != 0x47) {
-    return 0xFFFF;  // Invalid
+void EncoderPipeline::ApplyThreadBudget(int width, int height) {
+  if (!config_.encoder_threads) {
+    return;
+  }
+  if (thread_budget_id_ != 0 &&
+      (width != thread_budget_width_ || height != thread_budget_height_)) {
+    LeaveThreadBudget();
+  }
+  if (thread_budget_id_ == 0) {
+    EncoderThreadRequest request;
+    request.channel_id = config_.channel_id;
+    request.width = width;
+    request.height = height;
+    request.fps = config_.target_fps;
+    request.priority = config_.encoder_priority;
+    thread_budget_width_ = width;
+    thread_budget_height_ = height;
+    thread_budget_id_ = config_.encoder_threads->AddEncoder(
+        request, [this](EncoderThreadAllocation allocation) {
+          pending_threads_.store(allocation.threads, std::memory_order_relaxed);
+        });
   }
-  return ((ts_packet[1] & 0x1F) << 8) | ts_packet[2];
+  const int pending = pending_threads_.exchange(0, std::memory_order_relaxed);
+  if (pending > 0) {
+    encoder_threads_.store(pending, std::memory_order_relaxed);
+  }
+  // Sliced threads, one slice each: zerolatency's threading already, and
+  // the only one that adds no frames of delay
+  const int threads = encoder_threads_.load(std::memory_order_relaxed);
+  codec_ctx_->thread_count = threads;
+  codec_ctx_->thread_type = FF_THREAD_SLICE;
+  codec_ctx_->slices = threads;
 }
 
-// Extract continuity counter from TS packet (byte 3, lower 4 bits)
-uint8_t EncoderPipeline::ExtractContinuityCounter(const uint8_t* ts_packet) {
-  if (!ts_packet || ts_packet[0] != 0x47) {
-    return 0xFF;  // Invalid
+void EncoderPipeline::LeaveThreadBudget() {
+  if (thread_budget_id_ == 0) {
+    return;
   }
-  return ts_packet[3] & 0x0F;
+  config_.encoder_threads->RemoveEncoder(thread_budget_id_);
+  thread_budget_id_ = 0;
+  encoder_threads_.store(0, std::memory_order_relaxed);
+  pending_threads_.store(0, std::memory_order_relaxed);
 }
 
-// Extract PCR from TS packet adaptation field (if present)
-bool EncoderPipeline::ExtractPCR(const uint8_t* ts_packet, int64_t& pcr_90k) {
-  if (!ts_packet || ts_packet[0] != 0x47) {
+bool EncoderPipeline::ThreadReopenDue() const {
+  if (thread_budget_id_ == 0 || active_backend_ != EncoderBackend::SOFTWARE) {
     return false;
   }
-  
-  // Check if adaptation field is present (bit 4 of byte 3)
-  if (!(ts_packet[3] & 0x20)) {
-    return false;  // No adaptation field
+  const int pending = pending_threads_.load(std::memory_order_relaxed);
+  if (pending == 0 || pending == encoder_threads_.load(std::memory_order_relaxed)) {
+    return false;
   }
-  
-  // Byte 4: adaptation_field_length
-  uint8_t adaptation_field_length = ts_packet[4];
-  if (adaptation_field_length == 0) {
-    return false;  // No adaptation field data
+  return frames_since_key_ >= config_.gop_size ||
+         keyframe_requested_.load(std::memory_order_acquire) || filler_active_ ||
+         cache_resync_ || passthrough_active_;
+}
+
+void EncoderPipeline::ApplyVbv() {
+  if (!config_.adaptive_bitrate) {
+    return;
   }
-  
-  // Byte 5: adaptation_field_control flags (bit 4 = PCR flag)
-  if (!(ts_packet[5] & 0x10)) {
-    return false;  // No PCR flag set
+  codec_ctx_->rc_max_rate = codec_ctx_->bit_rate;
+  codec_ctx_->rc_buffer_size = static_cast<int>(codec_ctx_->bit_rate);
+}
+
+bool EncoderPipeline::InitHardwareFrames(EncoderBackend backend, int width, int height) {
+  const bool qsv = backend == EncoderBackend::QSV;
+  AVPixelFormat format = qsv ? AV_PIX_FMT_QSV : AV_PIX_FMT_VAAPI;
+  const bool on_surface_device =
+      surface_frames_ && SurfaceBackend(FramesFormat(surface_frames_)) == backend;
+  if (on_surface_device) {
+    // Device frames' own device, so they are encoded without a copy
+    const auto* surface = reinterpret_cast<const AVHWFramesContext*>(surface_frames_->data);
+    hw_device_ctx_ = av_buffer_ref(surface->device_ref);
+    format = surface->format;
+  } else {
+    const char* device = config_.hw_device.empty() ? nullptr : config_.hw_device.c_str();
+    if (av_hwdevice_ctx_create(&hw_device_ctx_,
+                               qsv ? AV_HWDEVICE_TYPE_QSV : AV_HWDEVICE_TYPE_VAAPI, device,
+                               nullptr, 0) < 0) {
+      hw_device_ctx_ = nullptr;
+    }
   }
-  
-  // PCR is 6 bytes starting at byte 6 (after adaptation_field_length and flags)
-  // PCR = (33-bit base) * 300 + (9-bit extension)
-  // PCR base ticks at 90kHz (each unit is 1/90000 second)
-  // PCR extension refines that base to 27MHz resolution
-  int64_t pcr_base = ((int64_t)ts_packet[6] << 25) |
-                     ((int64_t)ts_packet[7] << 17) |
-                     ((int64_t)ts_packet[8] << 9) |
-                     ((int64_t)ts_packet[9] << 1) |
-                     ((ts_packet[10] >> 7) & 0x01);
-  int64_t pcr_ext = ((ts_packet[10] & 0x01) << 8) | ts_packet[11];
-  
-  // pcr_base is already in 90kHz units; keep integer precision in that domain.
-  // (pcr_ext provides 27MHz sub-ticks; we ignore it for coarse 90kHz analysis.)
-  (void)pcr_ext;
-  pcr_90k = pcr_base;
-  
+  if (!hw_device_ctx_) {
+    std::cerr << "[EncoderPipeline] Failed to open " << EncoderBackendName(backend)
+              << " device" << std::endl;
+    return false;
+  }
+
+  AVBufferRef* frames_ref = av_hwframe_ctx_alloc(hw_device_ctx_);
+  if (!frames_ref) {
+    return false;
+  }
+  auto* frames = reinterpret_cast<AVHWFramesContext*>(frames_ref->data);
+  frames->format = format;
+  frames->sw_format = AV_PIX_FMT_NV12;
+  frames->width = width;
+  frames->height = height;
+  frames->initial_pool_size = kHwFramePoolSize;
+  if (av_hwframe_ctx_init(frames_ref) < 0) {
+    std::cerr << "[EncoderPipeline] Failed to create " << EncoderBackendName(backend)
+              << " surface pool" << std::endl;
+    av_buffer_unref(&frames_ref);
+    return false;
+  }
+
+  hw_frame_ = av_frame_alloc();
+  if (!hw_frame_) {
+    av_buffer_unref(&frames_ref);
+    return false;
+  }
+  codec_ctx_->hw_frames_ctx = frames_ref;  // Owned by the codec context from here
+  codec_ctx_->pix_fmt = frames->format;
+  encoder_sw_pix_fmt_ = AV_PIX_FMT_NV12;
+  device_input_ = on_surface_device;
   return true;
 }
 
-// Process TS packets and validate continuity counters
-void EncoderPipeline::ProcessTSPackets(uint8_t* data, size_t size) {
-  const size_t ts_packet_size = 188;
-  size_t offset = 0;
-  
-  while (offset + ts_packet_size <= size) {
-    uint8_t* ts_packet = data + offset;
-    
-    // Validate sync byte
-    if (ts_packet[0] != 0x47) {
-      std::cerr << "[EncoderPipeline] Invalid TS sync byte at offset " << offset << std::endl;
-      offset += 1;  // Skip one byte and try to resync
-      continue;
+void EncoderPipeline::CloseVideoEncoder() {
+  av_frame_free(&hw_frame_);
+  avcodec_free_context(&codec_ctx_);
+  av_buffer_unref(&hw_device_ctx_);
+  encoder_sw_pix_fmt_ = AV_PIX_FMT_YUV420P;
+  device_input_ = false;
+}
+
+bool EncoderPipeline::CanEncodeSurface(const AVFrame* surface) const {
+  // 8-bit surfaces, for the configured backend (any, with AUTO), unless its
+  // encoder already failed to open on their device
+  if (!surface->hw_frames_ctx || surface_encoder_failed_) {
+    return false;
+  }
+  const auto* frames = reinterpret_cast<const AVHWFramesContext*>(surface->hw_frames_ctx->data);
+  const EncoderBackend backend = SurfaceBackend(frames->format);
+  return backend != EncoderBackend::SOFTWARE && frames->sw_format == AV_PIX_FMT_NV12 &&
+         (config_.encoder_backend == EncoderBackend::AUTO ||
+          config_.encoder_backend == backend);
+}
+
+bool EncoderPipeline::EncodeDownloaded(const retrovue::buffer::Frame& frame, int64_t pts90k) {
+  if (!decode::DownloadDeviceFrame(frame, &downloaded_frame_)) {
+    return false;
+  }
+  device_downloads_.fetch_add(1, std::memory_order_relaxed);
+  return EncodeInput(downloaded_frame_, nullptr, pts90k);
+}
+
+bool EncoderPipeline::CanWrapFrame(const retrovue::buffer::Frame& frame) const {
+  // Device surfaces, NV12 encoders and NV12/P010 frames need the copy into frame_
+  if (codec_ctx_->hw_frames_ctx || encoder_sw_pix_fmt_ != AV_PIX_FMT_YUV420P ||
+      frame.format != retrovue::buffer::PixelFormat::kI420) {
+    return false;
+  }
+  if (frame.width % 2 != 0 || frame.height % 2 != 0) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    const auto start = reinterpret_cast<uintptr_t>(frame.Plane(i));
+    if (start % kWrapAlignment != 0 ||
+        static_cast<size_t>(frame.Stride(i)) % kWrapAlignment != 0) {
+      return false;
     }
-    
-    // Extract PID and continuity counter
-    uint16_t pid = ExtractPID(ts_packet);
-    uint8_t cc = ExtractContinuityCounter(ts_packet);
-    uint8_t adaptation_field_control = (ts_packet[3] >> 4) & 0x03;
-    bool has_adaptation = (adaptation_field_control & 0x02) != 0;
-    bool has_payload = (adaptation_field_control & 0x01) != 0;
-    
-    // Null packets (PID 0x1FFF) do not participate in continuity tracking
-    bool is_null_packet = (pid == 0x1FFF);
-    
-    // Check discontinuity indicator in adaptation field
-    bool discontinuity_flag = false;
-    if (has_adaptation && !is_null_packet) {
-      size_t adaptation_offset = 4;
-      if (adaptation_offset < ts_packet_size) {
-        uint8_t adaptation_length = ts_packet[adaptation_offset];
-        if (adaptation_length > 0 && adaptation_offset + 1 < ts_packet_size) {
-          uint8_t adaptation_flags = ts_packet[adaptation_offset + 1];
-          discontinuity_flag = (adaptation_flags & 0x80) != 0;
-        }
-      }
+  }
+  return true;
+}
+
+bool EncoderPipeline::WrapFrame(const retrovue::buffer::FrameHandle& handle) {
+  const retrovue::buffer::Frame& frame = *handle;
+  // The buffer owns a reference to the slot; read-only, since other
+  // readers of the ring may share the frame
+  auto* reference = new retrovue::buffer::FrameHandle(handle);
+  AVBufferRef* buffer = av_buffer_create(const_cast<uint8_t*>(frame.data.data()),
+                                         frame.data.size(), &ReleaseFrameHandle, reference,
+                                         AV_BUFFER_FLAG_READONLY);
+  if (!buffer) {
+    delete reference;
+    return false;
+  }
+
+  wrapped_frame_->buf[0] = buffer;
+  for (int i = 0; i < 3; ++i) {
+    wrapped_frame_->data[i] = buffer->data + (frame.Plane(i) - frame.data.data());
+    wrapped_frame_->linesize[i] = frame.Stride(i);
+  }
+  wrapped_frame_->width = frame.width;
+  wrapped_frame_->height = frame.height;
+  wrapped_frame_->format = AV_PIX_FMT_YUV420P;
+  return true;
+}
+
+bool EncoderPipeline::OpenAudioEncoder(const MpegTSPlayoutSinkConfig& config) {
+  const bool ac3 = config.audio_codec == AudioCodec::AC3;
+  const char* codec_name = ac3 ? "AC-3" : "AAC";
+  if (config.audio_sample_rate <= 0 || config.audio_channels <= 0 ||
+      config.audio_channels > AV_NUM_DATA_POINTERS) {
+    std::cerr << "[EncoderPipeline] Invalid audio layout: " << config.audio_sample_rate
+              << " Hz, " << config.audio_channels << " channel(s)" << std::endl;
+    return false;
+  }
+  const AVCodec* codec = avcodec_find_encoder(ac3 ? AV_CODEC_ID_AC3 : AV_CODEC_ID_AAC);
+  if (!codec) {
+    std::cerr << "[EncoderPipeline] " << codec_name << " encoder not found" << std::endl;
+    return false;
+  }
+  audio_codec_ctx_ = avcodec_alloc_context3(codec);
+  if (!audio_codec_ctx_) {
+    return false;
+  }
+  audio_codec_ctx_->sample_rate = config.audio_sample_rate;
+  audio_codec_ctx_->sample_fmt = AV_SAMPLE_FMT_FLTP;  // Native AAC and AC-3 encoders
+  av_channel_layout_default(&audio_codec_ctx_->ch_layout, config.audio_channels);
+  audio_codec_ctx_->bit_rate = config.audio_bitrate;
+  audio_codec_ctx_->time_base = AVRational{1, config.audio_sample_rate};
+  audio_codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;  // The TS muxer writes ADTS from it
+
+  int ret = avcodec_open2(audio_codec_ctx_, codec, nullptr);
+  if (ret < 0) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    std::cerr << "[EncoderPipeline] Failed to open " << codec_name << " encoder: " << errbuf
+              << std::endl;
+    CloseAudioEncoder();
+    return false;
+  }
+
+  const int frame_size = audio_codec_ctx_->frame_size;
+  audio_frame_ = av_frame_alloc();
+  audio_fifo_ = av_audio_fifo_alloc(AV_SAMPLE_FMT_FLTP, config.audio_channels, frame_size * 4);
+  audio_stream_ = avformat_new_stream(format_ctx_, nullptr);
+  bool ok = audio_frame_ && audio_fifo_ && audio_stream_;
+  if (ok) {
+    audio_frame_->nb_samples = frame_size;
+    audio_frame_->format = AV_SAMPLE_FMT_FLTP;
+    audio_frame_->sample_rate = config.audio_sample_rate;
+    ok = av_channel_layout_copy(&audio_frame_->ch_layout, &audio_codec_ctx_->ch_layout) >= 0 &&
+         av_frame_get_buffer(audio_frame_, 0) >= 0 &&
+         avcodec_parameters_from_context(audio_stream_->codecpar, audio_codec_ctx_) >= 0;
+  }
+  if (!ok) {
+    std::cerr << "[EncoderPipeline] Failed to create audio stream" << std::endl;
+    CloseAudioEncoder();
+    return false;
+  }
+  audio_stream_->id = format_ctx_->nb_streams - 1;
+  audio_stream_->time_base = AVRational{1, 90000};
+  audio_silence_.assign(static_cast<size_t>(frame_size), 0.0f);
+  audio_started_ = false;
+  last_audio_dts_valid_ = false;
+  std::cout << "[EncoderPipeline] " << codec_name << " audio encoder opened: "
+            << config.audio_sample_rate << " Hz, " << config.audio_channels << " channel(s), "
+            << config.audio_bitrate << " bps" << std::endl;
+  return true;
+}
+
+void EncoderPipeline::CloseAudioEncoder() {
+  avcodec_free_context(&audio_codec_ctx_);
+  av_frame_free(&audio_frame_);
+  if (audio_fifo_) {
+    av_audio_fifo_free(audio_fifo_);
+    audio_fifo_ = nullptr;
+  }
+  swr_free(&swr_ctx_);
+  swr_in_rate_ = 0;
+  swr_in_channels_ = 0;
+}
+
+bool EncoderPipeline::ConfigureResampler(int in_rate, int in_channels) {
+  if (swr_ctx_ && in_rate == swr_in_rate_ && in_channels == swr_in_channels_) {
+    return true;
+  }
+  swr_free(&swr_ctx_);
+  AVChannelLayout in_layout;
+  av_channel_layout_default(&in_layout, in_channels);
+  const int ret = swr_alloc_set_opts2(&swr_ctx_, &audio_codec_ctx_->ch_layout,
+                                      AV_SAMPLE_FMT_FLTP, audio_codec_ctx_->sample_rate,
+                                      &in_layout, AV_SAMPLE_FMT_S16, in_rate, 0, nullptr);
+  av_channel_layout_uninit(&in_layout);
+  if (ret < 0 || swr_init(swr_ctx_) < 0) {
+    std::cerr << "[EncoderPipeline] Failed to set up audio resampler for " << in_rate
+              << " Hz, " << in_channels << " channel(s)" << std::endl;
+    swr_free(&swr_ctx_);
+    return false;
+  }
+  swr_in_rate_ = in_rate;
+  swr_in_channels_ = in_channels;
+  return true;
+}
+
+int64_t EncoderPipeline::AudioEnd90k() const {
+  const int64_t samples = audio_samples_ + av_audio_fifo_size(audio_fifo_);
+  return audio_start_90k_ +
+         av_rescale_q(samples, AVRational{1, audio_codec_ctx_->sample_rate}, AVRational{1, 90000});
+}
+
+void EncoderPipeline::WriteSilence(int64_t samples) {
+  const int64_t max_samples = audio_codec_ctx_->sample_rate;  // Never more than a second
+  samples = std::min(samples, max_samples);
+  void* planes[AV_NUM_DATA_POINTERS];
+  for (int ch = 0; ch < AV_NUM_DATA_POINTERS; ++ch) {
+    planes[ch] = audio_silence_.data();
+  }
+  while (samples > 0) {
+    const int chunk =
+        static_cast<int>(std::min<int64_t>(samples, static_cast<int64_t>(audio_silence_.size())));
+    if (av_audio_fifo_write(audio_fifo_, planes, chunk) < chunk) {
+      return;
     }
-    
-    auto& test_state = continuity_test_counters_[pid];
-    continuity_test_pid_packets_[pid]++;
-    if (test_state.initialized) {
-      uint8_t expected = (test_state.last_cc + 1) & 0x0F;
-      if (cc != expected) {
-        continuity_test_mismatches_++;
-        continuity_test_pid_mismatches_[pid]++;
+    samples -= chunk;
+  }
+}
+
+bool EncoderPipeline::encodeAudioFrame(const retrovue::buffer::AudioFrame& audio) {
+  if (!initialized_ || config_.stub_mode || !audio_codec_ctx_ || !header_written_) {
+    // Silent or no audio track, or the stream has not started (no video yet)
+    return initialized_;
+  }
+  const size_t needed = static_cast<size_t>(std::max(audio.nb_samples, 0)) *
+                        static_cast<size_t>(std::max(audio.channels, 0)) * sizeof(int16_t);
+  if (audio.nb_samples <= 0 || audio.channels <= 0 || audio.sample_rate <= 0 ||
+      audio.data.size() < needed) {
+    std::cerr << "[EncoderPipeline] Invalid audio frame: " << audio.nb_samples << " samples, "
+              << audio.channels << " channel(s), " << audio.data.size() << " bytes" << std::endl;
+    return false;
+  }
+  if (!ConfigureResampler(audio.sample_rate, audio.channels)) {
+    return false;
+  }
+
+  // Line the samples up with the track: fill a gap with silence, trim an
+  // overlap, and jump (without silence) over a gap too long to fill
+  const AVRational tb90k = {1, 90000};
+  const int64_t pts90k = av_rescale_q(audio.pts_us, AVRational{1, 1000000}, tb90k);
+  int skip = 0;
+  if (!audio_started_) {
+    audio_start_90k_ = pts90k;
+    audio_samples_ = 0;
+    audio_started_ = true;
+  } else {
+    const int64_t gap = pts90k - AudioEnd90k();
+    if (gap > kAudioResyncGap90k) {
+      audio_start_90k_ += gap;
+    } else if (gap > kAudioGapTolerance90k) {
+      WriteSilence(av_rescale_q(gap, tb90k, AVRational{1, audio_codec_ctx_->sample_rate}));
+    } else if (gap < -kAudioGapTolerance90k && gap >= -kAudioResyncGap90k) {
+      skip = static_cast<int>(av_rescale_q(-gap, tb90k, AVRational{1, audio.sample_rate}));
+      if (skip >= audio.nb_samples) {
+        return true;  // Already covered, by padding or an earlier frame
       }
-      test_state.last_cc = cc;
+    }
+  }
+
+  const int in_count = audio.nb_samples - skip;
+  const uint8_t* in = audio.data.data() + static_cast<size_t>(skip) * audio.channels * sizeof(int16_t);
+  const int out_capacity = swr_get_out_samples(swr_ctx_, in_count);
+  const int channels = audio_codec_ctx_->ch_layout.nb_channels;
+  audio_convert_.resize(static_cast<size_t>(std::max(out_capacity, 0)) * channels);
+  uint8_t* planes[AV_NUM_DATA_POINTERS] = {};
+  for (int ch = 0; ch < channels; ++ch) {
+    planes[ch] = reinterpret_cast<uint8_t*>(audio_convert_.data() +
+                                            static_cast<size_t>(ch) * out_capacity);
+  }
+  const int converted = swr_convert(swr_ctx_, planes, out_capacity, &in, in_count);
+  if (converted < 0) {
+    std::cerr << "[EncoderPipeline] Audio resampling failed" << std::endl;
+    return false;
+  }
+  if (converted > 0 &&
+      av_audio_fifo_write(audio_fifo_, reinterpret_cast<void**>(planes), converted) < converted) {
+    return false;
+  }
+  return EncodeQueuedAudio();
+}
+
+void EncoderPipeline::PadAudio(int64_t until_90k) {
+  if (!audio_codec_ctx_ || !header_written_) {
+    return;
+  }
+  if (!audio_started_) {
+    // No producer audio yet: the track starts here, in silence
+    audio_start_90k_ = until_90k;
+    audio_samples_ = 0;
+    audio_started_ = true;
+    return;
+  }
+  const int64_t lag = until_90k - AudioEnd90k();
+  if (lag > 0) {
+    WriteSilence(av_rescale_q(lag, AVRational{1, 90000},
+                              AVRational{1, audio_codec_ctx_->sample_rate}));
+    EncodeQueuedAudio();
+  }
+}
+
+bool EncoderPipeline::EncodeQueuedAudio() {
+  const int frame_size = audio_codec_ctx_->frame_size;
+  while (av_audio_fifo_size(audio_fifo_) >= frame_size) {
+    if (av_frame_make_writable(audio_frame_) < 0 ||
+        av_audio_fifo_read(audio_fifo_, reinterpret_cast<void**>(audio_frame_->data),
+                           frame_size) < frame_size) {
+      return false;
+    }
+    audio_frame_->pts = audio_samples_;  // Encoder time base: samples since audio_start_90k_
+    audio_samples_ += frame_size;
+    if (!SendAudio(audio_frame_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EncoderPipeline::SendAudio(AVFrame* frame) {
+  int ret = avcodec_send_frame(audio_codec_ctx_, frame);
+  if (ret < 0 && ret != AVERROR_EOF) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    std::cerr << "[EncoderPipeline] Error sending audio frame: " << errbuf << std::endl;
+    return false;
+  }
+
+  const int64_t start = av_rescale_q(audio_start_90k_, AVRational{1, 90000},
+                                     audio_stream_->time_base);
+  while (true) {
+    ret = avcodec_receive_packet(audio_codec_ctx_, packet_);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+      break;
+    }
+    if (ret < 0) {
+      return false;
+    }
+    packet_->stream_index = audio_stream_->index;
+    av_packet_rescale_ts(packet_, audio_codec_ctx_->time_base, audio_stream_->time_base);
+    if (packet_->pts != AV_NOPTS_VALUE) {
+      packet_->pts += start;
+    }
+    packet_->dts = packet_->dts != AV_NOPTS_VALUE ? packet_->dts + start : packet_->pts;
+    if (last_audio_dts_valid_ && packet_->dts <= last_audio_dts_) {
+      av_packet_unref(packet_);  // Timeline stepped back; the muxer needs rising DTS
+      continue;
+    }
+    last_audio_dts_ = packet_->dts;
+    last_audio_dts_valid_ = true;
+    mux_queue_.Push(packet_);
+  }
+  return true;
+}
+
+void EncoderPipeline::RecordVideoPacket(const AVPacket* packet) {
+  if (!telemetry_ && !on_gop_complexity_) {
+    return;
+  }
+  // Encoders that export quality stats (libx264, libx265, NVENC) give the
+  // QP and picture type; otherwise only keyframes are told apart
+  using retrovue::telemetry::PictureType;
+  PictureType type = (packet->flags & AV_PKT_FLAG_KEY) ? PictureType::kI : PictureType::kP;
+  int qp = -1;
+#if LIBAVCODEC_VERSION_MAJOR >= 59
+  size_t stats_size = 0;
+#else
+  int stats_size = 0;
+#endif
+  const uint8_t* stats = av_packet_get_side_data(packet, AV_PKT_DATA_QUALITY_STATS, &stats_size);
+  if (stats && stats_size >= 5) {
+    const uint32_t quality = static_cast<uint32_t>(stats[0]) |
+                             (static_cast<uint32_t>(stats[1]) << 8) |
+                             (static_cast<uint32_t>(stats[2]) << 16) |
+                             (static_cast<uint32_t>(stats[3]) << 24);
+    qp = static_cast<int>((quality + FF_QP2LAMBDA / 2) / FF_QP2LAMBDA);
+    switch (stats[4]) {
+      case AV_PICTURE_TYPE_I:
+        type = PictureType::kI;
+        break;
+      case AV_PICTURE_TYPE_B:
+        type = PictureType::kB;
+        break;
+      case AV_PICTURE_TYPE_P:
+        type = PictureType::kP;
+        break;
+      default:
+        break;
+    }
+  }
+  if (telemetry_) {
+    telemetry_->RecordFrame(type, static_cast<size_t>(packet->size), qp);
+  }
+  frames_since_key_ = (packet->flags & AV_PKT_FLAG_KEY) ? 1 : frames_since_key_ + 1;
+  if (!on_gop_complexity_) {
+    return;
+  }
+
+  // A keyframe closes the GOP before it
+  if ((packet->flags & AV_PKT_FLAG_KEY) && gop_frames_ > 0) {
+    GopComplexity gop;
+    gop.bits = gop_bits_;
+    gop.frames = gop_frames_;
+    gop.duration_us =
+        static_cast<int64_t>(gop_frames_ * 1'000'000.0 / std::max(1.0, config_.target_fps));
+    gop.complexity = gop_weighted_bits_ * 1'000'000.0 / static_cast<double>(gop.duration_us);
+    on_gop_complexity_(gop);
+    gop_weighted_bits_ = 0.0;
+    gop_bits_ = 0;
+    gop_frames_ = 0;
+  }
+  // H.264/HEVC quantizer step: 0.625 at QP 0, doubling every 6
+  const double step = qp >= 0 ? 0.625 * std::pow(2.0, qp / 6.0) : 1.0;
+  const int64_t bits = static_cast<int64_t>(packet->size) * 8;
+  gop_weighted_bits_ += static_cast<double>(bits) * step;
+  gop_bits_ += bits;
+  gop_frames_++;
+}
+
+void EncoderPipeline::DrainMuxQueue(int64_t clock_90k) {
+  int ret = 0;
+  if (native_muxer_) {
+    ret = mux_queue_.Drain(&EncoderPipeline::NativeMuxThunk, this, clock_90k);
+    native_muxer_->Flush();
+  } else {
+    ret = mux_queue_.Drain(format_ctx_, clock_90k);
+  }
+  if (ret < 0) {
+    static uint64_t mux_error_count = 0;
+    if (mux_error_count++ % 100 == 0) {
+      char errbuf[AV_ERROR_MAX_STRING_SIZE];
+      av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+      std::cerr << "[EncoderPipeline] Error writing packet: " << errbuf << std::endl;
+    }
+  }
+}
+
+MuxerConfig EncoderPipeline::NativeMuxerConfig() const {
+  MuxerConfig muxer_config;
+  if (config_.mpts) {
+    const MptsProgramPids pids = MptsPidsForProgram(config_.mpts_program);
+    muxer_config.program_number = config_.mpts_program;
+    muxer_config.pmt_pid = pids.pmt_pid;
+    muxer_config.video_pid = pids.video_pid;
+    muxer_config.audio_pid = pids.audio_pid;
+  }
+  muxer_config.video_stream_type =
+      config_.video_codec == VideoCodec::HEVC ? kTsStreamTypeHevc : kTsStreamTypeH264;
+  if (audio_stream_) {
+    const AVCodecParameters* par = audio_stream_->codecpar;
+    muxer_config.enable_audio = true;
+    muxer_config.audio_stream_type =
+        par->codec_id == AV_CODEC_ID_AC3 ? kTsStreamTypeAc3 : kTsStreamTypeAac;
+    if (par->extradata && par->extradata_size > 0) {
+      muxer_config.audio_specific_config.assign(par->extradata,
+                                                par->extradata + par->extradata_size);
+    }
+  }
+  return muxer_config;
+}
+
+bool EncoderPipeline::OpenNativeMuxer() {
+  auto muxer = std::make_unique<TSMuxer>();
+  if (!muxer->Initialize(NativeMuxerConfig(), this, &EncoderPipeline::NativeWriteThunk)) {
+    std::cerr << "[EncoderPipeline] Failed to open native TS muxer" << std::endl;
+    return false;
+  }
+  native_muxer_ = std::move(muxer);
+  // Airings are recorded from the packets on their way to the muxer
+  mux_queue_.SetTap(config_.ts_cache ? &EncoderPipeline::RecordMuxedPacket : nullptr, this);
+  std::cout << "[EncoderPipeline] Native TS muxer opened" << std::endl;
+  return true;
+}
+
+int EncoderPipeline::NativeMuxThunk(void* opaque, AVPacket* packet) {
+  auto* pipeline = static_cast<EncoderPipeline*>(opaque);
+  const bool audio =
+      pipeline->audio_stream_ && packet->stream_index == pipeline->audio_stream_->index;
+  const int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+  const bool ok = pipeline->native_muxer_->MuxFrame(
+      audio ? TsStream::kAudio : TsStream::kVideo, packet->data,
+      static_cast<size_t>(packet->size), packet->pts, dts,
+      (packet->flags & AV_PKT_FLAG_KEY) != 0);
+  return ok ? 0 : AVERROR(EIO);
+}
+
+// Whole packets with counters already in order: straight to the output
+int EncoderPipeline::NativeWriteThunk(void* opaque, uint8_t* buf, int buf_size) {
+  auto* pipeline = static_cast<EncoderPipeline*>(opaque);
+  if (!pipeline->avio_write_callback_) {
+    return -1;
+  }
+  pipeline->last_write_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  return pipeline->avio_write_callback_(pipeline->avio_opaque_, buf, buf_size);
+}
+
+void EncoderPipeline::MuxSilentAudio(int64_t pts90k, int64_t until_90k) {
+  if (!audio_stream_ || !mux_silent_audio_ || !header_written_) {
+    return;
+  }
+  const SilentAacTrack& track = *silent_audio_;
+  const AVRational sample_tb = {1, track.sample_rate};
+  const AVRational tb90k = {1, 90000};
+  int64_t next_90k = audio_start_90k_ + av_rescale_q(audio_samples_, sample_tb, tb90k);
+  if (!audio_started_ || next_90k < pts90k - kAudioResyncGap90k ||
+      next_90k > until_90k + kAudioResyncGap90k) {
+    audio_start_90k_ = pts90k;
+    audio_samples_ = 0;
+    audio_started_ = true;
+    next_90k = pts90k;
+  }
+
+  const int64_t duration = av_rescale_q(track.frame_size, sample_tb, audio_stream_->time_base);
+  while (next_90k < until_90k) {
+    // Every packet shares the one padded copy of the access unit
+    packet_->buf = av_buffer_ref(audio_unit_);
+    if (!packet_->buf) {
+      return;
+    }
+    packet_->data = packet_->buf->data;
+    packet_->size = static_cast<int>(track.access_unit.size());
+    packet_->stream_index = audio_stream_->index;
+    packet_->pts = av_rescale_q(next_90k, tb90k, audio_stream_->time_base);
+    packet_->dts = packet_->pts;
+    packet_->duration = duration;
+    packet_->flags |= AV_PKT_FLAG_KEY;
+    if (!mux_queue_.Push(packet_)) {  // Takes the reference
+      return;
+    }
+    audio_samples_ += track.frame_size;
+    next_90k = audio_start_90k_ + av_rescale_q(audio_samples_, sample_tb, tb90k);
+  }
+}
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+void EncoderPipeline::BuildFiller(int width, int height) {
+  filler_.Clear();
+  filler_active_ = false;
+  if (config_.underflow_policy == UnderflowPolicy::SKIP) {
+    return;
+  }
+
+  // Same codec, backend and GOP as this encoder, so the clip's SPS/PPS
+  // match the stream and its skip P-frames decode against its pictures
+  MpegTSPlayoutSinkConfig clip_config = config_;
+  clip_config.underflow_policy = UnderflowPolicy::SKIP;  // No filler for the filler
+  clip_config.renditions.clear();
+  clip_config.ts_validation_interval = 0;
+
+  std::vector<uint8_t> clip;
+  EncoderPipeline clip_encoder(clip_config);
+  // The clip's PMT lists the audio track like the stream's; the audio
+  // itself comes from this encoder when the filler is emitted
+  clip_encoder.mux_silent_audio_ = false;
+  if (!clip_encoder.open(clip_config, &clip, &AppendToBuffer)) {
+    std::cerr << "[EncoderPipeline] Failed to open filler encoder" << std::endl;
+    return;
+  }
+
+  // Black in limited range: Y=16, U=V=128
+  retrovue::buffer::Frame black;
+  black.width = width;
+  black.height = height;
+  const size_t y_size = static_cast<size_t>(width) * static_cast<size_t>(height);
+  black.data.assign(y_size + 2 * ((width / 2) * (height / 2)), 128);
+  std::fill(black.data.begin(), black.data.begin() + static_cast<std::ptrdiff_t>(y_size), 16);
+
+  const int64_t frame_duration_90k = static_cast<int64_t>(90000.0 / config_.target_fps);
+  const int frames = std::max(1, config_.gop_size);
+  for (int i = 0; i < frames; ++i) {
+    if (!clip_encoder.encodeFrame(black, i * frame_duration_90k)) {
+      std::cerr << "[EncoderPipeline] Failed to encode filler frame " << i << std::endl;
+      return;
+    }
+  }
+  clip_encoder.close();
+
+  if (!filler_.Load(std::move(clip))) {
+    std::cerr << "[EncoderPipeline] Filler clip has no video frames" << std::endl;
+    return;
+  }
+  std::cout << "[EncoderPipeline] Pre-encoded " << filler_.frame_count()
+            << " underflow filler frames (" << filler_.size_bytes() << " bytes)" << std::endl;
+}
+
+bool EncoderPipeline::EmitFiller(int64_t pts90k) {
+  if (!initialized_ || config_.stub_mode || !header_written_ || filler_.empty()) {
+    return false;
+  }
+
+  // Filler breaks the airing: a recording would miss frames, and a cached
+  // run's next P-frame would follow the filler
+  if (cache_record_) {
+    FinishCacheRecord(pts90k, false);
+  }
+  if (cached_run_) {
+    EndCachedRun(pts90k);
+  }
+
+  // FRAME_FREEZE skips the IDR, so the client keeps its last picture
+  const size_t first =
+      config_.underflow_policy == UnderflowPolicy::FRAME_FREEZE && filler_.frame_count() > 1
+          ? 1
+          : 0;
+  if (!filler_active_ || filler_next_ >= filler_.frame_count()) {
+    filler_next_ = first;
+  }
+  if (last_pts_valid_ && pts90k <= last_pts_90k_) {
+    pts90k = last_pts_90k_ + 1;
+  }
+
+  // Audio continues under the filler; everything queued for the muxer,
+  // then its I/O buffer, goes out first
+  if (audio_codec_ctx_) {
+    PadAudio(pts90k - kAudioPadLag90k);
+  } else if (audio_stream_) {
+    MuxSilentAudio(pts90k, pts90k + static_cast<int64_t>(90000.0 / config_.target_fps));
+  }
+  DrainMuxQueue(INT64_MAX);
+  if (!native_muxer_) {
+    avio_flush(format_ctx_->pb);
+  }
+
+  // The native muxer continues its own counters over the clip's packets
+  filler_buffer_.clear();
+  const int64_t dts90k = filler_.AppendFrame(filler_next_++, pts90k, &filler_buffer_);
+  const bool written =
+      native_muxer_
+          ? native_muxer_->WriteMuxed(filler_buffer_.data(), filler_buffer_.size()) &&
+                native_muxer_->Flush()
+          : WriteWithAlignment(filler_buffer_.data(), filler_buffer_.size());
+  if (!written) {
+    return false;
+  }
+  last_pts_90k_ = pts90k;
+  last_pts_valid_ = true;
+  last_dts_90k_ = dts90k;
+  last_dts_valid_ = true;
+  filler_active_ = true;
+  return true;
+}
+
+bool EncoderPipeline::MuxCompressedFrame(const retrovue::buffer::Frame& frame,
+                                         int64_t pts90k) {
+  if (config_.video_codec != VideoCodec::H264) {
+    static uint64_t codec_warning_count = 0;
+    if (codec_warning_count++ % 100 == 0) {
+      std::cerr << "[EncoderPipeline] Dropping passed-through H.264 frame: output is HEVC"
+                << std::endl;
+    }
+    return false;
+  }
+
+  // Coming from encoded frames, filler or a cached airing, or past a lost
+  // frame, the client's decoder lacks the references: resume on a keyframe
+  const int64_t frame_duration_90k = static_cast<int64_t>(90000.0 / config_.target_fps);
+  if (!passthrough_active_ || filler_active_ || cache_resync_ ||
+      (last_pts_valid_ && pts90k - last_pts_90k_ > frame_duration_90k * 3 / 2)) {
+    passthrough_wait_keyframe_ = true;
+  }
+  passthrough_active_ = true;
+  if (passthrough_wait_keyframe_ && !frame.metadata.keyframe) {
+    passthrough_skips_.fetch_add(1, std::memory_order_relaxed);
+    last_pts_90k_ = std::max(last_pts_90k_, pts90k);  // Gaps are measured from here on
+    last_pts_valid_ = true;
+    return true;
+  }
+  passthrough_wait_keyframe_ = false;
+  filler_active_ = false;
+  cache_resync_ = false;
+
+  // Timestamps as for encoded packets: DTS keeps the source's lead, both
+  // strictly increasing
+  int64_t dts90k = pts90k - (frame.metadata.pts - frame.metadata.dts) * 90000 / 1'000'000;
+  if (last_pts_valid_ && pts90k <= last_pts_90k_) {
+    pts90k = last_pts_90k_ + 1;
+  }
+  if (last_dts_valid_ && dts90k <= last_dts_90k_) {
+    dts90k = last_dts_90k_ + 1;
+  }
+  dts90k = std::min(dts90k, pts90k);
+
+  av_packet_unref(packet_);
+  if (av_new_packet(packet_, static_cast<int>(frame.data.size())) < 0) {
+    std::cerr << "[EncoderPipeline] Failed to allocate passthrough packet" << std::endl;
+    return false;
+  }
+  std::memcpy(packet_->data, frame.data.data(), frame.data.size());
+  packet_->pts = pts90k;
+  packet_->dts = dts90k;
+  packet_->duration = frame_duration_90k;
+  packet_->flags = frame.metadata.keyframe ? AV_PKT_FLAG_KEY : 0;
+  packet_->stream_index = video_stream_->index;
+  RecordVideoPacket(packet_);
+  const bool queued = mux_queue_.Push(packet_);
+  av_packet_unref(packet_);
+  if (!queued) {
+    std::cerr << "[EncoderPipeline] Error queueing passthrough packet" << std::endl;
+    return false;
+  }
+  last_pts_90k_ = pts90k;
+  last_pts_valid_ = true;
+  last_dts_90k_ = dts90k;
+  last_dts_valid_ = true;
+  last_packet_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count();
+  passthrough_frames_.fetch_add(1, std::memory_order_relaxed);
+
+  // Audio up to the end of this frame, then everything due at its time
+  if (audio_codec_ctx_) {
+    PadAudio(pts90k - kAudioPadLag90k);
+  } else {
+    MuxSilentAudio(pts90k, pts90k + frame_duration_90k);
+  }
+  DrainMuxQueue(pts90k);
+  cpu_meter_.Charge(retrovue::telemetry::CpuStage::kMux);
+  return true;
+}
+
+std::string EncoderPipeline::CacheProfile(int width, int height) const {
+  std::ostringstream profile;
+  profile << (config_.video_codec == VideoCodec::HEVC ? "hevc " : "h264 ") << width << 'x'
+          << height << '@' << config_.target_fps << ' ' << config_.bitrate << "bps gop"
+          << config_.gop_size << (config_.fixed_gop ? " fixed" : "");
+  if (audio_stream_) {
+    profile << " audio ";
+    if (audio_codec_ctx_) {
+      profile << (config_.audio_codec == AudioCodec::AC3 ? "ac3 " : "aac ")
+              << config_.audio_bitrate << "bps ";
     } else {
-      test_state.last_cc = cc;
-      test_state.initialized = true;
+      profile << "silent ";
     }
-    continuity_test_packets_++;
+    profile << config_.audio_sample_rate << "Hz " << config_.audio_channels << "ch";
+  }
+  if (!overlay_key_.empty()) {
+    profile << " overlays " << overlay_key_;
+  }
+  if (config_.mpts) {
+    profile << " program " << config_.mpts_program;  // Muxed on the program's PIDs
+  }
+  return profile.str();
+}
 
-    if (!is_null_packet) {
-      auto& state = continuity_counters_[pid];
-      
-      if (discontinuity_flag) {
-        state.initialized = false;
-      }
-      
-      if (!state.initialized) {
-        state.last_cc = cc;
-        state.initialized = true;
-      } else if (has_payload) {
-        uint8_t expected_cc = (state.last_cc + 1) & 0x0F;
-        if (cc != expected_cc) {
-          ts_packet[3] = (ts_packet[3] & 0xF0) | expected_cc;
-          cc = expected_cc;
-          continuity_corrections_++;
-        }
-        state.last_cc = cc;
-      } else {
-        // Adaptation-only packets must repeat the previous CC
-        if (cc != state.last_cc) {
-          ts_packet[3] = (ts_packet[3] & 0xF0) | state.last_cc;
-          continuity_corrections_++;
-        }
-        // No change to last_cc when no payload
-      }
+bool EncoderPipeline::EmitCachedFrame(const retrovue::buffer::Frame& frame, int64_t pts90k,
+                                      bool repeat) {
+  if (!config_.ts_cache || !initialized_ || config_.stub_mode || !native_muxer_) {
+    return false;
+  }
+  const retrovue::buffer::FrameMetadata& metadata = frame.metadata;
+  const bool asset_start = metadata.asset_start && !repeat;
+  const int64_t frame_duration_90k = static_cast<int64_t>(90000.0 / config_.target_fps);
+
+  // A recording ends with its asset; a gap (a frame dropped as late, or
+  // behind in the encode queue), a change of overlays or an airing too long
+  // to keep spoils it
+  if (cache_record_) {
+    CacheRecord& record = *cache_record_;
+    if (asset_start || metadata.asset_id != record.asset) {
+      FinishCacheRecord(pts90k, true);
+    } else if (std::abs(pts90k - record.next_pts90k) > frame_duration_90k / 2 ||
+               record.overlays != overlay_key_ ||
+               pts90k - record.start_90k > config_.ts_cache_max_asset_ms * 90 ||
+               record.ts.size() > config_.ts_cache->capacity_bytes()) {
+      FinishCacheRecord(pts90k, false);
+    } else {
+      record.next_pts90k = pts90k + frame_duration_90k;
     }
-    
-    // Check if payload unit start indicator is set (bit 6 of byte 1)
-    bool payload_start = (ts_packet[1] & 0x40) != 0;
-    
-    // Track continuity counter
-    if (!is_null_packet && payload_start) {
-      // Logging for diagnostics when continuity had to be corrected repeatedly
-      static uint64_t continuity_warning_count = 0;
-      if (continuity_corrections_ > 0 && (continuity_warning_count++ % 500 == 0)) {
-        std::cout << "[EncoderPipeline] Continuity correction applied | PID=" << pid
-                  << " | CC=" << static_cast<int>(cc) << std::endl;
-      }
+  }
+  if (cached_run_ && (asset_start || metadata.asset_id != cached_run_->asset ||
+                      cached_run_->overlays != overlay_key_)) {
+    EndCachedRun(pts90k);
+  }
+
+  // An airing from the asset's first frame is sent from the cache, or
+  // recorded for the next one
+  if (asset_start && metadata.asset_id != retrovue::buffer::kNoAsset) {
+    const std::string uri = retrovue::buffer::AssetUri(metadata.asset_id);
+    const std::string profile = CacheProfile(frame.width, frame.height);
+    std::shared_ptr<const TsFillerClip> clip = config_.ts_cache->Find(uri, profile);
+    if (clip) {
+      cached_run_ = std::make_unique<CachedRun>();
+      cached_run_->clip = std::move(clip);
+      cached_run_->overlays = overlay_key_;
+      cached_run_->asset = metadata.asset_id;
+      cached_run_->start_90k = pts90k;
+    } else {
+      BeginCacheRecord(uri, profile, metadata.asset_id, pts90k);
     }
-    
-    // Extract and track PCR if present
-    int64_t pcr_90k = 0;
-    if (ExtractPCR(ts_packet, pcr_90k)) {
-      // Debug: Log PCR values and differences
-      static int64_t last_pcr_debug = -1;
-      if (last_pcr_debug >= 0) {
-        int64_t pcr_diff = pcr_90k - last_pcr_debug;
-        static uint64_t pcr_debug_count = 0;
-        if (pcr_debug_count++ % 100 == 0) {
-          std::cerr << "[DEBUG] PCR_90k=" << pcr_90k
-                    << " diff=" << pcr_diff
-                    << " (~" << (pcr_diff / 90.0) << " ms)" << std::endl;
-        }
-      }
-      last_pcr_debug = pcr_90k;
-      
-      auto now = std::chrono::steady_clock::now();
-      int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
-          now.time_since_epoch()).count();
-      
-      if (last_pcr_valid_) {
-        // Validate PCR cadence (should be ~40ms apart, allow 20-60ms range)
-        int64_t pcr_diff = pcr_90k - last_pcr_90k_;
-        int64_t time_diff_us = now_us - last_pcr_packet_time_us_;
-        int64_t expected_pcr_diff = (time_diff_us * 90) / 1000;  // Convert us to 90kHz
-        
-        // Allow some tolerance (20-60ms)
-        if (pcr_diff < (expected_pcr_diff * 20 / 40) || 
-            pcr_diff > (expected_pcr_diff * 60 / 40)) {
-          static uint64_t pcr_warning_count = 0;
-          if (pcr_warning_count++ % 100 == 0) {
-            std::cout << "[EncoderPipeline] PCR cadence warning | "
-                      << "PCR_diff=" << pcr_diff << " | "
-                      << "time_diff=" << (time_diff_us / 1000) << "ms" << std::endl;
-          }
-        }
+  }
+  if (!cached_run_) {
+    return false;
+  }
+
+  CachedRun& run = *cached_run_;
+  const size_t index = run.clip->FindFrame(pts90k - run.start_90k, frame_duration_90k / 2);
+  if (index >= run.clip->frame_count()) {
+    EndCachedRun(pts90k);  // Aired past the end of the clip: encode the rest
+    return false;
+  }
+  if (index < run.next) {
+    return true;  // Sent already
+  }
+
+  // Everything queued for the muxer goes out first. Clip frames up to this
+  // one follow in order: one dropped upstream is still sent (late), so the
+  // P-frames after it keep their references
+  DrainMuxQueue(INT64_MAX);
+  cache_buffer_.clear();
+  int64_t dts90k = 0;
+  for (size_t i = run.next; i <= index; ++i) {
+    dts90k = run.clip->AppendFrame(i, run.start_90k + run.clip->FrameOffset90k(i), &cache_buffer_);
+  }
+  // The native muxer continues its own counters over the clip's packets;
+  // what the output cannot take is dropped like encoded output would be
+  if (!native_muxer_->WriteMuxed(cache_buffer_.data(), cache_buffer_.size()) ||
+      !native_muxer_->Flush()) {
+    static uint64_t cache_write_errors = 0;
+    if (cache_write_errors++ % 100 == 0) {
+      std::cerr << "[EncoderPipeline] Output dropped cached frames" << std::endl;
+    }
+  }
+  cached_frames_.fetch_add(index + 1 - run.next, std::memory_order_relaxed);
+  run.next = index + 1;
+  last_pts_90k_ = run.start_90k + run.clip->FrameOffset90k(index);
+  last_pts_valid_ = true;
+  last_dts_90k_ = dts90k;
+  last_dts_valid_ = true;
+  return true;
+}
+
+void EncoderPipeline::BeginCacheRecord(const std::string& uri, const std::string& profile,
+                                       retrovue::buffer::AssetId asset, int64_t pts90k) {
+  // What is still queued belongs to the asset before
+  DrainMuxQueue(pts90k - 1);
+
+  auto record = std::make_unique<CacheRecord>();
+  if (!record->muxer.Initialize(NativeMuxerConfig(), &record->ts, &AppendToBuffer)) {
+    std::cerr << "[EncoderPipeline] Failed to open the cache recording muxer" << std::endl;
+    return;
+  }
+  record->uri = uri;
+  record->profile = profile;
+  record->overlays = overlay_key_;
+  record->asset = asset;
+  record->start_90k = pts90k;
+  record->next_pts90k = pts90k + static_cast<int64_t>(90000.0 / config_.target_fps);
+  cache_record_ = std::move(record);
+  RequestKeyframe();  // The clip starts on an IDR
+}
+
+void EncoderPipeline::FinishCacheRecord(int64_t end_90k, bool keep) {
+  if (!cache_record_) {
+    return;
+  }
+  if (keep) {
+    DrainMuxQueue(end_90k - 1);  // The asset's last packets, through the tap
+  }
+  const std::unique_ptr<CacheRecord> record = std::move(cache_record_);
+  if (!keep) {
+    return;
+  }
+  record->muxer.Flush();
+  auto clip = std::make_shared<TsFillerClip>();
+  if (!clip->Load(std::move(record->ts))) {
+    std::cerr << "[EncoderPipeline] Recorded airing has no video frames: " << record->uri
+              << std::endl;
+    return;
+  }
+  std::cout << "[EncoderPipeline] Cached " << clip->frame_count() << " frames ("
+            << clip->size_bytes() << " bytes) of " << record->uri << std::endl;
+  config_.ts_cache->Insert(record->uri, record->profile, std::move(clip));
+}
+
+void EncoderPipeline::EndCachedRun(int64_t end_90k) {
+  cached_run_.reset();
+  cache_resync_ = true;
+
+  // The clip carried the audio up to end_90k; the track goes on from there
+  if (audio_codec_ctx_) {
+    if (audio_started_) {
+      const int64_t gap = end_90k - AudioEnd90k();
+      if (gap > 0) {
+        audio_start_90k_ += gap;
       }
-      
-      last_pcr_90k_ = pcr_90k;
-      last_pcr_packet_time_us_ = now_us;
-      last_pcr_valid_ = true;
     }
-    
-    offset += ts_packet_size;
+    const int64_t end_dts = av_rescale_q(end_90k, AVRational{1, 90000}, audio_stream_->time_base);
+    if (!last_audio_dts_valid_ || last_audio_dts_ < end_dts - 1) {
+      last_audio_dts_ = end_dts - 1;  // Packets of samples sent before it are dropped
+      last_audio_dts_valid_ = true;
+    }
+  } else {
+    audio_started_ = false;  // Silence restarts with the next frame
+  }
+}
+
+void EncoderPipeline::RecordMuxedPacket(void* opaque, const AVPacket* packet) {
+  auto* pipeline = static_cast<EncoderPipeline*>(opaque);
+  CacheRecord* record = pipeline->cache_record_.get();
+  if (!record || packet->pts == AV_NOPTS_VALUE || packet->pts < record->start_90k) {
+    return;  // Not recording, or audio from before the asset's first frame
   }
+  const bool audio =
+      pipeline->audio_stream_ && packet->stream_index == pipeline->audio_stream_->index;
+  const int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+  record->muxer.MuxFrame(audio ? TsStream::kAudio : TsStream::kVideo, packet->data,
+                         static_cast<size_t>(packet->size), packet->pts - record->start_90k,
+                         std::max<int64_t>(dts - record->start_90k, 0),
+                         (packet->flags & AV_PKT_FLAG_KEY) != 0);
+}
+
+// Note: avioWriteCallback is no longer used - we use the callback directly
+
+// Repair continuity counters and validate (sampled) before the packets leave
+void EncoderPipeline::ProcessTSPackets(uint8_t* data, size_t size) {
+  ts_inspector_.Process(data, size);
 }
 
 // Validate that data is aligned on 188-byte TS packet boundaries
@@ -1226,7 +2373,10 @@ int EncoderPipeline::HandleAVIOWrite(uint8_t* buf, int buf_size) {
 // Stub implementations when FFmpeg is not available
 
 EncoderPipeline::EncoderPipeline(const MpegTSPlayoutSinkConfig& config)
-    : config_(config), initialized_(false) {
+    : config_(config),
+      initialized_(false),
+      active_backend_(EncoderBackend::SOFTWARE),
+      ts_inspector_(config.ts_validation_interval) {
 }
 
 EncoderPipeline::~EncoderPipeline() {
@@ -1243,6 +2393,14 @@ bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config) {
   return true;
 }
 
+bool EncoderPipeline::open(const MpegTSPlayoutSinkConfig& config,
+                           void* opaque,
+                           int (*write_callback)(void* opaque, uint8_t* buf, int buf_size)) {
+  (void)opaque;
+  (void)write_callback;
+  return open(config);
+}
+
 bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t pts90k) {
   if (!initialized_) {
     return false;
@@ -1254,6 +2412,16 @@ bool EncoderPipeline::encodeFrame(const retrovue::buffer::Frame& frame, int64_t
   return true;
 }
 
+bool EncoderPipeline::encodeFrame(const retrovue::buffer::FrameHandle& handle,
+                                  int64_t pts90k) {
+  return handle && encodeFrame(*handle, pts90k);
+}
+
+bool EncoderPipeline::encodeAudioFrame(const retrovue::buffer::AudioFrame& audio) {
+  (void)audio;
+  return initialized_;
+}
+
 void EncoderPipeline::close() {
   if (!initialized_) {
     return;
@@ -1267,6 +2435,35 @@ bool EncoderPipeline::IsInitialized() const {
   return initialized_;
 }
 
+EncoderBackend EncoderPipeline::GetActiveBackend() const {
+  return active_backend_;
+}
+
+TsInspectorStats EncoderPipeline::GetTsStats() const {
+  return ts_inspector_.GetStats();
+}
+
+MuxQueueStats EncoderPipeline::GetMuxStats() const {
+  return mux_queue_.GetStats();
+}
+
+void EncoderPipeline::RequestKeyframe() {
+  keyframe_requested_.store(true, std::memory_order_release);
+}
+
+bool EncoderPipeline::EmitFiller(int64_t pts90k) {
+  (void)pts90k;
+  return false;
+}
+
+bool EncoderPipeline::EmitCachedFrame(const retrovue::buffer::Frame& frame, int64_t pts90k,
+                                      bool repeat) {
+  (void)frame;
+  (void)pts90k;
+  (void)repeat;
+  return false;
+}
+
 #endif  // RETROVUE_FFMPEG_AVAILABLE
 
 }  // namespace retrovue::playout_sinks::mpegts
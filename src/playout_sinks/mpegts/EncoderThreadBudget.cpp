@@ -0,0 +1,104 @@
+// Repository: Retrovue-playout
+// Component: Encoder Thread Budget
+// Purpose: Shares the host's cores among every channel's software video encoder.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace retrovue::playout_sinks::mpegts {
+
+EncoderThreadBudget::EncoderThreadBudget(int total_threads)
+    : total_threads_(total_threads > 0
+                         ? total_threads
+                         : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))) {}
+
+uint64_t EncoderThreadBudget::AddEncoder(const EncoderThreadRequest& request,
+                                         ThreadsCallback on_change) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Encoder encoder;
+  encoder.id = next_id_++;
+  encoder.request = request;
+  encoder.request.priority = std::max(1, request.priority);
+  encoder.on_change = std::move(on_change);
+  encoder.weight = static_cast<double>(request.width) * std::max(1, request.height) *
+                   std::max(1.0, request.fps) * encoder.request.priority;
+  encoder.cap = std::clamp(request.height / kRowsPerThread, 1, kMaxThreads);
+  encoders_.push_back(std::move(encoder));
+  RebalanceLocked();
+  return encoders_.back().id;
+}
+
+void EncoderThreadBudget::RemoveEncoder(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = std::find_if(encoders_.begin(), encoders_.end(),
+                               [id](const Encoder& encoder) { return encoder.id == id; });
+  if (it == encoders_.end()) {
+    return;
+  }
+  encoders_.erase(it);
+  RebalanceLocked();
+}
+
+EncoderThreadBudgetStats EncoderThreadBudget::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EncoderThreadBudgetStats stats;
+  stats.total_threads = total_threads_;
+  stats.rebalances = rebalances_;
+  stats.reallocations = reallocations_;
+  for (const Encoder& encoder : encoders_) {
+    EncoderThreadShare share;
+    share.id = encoder.id;
+    share.channel_id = encoder.request.channel_id;
+    share.width = encoder.request.width;
+    share.height = encoder.request.height;
+    share.priority = encoder.request.priority;
+    share.threads = encoder.threads;
+    stats.allocated_threads += encoder.threads;
+    stats.encoders.push_back(share);
+  }
+  return stats;
+}
+
+void EncoderThreadBudget::RebalanceLocked() {
+  ++rebalances_;
+  std::vector<int> threads(encoders_.size(), 1);
+  int spare = total_threads_ - static_cast<int>(encoders_.size());
+  while (spare > 0) {
+    // The encoder with the most work per thread, of those under their cap
+    Encoder* next = nullptr;
+    size_t next_index = 0;
+    for (size_t i = 0; i < encoders_.size(); ++i) {
+      if (threads[i] >= encoders_[i].cap) {
+        continue;
+      }
+      if (!next || encoders_[i].weight * threads[next_index] >
+                       next->weight * threads[i]) {
+        next = &encoders_[i];
+        next_index = i;
+      }
+    }
+    if (!next) {
+      break;  // Every encoder at its cap
+    }
+    ++threads[next_index];
+    --spare;
+  }
+
+  for (size_t i = 0; i < encoders_.size(); ++i) {
+    Encoder& encoder = encoders_[i];
+    if (encoder.threads == threads[i]) {
+      continue;
+    }
+    encoder.threads = threads[i];
+    ++reallocations_;
+    if (encoder.on_change) {
+      encoder.on_change({encoder.threads, encoder.threads});
+    }
+  }
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,105 @@
+// Repository: Retrovue-playout
+// Component: Frame Cadence
+// Purpose: Maps source frames onto the output frame-rate grid with drop/repeat patterns.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/FrameCadence.hpp"
+
+#include <cmath>
+
+namespace retrovue::playout_sinks::mpegts {
+
+FrameCadence::FrameCadence(double output_fps) : tick_us_(1'000'000.0 / output_fps) {}
+
+void FrameCadence::Reset() {
+  anchored_ = false;
+  index_ = 0;
+}
+
+int64_t FrameCadence::Tick(int64_t front_pts) {
+  if (!anchored_) {
+    Anchor(front_pts);
+  } else {
+    const double off_grid = static_cast<double>(front_pts - TickAt(index_));
+    if (std::abs(off_grid) > tick_us_ * kReanchorTicks) {
+      reanchors_.fetch_add(1, std::memory_order_relaxed);
+      Anchor(front_pts);
+    }
+  }
+  return TickAt(index_);
+}
+
+FrameCadence::Action FrameCadence::Decide(int64_t front_pts, const int64_t* next_pts,
+                                          bool can_repeat) const {
+  // Each tick takes the latest frame up to just under half a tick after it
+  // (the nearest one). Frames of the usual rates (23.976 to 60) sit
+  // exactly on the half, or on quarters and fifths, never at 0.45, so PTS
+  // rounding does not flip a decision and the pattern stays regular
+  const int64_t near = TickAt(index_) + static_cast<int64_t>(tick_us_ * kNearTicks);
+  if (next_pts && *next_pts <= near) {
+    return Action::kDrop;
+  }
+  if (front_pts <= near || !can_repeat) {
+    return Action::kShow;
+  }
+  return Action::kRepeat;
+}
+
+void FrameCadence::Shown(int64_t frame_pts) {
+  const int64_t error = std::abs(frame_pts - TickAt(index_));
+  if (error > max_error_us_.load(std::memory_order_relaxed)) {
+    max_error_us_.store(error, std::memory_order_relaxed);
+  }
+  error_total_us_.fetch_add(error, std::memory_order_relaxed);
+  shown_.fetch_add(1, std::memory_order_relaxed);
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+  ++index_;
+}
+
+void FrameCadence::Repeated() {
+  repeats_.fetch_add(1, std::memory_order_relaxed);
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+  ++index_;
+}
+
+void FrameCadence::Dropped() {
+  drops_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameCadence::SkipTo(int64_t pts) {
+  if (!anchored_) {
+    return;
+  }
+  const double ticks = std::ceil(static_cast<double>(pts - origin_pts_) / tick_us_);
+  if (ticks > static_cast<double>(index_)) {
+    index_ = static_cast<int64_t>(ticks);
+  }
+}
+
+FrameCadenceStats FrameCadence::GetStats() const {
+  FrameCadenceStats stats;
+  stats.ticks = ticks_.load(std::memory_order_relaxed);
+  stats.repeats = repeats_.load(std::memory_order_relaxed);
+  stats.drops = drops_.load(std::memory_order_relaxed);
+  stats.reanchors = reanchors_.load(std::memory_order_relaxed);
+  stats.max_error_us = max_error_us_.load(std::memory_order_relaxed);
+  const uint64_t shown = shown_.load(std::memory_order_relaxed);
+  if (shown > 0) {
+    stats.mean_error_us =
+        error_total_us_.load(std::memory_order_relaxed) / static_cast<int64_t>(shown);
+  }
+  return stats;
+}
+
+int64_t FrameCadence::TickAt(int64_t index) const {
+  // From the origin each time, so the grid does not drift by rounding
+  return origin_pts_ + std::llround(static_cast<double>(index) * tick_us_);
+}
+
+void FrameCadence::Anchor(int64_t pts) {
+  anchored_ = true;
+  origin_pts_ = pts;
+  index_ = 0;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
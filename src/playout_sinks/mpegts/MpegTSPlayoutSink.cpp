@@ -7,7 +7,11 @@
 #include "retrovue/playout_sinks/mpegts/PTSController.hpp"
 #include "retrovue/playout_sinks/mpegts/EncoderPipeline.hpp"
 #include "retrovue/playout_sinks/mpegts/ClockUtils.hpp"
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/telemetry/ChannelCpu.h"
+#include "retrovue/telemetry/TraceRing.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <cmath>
@@ -15,17 +19,30 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
 #include <cstring>
 
 namespace retrovue::playout_sinks::mpegts {
 
+namespace {
+
+constexpr int64_t kMaxLateToleranceUs = 50'000;  // 50ms tolerance for late frames
+constexpr size_t kOutputSlabBytes = 7 * 188;       // Output ring slab (one UDP datagram)
+constexpr int64_t kOutputDrainTimeoutMs = 100;     // Bound on waiting for the output thread
+constexpr size_t kOutputBatchSlabs = 64;           // Slabs gathered into one fanout publish
+constexpr auto kOutputSampleInterval = std::chrono::seconds(1);  // Output gauge sampling
+constexpr int kHibernatePollMs = 20;               // Hibernating worker's wait for a client
+constexpr int64_t kMptsPsiBps = 2 * 188 * 8 * 10;  // A program's PMT and keyframe PSI in an MPTS
+
+}  // namespace
+
 // C-style callback for FFmpeg AVIO
 // FE-017: Must write full packet atomically to preserve continuity counters
 extern "C" int writePacketCallback(void* opaque, uint8_t* buf, int buf_size) {
   auto* sink = reinterpret_cast<MpegTSPlayoutSink*>(opaque);
-  int written = sink->writeAllBlocking(buf, buf_size);
+  int written = sink->publishTsBytes(buf, buf_size);
   // Return buf_size if all written, -1 on error (FFmpeg will handle retry/error)
   return (written == buf_size ? buf_size : -1);
 }
@@ -41,10 +58,15 @@ MpegTSPlayoutSink::MpegTSPlayoutSink(
       running_(false),
       stop_requested_(false),
       listen_fd_(-1),
-      client_fd_(-1),
       client_connected_(false),
+      fanout_(config_.max_subscribers, config_.subscriber_queue_bytes,
+              config_.slow_client_policy,
+              config_.warm_start ? config_.subscriber_queue_bytes : 0,
+              config_.send_batch_bytes, config_.send_batch_delay_us,
+              config_.subscriber_max_lag_ms, config_.io_ring),
       pts_controller_(std::make_unique<PTSController>()),
       encoder_pipeline_(std::make_unique<EncoderPipeline>(config_)),
+      output_ring_(kOutputSlabBytes, config_.output_queue_bytes),
       frames_sent_(0),
       frames_dropped_(0),
       late_frames_(0),
@@ -52,10 +74,33 @@ MpegTSPlayoutSink::MpegTSPlayoutSink(
       network_errors_(0),
       buffer_underruns_(0),
       late_frame_drops_(0) {
+  if (!config_.encoder_telemetry) {
+    config_.encoder_telemetry = std::make_shared<retrovue::telemetry::EncoderTelemetry>();
+  }
   // Create UDS sink if socket path is configured
   if (!config_.ts_socket_path.empty()) {
-    ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path);
+    ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path, fanout_,
+                                                      config_.ts_socket_pipe);
+  }
+  // ABR ladder: the main output keeps its GOPs aligned with the renditions
+  if (!config_.renditions.empty()) {
+    config_.fixed_gop = true;
+    rendition_ladder_ = std::make_unique<RenditionLadder>(config_);
   }
+  if (config_.audio_processing.enabled) {
+    decode::AudioProcessingConfig processing = config_.audio_processing;
+    processing.downmix = processing.downmix && config_.audio_channels == 2;
+    audio_processor_ = std::make_unique<decode::AudioProcessor>(processing);
+  }
+  if (config_.cbr_mux_rate > 0) {
+    ts_pacer_ = std::make_unique<TsPacer>(master_clock_, config_.cbr_mux_rate,
+                                          config_.cbr_burst_packets, config_.cbr_max_queue_ms,
+                                          this, &MpegTSPlayoutSink::pacedWriteCallback);
+  }
+  if (config_.frame_rate_conversion) {
+    cadence_ = std::make_unique<FrameCadence>(config_.target_fps);
+  }
+  createNetworkOutputs();
 }
 
 MpegTSPlayoutSink::MpegTSPlayoutSink(
@@ -70,10 +115,15 @@ MpegTSPlayoutSink::MpegTSPlayoutSink(
       running_(false),
       stop_requested_(false),
       listen_fd_(-1),
-      client_fd_(-1),
       client_connected_(false),
+      fanout_(config_.max_subscribers, config_.subscriber_queue_bytes,
+              config_.slow_client_policy,
+              config_.warm_start ? config_.subscriber_queue_bytes : 0,
+              config_.send_batch_bytes, config_.send_batch_delay_us,
+              config_.subscriber_max_lag_ms, config_.io_ring),
       pts_controller_(std::make_unique<PTSController>()),
       encoder_pipeline_(std::move(encoder_pipeline)),
+      output_ring_(kOutputSlabBytes, config_.output_queue_bytes),
       frames_sent_(0),
       frames_dropped_(0),
       late_frames_(0),
@@ -81,16 +131,95 @@ MpegTSPlayoutSink::MpegTSPlayoutSink(
       network_errors_(0),
       buffer_underruns_(0),
       late_frame_drops_(0) {
+  if (!config_.encoder_telemetry) {
+    config_.encoder_telemetry = std::make_shared<retrovue::telemetry::EncoderTelemetry>();
+  }
   // Create UDS sink if socket path is configured
   if (!config_.ts_socket_path.empty()) {
-    ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path);
+    ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path, fanout_,
+                                                      config_.ts_socket_pipe);
+  }
+  // ABR ladder: the main output keeps its GOPs aligned with the renditions
+  if (!config_.renditions.empty()) {
+    config_.fixed_gop = true;
+    rendition_ladder_ = std::make_unique<RenditionLadder>(config_);
   }
+  if (config_.audio_processing.enabled) {
+    decode::AudioProcessingConfig processing = config_.audio_processing;
+    processing.downmix = processing.downmix && config_.audio_channels == 2;
+    audio_processor_ = std::make_unique<decode::AudioProcessor>(processing);
+  }
+  if (config_.cbr_mux_rate > 0) {
+    ts_pacer_ = std::make_unique<TsPacer>(master_clock_, config_.cbr_mux_rate,
+                                          config_.cbr_burst_packets, config_.cbr_max_queue_ms,
+                                          this, &MpegTSPlayoutSink::pacedWriteCallback);
+  }
+  if (config_.frame_rate_conversion) {
+    cadence_ = std::make_unique<FrameCadence>(config_.target_fps);
+  }
+  createNetworkOutputs();
 }
 
 MpegTSPlayoutSink::~MpegTSPlayoutSink() {
   stop();
 }
 
+void MpegTSPlayoutSink::createNetworkOutputs() {
+  if (config_.udp_port > 0) {
+    UdpOutputConfig udp;
+    udp.host = config_.udp_host;
+    udp.port = config_.udp_port;
+    udp.rtp = config_.udp_rtp;
+    udp.ttl = config_.udp_ttl;
+    udp.interface_address = config_.udp_interface;
+    udp.fec_columns = config_.udp_fec_columns;
+    udp.fec_rows = config_.udp_fec_rows;
+    udp.fec_row = config_.udp_fec_row;
+    udp.txtime = config_.udp_txtime && ts_pacer_ != nullptr;
+    udp.txtime_monotonic = config_.udp_txtime_monotonic;
+    udp.txtime_lead_us = config_.udp_txtime_lead_us;
+    udp_output_ = std::make_unique<TsUdpOutput>(udp, master_clock_);
+  }
+  if (config_.srt_port > 0) {
+    SrtOutputConfig srt;
+    srt.host = config_.srt_host;
+    srt.port = config_.srt_port;
+    srt.listener = config_.srt_listener;
+    srt.latency_ms = config_.srt_latency_ms;
+    srt.passphrase = config_.srt_passphrase;
+    srt.key_length = config_.srt_key_length;
+    srt.stream_id = config_.srt_stream_id;
+    srt.stats_interval_ms = config_.srt_stats_interval_ms;
+    srt.on_stats = config_.on_srt_stats;
+    srt_output_ = std::make_unique<TsSrtOutput>(srt);
+  }
+  if (config_.hls_port > 0) {
+    HlsSegmenterConfig hls;
+    hls.path = config_.hls_path;
+    hls.segment_ms = config_.hls_segment_ms;
+    hls.part_ms = config_.hls_part_ms;
+    hls.window_segments = config_.hls_window_segments;
+    hls_segmenter_ = std::make_unique<TsHlsSegmenter>(hls);
+    hls_server_ = std::make_unique<telemetry::MetricsHTTPServer>(config_.hls_port);
+    TsHlsSegmenter* segmenter = hls_segmenter_.get();
+    hls_server_->AddHandler(config_.hls_path + "/",
+                            [segmenter](const telemetry::HttpRequest& request,
+                                        telemetry::HttpResponse& response) {
+                              return segmenter->HandleRequest(request, response);
+                            });
+  }
+  // Only the clients': a lower rate would shortchange the outputs with a
+  // receiver of their own, and a CBR mux would only stuff the difference
+  if (config_.adaptive_bitrate && !udp_output_ && !srt_output_ && !hls_segmenter_ &&
+      !config_.mpts && !ts_pacer_) {
+    const int64_t max_bps = config_.bitrate;
+    const int64_t min_bps =
+        config_.adaptive_min_bitrate > 0 ? config_.adaptive_min_bitrate : max_bps / 4;
+    rate_adapter_ = std::make_unique<TsRateAdapter>(
+        max_bps, min_bps, config_.enable_audio ? config_.audio_bitrate : 0);
+  }
+}
+
 bool MpegTSPlayoutSink::start() {
   std::lock_guard<std::mutex> lock(state_mutex_);
 
@@ -106,7 +235,8 @@ bool MpegTSPlayoutSink::start() {
   if (!config_.ts_socket_path.empty()) {
     // UDS mode: initialize Unix domain socket sink
     if (!ts_output_sink_) {
-      ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path);
+      ts_output_sink_ = std::make_unique<TsOutputSink>(config_.ts_socket_path, fanout_,
+                                                        config_.ts_socket_pipe);
     }
     if (!ts_output_sink_->Initialize()) {
       std::cerr << "[MpegTSPlayoutSink] Failed to initialize UDS sink" << std::endl;
@@ -127,11 +257,43 @@ bool MpegTSPlayoutSink::start() {
     }
   }
 
+  if (hls_segmenter_) {
+    hls_segmenter_->Open();
+  }
+  if ((rendition_ladder_ && !rendition_ladder_->Start()) ||
+      (udp_output_ && !udp_output_->Open()) || (srt_output_ && !srt_output_->Open()) ||
+      (hls_server_ && !hls_server_->Start()) || (ts_pacer_ && !startPacer()) ||
+      (config_.mpts && !joinMpts())) {
+    if (ts_pacer_) {
+      ts_pacer_->Stop();
+    }
+    if (rendition_ladder_) {
+      rendition_ladder_->Stop();
+    }
+    if (udp_output_) {
+      udp_output_->Close();
+    }
+    if (srt_output_) {
+      srt_output_->Close();
+    }
+    if (hls_server_) {
+      hls_server_->Stop();
+    }
+    if (ts_output_sink_) {
+      ts_output_sink_->Stop();
+    } else {
+      cleanupSocket();
+    }
+    internal_state_ = InternalState::Error;
+    return false;
+  }
+
   internal_state_ = InternalState::WaitingForClient;
 
   // Note: PTS mapping will be initialized on first frame (per timing contract T-002)
   // We don't set sink_start_time_utc_us_ here - it will be set when first frame is processed
   sink_start_time_recorded_ = false;
+  filler_slot_valid_ = false;
   
   std::cout << "[MpegTSPlayoutSink] Started | PTS mapping will be initialized on first frame" << std::endl;
 
@@ -146,7 +308,33 @@ bool MpegTSPlayoutSink::start() {
     running_.store(true, std::memory_order_release);
   }
 
-  // Note: Encoder pipeline is initialized when client connects
+  // Start output thread (before anything can write to the ring)
+  output_ring_.Discard();
+  output_stop_.store(false, std::memory_order_release);
+  output_thread_ = std::thread(&MpegTSPlayoutSink::outputLoop, this);
+
+  // Note: Encoder pipeline is initialized when client connects, unless warm
+  // (or sending UDP, which always has a receiver)
+  if (encodesWithoutClients()) {
+    if (initializeEncoderForClient()) {
+      client_connected_.store(true, std::memory_order_release);
+      std::cout << "[MpegTSPlayoutSink] Warm start: encoding before the first client"
+                << std::endl;
+    } else {
+      std::cerr << "[MpegTSPlayoutSink] Warm start failed; encoder opens on first client"
+                << std::endl;
+    }
+  }
+
+  // Start encode thread (before the worker that feeds it)
+  if (config_.encode_queue_depth > 0) {
+    {
+      std::lock_guard<std::mutex> encode_lock(encode_mutex_);
+      encode_stop_ = false;
+      encode_queue_.clear();
+    }
+    encode_thread_ = std::thread(&MpegTSPlayoutSink::encodeLoop, this);
+  }
 
   // Start worker thread
   stop_requested_.store(false, std::memory_order_release);
@@ -171,6 +359,7 @@ void MpegTSPlayoutSink::stop() {
 
   // Signal stop
   stop_requested_.store(true, std::memory_order_release);
+  frame_buffer_->WakeWaiters();
 
   // Wait for worker thread to exit
   if (worker_thread_.joinable()) {
@@ -182,40 +371,72 @@ void MpegTSPlayoutSink::stop() {
     accept_thread_.join();
   }
 
+  // Let the encode thread finish the frames already handed to it
+  if (encode_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> encode_lock(encode_mutex_);
+      encode_stop_ = true;
+    }
+    encode_cv_.notify_all();
+    encode_thread_.join();
+  }
+
+  // Renditions are only encoded by the (now stopped) encode path
+  if (rendition_ladder_) {
+    rendition_ladder_->Stop();
+  }
+
   // Close encoder pipeline
-  encoder_pipeline_->close();
+  {
+    std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
+    encoder_pipeline_->close();
+  }
+
+  // The output thread delivers what the encoder wrote (the trailer included)
+  if (output_thread_.joinable()) {
+    output_stop_.store(true, std::memory_order_release);
+    output_ring_.Wake();
+    output_thread_.join();
+  }
+  // The next session starts at the configured rate
+  if (rate_adapter_ && rate_adapter_->Reset() > 0) {
+    encoder_pipeline_->SetVideoBitrate(0);
+  }
+
+  // The pacer sends what it still holds (the trailer included) first
+  if (ts_pacer_) {
+    ts_pacer_->Stop();
+  }
+  if (mpts_joined_) {
+    config_.mpts->RemoveProgram(config_.mpts_program);
+    encoder_pipeline_->SetGopComplexityCallback(nullptr);
+    encoder_pipeline_->SetVideoBitrate(0);
+    mpts_joined_ = false;
+  }
+  if (udp_output_) {
+    udp_output_->Close();
+  }
+  if (srt_output_) {
+    srt_output_->Close();
+  }
+  if (hls_server_) {
+    hls_segmenter_->Close();  // Releases held LL-HLS requests
+    hls_server_->Stop();
+  }
 
   // FE-020: Ensure output ends on 188-byte TS packet boundary
-  // Write a null TS packet (188 bytes) to pad if needed
-  // This ensures the total stream size is a multiple of 188 bytes
-  // Note: We write this after encoder closes but before socket cleanup
-  // to ensure it's sent before the connection is closed
-  if (client_connected_.load(std::memory_order_acquire) && client_fd_ >= 0) {
+  // Queue a null TS packet (188 bytes) for every client after the encoder's
+  // final bytes, and give the senders a moment to deliver them before the
+  // connections are closed
+  {
     uint8_t null_packet[188] = {0};
     null_packet[0] = 0x47;  // Sync byte
     null_packet[1] = 0x1F;  // PID high byte (0x1FFF = null packet)
     null_packet[2] = 0xFF;  // PID low byte
     null_packet[3] = 0x10;  // Payload unit start indicator + adaptation field control
     // Rest is zeros (null packet payload)
-    
-    // Write null packet directly to socket (blocking send to ensure it's sent)
-    // Use blocking send here since we're shutting down and need to ensure padding is sent
-    size_t sent = 0;
-    while (sent < 188 && client_fd_ >= 0) {
-      ssize_t result = send(client_fd_, null_packet + sent, 188 - sent, MSG_NOSIGNAL);
-      if (result < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          // Socket buffer full - wait a bit and retry
-          std::this_thread::sleep_for(std::chrono::milliseconds(10));
-          continue;
-        } else {
-          // Error - break and continue with cleanup
-          break;
-        }
-      } else if (result > 0) {
-        sent += static_cast<size_t>(result);
-      }
-    }
+    constexpr int64_t kCloseDrainTimeoutMs = 1000;
+    fanout_.CloseAll(null_packet, sizeof(null_packet), kCloseDrainTimeoutMs);
   }
 
   // Cleanup socket (TCP or UDS)
@@ -252,12 +473,69 @@ MpegTSPlayoutSink::SinkStats MpegTSPlayoutSink::getStats() const {
   stats.network_errors = network_errors_.load(std::memory_order_relaxed);
   stats.buffer_underruns = buffer_underruns_.load(std::memory_order_relaxed);
   stats.late_frame_drops = late_frame_drops_.load(std::memory_order_relaxed);
+  stats.encode_queue_drops = encode_queue_drops_.load(std::memory_order_relaxed);
+  stats.output_gop_skips = output_gop_skips_.load(std::memory_order_relaxed);
+  stats.filler_frames = filler_frames_.load(std::memory_order_relaxed);
+  if (encoder_pipeline_) {
+    stats.cached_frames = encoder_pipeline_->GetCachedFrames();
+    stats.passthrough_frames = encoder_pipeline_->GetPassthroughFrames();
+    stats.passthrough_skips = encoder_pipeline_->GetPassthroughSkips();
+    stats.device_frames = encoder_pipeline_->GetDeviceFrames();
+    stats.device_downloads = encoder_pipeline_->GetDeviceDownloads() +
+                             device_downloads_.load(std::memory_order_relaxed);
+    stats.encoder_threads = encoder_pipeline_->GetEncoderThreads();
+  }
+  if (config_.ts_cache) {
+    stats.ts_cache = config_.ts_cache->GetStats();
+  }
+  if (config_.encoder_threads) {
+    stats.encoder_thread_budget = config_.encoder_threads->GetStats();
+  }
+  if (config_.overlays) {
+    stats.overlays = config_.overlays->GetStats();
+  }
+  if (audio_processor_) {
+    stats.audio_processing = audio_processor_->GetStats();
+  }
+  stats.audio_frames = audio_frames_.load(std::memory_order_relaxed);
+  stats.hibernating = hibernating_.load(std::memory_order_acquire);
+  stats.hibernations = hibernations_.load(std::memory_order_relaxed);
+  stats.splices = splices_.load(std::memory_order_relaxed);
+  if (encoder_pipeline_) {
+    stats.ts = encoder_pipeline_->GetTsStats();
+    stats.mux = encoder_pipeline_->GetMuxStats();
+  }
+  stats.fanout = fanout_.GetStats();
+  stats.network_errors += stats.fanout.send_failures;
+  if (ts_pacer_) {
+    stats.pacer = ts_pacer_->GetStats();
+  }
+  stats.output = output_ring_.GetStats();
+  if (udp_output_) {
+    stats.udp = udp_output_->GetStats();
+  }
+  if (srt_output_) {
+    stats.srt = srt_output_->GetStats();
+  }
+  if (hls_segmenter_) {
+    stats.hls = hls_segmenter_->GetStats();
+  }
+  if (rendition_ladder_) {
+    stats.renditions = rendition_ladder_->GetStats();
+  }
+  if (rate_adapter_) {
+    stats.rate_adapter = rate_adapter_->GetStats();
+  }
+  if (cadence_) {
+    stats.cadence = cadence_->GetStats();
+  }
+  stats.encoder = config_.encoder_telemetry->Snapshot();
   return stats;
 }
 
 void MpegTSPlayoutSink::workerLoop() {
-  // Timing constants
-  constexpr int64_t kMaxLateToleranceUs = 50'000;  // 50ms tolerance for late frames
+  retrovue::telemetry::NameCurrentThread(config_.channel_id, "pace");
+  // Timing constants (and kMaxLateToleranceUs)
   constexpr int64_t kSoftWaitThresholdUs = 5'000;   // 5ms - sleep if ahead by more
   constexpr int64_t kWaitFudgeUs = 500;             // 500µs - wake slightly before deadline
   constexpr int64_t kMinSleepUs = 100;              // 100µs minimum sleep to avoid busy loop
@@ -275,46 +553,23 @@ void MpegTSPlayoutSink::workerLoop() {
     // Poll master clock for current time (ALWAYS pull from MasterClock)
     const int64_t now_us = master_clock_->now_utc_us();
 
-    // Try to accept new client connection (non-blocking)
+    // Try to accept new client connections (non-blocking)
     // For UDS mode, the accept is handled by TsOutputSink
-    if (!config_.ts_socket_path.empty()) {
-      // UDS mode: check if client is connected
-      if (ts_output_sink_ && ts_output_sink_->IsClientConnected()) {
-        if (!client_connected_.load(std::memory_order_acquire)) {
-          client_connected_.store(true, std::memory_order_release);
-          // Initialize encoder for new client
-          if (!initializeEncoderForClient()) {
-            std::cerr << "[MpegTSPlayoutSink] Failed to initialize encoder for UDS client" << std::endl;
-            client_connected_.store(false, std::memory_order_release);
-          }
-        }
-      } else {
-        // Client disconnected
-        if (client_connected_.load(std::memory_order_acquire)) {
-          handleClientDisconnect();
-        }
-      }
-    } else {
-      // TCP mode: try to accept client
+    if (config_.ts_socket_path.empty()) {
       tryAcceptClient();
     }
+    updateSubscribers();
 
-    // Try to drain output queue first (send pending packets)
-    drainOutputQueue();
-    
-    // FE-017: Note - we no longer drain pending AVIO bytes here
-    // The writeAllBlocking callback ensures all bytes are written atomically
-    // No need for separate drain logic that could reorder packets
-
-    // Check output queue size to decide if we should encode new frames
-    size_t queue_size = 0;
-    {
-      std::lock_guard<std::mutex> lock(output_queue_mutex_);
-      queue_size = output_queue_.size();
+    // Idle channel: nothing is decoded or paced until a client connects
+    if (updateHibernation(now_us)) {
+      waitForClient();
+      continue;
     }
 
-    // Only encode new frames if queue is below high-water mark
-    if (queue_size >= config_.output_queue_high_water_mark) {
+    // FE-017: The output thread hands the ring's whole packets to the
+    // fanout in muxer order; only encode new frames while the ring is below
+    // its high-water mark
+    if (output_ring_.QueuedBytes() >= config_.output_queue_high_water_bytes) {
       std::this_thread::sleep_for(std::chrono::microseconds(kMinSleepUs));
       continue;
     }
@@ -329,6 +584,7 @@ void MpegTSPlayoutSink::workerLoop() {
 
     if (next_frame == nullptr) {
       // Buffer is empty - handle underflow
+      RETROVUE_TRACE_INSTANT("sink.underflow");
       handleBufferUnderflow(now_us);
 
       // Check stop_requested_ before sleeping
@@ -337,9 +593,11 @@ void MpegTSPlayoutSink::workerLoop() {
         break;
       }
 
-      // In underflow case, use real-time sleep (not MasterClock timing)
-      // This prevents hanging when no producer is pushing frames and clock isn't advancing
-      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      // In underflow case, wait in real time (not MasterClock timing) for the
+      // producer's next push. This prevents hanging when no producer is pushing
+      // frames and the clock isn't advancing, and wakes as soon as a frame lands.
+      frame_buffer_->WaitForFrame(std::chrono::steady_clock::now() +
+                                  std::chrono::microseconds(kUnderrunBackoffUs));
       
       // Check stop_requested_ after sleep
       if (!running_.load(std::memory_order_acquire) ||
@@ -349,8 +607,18 @@ void MpegTSPlayoutSink::workerLoop() {
       continue;
     }
 
-    // Extract pts_usec from frame metadata
-    const int64_t pts_usec = next_frame->metadata.pts;
+    // With frame-rate conversion, decoded frames are paced by the grid's
+    // ticks; compressed ones go one for one, and the grid restarts after them
+    const bool cadenced =
+        cadence_ && next_frame->format != retrovue::buffer::PixelFormat::kH264;
+    if (cadence_ && !cadenced) {
+      cadence_->Reset();
+      cadence_last_.Reset();
+    }
+
+    // Extract pts_usec from frame metadata (the tick's, when cadenced)
+    const int64_t pts_usec =
+        cadenced ? cadence_->Tick(next_frame->metadata.pts) : next_frame->metadata.pts;
 
     // Calculate target station time for this frame
     int64_t target_time_us = 0;
@@ -373,14 +641,17 @@ void MpegTSPlayoutSink::workerLoop() {
       constexpr int64_t kSameTimebaseThresholdUs = 1'000'000;  // 1 second
       if (pts_age_us > 0 && pts_age_us < kSameTimebaseThresholdUs && pts_age_us > kMaxLateToleranceUs) {
         // Frame is late and PTS appears to be in same timebase as clock - drop it (FE-003)
-        retrovue::buffer::Frame dropped_frame;
-        if (frame_buffer_->Pop(dropped_frame)) {
+        splice_carry_ = splice_carry_ || next_frame->metadata.splice_point;
+        if (cadenced) {
+          cadence_->Reset();
+        }
+        if (frame_buffer_->Discard(1) == 1) {
           late_frame_drops_.fetch_add(1, std::memory_order_relaxed);
           frames_dropped_.fetch_add(1, std::memory_order_relaxed);
           late_frames_.fetch_add(1, std::memory_order_relaxed);
           std::cout << "[MpegTSPlayoutSink] Dropped late frame (before PTS init) | "
                     << "pts_age=" << (pts_age_us / 1000) << "ms | "
-                    << "pts_usec=" << dropped_frame.metadata.pts << " | "
+                    << "pts_usec=" << pts_usec << " | "
                     << "now_us=" << now_us << std::endl;
         }
         continue;  // Wait for a better frame to initialize PTS mapping
@@ -410,27 +681,73 @@ void MpegTSPlayoutSink::workerLoop() {
 
     // Handle late frames (beyond tolerance)
     if (gap_us > kMaxLateToleranceUs) {
-      // Frame is too late - drop it
-      retrovue::buffer::Frame dropped_frame;
-      if (frame_buffer_->Pop(dropped_frame)) {
-        late_frame_drops_.fetch_add(1, std::memory_order_relaxed);
-        frames_dropped_.fetch_add(1, std::memory_order_relaxed);
-        late_frames_.fetch_add(1, std::memory_order_relaxed);
+      // Frame is too late - drop it together with every queued frame behind it
+      // that is also past tolerance, in one index update and without copying
+      // payloads, so catch-up after a stall costs no per-frame copies.
+      const int64_t min_on_time_pts =
+          now_us - sink_start_time_utc_us_ - kMaxLateToleranceUs;
+      splice_carry_ = splice_carry_ || next_frame->metadata.splice_point;
+      const size_t dropped = frame_buffer_->DiscardUntilPts(min_on_time_pts);
+      if (cadenced) {
+        cadence_->SkipTo(min_on_time_pts);  // The ticks missed are not filled
+      }
+      if (dropped > 0) {
+        RETROVUE_TRACE_COUNTER("sink.late_drops", dropped);
+        late_frame_drops_.fetch_add(dropped, std::memory_order_relaxed);
+        frames_dropped_.fetch_add(dropped, std::memory_order_relaxed);
+        late_frames_.fetch_add(dropped, std::memory_order_relaxed);
 
         // Log the drop
-        std::cout << "[MpegTSPlayoutSink] Dropped late frame | "
+        std::cout << "[MpegTSPlayoutSink] Dropped late frames | "
+                  << "count=" << dropped << " | "
                   << "gap=" << (gap_us / 1000) << "ms | "
-                  << "pts_usec=" << dropped_frame.metadata.pts << " | "
+                  << "pts_usec=" << pts_usec << " | "
                   << "buffer=" << frame_buffer_->Size() << "/"
                   << frame_buffer_->Capacity() << std::endl;
       }
       continue;
     }
 
+    // The tick shows the front frame, the one after it, or the last one
+    // again: a repeat is the same pooled frame, with the tick's PTS
+    bool repeat = false;
+    if (cadenced) {
+      const retrovue::buffer::Frame* queued[2] = {};
+      const size_t count = frame_buffer_->PeekRange(queued);
+      const int64_t next_pts = count > 1 ? queued[1]->metadata.pts : 0;
+      const FrameCadence::Action action =
+          cadence_->Decide(next_frame->metadata.pts, count > 1 ? &next_pts : nullptr,
+                           static_cast<bool>(cadence_last_));
+      if (action == FrameCadence::Action::kDrop) {
+        splice_carry_ = splice_carry_ || next_frame->metadata.splice_point;
+        if (frame_buffer_->Discard(1) == 1) {
+          cadence_->Dropped();
+        }
+        continue;
+      }
+      repeat = action == FrameCadence::Action::kRepeat;
+    }
+
     // Frame is on time or slightly late (within tolerance) - emit it
-    retrovue::buffer::Frame frame;
-    if (!frame_buffer_->Pop(frame)) {
-      continue;
+    retrovue::buffer::FrameHandle frame;
+    if (repeat) {
+      frame = cadence_last_;
+      cadence_->Repeated();
+    } else {
+      if (!frame_buffer_->Pop(frame)) {
+        continue;
+      }
+      frame->metadata.trace.Mark(retrovue::buffer::FrameStage::kPopped);
+      RETROVUE_TRACE_COUNTER("sink.frame_gap_us", gap_us);
+
+      if (splice_carry_) {
+        frame->metadata.splice_point = true;
+        splice_carry_ = false;
+      }
+      if (cadenced) {
+        cadence_->Shown(frame->metadata.pts);
+        cadence_last_ = frame;
+      }
     }
 
     // Track late frame if slightly late (within tolerance but still late)
@@ -441,8 +758,22 @@ void MpegTSPlayoutSink::workerLoop() {
     // Calculate PTS in 90kHz units for encoder
     const int64_t pts90k = (pts_usec * 90000) / 1'000'000;
 
-    // Process the frame (encode and send)
-    processFrame(frame, now_us, pts90k, frame_counter, gap_us);
+    // Producer audio up to the end of this frame travels with it, so the
+    // encoder sees both streams advance together
+    std::vector<retrovue::buffer::AudioFrame> audio;
+    if (config_.enable_audio && config_.audio_source == AudioSource::PRODUCER) {
+      popAudioUntil(pts_usec + frame_duration_us, &audio);
+    }
+
+    // Hand the frame to the encode stage; pacing continues without waiting
+    // for the encode
+    submitFrame(std::move(frame), std::move(audio), now_us, pts90k, frame_counter, gap_us,
+                repeat);
+
+    // The frame after this one is the first filler slot should it not arrive
+    filler_slot_valid_ = true;
+    filler_slot_time_us_ = target_time_us + frame_duration_us;
+    filler_slot_pts90k_ = pts90k + static_cast<int64_t>(90000.0 / config_.target_fps);
 
     // Update statistics
     frames_sent_.fetch_add(1, std::memory_order_relaxed);
@@ -452,52 +783,215 @@ void MpegTSPlayoutSink::workerLoop() {
     std::this_thread::sleep_for(std::chrono::microseconds(kMinSleepUs));
   }
   
-  // FE-020: When stop_requested_ is set, flush encoder and drain all pending data
-  // This ensures all encoded packets are sent before shutdown
-  if (stop_requested_.load(std::memory_order_acquire)) {
-    // Flush encoder pipeline (sends NULL frame to drain remaining packets)
-    if (client_connected_.load(std::memory_order_acquire)) {
-      // The encoder pipeline will be closed in stop(), but we need to ensure
-      // all pending data is drained first
-      
-      // Continue draining output queue until empty
-      // Note: AVIO bytes are written atomically via blocking writes, so no separate drain needed
-      constexpr int max_flush_iterations = 100;
-      constexpr int flush_sleep_ms = 10;
-      for (int i = 0; i < max_flush_iterations; ++i) {
-        size_t drained_queue = drainOutputQueue();
-        
-        // If nothing was drained, we're done
-        if (drained_queue == 0) {
-          break;
-        }
-        
-        // Small sleep to allow socket buffer to drain
-        std::this_thread::sleep_for(std::chrono::milliseconds(flush_sleep_ms));
-      }
+  cadence_last_.Reset();
+
+  // FE-020: stop() closes the encoder once this loop exits, and the output
+  // thread delivers everything queued before the clients are closed
+}
+
+void MpegTSPlayoutSink::popAudioUntil(int64_t pts_us,
+                                      std::vector<retrovue::buffer::AudioFrame>* audio) {
+  const retrovue::buffer::AudioFrame* next = nullptr;
+  while ((next = frame_buffer_->PeekAudioFrame()) != nullptr && next->pts_us < pts_us) {
+    audio->emplace_back();
+    if (!frame_buffer_->PopAudioFrame(audio->back())) {
+      audio->pop_back();
+      break;
     }
   }
+  audio_frames_.fetch_add(audio->size(), std::memory_order_relaxed);
 }
 
-void MpegTSPlayoutSink::processFrame(const retrovue::buffer::Frame& frame,
+void MpegTSPlayoutSink::processFrame(const retrovue::buffer::FrameHandle& frame,
+                                     std::vector<retrovue::buffer::AudioFrame>& audio,
                                      int64_t master_time_us,
                                      int64_t pts90k,
                                      uint64_t frame_number,
-                                     int64_t drift_us) {
-  // Phase 6: Real encoding via EncoderPipeline
+                                     int64_t drift_us,
+                                     bool repeat) {
+  RETROVUE_TRACE_SCOPE("sink.process_frame");
+  // A rendition that opened or gained a client starts on a keyframe; the
+  // main output takes one on the same frame to keep IDRs aligned
+  if (rendition_ladder_ && rendition_ladder_->UpdateOutputs()) {
+    encoder_pipeline_->RequestKeyframe();
+  }
+
+  // First frame of a switched-in producer: restart the GOP on every output
+  if (frame->metadata.splice_point && !repeat) {
+    encoder_pipeline_->RequestKeyframe();
+    if (rendition_ladder_) {
+      rendition_ladder_->RequestKeyframe();
+    }
+    splices_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Audio is processed whether or not anyone watches, so the loudness
+  // measure and the gain are settled when a client connects
+  if (audio_processor_ && !audio.empty()) {
+    for (retrovue::buffer::AudioFrame& samples : audio) {
+      audio_processor_->Process(samples);
+    }
+    const decode::AudioProcessorStats processed = audio_processor_->GetStats();
+    config_.encoder_telemetry->SetAudioLoudness(processed.integrated_lufs, processed.gain_db);
+  }
+
+  // Overlays on air go onto the frame once, before the first output that
+  // encodes it; a cached airing carries them already
+  std::shared_ptr<const decode::OverlaySet> overlays;
+  if (config_.overlays) {
+    overlays = config_.overlays->ActiveAt(master_time_us);
+  }
+  // A GPU surface comes down to system memory only for what blends or
+  // scales it here (overlays, renditions)
+  const auto download = [&]() {
+    if (frame->format == retrovue::buffer::PixelFormat::kDevice) {
+      device_downloads_.fetch_add(1, std::memory_order_relaxed);
+      return decode::DownloadDeviceFrame(*frame, frame.get());
+    }
+    return true;
+  };
+  // A repeat carries the overlays it got the first time
+  bool composited = repeat && frame.get() == composited_frame_;
+  const auto composite = [&]() {
+    if (overlays && !composited) {
+      composited = true;
+      if (download()) {
+        config_.overlays->Composite(*overlays, frame.get());
+        composited_frame_ = frame.get();
+      }
+    }
+  };
+
+  // Phase 6: Real encoding via EncoderPipeline (a repeat's trace ended
+  // with its first encode)
+  retrovue::buffer::FrameTrace repeat_trace;
+  retrovue::buffer::FrameTrace& trace = repeat ? repeat_trace : frame->metadata.trace;
   bool client_connected = client_connected_.load(std::memory_order_acquire);
   if (client_connected) {
-    if (!encoder_pipeline_->encodeFrame(frame, pts90k)) {
-      encoding_errors_.fetch_add(1, std::memory_order_relaxed);
-      std::cerr << "[MpegTSPlayoutSink] Encoding failed for frame #" << frame_number << std::endl;
-      // Continue processing - don't block the producer
+    std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
+    const uint64_t output_bytes = trace.sampled() ? output_ring_.BytesWritten() : 0;
+    trace.Mark(retrovue::buffer::FrameStage::kEncodeStart);
+    // A cached airing goes out as it was muxed, its audio included
+    encoder_pipeline_->SetOverlayKey(overlays ? overlays->name : std::string());
+    if (!encoder_pipeline_->EmitCachedFrame(*frame, pts90k, repeat)) {
+      for (const retrovue::buffer::AudioFrame& samples : audio) {
+        if (!encoder_pipeline_->encodeAudioFrame(samples)) {
+          encoding_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      composite();
+      if (!encoder_pipeline_->encodeFrame(frame, pts90k)) {
+        encoding_errors_.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[MpegTSPlayoutSink] Encoding failed for frame #" << frame_number
+                  << std::endl;
+        // Continue processing - don't block the producer
+      }
+    }
+    trace.Mark(retrovue::buffer::FrameStage::kEncodeEnd);
+    if (trace.sampled()) {
+      traceEncodedFrame(trace, output_bytes);
     }
   } else {
     // No client connected - skip encoding (frame is dropped)
-    // This saves CPU when no one is watching
+    // This saves CPU when no one is watching; a sampled frame's trace ends
+    // at the pop
+    if (trace.sampled() && config_.on_frame_trace) {
+      config_.on_frame_trace(trace);
+    }
+  }
+
+  // Renditions without clients are skipped inside the ladder
+  if (rendition_ladder_) {
+    for (const retrovue::buffer::AudioFrame& samples : audio) {
+      rendition_ladder_->EncodeAudio(samples);
+    }
+    composite();
+    if (download()) {
+      rendition_ladder_->EncodeFrame(*frame, pts90k);
+    }
+  }
+}
+
+void MpegTSPlayoutSink::processFiller(int64_t pts90k) {
+  if (rendition_ladder_ && rendition_ladder_->UpdateOutputs()) {
+    encoder_pipeline_->RequestKeyframe();
+  }
+  if (client_connected_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
+    if (encoder_pipeline_->EmitFiller(pts90k)) {
+      filler_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (rendition_ladder_) {
+    rendition_ladder_->EmitFiller(pts90k);
   }
 }
 
+void MpegTSPlayoutSink::submitFrame(retrovue::buffer::FrameHandle frame,
+                                    std::vector<retrovue::buffer::AudioFrame> audio,
+                                    int64_t master_time_us,
+                                    int64_t pts90k,
+                                    uint64_t frame_number,
+                                    int64_t drift_us,
+                                    bool repeat) {
+  if (config_.encode_queue_depth == 0) {
+    processFrame(frame, audio, master_time_us, pts90k, frame_number, drift_us, repeat);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(encode_mutex_);
+    if (encode_queue_.size() >= config_.encode_queue_depth) {
+      // Encoder is behind: the oldest frame would be late by the time it is
+      // encoded, so drop it rather than stall pacing
+      const EncodeJob& oldest = encode_queue_.front();
+      if (oldest.frame && !oldest.repeat && oldest.frame->metadata.splice_point) {
+        // The next frame in order starts the switched-in producer instead
+        auto next = std::find_if(encode_queue_.begin() + 1, encode_queue_.end(),
+                                 [](const EncodeJob& job) { return job.frame && !job.repeat; });
+        (next != encode_queue_.end() ? next->frame : frame)->metadata.splice_point = true;
+      }
+      encode_queue_.pop_front();
+      encode_queue_drops_.fetch_add(1, std::memory_order_relaxed);
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    encode_queue_.push_back(EncodeJob{std::move(frame), std::move(audio), master_time_us,
+                                      pts90k, frame_number, drift_us, repeat});
+  }
+  encode_cv_.notify_one();
+}
+
+void MpegTSPlayoutSink::encodeLoop() {
+  retrovue::telemetry::NameCurrentThread(config_.channel_id, "encode");
+  while (true) {
+    EncodeJob job;
+    {
+      std::unique_lock<std::mutex> lock(encode_mutex_);
+      encode_cv_.wait(lock, [this] { return encode_stop_ || !encode_queue_.empty(); });
+      if (encode_queue_.empty()) {
+        return;  // Stopped and drained
+      }
+      job = std::move(encode_queue_.front());
+      encode_queue_.pop_front();
+    }
+    if (job.frame) {
+      processFrame(job.frame, job.audio, job.master_time_us, job.pts90k, job.frame_number,
+                   job.drift_us, job.repeat);
+    } else {
+      processFiller(job.pts90k);
+    }
+  }
+}
+
+void MpegTSPlayoutSink::clearEncodeQueue() {
+  std::deque<EncodeJob> stale;
+  {
+    std::lock_guard<std::mutex> lock(encode_mutex_);
+    stale.swap(encode_queue_);
+  }
+  // Handles return their frames to the pool here, off the lock
+}
+
 void MpegTSPlayoutSink::handleBufferUnderflow(int64_t master_time_us) {
   // Increment underrun counter
   buffer_underruns_.fetch_add(1, std::memory_order_relaxed);
@@ -507,6 +1001,31 @@ void MpegTSPlayoutSink::handleBufferUnderflow(int64_t master_time_us) {
   //          << "underruns=" << buffer_underruns_.load(std::memory_order_relaxed)
   //          << " | buffer=0/" << frame_buffer_->Capacity()
   //          << " | now_utc_us=" << master_time_us << std::endl;
+
+  // Fill a frame slot once it is past the late tolerance (a frame for it
+  // would be dropped as late anyway) with pre-encoded filler; one slot per
+  // call, in order with the frames already handed to the encode stage
+  if (config_.underflow_policy == UnderflowPolicy::SKIP || !filler_slot_valid_ ||
+      master_time_us - filler_slot_time_us_ <= kMaxLateToleranceUs) {
+    return;
+  }
+  const int64_t pts90k = filler_slot_pts90k_;
+  filler_slot_time_us_ += static_cast<int64_t>(1'000'000.0 / config_.target_fps);
+  filler_slot_pts90k_ += static_cast<int64_t>(90000.0 / config_.target_fps);
+
+  if (config_.encode_queue_depth == 0) {
+    processFiller(pts90k);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(encode_mutex_);
+    if (encode_queue_.size() >= config_.encode_queue_depth) {
+      return;  // Encoder still busy with real frames; no filler needed yet
+    }
+    encode_queue_.push_back(EncodeJob{retrovue::buffer::FrameHandle(), {}, master_time_us,
+                                      pts90k, 0, 0});
+  }
+  encode_cv_.notify_one();
 }
 
 void MpegTSPlayoutSink::handleBufferOverflow(int64_t master_time_us) {
@@ -568,8 +1087,8 @@ bool MpegTSPlayoutSink::initializeSocket() {
     return false;
   }
 
-  // Listen for connections (backlog of 1 - only accept one client at a time)
-  if (listen(listen_fd_, 1) < 0) {
+  // Listen for connections (backlog sized for the fanout's subscriber limit)
+  if (listen(listen_fd_, static_cast<int>(config_.max_subscribers)) < 0) {
     std::cerr << "[MpegTSPlayoutSink] Failed to listen: " 
               << strerror(errno) << std::endl;
     close(listen_fd_);
@@ -583,12 +1102,8 @@ bool MpegTSPlayoutSink::initializeSocket() {
 }
 
 void MpegTSPlayoutSink::cleanupSocket() {
-  // Close client socket if connected
-  if (client_fd_ >= 0) {
-    close(client_fd_);
-    client_fd_ = -1;
-  }
-  
+  // Client sockets are closed by fanout_
+
   // Close listen socket
   if (listen_fd_ >= 0) {
     close(listen_fd_);
@@ -596,10 +1111,9 @@ void MpegTSPlayoutSink::cleanupSocket() {
   }
   
   client_connected_.store(false, std::memory_order_release);
-  
-  // Clear output queue
-  std::lock_guard<std::mutex> lock(output_queue_mutex_);
-  output_queue_.clear();
+
+  // Output thread is stopped: drop anything it did not deliver
+  output_ring_.Discard();
 }
 
 void MpegTSPlayoutSink::acceptThread() {
@@ -638,74 +1152,107 @@ bool MpegTSPlayoutSink::tryAcceptClient() {
   if (!config_.ts_socket_path.empty()) {
     return false;  // Not applicable for UDS mode
   }
-  
-  // If already connected, don't accept another
-  if (client_connected_.load(std::memory_order_acquire)) {
-    return false;
-  }
 
   if (listen_fd_ < 0) {
     return false;
   }
 
-  struct sockaddr_in client_addr;
-  socklen_t addr_len = sizeof(client_addr);
-  int new_client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &addr_len);
+  bool accepted = false;
+  while (true) {
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    int new_client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &addr_len);
 
-  if (new_client_fd < 0) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      return false;
-    } else {
-      std::cerr << "[MpegTSPlayoutSink] Accept error: " << strerror(errno) << std::endl;
-      return false;
+    if (new_client_fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "[MpegTSPlayoutSink] Accept error: " << strerror(errno) << std::endl;
+      }
+      return accepted;  // No more clients waiting
+    }
+
+    // FE-017: Set client socket to BLOCKING mode for atomic packet writes
+    // This ensures TS packets (188 bytes) are written atomically, preserving continuity counters
+    // The listen/accept socket remains non-blocking, only the client socket is blocking
+    // (each client's sender thread is the only writer, so blocking stalls only that client)
+    int flags = fcntl(new_client_fd, F_GETFL, 0);
+    if (flags < 0) {
+      std::cerr << "[MpegTSPlayoutSink] Failed to get socket flags: " 
+                << strerror(errno) << std::endl;
+      close(new_client_fd);
+      continue;
+    }
+    // Clear O_NONBLOCK flag to make socket blocking
+    if (fcntl(new_client_fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+      std::cerr << "[MpegTSPlayoutSink] Failed to set client socket blocking: " 
+                << strerror(errno) << std::endl;
+      close(new_client_fd);
+      continue;
+    }
+  
+    // FE-017: Increase send buffer size for better performance
+    // Larger buffer means more data can be queued in kernel
+    int send_buf_size = 256 * 1024;  // 256KB send buffer
+    if (setsockopt(new_client_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
+      std::cerr << "[MpegTSPlayoutSink] Warning: Failed to set SO_SNDBUF: " 
+                << strerror(errno) << std::endl;
+      // Continue anyway - not critical
+    }
+
+    // The fanout owns the socket from here; the worker opens the encoder
+    // (or requests a keyframe) when it sees the new subscriber
+    char client_ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+    const std::string label =
+        std::string(client_ip) + ":" + std::to_string(ntohs(client_addr.sin_port));
+    if (fanout_.AddSubscriber(new_client_fd, label)) {
+      accepted = true;
     }
   }
+}
 
-  // FE-017: Set client socket to BLOCKING mode for atomic packet writes
-  // This ensures TS packets (188 bytes) are written atomically, preserving continuity counters
-  // The listen/accept socket remains non-blocking, only the client socket is blocking
-  int flags = fcntl(new_client_fd, F_GETFL, 0);
-  if (flags < 0) {
-    std::cerr << "[MpegTSPlayoutSink] Failed to get socket flags: " 
-              << strerror(errno) << std::endl;
-    close(new_client_fd);
-    return false;
+void MpegTSPlayoutSink::updateSubscribers() {
+  const TsFanoutStats fanout = fanout_.GetStats();
+  if (fanout.gop_resyncs != gop_resyncs_seen_) {
+    // A slow client lost queued GOPs (DROP_OLDEST): it resumes at the next
+    // keyframe, so make that soon
+    gop_resyncs_seen_ = fanout.gop_resyncs;
+    encoder_pipeline_->RequestKeyframe();
+    if (rendition_ladder_) {
+      rendition_ladder_->RequestKeyframe();
+    }
   }
-  // Clear O_NONBLOCK flag to make socket blocking
-  if (fcntl(new_client_fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
-    std::cerr << "[MpegTSPlayoutSink] Failed to set client socket blocking: " 
-              << strerror(errno) << std::endl;
-    close(new_client_fd);
-    return false;
+  if (encodesWithoutClients() && client_connected_.load(std::memory_order_acquire)) {
+    // Warm (or UDP): the encoder runs without clients, and a joining client
+    // starts from the fanout's cached GOP with warm_start (otherwise from
+    // the next PAT)
+    subscribers_seen_ = fanout.subscribers_total;
+    return;
   }
-  
-  // FE-017: Increase send buffer size for better performance
-  // Larger buffer means more data can be queued in kernel
-  int send_buf_size = 256 * 1024;  // 256KB send buffer
-  if (setsockopt(new_client_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
-    std::cerr << "[MpegTSPlayoutSink] Warning: Failed to set SO_SNDBUF: " 
-              << strerror(errno) << std::endl;
-    // Continue anyway - not critical
+  if (fanout.subscribers == 0) {
+    if (client_connected_.load(std::memory_order_acquire)) {
+      handleClientDisconnect();
+    }
+    return;
   }
 
-  // Store client file descriptor
-  client_fd_ = new_client_fd;
-  client_connected_.store(true, std::memory_order_release);
-
-  // Log connection
-  char client_ip[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-  std::cout << "[MpegTSPlayoutSink] Client connected from " << client_ip 
-            << ":" << ntohs(client_addr.sin_port) << std::endl;
-
-  // Initialize encoder for new client
-  if (!initializeEncoderForClient()) {
-    std::cerr << "[MpegTSPlayoutSink] Failed to initialize encoder for client" << std::endl;
-    handleClientDisconnect();
-    return false;
+  const bool joined = fanout.subscribers_total != subscribers_seen_;
+  subscribers_seen_ = fanout.subscribers_total;
+  if (!client_connected_.load(std::memory_order_acquire)) {
+    // First client: start a fresh stream (PAT/PMT, keyframe, CC from 0)
+    client_connected_.store(true, std::memory_order_release);
+    if (!initializeEncoderForClient()) {
+      std::cerr << "[MpegTSPlayoutSink] Failed to initialize encoder for client" << std::endl;
+      client_connected_.store(false, std::memory_order_release);
+    } else if (rendition_ladder_) {
+      rendition_ladder_->RequestKeyframe();  // Keep the ladder's IDRs aligned
+    }
+  } else if (joined) {
+    // Another client joined the running stream
+    encoder_pipeline_->RequestKeyframe();
+    if (rendition_ladder_) {
+      rendition_ladder_->RequestKeyframe();
+    }
   }
-
-  return true;
 }
 
 void MpegTSPlayoutSink::handleClientDisconnect() {
@@ -713,178 +1260,343 @@ void MpegTSPlayoutSink::handleClientDisconnect() {
     return;  // Already disconnected
   }
 
-  std::cout << "[MpegTSPlayoutSink] Client disconnected" << std::endl;
-
-  // Close client socket
-  if (client_fd_ >= 0) {
-    close(client_fd_);
-    client_fd_ = -1;
-  }
+  std::cout << "[MpegTSPlayoutSink] Last client disconnected" << std::endl;
 
   // Mark as disconnected
   client_connected_.store(false, std::memory_order_release);
 
-  // Clear output queue (client is gone, no point keeping packets)
-  {
-    std::lock_guard<std::mutex> lock(output_queue_mutex_);
-    output_queue_.clear();
+  // Frames queued for the old client are not encoded (unless renditions
+  // still need them)
+  if (!rendition_ladder_) {
+    clearEncodeQueue();
   }
 
   // Close encoder pipeline (will reopen on next client)
-  encoder_pipeline_->close();
+  {
+    std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
+    encoder_pipeline_->close();
+  }
+  if (ts_pacer_) {
+    waitOutputDrained();  // The old session's bytes reach the pacer first
+    ts_pacer_->Reset();   // The pacer idles until the next session
+  }
 
   // Reset encoder state for next client
 }
 
+bool MpegTSPlayoutSink::hasClients() const {
+  if (fanout_.GetStats().subscribers > 0) {
+    return true;
+  }
+  if (rendition_ladder_) {
+    for (const RenditionStats& rendition : rendition_ladder_->GetStats()) {
+      if (rendition.fanout.subscribers > 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool MpegTSPlayoutSink::updateHibernation(int64_t now_us) {
+  if (config_.hibernate_after_ms <= 0 || encodesWithoutClients()) {
+    return false;
+  }
+  const bool hibernating = hibernating_.load(std::memory_order_relaxed);
+  if (hasClients()) {
+    idle_since_us_ = -1;
+    if (hibernating) {
+      // Anything queued predates the pause; the producer resumes at the
+      // schedule-correct position and the first frame it pushes is on time
+      discardBufferedFrames();
+      filler_slot_valid_ = false;
+      hibernating_.store(false, std::memory_order_release);
+      std::cout << "[MpegTSPlayoutSink] Client connected; waking from hibernation" << std::endl;
+      if (config_.on_hibernate) {
+        config_.on_hibernate(false);
+      }
+    }
+    return false;
+  }
+  if (hibernating) {
+    discardBufferedFrames();  // Whatever the producer pushed before it paused
+    return true;
+  }
+  if (idle_since_us_ < 0) {
+    idle_since_us_ = now_us;
+  }
+  if (now_us - idle_since_us_ < config_.hibernate_after_ms * 1000) {
+    return false;
+  }
+
+  std::cout << "[MpegTSPlayoutSink] No client for " << config_.hibernate_after_ms
+            << "ms; hibernating" << std::endl;
+  hibernating_.store(true, std::memory_order_release);
+  hibernations_.fetch_add(1, std::memory_order_relaxed);
+  clearEncodeQueue();
+  if (config_.on_hibernate) {
+    config_.on_hibernate(true);
+  }
+  discardBufferedFrames();
+  return true;
+}
+
+void MpegTSPlayoutSink::waitForClient() {
+  if (listen_fd_ >= 0) {
+    // Returns as soon as a client is waiting; the next pass accepts it
+    struct pollfd pfd = {listen_fd_, POLLIN, 0};
+    poll(&pfd, 1, kHibernatePollMs);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(kHibernatePollMs));
+}
+
+void MpegTSPlayoutSink::discardBufferedFrames() {
+  frame_buffer_->Discard(frame_buffer_->Size());
+  retrovue::buffer::AudioFrame audio;
+  while (frame_buffer_->PopAudioFrame(audio)) {
+  }
+}
+
 bool MpegTSPlayoutSink::initializeEncoderForClient() {
+  std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
   encoder_pipeline_->close();
+  output_resync_.store(false, std::memory_order_relaxed);  // New stream from PAT/PMT
 
   // Use C-style callback for FFmpeg AVIO (nonblocking mode)
   return encoder_pipeline_->open(config_, this, writePacketCallback);
 }
 
 bool MpegTSPlayoutSink::sendToSocket(const uint8_t* data, size_t size) {
-  if (!client_connected_.load(std::memory_order_acquire) || client_fd_ < 0) {
+  fanout_.Publish(data, size);  // Also feeds the GOP cache with no client
+  return fanout_.SubscriberCount() > 0;
+}
+
+// FE-017: Whole packets go through the output ring to the fanout in muxer
+// order; each client's sender writes them to its blocking socket, so TS
+// packets are never split and a slow client never blocks the encoder
+int MpegTSPlayoutSink::publishTsBytes(uint8_t* buf, int buf_size) {
+  if (buf_size <= 0) {
+    return 0;
+  }
+  const size_t size = static_cast<size_t>(buf_size);
+  size_t offset = 0;
+  if (output_resync_.load(std::memory_order_relaxed)) {
+    // Rest of a GOP that lost a write: frames clients could not decode
+    offset = TsFanout::KeyframeOffset(buf, size);
+    if (offset == size) {
+      output_gop_skips_.fetch_add(1, std::memory_order_relaxed);
+      return buf_size;
+    }
+  }
+  if (!output_ring_.Write(buf + offset, size - offset)) {
+    const uint64_t drops = output_ring_.GetStats().writes_dropped;
+    if (drops % 100 == 1) {  // Throttled
+      std::cerr << "[MpegTSPlayoutSink] Output ring full - dropped write of " << buf_size
+                << " bytes. Total dropped writes: " << drops << std::endl;
+    }
+    // Skip to the next keyframe, and ask for one now so the gap is short
+    output_resync_.store(true, std::memory_order_relaxed);
+    encoder_pipeline_->RequestKeyframe();
+    return -1;
+  }
+  output_resync_.store(false, std::memory_order_relaxed);
+  return buf_size;
+}
+
+bool MpegTSPlayoutSink::joinMpts() {
+  if (!config_.native_mux) {
+    std::cerr << "[MpegTSPlayoutSink] MPTS output needs native_mux" << std::endl;
+    return false;
+  }
+  MptsProgramConfig program;
+  program.program_number = config_.mpts_program;
+  program.min_video_bps =
+      config_.mpts_min_bitrate > 0 ? config_.mpts_min_bitrate : config_.bitrate / 2;
+  program.max_video_bps =
+      config_.mpts_max_bitrate > 0 ? config_.mpts_max_bitrate : int64_t{config_.bitrate} * 2;
+  program.overhead_bps = (config_.enable_audio ? config_.audio_bitrate : 0) + kMptsPsiBps;
+  EncoderPipeline* pipeline = encoder_pipeline_.get();
+  if (!config_.mpts->AddProgram(program,
+                                [pipeline](int64_t bps) { pipeline->SetVideoBitrate(bps); })) {
+    std::cerr << "[MpegTSPlayoutSink] Cannot join the MPTS as program " << config_.mpts_program
+              << std::endl;
     return false;
   }
+  // The encoder reports each GOP's complexity, and codes at the rate the
+  // multiplexer allocates from the next frame
+  std::shared_ptr<TsMptsMux> mpts = config_.mpts;
+  const uint16_t program_number = config_.mpts_program;
+  pipeline->SetGopComplexityCallback([mpts, program_number](const GopComplexity& gop) {
+    mpts->ReportComplexity(program_number, gop.complexity);
+  });
+  mpts_joined_ = true;
+  return true;
+}
 
-  size_t sent = 0;
-  while (sent < size) {
-    ssize_t result = send(client_fd_, data + sent, size - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
-    
-    if (result < 0) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        // Socket buffer is full - partial send
-        return sent > 0;
-      } else if (errno == EPIPE || errno == ECONNRESET) {
-        handleClientDisconnect();
-        network_errors_.fetch_add(1, std::memory_order_relaxed);
-        return false;
-      } else {
-        std::cerr << "[MpegTSPlayoutSink] Send error: " << strerror(errno) << std::endl;
-        handleClientDisconnect();
-        network_errors_.fetch_add(1, std::memory_order_relaxed);
-        return false;
-      }
-    } else if (result == 0) {
-      handleClientDisconnect();
-      network_errors_.fetch_add(1, std::memory_order_relaxed);
-      return false;
-    } else {
-      sent += static_cast<size_t>(result);
-    }
+bool MpegTSPlayoutSink::startPacer() {
+  // UDP launch times (set once the socket took SO_TXTIME) let the pacer
+  // write ahead of its schedule
+  if (udp_output_ && udp_output_->TxTimeActive()) {
+    ts_pacer_->SetTimedWrite(&MpegTSPlayoutSink::pacedTimedWriteCallback,
+                             config_.udp_txtime_lead_us);
+  } else {
+    ts_pacer_->SetTimedWrite(nullptr, 0);
   }
+  return ts_pacer_->Start();
+}
 
-  return true;  // All data sent
+int MpegTSPlayoutSink::pacedWriteCallback(void* opaque, uint8_t* buf, int buf_size) {
+  return static_cast<MpegTSPlayoutSink*>(opaque)->emitTsBytes(buf, buf_size);
 }
 
-// FE-017: Write all bytes atomically to preserve continuity counters
-// Socket is in blocking mode, so send() will block until all bytes are written
-// No EAGAIN can occur, no retries needed, no sleeps needed
-int MpegTSPlayoutSink::writeAllBlocking(uint8_t* buf, int buf_size) {
-  // Use UDS sink if configured, otherwise use TCP socket
-  if (!config_.ts_socket_path.empty() && ts_output_sink_) {
-    if (!ts_output_sink_->IsClientConnected()) {
-      return -1;  // No client connected
-    }
-    
-    // Write to UDS sink (blocking write)
-    if (ts_output_sink_->Write(buf, static_cast<size_t>(buf_size))) {
-      return buf_size;  // All bytes written
-    } else {
-      // Write failed - client may have disconnected
-      return -1;
+int MpegTSPlayoutSink::pacedTimedWriteCallback(void* opaque, uint8_t* buf, int buf_size,
+                                               const int64_t* slot_utc_us) {
+  return static_cast<MpegTSPlayoutSink*>(opaque)->emitTsBytes(buf, buf_size, slot_utc_us);
+}
+
+int MpegTSPlayoutSink::emitTsBytes(const uint8_t* buf, int buf_size,
+                                   const int64_t* slot_utc_us) {
+  if (udp_output_ && slot_utc_us) {
+    udp_output_->Send(buf, static_cast<size_t>(buf_size), slot_utc_us);
+    if (!udp_output_->TxTimeActive()) {
+      ts_pacer_->SetLeadUs(0);  // Fell back: pace in user space
     }
+  } else if (udp_output_) {
+    udp_output_->Send(buf, static_cast<size_t>(buf_size));
   }
-  
-  // TCP mode: use existing TCP socket logic
-  if (!client_connected_.load(std::memory_order_acquire)) {
-    return -1;  // No client - fail immediately
+  if (srt_output_) {
+    srt_output_->Send(buf, static_cast<size_t>(buf_size));
   }
-
-  int sock = client_fd_;
-  if (sock < 0) {
-    client_connected_.store(false, std::memory_order_release);
-    return -1;
+  if (hls_segmenter_) {
+    hls_segmenter_->Write(buf, static_cast<size_t>(buf_size));
   }
+  // Use UDS sink if configured, otherwise the TCP clients
+  if (!config_.ts_socket_path.empty() && ts_output_sink_) {
+    return ts_output_sink_->Write(buf, static_cast<size_t>(buf_size)) ? buf_size : -1;
+  }
+  return sendToSocket(buf, static_cast<size_t>(buf_size)) ? buf_size : -1;
+}
 
-  // FE-017: Simple blocking send loop - socket is blocking so EAGAIN never happens
-  // This ensures TS packets (188 bytes) are written atomically, preserving continuity counters
-  uint8_t* p = buf;
-  int remaining = buf_size;
-
-  while (remaining > 0) {
-    ssize_t n = send(sock, p, remaining, MSG_NOSIGNAL);
-    
-    if (n < 0) {
-      if (errno == EINTR) {
-        // Interrupted by signal - retry
-        continue;
+void MpegTSPlayoutSink::outputLoop() {
+  const TsSlabRing::Slab* slabs[kOutputBatchSlabs];
+  struct iovec parts[kOutputBatchSlabs];
+  retrovue::telemetry::NameCurrentThread(config_.channel_id, "send");
+  retrovue::telemetry::StageCpuMeter cpu_meter(config_.cpu_account);
+  cpu_meter.Restart();
+  retrovue::telemetry::EncoderTelemetry& telemetry = *config_.encoder_telemetry;
+  auto last_sample = std::chrono::steady_clock::now();
+  uint64_t last_sample_bytes = telemetry.output_bytes();
+  while (true) {
+    const size_t count = output_ring_.Peek(slabs, kOutputBatchSlabs);
+    if (count == 0) {
+      if (output_stop_.load(std::memory_order_acquire) && output_ring_.Front() == nullptr) {
+        break;  // Stopped and drained
       }
-      // Hard failure - disconnect and fail
-      client_connected_.store(false, std::memory_order_release);
-      close(sock);
-      client_fd_ = -1;
-      return -1;
+      output_ring_.Wait();
+      continue;
+    }
+    if (mpts_joined_) {
+      for (size_t i = 0; i < count; ++i) {
+        config_.mpts->Push(config_.mpts_program, slabs[i]->data, slabs[i]->size);
+      }
+    }
+    if (ts_pacer_) {
+      for (size_t i = 0; i < count; ++i) {
+        ts_pacer_->Push(slabs[i]->data, slabs[i]->size);
+      }
+    } else {
+      // Everything queued goes to the fanout as one chunk (TCP and UDS
+      // clients alike), so the senders gather it with few syscalls, to the
+      // UDP output as one sendmmsg() batch, to the SRT link's own queue and
+      // to the HLS segmenter
+      for (size_t i = 0; i < count; ++i) {
+        parts[i].iov_base = const_cast<uint8_t*>(slabs[i]->data);
+        parts[i].iov_len = slabs[i]->size;
+      }
+      fanout_.Publish(parts, count);
+      if (udp_output_) {
+        udp_output_->Send(parts, count);
+      }
+      if (srt_output_) {
+        srt_output_->Send(parts, count);
+      }
+      if (hls_segmenter_) {
+        hls_segmenter_->Write(parts, count);
+      }
+    }
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+      bytes += slabs[i]->size;
+    }
+    output_ring_.Pop(count);
+    telemetry.AddOutputBytes(bytes);
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_sample >= kOutputSampleInterval) {
+      // Realized bitrate over the interval; queued bytes up to the slowest client
+      const uint64_t output_bytes = telemetry.output_bytes();
+      const auto elapsed_us =
+          std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample).count();
+      const TsFanoutStats fanout = fanout_.GetStats();
+      telemetry.SetOutputGauges(
+          static_cast<int64_t>((output_bytes - last_sample_bytes) * 8 * 1'000'000 / elapsed_us),
+          output_ring_.QueuedBytes() + fanout.max_queued_bytes, fanout.send_buffer_ratio);
+      if (rate_adapter_) {
+        // 0 from SetVideoBitrate() is the configured rate
+        const int64_t video_bps = fanout.subscribers == 0
+                                      ? rate_adapter_->Reset()
+                                      : rate_adapter_->Sample(fanout, elapsed_us);
+        if (video_bps > 0) {
+          encoder_pipeline_->SetVideoBitrate(video_bps == config_.bitrate ? 0 : video_bps);
+        }
+      }
+      last_sample = now;
+      last_sample_bytes = output_bytes;
+    }
+    cpu_meter.Charge(retrovue::telemetry::CpuStage::kSend);
+    if (trace_pending_.load(std::memory_order_acquire)) {
+      completeFrameTrace();
     }
-    
-    // n > 0: bytes sent (blocking socket guarantees this until all sent or error)
-    remaining -= static_cast<int>(n);
-    p += n;
   }
-  
-  return buf_size;  // All bytes written
 }
 
-size_t MpegTSPlayoutSink::drainOutputQueue() {
-  if (!client_connected_.load(std::memory_order_acquire)) {
-    return 0;  // No client connected - can't send
+void MpegTSPlayoutSink::traceEncodedFrame(const retrovue::buffer::FrameTrace& trace,
+                                          uint64_t output_bytes) {
+  if (!config_.on_frame_trace) {
+    return;
+  }
+  std::optional<PendingTrace> unsent;
+  {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    unsent.swap(pending_trace_);
+    pending_trace_ = PendingTrace{trace, output_bytes};
+    trace_pending_.store(true, std::memory_order_release);
   }
+  if (unsent) {
+    config_.on_frame_trace(unsent->trace);
+  }
+}
 
-  size_t packets_sent = 0;
-  
-  std::lock_guard<std::mutex> lock(output_queue_mutex_);
-  
-  while (!output_queue_.empty()) {
-    EncodedPacket& packet = output_queue_.front();
-    
-    // Try to send packet (non-blocking)
-    bool sent = sendToSocket(packet.data.data(), packet.data.size());
-    
-    if (!sent) {
-      break;
+void MpegTSPlayoutSink::completeFrameTrace() {
+  std::optional<PendingTrace> sent;
+  {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    if (!pending_trace_ || output_ring_.BytesConsumed() <= pending_trace_->output_bytes) {
+      return;
     }
-    
-    output_queue_.pop_front();
-    packets_sent++;
+    sent.swap(pending_trace_);
+    trace_pending_.store(false, std::memory_order_release);
   }
-  
-  return packets_sent;
+  sent->trace.Mark(retrovue::buffer::FrameStage::kSent);
+  config_.on_frame_trace(sent->trace);
 }
 
-bool MpegTSPlayoutSink::queueEncodedPacket(PacketType type, std::vector<uint8_t> data, int64_t pts90k) {
-  std::lock_guard<std::mutex> lock(output_queue_mutex_);
-  
-  // Check if queue is at capacity
-  if (output_queue_.size() >= config_.max_output_queue_packets) {
-    // Queue overflow - drop oldest packet
-    if (!output_queue_.empty()) {
-      output_queue_.pop_front();
-      packets_dropped_.fetch_add(1, std::memory_order_relaxed);
-      
-      // Log warning (throttled to avoid spam)
-      static uint64_t last_warning = 0;
-      uint64_t current_drops = packets_dropped_.load(std::memory_order_relaxed);
-      if (current_drops % 10 == 1 || current_drops == 1) {
-        std::cerr << "[MpegTSPlayoutSink] Output queue overflow - dropping packets. "
-                  << "Total dropped: " << current_drops << std::endl;
-      }
-    }
+void MpegTSPlayoutSink::waitOutputDrained() {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(kOutputDrainTimeoutMs);
+  while (output_ring_.QueuedBytes() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
-  
-  // Add packet to queue
-  output_queue_.emplace_back(type, std::move(data), pts90k);
-  return true;
 }
 
 }  // namespace retrovue::playout_sinks::mpegts
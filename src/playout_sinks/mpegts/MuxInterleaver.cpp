@@ -0,0 +1,156 @@
+// Repository: Retrovue-playout
+// Component: Mux Interleaver
+// Purpose: Bounded, clock-driven A/V packet interleaving in front of the TS muxer.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/MuxInterleaver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+#endif
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+int WriteToFormat(void* opaque, AVPacket* packet) {
+  return av_write_frame(static_cast<AVFormatContext*>(opaque), packet);
+}
+
+int64_t SteadyNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+}  // namespace
+
+MuxInterleaver::MuxInterleaver(size_t max_packets)
+    : max_packets_(std::max<size_t>(max_packets, 1)) {}
+
+MuxInterleaver::~MuxInterleaver() {
+  Clear();
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  for (AVPacket* packet : spare_) {
+    av_packet_free(&packet);
+  }
+#endif
+}
+
+bool MuxInterleaver::Push(AVPacket* packet) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  AVPacket* queued = nullptr;
+  if (!spare_.empty()) {
+    queued = spare_.back();
+    spare_.pop_back();
+  } else {
+    queued = av_packet_alloc();
+    if (!queued) {
+      av_packet_unref(packet);
+      return false;
+    }
+  }
+  av_packet_move_ref(queued, packet);
+
+  // Encoders emit in DTS order, so the position is almost always the back
+  auto it = queue_.end();
+  while (it != queue_.begin() && std::prev(it)->packet->dts > queued->dts) {
+    --it;
+  }
+  queue_.insert(it, Entry{queued, SteadyNowUs()});
+
+  const size_t depth = queue_.size();
+  depth_.store(depth, std::memory_order_relaxed);
+  if (depth > peak_depth_.load(std::memory_order_relaxed)) {
+    peak_depth_.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+#else
+  (void)packet;
+  return false;
+#endif
+}
+
+int MuxInterleaver::Drain(AVFormatContext* format_ctx, int64_t clock_90k) {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  return Drain(&WriteToFormat, format_ctx, clock_90k);
+#else
+  (void)format_ctx;
+  (void)clock_90k;
+  return 0;
+#endif
+}
+
+int MuxInterleaver::Drain(WriteFn write, void* opaque, int64_t clock_90k) {
+  int result = 0;
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  const int64_t now_us = SteadyNowUs();
+  while (!queue_.empty()) {
+    const Entry entry = queue_.front();
+    const bool forced = queue_.size() > max_packets_;
+    if (entry.packet->dts > clock_90k && !forced) {
+      break;
+    }
+    queue_.pop_front();
+    if (forced && entry.packet->dts > clock_90k) {
+      forced_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (tap_) {
+      tap_(tap_opaque_, entry.packet);
+    }
+    const int ret = write(opaque, entry.packet);
+    av_packet_unref(entry.packet);
+    spare_.push_back(entry.packet);
+    if (ret < 0 && result == 0) {
+      result = ret;
+    }
+
+    const int64_t hold_us = now_us - entry.queued_us;
+    last_hold_us_.store(hold_us, std::memory_order_relaxed);
+    if (hold_us > max_hold_us_.load(std::memory_order_relaxed)) {
+      max_hold_us_.store(hold_us, std::memory_order_relaxed);
+    }
+    packets_written_.fetch_add(1, std::memory_order_relaxed);
+  }
+  depth_.store(queue_.size(), std::memory_order_relaxed);
+#else
+  (void)write;
+  (void)opaque;
+  (void)clock_90k;
+#endif
+  return result;
+}
+
+void MuxInterleaver::Clear() {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  for (Entry& entry : queue_) {
+    av_packet_unref(entry.packet);
+    spare_.push_back(entry.packet);
+  }
+#endif
+  queue_.clear();
+  depth_.store(0, std::memory_order_relaxed);
+}
+
+MuxQueueStats MuxInterleaver::GetStats() const {
+  MuxQueueStats stats;
+  stats.depth = depth_.load(std::memory_order_relaxed);
+  stats.peak_depth = peak_depth_.load(std::memory_order_relaxed);
+  stats.packets_written = packets_written_.load(std::memory_order_relaxed);
+  stats.forced_writes = forced_writes_.load(std::memory_order_relaxed);
+  stats.last_hold_us = last_hold_us_.load(std::memory_order_relaxed);
+  stats.max_hold_us = max_hold_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,252 @@
+// Repository: Retrovue-playout
+// Component: Rendition Ladder
+// Purpose: Encodes lower-resolution ABR renditions from the sink's decoded frames.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/RenditionLadder.hpp"
+
+#include "retrovue/decode/PlaneKernels.h"
+
+#include <iostream>
+
+namespace retrovue::playout_sinks::mpegts {
+
+RenditionLadder::RenditionLadder(const MpegTSPlayoutSinkConfig& config)
+    : outputs_(config.renditions), source_bitrate_(config.bitrate) {
+  // Largest first, as PlanRenditionLadder() orders them
+  for (const RenditionRung& rung : PlanRenditionLadder(outputs_, 0, 0, source_bitrate_)) {
+    const RenditionConfig& output = outputs_[rung.index];
+    auto rendition = std::make_unique<Rendition>();
+    rendition->output = output;
+    rendition->config = config;
+    rendition->config.renditions.clear();
+    rendition->config.ts_socket_path = output.ts_socket_path;
+    rendition->config.fixed_gop = true;
+    rendition->config.encoder_telemetry.reset();  // The main output's only
+    rendition->fanout = std::make_unique<TsFanout>(
+        config.max_subscribers, config.subscriber_queue_bytes, config.slow_client_policy, 0,
+        config.send_batch_bytes, config.send_batch_delay_us, config.subscriber_max_lag_ms);
+    rendition->output_sink =
+        std::make_unique<TsOutputSink>(output.ts_socket_path, *rendition->fanout,
+                                       config.ts_socket_pipe);
+    rendition->encoder = std::make_unique<EncoderPipeline>(rendition->config);
+    renditions_.push_back(std::move(rendition));
+  }
+  Plan(0, 0);
+}
+
+RenditionLadder::~RenditionLadder() { Stop(); }
+
+bool RenditionLadder::Start() {
+  for (const auto& rendition : renditions_) {
+    const RenditionConfig& output = rendition->output;
+    if (output.width <= 0 || output.height <= 0 || output.width % 2 != 0 ||
+        output.height % 2 != 0) {
+      std::cerr << "[RenditionLadder] Invalid rendition size " << output.width << "x"
+                << output.height << " (must be positive and even)" << std::endl;
+      return false;
+    }
+    if (output.ts_socket_path.empty()) {
+      std::cerr << "[RenditionLadder] Rendition " << output.width << "x" << output.height
+                << " has no ts_socket_path" << std::endl;
+      return false;
+    }
+    if (!rendition->output_sink->Initialize() || !rendition->output_sink->Start()) {
+      std::cerr << "[RenditionLadder] Failed to start output for " << output.width << "x"
+                << output.height << " at " << output.ts_socket_path << std::endl;
+      return false;
+    }
+    std::cout << "[RenditionLadder] Rendition " << output.width << "x" << output.height
+              << " @ " << rendition->rung.bitrate << " bps on " << output.ts_socket_path
+              << (rendition->rung.source >= 0 ? " (scaled from the next rendition up)" : "")
+              << std::endl;
+  }
+  return true;
+}
+
+void RenditionLadder::Stop() {
+  for (const auto& rendition : renditions_) {
+    if (rendition->open) {
+      rendition->encoder->close();  // Writes the trailer to connected clients
+      rendition->open = false;
+      rendition->encoding.store(false, std::memory_order_relaxed);
+    }
+    rendition->fanout->CloseAll(nullptr, 0, 1000);
+    rendition->output_sink->Stop();
+    rendition->subscribers_seen = 0;
+  }
+}
+
+bool RenditionLadder::UpdateOutputs() {
+  bool keyframe = false;
+  for (const auto& rendition : renditions_) {
+    const TsFanoutStats fanout = rendition->fanout->GetStats();
+    if (fanout.subscribers == 0) {
+      if (rendition->open) {
+        std::cout << "[RenditionLadder] No clients on " << rendition->output.ts_socket_path
+                  << ", closing encoder" << std::endl;
+        rendition->encoder->close();
+        rendition->open = false;
+        rendition->encoding.store(false, std::memory_order_relaxed);
+      }
+      continue;
+    }
+
+    const bool joined = fanout.subscribers_total != rendition->subscribers_seen ||
+                        fanout.gop_resyncs != rendition->gop_resyncs_seen;  // Or lost GOPs
+    rendition->subscribers_seen = fanout.subscribers_total;
+    rendition->gop_resyncs_seen = fanout.gop_resyncs;
+    if (!rendition->open) {
+      if (!rendition->encoder->open(rendition->config, rendition.get(),
+                                    &RenditionLadder::WriteThunk)) {
+        std::cerr << "[RenditionLadder] Failed to open encoder for "
+                  << rendition->output.ts_socket_path << std::endl;
+        continue;
+      }
+      rendition->open = true;
+      rendition->encoding.store(true, std::memory_order_relaxed);
+      keyframe = true;
+    } else if (joined) {
+      keyframe = true;  // New client mid-stream
+    }
+  }
+  if (keyframe) {
+    RequestKeyframe();
+  }
+  return keyframe;
+}
+
+void RenditionLadder::RequestKeyframe() {
+  for (const auto& rendition : renditions_) {
+    rendition->encoder->RequestKeyframe();
+  }
+}
+
+void RenditionLadder::Plan(int source_width, int source_height) {
+  source_width_ = source_width;
+  source_height_ = source_height;
+  const std::vector<RenditionRung> rungs =
+      PlanRenditionLadder(outputs_, source_width, source_height, source_bitrate_);
+  for (size_t i = 0; i < renditions_.size(); ++i) {
+    Rendition& rendition = *renditions_[i];
+    const RenditionRung& rung = rungs[i];  // Same order: sorted by configured size
+    if (rung.clamped && !rendition.rung.clamped) {
+      std::cout << "[RenditionLadder] Rendition " << rendition.output.width << "x"
+                << rendition.output.height << " @ " << rendition.output.bitrate
+                << " bps clamped to " << rung.width << "x" << rung.height << " @ "
+                << rung.bitrate << " bps to fit the source" << std::endl;
+    }
+    if (rung.width != rendition.frame.width || rung.height != rendition.frame.height) {
+      rendition.frame.width = rung.width;
+      rendition.frame.height = rung.height;
+      if (rung.width > 0 && rung.height > 0) {
+        rendition.frame.Layout(buffer::PixelFormat::kI420, rung.width, rung.height);
+      }
+    }
+    // The encoder reads its config when the new size reopens it
+    rendition.config.bitrate = rung.bitrate;
+    rendition.rung = rung;
+    rendition.width.store(rung.width, std::memory_order_relaxed);
+    rendition.height.store(rung.height, std::memory_order_relaxed);
+    rendition.bitrate.store(rung.bitrate, std::memory_order_relaxed);
+    rendition.clamped.store(rung.clamped, std::memory_order_relaxed);
+  }
+}
+
+void RenditionLadder::ScaleCascade(const buffer::Frame& frame) {
+  if (frame.width > 0 && frame.height > 0 &&
+      (frame.width != source_width_ || frame.height != source_height_)) {
+    Plan(frame.width, frame.height);
+  }
+  for (const auto& rendition : renditions_) {
+    rendition->needed = rendition->open;
+  }
+  // Smallest first, so a needed rendition marks the one it scales from
+  for (size_t i = renditions_.size(); i-- > 0;) {
+    const Rendition& rendition = *renditions_[i];
+    if (rendition.needed && rendition.rung.source >= 0) {
+      renditions_[rendition.rung.source]->needed = true;
+    }
+  }
+
+  for (const auto& rendition : renditions_) {
+    rendition->frame.metadata = frame.metadata;
+    if (!rendition->needed) {
+      continue;
+    }
+    const buffer::Frame& source =
+        rendition->rung.source >= 0 ? renditions_[rendition->rung.source]->frame : frame;
+    decode::PlanarImage src;
+    const bool source_ready =
+        rendition->rung.source < 0 || renditions_[rendition->rung.source]->needed;
+    if (!source_ready || !decode::DescribeFrame(source, &src)) {
+      rendition->needed = false;  // Input frame is smaller than its stated layout
+      rendition->encoding_errors.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    // Beyond 2:1 from the input (the largest rendition of a steep ladder)
+    // the two-tap filter aliases, but stays usable
+    buffer::Frame& out = rendition->frame;
+    uint8_t* const planes[3] = {out.Plane(0), out.Plane(1), out.Plane(2)};
+    const int strides[3] = {out.Stride(0), out.Stride(1), out.Stride(2)};
+    decode::PackI420(src, out.width, out.height, planes, strides);
+  }
+}
+
+void RenditionLadder::EncodeFrame(const buffer::Frame& frame, int64_t pts90k) {
+  ScaleCascade(frame);
+  for (const auto& rendition : renditions_) {
+    if (!rendition->open || !rendition->needed) {
+      continue;
+    }
+    if (rendition->encoder->encodeFrame(rendition->frame, pts90k)) {
+      rendition->frames_encoded.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      rendition->encoding_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void RenditionLadder::EncodeAudio(const buffer::AudioFrame& audio) {
+  for (const auto& rendition : renditions_) {
+    if (rendition->open && !rendition->encoder->encodeAudioFrame(audio)) {
+      rendition->encoding_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void RenditionLadder::EmitFiller(int64_t pts90k) {
+  for (const auto& rendition : renditions_) {
+    if (rendition->open) {
+      rendition->encoder->EmitFiller(pts90k);
+    }
+  }
+}
+
+int RenditionLadder::WriteThunk(void* opaque, uint8_t* buf, int buf_size) {
+  auto* rendition = static_cast<Rendition*>(opaque);
+  if (!rendition || !buf || buf_size <= 0) {
+    return -1;
+  }
+  return rendition->output_sink->Write(buf, static_cast<size_t>(buf_size)) ? buf_size : -1;
+}
+
+std::vector<RenditionStats> RenditionLadder::GetStats() const {
+  std::vector<RenditionStats> stats;
+  stats.reserve(renditions_.size());
+  for (const auto& rendition : renditions_) {
+    RenditionStats entry;
+    entry.width = rendition->width.load(std::memory_order_relaxed);
+    entry.height = rendition->height.load(std::memory_order_relaxed);
+    entry.bitrate = rendition->bitrate.load(std::memory_order_relaxed);
+    entry.clamped = rendition->clamped.load(std::memory_order_relaxed);
+    entry.encoding = rendition->encoding.load(std::memory_order_relaxed);
+    entry.frames_encoded = rendition->frames_encoded.load(std::memory_order_relaxed);
+    entry.encoding_errors = rendition->encoding_errors.load(std::memory_order_relaxed);
+    entry.fanout = rendition->fanout->GetStats();
+    stats.push_back(entry);
+  }
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,85 @@
+// Repository: Retrovue-playout
+// Component: Rendition Plan
+// Purpose: Resolves the ABR ladder's rung sizes, bitrates and scale cascade against the source.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/RenditionPlan.hpp"
+
+#include "retrovue/decode/PlaneKernels.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+int EvenAtLeast2(int64_t value) {
+  return static_cast<int>(std::max<int64_t>(2, value & ~int64_t{1}));
+}
+
+}  // namespace
+
+std::vector<RenditionRung> PlanRenditionLadder(const std::vector<RenditionConfig>& renditions,
+                                               int source_width, int source_height,
+                                               int source_bitrate) {
+  std::vector<RenditionRung> rungs(renditions.size());
+  for (size_t i = 0; i < renditions.size(); ++i) {
+    rungs[i].index = i;
+    rungs[i].width = renditions[i].width;
+    rungs[i].height = renditions[i].height;
+    rungs[i].bitrate = renditions[i].bitrate;
+  }
+  std::stable_sort(rungs.begin(), rungs.end(), [](const RenditionRung& a, const RenditionRung& b) {
+    return int64_t{a.width} * a.height > int64_t{b.width} * b.height;
+  });
+
+  const bool source_known = source_width > 0 && source_height > 0;
+  int64_t source_pixels = 0;
+  if (source_known) {
+    source_pixels = int64_t{source_width} * source_height;
+  } else if (!rungs.empty()) {
+    source_pixels = int64_t{rungs.front().width} * rungs.front().height;
+  }
+
+  for (size_t i = 0; i < rungs.size(); ++i) {
+    RenditionRung& rung = rungs[i];
+    if (source_known && rung.width > 0 && rung.height > 0 &&
+        (rung.width > source_width || rung.height > source_height)) {
+      // Bound by whichever side overshoots more
+      const int64_t w = rung.width;
+      const int64_t h = rung.height;
+      if (w * source_height >= h * source_width) {
+        rung.height = EvenAtLeast2(h * source_width / w);
+        rung.width = EvenAtLeast2(source_width);
+      } else {
+        rung.width = EvenAtLeast2(w * source_height / h);
+        rung.height = EvenAtLeast2(source_height);
+      }
+      rung.clamped = true;
+    }
+
+    if (rung.bitrate <= 0 && source_pixels > 0 && rung.width > 0 && rung.height > 0) {
+      const int64_t share = int64_t{source_bitrate} * rung.width * rung.height / source_pixels;
+      rung.bitrate = static_cast<int>(std::max<int64_t>(kMinRenditionBitrate, share));
+    }
+    if (source_bitrate > 0 && rung.bitrate > source_bitrate) {
+      rung.bitrate = source_bitrate;
+      rung.clamped = true;
+    }
+
+    // Nearest larger rung within 2:1; the source frame otherwise
+    decode::PlanarImage target;
+    for (int j = static_cast<int>(i) - 1; j >= 0; --j) {
+      target.width = rungs[j].width;
+      target.height = rungs[j].height;
+      if (decode::CanPackI420(target, rung.width, rung.height)) {
+        rung.source = j;
+        break;
+      }
+    }
+  }
+  return rungs;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
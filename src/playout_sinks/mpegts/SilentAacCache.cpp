@@ -0,0 +1,160 @@
+// Repository: Retrovue-playout
+// Component: Silent AAC Cache
+// Purpose: Process-wide cache of pre-encoded silent AAC access units.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/SilentAacCache.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+}
+#endif
+
+namespace retrovue::playout_sinks::mpegts {
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+namespace {
+
+// Frames of silence encoded to get past the encoder's priming and
+// lookahead; the last packet out is the steady-state silent frame.
+constexpr int kSilenceFrames = 8;
+
+// Silence spends almost none of it; the bitrate only picks the profile
+// settings the encoder opens with.
+constexpr int64_t kBitratePerChannel = 64000;
+
+// Encodes kSilenceFrames of zeros; nullptr if the encoder fails.
+std::shared_ptr<const SilentAacTrack> EncodeSilence(int sample_rate, int channels) {
+  const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+  if (!codec) {
+    std::cerr << "[SilentAacCache] No AAC encoder available" << std::endl;
+    return nullptr;
+  }
+  AVCodecContext* codec_ctx = avcodec_alloc_context3(codec);
+  AVFrame* frame = av_frame_alloc();
+  AVPacket* packet = av_packet_alloc();
+  auto track = std::make_shared<SilentAacTrack>();
+  std::shared_ptr<AVCodecParameters> codecpar(
+      avcodec_parameters_alloc(),
+      [](AVCodecParameters* par) { avcodec_parameters_free(&par); });
+
+  bool ok = codec_ctx && frame && packet && codecpar;
+  if (ok) {
+    codec_ctx->sample_rate = sample_rate;
+    codec_ctx->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    av_channel_layout_default(&codec_ctx->ch_layout, channels);
+    codec_ctx->bit_rate = kBitratePerChannel * channels;
+    codec_ctx->time_base = AVRational{1, sample_rate};
+    // AudioSpecificConfig goes in extradata; the TS muxer writes ADTS
+    // headers from it
+    codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    ok = avcodec_open2(codec_ctx, codec, nullptr) >= 0;
+  }
+  if (ok) {
+    frame->nb_samples = codec_ctx->frame_size;
+    frame->format = codec_ctx->sample_fmt;
+    frame->sample_rate = sample_rate;
+    ok = av_channel_layout_copy(&frame->ch_layout, &codec_ctx->ch_layout) >= 0 &&
+         av_frame_get_buffer(frame, 0) >= 0;
+  }
+  if (ok) {
+    // Planar float: all-zero bytes are 0.0 samples
+    for (int ch = 0; ch < channels; ++ch) {
+      std::memset(frame->extended_data[ch], 0, static_cast<size_t>(frame->linesize[0]));
+    }
+  }
+
+  for (int i = 0; ok && i < kSilenceFrames; ++i) {
+    frame->pts = static_cast<int64_t>(i) * codec_ctx->frame_size;
+    ok = avcodec_send_frame(codec_ctx, frame) >= 0;
+    while (ok) {
+      const int ret = avcodec_receive_packet(codec_ctx, packet);
+      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+        break;
+      }
+      if (ret < 0) {
+        ok = false;
+        break;
+      }
+      track->access_unit.assign(packet->data, packet->data + packet->size);
+      av_packet_unref(packet);
+    }
+  }
+
+  ok = ok && !track->access_unit.empty() &&
+       avcodec_parameters_from_context(codecpar.get(), codec_ctx) >= 0;
+  if (ok) {
+    track->codecpar = std::move(codecpar);
+    track->sample_rate = sample_rate;
+    track->channels = channels;
+    track->frame_size = codec_ctx->frame_size;
+  }
+
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&codec_ctx);
+  if (!ok) {
+    std::cerr << "[SilentAacCache] Failed to encode silent AAC at " << sample_rate << " Hz, "
+              << channels << " channel(s)" << std::endl;
+    return nullptr;
+  }
+  std::cout << "[SilentAacCache] Encoded silent AAC at " << sample_rate << " Hz, " << channels
+            << " channel(s) (" << track->access_unit.size() << "-byte access unit)"
+            << std::endl;
+  return track;
+}
+
+}  // namespace
+#endif
+
+SilentAacCache& SilentAacCache::Instance() {
+  static SilentAacCache instance;
+  return instance;
+}
+
+std::shared_ptr<const SilentAacTrack> SilentAacCache::Get(int sample_rate, int channels) {
+  if (sample_rate <= 0 || channels <= 0) {
+    return nullptr;
+  }
+  // Encoding under the lock keeps channels starting together from each
+  // encoding the same layout; it runs once per layout
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tracks_.find({sample_rate, channels});
+  if (it != tracks_.end()) {
+    stats_.hits++;
+    return it->second;
+  }
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  std::shared_ptr<const SilentAacTrack> track = EncodeSilence(sample_rate, channels);
+  if (!track) {
+    stats_.failures++;
+    return nullptr;
+  }
+  stats_.encodes++;
+  tracks_.emplace(std::make_pair(sample_rate, channels), track);
+  return track;
+#else
+  stats_.failures++;
+  return nullptr;
+#endif
+}
+
+void SilentAacCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.clear();
+}
+
+SilentAacCacheStats SilentAacCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SilentAacCacheStats stats = stats_;
+  stats.entries = tracks_.size();
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -1,6 +1,6 @@
 // Repository: Retrovue-playout
 // Component: MPEG-TS Muxer Implementation
-// Purpose: Wraps FFmpeg MPEG-TS muxing.
+// Purpose: Native MPEG-TS muxing (PES, PAT/PMT, PCR) for the MPEG-TS sinks.
 // Copyright (c) 2025 RetroVue
 
 // CMakeLists.txt snippet:
@@ -12,98 +12,510 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
 namespace retrovue::playout_sinks::mpegts {
 
-TSMuxer::TSMuxer() {
-  // Constructor
+namespace {
+
+constexpr uint8_t kSyncByte = 0x47;
+constexpr size_t kPayloadSize = TSMuxer::kPacketSize - 4;
+constexpr int64_t kTimestampMask = (int64_t{1} << 33) - 1;  // 33-bit PTS/DTS/PCR base
+
+constexpr uint8_t kVideoStreamId = 0xE0;
+constexpr uint8_t kAudioStreamId = 0xC0;
+constexpr uint8_t kPrivateStream1 = 0xBD;  // AC-3
+
+constexpr uint8_t kH264Aud[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0};
+constexpr uint8_t kHevcAud[] = {0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50};
+constexpr size_t kAdtsHeaderSize = 7;
+
+int64_t UsTo90k(int64_t us) { return us * 9 / 100; }
+
+void AppendCrc(std::vector<uint8_t>* section) {
+  const uint32_t crc = Crc32Mpeg(section->data(), section->size());
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    section->push_back(static_cast<uint8_t>(crc >> shift));
+  }
+}
+
+// PES timestamp with its 4-bit prefix (0x2 PTS only, 0x3 PTS of a pair, 0x1 DTS).
+void PutTimestamp(uint8_t* p, uint8_t prefix, int64_t ts) {
+  ts &= kTimestampMask;
+  p[0] = static_cast<uint8_t>((prefix << 4) | ((ts >> 29) & 0x0E) | 0x01);
+  p[1] = static_cast<uint8_t>(ts >> 22);
+  p[2] = static_cast<uint8_t>(((ts >> 14) & 0xFE) | 0x01);
+  p[3] = static_cast<uint8_t>(ts >> 7);
+  p[4] = static_cast<uint8_t>(((ts << 1) & 0xFE) | 0x01);
+}
+
+// PCR with a zero extension (the 90 kHz base carries all our precision).
+void PutPcr(uint8_t* p, int64_t base) {
+  base &= kTimestampMask;
+  p[0] = static_cast<uint8_t>(base >> 25);
+  p[1] = static_cast<uint8_t>(base >> 17);
+  p[2] = static_cast<uint8_t>(base >> 9);
+  p[3] = static_cast<uint8_t>(base >> 1);
+  p[4] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E);
+  p[5] = 0x00;
+}
+
+// Offset of the first NAL header byte behind a leading start code, or 0.
+size_t FirstNalOffset(const uint8_t* data, size_t size) {
+  if (size >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 1) {
+    return 3;
+  }
+  if (size >= 5 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) {
+    return 4;
+  }
+  return 0;
+}
+
+}  // namespace
+
+uint32_t Crc32Mpeg(const uint8_t* data, size_t size) {
+  static const auto table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i << 24;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+      }
+      t[i] = crc;
+    }
+    return t;
+  }();
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; ++i) {
+    crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF];
+  }
+  return crc;
 }
 
+TSMuxer::TSMuxer() = default;
+
 TSMuxer::~TSMuxer() {
   Cleanup();
 }
 
 bool TSMuxer::Initialize(const MuxerConfig& config, int output_fd) {
-  // TODO: Initialize FFmpeg MPEG-TS muxer
-  // if (config.stub_mode) {
-  //   // Stub mode: no real muxing
-  //   output_fd_ = output_fd;
-  //   is_initialized_ = true;
-  //   return true;
-  // }
-  // 
-  // // Real FFmpeg muxing
-  // // TODO: Allocate AVFormatContext for MPEG-TS
-  // // TODO: Add video stream (H.264)
-  // // TODO: Add audio stream (AAC) if enable_audio
-  // // TODO: Open output (using custom AVIO for file descriptor)
-  // // TODO: Write header
-  // 
-  // output_fd_ = output_fd;
-  // is_initialized_ = true;
-  // return true;
-  
+  config_ = config;
+  chunk_.assign(kChunkPackets * kPacketSize, 0);
+  chunk_packets_ = 0;
+  write_failed_ = false;
+  pat_.clear();
+  pmt_.clear();
+  resetForNewProducer();
+
   output_fd_ = output_fd;
-  is_initialized_ = true;  // TODO: Return actual result
+  opaque_ = nullptr;
+  write_ = nullptr;
+  is_initialized_ = true;
+  return true;
+}
+
+bool TSMuxer::Initialize(const MuxerConfig& config, void* opaque, WriteCallback write) {
+  if (!write) {
+    std::cerr << "[TSMuxer] No write callback" << std::endl;
+    return false;
+  }
+  Initialize(config, -1);
+  opaque_ = opaque;
+  write_ = write;
   return true;
 }
 
 void TSMuxer::Cleanup() {
-  // TODO: Cleanup FFmpeg muxer resources
-  // if (muxer_state_) {
-  //   // TODO: Write trailer
-  //   // TODO: Close output
-  //   // TODO: Free AVFormatContext
-  //   muxer_state_.reset();
-  // }
+  if (is_initialized_) {
+    Flush();
+  }
   output_fd_ = -1;
+  opaque_ = nullptr;
+  write_ = nullptr;
   is_initialized_ = false;
 }
 
 bool TSMuxer::MuxPacket(const std::vector<uint8_t>& packet_data, int64_t pts_us) {
-  // TODO: Mux packet using FFmpeg
-  // if (!is_initialized_) {
-  //   return false;
-  // }
-  // 
-  // if (config_.stub_mode) {
-  //   // Stub mode: write packet data directly to socket
-  //   ssize_t written = write(output_fd_, packet_data.data(), packet_data.size());
-  //   return written == static_cast<ssize_t>(packet_data.size());
-  // }
-  // 
-  // // Real muxing
-  // // TODO: Convert packet_data to AVPacket
-  // // TODO: Set PTS
-  // // TODO: Mux packet using av_interleaved_write_frame
-  // 
-  // return true;
-  
-  return true;  // TODO: Return actual result
+  if (!is_initialized_) {
+    return false;
+  }
+  const int64_t pts90k = UsTo90k(pts_us);
+  if (!MuxFrame(TsStream::kVideo, packet_data.data(), packet_data.size(), pts90k, pts90k,
+                IsH264Keyframe(packet_data.data(), packet_data.size()))) {
+    Flush();
+    return false;
+  }
+  return Flush();
+}
+
+bool TSMuxer::MuxFrame(TsStream stream, const uint8_t* data, size_t size, int64_t pts90k,
+                       int64_t dts90k, bool keyframe) {
+  if (!is_initialized_ || !data || size == 0) {
+    return false;
+  }
+  const bool video = stream == TsStream::kVideo;
+  if (!video && !config_.enable_audio) {
+    return false;
+  }
+  if (config_.stub_mode) {
+    // Stub mode: the access unit goes out as is, without TS framing
+    EmitChunk();
+    if (!WriteOut(data, size)) {
+      write_failed_ = true;
+    }
+    return !write_failed_;
+  }
+
+  if (pat_.empty()) {
+    BuildTables();
+  }
+
+  // The PCR runs on the input DTS; PTS/DTS lead it by the mux delay
+  const int64_t clock_90k = dts90k;
+  const int64_t delay_90k = UsTo90k(config_.mux_delay_us);
+  const bool tables_due =
+      !psi_valid_ ||
+      (video && (keyframe || clock_90k - last_psi_90k_ >= UsTo90k(config_.psi_interval_us)));
+  if (tables_due) {
+    WriteTables();
+    psi_valid_ = true;
+    last_psi_90k_ = clock_90k;
+  }
+  const bool pcr_due =
+      !pcr_valid_ || clock_90k - last_pcr_90k_ >= UsTo90k(config_.pcr_interval_us);
+  if (pcr_due) {
+    if (!video) {
+      WritePcrPacket(clock_90k);
+    }
+    pcr_valid_ = true;
+    last_pcr_90k_ = clock_90k;
+  }
+
+  // PES header, then the access unit delimiter or ADTS header it lacks
+  uint8_t header[32];
+  size_t n = 0;
+  const bool ac3 = config_.audio_stream_type == kTsStreamTypeAc3;
+  const bool with_dts = dts90k != pts90k;
+  header[n++] = 0x00;
+  header[n++] = 0x00;
+  header[n++] = 0x01;
+  header[n++] = video ? kVideoStreamId : (ac3 ? kPrivateStream1 : kAudioStreamId);
+  n += 2;  // PES_packet_length, below
+  header[n++] = 0x84;  // Marker bits, data_alignment_indicator
+  header[n++] = with_dts ? 0xC0 : 0x80;
+  header[n++] = with_dts ? 10 : 5;
+  PutTimestamp(header + n, with_dts ? 0x3 : 0x2, pts90k + delay_90k);
+  n += 5;
+  if (with_dts) {
+    PutTimestamp(header + n, 0x1, dts90k + delay_90k);
+    n += 5;
+  }
+
+  if (video) {
+    const size_t nal = FirstNalOffset(data, size);
+    if (config_.video_stream_type == kTsStreamTypeH264 &&
+        (nal == 0 || (data[nal] & 0x1F) != 9)) {
+      std::memcpy(header + n, kH264Aud, sizeof(kH264Aud));
+      n += sizeof(kH264Aud);
+    } else if (config_.video_stream_type == kTsStreamTypeHevc &&
+               (nal == 0 || ((data[nal] >> 1) & 0x3F) != 35)) {
+      std::memcpy(header + n, kHevcAud, sizeof(kHevcAud));
+      n += sizeof(kHevcAud);
+    }
+  } else if (config_.audio_stream_type == kTsStreamTypeAac &&
+             config_.audio_specific_config.size() >= 2 &&
+             !(size >= 2 && data[0] == 0xFF && (data[1] & 0xF0) == 0xF0)) {
+    const uint8_t* asc = config_.audio_specific_config.data();
+    const int profile = std::max(0, (asc[0] >> 3) - 1);
+    const int rate_index = ((asc[0] & 0x07) << 1) | (asc[1] >> 7);
+    const int channels = (asc[1] >> 3) & 0x0F;
+    const size_t frame_length = size + kAdtsHeaderSize;
+    uint8_t* adts = header + n;
+    adts[0] = 0xFF;
+    adts[1] = 0xF1;  // MPEG-4, layer 0, no CRC
+    adts[2] = static_cast<uint8_t>((profile << 6) | (rate_index << 2) | (channels >> 2));
+    adts[3] = static_cast<uint8_t>(((channels & 0x03) << 6) | ((frame_length >> 11) & 0x03));
+    adts[4] = static_cast<uint8_t>(frame_length >> 3);
+    adts[5] = static_cast<uint8_t>(((frame_length & 0x07) << 5) | 0x1F);
+    adts[6] = 0xFC;
+    n += kAdtsHeaderSize;
+  }
+
+  // Unbounded for video, as libavformat writes it; audio when it fits
+  const size_t pes_length = n - 6 + size;
+  const size_t length_field = !video && pes_length <= 0xFFFF ? pes_length : 0;
+  header[4] = static_cast<uint8_t>(length_field >> 8);
+  header[5] = static_cast<uint8_t>(length_field);
+
+  WritePes(video ? config_.video_pid : config_.audio_pid, header, n, data, size,
+           video && pcr_due, clock_90k, video && keyframe);
+  return !write_failed_;
+}
+
+bool TSMuxer::WriteMuxed(uint8_t* data, size_t size) {
+  if (!is_initialized_ || !data) {
+    return false;
+  }
+  for (size_t offset = 0; offset + kPacketSize <= size; offset += kPacketSize) {
+    uint8_t* packet = data + offset;
+    if (packet[0] != kSyncByte) {
+      continue;
+    }
+    const uint16_t pid = static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+    const uint8_t afc = (packet[3] >> 4) & 0x03;
+    if (uint8_t* cc = Counter(pid)) {
+      if (afc & 0x01) {
+        packet[3] = static_cast<uint8_t>((packet[3] & 0xF0) | *cc);
+        *cc = (*cc + 1) & 0x0F;
+      } else {
+        packet[3] = static_cast<uint8_t>((packet[3] & 0xF0) | ((*cc + 15) & 0x0F));
+      }
+    }
+    if (pid == config_.video_pid && (afc & 0x02) && packet[4] >= 7 && (packet[5] & 0x10)) {
+      last_pcr_90k_ = (static_cast<int64_t>(packet[6]) << 25) |
+                      (static_cast<int64_t>(packet[7]) << 17) |
+                      (static_cast<int64_t>(packet[8]) << 9) |
+                      (static_cast<int64_t>(packet[9]) << 1) | (packet[10] >> 7);
+      pcr_valid_ = true;
+    }
+    if (pid == 0 && pcr_valid_) {
+      psi_valid_ = true;
+      last_psi_90k_ = last_pcr_90k_;
+    }
+    std::memcpy(NextPacket(), packet, kPacketSize);
+  }
+  return !write_failed_;
 }
 
 bool TSMuxer::Flush() {
-  // TODO: Flush any buffered MPEG-TS data
-  // if (!is_initialized_) {
-  //   return false;
-  // }
-  // 
-  // // TODO: Flush muxer buffers
-  // // In stub mode, this may be a no-op
-  // 
-  // return true;
-  
-  return true;  // TODO: Return actual result
+  const bool ok = EmitChunk() && !write_failed_;
+  write_failed_ = false;
+  return ok;
 }
 
 void TSMuxer::resetForNewProducer() {
-  // Reset continuity counter state and frame timing history
-  // TODO: When FFmpeg muxer is implemented, reset:
-  // - Continuity counters for video/audio streams
-  // - Frame timing history
-  // - Any buffered packets
-  std::cout << "[TSMuxer] Reset for new producer" << std::endl;
+  // New stream: counters restart and the next frame carries PAT/PMT and a PCR
+  if (is_initialized_) {
+    Flush();
+    std::cout << "[TSMuxer] Reset for new producer" << std::endl;
+  }
+  pat_cc_ = 0;
+  pmt_cc_ = 0;
+  video_cc_ = 0;
+  audio_cc_ = 0;
+  pcr_valid_ = false;
+  last_pcr_90k_ = 0;
+  psi_valid_ = false;
+  last_psi_90k_ = 0;
 }
 
-}  // namespace retrovue::playout_sinks::mpegts
+bool TSMuxer::IsH264Keyframe(const uint8_t* data, size_t size) {
+  for (size_t i = 0; i + 3 < size; ++i) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      const uint8_t type = data[i + 3] & 0x1F;
+      if (type == 5 || type == 7) {  // IDR slice, SPS
+        return true;
+      }
+      i += 2;
+    }
+  }
+  return false;
+}
+
+uint8_t* TSMuxer::NextPacket() {
+  if (chunk_.size() < kChunkPackets * kPacketSize) {
+    chunk_.assign(kChunkPackets * kPacketSize, 0);
+    chunk_packets_ = 0;
+  }
+  if (chunk_packets_ == kChunkPackets) {
+    EmitChunk();
+  }
+  return chunk_.data() + (chunk_packets_++) * kPacketSize;
+}
+
+bool TSMuxer::EmitChunk() {
+  if (chunk_packets_ == 0) {
+    return true;
+  }
+  const size_t size = chunk_packets_ * kPacketSize;
+  chunk_packets_ = 0;
+  if (!WriteOut(chunk_.data(), size)) {
+    write_failed_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool TSMuxer::WriteOut(const uint8_t* data, size_t size) {
+  if (write_) {
+    return write_(opaque_, const_cast<uint8_t*>(data), static_cast<int>(size)) >= 0;
+  }
+  if (output_fd_ < 0) {
+    return true;  // No output attached (test doubles); nothing to deliver
+  }
+  // Nonblocking socket: what does not fit now is dropped, never waited on
+  size_t written = 0;
+  while (written < size) {
+    const ssize_t n = ::write(output_fd_, data + written, size - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+uint8_t* TSMuxer::Counter(uint16_t pid) {
+  if (pid == 0) {
+    return &pat_cc_;
+  }
+  if (pid == config_.pmt_pid) {
+    return &pmt_cc_;
+  }
+  if (pid == config_.video_pid) {
+    return &video_cc_;
+  }
+  if (config_.enable_audio && pid == config_.audio_pid) {
+    return &audio_cc_;
+  }
+  return nullptr;
+}
+
+void TSMuxer::BuildTables() {
+  // PAT: one program
+  pat_ = {0x00, 0xB0, 0x0D,
+          static_cast<uint8_t>(config_.transport_stream_id >> 8),
+          static_cast<uint8_t>(config_.transport_stream_id), 0xC1, 0x00, 0x00,
+          static_cast<uint8_t>(config_.program_number >> 8),
+          static_cast<uint8_t>(config_.program_number),
+          static_cast<uint8_t>(0xE0 | (config_.pmt_pid >> 8)),
+          static_cast<uint8_t>(config_.pmt_pid)};
+  AppendCrc(&pat_);
 
+  // PMT: video (the PCR PID), then audio
+  std::vector<uint8_t> streams = {config_.video_stream_type,
+                                  static_cast<uint8_t>(0xE0 | (config_.video_pid >> 8)),
+                                  static_cast<uint8_t>(config_.video_pid), 0xF0, 0x00};
+  if (config_.enable_audio) {
+    const bool ac3 = config_.audio_stream_type == kTsStreamTypeAc3;
+    streams.insert(streams.end(),
+                   {config_.audio_stream_type,
+                    static_cast<uint8_t>(0xE0 | (config_.audio_pid >> 8)),
+                    static_cast<uint8_t>(config_.audio_pid), 0xF0,
+                    static_cast<uint8_t>(ac3 ? 6 : 0)});
+    if (ac3) {
+      streams.insert(streams.end(), {0x05, 0x04, 'A', 'C', '-', '3'});  // Registration
+    }
+  }
+  const size_t section_length = 9 + streams.size() + 4;
+  pmt_ = {0x02, static_cast<uint8_t>(0xB0 | (section_length >> 8)),
+          static_cast<uint8_t>(section_length),
+          static_cast<uint8_t>(config_.program_number >> 8),
+          static_cast<uint8_t>(config_.program_number), 0xC1, 0x00, 0x00,
+          static_cast<uint8_t>(0xE0 | (config_.video_pid >> 8)),
+          static_cast<uint8_t>(config_.video_pid), 0xF0, 0x00};
+  pmt_.insert(pmt_.end(), streams.begin(), streams.end());
+  AppendCrc(&pmt_);
+}
+
+void TSMuxer::WritePsi(uint16_t pid, const uint8_t* section, size_t size) {
+  uint8_t* packet = NextPacket();
+  uint8_t* cc = Counter(pid);
+  packet[0] = kSyncByte;
+  packet[1] = static_cast<uint8_t>(0x40 | ((pid >> 8) & 0x1F));  // Payload unit start
+  packet[2] = static_cast<uint8_t>(pid);
+  packet[3] = static_cast<uint8_t>(0x10 | *cc);
+  *cc = (*cc + 1) & 0x0F;
+  packet[4] = 0x00;  // pointer_field
+  std::memcpy(packet + 5, section, size);
+  std::memset(packet + 5 + size, 0xFF, kPacketSize - 5 - size);
+}
+
+void TSMuxer::WriteTables() {
+  WritePsi(0, pat_.data(), pat_.size());
+  WritePsi(config_.pmt_pid, pmt_.data(), pmt_.size());
+}
+
+void TSMuxer::WritePcrPacket(int64_t clock_90k) {
+  // Adaptation field only: the continuity counter does not advance
+  uint8_t* packet = NextPacket();
+  packet[0] = kSyncByte;
+  packet[1] = static_cast<uint8_t>((config_.video_pid >> 8) & 0x1F);
+  packet[2] = static_cast<uint8_t>(config_.video_pid);
+  packet[3] = static_cast<uint8_t>(0x20 | ((video_cc_ + 15) & 0x0F));
+  packet[4] = static_cast<uint8_t>(kPacketSize - 5);
+  packet[5] = 0x10;  // PCR_flag
+  PutPcr(packet + 6, clock_90k);
+  std::memset(packet + 12, 0xFF, kPacketSize - 12);
+}
 
+void TSMuxer::WritePes(uint16_t pid, const uint8_t* header, size_t header_size,
+                       const uint8_t* data, size_t size, bool pcr, int64_t clock_90k,
+                       bool random_access) {
+  uint8_t* cc = Counter(pid);
+  size_t remaining = header_size + size;
+  size_t header_used = 0;
+  size_t data_used = 0;
+  bool first = true;
+  while (remaining > 0) {
+    uint8_t* packet = NextPacket();
+
+    // Adaptation field: PCR / random access on the first packet, stuffing
+    // on the last
+    size_t af_size = 0;  // Including its length byte
+    if (first && (pcr || random_access)) {
+      af_size = 2 + (pcr ? 6 : 0);
+    }
+    const size_t payload = std::min(remaining, kPayloadSize - af_size);
+    af_size = kPayloadSize - payload;
+
+    packet[0] = kSyncByte;
+    packet[1] = static_cast<uint8_t>((first ? 0x40 : 0x00) | ((pid >> 8) & 0x1F));
+    packet[2] = static_cast<uint8_t>(pid);
+    packet[3] = static_cast<uint8_t>((af_size > 0 ? 0x30 : 0x10) | *cc);
+    *cc = (*cc + 1) & 0x0F;
+
+    uint8_t* out = packet + 4;
+    if (af_size > 0) {
+      out[0] = static_cast<uint8_t>(af_size - 1);
+      if (af_size > 1) {
+        size_t used = 2;
+        out[1] = 0x00;
+        if (first && random_access) {
+          out[1] |= 0x40;
+        }
+        if (first && pcr) {
+          out[1] |= 0x10;
+          PutPcr(out + 2, clock_90k);
+          used += 6;
+        }
+        std::memset(out + used, 0xFF, af_size - used);
+      }
+      out += af_size;
+    }
+
+    // Payload: the rest of the header, then the access unit
+    size_t left = payload;
+    if (header_used < header_size) {
+      const size_t n = std::min(left, header_size - header_used);
+      std::memcpy(out, header + header_used, n);
+      header_used += n;
+      out += n;
+      left -= n;
+    }
+    if (left > 0) {
+      std::memcpy(out, data + data_used, left);
+      data_used += left;
+    }
+    remaining -= payload;
+    first = false;
+  }
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,179 @@
+// Repository: Retrovue-playout
+// Component: TS Asset Cache
+// Purpose: Pre-encoded airings of repeatedly aired assets, per encoder profile.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsAssetCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+// FNV-1a; names cache files, so it must not change between builds
+uint64_t HashKey(const std::string& key) {
+  uint64_t hash = 1469598103934665603ull;
+  for (const char c : key) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+TsAssetCache::TsAssetCache(size_t capacity_bytes, std::string directory)
+    : capacity_bytes_(capacity_bytes), directory_(std::move(directory)) {}
+
+std::string TsAssetCache::MakeKey(const std::string& uri, const std::string& profile) {
+  // Size and mtime when uri is a local file (0 for network URIs)
+  uint64_t size_bytes = 0;
+  int64_t mtime_ns = 0;
+  std::error_code ec;
+  const std::filesystem::path path(uri);
+  if (std::filesystem::is_regular_file(path, ec)) {
+    size_bytes = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (!ec) {
+      mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch())
+                     .count();
+    }
+  }
+  return profile + '\n' + uri + '\n' + std::to_string(size_bytes) + ':' +
+         std::to_string(mtime_ns);
+}
+
+std::string TsAssetCache::FileName(const std::string& uri, const std::string& profile) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.ts",
+                static_cast<unsigned long long>(HashKey(MakeKey(uri, profile))));
+  return name;
+}
+
+std::shared_ptr<const TsFillerClip> TsAssetCache::Find(const std::string& uri,
+                                                       const std::string& profile) {
+  std::string key = MakeKey(uri, profile);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = index_.find(key);
+    if (found != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, found->second);
+      stats_.hits++;
+      return found->second->clip;
+    }
+  }
+
+  std::shared_ptr<const TsFillerClip> clip;
+  if (!directory_.empty()) {
+    clip = LoadFile((std::filesystem::path(directory_) / FileName(uri, profile)).string());
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!clip) {
+    stats_.misses++;
+    return nullptr;
+  }
+  stats_.hits++;
+  stats_.disk_loads++;
+  InsertLocked(std::move(key), clip);
+  return clip;
+}
+
+void TsAssetCache::Insert(const std::string& uri, const std::string& profile,
+                          std::shared_ptr<const TsFillerClip> clip) {
+  if (!clip || clip->empty() || clip->size_bytes() > capacity_bytes_) {
+    return;
+  }
+  if (!directory_.empty()) {
+    SaveFile((std::filesystem::path(directory_) / FileName(uri, profile)).string(), *clip);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.inserts++;
+  InsertLocked(MakeKey(uri, profile), std::move(clip));
+}
+
+void TsAssetCache::InsertLocked(std::string key, std::shared_ptr<const TsFillerClip> clip) {
+  const auto found = index_.find(key);
+  if (found != index_.end()) {
+    size_bytes_ -= found->second->clip->size_bytes();
+    lru_.erase(found->second);
+    index_.erase(found);
+  }
+  size_bytes_ += clip->size_bytes();
+  lru_.push_front(Entry{key, std::move(clip)});
+  index_.emplace(std::move(key), lru_.begin());
+
+  // Entries being emitted stay alive through their pipelines' references
+  while (size_bytes_ > capacity_bytes_ && lru_.size() > 1) {
+    const Entry& oldest = lru_.back();
+    size_bytes_ -= oldest.clip->size_bytes();
+    index_.erase(oldest.key);
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+}
+
+void TsAssetCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  index_.clear();
+  size_bytes_ = 0;
+}
+
+TsAssetCacheStats TsAssetCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TsAssetCacheStats stats = stats_;
+  stats.entries = lru_.size();
+  stats.size_bytes = size_bytes_;
+  return stats;
+}
+
+std::shared_ptr<const TsFillerClip> TsAssetCache::LoadFile(const std::string& path) const {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return nullptr;  // Not prepared
+  }
+  std::vector<uint8_t> ts((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (ts.size() > capacity_bytes_) {
+    return nullptr;
+  }
+  auto clip = std::make_shared<TsFillerClip>();
+  if (!clip->Load(std::move(ts))) {
+    std::cerr << "[TsAssetCache] Ignoring cache file without video frames: " << path << std::endl;
+    return nullptr;
+  }
+  return clip;
+}
+
+void TsAssetCache::SaveFile(const std::string& path, const TsFillerClip& clip) const {
+  // Through a temporary file and rename, so readers never load a partial clip
+  const std::string temp_path = path + ".tmp";
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(clip.bytes().data()),
+              static_cast<std::streamsize>(clip.bytes().size()));
+    out.flush();
+    if (!out) {
+      std::cerr << "[TsAssetCache] Failed writing cache file: " << temp_path << std::endl;
+      out.close();
+      std::filesystem::remove(temp_path, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec) {
+    std::cerr << "[TsAssetCache] Failed to rename cache file " << temp_path << ": "
+              << ec.message() << std::endl;
+    std::filesystem::remove(temp_path, ec);
+  }
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,798 @@
+// Repository: Retrovue-playout
+// Component: TS Fanout
+// Purpose: Delivers one encoder's MPEG-TS output to several connected clients.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "retrovue/runtime/IoRing.h"
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr size_t kTsPacketSize = 188;
+constexpr int kPipeWaitSliceMs = 100;  // Bound on a wait for pipe space, for Disconnect()
+
+uint16_t PacketPid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+bool PayloadStart(const uint8_t* packet) { return (packet[1] & 0x40) != 0; }
+
+// True for the first packet of a video keyframe: a video PES start whose
+// adaptation field sets the random access indicator.
+bool VideoKeyframeStart(const uint8_t* packet) {
+  if (!PayloadStart(packet) || (packet[3] & 0x20) == 0 || packet[4] == 0 ||
+      (packet[5] & 0x40) == 0) {
+    return false;
+  }
+  const size_t offset = 5 + packet[4];
+  if (offset + 4 > kTsPacketSize) {
+    return false;
+  }
+  const uint8_t* pes = packet + offset;
+  return pes[0] == 0x00 && pes[1] == 0x00 && pes[2] == 0x01 && (pes[3] & 0xF0) == 0xE0;
+}
+
+// PMT PID of the first program in a PAT packet.
+bool ParsePmtPid(const uint8_t* packet, uint16_t* pmt_pid) {
+  size_t offset = 4;
+  if (packet[3] & 0x20) {
+    offset += 1 + packet[4];
+  }
+  if (offset >= kTsPacketSize) {
+    return false;
+  }
+  offset += 1 + packet[offset];  // pointer_field
+  // table_id, section_length (2), transport_stream_id (2), version (1),
+  // section numbers (2), then 4-byte program entries
+  if (offset + 12 > kTsPacketSize || packet[offset] != 0x00) {
+    return false;
+  }
+  const size_t section_length = ((packet[offset + 1] & 0x0F) << 8) | packet[offset + 2];
+  if (section_length < 9) {
+    return false;
+  }
+  const size_t entries_end = std::min(offset + 3 + section_length - 4, kTsPacketSize);
+  for (size_t entry = offset + 8; entry + 4 <= entries_end; entry += 4) {
+    const uint16_t program_number =
+        static_cast<uint16_t>((packet[entry] << 8) | packet[entry + 1]);
+    if (program_number != 0) {
+      *pmt_pid = static_cast<uint16_t>(((packet[entry + 2] & 0x1F) << 8) | packet[entry + 3]);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Offset of the first packet in data that starts a PAT section, or size if
+// there is none.
+size_t FindPatStart(const uint8_t* data, size_t size) {
+  for (size_t offset = 0; offset + kTsPacketSize <= size; offset += kTsPacketSize) {
+    const uint8_t* packet = data + offset;
+    if (packet[0] == 0x47 && PayloadStart(packet) && PacketPid(packet) == 0) {
+      return offset;
+    }
+  }
+  return size;
+}
+
+// Skips sent bytes of the count buffers at iov, resuming mid-buffer after a
+// partial write.
+void AdvanceIov(struct iovec*& iov, size_t& count, size_t sent) {
+  while (count > 0 && sent >= iov->iov_len) {
+    sent -= iov->iov_len;
+    ++iov;
+    --count;
+  }
+  if (count > 0) {
+    iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + sent;
+    iov->iov_len -= sent;
+  }
+}
+
+// Blocking gathered send of every byte in iov (advanced in place as it
+// goes); false once the client is gone. Counts each sendmsg() in syscalls.
+bool SendAll(int fd, struct iovec* iov, size_t count, const std::string& label,
+             std::atomic<uint64_t>& syscalls) {
+  while (count > 0) {
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = count;
+    ssize_t result = sendmsg(fd, &message, MSG_NOSIGNAL);
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EPIPE && errno != ECONNRESET) {
+        std::cerr << "[TsFanout] Send error (" << label << "): " << strerror(errno)
+                  << std::endl;
+      }
+      return false;
+    }
+    if (result == 0) {
+      return false;
+    }
+    AdvanceIov(iov, count, static_cast<size_t>(result));
+  }
+  return true;
+}
+
+}  // namespace
+
+TsFanout::TsFanout(size_t max_subscribers, size_t queue_bytes, SlowClientPolicy policy,
+                   size_t gop_cache_bytes, size_t send_batch_bytes,
+                   int64_t send_batch_delay_us, int64_t max_lag_ms,
+                   std::shared_ptr<runtime::IoRing> io_ring)
+    : max_subscribers_(max_subscribers),
+      queue_bytes_(queue_bytes),
+      policy_(policy),
+      gop_cache_bytes_(gop_cache_bytes),
+      send_batch_bytes_(std::max<size_t>(send_batch_bytes, 1)),
+      send_batch_delay_us_(std::max<int64_t>(send_batch_delay_us, 0)),
+      max_lag_(std::max<int64_t>(max_lag_ms, 0)),
+      io_ring_(io_ring && io_ring->IsOpen() ? std::move(io_ring) : nullptr) {}
+
+TsFanout::~TsFanout() {
+  CloseAll(nullptr, 0, 0);
+  // Readers still behind on a pipe may now see released memory
+  for (const auto& subscriber : draining_) {
+    close(subscriber->fd);
+  }
+}
+
+bool TsFanout::AddSubscriber(int fd, const std::string& label, bool pipe) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReapLocked();
+  if (subscribers_.size() >= max_subscribers_) {
+    stats_.rejected++;
+    std::cerr << "[TsFanout] Rejected " << label << ": " << max_subscribers_
+              << " subscribers already connected" << std::endl;
+    close(fd);
+    return false;
+  }
+
+  auto subscriber = std::make_unique<Subscriber>();
+  subscriber->fd = fd;
+  subscriber->label = label;
+  subscriber->pipe = pipe;
+  const bool cached = !gop_cache_.empty();
+  if (cached) {
+    // Start from the latest keyframe instead of waiting for the next one
+    const auto now = std::chrono::steady_clock::now();
+    if (gop_prefix_) {
+      subscriber->queue.push_back({gop_prefix_, 0, gop_prefix_->size(), now});
+      subscriber->queued_bytes += gop_prefix_->size();
+    }
+    for (const auto& entry : gop_cache_) {
+      // The cached GOP starts at a keyframe; later chunks are not scanned
+      const size_t keyframe =
+          entry.first == gop_cache_.front().first ? entry.second : entry.first->size();
+      subscriber->queue.push_back({entry.first, entry.second, keyframe, now});
+      subscriber->queued_bytes += entry.first->size() - entry.second;
+    }
+    subscriber->joined = true;
+    stats_.cached_joins++;
+  }
+  Subscriber* raw = subscriber.get();
+  subscriber->completion = io_ring_ && !pipe;
+  if (!subscriber->completion) {
+    subscriber->sender = std::thread(&TsFanout::SendLoop, this, raw);
+  }
+  subscribers_.push_back(std::move(subscriber));
+  stats_.subscribers_total++;
+  if (raw->completion && cached) {
+    Kick(*raw);
+    io_ring_->Submit();
+  }
+
+  std::cout << "[TsFanout] Subscriber connected: " << label << " ("
+            << subscribers_.size() << "/" << max_subscribers_ << ")"
+            << (cached ? " from cached GOP" : "") << std::endl;
+  return true;
+}
+
+void TsFanout::Publish(const uint8_t* data, size_t size) {
+  struct iovec part;
+  part.iov_base = const_cast<uint8_t*>(data);
+  part.iov_len = size;
+  Publish(&part, 1);
+}
+
+void TsFanout::Publish(const struct iovec* parts, size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size += parts[i].iov_len;
+  }
+  if (size == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReapLocked();
+  if (subscribers_.empty() && gop_cache_bytes_ == 0) {
+    return;
+  }
+
+  // One copy shared by every queue (and the GOP cache)
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  bytes->reserve(size);
+  for (size_t i = 0; i < count; ++i) {
+    const auto* part = static_cast<const uint8_t*>(parts[i].iov_base);
+    bytes->insert(bytes->end(), part, part + parts[i].iov_len);
+  }
+  TsChunk chunk = std::move(bytes);
+  const uint8_t* data = chunk->data();
+  stats_.bytes_published += size;
+  if (gop_cache_bytes_ > 0) {
+    UpdateGopCacheLocked(chunk);
+  }
+
+  const size_t keyframe = KeyframeOffset(data, size);
+  const auto now = std::chrono::steady_clock::now();
+  for (const auto& subscriber : subscribers_) {
+    if (subscriber->finished.load(std::memory_order_acquire)) {
+      continue;
+    }
+    size_t offset = 0;
+    if (!subscriber->joined) {
+      offset = FindPatStart(data, size);
+      if (offset == size) {
+        continue;  // Still waiting for a PAT to start from
+      }
+      subscriber->joined = true;
+    }
+    if (!Enqueue(*subscriber, chunk, offset, keyframe, now)) {
+      stats_.evictions++;
+      std::cerr << "[TsFanout] Evicted slow subscriber " << subscriber->label << std::endl;
+    }
+  }
+  if (io_ring_) {
+    io_ring_->Submit();  // Every subscriber's send in one system call
+  }
+}
+
+bool TsFanout::Enqueue(Subscriber& subscriber, const TsChunk& chunk, size_t offset,
+                       size_t keyframe, std::chrono::steady_clock::time_point now) {
+  const size_t size = chunk->size();
+  if (keyframe < offset) {
+    keyframe = size;  // Before where this subscriber starts
+  }
+  bool evict = false;
+  {
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    if (subscriber.closing) {
+      return true;  // Already on its way out
+    }
+    // Too far behind: the queue would outgrow queue_bytes, or (with a lag
+    // limit) its oldest chunk has waited longer than max_lag_
+    auto behind = [&] {
+      return subscriber.queued_bytes + (size - offset) > queue_bytes_ ||
+             (max_lag_.count() > 0 && !subscriber.queue.empty() &&
+              now - subscriber.queue.front().queued > max_lag_);
+    };
+    if (!subscriber.resync && behind()) {
+      if (policy_ == SlowClientPolicy::EVICT) {
+        evict = true;
+        if (subscriber.queued_bytes + (size - offset) <= queue_bytes_) {
+          stats_.lag_evictions++;
+        }
+      } else {
+        // Drop the oldest bytes, then the rest of their GOP up to the next
+        // queued keyframe, which the client resumes from
+        auto before_keyframe = [&] {
+          const Queued& oldest = subscriber.queue.front();
+          return oldest.keyframe == oldest.chunk->size();
+        };
+        bool cut = false;
+        while (!subscriber.queue.empty() && (behind() || before_keyframe())) {
+          const Queued& oldest = subscriber.queue.front();
+          subscriber.queued_bytes -= oldest.chunk->size() - oldest.offset;
+          subscriber.queue.pop_front();
+          stats_.chunks_dropped++;
+          cut = true;
+        }
+        if (!subscriber.queue.empty()) {
+          Queued& first = subscriber.queue.front();
+          subscriber.queued_bytes -= first.keyframe - first.offset;
+          first.offset = first.keyframe;
+        } else {
+          subscriber.resync = true;  // Wait for a keyframe in a new chunk
+        }
+        if (cut || subscriber.resync) {
+          stats_.gop_resyncs++;
+        }
+      }
+    }
+    if (subscriber.resync) {
+      if (keyframe == size) {
+        stats_.chunks_dropped++;
+        return true;
+      }
+      offset = keyframe;
+      subscriber.resync = false;
+    }
+    if (!evict) {
+      subscriber.queue.push_back({chunk, offset, keyframe, now});
+      subscriber.queued_bytes += size - offset;
+    }
+  }
+  if (evict) {
+    Disconnect(subscriber);
+    Kick(subscriber);
+    return false;
+  }
+  subscriber.cv.notify_one();
+  Kick(subscriber);
+  return true;
+}
+
+void TsFanout::Disconnect(Subscriber& subscriber) {
+  {
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    subscriber.closing = true;
+    subscriber.disconnected = true;
+    subscriber.queue.clear();
+    subscriber.queued_bytes = 0;
+  }
+  // Fails a send in progress (a pipe sender sees disconnected within
+  // kPipeWaitSliceMs); the fd is closed once the sender is joined
+  if (!subscriber.pipe) {
+    shutdown(subscriber.fd, SHUT_RDWR);
+  }
+  subscriber.cv.notify_one();
+}
+
+bool TsFanout::SpliceAll(Subscriber& subscriber, struct iovec* iov, size_t count) {
+  while (count > 0) {
+    ssize_t result = vmsplice(subscriber.fd, iov, count, SPLICE_F_NONBLOCK);
+    send_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        // Pipe full: wait for the reader
+        struct pollfd pfd;
+        pfd.fd = subscriber.fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        poll(&pfd, 1, kPipeWaitSliceMs);
+        std::lock_guard<std::mutex> lock(subscriber.mutex);
+        if (subscriber.disconnected) {
+          return false;
+        }
+        continue;
+      }
+      if (errno != EPIPE) {
+        std::cerr << "[TsFanout] vmsplice error (" << subscriber.label << "): "
+                  << strerror(errno) << std::endl;
+      }
+      return false;
+    }
+    subscriber.spliced += static_cast<uint64_t>(result);
+    AdvanceIov(iov, count, static_cast<size_t>(result));
+  }
+  return true;
+}
+
+bool TsFanout::ReleaseSpliced(Subscriber& subscriber) {
+  if (subscriber.pinned.empty()) {
+    return true;
+  }
+  struct pollfd pfd;
+  pfd.fd = subscriber.fd;
+  pfd.events = 0;
+  pfd.revents = 0;
+  if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLERR)) {
+    subscriber.pinned.clear();  // Reader has closed the pipe
+    return true;
+  }
+  int unread = 0;
+  if (ioctl(subscriber.fd, FIONREAD, &unread) < 0) {
+    return false;
+  }
+  const uint64_t consumed = subscriber.spliced - static_cast<uint64_t>(unread);
+  while (!subscriber.pinned.empty() && subscriber.pinned.front().second <= consumed) {
+    subscriber.pinned.pop_front();
+  }
+  return subscriber.pinned.empty();
+}
+
+void TsFanout::SendLoop(Subscriber* subscriber) {
+  if (subscriber->pipe) {
+    // A closed reader fails vmsplice() with EPIPE instead of raising SIGPIPE
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  }
+  std::vector<TsChunk> batch;  // Holds the chunks alive while iov points at them
+  std::vector<struct iovec> iov;
+  batch.reserve(kMaxBatchChunks);
+  iov.reserve(kMaxBatchChunks);
+  while (true) {
+    batch.clear();
+    iov.clear();
+    size_t batch_bytes = 0;
+    {
+      std::unique_lock<std::mutex> lock(subscriber->mutex);
+      subscriber->cv.wait(lock, [subscriber] {
+        return subscriber->closing || !subscriber->queue.empty();
+      });
+      if (send_batch_delay_us_ > 0 && !subscriber->closing &&
+          subscriber->queued_bytes < send_batch_bytes_) {
+        // Latency budget: let more chunks gather behind the first
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::microseconds(send_batch_delay_us_);
+        subscriber->cv.wait_until(lock, deadline, [this, subscriber] {
+          return subscriber->closing || subscriber->queued_bytes >= send_batch_bytes_;
+        });
+      }
+      if (subscriber->queue.empty()) {
+        break;  // Closing and drained
+      }
+      while (!subscriber->queue.empty() && batch.size() < kMaxBatchChunks) {
+        Queued& item = subscriber->queue.front();
+        const size_t bytes = item.chunk->size() - item.offset;
+        if (!batch.empty() && batch_bytes + bytes > send_batch_bytes_) {
+          break;
+        }
+        struct iovec part;
+        part.iov_base = const_cast<uint8_t*>(item.chunk->data() + item.offset);
+        part.iov_len = bytes;
+        iov.push_back(part);
+        batch.push_back(std::move(item.chunk));
+        batch_bytes += bytes;
+        subscriber->queued_bytes -= bytes;
+        subscriber->queue.pop_front();
+      }
+    }
+    if (batch.size() > max_batch_chunks_.load(std::memory_order_relaxed)) {
+      max_batch_chunks_.store(batch.size(), std::memory_order_relaxed);
+    }
+    const uint64_t spliced_before = subscriber->spliced;
+    const bool sent =
+        subscriber->pipe
+            ? SpliceAll(*subscriber, iov.data(), iov.size())
+            : SendAll(subscriber->fd, iov.data(), iov.size(), subscriber->label, send_syscalls_);
+    if (subscriber->pipe) {
+      // The pipe now points into the batch: keep it until read past its end
+      const uint64_t end = sent ? spliced_before + batch_bytes : subscriber->spliced;
+      for (TsChunk& chunk : batch) {
+        subscriber->pinned.emplace_back(std::move(chunk), end);
+      }
+      ReleaseSpliced(*subscriber);
+    }
+    if (!sent) {
+      std::lock_guard<std::mutex> lock(subscriber->mutex);
+      if (!subscriber->closing) {
+        send_failures_.fetch_add(1, std::memory_order_relaxed);  // Not an eviction
+      }
+      break;
+    }
+    bytes_sent_.fetch_add(batch_bytes, std::memory_order_relaxed);
+  }
+  subscriber->finished.store(true, std::memory_order_release);
+}
+
+bool TsFanout::SendNextLocked(Subscriber& subscriber) {
+  if (subscriber.in_flight) {
+    return false;
+  }
+  if (subscriber.disconnected || subscriber.queue.empty()) {
+    return subscriber.disconnected || subscriber.closing;
+  }
+  subscriber.batch.clear();
+  subscriber.iov.clear();
+  subscriber.iov_next = 0;
+  subscriber.batch_bytes = 0;
+  while (!subscriber.queue.empty() && subscriber.batch.size() < kMaxBatchChunks) {
+    Queued& item = subscriber.queue.front();
+    const size_t bytes = item.chunk->size() - item.offset;
+    if (!subscriber.batch.empty() && subscriber.batch_bytes + bytes > send_batch_bytes_) {
+      break;
+    }
+    struct iovec part;
+    part.iov_base = const_cast<uint8_t*>(item.chunk->data() + item.offset);
+    part.iov_len = bytes;
+    subscriber.iov.push_back(part);
+    subscriber.batch.push_back(std::move(item.chunk));
+    subscriber.batch_bytes += bytes;
+    subscriber.queued_bytes -= bytes;
+    subscriber.queue.pop_front();
+  }
+  if (subscriber.batch.size() > max_batch_chunks_.load(std::memory_order_relaxed)) {
+    max_batch_chunks_.store(subscriber.batch.size(), std::memory_order_relaxed);
+  }
+  if (!QueueBatchLocked(subscriber)) {
+    send_failures_.fetch_add(1, std::memory_order_relaxed);
+    subscriber.batch.clear();
+    return true;
+  }
+  return false;
+}
+
+bool TsFanout::QueueBatchLocked(Subscriber& subscriber) {
+  std::memset(&subscriber.message, 0, sizeof(subscriber.message));
+  subscriber.message.msg_iov = subscriber.iov.data() + subscriber.iov_next;
+  subscriber.message.msg_iovlen = subscriber.iov.size() - subscriber.iov_next;
+  Subscriber* raw = &subscriber;
+  if (!io_ring_->QueueSendmsg(subscriber.fd, &subscriber.message, MSG_NOSIGNAL | MSG_WAITALL,
+                              [this, raw](int32_t result) { OnSendComplete(*raw, result); })) {
+    std::cerr << "[TsFanout] Cannot queue send (" << subscriber.label << ")" << std::endl;
+    return false;
+  }
+  subscriber.in_flight = true;
+  send_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void TsFanout::OnSendComplete(Subscriber& subscriber, int32_t result) {
+  bool done = false;
+  {
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    subscriber.in_flight = false;
+    if (result == -EINTR || result == -EAGAIN) {
+      done = subscriber.disconnected || !QueueBatchLocked(subscriber);
+    } else if (result <= 0) {
+      if (!subscriber.closing) {
+        send_failures_.fetch_add(1, std::memory_order_relaxed);  // Not an eviction
+      }
+      if (result < 0 && result != -EPIPE && result != -ECONNRESET && !subscriber.disconnected) {
+        std::cerr << "[TsFanout] Send error (" << subscriber.label << "): "
+                  << strerror(-result) << std::endl;
+      }
+      subscriber.disconnected = true;
+      subscriber.queue.clear();
+      subscriber.queued_bytes = 0;
+      subscriber.batch.clear();
+      done = true;
+    } else {
+      struct iovec* iov = subscriber.iov.data() + subscriber.iov_next;
+      size_t count = subscriber.iov.size() - subscriber.iov_next;
+      AdvanceIov(iov, count, static_cast<size_t>(result));
+      subscriber.iov_next = static_cast<size_t>(iov - subscriber.iov.data());
+      if (count > 0) {
+        // Short write: the rest of the batch first
+        done = subscriber.disconnected || !QueueBatchLocked(subscriber);
+      } else {
+        bytes_sent_.fetch_add(subscriber.batch_bytes, std::memory_order_relaxed);
+        subscriber.batch.clear();
+        done = SendNextLocked(subscriber);
+      }
+    }
+  }
+  if (done) {
+    // Last touch: the subscriber may be reaped from here on
+    subscriber.finished.store(true, std::memory_order_release);
+  }
+}
+
+void TsFanout::Kick(Subscriber& subscriber) {
+  if (!subscriber.completion) {
+    return;
+  }
+  bool done = false;
+  {
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    done = SendNextLocked(subscriber);
+  }
+  if (done) {
+    subscriber.finished.store(true, std::memory_order_release);
+  }
+}
+
+void TsFanout::UpdateGopCacheLocked(const TsChunk& chunk) {
+  const uint8_t* data = chunk->data();
+  const size_t size = chunk->size();
+  // The GOP starts at the last keyframe in the chunk, or at the PAT/PMT
+  // run directly before it
+  size_t keyframe = size;
+  size_t psi_start = size;
+  for (size_t offset = 0; offset + kTsPacketSize <= size; offset += kTsPacketSize) {
+    const uint8_t* packet = data + offset;
+    if (packet[0] != 0x47) {
+      continue;
+    }
+    const uint16_t pid = PacketPid(packet);
+    if (pid == 0 && PayloadStart(packet)) {
+      pat_packet_.assign(packet, packet + kTsPacketSize);
+      pmt_pid_known_ = ParsePmtPid(packet, &pmt_pid_);
+      psi_start = offset;
+      continue;
+    }
+    if (pmt_pid_known_ && pid == pmt_pid_ && PayloadStart(packet)) {
+      pmt_packet_.assign(packet, packet + kTsPacketSize);
+      continue;
+    }
+    if (VideoKeyframeStart(packet)) {
+      keyframe = psi_start < offset ? psi_start : offset;
+    } else if (pid != 0x1FFF) {
+      psi_start = size;  // PAT/PMT run broken by other packets
+    }
+  }
+
+  if (keyframe < size) {
+    gop_cache_.clear();
+    gop_cache_.emplace_back(chunk, keyframe);
+    gop_cache_size_ = size - keyframe;
+    gop_prefix_.reset();
+    const bool starts_with_pat = PacketPid(data + keyframe) == 0;
+    if (!starts_with_pat && !pat_packet_.empty() && !pmt_packet_.empty()) {
+      auto prefix = std::make_shared<std::vector<uint8_t>>(pat_packet_);
+      prefix->insert(prefix->end(), pmt_packet_.begin(), pmt_packet_.end());
+      gop_prefix_ = std::move(prefix);
+    }
+  } else if (!gop_cache_.empty()) {
+    gop_cache_.emplace_back(chunk, 0);
+    gop_cache_size_ += size;
+  }
+
+  if (gop_cache_size_ > gop_cache_bytes_) {
+    // Longer than a new subscriber could be sent at once
+    gop_cache_.clear();
+    gop_cache_size_ = 0;
+    gop_prefix_.reset();
+  }
+}
+
+void TsFanout::ReapLocked() {
+  for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+    if (!(*it)->finished.load(std::memory_order_acquire)) {
+      ++it;
+      continue;
+    }
+    if ((*it)->sender.joinable()) {
+      (*it)->sender.join();
+    }
+    RetireLocked(std::move(*it));
+    it = subscribers_.erase(it);
+  }
+  for (auto it = draining_.begin(); it != draining_.end();) {
+    if (!ReleaseSpliced(**it)) {
+      ++it;
+      continue;
+    }
+    close((*it)->fd);
+    it = draining_.erase(it);
+  }
+}
+
+void TsFanout::RetireLocked(std::unique_ptr<Subscriber> subscriber) {
+  std::cout << "[TsFanout] Subscriber disconnected: " << subscriber->label << std::endl;
+  if (subscriber->pipe && !ReleaseSpliced(*subscriber)) {
+    draining_.push_back(std::move(subscriber));  // Its reader is still behind
+    return;
+  }
+  close(subscriber->fd);
+}
+
+size_t TsFanout::KeyframeOffset(const uint8_t* data, size_t size) {
+  for (size_t offset = 0; offset + kTsPacketSize <= size; offset += kTsPacketSize) {
+    if (data[offset] == 0x47 && VideoKeyframeStart(data + offset)) {
+      return offset;
+    }
+  }
+  return size;
+}
+
+size_t TsFanout::SubscriberCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& subscriber : subscribers_) {
+    if (!subscriber->finished.load(std::memory_order_acquire)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void TsFanout::CloseAll(const uint8_t* trailer, size_t trailer_size, int64_t timeout_ms) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribers_.empty()) {
+      return;
+    }
+    TsChunk chunk;
+    const auto now = std::chrono::steady_clock::now();
+    if (trailer && trailer_size > 0) {
+      chunk = std::make_shared<const std::vector<uint8_t>>(trailer, trailer + trailer_size);
+    }
+    for (const auto& subscriber : subscribers_) {
+      {
+        std::lock_guard<std::mutex> sub_lock(subscriber->mutex);
+        if (chunk && subscriber->joined && !subscriber->closing) {
+          subscriber->queue.push_back({chunk, 0, trailer_size, now});
+          subscriber->queued_bytes += trailer_size;
+        }
+        subscriber->closing = true;
+      }
+      subscriber->cv.notify_one();
+      Kick(*subscriber);
+    }
+    if (io_ring_) {
+      io_ring_->Submit();
+    }
+  }
+
+  // Let the senders finish what is queued, then cut off any that are stuck
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (SubscriberCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& subscriber : subscribers_) {
+    if (!subscriber->finished.load(std::memory_order_acquire)) {
+      Disconnect(*subscriber);
+      Kick(*subscriber);
+    }
+  }
+  for (auto& subscriber : subscribers_) {
+    if (subscriber->sender.joinable()) {
+      subscriber->sender.join();
+    }
+    // A send in flight fails promptly on the shut-down socket
+    while (!subscriber->finished.load(std::memory_order_acquire)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    RetireLocked(std::move(subscriber));
+  }
+  subscribers_.clear();
+}
+
+TsFanoutStats TsFanout::GetStats() const {
+  TsFanoutStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats = stats_;
+    stats.gop_cache_bytes = gop_cache_size_;
+    stats.draining = draining_.size();
+    // Read here rather than per send, so the senders pay nothing for it
+    for (const auto& subscriber : subscribers_) {
+      if (subscriber->finished.load(std::memory_order_acquire)) {
+        continue;
+      }
+      {
+        std::lock_guard<std::mutex> subscriber_lock(subscriber->mutex);
+        stats.max_queued_bytes = std::max(stats.max_queued_bytes, subscriber->queued_bytes);
+      }
+      int unsent = 0;
+      int send_buffer = 0;
+      socklen_t length = sizeof(send_buffer);
+      if (!subscriber->pipe && ioctl(subscriber->fd, TIOCOUTQ, &unsent) == 0 &&
+          getsockopt(subscriber->fd, SOL_SOCKET, SO_SNDBUF, &send_buffer, &length) == 0 &&
+          send_buffer > 0) {
+        stats.send_buffer_ratio =
+            std::max(stats.send_buffer_ratio,
+                     std::min(1.0, static_cast<double>(unsent) / send_buffer));
+      }
+    }
+  }
+  stats.subscribers = SubscriberCount();
+  stats.send_failures = send_failures_.load(std::memory_order_relaxed);
+  stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  stats.send_syscalls = send_syscalls_.load(std::memory_order_relaxed);
+  stats.max_batch_chunks = max_batch_chunks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,208 @@
+// Repository: Retrovue-playout
+// Component: TS Filler Clip
+// Purpose: Pre-muxed frames (underflow filler, cached airings), re-timed on emit.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsFillerClip.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr size_t kPacketSize = 188;
+constexpr uint8_t kSyncByte = 0x47;
+constexpr int64_t kTimestampMask = (int64_t{1} << 33) - 1;  // 33-bit PTS/DTS/PCR base
+
+uint16_t PacketPid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+// Offset of the payload in packet, or 0 if it has none.
+size_t PayloadOffset(const uint8_t* packet) {
+  const uint8_t adaptation_field_control = (packet[3] >> 4) & 0x03;
+  if ((adaptation_field_control & 0x01) == 0) {
+    return 0;
+  }
+  size_t offset = 4;
+  if (adaptation_field_control & 0x02) {
+    offset += 1 + packet[4];
+  }
+  return offset < kPacketSize ? offset : 0;
+}
+
+// The PES header starting in packet (whole, within the packet), or null.
+uint8_t* PesHeader(uint8_t* packet) {
+  if ((packet[1] & 0x40) == 0) {
+    return nullptr;  // No payload unit start
+  }
+  const size_t offset = PayloadOffset(packet);
+  if (offset == 0 || offset + 9 > kPacketSize) {
+    return nullptr;
+  }
+  uint8_t* pes = packet + offset;
+  if (pes[0] != 0x00 || pes[1] != 0x00 || pes[2] != 0x01 || offset + 9 + pes[8] > kPacketSize) {
+    return nullptr;
+  }
+  return pes;
+}
+
+// The video PES header starting in packet, or null.
+uint8_t* VideoPesHeader(uint8_t* packet) {
+  uint8_t* pes = PesHeader(packet);
+  return pes && (pes[3] & 0xF0) == 0xE0 && pes[8] >= 5 ? pes : nullptr;
+}
+
+int64_t ReadTimestamp(const uint8_t* p) {
+  return (static_cast<int64_t>((p[0] >> 1) & 0x07) << 30) |
+         (static_cast<int64_t>(p[1]) << 22) | (static_cast<int64_t>(p[2] >> 1) << 15) |
+         (static_cast<int64_t>(p[3]) << 7) | static_cast<int64_t>(p[4] >> 1);
+}
+
+// Rewrites a PES timestamp in place, keeping its 4-bit prefix.
+void WriteTimestamp(uint8_t* p, int64_t ts) {
+  ts &= kTimestampMask;
+  p[0] = static_cast<uint8_t>((p[0] & 0xF0) | ((ts >> 29) & 0x0E) | 0x01);
+  p[1] = static_cast<uint8_t>(ts >> 22);
+  p[2] = static_cast<uint8_t>(((ts >> 14) & 0xFE) | 0x01);
+  p[3] = static_cast<uint8_t>(ts >> 7);
+  p[4] = static_cast<uint8_t>(((ts << 1) & 0xFE) | 0x01);
+}
+
+// PTS and DTS of a PES header; false if it carries no PTS.
+bool ReadPesTimes(const uint8_t* pes, int64_t* pts, int64_t* dts) {
+  const uint8_t pts_dts_flags = pes[7] >> 6;
+  if ((pts_dts_flags & 0x02) == 0) {
+    return false;
+  }
+  *pts = ReadTimestamp(pes + 9);
+  *dts = pts_dts_flags == 0x03 ? ReadTimestamp(pes + 14) : *pts;
+  return true;
+}
+
+// Moves the PCR base of packet (if it carries one) by delta; the 27 MHz
+// extension is kept.
+void ShiftPcr(uint8_t* packet, int64_t delta) {
+  if (!(packet[3] & 0x20) || packet[4] == 0 || !(packet[5] & 0x10)) {
+    return;
+  }
+  int64_t base = (static_cast<int64_t>(packet[6]) << 25) |
+                 (static_cast<int64_t>(packet[7]) << 17) |
+                 (static_cast<int64_t>(packet[8]) << 9) |
+                 (static_cast<int64_t>(packet[9]) << 1) | ((packet[10] >> 7) & 0x01);
+  base = (base + delta) & kTimestampMask;
+  packet[6] = static_cast<uint8_t>(base >> 25);
+  packet[7] = static_cast<uint8_t>(base >> 17);
+  packet[8] = static_cast<uint8_t>(base >> 9);
+  packet[9] = static_cast<uint8_t>(base >> 1);
+  packet[10] = static_cast<uint8_t>(((base & 0x01) << 7) | (packet[10] & 0x7F));
+}
+
+}  // namespace
+
+bool TsFillerClip::Load(std::vector<uint8_t> ts) {
+  Clear();
+  ts.resize(ts.size() - ts.size() % kPacketSize);
+  const size_t packets = ts.size() / kPacketSize;
+
+  bool have_video = false;
+  std::vector<size_t> starts;  // Packet index of each video PES start
+  for (size_t i = 0; i < packets; ++i) {
+    uint8_t* packet = ts.data() + i * kPacketSize;
+    if (packet[0] != kSyncByte) {
+      return false;
+    }
+    const uint16_t pid = PacketPid(packet);
+    const uint8_t* pes = VideoPesHeader(packet);
+    if (pes && (!have_video || pid == video_pid_)) {
+      FrameRun run;
+      if (ReadPesTimes(pes, &run.pts90k, &run.dts90k)) {
+        video_pid_ = pid;
+        have_video = true;
+        starts.push_back(i);
+        frames_.push_back(run);
+      }
+    }
+  }
+  if (frames_.empty()) {
+    return false;
+  }
+
+  // Each frame starts with the PAT/PMT muxed just before its PES (the first
+  // also takes the stream header) and ends where the next one starts; the
+  // last one takes the clip's trailing packets (audio of a cached airing)
+  std::vector<size_t> begins(starts.size());
+  for (size_t k = 0; k < starts.size(); ++k) {
+    size_t begin = starts[k];
+    if (k == 0) {
+      begin = 0;
+    } else {
+      while (begin > starts[k - 1] + 1 &&
+             PacketPid(ts.data() + (begin - 1) * kPacketSize) != video_pid_) {
+        --begin;
+      }
+    }
+    begins[k] = begin;
+  }
+  for (size_t k = 0; k < frames_.size(); ++k) {
+    const size_t end = k + 1 < begins.size() ? begins[k + 1] : packets;
+    frames_[k].offset = begins[k] * kPacketSize;
+    frames_[k].size = (end - begins[k]) * kPacketSize;
+  }
+  // The clip's first frame was encoded at PTS 0
+  mux_delay_90k_ = frames_[0].pts90k;
+  ts_ = std::move(ts);
+  return true;
+}
+
+void TsFillerClip::Clear() {
+  ts_.clear();
+  frames_.clear();
+  video_pid_ = 0;
+  mux_delay_90k_ = 0;
+}
+
+int64_t TsFillerClip::AppendFrame(size_t index, int64_t pts90k,
+                                  std::vector<uint8_t>* out) const {
+  const FrameRun& run = frames_[index];
+  const int64_t delta = pts90k + mux_delay_90k_ - run.pts90k;
+  const size_t start = out->size();
+  out->insert(out->end(), ts_.begin() + static_cast<std::ptrdiff_t>(run.offset),
+              ts_.begin() + static_cast<std::ptrdiff_t>(run.offset + run.size));
+
+  for (size_t offset = start; offset < out->size(); offset += kPacketSize) {
+    uint8_t* packet = out->data() + offset;
+    ShiftPcr(packet, delta);
+    uint8_t* pes = PesHeader(packet);
+    if (!pes) {
+      continue;
+    }
+    // Video and audio alike: every stream moves by the frame's offset
+    const uint8_t pts_dts_flags = pes[7] >> 6;
+    if ((pts_dts_flags & 0x02) && pes[8] >= 5) {
+      WriteTimestamp(pes + 9, ReadTimestamp(pes + 9) + delta);
+    }
+    if (pts_dts_flags == 0x03 && pes[8] >= 10) {
+      WriteTimestamp(pes + 14, ReadTimestamp(pes + 14) + delta);
+    }
+  }
+  return run.dts90k + delta - mux_delay_90k_;
+}
+
+size_t TsFillerClip::FindFrame(int64_t offset90k, int64_t tolerance90k) const {
+  if (frames_.empty()) {
+    return 0;
+  }
+  const int64_t target = offset90k + mux_delay_90k_;
+  if (target > frames_.back().pts90k + tolerance90k) {
+    return frames_.size();  // Past the end
+  }
+  const auto after = std::upper_bound(
+      frames_.begin(), frames_.end(), target + tolerance90k,
+      [](int64_t pts90k, const FrameRun& run) { return pts90k < run.pts90k; });
+  return after == frames_.begin() ? 0 : static_cast<size_t>(after - frames_.begin()) - 1;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,516 @@
+// Repository: Retrovue-playout
+// Component: TS HLS Segmenter
+// Purpose: Cuts the muxed TS into in-memory HLS/LL-HLS segments and serves them.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsHlsSegmenter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr uint16_t kNullPid = 0x1FFF;
+constexpr int64_t kDtsWrap = int64_t{1} << 33;
+constexpr int64_t kMaxFrameGap90k = 5 * 90000;  // Longer DTS steps are discontinuities
+
+uint16_t PacketPid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+bool PayloadStart(const uint8_t* packet) { return (packet[1] & 0x40) != 0; }
+
+// Offset of the payload, or 188 if there is none.
+size_t PayloadOffset(const uint8_t* packet) {
+  if ((packet[3] & 0x10) == 0) {
+    return TsHlsSegmenter::kPacketSize;
+  }
+  size_t offset = 4;
+  if (packet[3] & 0x20) {
+    offset += 1 + packet[4];
+  }
+  return std::min(offset, TsHlsSegmenter::kPacketSize);
+}
+
+// Offset of a PSI section after the pointer_field, or 0 if out of range.
+size_t SectionOffset(const uint8_t* packet) {
+  const size_t offset = PayloadOffset(packet);
+  if (offset >= TsHlsSegmenter::kPacketSize) {
+    return 0;
+  }
+  const size_t section = offset + 1 + packet[offset];
+  return section + 12 <= TsHlsSegmenter::kPacketSize ? section : 0;
+}
+
+// PMT PID of the first program in a PAT packet.
+bool ParsePmtPid(const uint8_t* packet, uint16_t* pmt_pid) {
+  const size_t offset = SectionOffset(packet);
+  if (offset == 0 || packet[offset] != 0x00) {
+    return false;
+  }
+  const size_t section_length = ((packet[offset + 1] & 0x0F) << 8) | packet[offset + 2];
+  if (section_length < 9) {
+    return false;
+  }
+  const size_t entries_end =
+      std::min(offset + 3 + section_length - 4, TsHlsSegmenter::kPacketSize);
+  for (size_t entry = offset + 8; entry + 4 <= entries_end; entry += 4) {
+    const uint16_t program_number =
+        static_cast<uint16_t>((packet[entry] << 8) | packet[entry + 1]);
+    if (program_number != 0) {
+      *pmt_pid = static_cast<uint16_t>(((packet[entry + 2] & 0x1F) << 8) | packet[entry + 3]);
+      return true;
+    }
+  }
+  return false;
+}
+
+// PID of the first video stream (MPEG-2, H.264 or HEVC) in a PMT packet.
+bool ParseVideoPid(const uint8_t* packet, uint16_t* video_pid) {
+  const size_t offset = SectionOffset(packet);
+  if (offset == 0 || packet[offset] != 0x02) {
+    return false;
+  }
+  const size_t section_length = ((packet[offset + 1] & 0x0F) << 8) | packet[offset + 2];
+  if (section_length < 13) {
+    return false;
+  }
+  const size_t streams_end =
+      std::min(offset + 3 + section_length - 4, TsHlsSegmenter::kPacketSize);
+  const size_t program_info_length = ((packet[offset + 10] & 0x0F) << 8) | packet[offset + 11];
+  for (size_t entry = offset + 12 + program_info_length; entry + 5 <= streams_end;) {
+    const uint8_t stream_type = packet[entry];
+    if (stream_type == 0x02 || stream_type == 0x1B || stream_type == 0x24) {
+      *video_pid = static_cast<uint16_t>(((packet[entry + 1] & 0x1F) << 8) | packet[entry + 2]);
+      return true;
+    }
+    entry += 5 + (((packet[entry + 3] & 0x0F) << 8) | packet[entry + 4]);
+  }
+  return false;
+}
+
+// True if the adaptation field sets the random access indicator (an IDR).
+bool RandomAccess(const uint8_t* packet) {
+  return (packet[3] & 0x20) != 0 && packet[4] != 0 && (packet[5] & 0x40) != 0;
+}
+
+// DTS (PTS if the PES carries no DTS) of a PES starting in packet, 90 kHz.
+bool ParsePesDts(const uint8_t* packet, int64_t* dts) {
+  const size_t offset = PayloadOffset(packet);
+  if (offset + 19 > TsHlsSegmenter::kPacketSize) {
+    return false;
+  }
+  const uint8_t* pes = packet + offset;
+  if (pes[0] != 0x00 || pes[1] != 0x00 || pes[2] != 0x01) {
+    return false;
+  }
+  const uint8_t pts_dts_flags = pes[7] >> 6;
+  if (pts_dts_flags < 2) {
+    return false;
+  }
+  const uint8_t* ts = pes + 9 + (pts_dts_flags == 3 ? 5 : 0);
+  *dts = (static_cast<int64_t>(ts[0] & 0x0E) << 29) | (static_cast<int64_t>(ts[1]) << 22) |
+         (static_cast<int64_t>(ts[2] & 0xFE) << 14) | (static_cast<int64_t>(ts[3]) << 7) |
+         (ts[4] >> 1);
+  return true;
+}
+
+// Parses "<prefix><number><suffix>" (and "<prefix><a>.<b><suffix>" with b).
+bool ParseMediaName(const std::string& name, const char* prefix, uint64_t* a, uint64_t* b) {
+  const std::string head(prefix);
+  const std::string tail(".ts");
+  if (name.size() <= head.size() + tail.size() || name.compare(0, head.size(), head) != 0 ||
+      name.compare(name.size() - tail.size(), tail.size(), tail) != 0) {
+    return false;
+  }
+  const std::string numbers = name.substr(head.size(), name.size() - head.size() - tail.size());
+  char* end = nullptr;
+  *a = std::strtoull(numbers.c_str(), &end, 10);
+  if (end == numbers.c_str()) {
+    return false;
+  }
+  if (b == nullptr) {
+    return *end == '\0';
+  }
+  if (*end != '.') {
+    return false;
+  }
+  const char* second = end + 1;
+  *b = std::strtoull(second, &end, 10);
+  return end != second && *end == '\0';
+}
+
+void Status(telemetry::HttpResponse& response, int status, const char* text) {
+  response.status = status;
+  response.content_type = "text/plain";
+  response.cache_control = "no-cache";
+  response.body = std::make_shared<const std::string>(text);
+}
+
+}  // namespace
+
+TsHlsSegmenter::TsHlsSegmenter(const HlsSegmenterConfig& config)
+    : config_(config),
+      segment_90k_(std::max<int64_t>(config.segment_ms, 1) * 90),
+      part_90k_(std::max<int64_t>(config.part_ms, 0) * 90) {}
+
+void TsHlsSegmenter::Write(const uint8_t* data, size_t size) {
+  for (size_t offset = 0; offset + kPacketSize <= size; offset += kPacketSize) {
+    if (data[offset] == 0x47) {
+      WritePacket(data + offset);
+    }
+  }
+}
+
+void TsHlsSegmenter::Write(const struct iovec* parts, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    Write(static_cast<const uint8_t*>(parts[i].iov_base), parts[i].iov_len);
+  }
+}
+
+void TsHlsSegmenter::WritePacket(const uint8_t* packet) {
+  const uint16_t pid = PacketPid(packet);
+  if (pid == kNullPid) {
+    return;
+  }
+  const char* bytes = reinterpret_cast<const char*>(packet);
+
+  // PAT/PMT are held so the ones ahead of an IDR open its segment
+  if (pid == 0 || pid == pmt_pid_) {
+    if (PayloadStart(packet)) {
+      if (pid == 0) {
+        pat_packet_.assign(bytes, kPacketSize);
+        ParsePmtPid(packet, &pmt_pid_);
+      } else {
+        pmt_packet_.assign(bytes, kPacketSize);
+        ParseVideoPid(packet, &video_pid_);
+      }
+    }
+    psi_pending_.append(bytes, kPacketSize);
+    return;
+  }
+
+  if (pid == video_pid_ && PayloadStart(packet)) {
+    int64_t dts = 0;
+    const bool has_dts = ParsePesDts(packet, &dts);
+    const bool keyframe = RandomAccess(packet);
+    if (has_dts && started_) {
+      int64_t delta = ((dts - last_dts_) % kDtsWrap + kDtsWrap) % kDtsWrap;
+      if (delta >= kDtsWrap / 2) {
+        delta -= kDtsWrap;
+      }
+      if (delta <= 0 || delta > kMaxFrameGap90k) {
+        discontinuity_pending_ = true;  // Restart at the next IDR
+        delta = frame_90k_;
+      } else {
+        frame_90k_ = delta;
+      }
+      media_90k_ += delta;
+    }
+    if (has_dts) {
+      last_dts_ = dts;
+    }
+
+    if (!started_) {
+      if (!keyframe || !has_dts || pat_packet_.empty() || pmt_packet_.empty()) {
+        psi_pending_.clear();
+        return;
+      }
+      started_ = true;
+      media_90k_ = 0;
+      frame_90k_ = 0;
+      OpenSegment(false);
+    } else if (keyframe &&
+               (media_90k_ - segment_start_90k_ >= segment_90k_ || discontinuity_pending_)) {
+      CloseSegment();
+      OpenSegment(discontinuity_pending_);
+      discontinuity_pending_ = false;
+    } else if (part_90k_ > 0 && media_90k_ > part_start_90k_ &&
+               media_90k_ - part_start_90k_ + frame_90k_ > part_90k_) {
+      ClosePart();  // The next frame would take the part past its target
+    }
+  } else if (!started_) {
+    psi_pending_.clear();
+    return;
+  }
+
+  FlushPsi();
+  part_bytes_.append(bytes, kPacketSize);
+}
+
+void TsHlsSegmenter::FlushPsi() {
+  if (!psi_pending_.empty()) {
+    part_bytes_ += psi_pending_;
+    psi_pending_.clear();
+  }
+}
+
+void TsHlsSegmenter::OpenSegment(bool discontinuity) {
+  segment_start_90k_ = media_90k_;
+  part_start_90k_ = media_90k_;
+  part_independent_ = true;
+  segment_bytes_.clear();
+  part_bytes_.clear();
+  // Every segment starts with PAT/PMT
+  const bool has_pat = !psi_pending_.empty() &&
+                       PacketPid(reinterpret_cast<const uint8_t*>(psi_pending_.data())) == 0;
+  if (!has_pat) {
+    part_bytes_ = pat_packet_ + pmt_packet_;
+  }
+  if (discontinuity) {
+    discontinuities_.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  Segment segment;
+  segment.sequence = next_sequence_++;
+  segment.discontinuity = discontinuity;
+  segments_.push_back(std::move(segment));
+}
+
+void TsHlsSegmenter::ClosePart() {
+  if (part_bytes_.empty()) {
+    return;
+  }
+  Part part;
+  part.data = std::make_shared<const std::string>(part_bytes_);
+  part.duration = static_cast<double>(media_90k_ - part_start_90k_) / 90000.0;
+  part.independent = part_independent_;
+  segment_bytes_ += part_bytes_;
+  part_bytes_.clear();
+  part_start_90k_ = media_90k_;
+  part_independent_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stored_bytes_ += part.data->size();
+    segments_.back().parts.push_back(std::move(part));
+  }
+  parts_total_.fetch_add(1, std::memory_order_relaxed);
+  changed_.notify_all();
+}
+
+void TsHlsSegmenter::CloseSegment() {
+  if (part_90k_ > 0) {
+    ClosePart();
+  } else {
+    segment_bytes_ += part_bytes_;
+    part_bytes_.clear();
+  }
+  Body data = std::make_shared<const std::string>(std::move(segment_bytes_));
+  segment_bytes_.clear();
+  const double duration = static_cast<double>(media_90k_ - segment_start_90k_) / 90000.0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Segment& segment = segments_.back();
+    segment.complete = true;
+    segment.duration = duration;
+    segment.data = data;
+    stored_bytes_ += data->size();
+    longest_segment_ = std::max(longest_segment_, duration);
+
+    // Keep the window, and parts only for the newest segments
+    while (segments_.size() > std::max<size_t>(config_.window_segments, 1)) {
+      const Segment& oldest = segments_.front();
+      stored_bytes_ -= oldest.data->size();
+      for (const Part& old_part : oldest.parts) {
+        stored_bytes_ -= old_part.data->size();
+      }
+      if (oldest.discontinuity) {
+        discontinuity_sequence_++;
+      }
+      segments_.pop_front();
+    }
+    for (size_t i = 0; i + kPartWindowSegments - 1 < segments_.size(); ++i) {
+      for (const Part& old_part : segments_[i].parts) {
+        stored_bytes_ -= old_part.data->size();
+      }
+      segments_[i].parts.clear();
+    }
+  }
+  segments_total_.fetch_add(1, std::memory_order_relaxed);
+  changed_.notify_all();
+}
+
+void TsHlsSegmenter::Open() {
+  if (started_) {
+    discontinuity_pending_ = true;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = false;
+}
+
+void TsHlsSegmenter::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  changed_.notify_all();
+}
+
+bool TsHlsSegmenter::HandleRequest(const telemetry::HttpRequest& request,
+                                   telemetry::HttpResponse& response) {
+  const std::string prefix = config_.path + "/";
+  if (request.path.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  const std::string name = request.path.substr(prefix.size());
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (name == "index.m3u8") {
+    playlist_requests_.fetch_add(1, std::memory_order_relaxed);
+    const auto msn = request.query.find("_HLS_msn");
+    if (part_90k_ > 0 && msn != request.query.end()) {
+      // Blocking playlist reload: hold until the named segment/part exists
+      const uint64_t wanted = std::strtoull(msn->second.c_str(), nullptr, 10);
+      const auto part = request.query.find("_HLS_part");
+      const int64_t wanted_part =
+          part != request.query.end() ? std::strtoll(part->second.c_str(), nullptr, 10) : -1;
+      if (wanted > next_sequence_ + 1) {
+        Status(response, 400, "Media sequence too far ahead\n");
+        return true;
+      }
+      if (!ReachedLocked(wanted, wanted_part)) {
+        blocked_requests_.fetch_add(1, std::memory_order_relaxed);
+        if (!changed_.wait_for(lock, HoldTimeout(), [&] {
+              return closed_ || ReachedLocked(wanted, wanted_part);
+            })) {
+          Status(response, 503, "Timed out waiting for media\n");
+          return true;
+        }
+      }
+    }
+    if (closed_) {
+      Status(response, 503, "Stream stopped\n");
+      return true;
+    }
+    response.content_type = "application/vnd.apple.mpegurl";
+    response.cache_control = "no-cache";
+    response.body = std::make_shared<const std::string>(RenderPlaylistLocked());
+    return true;
+  }
+
+  uint64_t sequence = 0;
+  uint64_t index = 0;
+  if (ParseMediaName(name, "seg", &sequence, nullptr)) {
+    const Segment* segment = FindLocked(sequence);
+    if (segment == nullptr || !segment->complete) {
+      return false;
+    }
+    response.body = segment->data;
+  } else if (part_90k_ > 0 && ParseMediaName(name, "part", &sequence, &index)) {
+    // The preload-hinted part (the next one) is held until it is cut
+    const auto available = [&] {
+      const Segment* segment = FindLocked(sequence);
+      return segment != nullptr && index < segment->parts.size();
+    };
+    if (!available()) {
+      const bool hinted = !segments_.empty() && !segments_.back().complete &&
+                          sequence == segments_.back().sequence &&
+                          index == segments_.back().parts.size();
+      const bool next_segment = sequence == next_sequence_ && index == 0;
+      if (!hinted && !next_segment) {
+        return false;
+      }
+      blocked_requests_.fetch_add(1, std::memory_order_relaxed);
+      if (!changed_.wait_for(lock, HoldTimeout(), [&] { return closed_ || available(); }) ||
+          closed_) {
+        Status(response, 503, "Timed out waiting for media\n");
+        return true;
+      }
+    }
+    response.body = FindLocked(sequence)->parts[index].data;
+  } else {
+    return false;
+  }
+  media_requests_.fetch_add(1, std::memory_order_relaxed);
+  response.content_type = "video/mp2t";
+  response.cache_control = "max-age=60";
+  return true;
+}
+
+TsHlsSegmenterStats TsHlsSegmenter::GetStats() const {
+  TsHlsSegmenterStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.media_sequence = segments_.empty() ? next_sequence_ : segments_.front().sequence;
+    stats.stored_bytes = stored_bytes_;
+  }
+  stats.segments = segments_total_.load(std::memory_order_relaxed);
+  stats.parts = parts_total_.load(std::memory_order_relaxed);
+  stats.discontinuities = discontinuities_.load(std::memory_order_relaxed);
+  stats.playlist_requests = playlist_requests_.load(std::memory_order_relaxed);
+  stats.blocked_requests = blocked_requests_.load(std::memory_order_relaxed);
+  stats.media_requests = media_requests_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::string TsHlsSegmenter::RenderPlaylistLocked() const {
+  const bool low_latency = part_90k_ > 0;
+  const double part_target = static_cast<double>(part_90k_) / 90000.0;
+  const int target_duration = static_cast<int>(std::ceil(
+      std::max(static_cast<double>(segment_90k_) / 90000.0, longest_segment_) - 1e-3));
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(5);
+  out << "#EXTM3U\n";
+  out << "#EXT-X-VERSION:" << (low_latency ? 6 : 3) << "\n";
+  out << "#EXT-X-TARGETDURATION:" << std::max(target_duration, 1) << "\n";
+  if (low_latency) {
+    out << "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" << 3 * part_target
+        << "\n";
+    out << "#EXT-X-PART-INF:PART-TARGET=" << part_target << "\n";
+  }
+  out << "#EXT-X-MEDIA-SEQUENCE:"
+      << (segments_.empty() ? next_sequence_ : segments_.front().sequence) << "\n";
+  if (discontinuity_sequence_ > 0) {
+    out << "#EXT-X-DISCONTINUITY-SEQUENCE:" << discontinuity_sequence_ << "\n";
+  }
+  for (const Segment& segment : segments_) {
+    if (segment.discontinuity) {
+      out << "#EXT-X-DISCONTINUITY\n";
+    }
+    for (size_t i = 0; i < segment.parts.size(); ++i) {
+      const Part& part = segment.parts[i];
+      out << "#EXT-X-PART:DURATION=" << part.duration << ",URI=\"part" << segment.sequence
+          << "." << i << ".ts\"" << (part.independent ? ",INDEPENDENT=YES" : "") << "\n";
+    }
+    if (segment.complete) {
+      out << "#EXTINF:" << segment.duration << ",\nseg" << segment.sequence << ".ts\n";
+    }
+  }
+  if (low_latency && !segments_.empty() && !segments_.back().complete) {
+    out << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part" << segments_.back().sequence << "."
+        << segments_.back().parts.size() << ".ts\"\n";
+  }
+  return out.str();
+}
+
+bool TsHlsSegmenter::ReachedLocked(uint64_t msn, int64_t part) const {
+  if (segments_.empty()) {
+    return false;
+  }
+  const Segment& last = segments_.back();
+  if (last.sequence != msn) {
+    return last.sequence > msn;
+  }
+  return last.complete || (part >= 0 && last.parts.size() > static_cast<size_t>(part));
+}
+
+const TsHlsSegmenter::Segment* TsHlsSegmenter::FindLocked(uint64_t sequence) const {
+  if (segments_.empty() || sequence < segments_.front().sequence ||
+      sequence > segments_.back().sequence) {
+    return nullptr;
+  }
+  return &segments_[static_cast<size_t>(sequence - segments_.front().sequence)];
+}
+
+std::chrono::milliseconds TsHlsSegmenter::HoldTimeout() const {
+  // Three target durations, as LL-HLS allows
+  return std::chrono::milliseconds(3 * std::max<int64_t>(config_.segment_ms, 1000));
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,361 @@
+// Repository: Retrovue-playout
+// Component: TS MPTS Multiplexer
+// Purpose: Statistically multiplexes several channels into one multi-program transport stream.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsMptsMux.hpp"
+
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr size_t kPacketSize = 188;
+constexpr int64_t kPatRateBps =
+    static_cast<int64_t>(kPacketSize) * 8 * 1'000'000 / TsMptsMux::kPatIntervalUs;
+
+uint16_t PacketPid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+}  // namespace
+
+TsMptsMux::TsMptsMux(const MptsConfig& config,
+                     std::shared_ptr<retrovue::timing::MasterClock> clock)
+    : config_(config),
+      clock_(std::move(clock)),
+      udp_output_(config.udp, clock_),
+      pacer_(clock_, config.total_rate_bps, config.burst_packets, config.max_queue_ms, this,
+             &TsMptsMux::PacedWriteThunk) {}
+
+TsMptsMux::~TsMptsMux() { Stop(); }
+
+bool TsMptsMux::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return true;
+  }
+  if (config_.total_rate_bps <= 0) {
+    std::cerr << "[TsMptsMux] Invalid total rate: " << config_.total_rate_bps << std::endl;
+    return false;
+  }
+  if (!udp_output_.Open()) {
+    return false;
+  }
+  if (udp_output_.TxTimeActive()) {
+    pacer_.SetTimedWrite(&TsMptsMux::PacedTimedWriteThunk, config_.udp.txtime_lead_us);
+  } else {
+    pacer_.SetTimedWrite(nullptr, 0);
+  }
+  if (!pacer_.Start()) {
+    udp_output_.Close();
+    return false;
+  }
+  running_ = true;
+  MaybeSendPatLocked(true);
+  std::cout << "[TsMptsMux] MPTS at " << config_.total_rate_bps << " bps, video budget "
+            << VideoBudgetLocked() << " bps" << std::endl;
+  return true;
+}
+
+void TsMptsMux::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  // The pacer sends the backlog before the output closes
+  pacer_.Stop();
+  udp_output_.Close();
+}
+
+bool TsMptsMux::AddProgram(const MptsProgramConfig& program, BitrateCallback set_bitrate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (program.program_number < 1 || program.program_number > 255 ||
+      FindLocked(program.program_number) != nullptr || programs_.size() >= kMaxPrograms) {
+    std::cerr << "[TsMptsMux] Cannot add program " << program.program_number
+              << " (taken, out of range or the PAT is full)" << std::endl;
+    return false;
+  }
+  if (program.min_video_bps <= 0 || program.max_video_bps < program.min_video_bps ||
+      program.overhead_bps < 0) {
+    std::cerr << "[TsMptsMux] Invalid limits for program " << program.program_number
+              << std::endl;
+    return false;
+  }
+  int64_t floors = program.min_video_bps;
+  int64_t overheads = program.overhead_bps;
+  for (const Program& other : programs_) {
+    floors += other.config.min_video_bps;
+    overheads += other.config.overhead_bps;
+  }
+  if (floors > VideoBudgetLocked() - program.overhead_bps) {
+    std::cerr << "[TsMptsMux] Program " << program.program_number << " does not fit: "
+              << floors << " bps of video floors and " << overheads << " bps of overhead in "
+              << config_.total_rate_bps << " bps" << std::endl;
+    return false;
+  }
+
+  Program added;
+  added.config = program;
+  added.pids = MptsPidsForProgram(program.program_number);
+  added.set_bitrate = std::move(set_bitrate);
+  const auto position =
+      std::find_if(programs_.begin(), programs_.end(), [&](const Program& other) {
+        return other.config.program_number > program.program_number;
+      });
+  programs_.insert(position, std::move(added));
+  pat_version_ = static_cast<uint8_t>((pat_version_ + 1) & 0x1F);
+  if (running_) {
+    MaybeSendPatLocked(true);
+  }
+  ReallocateLocked();
+  return true;
+}
+
+void TsMptsMux::RemoveProgram(uint16_t program_number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = std::find_if(programs_.begin(), programs_.end(), [&](const Program& p) {
+    return p.config.program_number == program_number;
+  });
+  if (it == programs_.end()) {
+    return;
+  }
+  programs_.erase(it);
+  pat_version_ = static_cast<uint8_t>((pat_version_ + 1) & 0x1F);
+  if (running_) {
+    MaybeSendPatLocked(true);
+  }
+  ReallocateLocked();
+}
+
+void TsMptsMux::Push(uint16_t program_number, const uint8_t* data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Program* program = FindLocked(program_number);
+  if (!running_ || program == nullptr || size == 0) {
+    return;
+  }
+  program->bytes += size;
+  MaybeSendPatLocked(false);
+  if (!program->partial.empty()) {
+    const size_t n = std::min(size, kPacketSize - program->partial.size());
+    program->partial.insert(program->partial.end(), data, data + n);
+    data += n;
+    size -= n;
+    if (program->partial.size() < kPacketSize) {
+      return;
+    }
+    PushPacketsLocked(program->partial.data(), kPacketSize);
+    program->partial.clear();
+  }
+  const size_t whole = size / kPacketSize * kPacketSize;
+  PushPacketsLocked(data, whole);
+  program->partial.assign(data + whole, data + size);
+}
+
+void TsMptsMux::PushPacketsLocked(const uint8_t* data, size_t size) {
+  // Runs of packets between the channel's PATs go to the pacer as they are
+  size_t run = 0;
+  for (size_t offset = 0; offset + kPacketSize <= size; offset += kPacketSize) {
+    if (PacketPid(data + offset) == 0) {
+      if (offset > run) {
+        pacer_.Push(data + run, offset - run);
+      }
+      run = offset + kPacketSize;
+    }
+  }
+  if (size > run) {
+    pacer_.Push(data + run, size - run);
+  }
+}
+
+void TsMptsMux::ReportComplexity(uint16_t program_number, double complexity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Program* program = FindLocked(program_number);
+  if (program == nullptr || !(complexity > 0.0)) {
+    return;
+  }
+  program->complexity = program->complexity > 0.0
+                            ? program->complexity +
+                                  kComplexitySmoothing * (complexity - program->complexity)
+                            : complexity;
+  program->gops++;
+  allocations_++;
+  ReallocateLocked();
+}
+
+TsMptsMux::Program* TsMptsMux::FindLocked(uint16_t program_number) {
+  for (Program& program : programs_) {
+    if (program.config.program_number == program_number) {
+      return &program;
+    }
+  }
+  return nullptr;
+}
+
+int64_t TsMptsMux::VideoBudgetLocked() const {
+  int64_t budget = config_.total_rate_bps * (100 - kMuxOverheadPercent) / 100 - kPatRateBps;
+  for (const Program& program : programs_) {
+    budget -= program.config.overhead_bps;
+  }
+  return std::max<int64_t>(budget, 0);
+}
+
+void TsMptsMux::ReallocateLocked() {
+  if (programs_.empty()) {
+    return;
+  }
+  // Programs not heard from yet weigh as the average of the others (all
+  // alike before the first report)
+  double reported = 0.0;
+  size_t reporting = 0;
+  for (const Program& program : programs_) {
+    if (program.complexity > 0.0) {
+      reported += program.complexity;
+      reporting++;
+    }
+  }
+  const double average = reporting > 0 ? reported / static_cast<double>(reporting) : 1.0;
+
+  const size_t count = programs_.size();
+  std::vector<double> weight(count);
+  std::vector<int64_t> allocation(count);
+  std::vector<bool> capped(count, false);
+  int64_t remaining = VideoBudgetLocked();
+  for (size_t i = 0; i < count; ++i) {
+    weight[i] = programs_[i].complexity > 0.0 ? programs_[i].complexity : average;
+    allocation[i] = programs_[i].config.min_video_bps;
+    remaining -= allocation[i];
+  }
+
+  // Water-filling: share what is left by weight; programs that reach their
+  // ceiling are capped and the rest shared again among the others
+  bool capped_any = true;
+  while (remaining > 0 && capped_any) {
+    capped_any = false;
+    double total_weight = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      total_weight += capped[i] ? 0.0 : weight[i];
+    }
+    if (total_weight <= 0.0) {
+      break;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      const double share = static_cast<double>(remaining) * weight[i] / total_weight;
+      if (!capped[i] && static_cast<double>(allocation[i]) + share >=
+                            static_cast<double>(programs_[i].config.max_video_bps)) {
+        remaining -= programs_[i].config.max_video_bps - allocation[i];
+        allocation[i] = programs_[i].config.max_video_bps;
+        capped[i] = true;
+        capped_any = true;
+      }
+    }
+    if (!capped_any) {
+      for (size_t i = 0; i < count; ++i) {
+        if (!capped[i]) {
+          allocation[i] += static_cast<int64_t>(static_cast<double>(remaining) * weight[i] /
+                                                total_weight);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    Program& program = programs_[i];
+    const int64_t change = std::abs(allocation[i] - program.video_bps);
+    if (program.video_bps == 0 || change * 100 > program.video_bps * kMinChangePercent) {
+      program.video_bps = allocation[i];
+      if (program.set_bitrate) {
+        program.set_bitrate(allocation[i]);
+      }
+    }
+  }
+}
+
+void TsMptsMux::MaybeSendPatLocked(bool force) {
+  const int64_t now_us = clock_->now_utc_us();
+  if (!force && now_us - last_pat_us_ < kPatIntervalUs) {
+    return;
+  }
+  last_pat_us_ = now_us;
+
+  uint8_t packet[kPacketSize];
+  std::memset(packet, 0xFF, sizeof(packet));
+  packet[0] = 0x47;
+  packet[1] = 0x40;  // payload_unit_start, PID 0
+  packet[2] = 0x00;
+  packet[3] = static_cast<uint8_t>(0x10 | (pat_continuity_++ & 0x0F));
+  packet[4] = 0x00;  // pointer_field
+  uint8_t* section = packet + 5;
+  const size_t section_length = 5 + 4 * programs_.size() + 4;
+  section[0] = 0x00;  // table_id: program_association_section
+  section[1] = static_cast<uint8_t>(0xB0 | (section_length >> 8));
+  section[2] = static_cast<uint8_t>(section_length);
+  section[3] = static_cast<uint8_t>(config_.transport_stream_id >> 8);
+  section[4] = static_cast<uint8_t>(config_.transport_stream_id);
+  section[5] = static_cast<uint8_t>(0xC1 | (pat_version_ << 1));  // current_next
+  section[6] = 0x00;
+  section[7] = 0x00;
+  uint8_t* entry = section + 8;
+  for (const Program& program : programs_) {
+    entry[0] = static_cast<uint8_t>(program.config.program_number >> 8);
+    entry[1] = static_cast<uint8_t>(program.config.program_number);
+    entry[2] = static_cast<uint8_t>(0xE0 | (program.pids.pmt_pid >> 8));
+    entry[3] = static_cast<uint8_t>(program.pids.pmt_pid);
+    entry += 4;
+  }
+  const uint32_t crc = Crc32Mpeg(section, static_cast<size_t>(entry - section));
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    *entry++ = static_cast<uint8_t>(crc >> shift);
+  }
+  pacer_.Push(packet, sizeof(packet));
+  pat_packets_++;
+}
+
+int TsMptsMux::PacedWriteThunk(void* opaque, uint8_t* buf, int buf_size) {
+  auto* mux = static_cast<TsMptsMux*>(opaque);
+  return mux->udp_output_.Send(buf, static_cast<size_t>(buf_size)) ? buf_size : -1;
+}
+
+int TsMptsMux::PacedTimedWriteThunk(void* opaque, uint8_t* buf, int buf_size,
+                                     const int64_t* slot_utc_us) {
+  auto* mux = static_cast<TsMptsMux*>(opaque);
+  const bool sent = mux->udp_output_.Send(buf, static_cast<size_t>(buf_size), slot_utc_us);
+  if (!mux->udp_output_.TxTimeActive()) {
+    mux->pacer_.SetLeadUs(0);  // Fell back: pace in user space
+  }
+  return sent ? buf_size : -1;
+}
+
+TsMptsMuxStats TsMptsMux::GetStats() const {
+  TsMptsMuxStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.video_budget_bps = VideoBudgetLocked();
+    stats.allocations = allocations_;
+    stats.pat_packets = pat_packets_;
+    for (const Program& program : programs_) {
+      MptsProgramStats entry;
+      entry.program_number = program.config.program_number;
+      entry.video_bps = program.video_bps;
+      entry.complexity = program.complexity;
+      entry.gops = program.gops;
+      entry.bytes = program.bytes;
+      stats.programs.push_back(entry);
+    }
+  }
+  stats.pacer = pacer_.GetStats();
+  stats.udp = udp_output_.GetStats();
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
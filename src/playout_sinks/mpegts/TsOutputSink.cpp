@@ -18,11 +18,11 @@
 
 namespace retrovue::playout_sinks::mpegts {
 
-TsOutputSink::TsOutputSink(const std::string& socket_path)
+TsOutputSink::TsOutputSink(const std::string& socket_path, TsFanout& fanout, bool pipe_mode)
     : socket_path_(socket_path),
+      fanout_(fanout),
+      pipe_mode_(pipe_mode),
       listen_fd_(-1),
-      client_fd_(-1),
-      client_connected_(false),
       running_(false),
       stop_requested_(false) {
 }
@@ -94,8 +94,8 @@ bool TsOutputSink::Initialize() {
     return false;
   }
 
-  // Listen for connections (backlog of 1 - only accept one client at a time)
-  if (listen(listen_fd_, 1) < 0) {
+  // Listen for connections (backlog sized for the fanout's subscriber limit)
+  if (listen(listen_fd_, static_cast<int>(fanout_.max_subscribers())) < 0) {
     std::cerr << "[TsOutputSink] Failed to listen: " 
               << strerror(errno) << std::endl;
     close(listen_fd_);
@@ -144,44 +144,12 @@ void TsOutputSink::Stop() {
 }
 
 bool TsOutputSink::Write(const uint8_t* data, size_t size) {
-  if (!client_connected_.load(std::memory_order_acquire) || client_fd_ < 0) {
-    return false;  // No client connected
-  }
-
-  // Use blocking send with MSG_NOSIGNAL to avoid SIGPIPE
-  // The socket is set to blocking mode for the client connection to ensure atomic packet writes
-  size_t sent = 0;
-  while (sent < size) {
-    ssize_t result = send(client_fd_, data + sent, size - sent, MSG_NOSIGNAL);
-    
-    if (result < 0) {
-      if (errno == EINTR) {
-        // Interrupted by signal - retry
-        continue;
-      } else if (errno == EPIPE || errno == ECONNRESET) {
-        // Client disconnected
-        std::cout << "[TsOutputSink] Client disconnected during write (EPIPE/ECONNRESET)" << std::endl;
-        HandleClientDisconnect();
-        return false;
-      } else {
-        std::cerr << "[TsOutputSink] Send error: " << strerror(errno) << std::endl;
-        HandleClientDisconnect();
-        return false;
-      }
-    } else if (result == 0) {
-      // Connection closed
-      HandleClientDisconnect();
-      return false;
-    } else {
-      sent += static_cast<size_t>(result);
-    }
-  }
-
-  return true;  // All data sent
+  fanout_.Publish(data, size);  // Also feeds the GOP cache with no client
+  return fanout_.SubscriberCount() > 0;
 }
 
 bool TsOutputSink::IsClientConnected() const {
-  return client_connected_.load(std::memory_order_acquire);
+  return fanout_.SubscriberCount() > 0;
 }
 
 void TsOutputSink::AcceptThread() {
@@ -209,92 +177,112 @@ void TsOutputSink::AcceptThread() {
 }
 
 bool TsOutputSink::TryAcceptClient() {
-  // If already connected, don't accept another
-  if (client_connected_.load(std::memory_order_acquire)) {
-    return false;
-  }
-
   if (listen_fd_ < 0) {
     return false;
   }
 
-  int new_client_fd = accept(listen_fd_, nullptr, nullptr);
-
-  if (new_client_fd < 0) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      return false;  // No client waiting
-    } else {
-      std::cerr << "[TsOutputSink] Accept error: " << strerror(errno) << std::endl;
-      return false;
+  bool accepted = false;
+  while (true) {
+    int new_client_fd = accept(listen_fd_, nullptr, nullptr);
+    if (new_client_fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "[TsOutputSink] Accept error: " << strerror(errno) << std::endl;
+      }
+      return accepted;  // No more clients waiting
     }
-  }
 
-  // Set client socket to blocking mode for atomic packet writes
-  int flags = fcntl(new_client_fd, F_GETFL, 0);
-  if (flags < 0) {
-    std::cerr << "[TsOutputSink] Failed to get socket flags: " 
-              << strerror(errno) << std::endl;
-    close(new_client_fd);
-    return false;
-  }
-  // Clear O_NONBLOCK flag to make socket blocking
-  if (fcntl(new_client_fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
-    std::cerr << "[TsOutputSink] Failed to set client socket blocking: " 
-              << strerror(errno) << std::endl;
-    close(new_client_fd);
-    return false;
-  }
+    // Set client socket to blocking mode for atomic packet writes
+    int flags = fcntl(new_client_fd, F_GETFL, 0);
+    if (flags < 0) {
+      std::cerr << "[TsOutputSink] Failed to get socket flags: " 
+                << strerror(errno) << std::endl;
+      close(new_client_fd);
+      continue;
+    }
+    // Clear O_NONBLOCK flag to make socket blocking
+    if (fcntl(new_client_fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+      std::cerr << "[TsOutputSink] Failed to set client socket blocking: " 
+                << strerror(errno) << std::endl;
+      close(new_client_fd);
+      continue;
+    }
   
-  // Increase send buffer size for better performance
-  int send_buf_size = 256 * 1024;  // 256KB send buffer
-  if (setsockopt(new_client_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
-    std::cerr << "[TsOutputSink] Warning: Failed to set SO_SNDBUF: " 
-              << strerror(errno) << std::endl;
-    // Continue anyway - not critical
-  }
+    // Increase send buffer size for better performance
+    int send_buf_size = 256 * 1024;  // 256KB send buffer
+    if (setsockopt(new_client_fd, SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(send_buf_size)) < 0) {
+      std::cerr << "[TsOutputSink] Warning: Failed to set SO_SNDBUF: " 
+                << strerror(errno) << std::endl;
+      // Continue anyway - not critical
+    }
 
-  // Store client file descriptor
-  client_fd_ = new_client_fd;
-  client_connected_.store(true, std::memory_order_release);
+    if (pipe_mode_) {
+      const int pipe_fd = HandOffPipe(new_client_fd);
+      if (pipe_fd >= 0 && fanout_.AddSubscriber(pipe_fd, "pipe:" + socket_path_, true)) {
+        accepted = true;
+      }
+      continue;
+    }
 
-  std::cout << "[TsOutputSink] Client connected (ChannelManager)" << std::endl;
-  return true;
+    // The fanout owns the socket from here (and closes it if it is full)
+    if (fanout_.AddSubscriber(new_client_fd, "uds:" + socket_path_)) {
+      accepted = true;
+    }
+  }
 }
 
-void TsOutputSink::HandleClientDisconnect() {
-  if (!client_connected_.load(std::memory_order_acquire)) {
-    return;  // Already disconnected
+int TsOutputSink::HandOffPipe(int client_fd) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) < 0) {
+    std::cerr << "[TsOutputSink] Failed to create pipe: " << strerror(errno) << std::endl;
+    close(client_fd);
+    return -1;
   }
-
-  std::cout << "[TsOutputSink] Client disconnected" << std::endl;
-
-  // Close client socket
-  if (client_fd_ >= 0) {
-    close(client_fd_);
-    client_fd_ = -1;
+  if (fcntl(fds[1], F_SETPIPE_SZ, kPipeBytes) < 0) {
+    std::cerr << "[TsOutputSink] Warning: Failed to set pipe size: "
+              << strerror(errno) << std::endl;
+    // Continue anyway - the default capacity only means more wakeups
   }
 
-  // Mark as disconnected
-  client_connected_.store(false, std::memory_order_release);
-  
-  // Note: We don't close the listen socket - it stays open to accept new connections
+  // One byte carrying the read end
+  char tag = 'P';
+  struct iovec part;
+  part.iov_base = &tag;
+  part.iov_len = 1;
+  alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  std::memset(control, 0, sizeof(control));
+  struct msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &fds[0], sizeof(int));
+
+  const bool sent = sendmsg(client_fd, &message, MSG_NOSIGNAL) == 1;
+  if (!sent) {
+    std::cerr << "[TsOutputSink] Failed to pass pipe to client: " << strerror(errno)
+              << std::endl;
+  }
+  close(fds[0]);
+  close(client_fd);
+  if (!sent) {
+    close(fds[1]);
+    return -1;
+  }
+  return fds[1];
 }
 
 void TsOutputSink::CleanupSocket() {
-  // Close client socket if connected
-  if (client_fd_ >= 0) {
-    close(client_fd_);
-    client_fd_ = -1;
-  }
-  
   // Close listen socket
   if (listen_fd_ >= 0) {
     close(listen_fd_);
     listen_fd_ = -1;
   }
   
-  client_connected_.store(false, std::memory_order_release);
-  
   // Unlink socket file
   if (!socket_path_.empty() && std::filesystem::exists(socket_path_)) {
     if (unlink(socket_path_.c_str()) < 0) {
@@ -0,0 +1,320 @@
+// Repository: Retrovue-playout
+// Component: TS Pacer
+// Purpose: Constant-bitrate output pacing with null stuffing and PCR restamping.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsPacer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr int64_t kPacketBitsUs = static_cast<int64_t>(TsPacer::kPacketSize) * 8 * 1'000'000;
+constexpr int64_t kPcrWrap27m = (int64_t{1} << 33) * 300;  // PCR base wraps at 33 bits
+
+// Null packet: PID 0x1FFF, payload only, all stuffing bytes
+void WriteNullPacket(uint8_t* packet) {
+  std::memset(packet, 0xFF, TsPacer::kPacketSize);
+  packet[0] = 0x47;
+  packet[1] = 0x1F;
+  packet[2] = 0xFF;
+  packet[3] = 0x10;
+}
+
+void AtomicMax(std::atomic<size_t>& target, size_t value) {
+  if (value > target.load(std::memory_order_relaxed)) {
+    target.store(value, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+
+TsPacer::TsPacer(std::shared_ptr<retrovue::timing::MasterClock> clock, int64_t rate_bps,
+                 size_t burst_packets, int64_t max_queue_ms, void* opaque, WriteCallback write)
+    : clock_(std::move(clock)),
+      rate_bps_(std::max<int64_t>(rate_bps, 1)),
+      burst_packets_(std::max<size_t>(burst_packets, 1)),
+      queue_limit_packets_(std::max<size_t>(
+          burst_packets_,
+          static_cast<size_t>(rate_bps_ / 1000 * std::max<int64_t>(max_queue_ms, 0) /
+                              (static_cast<int64_t>(kPacketSize) * 8)))),
+      opaque_(opaque),
+      write_(write) {}
+
+TsPacer::~TsPacer() { Stop(); }
+
+bool TsPacer::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return true;
+  }
+  if (!clock_ || (!write_ && !timed_write_)) {
+    std::cerr << "[TsPacer] No clock or output" << std::endl;
+    return false;
+  }
+  running_ = true;
+  stopping_ = false;
+  scheduled_ = false;
+  thread_ = std::thread(&TsPacer::PaceLoop, this);
+  std::cout << "[TsPacer] Pacing output at " << rate_bps_ << " bps, " << burst_packets_
+            << " packets per write" << std::endl;
+  return true;
+}
+
+void TsPacer::SetTimedWrite(TimedWriteCallback write, int64_t lead_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  timed_write_ = write;
+  lead_us_.store(std::max<int64_t>(lead_us, 0), std::memory_order_relaxed);
+}
+
+void TsPacer::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+}
+
+void TsPacer::Push(const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!partial_.empty()) {
+    const size_t n = std::min(size, kPacketSize - partial_.size());
+    partial_.insert(partial_.end(), data, data + n);
+    data += n;
+    size -= n;
+    if (partial_.size() < kPacketSize) {
+      return;
+    }
+    queue_.insert(queue_.end(), partial_.begin(), partial_.end());
+    partial_.clear();
+  }
+  const size_t whole = size / kPacketSize * kPacketSize;
+  queue_.insert(queue_.end(), data, data + whole);
+  partial_.assign(data + whole, data + size);
+
+  const size_t queued = (queue_.size() - queue_head_) / kPacketSize;
+  queue_packets_.store(queued, std::memory_order_relaxed);
+  AtomicMax(peak_queue_packets_, queued);
+  if (!scheduled_) {
+    cv_.notify_all();  // Leave idle
+  }
+}
+
+void TsPacer::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  queue_.clear();
+  queue_head_ = 0;
+  partial_.clear();
+  scheduled_ = false;
+  pcr_lines_.clear();
+  queue_packets_.store(0, std::memory_order_relaxed);
+}
+
+TsPacerStats TsPacer::GetStats() const {
+  TsPacerStats stats;
+  stats.rate_bps = rate_bps_;
+  stats.packets_sent = packets_sent_.load(std::memory_order_relaxed);
+  stats.null_packets = null_packets_.load(std::memory_order_relaxed);
+  stats.overrun_packets = overrun_packets_.load(std::memory_order_relaxed);
+  stats.pcr_restamps = pcr_restamps_.load(std::memory_order_relaxed);
+  stats.pcr_discontinuities = pcr_discontinuities_.load(std::memory_order_relaxed);
+  stats.schedule_resets = schedule_resets_.load(std::memory_order_relaxed);
+  stats.queue_packets = queue_packets_.load(std::memory_order_relaxed);
+  stats.peak_queue_packets = peak_queue_packets_.load(std::memory_order_relaxed);
+  stats.max_burst_packets = max_burst_packets_.load(std::memory_order_relaxed);
+  stats.last_late_us = last_late_us_.load(std::memory_order_relaxed);
+  stats.max_late_us = max_late_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+int64_t TsPacer::SlotUs(uint64_t n) const {
+  // Split so the products stay within 64 bits over days of output
+  const uint64_t rate = static_cast<uint64_t>(rate_bps_);
+  return static_cast<int64_t>((n / rate) * kPacketBitsUs + (n % rate) * kPacketBitsUs / rate);
+}
+
+void TsPacer::PaceLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    if (!scheduled_) {
+      // Idle until the muxer produces something
+      cv_.wait(lock, [this] { return stopping_ || queue_.size() > queue_head_; });
+      if (stopping_) {
+        break;
+      }
+      scheduled_ = true;
+      schedule_start_us_ = clock_->now_utc_us();
+      slots_sent_ = 0;
+    }
+
+    // Wait for the next burst's worth of tokens; writing ahead, until lead_us
+    // before the burst's first slot, which go out with their launch times
+    const int64_t lead_us =
+        timed_write_ ? lead_us_.load(std::memory_order_relaxed) + SlotUs(burst_packets_) : 0;
+    const int64_t due_us = schedule_start_us_ + SlotUs(slots_sent_ + burst_packets_);
+    if (clock_->is_fake()) {
+      cv_.wait_for(lock, std::chrono::milliseconds(1));  // Test clocks advance on their own
+    } else {
+      lock.unlock();
+      clock_->WaitUntilUtcUs(due_us - lead_us);
+      lock.lock();
+    }
+    if (stopping_ || !scheduled_) {
+      continue;
+    }
+
+    const int64_t now_us = clock_->now_utc_us() + lead_us;
+    if (now_us < due_us) {
+      continue;
+    }
+    int64_t late_us = now_us - due_us;
+    if (late_us > kStallResetUs) {
+      // Too far behind to catch up at the line rate: restart the schedule
+      schedule_start_us_ = now_us - SlotUs(burst_packets_);
+      slots_sent_ = 0;
+      late_us = 0;
+      schedule_resets_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Every slot due by now, plus the backlog above the limit
+    uint64_t slots = burst_packets_;
+    while (schedule_start_us_ + SlotUs(slots_sent_ + slots + 1) <= now_us) {
+      ++slots;
+    }
+    const size_t queued = (queue_.size() - queue_head_) / kPacketSize;
+    const size_t overrun = queued > queue_limit_packets_ + slots
+                               ? queued - queue_limit_packets_ - static_cast<size_t>(slots)
+                               : 0;
+    const size_t count = static_cast<size_t>(slots) + overrun;
+    TakeLocked(count, slots_sent_);
+    slots_sent_ += slots;
+    overrun_packets_.fetch_add(overrun, std::memory_order_relaxed);
+
+    lock.unlock();
+    WriteOut();
+    lock.lock();
+
+    AtomicMax(max_burst_packets_, count);
+    last_late_us_.store(late_us, std::memory_order_relaxed);
+    if (late_us > max_late_us_.load(std::memory_order_relaxed)) {
+      max_late_us_.store(late_us, std::memory_order_relaxed);
+    }
+  }
+
+  // Stopping: the backlog goes out as is, without stuffing
+  const size_t queued = (queue_.size() - queue_head_) / kPacketSize;
+  if (queued > 0) {
+    if (!scheduled_) {
+      schedule_start_us_ = clock_->now_utc_us();
+      slots_sent_ = 0;
+    }
+    TakeLocked(queued, slots_sent_);
+    lock.unlock();
+    WriteOut();
+  }
+}
+
+void TsPacer::WriteOut() {
+  if (timed_write_) {
+    timed_write_(opaque_, out_.data(), static_cast<int>(out_.size()), out_slot_us_.data());
+  } else {
+    write_(opaque_, out_.data(), static_cast<int>(out_.size()));
+  }
+}
+
+void TsPacer::TakeLocked(size_t count, uint64_t first_slot) {
+  out_.resize(count * kPacketSize);
+  if (timed_write_) {
+    out_slot_us_.resize(count);
+  }
+  size_t sent = 0;
+  size_t nulls = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint8_t* packet = out_.data() + i * kPacketSize;
+    const int64_t slot_us = schedule_start_us_ + SlotUs(first_slot + i);
+    if (timed_write_) {
+      out_slot_us_[i] = slot_us;
+    }
+    if (queue_.size() - queue_head_ >= kPacketSize) {
+      std::memcpy(packet, queue_.data() + queue_head_, kPacketSize);
+      queue_head_ += kPacketSize;
+      RestampPcr(packet, slot_us);
+      ++sent;
+    } else {
+      WriteNullPacket(packet);
+      ++nulls;
+    }
+  }
+
+  // Reclaim the sent front of the backlog once it is most of the buffer
+  if (queue_head_ == queue_.size()) {
+    queue_.clear();
+    queue_head_ = 0;
+  } else if (queue_head_ > queue_.size() / 2) {
+    queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(queue_head_));
+    queue_head_ = 0;
+  }
+  queue_packets_.store((queue_.size() - queue_head_) / kPacketSize, std::memory_order_relaxed);
+  packets_sent_.fetch_add(sent, std::memory_order_relaxed);
+  null_packets_.fetch_add(nulls, std::memory_order_relaxed);
+}
+
+void TsPacer::RestampPcr(uint8_t* packet, int64_t slot_us) {
+  const bool has_adaptation = (packet[3] & 0x20) != 0;
+  if (packet[0] != 0x47 || !has_adaptation || packet[4] < 7 || (packet[5] & 0x10) == 0) {
+    return;
+  }
+  const int64_t base = (static_cast<int64_t>(packet[6]) << 25) |
+                       (static_cast<int64_t>(packet[7]) << 17) |
+                       (static_cast<int64_t>(packet[8]) << 9) |
+                       (static_cast<int64_t>(packet[9]) << 1) | (packet[10] >> 7);
+  const int64_t extension = ((packet[10] & 0x01) << 8) | packet[11];
+  const int64_t muxed_27m = base * 300 + extension;
+  const int64_t slot_27m = slot_us * 27;
+
+  const uint16_t pid = static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+  auto line = std::find_if(pcr_lines_.begin(), pcr_lines_.end(),
+                           [pid](const PcrLine& l) { return l.pid == pid; });
+  if (line == pcr_lines_.end()) {
+    pcr_lines_.push_back({pid, muxed_27m - slot_27m});
+    line = pcr_lines_.end() - 1;
+  }
+  int64_t pcr_27m = slot_27m + line->offset_27m;
+  const int64_t error_27m = pcr_27m - muxed_27m;
+  if (error_27m > kPcrReanchorUs * 27 || error_27m < -kPcrReanchorUs * 27) {
+    line->offset_27m = muxed_27m - slot_27m;
+    pcr_27m = muxed_27m;
+    packet[5] |= 0x80;  // discontinuity_indicator
+    pcr_discontinuities_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  pcr_27m = ((pcr_27m % kPcrWrap27m) + kPcrWrap27m) % kPcrWrap27m;
+  const int64_t new_base = pcr_27m / 300;
+  const int64_t new_extension = pcr_27m % 300;
+  packet[6] = static_cast<uint8_t>(new_base >> 25);
+  packet[7] = static_cast<uint8_t>(new_base >> 17);
+  packet[8] = static_cast<uint8_t>(new_base >> 9);
+  packet[9] = static_cast<uint8_t>(new_base >> 1);
+  packet[10] = static_cast<uint8_t>(((new_base & 1) << 7) | 0x7E | (new_extension >> 8));
+  packet[11] = static_cast<uint8_t>(new_extension);
+  pcr_restamps_.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
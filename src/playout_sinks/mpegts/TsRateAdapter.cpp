@@ -0,0 +1,131 @@
+// Repository: Retrovue-playout
+// Component: TS Rate Adapter
+// Purpose: Fits the video bitrate to the throughput the slowest TCP client sustains.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsRateAdapter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr double kMuxOverhead = 1.03;  // TS and PES headers on top of the elementary streams
+constexpr double kLossCut = 0.7;       // At most this much of the rate once the fanout lost data
+
+}  // namespace
+
+TsRateAdapter::TsRateAdapter(int64_t max_bps, int64_t min_bps, int64_t overhead_bps)
+    : max_bps_(max_bps),
+      min_bps_(std::min(min_bps, max_bps)),
+      overhead_bps_(overhead_bps),
+      video_bps_(max_bps),
+      video_bps_stat_(max_bps) {}
+
+int64_t TsRateAdapter::Sample(const TsFanoutStats& fanout, int64_t elapsed_us) {
+  const uint64_t losses = fanout.chunks_dropped + fanout.gop_resyncs + fanout.evictions;
+  if (!have_baseline_) {
+    have_baseline_ = true;
+    last_published_ = fanout.bytes_published;
+    last_queued_ = fanout.max_queued_bytes;
+    last_losses_ = losses;
+    return 0;
+  }
+  const auto published = static_cast<int64_t>(fanout.bytes_published - last_published_);
+  const int64_t growth =
+      static_cast<int64_t>(fanout.max_queued_bytes) - static_cast<int64_t>(last_queued_);
+  const bool lost = losses != last_losses_;
+  last_published_ = fanout.bytes_published;
+  last_queued_ = fanout.max_queued_bytes;
+  last_losses_ = losses;
+  if (elapsed_us <= 0) {
+    return 0;
+  }
+
+  // What the slowest client took off its queue: everything published,
+  // less what piled up behind it
+  const double published_bps = static_cast<double>(published) * 8 * 1'000'000 / elapsed_us;
+  const double backlog_bytes = static_cast<double>(fanout.max_queued_bytes);
+  const bool backlogged = backlog_bytes * 8 * 1000 > published_bps * kBacklogMs;
+  const bool congested =
+      lost || (growth > 0 && backlogged && fanout.send_buffer_ratio >= kFullSendBuffer);
+  if (congested) {
+    clear_samples_ = 0;
+    congested_samples_.fetch_add(1, std::memory_order_relaxed);
+    const double throughput_bps =
+        static_cast<double>(std::max<int64_t>(published - growth, 0)) * 8 * 1'000'000 /
+        elapsed_us;
+    throughput_bps_.store(static_cast<int64_t>(throughput_bps), std::memory_order_relaxed);
+    int64_t target = VideoRate(kHeadroom * throughput_bps - backlog_bytes * 8 * 1000 / kDrainMs);
+    if (lost) {
+      // Dropped chunks shrink the queue, so the estimate runs high
+      const int64_t cut = std::max<int64_t>(min_bps_, std::llround(video_bps_ * kLossCut));
+      target = std::min(target, cut);
+    }
+    if (target >= video_bps_) {
+      return 0;
+    }
+    const int64_t applied = Apply(target);
+    if (applied > 0) {
+      decreases_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return applied;
+  }
+
+  if (backlogged || video_bps_ >= max_bps_) {
+    clear_samples_ = 0;
+    return 0;
+  }
+  if (++clear_samples_ < kRecoverSamples) {
+    return 0;
+  }
+  clear_samples_ = 0;
+  const int64_t applied =
+      Apply(std::min<int64_t>(max_bps_, std::llround(video_bps_ * kStepUp)));
+  if (applied > 0) {
+    increases_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return applied;
+}
+
+int64_t TsRateAdapter::Reset() {
+  have_baseline_ = false;
+  clear_samples_ = 0;
+  if (video_bps_ >= max_bps_) {
+    return 0;
+  }
+  video_bps_ = max_bps_;
+  video_bps_stat_.store(max_bps_, std::memory_order_relaxed);
+  return max_bps_;
+}
+
+TsRateAdapterStats TsRateAdapter::GetStats() const {
+  TsRateAdapterStats stats;
+  stats.video_bps = video_bps_stat_.load(std::memory_order_relaxed);
+  stats.throughput_bps = throughput_bps_.load(std::memory_order_relaxed);
+  stats.decreases = decreases_.load(std::memory_order_relaxed);
+  stats.increases = increases_.load(std::memory_order_relaxed);
+  stats.congested_samples = congested_samples_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+int64_t TsRateAdapter::VideoRate(double total_bps) const {
+  const auto video = static_cast<int64_t>(total_bps / kMuxOverhead) - overhead_bps_;
+  return std::clamp(video, min_bps_, max_bps_);
+}
+
+int64_t TsRateAdapter::Apply(int64_t video_bps) {
+  // Small steps are not worth reconfiguring the encoder for, except the
+  // last one back to the configured rate
+  const int64_t change = std::abs(video_bps - video_bps_);
+  if (change == 0 || (video_bps != max_bps_ && change < video_bps_ * kMinChange)) {
+    return 0;
+  }
+  video_bps_ = video_bps;
+  video_bps_stat_.store(video_bps, std::memory_order_relaxed);
+  return video_bps;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,117 @@
+// Repository: Retrovue-playout
+// Component: TS Slab Ring
+// Purpose: Lock-free single-producer queue of muxed TS bytes in recycled slabs.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsSlabRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace retrovue::playout_sinks::mpegts {
+
+TsSlabRing::TsSlabRing(size_t slab_bytes, size_t capacity_bytes)
+    : slab_bytes_(std::max<size_t>(slab_bytes / kPacketSize, 1) * kPacketSize),
+      slabs_(std::max<size_t>(capacity_bytes / slab_bytes_, 2)) {
+  for (SlabStorage& slab : slabs_) {
+    slab.bytes.resize(slab_bytes_);
+    slab.view.data = slab.bytes.data();
+  }
+}
+
+bool TsSlabRing::Write(const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return true;
+  }
+  const size_t bytes = size;
+  const uint64_t write = write_seq_.load(std::memory_order_relaxed);
+  const uint64_t read = read_seq_.load(std::memory_order_acquire);  // Slabs handed back
+  const size_t needed = (size + slab_bytes_ - 1) / slab_bytes_;
+  if (needed > slabs_.size() - static_cast<size_t>(write - read)) {
+    writes_dropped_.fetch_add(1, std::memory_order_relaxed);
+    bytes_dropped_.fetch_add(size, std::memory_order_relaxed);
+    return false;
+  }
+
+  for (size_t i = 0; i < needed; ++i) {
+    SlabStorage& slab = slabs_[(write + i) % slabs_.size()];
+    const size_t n = std::min(size, slab_bytes_);
+    std::memcpy(slab.bytes.data(), data, n);
+    slab.view.size = n;
+    data += n;
+    size -= n;
+  }
+  const size_t queued = queued_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  if (queued > peak_queued_bytes_.load(std::memory_order_relaxed)) {
+    peak_queued_bytes_.store(queued, std::memory_order_relaxed);
+  }
+  bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+
+  write_seq_.store(write + needed, std::memory_order_release);
+  signal_.fetch_add(1, std::memory_order_release);
+  signal_.notify_one();
+  return true;
+}
+
+const TsSlabRing::Slab* TsSlabRing::Front() const {
+  const uint64_t read = read_seq_.load(std::memory_order_relaxed);
+  if (read == write_seq_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &slabs_[read % slabs_.size()].view;
+}
+
+void TsSlabRing::Pop() { Pop(1); }
+
+size_t TsSlabRing::Peek(const Slab** slabs, size_t max) const {
+  const uint64_t read = read_seq_.load(std::memory_order_relaxed);
+  const size_t available =
+      static_cast<size_t>(write_seq_.load(std::memory_order_acquire) - read);
+  const size_t count = std::min(available, max);
+  for (size_t i = 0; i < count; ++i) {
+    slabs[i] = &slabs_[(read + i) % slabs_.size()].view;
+  }
+  return count;
+}
+
+void TsSlabRing::Pop(size_t count) {
+  const uint64_t read = read_seq_.load(std::memory_order_relaxed);
+  size_t bytes = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bytes += slabs_[(read + i) % slabs_.size()].view.size;
+  }
+  queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+  read_seq_.store(read + count, std::memory_order_release);
+}
+
+void TsSlabRing::Discard() {
+  while (Front() != nullptr) {
+    Pop();
+  }
+}
+
+void TsSlabRing::Wait() {
+  const uint32_t seen = signal_.load(std::memory_order_acquire);
+  if (Front() != nullptr) {
+    return;
+  }
+  signal_.wait(seen, std::memory_order_acquire);
+}
+
+void TsSlabRing::Wake() {
+  signal_.fetch_add(1, std::memory_order_release);
+  signal_.notify_one();
+}
+
+TsSlabRingStats TsSlabRing::GetStats() const {
+  TsSlabRingStats stats;
+  stats.capacity_bytes = slabs_.size() * slab_bytes_;
+  stats.queued_bytes = queued_bytes_.load(std::memory_order_relaxed);
+  stats.peak_queued_bytes = peak_queued_bytes_.load(std::memory_order_relaxed);
+  stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  stats.writes_dropped = writes_dropped_.load(std::memory_order_relaxed);
+  stats.bytes_dropped = bytes_dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,429 @@
+// Repository: Retrovue-playout
+// Component: TS SRT Output
+// Purpose: Sends MPEG-TS over an SRT contribution link (caller or listener).
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsSrtOutput.hpp"
+
+#ifdef RETROVUE_SRT_AVAILABLE
+#include <srt/srt.h>
+#endif
+
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace retrovue::playout_sinks::mpegts {
+
+#ifdef RETROVUE_SRT_AVAILABLE
+
+namespace {
+
+bool SetFlag(SRTSOCKET sock, SRT_SOCKOPT option, const void* value, int size, const char* name) {
+  if (srt_setsockflag(sock, option, value, size) == SRT_ERROR) {
+    std::cerr << "[TsSrtOutput] Failed to set " << name << ": " << srt_getlasterror_str()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Resolves host:port; an empty host with passive = every local IPv4 address.
+bool Resolve(const std::string& host, int port, bool passive, sockaddr_storage* addr,
+             int* length) {
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = host.empty() ? AF_INET : AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  struct addrinfo* result = nullptr;
+  const std::string service = std::to_string(port);
+  const int error =
+      getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &result);
+  if (error != 0 || result == nullptr) {
+    std::cerr << "[TsSrtOutput] Failed to resolve " << host << ":" << port << ": "
+              << gai_strerror(error) << std::endl;
+    return false;
+  }
+  std::memcpy(addr, result->ai_addr, result->ai_addrlen);
+  *length = static_cast<int>(result->ai_addrlen);
+  freeaddrinfo(result);
+  return true;
+}
+
+}  // namespace
+
+#endif  // RETROVUE_SRT_AVAILABLE
+
+TsSrtOutput::TsSrtOutput(const SrtOutputConfig& config)
+    : config_(config), ring_(kPayloadSize, config.queue_bytes) {}
+
+TsSrtOutput::~TsSrtOutput() { Close(); }
+
+bool TsSrtOutput::Open() {
+  if (open_) {
+    return true;
+  }
+#ifndef RETROVUE_SRT_AVAILABLE
+  std::cerr << "[TsSrtOutput] Built without SRT support (RETROVUE_SRT_AVAILABLE)" << std::endl;
+  return false;
+#else
+  if (config_.port <= 0 || config_.port > 65535) {
+    std::cerr << "[TsSrtOutput] Invalid port: " << config_.port << std::endl;
+    return false;
+  }
+  if (!config_.listener && config_.host.empty()) {
+    std::cerr << "[TsSrtOutput] Caller mode needs a remote host" << std::endl;
+    return false;
+  }
+  if (!config_.passphrase.empty() &&
+      (config_.passphrase.size() < 10 || config_.passphrase.size() > 79)) {
+    std::cerr << "[TsSrtOutput] Passphrase must be 10-79 characters" << std::endl;
+    return false;
+  }
+  if (config_.key_length != 0 && config_.key_length != 16 && config_.key_length != 24 &&
+      config_.key_length != 32) {
+    std::cerr << "[TsSrtOutput] Invalid key length: " << config_.key_length << std::endl;
+    return false;
+  }
+  if (config_.latency_ms < 0) {
+    std::cerr << "[TsSrtOutput] Invalid latency: " << config_.latency_ms << std::endl;
+    return false;
+  }
+
+  if (srt_startup() < 0) {
+    std::cerr << "[TsSrtOutput] Failed to start SRT: " << srt_getlasterror_str() << std::endl;
+    return false;
+  }
+  eid_ = srt_epoll_create();
+  if (eid_ < 0) {
+    std::cerr << "[TsSrtOutput] Failed to create SRT epoll: " << srt_getlasterror_str()
+              << std::endl;
+    srt_cleanup();
+    return false;
+  }
+
+  if (config_.listener) {
+    sockaddr_storage addr;
+    int length = 0;
+    bool ok = Resolve(config_.host, config_.port, true, &addr, &length);
+    if (ok) {
+      listen_sock_ = srt_create_socket();
+      ok = listen_sock_ != SRT_INVALID_SOCK && ApplyOptions(listen_sock_, false);
+    }
+    if (ok && (srt_bind(listen_sock_, reinterpret_cast<sockaddr*>(&addr), length) == SRT_ERROR ||
+               srt_listen(listen_sock_, 1) == SRT_ERROR)) {
+      std::cerr << "[TsSrtOutput] Failed to listen on port " << config_.port << ": "
+                << srt_getlasterror_str() << std::endl;
+      ok = false;
+    }
+    if (!ok) {
+      if (listen_sock_ != SRT_INVALID_SOCK) {
+        srt_close(listen_sock_);
+        listen_sock_ = SRT_INVALID_SOCK;
+      }
+      srt_epoll_release(eid_);
+      eid_ = -1;
+      srt_cleanup();
+      return false;
+    }
+  }
+
+  ring_.Discard();
+  {
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    link_ = TsSrtOutputStats{};
+    closed_retransmits_ = 0;
+    closed_packets_lost_ = 0;
+    closed_sender_drops_ = 0;
+  }
+  connections_.store(0, std::memory_order_relaxed);
+  bytes_sent_.store(0, std::memory_order_relaxed);
+  messages_sent_.store(0, std::memory_order_relaxed);
+  connected_.store(false, std::memory_order_release);
+  stop_.store(false, std::memory_order_release);
+  connecting_ = false;
+  next_connect_ = std::chrono::steady_clock::time_point{};
+  open_ = true;
+  link_thread_ = std::thread(&TsSrtOutput::LinkLoop, this);
+
+  std::cout << "[TsSrtOutput] " << (config_.listener ? "Listening on " : "Calling ")
+            << (config_.host.empty() ? "*" : config_.host) << ":" << config_.port
+            << " (latency " << config_.latency_ms << " ms"
+            << (config_.passphrase.empty() ? "" : ", encrypted") << ")" << std::endl;
+  return true;
+#endif  // RETROVUE_SRT_AVAILABLE
+}
+
+void TsSrtOutput::Close() {
+  if (!open_) {
+    return;
+  }
+  stop_.store(true, std::memory_order_release);
+  ring_.Wake();
+  if (link_thread_.joinable()) {
+    link_thread_.join();
+  }
+#ifdef RETROVUE_SRT_AVAILABLE
+  if (listen_sock_ != SRT_INVALID_SOCK) {
+    srt_close(listen_sock_);
+    listen_sock_ = SRT_INVALID_SOCK;
+  }
+  if (eid_ >= 0) {
+    srt_epoll_release(eid_);
+    eid_ = -1;
+  }
+  srt_cleanup();
+#endif
+  open_ = false;
+}
+
+bool TsSrtOutput::Send(const uint8_t* data, size_t size) {
+  if (!connected_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  return ring_.Write(data, size);
+}
+
+bool TsSrtOutput::Send(const struct iovec* parts, size_t count) {
+  bool ok = true;
+  for (size_t i = 0; i < count; ++i) {
+    ok = Send(static_cast<const uint8_t*>(parts[i].iov_base), parts[i].iov_len) && ok;
+  }
+  return ok;
+}
+
+TsSrtOutputStats TsSrtOutput::GetStats() const {
+  TsSrtOutputStats stats;
+  {
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    stats = link_;
+  }
+  stats.connected = connected_.load(std::memory_order_acquire);
+  stats.connections = connections_.load(std::memory_order_relaxed);
+  stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  stats.messages_sent = messages_sent_.load(std::memory_order_relaxed);
+  stats.queue_drops = ring_.GetStats().writes_dropped;
+  return stats;
+}
+
+#ifdef RETROVUE_SRT_AVAILABLE
+
+void TsSrtOutput::LinkLoop() {
+  while (!stop_.load(std::memory_order_acquire)) {
+    if (peer_sock_ == SRT_INVALID_SOCK || connecting_) {
+      if (!(config_.listener ? AcceptPeer() : ConnectPeer())) {
+        continue;
+      }
+      // Start from live data: anything queued before the connection is stale
+      ring_.Discard();
+      connections_.fetch_add(1, std::memory_order_relaxed);
+      next_stats_ = std::chrono::steady_clock::now();
+      connected_.store(true, std::memory_order_release);
+    }
+
+    if (std::chrono::steady_clock::now() >= next_stats_) {
+      next_stats_ = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(std::max<int64_t>(config_.stats_interval_ms, 1));
+      SampleStats();
+    }
+
+    const TsSlabRing::Slab* slab = ring_.Front();
+    if (slab == nullptr) {
+      ring_.Wait();
+      continue;
+    }
+    const bool sent = SendSlab(*slab);
+    ring_.Pop();
+    if (!sent) {
+      DropPeer("send failed");
+    }
+  }
+  if (peer_sock_ != SRT_INVALID_SOCK) {
+    DropPeer(nullptr);
+  }
+}
+
+bool TsSrtOutput::ConnectPeer() {
+  if (!connecting_) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_connect_) {
+      std::this_thread::sleep_for(
+          std::min<std::chrono::steady_clock::duration>(next_connect_ - now,
+                                                        std::chrono::milliseconds(kWaitSliceMs)));
+      return false;
+    }
+    next_connect_ = now + std::chrono::milliseconds(kReconnectDelayMs);
+
+    sockaddr_storage addr;
+    int length = 0;
+    if (!Resolve(config_.host, config_.port, false, &addr, &length)) {
+      return false;
+    }
+    peer_sock_ = srt_create_socket();
+    if (peer_sock_ == SRT_INVALID_SOCK || !ApplyOptions(peer_sock_, true) ||
+        srt_connect(peer_sock_, reinterpret_cast<sockaddr*>(&addr), length) == SRT_ERROR) {
+      std::cerr << "[TsSrtOutput] Failed to call " << config_.host << ":" << config_.port
+                << ": " << srt_getlasterror_str() << std::endl;
+      if (peer_sock_ != SRT_INVALID_SOCK) {
+        srt_close(peer_sock_);
+        peer_sock_ = SRT_INVALID_SOCK;
+      }
+      return false;
+    }
+    connecting_ = true;
+  }
+
+  WaitEvents(peer_sock_, SRT_EPOLL_OUT | SRT_EPOLL_ERR, kWaitSliceMs);
+  const SRT_SOCKSTATUS state = srt_getsockstate(peer_sock_);
+  if (state == SRTS_CONNECTED) {
+    connecting_ = false;
+    std::cout << "[TsSrtOutput] Connected to " << config_.host << ":" << config_.port
+              << std::endl;
+    return true;
+  }
+  if (state == SRTS_INIT || state == SRTS_OPENED || state == SRTS_CONNECTING) {
+    return false;  // Still handshaking
+  }
+  std::cerr << "[TsSrtOutput] Call to " << config_.host << ":" << config_.port
+            << " failed: " << srt_rejectreason_str(srt_getrejectreason(peer_sock_))
+            << std::endl;
+  srt_close(peer_sock_);
+  peer_sock_ = SRT_INVALID_SOCK;
+  connecting_ = false;
+  return false;
+}
+
+bool TsSrtOutput::AcceptPeer() {
+  if (WaitEvents(listen_sock_, SRT_EPOLL_IN | SRT_EPOLL_ERR, kWaitSliceMs) == 0) {
+    return false;
+  }
+  sockaddr_storage addr;
+  int length = sizeof(addr);
+  const SRTSOCKET peer = srt_accept(listen_sock_, reinterpret_cast<sockaddr*>(&addr), &length);
+  if (peer == SRT_INVALID_SOCK) {
+    if (srt_getlasterror(nullptr) != SRT_EASYNCRCV) {
+      std::cerr << "[TsSrtOutput] Accept failed: " << srt_getlasterror_str() << std::endl;
+    }
+    return false;
+  }
+  const bool blocking = false;
+  SetFlag(peer, SRTO_SNDSYN, &blocking, sizeof(blocking), "SRTO_SNDSYN");
+  peer_sock_ = peer;
+
+  char host[NI_MAXHOST] = "?";
+  getnameinfo(reinterpret_cast<sockaddr*>(&addr), static_cast<socklen_t>(length), host,
+              sizeof(host), nullptr, 0, NI_NUMERICHOST);
+  std::cout << "[TsSrtOutput] Caller connected from " << host << std::endl;
+  return true;
+}
+
+bool TsSrtOutput::SendSlab(const TsSlabRing::Slab& slab) {
+  while (!stop_.load(std::memory_order_acquire)) {
+    if (srt_sendmsg2(peer_sock_, reinterpret_cast<const char*>(slab.data),
+                     static_cast<int>(slab.size), nullptr) != SRT_ERROR) {
+      bytes_sent_.fetch_add(slab.size, std::memory_order_relaxed);
+      messages_sent_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (srt_getlasterror(nullptr) != SRT_EASYNCSND) {
+      std::cerr << "[TsSrtOutput] Send failed: " << srt_getlasterror_str() << std::endl;
+      return false;
+    }
+    // Send buffer full: wait for the peer to acknowledge
+    WaitEvents(peer_sock_, SRT_EPOLL_OUT | SRT_EPOLL_ERR, kWaitSliceMs);
+  }
+  return true;  // Closing
+}
+
+int TsSrtOutput::WaitEvents(int sock, int events, int timeout_ms) {
+  if (srt_epoll_add_usock(eid_, sock, &events) == SRT_ERROR) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    return 0;
+  }
+  SRT_EPOLL_EVENT ready[1];
+  const int count = srt_epoll_uwait(eid_, ready, 1, timeout_ms);
+  srt_epoll_remove_usock(eid_, sock);
+  return count > 0 ? ready[0].events : 0;
+}
+
+bool TsSrtOutput::ApplyOptions(int sock, bool caller) {
+  const SRT_TRANSTYPE live = SRTT_LIVE;
+  const bool blocking = false;
+  const int latency = config_.latency_ms;
+  bool ok = SetFlag(sock, SRTO_TRANSTYPE, &live, sizeof(live), "SRTO_TRANSTYPE") &&
+            SetFlag(sock, SRTO_SNDSYN, &blocking, sizeof(blocking), "SRTO_SNDSYN") &&
+            SetFlag(sock, SRTO_RCVSYN, &blocking, sizeof(blocking), "SRTO_RCVSYN") &&
+            SetFlag(sock, SRTO_LATENCY, &latency, sizeof(latency), "SRTO_LATENCY");
+  if (ok && !config_.passphrase.empty()) {
+    ok = SetFlag(sock, SRTO_PASSPHRASE, config_.passphrase.c_str(),
+                 static_cast<int>(config_.passphrase.size()), "SRTO_PASSPHRASE");
+    if (ok && config_.key_length != 0) {
+      ok = SetFlag(sock, SRTO_PBKEYLEN, &config_.key_length, sizeof(config_.key_length),
+                   "SRTO_PBKEYLEN");
+    }
+  }
+  if (ok && caller && !config_.stream_id.empty()) {
+    ok = SetFlag(sock, SRTO_STREAMID, config_.stream_id.c_str(),
+                 static_cast<int>(config_.stream_id.size()), "SRTO_STREAMID");
+  }
+  return ok;
+}
+
+void TsSrtOutput::SampleStats() {
+  SRT_TRACEBSTATS perf;
+  TsSrtOutputStats stats;
+  if (srt_bstats(peer_sock_, &perf, 0) != SRT_ERROR) {
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    link_.retransmits = closed_retransmits_ + static_cast<uint64_t>(perf.pktRetransTotal);
+    link_.packets_lost = closed_packets_lost_ + static_cast<uint64_t>(perf.pktSndLossTotal);
+    link_.sender_drops = closed_sender_drops_ + static_cast<uint64_t>(perf.pktSndDropTotal);
+    link_.rtt_ms = perf.msRTT;
+    link_.send_rate_mbps = perf.mbpsSendRate;
+    link_.send_buffer_bytes = static_cast<size_t>(std::max(perf.byteSndBuf, 0));
+    link_.send_buffer_ms = perf.msSndBuf;
+    const double capacity = static_cast<double>(perf.byteSndBuf) + perf.byteAvailSndBuf;
+    link_.send_buffer_fill = capacity > 0 ? perf.byteSndBuf / capacity : 0.0;
+  }
+  if (config_.on_stats) {
+    config_.on_stats(GetStats());
+  }
+}
+
+void TsSrtOutput::DropPeer(const char* reason) {
+  connected_.store(false, std::memory_order_release);
+  if (!connecting_) {
+    SampleStats();
+  }
+  {
+    // The connection's totals carry over; its gauges end with it
+    std::lock_guard<std::mutex> lock(link_mutex_);
+    closed_retransmits_ = link_.retransmits;
+    closed_packets_lost_ = link_.packets_lost;
+    closed_sender_drops_ = link_.sender_drops;
+    link_.rtt_ms = 0.0;
+    link_.send_rate_mbps = 0.0;
+    link_.send_buffer_bytes = 0;
+    link_.send_buffer_ms = 0;
+    link_.send_buffer_fill = 0.0;
+  }
+  srt_close(peer_sock_);
+  peer_sock_ = SRT_INVALID_SOCK;
+  connecting_ = false;
+  ring_.Discard();
+  next_connect_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReconnectDelayMs);
+  if (reason != nullptr) {
+    std::cerr << "[TsSrtOutput] Peer lost (" << reason << "), "
+              << (config_.listener ? "waiting for a new caller" : "reconnecting") << std::endl;
+  }
+  if (config_.on_stats) {
+    config_.on_stats(GetStats());
+  }
+}
+
+#endif  // RETROVUE_SRT_AVAILABLE
+
+}  // namespace retrovue::playout_sinks::mpegts
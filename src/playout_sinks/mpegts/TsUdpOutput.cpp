@@ -0,0 +1,524 @@
+// Repository: Retrovue-playout
+// Component: TS UDP Output
+// Purpose: Sends MPEG-TS over UDP or RTP (unicast/multicast) with optional SMPTE 2022-1 FEC.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsUdpOutput.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <utility>
+
+namespace retrovue::playout_sinks::mpegts {
+
+namespace {
+
+constexpr uint8_t kRtpPayloadTypeMp2t = 33;  // RFC 3551
+constexpr uint8_t kRtpPayloadTypeFec = 96;   // Dynamic
+constexpr int kSendBufferBytes = 1024 * 1024;
+constexpr uint64_t kErrorQueueIntervalSends = 64;  // Checked for missed launches this often
+
+int64_t ClockNs(int clock_id) {
+  struct timespec now;
+  clock_gettime(clock_id, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+void PutBe16(uint8_t* out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value >> 8);
+  out[1] = static_cast<uint8_t>(value);
+}
+
+void PutBe32(uint8_t* out, uint32_t value) {
+  out[0] = static_cast<uint8_t>(value >> 24);
+  out[1] = static_cast<uint8_t>(value >> 16);
+  out[2] = static_cast<uint8_t>(value >> 8);
+  out[3] = static_cast<uint8_t>(value);
+}
+
+}  // namespace
+
+TsUdpOutput::TsUdpOutput(const UdpOutputConfig& config,
+                         std::shared_ptr<retrovue::timing::MasterClock> clock)
+    : config_(config), clock_(std::move(clock)) {}
+
+TsUdpOutput::~TsUdpOutput() { Close(); }
+
+bool TsUdpOutput::Open() {
+  if (fd_ >= 0) {
+    return true;
+  }
+  if (config_.port <= 0 || config_.port > 65535 - 4) {
+    std::cerr << "[TsUdpOutput] Invalid port: " << config_.port << std::endl;
+    return false;
+  }
+  std::memset(&media_addr_, 0, sizeof(media_addr_));
+  media_addr_.sin_family = AF_INET;
+  media_addr_.sin_port = htons(static_cast<uint16_t>(config_.port));
+  if (inet_pton(AF_INET, config_.host.c_str(), &media_addr_.sin_addr) <= 0) {
+    std::cerr << "[TsUdpOutput] Invalid destination address: " << config_.host << std::endl;
+    return false;
+  }
+  column_addr_ = media_addr_;
+  column_addr_.sin_port = htons(static_cast<uint16_t>(config_.port + 2));
+  row_addr_ = media_addr_;
+  row_addr_.sin_port = htons(static_cast<uint16_t>(config_.port + 4));
+
+  fec_enabled_ = config_.fec_columns > 0 || config_.fec_rows > 0;
+  if (fec_enabled_) {
+    const int columns = config_.fec_columns;
+    const int rows = config_.fec_rows;
+    if (!config_.rtp || columns < 1 || columns > 20 || rows < 4 || rows > 20 ||
+        columns * rows > 100) {
+      std::cerr << "[TsUdpOutput] Invalid SMPTE 2022-1 FEC " << columns << "x" << rows
+                << " (needs RTP, L 1-20, D 4-20, L x D <= 100)" << std::endl;
+      return false;
+    }
+  }
+
+  fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd_ < 0) {
+    std::cerr << "[TsUdpOutput] Failed to create socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+  const bool multicast = IN_MULTICAST(ntohl(media_addr_.sin_addr.s_addr));
+  bool ok = true;
+  if (multicast) {
+    const unsigned char ttl = static_cast<unsigned char>(std::clamp(config_.ttl, 1, 255));
+    ok = setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == 0;
+    if (ok && !config_.interface_address.empty()) {
+      struct in_addr interface_addr;
+      if (inet_pton(AF_INET, config_.interface_address.c_str(), &interface_addr) <= 0) {
+        std::cerr << "[TsUdpOutput] Invalid interface address: " << config_.interface_address
+                  << std::endl;
+        Close();
+        return false;
+      }
+      ok = setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &interface_addr,
+                      sizeof(interface_addr)) == 0;
+    }
+  } else {
+    const int ttl = std::clamp(config_.ttl, 1, 255);
+    ok = setsockopt(fd_, IPPROTO_IP, IP_TTL, &ttl, sizeof(ttl)) == 0;
+  }
+  if (!ok) {
+    std::cerr << "[TsUdpOutput] Failed to set TTL/interface: " << strerror(errno) << std::endl;
+    Close();
+    return false;
+  }
+  if (setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &kSendBufferBytes, sizeof(kSendBufferBytes)) < 0) {
+    std::cerr << "[TsUdpOutput] Warning: Failed to set SO_SNDBUF: " << strerror(errno)
+              << std::endl;
+  }
+
+  txtime_active_.store(false, std::memory_order_relaxed);
+  sample_requested_ns_.clear();
+  if (config_.txtime) {
+    txtime_clock_ = config_.txtime_monotonic ? CLOCK_MONOTONIC : CLOCK_TAI;
+    struct sock_txtime txtime {};
+    txtime.clockid = txtime_clock_;
+    txtime.flags = SOF_TXTIME_REPORT_ERRORS;
+    if (setsockopt(fd_, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) < 0) {
+      std::cerr << "[TsUdpOutput] SO_TXTIME unavailable (" << strerror(errno)
+                << "): pacing in user space" << std::endl;
+    } else {
+      txtime_active_.store(true, std::memory_order_relaxed);
+      // Keyed transmit timestamps without the payload; the sampled
+      // datagrams ask for theirs
+      const int timestamping =
+          SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+      if (setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping)) ==
+          0) {
+        sample_requested_ns_.assign(kSampleRing, 0);
+      } else {
+        std::cerr << "[TsUdpOutput] Warning: No transmit timestamps (" << strerror(errno)
+                  << "): launch times are not measured" << std::endl;
+      }
+    }
+  }
+  launch_utc_us_ = 0;
+  media_datagrams_ = 0;
+  samples_requested_ = 0;
+  samples_reported_ = 0;
+  timed_sends_ = 0;
+  early_samples_ = 0;
+
+  // Datagram slots and their message headers, allocated once
+  slots_.assign(kMaxBatch * kSlotSize, 0);
+  iov_.assign(kMaxBatch, {});
+  messages_.assign(kMaxBatch, {});
+  control_.assign(kMaxBatch * kControlSize, 0);
+  sampled_.assign(kMaxBatch, false);
+  for (size_t i = 0; i < kMaxBatch; ++i) {
+    messages_[i].msg_hdr.msg_iov = &iov_[i];
+    messages_[i].msg_hdr.msg_iovlen = 1;
+    messages_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+  }
+  batch_count_ = 0;
+  batch_media_ = 0;
+  batch_media_bytes_ = 0;
+
+  std::random_device random;
+  ssrc_ = random();
+  media_seq_ = static_cast<uint16_t>(random());
+  column_seq_ = 0;
+  row_seq_ = 0;
+
+  if (fec_enabled_) {
+    columns_.assign(static_cast<size_t>(config_.fec_columns), FecAccumulator{});
+    for (FecAccumulator& column : columns_) {
+      column.payload.assign(kMaxPayload, 0);
+    }
+    row_ = FecAccumulator{};
+    row_.payload.assign(kMaxPayload, 0);
+    matrix_index_ = 0;
+  }
+
+  std::cout << "[TsUdpOutput] Sending " << (config_.rtp ? "RTP" : "UDP") << " to "
+            << config_.host << ":" << config_.port << (multicast ? " (multicast)" : "");
+  if (fec_enabled_) {
+    std::cout << " with SMPTE 2022-1 FEC " << config_.fec_columns << "x" << config_.fec_rows
+              << (config_.fec_row ? " (column + row)" : " (column)");
+  }
+  if (TxTimeActive()) {
+    std::cout << ", kernel-paced (SO_TXTIME, "
+              << (config_.txtime_monotonic ? "CLOCK_MONOTONIC" : "CLOCK_TAI") << ")";
+  }
+  std::cout << std::endl;
+  return true;
+}
+
+void TsUdpOutput::Close() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  batch_count_ = 0;
+  batch_media_ = 0;
+  batch_media_bytes_ = 0;
+}
+
+bool TsUdpOutput::Send(const uint8_t* data, size_t size) {
+  struct iovec part;
+  part.iov_base = const_cast<uint8_t*>(data);
+  part.iov_len = size;
+  return Send(&part, 1);
+}
+
+bool TsUdpOutput::Send(const struct iovec* parts, size_t count) {
+  if (fd_ < 0) {
+    return false;
+  }
+  send_failed_ = false;
+  const uint32_t ts = config_.rtp ? static_cast<uint32_t>(clock_->now_utc_us() * 9 / 100) : 0;
+  for (size_t i = 0; i < count; ++i) {
+    QueueMedia(static_cast<const uint8_t*>(parts[i].iov_base), parts[i].iov_len, ts);
+  }
+  FlushBatch();
+  return !send_failed_;
+}
+
+bool TsUdpOutput::Send(const uint8_t* data, size_t size, const int64_t* packet_utc_us) {
+  if (fd_ < 0) {
+    return false;
+  }
+  send_failed_ = false;
+  const bool txtime = TxTimeActive();
+  if (txtime) {
+    const int64_t now_ns = clock_->now_utc_us() * 1000;
+    txtime_offset_ns_ = ClockNs(txtime_clock_) - now_ns;
+    realtime_offset_ns_ = ClockNs(CLOCK_REALTIME) - now_ns;
+  }
+  QueueMedia(data, size, 0, packet_utc_us);
+  launch_utc_us_ = 0;
+  FlushBatch();
+  // Transmit timestamps due back, and now and then launches the qdisc missed
+  if (txtime && (samples_reported_ != samples_requested_ ||
+                 ++timed_sends_ % kErrorQueueIntervalSends == 0)) {
+    DrainErrorQueue();
+  }
+  return !send_failed_;
+}
+
+void TsUdpOutput::QueueMedia(const uint8_t* data, size_t size, uint32_t ts,
+                             const int64_t* packet_utc_us) {
+  size = size / kPacketSize * kPacketSize;
+  const size_t header = config_.rtp ? kRtpHeaderSize : 0;
+  const bool txtime = packet_utc_us && TxTimeActive();
+  size_t packet = 0;
+  while (size > 0) {
+    const size_t n = std::min(size, kMaxPayload);
+    bool sample = false;
+    if (packet_utc_us) {
+      launch_utc_us_ = txtime ? packet_utc_us[packet] : 0;
+      ts = config_.rtp ? static_cast<uint32_t>(packet_utc_us[packet] * 9 / 100) : 0;
+      packet += n / kPacketSize;
+      sample = txtime && !sample_requested_ns_.empty() &&
+               media_datagrams_++ % kTimestampInterval == 0;
+    }
+    uint8_t* slot = NextSlot(&media_addr_, header + n, sample);
+    if (config_.rtp) {
+      WriteRtpHeader(slot, kRtpPayloadTypeMp2t, media_seq_, ts);
+    }
+    std::memcpy(slot + header, data, n);
+    batch_media_++;
+    batch_media_bytes_ += n;
+    if (fec_enabled_) {
+      AccumulateFec(slot + header, n, media_seq_, ts);
+    }
+    media_seq_++;
+    data += n;
+    size -= n;
+  }
+}
+
+uint8_t* TsUdpOutput::NextSlot(const sockaddr_in* destination, size_t size, bool sample) {
+  if (batch_count_ == kMaxBatch) {
+    FlushBatch();
+  }
+  uint8_t* slot = slots_.data() + batch_count_ * kSlotSize;
+  iov_[batch_count_].iov_base = slot;
+  iov_[batch_count_].iov_len = size;
+  messages_[batch_count_].msg_hdr.msg_name = const_cast<sockaddr_in*>(destination);
+  batch_count_++;
+  SetControl(sample);
+  return slot;
+}
+
+void TsUdpOutput::SetControl(bool sample) {
+  const size_t index = batch_count_ - 1;
+  struct msghdr& message = messages_[index].msg_hdr;
+  sampled_[index] = false;
+  if (launch_utc_us_ == 0) {
+    message.msg_control = nullptr;
+    message.msg_controllen = 0;
+    return;
+  }
+  message.msg_control = control_.data() + index * kControlSize;
+  message.msg_controllen = kControlSize;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_TXTIME;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+  const uint64_t launch_ns =
+      static_cast<uint64_t>(std::max<int64_t>(launch_utc_us_ * 1000 + txtime_offset_ns_, 0));
+  std::memcpy(CMSG_DATA(cmsg), &launch_ns, sizeof(launch_ns));
+  size_t length = CMSG_SPACE(sizeof(uint64_t));
+  if (sample) {
+    cmsg = CMSG_NXTHDR(&message, cmsg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SO_TIMESTAMPING;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+    const uint32_t flags = SOF_TIMESTAMPING_TX_SOFTWARE;
+    std::memcpy(CMSG_DATA(cmsg), &flags, sizeof(flags));
+    length += CMSG_SPACE(sizeof(uint32_t));
+    sample_requested_ns_[samples_requested_ % kSampleRing] =
+        launch_utc_us_ * 1000 + realtime_offset_ns_;
+    samples_requested_++;
+    sampled_[index] = true;
+  }
+  message.msg_controllen = length;
+}
+
+bool TsUdpOutput::FlushBatch() {
+  size_t sent = 0;
+  bool ok = true;
+  while (sent < batch_count_) {
+    const int result = sendmmsg(fd_, messages_.data() + sent,
+                                static_cast<unsigned int>(batch_count_ - sent), 0);
+    send_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Unicast with no listener reports ECONNREFUSED; the rest of the
+      // batch is dropped and the next Send() tries again
+      const uint64_t errors =
+          send_errors_.fetch_add(batch_count_ - sent, std::memory_order_relaxed);
+      if (errors == 0 || errors / 1000 != (errors + batch_count_ - sent) / 1000) {
+        std::cerr << "[TsUdpOutput] Send error: " << strerror(errno) << std::endl;
+      }
+      // Timestamp keys count only datagrams the kernel took
+      for (size_t i = sent; i < batch_count_; ++i) {
+        samples_requested_ -= sampled_[i] ? 1 : 0;
+      }
+      ok = false;
+      break;
+    }
+    sent += static_cast<size_t>(result);
+  }
+  if (ok) {
+    datagrams_sent_.fetch_add(batch_media_, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(batch_media_bytes_, std::memory_order_relaxed);
+  } else {
+    send_failed_ = true;
+  }
+  batch_count_ = 0;
+  batch_media_ = 0;
+  batch_media_bytes_ = 0;
+  return ok;
+}
+
+void TsUdpOutput::WriteRtpHeader(uint8_t* header, uint8_t payload_type, uint16_t seq,
+                                 uint32_t ts) {
+  header[0] = 0x80;  // Version 2, no padding, extension or CSRCs
+  header[1] = payload_type & 0x7F;
+  PutBe16(header + 2, seq);
+  PutBe32(header + 4, ts);
+  PutBe32(header + 8, ssrc_);
+}
+
+void TsUdpOutput::Fold(FecAccumulator& fec, const uint8_t* payload, size_t size, uint16_t seq,
+                       uint32_t ts) {
+  if (fec.count == 0) {
+    fec.sn_base = seq;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    fec.payload[i] ^= payload[i];
+  }
+  fec.length_recovery ^= static_cast<uint16_t>(size);
+  fec.pt_recovery ^= kRtpPayloadTypeMp2t;
+  fec.ts_recovery ^= ts;
+  fec.max_length = std::max(fec.max_length, size);
+  fec.count++;
+}
+
+void TsUdpOutput::AccumulateFec(const uint8_t* payload, size_t size, uint16_t seq,
+                                uint32_t ts) {
+  const size_t columns = columns_.size();
+  Fold(columns_[matrix_index_ % columns], payload, size, seq, ts);
+  if (config_.fec_row) {
+    Fold(row_, payload, size, seq, ts);
+    if (row_.count == columns) {
+      QueueFecPacket(row_, &row_addr_, true, &row_seq_);
+    }
+  }
+  if (++matrix_index_ == columns * static_cast<size_t>(config_.fec_rows)) {
+    // Matrix complete: every column has its D packets
+    for (FecAccumulator& column : columns_) {
+      QueueFecPacket(column, &column_addr_, false, &column_seq_);
+    }
+    matrix_index_ = 0;
+  }
+}
+
+void TsUdpOutput::QueueFecPacket(FecAccumulator& fec, const sockaddr_in* destination, bool row,
+                                 uint16_t* seq) {
+  uint8_t* slot = NextSlot(destination, kRtpHeaderSize + kFecHeaderSize + fec.max_length);
+  WriteRtpHeader(slot, kRtpPayloadTypeFec, (*seq)++,
+                 static_cast<uint32_t>(clock_->now_utc_us() * 9 / 100));
+
+  // FEC header (SMPTE 2022-1, after RFC 2733)
+  uint8_t* header = slot + kRtpHeaderSize;
+  PutBe16(header, fec.sn_base);
+  PutBe16(header + 2, fec.length_recovery);
+  header[4] = 0x80 | (fec.pt_recovery & 0x7F);  // E = 1
+  header[5] = 0;                                // Mask (24 bits): unused
+  header[6] = 0;
+  header[7] = 0;
+  PutBe32(header + 8, fec.ts_recovery);
+  header[12] = row ? 0x40 : 0x00;  // N = 0, D (row stream), type 0 (XOR), index 0
+  header[13] = static_cast<uint8_t>(row ? 1 : columns_.size());             // Offset
+  header[14] = static_cast<uint8_t>(row ? columns_.size() : config_.fec_rows);  // NA
+  header[15] = 0;                  // SNBase ext bits
+  std::memcpy(header + kFecHeaderSize, fec.payload.data(), fec.max_length);
+  fec_packets_sent_.fetch_add(1, std::memory_order_relaxed);
+
+  std::memset(fec.payload.data(), 0, fec.max_length);
+  fec.length_recovery = 0;
+  fec.pt_recovery = 0;
+  fec.ts_recovery = 0;
+  fec.max_length = 0;
+  fec.count = 0;
+}
+
+void TsUdpOutput::DrainErrorQueue() {
+  alignas(struct cmsghdr) uint8_t control[256];
+  while (true) {
+    struct msghdr message {};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(fd_, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;  // Empty
+    }
+    const struct scm_timestamping* stamps = nullptr;
+    const struct sock_extended_err* error = nullptr;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&message, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+        stamps = reinterpret_cast<const struct scm_timestamping*>(CMSG_DATA(cmsg));
+      } else if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) {
+        error = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cmsg));
+      }
+    }
+    if (error == nullptr) {
+      continue;
+    }
+    if (error->ee_origin == SO_EE_ORIGIN_TXTIME) {
+      // Dropped by the qdisc: launch time already past (or invalid)
+      const uint64_t missed = txtime_missed_.fetch_add(1, std::memory_order_relaxed);
+      if (missed % 1000 == 0) {
+        std::cerr << "[TsUdpOutput] Launch time missed (" << missed + 1 << " datagrams)"
+                  << std::endl;
+      }
+      continue;
+    }
+    if (error->ee_origin != SO_EE_ORIGIN_TIMESTAMPING || stamps == nullptr) {
+      continue;
+    }
+    const uint32_t key = error->ee_data;
+    samples_reported_ = key + 1;
+    if (samples_requested_ - key - 1 >= kSampleRing) {
+      continue;  // Overwritten by later requests
+    }
+    const int64_t sent_ns =
+        static_cast<int64_t>(stamps->ts[0].tv_sec) * 1'000'000'000 + stamps->ts[0].tv_nsec;
+    const int64_t error_us = (sent_ns - sample_requested_ns_[key % kSampleRing]) / 1000;
+    txtime_samples_.fetch_add(1, std::memory_order_relaxed);
+    txtime_last_error_us_.store(error_us, std::memory_order_relaxed);
+    if (std::abs(error_us) > std::abs(txtime_max_error_us_.load(std::memory_order_relaxed))) {
+      txtime_max_error_us_.store(error_us, std::memory_order_relaxed);
+    }
+
+    // Leaving most of the lead early: nothing on the device honours launch
+    // times, so the caller has to pace
+    if (error_us >= -config_.txtime_lead_us / 2) {
+      early_samples_ = 0;
+    } else if (++early_samples_ == kEarlySamplesToFallBack && TxTimeActive()) {
+      txtime_active_.store(false, std::memory_order_relaxed);
+      std::cerr << "[TsUdpOutput] Datagrams leave " << -error_us
+                << " us before their launch times (no etf/fq qdisc?): pacing in user space"
+                << std::endl;
+    }
+  }
+}
+
+TsUdpOutputStats TsUdpOutput::GetStats() const {
+  TsUdpOutputStats stats;
+  stats.datagrams_sent = datagrams_sent_.load(std::memory_order_relaxed);
+  stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  stats.fec_packets_sent = fec_packets_sent_.load(std::memory_order_relaxed);
+  stats.send_syscalls = send_syscalls_.load(std::memory_order_relaxed);
+  stats.send_errors = send_errors_.load(std::memory_order_relaxed);
+  stats.txtime_active = txtime_active_.load(std::memory_order_relaxed);
+  stats.txtime_missed = txtime_missed_.load(std::memory_order_relaxed);
+  stats.txtime_samples = txtime_samples_.load(std::memory_order_relaxed);
+  stats.txtime_last_error_us = txtime_last_error_us_.load(std::memory_order_relaxed);
+  stats.txtime_max_error_us = txtime_max_error_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::playout_sinks::mpegts
@@ -0,0 +1,313 @@
+// Repository: Retrovue-playout
+// Component: Playlist Producer
+// Purpose: Plays an ordered list of assets gaplessly, pre-opening the next item.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/producers/playlist/PlaylistProducer.h"
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+namespace retrovue::producers::playlist
+{
+
+  namespace
+  {
+    constexpr auto kReadyPollInterval = std::chrono::milliseconds(5);  // Late next item poll
+  } // namespace
+
+  PlaylistProducer::PlaylistProducer(
+      const PlaylistConfig &config,
+      PlaylistItemFactory item_factory,
+      PlaylistEventCallback event_callback)
+      : config_(config),
+        item_factory_(std::move(item_factory)),
+        event_callback_(std::move(event_callback)),
+        next_serial_(0),
+        running_(false),
+        current_index_(0),
+        transitions_(0),
+        late_transitions_(0)
+  {
+  }
+
+  PlaylistProducer::~PlaylistProducer()
+  {
+    stop();
+  }
+
+  void PlaylistProducer::EmitEvent(const std::string &event_type, const std::string &message)
+  {
+    if (event_callback_)
+    {
+      event_callback_(event_type, message);
+    }
+  }
+
+  bool PlaylistProducer::start()
+  {
+    if (running_.load(std::memory_order_acquire) || transition_thread_ || !item_factory_)
+    {
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(event_mutex_);
+      stop_requested_ = false;
+      eof_serial_ = 0;
+    }
+
+    size_t index = 0;
+    {
+      std::lock_guard<std::mutex> lock(items_mutex_);
+      current_ = OpenItem(0);
+      if (!current_.producer)
+      {
+        std::cerr << "[PlaylistProducer] No playable item in playlist of "
+                  << config_.asset_uris.size() << std::endl;
+        return false;
+      }
+      if (!shadow_mode_)
+      {
+        current_.producer->SetShadowDecodeMode(false);
+      }
+      index = current_.index;
+      current_index_.store(index, std::memory_order_release);
+      // Warm the following item while this one plays
+      next_ = OpenItem(index + 1);
+    }
+
+    std::cout << "[PlaylistProducer] Started with " << config_.asset_uris.size()
+              << " items" << std::endl;
+    EmitEvent("item_started", std::to_string(index));
+
+    running_.store(true, std::memory_order_release);
+    transition_thread_ = std::make_unique<std::thread>(&PlaylistProducer::TransitionLoop, this);
+    return true;
+  }
+
+  void PlaylistProducer::stop()
+  {
+    if (!transition_thread_)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(event_mutex_);
+      stop_requested_ = true;
+    }
+    event_cv_.notify_all();
+    if (transition_thread_->joinable())
+    {
+      transition_thread_->join();
+    }
+    transition_thread_.reset();
+
+    Item current;
+    Item next;
+    {
+      std::lock_guard<std::mutex> lock(items_mutex_);
+      current = std::move(current_);
+      next = std::move(next_);
+      current_ = Item();
+      next_ = Item();
+    }
+    if (next.producer)
+    {
+      next.producer->stop();
+    }
+    if (current.producer)
+    {
+      current.producer->stop();
+    }
+    running_.store(false, std::memory_order_release);
+
+    std::cout << "[PlaylistProducer] Stopped after " << transitions_.load(std::memory_order_acquire)
+              << " transitions" << std::endl;
+    EmitEvent("stopped", "");
+  }
+
+  bool PlaylistProducer::isRunning() const
+  {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  void PlaylistProducer::SetShadowDecodeMode(bool enabled)
+  {
+    std::lock_guard<std::mutex> lock(items_mutex_);
+    shadow_mode_ = enabled;
+    if (current_.producer)
+    {
+      current_.producer->SetShadowDecodeMode(enabled);
+    }
+  }
+
+  bool PlaylistProducer::IsShadowDecodeReady() const
+  {
+    std::lock_guard<std::mutex> lock(items_mutex_);
+    return current_.producer && current_.producer->IsShadowDecodeReady();
+  }
+
+  int64_t PlaylistProducer::GetNextPTS() const
+  {
+    std::lock_guard<std::mutex> lock(items_mutex_);
+    return current_.producer ? current_.producer->GetNextPTS() : 0;
+  }
+
+  void PlaylistProducer::AlignPTS(int64_t target_pts)
+  {
+    std::lock_guard<std::mutex> lock(items_mutex_);
+    if (current_.producer)
+    {
+      current_.producer->AlignPTS(target_pts);
+    }
+  }
+
+  size_t PlaylistProducer::GetCurrentIndex() const
+  {
+    return current_index_.load(std::memory_order_acquire);
+  }
+
+  uint64_t PlaylistProducer::GetTransitionCount() const
+  {
+    return transitions_.load(std::memory_order_acquire);
+  }
+
+  uint64_t PlaylistProducer::GetLateTransitionCount() const
+  {
+    return late_transitions_.load(std::memory_order_acquire);
+  }
+
+  PlaylistProducer::Item PlaylistProducer::OpenItem(size_t index)
+  {
+    for (; index < config_.asset_uris.size(); index++)
+    {
+      const std::string &asset_uri = config_.asset_uris[index];
+      const uint64_t serial = next_serial_.fetch_add(1, std::memory_order_relaxed) + 1;
+      std::unique_ptr<ISwitchableProducer> producer = item_factory_(
+          asset_uri, [this, serial](const std::string &event_type, const std::string &message) {
+            OnItemEvent(serial, event_type, message);
+          });
+      if (producer)
+      {
+        // Shadow mode: open, probe and fill the preroll, then hold
+        producer->SetShadowDecodeMode(true);
+        if (producer->start())
+        {
+          Item item;
+          item.producer = std::move(producer);
+          item.index = index;
+          item.serial = serial;
+          return item;
+        }
+      }
+      std::cerr << "[PlaylistProducer] Skipping unplayable item " << index << ": "
+                << asset_uri << std::endl;
+      EmitEvent("error", "Skipped unplayable item " + std::to_string(index));
+    }
+    return Item();
+  }
+
+  void PlaylistProducer::OnItemEvent(uint64_t serial, const std::string &event_type,
+                                     const std::string &message)
+  {
+    if (event_type == "eof")
+    {
+      {
+        std::lock_guard<std::mutex> lock(event_mutex_);
+        eof_serial_ = serial;
+      }
+      event_cv_.notify_all();
+    }
+    else if (event_type == "error")
+    {
+      EmitEvent("error", message);
+    }
+  }
+
+  void PlaylistProducer::TransitionLoop()
+  {
+    while (true)
+    {
+      uint64_t current_serial = 0;
+      {
+        std::lock_guard<std::mutex> lock(items_mutex_);
+        current_serial = current_.serial;
+      }
+      {
+        std::unique_lock<std::mutex> lock(event_mutex_);
+        event_cv_.wait(lock, [&] { return stop_requested_ || eof_serial_ == current_serial; });
+        if (stop_requested_)
+        {
+          return;
+        }
+      }
+
+      // A next item still opening (slow storage, long probe) delays the
+      // boundary instead of letting the buffer run dry on a cold decoder.
+      bool late = false;
+      while (true)
+      {
+        {
+          std::lock_guard<std::mutex> lock(items_mutex_);
+          if (!next_.producer || next_.producer->IsShadowDecodeReady())
+          {
+            break;
+          }
+        }
+        late = true;
+        std::unique_lock<std::mutex> lock(event_mutex_);
+        if (event_cv_.wait_for(lock, kReadyPollInterval, [this] { return stop_requested_; }))
+        {
+          return;
+        }
+      }
+
+      Item retired;
+      size_t index = 0;
+      {
+        std::lock_guard<std::mutex> lock(items_mutex_);
+        if (!next_.producer)
+        {
+          std::cout << "[PlaylistProducer] End of playlist reached" << std::endl;
+          running_.store(false, std::memory_order_release);
+          EmitEvent("eof", "");
+          return;
+        }
+
+        // Same handoff as a preview -> live switch: stop the finished item so
+        // the buffer stays single-producer, then splice the next one's
+        // preroll with PTS continuing from the finished item.
+        const int64_t next_pts = current_.producer->GetNextPTS();
+        current_.producer->stop();
+        next_.producer->AlignPTS(next_pts);
+        if (!shadow_mode_)
+        {
+          next_.producer->SetShadowDecodeMode(false);
+        }
+        retired = std::move(current_);
+        current_ = std::move(next_);
+        next_ = Item();
+        index = current_.index;
+        current_index_.store(index, std::memory_order_release);
+        transitions_.fetch_add(1, std::memory_order_relaxed);
+        if (late)
+        {
+          late_transitions_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+
+      // Teardown (decoder close) and the next open happen off the boundary.
+      retired.producer.reset();
+      std::cout << "[PlaylistProducer] Item " << index << " started" << (late ? " (late)" : "")
+                << std::endl;
+      EmitEvent("item_started", std::to_string(index));
+
+      Item upcoming = OpenItem(index + 1);
+      std::lock_guard<std::mutex> lock(items_mutex_);
+      next_ = std::move(upcoming);
+    }
+  }
+
+} // namespace retrovue::producers::playlist
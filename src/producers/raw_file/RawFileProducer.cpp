@@ -0,0 +1,547 @@
+// Repository: Retrovue-playout
+// Component: Raw File Producer
+// Purpose: Plays pre-decoded YUV420/PCM clips from a memory-mapped file.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/producers/raw_file/RawFileProducer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace retrovue::producers::raw_file
+{
+
+  namespace
+  {
+    constexpr int64_t kMicrosecondsPerSecond = 1'000'000;
+    constexpr size_t kFramePoolHeadroom = 2;        // Slot being filled + slot held by consumer
+    constexpr int64_t kProducerBackoffUs = 10'000;  // 10ms backoff when buffer is full
+
+    bool ValidHeader(const RawClipHeader &header, size_t file_bytes)
+    {
+      if (std::memcmp(header.magic, kRawClipMagic, sizeof(kRawClipMagic)) != 0 ||
+          header.version != kRawClipVersion ||
+          header.header_bytes < sizeof(RawClipHeader) ||
+          header.width == 0 || header.height == 0 ||
+          header.width % 2 != 0 || header.height % 2 != 0 ||
+          header.fps_num == 0 || header.fps_den == 0 ||
+          header.frame_count == 0)
+      {
+        return false;
+      }
+      const uint64_t video_end = header.header_bytes + header.frame_count * RawClipFrameBytes(header);
+      if (video_end > file_bytes)
+      {
+        return false;
+      }
+      if (header.sample_rate == 0)
+      {
+        return true;
+      }
+      const uint64_t audio_bytes = header.audio_samples * header.channels * sizeof(int16_t);
+      return header.channels > 0 && header.audio_offset >= video_end &&
+             header.audio_offset + audio_bytes <= file_bytes;
+    }
+  } // namespace
+
+  size_t RawClipFrameBytes(const RawClipHeader &header)
+  {
+    return static_cast<size_t>(header.width) * header.height * 3 / 2;
+  }
+
+  bool IsRawClip(const std::string &path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kRawClipMagic)] = {};
+    return file.read(magic, sizeof(magic)) &&
+           std::memcmp(magic, kRawClipMagic, sizeof(kRawClipMagic)) == 0;
+  }
+
+  RawClipWriter::~RawClipWriter()
+  {
+    if (file_)
+    {
+      std::fclose(file_);
+    }
+  }
+
+  bool RawClipWriter::Open(const std::string &path, int width, int height, int fps_num,
+                           int fps_den, int sample_rate, int channels)
+  {
+    if (file_ || width <= 0 || height <= 0 || width % 2 != 0 || height % 2 != 0 ||
+        fps_num <= 0 || fps_den <= 0 || (sample_rate > 0 && channels <= 0))
+    {
+      return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+    {
+      std::cerr << "[RawClipWriter] Failed to create: " << path << std::endl;
+      return false;
+    }
+
+    header_ = RawClipHeader{};
+    std::memcpy(header_.magic, kRawClipMagic, sizeof(kRawClipMagic));
+    header_.version = kRawClipVersion;
+    header_.header_bytes = sizeof(RawClipHeader);
+    header_.width = static_cast<uint32_t>(width);
+    header_.height = static_cast<uint32_t>(height);
+    header_.fps_num = static_cast<uint32_t>(fps_num);
+    header_.fps_den = static_cast<uint32_t>(fps_den);
+    header_.sample_rate = static_cast<uint32_t>(std::max(sample_rate, 0));
+    header_.channels = sample_rate > 0 ? static_cast<uint32_t>(channels) : 0;
+    audio_.clear();
+
+    // Placeholder; Finish() rewrites it with the final counts.
+    return std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+  }
+
+  bool RawClipWriter::AppendFrame(const buffer::Frame &frame)
+  {
+    if (!file_ || frame.width != static_cast<int>(header_.width) ||
+        frame.height != static_cast<int>(header_.height) ||
+        frame.format != buffer::PixelFormat::kI420 || frame.data.size() < frame.LayoutBytes())
+    {
+      return false;
+    }
+    // Clips hold packed I420: strided planes are written row by row
+    for (int i = 0; i < 3; ++i)
+    {
+      const size_t row_bytes = buffer::Frame::PlaneRowBytes(frame.format, i, frame.width);
+      const int rows = buffer::Frame::PlaneRows(i, frame.height);
+      if (static_cast<size_t>(frame.Stride(i)) == row_bytes)
+      {
+        if (std::fwrite(frame.Plane(i), row_bytes * rows, 1, file_) != 1)
+        {
+          return false;
+        }
+        continue;
+      }
+      for (int row = 0; row < rows; ++row)
+      {
+        if (std::fwrite(frame.Plane(i) + static_cast<size_t>(row) * frame.Stride(i), row_bytes, 1,
+                        file_) != 1)
+        {
+          return false;
+        }
+      }
+    }
+    header_.frame_count++;
+    return true;
+  }
+
+  void RawClipWriter::AppendAudio(const int16_t *samples, size_t sample_count)
+  {
+    if (header_.channels > 0)
+    {
+      audio_.insert(audio_.end(), samples, samples + sample_count * header_.channels);
+    }
+  }
+
+  bool RawClipWriter::Finish()
+  {
+    if (!file_)
+    {
+      return false;
+    }
+    bool ok = true;
+    if (header_.channels > 0)
+    {
+      header_.audio_offset =
+          header_.header_bytes + header_.frame_count * RawClipFrameBytes(header_);
+      header_.audio_samples = audio_.size() / header_.channels;
+      ok = audio_.empty() ||
+           std::fwrite(audio_.data(), audio_.size() * sizeof(int16_t), 1, file_) == 1;
+    }
+    ok = ok && std::fseek(file_, 0, SEEK_SET) == 0 &&
+         std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    audio_.clear();
+    if (!ok)
+    {
+      std::cerr << "[RawClipWriter] Failed to write clip" << std::endl;
+    }
+    return ok;
+  }
+
+  RawFileProducer::RawFileProducer(
+      const RawProducerConfig &config,
+      buffer::FrameRingBuffer &output_buffer,
+      RawProducerEventCallback event_callback)
+      : config_(config),
+        asset_id_(buffer::InternAsset(config.asset_uri)),
+        output_buffer_(output_buffer),
+        event_callback_(event_callback),
+        running_(false),
+        stop_requested_(false),
+        frames_produced_(0),
+        audio_dropped_(0)
+  {
+  }
+
+  RawFileProducer::~RawFileProducer()
+  {
+    stop();
+  }
+
+  void RawFileProducer::EmitEvent(const std::string &event_type, const std::string &message)
+  {
+    if (event_callback_)
+    {
+      event_callback_(event_type, message);
+    }
+  }
+
+  bool RawFileProducer::start()
+  {
+    if (running_.load(std::memory_order_acquire) || producer_thread_)
+    {
+      return false;
+    }
+    if (!MapClip())
+    {
+      return false;
+    }
+
+    // Reallocate only when the clip geometry differs from the last start();
+    // frames still queued from an old pool keep it alive until released.
+    const size_t frame_bytes = RawClipFrameBytes(header_);
+    if (!frame_pool_ || pool_frame_bytes_ != frame_bytes)
+    {
+      frame_pool_ = buffer::FramePool::Create(output_buffer_.Capacity() + kFramePoolHeadroom,
+                                              frame_bytes);
+      pool_frame_bytes_ = frame_bytes;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      next_frame_ = 0;
+    }
+    PrefaultFrames(0, config_.prefault_frames);
+
+    std::cout << "[RawFileProducer] Started for asset: " << config_.asset_uri << " ("
+              << header_.width << "x" << header_.height << ", " << header_.frame_count
+              << " frames)" << std::endl;
+    // Emitted before the thread exists so they always precede "eof".
+    EmitEvent("ready", "");
+    EmitEvent("started", "");
+
+    stop_requested_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    producer_thread_ = std::make_unique<std::thread>(&RawFileProducer::ProduceLoop, this);
+    return true;
+  }
+
+  void RawFileProducer::stop()
+  {
+    if (!producer_thread_)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      stop_requested_.store(true, std::memory_order_release);
+    }
+    shadow_cv_.notify_all();
+    output_buffer_.WakeWaiters();
+
+    if (producer_thread_->joinable())
+    {
+      producer_thread_->join();
+    }
+    producer_thread_.reset();
+    running_.store(false, std::memory_order_release);
+
+    // Delivered frames are copies, so the mapping can go while they are queued.
+    UnmapClip();
+
+    std::cout << "[RawFileProducer] Stopped. Total frames produced: "
+              << frames_produced_.load(std::memory_order_acquire) << std::endl;
+    EmitEvent("stopped", "");
+  }
+
+  bool RawFileProducer::isRunning() const
+  {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  void RawFileProducer::SetShadowDecodeMode(bool enabled)
+  {
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      shadow_mode_ = enabled;
+    }
+    shadow_cv_.notify_all();
+  }
+
+  bool RawFileProducer::IsShadowDecodeReady() const
+  {
+    // The first frames were paged in by start(); delivery cannot stall on decode.
+    return map_base_ != nullptr && running_.load(std::memory_order_acquire);
+  }
+
+  int64_t RawFileProducer::GetNextPTS() const
+  {
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    return FramePtsUs(next_frame_) + pts_offset_us_;
+  }
+
+  void RawFileProducer::AlignPTS(int64_t target_pts)
+  {
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    pts_offset_us_ = target_pts - FramePtsUs(next_frame_);
+    std::cout << "[RawFileProducer] PTS aligned: offset=" << pts_offset_us_
+              << ", target=" << target_pts << std::endl;
+  }
+
+  RawClipHeader RawFileProducer::GetClipHeader() const
+  {
+    return header_;
+  }
+
+  uint64_t RawFileProducer::GetFramesProduced() const
+  {
+    return frames_produced_.load(std::memory_order_acquire);
+  }
+
+  uint64_t RawFileProducer::GetAudioDropped() const
+  {
+    return audio_dropped_.load(std::memory_order_acquire);
+  }
+
+  void RawFileProducer::ProduceLoop()
+  {
+    const uint64_t prefault = std::max<uint64_t>(config_.prefault_frames, 1);
+    while (!stop_requested_.load(std::memory_order_acquire))
+    {
+      uint64_t index = 0;
+      {
+        // Shadow mode: hold until the switch (or stop).
+        std::unique_lock<std::mutex> lock(shadow_mutex_);
+        shadow_cv_.wait(lock, [this] {
+          return !shadow_mode_ || stop_requested_.load(std::memory_order_acquire);
+        });
+        if (stop_requested_.load(std::memory_order_acquire))
+        {
+          break;
+        }
+        index = next_frame_;
+      }
+
+      if (index >= header_.frame_count)
+      {
+        std::cout << "[RawFileProducer] End of clip reached, all frames emitted" << std::endl;
+        EmitEvent("eof", "");
+        break;
+      }
+
+      // Keep one window of frames paged in ahead of the one being copied.
+      if (index % prefault == 0)
+      {
+        PrefaultFrames(index + prefault, prefault);
+      }
+
+      if (!DeliverFrame(index))
+      {
+        output_buffer_.WaitForSpace(std::chrono::steady_clock::now() +
+                                    std::chrono::microseconds(kProducerBackoffUs));
+      }
+    }
+    running_.store(false, std::memory_order_release);
+  }
+
+  bool RawFileProducer::DeliverFrame(uint64_t index)
+  {
+    if (output_buffer_.IsFull())
+    {
+      return false;
+    }
+    buffer::FrameHandle handle = frame_pool_->Acquire();
+    if (!handle)
+    {
+      return false;  // Every slot is still queued downstream
+    }
+
+    int64_t pts_offset_us = 0;
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      pts_offset_us = pts_offset_us_;
+    }
+
+    // The single copy on this path: page cache -> pooled frame.
+    const size_t frame_bytes = RawClipFrameBytes(header_);
+    buffer::Frame &frame = *handle;
+    frame.width = static_cast<int>(header_.width);
+    frame.height = static_cast<int>(header_.height);
+    frame.data.resize(frame_bytes);
+    std::memcpy(frame.data.data(), map_base_ + header_.header_bytes + index * frame_bytes,
+                frame_bytes);
+    frame.metadata.pts = FramePtsUs(index) + pts_offset_us;
+    frame.metadata.dts = frame.metadata.pts;
+    frame.metadata.duration = static_cast<double>(header_.fps_den) / header_.fps_num;
+    frame.metadata.asset_id = asset_id_;
+    const int64_t pts_us = frame.metadata.pts;
+
+    if (!output_buffer_.Push(std::move(handle)))
+    {
+      return false;
+    }
+    frames_produced_.fetch_add(1, std::memory_order_relaxed);
+
+    if (header_.sample_rate > 0)
+    {
+      const uint64_t first = std::min(FrameAudioStart(index), header_.audio_samples);
+      const uint64_t last = std::min(FrameAudioStart(index + 1), header_.audio_samples);
+      if (last > first)
+      {
+        const size_t sample_bytes = header_.channels * sizeof(int16_t);
+        buffer::AudioFrame audio;
+        audio.sample_rate = static_cast<int>(header_.sample_rate);
+        audio.channels = static_cast<int>(header_.channels);
+        audio.nb_samples = static_cast<int>(last - first);
+        audio.pts_us = pts_us;
+        const uint8_t *pcm = map_base_ + header_.audio_offset + first * sample_bytes;
+        audio.data.assign(pcm, pcm + (last - first) * sample_bytes);
+        if (!output_buffer_.PushAudioFrame(audio))
+        {
+          audio_dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    if (next_frame_ == index)
+    {
+      next_frame_++;
+    }
+    return true;
+  }
+
+  int64_t RawFileProducer::FramePtsUs(uint64_t index) const
+  {
+    if (header_.fps_num == 0)
+    {
+      return 0;
+    }
+    return static_cast<int64_t>(index * kMicrosecondsPerSecond * header_.fps_den /
+                                header_.fps_num);
+  }
+
+  uint64_t RawFileProducer::FrameAudioStart(uint64_t index) const
+  {
+    return index * header_.sample_rate * header_.fps_den / header_.fps_num;
+  }
+
+  bool RawFileProducer::MapClip()
+  {
+    UnmapClip();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(config_.asset_uri.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      std::cerr << "[RawFileProducer] Failed to open: " << config_.asset_uri << std::endl;
+      return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(RawClipHeader)))
+    {
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    void *base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping)
+    {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!base)
+    {
+      std::cerr << "[RawFileProducer] Failed to map: " << config_.asset_uri << std::endl;
+      return false;
+    }
+    map_bytes_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(config_.asset_uri.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      std::cerr << "[RawFileProducer] Failed to open: " << config_.asset_uri << std::endl;
+      return false;
+    }
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(RawClipHeader)))
+    {
+      base = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);  // The mapping holds its own reference to the file
+    if (base == MAP_FAILED)
+    {
+      std::cerr << "[RawFileProducer] Failed to map: " << config_.asset_uri << std::endl;
+      return false;
+    }
+    map_bytes_ = static_cast<size_t>(st.st_size);
+    ::madvise(base, map_bytes_, MADV_SEQUENTIAL);
+#endif
+    map_base_ = static_cast<const uint8_t *>(base);
+
+    std::memcpy(&header_, map_base_, sizeof(header_));
+    if (!ValidHeader(header_, map_bytes_))
+    {
+      std::cerr << "[RawFileProducer] Not a valid raw clip: " << config_.asset_uri << std::endl;
+      UnmapClip();
+      return false;
+    }
+    return true;
+  }
+
+  void RawFileProducer::UnmapClip()
+  {
+    if (map_base_)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(map_base_);
+#else
+      ::munmap(const_cast<uint8_t *>(map_base_), map_bytes_);
+#endif
+    }
+    map_base_ = nullptr;
+    map_bytes_ = 0;
+    header_ = RawClipHeader{};
+  }
+
+  void RawFileProducer::PrefaultFrames(uint64_t first, uint64_t count) const
+  {
+#ifndef _WIN32
+    if (!map_base_ || first >= header_.frame_count || count == 0)
+    {
+      return;
+    }
+    const size_t frame_bytes = RawClipFrameBytes(header_);
+    const uint64_t last = std::min(first + count, header_.frame_count);
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin = header_.header_bytes + first * frame_bytes;
+    const size_t end = header_.header_bytes + last * frame_bytes;
+    begin -= begin % page;  // madvise needs a page-aligned start
+    ::madvise(const_cast<uint8_t *>(map_base_) + begin, end - begin, MADV_WILLNEED);
+#else
+    (void)first;
+    (void)count;
+#endif
+  }
+
+} // namespace retrovue::producers::raw_file
@@ -0,0 +1,420 @@
+// Repository: Retrovue-playout
+// Component: Synthetic Producer
+// Purpose: Load generator that plays a moving test pattern from precomputed frame templates.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/producers/synthetic/SyntheticProducer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+namespace retrovue::producers::synthetic
+{
+
+  namespace
+  {
+    constexpr size_t kFramePoolHeadroom = 2;        // Slot being filled + slot held by consumer
+    constexpr int64_t kProducerBackoffUs = 10'000;  // 10ms backoff when buffer is full
+
+    // 75% colour bars (BT.601 limited range): white, yellow, cyan, green,
+    // magenta, red, blue.
+    constexpr int kBarCount = 7;
+    constexpr uint8_t kBarY[kBarCount] = {180, 162, 131, 112, 84, 65, 35};
+    constexpr uint8_t kBarU[kBarCount] = {128, 44, 156, 72, 184, 100, 212};
+    constexpr uint8_t kBarV[kBarCount] = {128, 142, 44, 58, 198, 212, 114};
+
+    using TemplateKey = std::tuple<int, int, SyntheticComplexity, size_t>;
+
+    bool ValidConfig(const SyntheticProducerConfig &config)
+    {
+      return config.width > 0 && config.height > 0 && config.width % 2 == 0 &&
+             config.height % 2 == 0 && config.target_fps > 0.0 && config.template_count > 0;
+    }
+
+    // Renders template t (of count) of the pattern into a packed I420 frame.
+    std::vector<uint8_t> RenderTemplate(int width, int height, SyntheticComplexity complexity,
+                                        size_t t, size_t count)
+    {
+      const int chroma_width = width / 2;
+      const int chroma_height = height / 2;
+      std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 3 / 2);
+      uint8_t *y_plane = frame.data();
+      uint8_t *u_plane = y_plane + static_cast<size_t>(width) * height;
+      uint8_t *v_plane = u_plane + static_cast<size_t>(chroma_width) * chroma_height;
+
+      // kMotion scrolls the picture one full width per loop, so the last
+      // template leads seamlessly into the first.
+      const int shift = complexity == SyntheticComplexity::kMotion
+                            ? static_cast<int>(t * static_cast<size_t>(width) / count)
+                            : 0;
+      for (int row = 0; row < height; ++row)
+      {
+        uint8_t *dst = y_plane + static_cast<size_t>(row) * width;
+        for (int col = 0; col < width; ++col)
+        {
+          const int x = (col + shift) % width;
+          const int bar = x * kBarCount / width;
+          int luma = kBarY[bar];
+          if (complexity == SyntheticComplexity::kMotion)
+          {
+            // Diagonal ramp on top of the bars, moving with them
+            luma += ((x + row) & 63) - 32;
+          }
+          dst[col] = static_cast<uint8_t>(std::clamp(luma, 16, 235));
+        }
+      }
+      for (int row = 0; row < chroma_height; ++row)
+      {
+        for (int col = 0; col < chroma_width; ++col)
+        {
+          const int x = (col * 2 + shift) % width;
+          const int bar = x * kBarCount / width;
+          u_plane[static_cast<size_t>(row) * chroma_width + col] = kBarU[bar];
+          v_plane[static_cast<size_t>(row) * chroma_width + col] = kBarV[bar];
+        }
+      }
+
+      if (complexity == SyntheticComplexity::kNoise)
+      {
+        // xorshift32 seeded per template: noise differs in every frame of
+        // the loop, which defeats both intra and inter prediction.
+        uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(t * 2654435761u + 1);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+        {
+          state ^= state << 13;
+          state ^= state >> 17;
+          state ^= state << 5;
+          const int luma = y_plane[i] + static_cast<int>(state & 63) - 32;
+          y_plane[i] = static_cast<uint8_t>(std::clamp(luma, 16, 235));
+        }
+      }
+
+      // A white box sweeps left to right once per loop (the moving part of
+      // kStatic, and a visual frame counter for the other profiles).
+      const int box = std::max(2, (height / 8) & ~1);
+      const int box_x =
+          static_cast<int>(t * static_cast<size_t>(std::max(width - box, 0)) / count) & ~1;
+      const int box_y = ((height - box) / 2) & ~1;
+      for (int row = box_y; row < std::min(box_y + box, height); ++row)
+      {
+        std::memset(y_plane + static_cast<size_t>(row) * width + box_x, 235,
+                    std::min(box, width - box_x));
+      }
+      for (int row = box_y / 2; row < std::min((box_y + box) / 2, chroma_height); ++row)
+      {
+        const int chroma_box = std::min(box / 2, chroma_width - box_x / 2);
+        std::memset(u_plane + static_cast<size_t>(row) * chroma_width + box_x / 2, 128, chroma_box);
+        std::memset(v_plane + static_cast<size_t>(row) * chroma_width + box_x / 2, 128, chroma_box);
+      }
+      return frame;
+    }
+  } // namespace
+
+  std::shared_ptr<const SyntheticTemplates> GetSyntheticTemplates(
+      const SyntheticProducerConfig &config)
+  {
+    static std::mutex cache_mutex;
+    static std::map<TemplateKey, std::weak_ptr<const SyntheticTemplates>> cache;
+
+    if (!ValidConfig(config))
+    {
+      return nullptr;
+    }
+    const TemplateKey key{config.width, config.height, config.complexity, config.template_count};
+    // Rendering happens under the lock so channels starting together on
+    // one profile render it once.
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (auto cached = cache[key].lock())
+    {
+      return cached;
+    }
+    auto templates = std::make_shared<SyntheticTemplates>();
+    templates->width = config.width;
+    templates->height = config.height;
+    templates->frames.reserve(config.template_count);
+    for (size_t t = 0; t < config.template_count; ++t)
+    {
+      templates->frames.push_back(RenderTemplate(config.width, config.height, config.complexity,
+                                                 t, config.template_count));
+    }
+    cache[key] = templates;
+    return templates;
+  }
+
+  SyntheticProducer::SyntheticProducer(
+      const SyntheticProducerConfig &config,
+      buffer::FrameRingBuffer &output_buffer,
+      SyntheticProducerEventCallback event_callback)
+      : config_(config),
+        asset_id_(buffer::InternAsset(config.asset_uri)),
+        output_buffer_(output_buffer),
+        event_callback_(event_callback),
+        running_(false),
+        stop_requested_(false),
+        frames_produced_(0),
+        late_frames_(0)
+  {
+  }
+
+  SyntheticProducer::~SyntheticProducer()
+  {
+    stop();
+  }
+
+  void SyntheticProducer::EmitEvent(const std::string &event_type, const std::string &message)
+  {
+    if (event_callback_)
+    {
+      event_callback_(event_type, message);
+    }
+  }
+
+  bool SyntheticProducer::start()
+  {
+    if (running_.load(std::memory_order_acquire) || producer_thread_)
+    {
+      return false;
+    }
+    if (!ValidConfig(config_))
+    {
+      std::cerr << "[SyntheticProducer] Invalid configuration: " << config_.width << "x"
+                << config_.height << " @ " << config_.target_fps << " fps, "
+                << config_.template_count << " templates" << std::endl;
+      return false;
+    }
+
+    if (!templates_)
+    {
+      templates_ = GetSyntheticTemplates(config_);
+    }
+    if (!frame_pool_)
+    {
+      frame_pool_ = buffer::FramePool::Create(output_buffer_.Capacity() + kFramePoolHeadroom,
+                                              templates_->frames.front().size());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      next_frame_ = 0;
+    }
+
+    std::cout << "[SyntheticProducer] Started: " << config_.width << "x" << config_.height
+              << " @ " << config_.target_fps << " fps, " << templates_->frames.size()
+              << " templates" << std::endl;
+    // Emitted before the thread exists so they always precede "eof".
+    EmitEvent("ready", "");
+    EmitEvent("started", "");
+
+    stop_requested_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    producer_thread_ = std::make_unique<std::thread>(&SyntheticProducer::ProduceLoop, this);
+    return true;
+  }
+
+  void SyntheticProducer::stop()
+  {
+    if (!producer_thread_)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      stop_requested_.store(true, std::memory_order_release);
+    }
+    shadow_cv_.notify_all();
+    output_buffer_.WakeWaiters();
+
+    if (producer_thread_->joinable())
+    {
+      producer_thread_->join();
+    }
+    producer_thread_.reset();
+    running_.store(false, std::memory_order_release);
+
+    std::cout << "[SyntheticProducer] Stopped. Total frames produced: "
+              << frames_produced_.load(std::memory_order_acquire) << std::endl;
+    EmitEvent("stopped", "");
+  }
+
+  bool SyntheticProducer::isRunning() const
+  {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  void SyntheticProducer::SetShadowDecodeMode(bool enabled)
+  {
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      shadow_mode_ = enabled;
+    }
+    shadow_cv_.notify_all();
+  }
+
+  bool SyntheticProducer::IsShadowDecodeReady() const
+  {
+    // Templates are rendered by start(); delivery cannot stall on decode.
+    return templates_ != nullptr && running_.load(std::memory_order_acquire);
+  }
+
+  int64_t SyntheticProducer::GetNextPTS() const
+  {
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    return FramePtsUs(next_frame_) + pts_offset_us_;
+  }
+
+  void SyntheticProducer::AlignPTS(int64_t target_pts)
+  {
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    pts_offset_us_ = target_pts - FramePtsUs(next_frame_);
+    std::cout << "[SyntheticProducer] PTS aligned: offset=" << pts_offset_us_
+              << ", target=" << target_pts << std::endl;
+  }
+
+  uint64_t SyntheticProducer::GetFramesProduced() const
+  {
+    return frames_produced_.load(std::memory_order_acquire);
+  }
+
+  uint64_t SyntheticProducer::GetLateFrames() const
+  {
+    return late_frames_.load(std::memory_order_acquire);
+  }
+
+  void SyntheticProducer::ProduceLoop()
+  {
+    using Clock = std::chrono::steady_clock;
+    const std::chrono::duration<double> interval(1.0 / config_.target_fps);
+    // Deadlines are computed from an epoch rather than accumulated, so
+    // rounding does not drift the rate over long runs.
+    Clock::time_point epoch = Clock::now();
+    uint64_t epoch_frame = 0;
+
+    while (!stop_requested_.load(std::memory_order_acquire))
+    {
+      uint64_t index = 0;
+      {
+        // Shadow mode: hold until the switch (or stop).
+        std::unique_lock<std::mutex> lock(shadow_mutex_);
+        const bool held = shadow_mode_;
+        shadow_cv_.wait(lock, [this] {
+          return !shadow_mode_ || stop_requested_.load(std::memory_order_acquire);
+        });
+        if (stop_requested_.load(std::memory_order_acquire))
+        {
+          break;
+        }
+        index = next_frame_;
+        if (held)
+        {
+          // The first frame after the switch is due immediately.
+          epoch = Clock::now();
+          epoch_frame = index;
+        }
+
+        if (config_.frame_limit > 0 && index >= config_.frame_limit)
+        {
+          lock.unlock();
+          std::cout << "[SyntheticProducer] Frame limit reached, all frames emitted" << std::endl;
+          EmitEvent("eof", "");
+          break;
+        }
+
+        if (config_.realtime)
+        {
+          const auto deadline =
+              epoch + std::chrono::duration_cast<Clock::duration>(interval * (index - epoch_frame));
+          if (shadow_cv_.wait_until(lock, deadline, [this] {
+                return stop_requested_.load(std::memory_order_acquire);
+              }))
+          {
+            break;
+          }
+        }
+      }
+
+      if (!DeliverFrame(index))
+      {
+        output_buffer_.WaitForSpace(Clock::now() + std::chrono::microseconds(kProducerBackoffUs));
+        continue;
+      }
+
+      if (config_.realtime)
+      {
+        // A consumer that fell behind gets frames as it drains, then the
+        // schedule restarts from now instead of bursting to catch up.
+        const auto now = Clock::now();
+        const auto deadline =
+            epoch + std::chrono::duration_cast<Clock::duration>(interval * (index - epoch_frame));
+        if (now - deadline > interval)
+        {
+          late_frames_.fetch_add(1, std::memory_order_relaxed);
+          epoch = now;
+          epoch_frame = index + 1;
+        }
+      }
+    }
+    running_.store(false, std::memory_order_release);
+  }
+
+  bool SyntheticProducer::DeliverFrame(uint64_t index)
+  {
+    if (output_buffer_.IsFull())
+    {
+      return false;
+    }
+    buffer::FrameHandle handle = frame_pool_->Acquire();
+    if (!handle)
+    {
+      return false;  // Every slot is still queued downstream
+    }
+
+    int64_t pts_offset_us = 0;
+    {
+      std::lock_guard<std::mutex> lock(shadow_mutex_);
+      pts_offset_us = pts_offset_us_;
+    }
+
+    // The only per-frame work: template -> pooled frame (capacity retained,
+    // so this resize never allocates after the first loop).
+    const std::vector<uint8_t> &pattern = templates_->frames[index % templates_->frames.size()];
+    buffer::Frame &frame = *handle;
+    frame.width = templates_->width;
+    frame.height = templates_->height;
+    frame.data.resize(pattern.size());
+    std::memcpy(frame.data.data(), pattern.data(), pattern.size());
+    frame.metadata.pts = FramePtsUs(index) + pts_offset_us;
+    frame.metadata.dts = frame.metadata.pts;
+    frame.metadata.duration = 1.0 / config_.target_fps;
+    frame.metadata.asset_id = asset_id_;
+
+    if (!output_buffer_.Push(std::move(handle)))
+    {
+      return false;
+    }
+    frames_produced_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(shadow_mutex_);
+    if (next_frame_ == index)
+    {
+      next_frame_++;
+    }
+    return true;
+  }
+
+  int64_t SyntheticProducer::FramePtsUs(uint64_t index) const
+  {
+    if (config_.target_fps <= 0.0)
+    {
+      return 0;
+    }
+    return static_cast<int64_t>(std::llround(static_cast<double>(index) * 1'000'000.0 /
+                                             config_.target_fps));
+  }
+
+} // namespace retrovue::producers::synthetic
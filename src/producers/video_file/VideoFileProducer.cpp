@@ -5,22 +5,37 @@
 
 #include "retrovue/producers/video_file/VideoFileProducer.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef RETROVUE_FFMPEG_AVAILABLE
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavcodec/bsf.h>
 #include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/hwcontext.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
 #include <libswscale/swscale.h>
 }
 #endif
 
+#include "retrovue/decode/AssetProbeCache.h"
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/decode/PlaneKernels.h"
+#include "retrovue/telemetry/TraceRing.h"
 #include "retrovue/timing/MasterClock.h"
 
 namespace retrovue::producers::video_file
@@ -30,15 +45,168 @@ namespace retrovue::producers::video_file
   {
     constexpr int64_t kProducerBackoffUs = 10'000; // 10ms backoff when buffer is full
     constexpr int64_t kMicrosecondsPerSecond = 1'000'000;
+    constexpr size_t kFramePoolHeadroom = 2;        // Slot being filled + slot held by consumer
+    constexpr auto kStageWaitTimeout = std::chrono::milliseconds(10);  // Stage queue poll interval
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    // Device types tried, in order, when ProducerConfig::hw_device_type is empty.
+    constexpr const char* kAutoHwDeviceTypes[] = {"cuda", "vaapi", "qsv"};
+
+    // AVCodecContext::get_format callback. Picks the hardware surface format
+    // negotiated in InitializeHardwareDecoder() (ctx->opaque points at it), or
+    // the first software format when this stream cannot be decoded on the
+    // device, which makes libavcodec fall back to software decode.
+    AVPixelFormat SelectHwPixelFormat(AVCodecContext* ctx, const AVPixelFormat* formats)
+    {
+      const int wanted = *static_cast<const int*>(ctx->opaque);
+      for (const AVPixelFormat* fmt = formats; *fmt != AV_PIX_FMT_NONE; ++fmt)
+      {
+        if (*fmt == wanted)
+        {
+          return *fmt;
+        }
+      }
+
+      for (const AVPixelFormat* fmt = formats; *fmt != AV_PIX_FMT_NONE; ++fmt)
+      {
+        const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(*fmt);
+        if (desc && !(desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+        {
+          std::cerr << "[VideoFileProducer] Hardware surface unavailable for stream, "
+                    << "decoding in software" << std::endl;
+          return *fmt;
+        }
+      }
+      return AV_PIX_FMT_NONE;
+    }
+
+    enum class StageResult
+    {
+      kItem,
+      kTimeout,
+      kClosed  // Finished and drained, or aborted
+    };
+
+    // StageQueue is a bounded blocking FIFO of owned FFmpeg objects passed
+    // between decode stages. Free releases items still queued at destruction.
+    template <typename T, void (*Free)(T **)>
+    class StageQueue
+    {
+    public:
+      explicit StageQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+      ~StageQueue()
+      {
+        for (T *item : items_)
+        {
+          Free(&item);
+        }
+      }
+
+      StageQueue(const StageQueue &) = delete;
+      StageQueue &operator=(const StageQueue &) = delete;
+
+      // Blocks while the queue is full. Returns false once aborted; the caller
+      // keeps ownership of item.
+      bool Push(T *item)
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return aborted_ || items_.size() < capacity_; });
+        if (aborted_)
+        {
+          return false;
+        }
+        items_.push_back(item);
+        not_empty_.notify_one();
+        return true;
+      }
+
+      // Waits up to timeout for the next item.
+      StageResult Pop(T *&item, std::chrono::milliseconds timeout)
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!not_empty_.wait_for(lock, timeout, [this]()
+                                 { return aborted_ || finished_ || !items_.empty(); }))
+        {
+          return StageResult::kTimeout;
+        }
+        if (aborted_ || items_.empty())
+        {
+          return StageResult::kClosed;
+        }
+        item = items_.front();
+        items_.pop_front();
+        not_full_.notify_one();
+        return StageResult::kItem;
+      }
+
+      // Producer side: no more items. Consumers drain what is queued first.
+      void Finish()
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        not_empty_.notify_all();
+      }
+
+      // Stops both sides immediately; queued items are discarded on destruction.
+      void Abort()
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+      }
+
+      bool IsAborted() const
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return aborted_;
+      }
+
+    private:
+      const size_t capacity_;
+      mutable std::mutex mutex_;
+      std::condition_variable not_full_;
+      std::condition_variable not_empty_;
+      std::deque<T *> items_;
+      bool finished_ = false;
+      bool aborted_ = false;
+    };
+#endif
   }
 
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  struct VideoFileProducer::DecodePipeline
+  {
+    DecodePipeline(size_t packet_depth, size_t frame_depth)
+        : packets(packet_depth), audio_packets(packet_depth), frames(frame_depth) {}
+
+    StageQueue<AVPacket, av_packet_free> packets;
+    StageQueue<AVPacket, av_packet_free> audio_packets;  // Decoded on the producer thread
+    StageQueue<AVFrame, av_frame_free> frames;
+    std::thread demux_thread;
+    std::thread decode_thread;
+  };
+#else
+  struct VideoFileProducer::DecodePipeline
+  {
+  };
+#endif
+
   VideoFileProducer::VideoFileProducer(
       const ProducerConfig &config,
       buffer::FrameRingBuffer &output_buffer,
       std::shared_ptr<timing::MasterClock> clock,
       ProducerEventCallback event_callback)
       : config_(config),
+        asset_id_(buffer::InternAsset(config.asset_uri)),
         output_buffer_(output_buffer),
+        frame_pool_(buffer::FramePool::Create(
+            output_buffer.Capacity() + kFramePoolHeadroom +
+                std::max<size_t>(config.shadow_preroll_frames, 1),
+            buffer::Frame::LayoutBytes(config.high_bit_depth ? buffer::PixelFormat::kP010
+                                                             : buffer::PixelFormat::kI420,
+                                       config.target_width, config.target_height))),
         master_clock_(clock),
         event_callback_(event_callback),
         state_(ProducerState::STOPPED),
@@ -54,6 +222,33 @@ namespace retrovue::producers::video_file
         scaled_frame_(nullptr),
         packet_(nullptr),
         sws_ctx_(nullptr),
+        decoder_pooled_(false),
+        assemble_source_(nullptr),
+        hw_device_ctx_(nullptr),
+        passthrough_bsf_(nullptr),
+        passthrough_active_(false),
+        passthrough_wait_keyframe_(false),
+        passthrough_last_pts_us_(-1),
+        hw_transfer_frame_(nullptr),
+        hw_pix_fmt_(-1),
+        hw_decode_active_(false),
+        device_source_(false),
+        device_frames_in_flight_(std::make_shared<std::atomic<int>>(0)),
+        device_frames_produced_(0),
+        device_frame_downloads_(0),
+        audio_codec_ctx_(nullptr),
+        audio_frame_(nullptr),
+        swr_ctx_(nullptr),
+        audio_stream_index_(-1),
+        audio_time_base_(0.0),
+        audio_block_fill_(0),
+        audio_base_pts_us_(-1),
+        audio_samples_emitted_(0),
+        audio_skip_until_us_(-1),
+        audio_blocks_produced_(0),
+        audio_blocks_dropped_(0),
+        io_ctx_(nullptr),
+        seek_target_pts_us_(-1),
         video_stream_index_(-1),
         decoder_initialized_(false),
         eof_reached_(false),
@@ -62,13 +257,22 @@ namespace retrovue::producers::video_file
         last_decoded_frame_pts_us_(0),
         first_frame_pts_us_(0),
         playback_start_utc_us_(0),
+        pending_traces_{},
+        next_pending_trace_(0),
+        pending_trace_count_(0),
+        video_packets_(0),
         stub_pts_counter_(0),
         frame_interval_us_(static_cast<int64_t>(std::round(kMicrosecondsPerSecond / config.target_fps))),
         next_stub_deadline_utc_(0),
         shadow_decode_mode_(false),
         shadow_decode_ready_(false),
-        pts_offset_us_(0)
+        shadow_splice_started_(false),
+        out_point_pts_us_(0),
+        pts_offset_us_(0),
+        hibernate_requested_(false),
+        hibernating_(false)
   {
+    cpu_meter_.SetAccount(config_.cpu_account);
   }
 
   VideoFileProducer::~VideoFileProducer()
@@ -107,6 +311,7 @@ namespace retrovue::producers::video_file
     SetState(ProducerState::STARTING);
     stop_requested_.store(false, std::memory_order_release);
     teardown_requested_.store(false, std::memory_order_release);
+    hibernate_requested_.store(false, std::memory_order_release);
     stub_pts_counter_.store(0, std::memory_order_release);
     next_stub_deadline_utc_.store(0, std::memory_order_release);
     eof_reached_ = false;
@@ -144,6 +349,11 @@ namespace retrovue::producers::video_file
     SetState(ProducerState::STOPPING);
     stop_requested_.store(true, std::memory_order_release);
     teardown_requested_.store(false, std::memory_order_release);
+    output_buffer_.WakeWaiters();
+    {
+      std::lock_guard<std::mutex> lock(hibernate_mutex_);
+    }
+    hibernate_cv_.notify_all();
 
     // Wait for producer thread to exit
     if (producer_thread_ && producer_thread_->joinable())
@@ -154,6 +364,14 @@ namespace retrovue::producers::video_file
 
     CloseDecoder();
 
+    {
+      // Staged preroll frames never made it to air; return them to the pool.
+      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+      shadow_preroll_.clear();
+      shadow_audio_.clear();
+      shadow_splice_started_ = false;
+    }
+
     SetState(ProducerState::STOPPED);
     std::cout << "[VideoFileProducer] Stopped. Total decoded frames produced: " 
               << frames_produced_.load(std::memory_order_acquire) << std::endl;
@@ -178,6 +396,11 @@ namespace retrovue::producers::video_file
   void VideoFileProducer::ForceStop()
   {
     stop_requested_.store(true, std::memory_order_release);
+    output_buffer_.WakeWaiters();
+    {
+      std::lock_guard<std::mutex> lock(hibernate_mutex_);
+    }
+    hibernate_cv_.notify_all();
     std::cout << "[VideoFileProducer] Force stop requested" << std::endl;
     EmitEvent("force_stop", "");
   }
@@ -208,8 +431,46 @@ namespace retrovue::producers::video_file
     return state_.load(std::memory_order_acquire);
   }
 
+  decode::ReadAheadStats VideoFileProducer::GetReadAheadStats() const
+  {
+    std::lock_guard<std::mutex> lock(read_ahead_mutex_);
+    return read_ahead_ ? read_ahead_->GetStats() : decode::ReadAheadStats();
+  }
+
+  bool VideoFileProducer::IsHardwareDecodeActive() const
+  {
+    return hw_decode_active_.load(std::memory_order_acquire);
+  }
+
+  bool VideoFileProducer::IsPassthroughActive() const
+  {
+    return passthrough_active_.load(std::memory_order_acquire);
+  }
+
+  uint64_t VideoFileProducer::GetAudioBlocksProduced() const
+  {
+    return audio_blocks_produced_.load(std::memory_order_acquire);
+  }
+
+  uint64_t VideoFileProducer::GetAudioBlocksDropped() const
+  {
+    return audio_blocks_dropped_.load(std::memory_order_acquire);
+  }
+
+  uint64_t VideoFileProducer::GetDeviceFramesProduced() const
+  {
+    return device_frames_produced_.load(std::memory_order_acquire);
+  }
+
+  uint64_t VideoFileProducer::GetDeviceFrameDownloads() const
+  {
+    return device_frame_downloads_.load(std::memory_order_acquire);
+  }
+
   void VideoFileProducer::ProduceLoop()
   {
+    telemetry::NameCurrentThread(config_.channel_id, "produce");
+    cpu_meter_.Restart();
     std::cout << "[VideoFileProducer] Decode loop started (stub_mode=" 
               << (config_.stub_mode ? "true" : "false") << ")" << std::endl;
 
@@ -228,6 +489,25 @@ namespace retrovue::producers::video_file
       else
       {
         std::cout << "[VideoFileProducer] Internal decoder initialized successfully" << std::endl;
+        // Passthrough eligibility needs the GOP lengths, so it scans too
+        if (config_.keyframe_index_enabled)
+        {
+          LoadOrBuildKeyframeIndex(config_.start_offset_us > 0 || config_.passthrough);
+        }
+        if (config_.passthrough)
+        {
+          InitializePassthrough();
+        }
+        if (config_.start_offset_us > 0)
+        {
+          SeekToStartOffset();
+        }
+        // Joined in progress, the asset's first frame never airs
+        asset_start_pending_ = config_.start_offset_us <= 0;
+        if (config_.pipelined_decode && !IsPassthroughActive())
+        {
+          StartPipeline();
+        }
         // Emit ready after successful decoder initialization
         EmitEvent("ready", "");
       }
@@ -243,6 +523,36 @@ namespace retrovue::producers::video_file
         continue;
       }
 
+      // Idle channel: hold with the decoder open until woken.
+      if (hibernate_requested_.load(std::memory_order_acquire) &&
+          !shadow_decode_mode_.load(std::memory_order_acquire))
+      {
+        HoldWhileHibernating();
+        continue;
+      }
+
+      // Shadow preroll: once the staging ring is full (or the asset is
+      // exhausted), hold instead of decoding further ahead of the switch.
+      if (shadow_decode_mode_.load(std::memory_order_acquire))
+      {
+        std::unique_lock<std::mutex> lock(shadow_decode_mutex_);
+        if (eof_reached_ || shadow_preroll_.size() >= ShadowPrerollTarget())
+        {
+          shadow_decode_cv_.wait_for(lock, kStageWaitTimeout, [this] {
+            return !shadow_decode_mode_.load(std::memory_order_acquire) ||
+                   stop_requested_.load(std::memory_order_acquire);
+          });
+          continue;
+        }
+      }
+      else if (!SpliceShadowPreroll())
+      {
+        // Output buffer full: splice the rest as the consumer makes room.
+        output_buffer_.WaitForSpace(std::chrono::steady_clock::now() +
+                                    std::chrono::microseconds(kProducerBackoffUs));
+        continue;
+      }
+
       // Check teardown timeout
       if (teardown_requested_.load(std::memory_order_acquire))
       {
@@ -286,6 +596,17 @@ namespace retrovue::producers::video_file
         break;
       }
 
+      // Scheduled switch: the frame at the out point belongs to the producer
+      // switching in
+      const int64_t out_point_pts_us = out_point_pts_us_.load(std::memory_order_acquire);
+      if (out_point_pts_us > 0 && GetNextPTS() >= out_point_pts_us)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(kProducerBackoffUs));
+        continue;
+      }
+
+      RETROVUE_TRACE_SCOPE("producer.produce_frame");
+      RETROVUE_TRACE_COUNTER("producer.output_depth", output_buffer_.Size());
       if (config_.stub_mode)
       {
         ProduceStubFrame();
@@ -299,13 +620,17 @@ namespace retrovue::producers::video_file
           // Decode error or EOF - back off and retry
           if (eof_reached_)
           {
-            break;
+            // Short asset in shadow mode: hold the staged frames for the
+            // switch. Live: the EOF check above reports "eof" once the last
+            // frame is due.
+            continue;
           }
           // Transient decode error - back off and retry
           decode_errors_.fetch_add(1, std::memory_order_relaxed);
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
       }
+      cpu_meter_.Charge(telemetry::CpuStage::kDecode);  // The rest of the iteration
     }
 
     std::cout << "[VideoFileProducer] Decode loop exited" << std::endl;
@@ -323,17 +648,36 @@ namespace retrovue::producers::video_file
       return false;
     }
 
+    // Route demuxer reads through the prefetch window so storage stalls
+    // do not reach the decode thread. URLs and devices are opened directly.
+    if (config_.read_ahead_bytes > 0)
+    {
+      auto read_ahead = std::make_unique<decode::ReadAheadFile>(config_.read_ahead_bytes);
+      if (read_ahead->Open(config_.asset_uri))
+      {
+        io_ctx_ = read_ahead->CreateIOContext();
+        if (io_ctx_)
+        {
+          format_ctx_->pb = io_ctx_;
+          format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+          std::lock_guard<std::mutex> lock(read_ahead_mutex_);
+          read_ahead_ = std::move(read_ahead);
+        }
+      }
+    }
+
     // Open input file
     if (avformat_open_input(&format_ctx_, config_.asset_uri.c_str(), nullptr, nullptr) < 0)
     {
       std::cerr << "[VideoFileProducer] Failed to open input: " << config_.asset_uri << std::endl;
       avformat_free_context(format_ctx_);
       format_ctx_ = nullptr;
+      CloseDecoder();
       return false;
     }
 
-    // Retrieve stream information
-    if (avformat_find_stream_info(format_ctx_, nullptr) < 0)
+    // Retrieve stream information (cached for assets we have probed before)
+    if (!decode::AssetProbeCache::Instance().ProbeInput(config_.asset_uri, format_ctx_))
     {
       std::cerr << "[VideoFileProducer] Failed to find stream info" << std::endl;
       CloseDecoder();
@@ -371,71 +715,80 @@ namespace retrovue::producers::video_file
       return false;
     }
 
-    codec_ctx_ = avcodec_alloc_context3(codec);
-    if (!codec_ctx_)
-    {
-      std::cerr << "[VideoFileProducer] Failed to allocate codec context" << std::endl;
-      CloseDecoder();
-      return false;
-    }
-
-    if (avcodec_parameters_to_context(codec_ctx_, codecpar) < 0)
+    // A warm context from an earlier asset with identical stream parameters
+    // skips avcodec_open2() (thread pool and frame context setup).
+    decode::DecoderContextPool& pool = decode::DecoderContextPool::Instance();
+    const bool poolable = config_.reuse_decoder_contexts && !config_.hw_accel_enabled;
+    decoder_key_ = decode::DecoderContextPool::MakeDecoderKey(
+        codecpar, std::max(config_.decode_threads, 0), config_.decode_thread_type);
+    codec_ctx_ = poolable ? pool.AcquireDecoder(decoder_key_) : nullptr;
+    if (codec_ctx_)
     {
-      std::cerr << "[VideoFileProducer] Failed to copy codec parameters" << std::endl;
-      CloseDecoder();
-      return false;
+      std::cout << "[VideoFileProducer] Reusing warm " << codec->name << " decoder context"
+                << std::endl;
     }
-
-    if (avcodec_open2(codec_ctx_, codec, nullptr) < 0)
+    else if (!OpenCodec(codec, codecpar))
     {
-      std::cerr << "[VideoFileProducer] Failed to open codec" << std::endl;
       CloseDecoder();
       return false;
     }
+    decoder_pooled_ = poolable;
+    hw_decode_active_.store(hw_device_ctx_ != nullptr, std::memory_order_release);
 
     // Allocate frames
     frame_ = av_frame_alloc();
     scaled_frame_ = av_frame_alloc();
-    if (!frame_ || !scaled_frame_)
+    if (hw_device_ctx_)
+    {
+      hw_transfer_frame_ = av_frame_alloc();
+    }
+    if (!frame_ || !scaled_frame_ || (hw_device_ctx_ && !hw_transfer_frame_))
     {
       std::cerr << "[VideoFileProducer] Failed to allocate frames" << std::endl;
       CloseDecoder();
       return false;
     }
 
-    // Initialize scaler
-    int src_width = codec_ctx_->width;
-    int src_height = codec_ctx_->height;
-    AVPixelFormat src_format = codec_ctx_->pix_fmt;
     int dst_width = config_.target_width;
     int dst_height = config_.target_height;
     AVPixelFormat dst_format = AV_PIX_FMT_YUV420P;
+    const AVPixFmtDescriptor* source_desc = av_pix_fmt_desc_get(codec_ctx_->pix_fmt);
+    if (config_.high_bit_depth && source_desc && source_desc->comp[0].depth > 8)
+    {
+      dst_format = AV_PIX_FMT_P010LE;
+    }
 
-    sws_ctx_ = sws_getContext(
-        src_width, src_height, src_format,
-        dst_width, dst_height, dst_format,
-        SWS_BILINEAR, nullptr, nullptr, nullptr);
-
-    if (!sws_ctx_)
+    // Initialize scaler. Hardware frames are downloaded in the device's
+    // software format (NV12, P010, ...), which is only known once the first
+    // frame arrives, so ScaleFrame() creates the context lazily in that case.
+    // Sources already at the target size in yuv420p never need one.
+    const bool source_matches_target =
+        codec_ctx_->width == dst_width && codec_ctx_->height == dst_height &&
+        codec_ctx_->pix_fmt == dst_format;
+    if (!hw_device_ctx_ && !source_matches_target)
     {
-      std::cerr << "[VideoFileProducer] Failed to create scaler context" << std::endl;
-      CloseDecoder();
-      return false;
+      decode::ScalerKey scaler_key;
+      scaler_key.src_width = codec_ctx_->width;
+      scaler_key.src_height = codec_ctx_->height;
+      scaler_key.src_format = codec_ctx_->pix_fmt;
+      scaler_key.dst_width = dst_width;
+      scaler_key.dst_height = dst_height;
+      scaler_key.dst_format = dst_format;
+      scaler_key.flags = SWS_BILINEAR;
+      if (!UseScaler(scaler_key))
+      {
+        std::cerr << "[VideoFileProducer] Failed to create scaler context" << std::endl;
+        CloseDecoder();
+        return false;
+      }
     }
 
-    // Allocate buffer for scaled frame
-    if (av_image_alloc(scaled_frame_->data, scaled_frame_->linesize,
-                       dst_width, dst_height, dst_format, 32) < 0)
+    if (!AllocateScaledFrame(dst_format))
     {
-      std::cerr << "[VideoFileProducer] Failed to allocate scaled frame buffer" << std::endl;
       CloseDecoder();
       return false;
     }
 
-    scaled_frame_->width = dst_width;
-    scaled_frame_->height = dst_height;
-    scaled_frame_->format = dst_format;
-
     // Allocate packet
     packet_ = av_packet_alloc();
     if (!packet_)
@@ -445,6 +798,12 @@ namespace retrovue::producers::video_file
       return false;
     }
 
+    // Audio is optional: assets without a usable audio stream play video-only.
+    if (config_.audio_enabled)
+    {
+      InitializeAudioDecoder();
+    }
+
     decoder_initialized_ = true;
     eof_reached_ = false;
     return true;
@@ -454,235 +813,1666 @@ namespace retrovue::producers::video_file
 #endif
   }
 
-  void VideoFileProducer::CloseDecoder()
+  void VideoFileProducer::LoadOrBuildKeyframeIndex(bool scan_packets)
   {
 #ifdef RETROVUE_FFMPEG_AVAILABLE
-    if (sws_ctx_)
+    keyframe_index_.Clear();
+
+    // A scan during hibernation gives way to the wake-up.
+    auto cancelled = [this]
     {
-      sws_freeContext(sws_ctx_);
-      sws_ctx_ = nullptr;
+      return stop_requested_.load(std::memory_order_acquire) ||
+             (hibernating_.load(std::memory_order_acquire) &&
+              !hibernate_requested_.load(std::memory_order_acquire));
+    };
+
+    // Only local files can be stamped; streams and URLs are never indexed.
+    decode::AssetStamp stamp;
+    if (!decode::KeyframeIndex::StatAsset(config_.asset_uri, &stamp))
+    {
+      return;
     }
-
-    if (scaled_frame_)
+    const std::string sidecar_path =
+        decode::KeyframeIndex::SidecarPathFor(config_.asset_uri, config_.keyframe_index_dir);
+    if (keyframe_index_.Load(sidecar_path, stamp, video_stream_index_))
     {
-      if (scaled_frame_->data[0])
-      {
-        av_freep(&scaled_frame_->data[0]);
-      }
-      av_frame_free(&scaled_frame_);
-      scaled_frame_ = nullptr;
+      std::cout << "[VideoFileProducer] Loaded keyframe index (" << keyframe_index_.size()
+                << " keyframes) from " << sidecar_path << std::endl;
+      return;
     }
 
-    if (frame_)
+    AVStream* stream = format_ctx_->streams[video_stream_index_];
+    auto to_us = [this](int64_t ts)
     {
-      av_frame_free(&frame_);
-      frame_ = nullptr;
+      return static_cast<int64_t>(ts * time_base_ * kMicrosecondsPerSecond);
+    };
+
+    // Containers with a seek index (MP4 stss, MKV cues) give it to us for
+    // free. Their timestamps may be DTS, which precede the keyframe's PTS by
+    // at most the reorder delay.
+    const int entry_count = avformat_index_get_entries_count(stream);
+    for (int i = 0; i < entry_count; i++)
+    {
+      const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+      if (entry && (entry->flags & AVINDEX_KEYFRAME))
+      {
+        keyframe_index_.Add({to_us(entry->timestamp), entry->timestamp, entry->pos});
+      }
     }
 
-    if (packet_)
+    // Otherwise (MPEG-TS, raw streams) scan the packets, which reads the
+    // whole file once. Only worth it when the producer needs to seek.
+    if (keyframe_index_.empty() && scan_packets)
     {
-      av_packet_free(&packet_);
-      packet_ = nullptr;
+      std::cout << "[VideoFileProducer] Building keyframe index by packet scan: "
+                << config_.asset_uri << std::endl;
+      while (!cancelled() && av_read_frame(format_ctx_, packet_) >= 0)
+      {
+        if (packet_->stream_index == video_stream_index_ && (packet_->flags & AV_PKT_FLAG_KEY))
+        {
+          const int64_t ts = packet_->pts != AV_NOPTS_VALUE ? packet_->pts : packet_->dts;
+          if (ts != AV_NOPTS_VALUE)
+          {
+            keyframe_index_.Add({to_us(ts), ts, packet_->pos});
+          }
+        }
+        av_packet_unref(packet_);
+      }
+      const int64_t start = format_ctx_->start_time != AV_NOPTS_VALUE ? format_ctx_->start_time : 0;
+      if (avformat_seek_file(format_ctx_, -1, INT64_MIN, start, start, 0) < 0)
+      {
+        std::cerr << "[VideoFileProducer] Failed to rewind after keyframe scan" << std::endl;
+      }
+      if (cancelled())
+      {
+        keyframe_index_.Clear();  // Partial scan; never persist it
+        return;
+      }
     }
 
-    if (codec_ctx_)
+    if (keyframe_index_.empty())
     {
-      avcodec_free_context(&codec_ctx_);
-      codec_ctx_ = nullptr;
+      return;
     }
-
-    if (format_ctx_)
+    keyframe_index_.Finalize();
+    keyframe_index_.set_stamp(stamp);
+    keyframe_index_.set_stream_index(video_stream_index_);
+    if (keyframe_index_.Save(sidecar_path))
     {
-      avformat_close_input(&format_ctx_);
-      format_ctx_ = nullptr;
+      std::cout << "[VideoFileProducer] Saved keyframe index (" << keyframe_index_.size()
+                << " keyframes) to " << sidecar_path << std::endl;
     }
+#else
+    (void)scan_packets;
+#endif
+  }
 
-    decoder_initialized_ = false;
-    video_stream_index_ = -1;
-    eof_reached_ = false;
+  void VideoFileProducer::SeekToStartOffset()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    AVStream* stream = format_ctx_->streams[video_stream_index_];
+    const int64_t stream_start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    const int64_t target_pts_us =
+        static_cast<int64_t>(stream_start * time_base_ * kMicrosecondsPerSecond) +
+        config_.start_offset_us;
+    const int64_t keyframe_pts_us = SeekToMediaTime(target_pts_us);
+    std::cout << "[VideoFileProducer] Join-in-progress start at " << config_.start_offset_us
+              << "us (keyframe at " << keyframe_pts_us << "us)" << std::endl;
 #endif
   }
 
-  bool VideoFileProducer::ProduceRealFrame()
+  int64_t VideoFileProducer::SeekToMediaTime(int64_t target_pts_us)
   {
 #ifdef RETROVUE_FFMPEG_AVAILABLE
-    if (!decoder_initialized_)
+    AVStream* stream = format_ctx_->streams[video_stream_index_];
+    int result = 0;
+    const decode::KeyframeEntry* keyframe = keyframe_index_.FindAtOrBefore(target_pts_us);
+    if (keyframe)
     {
-      return false;
+      // Byte offsets go straight to the GOP without the demuxer's timestamp
+      // bisection; use them where the container has no index of its own.
+      const bool byte_seek = keyframe->byte_pos >= 0 &&
+                             avformat_index_get_entries_count(stream) == 0 &&
+                             !(format_ctx_->iformat->flags & AVFMT_NO_BYTE_SEEK);
+      result = byte_seek
+                   ? av_seek_frame(format_ctx_, -1, keyframe->byte_pos, AVSEEK_FLAG_BYTE)
+                   : av_seek_frame(format_ctx_, video_stream_index_, keyframe->timestamp,
+                                   AVSEEK_FLAG_BACKWARD);
+    }
+    else
+    {
+      // No index: let the demuxer locate the preceding keyframe.
+      const int64_t target_ts = static_cast<int64_t>(
+          target_pts_us / (time_base_ * kMicrosecondsPerSecond));
+      result = av_seek_frame(format_ctx_, video_stream_index_, target_ts, AVSEEK_FLAG_BACKWARD);
     }
 
-    // Decode ONE frame at a time (paced according to fake time)
-    // Read packet
-    int ret = av_read_frame(format_ctx_, packet_);
-    
-    if (ret == AVERROR_EOF)
+    if (result < 0)
     {
-      eof_reached_ = true;
-      return false;
+      // Still correct, just slow: decode forward from the current position.
+      std::cerr << "[VideoFileProducer] Seek to " << target_pts_us
+                << "us failed, decoding forward" << std::endl;
     }
-    
-    if (ret < 0)
+    avcodec_flush_buffers(codec_ctx_);
+    seek_target_pts_us_ = target_pts_us;
+    passthrough_wait_keyframe_ = true;
+    passthrough_last_pts_us_ = -1;
+    if (audio_codec_ctx_)
     {
-      av_packet_unref(packet_);
-      return false;  // Read error
+      avcodec_flush_buffers(audio_codec_ctx_);
+      audio_skip_until_us_ = target_pts_us;
     }
-
-    // Check if packet is from video stream
-    if (packet_->stream_index != video_stream_index_)
+    if (!config_.pipelined_decode)
     {
-      av_packet_unref(packet_);
-      return true;  // Skip non-video packets, try again
+      // Frames before the target are never shown; skip the ones nothing
+      // references. (The decode stage owns codec_ctx_ in staged mode.)
+      codec_ctx_->skip_frame = AVDISCARD_NONREF;
     }
+    return keyframe ? keyframe->pts_us : target_pts_us;
+#else
+    return target_pts_us;
+#endif
+  }
 
-    // Send packet to decoder
-    ret = avcodec_send_packet(codec_ctx_, packet_);
-    av_packet_unref(packet_);
-    
-    if (ret < 0)
+  void VideoFileProducer::Hibernate()
+  {
+    hibernate_requested_.store(true, std::memory_order_release);
+    output_buffer_.WakeWaiters();  // A producer waiting for space sees it at once
+  }
+
+  void VideoFileProducer::Wake()
+  {
     {
-      return false;  // Decode error
+      std::lock_guard<std::mutex> lock(hibernate_mutex_);
+      hibernate_requested_.store(false, std::memory_order_release);
     }
+    hibernate_cv_.notify_all();
+  }
 
-    // Receive decoded frame
-    ret = avcodec_receive_frame(codec_ctx_, frame_);
-    
-    if (ret == AVERROR(EAGAIN))
+  bool VideoFileProducer::IsHibernating() const
+  {
+    return hibernating_.load(std::memory_order_acquire);
+  }
+
+  int64_t VideoFileProducer::HibernationNowUs() const
+  {
+    if (master_clock_)
     {
-      return true;  // Need more packets, try again
+      return master_clock_->now_utc_us();
     }
-    
-    if (ret < 0)
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void VideoFileProducer::HoldWhileHibernating()
+  {
+    // Resume where the next frame would have been (stream time, no offset)
+    const bool positioned = frames_produced_.load(std::memory_order_acquire) > 0;
+    int64_t resume_pts_us = 0;
     {
-      return false;  // Decode error
+      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+      resume_pts_us = last_pts_us_ - pts_offset_us_ + frame_interval_us_;
     }
+    const int64_t paused_at_us = HibernationNowUs();
 
-    // Successfully decoded a frame - scale and assemble
-    if (!ScaleFrame())
+    StopPipeline();  // The stage threads own the demuxer; restarted on wake
+    hibernating_.store(true, std::memory_order_release);
+    std::cout << "[VideoFileProducer] Hibernating at " << resume_pts_us << "us" << std::endl;
+    EmitEvent("hibernating", "");
+
+    // Idle time pays for the packet scan the wake-up seek would otherwise lack
+    if (!config_.stub_mode && decoder_initialized_ && positioned &&
+        config_.keyframe_index_enabled && keyframe_index_.empty())
     {
-      return false;
+      LoadOrBuildKeyframeIndex(true);
     }
 
-    buffer::Frame output_frame;
-    if (!AssembleFrame(output_frame))
     {
-      return false;
+      std::unique_lock<std::mutex> lock(hibernate_mutex_);
+      hibernate_cv_.wait(lock, [this] {
+        return !hibernate_requested_.load(std::memory_order_acquire) ||
+               stop_requested_.load(std::memory_order_acquire);
+      });
     }
-
-    // Extract frame PTS in microseconds for pacing
+    hibernating_.store(false, std::memory_order_release);
+    if (stop_requested_.load(std::memory_order_acquire))
+    {
+      return;
+    }
+
+    const int64_t elapsed_us = std::max<int64_t>(0, HibernationNowUs() - paused_at_us);
+    if (config_.stub_mode)
+    {
+      stub_pts_counter_.fetch_add(elapsed_us / frame_interval_us_, std::memory_order_relaxed);
+      next_stub_deadline_utc_.store(0, std::memory_order_release);
+    }
+    else if (decoder_initialized_ && positioned)
+    {
+      const int64_t keyframe_pts_us = SeekToMediaTime(resume_pts_us + elapsed_us);
+      audio_block_fill_ = 0;
+      audio_base_pts_us_ = -1;
+      audio_samples_emitted_ = 0;
+      std::cout << "[VideoFileProducer] Woken after " << elapsed_us / 1000 << "ms, resuming at "
+                << resume_pts_us + elapsed_us << "us (keyframe at " << keyframe_pts_us << "us)"
+                << std::endl;
+    }
+    if (config_.pipelined_decode && decoder_initialized_ && !config_.stub_mode &&
+        !IsPassthroughActive())
+    {
+      StartPipeline();
+    }
+    EmitEvent("woken", "");
+  }
+
+  bool VideoFileProducer::OpenCodec(const AVCodec* codec, const AVCodecParameters* codecpar)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_)
+    {
+      std::cerr << "[VideoFileProducer] Failed to allocate codec context" << std::endl;
+      return false;
+    }
+
+    if (avcodec_parameters_to_context(codec_ctx_, codecpar) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to copy codec parameters" << std::endl;
+      return false;
+    }
+
+    ConfigureDecoderThreads();
+
+    if (config_.hw_accel_enabled && !InitializeHardwareDecoder())
+    {
+      std::cout << "[VideoFileProducer] No usable hardware decoder, using software decode"
+                << std::endl;
+    }
+    if (hw_device_ctx_ && config_.pipelined_decode)
+    {
+      // Frames queued between stages keep their GPU surfaces.
+      codec_ctx_->extra_hw_frames = static_cast<int>(config_.frame_queue_depth);
+    }
+    if (hw_device_ctx_ && config_.device_frames)
+    {
+      // ... and so do the frames out in the ring, the sink and the encoder.
+      codec_ctx_->extra_hw_frames = std::max(codec_ctx_->extra_hw_frames, 0) +
+                                    static_cast<int>(config_.device_frame_surfaces);
+    }
+
+    if (avcodec_open2(codec_ctx_, codec, nullptr) < 0)
+    {
+      if (!hw_device_ctx_)
+      {
+        std::cerr << "[VideoFileProducer] Failed to open codec" << std::endl;
+        return false;
+      }
+
+      // The device accepted the context but the codec would not open on it:
+      // rebuild a plain software context.
+      std::cerr << "[VideoFileProducer] Failed to open codec on hardware device, "
+                << "falling back to software decode" << std::endl;
+      avcodec_free_context(&codec_ctx_);
+      av_buffer_unref(&hw_device_ctx_);
+      hw_pix_fmt_ = -1;
+
+      codec_ctx_ = avcodec_alloc_context3(codec);
+      if (!codec_ctx_ || avcodec_parameters_to_context(codec_ctx_, codecpar) < 0)
+      {
+        std::cerr << "[VideoFileProducer] Failed to copy codec parameters" << std::endl;
+        return false;
+      }
+      ConfigureDecoderThreads();
+      if (avcodec_open2(codec_ctx_, codec, nullptr) < 0)
+      {
+        std::cerr << "[VideoFileProducer] Failed to open codec" << std::endl;
+        return false;
+      }
+    }
+    return true;
+#else
+    (void)codec;
+    (void)codecpar;
+    return false;
+#endif
+  }
+
+  void VideoFileProducer::ConfigureDecoderThreads()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    // An explicit budget keeps dozens of channels from each claiming every core.
+    codec_ctx_->thread_count = config_.decode_threads > 0 ? config_.decode_threads : 0;  // 0 = auto
+    switch (config_.decode_thread_type)
+    {
+      case decode::DecodeThreadType::kFrame:
+        codec_ctx_->thread_type = FF_THREAD_FRAME;
+        break;
+      case decode::DecodeThreadType::kSlice:
+        codec_ctx_->thread_type = FF_THREAD_SLICE;
+        break;
+      case decode::DecodeThreadType::kAuto:
+        codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        break;
+    }
+#endif
+  }
+
+  bool VideoFileProducer::UseScaler(const decode::ScalerKey& key)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (sws_ctx_ && key == scaler_key_)
+    {
+      return true;
+    }
+    ReleaseScaler();
+    if (config_.reuse_decoder_contexts)
+    {
+      sws_ctx_ = decode::DecoderContextPool::Instance().AcquireScaler(key);
+    }
+    else
+    {
+      sws_ctx_ = sws_getContext(
+          key.src_width, key.src_height, static_cast<AVPixelFormat>(key.src_format),
+          key.dst_width, key.dst_height, static_cast<AVPixelFormat>(key.dst_format),
+          key.flags, nullptr, nullptr, nullptr);
+    }
+    scaler_key_ = key;
+    return sws_ctx_ != nullptr;
+#else
+    (void)key;
+    return false;
+#endif
+  }
+
+  void VideoFileProducer::ReleaseScaler()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!sws_ctx_)
+    {
+      return;
+    }
+    if (config_.reuse_decoder_contexts)
+    {
+      decode::DecoderContextPool::Instance().ReleaseScaler(scaler_key_, &sws_ctx_);
+    }
+    else
+    {
+      sws_freeContext(sws_ctx_);
+      sws_ctx_ = nullptr;
+    }
+#endif
+  }
+
+  bool VideoFileProducer::InitializeHardwareDecoder()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    std::vector<std::string> candidates;
+    if (!config_.hw_device_type.empty())
+    {
+      candidates.push_back(config_.hw_device_type);
+    }
+    else
+    {
+      candidates.assign(std::begin(kAutoHwDeviceTypes), std::end(kAutoHwDeviceTypes));
+    }
+
+    for (const std::string& name : candidates)
+    {
+      const AVHWDeviceType type = av_hwdevice_find_type_by_name(name.c_str());
+      if (type == AV_HWDEVICE_TYPE_NONE)
+      {
+        std::cerr << "[VideoFileProducer] Unknown hardware device type: " << name << std::endl;
+        continue;
+      }
+
+      // The codec must expose a device-context decode path for this type.
+      int pix_fmt = AV_PIX_FMT_NONE;
+      for (int i = 0;; ++i)
+      {
+        const AVCodecHWConfig* hw_config = avcodec_get_hw_config(codec_ctx_->codec, i);
+        if (!hw_config)
+        {
+          break;
+        }
+        if ((hw_config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) &&
+            hw_config->device_type == type)
+        {
+          pix_fmt = hw_config->pix_fmt;
+          break;
+        }
+      }
+      if (pix_fmt == AV_PIX_FMT_NONE)
+      {
+        continue;
+      }
+
+      // Device frames are encoded on the shared device they were decoded on.
+      const char* device = config_.hw_device.empty() ? nullptr : config_.hw_device.c_str();
+      if (config_.device_frames)
+      {
+        hw_device_ctx_ = decode::AcquireSharedHwDevice(type, config_.hw_device);
+      }
+      else if (av_hwdevice_ctx_create(&hw_device_ctx_, type, device, nullptr, 0) < 0)
+      {
+        hw_device_ctx_ = nullptr;
+      }
+      if (!hw_device_ctx_)
+      {
+        std::cerr << "[VideoFileProducer] Failed to open " << name << " device" << std::endl;
+        continue;
+      }
+
+      codec_ctx_->hw_device_ctx = av_buffer_ref(hw_device_ctx_);
+      hw_pix_fmt_ = pix_fmt;
+      codec_ctx_->opaque = &hw_pix_fmt_;
+      codec_ctx_->get_format = SelectHwPixelFormat;
+      std::cout << "[VideoFileProducer] Hardware decode: " << name << " ("
+                << codec_ctx_->codec->name << ")" << std::endl;
+      return true;
+    }
+#endif
+    return false;
+  }
+
+  void VideoFileProducer::CloseDecoder()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    // Stage threads use the contexts below; join them first.
+    StopPipeline();
+    CloseAudioDecoder();
+    ClosePassthrough();
+
+    ReleaseScaler();
+
+    if (hw_transfer_frame_)
+    {
+      av_frame_free(&hw_transfer_frame_);
+      hw_transfer_frame_ = nullptr;
+    }
+
+    if (scaled_frame_)
+    {
+      if (scaled_frame_->data[0])
+      {
+        av_freep(&scaled_frame_->data[0]);
+      }
+      av_frame_free(&scaled_frame_);
+      scaled_frame_ = nullptr;
+    }
+
+    if (frame_)
+    {
+      av_frame_free(&frame_);
+      frame_ = nullptr;
+    }
+
+    if (packet_)
+    {
+      av_packet_free(&packet_);
+      packet_ = nullptr;
+    }
+
+    if (codec_ctx_ && decoder_pooled_)
+    {
+      decode::DecoderContextPool::Instance().ReleaseDecoder(decoder_key_, &codec_ctx_);
+    }
+    else if (codec_ctx_)
+    {
+      avcodec_free_context(&codec_ctx_);
+      codec_ctx_ = nullptr;
+    }
+    decoder_pooled_ = false;
+
+    if (hw_device_ctx_)
+    {
+      av_buffer_unref(&hw_device_ctx_);
+    }
+    hw_pix_fmt_ = -1;
+    hw_decode_active_.store(false, std::memory_order_release);
+    assemble_source_ = nullptr;
+    device_source_ = false;
+
+    if (format_ctx_)
+    {
+      avformat_close_input(&format_ctx_);
+      format_ctx_ = nullptr;
+    }
+
+    // Custom I/O outlives the format context that read through it.
+    decode::ReadAheadFile::FreeIOContext(&io_ctx_);
+    {
+      std::lock_guard<std::mutex> lock(read_ahead_mutex_);
+      read_ahead_.reset();
+    }
+
+    decoder_initialized_ = false;
+    video_stream_index_ = -1;
+    seek_target_pts_us_ = -1;
+    eof_reached_ = false;
+#endif
+  }
+
+  bool VideoFileProducer::ProduceRealFrame()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!decoder_initialized_)
+    {
+      return false;
+    }
+    if (IsPassthroughActive())
+    {
+      return ProducePassthroughFrame();
+    }
+
+    DrainAudioPackets();
+
+    // Decode ONE frame at a time (paced according to fake time)
+    switch (pipeline_ ? FetchPipelinedFrame() : FetchSerialFrame())
+    {
+      case FetchResult::kFrame:
+        break;
+      case FetchResult::kRetry:
+        return true;
+      case FetchResult::kEndOfStream:
+        FlushAudio();
+        eof_reached_ = true;
+        return false;
+      case FetchResult::kError:
+        return false;
+    }
+
+    // Join-in-progress: decode forward from the keyframe, but only emit
+    // frames from the requested offset on.
+    if (seek_target_pts_us_ >= 0)
+    {
+      const int64_t pts = frame_->pts != AV_NOPTS_VALUE ? frame_->pts : frame_->best_effort_timestamp;
+      if (pts != AV_NOPTS_VALUE &&
+          static_cast<int64_t>(pts * time_base_ * kMicrosecondsPerSecond) < seek_target_pts_us_)
+      {
+        return true;
+      }
+      seek_target_pts_us_ = -1;
+      if (!pipeline_)
+      {
+        codec_ctx_->skip_frame = AVDISCARD_DEFAULT;
+      }
+    }
+
+    // get_format may have fallen back to software for this stream.
+    if (hw_device_ctx_)
+    {
+      hw_decode_active_.store(frame_->format == hw_pix_fmt_, std::memory_order_release);
+    }
+
+    // Successfully decoded a frame - scale and assemble
+    cpu_meter_.Charge(telemetry::CpuStage::kDecode);
+    if (!ScaleFrame())
+    {
+      return false;
+    }
+
+    // Assemble directly into pooled memory so the consumer reads the payload
+    // in place. If every slot is still queued downstream, fall back to an
+    // unpooled frame rather than discarding a decoded picture.
+    buffer::FrameHandle handle = frame_pool_->Acquire();
+    if (!handle)
+    {
+      handle = buffer::FrameHandle::Adopt(buffer::Frame());
+    }
+    buffer::Frame& output_frame = *handle;
+    if (!AssembleFrame(output_frame))
+    {
+      return false;
+    }
+    TakeTrace(frame_, output_frame.metadata.trace);
+    output_frame.metadata.trace.Mark(buffer::FrameStage::kScaled);
+    cpu_meter_.Charge(telemetry::CpuStage::kScale);
+    return PushFrame(std::move(handle));
+#else
+    return false;
+#endif
+  }
+
+  bool VideoFileProducer::PushFrame(buffer::FrameHandle handle)
+  {
+    buffer::Frame& output_frame = *handle;
+
+    // Extract frame PTS in microseconds for pacing
     int64_t base_pts_us = output_frame.metadata.pts;
-    // Apply PTS offset for alignment
-    int64_t frame_pts_us = base_pts_us + pts_offset_us_;
+    int64_t frame_pts_us = 0;
+    {
+      // Apply PTS offset for alignment; AlignPTS() and GetNextPTS() run on
+      // the control thread
+      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+      frame_pts_us = base_pts_us + pts_offset_us_;
+      last_decoded_frame_pts_us_ = frame_pts_us;
+      last_pts_us_ = frame_pts_us;
+    }
     output_frame.metadata.pts = frame_pts_us;
-    last_decoded_frame_pts_us_ = frame_pts_us;
-    last_pts_us_ = frame_pts_us;
 
     // Establish time mapping on first frame
     if (first_frame_pts_us_ == 0)
     {
-      first_frame_pts_us_ = frame_pts_us;
-      if (master_clock_)
+      first_frame_pts_us_ = frame_pts_us;
+      if (master_clock_)
+      {
+        playback_start_utc_us_ = master_clock_->now_utc_us();
+      }
+    }
+
+    // Check if in shadow decode mode
+    if (ShadowStaging())
+    {
+      // Shadow mode: stage the frame for the switch, don't push to buffer
+      StageShadowFrame(std::move(handle), base_pts_us);
+      return true;
+    }
+
+    // Calculate target UTC time for this frame: playback_start + (frame_pts - first_frame_pts)
+    int64_t frame_offset_us = frame_pts_us - first_frame_pts_us_;
+    int64_t target_utc_us = playback_start_utc_us_ + frame_offset_us;
+
+    // Frame decoded and ready to push
+
+    // If using fake clock, wait until fake time reaches target UTC time before pushing
+    if (master_clock_ && master_clock_->is_fake())
+    {
+      int64_t now_us = master_clock_->now_utc_us();
+      if (now_us < target_utc_us)
+      {
+        // Wait until fake clock reaches target UTC time
+        while (master_clock_->now_utc_us() < target_utc_us &&
+               !stop_requested_.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();  // Busy-wait for fake clock to advance
+        }
+      }
+    }
+
+    // Attempt to push decoded frame
+    output_frame.metadata.trace.Mark(buffer::FrameStage::kPushed);
+    if (output_buffer_.Push(std::move(handle)))
+    {
+      frames_produced_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    else
+    {
+      // Buffer is full, back off
+      buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+      if (master_clock_)
+      {
+        int64_t now_utc_us = master_clock_->now_utc_us();
+        int64_t deadline_utc_us = now_utc_us + kProducerBackoffUs;
+        if (master_clock_->is_fake())
+        {
+          // For fake clock, busy-wait
+          while (master_clock_->now_utc_us() < deadline_utc_us && 
+                 !stop_requested_.load(std::memory_order_acquire))
+          {
+            std::this_thread::yield();
+          }
+        }
+        else
+        {
+          // Wake on the consumer's next pop instead of polling
+          output_buffer_.WaitForSpace(std::chrono::steady_clock::now() +
+                                      std::chrono::microseconds(kProducerBackoffUs));
+        }
+      }
+      else
+      {
+        output_buffer_.WaitForSpace(std::chrono::steady_clock::now() +
+                                    std::chrono::microseconds(kProducerBackoffUs));
+      }
+      // Retry on next iteration
+      return true;  // Frame was decoded successfully, just couldn't push
+    }
+  }
+
+  bool VideoFileProducer::InitializePassthrough()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    AVStream* stream = format_ctx_->streams[video_stream_index_];
+    const AVCodecParameters* codecpar = stream->codecpar;
+    decode::SourceStream source;
+    source.h264 = codecpar->codec_id == AV_CODEC_ID_H264;
+    source.profile = codecpar->profile;
+    source.level = codecpar->level;
+    source.width = codecpar->width;
+    source.height = codecpar->height;
+    source.sar_num = codecpar->sample_aspect_ratio.num;
+    source.sar_den = codecpar->sample_aspect_ratio.den;
+    source.interlaced = codecpar->field_order != AV_FIELD_PROGRESSIVE &&
+                        codecpar->field_order != AV_FIELD_UNKNOWN;
+    const AVRational rate =
+        stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+    source.fps = rate.num > 0 && rate.den > 0 ? av_q2d(rate) : 0.0;
+    source.reorder_depth = codecpar->video_delay;
+    source.max_gop_us = decode::LongestKeyframeInterval(keyframe_index_);
+
+    decode::PassthroughProfile profile = config_.passthrough_profile;
+    profile.width = config_.target_width;
+    profile.height = config_.target_height;
+    profile.fps = config_.target_fps;
+    const char* mismatch = decode::PassthroughMismatch(source, profile);
+    if (mismatch)
+    {
+      std::cout << "[VideoFileProducer] Transcoding " << config_.asset_uri << ": " << mismatch
+                << std::endl;
+      EmitEvent("transcode", mismatch);
+      return false;
+    }
+
+    // MP4/MKV carry length-prefixed NAL units; the muxer wants start codes,
+    // with the parameter sets ahead of each IDR (Annex B input passes as is)
+    const AVBitStreamFilter* filter = av_bsf_get_by_name("h264_mp4toannexb");
+    if (!filter || av_bsf_alloc(filter, &passthrough_bsf_) < 0 ||
+        avcodec_parameters_copy(passthrough_bsf_->par_in, codecpar) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Annex B filter unavailable, transcoding" << std::endl;
+      ClosePassthrough();
+      EmitEvent("transcode", "Annex B filter unavailable");
+      return false;
+    }
+    passthrough_bsf_->time_base_in = stream->time_base;
+    if (av_bsf_init(passthrough_bsf_) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to open the Annex B filter, transcoding" << std::endl;
+      ClosePassthrough();
+      EmitEvent("transcode", "Annex B filter failed");
+      return false;
+    }
+
+    passthrough_active_.store(true, std::memory_order_release);
+    passthrough_wait_keyframe_ = true;
+    passthrough_last_pts_us_ = -1;
+    std::cout << "[VideoFileProducer] Passing " << config_.asset_uri
+              << " through without transcoding" << std::endl;
+    EmitEvent("passthrough", "");
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void VideoFileProducer::ClosePassthrough()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    av_bsf_free(&passthrough_bsf_);
+#endif
+    passthrough_active_.store(false, std::memory_order_release);
+  }
+
+  void VideoFileProducer::FallBackToDecode(const char* reason)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    std::cerr << "[VideoFileProducer] Passthrough stopped (" << reason << "), transcoding "
+              << config_.asset_uri << std::endl;
+    EmitEvent("transcode", reason);
+
+    // Decode from the keyframe before the next frame due; audio already
+    // emitted is not emitted again
+    int64_t resume_pts_us = passthrough_last_pts_us_ + frame_interval_us_;
+    if (passthrough_last_pts_us_ < 0)
+    {
+      resume_pts_us = std::max<int64_t>(seek_target_pts_us_, 0);
+    }
+    const int64_t audio_end_us =
+        audio_base_pts_us_ < 0
+            ? -1
+            : audio_base_pts_us_ + (audio_samples_emitted_ + audio_block_fill_) *
+                                       kMicrosecondsPerSecond / kAudioOutputSampleRate;
+    ClosePassthrough();
+    SeekToMediaTime(resume_pts_us);
+    if (audio_codec_ctx_ && audio_end_us > audio_skip_until_us_)
+    {
+      audio_skip_until_us_ = audio_end_us;
+    }
+    if (config_.pipelined_decode)
+    {
+      StartPipeline();
+    }
+#else
+    (void)reason;
+#endif
+  }
+
+  bool VideoFileProducer::ProducePassthroughFrame()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    int ret = av_read_frame(format_ctx_, packet_);
+    if (ret == AVERROR_EOF)
+    {
+      FlushAudio();
+      eof_reached_ = true;
+      return false;
+    }
+    if (ret < 0)
+    {
+      av_packet_unref(packet_);
+      return false;  // Read error
+    }
+    if (packet_->stream_index == audio_stream_index_)
+    {
+      DecodeAudioPacket(packet_);
+      av_packet_unref(packet_);
+      return true;
+    }
+    if (packet_->stream_index != video_stream_index_)
+    {
+      av_packet_unref(packet_);
+      return true;
+    }
+
+    const bool keyframe = (packet_->flags & AV_PKT_FLAG_KEY) != 0;
+    const int64_t pts = packet_->pts != AV_NOPTS_VALUE ? packet_->pts : packet_->dts;
+    const int64_t dts = packet_->dts != AV_NOPTS_VALUE ? packet_->dts : pts;
+    if (pts == AV_NOPTS_VALUE)
+    {
+      av_packet_unref(packet_);
+      FallBackToDecode("packet without timestamps");
+      return true;
+    }
+    const int64_t pts_us = static_cast<int64_t>(pts * time_base_ * kMicrosecondsPerSecond);
+    const int64_t dts_us = static_cast<int64_t>(dts * time_base_ * kMicrosecondsPerSecond);
+
+    // Start (and join or wake) on a keyframe at or after the target: the
+    // frames before it would be sent without their references
+    if (passthrough_wait_keyframe_)
+    {
+      if (!keyframe || (seek_target_pts_us_ >= 0 && pts_us < seek_target_pts_us_))
+      {
+        av_packet_unref(packet_);
+        return true;
+      }
+      passthrough_wait_keyframe_ = false;
+      seek_target_pts_us_ = -1;
+    }
+
+    // Reordered packets (B-frames the stream parameters did not announce)
+    // cannot be paced in decode order
+    if (passthrough_last_pts_us_ >= 0 && pts_us <= passthrough_last_pts_us_)
+    {
+      av_packet_unref(packet_);
+      FallBackToDecode("packets out of presentation order");
+      return true;
+    }
+
+    buffer::FrameTrace trace;
+    if (config_.trace_sample_interval != 0 &&
+        video_packets_++ % config_.trace_sample_interval == 0)
+    {
+      trace.MarkAt(buffer::FrameStage::kDemuxed, buffer::FrameTrace::NowUs());
+    }
+
+    ret = av_bsf_send_packet(passthrough_bsf_, packet_);
+    if (ret < 0)
+    {
+      av_packet_unref(packet_);
+      return false;
+    }
+    if (av_bsf_receive_packet(passthrough_bsf_, packet_) < 0)
+    {
+      return true;  // The filter wants more input
+    }
+
+    buffer::FrameHandle handle = frame_pool_->Acquire();
+    if (!handle)
+    {
+      handle = buffer::FrameHandle::Adopt(buffer::Frame());
+    }
+    buffer::Frame& output_frame = *handle;
+    output_frame.Layout(buffer::PixelFormat::kH264, config_.target_width, config_.target_height);
+    output_frame.data.assign(packet_->data, packet_->data + packet_->size);
+    av_packet_unref(packet_);
+    output_frame.metadata.pts = pts_us;
+    output_frame.metadata.dts = std::min(dts_us, pts_us);
+    output_frame.metadata.duration = 1.0 / config_.target_fps;
+    output_frame.metadata.asset_id = asset_id_;
+    output_frame.metadata.splice_point = false;
+    output_frame.metadata.asset_start = std::exchange(asset_start_pending_, false);
+    output_frame.metadata.keyframe = keyframe;
+    output_frame.metadata.trace = trace;
+    passthrough_last_pts_us_ = pts_us;
+    return PushFrame(std::move(handle));
+#else
+    return false;
+#endif
+  }
+
+  VideoFileProducer::FetchResult VideoFileProducer::FetchSerialFrame()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    // Read packet
+    int ret = av_read_frame(format_ctx_, packet_);
+    
+    if (ret == AVERROR_EOF)
+    {
+      return FetchResult::kEndOfStream;
+    }
+    
+    if (ret < 0)
+    {
+      av_packet_unref(packet_);
+      return FetchResult::kError;  // Read error
+    }
+
+    if (packet_->stream_index == audio_stream_index_)
+    {
+      DecodeAudioPacket(packet_);
+      av_packet_unref(packet_);
+      return FetchResult::kRetry;
+    }
+
+    // Check if packet is from video stream
+    if (packet_->stream_index != video_stream_index_)
+    {
+      av_packet_unref(packet_);
+      return FetchResult::kRetry;  // Skip non-video packets, try again
+    }
+
+    StampDemuxed(packet_);
+
+    // Send packet to decoder
+    ret = avcodec_send_packet(codec_ctx_, packet_);
+    av_packet_unref(packet_);
+    
+    if (ret < 0)
+    {
+      return FetchResult::kError;  // Decode error
+    }
+
+    // Receive decoded frame
+    ret = avcodec_receive_frame(codec_ctx_, frame_);
+    
+    if (ret == AVERROR(EAGAIN))
+    {
+      return FetchResult::kRetry;  // Need more packets, try again
+    }
+    
+    if (ret < 0)
+    {
+      return FetchResult::kError;  // Decode error
+    }
+    StampDecoded(frame_);
+    return FetchResult::kFrame;
+#else
+    return FetchResult::kError;
+#endif
+  }
+
+  VideoFileProducer::FetchResult VideoFileProducer::FetchPipelinedFrame()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    AVFrame* decoded = nullptr;
+    switch (pipeline_->frames.Pop(decoded, kStageWaitTimeout))
+    {
+      case StageResult::kItem:
+        break;
+      case StageResult::kTimeout:
+        return FetchResult::kRetry;  // Decode stage behind; loop re-checks stop/teardown
+      case StageResult::kClosed:
+        return FetchResult::kEndOfStream;
+    }
+
+    av_frame_unref(frame_);
+    av_frame_move_ref(frame_, decoded);
+    av_frame_free(&decoded);
+    return FetchResult::kFrame;
+#else
+    return FetchResult::kError;
+#endif
+  }
+
+  void VideoFileProducer::StartPipeline()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    pipeline_ = std::make_unique<DecodePipeline>(config_.packet_queue_depth,
+                                                 config_.frame_queue_depth);
+    pipeline_->demux_thread = std::thread(&VideoFileProducer::DemuxLoop, this);
+    pipeline_->decode_thread = std::thread(&VideoFileProducer::DecodeLoop, this);
+    std::cout << "[VideoFileProducer] Staged decode started (packets="
+              << config_.packet_queue_depth << ", frames=" << config_.frame_queue_depth
+              << ")" << std::endl;
+#endif
+  }
+
+  void VideoFileProducer::StopPipeline()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!pipeline_)
+    {
+      return;
+    }
+
+    pipeline_->packets.Abort();
+    pipeline_->audio_packets.Abort();
+    pipeline_->frames.Abort();
+    if (pipeline_->demux_thread.joinable())
+    {
+      pipeline_->demux_thread.join();
+    }
+    if (pipeline_->decode_thread.joinable())
+    {
+      pipeline_->decode_thread.join();
+    }
+    pipeline_.reset();
+#endif
+  }
+
+  void VideoFileProducer::DemuxLoop()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    telemetry::NameCurrentThread(config_.channel_id, "demux");
+    telemetry::StageCpuMeter cpu_meter(config_.cpu_account);
+    DecodePipeline& pipeline = *pipeline_;
+    while (true)
+    {
+      AVPacket* packet = av_packet_alloc();
+      if (!packet)
+      {
+        break;
+      }
+
+      const int ret = av_read_frame(format_ctx_, packet);
+      if (ret == AVERROR(EAGAIN))
+      {
+        av_packet_free(&packet);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      if (ret < 0)
+      {
+        av_packet_free(&packet);
+        if (ret != AVERROR_EOF)
+        {
+          std::cerr << "[VideoFileProducer] Demux read error, ending stream" << std::endl;
+        }
+        break;
+      }
+
+      StageQueue<AVPacket, av_packet_free>* queue = nullptr;
+      if (packet->stream_index == video_stream_index_)
+      {
+        StampDemuxed(packet);
+        queue = &pipeline.packets;
+      }
+      else if (packet->stream_index == audio_stream_index_)
+      {
+        queue = &pipeline.audio_packets;
+      }
+      if (!queue)
+      {
+        av_packet_free(&packet);
+        continue;
+      }
+
+      cpu_meter.Charge(telemetry::CpuStage::kDecode);
+      if (!queue->Push(packet))
+      {
+        av_packet_free(&packet);  // Pipeline aborted
+        break;
+      }
+    }
+    pipeline.packets.Finish();
+    pipeline.audio_packets.Finish();
+#endif
+  }
+
+  void VideoFileProducer::DecodeLoop()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    telemetry::NameCurrentThread(config_.channel_id, "decode");
+    telemetry::StageCpuMeter cpu_meter(config_.cpu_account);
+    DecodePipeline& pipeline = *pipeline_;
+    AVFrame* decoded = av_frame_alloc();
+    bool flushing = false;
+
+    while (decoded)
+    {
+      AVPacket* packet = nullptr;
+      if (!flushing)
+      {
+        const StageResult result = pipeline.packets.Pop(packet, kStageWaitTimeout);
+        if (result == StageResult::kTimeout)
+        {
+          continue;
+        }
+        if (result == StageResult::kClosed)
+        {
+          if (pipeline.packets.IsAborted())
+          {
+            break;
+          }
+          flushing = true;  // End of input: a null packet drains delayed frames
+        }
+      }
+
+      int ret = avcodec_send_packet(codec_ctx_, packet);
+      if (packet)
+      {
+        av_packet_free(&packet);
+      }
+      if (ret < 0 && ret != AVERROR_EOF)
+      {
+        decode_errors_.fetch_add(1, std::memory_order_relaxed);
+        if (flushing)
+        {
+          break;
+        }
+        continue;
+      }
+
+      // One packet can yield several frames (and threaded decoders release
+      // them in bursts); hand every one to the scale stage.
+      while ((ret = avcodec_receive_frame(codec_ctx_, decoded)) >= 0)
+      {
+        StampDecoded(decoded);
+        cpu_meter.Charge(telemetry::CpuStage::kDecode);
+        if (!pipeline.frames.Push(decoded))
+        {
+          av_frame_free(&decoded);  // Pipeline aborted
+          break;
+        }
+        decoded = av_frame_alloc();
+        if (!decoded)
+        {
+          break;
+        }
+      }
+
+      if (ret == AVERROR_EOF)
+      {
+        break;  // Fully drained
+      }
+      if (ret < 0 && ret != AVERROR(EAGAIN))
+      {
+        decode_errors_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    if (decoded)
+    {
+      av_frame_free(&decoded);
+    }
+    pipeline.frames.Finish();
+#endif
+  }
+
+  bool VideoFileProducer::InitializeAudioDecoder()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    int index = -1;
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
+    {
+      if (format_ctx_->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+      {
+        index = static_cast<int>(i);
+        break;
+      }
+    }
+    if (index < 0)
+    {
+      std::cout << "[VideoFileProducer] No audio stream, playing video only" << std::endl;
+      return false;
+    }
+
+    AVStream* stream = format_ctx_->streams[index];
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec)
+    {
+      std::cerr << "[VideoFileProducer] Audio codec not found: " << stream->codecpar->codec_id
+                << std::endl;
+      return false;
+    }
+    audio_codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!audio_codec_ctx_ ||
+        avcodec_parameters_to_context(audio_codec_ctx_, stream->codecpar) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to copy audio codec parameters" << std::endl;
+      CloseAudioDecoder();
+      return false;
+    }
+    audio_codec_ctx_->pkt_timebase = stream->time_base;
+    if (avcodec_open2(audio_codec_ctx_, codec, nullptr) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to open audio codec" << std::endl;
+      CloseAudioDecoder();
+      return false;
+    }
+    audio_frame_ = av_frame_alloc();
+    if (!audio_frame_)
+    {
+      std::cerr << "[VideoFileProducer] Failed to allocate audio frame" << std::endl;
+      CloseAudioDecoder();
+      return false;
+    }
+
+    // Resampler to the output format. Streams that only carry a channel
+    // count get the default layout for it.
+    AVChannelLayout src_layout;
+    AVChannelLayout dst_layout;
+    if (audio_codec_ctx_->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC)
+    {
+      av_channel_layout_default(&src_layout, audio_codec_ctx_->ch_layout.nb_channels);
+    }
+    else if (av_channel_layout_copy(&src_layout, &audio_codec_ctx_->ch_layout) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to copy audio channel layout" << std::endl;
+      CloseAudioDecoder();
+      return false;
+    }
+    const int out_channels = audio_codec_ctx_->ch_layout.nb_channels == kAudioSurroundChannels
+                                 ? kAudioSurroundChannels
+                                 : kAudioOutputChannels;
+    av_channel_layout_default(&dst_layout, out_channels);
+    const bool resampler_ok =
+        swr_alloc_set_opts2(&swr_ctx_,
+                            &dst_layout, AV_SAMPLE_FMT_S16, kAudioOutputSampleRate,
+                            &src_layout, audio_codec_ctx_->sample_fmt,
+                            audio_codec_ctx_->sample_rate, 0, nullptr) == 0 &&
+        swr_init(swr_ctx_) >= 0;
+    av_channel_layout_uninit(&src_layout);
+    av_channel_layout_uninit(&dst_layout);
+    if (!resampler_ok)
+    {
+      std::cerr << "[VideoFileProducer] Failed to initialize audio resampler" << std::endl;
+      CloseAudioDecoder();
+      return false;
+    }
+
+    // Every block has the same size, so ring slots keep their capacity and
+    // pushing a block never reallocates once the lane has cycled.
+    audio_block_.data.assign(
+        static_cast<size_t>(kAudioBlockSamples) * out_channels * sizeof(int16_t), 0);
+    audio_block_.sample_rate = kAudioOutputSampleRate;
+    audio_block_.channels = out_channels;
+    audio_block_.nb_samples = kAudioBlockSamples;
+    audio_block_fill_ = 0;
+    audio_base_pts_us_ = -1;
+    audio_samples_emitted_ = 0;
+    audio_skip_until_us_ = -1;
+    audio_time_base_ = av_q2d(stream->time_base);
+    audio_stream_index_ = index;
+
+    std::cout << "[VideoFileProducer] Audio: " << codec->name << " "
+              << audio_codec_ctx_->sample_rate << " Hz, "
+              << audio_codec_ctx_->ch_layout.nb_channels << " ch -> "
+              << kAudioOutputSampleRate << " Hz " << out_channels << " ch, " << kAudioBlockSamples
+              << "-sample blocks" << std::endl;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void VideoFileProducer::CloseAudioDecoder()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (swr_ctx_)
+    {
+      swr_free(&swr_ctx_);
+    }
+    if (audio_frame_)
+    {
+      av_frame_free(&audio_frame_);
+    }
+    if (audio_codec_ctx_)
+    {
+      avcodec_free_context(&audio_codec_ctx_);
+    }
+#endif
+    audio_stream_index_ = -1;
+    audio_block_fill_ = 0;
+    audio_base_pts_us_ = -1;
+    audio_samples_emitted_ = 0;
+    audio_skip_until_us_ = -1;
+  }
+
+  void VideoFileProducer::DecodeAudioPacket(const AVPacket* packet)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!audio_codec_ctx_)
+    {
+      return;
+    }
+    if (avcodec_send_packet(audio_codec_ctx_, packet) < 0)
+    {
+      if (packet)
       {
-        playback_start_utc_us_ = master_clock_->now_utc_us();
+        decode_errors_.fetch_add(1, std::memory_order_relaxed);
       }
+      return;
     }
 
-    // Check if in shadow decode mode
-    bool shadow_mode = shadow_decode_mode_.load(std::memory_order_acquire);
-    if (shadow_mode)
+    while (avcodec_receive_frame(audio_codec_ctx_, audio_frame_) >= 0)
     {
-      // Shadow mode: cache first frame, don't push to buffer
-      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
-      if (!cached_first_frame_)
+      const int64_t ts = audio_frame_->best_effort_timestamp != AV_NOPTS_VALUE
+                             ? audio_frame_->best_effort_timestamp
+                             : audio_frame_->pts;
+      const int64_t pts_us =
+          ts != AV_NOPTS_VALUE
+              ? static_cast<int64_t>(ts * audio_time_base_ * kMicrosecondsPerSecond)
+              : 0;
+
+      // Join-in-progress: drop audio that ends before the start offset
+      if (audio_skip_until_us_ >= 0 && ts != AV_NOPTS_VALUE && audio_frame_->sample_rate > 0)
       {
-        cached_first_frame_ = std::make_unique<buffer::Frame>(output_frame);
-        shadow_decode_ready_.store(true, std::memory_order_release);
-        std::cout << "[VideoFileProducer] Shadow decode: first frame cached, PTS=" 
-                  << frame_pts_us << std::endl;
-        // Emit ShadowDecodeReady event
-        EmitEvent("ShadowDecodeReady", "");
+        const int64_t end_us = pts_us + static_cast<int64_t>(audio_frame_->nb_samples) *
+                                            kMicrosecondsPerSecond / audio_frame_->sample_rate;
+        if (end_us <= audio_skip_until_us_)
+        {
+          av_frame_unref(audio_frame_);
+          continue;
+        }
       }
-      // Don't push to buffer in shadow mode, but continue decoding
-      return true;
+      audio_skip_until_us_ = -1;
+
+      // Blocks are timed by sample count from the first one, so the lane has
+      // no jitter from packet timestamps.
+      if (audio_base_pts_us_ < 0)
+      {
+        audio_base_pts_us_ = pts_us;
+      }
+      ResampleAudio(audio_frame_);
+      av_frame_unref(audio_frame_);
     }
+#else
+    (void)packet;
+#endif
+  }
 
-    // Calculate target UTC time for this frame: playback_start + (frame_pts - first_frame_pts)
-    int64_t frame_offset_us = frame_pts_us - first_frame_pts_us_;
-    int64_t target_utc_us = playback_start_utc_us_ + frame_offset_us;
+  void VideoFileProducer::ResampleAudio(const AVFrame* frame)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    const int in_samples = frame ? frame->nb_samples : 0;
+    const int max_out = swr_get_out_samples(swr_ctx_, in_samples);
+    if (max_out <= 0)
+    {
+      return;
+    }
+    const size_t bytes_per_sample = static_cast<size_t>(audio_block_.channels) * sizeof(int16_t);
+    const size_t max_bytes = static_cast<size_t>(max_out) * bytes_per_sample;
+    if (audio_scratch_.size() < max_bytes)
+    {
+      audio_scratch_.resize(max_bytes);
+    }
 
-    // Frame decoded and ready to push
+    uint8_t* out[1] = {audio_scratch_.data()};
+    const int converted = swr_convert(
+        swr_ctx_, out, max_out,
+        frame ? const_cast<const uint8_t**>(frame->extended_data) : nullptr, in_samples);
+    if (converted < 0)
+    {
+      std::cerr << "[VideoFileProducer] Audio resampling failed" << std::endl;
+      decode_errors_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
 
-    // If using fake clock, wait until fake time reaches target UTC time before pushing
-    if (master_clock_ && master_clock_->is_fake())
+    // Batch into fixed blocks; a packet's samples may span two of them.
+    const uint8_t* src = audio_scratch_.data();
+    int remaining = converted;
+    while (remaining > 0)
     {
-      int64_t now_us = master_clock_->now_utc_us();
-      if (now_us < target_utc_us)
+      const int take = std::min(remaining, kAudioBlockSamples - audio_block_fill_);
+      std::memcpy(audio_block_.data.data() + audio_block_fill_ * bytes_per_sample, src,
+                  take * bytes_per_sample);
+      audio_block_fill_ += take;
+      src += take * bytes_per_sample;
+      remaining -= take;
+      if (audio_block_fill_ == kAudioBlockSamples)
       {
-        // Wait until fake clock reaches target UTC time
-        while (master_clock_->now_utc_us() < target_utc_us &&
-               !stop_requested_.load(std::memory_order_acquire))
-        {
-          std::this_thread::yield();  // Busy-wait for fake clock to advance
-        }
+        EmitAudioBlock();
       }
     }
+#else
+    (void)frame;
+#endif
+  }
 
-    // Attempt to push decoded frame
-    if (output_buffer_.Push(output_frame))
+  void VideoFileProducer::EmitAudioBlock()
+  {
+    const int64_t block_pts_us =
+        audio_base_pts_us_ + audio_samples_emitted_ * kMicrosecondsPerSecond / kAudioOutputSampleRate;
+    audio_samples_emitted_ += kAudioBlockSamples;
+    audio_block_fill_ = 0;
+
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    audio_block_.pts_us = block_pts_us + pts_offset_us_;
+    // Stage with the preroll, and keep staging until it has been spliced so
+    // live audio never overtakes it.
+    if (shadow_decode_mode_.load(std::memory_order_acquire) || !shadow_audio_.empty())
     {
-      frames_produced_.fetch_add(1, std::memory_order_relaxed);
-      return true;
+      shadow_audio_.push_back(audio_block_);
+      return;
+    }
+    if (output_buffer_.PushAudioFrame(audio_block_))
+    {
+      audio_blocks_produced_.fetch_add(1, std::memory_order_relaxed);
     }
     else
     {
-      // Buffer is full, back off
-      buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
-      if (master_clock_)
+      audio_blocks_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void VideoFileProducer::DrainAudioPackets()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!pipeline_ || !audio_codec_ctx_)
+    {
+      return;
+    }
+    AVPacket* packet = nullptr;
+    while (pipeline_->audio_packets.Pop(packet, std::chrono::milliseconds(0)) ==
+           StageResult::kItem)
+    {
+      DecodeAudioPacket(packet);
+      av_packet_free(&packet);
+    }
+#endif
+  }
+
+  void VideoFileProducer::FlushAudio()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!audio_codec_ctx_)
+    {
+      return;
+    }
+    DrainAudioPackets();
+    DecodeAudioPacket(nullptr);
+    ResampleAudio(nullptr);
+    if (audio_block_fill_ > 0)
+    {
+      const size_t bytes_per_sample =
+          static_cast<size_t>(audio_block_.channels) * sizeof(int16_t);
+      std::memset(audio_block_.data.data() + audio_block_fill_ * bytes_per_sample, 0,
+                  (kAudioBlockSamples - audio_block_fill_) * bytes_per_sample);
+      EmitAudioBlock();
+    }
+#endif
+  }
+
+  bool VideoFileProducer::ScaleFrame()
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (!frame_ || !scaled_frame_)
+    {
+      return false;
+    }
+
+    // A GPU surface at the target size stays on the GPU while the decoder
+    // has surfaces to spare.
+    device_source_ = false;
+    if (config_.device_frames && hw_transfer_frame_ && frame_->format == hw_pix_fmt_)
+    {
+      if (frame_->width == config_.target_width && frame_->height == config_.target_height &&
+          device_frames_in_flight_->load(std::memory_order_relaxed) <
+              static_cast<int>(config_.device_frame_surfaces))
       {
-        int64_t now_utc_us = master_clock_->now_utc_us();
-        int64_t deadline_utc_us = now_utc_us + kProducerBackoffUs;
-        if (master_clock_->is_fake())
-        {
-          // For fake clock, busy-wait
-          while (master_clock_->now_utc_us() < deadline_utc_us && 
-                 !stop_requested_.load(std::memory_order_acquire))
-          {
-            std::this_thread::yield();
-          }
-        }
-        else
-        {
-          while (master_clock_->now_utc_us() < deadline_utc_us && 
-                 !stop_requested_.load(std::memory_order_acquire))
-          {
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-          }
-        }
+        device_source_ = true;
+        return true;
       }
-      else
+      device_frame_downloads_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const AVFrame* source = frame_;
+    if (hw_transfer_frame_ && frame_->format == hw_pix_fmt_)
+    {
+      // Download the GPU surface into system memory for the scaler.
+      av_frame_unref(hw_transfer_frame_);
+      if (av_hwframe_transfer_data(hw_transfer_frame_, frame_, 0) < 0)
       {
-        std::this_thread::sleep_for(std::chrono::microseconds(kProducerBackoffUs));
+        std::cerr << "[VideoFileProducer] Failed to transfer hardware frame" << std::endl;
+        return false;
       }
-      // Retry on next iteration
-      return true;  // Frame was decoded successfully, just couldn't push
+      source = hw_transfer_frame_;
+    }
+
+    // 10-bit sources stay 10-bit when configured
+    const AVPixFmtDescriptor* source_desc =
+        av_pix_fmt_desc_get(static_cast<AVPixelFormat>(source->format));
+    const bool keep_depth =
+        config_.high_bit_depth && source_desc && source_desc->comp[0].depth > 8;
+
+    // Fast path: yuv420p/nv12/p010 at the target geometry, which
+    // AssembleFrame() copies as is, or within a 2:1 downscale of it, which
+    // it packs (and scales) into I420 with the SIMD plane kernels straight
+    // from the decoded planes.
+    decode::PlanarImage image;
+    if (decode::DescribeFrame(source, &image) &&
+        decode::CanPackI420(image, config_.target_width, config_.target_height))
+    {
+      const bool same_size =
+          image.width == config_.target_width && image.height == config_.target_height;
+      if (same_size || !keep_depth)
+      {
+        assemble_source_ = source;
+        return true;
+      }
+    }
+
+    const AVPixelFormat scaled_format = keep_depth ? AV_PIX_FMT_P010LE : AV_PIX_FMT_YUV420P;
+    if (scaled_frame_->format != scaled_format && !AllocateScaledFrame(scaled_format))
+    {
+      return false;
+    }
+
+    // Reuses the context while the source geometry and format are unchanged.
+    decode::ScalerKey scaler_key;
+    scaler_key.src_width = source->width;
+    scaler_key.src_height = source->height;
+    scaler_key.src_format = source->format;
+    scaler_key.dst_width = config_.target_width;
+    scaler_key.dst_height = config_.target_height;
+    scaler_key.dst_format = scaled_format;
+    scaler_key.flags = SWS_BILINEAR;
+    if (!UseScaler(scaler_key))
+    {
+      std::cerr << "[VideoFileProducer] Failed to create scaler context" << std::endl;
+      return false;
     }
+
+    sws_scale(sws_ctx_,
+              source->data, source->linesize, 0, source->height,
+              scaled_frame_->data, scaled_frame_->linesize);
+    assemble_source_ = scaled_frame_;
+    return true;
 #else
     return false;
 #endif
   }
 
-  bool VideoFileProducer::ScaleFrame()
+  void VideoFileProducer::StampDemuxed(const AVPacket* packet)
   {
 #ifdef RETROVUE_FFMPEG_AVAILABLE
-    if (!sws_ctx_ || !frame_ || !scaled_frame_)
+    if (config_.trace_sample_interval == 0 || packet->pts == AV_NOPTS_VALUE ||
+        video_packets_++ % config_.trace_sample_interval != 0)
     {
-      return false;
+      return;
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    PacketTrace& entry = pending_traces_[next_pending_trace_];
+    next_pending_trace_ = (next_pending_trace_ + 1) % kPendingTraces;
+    if (entry.demuxed_us == 0)
+    {
+      pending_trace_count_.fetch_add(1, std::memory_order_relaxed);
     }
+    entry.pts = packet->pts;
+    entry.demuxed_us = buffer::FrameTrace::NowUs();
+    entry.decoded_us = 0;
+#else
+    (void)packet;
+#endif
+  }
 
-    sws_scale(sws_ctx_, 
-              frame_->data, frame_->linesize, 0, codec_ctx_->height,
-              scaled_frame_->data, scaled_frame_->linesize);
+  void VideoFileProducer::StampDecoded(const AVFrame* frame)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (pending_trace_count_.load(std::memory_order_relaxed) == 0 || frame->pts == AV_NOPTS_VALUE)
+    {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    for (PacketTrace& entry : pending_traces_)
+    {
+      if (entry.demuxed_us != 0 && entry.pts == frame->pts)
+      {
+        entry.decoded_us = buffer::FrameTrace::NowUs();
+        return;
+      }
+    }
+#else
+    (void)frame;
+#endif
+  }
+
+  void VideoFileProducer::TakeTrace(const AVFrame* frame, buffer::FrameTrace& trace)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (pending_trace_count_.load(std::memory_order_relaxed) == 0 || frame->pts == AV_NOPTS_VALUE)
+    {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    for (PacketTrace& entry : pending_traces_)
+    {
+      if (entry.demuxed_us != 0 && entry.pts == frame->pts)
+      {
+        trace.MarkAt(buffer::FrameStage::kDemuxed, entry.demuxed_us);
+        trace.MarkAt(buffer::FrameStage::kDecoded, entry.decoded_us);
+        entry.demuxed_us = 0;
+        pending_trace_count_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+#else
+    (void)frame;
+    (void)trace;
+#endif
+  }
+
+  bool VideoFileProducer::AllocateScaledFrame(int pix_fmt)
+  {
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+    if (scaled_frame_->data[0])
+    {
+      av_freep(&scaled_frame_->data[0]);
+    }
+    if (av_image_alloc(scaled_frame_->data, scaled_frame_->linesize, config_.target_width,
+                       config_.target_height, static_cast<AVPixelFormat>(pix_fmt), 32) < 0)
+    {
+      std::cerr << "[VideoFileProducer] Failed to allocate scaled frame buffer" << std::endl;
+      return false;
+    }
+    scaled_frame_->width = config_.target_width;
+    scaled_frame_->height = config_.target_height;
+    scaled_frame_->format = pix_fmt;
     return true;
 #else
+    (void)pix_fmt;
     return false;
 #endif
   }
@@ -690,15 +2480,13 @@ namespace retrovue::producers::video_file
   bool VideoFileProducer::AssembleFrame(buffer::Frame& output_frame)
   {
 #ifdef RETROVUE_FFMPEG_AVAILABLE
-    if (!scaled_frame_)
+    decode::PlanarImage source;
+    if (!device_source_ &&
+        (!assemble_source_ || !decode::DescribeFrame(assemble_source_, &source)))
     {
       return false;
     }
 
-    // Set frame dimensions
-    output_frame.width = config_.target_width;
-    output_frame.height = config_.target_height;
-
     // Calculate PTS/DTS in microseconds
     // Use frame PTS (from decoded frame) or best_effort_timestamp
     int64_t pts = frame_->pts != AV_NOPTS_VALUE ? frame_->pts : frame_->best_effort_timestamp;
@@ -708,12 +2496,13 @@ namespace retrovue::producers::video_file
     int64_t pts_us = static_cast<int64_t>(pts * time_base_ * kMicrosecondsPerSecond);
     int64_t dts_us = static_cast<int64_t>(dts * time_base_ * kMicrosecondsPerSecond);
 
-    // Ensure PTS monotonicity
-    if (pts_us <= last_pts_us_)
+    // Ensure PTS monotonicity (last_pts_us_ has the alignment offset applied;
+    // compare in media time)
+    const int64_t last_media_pts_us = last_pts_us_ - pts_offset_us_;
+    if (pts_us <= last_media_pts_us)
     {
-      pts_us = last_pts_us_ + frame_interval_us_;
+      pts_us = last_media_pts_us + frame_interval_us_;
     }
-    last_pts_us_ = pts_us;
 
     // Ensure DTS <= PTS
     if (dts_us > pts_us)
@@ -724,41 +2513,38 @@ namespace retrovue::producers::video_file
     output_frame.metadata.pts = pts_us;
     output_frame.metadata.dts = dts_us;
     output_frame.metadata.duration = 1.0 / config_.target_fps;
-    output_frame.metadata.asset_uri = config_.asset_uri;
-
-    // Copy YUV420 planar data
-    int y_size = config_.target_width * config_.target_height;
-    int uv_size = (config_.target_width / 2) * (config_.target_height / 2);
-    int total_size = y_size + 2 * uv_size;
+    output_frame.metadata.asset_id = asset_id_;
+    output_frame.metadata.splice_point = false;  // Pooled frames keep the last use's mark
+    output_frame.metadata.asset_start = std::exchange(asset_start_pending_, false);
+    output_frame.metadata.keyframe = false;
+    output_frame.metadata.trace = buffer::FrameTrace();
 
-    output_frame.data.resize(total_size);
-
-    // Copy Y plane
-    uint8_t* dst = output_frame.data.data();
-    for (int y = 0; y < config_.target_height; y++)
-    {
-      std::memcpy(dst + y * config_.target_width,
-                  scaled_frame_->data[0] + y * scaled_frame_->linesize[0],
-                  config_.target_width);
-    }
-
-    // Copy U plane
-    dst += y_size;
-    for (int y = 0; y < config_.target_height / 2; y++)
+    if (device_source_)
     {
-      std::memcpy(dst + y * (config_.target_width / 2),
-                  scaled_frame_->data[1] + y * scaled_frame_->linesize[1],
-                  config_.target_width / 2);
+      if (!decode::WrapDeviceSurface(frame_, device_frames_in_flight_, &output_frame))
+      {
+        return false;
+      }
+      device_frames_produced_.fetch_add(1, std::memory_order_relaxed);
+      return true;
     }
 
-    // Copy V plane
-    dst += uv_size;
-    for (int y = 0; y < config_.target_height / 2; y++)
+    // Pictures at the target size keep their layout (P010 only when
+    // configured); the rest are scaled into I420. Pooled frames are
+    // preallocated, so laying out the planes does not reallocate.
+    const bool same_size =
+        source.width == config_.target_width && source.height == config_.target_height;
+    if (same_size && (source.layout != decode::PlanarLayout::kP010 || config_.high_bit_depth))
     {
-      std::memcpy(dst + y * (config_.target_width / 2),
-                  scaled_frame_->data[2] + y * scaled_frame_->linesize[2],
-                  config_.target_width / 2);
+      decode::CopyToFrame(source, &output_frame);
+      return true;
     }
+    output_frame.Layout(buffer::PixelFormat::kI420, config_.target_width, config_.target_height);
+    uint8_t* const planes[3] = {output_frame.Plane(0), output_frame.Plane(1),
+                                output_frame.Plane(2)};
+    const int strides[3] = {output_frame.Stride(0), output_frame.Stride(1),
+                            output_frame.Stride(2)};
+    decode::PackI420(source, config_.target_width, config_.target_height, planes, strides);
 
     return true;
 #else
@@ -813,34 +2599,26 @@ namespace retrovue::producers::video_file
     
     int64_t pts_counter = stub_pts_counter_.fetch_add(1, std::memory_order_relaxed);
     int64_t base_pts = pts_counter * frame_interval_us_;
-    frame.metadata.pts = base_pts + pts_offset_us_;  // Apply PTS offset for alignment
+    {
+      // Apply PTS offset for alignment and track it, under the lock
+      // AlignPTS() and GetNextPTS() take
+      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+      frame.metadata.pts = base_pts + pts_offset_us_;
+      last_pts_us_ = frame.metadata.pts;
+    }
     frame.metadata.dts = frame.metadata.pts;
     frame.metadata.duration = 1.0 / config_.target_fps;
-    frame.metadata.asset_uri = config_.asset_uri;
-
-    // Update last_pts_us_ for PTS tracking
-    last_pts_us_ = frame.metadata.pts;
+    frame.metadata.asset_id = asset_id_;
 
     // Generate YUV420 planar data (stub: all zeros for now)
     size_t frame_size = static_cast<size_t>(config_.target_width * config_.target_height * 1.5);
     frame.data.resize(frame_size, 0);
 
     // Check if in shadow decode mode
-    bool shadow_mode = shadow_decode_mode_.load(std::memory_order_acquire);
-    if (shadow_mode)
+    if (ShadowStaging())
     {
-      // Shadow mode: cache first frame, don't push to buffer
-      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
-      if (!cached_first_frame_)
-      {
-        cached_first_frame_ = std::make_unique<buffer::Frame>(frame);
-        shadow_decode_ready_.store(true, std::memory_order_release);
-        std::cout << "[VideoFileProducer] Shadow decode: first frame cached, PTS=" 
-                  << frame.metadata.pts << std::endl;
-        // Emit ShadowDecodeReady event
-        EmitEvent("ShadowDecodeReady", "");
-      }
-      // Don't push to buffer in shadow mode
+      // Shadow mode: stage the frame for the switch, don't push to buffer
+      StageShadowFrame(buffer::FrameHandle::Adopt(std::move(frame)), base_pts);
       return;
     }
 
@@ -853,9 +2631,9 @@ namespace retrovue::producers::video_file
     {
       // Buffer is full, back off
       buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
-      if (master_clock_)
+      if (master_clock_ && master_clock_->is_fake())
       {
-        // Wait using master clock if available
+        // Wait using master clock for deterministic tests
         int64_t now_utc_us = master_clock_->now_utc_us();
         int64_t deadline_utc_us = now_utc_us + kProducerBackoffUs;
         while (master_clock_->now_utc_us() < deadline_utc_us && 
@@ -866,28 +2644,134 @@ namespace retrovue::producers::video_file
       }
       else
       {
-        std::this_thread::sleep_for(std::chrono::microseconds(kProducerBackoffUs));
+        // Wake on the consumer's next pop instead of sleeping the full backoff
+        output_buffer_.WaitForSpace(std::chrono::steady_clock::now() +
+                                    std::chrono::microseconds(kProducerBackoffUs));
       }
     }
   }
 
   void VideoFileProducer::SetShadowDecodeMode(bool enabled)
   {
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
     shadow_decode_mode_.store(enabled, std::memory_order_release);
+    shadow_decode_ready_.store(false, std::memory_order_release);
     if (!enabled)
     {
-      // Exiting shadow mode - clear cached frame
-      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
-      cached_first_frame_.reset();
-      shadow_decode_ready_.store(false, std::memory_order_release);
+      // Exiting shadow mode - the producer thread splices the staged frames
+      // before it pushes anything new
+      shadow_decode_cv_.notify_all();
     }
     else
     {
-      // Entering shadow mode - reset readiness state
-      std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
-      shadow_decode_ready_.store(false, std::memory_order_release);
-      cached_first_frame_.reset();
+      // Entering shadow mode - start a fresh preroll
+      shadow_preroll_.clear();
+      shadow_audio_.clear();
+      shadow_splice_started_ = false;
+    }
+  }
+
+  void VideoFileProducer::StageShadowFrame(buffer::FrameHandle handle, int64_t base_pts_us)
+  {
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    // Stamp under the lock so a concurrent AlignPTS() covers this frame too
+    handle->metadata.pts = base_pts_us + pts_offset_us_;
+    handle->metadata.splice_point = false;
+    last_pts_us_ = handle->metadata.pts;
+    last_decoded_frame_pts_us_ = handle->metadata.pts;
+    shadow_preroll_.push_back(std::move(handle));
+    if (!shadow_decode_mode_.load(std::memory_order_acquire))
+    {
+      return;  // Queued behind a preroll not yet spliced
+    }
+
+    if (shadow_preroll_.size() == 1)
+    {
+      shadow_decode_ready_.store(true, std::memory_order_release);
+      std::cout << "[VideoFileProducer] Shadow decode: first frame staged, PTS="
+                << shadow_preroll_.front()->metadata.pts << std::endl;
+      EmitEvent("ShadowDecodeReady", "");
+    }
+    if (shadow_preroll_.size() == ShadowPrerollTarget())
+    {
+      std::cout << "[VideoFileProducer] Shadow preroll complete: "
+                << shadow_preroll_.size() << " frames staged" << std::endl;
+      EmitEvent("ShadowPrerollComplete", "");
+    }
+  }
+
+  bool VideoFileProducer::ShadowStaging() const
+  {
+    // Only the producer thread splices, so a preroll seen here is still
+    // pending when the frame is staged behind it
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    return shadow_decode_mode_.load(std::memory_order_acquire) || !shadow_preroll_.empty();
+  }
+
+  bool VideoFileProducer::SpliceShadowPreroll()
+  {
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    if (shadow_preroll_.empty())
+    {
+      SpliceShadowAudio();
+      return true;
+    }
+
+    if (!shadow_splice_started_)
+    {
+      // Pace everything after the preroll from the moment the preroll airs
+      shadow_splice_started_ = true;
+      first_frame_pts_us_ = shadow_preroll_.front()->metadata.pts;
+      // The sink restarts its GOP here, so the switch airs on an IDR
+      shadow_preroll_.front()->metadata.splice_point = true;
+      if (master_clock_)
+      {
+        playback_start_utc_us_ = master_clock_->now_utc_us();
+      }
+    }
+
+    // One index update per batch: the consumer sees the staged frames appear
+    // together, never a half-spliced ring
+    const size_t pushed = output_buffer_.PushBatch(shadow_preroll_);
+    frames_produced_.fetch_add(pushed, std::memory_order_relaxed);
+    shadow_preroll_.erase(shadow_preroll_.begin(), shadow_preroll_.begin() + pushed);
+    if (!shadow_preroll_.empty())
+    {
+      buffer_full_count_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    shadow_splice_started_ = false;
+    SpliceShadowAudio();
+    std::cout << "[VideoFileProducer] Shadow preroll spliced into output buffer" << std::endl;
+    return true;
+  }
+
+  void VideoFileProducer::SpliceShadowAudio()
+  {
+    for (const buffer::AudioFrame& block : shadow_audio_)
+    {
+      if (output_buffer_.PushAudioFrame(block))
+      {
+        audio_blocks_produced_.fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+        audio_blocks_dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
     }
+    shadow_audio_.clear();
+  }
+
+  size_t VideoFileProducer::ShadowPrerollTarget() const
+  {
+    return std::max<size_t>(config_.shadow_preroll_frames, 1);
+  }
+
+  size_t VideoFileProducer::GetShadowPrerollDepth() const
+  {
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    return shadow_preroll_.size();
   }
 
   bool VideoFileProducer::IsShadowDecodeMode() const
@@ -903,35 +2787,69 @@ namespace retrovue::producers::video_file
   int64_t VideoFileProducer::GetNextPTS() const
   {
     // Return the PTS that the next frame will have
-    // This is last_pts_us_ + frame_interval_us_ + pts_offset_us_
+    // This is last_pts_us_ (offset already applied) + frame_interval_us_
     // Note: last_pts_us_ is not atomic, but we're reading it in a const method
     // In practice, this is called from the state machine which holds a lock
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    if (!shadow_preroll_.empty())
+    {
+      // Staged frames go out first
+      return shadow_preroll_.front()->metadata.pts;
+    }
     int64_t next_pts = last_pts_us_;
     if (next_pts == 0)
     {
       // First frame - use pts_offset_us_ as base
       return pts_offset_us_;
     }
-    return next_pts + frame_interval_us_ + pts_offset_us_;
+    return next_pts + frame_interval_us_;
   }
 
   void VideoFileProducer::AlignPTS(int64_t target_pts)
   {
     // Calculate offset needed to align next frame to target_pts
     // Note: last_pts_us_ is not atomic, but this is called from state machine which holds a lock
-    int64_t next_pts_without_offset = last_pts_us_;
-    if (next_pts_without_offset == 0)
+    std::lock_guard<std::mutex> lock(shadow_decode_mutex_);
+    const int64_t previous_offset_us = pts_offset_us_;
+    if (!shadow_preroll_.empty())
+    {
+      // Shift the staged frames (and everything decoded after them) so the
+      // oldest staged frame lands on target_pts
+      const int64_t delta = target_pts - shadow_preroll_.front()->metadata.pts;
+      for (buffer::FrameHandle& staged : shadow_preroll_)
+      {
+        staged->metadata.pts += delta;
+      }
+      pts_offset_us_ += delta;
+      last_pts_us_ += delta;
+      last_decoded_frame_pts_us_ += delta;
+    }
+    else if (last_pts_us_ == 0)
     {
       // First frame - set offset directly
       pts_offset_us_ = target_pts;
     }
     else
     {
-      // Calculate offset: target_pts - (next_pts_without_offset + frame_interval_us_)
-      pts_offset_us_ = target_pts - (next_pts_without_offset + frame_interval_us_);
+      // Shift by the distance from the next frame's PTS, so repeated
+      // alignments (one per playlist item) do not compound
+      const int64_t delta = target_pts - (last_pts_us_ + frame_interval_us_);
+      pts_offset_us_ += delta;
+      last_pts_us_ += delta;
+    }
+    // Staged audio moves with the video it was decoded alongside
+    for (buffer::AudioFrame& staged : shadow_audio_)
+    {
+      staged.pts_us += pts_offset_us_ - previous_offset_us;
     }
     std::cout << "[VideoFileProducer] Aligned PTS: target=" << target_pts 
               << ", offset=" << pts_offset_us_ << std::endl;
   }
 
+  bool VideoFileProducer::SetOutPoint(int64_t out_pts)
+  {
+    out_point_pts_us_.store(std::max<int64_t>(out_pts, 0), std::memory_order_release);
+    return true;
+  }
+
 } // namespace retrovue::producers::video_file
@@ -6,8 +6,10 @@
 #include "retrovue/renderer/FrameRenderer.h"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
 #include <thread>
@@ -25,7 +27,11 @@ extern "C" {
 }
 #endif
 
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/decode/PlaneKernels.h"
+#include "retrovue/runtime/TaskExecutor.h"
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/telemetry/ThreadCpu.h"
 #include "retrovue/timing/MasterClock.h"
 
 namespace retrovue::renderer {
@@ -34,10 +40,32 @@ namespace {
 constexpr double kWaitFudgeSeconds = 0.001;                // wake a millisecond early
 constexpr double kDropThresholdSeconds = -0.008;           // drop when we are 8 ms late (MC-003)
 constexpr int kMinDepthForDrop = 5;                        // keep buffer from starving
+constexpr size_t kMaxSkipFrames = 64;                      // frames one catch-up skip looks at
 constexpr int64_t kSpinThresholdUs = 200;                  // busy wait for last 0.2 ms
 constexpr int64_t kSpinSleepUs = 100;                      // fine-grained wait window
 constexpr int64_t kEmptyBufferBackoffUs = 5'000;           // MC-004: allow producer to refill
 constexpr int64_t kErrorBackoffUs = 10'000;                // MC-004 recovery assistance
+constexpr int64_t kStopCheckSliceUs = 10'000;              // Real-clock wait between stop checks
+
+static_assert(telemetry::kBufferOccupancyBuckets == buffer::kOccupancyBuckets,
+              "telemetry histogram must mirror the ring buffer's buckets");
+
+// Copies the ring buffer's built-in instrumentation into a metrics snapshot.
+void ApplyBufferStats(const buffer::FrameRingBuffer& ring,
+                      telemetry::ChannelMetrics& snapshot) {
+  const buffer::BufferStats stats = ring.GetStats();
+  snapshot.buffer_high_water_frames = stats.high_water_frames;
+  snapshot.buffer_low_water_frames = stats.low_water_frames;
+  snapshot.buffer_push_failures_total = stats.push_failures;
+  snapshot.buffer_residency_seconds_sum = stats.residency_total_us / 1'000'000.0;
+  snapshot.buffer_residency_count = stats.frames_popped;
+  snapshot.buffer_residency_seconds_max = stats.residency_max_us / 1'000'000.0;
+  snapshot.buffer_occupancy_buckets = stats.occupancy_histogram;
+  snapshot.buffer_occupancy_ratio_sum =
+      ring.DepthLimit() > 0
+          ? static_cast<double>(stats.occupancy_sum_frames) / ring.DepthLimit()
+          : 0.0;
+}
 
 inline void WaitUntilUtc(const std::shared_ptr<timing::MasterClock>& clock,
                          int64_t target_utc_us,
@@ -59,6 +87,11 @@ inline void WaitUntilUtc(const std::shared_ptr<timing::MasterClock>& clock,
       break;
     }
 
+    if (!clock->is_fake()) {
+      // The clock's precise wait, in slices so the stop flag stays responsive
+      clock->WaitUntilUtcUs(std::min(target_utc_us, now + kStopCheckSliceUs));
+      continue;
+    }
     const int64_t sleep_us =
         (remaining > 2'000) ? remaining - 1'000
                             : std::max<int64_t>(remaining / 2, 200);
@@ -92,6 +125,21 @@ inline void WaitForMicros(const std::shared_ptr<timing::MasterClock>& clock,
 inline int64_t WaitFudgeUs() {
   return static_cast<int64_t>(kWaitFudgeSeconds * 1'000'000.0);
 }
+
+#ifdef RETROVUE_SDL2_AVAILABLE
+// Preview texture size for frame_width x frame_height frames: the preview
+// size (the window's by default), but no smaller than half the frame on
+// either axis, so the CPU downscale stays within the two-tap filter's 2:1
+// and the GPU scales the rest. Never larger than the frame; always even.
+void PreviewTextureSize(const RenderConfig& config, int frame_width, int frame_height,
+                        int* width, int* height) {
+  const int target_width = config.preview_width > 0 ? config.preview_width : config.window_width;
+  const int target_height =
+      config.preview_height > 0 ? config.preview_height : config.window_height;
+  *width = std::clamp(target_width, (frame_width / 2 + 1) & ~1, frame_width) & ~1;
+  *height = std::clamp(target_height, (frame_height / 2 + 1) & ~1, frame_height) & ~1;
+}
+#endif
 }  // namespace
 
 FrameRenderer::FrameRenderer(const RenderConfig& config,
@@ -117,6 +165,15 @@ std::unique_ptr<FrameRenderer> FrameRenderer::Create(
     const std::shared_ptr<timing::MasterClock>& clock,
     const std::shared_ptr<telemetry::MetricsExporter>& metrics,
     int32_t channel_id) {
+  if (config.mode == RenderMode::SINK) {
+    if (config.sink) {
+      return std::make_unique<SinkRenderer>(config, input_buffer, clock, metrics, channel_id);
+    }
+    std::cerr << "[FrameRenderer] WARNING: Sink mode without a sink, using headless mode"
+              << std::endl;
+    return std::make_unique<HeadlessRenderer>(config, input_buffer, clock, metrics,
+                                              channel_id);
+  }
   if (config.mode == RenderMode::PREVIEW) {
 #ifdef RETROVUE_SDL2_AVAILABLE
     return std::make_unique<PreviewRenderer>(config, input_buffer, clock, metrics,
@@ -133,6 +190,12 @@ std::unique_ptr<FrameRenderer> FrameRenderer::Create(
                                             channel_id);
 }
 
+void FrameRenderer::SetExecutor(std::shared_ptr<runtime::TaskExecutor> executor) {
+  executor_ = std::move(executor);
+}
+
+void FrameRenderer::SetFrameTap(FrameTap tap) { frame_tap_ = std::move(tap); }
+
 bool FrameRenderer::Start() {
   if (running_.load(std::memory_order_acquire)) {
     std::cerr << "[FrameRenderer] Already running" << std::endl;
@@ -150,25 +213,51 @@ bool FrameRenderer::Start() {
     std::cout << "[FrameRenderer] Registering channel " << channel_id_
               << " with MetricsExporter" << std::endl;
     metrics_->SubmitChannelMetrics(channel_id_, initial_snapshot);
+    metrics_slot_ = metrics_->AcquireChannelSlot(channel_id_);
+    cpu_meter_.SetAccount(metrics_->AcquireChannelCpu(channel_id_));
   }
 
-  render_thread_ = std::make_unique<std::thread>(&FrameRenderer::RenderLoop, this);
+  task_loop_.reset();  // A previous chain that ended on its own
+  if (executor_ && executor_->running() && config_.mode == RenderMode::HEADLESS && clock_ &&
+      !clock_->is_fake()) {
+    task_begun_ = false;
+    task_loop_ = std::make_unique<runtime::TaskLoop>(
+        *executor_, runtime::TaskExecutor::Lane::kPacing, [this] { return RunTaskStep(); },
+        [this] {
+          pending_.Reset();
+          if (task_begun_) {
+            EndRender();
+          }
+        });
+    if (!task_loop_->Start()) {
+      std::cerr << "[FrameRenderer] Executor refused the task chain" << std::endl;
+      task_loop_.reset();
+      return false;
+    }
+  } else {
+    render_thread_ = std::make_unique<std::thread>(&FrameRenderer::RenderLoop, this);
+  }
   
   std::cout << "[FrameRenderer] Started" << std::endl;
   return true;
 }
 
 void FrameRenderer::Stop() {
-  if (!running_.load(std::memory_order_acquire) && !render_thread_) {
+  if (!running_.load(std::memory_order_acquire) && !render_thread_ && !task_loop_) {
     return;
   }
 
   std::cout << "[FrameRenderer] Stopping..." << std::endl;
   stop_requested_.store(true, std::memory_order_release);
+  input_buffer_.WakeWaiters();
 
   if (render_thread_ && render_thread_->joinable()) {
     render_thread_->join();
   }
+  if (task_loop_) {
+    task_loop_->Stop();
+    task_loop_.reset();
+  }
 
   render_thread_.reset();
   running_.store(false, std::memory_order_release);
@@ -181,6 +270,7 @@ void FrameRenderer::Stop() {
     final_snapshot.buffer_depth_frames = input_buffer_.Size();
     final_snapshot.frame_gap_seconds = stats_.frame_gap_ms / 1000.0;
     final_snapshot.corrections_total = stats_.corrections_total;
+    ApplyBufferStats(input_buffer_, final_snapshot);
     std::cout << "[FrameRenderer] Flushing final metrics snapshot for channel "
               << channel_id_ << std::endl;
     metrics_->SubmitChannelMetrics(channel_id_, final_snapshot);
@@ -190,15 +280,17 @@ void FrameRenderer::Stop() {
             << stats_.frames_rendered << std::endl;
 }
 
-void FrameRenderer::RenderLoop() {
+bool FrameRenderer::BeginRender() {
   std::cout << "[FrameRenderer] Render loop started (mode=" 
-            << (config_.mode == RenderMode::HEADLESS ? "HEADLESS" : "PREVIEW") 
+            << (config_.mode == RenderMode::HEADLESS  ? "HEADLESS"
+                : config_.mode == RenderMode::PREVIEW ? "PREVIEW"
+                                                      : "SINK")
             << ")" << std::endl;
 
   // Initialize renderer
   if (!Initialize()) {
     std::cerr << "[FrameRenderer] Failed to initialize" << std::endl;
-    return;
+    return false;
   }
 
   running_.store(true, std::memory_order_release);
@@ -207,6 +299,24 @@ void FrameRenderer::RenderLoop() {
   } else {
     fallback_last_frame_time_ = std::chrono::steady_clock::now();
   }
+  return true;
+}
+
+void FrameRenderer::EndRender() {
+  // Cleanup renderer
+  Cleanup();
+  running_.store(false, std::memory_order_release);
+  
+  std::cout << "[FrameRenderer] Render loop exited" << std::endl;
+}
+
+void FrameRenderer::RenderLoop() {
+  runtime::ApplyChannelPlacement(config_.placement, /*pacing_thread=*/true, "FrameRenderer");
+  telemetry::NameCurrentThread(channel_id_, "render");
+  cpu_meter_.Restart();
+  if (!BeginRender()) {
+    return;
+  }
 
   while (!stop_requested_.load(std::memory_order_acquire)) {
     int64_t frame_start_utc = 0;
@@ -217,13 +327,25 @@ void FrameRenderer::RenderLoop() {
       frame_start_fallback = std::chrono::steady_clock::now();
     }
 
-    // Try to pop a frame from the buffer
-    buffer::Frame frame;
-    if (!input_buffer_.Pop(frame)) {
-      WaitForMicros(clock_, kEmptyBufferBackoffUs, &stop_requested_);  // MC-004: allow producer to refill
-      stats_.frames_skipped++;
+    // Try to pop a frame from the buffer (pooled frames are not copied)
+    buffer::FrameHandle handle;
+    if (!input_buffer_.Pop(handle)) {
+      // MC-004: allow producer to refill. Real clocks block on the buffer and
+      // wake on the producer's next push; fake clocks keep clock-driven waits.
+      if (clock_ && clock_->is_fake()) {
+        WaitForMicros(clock_, kEmptyBufferBackoffUs, &stop_requested_);
+      } else {
+        input_buffer_.WaitForFrame(std::chrono::steady_clock::now() +
+                                   std::chrono::microseconds(kEmptyBufferBackoffUs));
+      }
+      NoteBufferEmpty();
       continue;
     }
+    starved_ = false;
+    handle->metadata.trace.Mark(buffer::FrameStage::kPopped);
+    const buffer::Frame& frame = *handle;
+    const uint64_t residency_us = input_buffer_.LastPopResidencyUs();
+    const auto popped_at = std::chrono::steady_clock::now();
 
     double frame_gap_ms = 0.0;
     if (clock_) {
@@ -233,27 +355,30 @@ void FrameRenderer::RenderLoop() {
       const double gap_s = static_cast<double>(gap_us) / 1'000'000.0;
       frame_gap_ms = gap_s * 1000.0;
 
-      if (gap_s > 0.0) {
+      if (CatchUp(frame, gap_us)) {
+        PublishMetrics(frame_gap_ms);
+        continue;
+      }
+      // kSpeedUp presents behind the deadlines by the lag it is earning back
+      const int64_t lag_us = stats_.catch_up_lag_us;
+      if (gap_us + lag_us > 0) {
         const int64_t deadline_utc =
-            clock_->scheduled_to_utc_us(frame.metadata.pts);
-        const int64_t target_utc = deadline_utc - WaitFudgeUs();
+            clock_->scheduled_to_utc_us(frame.metadata.pts) + lag_us;
+        // Real clocks wait precisely to the deadline; fake clocks wake early
+        // and close in below
+        const int64_t target_utc =
+            clock_->is_fake() ? deadline_utc - WaitFudgeUs() : deadline_utc;
         WaitUntilUtc(clock_, target_utc, &stop_requested_);  // MC-003: pace rendering to MasterClock
 
         int64_t remaining_us =
-            clock_->scheduled_to_utc_us(frame.metadata.pts) - clock_->now_utc_us();
+            clock_->scheduled_to_utc_us(frame.metadata.pts) + lag_us - clock_->now_utc_us();
         while (remaining_us > kSpinThresholdUs && !stop_requested_.load(std::memory_order_acquire)) {
           const int64_t spin_us =
               std::min<int64_t>(remaining_us / 2, kSpinSleepUs);
           WaitForMicros(clock_, spin_us, &stop_requested_);
           remaining_us =
-              clock_->scheduled_to_utc_us(frame.metadata.pts) - clock_->now_utc_us();
+              clock_->scheduled_to_utc_us(frame.metadata.pts) + lag_us - clock_->now_utc_us();
         }
-      } else if (gap_s < kDropThresholdSeconds &&
-                 input_buffer_.Size() > kMinDepthForDrop) {
-        stats_.frames_dropped++;
-        stats_.corrections_total++;
-        PublishMetrics(frame_gap_ms);
-        continue;
       }
     } else {
       auto now = std::chrono::steady_clock::now();
@@ -262,47 +387,191 @@ void FrameRenderer::RenderLoop() {
       fallback_last_frame_time_ = now;
     }
 
-    RenderFrame(frame);
-
-    int64_t frame_end_utc = 0;
-    std::chrono::steady_clock::time_point frame_end_fallback;
-    if (clock_) {
-      frame_end_utc = clock_->now_utc_us();
-    } else {
-      frame_end_fallback = std::chrono::steady_clock::now();
+    if (frame_tap_) {
+      frame_tap_(handle);
     }
+    PresentFrame(frame, residency_us, popped_at, frame_start_utc, frame_start_fallback,
+                 frame_gap_ms);
+  }
 
-    double render_time_ms = 0.0;
-    if (clock_) {
-      render_time_ms =
-          static_cast<double>(frame_end_utc - frame_start_utc) / 1'000.0;
-      last_frame_time_utc_ = frame_end_utc;
-    } else {
-      render_time_ms =
-          std::chrono::duration<double, std::milli>(frame_end_fallback - frame_start_fallback)
-              .count();
-      fallback_last_frame_time_ = frame_end_fallback;
-    }
+  EndRender();
+}
+
+void FrameRenderer::PresentFrame(const buffer::Frame& frame, uint64_t residency_us,
+                                 std::chrono::steady_clock::time_point popped_at,
+                                 int64_t frame_start_utc,
+                                 std::chrono::steady_clock::time_point frame_start_fallback,
+                                 double frame_gap_ms) {
+  if (clock_) {
+    pacing_error_us_.Record(std::llabs(clock_->now_utc_us() -
+                                       clock_->scheduled_to_utc_us(frame.metadata.pts)));
+  }
+  // Sampled frames end their trace here: the render (or sink write) is the
+  // output stage
+  const bool traced = frame.metadata.trace.sampled() && metrics_;
+  buffer::FrameTrace trace;
+  if (traced) {
+    trace = frame.metadata.trace;
+    trace.Mark(buffer::FrameStage::kEncodeStart);
+  }
+  RenderFrame(frame);
+  if (traced) {
+    trace.Mark(buffer::FrameStage::kEncodeEnd);
+    metrics_->RecordFrameTrace(channel_id_, trace);
+  }
+  latency_us_.Record(static_cast<int64_t>(residency_us) +
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - popped_at)
+                         .count());
+  if (!task_loop_) {
+    render_cpu_ns_.store(telemetry::ThreadCpuTimeNs(), std::memory_order_relaxed);
+    cpu_meter_.Charge(telemetry::CpuStage::kRender);
+  }
 
-    UpdateStats(render_time_ms, frame_gap_ms);
-    PublishMetrics(frame_gap_ms);
+  int64_t frame_end_utc = 0;
+  std::chrono::steady_clock::time_point frame_end_fallback;
+  if (clock_) {
+    frame_end_utc = clock_->now_utc_us();
+  } else {
+    frame_end_fallback = std::chrono::steady_clock::now();
+  }
 
-    // Log progress periodically
-    if (stats_.frames_rendered % 100 == 0) {
-      std::cout << "[FrameRenderer] Rendered " << stats_.frames_rendered 
-                << " frames, avg render time: " << stats_.average_render_time_ms << "ms, "
-                << "fps: " << stats_.current_render_fps 
-                << ", gap: " << frame_gap_ms << "ms" << std::endl;
+  double render_time_ms = 0.0;
+  if (clock_) {
+    render_time_ms =
+        static_cast<double>(frame_end_utc - frame_start_utc) / 1'000.0;
+    last_frame_time_utc_ = frame_end_utc;
+  } else {
+    render_time_ms =
+        std::chrono::duration<double, std::milli>(frame_end_fallback - frame_start_fallback)
+            .count();
+    fallback_last_frame_time_ = frame_end_fallback;
+  }
+
+  UpdateStats(render_time_ms, frame_gap_ms);
+  PublishMetrics(frame_gap_ms);
+
+  // Log progress periodically
+  if (stats_.frames_rendered % 100 == 0) {
+    std::cout << "[FrameRenderer] Rendered " << stats_.frames_rendered 
+              << " frames, avg render time: " << stats_.average_render_time_ms << "ms, "
+              << "fps: " << stats_.current_render_fps 
+              << ", gap: " << frame_gap_ms << "ms" << std::endl;
+  }
+
+  last_pts_ = frame.metadata.pts;
+}
+
+int64_t FrameRenderer::RunTaskStep() {
+  const uint64_t cpu_start_ns = telemetry::ThreadCpuTimeNs();
+  cpu_meter_.Restart();
+  if (!task_begun_) {
+    task_begun_ = BeginRender();
+  }
+  const int64_t next = task_begun_ ? RenderTaskStep() : runtime::TaskLoop::kDone;
+  cpu_meter_.Charge(telemetry::CpuStage::kRender);
+  // Pacing threads are shared, so the renderer's CPU time is summed per step
+  render_cpu_ns_.fetch_add(telemetry::ThreadCpuTimeNs() - cpu_start_ns,
+                           std::memory_order_relaxed);
+  return stop_requested_.load(std::memory_order_acquire) ? runtime::TaskLoop::kDone : next;
+}
+
+int64_t FrameRenderer::RenderTaskStep() {
+  if (!pending_) {
+    pending_start_utc_ = clock_->now_utc_us();
+    if (!input_buffer_.Pop(pending_)) {
+      // MC-004: allow producer to refill (no thread to park on the buffer: poll)
+      NoteBufferEmpty();
+      return clock_->ToSystemUtcUs(clock_->now_utc_us() + kEmptyBufferBackoffUs);
+    }
+    starved_ = false;
+    pending_->metadata.trace.Mark(buffer::FrameStage::kPopped);
+    pending_residency_us_ = input_buffer_.LastPopResidencyUs();
+    pending_popped_at_ = std::chrono::steady_clock::now();
+
+    const int64_t deadline_utc = clock_->scheduled_to_utc_us(pending_->metadata.pts);
+    const int64_t gap_us = deadline_utc - clock_->now_utc_us();
+    const double gap_s = static_cast<double>(gap_us) / 1'000'000.0;
+    pending_gap_ms_ = gap_s * 1000.0;
+    if (CatchUp(*pending_, gap_us)) {
+      pending_.Reset();
+      PublishMetrics(pending_gap_ms_);
+      return runtime::TaskLoop::kNow;
     }
+    if (gap_us + stats_.catch_up_lag_us > 0) {
+      // MC-003: come back on the pacing lane at the frame's deadline
+      return clock_->ToSystemUtcUs(deadline_utc + stats_.catch_up_lag_us);
+    }
+  }
 
-    last_pts_ = frame.metadata.pts;
+  if (frame_tap_) {
+    frame_tap_(pending_);
   }
+  PresentFrame(*pending_, pending_residency_us_, pending_popped_at_, pending_start_utc_, {},
+               pending_gap_ms_);
+  pending_.Reset();
+  return runtime::TaskLoop::kNow;
+}
 
-  // Cleanup renderer
-  Cleanup();
-  running_.store(false, std::memory_order_release);
-  
-  std::cout << "[FrameRenderer] Render loop exited" << std::endl;
+bool FrameRenderer::CatchUp(const buffer::Frame& frame, int64_t gap_us) {
+  slack_us_.Record(std::max<int64_t>(gap_us, 0));
+  constexpr int64_t threshold_us = static_cast<int64_t>(-kDropThresholdSeconds * 1'000'000.0);
+
+  switch (config_.catch_up) {
+    case CatchUpPolicy::kDropEach:
+      if (gap_us < -threshold_us && input_buffer_.Size() > kMinDepthForDrop) {
+        stats_.frames_dropped++;
+        stats_.corrections_total++;
+        return true;
+      }
+      return false;
+
+    case CatchUpPolicy::kSkipToNow:
+      return gap_us < -threshold_us && SkipToNow();
+
+    case CatchUpPolicy::kSpeedUp:
+      if (-gap_us - stats_.catch_up_lag_us > threshold_us) {
+        // Too far behind to earn back in reasonable time: skip instead
+        if (-gap_us > config_.catch_up_max_lag_us && SkipToNow()) {
+          stats_.catch_up_lag_us = 0;
+          return true;
+        }
+        // A new stall: fall back to the frame's lateness and earn it back
+        stats_.corrections_total++;
+        stats_.catch_up_lag_us = -gap_us;
+      }
+      if (stats_.catch_up_lag_us > 0) {
+        const int64_t earned_us =
+            std::llround(std::max(frame.metadata.duration, 0.0) * config_.catch_up_ppm);
+        stats_.catch_up_lag_us = std::max<int64_t>(stats_.catch_up_lag_us - earned_us, 0);
+      }
+      return false;
+  }
+  return false;
+}
+
+bool FrameRenderer::SkipToNow() {
+  std::array<const buffer::Frame*, kMaxSkipFrames> queued{};
+  const size_t count = input_buffer_.PeekRange(queued);
+  const int64_t now_utc = clock_->now_utc_us();
+  size_t due = 0;
+  while (due < count && clock_->scheduled_to_utc_us(queued[due]->metadata.pts) <= now_utc) {
+    ++due;
+  }
+  if (due == 0) {
+    return false;
+  }
+  // The popped frame and all due frames before the newest, in one index update
+  stats_.frames_dropped += 1 + input_buffer_.Discard(due - 1);
+  stats_.corrections_total++;
+  stats_.catch_up_skips++;
+  return true;
+}
+
+FrameTimingStats FrameRenderer::GetTimingStats() const {
+  FrameTimingStats stats{pacing_error_us_, latency_us_, slack_us_,
+                         render_cpu_ns_.load(std::memory_order_relaxed)};
+  return stats;
 }
 
 void FrameRenderer::UpdateStats(double render_time_ms, double frame_gap_ms) {
@@ -321,19 +590,29 @@ void FrameRenderer::UpdateStats(double render_time_ms, double frame_gap_ms) {
 }
 
 void FrameRenderer::PublishMetrics(double frame_gap_ms) {
-  if (!metrics_) {
+  if (!metrics_slot_) {
     return;
   }
 
+  // Only the slot's fields are taken; state and the rest stay as submitted
   telemetry::ChannelMetrics snapshot;
-  if (!metrics_->GetChannelMetrics(channel_id_, snapshot)) {
-    snapshot = telemetry::ChannelMetrics{};
-  }
-
   snapshot.buffer_depth_frames = input_buffer_.Size();
   snapshot.frame_gap_seconds = frame_gap_ms / 1000.0;
   snapshot.corrections_total = stats_.corrections_total;
-  metrics_->SubmitChannelMetrics(channel_id_, snapshot);
+  snapshot.underruns_total = stats_.underruns;
+  snapshot.late_frames_total = stats_.frames_dropped;
+  ApplyBufferStats(input_buffer_, snapshot);
+  metrics_slot_->Record(snapshot);
+}
+
+void FrameRenderer::NoteBufferEmpty() {
+  stats_.frames_skipped++;
+  if (starved_) {
+    return;
+  }
+  starved_ = true;
+  stats_.underruns++;
+  PublishMetrics(stats_.frame_gap_ms);
 }
 
 void FrameRenderer::setProducer(producers::IProducer* producer) {
@@ -351,6 +630,7 @@ void FrameRenderer::resetPipeline() {
   
   // Reset timestamp state
   last_pts_ = 0;
+  stats_.catch_up_lag_us = 0;
   if (clock_) {
     last_frame_time_utc_ = clock_->now_utc_us();
   } else {
@@ -372,6 +652,8 @@ HeadlessRenderer::HeadlessRenderer(const RenderConfig& config,
     : FrameRenderer(config, input_buffer, clock, metrics, channel_id) {}
 
 HeadlessRenderer::~HeadlessRenderer() {
+  // Join the render thread while RenderFrame() still dispatches here
+  Stop();
 }
 
 bool HeadlessRenderer::Initialize() {
@@ -392,6 +674,40 @@ void HeadlessRenderer::Cleanup() {
   std::cout << "[HeadlessRenderer] Cleanup complete" << std::endl;
 }
 
+// ============================================================================
+// SinkRenderer
+// ============================================================================
+
+SinkRenderer::SinkRenderer(const RenderConfig& config,
+                           buffer::FrameRingBuffer& input_buffer,
+                           const std::shared_ptr<timing::MasterClock>& clock,
+                           const std::shared_ptr<telemetry::MetricsExporter>& metrics,
+                           int32_t channel_id)
+    : FrameRenderer(config, input_buffer, clock, metrics, channel_id), sink_(config.sink) {}
+
+SinkRenderer::~SinkRenderer() {
+  // Join the render thread while RenderFrame() still dispatches here
+  Stop();
+}
+
+bool SinkRenderer::Initialize() {
+  if (!sink_ || !sink_->Open()) {
+    std::cerr << "[SinkRenderer] Failed to open the sink" << std::endl;
+    return false;
+  }
+  std::cout << "[SinkRenderer] Initialized (render loop drives the sink)" << std::endl;
+  return true;
+}
+
+void SinkRenderer::RenderFrame(const buffer::Frame& frame) {
+  sink_->WriteFrame(frame, clock_ ? clock_->scheduled_to_utc_us(frame.metadata.pts) : 0);
+}
+
+void SinkRenderer::Cleanup() {
+  sink_->Close();
+  std::cout << "[SinkRenderer] Cleanup complete" << std::endl;
+}
+
 // ============================================================================
 // PreviewRenderer
 // ============================================================================
@@ -410,6 +726,8 @@ PreviewRenderer::PreviewRenderer(const RenderConfig& config,
 }
 
 PreviewRenderer::~PreviewRenderer() {
+  // Join the render thread while RenderFrame() still dispatches here
+  Stop();
 }
 
 bool PreviewRenderer::Initialize() {
@@ -453,34 +771,51 @@ bool PreviewRenderer::Initialize() {
   }
   renderer_ = renderer;
 
-  // Create texture for YUV420 frames
+  // The texture is sized from the first frame (see EnsureTexture)
+  frames_presented_ = 0;
+  frames_not_presented_ = 0;
+
+  std::cout << "[PreviewRenderer] Initialized successfully: " 
+            << config_.window_width << "x" << config_.window_height << std::endl;
+
+  return true;
+}
+
+bool PreviewRenderer::EnsureTexture(int frame_width, int frame_height) {
+  int width = 0;
+  int height = 0;
+  PreviewTextureSize(config_, frame_width, frame_height, &width, &height);
+  if (texture_ && width == texture_width_ && height == texture_height_) {
+    return true;
+  }
+  if (texture_) {
+    SDL_DestroyTexture(static_cast<SDL_Texture*>(texture_));
+    texture_ = nullptr;
+  }
+
+  // Create texture for YUV420 frames; the GPU converts it to RGB
   SDL_Texture* texture = SDL_CreateTexture(
-      renderer,
+      static_cast<SDL_Renderer*>(renderer_),
       SDL_PIXELFORMAT_IYUV,  // YUV420P
       SDL_TEXTUREACCESS_STREAMING,
-      config_.window_width,
-      config_.window_height);
-
+      width,
+      height);
   if (!texture) {
-    std::cerr << "[PreviewRenderer] SDL_CreateTexture failed: " << SDL_GetError() 
+    std::cerr << "[PreviewRenderer] SDL_CreateTexture failed: " << SDL_GetError()
               << std::endl;
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
     return false;
   }
   texture_ = texture;
-
-  std::cout << "[PreviewRenderer] Initialized successfully: " 
-            << config_.window_width << "x" << config_.window_height << std::endl;
-
+  texture_width_ = width;
+  texture_height_ = height;
+  std::cout << "[PreviewRenderer] Preview texture " << width << "x" << height << " for "
+            << frame_width << "x" << frame_height << " frames" << std::endl;
   return true;
 }
 
 void PreviewRenderer::RenderFrame(const buffer::Frame& frame) {
   SDL_Window* window = static_cast<SDL_Window*>(window_);
   SDL_Renderer* renderer = static_cast<SDL_Renderer*>(renderer_);
-  SDL_Texture* texture = static_cast<SDL_Texture*>(texture_);
 
   // Handle SDL events (window close, etc.)
   SDL_Event event;
@@ -491,27 +826,61 @@ void PreviewRenderer::RenderFrame(const buffer::Frame& frame) {
     }
   }
 
-  // Update texture with YUV420 data
-  if (!frame.data.empty()) {
-    int y_size = frame.width * frame.height;
-    int uv_size = (frame.width / 2) * (frame.height / 2);
+  // Preview rate cap: the frame is consumed but not uploaded
+  const auto now = std::chrono::steady_clock::now();
+  if (config_.preview_max_fps > 0.0 && frames_presented_ > 0 &&
+      now - last_present_ < std::chrono::duration<double>(1.0 / config_.preview_max_fps)) {
+    ++frames_not_presented_;
+    return;
+  }
 
-    const uint8_t* y_plane = frame.data.data();
-    const uint8_t* u_plane = y_plane + y_size;
-    const uint8_t* v_plane = u_plane + uv_size;
+  // GPU surfaces are read back first
+  const buffer::Frame* source = &frame;
+  if (frame.format == buffer::PixelFormat::kDevice) {
+    if (!decode::DownloadDeviceFrame(frame, &downloaded_)) {
+      return;
+    }
+    source = &downloaded_;
+  }
+  decode::PlanarImage image;
+  if (!decode::DescribeFrame(*source, &image) || !EnsureTexture(frame.width, frame.height)) {
+    return;
+  }
+  SDL_Texture* texture = static_cast<SDL_Texture*>(texture_);
 
+  // Update texture with YUV420 data
+  if (image.layout == decode::PlanarLayout::kI420 && texture_width_ == frame.width &&
+      texture_height_ == frame.height) {
     SDL_UpdateYUVTexture(
         texture,
         nullptr,
-        y_plane, frame.width,
-        u_plane, frame.width / 2,
-        v_plane, frame.width / 2);
+        image.planes[0], image.strides[0],
+        image.planes[1], image.strides[1],
+        image.planes[2], image.strides[2]);
+  } else {
+    // Convert (NV12, P010) and downscale straight into the locked texture
+    // (IYUV planes are contiguous, chroma at half the pitch)
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) {
+      std::cerr << "[PreviewRenderer] SDL_LockTexture failed: " << SDL_GetError() << std::endl;
+      return;
+    }
+    uint8_t* dst_y = static_cast<uint8_t*>(pixels);
+    uint8_t* dst_u = dst_y + static_cast<size_t>(pitch) * texture_height_;
+    uint8_t* dst_v = dst_u + static_cast<size_t>(pitch / 2) * (texture_height_ / 2);
+    uint8_t* const planes[3] = {dst_y, dst_u, dst_v};
+    const int pitches[3] = {pitch, pitch / 2, pitch / 2};
+    decode::PackI420(image, texture_width_, texture_height_, planes, pitches);
+    SDL_UnlockTexture(texture);
   }
 
-  // Render texture to window
+  // Render texture to window (the GPU scales it to the window size)
   SDL_RenderClear(renderer);
   SDL_RenderCopy(renderer, texture, nullptr, nullptr);
   SDL_RenderPresent(renderer);
+  last_present_ = now;
+  ++frames_presented_;
 }
 
 void PreviewRenderer::Cleanup() {
@@ -520,7 +889,11 @@ void PreviewRenderer::Cleanup() {
   if (texture_) {
     SDL_DestroyTexture(static_cast<SDL_Texture*>(texture_));
     texture_ = nullptr;
+    texture_width_ = 0;
+    texture_height_ = 0;
   }
+  std::cout << "[PreviewRenderer] Frames presented: " << frames_presented_
+            << ", not presented (rate cap): " << frames_not_presented_ << std::endl;
 
   if (renderer_) {
     SDL_DestroyRenderer(static_cast<SDL_Renderer*>(renderer_));
@@ -551,6 +924,8 @@ PreviewRenderer::PreviewRenderer(const RenderConfig& config,
 }
 
 PreviewRenderer::~PreviewRenderer() {
+  // Join the render thread while RenderFrame() still dispatches here
+  Stop();
 }
 
 bool PreviewRenderer::Initialize() {
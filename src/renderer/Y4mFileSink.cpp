@@ -0,0 +1,125 @@
+// Repository: Retrovue-playout
+// Component: Y4M File Sink
+// Purpose: Writes rendered frames to a YUV4MPEG2 file (offline renders).
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/renderer/Y4mFileSink.h"
+
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/decode/PlaneKernels.h"
+
+namespace retrovue::renderer {
+
+namespace {
+constexpr size_t kFileBufferBytes = 4 * 1024 * 1024;  // A few frames per write() at 1080p
+constexpr char kFrameMarker[] = "FRAME\n";
+}  // namespace
+
+Y4mFileSink::Y4mFileSink(std::string path) : path_(std::move(path)) {}
+
+Y4mFileSink::~Y4mFileSink() { Close(); }
+
+bool Y4mFileSink::Open() {
+  if (file_) {
+    return true;
+  }
+  file_ = path_ == "-" ? stdout : std::fopen(path_.c_str(), "wb");
+  if (!file_) {
+    std::cerr << "[Y4mFileSink] Failed to open " << path_ << std::endl;
+    return false;
+  }
+  std::setvbuf(file_, nullptr, _IOFBF, kFileBufferBytes);
+  width_ = 0;
+  height_ = 0;
+  return true;
+}
+
+void Y4mFileSink::WriteFrame(const buffer::Frame& frame, int64_t /*deadline_utc_us*/) {
+  if (!file_ || write_failed_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // GPU surfaces are read back first
+  const buffer::Frame* source = &frame;
+  if (frame.format == buffer::PixelFormat::kDevice) {
+    if (!decode::DownloadDeviceFrame(frame, &downloaded_)) {
+      frames_rejected_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    source = &downloaded_;
+  }
+  decode::PlanarImage image;
+  if (!decode::DescribeFrame(*source, &image) ||
+      (width_ != 0 && (frame.width != width_ || frame.height != height_))) {
+    frames_rejected_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (width_ == 0) {
+    // Rate in millihertz: exact for integer and 1000/1001 rates alike
+    const int64_t rate_mhz =
+        frame.metadata.duration > 0.0 ? std::llround(1000.0 / frame.metadata.duration) : 30'000;
+    char header[96];
+    const int length = std::snprintf(header, sizeof(header),
+                                     "YUV4MPEG2 W%d H%d F%lld:1000 Ip A1:1 C420jpeg\n",
+                                     frame.width, frame.height,
+                                     static_cast<long long>(rate_mhz));
+    if (!Write(header, static_cast<size_t>(length))) {
+      return;
+    }
+    width_ = frame.width;
+    height_ = frame.height;
+  }
+
+  // Y4M frames are packed I420: other layouts and strided planes convert
+  const size_t y_size = static_cast<size_t>(frame.width) * frame.height;
+  const size_t uv_size = static_cast<size_t>(frame.width / 2) * (frame.height / 2);
+  const uint8_t* bytes = image.planes[0];
+  if (!decode::IsPackedI420(image)) {
+    packed_.resize(y_size + 2 * uv_size);
+    decode::PackI420(image, frame.width, frame.height, packed_.data());
+    bytes = packed_.data();
+  }
+  if (Write(kFrameMarker, sizeof(kFrameMarker) - 1) && Write(bytes, y_size + 2 * uv_size)) {
+    frames_written_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Y4mFileSink::Close() {
+  if (!file_) {
+    return;
+  }
+  if (std::fflush(file_) != 0) {
+    write_failed_.store(true, std::memory_order_relaxed);
+  }
+  if (file_ != stdout) {
+    std::fclose(file_);
+  }
+  file_ = nullptr;
+  if (write_failed_.load(std::memory_order_relaxed)) {
+    std::cerr << "[Y4mFileSink] Output incomplete: writing " << path_ << " failed" << std::endl;
+  }
+}
+
+Y4mFileSinkStats Y4mFileSink::GetStats() const {
+  Y4mFileSinkStats stats;
+  stats.frames_written = frames_written_.load(std::memory_order_relaxed);
+  stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  stats.frames_rejected = frames_rejected_.load(std::memory_order_relaxed);
+  stats.write_failed = write_failed_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool Y4mFileSink::Write(const void* data, size_t size) {
+  if (std::fwrite(data, 1, size, file_) != size) {
+    write_failed_.store(true, std::memory_order_relaxed);
+    return false;
+  }
+  bytes_written_.fetch_add(size, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace retrovue::renderer
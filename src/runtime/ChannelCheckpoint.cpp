@@ -0,0 +1,223 @@
+// Repository: Retrovue-playout
+// Component: Channel Checkpoint
+// Purpose: Memory-mapped record of where each channel is, for resuming after a crash.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/ChannelCheckpoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace retrovue::runtime {
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'V', 'C', 'H', 'K', 'P', 'T', '1'};
+constexpr size_t kHeaderBytes = 64;
+
+struct Header {
+  char magic[8];
+  uint32_t slot_count;
+  uint32_t slot_bytes;
+};
+
+}  // namespace
+
+struct ChannelCheckpointFile::Slot {
+  uint32_t sequence;  // Odd while being written
+  uint32_t used;
+  int32_t channel_id;
+  uint32_t plan_bytes;
+  int64_t timeline_origin_utc_us;
+  int64_t start_offset_us;
+  int64_t pts_us;
+  int64_t written_utc_us;
+  uint64_t frames_produced;
+  char plan[kMaxPlanBytes];
+  uint8_t reserved[8];
+};
+
+ChannelCheckpointFile::ChannelCheckpointFile(std::string path, size_t slots)
+    : path_(std::move(path)), slot_count_(std::max<size_t>(1, slots)) {}
+
+ChannelCheckpointFile::~ChannelCheckpointFile() {
+  if (mapping_) {
+    munmap(mapping_, mapping_bytes_);
+  }
+}
+
+bool ChannelCheckpointFile::Open() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (mapping_) {
+    return true;
+  }
+  const int fd = open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    std::cerr << "[ChannelCheckpointFile] Cannot open " << path_ << ": " << std::strerror(errno)
+              << std::endl;
+    return false;
+  }
+  const size_t bytes = kHeaderBytes + slot_count_ * sizeof(Slot);
+  struct stat st {};
+  Header header{};
+  const bool valid = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == bytes &&
+                     pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+                     std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                     header.slot_count == slot_count_ && header.slot_bytes == sizeof(Slot);
+  if (!valid) {
+    // Not ours, or another slot layout: start over
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      std::cerr << "[ChannelCheckpointFile] Cannot size " << path_ << ": "
+                << std::strerror(errno) << std::endl;
+      close(fd);
+      return false;
+    }
+  }
+  void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    std::cerr << "[ChannelCheckpointFile] Cannot map " << path_ << ": " << std::strerror(errno)
+              << std::endl;
+    return false;
+  }
+  mapping_ = static_cast<uint8_t*>(base);
+  mapping_bytes_ = bytes;
+  if (!valid) {
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.slot_count = static_cast<uint32_t>(slot_count_);
+    header.slot_bytes = sizeof(Slot);
+    std::memcpy(mapping_, &header, sizeof(header));
+  }
+
+  // Slots are handed out from the highest index down, so the first
+  // channels take the first slots
+  for (size_t i = slot_count_; i-- > 0;) {
+    const Slot* slot = SlotAt(i);
+    if (slot->used && slot->sequence % 2 == 0 && slots_.count(slot->channel_id) == 0) {
+      slots_[slot->channel_id] = i;
+    } else {
+      free_slots_.push_back(i);
+    }
+  }
+  return true;
+}
+
+ChannelCheckpointFile::Slot* ChannelCheckpointFile::SlotAt(size_t index) const {
+  static_assert(sizeof(Slot) == 512, "Checkpoint slots are 512 bytes");
+  return reinterpret_cast<Slot*>(mapping_ + kHeaderBytes + index * sizeof(Slot));
+}
+
+bool ChannelCheckpointFile::Write(const ChannelCheckpoint& checkpoint) {
+  if (checkpoint.plan_handle.size() > kMaxPlanBytes) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!mapping_) {
+    return false;
+  }
+  size_t index = 0;
+  const auto it = slots_.find(checkpoint.channel_id);
+  if (it != slots_.end()) {
+    index = it->second;
+  } else if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[checkpoint.channel_id] = index;
+  } else {
+    return false;
+  }
+
+  Slot* slot = SlotAt(index);
+  std::atomic_ref<uint32_t> sequence(slot->sequence);
+  const uint32_t start = sequence.load(std::memory_order_relaxed) | 1u;
+  sequence.store(start, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->used = 1;
+  slot->channel_id = checkpoint.channel_id;
+  slot->plan_bytes = static_cast<uint32_t>(checkpoint.plan_handle.size());
+  slot->timeline_origin_utc_us = checkpoint.timeline_origin_utc_us;
+  slot->start_offset_us = checkpoint.start_offset_us;
+  slot->pts_us = checkpoint.pts_us;
+  slot->written_utc_us = checkpoint.written_utc_us;
+  slot->frames_produced = checkpoint.frames_produced;
+  std::memcpy(slot->plan, checkpoint.plan_handle.data(), checkpoint.plan_handle.size());
+  sequence.store(start + 1, std::memory_order_release);
+  return true;
+}
+
+bool ChannelCheckpointFile::Read(int32_t channel_id, ChannelCheckpoint& checkpoint) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = slots_.find(channel_id);
+  if (!mapping_ || it == slots_.end()) {
+    return false;
+  }
+  const Slot* slot = SlotAt(it->second);
+  if (slot->sequence % 2 != 0 || slot->plan_bytes > kMaxPlanBytes) {
+    return false;  // Torn by a crash mid-write
+  }
+  checkpoint.channel_id = slot->channel_id;
+  checkpoint.plan_handle.assign(slot->plan, slot->plan_bytes);
+  checkpoint.timeline_origin_utc_us = slot->timeline_origin_utc_us;
+  checkpoint.start_offset_us = slot->start_offset_us;
+  checkpoint.pts_us = slot->pts_us;
+  checkpoint.written_utc_us = slot->written_utc_us;
+  checkpoint.frames_produced = slot->frames_produced;
+  return true;
+}
+
+std::vector<ChannelCheckpoint> ChannelCheckpointFile::ReadAll() const {
+  std::vector<int32_t> channel_ids;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [channel_id, index] : slots_) {
+      channel_ids.push_back(channel_id);
+    }
+  }
+  std::sort(channel_ids.begin(), channel_ids.end());
+  std::vector<ChannelCheckpoint> checkpoints;
+  for (const int32_t channel_id : channel_ids) {
+    ChannelCheckpoint checkpoint;
+    if (Read(channel_id, checkpoint)) {
+      checkpoints.push_back(std::move(checkpoint));
+    }
+  }
+  return checkpoints;
+}
+
+void ChannelCheckpointFile::Clear(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = slots_.find(channel_id);
+  if (!mapping_ || it == slots_.end()) {
+    return;
+  }
+  Slot* slot = SlotAt(it->second);
+  std::atomic_ref<uint32_t> sequence(slot->sequence);
+  const uint32_t start = sequence.load(std::memory_order_relaxed) | 1u;
+  sequence.store(start, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->used = 0;
+  sequence.store(start + 1, std::memory_order_release);
+  free_slots_.push_back(it->second);
+  slots_.erase(it);
+}
+
+bool ResumeFromCheckpoint(const ChannelCheckpoint& checkpoint, ChannelStartRequest& request) {
+  if (checkpoint.channel_id != request.channel_id ||
+      checkpoint.plan_handle != request.plan_handle || checkpoint.timeline_origin_utc_us == 0 ||
+      request.timeline_origin_utc_us != 0) {
+    return false;
+  }
+  request.timeline_origin_utc_us = checkpoint.timeline_origin_utc_us;
+  return true;
+}
+
+}  // namespace retrovue::runtime
@@ -0,0 +1,246 @@
+// Repository: Retrovue-playout
+// Component: Channel Manifest
+// Purpose: On-disk record of running channels, restored after a restart.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/ChannelManifest.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace retrovue::runtime {
+
+namespace {
+
+constexpr const char* kManifestHeader = "retrovue-channel-manifest 1";
+
+// Keeps values free of the separators (space, '=', newline)
+std::string Encode(const std::string& value) {
+  static const char kHex[] = "0123456789ABCDEF";
+  std::string out;
+  for (const unsigned char c : value) {
+    if (c <= ' ' || c == '%' || c == '=' || c >= 0x7f) {
+      out += '%';
+      out += kHex[c >> 4];
+      out += kHex[c & 0xf];
+    } else {
+      out += static_cast<char>(c);
+    }
+  }
+  return out;
+}
+
+std::string Decode(const std::string& value) {
+  std::string out;
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == '%' && i + 2 < value.size()) {
+      const std::string hex = value.substr(i + 1, 2);
+      char* end = nullptr;
+      const long c = std::strtol(hex.c_str(), &end, 16);
+      if (end == hex.c_str() + 2) {
+        out += static_cast<char>(c);
+        i += 2;
+        continue;
+      }
+    }
+    out += value[i];
+  }
+  return out;
+}
+
+bool ParseInt(const std::string& text, int64_t& value) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  value = std::strtoll(text.c_str(), &end, 10);
+  return *end == '\0';
+}
+
+std::string FormatCpus(const std::vector<int>& cpus) {
+  std::string list;
+  for (const int cpu : cpus) {
+    if (!list.empty()) {
+      list += ',';
+    }
+    list += std::to_string(cpu);
+  }
+  return list;
+}
+
+}  // namespace
+
+std::string FormatManifestEntry(const ChannelStartRequest& channel) {
+  std::ostringstream line;
+  line << "channel=" << channel.channel_id << " port=" << channel.port
+       << " plan=" << Encode(channel.plan_handle);
+  if (channel.uds_path) {
+    line << " uds=" << Encode(*channel.uds_path);
+  }
+  if (!channel.placement.cpus.empty()) {
+    line << " cpus=" << FormatCpus(channel.placement.cpus);
+  }
+  if (channel.placement.numa_node >= 0) {
+    line << " numa=" << channel.placement.numa_node;
+  }
+  if (channel.placement.pacing_priority > 0) {
+    line << " pacing_priority=" << channel.placement.pacing_priority;
+  }
+  if (channel.priority != 0) {
+    line << " priority=" << channel.priority;
+  }
+  if (channel.timeline_origin_utc_us != 0) {
+    line << " timeline_origin_us=" << channel.timeline_origin_utc_us;
+  }
+  if (channel.buffer.latency_ms > 0) {
+    line << " latency_ms=" << channel.buffer.latency_ms;
+  }
+  if (channel.buffer.width > 0 && channel.buffer.height > 0) {
+    line << " width=" << channel.buffer.width << " height=" << channel.buffer.height;
+  }
+  return line.str();
+}
+
+bool ParseManifestEntry(const std::string& line, ChannelStartRequest& channel) {
+  channel = ChannelStartRequest();
+  bool has_id = false;
+  std::istringstream fields(line);
+  std::string field;
+  while (fields >> field) {
+    const size_t eq = field.find('=');
+    if (eq == std::string::npos) {
+      continue;
+    }
+    const std::string key = field.substr(0, eq);
+    const std::string value = Decode(field.substr(eq + 1));
+    int64_t number = 0;
+    if (key == "channel") {
+      has_id = ParseInt(value, number);
+      channel.channel_id = static_cast<int32_t>(number);
+    } else if (key == "plan") {
+      channel.plan_handle = value;
+    } else if (key == "uds") {
+      channel.uds_path = value;
+    } else if (key == "cpus") {
+      channel.placement.cpus = ParseCpuList(value.c_str());
+    } else if (!ParseInt(value, number)) {
+      continue;
+    } else if (key == "port") {
+      channel.port = static_cast<int32_t>(number);
+    } else if (key == "numa") {
+      channel.placement.numa_node = static_cast<int>(number);
+    } else if (key == "pacing_priority") {
+      channel.placement.pacing_priority = static_cast<int>(number);
+    } else if (key == "priority") {
+      channel.priority = static_cast<int32_t>(number);
+    } else if (key == "timeline_origin_us") {
+      channel.timeline_origin_utc_us = number;
+    } else if (key == "latency_ms") {
+      channel.buffer.latency_ms = number;
+    } else if (key == "width") {
+      channel.buffer.width = static_cast<int>(number);
+    } else if (key == "height") {
+      channel.buffer.height = static_cast<int>(number);
+    }
+  }
+  return has_id;
+}
+
+ChannelManifest::ChannelManifest(std::string path) : path_(std::move(path)) {}
+
+bool ChannelManifest::Load(std::vector<ChannelStartRequest>& channels) {
+  channels.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  channels_.clear();
+  std::ifstream file(path_);
+  if (!file) {
+    return true;  // Nothing persisted yet
+  }
+  std::string line;
+  if (!std::getline(file, line) || line != kManifestHeader) {
+    std::cerr << "[ChannelManifest] Not a channel manifest: " << path_ << std::endl;
+    return false;
+  }
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    ChannelStartRequest channel;
+    if (!ParseManifestEntry(line, channel)) {
+      std::cerr << "[ChannelManifest] Skipping malformed entry in " << path_ << ": " << line
+                << std::endl;
+      continue;
+    }
+    channels_[channel.channel_id] = std::move(channel);
+  }
+  if (file.bad()) {
+    std::cerr << "[ChannelManifest] Cannot read " << path_ << std::endl;
+    channels_.clear();
+    return false;
+  }
+  for (const auto& [channel_id, channel] : channels_) {
+    channels.push_back(channel);
+  }
+  return true;
+}
+
+bool ChannelManifest::Put(const ChannelStartRequest& channel) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  channels_[channel.channel_id] = channel;
+  return WriteLocked();
+}
+
+bool ChannelManifest::Remove(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (channels_.erase(channel_id) == 0) {
+    return true;
+  }
+  return WriteLocked();
+}
+
+bool ChannelManifest::Update(int32_t channel_id,
+                             const std::function<void(ChannelStartRequest&)>& edit) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = channels_.find(channel_id);
+  if (it == channels_.end()) {
+    return true;
+  }
+  edit(it->second);
+  return WriteLocked();
+}
+
+bool ChannelManifest::WriteLocked() const {
+  const std::string temp_path = path_ + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::trunc);
+    if (!file) {
+      std::cerr << "[ChannelManifest] Cannot write " << temp_path << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+    file << kManifestHeader << '\n';
+    for (const auto& [channel_id, channel] : channels_) {
+      file << FormatManifestEntry(channel) << '\n';
+    }
+    file.flush();
+    if (!file) {
+      std::cerr << "[ChannelManifest] Cannot write " << temp_path << std::endl;
+      return false;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path_.c_str()) != 0) {
+    std::cerr << "[ChannelManifest] Cannot replace " << path_ << ": " << std::strerror(errno)
+              << std::endl;
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace retrovue::runtime
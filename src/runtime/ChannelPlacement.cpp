@@ -0,0 +1,218 @@
+// Repository: Retrovue-playout
+// Component: Channel Placement
+// Purpose: CPU affinity, NUMA node and real-time priority of a channel's threads.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/ChannelPlacement.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace retrovue::runtime {
+
+namespace {
+
+#ifdef __linux__
+// From <numaif.h>, without linking libnuma
+constexpr int kMpolPreferred = 1;
+constexpr unsigned kMpolMfMove = 1u << 1;
+constexpr size_t kMaxNodes = 1024;
+constexpr size_t kMaskWords = kMaxNodes / (8 * sizeof(unsigned long));
+
+bool NodeMask(int node, unsigned long (&mask)[kMaskWords]) {
+  std::memset(mask, 0, sizeof(mask));
+  if (node < 0 || static_cast<size_t>(node) >= kMaxNodes) {
+    return false;
+  }
+  mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+  return true;
+}
+#endif
+
+}  // namespace
+
+std::vector<int> ParseCpuList(const char* list) {
+  std::vector<int> cpus;
+  if (!list) {
+    return cpus;
+  }
+  const std::string text(list);
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find(',', pos);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    const std::string range = text.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty() || range.find_first_of("0123456789") == std::string::npos) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const int first = std::atoi(range.c_str());
+    const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+    for (int cpu = first; cpu <= last && cpu >= 0; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> NumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  for (int node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file) {
+      break;
+    }
+    std::string list;
+    std::getline(file, list);
+    nodes.push_back(ParseCpuList(list.c_str()));
+  }
+#endif
+  if (nodes.empty()) {
+    std::vector<int> all;
+    const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < count; ++cpu) {
+      all.push_back(static_cast<int>(cpu));
+    }
+    nodes.push_back(std::move(all));
+  }
+  return nodes;
+}
+
+ChannelPlacer::ChannelPlacer(const PlacementPolicy& policy,
+                             std::vector<std::vector<int>> node_cpus)
+    : policy_(policy),
+      node_cpus_(std::move(node_cpus)),
+      channels_per_node_(node_cpus_.size(), 0) {}
+
+bool ChannelPlacer::Acquire(const ChannelPlacement& requested, ChannelPlacement& resolved) {
+  resolved = requested;
+  if (resolved.pacing_priority <= 0) {
+    resolved.pacing_priority = policy_.pacing_priority;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (resolved.numa_node < 0 && resolved.cpus.empty() && policy_.pack_numa_nodes &&
+      !channels_per_node_.empty()) {
+    resolved.numa_node = static_cast<int>(
+        std::min_element(channels_per_node_.begin(), channels_per_node_.end()) -
+        channels_per_node_.begin());
+  }
+  if (resolved.numa_node >= static_cast<int>(node_cpus_.size())) {
+    return false;
+  }
+  if (resolved.numa_node >= 0) {
+    if (resolved.cpus.empty()) {
+      resolved.cpus = node_cpus_[resolved.numa_node];
+    }
+    ++channels_per_node_[resolved.numa_node];
+  }
+  return true;
+}
+
+void ChannelPlacer::Release(const ChannelPlacement& resolved) {
+  if (resolved.numa_node < 0 || resolved.numa_node >= static_cast<int>(node_cpus_.size())) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  --channels_per_node_[resolved.numa_node];
+}
+
+int ChannelPlacer::ChannelsOnNode(int node) const {
+  if (node < 0 || node >= static_cast<int>(node_cpus_.size())) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return channels_per_node_[node];
+}
+
+bool ApplyChannelPlacement(const ChannelPlacement& placement, bool pacing_thread,
+                           const char* who) {
+  if (placement.IsDefault()) {
+    return true;
+  }
+#ifdef __linux__
+  bool ok = true;
+  if (!placement.cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : placement.cpus) {
+      if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+      std::cerr << "[" << who << "] Cannot pin thread to its CPU set: " << std::strerror(rc)
+                << std::endl;
+      ok = false;
+    }
+  }
+  if (placement.numa_node >= 0) {
+    unsigned long mask[kMaskWords];
+    if (!NodeMask(placement.numa_node, mask) ||
+        syscall(SYS_set_mempolicy, kMpolPreferred, mask, kMaxNodes) != 0) {
+      std::cerr << "[" << who << "] Cannot prefer NUMA node " << placement.numa_node << ": "
+                << std::strerror(errno) << std::endl;
+      ok = false;
+    }
+  }
+  if (pacing_thread && placement.pacing_priority > 0) {
+    // Needs CAP_SYS_NICE (or an rtprio limit)
+    sched_param param{};
+    param.sched_priority = placement.pacing_priority;
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+      std::cerr << "[" << who << "] Cannot raise thread to SCHED_FIFO priority "
+                << placement.pacing_priority << ": " << std::strerror(rc) << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+#else
+  std::cerr << "[" << who << "] Channel placement is only supported on Linux" << std::endl;
+  return false;
+#endif
+}
+
+bool BindMemoryToNode(void* data, std::size_t bytes, int numa_node) {
+#ifdef __linux__
+  if (!data || bytes == 0) {
+    return true;
+  }
+  unsigned long mask[kMaskWords];
+  if (!NodeMask(numa_node, mask)) {
+    return false;
+  }
+  // mbind works on whole pages
+  const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const auto begin = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+  const auto end = (reinterpret_cast<uintptr_t>(data) + bytes + page - 1) & ~(page - 1);
+  return syscall(SYS_mbind, begin, end - begin, kMpolPreferred, mask, kMaxNodes, kMpolMfMove) ==
+         0;
+#else
+  (void)data;
+  (void)bytes;
+  (void)numa_node;
+  return false;
+#endif
+}
+
+}  // namespace retrovue::runtime
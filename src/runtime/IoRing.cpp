@@ -0,0 +1,329 @@
+// Repository: Retrovue-playout
+// Component: IO Ring
+// Purpose: Process-wide io_uring instance for completion-driven socket sends and file reads.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/IoRing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace retrovue::runtime {
+
+namespace {
+
+constexpr uint64_t kWakeUserData = 0;  // The NOP that stops the completion thread
+
+int Setup(unsigned entries, struct io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int Enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int Register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+unsigned* RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<unsigned*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+}  // namespace
+
+IoRing::IoRing(unsigned entries) : requested_entries_(std::max(entries, 2u)) {}
+
+IoRing::~IoRing() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    struct io_uring_sqe* sqe = NextSqeLocked();
+    if (sqe) {
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = kWakeUserData;
+    }
+    closing_ = true;
+    SubmitLocked();
+  }
+  if (completion_thread_.joinable()) {
+    completion_thread_.join();
+  }
+  munmap(sqes_, sqes_bytes_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_bytes_);
+  }
+  munmap(sq_ring_, sq_ring_bytes_);
+  close(ring_fd_);
+}
+
+bool IoRing::Open() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ring_fd_ >= 0) {
+    return true;
+  }
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CLAMP;
+  const int fd = Setup(requested_entries_, &params);
+  if (fd < 0) {
+    std::cerr << "[IoRing] io_uring unavailable: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if ((params.features & IORING_FEAT_NODROP) == 0) {
+    // Without it, completions past the queue's size are lost
+    std::cerr << "[IoRing] Kernel too old (no IORING_FEAT_NODROP)" << std::endl;
+    close(fd);
+    return false;
+  }
+
+  sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                  IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap || sq_ring_ == MAP_FAILED
+                 ? sq_ring_
+                 : mmap(nullptr, cq_ring_bytes_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  sqes_bytes_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED
+                   ? MAP_FAILED
+                   : mmap(nullptr, sqes_bytes_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    std::cerr << "[IoRing] Cannot map rings: " << std::strerror(errno) << std::endl;
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_bytes_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_bytes_);
+    }
+    sq_ring_ = cq_ring_ = nullptr;
+    close(fd);
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  sq_head_ = RingField(sq_ring_, params.sq_off.head);
+  sq_tail_ = RingField(sq_ring_, params.sq_off.tail);
+  sq_array_ = RingField(sq_ring_, params.sq_off.array);
+  sq_mask_ = *RingField(sq_ring_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  cq_head_ = RingField(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *RingField(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(static_cast<uint8_t*>(cq_ring_) +
+                                                 params.cq_off.cqes);
+  ring_fd_ = fd;
+
+  // A sparse table, filled in by RegisterBuffer() (Linux 5.19+; without it
+  // reads just do not use fixed buffers)
+  struct io_uring_rsrc_register table;
+  std::memset(&table, 0, sizeof(table));
+  table.nr = kMaxRegisteredBuffers;
+  table.flags = IORING_RSRC_REGISTER_SPARSE;
+  {
+    std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+    buffers_supported_ =
+        Register(fd, IORING_REGISTER_BUFFERS2, &table, sizeof(table)) == 0;
+    buffer_used_.assign(buffers_supported_ ? kMaxRegisteredBuffers : 0, false);
+  }
+
+  completion_thread_ = std::thread(&IoRing::CompletionLoop, this);
+  std::cout << "[IoRing] Opened with " << sq_entries_ << " entries"
+            << (buffers_supported_ ? ", registered buffers" : "") << std::endl;
+  return true;
+}
+
+struct io_uring_sqe* IoRing::NextSqeLocked() {
+  if (ring_fd_ < 0 || closing_) {
+    return nullptr;
+  }
+  auto full = [this] {
+    const unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    return *sq_tail_ + pending_ - head >= sq_entries_;
+  };
+  if (full()) {
+    SubmitLocked();
+    if (full()) {
+      return nullptr;
+    }
+  }
+  const unsigned index = (*sq_tail_ + pending_) & sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  pending_++;
+  return sqe;
+}
+
+void IoRing::SubmitLocked() {
+  if (pending_ > 0) {
+    // Publish the entries, then have the kernel consume them
+    std::atomic_ref<unsigned>(*sq_tail_).store(*sq_tail_ + pending_, std::memory_order_release);
+    unsubmitted_ += pending_;
+    pending_ = 0;
+  }
+  while (unsubmitted_ > 0) {
+    const int result = Enter(ring_fd_, unsubmitted_, 0, 0);
+    enter_calls_.fetch_add(1, std::memory_order_relaxed);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EBUSY) {
+        std::cerr << "[IoRing] Submit error: " << std::strerror(errno) << std::endl;
+      }
+      // Completions backed up: the completion thread submits the rest once
+      // it has reaped them (waiting here could hold up its callbacks)
+      return;
+    }
+    unsubmitted_ -= std::min(unsubmitted_, static_cast<unsigned>(result));
+  }
+}
+
+bool IoRing::QueueSendmsg(int fd, const struct msghdr* message, int flags, Completion done) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  struct io_uring_sqe* sqe = NextSqeLocked();
+  if (!sqe) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(message);
+  sqe->len = 1;
+  sqe->msg_flags = static_cast<uint32_t>(flags);
+  sqe->user_data = reinterpret_cast<uint64_t>(new Completion(std::move(done)));
+  submitted_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool IoRing::QueueRead(int fd, void* buffer, size_t length, int64_t offset, Completion done,
+                       int buffer_index) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  struct io_uring_sqe* sqe = NextSqeLocked();
+  if (!sqe) {
+    return false;
+  }
+  sqe->opcode = buffer_index >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = static_cast<uint32_t>(length);
+  sqe->off = static_cast<uint64_t>(offset);
+  if (buffer_index >= 0) {
+    sqe->buf_index = static_cast<uint16_t>(buffer_index);
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(new Completion(std::move(done)));
+  submitted_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void IoRing::Submit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ring_fd_ >= 0) {
+    SubmitLocked();
+  }
+}
+
+int IoRing::RegisterBuffer(void* base, size_t length) {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  if (!buffers_supported_) {
+    return -1;
+  }
+  const auto slot = std::find(buffer_used_.begin(), buffer_used_.end(), false);
+  if (slot == buffer_used_.end()) {
+    return -1;
+  }
+  const int index = static_cast<int>(slot - buffer_used_.begin());
+  struct iovec buffer;
+  buffer.iov_base = base;
+  buffer.iov_len = length;
+  struct io_uring_rsrc_update2 update;
+  std::memset(&update, 0, sizeof(update));
+  update.offset = static_cast<uint32_t>(index);
+  update.data = reinterpret_cast<uint64_t>(&buffer);
+  update.nr = 1;
+  if (Register(ring_fd_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) != 1) {
+    // Typically RLIMIT_MEMLOCK: reads go through the page tables instead
+    return -1;
+  }
+  *slot = true;
+  registered_buffers_.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+void IoRing::UnregisterBuffer(int index) {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  if (index < 0 || static_cast<size_t>(index) >= buffer_used_.size() || !buffer_used_[index]) {
+    return;
+  }
+  struct iovec empty;
+  empty.iov_base = nullptr;
+  empty.iov_len = 0;
+  struct io_uring_rsrc_update2 update;
+  std::memset(&update, 0, sizeof(update));
+  update.offset = static_cast<uint32_t>(index);
+  update.data = reinterpret_cast<uint64_t>(&empty);
+  update.nr = 1;
+  Register(ring_fd_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+  buffer_used_[index] = false;
+  registered_buffers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void IoRing::CompletionLoop() {
+  bool stop = false;
+  while (!stop) {
+    if (Enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR &&
+        errno != EAGAIN && errno != EBUSY) {
+      std::cerr << "[IoRing] Wait error: " << std::strerror(errno) << std::endl;
+      break;
+    }
+    std::atomic_ref<unsigned> tail(*cq_tail_);
+    std::atomic_ref<unsigned> head(*cq_head_);
+    unsigned next = head.load(std::memory_order_relaxed);
+    const unsigned end = tail.load(std::memory_order_acquire);
+    while (next != end) {
+      const struct io_uring_cqe cqe = cqes_[next & cq_mask_];
+      next++;
+      // Hand the entry back before running the callback, which may queue more
+      head.store(next, std::memory_order_release);
+      if (cqe.user_data == kWakeUserData) {
+        stop = true;
+        continue;
+      }
+      auto* done = reinterpret_cast<Completion*>(cqe.user_data);
+      completed_.fetch_add(1, std::memory_order_relaxed);
+      (*done)(cqe.res);
+      delete done;
+    }
+    // Everything the callbacks queued goes in one submission
+    Submit();
+  }
+}
+
+IoRingStats IoRing::GetStats() const {
+  IoRingStats stats;
+  stats.submitted = submitted_.load(std::memory_order_relaxed);
+  stats.completed = completed_.load(std::memory_order_relaxed);
+  stats.enter_calls = enter_calls_.load(std::memory_order_relaxed);
+  stats.in_flight = static_cast<size_t>(stats.submitted - std::min(stats.submitted, stats.completed));
+  stats.registered_buffers = registered_buffers_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::runtime
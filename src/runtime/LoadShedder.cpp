@@ -0,0 +1,128 @@
+// Repository: Retrovue-playout
+// Component: Load Shedder
+// Purpose: Degrades low-priority channels first when the host falls behind.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/LoadShedder.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace retrovue::runtime {
+
+namespace {
+
+using decode::DecodeDegradation;
+
+DecodeDegradation Deeper(DecodeDegradation level) {
+  return static_cast<DecodeDegradation>(
+      std::min(static_cast<int>(level) + 1, static_cast<int>(decode::kMaxDecodeDegradation)));
+}
+
+DecodeDegradation Shallower(DecodeDegradation level) {
+  return static_cast<DecodeDegradation>(std::max(static_cast<int>(level) - 1, 0));
+}
+
+}  // namespace
+
+LoadShedder::LoadShedder(const LoadShedPolicy& policy) : policy_(policy) {}
+
+std::vector<LoadShedDecision> LoadShedder::Evaluate(
+    const std::vector<ChannelLoadSample>& samples) {
+  bool overloaded = false;
+  std::unordered_set<int32_t> present;
+  for (const ChannelLoadSample& sample : samples) {
+    present.insert(sample.channel_id);
+    const auto [it, added] = channels_.try_emplace(sample.channel_id);
+    Channel& channel = it->second;
+    // A channel's first sample is only its baseline
+    if (!added && FellBehind(channel, sample)) {
+      overloaded = true;
+    }
+    channel.priority = sample.priority;
+    channel.last = sample;
+  }
+  for (auto it = channels_.begin(); it != channels_.end();) {
+    it = present.count(it->first) ? std::next(it) : channels_.erase(it);
+  }
+
+  overloaded_ = overloaded;
+  if (overloaded) {
+    clean_samples_ = 0;
+    return Escalate();
+  }
+  if (++clean_samples_ < policy_.recovery_samples) {
+    return {};
+  }
+  clean_samples_ = 0;
+  return Relax();
+}
+
+DecodeDegradation LoadShedder::LevelOf(int32_t channel_id) const {
+  const auto it = channels_.find(channel_id);
+  return it == channels_.end() ? DecodeDegradation::kNone : it->second.level;
+}
+
+bool LoadShedder::FellBehind(const Channel& channel, const ChannelLoadSample& sample) const {
+  if (sample.late_frames_total > channel.last.late_frames_total ||
+      sample.underruns_total > channel.last.underruns_total) {
+    return true;
+  }
+  // Degraded channels carry fewer frames, so their residency says little
+  if (policy_.min_slack_ms <= 0 || channel.level != DecodeDegradation::kNone ||
+      sample.buffer_residency_count <= channel.last.buffer_residency_count) {
+    return false;
+  }
+  const double slack_s =
+      (sample.buffer_residency_seconds_sum - channel.last.buffer_residency_seconds_sum) /
+      static_cast<double>(sample.buffer_residency_count - channel.last.buffer_residency_count);
+  return slack_s * 1000.0 < static_cast<double>(policy_.min_slack_ms);
+}
+
+std::vector<LoadShedDecision> LoadShedder::Escalate() {
+  // Lowest priority with a channel that can still give up quality
+  int32_t tier = std::numeric_limits<int32_t>::max();
+  for (const auto& [channel_id, channel] : channels_) {
+    if (channel.priority < policy_.protected_priority &&
+        channel.level != decode::kMaxDecodeDegradation) {
+      tier = std::min(tier, channel.priority);
+    }
+  }
+  std::vector<LoadShedDecision> decisions;
+  if (tier == std::numeric_limits<int32_t>::max()) {
+    return decisions;  // Everything sheddable is already at keyframes only
+  }
+  for (auto& [channel_id, channel] : channels_) {
+    if (channel.priority == tier && channel.level != decode::kMaxDecodeDegradation) {
+      channel.level = Deeper(channel.level);
+      decisions.push_back({channel_id, channel.level});
+    }
+  }
+  return decisions;
+}
+
+std::vector<LoadShedDecision> LoadShedder::Relax() {
+  // Highest priority with a degraded channel gets quality back first
+  int32_t tier = std::numeric_limits<int32_t>::min();
+  bool degraded = false;
+  for (const auto& [channel_id, channel] : channels_) {
+    if (channel.level != DecodeDegradation::kNone) {
+      tier = std::max(tier, channel.priority);
+      degraded = true;
+    }
+  }
+  std::vector<LoadShedDecision> decisions;
+  if (!degraded) {
+    return decisions;
+  }
+  for (auto& [channel_id, channel] : channels_) {
+    if (channel.priority == tier && channel.level != DecodeDegradation::kNone) {
+      channel.level = Shallower(channel.level);
+      decisions.push_back({channel_id, channel.level});
+    }
+  }
+  return decisions;
+}
+
+}  // namespace retrovue::runtime
@@ -4,6 +4,8 @@
 #include <cmath>
 #include <limits>
 
+#include "retrovue/telemetry/TraceRing.h"
+
 namespace retrovue::runtime {
 
 namespace {
@@ -82,8 +84,14 @@ void OrchestrationLoop::ReportBackPressureEvent(BackPressureEvent event) {
 }
 
 OrchestrationLoop::Stats OrchestrationLoop::Snapshot() const {
-  std::lock_guard<std::mutex> lock(metrics_mutex_);
-  return stats_;
+  Stats snapshot;
+  {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    snapshot = stats_;
+  }
+  snapshot.tick_skew_us = tick_skew_us_.Views();
+  snapshot.latency_us = latency_us_.Views();
+  return snapshot;
 }
 
 void OrchestrationLoop::Run() {
@@ -121,6 +129,7 @@ void OrchestrationLoop::Run() {
         std::chrono::duration<double, std::milli>(tick_start - previous_tick_start).count();
     previous_tick_start = tick_start;
     if (gap_ms > config_.starvation_threshold_ms) {
+      RETROVUE_TRACE_INSTANT("orchestration.starvation");
       std::lock_guard<std::mutex> lock(metrics_mutex_);
       stats_.starvation_detected = true;
     }
@@ -132,9 +141,11 @@ void OrchestrationLoop::Run() {
                                           .count());
     const double skew_ms = ToMilliseconds(actual_utc - next_deadline);
     RecordTickSkew(skew_ms);
+    RETROVUE_TRACE_COUNTER("orchestration.tick_skew_us", actual_utc - next_deadline);
 
     TickResult result;
     if (tick_callback_) {
+      RETROVUE_TRACE_SCOPE("orchestration.tick");
       TickContext context{tick_index_.load(std::memory_order_relaxed), next_deadline};
       result = tick_callback_(context);
     }
@@ -159,13 +170,11 @@ void OrchestrationLoop::Run() {
 }
 
 void OrchestrationLoop::RecordTickSkew(double skew_ms) {
-  std::lock_guard<std::mutex> lock(metrics_mutex_);
-  stats_.tick_skew_ms.push_back(skew_ms);
+  tick_skew_us_.Record(std::llround(std::abs(skew_ms) * 1'000.0));
 }
 
 void OrchestrationLoop::RecordLatency(double latency_ms) {
-  std::lock_guard<std::mutex> lock(metrics_mutex_);
-  stats_.latency_ms.push_back(latency_ms);
+  latency_us_.Record(std::llround(std::max(latency_ms, 0.0) * 1'000.0));
 }
 
 void OrchestrationLoop::HandleBackPressure(const TickResult& result) {
@@ -194,26 +203,5 @@ void OrchestrationLoop::HandleBackPressure(const TickResult& result) {
   }
 }
 
-double OrchestrationLoop::ComputePercentile(const std::vector<double>& values,
-                                            double percentile) {
-  if (values.empty()) {
-    return 0.0;
-  }
-
-  std::vector<double> copy = values;
-  const double rank = percentile * static_cast<double>(copy.size() - 1);
-  const std::size_t lower_index = static_cast<std::size_t>(std::floor(rank));
-  const std::size_t upper_index = static_cast<std::size_t>(std::ceil(rank));
-  std::nth_element(copy.begin(), copy.begin() + lower_index, copy.end());
-  const double lower = copy[lower_index];
-  if (upper_index == lower_index) {
-    return lower;
-  }
-  std::nth_element(copy.begin(), copy.begin() + upper_index, copy.end());
-  const double upper = copy[upper_index];
-  const double fraction = rank - static_cast<double>(lower_index);
-  return lower + (upper - lower) * fraction;
-}
-
 }  // namespace retrovue::runtime
 
@@ -1,10 +1,13 @@
 #include "retrovue/runtime/PlayoutControlStateMachine.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <thread>
+#include <utility>
 
-#include "retrovue/producers/video_file/VideoFileProducer.h"
+#include "retrovue/producers/IProducer.h"
 
 namespace retrovue::runtime
 {
@@ -22,13 +25,7 @@ namespace retrovue::runtime
   PlayoutControlStateMachine::PlayoutControlStateMachine()
       : state_(State::kIdle),
         current_pts_us_(0),
-        illegal_transition_total_(0),
-        latency_violation_total_(0),
-        timeout_total_(0),
-        queue_overflow_total_(0),
-        recover_total_(0),
-        consistency_failure_total_(0),
-        late_seek_total_(0) {}
+        last_switch_pts_us_(0) {}
 
   bool PlayoutControlStateMachine::BeginSession(const std::string &command_id,
                                                 int64_t request_utc_us)
@@ -73,7 +70,7 @@ namespace retrovue::runtime
 
     if (latency_ms > kPauseLatencyThresholdMs)
     {
-      ++latency_violation_total_;
+      latency_violation_total_.fetch_add(1, std::memory_order_relaxed);
     }
 
     TransitionLocked(State::kPaused, effective_utc_us);
@@ -101,7 +98,7 @@ namespace retrovue::runtime
     RecordLatencyLocked(resume_latencies_ms_, latency_ms);
     if (latency_ms > kResumeLatencyThresholdMs)
     {
-      ++latency_violation_total_;
+      latency_violation_total_.fetch_add(1, std::memory_order_relaxed);
     }
 
     TransitionLocked(State::kPlaying, effective_utc_us);
@@ -121,7 +118,7 @@ namespace retrovue::runtime
 
     if (target_pts_us < current_pts_us_)
     {
-      ++late_seek_total_;
+      late_seek_total_.fetch_add(1, std::memory_order_relaxed);
       return false;
     }
 
@@ -136,7 +133,7 @@ namespace retrovue::runtime
     RecordLatencyLocked(seek_latencies_ms_, latency_ms);
     if (latency_ms > kSeekLatencyThresholdMs)
     {
-      ++latency_violation_total_;
+      latency_violation_total_.fetch_add(1, std::memory_order_relaxed);
     }
 
     TransitionLocked(State::kBuffering, request_utc_us);
@@ -167,7 +164,7 @@ namespace retrovue::runtime
     RecordLatencyLocked(stop_latencies_ms_, latency_ms);
     if (latency_ms > kStopLatencyThresholdMs)
     {
-      ++latency_violation_total_;
+      latency_violation_total_.fetch_add(1, std::memory_order_relaxed);
     }
 
     TransitionLocked(State::kStopping, request_utc_us);
@@ -191,7 +188,7 @@ namespace retrovue::runtime
     }
 
     TransitionLocked(State::kBuffering, request_utc_us);
-    ++recover_total_;
+    recover_total_.fetch_add(1, std::memory_order_relaxed);
     return true;
   }
 
@@ -199,11 +196,19 @@ namespace retrovue::runtime
                                                  std::size_t capacity,
                                                  int64_t event_utc_us)
   {
-    std::lock_guard<std::mutex> lock(mutex_);
     if (capacity == 0)
     {
       return;
     }
+    // Called every tick: only a depth that changes the state takes the lock
+    const State observed = state();
+    if (!(observed == State::kBuffering && depth >= kReadinessThresholdFrames) &&
+        !(observed == State::kPlaying && depth == 0))
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
 
     if (state_ == State::kBuffering && depth >= kReadinessThresholdFrames)
     {
@@ -220,9 +225,9 @@ namespace retrovue::runtime
       OrchestrationLoop::BackPressureEvent event,
       int64_t event_utc_us)
   {
-    std::lock_guard<std::mutex> lock(mutex_);
     if (event == OrchestrationLoop::BackPressureEvent::kUnderrun)
     {
+      std::lock_guard<std::mutex> lock(mutex_);
       if (state_ == State::kPlaying)
       {
         TransitionLocked(State::kBuffering, event_utc_us);
@@ -231,7 +236,7 @@ namespace retrovue::runtime
     else if (event == OrchestrationLoop::BackPressureEvent::kOverrun)
     {
       // Currently treated as informational; no state change but recorded.
-      ++queue_overflow_total_;
+      queue_overflow_total_.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
@@ -248,39 +253,59 @@ namespace retrovue::runtime
   void PlayoutControlStateMachine::OnExternalTimeout(int64_t event_utc_us)
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    ++timeout_total_;
+    timeout_total_.fetch_add(1, std::memory_order_relaxed);
     TransitionLocked(State::kError, event_utc_us);
   }
 
   void PlayoutControlStateMachine::OnQueueOverflow()
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ++queue_overflow_total_;
+    queue_overflow_total_.fetch_add(1, std::memory_order_relaxed);
   }
 
-  PlayoutControlStateMachine::State PlayoutControlStateMachine::state() const
+  uint64_t PlayoutControlStateMachine::TransitionCount(State from, State to) const
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return state_;
+    return Count(transitions_, from, to);
+  }
+
+  uint64_t PlayoutControlStateMachine::IllegalTransitionCount(State from,
+                                                              State attempted_to) const
+  {
+    return Count(illegal_transitions_, from, attempted_to);
   }
 
   PlayoutControlStateMachine::MetricsSnapshot PlayoutControlStateMachine::Snapshot()
       const
   {
-    std::lock_guard<std::mutex> lock(mutex_);
     MetricsSnapshot snapshot;
-    snapshot.transitions = transitions_;
-    snapshot.illegal_transition_total = illegal_transition_total_;
-    snapshot.latency_violation_total = latency_violation_total_;
-    snapshot.timeout_total = timeout_total_;
-    snapshot.queue_overflow_total = queue_overflow_total_;
-    snapshot.recover_total = recover_total_;
-    snapshot.consistency_failure_total = consistency_failure_total_;
-    snapshot.late_seek_total = late_seek_total_;
+    for (std::size_t from = 0; from < kStateCount; ++from)
+    {
+      for (std::size_t to = 0; to < kStateCount; ++to)
+      {
+        const auto from_state = static_cast<State>(from);
+        const auto to_state = static_cast<State>(to);
+        if (const uint64_t count = Count(transitions_, from_state, to_state))
+        {
+          snapshot.transitions[{from_state, to_state}] = count;
+        }
+        snapshot.illegal_transition_total += Count(illegal_transitions_, from_state, to_state);
+      }
+    }
+    snapshot.latency_violation_total = latency_violation_total_.load(std::memory_order_relaxed);
+    snapshot.timeout_total = timeout_total_.load(std::memory_order_relaxed);
+    snapshot.queue_overflow_total = queue_overflow_total_.load(std::memory_order_relaxed);
+    snapshot.recover_total = recover_total_.load(std::memory_order_relaxed);
+    snapshot.consistency_failure_total =
+        consistency_failure_total_.load(std::memory_order_relaxed);
+    snapshot.late_seek_total = late_seek_total_.load(std::memory_order_relaxed);
+    snapshot.state = state();
+
+    // Latency samples still need the lock
+    std::lock_guard<std::mutex> lock(mutex_);
     snapshot.pause_latency_p95_ms = PercentileLocked(pause_latencies_ms_, 0.95);
     snapshot.resume_latency_p95_ms = PercentileLocked(resume_latencies_ms_, 0.95);
     snapshot.seek_latency_p95_ms = PercentileLocked(seek_latencies_ms_, 0.95);
     snapshot.stop_latency_p95_ms = PercentileLocked(stop_latencies_ms_, 0.95);
+    snapshot.switch_latency_p95_ms = PercentileLocked(switch_latencies_ms_, 0.95);
     snapshot.pause_deviation_p95_ms = PercentileLocked(pause_deviation_ms_, 0.95);
     if (!pause_latencies_ms_.empty())
     {
@@ -298,11 +323,16 @@ namespace retrovue::runtime
     {
       snapshot.last_stop_latency_ms = stop_latencies_ms_.back();
     }
+    if (!switch_latencies_ms_.empty())
+    {
+      snapshot.last_switch_latency_ms = switch_latencies_ms_.back();
+    }
     if (!pause_deviation_ms_.empty())
     {
       snapshot.last_pause_deviation_ms = pause_deviation_ms_.back();
     }
-    snapshot.state = state_;
+    snapshot.switch_total = switch_latencies_ms_.size();
+    snapshot.last_switch_pts_us = last_switch_pts_us_;
     return snapshot;
   }
 
@@ -312,14 +342,47 @@ namespace retrovue::runtime
     {
       return;
     }
-    RecordTransitionLocked(state_, to);
-    state_ = to;
-    (void)event_utc_us;
+    const State from = state_;
+    RecordTransitionLocked(from, to);
+    state_.store(to, std::memory_order_release);
+    if (transition_listener_)
+    {
+      transition_listener_(from, to, event_utc_us);
+    }
+  }
+
+  const char *PlayoutControlStateMachine::StateName(State state)
+  {
+    switch (state)
+    {
+    case State::kIdle:
+      return "idle";
+    case State::kBuffering:
+      return "buffering";
+    case State::kReady:
+      return "ready";
+    case State::kPlaying:
+      return "playing";
+    case State::kPaused:
+      return "paused";
+    case State::kStopping:
+      return "stopping";
+    case State::kError:
+      return "error";
+    }
+    return "unknown";
+  }
+
+  void PlayoutControlStateMachine::setTransitionListener(TransitionListener listener)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    transition_listener_ = std::move(listener);
   }
 
   void PlayoutControlStateMachine::RecordTransitionLocked(State from, State to)
   {
-    transitions_[{from, to}]++;
+    transitions_[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)].fetch_add(
+        1, std::memory_order_relaxed);
   }
 
   void PlayoutControlStateMachine::RecordLatencyLocked(std::vector<double> &samples,
@@ -371,8 +434,9 @@ namespace retrovue::runtime
   void PlayoutControlStateMachine::RecordIllegalTransitionLocked(State from,
                                                                  State attempted_to)
   {
-    ++illegal_transition_total_;
-    transitions_[{from, attempted_to}]++;
+    illegal_transitions_[static_cast<std::size_t>(from)][static_cast<std::size_t>(attempted_to)]
+        .fetch_add(1, std::memory_order_relaxed);
+    RecordTransitionLocked(from, attempted_to);
   }
 
   void PlayoutControlStateMachine::setProducerFactory(ProducerFactory factory)
@@ -395,12 +459,14 @@ namespace retrovue::runtime
       // Reset shadow decode readiness when clearing preview slot
       if (previewSlot.producer)
       {
-        auto* video_producer = dynamic_cast<producers::video_file::VideoFileProducer*>(
+        auto* switchable = dynamic_cast<producers::ISwitchableProducer*>(
             previewSlot.producer.get());
-        if (video_producer)
+        if (switchable)
         {
-          // Reset shadow decode state before destroying producer
-          video_producer->SetShadowDecodeMode(false); // Clear readiness state
+          // Stop first so leaving shadow mode cannot splice the stale
+          // preroll into the shared ring buffer
+          switchable->stop();
+          switchable->SetShadowDecodeMode(false); // Clear readiness state
         }
       }
       previewSlot.reset();
@@ -422,10 +488,10 @@ namespace retrovue::runtime
     }
 
     // Enable shadow decode mode for preview producer
-    auto* video_producer = dynamic_cast<producers::video_file::VideoFileProducer*>(producer.get());
-    if (video_producer)
+    auto* switchable = dynamic_cast<producers::ISwitchableProducer*>(producer.get());
+    if (switchable)
     {
-      video_producer->SetShadowDecodeMode(true);
+      switchable->SetShadowDecodeMode(true);
       std::cout << "[PlayoutControlStateMachine] Enabled shadow decode mode for preview producer" << std::endl;
     }
 
@@ -447,9 +513,10 @@ namespace retrovue::runtime
     return true;
   }
 
-  bool PlayoutControlStateMachine::activatePreviewAsLive(renderer::FrameRenderer* renderer)
+  bool PlayoutControlStateMachine::activatePreviewAsLive(renderer::FrameRenderer* renderer,
+                                                         int64_t target_pts_us)
   {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
 
     // Check if preview is loaded
     if (!previewSlot.loaded || !previewSlot.producer)
@@ -458,15 +525,15 @@ namespace retrovue::runtime
       return false;
     }
 
-    auto* preview_video_producer = dynamic_cast<producers::video_file::VideoFileProducer*>(previewSlot.producer.get());
-    if (!preview_video_producer)
+    auto* preview_switchable = dynamic_cast<producers::ISwitchableProducer*>(previewSlot.producer.get());
+    if (!preview_switchable)
     {
-      std::cerr << "[PlayoutControlStateMachine] Preview producer is not a VideoFileProducer" << std::endl;
+      std::cerr << "[PlayoutControlStateMachine] Preview producer does not support seamless switching" << std::endl;
       return false;
     }
 
-    // Check if shadow decode is ready (first frame decoded and cached)
-    if (!preview_video_producer->IsShadowDecodeReady())
+    // Check if shadow decode is ready (first frame decoded and staged)
+    if (!preview_switchable->IsShadowDecodeReady())
     {
       std::cerr << "[PlayoutControlStateMachine] Preview producer shadow decode not ready" << std::endl;
       return false;
@@ -474,38 +541,94 @@ namespace retrovue::runtime
 
     std::cout << "[PlayoutControlStateMachine] Seamless switch: preview to live..." << std::endl;
 
-    // Seamless Switch Algorithm:
-    // 1. Get last PTS from live producer
-    int64_t last_live_pts = 0;
-    int64_t frame_duration_us = 0;
-    if (liveSlot.loaded && liveSlot.producer && liveSlot.producer->isRunning())
-    {
-      auto* live_video_producer = dynamic_cast<producers::video_file::VideoFileProducer*>(liveSlot.producer.get());
-      if (live_video_producer)
+    auto* live_switchable =
+        liveSlot.loaded && liveSlot.producer && liveSlot.producer->isRunning()
+            ? dynamic_cast<producers::ISwitchableProducer*>(liveSlot.producer.get())
+            : nullptr;
+
+    // Scheduled switch: the live producer holds at the target and the
+    // preview takes over on that frame. The wait runs unlocked; the slots
+    // must be unchanged when it ends.
+    bool scheduled = false;
+    if (target_pts_us > 0 && live_switchable && live_switchable->SetOutPoint(target_pts_us))
+    {
+      scheduled = true;
+      const producers::IProducer* live = liveSlot.producer.get();
+      const producers::IProducer* preview = previewSlot.producer.get();
+      const auto deadline =
+          std::chrono::steady_clock::now() +
+          std::chrono::microseconds(
+              std::max<int64_t>(target_pts_us - live_switchable->GetNextPTS(), 0) +
+              kOutPointSlackUs);
+      lock.unlock();
+      while (live->isRunning() && live_switchable->GetNextPTS() < target_pts_us &&
+             std::chrono::steady_clock::now() < deadline)
       {
-        last_live_pts = live_video_producer->GetNextPTS();
-        // Calculate frame duration (assuming 30fps for now, should get from producer config)
-        frame_duration_us = 33'366; // ~30fps in microseconds
-        std::cout << "[PlayoutControlStateMachine] Live producer last PTS: " << last_live_pts << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
       }
+      lock.lock();
+      if (liveSlot.producer.get() != live || previewSlot.producer.get() != preview)
+      {
+        if (liveSlot.producer.get() == live)
+        {
+          live_switchable->SetOutPoint(0);
+        }
+        std::cerr << "[PlayoutControlStateMachine] Slots changed while waiting for the switch"
+                  << std::endl;
+        return false;
+      }
+      if (live->isRunning() && live_switchable->GetNextPTS() < target_pts_us)
+      {
+        live_switchable->SetOutPoint(0);
+        std::cerr << "[PlayoutControlStateMachine] Live producer did not reach out point "
+                  << target_pts_us << std::endl;
+        return false;
+      }
+    }
+    else if (target_pts_us > 0 && live_switchable)
+    {
+      std::cerr << "[PlayoutControlStateMachine] Live producer cannot hold at an out point; "
+                << "switching at its next frame" << std::endl;
+    }
+    const auto switch_due = std::chrono::steady_clock::now();
+
+    // Seamless Switch Algorithm:
+    // 1. Get next PTS from live producer (the out point, if scheduled)
+    int64_t target_pts = scheduled ? target_pts_us : 0;
+    if (!scheduled && live_switchable)
+    {
+      target_pts = live_switchable->GetNextPTS();
+      std::cout << "[PlayoutControlStateMachine] Live producer next PTS: " << target_pts << std::endl;
+    }
+    else if (!scheduled && target_pts_us > 0)
+    {
+      target_pts = target_pts_us;  // Nothing live: the preview starts at the target
     }
 
     // 2. Align preview producer PTS to continue from live
-    int64_t target_pts = last_live_pts + frame_duration_us;
-    preview_video_producer->AlignPTS(target_pts);
+    preview_switchable->AlignPTS(target_pts);
     std::cout << "[PlayoutControlStateMachine] Aligned preview PTS to: " << target_pts << std::endl;
 
-    // 3. Exit shadow mode (preview producer will now write to buffer)
-    preview_video_producer->SetShadowDecodeMode(false);
-    std::cout << "[PlayoutControlStateMachine] Preview producer exited shadow mode" << std::endl;
-
-    // 4. Stop the live producer gracefully (wind down)
+    // 3. Stop the live producer gracefully (wind down). Its queued frames
+    //    stay in the ring buffer, and stopping it first keeps the buffer
+    //    single-producer for the splice below.
     if (liveSlot.loaded && liveSlot.producer && liveSlot.producer->isRunning())
     {
       std::cout << "[PlayoutControlStateMachine] Stopping current live producer gracefully" << std::endl;
       liveSlot.producer->stop();
     }
 
+    // 4. Exit shadow mode: the preview producer splices its staged preroll
+    //    into the ring buffer in one batch, then keeps decoding into it
+    preview_switchable->SetShadowDecodeMode(false);
+    std::cout << "[PlayoutControlStateMachine] Preview producer exited shadow mode" << std::endl;
+    RecordLatencyLocked(
+        switch_latencies_ms_,
+        MicrosecondsToMilliseconds(std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - switch_due)
+                                       .count()));
+    last_switch_pts_us_ = target_pts;
+
     // 5. Move preview → live (ring buffer writer swap is implicit - preview now writes)
     liveSlot.producer = std::move(previewSlot.producer);
     liveSlot.loaded = true;
@@ -18,9 +18,14 @@ ControllerResult PlayoutController::StartChannel(
     int32_t channel_id,
     const std::string& plan_handle,
     int32_t port,
-    const std::optional<std::string>& uds_path) {
+    const std::optional<std::string>& uds_path,
+    const ChannelPlacement& placement,
+    const ChannelBufferOptions& buffer,
+    int32_t priority,
+    int64_t timeline_origin_utc_us) {
   // Delegate to domain engine
-  auto result = engine_->StartChannel(channel_id, plan_handle, port, uds_path);
+  auto result = engine_->StartChannel(channel_id, plan_handle, port, uds_path, placement, buffer,
+                                      priority, timeline_origin_utc_us);
   ControllerResult controller_result(result.success, result.message);
   return controller_result;
 }
@@ -58,5 +63,48 @@ ControllerResult PlayoutController::UpdatePlan(
   return ControllerResult(result.success, result.message);
 }
 
+ControllerResult PlayoutController::ResizeBuffer(int32_t channel_id, int64_t latency_ms) {
+  // Delegate to domain engine
+  auto result = engine_->ResizeChannelBuffer(channel_id, latency_ms);
+  return ControllerResult(result.success, result.message);
+}
+
+std::vector<ControllerResult> PlayoutController::StartChannels(
+    const std::vector<ChannelStartRequest>& requests) {
+  std::vector<ControllerResult> results;
+  for (const EngineResult& result : engine_->StartChannels(requests)) {
+    results.emplace_back(result.success, result.message);
+  }
+  return results;
+}
+
+std::vector<ControllerResult> PlayoutController::StopChannels(
+    const std::vector<int32_t>& channel_ids) {
+  std::vector<ControllerResult> results;
+  for (const EngineResult& result : engine_->StopChannels(channel_ids)) {
+    results.emplace_back(result.success, result.message);
+  }
+  return results;
+}
+
+std::vector<ControllerResult> PlayoutController::LoadPreviews(
+    const std::vector<ChannelPreviewRequest>& requests) {
+  std::vector<ControllerResult> results;
+  for (const EngineResult& result : engine_->LoadPreviews(requests)) {
+    results.emplace_back(result.success, result.message);
+    results.back().shadow_decode_started = result.shadow_decode_started;
+  }
+  return results;
+}
+
+HostCapacityReport PlayoutController::GetHostCapacity() {
+  return engine_->GetHostCapacity();
+}
+
+std::shared_ptr<telemetry::ChannelWatch> PlayoutController::WatchChannels(
+    const std::vector<int32_t>& channel_ids, std::chrono::milliseconds min_interval) {
+  return engine_->WatchChannels(channel_ids, min_interval);
+}
+
 }  // namespace retrovue::runtime
 
@@ -5,22 +5,39 @@
 
 #include "retrovue/runtime/PlayoutEngine.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <vector>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "retrovue/buffer/ChannelArena.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/buffer/SharedFrameExport.h"
 #include "retrovue/decode/FrameProducer.h"
+#include "retrovue/producers/IProducer.h"
 #include "retrovue/renderer/FrameRenderer.h"
+#include "retrovue/runtime/ChannelCheckpoint.h"
+#include "retrovue/runtime/ChannelManifest.h"
 #include "retrovue/runtime/OrchestrationLoop.h"
 #include "retrovue/runtime/PlayoutControlStateMachine.h"
+#include "retrovue/runtime/TaskExecutor.h"
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/telemetry/ThumbnailGenerator.h"
+#include "retrovue/timing/DisciplinedMasterClock.h"
 #include "retrovue/timing/MasterClock.h"
 
 namespace retrovue::runtime {
 
 namespace {
-  constexpr size_t kDefaultBufferSize = 60; // 60 frames (~2 seconds at 30fps)
+  constexpr double kChannelFps = 30.0;
+  constexpr int kDefaultFrameWidth = 1920;
+  constexpr int kDefaultFrameHeight = 1080;
   constexpr size_t kReadyDepth = 3; // Minimum buffer depth for ready state
   constexpr auto kReadyTimeout = std::chrono::seconds(2);
   
@@ -33,6 +50,11 @@ namespace {
         now.time_since_epoch()).count();
   }
   
+  // Feeds are shared between previews of the same asset decoded at the same size
+  std::string FeedKey(const std::string& asset_uri, int width, int height) {
+    return asset_uri + "|" + std::to_string(width) + "x" + std::to_string(height);
+  }
+
   std::string MakeCommandId(const char* prefix, int32_t channel_id) {
     return std::string(prefix) + "-" + std::to_string(channel_id);
   }
@@ -57,6 +79,15 @@ namespace {
   }
 }  // namespace
 
+// A producer and the decode threads granted to it. Channels airing the same
+// asset at once hold the same feed, each fed into its own ring buffer; the
+// last to let go stops it.
+struct PlayoutEngine::Feed {
+  std::unique_ptr<decode::FrameProducer> producer;
+  int decode_threads = 0;
+  std::string key;  // FeedKey() it is registered under ("" = not shared)
+};
+
 // Internal channel state - manages all components for a single channel
 struct PlayoutEngine::ChannelState {
   int32_t channel_id;
@@ -66,11 +97,42 @@ struct PlayoutEngine::ChannelState {
   
   // Core components
   std::unique_ptr<buffer::FrameRingBuffer> ring_buffer;
-  std::unique_ptr<decode::FrameProducer> live_producer;
-  std::unique_ptr<decode::FrameProducer> preview_producer;  // For shadow decode/preview
+  std::shared_ptr<Feed> live;
+  std::shared_ptr<Feed> preview;  // For shadow decode/preview
   std::unique_ptr<renderer::FrameRenderer> renderer;
   std::unique_ptr<OrchestrationLoop> orchestration_loop;
   std::unique_ptr<PlayoutControlStateMachine> control;
+
+  // Resolved placement of the channel's threads and frames
+  ChannelPlacement placement;
+
+  // Load shedding order and the level its producers decode at
+  int32_t priority = 0;
+  decode::DecodeDegradation degradation = decode::DecodeDegradation::kNone;
+
+  // Buffer sizing: requested options (frame size resolved), the depth they
+  // gave and the frame memory reserved for it
+  ChannelBufferOptions buffer;
+  size_t buffer_depth = 0;
+  size_t buffer_reserved_bytes = 0;
+
+  // Frame and decoded picture memory of the channel's producers, and its
+  // export to other processes (shared with the renderer's tap; optional)
+  std::shared_ptr<buffer::ChannelArena> arena;
+  std::shared_ptr<buffer::SharedFrameExport> frame_export;
+
+  // Timeline its frames are paced on: the engine's clock, or one whose PTS 0
+  // is at the requested origin (a channel moved in from another host)
+  int64_t timeline_origin_utc_us = 0;  // As requested (0 = the engine's)
+  std::shared_ptr<timing::MasterClock> clock;
+  int64_t start_offset_us = 0;  // Media offset the live producer started from
+
+  // Serializes operations on this channel. Operations look the state up
+  // under channels_mutex_, release it, then lock this; `active` tells them
+  // whether the channel is still running once they get it (lock order:
+  // mutex, then channels_mutex_).
+  std::mutex mutex;
+  bool active = false;  // Started and not yet stopped (guarded by mutex)
   
   ChannelState(int32_t id, const std::string& plan, int32_t p, 
                const std::optional<std::string>& uds)
@@ -79,101 +141,838 @@ struct PlayoutEngine::ChannelState {
 
 PlayoutEngine::PlayoutEngine(
     std::shared_ptr<telemetry::MetricsExporter> metrics_exporter,
-    std::shared_ptr<timing::MasterClock> master_clock)
+    std::shared_ptr<timing::MasterClock> master_clock,
+    const DecodeThreadBudget& decode_budget,
+    size_t read_ahead_bytes,
+    std::shared_ptr<TaskExecutor> executor,
+    const PlacementPolicy& placement_policy,
+    const BufferPolicy& buffer_policy,
+    const LoadShedPolicy& shed_policy,
+    const HostCapacityPolicy& capacity_policy)
     : metrics_exporter_(std::move(metrics_exporter)),
-      master_clock_(std::move(master_clock)) {
+      master_clock_(std::move(master_clock)),
+      decode_budget_(decode_budget),
+      capacity_policy_(capacity_policy),
+      read_ahead_bytes_(read_ahead_bytes),
+      executor_(std::move(executor)),
+      placer_(placement_policy, NumaNodeCpus()),
+      buffer_policy_(buffer_policy),
+      buffer_budget_(buffer_policy.memory_budget_bytes),
+      shed_policy_(shed_policy),
+      shedder_(shed_policy) {
+  buffer_policy_.min_frames = std::max(buffer_policy_.min_frames, kReadyDepth);
+  buffer_policy_.max_frames = std::max(buffer_policy_.max_frames, buffer_policy_.min_frames);
+  if (buffer_policy_.latency_ms <= 0) {
+    buffer_policy_.latency_ms = BufferPolicy().latency_ms;
+  }
+  if (metrics_exporter_) {
+    metrics_exporter_->SetBufferMemoryBudget(buffer_policy_.memory_budget_bytes);
+  }
+  if (decode_budget_.max_total_threads <= 0) {
+    decode_budget_.max_total_threads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  decode_budget_.per_channel_threads = std::max(1, decode_budget_.per_channel_threads);
+  if (shed_policy_.enabled && metrics_exporter_) {
+    shed_thread_ = std::thread([this] { ShedLoop(); });
+  }
+}
+
+int PlayoutEngine::ReserveDecodeThreads() {
+  std::lock_guard<std::mutex> lock(budget_mutex_);
+  const int available = decode_budget_.max_total_threads - decode_threads_in_use_;
+  const int granted = std::clamp(available, 1, decode_budget_.per_channel_threads);
+  if (granted < decode_budget_.per_channel_threads) {
+    std::cout << "[PlayoutEngine] Decode thread cap reached (" << decode_threads_in_use_
+              << "/" << decode_budget_.max_total_threads << "), granting " << granted
+              << " thread(s)" << std::endl;
+  }
+  decode_threads_in_use_ += granted;
+  return granted;
+}
+
+void PlayoutEngine::ReleaseDecodeThreads(int threads) {
+  std::lock_guard<std::mutex> lock(budget_mutex_);
+  decode_threads_in_use_ -= threads;
+}
+
+bool PlayoutEngine::AcquireEncoderSlot() {
+  std::lock_guard<std::mutex> lock(budget_mutex_);
+  if (capacity_policy_.encoder_slots > 0 &&
+      encoder_slots_in_use_ >= capacity_policy_.encoder_slots) {
+    return false;
+  }
+  encoder_slots_in_use_++;
+  return true;
+}
+
+void PlayoutEngine::ReleaseEncoderSlot() {
+  std::lock_guard<std::mutex> lock(budget_mutex_);
+  encoder_slots_in_use_--;
+}
+
+std::shared_ptr<PlayoutEngine::ChannelState> PlayoutEngine::FindChannel(
+    int32_t channel_id) const {
+  std::lock_guard<std::mutex> lock(channels_mutex_);
+  const auto it = channels_.find(channel_id);
+  return it == channels_.end() ? nullptr : it->second;
+}
+
+void PlayoutEngine::EraseChannel(const ChannelState& state) {
+  std::lock_guard<std::mutex> lock(channels_mutex_);
+  const auto it = channels_.find(state.channel_id);
+  if (it != channels_.end() && it->second.get() == &state) {
+    channels_.erase(it);
+  }
+}
+
+std::shared_ptr<PlayoutEngine::Feed> PlayoutEngine::JoinFeed(const std::string& key,
+                                                             buffer::FrameRingBuffer& ring) {
+  std::lock_guard<std::mutex> lock(feeds_mutex_);
+  const auto it = feeds_.find(key);
+  if (it == feeds_.end()) {
+    return nullptr;
+  }
+  std::shared_ptr<Feed> feed = it->second.lock();
+  if (!feed) {
+    feeds_.erase(it);
+    return nullptr;
+  }
+  if (!feed->producer->AddOutput(ring)) {
+    return nullptr;  // Already this channel's
+  }
+  // Produced frames are counted inside the step AddOutput() serializes
+  // with, so a zero count now means ring gets every frame
+  if (feed->producer->GetFramesProduced() > 0) {
+    feed->producer->RemoveOutput(ring);
+    feeds_.erase(it);  // Past its start, no one else can join either
+    return nullptr;
+  }
+  return feed;
+}
+
+void PlayoutEngine::ReleaseFeed(ChannelState& state, std::shared_ptr<Feed>& feed, bool drain) {
+  const std::shared_ptr<Feed> released = std::move(feed);
+  if (!released) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(feeds_mutex_);
+    if (released->producer && released->producer->OutputCount() > 1) {
+      // Other channels still air it; it goes on pacing to the next of them
+      released->producer->RemoveOutput(*state.ring_buffer);
+      return;
+    }
+    const auto it = feeds_.find(released->key);
+    if (it != feeds_.end() && it->second.lock() == released) {
+      feeds_.erase(it);
+    }
+  }
+  if (released->producer) {
+    decode::FrameProducer& producer = *released->producer;
+    if (drain) {
+      producer.RequestTeardown(std::chrono::milliseconds(500));
+      while (producer.IsRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    producer.Stop();
+  }
+  ReleaseDecodeThreads(released->decode_threads);
+  released->decode_threads = 0;
+}
+
+void PlayoutEngine::ConfigureProducerIO(decode::ProducerConfig& config,
+                                        int32_t channel_id) const {
+  config.read_ahead_bytes = read_ahead_bytes_;
+  config.io_ring = io_ring_;
+  config.channel_id = channel_id;
+  // The export holds its last frames out of the pool
+  config.frame_pool_extra_slots = ExportsFrames(channel_id) ? frame_export_policy_.slots : 0;
+  if (metrics_exporter_) {
+    config.cpu_account = metrics_exporter_->AcquireChannelCpu(channel_id);
+  }
+  if (read_ahead_bytes_ > 0 && metrics_exporter_) {
+    config.on_read_stall = [exporter = metrics_exporter_, channel_id](
+                               uint64_t stalls, double stall_seconds) {
+      exporter->RecordReadStalls(channel_id, stalls, stall_seconds);
+    };
+  }
+}
+
+int PlayoutEngine::DecodeThreadsInUse() const {
+  std::lock_guard<std::mutex> lock(budget_mutex_);
+  return decode_threads_in_use_;
+}
+
+std::shared_ptr<telemetry::ChannelWatch> PlayoutEngine::WatchChannels(
+    const std::vector<int32_t>& channel_ids, std::chrono::milliseconds min_interval) {
+  return metrics_exporter_->WatchChannels(channel_ids, min_interval);
+}
+
+bool PlayoutEngine::GetChannelDegradation(int32_t channel_id,
+                                          decode::DecodeDegradation& level) const {
+  const auto found = FindChannel(channel_id);
+  if (!found) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(found->mutex);
+  if (!found->active) {
+    return false;
+  }
+  level = found->degradation;
+  return true;
+}
+
+void PlayoutEngine::ShedLoop() {
+  std::unique_lock<std::mutex> lock(shed_mutex_);
+  while (!shed_cv_.wait_for(lock, shed_policy_.interval, [this] { return shed_stop_; })) {
+    lock.unlock();
+    std::vector<std::shared_ptr<ChannelState>> states;
+    {
+      std::lock_guard<std::mutex> channels_lock(channels_mutex_);
+      for (const auto& [channel_id, state] : channels_) {
+        states.push_back(state);
+      }
+    }
+
+    // Channels still starting or gone by the time we get to them sit this one out
+    std::vector<ChannelLoadSample> samples;
+    std::vector<std::shared_ptr<ChannelState>> sampled;
+    for (const auto& state : states) {
+      telemetry::ChannelMetrics metrics;
+      std::lock_guard<std::mutex> state_lock(state->mutex);
+      if (!state->active || !metrics_exporter_->GetChannelMetrics(state->channel_id, metrics)) {
+        continue;
+      }
+      ChannelLoadSample sample;
+      sample.channel_id = state->channel_id;
+      sample.priority = state->priority;
+      sample.late_frames_total = metrics.late_frames_total;
+      sample.underruns_total = metrics.underruns_total;
+      sample.buffer_residency_seconds_sum = metrics.buffer_residency_seconds_sum;
+      sample.buffer_residency_count = metrics.buffer_residency_count;
+      samples.push_back(sample);
+      sampled.push_back(state);
+    }
+    shedder_.Evaluate(samples);
+
+    // Levels are re-applied from the shedder, so a channel restarted under
+    // the same id picks its level up again
+    for (const auto& state : sampled) {
+      const decode::DecodeDegradation level = shedder_.LevelOf(state->channel_id);
+      std::lock_guard<std::mutex> state_lock(state->mutex);
+      if (!state->active || state->degradation == level) {
+        continue;
+      }
+      std::cout << "[PlayoutEngine] Channel " << state->channel_id << " (priority "
+                << state->priority << ") decode degradation "
+                << static_cast<int>(state->degradation) << " -> " << static_cast<int>(level)
+                << (shedder_.overloaded() ? " (overloaded)" : " (recovered)") << std::endl;
+      state->degradation = level;
+      // A shared feed decodes at the level its channels set last
+      if (state->live) {
+        state->live->producer->SetDegradation(level);
+      }
+      if (state->preview) {
+        state->preview->producer->SetDegradation(level);
+      }
+    }
+    lock.lock();
+  }
+}
+
+bool PlayoutEngine::GetChannelPlacement(int32_t channel_id,
+                                        ChannelPlacement& placement) const {
+  const auto found = FindChannel(channel_id);
+  if (!found) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(found->mutex);
+  if (!found->active) {
+    return false;
+  }
+  placement = found->placement;
+  return true;
+}
+
+bool PlayoutEngine::GetChannelBuffer(int32_t channel_id, ChannelBufferReport& report) const {
+  const auto found = FindChannel(channel_id);
+  if (!found) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(found->mutex);
+  if (!found->active || !found->ring_buffer) {
+    return false;
+  }
+  report.depth_limit_frames = found->ring_buffer->DepthLimit();
+  report.depth_frames = found->ring_buffer->Size();
+  report.frame_bytes = buffer::Yuv420FrameBytes(found->buffer.width, found->buffer.height);
+  report.reserved_bytes = found->buffer_reserved_bytes;
+  report.used_bytes = report.depth_frames * report.frame_bytes;
+  report.latency_ms = found->buffer.latency_ms;
+  return true;
+}
+
+size_t PlayoutEngine::BufferDepthFor(int64_t latency_ms) const {
+  const size_t depth = buffer::DepthForLatency(
+      latency_ms > 0 ? latency_ms : buffer_policy_.latency_ms, kChannelFps);
+  return std::clamp(depth, buffer_policy_.min_frames, buffer_policy_.max_frames);
+}
+
+size_t PlayoutEngine::ChannelBufferBytes(const ChannelState& state, size_t depth,
+                                         int producers) const {
+  decode::ProducerConfig config;
+  config.target_width = state.buffer.width;
+  config.target_height = state.buffer.height;
+  config.frame_pool_extra_slots = ExportsFrames(state.channel_id) ? frame_export_policy_.slots : 0;
+  return decode::FrameProducer::FramePoolBytes(config, depth) * static_cast<size_t>(producers);
+}
+
+bool PlayoutEngine::ReserveChannelBuffer(ChannelState& state, std::string& error) {
+  size_t depth = BufferDepthFor(state.buffer.latency_ms);
+  if (!buffer_budget_.Reserve(ChannelBufferBytes(state, depth, 1))) {
+    // Take what is left, if that still makes a workable buffer
+    const size_t per_frame = ChannelBufferBytes(state, 1, 1) - ChannelBufferBytes(state, 0, 1);
+    const size_t fixed = ChannelBufferBytes(state, 0, 1);
+    const size_t available = buffer_budget_.Available();
+    const size_t fit = available > fixed ? (available - fixed) / per_frame : 0;
+    if (fit < buffer_policy_.min_frames ||
+        !buffer_budget_.Reserve(ChannelBufferBytes(state, fit, 1))) {
+      error = "Frame memory budget exhausted: channel " + std::to_string(state.channel_id) +
+              " needs " + std::to_string(ChannelBufferBytes(state, buffer_policy_.min_frames, 1)) +
+              " bytes, " + std::to_string(available) + " available";
+      return false;
+    }
+    std::cerr << "[PlayoutEngine] Channel " << state.channel_id << " buffer cut from " << depth
+              << " to " << fit << " frames to fit the memory budget" << std::endl;
+    depth = fit;
+  }
+  state.buffer_depth = depth;
+  state.buffer_reserved_bytes = ChannelBufferBytes(state, depth, 1);
+  return true;
+}
+
+void PlayoutEngine::ReleaseChannelBuffer(ChannelState& state) {
+  buffer_budget_.Release(state.buffer_reserved_bytes);
+  state.buffer_reserved_bytes = 0;
+  state.buffer_depth = 0;
+  metrics_exporter_->RecordBufferMemory(state.channel_id, telemetry::BufferMemoryMetrics());
+  if (state.frame_export) {
+    // Its held frames go once the renderer's tap lets go of it too
+    state.frame_export->Stop();
+    state.frame_export.reset();
+  }
+  if (state.arena) {
+    // Cached blocks go back now, blocks still held (frames a sink or a tap
+    // keeps) as they are freed
+    state.arena->Release();
+    state.arena.reset();
+  }
+}
+
+void PlayoutEngine::RecordChannelBuffer(const ChannelState& state) const {
+  telemetry::BufferMemoryMetrics memory;
+  memory.depth_limit_frames = state.buffer_depth;
+  memory.frame_bytes = buffer::Yuv420FrameBytes(state.buffer.width, state.buffer.height);
+  memory.reserved_bytes = state.buffer_reserved_bytes;
+  metrics_exporter_->RecordBufferMemory(state.channel_id, memory);
+}
+
+EngineResult PlayoutEngine::ResizeChannelBuffer(int32_t channel_id, int64_t latency_ms) {
+  const auto state = FindChannel(channel_id);
+  if (!state) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
+  }
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  if (!state->active) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
+  }
+
+  const size_t depth = std::min(BufferDepthFor(latency_ms), state->ring_buffer->Capacity());
+  const int producers = state->preview ? 2 : 1;
+  const size_t bytes = ChannelBufferBytes(*state, depth, producers);
+  if (!buffer_budget_.Resize(state->buffer_reserved_bytes, bytes)) {
+    return EngineResult(false, "Frame memory budget cannot hold " + std::to_string(depth) +
+                                   " frames for channel " + std::to_string(channel_id));
+  }
+  state->buffer.latency_ms = latency_ms;
+  if (manifest_) {
+    manifest_->Update(channel_id, [latency_ms](ChannelStartRequest& entry) {
+      entry.buffer.latency_ms = latency_ms;
+    });
+  }
+  state->buffer_depth = depth;
+  state->buffer_reserved_bytes = bytes;
+  // Producers replace their frame pools on their next frame
+  state->ring_buffer->SetDepthLimit(depth);
+  RecordChannelBuffer(*state);
+  return EngineResult(true, "Channel " + std::to_string(channel_id) + " buffer resized to " +
+                                std::to_string(depth) + " frames");
+}
+
+HostCapacityReport PlayoutEngine::GetHostCapacity() {
+  HostCapacityReport report;
+  report.host_id = capacity_policy_.host_id;
+#ifdef __linux__
+  if (report.host_id.empty()) {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) == 0) {
+      report.host_id = name;
+    }
+  }
+#endif
+  report.cpu_cores = static_cast<int>(std::thread::hardware_concurrency());
+  {
+    std::lock_guard<std::mutex> lock(host_cpu_mutex_);
+    telemetry::HostCpuTimes now;
+    if (telemetry::ReadHostCpuTimes(&now)) {
+      report.cpu_busy_ratio = telemetry::HostCpuBusyRatio(host_cpu_, now);
+      host_cpu_ = now;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(budget_mutex_);
+    report.decode_threads_total = decode_budget_.max_total_threads;
+    report.decode_threads_in_use = decode_threads_in_use_;
+    report.encoder_slots_total = capacity_policy_.encoder_slots;
+    report.encoder_slots_in_use = encoder_slots_in_use_;
+  }
+  const buffer::FrameMemoryBudgetStats memory = buffer_budget_.GetStats();
+  report.memory_budget_bytes = memory.limit_bytes;
+  report.memory_reserved_bytes = memory.reserved_bytes;
+  if (const auto* disciplined =
+          dynamic_cast<const timing::DisciplinedMasterClock*>(master_clock_.get())) {
+    const timing::ClockDisciplineStats clock = disciplined->GetStats();
+    report.clock_disciplined = true;
+    report.clock_locked = clock.locked;
+    report.clock_offset_us = clock.offset_us;
+  }
+
+  std::vector<std::shared_ptr<ChannelState>> states;
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    for (const auto& [channel_id, state] : channels_) {
+      states.push_back(state);
+    }
+  }
+  for (const auto& state : states) {
+    std::lock_guard<std::mutex> state_lock(state->mutex);
+    if (!state->active) {
+      continue;
+    }
+    HostChannelReport channel;
+    channel.channel_id = state->channel_id;
+    channel.plan_handle = state->plan_handle;
+    channel.priority = state->priority;
+    channel.timeline_origin_utc_us = state->clock ? state->clock->scheduled_to_utc_us(0) : 0;
+    channel.decode_threads = (state->live ? state->live->decode_threads : 0) +
+                             (state->preview ? state->preview->decode_threads : 0);
+    channel.reserved_bytes = state->buffer_reserved_bytes;
+    report.channels.push_back(std::move(channel));
+  }
+  std::sort(report.channels.begin(), report.channels.end(),
+            [](const HostChannelReport& a, const HostChannelReport& b) {
+              return a.channel_id < b.channel_id;
+            });
+  return report;
+}
+
+bool PlayoutEngine::GetChannelTiming(int32_t channel_id, ChannelTimingReport& report) const {
+  const auto found = FindChannel(channel_id);
+  if (!found) {
+    return false;
+  }
+  ChannelState& state = *found;
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.active || !state.renderer) {
+    return false;
+  }
+  report.render = state.renderer->GetTimingStats();
+  const decode::FrameProducer* producer = state.live ? state.live->producer.get() : nullptr;
+  report.producer_cpu_ns = producer ? producer->GetThreadCpuNs() : 0;
+  report.frames_produced = producer ? producer->GetFramesProduced() : 0;
+  report.producer_running = producer && producer->IsRunning();
+  return true;
 }
 
 PlayoutEngine::~PlayoutEngine() {
+  if (checkpoint_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+      checkpoint_stop_ = true;
+    }
+    checkpoint_cv_.notify_all();
+    checkpoint_thread_.join();
+  }
+  if (shed_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(shed_mutex_);
+      shed_stop_ = true;
+    }
+    shed_cv_.notify_all();
+    shed_thread_.join();
+  }
+
   // Stop all channels on destruction
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  for (auto& [channel_id, state] : channels_) {
-    if (state) {
-      StopChannel(channel_id);
+  std::vector<int32_t> channel_ids;
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    for (const auto& [channel_id, state] : channels_) {
+      channel_ids.push_back(channel_id);
     }
   }
-  channels_.clear();
+  for (const int32_t channel_id : channel_ids) {
+    StopChannelImpl(channel_id, /*forget=*/false);
+  }
+}
+
+void PlayoutEngine::SetChannelManifest(std::shared_ptr<ChannelManifest> manifest) {
+  manifest_ = std::move(manifest);
+}
+
+void PlayoutEngine::SetChannelCheckpoints(std::shared_ptr<ChannelCheckpointFile> checkpoints,
+                                          std::chrono::milliseconds interval) {
+  checkpoints_ = std::move(checkpoints);
+  checkpoint_interval_ = std::max(interval, std::chrono::milliseconds(1));
+  if (checkpoints_ && !checkpoint_thread_.joinable()) {
+    checkpoint_thread_ = std::thread([this] { CheckpointLoop(); });
+  }
+}
+
+void PlayoutEngine::CheckpointLoop() {
+  std::unique_lock<std::mutex> lock(checkpoint_mutex_);
+  while (!checkpoint_cv_.wait_for(lock, checkpoint_interval_,
+                                  [this] { return checkpoint_stop_; })) {
+    lock.unlock();
+    std::vector<std::shared_ptr<ChannelState>> states;
+    {
+      std::lock_guard<std::mutex> channels_lock(channels_mutex_);
+      for (const auto& [channel_id, state] : channels_) {
+        states.push_back(state);
+      }
+    }
+    for (const auto& state : states) {
+      std::lock_guard<std::mutex> state_lock(state->mutex);
+      if (state->active) {
+        WriteCheckpoint(*state);
+      }
+    }
+    lock.lock();
+  }
+}
+
+void PlayoutEngine::WriteCheckpoint(const ChannelState& state) {
+  if (!checkpoints_ || !state.clock) {
+    return;
+  }
+  ChannelCheckpoint checkpoint;
+  checkpoint.channel_id = state.channel_id;
+  checkpoint.plan_handle = state.plan_handle;
+  checkpoint.timeline_origin_utc_us = state.clock->scheduled_to_utc_us(0);
+  checkpoint.start_offset_us = state.start_offset_us;
+  checkpoint.written_utc_us = NowUtc(master_clock_);
+  checkpoint.pts_us = checkpoint.written_utc_us - checkpoint.timeline_origin_utc_us;
+  const decode::FrameProducer* producer = state.live ? state.live->producer.get() : nullptr;
+  checkpoint.frames_produced = producer ? producer->GetFramesProduced() : 0;
+  checkpoints_->Write(checkpoint);
+}
+
+void PlayoutEngine::SetChannelSinkFactory(ChannelSinkFactory factory) {
+  sink_factory_ = std::move(factory);
+}
+
+void PlayoutEngine::SetThumbnailGenerator(
+    std::shared_ptr<telemetry::ThumbnailGenerator> thumbnails) {
+  thumbnails_ = std::move(thumbnails);
+}
+
+void PlayoutEngine::SetIoRing(std::shared_ptr<IoRing> io_ring) {
+  io_ring_ = std::move(io_ring);
+}
+
+void PlayoutEngine::SetEncoderThreadBudget(
+    std::shared_ptr<playout_sinks::mpegts::EncoderThreadBudget> encoder_threads) {
+  encoder_threads_ = std::move(encoder_threads);
+}
+
+void PlayoutEngine::SetFrameExportPolicy(FrameExportPolicy policy) {
+  policy.slots = std::max<size_t>(policy.slots, 1);
+  frame_export_policy_ = std::move(policy);
+}
+
+bool PlayoutEngine::ExportsFrames(int32_t channel_id) const {
+  const auto& ids = frame_export_policy_.channel_ids;
+  return frame_export_policy_.all_channels ||
+         std::find(ids.begin(), ids.end(), channel_id) != ids.end();
+}
+
+std::vector<EngineResult> PlayoutEngine::RestoreChannels() {
+  std::vector<ChannelStartRequest> requests;
+  if (!manifest_ || !manifest_->Load(requests) || requests.empty()) {
+    return {};
+  }
+  std::cout << "[PlayoutEngine] Restoring " << requests.size() << " channels from "
+            << manifest_->path() << std::endl;
+  // Channels on this host's timeline resume where it is now; the seeks run
+  // in the batch, in parallel
+  if (checkpoints_) {
+    const int64_t now = NowUtc(master_clock_);
+    for (ChannelStartRequest& request : requests) {
+      ChannelCheckpoint checkpoint;
+      if (checkpoints_->Read(request.channel_id, checkpoint) &&
+          ResumeFromCheckpoint(checkpoint, request)) {
+        std::cout << "[PlayoutEngine] Channel " << request.channel_id << " resumes at "
+                  << (now - checkpoint.timeline_origin_utc_us) / 1000 << " ms (checkpoint at "
+                  << checkpoint.pts_us / 1000 << " ms, "
+                  << (now - checkpoint.written_utc_us) / 1000 << " ms ago)" << std::endl;
+      }
+    }
+  }
+  // Every channel is visible as coming up before the first one finishes
+  for (const ChannelStartRequest& request : requests) {
+    telemetry::ChannelMetrics metrics{};
+    metrics.state = telemetry::ChannelState::BUFFERING;
+    metrics_exporter_->SubmitChannelMetrics(request.channel_id, metrics);
+  }
+  const auto started = std::chrono::steady_clock::now();
+  std::vector<EngineResult> results = RunBatch(requests.size(), [&](size_t i) {
+    const ChannelStartRequest& request = requests[i];
+    EngineResult result =
+        StartChannel(request.channel_id, request.plan_handle, request.port, request.uds_path,
+                     request.placement, request.buffer, request.priority,
+                     request.timeline_origin_utc_us);
+    const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - started)
+                                .count();
+    if (result.success) {
+      std::cout << "[PlayoutEngine] Channel " << request.channel_id << " restored in "
+                << elapsed_ms << " ms" << std::endl;
+    } else {
+      std::cerr << "[PlayoutEngine] Channel " << request.channel_id
+                << " failed to restore: " << result.message << std::endl;
+      telemetry::ChannelMetrics metrics{};
+      metrics.state = telemetry::ChannelState::ERROR_STATE;
+      metrics_exporter_->SubmitChannelMetrics(request.channel_id, metrics);
+    }
+    return result;
+  });
+  return results;
 }
 
 EngineResult PlayoutEngine::StartChannel(
     int32_t channel_id,
     const std::string& plan_handle,
     int32_t port,
-    const std::optional<std::string>& uds_path) {
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  
-  // Check if channel already exists
-  if (channels_.find(channel_id) != channels_.end()) {
-    return EngineResult(true, "Channel " + std::to_string(channel_id) + " already started");
+    const std::optional<std::string>& uds_path,
+    const ChannelPlacement& placement,
+    const ChannelBufferOptions& buffer,
+    int32_t priority,
+    int64_t timeline_origin_utc_us) {
+  // Claim the id with an inactive entry, then start outside channels_mutex_:
+  // operations on this channel wait on its mutex, all others proceed.
+  const auto state = std::make_shared<ChannelState>(channel_id, plan_handle, port, uds_path);
+  std::unique_lock<std::mutex> state_lock(state->mutex);  // Uncontended: not yet published
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    if (!channels_.emplace(channel_id, state).second) {
+      return EngineResult(true, "Channel " + std::to_string(channel_id) + " already started");
+    }
   }
-  
+
+  if (!AcquireEncoderSlot()) {
+    EraseChannel(*state);
+    return EngineResult(false, "No encoder slot left for channel " + std::to_string(channel_id) +
+                                   " (" + std::to_string(capacity_policy_.encoder_slots) +
+                                   " in use)");
+  }
+  if (!placer_.Acquire(placement, state->placement)) {
+    ReleaseEncoderSlot();
+    EraseChannel(*state);
+    return EngineResult(false, "Unknown NUMA node " + std::to_string(placement.numa_node) +
+                                   " for channel " + std::to_string(channel_id));
+  }
+  state->priority = priority;
+  state->timeline_origin_utc_us = timeline_origin_utc_us;
+  state->buffer = buffer;
+  if (state->buffer.width <= 0 || state->buffer.height <= 0) {
+    state->buffer.width = kDefaultFrameWidth;
+    state->buffer.height = kDefaultFrameHeight;
+  }
+  std::string buffer_error;
+  if (!ReserveChannelBuffer(*state, buffer_error)) {
+    placer_.Release(state->placement);
+    ReleaseEncoderSlot();
+    EraseChannel(*state);
+    return EngineResult(false, buffer_error);
+  }
+  EngineResult result = StartChannelLocked(*state);
+  if (result.success) {
+    state->active = true;
+    RecordChannelBuffer(*state);
+    WriteCheckpoint(*state);  // A crash before the first interval still resumes
+    if (manifest_) {
+      // The request, not the resolution, so a restore re-applies the policy
+      ChannelStartRequest entry;
+      entry.channel_id = channel_id;
+      entry.plan_handle = plan_handle;
+      entry.port = port;
+      entry.uds_path = uds_path;
+      entry.placement = placement;
+      entry.buffer = buffer;
+      entry.priority = priority;
+      entry.timeline_origin_utc_us = timeline_origin_utc_us;
+      manifest_->Put(entry);
+    }
+  } else {
+    ReleaseFeed(*state, state->live, /*drain=*/false);
+    ReleaseChannelBuffer(*state);
+    placer_.Release(state->placement);
+    ReleaseEncoderSlot();
+    EraseChannel(*state);
+  }
+  return result;
+}
+
+EngineResult PlayoutEngine::StartChannelLocked(ChannelState& state) {
+  const int32_t channel_id = state.channel_id;
   try {
-    // Create channel state
-    auto state = std::make_unique<ChannelState>(channel_id, plan_handle, port, uds_path);
-    
-    // Create ring buffer
-    state->ring_buffer = std::make_unique<buffer::FrameRingBuffer>(kDefaultBufferSize);
+    // Exported frames live in a memfd the readers map; it is sparse, so
+    // room for twice the deepest buffer (a pool being replaced, the
+    // decoders' pictures) costs address space only
+    if (ExportsFrames(channel_id)) {
+      state.arena = buffer::ChannelArena::CreateShared(
+          2 * ChannelBufferBytes(state, buffer_policy_.max_frames, 1),
+          buffer::SharedFrameExport::FrontBytes(frame_export_policy_.slots));
+      if (!state.arena) {
+        std::cerr << "[PlayoutEngine] Channel " << channel_id
+                  << " frames cannot be shared; not exporting them" << std::endl;
+      }
+    }
+    if (!state.arena) {
+      state.arena = buffer::ChannelArena::Create();
+    }
+    metrics_exporter_->SetChannelArena(channel_id, state.arena);
+
+    // Create ring buffer, with room to grow up to the policy's deepest
+    state.ring_buffer = std::make_unique<buffer::FrameRingBuffer>(
+        std::max(buffer_policy_.max_frames, state.buffer_depth));
+    state.ring_buffer->SetDepthLimit(state.buffer_depth);
     
-    // Create control state machine
-    state->control = std::make_unique<PlayoutControlStateMachine>();
+    // Create control state machine; watchers see its transitions as they happen
+    state.control = std::make_unique<PlayoutControlStateMachine>();
+    state.control->setTransitionListener(
+        [exporter = metrics_exporter_, channel_id](PlayoutControlStateMachine::State,
+                                                   PlayoutControlStateMachine::State to,
+                                                   int64_t) {
+          exporter->RecordControlState(channel_id, PlayoutControlStateMachine::StateName(to));
+        });
     
     // Create producer config from plan_handle (simplified - in production, resolve plan to asset)
     decode::ProducerConfig producer_config;
-    producer_config.asset_uri = plan_handle; // For now, use plan_handle as asset URI
-    producer_config.target_fps = 30.0;
+    producer_config.asset_uri = state.plan_handle; // For now, use plan_handle as asset URI
+    producer_config.target_width = state.buffer.width;
+    producer_config.target_height = state.buffer.height;
+    producer_config.target_fps = kChannelFps;
     producer_config.stub_mode = false; // Use real decode
+    state.live = std::make_shared<Feed>();
+    state.live->decode_threads = ReserveDecodeThreads();
+    producer_config.max_decode_threads = state.live->decode_threads;
+    producer_config.placement = state.placement;
+    ConfigureProducerIO(producer_config, channel_id);
+    producer_config.arena = state.arena;
+
+    // On another host's timeline, start from the point of the plan due now
+    state.clock = master_clock_;
+    if (state.timeline_origin_utc_us != 0 && master_clock_) {
+      state.clock = timing::MakeTimelineMasterClock(master_clock_, state.timeline_origin_utc_us);
+      producer_config.start_offset_us =
+          std::max<int64_t>(0, NowUtc(master_clock_) - state.timeline_origin_utc_us);
+    }
+    state.start_offset_us = producer_config.start_offset_us;
     
     // Create live producer
-    state->live_producer = std::make_unique<decode::FrameProducer>(
-        producer_config, *state->ring_buffer, master_clock_);
+    state.live->producer = std::make_unique<decode::FrameProducer>(
+        producer_config, *state.ring_buffer, state.clock);
+    state.live->producer->SetExecutor(executor_);
     
     // Create renderer
     renderer::RenderConfig render_config;
     render_config.mode = renderer::RenderMode::HEADLESS;
-    state->renderer = renderer::FrameRenderer::Create(
-        render_config, *state->ring_buffer, master_clock_, metrics_exporter_, channel_id);
+    render_config.placement = state.placement;
+    if (sink_factory_) {
+      render_config.sink = sink_factory_(channel_id, state.port);
+      if (render_config.sink) {
+        render_config.mode = renderer::RenderMode::SINK;
+      }
+    }
+    state.renderer = renderer::FrameRenderer::Create(
+        render_config, *state.ring_buffer, state.clock, metrics_exporter_, channel_id);
+    state.renderer->SetExecutor(executor_);
+    if (state.arena->SharedFd() >= 0) {
+      state.frame_export = std::make_shared<buffer::SharedFrameExport>(
+          state.arena, channel_id, frame_export_policy_.slots);
+      const std::string socket_path = frame_export_policy_.socket_dir + "/frames-" +
+                                      std::to_string(channel_id) + ".sock";
+      if (!state.frame_export->IsValid() || !state.frame_export->Listen(socket_path)) {
+        state.frame_export.reset();
+      }
+    }
+    auto thumbnail_tap = thumbnails_ ? thumbnails_->AddChannel(channel_id) : nullptr;
+    if (thumbnail_tap || state.frame_export) {
+      state.renderer->SetFrameTap([thumbnail_tap, frame_export = state.frame_export](
+                                      const buffer::FrameHandle& frame) {
+        if (thumbnail_tap) {
+          thumbnail_tap->Offer(frame);
+        }
+        if (frame_export) {
+          frame_export->Publish(frame);
+        }
+      });
+    }
     
     // Start control state machine
     const int64_t now = NowUtc(master_clock_);
-    if (!state->control->BeginSession(MakeCommandId("start", channel_id), now)) {
+    if (!state.control->BeginSession(MakeCommandId("start", channel_id), now)) {
       return EngineResult(false, "Failed to begin session for channel " + std::to_string(channel_id));
     }
     
     // Start producer
-    if (!state->live_producer->Start()) {
+    if (!state.live->producer->Start()) {
       return EngineResult(false, "Failed to start producer for channel " + std::to_string(channel_id));
     }
     
     // Start renderer
-    if (!state->renderer->Start()) {
+    if (!state.renderer->Start()) {
       return EngineResult(false, "Failed to start renderer for channel " + std::to_string(channel_id));
     }
     
     // Wait for minimum buffer depth (like ChannelManagerStub)
     const auto start_time = std::chrono::steady_clock::now();
-    while (state->ring_buffer->Size() < kReadyDepth) {
+    while (state.ring_buffer->Size() < kReadyDepth) {
       if (std::chrono::steady_clock::now() - start_time > kReadyTimeout) {
         telemetry::ChannelMetrics metrics{};
         metrics.state = telemetry::ChannelState::BUFFERING;
-        metrics.buffer_depth_frames = state->ring_buffer->Size();
+        metrics.buffer_depth_frames = state.ring_buffer->Size();
         metrics_exporter_->SubmitChannelMetrics(channel_id, metrics);
         return EngineResult(false, "Timeout waiting for buffer depth on channel " + std::to_string(channel_id));
       }
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
     
+    // Steady state starts here; water marks should not reflect priming.
+    state.ring_buffer->ResetWaterMarks();
+
     // Update state machine with buffer depth
-    state->control->OnBufferDepth(state->ring_buffer->Size(), kDefaultBufferSize, NowUtc(master_clock_));
+    state.control->OnBufferDepth(state.ring_buffer->Size(), state.buffer_depth,
+                                 NowUtc(master_clock_));
     
     // Submit ready metrics
     telemetry::ChannelMetrics metrics{};
     metrics.state = telemetry::ChannelState::READY;
-    metrics.buffer_depth_frames = state->ring_buffer->Size();
+    metrics.buffer_depth_frames = state.ring_buffer->Size();
     metrics_exporter_->SubmitChannelMetrics(channel_id, metrics);
     
-    // Store channel state
-    channels_[channel_id] = std::move(state);
-    
     return EngineResult(true, "Channel " + std::to_string(channel_id) + " started successfully");
   } catch (const std::exception& e) {
     return EngineResult(false, "Exception starting channel " + std::to_string(channel_id) + ": " + e.what());
@@ -181,16 +980,17 @@ EngineResult PlayoutEngine::StartChannel(
 }
 
 EngineResult PlayoutEngine::StopChannel(int32_t channel_id) {
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  
-  auto it = channels_.find(channel_id);
-  if (it == channels_.end()) {
+  return StopChannelImpl(channel_id, /*forget=*/true);
+}
+
+EngineResult PlayoutEngine::StopChannelImpl(int32_t channel_id, bool forget) {
+  const auto state = FindChannel(channel_id);
+  if (!state) {
     return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
-  
-  auto& state = it->second;
-  if (!state) {
-    return EngineResult(false, "Channel " + std::to_string(channel_id) + " state is null");
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  if (!state->active) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
   
   try {
@@ -206,29 +1006,13 @@ EngineResult PlayoutEngine::StopChannel(int32_t channel_id) {
       state->renderer->Stop();
     }
     
-    // Stop producers
-    if (state->live_producer) {
-      state->live_producer->RequestTeardown(std::chrono::milliseconds(500));
-      while (state->live_producer->IsRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      }
-      state->live_producer->Stop();
-    }
-    
-    if (state->preview_producer) {
-      state->preview_producer->RequestTeardown(std::chrono::milliseconds(500));
-      while (state->preview_producer->IsRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      }
-      state->preview_producer->Stop();
-    }
+    // Stop producers (shared ones only detach) and return their decoder threads
+    ReleaseFeed(*state, state->live, /*drain=*/true);
+    ReleaseFeed(*state, state->preview, /*drain=*/true);
     
-    // Drain buffer
+    // Drain buffer (single index update, no payload copies)
     if (state->ring_buffer) {
-      buffer::Frame frame;
-      while (state->ring_buffer->Pop(frame)) {
-        // Drain all frames
-      }
+      state->ring_buffer->Discard(state->ring_buffer->Size());
       state->ring_buffer->Clear();
     }
     
@@ -237,9 +1021,22 @@ EngineResult PlayoutEngine::StopChannel(int32_t channel_id) {
     metrics.state = telemetry::ChannelState::STOPPED;
     metrics.buffer_depth_frames = 0;
     metrics_exporter_->SubmitChannelMetrics(channel_id, metrics);
+    if (thumbnails_) {
+      thumbnails_->RemoveChannel(channel_id);
+    }
     
     // Remove channel
-    channels_.erase(it);
+    ReleaseChannelBuffer(*state);
+    placer_.Release(state->placement);
+    ReleaseEncoderSlot();
+    state->active = false;
+    EraseChannel(*state);
+    if (forget && manifest_) {
+      manifest_->Remove(channel_id);
+    }
+    if (forget && checkpoints_) {
+      checkpoints_->Clear(channel_id);
+    }
     
     return EngineResult(true, "Channel " + std::to_string(channel_id) + " stopped successfully");
   } catch (const std::exception& e) {
@@ -250,37 +1047,88 @@ EngineResult PlayoutEngine::StopChannel(int32_t channel_id) {
 EngineResult PlayoutEngine::LoadPreview(
     int32_t channel_id,
     const std::string& asset_path) {
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  
-  auto it = channels_.find(channel_id);
-  if (it == channels_.end()) {
+  return LoadPreviewImpl(channel_id, asset_path, nullptr);
+}
+
+EngineResult PlayoutEngine::LoadPreviewImpl(int32_t channel_id, const std::string& asset_path,
+                                            std::shared_ptr<Feed>* held) {
+  const auto state = FindChannel(channel_id);
+  if (!state) {
     return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
-  
-  auto& state = it->second;
-  if (!state) {
-    return EngineResult(false, "Channel " + std::to_string(channel_id) + " state is null");
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  if (!state->active) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
   
   try {
     // Create preview producer config
     decode::ProducerConfig preview_config;
     preview_config.asset_uri = asset_path;
-    preview_config.target_fps = 30.0;
+    preview_config.target_width = state->buffer.width;
+    preview_config.target_height = state->buffer.height;
+    preview_config.target_fps = kChannelFps;
     preview_config.stub_mode = false;
+
+    // A replaced preview returns its threads before the new one is granted
+    ReleaseFeed(*state, state->preview, /*drain=*/false);
+
+    // The preview decodes into a frame pool of its own (a joined one holds
+    // copies of as many frames)
+    const size_t two_pools = ChannelBufferBytes(*state, state->buffer_depth, 2);
+    if (!buffer_budget_.Resize(state->buffer_reserved_bytes, two_pools)) {
+      return EngineResult(false, "Frame memory budget cannot hold a preview for channel " +
+                                     std::to_string(channel_id));
+    }
+    state->buffer_reserved_bytes = two_pools;
+
+    // Simulcast: a channel that just opened this asset decodes it for both
+    const std::string key = FeedKey(asset_path, state->buffer.width, state->buffer.height);
+    if (auto shared = JoinFeed(key, *state->ring_buffer)) {
+      state->preview = std::move(shared);
+      RecordChannelBuffer(*state);
+      EngineResult result(true, "Preview loaded for channel " + std::to_string(channel_id) +
+                                    " (decode shared)");
+      result.shadow_decode_started = true;
+      result.decode_shared = true;
+      return result;
+    }
+
+    const auto feed = std::make_shared<Feed>();
+    feed->key = key;
+    feed->decode_threads = ReserveDecodeThreads();
+    preview_config.max_decode_threads = feed->decode_threads;
+    preview_config.placement = state->placement;
+    ConfigureProducerIO(preview_config, channel_id);
+    preview_config.arena = state->arena;
     
     // Create preview producer (shadow decode - doesn't write to buffer yet)
     // Note: FrameProducer doesn't currently support shadow mode directly,
     // so we create it but don't start it writing to buffer until SwitchToLive
-    state->preview_producer = std::make_unique<decode::FrameProducer>(
-        preview_config, *state->ring_buffer, master_clock_);
+    feed->producer = std::make_unique<decode::FrameProducer>(
+        preview_config, *state->ring_buffer, state->clock);
+    feed->producer->SetExecutor(executor_);
+    feed->producer->SetDegradation(state->degradation);
+    state->preview = feed;
+    {
+      std::lock_guard<std::mutex> lock(feeds_mutex_);
+      feeds_[key] = feed;
+    }
     
     // For now, start it normally (in a real implementation, shadow mode would
     // decode without writing to buffer until SwitchToLive)
-    if (!state->preview_producer->Start()) {
+    if (held) {
+      *held = feed;  // Others join before the caller starts it
+    } else if (!feed->producer->Start()) {
+      ReleaseFeed(*state, state->preview, /*drain=*/false);
+      const size_t one_pool = ChannelBufferBytes(*state, state->buffer_depth, 1);
+      buffer_budget_.Resize(state->buffer_reserved_bytes, one_pool);
+      state->buffer_reserved_bytes = one_pool;
+      RecordChannelBuffer(*state);
       return EngineResult(false, "Failed to start preview producer for channel " + std::to_string(channel_id));
     }
     
+    RecordChannelBuffer(*state);
     EngineResult result(true, "Preview loaded for channel " + std::to_string(channel_id));
     result.shadow_decode_started = true;
     return result;
@@ -290,35 +1138,29 @@ EngineResult PlayoutEngine::LoadPreview(
 }
 
 EngineResult PlayoutEngine::SwitchToLive(int32_t channel_id) {
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  
-  auto it = channels_.find(channel_id);
-  if (it == channels_.end()) {
+  const auto state = FindChannel(channel_id);
+  if (!state) {
     return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
-  
-  auto& state = it->second;
-  if (!state) {
-    return EngineResult(false, "Channel " + std::to_string(channel_id) + " state is null");
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  if (!state->active) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
   
-  if (!state->preview_producer) {
+  if (!state->preview) {
     return EngineResult(false, "No preview producer loaded for channel " + std::to_string(channel_id));
   }
   
   try {
-    // Stop live producer
-    if (state->live_producer) {
-      state->live_producer->RequestTeardown(std::chrono::milliseconds(500));
-      while (state->live_producer->IsRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      }
-      state->live_producer->Stop();
-    }
+    // Stop live producer (a shared one detaches) and return its threads
+    ReleaseFeed(*state, state->live, /*drain=*/true);
     
     // Swap preview to live
-    state->live_producer = std::move(state->preview_producer);
-    state->preview_producer.reset();
+    state->live = std::move(state->preview);
+    const size_t one_pool = ChannelBufferBytes(*state, state->buffer_depth, 1);
+    buffer_budget_.Resize(state->buffer_reserved_bytes, one_pool);
+    state->buffer_reserved_bytes = one_pool;
+    RecordChannelBuffer(*state);
     
     // For PTS continuity, we'd need to align preview PTS to live's next PTS
     // This is simplified - in production, would check PTS alignment
@@ -332,24 +1174,123 @@ EngineResult PlayoutEngine::SwitchToLive(int32_t channel_id) {
   }
 }
 
+std::vector<EngineResult> PlayoutEngine::StartChannels(
+    const std::vector<ChannelStartRequest>& requests) {
+  return RunBatch(requests.size(), [this, &requests](size_t i) {
+    const ChannelStartRequest& request = requests[i];
+    return StartChannel(request.channel_id, request.plan_handle, request.port, request.uds_path,
+                        request.placement, request.buffer, request.priority,
+                        request.timeline_origin_utc_us);
+  });
+}
+
+std::vector<EngineResult> PlayoutEngine::StopChannels(const std::vector<int32_t>& channel_ids) {
+  return RunBatch(channel_ids.size(),
+                  [this, &channel_ids](size_t i) { return StopChannel(channel_ids[i]); });
+}
+
+std::vector<EngineResult> PlayoutEngine::LoadPreviews(
+    const std::vector<ChannelPreviewRequest>& requests) {
+  // The first entry for each asset leads; its feed is held back until the
+  // others have joined, so every channel airs the asset from its first frame
+  std::unordered_map<std::string, size_t> leaders;
+  std::vector<size_t> firsts;
+  std::vector<size_t> joiners;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (leaders.emplace(requests[i].asset_path, i).second) {
+      firsts.push_back(i);
+    } else {
+      joiners.push_back(i);
+    }
+  }
+  std::vector<std::shared_ptr<Feed>> held(requests.size());
+  std::vector<EngineResult> results(requests.size(), EngineResult(false, "Not run"));
+  const auto load = [this, &requests, &held, &results](const std::vector<size_t>& entries,
+                                                       bool hold) {
+    const std::vector<EngineResult> loaded =
+        RunBatch(entries.size(), [&](size_t i) {
+          const size_t entry = entries[i];
+          return LoadPreviewImpl(requests[entry].channel_id, requests[entry].asset_path,
+                                 hold ? &held[entry] : nullptr);
+        });
+    for (size_t i = 0; i < entries.size(); ++i) {
+      results[entries[i]] = loaded[i];
+    }
+  };
+  load(firsts, !joiners.empty());
+  load(joiners, false);
+
+  for (const size_t entry : firsts) {
+    if (!held[entry]) {
+      continue;
+    }
+    if (held[entry]->producer->Start()) {
+      continue;
+    }
+    // Every channel on the feed loses its preview
+    for (size_t i = 0; i < requests.size(); ++i) {
+      const auto state = FindChannel(requests[i].channel_id);
+      if (!state) {
+        continue;
+      }
+      std::lock_guard<std::mutex> state_lock(state->mutex);
+      if (state->active && state->preview == held[entry]) {
+        ReleaseFeed(*state, state->preview, /*drain=*/false);
+        const size_t one_pool = ChannelBufferBytes(*state, state->buffer_depth, 1);
+        buffer_budget_.Resize(state->buffer_reserved_bytes, one_pool);
+        state->buffer_reserved_bytes = one_pool;
+        RecordChannelBuffer(*state);
+        results[i] = EngineResult(false, "Failed to start preview producer for channel " +
+                                             std::to_string(requests[i].channel_id));
+      }
+    }
+  }
+  return results;
+}
+
+std::vector<EngineResult> PlayoutEngine::RunBatch(
+    size_t count, const std::function<EngineResult(size_t)>& op) {
+  std::vector<EngineResult> results(count, EngineResult(false, "Not run"));
+  // Each thread takes the next entry until none are left
+  std::atomic<size_t> next{0};
+  auto run = [&]() {
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+      results[i] = op(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  const size_t thread_count = std::min(count, kBatchParallelism);
+  for (size_t t = 1; t < thread_count; ++t) {
+    threads.emplace_back(run);
+  }
+  run();  // The calling thread takes entries too
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
 EngineResult PlayoutEngine::UpdatePlan(
     int32_t channel_id,
     const std::string& plan_handle) {
-  std::lock_guard<std::mutex> lock(channels_mutex_);
-  
-  auto it = channels_.find(channel_id);
-  if (it == channels_.end()) {
+  const auto state = FindChannel(channel_id);
+  if (!state) {
     return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
-  
-  auto& state = it->second;
-  if (!state) {
-    return EngineResult(false, "Channel " + std::to_string(channel_id) + " state is null");
+  std::lock_guard<std::mutex> state_lock(state->mutex);
+  if (!state->active) {
+    return EngineResult(false, "Channel " + std::to_string(channel_id) + " not found");
   }
   
   try {
     // Update plan handle
     state->plan_handle = plan_handle;
+    if (manifest_) {
+      manifest_->Update(channel_id, [&plan_handle](ChannelStartRequest& entry) {
+        entry.plan_handle = plan_handle;
+      });
+    }
+    WriteCheckpoint(*state);
     
     // In production, would restart producer with new plan
     // For now, just update the handle
@@ -0,0 +1,304 @@
+// Repository: Retrovue-playout
+// Component: Task Executor
+// Purpose: Shared work-stealing pool that runs channel components as tasks.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/runtime/TaskExecutor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+#include "retrovue/timing/DeadlineScheduler.h"
+
+namespace retrovue::runtime {
+
+namespace {
+
+// Worker of the executor running on this thread, so its own posts stay local
+thread_local const TaskExecutor* tls_executor = nullptr;
+thread_local size_t tls_worker = 0;
+
+int64_t SystemNowUtcUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+TaskExecutor::TaskExecutor(const Config& config,
+                           std::shared_ptr<timing::DeadlineScheduler> scheduler)
+    : config_(config), scheduler_(std::move(scheduler)) {}
+
+TaskExecutor::~TaskExecutor() { Stop(); }
+
+bool TaskExecutor::Start() {
+  if (running()) {
+    return true;
+  }
+  if (!scheduler_) {
+    std::cerr << "[TaskExecutor] A DeadlineScheduler is required" << std::endl;
+    return false;
+  }
+  if (!scheduler_->running()) {
+    if (!scheduler_->Start()) {
+      std::cerr << "[TaskExecutor] Failed to start the DeadlineScheduler" << std::endl;
+      return false;
+    }
+    owns_scheduler_run_ = true;
+  }
+
+  const size_t count =
+      config_.workers > 0 ? config_.workers
+                          : std::max<size_t>(1, std::thread::hardware_concurrency());
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stop_ = false;
+  }
+  workers_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  running_.store(true, std::memory_order_release);
+  for (size_t i = 0; i < count; ++i) {
+    workers_[i]->thread = std::thread([this, i] { WorkerLoop(i); });
+  }
+
+  std::cout << "[TaskExecutor] Started with " << count << " workers" << std::endl;
+  return true;
+}
+
+void TaskExecutor::Stop() {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  // Posts fail from here on; the workers drain what is queued and exit
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stop_ = true;
+  }
+  idle_cv_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  if (owns_scheduler_run_) {
+    scheduler_->Stop();
+    owns_scheduler_run_ = false;
+  }
+  std::cout << "[TaskExecutor] Stopped. Tasks run: "
+            << tasks_run_.load(std::memory_order_relaxed) << std::endl;
+}
+
+bool TaskExecutor::Post(Task task, Lane lane) {
+  if (!running()) {
+    return false;
+  }
+  if (lane == Lane::kPacing) {
+    pacing_tasks_.fetch_add(1, std::memory_order_relaxed);
+    return scheduler_->ScheduleAt(SystemNowUtcUs(), std::move(task)) != 0;
+  }
+
+  const size_t index = tls_executor == this
+                           ? tls_worker
+                           : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->tasks.push_back(std::move(task));
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+  {
+    // Pairs with the predicate check in WorkerLoop, so the wake-up is not lost
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+  }
+  idle_cv_.notify_one();
+  return true;
+}
+
+TaskExecutor::TimerId TaskExecutor::PostAt(int64_t system_utc_us, Task task, Lane lane) {
+  if (!running()) {
+    return 0;
+  }
+  timed_tasks_.fetch_add(1, std::memory_order_relaxed);
+  if (lane == Lane::kPacing) {
+    pacing_tasks_.fetch_add(1, std::memory_order_relaxed);
+    return scheduler_->ScheduleAt(system_utc_us, std::move(task));
+  }
+  return scheduler_->ScheduleAt(system_utc_us, [this, task = std::move(task)]() mutable {
+    if (!Post(task)) {
+      task();  // Stopped meanwhile: run it here so its owner sees the stop
+    }
+  });
+}
+
+bool TaskExecutor::Cancel(TimerId id) { return id != 0 && scheduler_->Cancel(id); }
+
+TaskExecutorStats TaskExecutor::GetStats() const {
+  TaskExecutorStats stats;
+  stats.workers = workers_.size();
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  stats.steals = steals_.load(std::memory_order_relaxed);
+  stats.pacing_tasks = pacing_tasks_.load(std::memory_order_relaxed);
+  stats.timed_tasks = timed_tasks_.load(std::memory_order_relaxed);
+  stats.queued = queued_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TaskExecutor::WorkerLoop(size_t index) {
+  tls_executor = this;
+  tls_worker = index;
+  Task task;
+  while (true) {
+    if (TakeTask(index, task)) {
+      task();
+      task = nullptr;
+      tasks_run_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock, [this] { return stop_ || queued_.load(std::memory_order_acquire) > 0; });
+    if (stop_ && queued_.load(std::memory_order_acquire) == 0) {
+      break;
+    }
+  }
+  tls_executor = nullptr;
+}
+
+bool TaskExecutor::TakeTask(size_t index, Task& task) {
+  {
+    Worker& own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queued_.fetch_sub(1, std::memory_order_acq_rel);
+      return true;
+    }
+  }
+  for (size_t k = 1; k < workers_.size(); ++k) {
+    Worker& victim = *workers_[(index + k) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queued_.fetch_sub(1, std::memory_order_acq_rel);
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+// ============================================================================
+// TaskLoop
+// ============================================================================
+
+TaskLoop::TaskLoop(TaskExecutor& executor, TaskExecutor::Lane lane, Step step,
+                   std::function<void()> on_done)
+    : executor_(executor), lane_(lane), step_(std::move(step)), on_done_(std::move(on_done)) {}
+
+TaskLoop::~TaskLoop() { Stop(); }
+
+bool TaskLoop::Start() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_) {
+      return false;
+    }
+    started_ = true;
+  }
+  if (!executor_.Post([this] { Run(); }, lane_)) {
+    Finish();
+    return false;
+  }
+  return true;
+}
+
+void TaskLoop::Stop() {
+  TaskExecutor::TimerId timer = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+      return;
+    }
+    stopping_ = true;
+    timer = timer_;
+    timer_ = 0;
+  }
+  if (timer != 0 && executor_.Cancel(timer)) {
+    Finish();  // The run will not come
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return done_; });
+}
+
+bool TaskLoop::done() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return done_;
+}
+
+void TaskLoop::Run() {
+  bool stopping = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timer_ = 0;
+    stopping = stopping_;
+  }
+  const int64_t next = stopping ? kDone : step_();
+  if (next == kDone) {
+    Finish();
+    return;
+  }
+  Schedule(next);
+}
+
+void TaskLoop::Schedule(int64_t system_utc_us) {
+  TaskExecutor::TimerId timer = 0;
+  bool queued = false;
+  if (system_utc_us != kNow && system_utc_us > SystemNowUtcUs()) {
+    timer = executor_.PostAt(system_utc_us, [this] { Run(); }, lane_);
+    queued = timer != 0;
+  } else {
+    queued = executor_.Post([this] { Run(); }, lane_);
+  }
+  if (!queued) {
+    Finish();  // Executor stopped
+    return;
+  }
+  if (timer == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stopping_) {
+      timer_ = timer;
+      return;
+    }
+  }
+  // Stop() came while the timer was being set and could not see it
+  if (executor_.Cancel(timer)) {
+    Finish();
+  }
+}
+
+void TaskLoop::Finish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finishing_) {
+      return;
+    }
+    finishing_ = true;
+  }
+  if (on_done_) {
+    on_done_();
+  }
+  // Notified under the lock: Stop() may destroy the loop once it sees done_
+  std::lock_guard<std::mutex> lock(mutex_);
+  done_ = true;
+  done_cv_.notify_all();
+}
+
+}  // namespace retrovue::runtime
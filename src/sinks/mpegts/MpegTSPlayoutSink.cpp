@@ -75,13 +75,59 @@ bool MpegTSPlayoutSink::start() {
   if (is_running_.load()) {
     return false;  // Already running
   }
+  if (!OpenOutput()) {
+    return false;
+  }
+
+  // Start worker thread
+  is_running_ = true;
+  worker_thread_ = std::thread(&MpegTSPlayoutSink::WorkerLoop, this);
+
+  return true;
+}
+
+bool MpegTSPlayoutSink::Open() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+
+  if (is_running_.load()) {
+    return false;  // Already running
+  }
+  if (!OpenOutput()) {
+    return false;
+  }
+  is_running_ = true;
+  return true;
+}
 
+void MpegTSPlayoutSink::WriteFrame(const buffer::Frame& frame, int64_t deadline_utc_us) {
+  if (!client_connected_.load()) {
+    frames_dropped_++;
+    return;
+  }
+  ProcessFrame(frame, deadline_utc_us);
+}
+
+void MpegTSPlayoutSink::Close() { stop(); }
+
+bool MpegTSPlayoutSink::OpenOutput() {
   // Initialize socket
   if (!InitializeSocket()) {
     std::cerr << "[MpegTSPlayoutSink] Failed to initialize socket" << std::endl;
     return false;
   }
 
+  // Unwinds a failed open (stop() would take state_mutex_, which the caller holds)
+  auto abort_open = [this] {
+    stop_requested_ = true;
+    CleanupMuxer();
+    CleanupEncoder();
+    CleanupSocket();
+    if (accept_thread_.joinable()) {
+      accept_thread_.join();
+    }
+    return false;
+  };
+
   // Start accept thread (only if not in stub mode)
   stop_requested_ = false;
   if (!config_.stub_mode) {
@@ -95,8 +141,7 @@ bool MpegTSPlayoutSink::start() {
     }
 
     if (!client_connected_.load()) {
-      stop();
-      return false;
+      return abort_open();
     }
   } else {
     // In stub mode, mark as connected immediately
@@ -106,21 +151,15 @@ bool MpegTSPlayoutSink::start() {
   // Initialize encoder
   if (!InitializeEncoder()) {
     std::cerr << "[MpegTSPlayoutSink] Failed to initialize encoder" << std::endl;
-    stop();
-    return false;
+    return abort_open();
   }
 
   // Initialize muxer
   if (!InitializeMuxer()) {
     std::cerr << "[MpegTSPlayoutSink] Failed to initialize muxer" << std::endl;
-    stop();
-    return false;
+    return abort_open();
   }
 
-  // Start worker thread
-  is_running_ = true;
-  worker_thread_ = std::thread(&MpegTSPlayoutSink::WorkerLoop, this);
-
   return true;
 }
 
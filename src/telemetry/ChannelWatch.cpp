@@ -0,0 +1,168 @@
+// Repository: Retrovue-playout
+// Component: Channel Watch
+// Purpose: Pushes channel status changes to a watcher, coalesced per channel.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/telemetry/ChannelWatch.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace retrovue::telemetry {
+
+namespace {
+
+std::vector<int32_t> Sorted(std::vector<int32_t> ids) {
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
+
+// Counter growth, treating a drop as a restart from zero
+uint64_t Growth(uint64_t before, uint64_t now) { return now >= before ? now - before : now; }
+
+bool SameStatus(const ChannelStatus& a, const ChannelStatus& b) {
+  return a.state == b.state && a.control_state == b.control_state &&
+         a.buffer_depth_frames == b.buffer_depth_frames &&
+         a.underruns_total == b.underruns_total && a.late_frames_total == b.late_frames_total &&
+         a.removed == b.removed;
+}
+
+}  // namespace
+
+ChannelWatch::ChannelWatch(std::vector<int32_t> channel_ids,
+                           std::chrono::milliseconds min_interval)
+    : channel_ids_(Sorted(std::move(channel_ids))),
+      min_interval_(std::max(min_interval, std::chrono::milliseconds(0))) {}
+
+bool ChannelWatch::Watches(int32_t channel_id) const {
+  return channel_ids_.empty() ||
+         std::binary_search(channel_ids_.begin(), channel_ids_.end(), channel_id);
+}
+
+void ChannelWatch::Offer(const ChannelStatus& status) {
+  if (!Watches(status.channel_id)) {
+    return;
+  }
+  std::function<void()> on_ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    auto [it, inserted] = channels_.try_emplace(status.channel_id);
+    Channel& channel = it->second;
+    const ChannelStatus& current = channel.pending || !channel.has_sent ? channel.latest
+                                                                         : channel.sent;
+    if (!inserted && SameStatus(current, status)) {
+      return;
+    }
+    if (channel.pending) {
+      ++channel.coalesced;
+    }
+    channel.latest = status;
+    channel.pending = true;
+    if (!Urgent(channel) && Clock::now() < channel.sent_at + min_interval_) {
+      return;  // Due later; pollers learn when from Poll()
+    }
+    on_ready = on_ready_;
+  }
+  ready_cv_.notify_all();
+  if (on_ready) {
+    on_ready();
+  }
+}
+
+bool ChannelWatch::Poll(ChannelStatusEvent& event, Clock::time_point& next_due) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closed_) {
+    next_due = Clock::time_point::max();
+    return false;
+  }
+  return TakeDueLocked(Clock::now(), event, next_due);
+}
+
+bool ChannelWatch::Next(ChannelStatusEvent& event, std::chrono::milliseconds timeout) {
+  const auto deadline = Clock::now() + timeout;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!closed_) {
+    Clock::time_point next_due;
+    if (TakeDueLocked(Clock::now(), event, next_due)) {
+      return true;
+    }
+    if (Clock::now() >= deadline) {
+      return false;
+    }
+    ready_cv_.wait_until(lock, std::min(deadline, next_due));
+  }
+  return false;
+}
+
+void ChannelWatch::SetReadyCallback(std::function<void()> on_ready) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_ready_ = std::move(on_ready);
+}
+
+void ChannelWatch::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  ready_cv_.notify_all();
+}
+
+bool ChannelWatch::closed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+bool ChannelWatch::Urgent(const Channel& channel) {
+  return !channel.has_sent || channel.latest.state != channel.sent.state ||
+         channel.latest.control_state != channel.sent.control_state ||
+         channel.latest.removed != channel.sent.removed;
+}
+
+bool ChannelWatch::TakeDueLocked(Clock::time_point now, ChannelStatusEvent& event,
+                                 Clock::time_point& next_due) {
+  // Urgent channels first, then the one whose interval ran out earliest
+  Channel* due = nullptr;
+  Clock::time_point due_at = Clock::time_point::max();
+  next_due = Clock::time_point::max();
+  for (auto& [channel_id, channel] : channels_) {
+    if (!channel.pending) {
+      continue;
+    }
+    const Clock::time_point at =
+        Urgent(channel) ? Clock::time_point::min() : channel.sent_at + min_interval_;
+    if (at > now) {
+      next_due = std::min(next_due, at);
+    } else if (!due || at < due_at) {
+      due = &channel;
+      due_at = at;
+    }
+  }
+  if (!due) {
+    return false;
+  }
+
+  event = ChannelStatusEvent();
+  event.status = due->latest;
+  event.state_changed = Urgent(*due);
+  if (due->has_sent) {
+    event.underruns = Growth(due->sent.underruns_total, due->latest.underruns_total);
+    event.late_frames = Growth(due->sent.late_frames_total, due->latest.late_frames_total);
+  }
+  event.coalesced = due->coalesced;
+
+  due->sent = due->latest;
+  due->has_sent = true;
+  due->pending = false;
+  due->coalesced = 0;
+  due->sent_at = now;
+  if (due->latest.removed) {
+    channels_.erase(due->latest.channel_id);
+  }
+  return true;
+}
+
+}  // namespace retrovue::telemetry
@@ -0,0 +1,199 @@
+// Repository: Retrovue-playout
+// Component: HDR Histogram
+// Purpose: Fixed-memory, lock-free latency histogram with percentile queries.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/telemetry/HdrHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace retrovue::telemetry {
+
+namespace {
+
+int BitLength(uint64_t value) { return value == 0 ? 0 : 64 - __builtin_clzll(value); }
+
+}  // namespace
+
+HdrHistogram::HdrHistogram(int64_t highest_value, int significant_digits)
+    : highest_value_(std::max<int64_t>(highest_value, 2)),
+      significant_digits_(std::clamp(significant_digits, 1, 5)) {
+  // Sub-buckets per power of two: enough to resolve 1 in 10^digits
+  const int64_t resolution = 2 * static_cast<int64_t>(std::pow(10, significant_digits_));
+  const int sub_bucket_magnitude = BitLength(static_cast<uint64_t>(resolution - 1));
+  sub_bucket_half_magnitude_ = sub_bucket_magnitude - 1;
+  const int64_t sub_bucket_count = int64_t{1} << sub_bucket_magnitude;
+  sub_bucket_half_count_ = sub_bucket_count / 2;
+  sub_bucket_mask_ = sub_bucket_count - 1;
+
+  // Buckets (powers of two) needed to reach highest_value
+  int buckets = 1;
+  int64_t reach = sub_bucket_count;
+  while (reach <= highest_value_) {
+    reach <<= 1;
+    ++buckets;
+  }
+  counts_length_ = static_cast<size_t>(buckets + 1) * static_cast<size_t>(sub_bucket_half_count_);
+  counts_ = std::make_unique<std::atomic<uint64_t>[]>(counts_length_);
+  Reset();
+}
+
+HdrHistogram::HdrHistogram(const HdrHistogram& other)
+    : highest_value_(other.highest_value_),
+      significant_digits_(other.significant_digits_),
+      sub_bucket_half_magnitude_(other.sub_bucket_half_magnitude_),
+      sub_bucket_half_count_(other.sub_bucket_half_count_),
+      sub_bucket_mask_(other.sub_bucket_mask_),
+      counts_length_(other.counts_length_),
+      counts_(std::make_unique<std::atomic<uint64_t>[]>(other.counts_length_)) {
+  Reset();
+  Add(other);
+}
+
+HdrHistogram& HdrHistogram::operator=(const HdrHistogram& other) {
+  if (this == &other) {
+    return *this;
+  }
+  if (!SameLayout(other)) {
+    highest_value_ = other.highest_value_;
+    significant_digits_ = other.significant_digits_;
+    sub_bucket_half_magnitude_ = other.sub_bucket_half_magnitude_;
+    sub_bucket_half_count_ = other.sub_bucket_half_count_;
+    sub_bucket_mask_ = other.sub_bucket_mask_;
+    counts_length_ = other.counts_length_;
+    counts_ = std::make_unique<std::atomic<uint64_t>[]>(counts_length_);
+  }
+  Reset();
+  Add(other);
+  return *this;
+}
+
+void HdrHistogram::RecordCount(int64_t value, uint64_t count) {
+  value = std::clamp<int64_t>(value, 0, highest_value_);
+  counts_[IndexOf(value)].fetch_add(count, std::memory_order_relaxed);
+  total_.fetch_add(count, std::memory_order_relaxed);
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+bool HdrHistogram::Add(const HdrHistogram& other) {
+  if (!SameLayout(other)) {
+    return false;
+  }
+  for (size_t i = 0; i < counts_length_; ++i) {
+    const uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+    if (count != 0) {
+      counts_[i].fetch_add(count, std::memory_order_relaxed);
+    }
+  }
+  total_.fetch_add(other.total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  const int64_t other_max = other.max_.load(std::memory_order_relaxed);
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (other_max > max &&
+         !max_.compare_exchange_weak(max, other_max, std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+bool HdrHistogram::Subtract(const HdrHistogram& other) {
+  if (!SameLayout(other)) {
+    return false;
+  }
+  uint64_t total = 0;
+  int64_t max = 0;
+  for (size_t i = 0; i < counts_length_; ++i) {
+    const uint64_t have = counts_[i].load(std::memory_order_relaxed);
+    const uint64_t take = std::min(have, other.counts_[i].load(std::memory_order_relaxed));
+    counts_[i].store(have - take, std::memory_order_relaxed);
+    total += have - take;
+    if (have > take) {
+      max = HighestAt(i);
+    }
+  }
+  // The exact maximum is lost; the remaining top bucket bounds it
+  total_.store(total, std::memory_order_relaxed);
+  max_.store(std::min(max, max_.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+  return true;
+}
+
+void HdrHistogram::Reset() {
+  for (size_t i = 0; i < counts_length_; ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+  total_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::Count() const { return total_.load(std::memory_order_relaxed); }
+
+int64_t HdrHistogram::Max() const { return max_.load(std::memory_order_relaxed); }
+
+double HdrHistogram::Mean() const {
+  uint64_t total = 0;
+  double sum = 0.0;
+  for (size_t i = 0; i < counts_length_; ++i) {
+    const uint64_t count = counts_[i].load(std::memory_order_relaxed);
+    if (count != 0) {
+      const double mid = (static_cast<double>(LowestAt(i)) + static_cast<double>(HighestAt(i))) / 2.0;
+      sum += mid * static_cast<double>(count);
+      total += count;
+    }
+  }
+  return total ? sum / static_cast<double>(total) : 0.0;
+}
+
+int64_t HdrHistogram::ValueAtPercentile(double percentile) const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < counts_length_; ++i) {
+    total += counts_[i].load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+  const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+  const uint64_t rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_length_; ++i) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(HighestAt(i), std::max<int64_t>(Max(), LowestAt(i)));
+    }
+  }
+  return Max();
+}
+
+size_t HdrHistogram::IndexOf(int64_t value) const {
+  const auto v = static_cast<uint64_t>(value);
+  const int bucket =
+      BitLength(v | static_cast<uint64_t>(sub_bucket_mask_)) - (sub_bucket_half_magnitude_ + 1);
+  const int64_t sub_bucket = static_cast<int64_t>(v >> bucket);
+  return (static_cast<size_t>(bucket + 1) << sub_bucket_half_magnitude_) +
+         static_cast<size_t>(sub_bucket - sub_bucket_half_count_);
+}
+
+int64_t HdrHistogram::LowestAt(size_t index) const {
+  int bucket = static_cast<int>(index >> sub_bucket_half_magnitude_) - 1;
+  int64_t sub_bucket =
+      static_cast<int64_t>(index & static_cast<size_t>(sub_bucket_half_count_ - 1)) +
+      sub_bucket_half_count_;
+  if (bucket < 0) {
+    sub_bucket -= sub_bucket_half_count_;
+    bucket = 0;
+  }
+  return sub_bucket << bucket;
+}
+
+int64_t HdrHistogram::HighestAt(size_t index) const {
+  const int bucket = std::max(0, static_cast<int>(index >> sub_bucket_half_magnitude_) - 1);
+  return LowestAt(index) + (int64_t{1} << bucket) - 1;
+}
+
+bool HdrHistogram::SameLayout(const HdrHistogram& other) const {
+  return counts_length_ == other.counts_length_ &&
+         sub_bucket_half_magnitude_ == other.sub_bucket_half_magnitude_;
+}
+
+}  // namespace retrovue::telemetry
@@ -4,15 +4,50 @@
 // Copyright (c) 2025 RetroVue
 
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/telemetry/ChannelWatch.h"
 #include "retrovue/telemetry/MetricsHTTPServer.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <sstream>
+#include <utility>
 
 namespace retrovue::telemetry {
 
+namespace {
+
+int64_t LatencyToMicros(double latency_ms) {
+  return std::llround(std::max(latency_ms, 0.0) * 1'000.0);
+}
+
+double P95Ms(const HdrHistogram& latency_us) {
+  return static_cast<double>(latency_us.ValueAtPercentile(95.0)) / 1'000.0;
+}
+
+const char* TransportName(MetricsExporter::Transport transport) {
+  switch (transport) {
+    case MetricsExporter::Transport::kGrpcStream:
+      return "grpc_stream";
+    case MetricsExporter::Transport::kScrape:
+      return "scrape";
+    case MetricsExporter::Transport::kFile:
+      return "file";
+  }
+  return "";
+}
+
+constexpr auto kSlotPublishInterval = std::chrono::milliseconds(50);
+
+int64_t SystemNowUtcUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
 const char* ChannelStateToString(ChannelState state) {
   switch (state) {
     case ChannelState::STOPPED:
@@ -32,6 +67,49 @@ int ChannelStateToValue(ChannelState state) {
   return static_cast<int>(state);
 }
 
+void ChannelSlot::Record(const ChannelMetrics& metrics) {
+  constexpr auto kRelaxed = std::memory_order_relaxed;
+  buffer_depth_frames_.store(metrics.buffer_depth_frames, kRelaxed);
+  frame_gap_seconds_.store(metrics.frame_gap_seconds, kRelaxed);
+  corrections_total_.store(metrics.corrections_total, kRelaxed);
+  underruns_total_.store(metrics.underruns_total, kRelaxed);
+  late_frames_total_.store(metrics.late_frames_total, kRelaxed);
+  buffer_high_water_frames_.store(metrics.buffer_high_water_frames, kRelaxed);
+  buffer_low_water_frames_.store(metrics.buffer_low_water_frames, kRelaxed);
+  buffer_push_failures_total_.store(metrics.buffer_push_failures_total, kRelaxed);
+  buffer_residency_seconds_sum_.store(metrics.buffer_residency_seconds_sum, kRelaxed);
+  buffer_residency_count_.store(metrics.buffer_residency_count, kRelaxed);
+  buffer_residency_seconds_max_.store(metrics.buffer_residency_seconds_max, kRelaxed);
+  for (size_t i = 0; i < kBufferOccupancyBuckets; ++i) {
+    buffer_occupancy_buckets_[i].store(metrics.buffer_occupancy_buckets[i], kRelaxed);
+  }
+  buffer_occupancy_ratio_sum_.store(metrics.buffer_occupancy_ratio_sum, kRelaxed);
+  records_.fetch_add(1, kRelaxed);
+}
+
+bool ChannelSlot::Load(ChannelMetrics& metrics) const {
+  constexpr auto kRelaxed = std::memory_order_relaxed;
+  if (records_.load(kRelaxed) == 0) {
+    return false;
+  }
+  metrics.buffer_depth_frames = buffer_depth_frames_.load(kRelaxed);
+  metrics.frame_gap_seconds = frame_gap_seconds_.load(kRelaxed);
+  metrics.corrections_total = corrections_total_.load(kRelaxed);
+  metrics.underruns_total = underruns_total_.load(kRelaxed);
+  metrics.late_frames_total = late_frames_total_.load(kRelaxed);
+  metrics.buffer_high_water_frames = buffer_high_water_frames_.load(kRelaxed);
+  metrics.buffer_low_water_frames = buffer_low_water_frames_.load(kRelaxed);
+  metrics.buffer_push_failures_total = buffer_push_failures_total_.load(kRelaxed);
+  metrics.buffer_residency_seconds_sum = buffer_residency_seconds_sum_.load(kRelaxed);
+  metrics.buffer_residency_count = buffer_residency_count_.load(kRelaxed);
+  metrics.buffer_residency_seconds_max = buffer_residency_seconds_max_.load(kRelaxed);
+  for (size_t i = 0; i < kBufferOccupancyBuckets; ++i) {
+    metrics.buffer_occupancy_buckets[i] = buffer_occupancy_buckets_[i].load(kRelaxed);
+  }
+  metrics.buffer_occupancy_ratio_sum = buffer_occupancy_ratio_sum_.load(kRelaxed);
+  return true;
+}
+
 MetricsExporter::EventQueue::EventQueue(size_t capacity)
     : capacity_(capacity),
       buffer_(capacity),
@@ -78,6 +156,7 @@ MetricsExporter::MetricsExporter(int port, bool enable_http)
       processed_events_(0) {
   if (http_server_) {
     http_server_->SetMetricsCallback([this]() { return this->GenerateMetricsText(); });
+    http_server_->SetMetricsVersionCallback([this]() { return this->MetricsVersion(); });
   }
 }
 
@@ -85,6 +164,12 @@ MetricsExporter::~MetricsExporter() {
   Stop();
 }
 
+void MetricsExporter::AddHttpHandler(const std::string& prefix, HttpHandler handler) {
+  if (http_server_) {
+    http_server_->AddHandler(prefix, std::move(handler));
+  }
+}
+
 bool MetricsExporter::Start(bool start_http_server) {
   bool expected = false;
   if (!running_.compare_exchange_strong(expected, true)) {
@@ -130,7 +215,8 @@ bool MetricsExporter::SubmitChannelMetrics(int32_t channel_id,
                                            const ChannelMetrics& metrics) {
   if (!running_.load(std::memory_order_acquire)) {
     std::lock_guard<std::mutex> lock(metrics_mutex_);
-    channel_metrics_[channel_id] = metrics;
+    StoreChannelMetricsLocked(channel_id, metrics);
+    PublishStatusLocked(channel_id);
     std::cout << "[MetricsExporter] (sync) snapshot written for channel "
               << channel_id << std::endl;
     return true;
@@ -155,10 +241,73 @@ bool MetricsExporter::SubmitChannelMetrics(int32_t channel_id,
   return true;
 }
 
+std::shared_ptr<ChannelSlot> MetricsExporter::AcquireChannelSlot(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  SlotEntry& entry = channel_slots_[channel_id];
+  if (!entry.slot) {
+    entry.slot = std::make_shared<ChannelSlot>();
+  }
+  return entry.slot;
+}
+
+std::shared_ptr<ChannelCpuAccount> MetricsExporter::AcquireChannelCpu(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  std::shared_ptr<ChannelCpuAccount>& account = channel_cpu_[channel_id];
+  if (!account) {
+    account = std::make_shared<ChannelCpuAccount>();
+  }
+  return account;
+}
+
+bool MetricsExporter::GetChannelCpu(int32_t channel_id,
+                                    std::array<uint64_t, kCpuStageCount>& cpu_ns) const {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  const auto it = channel_cpu_.find(channel_id);
+  if (it == channel_cpu_.end()) {
+    return false;
+  }
+  for (size_t stage = 0; stage < kCpuStageCount; ++stage) {
+    cpu_ns[stage] = it->second->Get(static_cast<CpuStage>(stage));
+  }
+  return true;
+}
+
+void MetricsExporter::SetChannelArena(int32_t channel_id,
+                                      std::shared_ptr<const buffer::ChannelArena> arena) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  channel_arenas_[channel_id] = std::move(arena);
+}
+
+std::shared_ptr<EncoderTelemetry> MetricsExporter::AcquireEncoderTelemetry(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  std::shared_ptr<EncoderTelemetry>& telemetry = encoder_telemetry_[channel_id];
+  if (!telemetry) {
+    telemetry = std::make_shared<EncoderTelemetry>();
+  }
+  return telemetry;
+}
+
+bool MetricsExporter::GetEncoderTelemetry(int32_t channel_id,
+                                          EncoderTelemetrySnapshot& snapshot) const {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  const auto it = encoder_telemetry_.find(channel_id);
+  if (it == encoder_telemetry_.end()) {
+    return false;
+  }
+  snapshot = it->second->Snapshot();
+  return true;
+}
+
 void MetricsExporter::SubmitChannelRemoval(int32_t channel_id) {
   if (!running_.load(std::memory_order_acquire)) {
     std::lock_guard<std::mutex> lock(metrics_mutex_);
     channel_metrics_.erase(channel_id);
+    channel_slots_.erase(channel_id);
+    channel_cpu_.erase(channel_id);
+    channel_arenas_.erase(channel_id);
+    encoder_telemetry_.erase(channel_id);
+    frame_latency_.erase(channel_id);
+    PublishRemovalLocked(channel_id);
     std::cout << "[MetricsExporter] (sync) channel " << channel_id
               << " removed from metrics" << std::endl;
     return;
@@ -234,31 +383,34 @@ void MetricsExporter::DeprecateMetricDescriptor(const std::string& name) {
 void MetricsExporter::RecordDeliveryStatus(Transport transport,
                                            bool success,
                                            double latency_ms) {
+  const auto index = static_cast<size_t>(transport);
+  if (index >= kTransports) {
+    return;
+  }
+  TransportData& data = transport_data_[index];
+  data.latency_us.Record(LatencyToMicros(latency_ms));
+  (success ? data.deliveries : data.failures).fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsExporter::RecordReadStalls(int32_t channel_id,
+                                       uint64_t stalls,
+                                       double stall_seconds) {
   if (!running_.load(std::memory_order_acquire)) {
     std::lock_guard<std::mutex> lock(metrics_mutex_);
-    auto& data = transport_data_[transport];
-    data.latencies_ms.push_back(latency_ms);
-    if (success) {
-      data.deliveries++;
-    } else {
-      data.failures++;
-    }
-    std::cout << "[MetricsExporter] (sync) recorded transport delivery (transport="
-              << static_cast<int>(transport) << ", success=" << std::boolalpha << success
-              << ", latency_ms=" << latency_ms << ")" << std::endl;
+    AddReadStallsLocked(channel_id, stalls, stall_seconds);
     return;
   }
 
   Event event{};
-  event.type = Event::Type::kRecordTransport;
-  event.transport = transport;
-  event.transport_success = success;
-  event.transport_latency_ms = latency_ms;
+  event.type = Event::Type::kRecordReadStalls;
+  event.channel_id = channel_id;
+  event.read_stalls = stalls;
+  event.read_stall_seconds = stall_seconds;
 
   if (!event_queue_.Push(event)) {
     queue_overflow_total_.fetch_add(1, std::memory_order_acq_rel);
-    std::cerr << "[MetricsExporter] Queue overflow while recording delivery status for transport "
-              << static_cast<int>(transport) << std::endl;
+    std::cerr << "[MetricsExporter] Queue overflow while recording read stalls for channel "
+              << channel_id << std::endl;
     return;
   }
 
@@ -266,31 +418,152 @@ void MetricsExporter::RecordDeliveryStatus(Transport transport,
   queue_cv_.notify_one();
 }
 
+void MetricsExporter::RecordSrtLinkStats(int32_t channel_id, const SrtLinkMetrics& link) {
+  if (!running_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    channel_metrics_[channel_id].srt_link = link;
+    return;
+  }
+
+  Event event{};
+  event.type = Event::Type::kRecordSrtLink;
+  event.channel_id = channel_id;
+  event.srt_link = link;
+
+  if (!event_queue_.Push(event)) {
+    queue_overflow_total_.fetch_add(1, std::memory_order_acq_rel);
+    std::cerr << "[MetricsExporter] Queue overflow while recording SRT link stats for channel "
+              << channel_id << std::endl;
+    return;
+  }
+
+  submitted_events_.fetch_add(1, std::memory_order_acq_rel);
+  queue_cv_.notify_one();
+}
+
+void MetricsExporter::RecordBufferMemory(int32_t channel_id, const BufferMemoryMetrics& memory) {
+  if (!running_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    channel_metrics_[channel_id].buffer_memory = memory;
+    return;
+  }
+
+  Event event{};
+  event.type = Event::Type::kRecordBufferMemory;
+  event.channel_id = channel_id;
+  event.buffer_memory = memory;
+
+  if (!event_queue_.Push(event)) {
+    queue_overflow_total_.fetch_add(1, std::memory_order_acq_rel);
+    std::cerr << "[MetricsExporter] Queue overflow while recording buffer memory for channel "
+              << channel_id << std::endl;
+    return;
+  }
+
+  submitted_events_.fetch_add(1, std::memory_order_acq_rel);
+  queue_cv_.notify_one();
+}
+
+void MetricsExporter::RecordFrameTrace(int32_t channel_id, const buffer::FrameTrace& trace) {
+  if (!trace.sampled()) {
+    return;
+  }
+  if (!running_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    AddFrameTraceLocked(channel_id, trace);
+    return;
+  }
+
+  Event event{};
+  event.type = Event::Type::kRecordFrameTrace;
+  event.channel_id = channel_id;
+  event.frame_trace = trace;
+
+  if (!event_queue_.Push(event)) {
+    queue_overflow_total_.fetch_add(1, std::memory_order_acq_rel);
+    return;  // Sampled: losing one trace is harmless, and not worth a log line
+  }
+
+  submitted_events_.fetch_add(1, std::memory_order_acq_rel);
+  queue_cv_.notify_one();
+}
+
+bool MetricsExporter::GetFrameStageLatency(int32_t channel_id,
+                                           FrameStageLatency& latency) const {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  const auto it = frame_latency_.find(channel_id);
+  if (it == frame_latency_.end()) {
+    return false;
+  }
+  latency = it->second;
+  return true;
+}
+
+void MetricsExporter::RecordControlState(int32_t channel_id, const std::string& control_state) {
+  if (!running_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    channel_metrics_[channel_id].control_state = control_state;
+    PublishStatusLocked(channel_id);
+    return;
+  }
+
+  Event event{};
+  event.type = Event::Type::kRecordControlState;
+  event.channel_id = channel_id;
+  event.control_state = control_state;
+
+  if (!event_queue_.Push(event)) {
+    queue_overflow_total_.fetch_add(1, std::memory_order_acq_rel);
+    std::cerr << "[MetricsExporter] Queue overflow while recording control state for channel "
+              << channel_id << std::endl;
+    return;
+  }
+
+  submitted_events_.fetch_add(1, std::memory_order_acq_rel);
+  queue_cv_.notify_one();
+}
+
+std::shared_ptr<ChannelWatch> MetricsExporter::WatchChannels(
+    const std::vector<int32_t>& channel_ids, std::chrono::milliseconds min_interval) {
+  auto watch = std::make_shared<ChannelWatch>(channel_ids, min_interval);
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  watches_.push_back(watch);
+  // Registered and seeded under one lock, so no update falls in between
+  for (const auto& [channel_id, metrics] : LoadChannelsLocked()) {
+    if (watch->Watches(channel_id)) {
+      PublishStatusLocked(channel_id);
+    }
+  }
+  return watch;
+}
+
 bool MetricsExporter::GetChannelMetrics(int32_t channel_id,
                                         ChannelMetrics& metrics) const {
   std::cout << "[MetricsExporter] GetChannelMetrics requested for channel "
             << channel_id << std::endl;
   std::lock_guard<std::mutex> lock(metrics_mutex_);
-  auto it = channel_metrics_.find(channel_id);
-  if (it == channel_metrics_.end()) {
-    return false;
-  }
-  metrics = it->second;
-  return true;
+  return LoadChannelLocked(channel_id, metrics);
 }
 
 MetricsExporter::Snapshot MetricsExporter::SnapshotForTest() const {
   std::lock_guard<std::mutex> lock(metrics_mutex_);
   Snapshot snapshot;
-  snapshot.channel_metrics = channel_metrics_;
+  snapshot.channel_metrics = LoadChannelsLocked();
   snapshot.descriptor_versions = descriptor_versions_;
   snapshot.descriptor_deprecated = descriptor_deprecated_;
-  for (const auto& [transport, data] : transport_data_) {
+  for (size_t i = 0; i < kTransports; ++i) {
+    const TransportData& data = transport_data_[i];
     TransportSnapshot ts;
-    ts.deliveries = data.deliveries;
-    ts.failures = data.failures;
-    ts.latency_p95_ms = ComputePercentile(data.latencies_ms, 0.95);
-    snapshot.transport_stats.emplace(transport, ts);
+    ts.deliveries = data.deliveries.load(std::memory_order_relaxed);
+    ts.failures = data.failures.load(std::memory_order_relaxed);
+    if (ts.deliveries + ts.failures == 0) {
+      continue;
+    }
+    const HistogramViews latency = data.latency_us.Views();
+    ts.latency_p95_ms = P95Ms(latency.total);
+    ts.latency_p95_1m_ms = P95Ms(latency.last_1m);
+    ts.latency_p95_5m_ms = P95Ms(latency.last_5m);
+    snapshot.transport_stats.emplace(static_cast<Transport>(i), ts);
   }
   snapshot.queue_overflow_total = queue_overflow_total_.load(std::memory_order_acquire);
   return snapshot;
@@ -313,9 +586,46 @@ bool MetricsExporter::WaitUntilDrainedForTest(std::chrono::milliseconds timeout)
   return false;
 }
 
+uint64_t MetricsExporter::MetricsVersion() const {
+  // A sum of counters that only grow (and the slot clock) changes with any
+  // of them
+  uint64_t version = processed_events_.load(std::memory_order_acquire) +
+                     queue_overflow_total_.load(std::memory_order_relaxed) +
+                     buffer_memory_budget_bytes_.load(std::memory_order_relaxed);
+  for (const TransportData& data : transport_data_) {
+    version += data.deliveries.load(std::memory_order_relaxed) +
+               data.failures.load(std::memory_order_relaxed);
+  }
+  version += static_cast<uint64_t>(
+      WindowedHistogram::Clock::now().time_since_epoch() / WindowedHistogram::kSlotWidth);
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  for (const auto& [channel_id, entry] : channel_slots_) {
+    version += entry.slot->records();
+  }
+  for (const auto& [channel_id, account] : channel_cpu_) {
+    version += account->Total() >> 20;  // About a millisecond
+  }
+  for (const auto& [channel_id, arena] : channel_arenas_) {
+    const buffer::ChannelArenaStats stats = arena->GetStats();
+    version += stats.allocations + stats.reuses;
+  }
+  for (const auto& [channel_id, telemetry] : encoder_telemetry_) {
+    version += telemetry->encoded_frames() + (telemetry->output_bytes() >> 16);
+  }
+  return version;
+}
+
 void MetricsExporter::WorkerLoop() {
+  auto next_slot_publish = std::chrono::steady_clock::now();
   while (!stop_requested_.load(std::memory_order_acquire) ||
          !event_queue_.Empty()) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= next_slot_publish) {
+      next_slot_publish = now + kSlotPublishInterval;
+      std::lock_guard<std::mutex> lock(metrics_mutex_);
+      PublishSlotChangesLocked();
+    }
+
     Event event;
     if (event_queue_.Pop(event)) {
       ProcessEvent(event);
@@ -324,7 +634,7 @@ void MetricsExporter::WorkerLoop() {
     }
 
     std::unique_lock<std::mutex> lock(queue_mutex_);
-    queue_cv_.wait_for(lock, std::chrono::milliseconds(50));
+    queue_cv_.wait_until(lock, next_slot_publish);
   }
 }
 
@@ -332,12 +642,19 @@ void MetricsExporter::ProcessEvent(const Event& event) {
   std::lock_guard<std::mutex> lock(metrics_mutex_);
   switch (event.type) {
     case Event::Type::kUpdateChannel:
-      channel_metrics_[event.channel_id] = event.channel_metrics;
+      StoreChannelMetricsLocked(event.channel_id, event.channel_metrics);
+      PublishStatusLocked(event.channel_id);
       std::cout << "[MetricsExporter] Snapshot written for channel "
                 << event.channel_id << std::endl;
       break;
     case Event::Type::kRemoveChannel:
       channel_metrics_.erase(event.channel_id);
+      channel_slots_.erase(event.channel_id);
+      channel_cpu_.erase(event.channel_id);
+      channel_arenas_.erase(event.channel_id);
+      encoder_telemetry_.erase(event.channel_id);
+      frame_latency_.erase(event.channel_id);
+      PublishRemovalLocked(event.channel_id);
       std::cout << "[MetricsExporter] Channel " << event.channel_id
                 << " removed from metrics" << std::endl;
       break;
@@ -353,54 +670,177 @@ void MetricsExporter::ProcessEvent(const Event& event) {
       std::cout << "[MetricsExporter] Deprecated descriptor "
                 << event.descriptor_name << std::endl;
       break;
-    case Event::Type::kRecordTransport: {
-      auto& data = transport_data_[event.transport];
-      data.latencies_ms.push_back(event.transport_latency_ms);
-      if (event.transport_success) {
-        data.deliveries++;
-      } else {
-        data.failures++;
-      }
-      std::cout << "[MetricsExporter] Recorded transport delivery (transport="
-                << static_cast<int>(event.transport)
-                << ", success=" << std::boolalpha << event.transport_success
-                << ", latency_ms=" << event.transport_latency_ms << ")" << std::endl;
+    case Event::Type::kRecordReadStalls:
+      AddReadStallsLocked(event.channel_id, event.read_stalls, event.read_stall_seconds);
+      break;
+    case Event::Type::kRecordSrtLink:
+      channel_metrics_[event.channel_id].srt_link = event.srt_link;
+      break;
+    case Event::Type::kRecordBufferMemory:
+      channel_metrics_[event.channel_id].buffer_memory = event.buffer_memory;
       break;
+    case Event::Type::kRecordControlState:
+      channel_metrics_[event.channel_id].control_state = event.control_state;
+      PublishStatusLocked(event.channel_id);
+      break;
+    case Event::Type::kRecordFrameTrace:
+      AddFrameTraceLocked(event.channel_id, event.frame_trace);
+      break;
+  }
+}
+
+void MetricsExporter::StoreChannelMetricsLocked(int32_t channel_id,
+                                                const ChannelMetrics& metrics) {
+  // The latest writer wins, whether it submits or records
+  if (const auto slot = channel_slots_.find(channel_id); slot != channel_slots_.end()) {
+    slot->second.slot->Record(metrics);
+  }
+  auto it = channel_metrics_.find(channel_id);
+  if (it == channel_metrics_.end()) {
+    channel_metrics_.emplace(channel_id, metrics);
+    return;
+  }
+  const uint64_t read_stalls = it->second.read_stalls_total;
+  const double read_stall_seconds = it->second.read_stall_seconds_total;
+  std::optional<SrtLinkMetrics> srt_link = std::move(it->second.srt_link);
+  const BufferMemoryMetrics buffer_memory = it->second.buffer_memory;
+  std::string control_state = std::move(it->second.control_state);
+  it->second = metrics;
+  it->second.read_stalls_total = read_stalls;
+  it->second.read_stall_seconds_total = read_stall_seconds;
+  it->second.srt_link = std::move(srt_link);
+  it->second.buffer_memory = buffer_memory;
+  it->second.control_state = std::move(control_state);
+}
+
+bool MetricsExporter::LoadChannelLocked(int32_t channel_id, ChannelMetrics& metrics) const {
+  const auto it = channel_metrics_.find(channel_id);
+  const auto slot = channel_slots_.find(channel_id);
+  const bool recorded = slot != channel_slots_.end() && slot->second.slot->records() > 0;
+  if (it == channel_metrics_.end() && !recorded) {
+    return false;
+  }
+  metrics = it != channel_metrics_.end() ? it->second : ChannelMetrics{};
+  if (recorded) {
+    slot->second.slot->Load(metrics);
+  }
+  return true;
+}
+
+std::map<int32_t, ChannelMetrics> MetricsExporter::LoadChannelsLocked() const {
+  std::map<int32_t, ChannelMetrics> channels = channel_metrics_;
+  for (const auto& [channel_id, entry] : channel_slots_) {
+    if (entry.slot->records() > 0) {
+      entry.slot->Load(channels[channel_id]);
     }
   }
+  return channels;
 }
 
-double MetricsExporter::ComputePercentile(const std::vector<double>& values,
-                                          double percentile) {
-  if (values.empty()) {
-    return 0.0;
+void MetricsExporter::PublishSlotChangesLocked() {
+  for (auto& [channel_id, entry] : channel_slots_) {
+    const uint64_t records = entry.slot->records();
+    if (records != entry.published_records) {
+      entry.published_records = records;
+      PublishStatusLocked(channel_id);
+    }
   }
+}
 
-  std::vector<double> sorted = values;
-  std::sort(sorted.begin(), sorted.end());
-  const double rank = percentile * static_cast<double>(sorted.size() - 1);
-  const auto lower_index = static_cast<std::size_t>(std::floor(rank));
-  const auto upper_index = static_cast<std::size_t>(std::ceil(rank));
-  const double lower = sorted[lower_index];
-  if (upper_index == lower_index) {
-    return lower;
+void MetricsExporter::AddFrameTraceLocked(int32_t channel_id,
+                                          const buffer::FrameTrace& trace) {
+  FrameStageLatency& latency = frame_latency_[channel_id];
+  uint32_t first_us = 0;
+  uint32_t previous_us = 0;
+  for (size_t stage = 0; stage < buffer::kFrameStageCount; ++stage) {
+    const uint32_t at_us = trace.stage_us[stage];
+    if (at_us == 0) {
+      continue;  // Not reached (or not on this path)
+    }
+    if (previous_us != 0) {
+      latency.stage_us[stage].Record(
+          std::max<int64_t>(buffer::FrameTrace::StageDeltaUs(previous_us, at_us), 0));
+    } else {
+      first_us = at_us;
+    }
+    previous_us = at_us;
+  }
+  if (first_us == 0) {
+    return;
+  }
+  latency.total_us.Record(
+      std::max<int64_t>(buffer::FrameTrace::StageDeltaUs(first_us, previous_us), 0));
+  ++latency.frames;
+}
+
+void MetricsExporter::AddReadStallsLocked(int32_t channel_id, uint64_t stalls,
+                                          double stall_seconds) {
+  ChannelMetrics& metrics = channel_metrics_[channel_id];
+  metrics.read_stalls_total += stalls;
+  metrics.read_stall_seconds_total += stall_seconds;
+}
+
+void MetricsExporter::PublishStatusLocked(int32_t channel_id) {
+  if (watches_.empty()) {
+    return;
+  }
+  ChannelMetrics metrics;
+  if (!LoadChannelLocked(channel_id, metrics)) {
+    return;
+  }
+  ChannelStatus status;
+  status.channel_id = channel_id;
+  status.timestamp_us = SystemNowUtcUs();
+  status.state = metrics.state;
+  status.control_state = metrics.control_state;
+  status.buffer_depth_frames = metrics.buffer_depth_frames;
+  status.underruns_total = metrics.underruns_total;
+  status.late_frames_total = metrics.late_frames_total;
+
+  watches_.erase(std::remove_if(watches_.begin(), watches_.end(),
+                                [&status](const std::weak_ptr<ChannelWatch>& weak) {
+                                  const auto watch = weak.lock();
+                                  if (!watch || watch->closed()) {
+                                    return true;
+                                  }
+                                  watch->Offer(status);
+                                  return false;
+                                }),
+                 watches_.end());
+}
+
+void MetricsExporter::PublishRemovalLocked(int32_t channel_id) {
+  ChannelStatus status;
+  status.channel_id = channel_id;
+  status.timestamp_us = SystemNowUtcUs();
+  status.removed = true;
+  for (const auto& weak : watches_) {
+    if (const auto watch = weak.lock()) {
+      watch->Offer(status);
+    }
   }
-  const double upper = sorted[upper_index];
-  const double fraction = rank - static_cast<double>(lower_index);
-  return lower + (upper - lower) * fraction;
 }
 
 std::string MetricsExporter::GenerateMetricsText() const {
   std::lock_guard<std::mutex> lock(metrics_mutex_);
+  const std::map<int32_t, ChannelMetrics> channels = LoadChannelsLocked();
   std::ostringstream oss;
 
   oss << "# HELP retrovue_metrics_overflow_total Number of dropped metric events due to queue overflow\n";
   oss << "# TYPE retrovue_metrics_overflow_total counter\n";
   oss << "retrovue_metrics_overflow_total " << queue_overflow_total_.load(std::memory_order_acquire) << "\n\n";
 
+  uint64_t slot_records = 0;
+  for (const auto& [channel_id, entry] : channel_slots_) {
+    slot_records += entry.slot->records();
+  }
+  oss << "# HELP retrovue_metrics_slot_records_total Hot-path metric records into channel slots\n";
+  oss << "# TYPE retrovue_metrics_slot_records_total counter\n";
+  oss << "retrovue_metrics_slot_records_total " << slot_records << "\n\n";
+
   oss << "# HELP retrovue_playout_channel_state Current state of playout channel\n";
   oss << "# TYPE retrovue_playout_channel_state gauge\n";
-  for (const auto& [channel_id, metrics] : channel_metrics_) {
+  for (const auto& [channel_id, metrics] : channels) {
     oss << "retrovue_playout_channel_state{channel=\"" << channel_id
         << "\",state=\"" << ChannelStateToString(metrics.state) << "\"} "
         << ChannelStateToValue(metrics.state) << "\n";
@@ -408,32 +848,374 @@ std::string MetricsExporter::GenerateMetricsText() const {
 
   oss << "\n# HELP retrovue_playout_buffer_depth_frames Number of frames in buffer\n";
   oss << "# TYPE retrovue_playout_buffer_depth_frames gauge\n";
-  for (const auto& [channel_id, metrics] : channel_metrics_) {
+  for (const auto& [channel_id, metrics] : channels) {
     oss << "retrovue_playout_buffer_depth_frames{channel=\"" << channel_id
         << "\"} " << metrics.buffer_depth_frames << "\n";
   }
 
+  oss << "\n# HELP retrovue_playout_buffer_high_water_frames Deepest buffer occupancy since last reset\n";
+  oss << "# TYPE retrovue_playout_buffer_high_water_frames gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_high_water_frames{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_high_water_frames << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_low_water_frames Shallowest buffer occupancy since last reset\n";
+  oss << "# TYPE retrovue_playout_buffer_low_water_frames gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_low_water_frames{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_low_water_frames << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_push_failures_total Frames rejected because the buffer was full\n";
+  oss << "# TYPE retrovue_playout_buffer_push_failures_total counter\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_push_failures_total{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_push_failures_total << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_residency_seconds Time frames spend between push and pop\n";
+  oss << "# TYPE retrovue_playout_buffer_residency_seconds summary\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_residency_seconds_sum{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_residency_seconds_sum << "\n";
+    oss << "retrovue_playout_buffer_residency_seconds_count{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_residency_count << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_residency_seconds_max Longest push-to-pop time since last reset\n";
+  oss << "# TYPE retrovue_playout_buffer_residency_seconds_max gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_residency_seconds_max{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_residency_seconds_max << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_occupancy_ratio Buffer fill ratio sampled on every push\n";
+  oss << "# TYPE retrovue_playout_buffer_occupancy_ratio histogram\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < kBufferOccupancyBuckets; ++i) {
+      cumulative += metrics.buffer_occupancy_buckets[i];
+      oss << "retrovue_playout_buffer_occupancy_ratio_bucket{channel=\"" << channel_id
+          << "\",le=\"" << static_cast<double>(i + 1) / kBufferOccupancyBuckets << "\"} "
+          << cumulative << "\n";
+    }
+    oss << "retrovue_playout_buffer_occupancy_ratio_bucket{channel=\"" << channel_id
+        << "\",le=\"+Inf\"} " << cumulative << "\n";
+    oss << "retrovue_playout_buffer_occupancy_ratio_sum{channel=\"" << channel_id
+        << "\"} " << metrics.buffer_occupancy_ratio_sum << "\n";
+    oss << "retrovue_playout_buffer_occupancy_ratio_count{channel=\"" << channel_id
+        << "\"} " << cumulative << "\n";
+  }
+
+  // Buffer memory, only for the channels the engine sized
+  oss << "\n# HELP retrovue_playout_buffer_depth_limit_frames Frames the buffer may hold\n";
+  oss << "# TYPE retrovue_playout_buffer_depth_limit_frames gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    if (metrics.buffer_memory.frame_bytes > 0) {
+      oss << "retrovue_playout_buffer_depth_limit_frames{channel=\"" << channel_id
+          << "\"} " << metrics.buffer_memory.depth_limit_frames << "\n";
+    }
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_reserved_bytes Frame memory reserved for the buffer\n";
+  oss << "# TYPE retrovue_playout_buffer_reserved_bytes gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    if (metrics.buffer_memory.frame_bytes > 0) {
+      oss << "retrovue_playout_buffer_reserved_bytes{channel=\"" << channel_id
+          << "\"} " << metrics.buffer_memory.reserved_bytes << "\n";
+    }
+  }
+
+  oss << "\n# HELP retrovue_playout_buffer_used_bytes Frame memory held by queued frames\n";
+  oss << "# TYPE retrovue_playout_buffer_used_bytes gauge\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    if (metrics.buffer_memory.frame_bytes > 0) {
+      oss << "retrovue_playout_buffer_used_bytes{channel=\"" << channel_id
+          << "\"} " << metrics.buffer_depth_frames * metrics.buffer_memory.frame_bytes << "\n";
+    }
+  }
+
+  const uint64_t budget_bytes = buffer_memory_budget_bytes_.load(std::memory_order_relaxed);
+  if (budget_bytes > 0) {
+    oss << "\n# HELP retrovue_playout_buffer_memory_budget_bytes Frame memory all buffers may reserve\n";
+    oss << "# TYPE retrovue_playout_buffer_memory_budget_bytes gauge\n";
+    oss << "retrovue_playout_buffer_memory_budget_bytes " << budget_bytes << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_read_stalls_total Demuxer reads that waited on storage after the read-ahead window ran dry\n";
+  oss << "# TYPE retrovue_playout_read_stalls_total counter\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_read_stalls_total{channel=\"" << channel_id
+        << "\"} " << metrics.read_stalls_total << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_read_stall_seconds_total Time demuxers spent blocked on storage\n";
+  oss << "# TYPE retrovue_playout_read_stall_seconds_total counter\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_read_stall_seconds_total{channel=\"" << channel_id
+        << "\"} " << metrics.read_stall_seconds_total << "\n";
+  }
+
+  // SRT contribution links, only for the channels that have one
+  struct SrtGauge {
+    const char* name;
+    const char* help;
+    double (*value)(const SrtLinkMetrics&);
+  };
+  struct SrtCounter {
+    const char* name;
+    const char* help;
+    uint64_t (*value)(const SrtLinkMetrics&);
+  };
+  static const SrtGauge kSrtGauges[] = {
+      {"retrovue_playout_srt_connected", "1 while the SRT peer is connected",
+       [](const SrtLinkMetrics& l) { return l.connected ? 1.0 : 0.0; }},
+      {"retrovue_playout_srt_rtt_seconds", "Smoothed SRT round-trip time",
+       [](const SrtLinkMetrics& l) { return l.rtt_seconds; }},
+      {"retrovue_playout_srt_send_buffer_ratio", "SRT send buffer fill",
+       [](const SrtLinkMetrics& l) { return l.send_buffer_ratio; }},
+      {"retrovue_playout_srt_send_buffer_seconds",
+       "Time span of the unacknowledged data in the SRT send buffer",
+       [](const SrtLinkMetrics& l) { return l.send_buffer_seconds; }},
+      {"retrovue_playout_srt_send_rate_bps", "SRT sending rate, retransmissions included",
+       [](const SrtLinkMetrics& l) { return l.send_rate_bps; }},
+  };
+  static const SrtCounter kSrtCounters[] = {
+      {"retrovue_playout_srt_retransmits_total", "Packets SRT retransmitted",
+       [](const SrtLinkMetrics& l) { return l.retransmits_total; }},
+      {"retrovue_playout_srt_packets_lost_total", "Packets the SRT receiver reported lost",
+       [](const SrtLinkMetrics& l) { return l.packets_lost_total; }},
+      {"retrovue_playout_srt_send_drops_total", "Packets SRT dropped as too late to deliver",
+       [](const SrtLinkMetrics& l) { return l.send_drops_total; }},
+      {"retrovue_playout_srt_bytes_sent_total", "TS bytes sent over SRT",
+       [](const SrtLinkMetrics& l) { return l.bytes_sent_total; }},
+  };
+  for (const SrtGauge& gauge : kSrtGauges) {
+    oss << "\n# HELP " << gauge.name << " " << gauge.help << "\n";
+    oss << "# TYPE " << gauge.name << " gauge\n";
+    for (const auto& [channel_id, metrics] : channels) {
+      if (metrics.srt_link) {
+        oss << gauge.name << "{channel=\"" << channel_id << "\"} "
+            << gauge.value(*metrics.srt_link) << "\n";
+      }
+    }
+  }
+  for (const SrtCounter& counter : kSrtCounters) {
+    oss << "\n# HELP " << counter.name << " " << counter.help << "\n";
+    oss << "# TYPE " << counter.name << " counter\n";
+    for (const auto& [channel_id, metrics] : channels) {
+      if (metrics.srt_link) {
+        oss << counter.name << "{channel=\"" << channel_id << "\"} "
+            << counter.value(*metrics.srt_link) << "\n";
+      }
+    }
+  }
+
   oss << "\n# HELP retrovue_playout_frame_gap_seconds Timing deviation from MasterClock\n";
   oss << "# TYPE retrovue_playout_frame_gap_seconds gauge\n";
-  for (const auto& [channel_id, metrics] : channel_metrics_) {
+  for (const auto& [channel_id, metrics] : channels) {
     oss << "retrovue_playout_frame_gap_seconds{channel=\"" << channel_id
         << "\"} " << metrics.frame_gap_seconds << "\n";
   }
 
   oss << "\n# HELP retrovue_playout_decode_failure_count Total decode failures\n";
   oss << "# TYPE retrovue_playout_decode_failure_count counter\n";
-  for (const auto& [channel_id, metrics] : channel_metrics_) {
+  for (const auto& [channel_id, metrics] : channels) {
     oss << "retrovue_playout_decode_failure_count{channel=\"" << channel_id
         << "\"} " << metrics.decode_failure_count << "\n";
   }
 
+  oss << "\n# HELP retrovue_playout_buffer_underrun_total Times the renderer found the buffer empty\n";
+  oss << "# TYPE retrovue_playout_buffer_underrun_total counter\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_buffer_underrun_total{channel=\"" << channel_id
+        << "\"} " << metrics.underruns_total << "\n";
+  }
+
+  oss << "\n# HELP retrovue_playout_late_frames_total Frames dropped as too late to present\n";
+  oss << "# TYPE retrovue_playout_late_frames_total counter\n";
+  for (const auto& [channel_id, metrics] : channels) {
+    oss << "retrovue_playout_late_frames_total{channel=\"" << channel_id
+        << "\"} " << metrics.late_frames_total << "\n";
+  }
+
   oss << "\n# HELP retrovue_playout_corrections_total Total timing corrections applied\n";
   oss << "# TYPE retrovue_playout_corrections_total counter\n";
-  for (const auto& [channel_id, metrics] : channel_metrics_) {
+  for (const auto& [channel_id, metrics] : channels) {
     oss << "retrovue_playout_corrections_total{channel=\"" << channel_id << "\"} "
         << metrics.corrections_total << "\n";
   }
 
+  // Quantiles and sum/count of a histogram, its values multiplied by scale
+  // (1e-6: microseconds to seconds)
+  const auto write_summary = [&oss](const char* name, const std::string& labels,
+                                    const HdrHistogram& values, double scale) {
+    for (const double quantile : {0.5, 0.9, 0.99}) {
+      oss << name << "{" << labels << ",quantile=\"" << quantile << "\"} "
+          << static_cast<double>(values.ValueAtPercentile(quantile * 100.0)) * scale << "\n";
+    }
+    oss << name << "_sum{" << labels << "} "
+        << values.Mean() * static_cast<double>(values.Count()) * scale << "\n";
+    oss << name << "_count{" << labels << "} " << values.Count() << "\n";
+  };
+
+  // Sampled frame traces, in seconds
+  oss << "\n# HELP retrovue_playout_frame_stage_latency_seconds Time sampled frames took to reach each pipeline stage from the one before\n";
+  oss << "# TYPE retrovue_playout_frame_stage_latency_seconds summary\n";
+  for (const auto& [channel_id, latency] : frame_latency_) {
+    for (size_t stage = 0; stage < buffer::kFrameStageCount; ++stage) {
+      if (latency.stage_us[stage].Count() == 0) {
+        continue;
+      }
+      write_summary("retrovue_playout_frame_stage_latency_seconds",
+                    "channel=\"" + std::to_string(channel_id) + "\",stage=\"" +
+                        buffer::FrameStageName(static_cast<buffer::FrameStage>(stage)) + "\"",
+                    latency.stage_us[stage], 1e-6);
+    }
+  }
+  oss << "\n# HELP retrovue_playout_frame_pipeline_latency_seconds Time sampled frames took from their first traced stage to their last\n";
+  oss << "# TYPE retrovue_playout_frame_pipeline_latency_seconds summary\n";
+  for (const auto& [channel_id, latency] : frame_latency_) {
+    write_summary("retrovue_playout_frame_pipeline_latency_seconds",
+                  "channel=\"" + std::to_string(channel_id) + "\"", latency.total_us, 1e-6);
+  }
+
+  oss << "\n# HELP retrovue_channel_cpu_seconds_total Thread CPU time a channel used, per pipeline stage\n";
+  oss << "# TYPE retrovue_channel_cpu_seconds_total counter\n";
+  for (const auto& [channel_id, account] : channel_cpu_) {
+    for (size_t stage = 0; stage < kCpuStageCount; ++stage) {
+      const auto cpu_stage = static_cast<CpuStage>(stage);
+      oss << "retrovue_channel_cpu_seconds_total{channel=\"" << channel_id << "\",stage=\""
+          << CpuStageName(cpu_stage) << "\"} "
+          << static_cast<double>(account->Get(cpu_stage)) / 1e9 << "\n";
+    }
+  }
+
+  std::map<int32_t, buffer::ChannelArenaStats> arenas;
+  for (const auto& [channel_id, arena] : channel_arenas_) {
+    arenas.emplace(channel_id, arena->GetStats());
+  }
+  oss << "\n# HELP retrovue_channel_memory_bytes Frame and decoded picture memory a channel's arena holds, in use or cached for reuse\n";
+  oss << "# TYPE retrovue_channel_memory_bytes gauge\n";
+  for (const auto& [channel_id, arena] : arenas) {
+    oss << "retrovue_channel_memory_bytes{channel=\"" << channel_id << "\",state=\"in_use\"} "
+        << arena.bytes_in_use << "\n";
+    oss << "retrovue_channel_memory_bytes{channel=\"" << channel_id << "\",state=\"cached\"} "
+        << arena.bytes_cached << "\n";
+  }
+  oss << "\n# HELP retrovue_channel_memory_peak_bytes Most memory a channel's arena had in use\n";
+  oss << "# TYPE retrovue_channel_memory_peak_bytes gauge\n";
+  for (const auto& [channel_id, arena] : arenas) {
+    oss << "retrovue_channel_memory_peak_bytes{channel=\"" << channel_id << "\"} "
+        << arena.peak_bytes_in_use << "\n";
+  }
+  oss << "\n# HELP retrovue_channel_memory_allocations_total Arena allocations, by whether the system or the arena's cache served them\n";
+  oss << "# TYPE retrovue_channel_memory_allocations_total counter\n";
+  for (const auto& [channel_id, arena] : arenas) {
+    oss << "retrovue_channel_memory_allocations_total{channel=\"" << channel_id
+        << "\",source=\"system\"} " << arena.allocations << "\n";
+    oss << "retrovue_channel_memory_allocations_total{channel=\"" << channel_id
+        << "\",source=\"reused\"} " << arena.reuses << "\n";
+  }
+
+  // Encoder and output path, one snapshot per channel
+  std::map<int32_t, EncoderTelemetrySnapshot> encoders;
+  for (const auto& [channel_id, telemetry] : encoder_telemetry_) {
+    encoders.emplace(channel_id, telemetry->Snapshot());
+  }
+  const auto channel_label = [](int32_t channel_id) {
+    return "channel=\"" + std::to_string(channel_id) + "\"";
+  };
+  oss << "\n# HELP retrovue_encoder_encode_seconds Wall time each frame took through the encoder and muxer\n";
+  oss << "# TYPE retrovue_encoder_encode_seconds summary\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    write_summary("retrovue_encoder_encode_seconds", channel_label(channel_id), encoder.encode_us,
+                  1e-6);
+  }
+  oss << "\n# HELP retrovue_encoder_frame_size_bytes Coded video frame size by picture type\n";
+  oss << "# TYPE retrovue_encoder_frame_size_bytes summary\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    for (size_t type = 0; type < kPictureTypeCount; ++type) {
+      if (encoder.frame_bytes[type].Count() > 0) {
+        write_summary("retrovue_encoder_frame_size_bytes",
+                      channel_label(channel_id) + ",picture=\"" +
+                          PictureTypeName(static_cast<PictureType>(type)) + "\"",
+                      encoder.frame_bytes[type], 1.0);
+      }
+    }
+  }
+  oss << "\n# HELP retrovue_encoder_qp Quantizer of coded video frames by picture type (encoders that report it)\n";
+  oss << "# TYPE retrovue_encoder_qp summary\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    for (size_t type = 0; type < kPictureTypeCount; ++type) {
+      if (encoder.qp[type].Count() > 0) {
+        write_summary("retrovue_encoder_qp",
+                      channel_label(channel_id) + ",picture=\"" +
+                          PictureTypeName(static_cast<PictureType>(type)) + "\"",
+                      encoder.qp[type], 1.0);
+      }
+    }
+  }
+  oss << "\n# HELP retrovue_encoder_pcr_interval_seconds Stream time between consecutive PCRs\n";
+  oss << "# TYPE retrovue_encoder_pcr_interval_seconds summary\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    write_summary("retrovue_encoder_pcr_interval_seconds", channel_label(channel_id),
+                  encoder.pcr_interval_us, 1e-6);
+  }
+  oss << "\n# HELP retrovue_encoder_pcr_jitter_seconds Difference between PCR advance and wall time between PCRs\n";
+  oss << "# TYPE retrovue_encoder_pcr_jitter_seconds summary\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    write_summary("retrovue_encoder_pcr_jitter_seconds", channel_label(channel_id),
+                  encoder.pcr_jitter_us, 1e-6);
+  }
+  oss << "\n# HELP retrovue_encoder_configured_bitrate_bps Configured video bitrate\n";
+  oss << "# TYPE retrovue_encoder_configured_bitrate_bps gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    oss << "retrovue_encoder_configured_bitrate_bps{" << channel_label(channel_id) << "} "
+        << encoder.configured_bitrate_bps << "\n";
+  }
+  oss << "\n# HELP retrovue_encoder_realized_bitrate_bps Muxed output rate over the last second\n";
+  oss << "# TYPE retrovue_encoder_realized_bitrate_bps gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    oss << "retrovue_encoder_realized_bitrate_bps{" << channel_label(channel_id) << "} "
+        << encoder.realized_bitrate_bps << "\n";
+  }
+  oss << "\n# HELP retrovue_encoder_output_bytes_total Muxed TS bytes handed to the outputs\n";
+  oss << "# TYPE retrovue_encoder_output_bytes_total counter\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    oss << "retrovue_encoder_output_bytes_total{" << channel_label(channel_id) << "} "
+        << encoder.output_bytes << "\n";
+  }
+  oss << "\n# HELP retrovue_encoder_output_queue_bytes Muxed bytes not yet sent, up to the slowest client\n";
+  oss << "# TYPE retrovue_encoder_output_queue_bytes gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    oss << "retrovue_encoder_output_queue_bytes{" << channel_label(channel_id) << "} "
+        << encoder.output_queue_bytes << "\n";
+  }
+  oss << "\n# HELP retrovue_encoder_send_buffer_ratio Fullest client socket send buffer (0-1)\n";
+  oss << "# TYPE retrovue_encoder_send_buffer_ratio gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    oss << "retrovue_encoder_send_buffer_ratio{" << channel_label(channel_id) << "} "
+        << encoder.send_buffer_ratio << "\n";
+  }
+  oss << "\n# HELP retrovue_audio_integrated_lufs Gated loudness of the audio aired since start\n";
+  oss << "# TYPE retrovue_audio_integrated_lufs gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    if (encoder.audio_measured && std::isfinite(encoder.audio_integrated_lufs)) {
+      oss << "retrovue_audio_integrated_lufs{" << channel_label(channel_id) << "} "
+          << encoder.audio_integrated_lufs << "\n";
+    }
+  }
+  oss << "\n# HELP retrovue_audio_gain_db Loudness normalization gain\n";
+  oss << "# TYPE retrovue_audio_gain_db gauge\n";
+  for (const auto& [channel_id, encoder] : encoders) {
+    if (encoder.audio_measured) {
+      oss << "retrovue_audio_gain_db{" << channel_label(channel_id) << "} "
+          << encoder.audio_gain_db << "\n";
+    }
+  }
+
   oss << "\n# HELP retrovue_metrics_descriptor_version Metric descriptor version\n";
   oss << "# TYPE retrovue_metrics_descriptor_version gauge\n";
   for (const auto& [name, version] : descriptor_versions_) {
@@ -445,40 +1227,41 @@ std::string MetricsExporter::GenerateMetricsText() const {
 
   oss << "\n# HELP retrovue_metrics_delivery_failures_total Delivery failures per transport\n";
   oss << "# TYPE retrovue_metrics_delivery_failures_total counter\n";
-  for (const auto& [transport, data] : transport_data_) {
-    const char* transport_name = "";
-    switch (transport) {
-      case Transport::kGrpcStream:
-        transport_name = "grpc_stream";
-        break;
-      case Transport::kScrape:
-        transport_name = "scrape";
-        break;
-      case Transport::kFile:
-        transport_name = "file";
-        break;
+  for (size_t i = 0; i < kTransports; ++i) {
+    const TransportData& data = transport_data_[i];
+    const uint64_t failures = data.failures.load(std::memory_order_relaxed);
+    if (failures + data.deliveries.load(std::memory_order_relaxed) > 0) {
+      oss << "retrovue_metrics_delivery_failures_total{transport=\""
+          << TransportName(static_cast<Transport>(i)) << "\"} " << failures << "\n";
     }
-    oss << "retrovue_metrics_delivery_failures_total{transport=\"" << transport_name << "\"} "
-        << data.failures << "\n";
   }
 
   oss << "\n# HELP retrovue_metrics_delivery_latency_ms Delivery latency p95 per transport\n";
   oss << "# TYPE retrovue_metrics_delivery_latency_ms gauge\n";
-  for (const auto& [transport, data] : transport_data_) {
-    const char* transport_name = "";
-    switch (transport) {
-      case Transport::kGrpcStream:
-        transport_name = "grpc_stream";
-        break;
-      case Transport::kScrape:
-        transport_name = "scrape";
-        break;
-      case Transport::kFile:
-        transport_name = "file";
-        break;
+  for (size_t i = 0; i < kTransports; ++i) {
+    const TransportData& data = transport_data_[i];
+    if (data.failures.load(std::memory_order_relaxed) +
+            data.deliveries.load(std::memory_order_relaxed) > 0) {
+      oss << "retrovue_metrics_delivery_latency_ms{transport=\""
+          << TransportName(static_cast<Transport>(i)) << "\"} "
+          << P95Ms(data.latency_us.Total()) << "\n";
+    }
+  }
+
+  oss << "\n# HELP retrovue_metrics_delivery_latency_window_ms Delivery latency p95 per transport over recent windows\n";
+  oss << "# TYPE retrovue_metrics_delivery_latency_window_ms gauge\n";
+  for (size_t i = 0; i < kTransports; ++i) {
+    const TransportData& data = transport_data_[i];
+    if (data.failures.load(std::memory_order_relaxed) +
+            data.deliveries.load(std::memory_order_relaxed) == 0) {
+      continue;
     }
-    oss << "retrovue_metrics_delivery_latency_ms{transport=\"" << transport_name << "\"} "
-        << ComputePercentile(data.latencies_ms, 0.95) << "\n";
+    const char* transport_name = TransportName(static_cast<Transport>(i));
+    const HistogramViews latency = data.latency_us.Views();
+    oss << "retrovue_metrics_delivery_latency_window_ms{transport=\"" << transport_name
+        << "\",window=\"1m\"} " << P95Ms(latency.last_1m) << "\n";
+    oss << "retrovue_metrics_delivery_latency_window_ms{transport=\"" << transport_name
+        << "\",window=\"5m\"} " << P95Ms(latency.last_5m) << "\n";
   }
 
   return oss.str();
@@ -5,7 +5,12 @@
 
 #include "retrovue/telemetry/MetricsHTTPServer.h"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <sstream>
 #include <thread>
@@ -17,10 +22,13 @@
   #pragma comment(lib, "ws2_32.lib")
   typedef int socklen_t;
   #define CLOSE_SOCKET closesocket
+  #define poll WSAPoll
 #else
   #include <arpa/inet.h>
+  #include <errno.h>
   #include <fcntl.h>
   #include <netinet/in.h>
+  #include <poll.h>
   #include <sys/socket.h>
   #include <unistd.h>
   #define INVALID_SOCKET -1
@@ -28,8 +36,244 @@
   #define CLOSE_SOCKET close
 #endif
 
+#ifdef __linux__
+  #include <sys/epoll.h>
+#endif
+
+#ifdef RETROVUE_ZLIB_AVAILABLE
+  #include <zlib.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
 namespace retrovue::telemetry {
 
+namespace {
+
+constexpr size_t kMaxRequestBytes = 16 * 1024;            // Request head (and body) limit
+constexpr auto kIdleTimeout = std::chrono::seconds(5);    // Quiet connections are closed
+constexpr int kPollTimeoutMs = 100;                       // Stop checks (and Windows wakes)
+constexpr size_t kMinGzipBytes = 1024;                    // Smaller bodies go out as they are
+constexpr uint64_t kListenKey = 0;
+constexpr uint64_t kWakeKey = 1;
+
+const char* StatusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+  }
+}
+
+// Decodes %XX escapes and '+' in a query component.
+std::string UrlDecode(const std::string& text) {
+  std::string decoded;
+  decoded.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size()) {
+      decoded += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+std::shared_ptr<const std::string> TextBody(std::string text) {
+  return std::make_shared<const std::string>(std::move(text));
+}
+
+bool SetNonBlocking(int socket) {
+#ifdef _WIN32
+  u_long mode = 1;
+  return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+  const int flags = fcntl(socket, F_GETFL, 0);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool WouldBlock() {
+#ifdef _WIN32
+  const int err = WSAGetLastError();
+  return err == WSAEWOULDBLOCK || err == WSAEINTR;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+std::string Lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return text;
+}
+
+// Value of header `name` (lowercase) in a request head, lowercased; empty
+// if absent.
+std::string HeaderValue(const std::string& head, const std::string& name) {
+  size_t line = head.find("\r\n");
+  while (line != std::string::npos && line + 2 < head.size()) {
+    const size_t start = line + 2;
+    const size_t end = head.find("\r\n", start);
+    const std::string field =
+        head.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    const size_t colon = field.find(':');
+    if (colon != std::string::npos && Lowercase(field.substr(0, colon)) == name) {
+      const size_t value = field.find_first_not_of(" \t", colon + 1);
+      return value == std::string::npos ? std::string() : Lowercase(field.substr(value));
+    }
+    line = end;
+  }
+  return {};
+}
+
+#ifdef RETROVUE_ZLIB_AVAILABLE
+// gzip-encodes text; false if zlib failed.
+bool Gzip(const std::string& text, std::string& encoded) {
+  z_stream stream{};
+  // 15 window bits + 16 selects the gzip wrapper
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  encoded.resize(deflateBound(&stream, static_cast<uLong>(text.size())) + 32);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+  stream.avail_in = static_cast<uInt>(text.size());
+  stream.next_out = reinterpret_cast<Bytef*>(encoded.data());
+  stream.avail_out = static_cast<uInt>(encoded.size());
+  const int result = deflate(&stream, Z_FINISH);
+  encoded.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result == Z_STREAM_END;
+}
+#endif
+
+// Poller waits for socket readiness: epoll on Linux, poll() elsewhere.
+class Poller {
+ public:
+  struct Ready {
+    uint64_t key;
+    bool readable;
+    bool writable;
+    bool hangup;
+  };
+
+  Poller() {
+#ifdef __linux__
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+#endif
+  }
+
+  ~Poller() {
+#ifdef __linux__
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+    }
+#endif
+  }
+
+  Poller(const Poller&) = delete;
+  Poller& operator=(const Poller&) = delete;
+
+  bool ok() const {
+#ifdef __linux__
+    return epoll_fd_ >= 0;
+#else
+    return true;
+#endif
+  }
+
+  // Watches socket for input (and for output room with want_write).
+  void Add(int socket, uint64_t key, bool want_write) { Control(socket, key, want_write, true); }
+  void Modify(int socket, uint64_t key, bool want_write) {
+    Control(socket, key, want_write, false);
+  }
+
+  void Remove(int socket) {
+#ifdef __linux__
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, nullptr);
+#else
+    sockets_.erase(socket);
+#endif
+  }
+
+  // Waits up to timeout_ms; fills ready (cleared first).
+  void Wait(std::vector<Ready>& ready, int timeout_ms) {
+    ready.clear();
+#ifdef __linux__
+    epoll_event events[64];
+    const int count = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+    for (int i = 0; i < count; ++i) {
+      const uint32_t e = events[i].events;
+      ready.push_back({events[i].data.u64, (e & EPOLLIN) != 0, (e & EPOLLOUT) != 0,
+                       (e & (EPOLLERR | EPOLLHUP)) != 0});
+    }
+#else
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> keys;
+    for (const auto& [socket, watch] : sockets_) {
+      pollfd fd{};
+      fd.fd = socket;
+      fd.events = static_cast<short>(POLLIN | (watch.second ? POLLOUT : 0));
+      fds.push_back(fd);
+      keys.push_back(watch.first);
+    }
+    if (poll(fds.data(), static_cast<unsigned long>(fds.size()), timeout_ms) <= 0) {
+      return;
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+      const short e = fds[i].revents;
+      if (e != 0) {
+        ready.push_back({keys[i], (e & POLLIN) != 0, (e & POLLOUT) != 0,
+                         (e & (POLLERR | POLLHUP | POLLNVAL)) != 0});
+      }
+    }
+#endif
+  }
+
+ private:
+  void Control(int socket, uint64_t key, bool want_write, bool add) {
+#ifdef __linux__
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0u);
+    event.data.u64 = key;
+    epoll_ctl(epoll_fd_, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, socket, &event);
+#else
+    (void)add;
+    sockets_[socket] = {key, want_write};
+#endif
+  }
+
+#ifdef __linux__
+  int epoll_fd_ = -1;
+#else
+  std::map<int, std::pair<uint64_t, bool>> sockets_;  // socket -> key, want_write
+#endif
+};
+
+}  // namespace
+
+// Client is one connection's buffers and keep-alive state.
+struct MetricsHTTPServer::Client {
+  int socket = INVALID_SOCKET;
+  uint64_t id = 0;
+  std::string input;                                     // Unparsed request bytes
+  std::deque<std::shared_ptr<const std::string>> output;  // Queued response pieces
+  size_t output_offset = 0;                              // Sent of output.front()
+  bool busy = false;          // A handler thread holds its current request
+  bool keep_alive = true;     // Of the request being answered
+  bool close_after = false;   // Close once output is sent
+  bool want_write = false;    // Poller watches for output room
+  std::chrono::steady_clock::time_point last_activity;
+};
+
 MetricsHTTPServer::MetricsHTTPServer(int port)
     : port_(port),
       running_(false),
@@ -45,13 +289,36 @@ void MetricsHTTPServer::SetMetricsCallback(MetricsCallback callback) {
   metrics_callback_ = std::move(callback);
 }
 
+void MetricsHTTPServer::SetMetricsVersionCallback(MetricsVersionCallback callback) {
+  metrics_version_callback_ = std::move(callback);
+}
+
+void MetricsHTTPServer::SetMetricsCacheInterval(std::chrono::milliseconds interval) {
+  metrics_cache_interval_ = std::max(interval, std::chrono::milliseconds(0));
+}
+
+void MetricsHTTPServer::AddHandler(const std::string& prefix, HttpHandler handler) {
+  handlers_.emplace_back(prefix, std::move(handler));
+}
+
+HttpServerStats MetricsHTTPServer::GetStats() const {
+  HttpServerStats stats;
+  stats.connections_accepted = connections_accepted_.load(std::memory_order_relaxed);
+  stats.connections_rejected = connections_rejected_.load(std::memory_order_relaxed);
+  stats.requests = requests_.load(std::memory_order_relaxed);
+  stats.metrics_generated = metrics_generated_.load(std::memory_order_relaxed);
+  stats.metrics_cached = metrics_cached_.load(std::memory_order_relaxed);
+  stats.gzip_responses = gzip_responses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 bool MetricsHTTPServer::Start() {
   if (running_.load(std::memory_order_acquire)) {
     std::cerr << "[MetricsHTTPServer] Already running" << std::endl;
     return false;
   }
 
-  if (!metrics_callback_) {
+  if (!metrics_callback_ && handlers_.empty()) {
     std::cerr << "[MetricsHTTPServer] Metrics callback not set" << std::endl;
     return false;
   }
@@ -63,6 +330,18 @@ bool MetricsHTTPServer::Start() {
     std::cerr << "[MetricsHTTPServer] WSAStartup failed" << std::endl;
     return false;
   }
+#else
+  // Handler threads wake the loop through a pipe (Windows polls completions
+  // on the loop's timeout instead)
+  int wake[2];
+  if (pipe(wake) != 0) {
+    std::cerr << "[MetricsHTTPServer] Failed to create wake pipe" << std::endl;
+    return false;
+  }
+  SetNonBlocking(wake[0]);
+  SetNonBlocking(wake[1]);
+  wake_read_ = wake[0];
+  wake_write_ = wake[1];
 #endif
 
   stop_requested_.store(false, std::memory_order_release);
@@ -83,13 +362,10 @@ void MetricsHTTPServer::Stop() {
 
   std::cout << "[MetricsHTTPServer] Stopping..." << std::endl;
   stop_requested_.store(true, std::memory_order_release);
+  Wake();
 
-  // Close server socket to unblock accept()
-  if (server_socket_ != INVALID_SOCKET) {
-    CLOSE_SOCKET(server_socket_);
-    server_socket_ = INVALID_SOCKET;
-  }
-
+  // The loop closes the server socket and connections itself (closing them
+  // here would race it)
   if (server_thread_ && server_thread_->joinable()) {
     server_thread_->join();
   }
@@ -99,6 +375,13 @@ void MetricsHTTPServer::Stop() {
 
 #ifdef _WIN32
   WSACleanup();
+#else
+  if (wake_read_ >= 0) {
+    close(wake_read_);
+    close(wake_write_);
+    wake_read_ = -1;
+    wake_write_ = -1;
+  }
 #endif
   
   std::cout << "[MetricsHTTPServer] Stopped" << std::endl;
@@ -107,6 +390,12 @@ void MetricsHTTPServer::Stop() {
 void MetricsHTTPServer::ServerLoop() {
   std::cout << "[MetricsHTTPServer] Server loop started" << std::endl;
 
+  Poller poller;
+  if (!poller.ok()) {
+    std::cerr << "[MetricsHTTPServer] Failed to create poller" << std::endl;
+    return;
+  }
+
   // Create socket
   server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
   if (server_socket_ == INVALID_SOCKET) {
@@ -121,15 +410,7 @@ void MetricsHTTPServer::ServerLoop() {
 #else
   setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 #endif
-
-  // Set non-blocking mode for accept timeout
-#ifdef _WIN32
-  u_long mode = 1;
-  ioctlsocket(server_socket_, FIONBIO, &mode);
-#else
-  int flags = fcntl(server_socket_, F_GETFL, 0);
-  fcntl(server_socket_, F_SETFL, flags | O_NONBLOCK);
-#endif
+  SetNonBlocking(server_socket_);
 
   // Bind socket
   sockaddr_in addr{};
@@ -145,48 +426,166 @@ void MetricsHTTPServer::ServerLoop() {
   }
 
   // Listen for connections
-  if (listen(server_socket_, 5) == SOCKET_ERROR) {
+  if (listen(server_socket_, 128) == SOCKET_ERROR) {
     std::cerr << "[MetricsHTTPServer] Failed to listen" << std::endl;
     CLOSE_SOCKET(server_socket_);
     server_socket_ = INVALID_SOCKET;
     return;
   }
 
+  poller.Add(server_socket_, kListenKey, false);
+  if (wake_read_ >= 0) {
+    poller.Add(wake_read_, kWakeKey, false);
+  }
+
   running_.store(true, std::memory_order_release);
   std::cout << "[MetricsHTTPServer] Listening on port " << port_ << std::endl;
 
-  // Accept loop
+  uint64_t next_client_id = kWakeKey + 1;
+  std::vector<Poller::Ready> ready;
+  std::vector<Completion> completions;
+
+  auto close_client = [this, &poller](uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) {
+      return;
+    }
+    poller.Remove(it->second->socket);
+    CLOSE_SOCKET(it->second->socket);
+    clients_.erase(it);
+  };
+
+  // Sends what a client has queued and watches for output room while some
+  // is left; closes the client if it is done or gone
+  auto flush_client = [this, &poller, &close_client](Client& client) {
+    if (!FlushClient(client)) {
+      close_client(client.id);
+      return;
+    }
+    const bool want_write = !client.output.empty();
+    if (want_write != client.want_write) {
+      client.want_write = want_write;
+      poller.Modify(client.socket, client.id, want_write);
+    }
+  };
+
   while (!stop_requested_.load(std::memory_order_acquire)) {
-    sockaddr_in client_addr{};
-    socklen_t client_len = sizeof(client_addr);
-    
-    int client_socket = accept(server_socket_, (sockaddr*)&client_addr, &client_len);
-    
-    if (client_socket == INVALID_SOCKET) {
-#ifdef _WIN32
-      int err = WSAGetLastError();
-      if (err == WSAEWOULDBLOCK) {
-        // No pending connection - sleep and retry
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    poller.Wait(ready, kPollTimeoutMs);
+    const auto now = std::chrono::steady_clock::now();
+
+    for (const Poller::Ready& event : ready) {
+      if (event.key == kListenKey) {
+        // Accept everything pending
+        while (true) {
+          sockaddr_in client_addr{};
+          socklen_t client_len = sizeof(client_addr);
+          const int client_socket =
+              static_cast<int>(accept(server_socket_, (sockaddr*)&client_addr, &client_len));
+          if (client_socket == INVALID_SOCKET) {
+            break;
+          }
+          if (clients_.size() >= kMaxConnections || !SetNonBlocking(client_socket)) {
+            const std::string busy =
+                "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n";
+            send(client_socket, busy.c_str(), static_cast<int>(busy.size()), MSG_NOSIGNAL);
+            CLOSE_SOCKET(client_socket);
+            connections_rejected_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+          }
+          auto client = std::make_unique<Client>();
+          client->socket = client_socket;
+          client->id = next_client_id++;
+          client->last_activity = now;
+          poller.Add(client_socket, client->id, false);
+          clients_.emplace(client->id, std::move(client));
+          connections_accepted_.fetch_add(1, std::memory_order_relaxed);
+        }
         continue;
       }
-#else
-      if (errno == EWOULDBLOCK || errno == EAGAIN) {
-        // No pending connection - sleep and retry
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+      if (event.key == kWakeKey) {
+#ifndef _WIN32
+        char drain[64];
+        while (read(wake_read_, drain, sizeof(drain)) > 0) {
+        }
+#endif
         continue;
       }
-#endif
-      // Real error or server closing
-      break;
+
+      auto it = clients_.find(event.key);
+      if (it == clients_.end()) {
+        continue;
+      }
+      Client& client = *it->second;
+
+      if (event.readable || event.hangup) {
+        bool open = true;
+        char buffer[4096];
+        while (true) {
+          const int bytes = static_cast<int>(recv(client.socket, buffer, sizeof(buffer), 0));
+          if (bytes > 0) {
+            client.input.append(buffer, static_cast<size_t>(bytes));
+            client.last_activity = now;
+            continue;
+          }
+          // 0 is an orderly shutdown; anything but "try again" an error
+          open = bytes < 0 && WouldBlock();
+          break;
+        }
+        if (!open || !ServeRequests(client)) {
+          close_client(client.id);
+          continue;
+        }
+      }
+      if (event.writable || !client.output.empty()) {
+        flush_client(client);
+      }
     }
 
-    // Handle connection
-    HandleConnection(client_socket);
-    CLOSE_SOCKET(client_socket);
+    // Responses of handlers that returned
+    {
+      std::lock_guard<std::mutex> lock(completions_mutex_);
+      completions.swap(completions_);
+    }
+    for (Completion& completion : completions) {
+      auto it = clients_.find(completion.client_id);
+      if (it == clients_.end()) {
+        continue;  // The client went away while its handler ran
+      }
+      Client& client = *it->second;
+      client.busy = false;
+      client.last_activity = now;
+      QueueResponse(client, completion.response, false);
+      // Requests pipelined behind the handled one
+      if (!ServeRequests(client)) {
+        close_client(client.id);
+        continue;
+      }
+      flush_client(client);
+    }
+    completions.clear();
+    ReapHandlers(false);
+
+    // Idle connections (and readers too slow to take their response)
+    std::vector<uint64_t> idle;
+    for (const auto& [id, client] : clients_) {
+      if (!client->busy && now - client->last_activity > kIdleTimeout) {
+        idle.push_back(id);
+      }
+    }
+    for (const uint64_t id : idle) {
+      close_client(id);
+    }
   }
 
+  ReapHandlers(true);
+  completions_.clear();
+
   // Cleanup
+  while (!clients_.empty()) {
+    close_client(clients_.begin()->first);
+  }
   if (server_socket_ != INVALID_SOCKET) {
     CLOSE_SOCKET(server_socket_);
     server_socket_ = INVALID_SOCKET;
@@ -196,90 +595,264 @@ void MetricsHTTPServer::ServerLoop() {
   std::cout << "[MetricsHTTPServer] Server loop exited" << std::endl;
 }
 
-void MetricsHTTPServer::HandleConnection(int client_socket) {
-  // Read request (with timeout)
-  char buffer[4096] = {0};
-  
-#ifdef _WIN32
-  // Set receive timeout
-  DWORD timeout = 5000;  // 5 seconds
-  setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
-#else
-  struct timeval timeout;
-  timeout.tv_sec = 5;
-  timeout.tv_usec = 0;
-  setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-#endif
+bool MetricsHTTPServer::ServeRequests(Client& client) {
+  while (!client.busy && !client.close_after) {
+    const size_t head_end = client.input.find("\r\n\r\n");
+    if (head_end == std::string::npos) {
+      if (client.input.size() <= kMaxRequestBytes) {
+        return true;  // Wait for the rest of the request
+      }
+      HttpResponse response;
+      response.status = 400;
+      response.body = TextBody("400 Bad Request\n");
+      client.keep_alive = false;
+      QueueResponse(client, response, false);
+      return true;
+    }
 
-  int bytes_read = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-  if (bytes_read <= 0) {
-    return;
+    const std::string head = client.input.substr(0, head_end + 4);
+    const std::string length = HeaderValue(head, "content-length");
+    const size_t body_length = length.empty() ? 0 : std::strtoull(length.c_str(), nullptr, 10);
+    if (body_length > kMaxRequestBytes) {
+      HttpResponse response;
+      response.status = 400;
+      response.body = TextBody("400 Bad Request\n");
+      client.keep_alive = false;
+      QueueResponse(client, response, false);
+      return true;
+    }
+    if (client.input.size() < head.size() + body_length) {
+      return true;  // Bodies are skipped, but must arrive first
+    }
+    client.input.erase(0, head.size() + body_length);
+    requests_.fetch_add(1, std::memory_order_relaxed);
+
+    // HTTP/1.1 keeps the connection open unless told otherwise, 1.0 only
+    // when asked to
+    const std::string connection = HeaderValue(head, "connection");
+    const bool http10 = head.substr(0, head.find("\r\n")).find("HTTP/1.0") != std::string::npos;
+    client.keep_alive = http10 ? connection.find("keep-alive") != std::string::npos
+                               : connection.find("close") == std::string::npos;
+    const bool accepts_gzip =
+        HeaderValue(head, "accept-encoding").find("gzip") != std::string::npos;
+
+    HttpRequest request = ParseRequest(head);
+    if (const HttpHandler* handler = FindHandler(request.path)) {
+      if (StartHandler(*handler, std::move(request), client.id)) {
+        client.busy = true;
+        return true;
+      }
+      HttpResponse response;
+      response.status = 503;
+      response.body = TextBody("503 Service Unavailable\n");
+      connections_rejected_.fetch_add(1, std::memory_order_relaxed);
+      QueueResponse(client, response, false);
+    } else if (request.path == "/metrics" && metrics_callback_) {
+      HttpResponse response;
+      response.content_type = "text/plain; version=0.0.4; charset=utf-8";
+      response.body = MetricsBody(false);
+      const std::shared_ptr<const std::string> encoded =
+          accepts_gzip ? MetricsBody(true) : nullptr;
+      if (encoded) {
+        response.body = encoded;
+      }
+      QueueResponse(client, response, encoded != nullptr);
+    } else {
+      QueueResponse(client, GenerateResponse(request), false);
+    }
   }
+  return true;
+}
 
-  buffer[bytes_read] = '\0';
-  std::string request(buffer);
+void MetricsHTTPServer::QueueResponse(Client& client, const HttpResponse& response, bool gzip) {
+  const size_t body_length = response.body ? response.body->size() : 0;
 
-  // Parse request and generate response
-  std::string path = ParseRequest(request);
-  std::string response = GenerateResponse(path);
+  std::ostringstream header;
+  header << "HTTP/1.1 " << response.status << " " << StatusText(response.status) << "\r\n";
+  header << "Content-Type: " << response.content_type << "\r\n";
+  if (!response.cache_control.empty()) {
+    header << "Cache-Control: " << response.cache_control << "\r\n";
+  }
+  if (gzip) {
+    header << "Content-Encoding: gzip\r\n";
+    gzip_responses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (response.body && (response.body == metrics_text_ || response.body == metrics_gzip_)) {
+    header << "Vary: Accept-Encoding\r\n";
+  }
+  header << "Content-Length: " << body_length << "\r\n";
+  header << "Connection: " << (client.keep_alive ? "keep-alive" : "close") << "\r\n";
+  header << "\r\n";
+
+  // The body is queued by reference (large bodies go out in pieces)
+  client.output.push_back(TextBody(header.str()));
+  if (body_length > 0) {
+    client.output.push_back(response.body);
+  }
+  client.close_after = !client.keep_alive;
+}
 
-  // Send response
-  send(client_socket, response.c_str(), static_cast<int>(response.length()), 0);
+bool MetricsHTTPServer::FlushClient(Client& client) {
+  while (!client.output.empty()) {
+    const std::string& piece = *client.output.front();
+    const int sent = static_cast<int>(send(client.socket, piece.data() + client.output_offset,
+                                           static_cast<int>(piece.size() - client.output_offset),
+                                           MSG_NOSIGNAL));
+    if (sent < 0) {
+      return WouldBlock();
+    }
+    client.output_offset += static_cast<size_t>(sent);
+    client.last_activity = std::chrono::steady_clock::now();
+    if (client.output_offset == piece.size()) {
+      client.output.pop_front();
+      client.output_offset = 0;
+    }
+  }
+  return !client.close_after;
 }
 
-std::string MetricsHTTPServer::ParseRequest(const std::string& request) {
-  // Parse first line: GET /path HTTP/1.1
+HttpRequest MetricsHTTPServer::ParseRequest(const std::string& request) {
+  HttpRequest parsed;
+  parsed.path = "/";
+
+  // Parse first line: GET /path?query HTTP/1.1
   size_t space1 = request.find(' ');
   if (space1 == std::string::npos) {
-    return "/";
+    return parsed;
   }
 
   size_t space2 = request.find(' ', space1 + 1);
   if (space2 == std::string::npos) {
-    return "/";
+    return parsed;
+  }
+
+  const std::string target = request.substr(space1 + 1, space2 - space1 - 1);
+  const size_t question = target.find('?');
+  parsed.path = target.substr(0, question);
+  if (question == std::string::npos) {
+    return parsed;
   }
 
-  return request.substr(space1 + 1, space2 - space1 - 1);
+  std::istringstream query(target.substr(question + 1));
+  std::string pair;
+  while (std::getline(query, pair, '&')) {
+    const size_t equals = pair.find('=');
+    if (equals == std::string::npos) {
+      parsed.query[UrlDecode(pair)] = "";
+    } else {
+      parsed.query[UrlDecode(pair.substr(0, equals))] = UrlDecode(pair.substr(equals + 1));
+    }
+  }
+  return parsed;
 }
 
-std::string MetricsHTTPServer::GenerateResponse(const std::string& path) {
-  std::ostringstream response;
 
-  if (path == "/metrics") {
-    // Generate metrics via callback
-    std::string metrics = metrics_callback_();
+const HttpHandler* MetricsHTTPServer::FindHandler(const std::string& path) const {
+  // Longest prefix wins
+  const HttpHandler* handler = nullptr;
+  size_t matched = 0;
+  for (const auto& [prefix, candidate] : handlers_) {
+    if (prefix.size() >= matched && path.compare(0, prefix.size(), prefix) == 0) {
+      handler = &candidate;
+      matched = prefix.size();
+    }
+  }
+  return handler;
+}
+
+HttpResponse MetricsHTTPServer::GenerateResponse(const HttpRequest& request) {
+  HttpResponse response;
 
-    response << "HTTP/1.1 200 OK\r\n";
-    response << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
-    response << "Content-Length: " << metrics.length() << "\r\n";
-    response << "Connection: close\r\n";
-    response << "\r\n";
-    response << metrics;
-  } else if (path == "/") {
+  if (request.path == "/") {
     // Root path - return simple info page
-    std::string body = "RetroVue Playout Engine - Metrics Server\n"
-                       "Metrics available at: /metrics\n";
-    
-    response << "HTTP/1.1 200 OK\r\n";
-    response << "Content-Type: text/plain\r\n";
-    response << "Content-Length: " << body.length() << "\r\n";
-    response << "Connection: close\r\n";
-    response << "\r\n";
-    response << body;
+    response.body = TextBody("RetroVue Playout Engine - Metrics Server\n"
+                             "Metrics available at: /metrics\n");
   } else {
     // Not found
-    std::string body = "404 Not Found\n";
-    
-    response << "HTTP/1.1 404 Not Found\r\n";
-    response << "Content-Type: text/plain\r\n";
-    response << "Content-Length: " << body.length() << "\r\n";
-    response << "Connection: close\r\n";
-    response << "\r\n";
-    response << body;
+    response.status = 404;
+    response.body = TextBody("404 Not Found\n");
   }
 
-  return response.str();
+  return response;
 }
 
-}  // namespace retrovue::telemetry
+std::shared_ptr<const std::string> MetricsHTTPServer::MetricsBody(bool gzip) {
+  if (gzip) {
+#ifdef RETROVUE_ZLIB_AVAILABLE
+    // Encoded once per generated text, for the first client that accepts it
+    if (!metrics_gzip_ && metrics_text_ && metrics_text_->size() >= kMinGzipBytes) {
+      std::string encoded;
+      if (Gzip(*metrics_text_, encoded)) {
+        metrics_gzip_ = TextBody(std::move(encoded));
+      }
+    }
+    return metrics_gzip_;
+#else
+    return nullptr;
+#endif
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  const uint64_t version = metrics_version_callback_ ? metrics_version_callback_() : 0;
+  const bool changed = !metrics_version_callback_ || version != metrics_version_;
+  if (!metrics_text_ || (changed && now - metrics_generated_at_ >= metrics_cache_interval_)) {
+    metrics_text_ = TextBody(metrics_callback_());
+    metrics_gzip_.reset();
+    metrics_version_ = version;
+    metrics_generated_at_ = now;
+    metrics_generated_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    metrics_cached_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return metrics_text_;
+}
+
+bool MetricsHTTPServer::StartHandler(const HttpHandler& handler, HttpRequest request,
+                                     uint64_t client_id) {
+  ReapHandlers(false);
+  if (handler_threads_.size() >= kMaxHandlers) {
+    return false;
+  }
+  HandlerThread& slot = handler_threads_.emplace_back();
+  slot.thread = std::thread([this, &slot, &handler, request = std::move(request), client_id]() {
+    Completion completion;
+    completion.client_id = client_id;
+    if (!handler(request, completion.response)) {
+      completion.response = HttpResponse{};
+      completion.response.status = 404;
+      completion.response.body = TextBody("404 Not Found\n");
+    }
+    {
+      std::lock_guard<std::mutex> lock(completions_mutex_);
+      completions_.push_back(std::move(completion));
+    }
+    Wake();
+    slot.done.store(true, std::memory_order_release);
+  });
+  return true;
+}
+
+void MetricsHTTPServer::ReapHandlers(bool wait_all) {
+  for (auto it = handler_threads_.begin(); it != handler_threads_.end();) {
+    if (wait_all || it->done.load(std::memory_order_acquire)) {
+      if (it->thread.joinable()) {
+        it->thread.join();
+      }
+      it = handler_threads_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
 
+void MetricsHTTPServer::Wake() {
+#ifndef _WIN32
+  if (wake_write_ >= 0) {
+    const char byte = 1;
+    // A full pipe already wakes the loop
+    [[maybe_unused]] const ssize_t written = write(wake_write_, &byte, 1);
+  }
+#endif
+}
+
+}  // namespace retrovue::telemetry
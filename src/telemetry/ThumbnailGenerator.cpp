@@ -0,0 +1,392 @@
+// Repository: Retrovue-playout
+// Component: Thumbnail Generator
+// Purpose: Low-rate per-channel confidence thumbnails served over HTTP.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/telemetry/ThumbnailGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+#endif
+
+#include "retrovue/decode/DeviceFrames.h"
+#include "retrovue/decode/PlaneKernels.h"
+#include "retrovue/telemetry/MetricsHTTPServer.h"
+
+namespace retrovue::telemetry {
+
+namespace {
+
+constexpr char kHttpPrefix[] = "/thumbnail/";
+
+int64_t SteadyNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Resizes an 8-bit plane with the two-tap kernel, halving first until the
+// last step is at most 2:1 (steeper steps would skip source pixels).
+void ResizePlane(uint8_t* dst, int dst_width, int dst_height, const uint8_t* src,
+                 int src_width, int src_height, std::vector<uint8_t>& step_a,
+                 std::vector<uint8_t>& step_b) {
+  const uint8_t* current = src;
+  int width = src_width;
+  int height = src_height;
+  std::vector<uint8_t>* next = &step_a;
+  while (width > 2 * dst_width || height > 2 * dst_height) {
+    const int step_width = std::max(dst_width, (width + 1) / 2);
+    const int step_height = std::max(dst_height, (height + 1) / 2);
+    next->resize(static_cast<size_t>(step_width) * step_height);
+    decode::ScalePlane(next->data(), step_width, step_width, step_height, current, width, width,
+                       height);
+    current = next->data();
+    width = step_width;
+    height = step_height;
+    next = next == &step_a ? &step_b : &step_a;
+  }
+  decode::ScalePlane(dst, dst_width, dst_width, dst_height, current, width, width, height);
+}
+
+#ifndef RETROVUE_FFMPEG_AVAILABLE
+void PutLe16(std::string& out, uint16_t value) {
+  out.push_back(static_cast<char>(value & 0xff));
+  out.push_back(static_cast<char>(value >> 8));
+}
+
+void PutLe32(std::string& out, uint32_t value) {
+  PutLe16(out, static_cast<uint16_t>(value & 0xffff));
+  PutLe16(out, static_cast<uint16_t>(value >> 16));
+}
+
+uint8_t ClampByte(int value) { return static_cast<uint8_t>(std::clamp(value, 0, 255)); }
+
+// 24-bit bottom-up BMP from limited-range BT.601 I420.
+std::string EncodeBmp(const uint8_t* i420, int width, int height) {
+  const uint8_t* y_plane = i420;
+  const uint8_t* u_plane = y_plane + static_cast<size_t>(width) * height;
+  const uint8_t* v_plane = u_plane + static_cast<size_t>(width / 2) * (height / 2);
+  const uint32_t row_bytes = (static_cast<uint32_t>(width) * 3 + 3) & ~3u;
+  const uint32_t pixel_bytes = row_bytes * static_cast<uint32_t>(height);
+
+  std::string out;
+  out.reserve(54 + pixel_bytes);
+  out += "BM";
+  PutLe32(out, 54 + pixel_bytes);
+  PutLe32(out, 0);
+  PutLe32(out, 54);  // Pixel data offset
+  PutLe32(out, 40);  // BITMAPINFOHEADER
+  PutLe32(out, static_cast<uint32_t>(width));
+  PutLe32(out, static_cast<uint32_t>(height));
+  PutLe16(out, 1);   // Planes
+  PutLe16(out, 24);  // Bits per pixel
+  PutLe32(out, 0);   // BI_RGB
+  PutLe32(out, pixel_bytes);
+  PutLe32(out, 2835);  // 72 dpi
+  PutLe32(out, 2835);
+  PutLe32(out, 0);
+  PutLe32(out, 0);
+
+  for (int row = height - 1; row >= 0; --row) {
+    const size_t row_start = out.size();
+    for (int x = 0; x < width; ++x) {
+      const int c = y_plane[static_cast<size_t>(row) * width + x] - 16;
+      const size_t chroma = static_cast<size_t>(row / 2) * (width / 2) + x / 2;
+      const int d = u_plane[chroma] - 128;
+      const int e = v_plane[chroma] - 128;
+      out.push_back(static_cast<char>(ClampByte((298 * c + 516 * d + 128) >> 8)));
+      out.push_back(static_cast<char>(ClampByte((298 * c - 100 * d - 208 * e + 128) >> 8)));
+      out.push_back(static_cast<char>(ClampByte((298 * c + 409 * e + 128) >> 8)));
+    }
+    out.resize(row_start + row_bytes, '\0');
+  }
+  return out;
+}
+#endif
+
+}  // namespace
+
+// ============================================================================
+// ThumbnailTap
+// ============================================================================
+
+ThumbnailTap::ThumbnailTap(std::weak_ptr<ThumbnailGenerator> generator, int32_t channel_id,
+                           std::chrono::milliseconds interval)
+    : generator_(std::move(generator)),
+      channel_id_(channel_id),
+      interval_us_(std::chrono::duration_cast<std::chrono::microseconds>(interval).count()) {}
+
+bool ThumbnailTap::Offer(const buffer::FrameHandle& frame) {
+  const int64_t now = SteadyNowUs();
+  if (!frame || now < next_due_us_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  if (busy_.exchange(true, std::memory_order_acq_rel)) {
+    return false;  // The last one is still being encoded
+  }
+  next_due_us_.store(now + interval_us_, std::memory_order_relaxed);
+  const auto generator = generator_.lock();
+  if (!generator || !generator->Enqueue(shared_from_this(), frame)) {
+    busy_.store(false, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// ThumbnailGenerator
+// ============================================================================
+
+ThumbnailGenerator::ThumbnailGenerator(const ThumbnailConfig& config) : config_(config) {}
+
+ThumbnailGenerator::~ThumbnailGenerator() { Stop(); }
+
+bool ThumbnailGenerator::Start() {
+  if (running_.exchange(true, std::memory_order_acq_rel)) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = false;
+  }
+  worker_ = std::thread(&ThumbnailGenerator::WorkerLoop, this);
+  std::cout << "[ThumbnailGenerator] Started (every " << config_.interval.count() << " ms, "
+            << config_.max_width << "x" << config_.max_height << ")" << std::endl;
+  return true;
+}
+
+void ThumbnailGenerator::Stop() {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  std::deque<Job> dropped;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+    dropped.swap(queue_);
+  }
+  queue_cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  for (Job& job : dropped) {
+    job.tap->busy_.store(false, std::memory_order_release);
+  }
+  std::cout << "[ThumbnailGenerator] Stopped. Thumbnails: "
+            << generated_.load(std::memory_order_relaxed) << std::endl;
+}
+
+std::shared_ptr<ThumbnailTap> ThumbnailGenerator::AddChannel(int32_t channel_id) {
+  auto tap = std::make_shared<ThumbnailTap>(weak_from_this(), channel_id, config_.interval);
+  std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+  taps_[channel_id] = tap;
+  return tap;
+}
+
+void ThumbnailGenerator::RemoveChannel(int32_t channel_id) {
+  std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+  taps_.erase(channel_id);
+  thumbnails_.erase(channel_id);
+}
+
+bool ThumbnailGenerator::GetThumbnail(int32_t channel_id, Thumbnail& thumbnail) const {
+  std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+  const auto it = thumbnails_.find(channel_id);
+  if (it == thumbnails_.end()) {
+    return false;
+  }
+  thumbnail = it->second;
+  return true;
+}
+
+bool ThumbnailGenerator::ServeHttp(const HttpRequest& request, HttpResponse& response) const {
+  const std::string id = request.path.substr(std::min(request.path.size(), sizeof(kHttpPrefix) - 1));
+  char* end = nullptr;
+  const long channel_id = std::strtol(id.c_str(), &end, 10);
+  if (id.empty() || *end != '\0') {
+    return false;
+  }
+  Thumbnail thumbnail;
+  if (!GetThumbnail(static_cast<int32_t>(channel_id), thumbnail)) {
+    return false;
+  }
+  response.content_type = thumbnail.content_type;
+  response.cache_control = "no-cache";
+  response.body = thumbnail.image;
+  return true;
+}
+
+ThumbnailStats ThumbnailGenerator::GetStats() const {
+  ThumbnailStats stats;
+  stats.generated = generated_.load(std::memory_order_relaxed);
+  stats.failed = failed_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool ThumbnailGenerator::Enqueue(std::shared_ptr<ThumbnailTap> tap,
+                                 const buffer::FrameHandle& frame) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (stop_ || !running_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    queue_.push_back(Job{std::move(tap), frame});
+  }
+  queue_cv_.notify_one();
+  return true;
+}
+
+void ThumbnailGenerator::WorkerLoop() {
+#ifdef __linux__
+  // Thumbnails only use CPU time nothing else wants
+  sched_param param{};
+  const int rc = pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+  if (rc != 0) {
+    std::cerr << "[ThumbnailGenerator] Cannot lower the worker to SCHED_IDLE: "
+              << std::strerror(rc) << std::endl;
+  }
+#endif
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        break;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    Thumbnail thumbnail;
+    thumbnail.pts = job.frame->metadata.pts;
+    thumbnail.captured = std::chrono::system_clock::now();
+    int width = 0;
+    int height = 0;
+    const bool scaled = ScaleFrame(*job.frame, width, height);
+    job.frame.Reset();  // Back to the pool before encoding
+    if (!scaled || !Encode(width, height, thumbnail)) {
+      failed_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+      const auto it = taps_.find(job.tap->channel_id());
+      if (it != taps_.end() && it->second.lock() == job.tap) {
+        thumbnails_[job.tap->channel_id()] = std::move(thumbnail);
+        generated_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    job.tap->busy_.store(false, std::memory_order_release);
+  }
+}
+
+bool ThumbnailGenerator::ScaleFrame(const buffer::Frame& frame, int& width, int& height) {
+  const size_t y_size = static_cast<size_t>(frame.width) * frame.height;
+  const size_t uv_size = static_cast<size_t>(frame.width / 2) * (frame.height / 2);
+  // GPU surfaces are read back first
+  const buffer::Frame* source = &frame;
+  if (frame.format == buffer::PixelFormat::kDevice) {
+    if (!decode::DownloadDeviceFrame(frame, &downloaded_)) {
+      return false;
+    }
+    source = &downloaded_;
+  }
+  decode::PlanarImage image;
+  if (frame.width < 2 || frame.height < 2 || !decode::DescribeFrame(*source, &image)) {
+    return false;
+  }
+  // The resize steps read packed I420
+  const uint8_t* src = image.planes[0];
+  if (!decode::IsPackedI420(image)) {
+    packed_.resize(y_size + 2 * uv_size);
+    decode::PackI420(image, frame.width, frame.height, packed_.data());
+    src = packed_.data();
+  }
+  const double scale = std::min({1.0, static_cast<double>(config_.max_width) / frame.width,
+                                 static_cast<double>(config_.max_height) / frame.height});
+  width = std::max(2, static_cast<int>(std::lround(frame.width * scale)) & ~1);
+  height = std::max(2, static_cast<int>(std::lround(frame.height * scale)) & ~1);
+
+  const size_t scaled_y = static_cast<size_t>(width) * height;
+  const size_t scaled_uv = scaled_y / 4;
+  scaled_.resize(scaled_y + 2 * scaled_uv);
+  ResizePlane(scaled_.data(), width, height, src, frame.width, frame.height, step_a_, step_b_);
+  ResizePlane(scaled_.data() + scaled_y, width / 2, height / 2, src + y_size, frame.width / 2,
+              frame.height / 2, step_a_, step_b_);
+  ResizePlane(scaled_.data() + scaled_y + scaled_uv, width / 2, height / 2,
+              src + y_size + uv_size, frame.width / 2, frame.height / 2, step_a_, step_b_);
+  return true;
+}
+
+bool ThumbnailGenerator::Encode(int width, int height, Thumbnail& thumbnail) {
+  thumbnail.width = width;
+  thumbnail.height = height;
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+  if (!codec) {
+    std::cerr << "[ThumbnailGenerator] No MJPEG encoder" << std::endl;
+    return false;
+  }
+  AVCodecContext* ctx = avcodec_alloc_context3(codec);
+  AVFrame* image = av_frame_alloc();
+  AVPacket* packet = av_packet_alloc();
+  bool ok = ctx && image && packet;
+  if (ok) {
+    // Limited-range 4:2:0 as decoded, flagged as such instead of converted
+    ctx->width = width;
+    ctx->height = height;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->color_range = AVCOL_RANGE_MPEG;
+    ctx->strict_std_compliance = FF_COMPLIANCE_UNOFFICIAL;
+    ctx->time_base = {1, 25};
+    ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    const int qscale = 2 + (100 - std::clamp(config_.quality, 1, 100)) * 29 / 99;
+    ctx->global_quality = FF_QP2LAMBDA * qscale;
+    ok = avcodec_open2(ctx, codec, nullptr) >= 0;
+  }
+  if (ok) {
+    const size_t y_size = static_cast<size_t>(width) * height;
+    image->format = AV_PIX_FMT_YUV420P;
+    image->width = width;
+    image->height = height;
+    image->data[0] = scaled_.data();
+    image->data[1] = scaled_.data() + y_size;
+    image->data[2] = scaled_.data() + y_size + y_size / 4;
+    image->linesize[0] = width;
+    image->linesize[1] = width / 2;
+    image->linesize[2] = width / 2;
+    image->quality = ctx->global_quality;
+    image->pts = 0;
+    ok = avcodec_send_frame(ctx, image) >= 0 && avcodec_receive_packet(ctx, packet) >= 0;
+  }
+  if (ok) {
+    thumbnail.image = std::make_shared<const std::string>(
+        reinterpret_cast<const char*>(packet->data), static_cast<size_t>(packet->size));
+    thumbnail.content_type = "image/jpeg";
+  }
+  av_packet_free(&packet);
+  av_frame_free(&image);
+  avcodec_free_context(&ctx);
+  return ok;
+#else
+  thumbnail.image = std::make_shared<const std::string>(EncodeBmp(scaled_.data(), width, height));
+  thumbnail.content_type = "image/bmp";
+  return true;
+#endif
+}
+
+}  // namespace retrovue::telemetry
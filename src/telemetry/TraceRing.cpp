@@ -0,0 +1,318 @@
+// Repository: Retrovue-playout
+// Component: Trace Ring
+// Purpose: Per-thread binary event rings for stall forensics, dumped as Chrome trace JSON.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/telemetry/TraceRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "retrovue/telemetry/MetricsHTTPServer.h"
+
+namespace retrovue::telemetry {
+
+namespace trace_internal {
+std::atomic<bool> g_enabled{false};
+}  // namespace trace_internal
+
+namespace {
+
+constexpr size_t kMinEventsPerThread = 64;
+constexpr size_t kMaxEventsPerThread = size_t{1} << 22;
+
+struct Tracer {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<TraceRing>> rings;  // This session's
+  std::atomic<uint64_t> session{0};
+  size_t capacity = 0;
+  int64_t started_ns = 0;
+};
+
+// Never destroyed: threads may record while static destructors run
+Tracer& GetTracer() {
+  static Tracer* tracer = new Tracer();
+  return *tracer;
+}
+
+thread_local std::shared_ptr<TraceRing> t_ring;
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t RoundUpPow2(size_t value) {
+  size_t pow2 = kMinEventsPerThread;
+  while (pow2 < value && pow2 < kMaxEventsPerThread) {
+    pow2 <<= 1;
+  }
+  return pow2;
+}
+
+int64_t CurrentTid() {
+#ifdef __linux__
+  return static_cast<int64_t>(syscall(SYS_gettid));
+#else
+  return static_cast<int64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()) &
+                              0x7fffffff);
+#endif
+}
+
+std::string CurrentThreadName() {
+#ifdef __linux__
+  char name[32] = {};
+  if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0 && name[0] != '\0') {
+    return name;
+  }
+#endif
+  return std::string();
+}
+
+int64_t ProcessId() {
+#ifdef _WIN32
+  return 1;
+#else
+  return static_cast<int64_t>(getpid());
+#endif
+}
+
+TraceRing* AttachRing() {
+  Tracer& tracer = GetTracer();
+  std::lock_guard<std::mutex> lock(tracer.mutex);
+  const uint64_t session = tracer.session.load(std::memory_order_relaxed);
+  const int64_t tid = CurrentTid();
+  std::string name = CurrentThreadName();
+  if (name.empty()) {
+    name = "thread " + std::to_string(tid);
+  }
+  t_ring = std::make_shared<TraceRing>(tracer.capacity, session, tid, std::move(name));
+  tracer.rings.push_back(t_ring);
+  return t_ring.get();
+}
+
+void AppendEscaped(std::string& out, const char* text) {
+  for (const char* c = text ? text : ""; *c != '\0'; ++c) {
+    const auto byte = static_cast<unsigned char>(*c);
+    if (byte == '"' || byte == '\\') {
+      out += '\\';
+      out += *c;
+    } else if (byte < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+      out += escaped;
+    } else {
+      out += *c;
+    }
+  }
+}
+
+}  // namespace
+
+TraceRing::TraceRing(size_t capacity, uint64_t session, int64_t tid, std::string thread_name)
+    : mask_(RoundUpPow2(capacity) - 1),
+      session_(session),
+      tid_(tid),
+      thread_name_(std::move(thread_name)),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+void TraceRing::Push(TraceEventType type, const char* name, int64_t value, int64_t ts_ns) {
+  const uint64_t index = head_.load(std::memory_order_relaxed);
+  Slot& slot = slots_[index & mask_];
+  slot.ts_ns.store(ts_ns, std::memory_order_relaxed);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.type.store(static_cast<uint8_t>(type), std::memory_order_relaxed);
+  head_.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceRing::Snapshot() const {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const uint64_t capacity = mask_ + 1;
+  const uint64_t first = head > capacity ? head - capacity : 0;
+  std::vector<TraceEvent> events;
+  events.reserve(static_cast<size_t>(head - first));
+  for (uint64_t index = first; index < head; ++index) {
+    const Slot& slot = slots_[index & mask_];
+    TraceEvent event;
+    // Acquire keeps the head reload below after these reads
+    event.ts_ns = slot.ts_ns.load(std::memory_order_acquire);
+    event.name = slot.name.load(std::memory_order_acquire);
+    event.value = slot.value.load(std::memory_order_acquire);
+    event.type = static_cast<TraceEventType>(slot.type.load(std::memory_order_acquire));
+    events.push_back(event);
+  }
+  // Slots the owner reused while we read hold newer events: drop them
+  const uint64_t after = head_.load(std::memory_order_relaxed);
+  const uint64_t valid_from = after > capacity ? after - capacity : 0;
+  if (valid_from > first) {
+    const size_t stale = static_cast<size_t>(std::min<uint64_t>(valid_from - first, events.size()));
+    events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(stale));
+  }
+  return events;
+}
+
+namespace trace_internal {
+
+void Record(TraceEventType type, const char* name, int64_t value) {
+  const int64_t now_ns = NowNs();
+  TraceRing* ring = t_ring.get();
+  if (!ring || ring->session() != GetTracer().session.load(std::memory_order_acquire)) {
+    ring = AttachRing();
+  }
+  ring->Push(type, name, value, now_ns);
+}
+
+}  // namespace trace_internal
+
+void StartTracing(const TraceConfig& config) {
+  Tracer& tracer = GetTracer();
+  {
+    std::lock_guard<std::mutex> lock(tracer.mutex);
+    tracer.rings.clear();
+    tracer.capacity = RoundUpPow2(config.events_per_thread);
+    tracer.started_ns = NowNs();
+    tracer.session.fetch_add(1, std::memory_order_release);
+  }
+  trace_internal::g_enabled.store(true, std::memory_order_release);
+}
+
+void StopTracing() { trace_internal::g_enabled.store(false, std::memory_order_release); }
+
+TraceStats GetTraceStats() {
+  Tracer& tracer = GetTracer();
+  TraceStats stats;
+  stats.enabled = TraceEnabled();
+  std::lock_guard<std::mutex> lock(tracer.mutex);
+  stats.threads = tracer.rings.size();
+  for (const auto& ring : tracer.rings) {
+    const uint64_t recorded = ring->recorded();
+    stats.recorded += recorded;
+    stats.overwritten += recorded > ring->capacity() ? recorded - ring->capacity() : 0;
+  }
+  return stats;
+}
+
+std::string DumpTraceJson() {
+  Tracer& tracer = GetTracer();
+  std::vector<std::shared_ptr<TraceRing>> rings;
+  int64_t started_ns = 0;
+  {
+    std::lock_guard<std::mutex> lock(tracer.mutex);
+    rings = tracer.rings;
+    started_ns = tracer.started_ns;
+  }
+
+  const std::string pid = std::to_string(ProcessId());
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  const auto open_event = [&](const char* name, char phase, int64_t tid) {
+    out += first ? "\n" : ",\n";
+    first = false;
+    out += "{\"name\":\"";
+    AppendEscaped(out, name);
+    out += "\",\"ph\":\"";
+    out += phase;
+    out += "\",\"pid\":" + pid + ",\"tid\":" + std::to_string(tid);
+  };
+
+  for (const auto& ring : rings) {
+    open_event("thread_name", 'M', ring->tid());
+    out += ",\"args\":{\"name\":\"";
+    AppendEscaped(out, ring->thread_name().c_str());
+    out += "\"}}";
+
+    int depth = 0;
+    for (const TraceEvent& event : ring->Snapshot()) {
+      char phase = 'i';
+      switch (event.type) {
+        case TraceEventType::kBegin:
+          phase = 'B';
+          ++depth;
+          break;
+        case TraceEventType::kEnd:
+          if (depth == 0) {
+            continue;  // Its begin was overwritten
+          }
+          phase = 'E';
+          --depth;
+          break;
+        case TraceEventType::kCounter:
+          phase = 'C';
+          break;
+        case TraceEventType::kInstant:
+          phase = 'i';
+          break;
+      }
+      char ts[32];
+      std::snprintf(ts, sizeof(ts), "%.3f",
+                    static_cast<double>(std::max<int64_t>(event.ts_ns - started_ns, 0)) / 1000.0);
+      open_event(event.name, phase, ring->tid());
+      out += ",\"ts\":";
+      out += ts;
+      if (event.type == TraceEventType::kCounter) {
+        out += ",\"args\":{\"value\":" + std::to_string(event.value) + "}";
+      } else if (event.type == TraceEventType::kInstant) {
+        out += ",\"s\":\"t\"";
+      }
+      out += "}";
+    }
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+bool ServeTraceHttp(const HttpRequest& request, HttpResponse& response) {
+  response.cache_control = "no-store";
+  if (request.path == "/trace/start") {
+    TraceConfig config;
+    const auto events = request.query.find("events");
+    if (events != request.query.end()) {
+      const long long value = std::atoll(events->second.c_str());
+      if (value > 0) {
+        config.events_per_thread = static_cast<size_t>(value);
+      }
+    }
+    StartTracing(config);
+    response.body = std::make_shared<const std::string>("tracing started\n");
+    return true;
+  }
+  if (request.path == "/trace/stop") {
+    StopTracing();
+    response.body = std::make_shared<const std::string>("tracing stopped\n");
+    return true;
+  }
+  if (request.path == "/trace/status") {
+    const TraceStats stats = GetTraceStats();
+    response.content_type = "application/json";
+    response.body = std::make_shared<const std::string>(
+        std::string("{\"enabled\":") + (stats.enabled ? "true" : "false") +
+        ",\"threads\":" + std::to_string(stats.threads) +
+        ",\"recorded\":" + std::to_string(stats.recorded) +
+        ",\"overwritten\":" + std::to_string(stats.overwritten) + "}\n");
+    return true;
+  }
+  if (request.path == "/trace" || request.path == "/trace/") {
+    response.content_type = "application/json";
+    response.body = std::make_shared<const std::string>(DumpTraceJson());
+    return true;
+  }
+  return false;
+}
+
+}  // namespace retrovue::telemetry
@@ -0,0 +1,69 @@
+// Repository: Retrovue-playout
+// Component: Windowed Histogram
+// Purpose: HDR histogram with lock-free recording and 1m / 5m sliding views.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/telemetry/WindowedHistogram.h"
+
+#include <algorithm>
+
+namespace retrovue::telemetry {
+
+WindowedHistogram::WindowedHistogram(int64_t highest_value, int significant_digits)
+    : origin_(Clock::now()), total_(highest_value, significant_digits) {
+  for (auto& slot : slots_) {
+    slot = std::make_unique<Slot>(highest_value, significant_digits);
+  }
+}
+
+void WindowedHistogram::RecordAt(int64_t value, Clock::time_point now) {
+  total_.Record(value);
+
+  const int64_t interval = IntervalOf(now);
+  Slot& slot = *slots_[static_cast<std::size_t>(interval) % kSlots];
+  int64_t owner = slot.interval.load(std::memory_order_acquire);
+  if (owner < interval &&
+      slot.interval.compare_exchange_strong(owner, interval, std::memory_order_acq_rel)) {
+    slot.histogram.Reset();  // Drop what is left of the slot's previous lap
+  }
+  if (slot.interval.load(std::memory_order_acquire) == interval) {
+    slot.histogram.Record(value);
+  }
+}
+
+HdrHistogram WindowedHistogram::WindowAt(std::chrono::seconds span, Clock::time_point now) const {
+  HdrHistogram window(total_.highest_value(), total_.significant_digits());
+  const int64_t current = IntervalOf(now);
+  const int64_t slots = std::clamp<int64_t>(
+      (span.count() + kSlotWidth.count() - 1) / kSlotWidth.count(), 1, kSlots - 1);
+  // The current slot is partial, so `slots` full ones behind it are included too
+  for (int64_t interval = current; interval >= 0 && interval >= current - slots; --interval) {
+    const Slot& slot = *slots_[static_cast<std::size_t>(interval) % kSlots];
+    if (slot.interval.load(std::memory_order_acquire) == interval) {
+      window.Add(slot.histogram);
+    }
+  }
+  return window;
+}
+
+HistogramViews WindowedHistogram::ViewsAt(Clock::time_point now) const {
+  HistogramViews views;
+  views.total = total_;
+  views.last_1m = WindowAt(std::chrono::minutes(1), now);
+  views.last_5m = WindowAt(std::chrono::minutes(5), now);
+  return views;
+}
+
+void WindowedHistogram::Reset() {
+  total_.Reset();
+  for (auto& slot : slots_) {
+    slot->interval.store(-1, std::memory_order_release);
+    slot->histogram.Reset();
+  }
+}
+
+int64_t WindowedHistogram::IntervalOf(Clock::time_point now) const {
+  return std::max<int64_t>(0, (now - origin_) / kSlotWidth);
+}
+
+}  // namespace retrovue::telemetry
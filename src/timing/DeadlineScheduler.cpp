@@ -0,0 +1,478 @@
+#include "retrovue/timing/DeadlineScheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "timing/PreciseWait.h"
+
+namespace retrovue::timing {
+
+namespace {
+
+constexpr int64_t kNever = std::numeric_limits<int64_t>::max();
+
+// Wheel geometry: level 0 holds one slot per tick, each higher level one
+// slot per full turn of the level below
+constexpr int kLevel0Bits = 8;
+constexpr int kLevelNBits = 6;
+constexpr size_t kLevel0Slots = size_t{1} << kLevel0Bits;
+constexpr size_t kLevelNSlots = size_t{1} << kLevelNBits;
+constexpr int64_t kLevel0Mask = kLevel0Slots - 1;
+constexpr int64_t kLevelNMask = kLevelNSlots - 1;
+constexpr int kLevel1Shift = kLevel0Bits;
+constexpr int kLevel2Shift = kLevel0Bits + kLevelNBits;
+constexpr int kOverflowShift = kLevel0Bits + 2 * kLevelNBits;
+
+// Timer ids carry their shard in the low bits
+constexpr int kShardBits = 8;
+constexpr size_t kMaxShards = size_t{1} << kShardBits;
+
+// Per-thread wake-up target of WaitUntil(); shared with the timer callback,
+// which may still be running when the waiter returns
+struct Waiter {
+  std::atomic<uint32_t> fired{0};
+};
+
+std::chrono::system_clock::time_point ToSystemTime(int64_t utc_us) {
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::microseconds(utc_us)));
+}
+
+}  // namespace
+
+struct DeadlineScheduler::Shard {
+  struct Entry {
+    int64_t deadline_us = 0;
+    Callback callback;
+  };
+
+  struct Ready {
+    int64_t deadline_us;
+    TimerId id;
+    bool operator>(const Ready& other) const {
+      return deadline_us != other.deadline_us ? deadline_us > other.deadline_us
+                                              : id > other.id;
+    }
+  };
+
+  size_t index = 0;
+  std::thread thread;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stop = false;
+  int64_t wake_at_us = kNever;      // Planned wake-up of a waiting worker
+  int64_t current_tick = 0;         // Ticks up to this one are in ready
+  uint64_t next_serial = 1;
+  int64_t sleep_overshoot_us = 0;   // Calibrated wake-up lateness of the worker
+
+  // Slots hold ids; a cancelled timer leaves its id behind, skipped when
+  // the slot is reached
+  std::array<std::vector<TimerId>, kLevel0Slots> level0;
+  std::bitset<kLevel0Slots> level0_used;
+  std::array<std::vector<TimerId>, kLevelNSlots> level1;
+  std::array<std::vector<TimerId>, kLevelNSlots> level2;
+  std::vector<TimerId> overflow;
+  std::priority_queue<Ready, std::vector<Ready>, std::greater<Ready>> ready;
+  std::unordered_map<TimerId, Entry> timers;
+
+  std::atomic<uint64_t> scheduled{0};
+  std::atomic<uint64_t> fired{0};
+  std::atomic<uint64_t> cancelled{0};
+  std::atomic<uint64_t> wakeups{0};
+  std::atomic<uint64_t> batches{0};
+  std::atomic<uint64_t> max_batch{0};
+  internal::WaitAccuracyRecorder accuracy;
+
+  // Call with mutex held.
+  void Place(TimerId id, int64_t deadline_us, int64_t tick_us) {
+    const int64_t tick = deadline_us / tick_us;
+    if (tick <= current_tick) {
+      ready.push({deadline_us, id});
+      return;
+    }
+    const int64_t delta = tick - current_tick;
+    if (delta < (int64_t{1} << kLevel1Shift)) {
+      level0[tick & kLevel0Mask].push_back(id);
+      level0_used.set(tick & kLevel0Mask);
+    } else if (delta < (int64_t{1} << kLevel2Shift)) {
+      level1[(tick >> kLevel1Shift) & kLevelNMask].push_back(id);
+    } else if (delta < (int64_t{1} << kOverflowShift)) {
+      level2[(tick >> kLevel2Shift) & kLevelNMask].push_back(id);
+    } else {
+      overflow.push_back(id);
+    }
+  }
+
+  void Cascade(std::vector<TimerId>& slot, int64_t tick_us) {
+    std::vector<TimerId> ids;
+    ids.swap(slot);
+    for (TimerId id : ids) {
+      const auto it = timers.find(id);
+      if (it != timers.end()) {
+        Place(id, it->second.deadline_us, tick_us);
+      }
+    }
+  }
+
+  // Moves every timer of the ticks up to to_tick into ready.
+  void Advance(int64_t to_tick, int64_t tick_us) {
+    if (timers.empty()) {
+      current_tick = std::max(current_tick, to_tick);
+      return;
+    }
+    while (current_tick < to_tick) {
+      const int64_t tick = ++current_tick;
+      if ((tick & kLevel0Mask) == 0) {
+        if (((tick >> kLevel1Shift) & kLevelNMask) == 0) {
+          if (((tick >> kLevel2Shift) & kLevelNMask) == 0) {
+            Cascade(overflow, tick_us);
+          }
+          Cascade(level2[(tick >> kLevel2Shift) & kLevelNMask], tick_us);
+        }
+        Cascade(level1[(tick >> kLevel1Shift) & kLevelNMask], tick_us);
+      }
+      auto& slot = level0[tick & kLevel0Mask];
+      for (TimerId id : slot) {
+        const auto it = timers.find(id);
+        if (it != timers.end()) {
+          ready.push({it->second.deadline_us, id});
+        }
+      }
+      slot.clear();
+      level0_used.reset(tick & kLevel0Mask);
+    }
+  }
+
+  // The next tick holding timers, or the next level 0 wrap (where higher
+  // levels cascade down); kNever if nothing is pending.
+  int64_t NextTick() const {
+    if (timers.empty()) {
+      return kNever;
+    }
+    const int64_t wrap = (current_tick | kLevel0Mask) + 1;
+    for (int64_t tick = current_tick + 1; tick < wrap; ++tick) {
+      if (level0_used.test(tick & kLevel0Mask)) {
+        return tick;
+      }
+    }
+    return wrap;
+  }
+
+  void PopCancelled() {
+    while (!ready.empty() && timers.find(ready.top().id) == timers.end()) {
+      ready.pop();
+    }
+  }
+};
+
+DeadlineScheduler::DeadlineScheduler(const Config& config) : config_([&config] {
+  Config c = config;
+  c.threads = std::clamp<size_t>(c.threads, 1, kMaxShards);
+  c.tick_us = std::max<int64_t>(c.tick_us, 1);
+  c.spin_us = std::max<int64_t>(c.spin_us, 0);
+  return c;
+}()) {
+  for (size_t i = 0; i < config_.threads; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+    shards_.back()->index = i;
+  }
+}
+
+DeadlineScheduler::~DeadlineScheduler() { Stop(); }
+
+bool DeadlineScheduler::Start() {
+  if (running()) {
+    return true;
+  }
+  const int64_t now_tick = internal::NowUtcUs() / config_.tick_us;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->stop = false;
+    shard->current_tick = std::max(shard->current_tick, now_tick);
+  }
+  running_.store(true, std::memory_order_release);
+  for (auto& shard : shards_) {
+    Shard& s = *shard;
+    s.thread = std::thread([this, &s] { WorkerLoop(s); });
+#ifdef __linux__
+    if (!config_.cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(config_.cpus[s.index % config_.cpus.size()], &set);
+      const int rc = pthread_setaffinity_np(s.thread.native_handle(), sizeof(set), &set);
+      if (rc != 0) {
+        std::cerr << "[DeadlineScheduler] Cannot pin worker " << s.index << " to CPU "
+                  << config_.cpus[s.index % config_.cpus.size()] << ": " << std::strerror(rc)
+                  << std::endl;
+      }
+    }
+    if (config_.priority > 0) {
+      // Needs CAP_SYS_NICE (or an rtprio limit); the workers run at normal priority otherwise
+      sched_param param{};
+      param.sched_priority = config_.priority;
+      const int rc = pthread_setschedparam(s.thread.native_handle(), SCHED_FIFO, &param);
+      if (rc != 0) {
+        std::cerr << "[DeadlineScheduler] Cannot raise worker " << s.index
+                  << " to SCHED_FIFO priority " << config_.priority << ": " << std::strerror(rc)
+                  << std::endl;
+      }
+    }
+#endif
+  }
+  return true;
+}
+
+void DeadlineScheduler::Stop() {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  for (auto& shard : shards_) {
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->stop = true;
+    }
+    shard->wake.notify_all();
+  }
+  for (auto& shard : shards_) {
+    if (shard->thread.joinable()) {
+      shard->thread.join();
+    }
+  }
+  // Fire what is left, so no caller stays blocked on a stopped scheduler
+  for (auto& shard : shards_) {
+    std::vector<Callback> left;
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      for (auto& [id, entry] : shard->timers) {
+        left.push_back(std::move(entry.callback));
+      }
+      shard->timers.clear();
+      shard->ready = {};
+      for (auto& slot : shard->level0) slot.clear();
+      for (auto& slot : shard->level1) slot.clear();
+      for (auto& slot : shard->level2) slot.clear();
+      shard->overflow.clear();
+      shard->level0_used.reset();
+    }
+    for (auto& callback : left) {
+      callback();
+    }
+    shard->fired.fetch_add(left.size(), std::memory_order_relaxed);
+  }
+}
+
+DeadlineScheduler::TimerId DeadlineScheduler::ScheduleAt(int64_t utc_us, Callback callback) {
+  if (!running()) {
+    return 0;
+  }
+  // Timers of the same tick share a shard, so they fire in one batch
+  Shard& shard = *shards_[static_cast<size_t>(std::max<int64_t>(utc_us, 0) / config_.tick_us) %
+                          shards_.size()];
+  TimerId id = 0;
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.stop) {
+      return 0;
+    }
+    if (shard.timers.empty()) {
+      // Idle wheel: catch up without walking the ticks slept through
+      shard.current_tick =
+          std::max(shard.current_tick, internal::NowUtcUs() / config_.tick_us);
+    }
+    id = (shard.next_serial++ << kShardBits) | shard.index;
+    shard.timers.emplace(id, Shard::Entry{utc_us, std::move(callback)});
+    shard.Place(id, utc_us, config_.tick_us);
+    // Wake the worker if it sleeps past this deadline's lead time
+    const int64_t lead = config_.spin_us > 0 ? config_.spin_us + shard.sleep_overshoot_us : 0;
+    notify = utc_us - lead < shard.wake_at_us;
+  }
+  shard.scheduled.fetch_add(1, std::memory_order_relaxed);
+  if (notify) {
+    shard.wake.notify_one();
+  }
+  return id;
+}
+
+bool DeadlineScheduler::Cancel(TimerId id) {
+  const size_t index = id & (kMaxShards - 1);
+  if (id == 0 || index >= shards_.size()) {
+    return false;
+  }
+  Shard& shard = *shards_[index];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.timers.erase(id) == 0) {
+    return false;
+  }
+  shard.cancelled.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void DeadlineScheduler::WaitUntil(int64_t utc_us) {
+  int64_t now = internal::NowUtcUs();
+  if (now >= utc_us) {
+    return;
+  }
+  if (!running()) {
+    internal::SleepUntilUtcUs(utc_us);
+    return;
+  }
+  thread_local const std::shared_ptr<Waiter> waiter = std::make_shared<Waiter>();
+  const uint32_t seq = waiter->fired.load(std::memory_order_relaxed) + 1;
+  // Wake early by the usual hand-off latency and spin the rest here
+  const int64_t handoff_us =
+      config_.spin_us > 0 ? handoff_us_.load(std::memory_order_relaxed) : 0;
+  const int64_t wake_utc_us = utc_us - handoff_us;
+  const bool timed = wake_utc_us > now;
+  const TimerId id = ScheduleAt(wake_utc_us, [w = waiter, seq] {
+    w->fired.store(seq, std::memory_order_release);
+    w->fired.notify_one();
+  });
+  if (id == 0) {
+    internal::SleepUntilUtcUs(utc_us);
+    return;
+  }
+  uint32_t seen = waiter->fired.load(std::memory_order_acquire);
+  while (seen != seq) {
+    waiter->fired.wait(seen, std::memory_order_acquire);
+    seen = waiter->fired.load(std::memory_order_acquire);
+  }
+  now = internal::NowUtcUs();
+  if (timed && now >= wake_utc_us) {
+    handoff_us_.store(internal::NextOvershootUs(handoff_us, now - wake_utc_us),
+                      std::memory_order_relaxed);
+  }
+  if (utc_us - now > config_.spin_us + internal::kMaxSleepOvershootUs) {
+    internal::SleepUntilUtcUs(utc_us - config_.spin_us);  // Released early by Stop()
+    now = internal::NowUtcUs();
+  }
+  if (config_.spin_us == 0) {
+    if (now < utc_us) {
+      internal::SleepUntilUtcUs(utc_us);
+    }
+    return;
+  }
+  while (now < utc_us) {
+    internal::CpuRelax();
+    now = internal::NowUtcUs();
+  }
+}
+
+void DeadlineScheduler::WorkerLoop(Shard& shard) {
+  std::vector<Callback> batch;
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  while (!shard.stop) {
+    int64_t now = internal::NowUtcUs();
+    const int64_t lead = config_.spin_us > 0 ? config_.spin_us + shard.sleep_overshoot_us : 0;
+    shard.Advance((now + lead) / config_.tick_us, config_.tick_us);
+    shard.PopCancelled();
+
+    if (!shard.ready.empty() && shard.ready.top().deadline_us <= now + lead) {
+      // Spin to the earliest deadline, then fire everything due by then
+      const int64_t target_us = shard.ready.top().deadline_us;
+      if (now < target_us) {
+        lock.unlock();
+        while (now < target_us) {
+          internal::CpuRelax();
+          now = internal::NowUtcUs();
+        }
+        lock.lock();
+      }
+      now = internal::NowUtcUs();
+      while (!shard.ready.empty() && shard.ready.top().deadline_us <= now) {
+        const Shard::Ready due = shard.ready.top();
+        shard.ready.pop();
+        const auto it = shard.timers.find(due.id);
+        if (it == shard.timers.end()) {
+          continue;  // Cancelled
+        }
+        batch.push_back(std::move(it->second.callback));
+        shard.timers.erase(it);
+        shard.accuracy.Record(now - due.deadline_us);
+      }
+      if (batch.empty()) {
+        continue;
+      }
+      lock.unlock();
+      for (auto& callback : batch) {
+        callback();
+      }
+      const uint64_t count = batch.size();
+      batch.clear();
+      shard.fired.fetch_add(count, std::memory_order_relaxed);
+      shard.batches.fetch_add(1, std::memory_order_relaxed);
+      uint64_t max = shard.max_batch.load(std::memory_order_relaxed);
+      while (count > max &&
+             !shard.max_batch.compare_exchange_weak(max, count, std::memory_order_relaxed)) {
+      }
+      lock.lock();
+      continue;
+    }
+
+    int64_t next_us = shard.ready.empty() ? kNever : shard.ready.top().deadline_us;
+    const int64_t next_tick = shard.NextTick();
+    if (next_tick != kNever) {
+      next_us = std::min(next_us, next_tick * config_.tick_us);
+    }
+    if (next_us == kNever) {
+      shard.wake_at_us = kNever;
+      shard.wake.wait(lock);
+    } else {
+      shard.wake_at_us = next_us - lead;
+      if (shard.wake.wait_until(lock, ToSystemTime(shard.wake_at_us)) ==
+          std::cv_status::timeout) {
+        shard.sleep_overshoot_us = internal::NextOvershootUs(
+            shard.sleep_overshoot_us, internal::NowUtcUs() - shard.wake_at_us);
+      }
+    }
+    shard.wake_at_us = kNever;
+    shard.wakeups.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+DeadlineSchedulerStats DeadlineScheduler::GetStats() const {
+  DeadlineSchedulerStats stats;
+  for (const auto& shard : shards_) {
+    WaitAccuracyStats accuracy;
+    shard->accuracy.Fill(accuracy);
+    stats.accuracy.waits += accuracy.waits;
+    for (size_t i = 0; i < WaitAccuracyStats::kBuckets; ++i) {
+      stats.accuracy.buckets[i] += accuracy.buckets[i];
+    }
+    stats.accuracy.late_us_sum += accuracy.late_us_sum;
+    stats.accuracy.late_us_max = std::max(stats.accuracy.late_us_max, accuracy.late_us_max);
+    stats.timers_scheduled += shard->scheduled.load(std::memory_order_relaxed);
+    stats.timers_fired += shard->fired.load(std::memory_order_relaxed);
+    stats.timers_cancelled += shard->cancelled.load(std::memory_order_relaxed);
+    stats.wakeups += shard->wakeups.load(std::memory_order_relaxed);
+    stats.batches += shard->batches.load(std::memory_order_relaxed);
+    stats.max_batch = std::max(stats.max_batch, shard->max_batch.load(std::memory_order_relaxed));
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    stats.pending += shard->timers.size();
+    stats.accuracy.sleep_overshoot_us =
+        std::max(stats.accuracy.sleep_overshoot_us, shard->sleep_overshoot_us);
+  }
+  stats.accuracy.spin_budget_us = config_.spin_us;
+  stats.handoff_us = handoff_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace retrovue::timing
@@ -0,0 +1,206 @@
+#include "retrovue/timing/DisciplinedMasterClock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+namespace retrovue::timing {
+
+namespace {
+constexpr double kMillion = 1'000'000.0;
+
+// Loop samples after a step before the loop may report locked
+constexpr uint64_t kLockSamples = 4;
+}  // namespace
+
+DisciplinedMasterClock::DisciplinedMasterClock(std::shared_ptr<MasterClock> local,
+                                               std::shared_ptr<TimeReference> reference,
+                                               const ClockDisciplineConfig& config,
+                                               int64_t epoch_utc_us, double rate_ppm)
+    : local_(std::move(local)),
+      reference_(std::move(reference)),
+      config_(config),
+      epoch_utc_us_(epoch_utc_us),
+      rate_ppm_(rate_ppm) {}
+
+DisciplinedMasterClock::~DisciplinedMasterClock() { Stop(); }
+
+bool DisciplinedMasterClock::Start() {
+  if (loop_thread_.joinable()) {
+    return true;
+  }
+  const bool measured = reference_ && Poll();
+  if (!measured) {
+    std::cerr << "[DisciplinedMasterClock] Cannot read "
+              << (reference_ ? reference_->name() : std::string("time reference"))
+              << "; following the local clock until it can" << std::endl;
+  }
+  if (reference_) {
+    {
+      std::lock_guard<std::mutex> lock(loop_mutex_);
+      stop_ = false;
+    }
+    loop_thread_ = std::thread(&DisciplinedMasterClock::LoopThread, this);
+  }
+  return measured;
+}
+
+void DisciplinedMasterClock::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(loop_mutex_);
+    stop_ = true;
+  }
+  loop_cv_.notify_all();
+  if (loop_thread_.joinable()) {
+    loop_thread_.join();
+  }
+}
+
+int64_t DisciplinedMasterClock::now_utc_us() const {
+  const int64_t local = local_->now_utc_us();
+  return local + static_cast<int64_t>(std::llround(CorrectionAt(local)));
+}
+
+double DisciplinedMasterClock::now_monotonic_s() const { return local_->now_monotonic_s(); }
+
+int64_t DisciplinedMasterClock::scheduled_to_utc_us(int64_t pts_us) const {
+  // The rate error of the local clock is corrected in now_utc_us() already
+  const long double scale = 1.0L + static_cast<long double>(rate_ppm_) / kMillion;
+  return epoch_utc_us_ +
+         static_cast<int64_t>(std::llround(static_cast<long double>(pts_us) * scale));
+}
+
+double DisciplinedMasterClock::drift_ppm() const {
+  return -frequency_ppm_.load(std::memory_order_relaxed);
+}
+
+void DisciplinedMasterClock::WaitUntilUtcUs(int64_t target_utc_us) const {
+  // The correction moves by at most max_slew_ppm during the wait, so this
+  // takes one local wait and rarely a short second one
+  while (true) {
+    const int64_t local = local_->now_utc_us();
+    const int64_t now = local + static_cast<int64_t>(std::llround(CorrectionAt(local)));
+    if (now >= target_utc_us) {
+      return;
+    }
+    local_->WaitUntilUtcUs(local + (target_utc_us - now));
+  }
+}
+
+int64_t DisciplinedMasterClock::ToSystemUtcUs(int64_t utc_us) const {
+  const int64_t local = local_->now_utc_us();
+  return local_->ToSystemUtcUs(utc_us - static_cast<int64_t>(std::llround(CorrectionAt(local))));
+}
+
+WaitAccuracyStats DisciplinedMasterClock::wait_accuracy() const {
+  return local_->wait_accuracy();
+}
+
+void DisciplinedMasterClock::AddSample(const TimeReferenceSample& sample) {
+  samples_.fetch_add(1, std::memory_order_relaxed);
+  const double correction = CorrectionAt(sample.local_utc_us);
+  const double error_us = static_cast<double>(sample.offset_us) - correction;
+
+  if (!have_sample_ || std::abs(error_us) > static_cast<double>(config_.step_threshold_us)) {
+    // Phase step: take the reference time as is; the rate estimate stays
+    if (have_sample_) {
+      std::cerr << "[DisciplinedMasterClock] Stepping " << std::llround(error_us)
+                << " us onto " << (reference_ ? reference_->name() : std::string("reference"))
+                << std::endl;
+    }
+    SetCorrection(sample.local_utc_us, static_cast<double>(sample.offset_us),
+                  frequency_ppm_.load(std::memory_order_relaxed));
+    have_sample_ = true;
+    last_local_us_ = sample.local_utc_us;
+    samples_since_step_ = 0;
+    steps_.fetch_add(1, std::memory_order_relaxed);
+    offset_us_.store(0, std::memory_order_relaxed);
+    locked_.store(false, std::memory_order_relaxed);
+    return;
+  }
+
+  const double dt_s = static_cast<double>(sample.local_utc_us - last_local_us_) / kMillion;
+  if (dt_s <= 0.0) {
+    return;  // Out of order
+  }
+  // PI controller on the phase error (us); its output is a frequency (ppm)
+  integral_ppm_ = std::clamp(integral_ppm_ + config_.ki * error_us * dt_s,
+                             -config_.max_slew_ppm, config_.max_slew_ppm);
+  const double frequency_ppm = std::clamp(integral_ppm_ + config_.kp * error_us,
+                                          -config_.max_slew_ppm, config_.max_slew_ppm);
+  SetCorrection(sample.local_utc_us, correction, frequency_ppm);
+  last_local_us_ = sample.local_utc_us;
+  ++samples_since_step_;
+
+  offset_us_.store(static_cast<int64_t>(std::llround(error_us)), std::memory_order_relaxed);
+  locked_.store(samples_since_step_ >= kLockSamples &&
+                    std::abs(error_us) <= static_cast<double>(config_.lock_threshold_us),
+                std::memory_order_relaxed);
+}
+
+ClockDisciplineStats DisciplinedMasterClock::GetStats() const {
+  ClockDisciplineStats stats;
+  stats.samples = samples_.load(std::memory_order_relaxed);
+  stats.failed_samples = failed_samples_.load(std::memory_order_relaxed);
+  stats.steps = steps_.load(std::memory_order_relaxed);
+  stats.offset_us = offset_us_.load(std::memory_order_relaxed);
+  stats.frequency_ppm = frequency_ppm_.load(std::memory_order_relaxed);
+  stats.locked = locked_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+double DisciplinedMasterClock::CorrectionAt(int64_t local_utc_us) const {
+  while (true) {
+    const uint64_t seq = correction_seq_.load(std::memory_order_acquire);
+    if (seq & 1) {
+      continue;  // Being updated
+    }
+    const int64_t base_local = base_local_us_.load(std::memory_order_relaxed);
+    const double base = base_correction_us_.load(std::memory_order_relaxed);
+    const double frequency = frequency_ppm_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (correction_seq_.load(std::memory_order_relaxed) == seq) {
+      return base + frequency * static_cast<double>(local_utc_us - base_local) / kMillion;
+    }
+  }
+}
+
+void DisciplinedMasterClock::SetCorrection(int64_t base_local_us, double base_us,
+                                           double frequency_ppm) {
+  const uint64_t seq = correction_seq_.load(std::memory_order_relaxed);
+  correction_seq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  base_local_us_.store(base_local_us, std::memory_order_relaxed);
+  base_correction_us_.store(base_us, std::memory_order_relaxed);
+  frequency_ppm_.store(frequency_ppm, std::memory_order_relaxed);
+  correction_seq_.store(seq + 2, std::memory_order_release);
+}
+
+void DisciplinedMasterClock::LoopThread() {
+  std::unique_lock<std::mutex> lock(loop_mutex_);
+  while (!stop_) {
+    loop_cv_.wait_for(lock, std::chrono::milliseconds(config_.poll_interval_ms),
+                      [this] { return stop_; });
+    if (stop_) {
+      break;
+    }
+    lock.unlock();
+    Poll();
+    lock.lock();
+  }
+}
+
+bool DisciplinedMasterClock::Poll() {
+  TimeReferenceSample sample;
+  if (!reference_->Measure(sample)) {
+    failed_samples_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  AddSample(sample);
+  return true;
+}
+
+}  // namespace retrovue::timing
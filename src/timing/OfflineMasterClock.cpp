@@ -0,0 +1,49 @@
+// Repository: Retrovue-playout
+// Component: Offline Master Clock
+// Purpose: Virtual time that advances to each wait's target, for faster-than-realtime runs.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <atomic>
+#include <memory>
+
+namespace retrovue::timing {
+
+namespace {
+
+class OfflineMasterClock : public MasterClock {
+ public:
+  explicit OfflineMasterClock(int64_t epoch_utc_us)
+      : epoch_utc_us_(epoch_utc_us), now_utc_us_(epoch_utc_us) {}
+
+  int64_t now_utc_us() const override { return now_utc_us_.load(std::memory_order_acquire); }
+
+  double now_monotonic_s() const override {
+    return static_cast<double>(now_utc_us() - epoch_utc_us_) / 1'000'000.0;
+  }
+
+  int64_t scheduled_to_utc_us(int64_t pts_us) const override { return epoch_utc_us_ + pts_us; }
+
+  double drift_ppm() const override { return 0.0; }
+
+  void WaitUntilUtcUs(int64_t target_utc_us) const override {
+    int64_t now = now_utc_us_.load(std::memory_order_relaxed);
+    while (now < target_utc_us &&
+           !now_utc_us_.compare_exchange_weak(now, target_utc_us, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+    }
+  }
+
+ private:
+  const int64_t epoch_utc_us_;
+  mutable std::atomic<int64_t> now_utc_us_;
+};
+
+}  // namespace
+
+std::shared_ptr<MasterClock> MakeOfflineMasterClock(int64_t epoch_utc_us) {
+  return std::make_shared<OfflineMasterClock>(epoch_utc_us);
+}
+
+}  // namespace retrovue::timing
@@ -0,0 +1,106 @@
+#ifndef RETROVUE_TIMING_PRECISE_WAIT_H_
+#define RETROVUE_TIMING_PRECISE_WAIT_H_
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#endif
+
+namespace retrovue::timing::internal {
+
+// Wall-clock time in microseconds since the Unix epoch (the MasterClock
+// UTC timeline).
+inline int64_t NowUtcUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Sleeps until the wall clock reaches utc_us.
+inline void SleepUntilUtcUs(int64_t utc_us) {
+#ifdef _WIN32
+  std::this_thread::sleep_until(std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::microseconds(utc_us))));
+#else
+  // Absolute deadline: no drift from repeated relative sleeps, and a wall
+  // clock step moves the wake-up with it
+  struct timespec deadline;
+  deadline.tv_sec = static_cast<time_t>(utc_us / 1'000'000);
+  deadline.tv_nsec = static_cast<long>((utc_us % 1'000'000) * 1'000);
+  while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+  }
+#endif
+}
+
+// Pause hint for busy-wait loops.
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Bound on a calibrated sleep lateness, so one long stall (suspend, heavy
+// preemption) cannot turn later waits into long spins.
+constexpr int64_t kMaxSleepOvershootUs = 2'000;
+
+// Moving average (1/8) of sleep wake-up lateness.
+inline int64_t NextOvershootUs(int64_t estimate_us, int64_t late_us) {
+  if (late_us < 0) {
+    late_us = 0;
+  } else if (late_us > kMaxSleepOvershootUs) {
+    late_us = kMaxSleepOvershootUs;
+  }
+  return estimate_us + (late_us - estimate_us) / 8;
+}
+
+// WaitAccuracyRecorder accumulates a WaitAccuracyStats histogram from any
+// number of threads.
+class WaitAccuracyRecorder {
+ public:
+  void Record(int64_t late_us) {
+    size_t bucket = 0;
+    while (bucket < WaitAccuracyStats::kBucketUpperUs.size() &&
+           late_us > WaitAccuracyStats::kBucketUpperUs[bucket]) {
+      ++bucket;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    waits_.fetch_add(1, std::memory_order_relaxed);
+    late_us_sum_.fetch_add(late_us, std::memory_order_relaxed);
+    int64_t max = late_us_max_.load(std::memory_order_relaxed);
+    while (late_us > max &&
+           !late_us_max_.compare_exchange_weak(max, late_us, std::memory_order_relaxed)) {
+    }
+  }
+
+  // Fills the histogram fields of stats.
+  void Fill(WaitAccuracyStats& stats) const {
+    stats.waits = waits_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < WaitAccuracyStats::kBuckets; ++i) {
+      stats.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    stats.late_us_sum = late_us_sum_.load(std::memory_order_relaxed);
+    stats.late_us_max = late_us_max_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> waits_{0};
+  std::array<std::atomic<uint64_t>, WaitAccuracyStats::kBuckets> buckets_{};
+  std::atomic<int64_t> late_us_sum_{0};
+  std::atomic<int64_t> late_us_max_{0};
+};
+
+}  // namespace retrovue::timing::internal
+
+#endif  // RETROVUE_TIMING_PRECISE_WAIT_H_
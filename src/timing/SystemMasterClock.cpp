@@ -1,26 +1,35 @@
 #include "retrovue/timing/MasterClock.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <memory>
 #include <thread>
+#include <utility>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+#include "retrovue/timing/DeadlineScheduler.h"
+#include "timing/PreciseWait.h"
+
 namespace retrovue::timing {
 
 namespace {
 constexpr double kMillion = 1'000'000.0;
-}
+}  // namespace
 
 class SystemMasterClock : public MasterClock {
  public:
-  SystemMasterClock(int64_t epoch_utc_us, double rate_ppm)
+  SystemMasterClock(int64_t epoch_utc_us, double rate_ppm, int64_t wait_spin_us,
+                    std::shared_ptr<DeadlineScheduler> scheduler)
       : epoch_utc_us_(epoch_utc_us),
         rate_ppm_(rate_ppm),
-        drift_ppm_(0.0) {
+        drift_ppm_(0.0),
+        wait_spin_us_(std::max<int64_t>(wait_spin_us, 0)),
+        scheduler_(std::move(scheduler)) {
 #ifdef _WIN32
     LARGE_INTEGER freq;
     QueryPerformanceFrequency(&freq);
@@ -65,17 +74,39 @@ class SystemMasterClock : public MasterClock {
   double drift_ppm() const override { return drift_ppm_; }
 
   void WaitUntilUtcUs(int64_t target_utc_us) const override {
-    while (true) {
-      const int64_t now = now_utc_us();
-      const int64_t remaining = target_utc_us - now;
-      if (remaining <= 0) {
-        break;
-      }
-      // Sleep in chunks to allow for responsive wake-up
-      const int64_t sleep_us = (remaining > 2'000) ? remaining - 1'000
-                                                    : std::max<int64_t>(remaining / 2, 200);
-      std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+    if (now_utc_us() >= target_utc_us) {
+      return;  // Already due: not a wait, not measured
+    }
+    if (scheduler_ && scheduler_->running()) {
+      scheduler_->WaitUntil(target_utc_us);
+      RecordWake(now_utc_us() - target_utc_us);
+      return;
+    }
+    // Sleep to just before the spin window, allowing for the usual wake-up
+    // lateness; then spin to the deadline
+    const int64_t overshoot_us = sleep_overshoot_us_.load(std::memory_order_relaxed);
+    const int64_t wake_utc_us =
+        target_utc_us - (wait_spin_us_ > 0 ? wait_spin_us_ + overshoot_us : 0);
+    if (now_utc_us() < wake_utc_us) {
+      internal::SleepUntilUtcUs(wake_utc_us);
+      sleep_overshoot_us_.store(
+          internal::NextOvershootUs(overshoot_us, now_utc_us() - wake_utc_us),
+          std::memory_order_relaxed);
+    }
+    int64_t now = now_utc_us();
+    while (now < target_utc_us) {
+      internal::CpuRelax();
+      now = now_utc_us();
     }
+    RecordWake(now - target_utc_us);
+  }
+
+  WaitAccuracyStats wait_accuracy() const override {
+    WaitAccuracyStats stats;
+    accuracy_.Fill(stats);
+    stats.spin_budget_us = wait_spin_us_;
+    stats.sleep_overshoot_us = sleep_overshoot_us_.load(std::memory_order_relaxed);
+    return stats;
   }
 
   void set_drift_ppm(double ppm) { drift_ppm_ = ppm; }
@@ -83,9 +114,17 @@ class SystemMasterClock : public MasterClock {
   void set_epoch_utc_us(int64_t epoch_utc_us) { epoch_utc_us_ = epoch_utc_us; }
 
  private:
+  void RecordWake(int64_t late_us) const { accuracy_.Record(late_us); }
+
   int64_t epoch_utc_us_;
   double rate_ppm_;
   double drift_ppm_;
+  const int64_t wait_spin_us_;
+  const std::shared_ptr<DeadlineScheduler> scheduler_;  // Optional shared waits
+
+  // Wait calibration and accuracy (any waiting thread)
+  mutable std::atomic<int64_t> sleep_overshoot_us_{0};
+  mutable internal::WaitAccuracyRecorder accuracy_;
 #ifdef _WIN32
   double qpc_frequency_inv_;
   int64_t qpc_origin_;
@@ -94,9 +133,11 @@ class SystemMasterClock : public MasterClock {
 #endif
 };
 
-std::shared_ptr<MasterClock> MakeSystemMasterClock(int64_t epoch_utc_us,
-                                                   double rate_ppm) {
-  return std::make_shared<SystemMasterClock>(epoch_utc_us, rate_ppm);
+std::shared_ptr<MasterClock> MakeSystemMasterClock(int64_t epoch_utc_us, double rate_ppm,
+                                                   int64_t wait_spin_us,
+                                                   std::shared_ptr<DeadlineScheduler> scheduler) {
+  return std::make_shared<SystemMasterClock>(epoch_utc_us, rate_ppm, wait_spin_us,
+                                             std::move(scheduler));
 }
 
 }  // namespace retrovue::timing
@@ -0,0 +1,161 @@
+#include "retrovue/timing/TimeReference.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace retrovue::timing {
+
+namespace {
+
+#ifdef __linux__
+// Dynamic POSIX clock of an open PHC device (FD_TO_CLOCKID in the kernel's
+// testptp.c)
+clockid_t FdToClockId(int fd) { return static_cast<clockid_t>((~fd << 3) | 3); }
+
+int64_t TimespecToNs(const struct timespec& ts) {
+  return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+class PhcTimeReference : public TimeReference {
+ public:
+  static constexpr int kReads = 5;
+
+  PhcTimeReference(std::string device, int fd, int64_t tai_offset_s)
+      : device_(std::move(device)), fd_(fd), tai_offset_ns_(tai_offset_s * 1'000'000'000) {}
+
+  ~PhcTimeReference() override { ::close(fd_); }
+
+  bool Measure(TimeReferenceSample& sample) override {
+    const clockid_t phc = FdToClockId(fd_);
+    int64_t best_width = std::numeric_limits<int64_t>::max();
+    for (int i = 0; i < kReads; ++i) {
+      struct timespec before, ref, after;
+      if (clock_gettime(CLOCK_REALTIME, &before) != 0 || clock_gettime(phc, &ref) != 0 ||
+          clock_gettime(CLOCK_REALTIME, &after) != 0) {
+        std::cerr << "[PhcTimeReference] Cannot read " << device_ << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+      }
+      // The PHC read falls between the two local reads; the narrowest
+      // bracket has the least uncertainty
+      const int64_t width = TimespecToNs(after) - TimespecToNs(before);
+      if (width < best_width) {
+        best_width = width;
+        const int64_t local_ns = TimespecToNs(before) + width / 2;
+        sample.local_utc_us = local_ns / 1'000;
+        sample.offset_us = (TimespecToNs(ref) - tai_offset_ns_ - local_ns) / 1'000;
+      }
+    }
+    return true;
+  }
+
+  std::string name() const override { return "phc:" + device_; }
+
+ private:
+  const std::string device_;
+  const int fd_;
+  const int64_t tai_offset_ns_;
+};
+#endif
+
+class ChronyTimeReference : public TimeReference {
+ public:
+  static constexpr size_t kSystemTimeField = 4;
+
+  explicit ChronyTimeReference(std::string command) : command_(std::move(command)) {}
+
+  bool Measure(TimeReferenceSample& sample) override {
+#ifdef _WIN32
+    (void)sample;
+    return false;
+#else
+    FILE* pipe = ::popen(command_.c_str(), "r");
+    if (pipe == nullptr) {
+      std::cerr << "[ChronyTimeReference] Cannot run '" << command_ << "'" << std::endl;
+      return false;
+    }
+    char line[512] = {};
+    const bool read = std::fgets(line, sizeof(line), pipe) != nullptr;
+    const int status = ::pclose(pipe);
+    if (!read || status != 0) {
+      return false;
+    }
+    // CSV: ref id, name, stratum, ref time, system time, ...
+    std::vector<std::string> fields;
+    std::stringstream csv(line);
+    std::string field;
+    while (std::getline(csv, field, ',')) {
+      fields.push_back(field);
+    }
+    if (fields.size() <= kSystemTimeField) {
+      return false;
+    }
+    char* end = nullptr;
+    const double seconds = std::strtod(fields[kSystemTimeField].c_str(), &end);
+    if (end == fields[kSystemTimeField].c_str() || !std::isfinite(seconds)) {
+      return false;
+    }
+    // chronyd reports the correction it still has to apply: positive means
+    // the local clock is slow of NTP time
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    sample.local_utc_us = TimespecToUs(now);
+    sample.offset_us = static_cast<int64_t>(std::llround(seconds * 1'000'000.0));
+    return true;
+#endif
+  }
+
+  std::string name() const override { return "chrony"; }
+
+ private:
+#ifndef _WIN32
+  static int64_t TimespecToUs(const struct timespec& ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000 + ts.tv_nsec / 1'000;
+  }
+#endif
+
+  const std::string command_;
+};
+
+}  // namespace
+
+std::shared_ptr<TimeReference> MakePhcTimeReference(const std::string& device,
+                                                    int64_t tai_offset_s) {
+#ifdef __linux__
+  const int fd = ::open(device.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "[PhcTimeReference] Cannot open " << device << ": " << std::strerror(errno)
+              << std::endl;
+    return nullptr;
+  }
+  return std::make_shared<PhcTimeReference>(device, fd, tai_offset_s);
+#else
+  (void)tai_offset_s;
+  std::cerr << "[PhcTimeReference] PTP hardware clocks need Linux (" << device << ")"
+            << std::endl;
+  return nullptr;
+#endif
+}
+
+std::shared_ptr<TimeReference> MakeChronyTimeReference(const std::string& command) {
+  return std::make_shared<ChronyTimeReference>(command);
+}
+
+}  // namespace retrovue::timing
@@ -0,0 +1,52 @@
+// Repository: Retrovue-playout
+// Component: Timeline Master Clock
+// Purpose: A MasterClock whose PTS timeline starts at a given UTC time.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/timing/MasterClock.h"
+
+#include <memory>
+#include <utility>
+
+namespace retrovue::timing {
+
+namespace {
+
+class TimelineMasterClock : public MasterClock {
+ public:
+  TimelineMasterClock(std::shared_ptr<MasterClock> clock, int64_t origin_utc_us)
+      : clock_(std::move(clock)), shift_us_(origin_utc_us - clock_->scheduled_to_utc_us(0)) {}
+
+  int64_t now_utc_us() const override { return clock_->now_utc_us(); }
+
+  double now_monotonic_s() const override { return clock_->now_monotonic_s(); }
+
+  int64_t scheduled_to_utc_us(int64_t pts_us) const override {
+    return clock_->scheduled_to_utc_us(pts_us) + shift_us_;
+  }
+
+  double drift_ppm() const override { return clock_->drift_ppm(); }
+
+  bool is_fake() const override { return clock_->is_fake(); }
+
+  void WaitUntilUtcUs(int64_t target_utc_us) const override {
+    clock_->WaitUntilUtcUs(target_utc_us);
+  }
+
+  WaitAccuracyStats wait_accuracy() const override { return clock_->wait_accuracy(); }
+
+  int64_t ToSystemUtcUs(int64_t utc_us) const override { return clock_->ToSystemUtcUs(utc_us); }
+
+ private:
+  const std::shared_ptr<MasterClock> clock_;
+  const int64_t shift_us_;  // Added to clock_'s deadlines
+};
+
+}  // namespace
+
+std::shared_ptr<MasterClock> MakeTimelineMasterClock(std::shared_ptr<MasterClock> clock,
+                                                     int64_t origin_utc_us) {
+  return std::make_shared<TimelineMasterClock>(std::move(clock), origin_utc_us);
+}
+
+}  // namespace retrovue::timing
@@ -23,7 +23,9 @@ std::map<std::string, std::vector<std::string>> ExpectedCoverage()
         "MC-003",
         "MC-004",
         "MC-005",
-        "MC-006"}},
+        "MC-006",
+        "MC-007",
+        "MC-008"}},
       {"MetricsAndTiming",
        {"MT-001",
         "MT-002",
@@ -36,14 +38,26 @@ std::map<std::string, std::vector<std::string>> ExpectedCoverage()
       {"MetricsExport",
        {"MET-001",
         "MET-002",
-        "MET-003"}},
+        "MET-003",
+        "MET-004",
+        "MET-005",
+        "MET-006",
+        "MET-007"}},
       {"PlayoutEngine",
        {"BC-001",
         "BC-002",
         "BC-003",
         "BC-004",
         "BC-005",
-        "BC-006"}},
+        "BC-006",
+        "BC-008",
+        "BC-009",
+        "BC-010",
+        "BC-011",
+        "BC-012",
+        "BC-013",
+        "BC-015",
+        "BC-016"}},
       {"Renderer",
        {"FE-001",
         "FE-002",
@@ -62,7 +76,8 @@ std::map<std::string, std::vector<std::string>> ExpectedCoverage()
         "FE-009",
         "FE-010",
         "FE-011",
-        "FE-012"}}};
+        "FE-012",
+        "FE-013"}}};
 }
 
 TEST(ContractRegistry, AllRulesCovered)
@@ -2,13 +2,24 @@
 #include "../ContractRegistryEnvironment.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <deque>
+#include <filesystem>
+#include <memory>
 #include <numeric>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
 
+#include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/renderer/FrameRenderer.h"
+#include "retrovue/renderer/Y4mFileSink.h"
+#include "retrovue/timing/DisciplinedMasterClock.h"
+#include "retrovue/timing/MasterClock.h"
+#include "timing/TestMasterClock.h"
+
 namespace retrovue::tests
 {
   namespace
@@ -226,7 +237,7 @@ namespace retrovue::tests
     {
       RegisterExpectedDomainCoverage(
           "MasterClock",
-          {"MC-001", "MC-002", "MC-003", "MC-004", "MC-005", "MC-006"});
+          {"MC-001", "MC-002", "MC-003", "MC-004", "MC-005", "MC-006", "MC-007", "MC-008"});
       return true;
     }();
 
@@ -246,7 +257,9 @@ namespace retrovue::tests
             "MC-003",
             "MC-004",
             "MC-005",
-            "MC-006"};
+            "MC-006",
+            "MC-007",
+            "MC-008"};
       }
     };
 
@@ -416,5 +429,133 @@ namespace retrovue::tests
           << "Telemetry should reflect latest state after large-gap handling";
     }
 
+    // Rule: MC-007 Reference discipline (MasterClockDomainContract.md §MC_007)
+    TEST_F(MasterClockContractTest, MC_007_DisciplinedClockTracksReference)
+    {
+      SCOPED_TRACE("MC-007: a disciplined clock must converge onto its reference");
+
+      // Local clock 50 ppm fast and 3 ms behind the reference at the start
+      constexpr double kLocalFastPpm = 50.0;
+      const int64_t start = 1'700'000'000'000'000;
+      auto reference_at = [&](int64_t local_us)
+      {
+        const double elapsed = static_cast<double>(local_us - start);
+        return start + 3'000 + static_cast<int64_t>(std::llround(elapsed * (1.0 - kLocalFastPpm / 1e6)));
+      };
+
+      auto local = std::make_shared<retrovue::timing::TestMasterClock>(
+          start, retrovue::timing::TestMasterClock::Mode::Deterministic);
+      retrovue::timing::DisciplinedMasterClock clock(local, nullptr, {});
+
+      int64_t last_now = 0;
+      for (int i = 0; i <= 600; ++i)
+      {
+        const int64_t local_us = start + static_cast<int64_t>(i) * 1'000'000;
+        local->set_time_us(local_us);
+        clock.AddSample({local_us, reference_at(local_us) - local_us});
+        const int64_t now = clock.now_utc_us();
+        if (i > 0)
+        {
+          ASSERT_GT(now, last_now) << "Slewing must keep now_utc_us() monotonic";
+        }
+        last_now = now;
+      }
+
+      auto stats = clock.GetStats();
+      EXPECT_EQ(stats.samples, 601u);
+      EXPECT_EQ(stats.steps, 1u) << "Only the first sample steps";
+      EXPECT_TRUE(stats.locked);
+      EXPECT_LE(std::abs(stats.offset_us), 5);
+      EXPECT_NEAR(clock.drift_ppm(), kLocalFastPpm, 0.5);
+      EXPECT_NEAR(static_cast<double>(clock.now_utc_us()),
+                  static_cast<double>(reference_at(local->now_utc_us())), 5.0);
+      EXPECT_EQ(clock.scheduled_to_utc_us(1'000'000), 1'000'000)
+          << "Drift is corrected in now_utc_us(), not in the PTS mapping";
+
+      // A reference jump beyond the step threshold is stepped, not slewed
+      const int64_t local_us = start + 601'000'000;
+      clock.AddSample({local_us, reference_at(local_us) + 1'000'000 - local_us});
+      stats = clock.GetStats();
+      EXPECT_EQ(stats.steps, 2u);
+      EXPECT_FALSE(stats.locked);
+      local->set_time_us(local_us);
+      EXPECT_NEAR(static_cast<double>(clock.now_utc_us()),
+                  static_cast<double>(reference_at(local_us) + 1'000'000), 5.0);
+    }
+
+    // Rule: MC-008 Offline time (MasterClockDomainContract.md §MC_008)
+    TEST_F(MasterClockContractTest, MC_008_OfflineClockRendersFasterThanRealTime)
+    {
+      SCOPED_TRACE("MC-008: offline time must advance only to what waits ask for");
+
+      const int64_t epoch = 1'700'000'000'000'000;
+      auto clock = retrovue::timing::MakeOfflineMasterClock(epoch);
+      EXPECT_FALSE(clock->is_fake()) << "Consumers must wait on the clock, not sleep";
+      EXPECT_EQ(clock->now_utc_us(), epoch);
+      EXPECT_EQ(clock->scheduled_to_utc_us(1'000'000), epoch + 1'000'000);
+      clock->WaitUntilUtcUs(epoch + 40'000);
+      EXPECT_EQ(clock->now_utc_us(), epoch + 40'000);
+      clock->WaitUntilUtcUs(epoch + 10'000);
+      EXPECT_EQ(clock->now_utc_us(), epoch + 40'000) << "An earlier target must not move time back";
+
+      // 10 s of 30 fps frames, rendered to a file on a fresh offline clock
+      constexpr int kFrames = 300;
+      constexpr int64_t kFrameUs = 33'333;
+      constexpr int kWidth = 64;
+      constexpr int kHeight = 36;
+      clock = retrovue::timing::MakeOfflineMasterClock(epoch);
+      retrovue::buffer::FrameRingBuffer buffer(kFrames + 1);
+      for (int i = 0; i < kFrames; ++i)
+      {
+        retrovue::buffer::Frame frame;
+        frame.metadata.pts = i * kFrameUs;
+        frame.metadata.dts = frame.metadata.pts;
+        frame.metadata.duration = 1.0 / 30.0;
+        frame.width = kWidth;
+        frame.height = kHeight;
+        frame.data.assign(kWidth * kHeight * 3 / 2, static_cast<uint8_t>(i));
+        ASSERT_TRUE(buffer.Push(frame));
+      }
+
+      const std::filesystem::path path =
+          std::filesystem::temp_directory_path() / "retrovue_mc008_offline.y4m";
+      auto sink = std::make_shared<retrovue::renderer::Y4mFileSink>(path.string());
+      retrovue::renderer::RenderConfig config;
+      config.mode = retrovue::renderer::RenderMode::SINK;
+      config.sink = sink;
+      std::shared_ptr<retrovue::telemetry::MetricsExporter> metrics;
+      auto renderer = retrovue::renderer::FrameRenderer::Create(config, buffer, clock, metrics,
+                                                                /*channel_id=*/0);
+      const auto started = std::chrono::steady_clock::now();
+      ASSERT_TRUE(renderer->Start());
+      while (buffer.Size() > 0 &&
+             std::chrono::steady_clock::now() - started < std::chrono::seconds(5))
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      // The last frame popped is written before the renderer sees the stop
+      while (sink->GetStats().frames_written < static_cast<uint64_t>(kFrames) &&
+             std::chrono::steady_clock::now() - started < std::chrono::seconds(5))
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      renderer->Stop();
+      const auto elapsed = std::chrono::steady_clock::now() - started;
+
+      EXPECT_LT(elapsed, std::chrono::seconds(5)) << "10 s of frames must not take real time";
+      EXPECT_EQ(renderer->GetStats().frames_dropped, 0u);
+      EXPECT_EQ(renderer->GetTimingStats().pacing_error_us.Max(), 0)
+          << "Every frame must be presented exactly at its deadline";
+      EXPECT_EQ(clock->now_utc_us(), epoch + (kFrames - 1) * kFrameUs);
+
+      const retrovue::renderer::Y4mFileSinkStats stats = sink->GetStats();
+      EXPECT_EQ(stats.frames_written, static_cast<uint64_t>(kFrames));
+      EXPECT_FALSE(stats.write_failed);
+      const uint64_t frame_bytes = 6 + kWidth * kHeight * 3 / 2;  // "FRAME\n" and the planes
+      ASSERT_GT(stats.bytes_written, kFrames * frame_bytes);
+      EXPECT_EQ(std::filesystem::file_size(path), stats.bytes_written);
+      std::filesystem::remove(path);
+    }
+
   } // namespace
 } // namespace retrovue::tests
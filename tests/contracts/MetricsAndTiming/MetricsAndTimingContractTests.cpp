@@ -4,8 +4,10 @@
 #include "../ContractRegistryEnvironment.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <mutex>
 #include <numeric>
 #include <thread>
 #include <vector>
@@ -13,6 +15,8 @@
 #include "retrovue/buffer/FrameRingBuffer.h"
 #include "retrovue/decode/FrameProducer.h"
 #include "retrovue/renderer/FrameRenderer.h"
+#include "retrovue/runtime/TaskExecutor.h"
+#include "retrovue/timing/DeadlineScheduler.h"
 #include "timing/TestMasterClock.h"
 #include "../../fixtures/ChannelManagerStub.h"
 #include "../../fixtures/MasterClockStub.h"
@@ -44,7 +48,7 @@ namespace
       frame.metadata.dts = pts_counter;
       frame.metadata.duration =
           static_cast<double>(pts_step_us) / 1'000'000.0;
-      frame.metadata.asset_uri = "contract://metrics/stub_cadence";
+      frame.metadata.asset_id = buffer::InternAsset("contract://metrics/stub_cadence");
       frame.width = 1920;
       frame.height = 1080;
 
@@ -576,4 +580,190 @@ namespace
     EXPECT_GT(runtime_clock->now_utc_us(), 0);
   }
 
+  // Rule: MT-008 Runtime clock deadline waits (MetricsAndTimingContract.md §MT-008)
+  TEST_F(MetricsAndTimingContractTest, MT_008_SystemClockWaitsReportAccuracy)
+  {
+    auto clock = retrovue::timing::MakeSystemMasterClock(0, 0.0, /*wait_spin_us=*/100);
+    constexpr int kWaits = 50;
+    for (int i = 0; i < kWaits; ++i)
+    {
+      const int64_t target = clock->now_utc_us() + 2'000;
+      clock->WaitUntilUtcUs(target);
+      ASSERT_GE(clock->now_utc_us(), target);
+    }
+    clock->WaitUntilUtcUs(clock->now_utc_us() - 1);  // Already due: not counted
+
+    const retrovue::timing::WaitAccuracyStats stats = clock->wait_accuracy();
+    EXPECT_EQ(stats.waits, static_cast<uint64_t>(kWaits));
+    EXPECT_EQ(std::accumulate(stats.buckets.begin(), stats.buckets.end(), uint64_t{0}),
+              stats.waits);
+    EXPECT_EQ(stats.spin_budget_us, 100);
+    EXPECT_GE(stats.late_us_sum, stats.late_us_max);
+    // Most waits end within a millisecond even on a busy test host
+    const uint64_t within_ms =
+        std::accumulate(stats.buckets.begin(), stats.buckets.end() - 1, uint64_t{0});
+    EXPECT_GE(within_ms * 10, stats.waits * 8);
+
+    auto test_clock = std::make_shared<retrovue::timing::TestMasterClock>();
+    EXPECT_EQ(test_clock->wait_accuracy().waits, 0u);
+  }
+
+  // Rule: MT-008 Shared deadline scheduler (MetricsAndTimingContract.md §MT-008)
+  TEST_F(MetricsAndTimingContractTest, MT_008_SharedDeadlineSchedulerWakesWaiters)
+  {
+    retrovue::timing::DeadlineScheduler::Config config;
+    config.threads = 2;
+    config.spin_us = 100;
+    auto scheduler = std::make_shared<retrovue::timing::DeadlineScheduler>(config);
+    ASSERT_TRUE(scheduler->Start());
+    auto clock =
+        retrovue::timing::MakeSystemMasterClock(0, 0.0, /*wait_spin_us=*/100, scheduler);
+
+    // Several "channels" waiting on the same frame deadlines
+    constexpr int kChannels = 4;
+    constexpr int kFrames = 20;
+    const int64_t start = clock->now_utc_us() + 5'000;
+    std::atomic<int> early{0};
+    std::vector<std::thread> channels;
+    for (int c = 0; c < kChannels; ++c)
+    {
+      channels.emplace_back([&] {
+        for (int f = 0; f < kFrames; ++f)
+        {
+          const int64_t target = start + f * 2'000;
+          clock->WaitUntilUtcUs(target);
+          if (clock->now_utc_us() < target) early.fetch_add(1);
+        }
+      });
+    }
+    for (auto& channel : channels) channel.join();
+    EXPECT_EQ(early.load(), 0);
+
+    // Timers fire in deadline order; cancelled ones never do; far ones wait
+    std::vector<int> order;
+    std::mutex order_mutex;
+    const int64_t now = clock->now_utc_us();
+    for (int i : {3, 1, 2})
+    {
+      scheduler->ScheduleAt(now + i * 3'000, [&, i] {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(i);
+      });
+    }
+    std::atomic<bool> cancelled_ran{false};
+    const auto cancelled = scheduler->ScheduleAt(now + 2'000, [&] { cancelled_ran = true; });
+    EXPECT_TRUE(scheduler->Cancel(cancelled));
+    EXPECT_FALSE(scheduler->Cancel(cancelled));
+    std::atomic<bool> far_ran{false};
+    scheduler->ScheduleAt(now + 600'000'000, [&] { far_ran = true; });  // Overflow list
+    clock->WaitUntilUtcUs(now + 15'000);
+
+    {
+      std::lock_guard<std::mutex> lock(order_mutex);
+      EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+    }
+    EXPECT_FALSE(cancelled_ran.load());
+    EXPECT_FALSE(far_ran.load());
+
+    const auto stats = scheduler->GetStats();
+    EXPECT_EQ(stats.pending, 1u);
+    EXPECT_EQ(stats.timers_cancelled, 1u);
+    EXPECT_EQ(stats.timers_fired + stats.timers_cancelled + stats.pending,
+              stats.timers_scheduled);
+    EXPECT_EQ(stats.accuracy.waits, stats.timers_fired);
+    EXPECT_LE(stats.batches, stats.timers_fired);
+    // A channel running behind finds some deadlines already due (not waits)
+    EXPECT_GT(clock->wait_accuracy().waits, 0u);
+    EXPECT_LE(clock->wait_accuracy().waits, static_cast<uint64_t>(kChannels * kFrames + 1));
+
+    // Stop releases what is still pending
+    scheduler->Stop();
+    EXPECT_TRUE(far_ran.load());
+    EXPECT_EQ(scheduler->ScheduleAt(now, [] {}), 0u);
+    const int64_t target = clock->now_utc_us() + 1'000;
+    clock->WaitUntilUtcUs(target);  // Own wait again
+    EXPECT_GE(clock->now_utc_us(), target);
+  }
+
+  // Rule: MT-008 Shared component executor (MetricsAndTimingContract.md §MT-008)
+  TEST_F(MetricsAndTimingContractTest, MT_008_SharedExecutorRunsChannelComponents)
+  {
+    retrovue::timing::DeadlineScheduler::Config timer_config;
+    auto scheduler = std::make_shared<retrovue::timing::DeadlineScheduler>(timer_config);
+    runtime::TaskExecutor::Config executor_config;
+    executor_config.workers = 2;
+    auto executor = std::make_shared<runtime::TaskExecutor>(executor_config, scheduler);
+    ASSERT_TRUE(executor->Start());
+    EXPECT_TRUE(scheduler->running());
+
+    // Two channels, each a producer and a renderer, on two workers
+    constexpr int kChannels = 2;
+    const int64_t epoch = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count() +
+                          100'000;
+    auto clock = retrovue::timing::MakeSystemMasterClock(epoch, 0.0, 100, scheduler);
+    std::vector<std::unique_ptr<buffer::FrameRingBuffer>> rings;
+    std::vector<std::unique_ptr<decode::FrameProducer>> producers;
+    std::vector<std::unique_ptr<renderer::FrameRenderer>> renderers;
+    for (int c = 0; c < kChannels; ++c)
+    {
+      rings.push_back(std::make_unique<buffer::FrameRingBuffer>(30));
+      decode::ProducerConfig producer_config;
+      producer_config.stub_mode = true;
+      producer_config.target_width = 64;
+      producer_config.target_height = 36;
+      producers.push_back(
+          std::make_unique<decode::FrameProducer>(producer_config, *rings.back(), clock));
+      producers.back()->SetExecutor(executor);
+      renderers.push_back(renderer::FrameRenderer::Create(renderer::RenderConfig{}, *rings.back(),
+                                                          clock, nullptr, 700 + c));
+      renderers.back()->SetExecutor(executor);
+      ASSERT_TRUE(producers.back()->Start());
+      ASSERT_TRUE(renderers.back()->Start());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+
+    for (int c = 0; c < kChannels; ++c)
+    {
+      renderers[c]->Stop();
+      producers[c]->Stop();
+      EXPECT_FALSE(renderers[c]->IsRunning());
+      EXPECT_FALSE(producers[c]->IsRunning());
+
+      // Same observable behavior as the threaded components
+      EXPECT_GT(producers[c]->GetFramesProduced(), 10u);
+      EXPECT_GT(renderers[c]->GetStats().frames_rendered, 5u);
+      const renderer::FrameTimingStats timing = renderers[c]->GetTimingStats();
+      EXPECT_EQ(timing.pacing_error_us.Count(), renderers[c]->GetStats().frames_rendered);
+      EXPECT_LT(timing.pacing_error_us.ValueAtPercentile(50.0), 2'000);
+      EXPECT_GT(timing.render_cpu_ns + producers[c]->GetThreadCpuNs(), 0u);
+    }
+
+    const runtime::TaskExecutorStats stats = executor->GetStats();
+    EXPECT_EQ(stats.workers, 2u);
+    EXPECT_GT(stats.tasks_run, 0u);
+    EXPECT_GT(stats.pacing_tasks, 0u);
+    EXPECT_GT(stats.timed_tasks, 0u);
+
+    // A loop parked on a far timer stops at once and finishes exactly once
+    std::atomic<int> done_calls{0};
+    runtime::TaskLoop parked(
+        *executor, runtime::TaskExecutor::Lane::kWork,
+        [&] { return clock->ToSystemUtcUs(clock->now_utc_us() + 60'000'000); },
+        [&] { done_calls.fetch_add(1); });
+    ASSERT_TRUE(parked.Start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto stop_start = std::chrono::steady_clock::now();
+    parked.Stop();
+    parked.Stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - stop_start, std::chrono::milliseconds(100));
+    EXPECT_TRUE(parked.done());
+    EXPECT_EQ(done_calls.load(), 1);
+
+    executor->Stop();
+    EXPECT_FALSE(scheduler->running());  // Started by the executor, so stopped with it
+    EXPECT_FALSE(executor->Post([] {}));
+  }
+
 } // namespace
@@ -1,10 +1,30 @@
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "BaseContractTest.h"
+#include "retrovue/buffer/FramePool.h"
+#include "retrovue/telemetry/ChannelCpu.h"
+#include "retrovue/telemetry/ChannelWatch.h"
+#include "retrovue/telemetry/EncoderTelemetry.h"
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/telemetry/MetricsHTTPServer.h"
+#include "retrovue/telemetry/ThumbnailGenerator.h"
+#include "retrovue/telemetry/TraceRing.h"
 #include "../ContractRegistryEnvironment.h"
 
 namespace retrovue::tests::contracts {
@@ -16,7 +36,11 @@ namespace retrovue::tests::contracts {
     RegisterExpectedDomainCoverage("MetricsExport",
                                    {"MET-001",
                                     "MET-002",
-                                    "MET-003"});
+                                    "MET-003",
+                                    "MET-004",
+                                    "MET-005",
+                                    "MET-006",
+                                    "MET-007"});
     return true;
   }();
 
@@ -25,10 +49,90 @@ class MetricsExportContractTest : public BaseContractTest {
   [[nodiscard]] std::string DomainName() const override { return "MetricsExport"; }
 
   [[nodiscard]] std::vector<std::string> CoveredRuleIds() const override {
-    return {"MET-001", "MET-002", "MET-003"};
+    return {"MET-001", "MET-002", "MET-003", "MET-004", "MET-005", "MET-006",
+            "MET-007"};
   }
 };
 
+namespace {
+
+// A free TCP port (bound and released).
+int FreePort() {
+  const int probe = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  socklen_t length = sizeof(addr);
+  getsockname(probe, reinterpret_cast<sockaddr*>(&addr), &length);
+  close(probe);
+  return ntohs(addr.sin_port);
+}
+
+// A blocking HTTP client connection that reads responses one at a time.
+class TestHttpClient {
+ public:
+  explicit TestHttpClient(int port) : socket_(socket(AF_INET, SOCK_STREAM, 0)) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    connected_ = connect(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    timeval timeout{2, 0};
+    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  ~TestHttpClient() { close(socket_); }
+
+  bool connected() const { return connected_; }
+
+  void Send(const std::string& text) { send(socket_, text.data(), text.size(), MSG_NOSIGNAL); }
+
+  // Reads the next response; false on timeout or close.
+  bool Read(std::string& head, std::string& body) {
+    size_t head_end;
+    while ((head_end = input_.find("\r\n\r\n")) == std::string::npos) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+    head = input_.substr(0, head_end + 4);
+    const size_t length_at = head.find("Content-Length: ");
+    const size_t length =
+        length_at == std::string::npos ? 0 : std::strtoull(head.c_str() + length_at + 16, nullptr, 10);
+    while (input_.size() < head.size() + length) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+    body = input_.substr(head.size(), length);
+    input_.erase(0, head.size() + length);
+    return true;
+  }
+
+  // True if the server closed the connection.
+  bool Closed() {
+    char byte;
+    return recv(socket_, &byte, 1, 0) == 0;
+  }
+
+ private:
+  bool Fill() {
+    char buffer[4096];
+    const ssize_t bytes = recv(socket_, buffer, sizeof(buffer), 0);
+    if (bytes <= 0) {
+      return false;
+    }
+    input_.append(buffer, static_cast<size_t>(bytes));
+    return true;
+  }
+
+  const int socket_;
+  bool connected_ = false;
+  std::string input_;
+};
+
+}  // namespace
+
 TEST_F(MetricsExportContractTest, MET_001_NonBlockingExportSemantics) {
   telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
   ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
@@ -54,6 +158,320 @@ TEST_F(MetricsExportContractTest, MET_001_NonBlockingExportSemantics) {
   exporter.Stop();
 }
 
+TEST_F(MetricsExportContractTest, MET_001_ReadStallCountersAccumulate) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  exporter.RecordReadStalls(7, 2, 0.25);
+  exporter.RecordReadStalls(7, 1, 0.5);
+
+  // Snapshots submitted by the renderer must not reset exporter-owned totals.
+  telemetry::ChannelMetrics sample;
+  sample.state = telemetry::ChannelState::READY;
+  sample.buffer_depth_frames = 5;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(7, sample));
+  exporter.RecordReadStalls(7, 4, 0.25);
+
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  telemetry::ChannelMetrics metrics;
+  ASSERT_TRUE(exporter.GetChannelMetrics(7, metrics));
+  EXPECT_EQ(metrics.buffer_depth_frames, 5u);
+  EXPECT_EQ(metrics.read_stalls_total, 7u);
+  EXPECT_DOUBLE_EQ(metrics.read_stall_seconds_total, 1.0);
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_SrtLinkStatsSurviveSnapshots) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  telemetry::SrtLinkMetrics link;
+  link.connected = true;
+  link.rtt_seconds = 0.042;
+  link.retransmits_total = 12;
+  link.bytes_sent_total = 1316 * 1000;
+  exporter.RecordSrtLinkStats(3, link);
+
+  telemetry::ChannelMetrics sample;
+  sample.state = telemetry::ChannelState::READY;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(3, sample));
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(4, sample));
+
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  telemetry::ChannelMetrics metrics;
+  ASSERT_TRUE(exporter.GetChannelMetrics(3, metrics));
+  ASSERT_TRUE(metrics.srt_link.has_value());
+  EXPECT_TRUE(metrics.srt_link->connected);
+  EXPECT_DOUBLE_EQ(metrics.srt_link->rtt_seconds, 0.042);
+  EXPECT_EQ(metrics.srt_link->retransmits_total, 12u);
+  EXPECT_EQ(metrics.srt_link->bytes_sent_total, 1316u * 1000u);
+
+  // Channels without a link report none.
+  ASSERT_TRUE(exporter.GetChannelMetrics(4, metrics));
+  EXPECT_FALSE(metrics.srt_link.has_value());
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_BufferMemorySurvivesSnapshots) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  telemetry::BufferMemoryMetrics memory;
+  memory.depth_limit_frames = 15;
+  memory.frame_bytes = 518'400;
+  memory.reserved_bytes = 17 * 518'400;
+  exporter.RecordBufferMemory(5, memory);
+
+  telemetry::ChannelMetrics sample;
+  sample.state = telemetry::ChannelState::READY;
+  sample.buffer_depth_frames = 9;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(5, sample));
+
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  telemetry::ChannelMetrics metrics;
+  ASSERT_TRUE(exporter.GetChannelMetrics(5, metrics));
+  EXPECT_EQ(metrics.buffer_depth_frames, 9u);
+  EXPECT_EQ(metrics.buffer_memory.depth_limit_frames, 15u);
+  EXPECT_EQ(metrics.buffer_memory.reserved_bytes, 17u * 518'400u);
+
+  // A released buffer reports nothing
+  exporter.RecordBufferMemory(5, telemetry::BufferMemoryMetrics());
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  ASSERT_TRUE(exporter.GetChannelMetrics(5, metrics));
+  EXPECT_EQ(metrics.buffer_memory.frame_bytes, 0u);
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_ChannelSlotsRecordWithoutTheQueue) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  constexpr int kChannels = 4;
+  constexpr int kRecords = 100'000;
+  telemetry::ChannelMetrics ready;
+  ready.state = telemetry::ChannelState::READY;
+  for (int channel = 0; channel < kChannels; ++channel) {
+    EXPECT_TRUE(exporter.SubmitChannelMetrics(channel, ready));
+  }
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  // Each channel's render thread records into its own slot
+  std::vector<std::thread> threads;
+  std::vector<double> average_ns(kChannels, 0.0);
+  for (int channel = 0; channel < kChannels; ++channel) {
+    threads.emplace_back([&exporter, &average_ns, channel] {
+      const auto slot = exporter.AcquireChannelSlot(channel);
+      telemetry::ChannelMetrics sample;
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 1; i <= kRecords; ++i) {
+        sample.buffer_depth_frames = static_cast<uint64_t>(i % 30);
+        sample.late_frames_total = static_cast<uint64_t>(i);
+        slot->Record(sample);
+      }
+      average_ns[channel] = std::chrono::duration<double, std::nano>(
+                                std::chrono::steady_clock::now() - start)
+                                .count() /
+                            kRecords;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int channel = 0; channel < kChannels; ++channel) {
+    EXPECT_LE(average_ns[channel], 5'000.0) << "Average record latency must stay within 5 us";
+    telemetry::ChannelMetrics metrics;
+    ASSERT_TRUE(exporter.GetChannelMetrics(channel, metrics));
+    EXPECT_EQ(metrics.state, telemetry::ChannelState::READY);  // Submitted fields remain
+    EXPECT_EQ(metrics.buffer_depth_frames, static_cast<uint64_t>(kRecords % 30));
+    EXPECT_EQ(metrics.late_frames_total, static_cast<uint64_t>(kRecords));
+  }
+  EXPECT_EQ(exporter.queue_overflow_total(), 0u);
+
+  // A later submission replaces what the slot holds
+  telemetry::ChannelMetrics stopped;
+  stopped.state = telemetry::ChannelState::STOPPED;
+  stopped.buffer_depth_frames = 0;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(0, stopped));
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  telemetry::ChannelMetrics metrics;
+  ASSERT_TRUE(exporter.GetChannelMetrics(0, metrics));
+  EXPECT_EQ(metrics.buffer_depth_frames, 0u);
+  EXPECT_EQ(metrics.late_frames_total, 0u);
+
+  // Removal drops the slot with the channel
+  exporter.SubmitChannelRemoval(1);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  EXPECT_FALSE(exporter.GetChannelMetrics(1, metrics));
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_FrameTracesAggregatePerStage) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  using buffer::FrameStage;
+  buffer::FrameTrace trace;
+  exporter.RecordFrameTrace(5, trace);  // Not sampled: ignored
+  trace.MarkAt(FrameStage::kDemuxed, 1'000);  // Sampled from here
+  trace.MarkAt(FrameStage::kDecoded, 5'000);
+  trace.MarkAt(FrameStage::kPushed, 6'000);  // Scaled not stamped: pushed counts from decoded
+  trace.MarkAt(FrameStage::kPopped, 40'000);
+  trace.MarkAt(FrameStage::kEncodeStart, 40'100);
+  trace.MarkAt(FrameStage::kEncodeEnd, 48'100);
+  exporter.RecordFrameTrace(5, trace);
+  trace.MarkAt(FrameStage::kSent, 50'100);
+  exporter.RecordFrameTrace(5, trace);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  telemetry::FrameStageLatency latency;
+  EXPECT_FALSE(exporter.GetFrameStageLatency(6, latency));
+  ASSERT_TRUE(exporter.GetFrameStageLatency(5, latency));
+  EXPECT_EQ(latency.frames, 2u);
+  const auto stage = [&latency](FrameStage s) -> const telemetry::HdrHistogram& {
+    return latency.stage_us[static_cast<size_t>(s)];
+  };
+  EXPECT_EQ(stage(FrameStage::kDemuxed).Count(), 0u);
+  EXPECT_EQ(stage(FrameStage::kScaled).Count(), 0u);
+  EXPECT_EQ(stage(FrameStage::kDecoded).Count(), 2u);
+  EXPECT_EQ(stage(FrameStage::kPushed).Count(), 2u);
+  EXPECT_EQ(stage(FrameStage::kSent).Count(), 1u);
+  EXPECT_NEAR(stage(FrameStage::kDecoded).ValueAtPercentile(50.0), 4'000, 40);
+  EXPECT_NEAR(stage(FrameStage::kPushed).ValueAtPercentile(50.0), 1'000, 10);
+  EXPECT_NEAR(stage(FrameStage::kPopped).ValueAtPercentile(50.0), 34'000, 340);
+  EXPECT_NEAR(stage(FrameStage::kEncodeEnd).ValueAtPercentile(50.0), 8'000, 80);
+  EXPECT_NEAR(stage(FrameStage::kSent).ValueAtPercentile(50.0), 2'000, 20);
+  EXPECT_NEAR(latency.total_us.Max(), 49'100, 491);
+
+  // A removed channel drops its latencies
+  exporter.SubmitChannelRemoval(5);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  EXPECT_FALSE(exporter.GetFrameStageLatency(5, latency));
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_ChannelCpuPerStage) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  using telemetry::CpuStage;
+  std::array<uint64_t, telemetry::kCpuStageCount> cpu_ns{};
+  EXPECT_FALSE(exporter.GetChannelCpu(3, cpu_ns));
+
+  // Rule: every thread working for a channel charges the one account
+  const auto account = exporter.AcquireChannelCpu(3);
+  ASSERT_NE(account, nullptr);
+  EXPECT_EQ(exporter.AcquireChannelCpu(3), account);
+
+  std::string thread_name;
+  std::thread worker([&account, &thread_name]() {
+    telemetry::NameCurrentThread(3, "decode");
+#ifdef __linux__
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    thread_name = name;
+#endif
+    telemetry::StageCpuMeter meter(account);
+    meter.Restart();
+    volatile uint64_t sink = 0;
+    const auto spin = [&sink]() {
+      const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+      while (std::chrono::steady_clock::now() < until) {
+        sink = sink + 1;
+      }
+    };
+    spin();
+    meter.Charge(CpuStage::kDecode);
+    spin();
+    meter.Charge(CpuStage::kScale);
+  });
+  worker.join();
+#ifdef __linux__
+  EXPECT_EQ(thread_name, "rv3-decode");
+#endif
+
+  ASSERT_TRUE(exporter.GetChannelCpu(3, cpu_ns));
+  EXPECT_GT(cpu_ns[static_cast<size_t>(CpuStage::kDecode)], 5'000'000u);
+  EXPECT_GT(cpu_ns[static_cast<size_t>(CpuStage::kScale)], 5'000'000u);
+  EXPECT_EQ(cpu_ns[static_cast<size_t>(CpuStage::kEncode)], 0u);
+  EXPECT_EQ(account->Total(), cpu_ns[static_cast<size_t>(CpuStage::kDecode)] +
+                                  cpu_ns[static_cast<size_t>(CpuStage::kScale)]);
+
+  // A meter without an account charges nothing
+  telemetry::StageCpuMeter idle;
+  EXPECT_FALSE(idle.active());
+  idle.Charge(CpuStage::kSend);
+
+  // A removed channel drops its account
+  exporter.SubmitChannelRemoval(3);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  EXPECT_FALSE(exporter.GetChannelCpu(3, cpu_ns));
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_001_EncoderTelemetryPerChannel) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  using telemetry::PictureType;
+  telemetry::EncoderTelemetrySnapshot snapshot;
+  EXPECT_FALSE(exporter.GetEncoderTelemetry(4, snapshot));
+
+  const auto encoder = exporter.AcquireEncoderTelemetry(4);
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(exporter.AcquireEncoderTelemetry(4), encoder);
+  encoder->SetConfiguredBitrate(5'000'000);
+  for (int i = 0; i < 30; ++i) {
+    encoder->RecordEncode(4'000 + i);
+    encoder->RecordFrame(i == 0 ? PictureType::kI : PictureType::kP, i == 0 ? 60'000 : 12'000,
+                         i == 0 ? 22 : 26);
+    encoder->RecordPcr(40'000, i % 2 == 0 ? 300 : -300);
+  }
+  encoder->RecordFrame(PictureType::kB, 4'000, -1);  // QP not reported
+  encoder->RecordPcr(-1, 500);                        // Interval not known
+  encoder->AddOutputBytes(625'000);
+  encoder->SetOutputGauges(4'900'000, 18'800, 0.25);
+
+  // Rule: encoder telemetry is read as a snapshot of what the sink recorded
+  ASSERT_TRUE(exporter.GetEncoderTelemetry(4, snapshot));
+  EXPECT_EQ(snapshot.configured_bitrate_bps, 5'000'000);
+  EXPECT_EQ(snapshot.realized_bitrate_bps, 4'900'000);
+  EXPECT_EQ(snapshot.output_bytes, 625'000u);
+  EXPECT_EQ(snapshot.output_queue_bytes, 18'800u);
+  EXPECT_NEAR(snapshot.send_buffer_ratio, 0.25, 1e-6);
+  EXPECT_EQ(snapshot.encode_us.Count(), 30u);
+  EXPECT_NEAR(snapshot.encode_us.ValueAtPercentile(50.0), 4'015, 40);
+  const auto by_type = [](const auto& histograms, PictureType type) -> const telemetry::HdrHistogram& {
+    return histograms[static_cast<size_t>(type)];
+  };
+  EXPECT_EQ(by_type(snapshot.frame_bytes, PictureType::kI).Count(), 1u);
+  EXPECT_EQ(by_type(snapshot.frame_bytes, PictureType::kP).Count(), 29u);
+  EXPECT_EQ(by_type(snapshot.frame_bytes, PictureType::kB).Count(), 1u);
+  EXPECT_NEAR(by_type(snapshot.frame_bytes, PictureType::kI).Max(), 60'000, 600);
+  EXPECT_EQ(by_type(snapshot.qp, PictureType::kI).ValueAtPercentile(50.0), 22);
+  EXPECT_EQ(by_type(snapshot.qp, PictureType::kP).ValueAtPercentile(50.0), 26);
+  EXPECT_EQ(by_type(snapshot.qp, PictureType::kB).Count(), 0u);
+  EXPECT_EQ(snapshot.pcr_interval_us.Count(), 30u);
+  EXPECT_EQ(snapshot.pcr_jitter_us.Count(), 31u);
+  EXPECT_NEAR(snapshot.pcr_jitter_us.ValueAtPercentile(50.0), 300, 3);
+
+  // A removed channel drops its telemetry
+  exporter.SubmitChannelRemoval(4);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  EXPECT_FALSE(exporter.GetEncoderTelemetry(4, snapshot));
+
+  exporter.Stop();
+}
+
 TEST_F(MetricsExportContractTest, MET_002_SchemaVersionIntegrity) {
   telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
   ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
@@ -101,5 +519,346 @@ TEST_F(MetricsExportContractTest, MET_003_DeliveryReliabilityPerTransport) {
   exporter.Stop();
 }
 
+TEST_F(MetricsExportContractTest, MET_004_ChannelStatusWatch) {
+  telemetry::MetricsExporter exporter(0, /*enable_http=*/false);
+  ASSERT_TRUE(exporter.Start(/*start_http_server=*/false));
+
+  telemetry::ChannelMetrics sample;
+  sample.state = telemetry::ChannelState::READY;
+  sample.buffer_depth_frames = 1;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(7, sample));
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+
+  auto watch = exporter.WatchChannels({7}, std::chrono::milliseconds(200));
+  ASSERT_NE(watch, nullptr);
+
+  // Rule: the first event is due at once
+  telemetry::ChannelStatusEvent event;
+  ASSERT_TRUE(watch->Next(event, std::chrono::milliseconds(100)));
+  EXPECT_EQ(event.status.channel_id, 7);
+  EXPECT_TRUE(event.state_changed);
+  EXPECT_EQ(event.status.buffer_depth_frames, 1u);
+
+  // Rule: updates within the interval are coalesced; unwatched channels are not seen
+  for (uint64_t depth = 2; depth <= 4; ++depth) {
+    sample.buffer_depth_frames = depth;
+    EXPECT_TRUE(exporter.SubmitChannelMetrics(7, sample));
+    EXPECT_TRUE(exporter.SubmitChannelMetrics(8, sample));
+  }
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  ASSERT_TRUE(watch->Next(event, std::chrono::milliseconds(1000)));
+  EXPECT_EQ(event.status.channel_id, 7);
+  EXPECT_FALSE(event.state_changed);
+  EXPECT_EQ(event.status.buffer_depth_frames, 4u);
+  EXPECT_EQ(event.coalesced, 2u);
+
+  // Rule: a control-state change skips the interval; counters report growth
+  sample.underruns_total = 3;
+  sample.late_frames_total = 5;
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(7, sample));
+  exporter.RecordControlState(7, "playing");
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  const auto before = std::chrono::steady_clock::now();
+  ASSERT_TRUE(watch->Next(event, std::chrono::milliseconds(100)));
+  EXPECT_LT(std::chrono::steady_clock::now() - before, std::chrono::milliseconds(100));
+  EXPECT_TRUE(event.state_changed);
+  EXPECT_EQ(event.status.control_state, "playing");
+  EXPECT_EQ(event.underruns, 3u);
+  EXPECT_EQ(event.late_frames, 5u);
+  EXPECT_EQ(event.status.underruns_total, 3u);
+
+  // Rule: a removal is delivered at once
+  exporter.SubmitChannelRemoval(7);
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  ASSERT_TRUE(watch->Next(event, std::chrono::milliseconds(100)));
+  EXPECT_TRUE(event.status.removed);
+  EXPECT_TRUE(event.state_changed);
+
+  // Rule: a closed watch receives nothing further
+  watch->Close();
+  EXPECT_TRUE(exporter.SubmitChannelMetrics(7, sample));
+  ASSERT_TRUE(exporter.WaitUntilDrainedForTest(std::chrono::milliseconds(500)));
+  EXPECT_FALSE(watch->Next(event, std::chrono::milliseconds(50)));
+
+  exporter.Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_005_ChannelThumbnails) {
+  telemetry::ThumbnailConfig config;
+  config.interval = std::chrono::seconds(10);
+  config.max_width = 160;
+  config.max_height = 160;
+  auto thumbnails = std::make_shared<telemetry::ThumbnailGenerator>(config);
+  ASSERT_TRUE(thumbnails->Start());
+  auto tap = thumbnails->AddChannel(3);
+
+  buffer::Frame frame;
+  frame.width = 640;
+  frame.height = 360;
+  frame.metadata.pts = 1234;
+  frame.data.assign(640 * 360, 81);
+  frame.data.resize(640 * 360 * 3 / 2, 90);
+  const buffer::FrameHandle handle = buffer::FrameHandle::Adopt(std::move(frame));
+
+  // Rule: a channel's first frame is taken at once, later ones once per interval
+  EXPECT_TRUE(tap->Offer(handle));
+  EXPECT_FALSE(tap->Offer(handle));
+
+  telemetry::Thumbnail thumbnail;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (!thumbnails->GetThumbnail(3, thumbnail) && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_NE(thumbnail.image, nullptr);
+
+  // Rule: the image fits the box with the frame's aspect, and the frame is not kept
+  EXPECT_EQ(thumbnail.width, 160);
+  EXPECT_EQ(thumbnail.height, 90);
+  EXPECT_EQ(thumbnail.pts, 1234);
+  EXPECT_EQ(handle.use_count(), 1u);
+  ASSERT_GE(thumbnail.image->size(), 2u);
+  if (thumbnail.content_type == "image/jpeg") {
+    EXPECT_EQ(static_cast<uint8_t>((*thumbnail.image)[0]), 0xFF);
+    EXPECT_EQ(static_cast<uint8_t>((*thumbnail.image)[1]), 0xD8);
+  } else {
+    EXPECT_EQ(thumbnail.content_type, "image/bmp");
+    EXPECT_EQ(thumbnail.image->compare(0, 2, "BM"), 0);
+    EXPECT_EQ(thumbnail.image->size(), 54u + 160 * 3 * 90);
+  }
+
+  // Rule: GET /thumbnail/{channel} serves the newest image; unknown channels are 404
+  telemetry::HttpRequest request;
+  telemetry::HttpResponse response;
+  request.path = "/thumbnail/3";
+  ASSERT_TRUE(thumbnails->ServeHttp(request, response));
+  EXPECT_EQ(response.body, thumbnail.image);
+  EXPECT_EQ(response.content_type, thumbnail.content_type);
+  EXPECT_EQ(response.cache_control, "no-cache");
+  request.path = "/thumbnail/4";
+  EXPECT_FALSE(thumbnails->ServeHttp(request, response));
+  request.path = "/thumbnail/3x";
+  EXPECT_FALSE(thumbnails->ServeHttp(request, response));
+
+  // Rule: a removed channel has no thumbnail
+  thumbnails->RemoveChannel(3);
+  EXPECT_FALSE(thumbnails->GetThumbnail(3, thumbnail));
+  EXPECT_EQ(thumbnails->GetStats().generated, 1u);
+
+  thumbnails->Stop();
+}
+
+TEST_F(MetricsExportContractTest, MET_006_ConcurrentCachedScrapes) {
+  const int port = FreePort();
+  telemetry::MetricsHTTPServer server(port);
+  std::atomic<int> generated{0};
+  std::atomic<uint64_t> version{1};
+  server.SetMetricsCallback([&generated]() {
+    std::string text = "# generation " + std::to_string(++generated) + "\n";
+    for (int i = 0; i < 100; ++i) {
+      text += "retrovue_test_metric{channel=\"" + std::to_string(i) + "\"} 0\n";
+    }
+    return text;
+  });
+  server.SetMetricsVersionCallback([&version]() { return version.load(); });
+  server.SetMetricsCacheInterval(std::chrono::milliseconds(500));
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool release = false;
+  server.AddHandler("/slow", [&](const telemetry::HttpRequest&, telemetry::HttpResponse& response) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(2), [&release]() { return release; });
+    response.body = std::make_shared<const std::string>("done");
+    return true;
+  });
+  ASSERT_TRUE(server.Start());
+
+  const std::string scrape = "GET /metrics HTTP/1.1\r\nHost: test\r\nAccept-Encoding: gzip\r\n\r\n";
+  std::string head;
+  std::string body;
+
+  // Rule: pipelined requests on one kept-alive connection are answered in order
+  TestHttpClient client(port);
+  ASSERT_TRUE(client.connected());
+  client.Send(scrape + "GET / HTTP/1.1\r\nHost: test\r\n\r\n");
+  ASSERT_TRUE(client.Read(head, body));
+  EXPECT_EQ(head.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+  EXPECT_NE(head.find("Connection: keep-alive"), std::string::npos);
+  EXPECT_NE(head.find("Vary: Accept-Encoding"), std::string::npos);
+#ifdef RETROVUE_ZLIB_AVAILABLE
+  // Rule: clients that accept gzip get the text gzip-encoded
+  EXPECT_NE(head.find("Content-Encoding: gzip"), std::string::npos);
+  ASSERT_GE(body.size(), 2u);
+  EXPECT_EQ(static_cast<uint8_t>(body[0]), 0x1F);
+  EXPECT_EQ(static_cast<uint8_t>(body[1]), 0x8B);
+#endif
+  ASSERT_TRUE(client.Read(head, body));
+  EXPECT_NE(body.find("Metrics available at"), std::string::npos);
+
+  // Rule: the text is cached while its version holds, and within the interval
+  client.Send("GET /metrics HTTP/1.1\r\nHost: test\r\n\r\n");
+  ASSERT_TRUE(client.Read(head, body));
+  EXPECT_EQ(head.find("Content-Encoding"), std::string::npos);
+  EXPECT_EQ(body.compare(0, 15, "# generation 1\n"), 0);
+  ++version;
+  client.Send("GET /metrics HTTP/1.1\r\nHost: test\r\n\r\n");
+  ASSERT_TRUE(client.Read(head, body));
+  EXPECT_EQ(body.compare(0, 15, "# generation 1\n"), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  client.Send("GET /metrics HTTP/1.1\r\nHost: test\r\n\r\n");
+  ASSERT_TRUE(client.Read(head, body));
+  EXPECT_EQ(body.compare(0, 15, "# generation 2\n"), 0);
+  EXPECT_EQ(generated.load(), 2);
+
+  // Rule: a handler holding a request stalls only its own connection
+  TestHttpClient slow(port);
+  ASSERT_TRUE(slow.connected());
+  slow.Send("GET /slow HTTP/1.1\r\nHost: test\r\n\r\n");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  TestHttpClient other(port);
+  ASSERT_TRUE(other.connected());
+  other.Send("GET /metrics HTTP/1.0\r\n\r\n");
+  ASSERT_TRUE(other.Read(head, body));
+  EXPECT_NE(head.find("Connection: close"), std::string::npos);
+  EXPECT_TRUE(other.Closed());
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  ASSERT_TRUE(slow.Read(head, body));
+  EXPECT_EQ(body, "done");
+
+  // Rule: Connection: close is honoured
+  slow.Send("GET /missing HTTP/1.1\r\nConnection: close\r\n\r\n");
+  ASSERT_TRUE(slow.Read(head, body));
+  EXPECT_EQ(head.compare(0, 22, "HTTP/1.1 404 Not Found"), 0);
+  EXPECT_TRUE(slow.Closed());
+
+  const telemetry::HttpServerStats stats = server.GetStats();
+  EXPECT_EQ(stats.connections_accepted, 3u);
+  EXPECT_EQ(stats.requests, 8u);
+  EXPECT_EQ(stats.metrics_generated, 2u);
+  EXPECT_EQ(stats.metrics_cached, 3u);
+#ifdef RETROVUE_ZLIB_AVAILABLE
+  EXPECT_EQ(stats.gzip_responses, 1u);
+#endif
+
+  server.Stop();
+}
+
+namespace {
+
+size_t CountOccurrences(const std::string& text, const std::string& needle) {
+  size_t count = 0;
+  for (size_t pos = text.find(needle); pos != std::string::npos;
+       pos = text.find(needle, pos + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_F(MetricsExportContractTest, MET_007_TraceRingChromeExport) {
+  telemetry::StopTracing();
+
+  // Rule: Trace points record nothing while tracing is off
+  telemetry::StartTracing(telemetry::TraceConfig{64});
+  telemetry::StopTracing();
+  {
+    RETROVUE_TRACE_SCOPE("off.scope");
+    RETROVUE_TRACE_INSTANT("off.instant");
+  }
+  EXPECT_EQ(telemetry::GetTraceStats().recorded, 0u);
+  EXPECT_EQ(telemetry::GetTraceStats().threads, 0u);
+
+  // Rule: Each thread records into its own ring; scopes, counters and
+  // instants export as Chrome trace events
+  telemetry::StartTracing(telemetry::TraceConfig{64});
+  std::thread worker([] {
+    RETROVUE_TRACE_SCOPE("worker.scope");
+    RETROVUE_TRACE_COUNTER("worker.depth", 42);
+    RETROVUE_TRACE_INSTANT("worker.instant");
+  });
+  worker.join();
+  {
+    RETROVUE_TRACE_SCOPE("main.scope");
+  }
+  telemetry::TraceStats stats = telemetry::GetTraceStats();
+  EXPECT_TRUE(stats.enabled);
+  EXPECT_EQ(stats.threads, 2u);
+  EXPECT_EQ(stats.recorded, 6u);
+  EXPECT_EQ(stats.overwritten, 0u);
+
+  std::string json = telemetry::DumpTraceJson();
+  EXPECT_EQ(json.compare(0, 15, "{\"displayTimeUn"), 0);
+  EXPECT_EQ(CountOccurrences(json, "\"ph\":\"M\""), 2u);
+  EXPECT_NE(json.find("{\"name\":\"worker.scope\",\"ph\":\"B\""), std::string::npos);
+  EXPECT_NE(json.find("{\"name\":\"worker.scope\",\"ph\":\"E\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"C\""), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"value\":42}"), std::string::npos);
+  EXPECT_NE(json.find("{\"name\":\"worker.instant\",\"ph\":\"i\""), std::string::npos);
+  EXPECT_NE(json.find("\"s\":\"t\""), std::string::npos);
+  EXPECT_NE(json.find("{\"name\":\"main.scope\",\"ph\":\"B\""), std::string::npos);
+
+  // Rule: A full ring keeps its newest events; ends whose begin was
+  // overwritten are left out of the export
+  telemetry::StartTracing(telemetry::TraceConfig{64});
+  {
+    RETROVUE_TRACE_SCOPE("outer");
+    for (int i = 0; i < 100; ++i) {
+      RETROVUE_TRACE_SCOPE("inner");
+    }
+  }
+  stats = telemetry::GetTraceStats();
+  EXPECT_EQ(stats.threads, 1u);
+  EXPECT_EQ(stats.recorded, 202u);
+  EXPECT_EQ(stats.overwritten, 202u - 64u);
+  json = telemetry::DumpTraceJson();
+  EXPECT_EQ(json.find("\"outer\""), std::string::npos);
+  EXPECT_EQ(CountOccurrences(json, "{\"name\":\"inner\",\"ph\":\"B\""), 31u);
+  EXPECT_EQ(CountOccurrences(json, "{\"name\":\"inner\",\"ph\":\"E\""), 31u);
+
+  // Rule: Dumps run while threads record
+  std::atomic<bool> recording{true};
+  std::thread recorder([&recording] {
+    while (recording.load(std::memory_order_relaxed)) {
+      RETROVUE_TRACE_SCOPE("busy");
+    }
+  });
+  for (int i = 0; i < 20; ++i) {
+    json = telemetry::DumpTraceJson();
+    EXPECT_LE(CountOccurrences(json, "\"ph\":\"E\""),
+              CountOccurrences(json, "\"ph\":\"B\""));
+  }
+  recording.store(false, std::memory_order_relaxed);
+  recorder.join();
+
+  // Rule: Tracing is controlled over HTTP
+  telemetry::HttpRequest request;
+  telemetry::HttpResponse response;
+  request.path = "/trace/stop";
+  ASSERT_TRUE(telemetry::ServeTraceHttp(request, response));
+  EXPECT_FALSE(telemetry::TraceEnabled());
+  request.path = "/trace/start";
+  request.query["events"] = "128";
+  ASSERT_TRUE(telemetry::ServeTraceHttp(request, response));
+  EXPECT_TRUE(telemetry::TraceEnabled());
+  EXPECT_EQ(telemetry::GetTraceStats().threads, 0u);
+  request.path = "/trace/status";
+  ASSERT_TRUE(telemetry::ServeTraceHttp(request, response));
+  EXPECT_EQ(response.content_type, "application/json");
+  EXPECT_NE(response.body->find("\"enabled\":true"), std::string::npos);
+  request.path = "/trace";
+  ASSERT_TRUE(telemetry::ServeTraceHttp(request, response));
+  EXPECT_EQ(response.content_type, "application/json");
+  EXPECT_NE(response.body->find("\"traceEvents\""), std::string::npos);
+  request.path = "/trace/unknown";
+  EXPECT_FALSE(telemetry::ServeTraceHttp(request, response));
+
+  telemetry::StopTracing();
+}
+
 }  // namespace retrovue::tests::contracts
 
@@ -14,36 +14,6 @@
 
 namespace retrovue::tests::contracts {
 
-namespace {
-
-double Percentile(std::vector<double> samples, double percentile) {
-  if (samples.empty()) {
-    return 0.0;
-  }
-  std::sort(samples.begin(), samples.end());
-  const double rank = percentile * static_cast<double>(samples.size() - 1);
-  const auto lower_index = static_cast<std::size_t>(std::floor(rank));
-  const auto upper_index = static_cast<std::size_t>(std::ceil(rank));
-  const double lower = samples[lower_index];
-  if (upper_index == lower_index) {
-    return lower;
-  }
-  const double upper = samples[upper_index];
-  const double fraction = rank - static_cast<double>(lower_index);
-  return lower + (upper - lower) * fraction;
-}
-
-double PercentileAbs(const std::vector<double>& samples, double percentile) {
-  std::vector<double> magnitudes;
-  magnitudes.reserve(samples.size());
-  for (double value : samples) {
-    magnitudes.push_back(std::abs(value));
-  }
-  return Percentile(std::move(magnitudes), percentile);
-}
-
-}  // namespace
-
 class OrchestrationLoopContractTest : public BaseContractTest {
  protected:
   [[nodiscard]] std::string DomainName() const override { return "OrchestrationLoop"; }
@@ -73,12 +43,15 @@ TEST_F(OrchestrationLoopContractTest, ORCH_001_TickDisciplineAndLatencyBudget) {
 
   const auto stats = loop.Snapshot();
 
-  ASSERT_GE(stats.tick_skew_ms.size(), 60u) << "Insufficient tick samples collected";
-  EXPECT_LT(PercentileAbs(stats.tick_skew_ms, 0.95), 2.2)
+  ASSERT_GE(stats.tick_skew_us.total.Count(), 60u) << "Insufficient tick samples collected";
+  EXPECT_LT(stats.tick_skew_us.total.ValueAtPercentile(95.0) / 1'000.0, 2.2)
       << "Tick skew exceeded 95th percentile requirement";
-  ASSERT_FALSE(stats.latency_ms.empty());
-  EXPECT_LE(Percentile(stats.latency_ms, 0.95), config.max_latency_ms)
+  ASSERT_GT(stats.latency_us.total.Count(), 0u);
+  EXPECT_LE(stats.latency_us.total.ValueAtPercentile(95.0) / 1'000.0, config.max_latency_ms)
       << "Producer→renderer latency breached contract";
+  // A 3 s run sits entirely inside both recent windows
+  EXPECT_EQ(stats.tick_skew_us.last_1m.Count(), stats.tick_skew_us.total.Count());
+  EXPECT_EQ(stats.latency_us.last_5m.Count(), stats.latency_us.total.Count());
   EXPECT_FALSE(stats.starvation_detected) << "Unexpected starvation detected during steady state";
 }
 
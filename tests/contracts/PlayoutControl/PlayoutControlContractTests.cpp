@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <string>
 
 #include "BaseContractTest.h"
 #include "retrovue/runtime/PlayoutControlStateMachine.h"
@@ -24,7 +26,7 @@ class PlayoutControlContractTest : public BaseContractTest {
   [[nodiscard]] std::string DomainName() const override { return "PlayoutControl"; }
 
   [[nodiscard]] std::vector<std::string> CoveredRuleIds() const override {
-    return {"CTL_001", "CTL_002", "CTL_003", "CTL_004", "CTL_005"};
+    return {"CTL_001", "CTL_002", "CTL_003", "CTL_004", "CTL_005", "CTL_006"};
   }
 };
 
@@ -68,6 +70,50 @@ TEST_F(PlayoutControlContractTest, CTL_001_DeterministicStateTransitions) {
                                      runtime::PlayoutControlStateMachine::State::kBuffering}),
             1u);
   EXPECT_EQ(snapshot.illegal_transition_total, 1u);
+
+  // Rule: the counters read lock-free match the snapshot
+  using State = runtime::PlayoutControlStateMachine::State;
+  EXPECT_EQ(controller.TransitionCount(State::kIdle, State::kBuffering), 1u);
+  EXPECT_EQ(controller.TransitionCount(State::kPlaying, State::kPaused), 1u);
+  EXPECT_EQ(controller.IllegalTransitionCount(State::kIdle, State::kPlaying), 1u);
+  EXPECT_EQ(controller.IllegalTransitionCount(State::kPlaying, State::kPaused), 0u);
+}
+
+TEST_F(PlayoutControlContractTest, CTL_001_StateReadsDoNotWaitOnCommands) {
+  using State = runtime::PlayoutControlStateMachine::State;
+  runtime::PlayoutControlStateMachine controller;
+  const int64_t start_time = 1'700'000'050'000'000LL;
+
+  // Rule: ticks and readers run concurrently with commands; every state read
+  // is a published state, and each cycle counts exactly once
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> bad_reads{0};
+  std::thread reader([&] {
+    while (!done.load()) {
+      const State state = controller.state();
+      if (state != State::kIdle && state != State::kBuffering && state != State::kReady &&
+          state != State::kPlaying && state != State::kStopping) {
+        bad_reads.fetch_add(1);
+      }
+      controller.OnBufferDepth(0, 60, start_time);
+    }
+  });
+
+  constexpr uint64_t kCycles = 200;
+  for (uint64_t i = 0; i < kCycles; ++i) {
+    const int64_t t = start_time + MsToUs(static_cast<double>(i) * 10.0);
+    ASSERT_TRUE(controller.BeginSession("begin-" + std::to_string(i), t));
+    controller.OnBufferDepth(5, 60, t + MsToUs(1));
+    ASSERT_TRUE(controller.Stop("stop-" + std::to_string(i), t + MsToUs(2), t + MsToUs(3)));
+  }
+  done.store(true);
+  reader.join();
+
+  EXPECT_EQ(bad_reads.load(), 0u);
+  EXPECT_EQ(controller.state(), State::kIdle);
+  EXPECT_EQ(controller.TransitionCount(State::kIdle, State::kBuffering), kCycles);
+  EXPECT_EQ(controller.TransitionCount(State::kStopping, State::kIdle), kCycles);
+  EXPECT_EQ(controller.Snapshot().illegal_transition_total, 0u);
 }
 
 TEST_F(PlayoutControlContractTest, CTL_002_ControlActionLatencyCompliance) {
@@ -154,8 +200,9 @@ TEST_F(PlayoutControlContractTest, CTL_003_CommandIdempotencyAndFailureTelemetry
 
 // Rule: CTL_004 Dual-Producer Preview/Live Slot Management
 TEST_F(PlayoutControlContractTest, CTL_004_DualProducerSlotManagement) {
-  runtime::PlayoutControlStateMachine controller;
+  // The buffer outlives the controller, whose producers write into it
   buffer::FrameRingBuffer buffer(60);
+  runtime::PlayoutControlStateMachine controller;
   auto clock = std::make_shared<retrovue::timing::TestMasterClock>();
   const int64_t start_time = 1'700'000'000'000'000LL;
   clock->SetEpochUtcUs(start_time);
@@ -242,8 +289,9 @@ TEST_F(PlayoutControlContractTest, CTL_004_DualProducerSlotManagement) {
 
 // Rule: CTL_005 Producer Switching Seamlessness
 TEST_F(PlayoutControlContractTest, CTL_005_ProducerSwitchingSeamlessness) {
-  runtime::PlayoutControlStateMachine controller;
+  // The buffer outlives the controller, whose producers write into it
   buffer::FrameRingBuffer buffer(60);
+  runtime::PlayoutControlStateMachine controller;
   auto clock = std::make_shared<retrovue::timing::TestMasterClock>();
   const int64_t start_time = 1'700'000'000'000'000LL;
   clock->SetEpochUtcUs(start_time);
@@ -324,5 +372,95 @@ TEST_F(PlayoutControlContractTest, CTL_005_ProducerSwitchingSeamlessness) {
   EXPECT_TRUE(live2_after.producer->isRunning()) << "New live producer should be running";
 }
 
+// Rule: CTL_006 Scheduled Switch Splices On The Target Frame
+TEST_F(PlayoutControlContractTest, CTL_006_ScheduledSwitchSplicesOnTargetFrame) {
+  buffer::FrameRingBuffer buffer(120);
+  auto clock = std::make_shared<retrovue::timing::TestMasterClock>();
+  clock->SetEpochUtcUs(1'700'000'300'000'000LL);
+  runtime::PlayoutControlStateMachine controller;
+
+  controller.setProducerFactory(
+      [](const std::string &path, const std::string &asset_id,
+         buffer::FrameRingBuffer &rb, std::shared_ptr<retrovue::timing::MasterClock> clk)
+          -> std::unique_ptr<retrovue::producers::IProducer> {
+        producers::video_file::ProducerConfig config;
+        config.asset_uri = path;
+        config.target_width = 64;
+        config.target_height = 36;
+        config.target_fps = 30.0;
+        config.stub_mode = true;
+        return std::make_unique<producers::video_file::VideoFileProducer>(
+            config, rb, clk, nullptr);
+      });
+
+  // Stub producers pace on the clock; run it at about real time
+  std::atomic<bool> clock_running{true};
+  std::thread clock_thread([&] {
+    while (clock_running.load()) {
+      clock->AdvanceMicroseconds(1'000);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  auto wait_ready = [&] {
+    auto* preview = dynamic_cast<producers::ISwitchableProducer*>(
+        controller.getPreviewSlot().producer.get());
+    for (int i = 0; i < 200 && preview && !preview->IsShadowDecodeReady(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return preview && preview->IsShadowDecodeReady();
+  };
+
+  ASSERT_TRUE(controller.loadPreviewAsset("test://first.mp4", "first", buffer, clock));
+  ASSERT_TRUE(wait_ready());
+  ASSERT_TRUE(controller.activatePreviewAsLive());
+  ASSERT_TRUE(controller.loadPreviewAsset("test://second.mp4", "second", buffer, clock));
+  ASSERT_TRUE(wait_ready());
+
+  auto* live = dynamic_cast<producers::ISwitchableProducer*>(
+      controller.getLiveSlot().producer.get());
+  ASSERT_NE(live, nullptr);
+  constexpr int64_t kFrameUs = 33'333;
+  const int64_t target_pts = live->GetNextPTS() + 4 * kFrameUs;
+  ASSERT_TRUE(controller.activatePreviewAsLive(nullptr, target_pts));
+  EXPECT_EQ(controller.getLiveSlot().asset_id, "second");
+
+  // Let the new live producer deliver a few frames past the splice
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  clock_running.store(false);
+  clock_thread.join();
+
+  int64_t last_first_pts = -1;
+  int64_t first_second_pts = -1;
+  bool first_second_is_splice = false;
+  size_t splices = 0;
+  buffer::FrameHandle frame;
+  while (buffer.Pop(frame)) {
+    if (frame->metadata.splice_point) {
+      ++splices;
+    }
+    if (buffer::AssetUri(frame->metadata.asset_id) == "test://first.mp4") {
+      EXPECT_EQ(first_second_pts, -1) << "Old producer frame after the splice";
+      EXPECT_LT(frame->metadata.pts, target_pts);
+      last_first_pts = frame->metadata.pts;
+    } else if (first_second_pts < 0) {
+      first_second_pts = frame->metadata.pts;
+      first_second_is_splice = frame->metadata.splice_point;
+    }
+  }
+
+  // The old producer runs up to the frame before the target, the new one
+  // starts on it, marked for an IDR
+  EXPECT_EQ(first_second_pts, target_pts);
+  EXPECT_TRUE(first_second_is_splice);
+  EXPECT_GE(last_first_pts, target_pts - kFrameUs - 1);
+  EXPECT_EQ(splices, 2u) << "One splice per switch";
+
+  const auto snapshot = controller.Snapshot();
+  EXPECT_EQ(snapshot.switch_total, 2u);
+  EXPECT_EQ(snapshot.last_switch_pts_us, target_pts);
+  EXPECT_GE(snapshot.last_switch_latency_ms, 0.0);
+  EXPECT_LT(snapshot.last_switch_latency_ms, 1'000.0);
+}
+
 }  // namespace retrovue::tests::contracts
 
@@ -2,13 +2,22 @@
 #include "../ContractRegistryEnvironment.h"
 
 #include <chrono>
+#include <cstdio>
+#include <sched.h>
 #include <thread>
+#include <vector>
 
 #include "retrovue/buffer/FrameRingBuffer.h"
 #include "retrovue/decode/FrameProducer.h"
 #include "retrovue/renderer/FrameRenderer.h"
 #include "retrovue/telemetry/MetricsExporter.h"
+#include "retrovue/runtime/ChannelCheckpoint.h"
+#include "retrovue/runtime/ChannelManifest.h"
+#include "retrovue/runtime/ChannelPlacement.h"
+#include "retrovue/runtime/LoadShedder.h"
 #include "retrovue/runtime/PlayoutControlStateMachine.h"
+#include "retrovue/runtime/PlayoutEngine.h"
+#include "retrovue/timing/MasterClock.h"
 #include "retrovue/producers/video_file/VideoFileProducer.h"
 #include "retrovue/playout.grpc.pb.h"
 #include "retrovue/playout.pb.h"
@@ -31,7 +40,8 @@ const bool kRegisterCoverage = []() {
   RegisterExpectedDomainCoverage(
       "PlayoutEngine",
       {"BC-001", "BC-002", "BC-003", "BC-004", "BC-005", "BC-006", "BC-007",
-       "LT-005", "LT-006"});
+       "BC-008", "BC-009", "BC-010", "BC-011", "BC-012", "BC-013", "BC-015",
+       "BC-016", "LT-005", "LT-006"});
   return true;
 }();
 
@@ -53,6 +63,14 @@ protected:
         "BC-005",
         "BC-006",
         "BC-007",
+        "BC-008",
+        "BC-009",
+        "BC-010",
+        "BC-011",
+        "BC-012",
+        "BC-013",
+        "BC-015",
+        "BC-016",
         "LT-005",
         "LT-006"};
   }
@@ -208,6 +226,476 @@ TEST_F(PlayoutEngineContractTest, BC_004_ChannelErrorIsolation)
   manager.StopChannel(channel_b, exporter);
 }
 
+// Rule: BC-008 Channel operations run in parallel (PlayoutEngineDomain.md §BC-008)
+TEST_F(PlayoutEngineContractTest, BC_008_ChannelOperationsDoNotSerialize)
+{
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  // Epoch 0 puts every frame decades late, so the renderer drains the ring
+  // and each start spends the full readiness timeout (2 s) before failing:
+  // a stand-in for an asset that is slow to open.
+  auto clock = timing::MakeSystemMasterClock(/*epoch_utc_us=*/0, 0.0);
+  runtime::PlayoutEngine engine(metrics, clock);
+
+  constexpr int kChannels = 4;
+  std::vector<std::thread> starts;
+  std::vector<int> succeeded(kChannels, -1);
+  const auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kChannels; ++i)
+  {
+    starts.emplace_back([&, i]()
+                        { succeeded[i] = engine.StartChannel(230 + i, "contract://playout/slow", 0).success; });
+  }
+  for (auto& start : starts)
+  {
+    start.join();
+  }
+  const double elapsed_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  for (int i = 0; i < kChannels; ++i)
+  {
+    EXPECT_EQ(succeeded[i], 0) << "Channel " << 230 + i << " should time out";
+  }
+  // Serialized, four timeouts take 8 s
+  EXPECT_LT(elapsed_s, 5.0) << "Slow starts on other channels blocked this one";
+  EXPECT_EQ(engine.DecodeThreadsInUse(), 0) << "Failed starts must return their decode threads";
+  EXPECT_FALSE(engine.StopChannel(230).success) << "Failed start must not leave the channel mapped";
+}
+
+// Rule: BC-009 Channel placement (PlayoutEngineDomain.md §BC-009)
+TEST_F(PlayoutEngineContractTest, BC_009_ChannelsArePackedAcrossNumaNodes)
+{
+  EXPECT_EQ(runtime::ParseCpuList("0-2,5"), (std::vector<int>{0, 1, 2, 5}));
+
+  runtime::PlacementPolicy policy;
+  policy.pack_numa_nodes = true;
+  policy.pacing_priority = 10;
+  runtime::ChannelPlacer placer(policy, {{0, 1}, {2, 3}});
+
+  // Unplaced channels alternate between the nodes, pinned to the node's CPUs
+  std::vector<runtime::ChannelPlacement> placed(4);
+  for (size_t i = 0; i < placed.size(); ++i)
+  {
+    ASSERT_TRUE(placer.Acquire(runtime::ChannelPlacement(), placed[i]));
+    EXPECT_EQ(placed[i].numa_node, static_cast<int>(i % 2));
+    EXPECT_EQ(placed[i].cpus, (i % 2 == 0 ? std::vector<int>{0, 1} : std::vector<int>{2, 3}));
+    EXPECT_EQ(placed[i].pacing_priority, 10);
+  }
+  EXPECT_EQ(placer.ChannelsOnNode(0), 2);
+  EXPECT_EQ(placer.ChannelsOnNode(1), 2);
+
+  // A released slot is refilled first
+  placer.Release(placed[1]);
+  runtime::ChannelPlacement refill;
+  ASSERT_TRUE(placer.Acquire(runtime::ChannelPlacement(), refill));
+  EXPECT_EQ(refill.numa_node, 1);
+
+  // Explicit requests win over packing
+  runtime::ChannelPlacement requested;
+  requested.cpus = {3};
+  requested.pacing_priority = 20;
+  runtime::ChannelPlacement resolved;
+  ASSERT_TRUE(placer.Acquire(requested, resolved));
+  EXPECT_EQ(resolved.numa_node, -1);
+  EXPECT_EQ(resolved.cpus, std::vector<int>{3});
+  EXPECT_EQ(resolved.pacing_priority, 20);
+
+  requested = runtime::ChannelPlacement();
+  requested.numa_node = 2;
+  EXPECT_FALSE(placer.Acquire(requested, resolved)) << "Unknown node must be refused";
+
+  // The engine refuses such a start without mapping the channel
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0));
+  requested.numa_node = static_cast<int>(runtime::NumaNodeCpus().size());
+  EXPECT_FALSE(engine.StartChannel(240, "contract://playout/placed", 0, std::nullopt, requested).success);
+  EXPECT_FALSE(engine.StopChannel(240).success) << "Refused start must not map the channel";
+
+  // A core set pins the thread that applies it
+  const int first_cpu = runtime::NumaNodeCpus().front().front();
+  int cpu = -1;
+  std::thread pinned([&]()
+                     {
+    runtime::ChannelPlacement placement;
+    placement.cpus = {first_cpu};
+    if (runtime::ApplyChannelPlacement(placement, /*pacing_thread=*/false, "BC-009"))
+    {
+      cpu = sched_getcpu();
+    } });
+  pinned.join();
+  EXPECT_EQ(cpu, first_cpu);
+}
+
+// Rule: BC-010 Buffer memory budget (PlayoutEngineDomain.md §BC-010)
+TEST_F(PlayoutEngineContractTest, BC_010_BuffersFitTheMemoryBudget)
+{
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  runtime::BufferPolicy policy;
+  policy.memory_budget_bytes = 10u << 20;
+  runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0),
+                                runtime::DecodeThreadBudget(), 0, nullptr,
+                                runtime::PlacementPolicy(), policy);
+
+  // Even the minimum depth of 1080p frames exceeds 10 MiB: refused up front
+  const auto begin = std::chrono::steady_clock::now();
+  const auto refused = engine.StartChannel(250, "contract://playout/budget", 0);
+  EXPECT_FALSE(refused.success);
+  EXPECT_NE(refused.message.find("budget"), std::string::npos) << refused.message;
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(1))
+      << "A refused buffer must fail before anything starts";
+  EXPECT_FALSE(engine.StopChannel(250).success);
+  EXPECT_EQ(engine.DecodeThreadsInUse(), 0);
+
+  // 480p fits once cut to the budget; the start then times out (epoch 0,
+  // see BC-008) and must hand its reservation back
+  runtime::ChannelBufferOptions sd;
+  sd.width = 720;
+  sd.height = 480;
+  EXPECT_FALSE(engine.StartChannel(251, "contract://playout/budget", 0, std::nullopt,
+                                   runtime::ChannelPlacement(), sd)
+                   .success);
+  const auto stats = engine.GetBufferBudgetStats();
+  EXPECT_EQ(stats.limit_bytes, 10u << 20);
+  EXPECT_EQ(stats.reserved_bytes, 0u) << "Failed start must release its frame memory";
+  EXPECT_EQ(engine.ResizeChannelBuffer(251, 500).success, false) << "Channel is not running";
+}
+
+// Rule: BC-011 Batch channel operations (PlayoutEngineDomain.md §BC-011)
+TEST_F(PlayoutEngineContractTest, BC_011_BatchStartsRunInParallel)
+{
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  // Epoch 0: every start waits out the readiness timeout (see BC-008)
+  runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0));
+
+  std::vector<runtime::ChannelStartRequest> starts(4);
+  for (size_t i = 0; i < starts.size(); ++i)
+  {
+    starts[i].channel_id = 260 + static_cast<int32_t>(i);
+    starts[i].plan_handle = "contract://playout/batch";
+  }
+  const auto begin = std::chrono::steady_clock::now();
+  const auto started = engine.StartChannels(starts);
+  const double elapsed_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  ASSERT_EQ(started.size(), starts.size()) << "One result per entry, in order";
+  for (size_t i = 0; i < started.size(); ++i)
+  {
+    EXPECT_FALSE(started[i].success) << "Channel " << starts[i].channel_id << " should time out";
+  }
+  // Serialized, four timeouts take 8 s
+  EXPECT_LT(elapsed_s, 5.0) << "Batch entries must not wait for each other";
+  EXPECT_EQ(engine.DecodeThreadsInUse(), 0);
+
+  const auto stopped = engine.StopChannels({260, 261, 999});
+  ASSERT_EQ(stopped.size(), 3u);
+  for (const auto& result : stopped)
+  {
+    EXPECT_FALSE(result.success) << "No channel of the batch is running";
+  }
+  EXPECT_TRUE(engine.StartChannels({}).empty());
+}
+
+// Rule: BC-012 Channel manifest restore (PlayoutEngineDomain.md §BC-012)
+TEST_F(PlayoutEngineContractTest, BC_012_ManifestRestoresRecordedChannels)
+{
+  const std::string path = ::testing::TempDir() + "retrovue_bc012_manifest";
+  std::remove(path.c_str());
+
+  runtime::ChannelStartRequest news;
+  news.channel_id = 270;
+  news.plan_handle = "contract://playout/news hour";  // Separators survive the encoding
+  news.port = 9270;
+  news.uds_path = "/run/retrovue/270.sock";
+  news.placement.cpus = {2, 3};
+  news.buffer.latency_ms = 500;
+  runtime::ChannelStartRequest movies;
+  movies.channel_id = 271;
+  movies.plan_handle = "contract://playout/movies";
+  {
+    runtime::ChannelManifest manifest(path);
+    std::vector<runtime::ChannelStartRequest> loaded;
+    ASSERT_TRUE(manifest.Load(loaded)) << "A missing manifest is an empty one";
+    EXPECT_TRUE(loaded.empty());
+    ASSERT_TRUE(manifest.Put(movies));
+    ASSERT_TRUE(manifest.Put(news));
+    ASSERT_TRUE(manifest.Update(270, [](runtime::ChannelStartRequest& entry) {
+      entry.plan_handle = "contract://playout/late news";
+    }));
+    ASSERT_TRUE(manifest.Remove(271));
+  }
+
+  runtime::ChannelManifest reloaded(path);
+  std::vector<runtime::ChannelStartRequest> channels;
+  ASSERT_TRUE(reloaded.Load(channels));
+  ASSERT_EQ(channels.size(), 1u) << "Removed channels must not come back";
+  EXPECT_EQ(channels[0].channel_id, 270);
+  EXPECT_EQ(channels[0].plan_handle, "contract://playout/late news");
+  EXPECT_EQ(channels[0].port, 9270);
+  ASSERT_TRUE(channels[0].uds_path.has_value());
+  EXPECT_EQ(*channels[0].uds_path, "/run/retrovue/270.sock");
+  EXPECT_EQ(channels[0].placement.cpus, (std::vector<int>{2, 3}));
+  EXPECT_EQ(channels[0].placement.numa_node, -1);
+  EXPECT_EQ(channels[0].buffer.latency_ms, 500);
+
+  // Epoch 0: the restored start times out (see BC-008) and stays recorded
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  {
+    runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0));
+    engine.SetChannelManifest(std::make_shared<runtime::ChannelManifest>(path));
+    const auto restored = engine.RestoreChannels();
+    ASSERT_EQ(restored.size(), 1u);
+    EXPECT_FALSE(restored[0].success);
+    telemetry::ChannelMetrics status;
+    ASSERT_TRUE(metrics->GetChannelMetrics(270, status)) << "Restore must report per channel";
+    EXPECT_EQ(status.state, telemetry::ChannelState::ERROR_STATE);
+  }
+  ASSERT_TRUE(reloaded.Load(channels));
+  ASSERT_EQ(channels.size(), 1u) << "A failed restore keeps the channel for the next restart";
+
+  runtime::PlayoutEngine unmanaged(metrics, timing::MakeSystemMasterClock(0, 0.0));
+  EXPECT_TRUE(unmanaged.RestoreChannels().empty()) << "No manifest, nothing to restore";
+  std::remove(path.c_str());
+}
+
+// Rule: BC-013 Overload load shedding (PlayoutEngineDomain.md §BC-013)
+TEST_F(PlayoutEngineContractTest, BC_013_LowPriorityChannelsDegradeFirst)
+{
+  using decode::DecodeDegradation;
+  runtime::LoadShedPolicy policy;
+  policy.enabled = true;
+  policy.protected_priority = 5;
+  policy.recovery_samples = 3;
+  runtime::LoadShedder shedder(policy);
+
+  // Best effort (0), standard (1) and premium (5) channels; the premium one
+  // is the one dropping late frames
+  std::vector<runtime::ChannelLoadSample> samples(3);
+  samples[0].channel_id = 280;
+  samples[1].channel_id = 281;
+  samples[1].priority = 1;
+  samples[2].channel_id = 282;
+  samples[2].priority = 5;
+  EXPECT_TRUE(shedder.Evaluate(samples).empty()) << "First sample is only a baseline";
+  EXPECT_FALSE(shedder.overloaded());
+
+  const auto overloaded_sample = [&]() {
+    samples[2].late_frames_total += 4;
+    return shedder.Evaluate(samples);
+  };
+  for (const DecodeDegradation expected :
+       {DecodeDegradation::kFastDecode, DecodeDegradation::kSkipNonReference,
+        DecodeDegradation::kKeyframesOnly})
+  {
+    const auto decisions = overloaded_sample();
+    ASSERT_EQ(decisions.size(), 1u);
+    EXPECT_EQ(decisions[0].channel_id, 280) << "Lowest priority degrades first";
+    EXPECT_EQ(decisions[0].level, expected);
+    EXPECT_EQ(shedder.LevelOf(281), DecodeDegradation::kNone);
+  }
+  for (int step = 0; step < 4; ++step)
+  {
+    overloaded_sample();
+  }
+  EXPECT_EQ(shedder.LevelOf(281), DecodeDegradation::kKeyframesOnly);
+  EXPECT_EQ(shedder.LevelOf(282), DecodeDegradation::kNone) << "Protected channels never degrade";
+  EXPECT_TRUE(overloaded_sample().empty()) << "Nothing left to shed";
+
+  // Recovery gives the higher tier its quality back first, a level per
+  // recovery_samples clean samples
+  for (int sample = 0; sample < 2; ++sample)
+  {
+    EXPECT_TRUE(shedder.Evaluate(samples).empty());
+  }
+  auto decisions = shedder.Evaluate(samples);
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].channel_id, 281);
+  EXPECT_EQ(decisions[0].level, DecodeDegradation::kSkipNonReference);
+  EXPECT_EQ(shedder.LevelOf(280), DecodeDegradation::kKeyframesOnly);
+
+  // Thin slack on a full-quality channel is overload too
+  samples[2].buffer_residency_seconds_sum += 0.010 * 30;  // 10 ms per frame
+  samples[2].buffer_residency_count += 30;
+  decisions = shedder.Evaluate(samples);
+  EXPECT_TRUE(shedder.overloaded());
+  ASSERT_EQ(decisions.size(), 1u);
+  EXPECT_EQ(decisions[0].channel_id, 281);
+  EXPECT_EQ(decisions[0].level, DecodeDegradation::kKeyframesOnly);
+
+  // Channels that stop are forgotten
+  samples.resize(1);
+  shedder.Evaluate(samples);
+  EXPECT_EQ(shedder.LevelOf(281), DecodeDegradation::kNone);
+
+  // The engine reports each running channel's level
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0),
+                                runtime::DecodeThreadBudget(), 0, nullptr,
+                                runtime::PlacementPolicy(), runtime::BufferPolicy(), policy);
+  DecodeDegradation level = DecodeDegradation::kNone;
+  EXPECT_FALSE(engine.GetChannelDegradation(280, level)) << "Channel is not running";
+}
+
+// Rule: BC-015 Host capacity and channel migration (PlayoutEngineDomain.md §BC-015)
+TEST_F(PlayoutEngineContractTest, BC_015_HostAdvertisesCapacityAndTimelines)
+{
+  // A channel's timeline clock puts PTS 0 at the requested UTC, whatever
+  // this host's own epoch is
+  const int64_t origin_utc_us = 1'700'000'000'000'000;
+  const auto host_clock = timing::MakeSystemMasterClock(1'600'000'000'000'000, 0.0);
+  const auto timeline = timing::MakeTimelineMasterClock(host_clock, origin_utc_us);
+  EXPECT_EQ(timeline->scheduled_to_utc_us(0), origin_utc_us);
+  EXPECT_EQ(timeline->scheduled_to_utc_us(33'366), origin_utc_us + 33'366);
+  EXPECT_EQ(timeline->is_fake(), host_clock->is_fake());
+
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  runtime::BufferPolicy buffer_policy;
+  buffer_policy.memory_budget_bytes = 64u << 20;
+  runtime::HostCapacityPolicy capacity;
+  capacity.host_id = "playout-a";
+  capacity.encoder_slots = 1;
+  // Epoch 0: starts time out (see BC-008)
+  runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0),
+                                runtime::DecodeThreadBudget(), 0, nullptr,
+                                runtime::PlacementPolicy(), buffer_policy,
+                                runtime::LoadShedPolicy(), capacity);
+
+  auto report = engine.GetHostCapacity();
+  EXPECT_EQ(report.host_id, "playout-a");
+  EXPECT_GT(report.cpu_cores, 0);
+  EXPECT_GE(report.cpu_busy_ratio, 0.0);
+  EXPECT_LE(report.cpu_busy_ratio, 1.0);
+  EXPECT_EQ(report.encoder_slots_total, 1);
+  EXPECT_EQ(report.encoder_slots_in_use, 0);
+  EXPECT_EQ(report.decode_threads_in_use, 0);
+  EXPECT_EQ(report.memory_budget_bytes, 64u << 20);
+  EXPECT_EQ(report.memory_reserved_bytes, 0u);
+  EXPECT_FALSE(report.clock_disciplined) << "A local clock lines up with no other host";
+  EXPECT_TRUE(report.channels.empty());
+
+  EXPECT_FALSE(engine.StartChannel(290, "contract://playout/migrate", 0, std::nullopt,
+                                   runtime::ChannelPlacement(), runtime::ChannelBufferOptions(),
+                                   0, origin_utc_us)
+                   .success);
+  report = engine.GetHostCapacity();
+  EXPECT_EQ(report.encoder_slots_in_use, 0) << "Failed start must return its encoder slot";
+  EXPECT_EQ(report.memory_reserved_bytes, 0u);
+  EXPECT_TRUE(report.channels.empty());
+
+  // The origin is recorded, so a restarted host rejoins the same timeline
+  const std::string path = ::testing::TempDir() + "retrovue_bc015_manifest";
+  std::remove(path.c_str());
+  runtime::ChannelStartRequest migrated;
+  migrated.channel_id = 291;
+  migrated.plan_handle = "contract://playout/migrate";
+  migrated.timeline_origin_utc_us = origin_utc_us;
+  ASSERT_TRUE(runtime::ChannelManifest(path).Put(migrated));
+  std::vector<runtime::ChannelStartRequest> channels;
+  ASSERT_TRUE(runtime::ChannelManifest(path).Load(channels));
+  ASSERT_EQ(channels.size(), 1u);
+  EXPECT_EQ(channels[0].timeline_origin_utc_us, origin_utc_us);
+  std::remove(path.c_str());
+}
+
+// Rule: BC-016 Crash-fast channel resume (PlayoutEngineDomain.md §BC-016)
+TEST_F(PlayoutEngineContractTest, BC_016_CheckpointsResumeChannelsOnSchedule)
+{
+  const std::string path = ::testing::TempDir() + "retrovue_bc016_checkpoint";
+  std::remove(path.c_str());
+  const int64_t origin_utc_us = 1'700'000'000'000'000;
+
+  runtime::ChannelCheckpoint news;
+  news.channel_id = 300;
+  news.plan_handle = "contract://playout/news hour";
+  news.timeline_origin_utc_us = origin_utc_us;
+  news.pts_us = 90'000'000;
+  news.written_utc_us = origin_utc_us + news.pts_us;
+  runtime::ChannelCheckpoint movies = news;
+  movies.channel_id = 301;
+  movies.plan_handle = "contract://playout/movies";
+  {
+    runtime::ChannelCheckpointFile checkpoints(path, 4);
+    ASSERT_TRUE(checkpoints.Open());
+    ASSERT_TRUE(checkpoints.Write(news));
+    ASSERT_TRUE(checkpoints.Write(movies));
+    news.pts_us += 250'000;
+    ASSERT_TRUE(checkpoints.Write(news)) << "A channel rewrites its own slot";
+    checkpoints.Clear(301);
+    runtime::ChannelCheckpoint too_long = movies;
+    too_long.plan_handle.assign(runtime::ChannelCheckpointFile::kMaxPlanBytes + 1, 'x');
+    EXPECT_FALSE(checkpoints.Write(too_long));
+  }
+
+  // What was written is there for the next process, without a close or sync
+  {
+    runtime::ChannelCheckpointFile reopened(path, 4);
+    ASSERT_TRUE(reopened.Open());
+    const auto all = reopened.ReadAll();
+    ASSERT_EQ(all.size(), 1u) << "Cleared channels must not come back";
+    EXPECT_EQ(all[0].channel_id, 300);
+    EXPECT_EQ(all[0].plan_handle, "contract://playout/news hour");
+    EXPECT_EQ(all[0].timeline_origin_utc_us, origin_utc_us);
+    EXPECT_EQ(all[0].pts_us, 90'250'000);
+  }
+
+  // A slot a crash left half written (odd sequence) reads as absent
+  {
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    const uint32_t writing = 7;
+    ASSERT_EQ(std::fseek(file, 64, SEEK_SET), 0);  // Sequence of the first slot
+    ASSERT_EQ(std::fwrite(&writing, sizeof(writing), 1, file), 1u);
+    std::fclose(file);
+    runtime::ChannelCheckpointFile torn(path, 4);
+    ASSERT_TRUE(torn.Open());
+    runtime::ChannelCheckpoint read;
+    EXPECT_FALSE(torn.Read(300, read));
+    EXPECT_TRUE(torn.Write(movies)) << "A torn slot is free again";
+  }
+
+  // Only a channel on this host's timeline, with the same plan, resumes
+  runtime::ChannelStartRequest request;
+  request.channel_id = 300;
+  request.plan_handle = news.plan_handle;
+  EXPECT_TRUE(runtime::ResumeFromCheckpoint(news, request));
+  EXPECT_EQ(request.timeline_origin_utc_us, origin_utc_us);
+  runtime::ChannelStartRequest replanned;
+  replanned.channel_id = 300;
+  replanned.plan_handle = "contract://playout/late news";
+  EXPECT_FALSE(runtime::ResumeFromCheckpoint(news, replanned));
+  EXPECT_EQ(replanned.timeline_origin_utc_us, 0);
+  runtime::ChannelStartRequest migrated = request;
+  migrated.timeline_origin_utc_us = origin_utc_us + 1;
+  EXPECT_FALSE(runtime::ResumeFromCheckpoint(news, migrated)) << "A requested origin wins";
+
+  // A failed start leaves no checkpoint behind; a failed restore keeps its own
+  const std::string manifest_path = ::testing::TempDir() + "retrovue_bc016_manifest";
+  std::remove(manifest_path.c_str());
+  runtime::ChannelStartRequest recorded;
+  recorded.channel_id = 301;
+  recorded.plan_handle = movies.plan_handle;
+  ASSERT_TRUE(runtime::ChannelManifest(manifest_path).Put(recorded));
+  auto metrics = std::make_shared<telemetry::MetricsExporter>(/*port=*/0);
+  auto checkpoints = std::make_shared<runtime::ChannelCheckpointFile>(path, 4);
+  ASSERT_TRUE(checkpoints->Open());
+  {
+    // Epoch 0: starts time out (see BC-008)
+    runtime::PlayoutEngine engine(metrics, timing::MakeSystemMasterClock(0, 0.0));
+    engine.SetChannelManifest(std::make_shared<runtime::ChannelManifest>(manifest_path));
+    engine.SetChannelCheckpoints(checkpoints, std::chrono::milliseconds(10));
+    EXPECT_FALSE(engine.StartChannel(302, "contract://playout/none", 0).success);
+    const auto restored = engine.RestoreChannels();
+    ASSERT_EQ(restored.size(), 1u);
+    EXPECT_FALSE(restored[0].success);
+  }
+  runtime::ChannelCheckpoint read;
+  EXPECT_FALSE(checkpoints->Read(302, read));
+  ASSERT_TRUE(checkpoints->Read(301, read)) << "The next restart can still resume it";
+  EXPECT_EQ(read.timeline_origin_utc_us, origin_utc_us);
+  std::remove(manifest_path.c_str());
+  std::remove(path.c_str());
+}
+
 // Rule: BC-002 Buffer Depth Guarantees (PlayoutEngineDomain.md §BC-002)
 TEST_F(PlayoutEngineContractTest, BC_002_BufferDepthRemainsWithinCapacity)
 {
@@ -241,8 +729,9 @@ TEST_F(PlayoutEngineContractTest, BC_007_DualProducerSwitchingSeamlessness)
   // - Ring buffer is NOT flushed during switch
   // - Renderer pipeline is NOT reset during switch
   
-  runtime::PlayoutControlStateMachine controller;
+  // The buffer outlives the controller, whose producers write into it
   buffer::FrameRingBuffer buffer(60);
+  runtime::PlayoutControlStateMachine controller;
   auto clock = std::make_shared<retrovue::timing::TestMasterClock>();
   const int64_t start_time = 1'700'000'000'000'000LL;
   clock->SetEpochUtcUs(start_time);
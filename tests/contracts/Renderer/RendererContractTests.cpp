@@ -3,9 +3,11 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "retrovue/buffer/FrameRingBuffer.h"
 #include "retrovue/renderer/FrameRenderer.h"
+#include "timing/TestMasterClock.h"
 
 using namespace retrovue;
 using namespace retrovue::tests;
@@ -17,7 +19,7 @@ namespace
 
   const bool kRegisterCoverage = []()
   {
-    RegisterExpectedDomainCoverage("Renderer", {"FE-001", "FE-002"});
+    RegisterExpectedDomainCoverage("Renderer", {"FE-001", "FE-002", "FE-007", "FE-008"});
     return true;
   }();
 
@@ -34,7 +36,9 @@ namespace
       return {
           "FE-001",
           "FE-002",
-          "FE-003"};
+          "FE-003",
+          "FE-007",
+          "FE-008"};
     }
   };
 
@@ -132,4 +136,113 @@ namespace
     renderer->Stop();
   }
 
+  // Records what the render loop hands it (called from the render thread only)
+  class CountingSink : public renderer::FrameSink
+  {
+  public:
+    bool Open() override
+    {
+      ++opens;
+      return true;
+    }
+
+    void WriteFrame(const buffer::Frame &frame, int64_t /*deadline_utc_us*/) override
+    {
+      pts.push_back(frame.metadata.pts);
+    }
+
+    void Close() override { ++closes; }
+
+    int opens = 0;
+    int closes = 0;
+    std::vector<int64_t> pts;
+  };
+
+  // Rule: FE-007 Sink Mode (RendererContract.md §FE-007)
+  TEST_F(RendererContractTest, FE_007_SinkModeWritesEachFrameToTheSinkInOrder)
+  {
+    buffer::FrameRingBuffer buffer(6);
+
+    for (int i = 0; i < 3; ++i)
+    {
+      buffer::Frame frame;
+      frame.metadata.pts = i;
+      frame.metadata.dts = i;
+      frame.metadata.duration = 1.0 / 30.0;
+      frame.width = 1280;
+      frame.height = 720;
+      ASSERT_TRUE(buffer.Push(frame));
+    }
+
+    auto sink = std::make_shared<CountingSink>();
+    renderer::RenderConfig config;
+    config.mode = renderer::RenderMode::SINK;
+    config.sink = sink;
+
+    std::shared_ptr<timing::MasterClock> clock;
+    std::shared_ptr<telemetry::MetricsExporter> metrics;
+    auto renderer = renderer::FrameRenderer::Create(config, buffer, clock, metrics, /*channel_id=*/0);
+    ASSERT_TRUE(renderer->Start());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    renderer->Stop();
+
+    EXPECT_EQ(sink->opens, 1);
+    EXPECT_EQ(sink->closes, 1);
+    EXPECT_EQ(sink->pts, (std::vector<int64_t>{0, 1, 2}));
+    EXPECT_EQ(renderer->GetStats().frames_rendered, 3u);
+    EXPECT_EQ(buffer.Size(), 0u);
+  }
+
+  // Rule: FE-008 Catch-Up Policy (RendererContract.md §FE-008)
+  TEST_F(RendererContractTest, FE_008_SkipToNowCatchesUpInOneBatchedDrop)
+  {
+    constexpr int64_t kFrameUs = 33'366;
+    const int64_t epoch = 1'700'000'000'000'000;
+    auto clock = std::make_shared<timing::TestMasterClock>(
+        epoch, timing::TestMasterClock::Mode::Deterministic);
+    clock->SetEpochUtcUs(epoch);
+    clock->SetRatePpm(0.0);
+
+    buffer::FrameRingBuffer buffer(64);
+    for (int i = 0; i < 30; ++i)
+    {
+      buffer::Frame frame;
+      frame.metadata.pts = i * kFrameUs;
+      frame.metadata.dts = frame.metadata.pts;
+      frame.metadata.duration = 1.0 / 30.0;
+      frame.width = 1280;
+      frame.height = 720;
+      ASSERT_TRUE(buffer.Push(frame));
+    }
+    // A stall: the first frame is 500 ms late, frames 0-14 are all due
+    clock->SetNow(epoch + 500'000, 0.5);
+
+    auto sink = std::make_shared<CountingSink>();
+    renderer::RenderConfig config;
+    config.mode = renderer::RenderMode::SINK;
+    config.sink = sink;
+    config.catch_up = renderer::CatchUpPolicy::kSkipToNow;
+
+    std::shared_ptr<telemetry::MetricsExporter> metrics;
+    auto renderer = renderer::FrameRenderer::Create(config, buffer, clock, metrics, /*channel_id=*/0);
+    ASSERT_TRUE(renderer->Start());
+
+    // The clock stands still, so the renderer waits on frame 15
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    renderer->Stop();
+
+    const renderer::RenderStats &stats = renderer->GetStats();
+    ASSERT_FALSE(sink->pts.empty());
+    EXPECT_EQ(sink->pts.front(), 14 * kFrameUs);
+    EXPECT_EQ(stats.frames_dropped, 14u);
+    EXPECT_EQ(stats.corrections_total, 1u);
+    EXPECT_EQ(stats.catch_up_skips, 1u);
+    EXPECT_GE(buffer.Size(), 14u);
+
+    // The stalled frame, the one it skipped to and the one waited on
+    const renderer::FrameTimingStats timing = renderer->GetTimingStats();
+    EXPECT_EQ(timing.slack_us.Count(), 3u);
+  }
+
 } // namespace
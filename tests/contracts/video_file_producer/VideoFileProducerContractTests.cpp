@@ -31,7 +31,8 @@ namespace
     RegisterExpectedDomainCoverage(
         "VideoFileProducer",
         {"FE-001", "FE-002", "FE-003", "FE-004", "FE-005", "FE-006", 
-         "FE-007", "FE-008", "FE-009", "FE-010", "FE-011", "FE-012"});
+         "FE-007", "FE-008", "FE-009", "FE-010", "FE-011", "FE-012",
+         "FE-013", "FE-014"});
     return true;
   }();
 
@@ -47,7 +48,8 @@ namespace
     {
       return {
           "FE-001", "FE-002", "FE-003", "FE-004", "FE-005", "FE-006", 
-          "FE-007", "FE-008", "FE-009", "FE-010", "FE-011", "FE-012"};
+          "FE-007", "FE-008", "FE-009", "FE-010", "FE-011", "FE-012",
+          "FE-013", "FE-014"};
     }
 
     void SetUp() override
@@ -190,7 +192,7 @@ namespace
       last_pts = frame.metadata.pts;
       ASSERT_LE(frame.metadata.dts, frame.metadata.pts);
       ASSERT_NEAR(frame.metadata.duration, 1.0 / config.target_fps, 0.001);
-      ASSERT_EQ(frame.metadata.asset_uri, config.asset_uri);
+      ASSERT_EQ(buffer::AssetUri(frame.metadata.asset_id), config.asset_uri);
       ASSERT_EQ(frame.width, config.target_width);
       ASSERT_EQ(frame.height, config.target_height);
       frame_count++;
@@ -434,6 +436,118 @@ namespace
     producer_->stop();
   }
 
+  // Rule: FE-013 Shadow Preroll (Stub Mode)
+  TEST_F(VideoFileProducerContractTest, FE_013_ShadowPrerollSplicedAtSwitch)
+  {
+    ProducerConfig config;
+    config.asset_uri = "test.mp4";
+    config.target_fps = 30.0;
+    config.stub_mode = true;
+    config.shadow_preroll_frames = 4;
+
+    producer_ = std::make_unique<VideoFileProducer>(config, *buffer_, clock_, MakeEventCallback());
+    producer_->SetShadowDecodeMode(true);
+    ASSERT_TRUE(producer_->start());
+
+    // Let the first stub frame set its deadline, then give the producer clock
+    // time for far more than the preroll
+    for (int i = 0; i < 100 && producer_->GetShadowPrerollDepth() < 1; ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    clock_->AdvanceSeconds(1.0);
+    for (int i = 0; i < 100 && producer_->GetShadowPrerollDepth() < 4; ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Preroll is staged privately and decoding holds once it is full
+    ASSERT_TRUE(producer_->IsShadowDecodeReady());
+    EXPECT_EQ(producer_->GetShadowPrerollDepth(), 4u);
+    EXPECT_TRUE(buffer_->IsEmpty());
+    EXPECT_EQ(producer_->GetFramesProduced(), 0u);
+
+    // Alignment re-stamps the staged frames
+    const int64_t target_pts = 5'000'000;
+    producer_->AlignPTS(target_pts);
+    EXPECT_EQ(producer_->GetNextPTS(), target_pts);
+
+    producer_->SetShadowDecodeMode(false);
+    for (int i = 0; i < 100 && buffer_->Size() < 4; ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_GE(buffer_->Size(), 4u);
+    EXPECT_EQ(producer_->GetShadowPrerollDepth(), 0u);
+
+    // Staged frames come out first, in order, continuing from target_pts
+    const int64_t frame_interval_us = 33'333;
+    buffer::Frame frame;
+    for (int i = 0; i < 4; ++i)
+    {
+      ASSERT_TRUE(buffer_->Pop(frame));
+      EXPECT_EQ(frame.metadata.pts, target_pts + i * frame_interval_us);
+    }
+
+    producer_->stop();
+  }
+
+  // Rule: FE-014 Hibernation (Stub Mode)
+  TEST_F(VideoFileProducerContractTest, FE_014_HibernationResumesOnSchedule)
+  {
+    ProducerConfig config;
+    config.asset_uri = "test.mp4";
+    config.target_fps = 30.0;
+    config.stub_mode = true;
+
+    producer_ = std::make_unique<VideoFileProducer>(config, *buffer_, clock_, MakeEventCallback());
+    ASSERT_TRUE(producer_->start());
+    for (int i = 0; i < 100 && producer_->GetFramesProduced() < 1; ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_GE(producer_->GetFramesProduced(), 1u);
+
+    // The frame waiting for its deadline completes, then the producer holds
+    producer_->Hibernate();
+    clock_->AdvanceSeconds(0.1);
+    for (int i = 0; i < 100 && !producer_->IsHibernating(); ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(producer_->IsHibernating());
+    int64_t last_pts = -1;
+    buffer::Frame frame;
+    while (buffer_->Pop(frame))
+    {
+      last_pts = frame.metadata.pts;
+    }
+    ASSERT_GE(last_pts, 0);
+
+    // Nothing is produced while hibernating, however far the clock moves
+    const uint64_t produced = producer_->GetFramesProduced();
+    clock_->AdvanceSeconds(10.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_TRUE(producer_->IsHibernating());
+    EXPECT_EQ(producer_->GetFramesProduced(), produced);
+    EXPECT_TRUE(buffer_->IsEmpty());
+
+    // Waking resumes where the schedule is now, not where it paused
+    producer_->Wake();
+    for (int i = 0; i < 100 && buffer_->IsEmpty(); ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(producer_->IsHibernating());
+    ASSERT_TRUE(buffer_->Pop(frame));
+    const int64_t frame_interval_us = 33'333;
+    const int64_t skipped_frames = 10'000'000 / frame_interval_us;
+    EXPECT_EQ(frame.metadata.pts, last_pts + (skipped_frames + 1) * frame_interval_us);
+
+    producer_->stop();
+  }
+
   // Contract requirement: Ready event emitted
   TEST_F(VideoFileProducerContractTest, ReadyEventEmitted)
   {
@@ -29,7 +29,7 @@ class FrameFactory {
     frame.metadata.pts = pts_us;
     frame.metadata.dts = pts_us;
     frame.metadata.duration = 1.0 / 30.0;  // 30 fps default
-    frame.metadata.asset_uri = "test://synthetic_frame";
+    frame.metadata.asset_id = buffer::InternAsset("test://synthetic_frame");
     frame.width = width;
     frame.height = height;
 
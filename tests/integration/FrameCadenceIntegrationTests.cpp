@@ -57,7 +57,7 @@ public:
     frame.metadata.dts = pts_counter_;
     frame.metadata.duration =
         static_cast<double>(pts_step_us_) / 1'000'000.0;
-    frame.metadata.asset_uri = "integration://cadence/stub";
+    frame.metadata.asset_id = buffer::InternAsset("integration://cadence/stub");
     frame.width = 1920;
     frame.height = 1080;
 
@@ -3,9 +3,19 @@
 // Purpose: Tests ring buffer push/pop, starvation, and overflow logic.
 // Copyright (c) 2025 RetroVue
 
+#include "retrovue/buffer/ChannelArena.h"
+#include "retrovue/buffer/FrameBroadcastRing.h"
+#include "retrovue/buffer/FrameMemoryBudget.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/buffer/SharedFrameExport.h"
 
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -29,7 +39,7 @@ TEST(FrameRingBufferTest, SinglePushPop) {
   frame.metadata.pts = 1000;
   frame.metadata.dts = 1000;
   frame.metadata.duration = 0.033;
-  frame.metadata.asset_uri = "test://asset";
+  frame.metadata.asset_id = InternAsset("test://asset");
   frame.width = 1920;
   frame.height = 1080;
   
@@ -43,7 +53,7 @@ TEST(FrameRingBufferTest, SinglePushPop) {
   EXPECT_TRUE(buffer.IsEmpty());
   
   EXPECT_EQ(popped.metadata.pts, 1000);
-  EXPECT_EQ(popped.metadata.asset_uri, "test://asset");
+  EXPECT_EQ(AssetUri(popped.metadata.asset_id), "test://asset");
   EXPECT_EQ(popped.width, 1920);
 }
 
@@ -180,6 +190,776 @@ TEST(FrameRingBufferTest, PopFromEmpty) {
   EXPECT_TRUE(buffer.IsEmpty());
 }
 
+// Test pooled handles travel through the buffer without copying the payload
+TEST(FrameRingBufferTest, PooledHandlePushPopIsZeroCopy) {
+  auto pool = FramePool::Create(4, 1024);
+  FrameRingBuffer buffer(10);
+
+  FrameHandle handle = pool->Acquire();
+  ASSERT_TRUE(handle);
+  handle->metadata.pts = 42;
+  handle->data.resize(1024, 7);
+  const uint8_t* payload = handle->data.data();
+  EXPECT_EQ(pool->Available(), 3u);
+
+  ASSERT_TRUE(buffer.Push(std::move(handle)));
+  EXPECT_FALSE(handle);
+  ASSERT_NE(buffer.Peek(), nullptr);
+  EXPECT_EQ(buffer.Peek()->data.data(), payload);
+
+  FrameHandle popped;
+  ASSERT_TRUE(buffer.Pop(popped));
+  ASSERT_TRUE(popped);
+  EXPECT_EQ(popped->metadata.pts, 42);
+  EXPECT_EQ(popped->data.data(), payload);
+
+  popped.Reset();
+  EXPECT_EQ(pool->Available(), 4u);
+}
+
+// Test pool exhaustion and slot recycling
+TEST(FrameRingBufferTest, FramePoolExhaustionAndReuse) {
+  auto pool = FramePool::Create(2, 64);
+
+  FrameHandle a = pool->Acquire();
+  FrameHandle b = pool->Acquire();
+  ASSERT_TRUE(a);
+  ASSERT_TRUE(b);
+  EXPECT_FALSE(pool->Acquire());
+  EXPECT_EQ(pool->ExhaustedCount(), 1u);
+
+  FrameHandle shared = a;
+  EXPECT_EQ(a.use_count(), 2u);
+  a.Reset();
+  EXPECT_EQ(pool->Available(), 0u);  // Still referenced by |shared|
+  shared.Reset();
+  EXPECT_EQ(pool->Available(), 1u);
+
+  FrameHandle c = pool->Acquire();
+  EXPECT_TRUE(c);
+  EXPECT_GE(c->data.capacity(), 64u);
+}
+
+// Test handles keep the pool alive after the owner drops it
+TEST(FrameRingBufferTest, HandleOutlivesPool) {
+  FrameRingBuffer buffer(4);
+  {
+    auto pool = FramePool::Create(1, 16);
+    FrameHandle handle = pool->Acquire();
+    handle->metadata.pts = 7;
+    ASSERT_TRUE(buffer.Push(std::move(handle)));
+  }
+
+  FrameHandle popped;
+  ASSERT_TRUE(buffer.Pop(popped));
+  EXPECT_EQ(popped->metadata.pts, 7);
+}
+
+// Test mixing by-value and pooled frames preserves order
+TEST(FrameRingBufferTest, MixedValueAndHandleFrames) {
+  auto pool = FramePool::Create(2, 16);
+  FrameRingBuffer buffer(4);
+
+  Frame value_frame;
+  value_frame.metadata.pts = 1;
+  ASSERT_TRUE(buffer.Push(value_frame));
+
+  FrameHandle handle = pool->Acquire();
+  handle->metadata.pts = 2;
+  ASSERT_TRUE(buffer.Push(std::move(handle)));
+
+  FrameHandle first;
+  ASSERT_TRUE(buffer.Pop(first));
+  EXPECT_EQ(first->metadata.pts, 1);
+
+  Frame second;
+  ASSERT_TRUE(buffer.Pop(second));
+  EXPECT_EQ(second.metadata.pts, 2);
+  EXPECT_EQ(pool->Available(), 2u);
+}
+
+// Test Clear returns queued handles to the pool
+TEST(FrameRingBufferTest, ClearReleasesPooledFrames) {
+  auto pool = FramePool::Create(3, 16);
+  FrameRingBuffer buffer(4);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(buffer.Push(pool->Acquire()));
+  }
+  EXPECT_EQ(pool->Available(), 0u);
+
+  buffer.Clear();
+  EXPECT_TRUE(buffer.IsEmpty());
+  EXPECT_EQ(pool->Available(), 3u);
+}
+
+// Test WaitForFrame times out on an empty buffer
+TEST(FrameRingBufferTest, WaitForFrameTimesOut) {
+  FrameRingBuffer buffer(4);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(buffer.WaitForFrame(start + std::chrono::milliseconds(20)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+
+// Test WaitForFrame wakes on push well before its deadline
+TEST(FrameRingBufferTest, WaitForFrameWakesOnPush) {
+  FrameRingBuffer buffer(4);
+
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Frame frame;
+    frame.metadata.pts = 1;
+    buffer.Push(frame);
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(buffer.WaitForFrame(start + std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  producer.join();
+
+  Frame popped;
+  ASSERT_TRUE(buffer.Pop(popped));
+  EXPECT_EQ(popped.metadata.pts, 1);
+}
+
+// Test WaitForSpace wakes on pop when the buffer is full
+TEST(FrameRingBufferTest, WaitForSpaceWakesOnPop) {
+  FrameRingBuffer buffer(2);
+  Frame frame;
+  ASSERT_TRUE(buffer.Push(frame));
+  ASSERT_TRUE(buffer.Push(frame));
+  ASSERT_TRUE(buffer.IsFull());
+  EXPECT_FALSE(buffer.WaitForSpace(std::chrono::steady_clock::now() +
+                                   std::chrono::milliseconds(5)));
+
+  std::thread consumer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Frame popped;
+    buffer.Pop(popped);
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(buffer.WaitForSpace(start + std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  consumer.join();
+  EXPECT_TRUE(buffer.Push(frame));
+}
+
+// Test WakeWaiters releases a blocked waiter without a frame
+TEST(FrameRingBufferTest, WakeWaitersInterruptsWait) {
+  FrameRingBuffer buffer(4);
+
+  std::thread waker([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    buffer.WakeWaiters();
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(buffer.WaitForFrame(start + std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  waker.join();
+}
+
+// Test blocking producer/consumer hand-off preserves order
+TEST(FrameRingBufferTest, BlockingProducerConsumer) {
+  const int num_frames = 1000;
+  FrameRingBuffer buffer(8);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < num_frames; ++i) {
+      Frame frame;
+      frame.metadata.pts = i;
+      while (!buffer.Push(frame)) {
+        buffer.WaitForSpace(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+      }
+    }
+  });
+
+  int expected_pts = 0;
+  while (expected_pts < num_frames) {
+    Frame frame;
+    if (buffer.Pop(frame)) {
+      ASSERT_EQ(frame.metadata.pts, expected_pts++);
+    } else {
+      buffer.WaitForFrame(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+    }
+  }
+
+  producer.join();
+  EXPECT_TRUE(buffer.IsEmpty());
+}
+
+// Test PeekRange returns queued frames in order without consuming them
+TEST(FrameRingBufferTest, PeekRange) {
+  FrameRingBuffer buffer(8);
+  for (int i = 0; i < 5; ++i) {
+    Frame frame;
+    frame.metadata.pts = i;
+    ASSERT_TRUE(buffer.Push(frame));
+  }
+
+  std::array<const Frame*, 3> peeked{};
+  ASSERT_EQ(buffer.PeekRange(peeked), 3u);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(peeked[i]->metadata.pts, i);
+  }
+  EXPECT_EQ(buffer.Size(), 5u);
+
+  std::array<const Frame*, 10> all{};
+  EXPECT_EQ(buffer.PeekRange(all), 5u);
+}
+
+// Test PopBatch moves several frames out with one call
+TEST(FrameRingBufferTest, PopBatch) {
+  auto pool = FramePool::Create(6, 16);
+  FrameRingBuffer buffer(8);
+  for (int i = 0; i < 6; ++i) {
+    FrameHandle handle = pool->Acquire();
+    handle->metadata.pts = i;
+    ASSERT_TRUE(buffer.Push(std::move(handle)));
+  }
+
+  std::array<FrameHandle, 4> batch;
+  ASSERT_EQ(buffer.PopBatch(batch), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(batch[i]->metadata.pts, i);
+  }
+  EXPECT_EQ(buffer.Size(), 2u);
+  EXPECT_EQ(buffer.PopBatch(batch), 2u);
+  EXPECT_EQ(batch[0]->metadata.pts, 4);
+  EXPECT_TRUE(buffer.IsEmpty());
+}
+
+// Test PushBatch publishes what fits and leaves the rest with the caller
+TEST(FrameRingBufferTest, PushBatch) {
+  auto pool = FramePool::Create(6, 16);
+  FrameRingBuffer buffer(4);
+  ASSERT_TRUE(buffer.Push(pool->Acquire()));
+
+  std::array<FrameHandle, 5> batch;
+  for (int i = 0; i < 5; ++i) {
+    batch[i] = pool->Acquire();
+    batch[i]->metadata.pts = 100 + i;
+  }
+  ASSERT_EQ(buffer.PushBatch(batch), 3u);
+  EXPECT_TRUE(buffer.IsFull());
+  EXPECT_FALSE(batch[2]);
+  ASSERT_TRUE(batch[3]);
+  EXPECT_EQ(batch[3]->metadata.pts, 103);
+  EXPECT_EQ(buffer.GetStats().frames_pushed, 4u);
+
+  ASSERT_EQ(buffer.Discard(1), 1u);
+  for (int i = 0; i < 3; ++i) {
+    FrameHandle handle;
+    ASSERT_TRUE(buffer.Pop(handle));
+    EXPECT_EQ(handle->metadata.pts, 100 + i);
+  }
+  EXPECT_EQ(buffer.PushBatch(std::span<FrameHandle>(batch).subspan(3)), 2u);
+  EXPECT_EQ(buffer.Size(), 2u);
+}
+
+// Test DiscardUntilPts drops only stale frames and releases pooled slots
+TEST(FrameRingBufferTest, DiscardUntilPts) {
+  auto pool = FramePool::Create(8, 16);
+  FrameRingBuffer buffer(8);
+  for (int i = 0; i < 8; ++i) {
+    FrameHandle handle = pool->Acquire();
+    handle->metadata.pts = i * 1000;
+    ASSERT_TRUE(buffer.Push(std::move(handle)));
+  }
+  EXPECT_EQ(pool->Available(), 0u);
+
+  EXPECT_EQ(buffer.DiscardUntilPts(5000), 5u);
+  EXPECT_EQ(buffer.Size(), 3u);
+  EXPECT_EQ(pool->Available(), 5u);
+  ASSERT_NE(buffer.Peek(), nullptr);
+  EXPECT_EQ(buffer.Peek()->metadata.pts, 5000);
+
+  EXPECT_EQ(buffer.DiscardUntilPts(0), 0u);
+  EXPECT_EQ(buffer.DiscardUntilPts(1'000'000), 3u);
+  EXPECT_TRUE(buffer.IsEmpty());
+}
+
+// Test Discard across the wrap-around point
+TEST(FrameRingBufferTest, DiscardWrapsAround) {
+  FrameRingBuffer buffer(4);
+  Frame frame;
+  for (int i = 0; i < 3; ++i) {
+    frame.metadata.pts = i;
+    ASSERT_TRUE(buffer.Push(frame));
+  }
+  Frame popped;
+  ASSERT_TRUE(buffer.Pop(popped));
+  ASSERT_TRUE(buffer.Pop(popped));
+  for (int i = 3; i < 6; ++i) {
+    frame.metadata.pts = i;
+    ASSERT_TRUE(buffer.Push(frame));
+  }
+
+  EXPECT_EQ(buffer.Discard(3), 3u);
+  ASSERT_TRUE(buffer.Pop(popped));
+  EXPECT_EQ(popped.metadata.pts, 5);
+  EXPECT_EQ(buffer.Discard(10), 0u);
+}
+
+// Test counters, water marks and occupancy histogram
+TEST(FrameRingBufferTest, StatsTrackOccupancy) {
+  FrameRingBuffer buffer(8);
+  Frame frame;
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_TRUE(buffer.Push(frame));
+  }
+  EXPECT_FALSE(buffer.Push(frame));
+  EXPECT_FALSE(buffer.Push(frame));
+
+  Frame popped;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_TRUE(buffer.Pop(popped));
+  }
+  EXPECT_EQ(buffer.Discard(1), 1u);
+
+  BufferStats stats = buffer.GetStats();
+  EXPECT_EQ(stats.frames_pushed, 8u);
+  EXPECT_EQ(stats.push_failures, 2u);
+  EXPECT_EQ(stats.frames_popped, 6u);
+  EXPECT_EQ(stats.frames_discarded, 1u);
+  EXPECT_EQ(stats.high_water_frames, 8u);
+  EXPECT_EQ(stats.low_water_frames, 2u);
+  EXPECT_EQ(stats.occupancy_sum_frames, 36u);  // 1 + 2 + ... + 8
+  for (size_t i = 0; i < kOccupancyBuckets; ++i) {
+    EXPECT_EQ(stats.occupancy_histogram[i], 1u) << "bucket " << i;
+  }
+
+  buffer.ResetWaterMarks();
+  stats = buffer.GetStats();
+  EXPECT_EQ(stats.high_water_frames, 1u);
+  EXPECT_EQ(stats.low_water_frames, 1u);
+  EXPECT_EQ(stats.residency_max_us, 0u);
+  EXPECT_EQ(stats.frames_pushed, 8u);
+}
+
+// Test push-to-pop residency is measured for popped frames
+TEST(FrameRingBufferTest, StatsMeasureResidency) {
+  FrameRingBuffer buffer(4);
+  auto pool = FramePool::Create(2, 0);
+  FrameHandle handle = pool->Acquire();
+  ASSERT_TRUE(buffer.Push(std::move(handle)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  ASSERT_TRUE(buffer.Pop(handle));
+  const BufferStats stats = buffer.GetStats();
+  EXPECT_EQ(stats.frames_popped, 1u);
+  EXPECT_GE(stats.residency_max_us, 5'000u);
+  EXPECT_EQ(stats.residency_total_us, stats.residency_max_us);
+  EXPECT_GE(stats.AverageResidencyUs(), 5'000.0);
+}
+
+// Test the depth limit caps occupancy below capacity and can be raised and lowered
+TEST(FrameRingBufferTest, DepthLimit) {
+  FrameRingBuffer buffer(8);
+  EXPECT_EQ(buffer.DepthLimit(), 8u);
+  buffer.SetDepthLimit(3);
+  EXPECT_EQ(buffer.Capacity(), 8u);
+
+  Frame frame;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(buffer.Push(frame));
+  }
+  EXPECT_TRUE(buffer.IsFull());
+  EXPECT_FALSE(buffer.Push(frame));
+
+  // Lowering keeps queued frames; pushes resume once it drains below the limit
+  buffer.SetDepthLimit(1);
+  EXPECT_EQ(buffer.Size(), 3u);
+  Frame popped;
+  ASSERT_TRUE(buffer.Pop(popped));
+  ASSERT_TRUE(buffer.Pop(popped));
+  EXPECT_FALSE(buffer.Push(frame));
+  ASSERT_TRUE(buffer.Pop(popped));
+  EXPECT_TRUE(buffer.Push(frame));
+
+  // Raising wakes a producer waiting for space
+  std::thread raiser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    buffer.SetDepthLimit(100);  // Clamped to capacity
+  });
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(buffer.WaitForSpace(start + std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  raiser.join();
+  EXPECT_EQ(buffer.DepthLimit(), 8u);
+}
+
+// Test the memory budget refuses growth beyond its limit but always allows shrinking
+TEST(FrameMemoryBudgetTest, ReservesWithinLimit) {
+  FrameMemoryBudget budget(1000);
+  EXPECT_TRUE(budget.Reserve(600));
+  EXPECT_FALSE(budget.Reserve(500));
+  EXPECT_EQ(budget.Available(), 400u);
+
+  EXPECT_TRUE(budget.Resize(600, 900));
+  EXPECT_FALSE(budget.Resize(900, 1100));
+  EXPECT_TRUE(budget.Resize(900, 200));
+  budget.Release(200);
+
+  const FrameMemoryBudgetStats stats = budget.GetStats();
+  EXPECT_EQ(stats.reserved_bytes, 0u);
+  EXPECT_EQ(stats.refusals, 2u);
+
+  FrameMemoryBudget unlimited;
+  EXPECT_TRUE(unlimited.Reserve(size_t{1} << 40));
+}
+
+// Test depth follows latency at the frame rate
+TEST(FrameMemoryBudgetTest, DepthForLatency) {
+  EXPECT_EQ(DepthForLatency(2000, 30.0), 60u);
+  EXPECT_EQ(DepthForLatency(250, 29.97), 8u);
+  EXPECT_EQ(DepthForLatency(0, 30.0), 1u);
+  EXPECT_EQ(Yuv420FrameBytes(1920, 1080), 3'110'400u);
+}
+
+// Test every broadcast reader sees every frame, sharing one payload
+TEST(FrameBroadcastRingTest, AllReadersSeeAllFrames) {
+  auto pool = FramePool::Create(8, 32);
+  FrameBroadcastRing ring(4, 3);
+  const int renderer = ring.AddReader();
+  const int sink = ring.AddReader();
+  ASSERT_NE(renderer, FrameBroadcastRing::kInvalidReader);
+  ASSERT_NE(sink, FrameBroadcastRing::kInvalidReader);
+  EXPECT_EQ(ring.ReaderCount(), 2u);
+
+  FrameHandle handle = pool->Acquire();
+  handle->metadata.pts = 10;
+  const Frame* shared = handle.get();
+  ASSERT_TRUE(ring.Push(std::move(handle)));
+
+  FrameHandle a;
+  FrameHandle b;
+  ASSERT_TRUE(ring.Pop(renderer, a));
+  ASSERT_TRUE(ring.Pop(sink, b));
+  EXPECT_EQ(a.get(), shared);
+  EXPECT_EQ(b.get(), shared);
+  EXPECT_EQ(a->metadata.pts, 10);
+  EXPECT_FALSE(ring.Pop(renderer, a));
+}
+
+// Test the slowest reader applies backpressure to the producer
+TEST(FrameBroadcastRingTest, SlowestReaderSetsBackpressure) {
+  FrameBroadcastRing ring(3, 2);
+  const int fast = ring.AddReader();
+  const int slow = ring.AddReader();
+
+  Frame frame;
+  for (int i = 0; i < 3; ++i) {
+    frame.metadata.pts = i;
+    ASSERT_TRUE(ring.Push(frame));
+  }
+
+  FrameHandle handle;
+  while (ring.Pop(fast, handle)) {
+  }
+  EXPECT_EQ(ring.Size(fast), 0u);
+  EXPECT_EQ(ring.Size(slow), 3u);
+  EXPECT_TRUE(ring.IsFull());
+  EXPECT_FALSE(ring.Push(frame));
+
+  ASSERT_TRUE(ring.Pop(slow, handle));
+  EXPECT_EQ(handle->metadata.pts, 0);
+  EXPECT_FALSE(ring.IsFull());
+  frame.metadata.pts = 3;
+  EXPECT_TRUE(ring.Push(frame));
+}
+
+// Test removing a stalled reader releases backpressure; new readers start live
+TEST(FrameBroadcastRingTest, ReaderRegistration) {
+  FrameBroadcastRing ring(2, 2);
+  const int stalled = ring.AddReader();
+  Frame frame;
+  ASSERT_TRUE(ring.Push(frame));
+  ASSERT_TRUE(ring.Push(frame));
+  EXPECT_FALSE(ring.Push(frame));
+
+  ring.RemoveReader(stalled);
+  EXPECT_EQ(ring.ReaderCount(), 0u);
+  EXPECT_TRUE(ring.Push(frame));
+
+  const int late = ring.AddReader();
+  ASSERT_NE(late, FrameBroadcastRing::kInvalidReader);
+  EXPECT_EQ(ring.Size(late), 0u);
+  EXPECT_EQ(ring.Peek(late), nullptr);
+
+  const int second = ring.AddReader();
+  EXPECT_NE(second, FrameBroadcastRing::kInvalidReader);
+  EXPECT_EQ(ring.AddReader(), FrameBroadcastRing::kInvalidReader);
+}
+
+// Test one producer feeding two concurrent readers in order
+TEST(FrameBroadcastRingTest, ConcurrentReaders) {
+  const int num_frames = 1000;
+  auto pool = FramePool::Create(16, 16);
+  FrameBroadcastRing ring(8, 2);
+  const int readers[2] = {ring.AddReader(), ring.AddReader()};
+
+  std::thread producer([&]() {
+    for (int i = 0; i < num_frames; ++i) {
+      FrameHandle handle;
+      while (!(handle = pool->Acquire())) {
+        std::this_thread::yield();
+      }
+      handle->metadata.pts = i;
+      while (!ring.Push(std::move(handle))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<std::thread> consumers;
+  std::atomic<int> mismatches{0};
+  for (int reader : readers) {
+    consumers.emplace_back([&, reader]() {
+      int expected_pts = 0;
+      while (expected_pts < num_frames) {
+        FrameHandle handle;
+        if (ring.Pop(reader, handle)) {
+          if (handle->metadata.pts != expected_pts++) {
+            mismatches.fetch_add(1);
+          }
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  producer.join();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+}
+
+// Asset URIs intern to stable ids; the empty URI is kNoAsset
+TEST(AssetRegistryTest, InternsStableIds) {
+  const AssetId first = InternAsset("test://registry/first.mp4");
+  const AssetId second = InternAsset("test://registry/second.mp4");
+  EXPECT_NE(first, kNoAsset);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(InternAsset("test://registry/first.mp4"), first);
+  EXPECT_EQ(AssetUri(first), "test://registry/first.mp4");
+  EXPECT_EQ(AssetUri(second), "test://registry/second.mp4");
+  EXPECT_EQ(InternAsset(""), kNoAsset);
+  EXPECT_EQ(AssetUri(kNoAsset), "");
+}
+
+// Frame metadata copies as plain bytes, trace included
+TEST(AssetRegistryTest, MetadataCopiesWithoutAllocation) {
+  static_assert(std::is_trivially_copyable_v<FrameMetadata>);
+  FrameMetadata metadata(90, 90, 1.0 / 30.0, InternAsset("test://registry/copy.mp4"));
+  metadata.trace.MarkAt(FrameStage::kDemuxed, (int64_t{1} << 32) - 10);
+  metadata.trace.Mark(FrameStage::kDecoded);
+  metadata.trace.MarkAt(FrameStage::kScaled, (int64_t{1} << 32) + 15);
+  const FrameMetadata copy = metadata;
+  EXPECT_TRUE(copy.trace.sampled());
+  EXPECT_EQ(AssetUri(copy.asset_id), "test://registry/copy.mp4");
+  // Stage times wrap at 32 bits; deltas stay exact
+  EXPECT_EQ(FrameTrace::StageDeltaUs(copy.trace.At(FrameStage::kDemuxed),
+                                     copy.trace.At(FrameStage::kScaled)),
+            25);
+}
+
+// Layout() pads each plane's rows to the SIMD alignment; frames filled
+// without Layout() read as packed I420
+TEST(FrameLayoutTest, AlignsPlanesAndFallsBackToPackedI420) {
+  Frame frame;
+  frame.Layout(PixelFormat::kNV12, 1000, 100);
+  EXPECT_EQ(frame.width, 1000);
+  EXPECT_EQ(frame.height, 100);
+  EXPECT_EQ(frame.Stride(0), 1024);
+  EXPECT_EQ(frame.Stride(1), 1024);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.data.data()) % kFrameAlignment, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.Plane(1)) % kFrameAlignment, 0u);
+  EXPECT_EQ(frame.Plane(1) - frame.Plane(0), 1024 * 100);
+  EXPECT_EQ(frame.data.size(), Frame::LayoutBytes(PixelFormat::kNV12, 1000, 100));
+
+  frame.Layout(PixelFormat::kP010, 1000, 100);
+  EXPECT_EQ(frame.Stride(0), 2048);  // Two bytes per sample
+  EXPECT_EQ(frame.data.size(), 2048u * 150u);
+
+  Frame packed;
+  packed.width = 64;
+  packed.height = 32;
+  packed.data.assign(64 * 32 * 3 / 2, 0);
+  EXPECT_EQ(packed.format, PixelFormat::kI420);
+  EXPECT_EQ(packed.Stride(0), 64);
+  EXPECT_EQ(packed.Stride(1), 32);
+  EXPECT_EQ(packed.Plane(1) - packed.Plane(0), 64 * 32);
+  EXPECT_EQ(packed.Plane(2) - packed.Plane(1), 64 * 32 / 4);
+  EXPECT_EQ(packed.LayoutBytes(), packed.data.size());
+}
+
+// Test freed arena blocks are reused by size and returned once released
+TEST(ChannelArenaTest, ReusesBlocksAndReturnsThemOnRelease) {
+  auto arena = ChannelArena::Create(4 * 1024 * 1024);
+  EXPECT_EQ(ChannelArena::RoundedSize(100), 128u);
+  EXPECT_EQ(ChannelArena::RoundedSize(3'110'400), 3'145'728u);
+
+  void* big = arena->Allocate(3'110'400);
+  void* small = arena->Allocate(100);
+  ASSERT_NE(big, nullptr);
+  ASSERT_NE(small, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % ChannelArena::kAlignment, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % ChannelArena::kAlignment, 0u);
+  EXPECT_EQ(arena->GetStats().bytes_in_use, 3'145'728u + 128u);
+
+  ChannelArena::Free(big);
+  EXPECT_EQ(arena->Allocate(3'100'000), big);  // Same rounded size
+  ChannelArenaStats stats = arena->GetStats();
+  EXPECT_EQ(stats.allocations, 2u);
+  EXPECT_EQ(stats.reuses, 1u);
+
+  // Beyond the cache cap blocks go straight back
+  void* second = arena->Allocate(3'110'400);
+  ChannelArena::Free(big);
+  ChannelArena::Free(second);
+  EXPECT_EQ(arena->GetStats().bytes_cached, 3'145'728u);
+
+  arena->Release();
+  ChannelArena::Free(small);
+  stats = arena->GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 0u);
+  EXPECT_EQ(stats.bytes_cached, 0u);
+  EXPECT_EQ(stats.peak_bytes_in_use, 2u * 3'145'728u + 128u);
+}
+
+// Test pooled frames draw from the arena and blocks keep it alive
+TEST(ChannelArenaTest, BacksFramePoolPayloads) {
+  auto arena = ChannelArena::Create();
+  auto pool = FramePool::Create(2, 4096, arena);
+  EXPECT_EQ(arena->GetStats().bytes_in_use, 2u * 4096u);
+
+  FrameHandle handle = pool->Acquire();
+  handle->Layout(PixelFormat::kI420, 64, 64);
+  {
+    Frame moved = std::move(*handle);
+    EXPECT_EQ(moved.data.get_allocator().arena, arena);
+    EXPECT_EQ(handle->data.get_allocator().arena, arena);
+    handle->data.swap(moved.data);
+  }
+
+  std::weak_ptr<ChannelArena> weak = arena;
+  arena.reset();
+  EXPECT_FALSE(weak.expired());  // Pool payloads still hold it
+  handle.Reset();
+  pool.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+// Test a shared arena maps large blocks from its region and returns them
+TEST(ChannelArenaTest, SharedRegionHoldsLargeBlocks) {
+  auto arena = ChannelArena::CreateShared(8 * 1024 * 1024, 100, 0);
+  ASSERT_NE(arena, nullptr);
+  EXPECT_GE(arena->SharedFd(), 0);
+  EXPECT_EQ(arena->SharedBytes(), 8u * 1024 * 1024);
+  EXPECT_EQ(arena->SharedFrontBytes() % 4096, 0u);
+
+  void* big = arena->Allocate(3'110'400);
+  void* small = arena->Allocate(100);
+  ASSERT_NE(big, nullptr);
+  EXPECT_GE(arena->SharedOffset(big), static_cast<int64_t>(arena->SharedFrontBytes()));
+  EXPECT_EQ(arena->SharedOffset(small), -1);  // Below kMapThreshold: from the heap
+  std::memset(big, 0x5a, 3'110'400);
+
+  // A second fits, a third does not and is mapped privately
+  void* second = arena->Allocate(3'110'400);
+  void* third = arena->Allocate(3'110'400);
+  EXPECT_GE(arena->SharedOffset(second), 0);
+  EXPECT_EQ(arena->SharedOffset(third), -1);
+  EXPECT_EQ(arena->GetStats().unshared_allocations, 1u);
+
+  // Freed (uncached) blocks go back to the region and are taken again
+  ChannelArena::Free(big);
+  ChannelArena::Free(third);
+  void* again = arena->Allocate(3'110'400);
+  EXPECT_EQ(again, big);
+  ChannelArena::Free(again);
+  ChannelArena::Free(second);
+  ChannelArena::Free(small);
+  EXPECT_EQ(arena->GetStats().bytes_in_use, 0u);
+}
+
+// Test readers see exported frames in place and notice them being replaced
+TEST(SharedFrameExportTest, ReadersMapFramesInPlace) {
+  constexpr size_t kSlots = 2;
+  auto arena =
+      ChannelArena::CreateShared(16 * 1024 * 1024, SharedFrameExport::FrontBytes(kSlots));
+  ASSERT_NE(arena, nullptr);
+  auto pool = FramePool::Create(4, Frame::LayoutBytes(PixelFormat::kNV12, 320, 240), arena);
+  SharedFrameExport exporter(arena, 7, kSlots);
+  ASSERT_TRUE(exporter.IsValid());
+
+  SharedFrameReader reader;
+  ASSERT_TRUE(reader.Open(dup(arena->SharedFd())));
+  EXPECT_EQ(reader.channel_id(), 7);
+  SharedFrameView view;
+  EXPECT_FALSE(reader.Next(&view));
+
+  auto publish = [&](int64_t pts) {
+    FrameHandle handle = pool->Acquire();
+    handle->Layout(PixelFormat::kNV12, 320, 240);
+    std::fill(handle->data.begin(), handle->data.end(), static_cast<uint8_t>(pts));
+    handle->metadata.pts = pts;
+    return exporter.Publish(handle);
+  };
+  ASSERT_TRUE(publish(1));
+  ASSERT_TRUE(reader.Next(&view));
+  EXPECT_EQ(view.index, 0u);
+  EXPECT_EQ(view.metadata.pts, 1);
+  EXPECT_EQ(view.format, PixelFormat::kNV12);
+  EXPECT_EQ(view.width, 320);
+  EXPECT_EQ(view.strides[1], 320);
+  EXPECT_EQ(view.planes[1][0], 1);
+  EXPECT_TRUE(reader.Valid(view));
+  EXPECT_EQ(pool->Available(), 3u);  // The export holds the frame
+
+  // Three more through two slots: the first is replaced and the reader
+  // skips what it missed
+  ASSERT_TRUE(publish(2));
+  ASSERT_TRUE(publish(3));
+  EXPECT_FALSE(reader.Valid(view));
+  ASSERT_TRUE(publish(4));
+  ASSERT_TRUE(reader.Next(&view));
+  EXPECT_EQ(view.metadata.pts, 3);
+  EXPECT_EQ(reader.Lost(), 1u);
+  ASSERT_TRUE(reader.Next(&view));
+  EXPECT_EQ(view.planes[0][0], 4);
+  EXPECT_FALSE(reader.Next(&view));
+  EXPECT_EQ(pool->Available(), 2u);
+
+  // Frames outside the region are not exported
+  FrameHandle heap = FrameHandle::Adopt(Frame());
+  heap->Layout(PixelFormat::kI420, 64, 64);
+  EXPECT_FALSE(exporter.Publish(heap));
+  EXPECT_EQ(exporter.GetStats().published, 4u);
+  EXPECT_EQ(exporter.GetStats().not_shared, 1u);
+}
+
+// Test the region is handed out read-only over the export's socket
+TEST(SharedFrameExportTest, HandsRegionToConnectingReaders) {
+  auto arena = ChannelArena::CreateShared(4 * 1024 * 1024, SharedFrameExport::FrontBytes(4));
+  ASSERT_NE(arena, nullptr);
+  SharedFrameExport exporter(arena, 3, 4);
+  const std::string path = "/tmp/retrovue_frame_export_test.sock";
+  ASSERT_TRUE(exporter.Listen(path));
+
+  SharedFrameReader reader;
+  ASSERT_TRUE(reader.Connect(path));
+  EXPECT_EQ(reader.channel_id(), 3);
+  EXPECT_EQ(exporter.GetStats().readers_connected, 1u);
+  exporter.Stop();
+  EXPECT_FALSE(reader.Connect(path));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -3,12 +3,31 @@
 // Purpose: Tests decode thread lifecycle and frame production.
 // Copyright (c) 2025 RetroVue
 
+#include "retrovue/decode/AssetProbeCache.h"
+#include "retrovue/decode/AudioKernels.h"
+#include "retrovue/decode/AudioProcessor.h"
+#include "retrovue/decode/DecoderContextPool.h"
+#include "retrovue/decode/DeviceFrames.h"
 #include "retrovue/decode/FrameProducer.h"
+#include "retrovue/decode/KeyframeIndex.h"
+#include "retrovue/decode/OverlayCompositor.h"
+#include "retrovue/decode/PassthroughEligibility.h"
+#include "retrovue/decode/PlaneKernels.h"
+#include "retrovue/decode/ReadAheadFile.h"
 #include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/runtime/IoRing.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <thread>
+#include <tuple>
 #include <chrono>
+#include <cmath>
+#include <vector>
 
 using namespace retrovue::decode;
 using namespace retrovue::buffer;
@@ -130,7 +149,7 @@ TEST(FrameProducerTest, FrameMetadata) {
   Frame frame;
   ASSERT_TRUE(buffer.Pop(frame));
   
-  EXPECT_EQ(frame.metadata.asset_uri, "test://my-asset");
+  EXPECT_EQ(AssetUri(frame.metadata.asset_id), "test://my-asset");
   EXPECT_EQ(frame.width, 1920);
   EXPECT_EQ(frame.height, 1080);
   EXPECT_NEAR(frame.metadata.duration, 1.0 / 30.0, 0.001);
@@ -217,6 +236,803 @@ TEST(FrameProducerTest, DestructorStopsProducer) {
   SUCCEED();
 }
 
+// Test the producer's frame pool follows a depth limit changed while it runs
+TEST(FrameProducerTest, FollowsBufferDepthLimit) {
+  FrameRingBuffer buffer(30);
+  buffer.SetDepthLimit(4);
+
+  ProducerConfig config;
+  config.asset_uri = "test://asset";
+  config.target_width = 64;
+  config.target_height = 36;
+  config.target_fps = 200.0;
+  config.stub_mode = true;
+
+  const auto wait_for_depth = [&buffer](size_t depth) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (buffer.Size() < depth && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return buffer.Size();
+  };
+
+  FrameProducer producer(config, buffer);
+
+  // Until the producer has been turned away at the limit (again) a few times
+  const auto wait_for_refusals = [&producer]() {
+    const uint64_t target = producer.GetBufferFullCount() + 3;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (producer.GetBufferFullCount() < target &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return producer.GetBufferFullCount() >= target;
+  };
+
+  ASSERT_TRUE(producer.Start());
+  EXPECT_EQ(wait_for_depth(4), 4u);
+  EXPECT_TRUE(wait_for_refusals());
+  EXPECT_EQ(buffer.Size(), 4u);
+
+  // A pool sized for 4 frames could not fill this
+  buffer.SetDepthLimit(20);
+  EXPECT_EQ(wait_for_depth(20), 20u);
+
+  buffer.SetDepthLimit(2);
+  Frame frame;
+  while (buffer.Pop(frame)) {
+  }
+  EXPECT_GE(wait_for_depth(2), 2u);
+  EXPECT_TRUE(wait_for_refusals());
+  EXPECT_LE(buffer.Size(), 2u);
+
+  producer.Stop();
+}
+
+// Test one producer feeding a second buffer, and handing pacing over to it
+TEST(FrameProducerTest, FeedsAddedOutputs) {
+  FrameRingBuffer first(8);
+  FrameRingBuffer second(8);
+
+  ProducerConfig config;
+  config.asset_uri = "test://asset";
+  config.target_width = 64;
+  config.target_height = 36;
+  config.target_fps = 200.0;
+  config.stub_mode = true;
+
+  const auto wait_for_size = [](const FrameRingBuffer& buffer, size_t size) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (buffer.Size() < size && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return buffer.Size();
+  };
+
+  FrameProducer producer(config, first);
+  EXPECT_TRUE(producer.AddOutput(second));
+  EXPECT_FALSE(producer.AddOutput(second));
+  EXPECT_FALSE(producer.AddOutput(first));
+  EXPECT_EQ(producer.OutputCount(), 2u);
+  ASSERT_TRUE(producer.Start());
+  EXPECT_EQ(wait_for_size(first, 8), 8u);
+  EXPECT_EQ(wait_for_size(second, 8), 8u);
+
+  // Same frames, each buffer with a picture of its own
+  FrameHandle a;
+  FrameHandle b;
+  ASSERT_TRUE(first.Pop(a));
+  ASSERT_TRUE(second.Pop(b));
+  EXPECT_EQ(a->metadata.pts, b->metadata.pts);
+  EXPECT_EQ(a->data.size(), b->data.size());
+  EXPECT_NE(a->data.data(), b->data.data());
+  a.Reset();
+  b.Reset();
+
+  // The second buffer paces once the first is gone (and has let go of its
+  // frames, as a stopping channel does)
+  EXPECT_EQ(producer.RemoveOutput(first), 1u);
+  first.Clear();
+  Frame frame;
+  while (second.Pop(frame)) {
+  }
+  EXPECT_EQ(wait_for_size(second, 8), 8u);
+  EXPECT_TRUE(first.IsEmpty());
+
+  // With no outputs it idles until stopped
+  EXPECT_EQ(producer.RemoveOutput(second), 0u);
+  EXPECT_TRUE(producer.IsRunning());
+  producer.Stop();
+  EXPECT_FALSE(producer.IsRunning());
+}
+
+// Test keyframe lookup picks the GOP containing the requested time
+TEST(KeyframeIndexTest, FindAtOrBefore) {
+  KeyframeIndex index;
+  EXPECT_EQ(index.FindAtOrBefore(0), nullptr);
+
+  // Out of order and duplicated, as a packet scan may report them
+  index.Add({4'000'000, 360000, 9000});
+  index.Add({0, 0, 0});
+  index.Add({2'000'000, 180000, 4000});
+  index.Add({2'000'000, 180000, 4000});
+  index.Finalize();
+  ASSERT_EQ(index.size(), 3u);
+
+  EXPECT_EQ(index.FindAtOrBefore(-1)->pts_us, 0);
+  EXPECT_EQ(index.FindAtOrBefore(1'999'999)->pts_us, 0);
+  EXPECT_EQ(index.FindAtOrBefore(2'000'000)->pts_us, 2'000'000);
+  EXPECT_EQ(index.FindAtOrBefore(3'500'000)->byte_pos, 4000);
+  EXPECT_EQ(index.FindAtOrBefore(60'000'000)->timestamp, 360000);
+}
+
+// Test sidecar round trip and staleness checks
+TEST(KeyframeIndexTest, SidecarRoundTrip) {
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "retrovue_keyframe_index_test";
+  std::filesystem::create_directories(dir);
+  const std::string asset = (dir / "asset.mkv").string();
+  { std::ofstream(asset) << "not really a video"; }
+
+  AssetStamp stamp;
+  ASSERT_TRUE(KeyframeIndex::StatAsset(asset, &stamp));
+  EXPECT_FALSE(KeyframeIndex::StatAsset((dir / "missing.mkv").string(), &stamp));
+  ASSERT_TRUE(KeyframeIndex::StatAsset(asset, &stamp));
+
+  const std::string sidecar = KeyframeIndex::SidecarPathFor(asset);
+  EXPECT_EQ(sidecar, asset + ".rvidx");
+  EXPECT_EQ(KeyframeIndex::SidecarPathFor("/media/show/asset.mkv", dir.string()),
+            (dir / "asset.mkv").string() + ".rvidx");
+
+  KeyframeIndex built;
+  built.Add({0, 0, 0});
+  built.Add({2'002'000, 60060, 123456});
+  built.Finalize();
+  built.set_stamp(stamp);
+  built.set_stream_index(0);
+  ASSERT_TRUE(built.Save(sidecar));
+
+  KeyframeIndex loaded;
+  ASSERT_TRUE(loaded.Load(sidecar, stamp, 0));
+  ASSERT_EQ(loaded.size(), 2u);
+  EXPECT_EQ(loaded.entries()[1].pts_us, 2'002'000);
+  EXPECT_EQ(loaded.entries()[1].timestamp, 60060);
+  EXPECT_EQ(loaded.entries()[1].byte_pos, 123456);
+
+  // A different stream or a modified asset invalidates the sidecar
+  EXPECT_FALSE(loaded.Load(sidecar, stamp, 1));
+  EXPECT_TRUE(loaded.empty());
+  AssetStamp modified = stamp;
+  modified.size_bytes += 1;
+  EXPECT_FALSE(loaded.Load(sidecar, modified, 0));
+
+  // Truncated or foreign files are rejected
+  std::filesystem::resize_file(sidecar, 40);
+  EXPECT_FALSE(loaded.Load(sidecar, stamp, 0));
+  { std::ofstream(sidecar, std::ios::trunc) << "garbage"; }
+  EXPECT_FALSE(loaded.Load(sidecar, stamp, 0));
+
+  std::filesystem::remove_all(dir);
+}
+
+// Test probe cache hits, staleness and LRU eviction
+TEST(AssetProbeCacheTest, LookupInsertEvict) {
+  AssetProbeCache cache(2);
+  const AssetStamp stamp{1024, 42};
+
+  EXPECT_EQ(cache.Lookup("/media/promo.mp4", stamp), nullptr);
+
+  auto snapshot = std::make_shared<ProbeSnapshot>();
+  snapshot->duration = 30'000'000;
+  snapshot->streams.resize(2);
+  cache.Insert("/media/promo.mp4", stamp, snapshot);
+
+  auto hit = cache.Lookup("/media/promo.mp4", stamp);
+  ASSERT_NE(hit, nullptr);
+  EXPECT_EQ(hit->duration, 30'000'000);
+  EXPECT_EQ(hit->streams.size(), 2u);
+
+  // A replaced file (new mtime) is re-probed, and its stale entry dropped
+  EXPECT_EQ(cache.Lookup("/media/promo.mp4", AssetStamp{1024, 43}), nullptr);
+  EXPECT_EQ(cache.Lookup("/media/promo.mp4", stamp), nullptr);
+
+  // Least recently used entry goes first
+  cache.Insert("/media/a.mp4", stamp, snapshot);
+  cache.Insert("/media/b.mp4", stamp, snapshot);
+  ASSERT_NE(cache.Lookup("/media/a.mp4", stamp), nullptr);
+  cache.Insert("/media/c.mp4", stamp, snapshot);
+  EXPECT_NE(cache.Lookup("/media/a.mp4", stamp), nullptr);
+  EXPECT_EQ(cache.Lookup("/media/b.mp4", stamp), nullptr);
+  EXPECT_NE(cache.Lookup("/media/c.mp4", stamp), nullptr);
+
+  const ProbeCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 4u);
+  EXPECT_EQ(stats.misses, 4u);
+  EXPECT_EQ(stats.stale, 1u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.entries, 2u);
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+// Test decoder keys separate incompatible streams and the pool counts misses
+TEST(DecoderContextPoolTest, KeysAndMisses) {
+  DecoderKey hevc;
+  hevc.codec_id = 173;
+  hevc.width = 1920;
+  hevc.height = 1080;
+  hevc.pix_fmt = 0;
+  hevc.extradata_hash = 0x1234;
+  hevc.thread_count = 4;
+
+  DecoderKey other = hevc;
+  EXPECT_EQ(other, hevc);
+  other.extradata_hash = 0x5678;  // Different SPS/PPS
+  EXPECT_NE(other, hevc);
+  other = hevc;
+  other.thread_type = DecodeThreadType::kSlice;
+  EXPECT_NE(other, hevc);
+
+  ScalerKey scaler;
+  scaler.src_width = 1920;
+  scaler.dst_width = 1280;
+  ScalerKey other_scaler = scaler;
+  EXPECT_EQ(other_scaler, scaler);
+  other_scaler.flags = 1;
+  EXPECT_NE(other_scaler, scaler);
+
+  DecoderContextPool pool(2, 2);
+  EXPECT_EQ(pool.AcquireDecoder(hevc), nullptr);
+  AVCodecContext* none = nullptr;
+  pool.ReleaseDecoder(hevc, &none);  // Nothing to keep
+
+  const DecoderPoolStats stats = pool.GetStats();
+  EXPECT_EQ(stats.decoder_hits, 0u);
+  EXPECT_EQ(stats.decoder_misses, 1u);
+  EXPECT_EQ(stats.idle_decoders, 0u);
+  EXPECT_EQ(stats.evictions, 0u);
+}
+
+// Test read-ahead returns the file's bytes in order across seeks
+TEST(ReadAheadFileTest, SequentialReadAndSeek) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "retrovue_read_ahead_test.bin";
+  std::vector<uint8_t> data(1 << 20);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>((i * 31) ^ (i >> 8));
+  }
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+  }
+
+  // Window much smaller than the file so the fill thread wraps many times
+  ReadAheadFile file(64 * 1024, 16 * 1024);
+  ASSERT_FALSE(file.Open((path.parent_path() / "missing.bin").string()));
+  ASSERT_TRUE(file.Open(path.string()));
+  EXPECT_EQ(file.Size(), static_cast<int64_t>(data.size()));
+
+  std::vector<uint8_t> read_back;
+  std::vector<uint8_t> chunk(10'000);  // Not a multiple of the fill chunk
+  int64_t got = 0;
+  while ((got = file.Read(chunk.data(), chunk.size())) > 0) {
+    read_back.insert(read_back.end(), chunk.begin(), chunk.begin() + got);
+  }
+  EXPECT_EQ(got, 0);
+  EXPECT_TRUE(read_back == data);
+
+  // Backward seek refills from the new offset
+  ASSERT_EQ(file.Seek(500'000, SEEK_SET), 500'000);
+  ASSERT_EQ(file.Read(chunk.data(), 100), 100);
+  EXPECT_TRUE(std::equal(chunk.begin(), chunk.begin() + 100, data.begin() + 500'000));
+
+  // Short forward skip stays inside the window
+  ASSERT_EQ(file.Seek(50, SEEK_CUR), 500'150);
+  ASSERT_EQ(file.Read(chunk.data(), 100), 100);
+  EXPECT_TRUE(std::equal(chunk.begin(), chunk.begin() + 100, data.begin() + 500'150));
+
+  EXPECT_EQ(file.Seek(-10, SEEK_END), static_cast<int64_t>(data.size()) - 10);
+  EXPECT_EQ(file.Read(chunk.data(), chunk.size()), 10);
+  EXPECT_EQ(file.Read(chunk.data(), chunk.size()), 0);
+  EXPECT_EQ(file.Seek(1, SEEK_END), -1);
+
+  const ReadAheadStats stats = file.GetStats();
+  EXPECT_EQ(stats.bytes_read, data.size() + 210);
+  EXPECT_EQ(stats.seeks, 2u);
+
+  file.Close();
+  std::filesystem::remove(path);
+}
+
+// Test read-ahead through a shared IoRing returns the same bytes, with two
+// files reading on the ring at once
+TEST(ReadAheadFileTest, IoRingReadsAndSeeks) {
+  auto ring = std::make_shared<retrovue::runtime::IoRing>(8);
+  if (!ring->Open()) {
+    GTEST_SKIP() << "io_uring unavailable";
+  }
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "retrovue_read_ahead_ring_test.bin";
+  std::vector<uint8_t> data((1 << 20) + 123);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+  }
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+  }
+
+  ReadAheadFile first(64 * 1024, 16 * 1024, ring);
+  ReadAheadFile second(48 * 1024, 16 * 1024, ring);
+  ASSERT_FALSE(first.Open((path.parent_path() / "missing.bin").string()));
+  ASSERT_TRUE(first.Open(path.string()));
+  ASSERT_TRUE(second.Open(path.string()));
+
+  std::vector<uint8_t> first_back;
+  std::vector<uint8_t> second_back;
+  std::vector<uint8_t> chunk(10'000);
+  bool first_done = false;
+  bool second_done = false;
+  while (!first_done || !second_done) {
+    for (auto [file, back, done] : {std::tuple(&first, &first_back, &first_done),
+                                    std::tuple(&second, &second_back, &second_done)}) {
+      if (*done) {
+        continue;
+      }
+      const int64_t got = file->Read(chunk.data(), chunk.size());
+      ASSERT_GE(got, 0);
+      *done = got == 0;
+      back->insert(back->end(), chunk.begin(), chunk.begin() + got);
+    }
+  }
+  EXPECT_TRUE(first_back == data);
+  EXPECT_TRUE(second_back == data);
+
+  ASSERT_EQ(first.Seek(700'000, SEEK_SET), 700'000);
+  ASSERT_EQ(first.Read(chunk.data(), 100), 100);
+  EXPECT_TRUE(std::equal(chunk.begin(), chunk.begin() + 100, data.begin() + 700'000));
+  ASSERT_EQ(first.Seek(20, SEEK_CUR), 700'120);
+  ASSERT_EQ(first.Read(chunk.data(), 100), 100);
+  EXPECT_TRUE(std::equal(chunk.begin(), chunk.begin() + 100, data.begin() + 700'120));
+
+  first.Close();
+  second.Close();
+  const retrovue::runtime::IoRingStats stats = ring->GetStats();
+  EXPECT_GT(stats.completed, 2 * data.size() / (16 * 1024));
+  EXPECT_EQ(stats.in_flight, 0u);
+  std::filesystem::remove(path);
+}
+
+// Test the dispatched kernels match the scalar reference bit for bit,
+// including row tails shorter than a vector
+TEST(PlaneKernelsTest, SimdMatchesScalar) {
+  const KernelIsa active = ActiveKernelIsa();
+  const int width = 1920 + 6;  // Luma row with a tail
+  const int height = 1080;
+  const int stride = width + 26;
+  std::vector<uint8_t> src(static_cast<size_t>(stride) * height);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+  }
+
+  auto run = [&](KernelIsa isa) {
+    EXPECT_TRUE(SetKernelIsa(isa));
+    std::vector<uint8_t> scaled(1280 * 720);
+    ScalePlane(scaled.data(), 1280, 1280, 720, src.data(), stride, width, height);
+    std::vector<uint8_t> three_to_two(1280 * 720);  // Dedicated 1920 -> 1280 row filter
+    ScalePlane(three_to_two.data(), 1280, 1280, 720, src.data(), stride, 1920, height);
+    scaled.insert(scaled.end(), three_to_two.begin(), three_to_two.end());
+
+    const int pairs = width / 2;
+    std::vector<uint8_t> u(static_cast<size_t>(pairs) * 8);
+    std::vector<uint8_t> v(u.size());
+    std::vector<uint8_t> merged(static_cast<size_t>(pairs) * 2 * 8);
+    SplitUVPlane(u.data(), pairs, v.data(), pairs, src.data(), stride, pairs, 8);
+    MergeUVPlane(merged.data(), pairs * 2, u.data(), pairs, v.data(), pairs, pairs, 8);
+    for (int y = 0; y < 8; ++y) {
+      EXPECT_TRUE(std::equal(merged.begin() + y * pairs * 2, merged.begin() + (y + 1) * pairs * 2,
+                             src.begin() + y * stride));
+    }
+    EXPECT_EQ(u[1], src[2]);
+    EXPECT_EQ(v[1], src[3]);
+    return std::make_pair(scaled, u);
+  };
+
+  const auto reference = run(KernelIsa::kScalar);
+  const auto simd = run(active);
+  EXPECT_TRUE(simd.first == reference.first);
+  EXPECT_TRUE(simd.second == reference.second);
+  SetKernelIsa(active);
+}
+
+// Test premultiplied blending is exact, and the same on every ISA
+TEST(PlaneKernelsTest, BlendPremultipliedMatchesReference) {
+  const KernelIsa active = ActiveKernelIsa();
+  const int width = 256 + 37;  // Vector blocks and a tail
+  const int rows = 256;
+  std::vector<uint8_t> frame(static_cast<size_t>(width) * rows);
+  std::vector<uint8_t> overlay(frame.size());
+  std::vector<uint8_t> alpha(frame.size());
+  for (int y = 0; y < rows; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t i = static_cast<size_t>(y) * width + x;
+      frame[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+      alpha[i] = static_cast<uint8_t>(y);
+      overlay[i] = static_cast<uint8_t>(x % (y + 1));  // Premultiplied: at most alpha
+    }
+  }
+
+  auto run = [&](KernelIsa isa) {
+    EXPECT_TRUE(SetKernelIsa(isa));
+    std::vector<uint8_t> blended = frame;
+    BlendPremultipliedPlane(blended.data(), width, overlay.data(), width, alpha.data(), width,
+                            width, rows);
+    return blended;
+  };
+
+  const std::vector<uint8_t> reference = run(KernelIsa::kScalar);
+  for (size_t i = 0; i < frame.size(); i += 97) {
+    const int expected = overlay[i] + (frame[i] * (255 - alpha[i]) * 2 + 255) / 510;
+    EXPECT_EQ(reference[i], std::min(expected, 255));
+  }
+  EXPECT_TRUE(run(active) == reference);
+  SetKernelIsa(active);
+}
+
+// Test PackI420 scales and deinterleaves NV12 into a packed I420 frame
+TEST(PlaneKernelsTest, PackI420FromNV12) {
+  const int width = 1920;
+  const int height = 1080;
+  std::vector<uint8_t> y_plane(static_cast<size_t>(width) * height, 200);
+  std::vector<uint8_t> uv_plane(static_cast<size_t>(width) * height / 2);
+  for (size_t i = 0; i < uv_plane.size(); i += 2) {
+    uv_plane[i] = 64;       // U
+    uv_plane[i + 1] = 192;  // V
+  }
+  PlanarImage image;
+  image.layout = PlanarLayout::kNV12;
+  image.planes[0] = y_plane.data();
+  image.planes[1] = uv_plane.data();
+  image.strides[0] = width;
+  image.strides[1] = width;
+  image.width = width;
+  image.height = height;
+
+  EXPECT_TRUE(CanPackI420(image, 1280, 720));
+  EXPECT_TRUE(CanPackI420(image, width, height));
+  EXPECT_FALSE(CanPackI420(image, 640, 360));    // Steeper than 2:1
+  EXPECT_FALSE(CanPackI420(image, 3840, 2160));  // Upscale
+
+  // Flat planes stay flat through the bilinear filter
+  std::vector<uint8_t> packed(1280 * 720 * 3 / 2);
+  PackI420(image, 1280, 720, packed.data());
+  const size_t y_size = 1280 * 720;
+  const size_t uv_size = y_size / 4;
+  EXPECT_TRUE(std::all_of(packed.begin(), packed.begin() + y_size,
+                          [](uint8_t p) { return p == 200; }));
+  EXPECT_TRUE(std::all_of(packed.begin() + y_size, packed.begin() + y_size + uv_size,
+                          [](uint8_t p) { return p == 64; }));
+  EXPECT_TRUE(std::all_of(packed.begin() + y_size + uv_size, packed.end(),
+                          [](uint8_t p) { return p == 192; }));
+
+  // Same size is an exact copy plus deinterleave
+  uv_plane[0] = 1;
+  uv_plane[1] = 2;
+  std::vector<uint8_t> full(static_cast<size_t>(width) * height * 3 / 2);
+  PackI420(image, width, height, full.data());
+  EXPECT_EQ(full[static_cast<size_t>(width) * height], 1);
+  EXPECT_EQ(full[static_cast<size_t>(width) * height * 5 / 4], 2);
+}
+
+// Test 10-bit P010 narrows to 8 bits and frames keep the decoder's layout
+TEST(PlaneKernelsTest, P010NarrowsAndFramesKeepLayout) {
+  const int width = 64;
+  const int height = 32;
+  std::vector<uint16_t> y_plane(static_cast<size_t>(width) * height, 0x3200);
+  std::vector<uint16_t> uv_plane(static_cast<size_t>(width) * height / 2);
+  for (size_t i = 0; i < uv_plane.size(); i += 2) {
+    uv_plane[i] = 0x4000;      // U
+    uv_plane[i + 1] = 0xC000;  // V
+  }
+  PlanarImage image;
+  image.layout = PlanarLayout::kP010;
+  image.planes[0] = reinterpret_cast<const uint8_t*>(y_plane.data());
+  image.planes[1] = reinterpret_cast<const uint8_t*>(uv_plane.data());
+  image.strides[0] = width * 2;
+  image.strides[1] = width * 2;
+  image.width = width;
+  image.height = height;
+
+  std::vector<uint8_t> packed(static_cast<size_t>(width) * height * 3 / 2);
+  PackI420(image, width, height, packed.data());
+  const size_t y_size = static_cast<size_t>(width) * height;
+  EXPECT_EQ(packed[0], 0x32);
+  EXPECT_EQ(packed[y_size], 0x40);
+  EXPECT_EQ(packed[y_size + y_size / 4], 0xC0);
+
+  // CopyToFrame keeps P010 as P010, in aligned rows
+  Frame frame;
+  CopyToFrame(image, &frame);
+  EXPECT_EQ(frame.format, PixelFormat::kP010);
+  EXPECT_EQ(frame.width, width);
+  EXPECT_EQ(frame.Stride(0) % static_cast<int>(kFrameAlignment), 0);
+  EXPECT_EQ(std::memcmp(frame.Plane(1), uv_plane.data(), width * 2), 0);
+
+  PlanarImage described;
+  ASSERT_TRUE(DescribeFrame(frame, &described));
+  EXPECT_EQ(described.layout, PlanarLayout::kP010);
+  EXPECT_FALSE(IsPackedI420(described));
+  std::vector<uint8_t> repacked(packed.size());
+  PackI420(described, width, height, repacked.data());
+  EXPECT_EQ(repacked, packed);
+}
+
+// Test passthrough eligibility against a 1080p30 High@4.1 channel
+TEST(PassthroughEligibilityTest, MatchesChannelProfile) {
+  const PassthroughProfile profile;
+  SourceStream source;
+  source.h264 = true;
+  source.profile = 100;
+  source.level = 40;
+  source.width = 1920;
+  source.height = 1080;
+  source.sar_num = 1;
+  source.sar_den = 1;
+  source.fps = 30.0;
+  source.max_gop_us = 2'000'000;
+  EXPECT_EQ(PassthroughMismatch(source, profile), nullptr);
+
+  // Constrained Baseline carries FFmpeg's constraint flag
+  SourceStream baseline = source;
+  baseline.profile = 66 | (1 << 9);
+  EXPECT_EQ(PassthroughMismatch(baseline, profile), nullptr);
+
+  const auto rejects = [&](auto change) {
+    SourceStream changed = source;
+    change(changed);
+    return PassthroughMismatch(changed, profile) != nullptr;
+  };
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.h264 = false; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.profile = 110; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.level = 42; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.height = 720; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.sar_num = 4; s.sar_den = 3; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.interlaced = true; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.fps = 30000.0 / 1001.0; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.reorder_depth = 2; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.max_gop_us = -1; }));
+  EXPECT_TRUE(rejects([](SourceStream& s) { s.max_gop_us = 4'000'000; }));
+
+  KeyframeIndex index;
+  index.Add({0, 0, 0});
+  EXPECT_EQ(LongestKeyframeInterval(index), -1);
+  index.Add({3'000'000, 270000, 9000});
+  index.Add({1'000'000, 90000, 3000});
+  index.Finalize();
+  EXPECT_EQ(LongestKeyframeInterval(index), 2'000'000);
+
+  // Compressed frames have no planes to read
+  Frame frame;
+  frame.Layout(PixelFormat::kH264, 1920, 1080);
+  EXPECT_TRUE(frame.data.empty());
+  PlanarImage image;
+  EXPECT_FALSE(DescribeFrame(frame, &image));
+}
+
+// Test device frames hold their surface until laid out again, and read back
+TEST(DeviceFramesTest, SurfaceLifetimeAndDownload) {
+  auto in_flight = std::make_shared<std::atomic<int>>(1);
+  auto surface = std::make_shared<DeviceSurface>();
+  surface->in_flight = in_flight;
+
+  Frame frame;
+  frame.Layout(PixelFormat::kDevice, 1920, 1080);
+  frame.surface = std::move(surface);
+  EXPECT_TRUE(frame.data.empty());
+  PlanarImage image;
+  EXPECT_FALSE(DescribeFrame(frame, &image));
+  EXPECT_EQ(DeviceSurfaceFrame(frame), nullptr);  // No AVFrame behind this one
+
+  // Copies share the surface; the last one releases it
+  Frame copy = frame;
+  frame.Layout(PixelFormat::kI420, 4, 2);
+  EXPECT_FALSE(frame.surface);
+  EXPECT_EQ(in_flight->load(), 1);
+  copy = Frame();
+  EXPECT_EQ(in_flight->load(), 0);
+
+  // Frames already in memory are copied as they are
+  std::fill(frame.data.begin(), frame.data.end(), 7);
+  frame.metadata.pts = 42;
+  Frame out;
+  ASSERT_TRUE(DownloadDeviceFrame(frame, &out));
+  EXPECT_EQ(out.format, PixelFormat::kI420);
+  EXPECT_EQ(out.metadata.pts, 42);
+  EXPECT_EQ(out.data, frame.data);
+  EXPECT_TRUE(DownloadDeviceFrame(frame, &frame));
+
+  // A device frame without a surface cannot be read back
+  out.Layout(PixelFormat::kDevice, 4, 2);
+  EXPECT_FALSE(DownloadDeviceFrame(out, &out));
+}
+
+// Test overlays are blended where placed, per scheduled set
+TEST(OverlayCompositorTest, CompositesScheduledSets) {
+  // 8x6, opaque white on the left half, transparent on the right
+  std::vector<uint8_t> rgba(8 * 6 * 4, 0);
+  for (int y = 0; y < 6; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      std::fill_n(rgba.begin() + (y * 8 + x) * 4, 4, 255);
+    }
+  }
+  auto image = std::make_shared<OverlayImage>();
+  ASSERT_TRUE(OverlayFromPremultipliedRgba(rgba.data(), 8 * 4, 8, 6, image.get()));
+  EXPECT_EQ(image->y[0], 235);
+  EXPECT_EQ(image->u[0], 128);
+  EXPECT_EQ(image->alpha[7], 0);
+  OverlayImage too_small;
+  EXPECT_FALSE(OverlayFromPremultipliedRgba(rgba.data(), 8 * 4, 1, 6, &too_small));
+
+  OverlayCompositor compositor;
+  compositor.AddSet(OverlaySet{"bug", {OverlayPlacement{image, 3, 5}}});  // At (2, 4)
+  compositor.AddSet(OverlaySet{"off", {}});
+  compositor.Schedule(100, "bug");
+  compositor.Schedule(200, "off");
+  compositor.Schedule(300, "bug");
+  EXPECT_EQ(compositor.ActiveAt(50), nullptr);
+  EXPECT_EQ(compositor.ActiveAt(250), nullptr);
+  const std::shared_ptr<const OverlaySet> set = compositor.ActiveAt(300);
+  ASSERT_NE(set, nullptr);
+  EXPECT_EQ(set->name, "bug");
+
+  for (const PixelFormat format : {PixelFormat::kI420, PixelFormat::kNV12}) {
+    Frame frame;
+    frame.Layout(format, 16, 16);
+    std::fill(frame.data.begin(), frame.data.end(), 100);
+    ASSERT_TRUE(compositor.Composite(*set, &frame));
+    EXPECT_EQ(frame.Plane(0)[4 * frame.Stride(0) + 2], 235);   // Opaque: overlay
+    EXPECT_EQ(frame.Plane(0)[4 * frame.Stride(0) + 6], 100);   // Transparent: frame
+    EXPECT_EQ(frame.Plane(0)[3 * frame.Stride(0) + 2], 100);   // Above it
+    EXPECT_EQ(frame.Plane(0)[10 * frame.Stride(0) + 2], 100);  // Below it
+    EXPECT_EQ(frame.Plane(1)[2 * frame.Stride(1) + (format == PixelFormat::kNV12 ? 2 : 1)], 128);
+  }
+
+  // Clipped at the frame's edge; no 8-bit planes, no overlay
+  Frame small;
+  small.Layout(PixelFormat::kI420, 4, 6);
+  EXPECT_TRUE(compositor.Composite(*set, &small));
+  EXPECT_EQ(small.Plane(0)[5 * small.Stride(0) + 3], 235);
+  Frame p010;
+  p010.Layout(PixelFormat::kP010, 16, 16);
+  EXPECT_FALSE(compositor.Composite(*set, &p010));
+
+  const OverlayCompositorStats stats = compositor.GetStats();
+  EXPECT_EQ(stats.frames_composited, 3u);
+  EXPECT_EQ(stats.frames_skipped, 1u);
+}
+
+// Test the audio kernels match the scalar code, with tails shorter than a
+// vector (within a rounding step: see AudioKernels.h)
+TEST(AudioKernelsTest, SimdMatchesScalar) {
+  const KernelIsa active = ActiveKernelIsa();
+  const size_t frames = 1024 + 5;
+  std::vector<int16_t> pcm(frames * 6);
+  for (size_t i = 0; i < pcm.size(); ++i) {
+    pcm[i] = static_cast<int16_t>((i * 2654435761u) >> 16);
+  }
+
+  struct Result {
+    std::vector<float> floats;
+    std::vector<float> stereo;
+    std::vector<int16_t> mono;
+    std::vector<int16_t> ramped;
+  };
+  auto run = [&](KernelIsa isa) {
+    EXPECT_TRUE(SetKernelIsa(isa));
+    Result result;
+    result.floats.resize(pcm.size());
+    S16ToFloat(result.floats.data(), pcm.data(), pcm.size());
+    result.stereo.resize(frames * 2);
+    Downmix51ToStereo(result.stereo.data(), result.floats.data(), frames, DownmixCoefficients());
+    result.mono.resize(frames);
+    FloatToS16Ramped(result.mono.data(), result.floats.data(), frames, 1, 0.5f, 0.002f);
+    result.ramped.resize(frames * 2);
+    FloatToS16Ramped(result.ramped.data(), result.stereo.data(), frames, 2, 1.0f, 0.001f);
+    return result;
+  };
+
+  const Result reference = run(KernelIsa::kScalar);
+  EXPECT_EQ(reference.floats[1], pcm[1] / 32768.0f);
+  const float fl = reference.floats[6], fc = reference.floats[8], sl = reference.floats[10];
+  EXPECT_NEAR(reference.stereo[2], 0.41421356f * (fl + 0.70710678f * (fc + sl)), 1e-6f);
+  EXPECT_EQ(reference.mono.back(), 32767);  // Gain 2.56: saturates
+
+  const Result simd = run(active);
+  EXPECT_TRUE(simd.floats == reference.floats);
+  for (size_t i = 0; i < reference.stereo.size(); ++i) {
+    ASSERT_NEAR(simd.stereo[i], reference.stereo[i], 1e-6f) << i;
+    ASSERT_LE(std::abs(simd.ramped[i] - reference.ramped[i]), 1) << i;
+  }
+  for (size_t i = 0; i < frames; ++i) {
+    ASSERT_LE(std::abs(simd.mono[i] - reference.mono[i]), 1) << i;
+  }
+  SetKernelIsa(active);
+}
+
+// Interleaved S16 sine, the same in every channel.
+static AudioFrame MakeSine(int channels, double amplitude, size_t frames, size_t* phase) {
+  AudioFrame frame;
+  frame.sample_rate = 48000;
+  frame.channels = channels;
+  frame.nb_samples = static_cast<int>(frames);
+  frame.data.resize(frames * channels * sizeof(int16_t));
+  int16_t* samples = reinterpret_cast<int16_t*>(frame.data.data());
+  for (size_t i = 0; i < frames; ++i, ++(*phase)) {
+    const double x = amplitude * std::sin(2.0 * 3.14159265358979 * 1000.0 * *phase / 48000.0);
+    for (int ch = 0; ch < channels; ++ch) {
+      samples[i * channels + ch] = static_cast<int16_t>(std::lround(x * 32767.0));
+    }
+  }
+  return frame;
+}
+
+// Test loudness reads per BS.1770, 5.1 downmixes to stereo, and the gain
+// walks the output to the target without stepping
+TEST(AudioProcessorTest, MeasuresDownmixesAndNormalizes) {
+  // 1 kHz at -23 dBFS in both channels reads -23 LUFS
+  AudioProcessingConfig measure;
+  measure.enabled = true;
+  measure.normalize = false;
+  AudioProcessor meter(measure);
+  size_t phase = 0;
+  for (int i = 0; i < 5 * 48; ++i) {  // 5 s of 1000-sample frames
+    AudioFrame frame = MakeSine(2, std::pow(10.0, -23.0 / 20.0), 1000, &phase);
+    ASSERT_TRUE(meter.Process(frame));
+  }
+  AudioProcessorStats stats = meter.GetStats();
+  EXPECT_NEAR(stats.input_integrated_lufs, -23.0, 0.1);
+  EXPECT_NEAR(stats.integrated_lufs, -23.0, 0.1);
+  EXPECT_NEAR(stats.window_lufs, -23.0, 0.1);
+  EXPECT_EQ(stats.gain_db, 0.0);
+
+  AudioFrame bad;
+  bad.sample_rate = 48000;
+  bad.channels = 2;
+  bad.nb_samples = 10;
+  EXPECT_FALSE(meter.Process(bad));
+  EXPECT_EQ(meter.GetStats().invalid_frames, 1u);
+
+  // 5.1 at -30 dBFS comes out stereo and is raised toward -24 LUFS
+  AudioProcessingConfig normalize;
+  normalize.enabled = true;
+  normalize.ramp_db_per_second = 6.0;
+  AudioProcessor processor(normalize);
+  phase = 0;
+  int16_t last_peak = 0;
+  for (int i = 0; i < 20 * 48; ++i) {
+    AudioFrame frame = MakeSine(6, std::pow(10.0, -30.0 / 20.0), 1000, &phase);
+    ASSERT_TRUE(processor.Process(frame));
+    ASSERT_EQ(frame.channels, 2);
+    ASSERT_EQ(frame.data.size(), 1000u * 2 * sizeof(int16_t));
+    const int16_t* samples = reinterpret_cast<const int16_t*>(frame.data.data());
+    int16_t peak = 0;
+    for (int s = 0; s < 2000; ++s) {
+      peak = std::max<int16_t>(peak, samples[s]);
+    }
+    // Gain moves at most 6 dB/s: about 0.12 dB per frame, never a step
+    if (last_peak > 0) {
+      ASSERT_LT(std::abs(20.0 * std::log10(static_cast<double>(peak) / last_peak)), 0.5) << i;
+    }
+    last_peak = peak;
+  }
+  stats = processor.GetStats();
+  EXPECT_EQ(stats.downmixed_frames, stats.frames);
+  EXPECT_GT(stats.gain_db, 0.0);
+  EXPECT_NEAR(stats.window_lufs + stats.gain_db, -24.0, 0.2);  // Converged
+  EXPECT_GT(stats.integrated_lufs, stats.input_integrated_lufs);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
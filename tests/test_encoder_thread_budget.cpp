@@ -0,0 +1,154 @@
+// Repository: Retrovue-playout
+// Component: Encoder Thread Budget Unit Tests
+// Purpose: Tests how the budget shares threads among encoders and whom it tells.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::EncoderThreadAllocation;
+using retrovue::playout_sinks::mpegts::EncoderThreadBudget;
+using retrovue::playout_sinks::mpegts::EncoderThreadRequest;
+
+namespace {
+
+EncoderThreadRequest Request(int width, int height, int priority = 1, double fps = 30.0) {
+  EncoderThreadRequest request;
+  request.width = width;
+  request.height = height;
+  request.fps = fps;
+  request.priority = priority;
+  return request;
+}
+
+// Every allocation each encoder was told of, by name
+class Allocations {
+ public:
+  EncoderThreadBudget::ThreadsCallback For(char name) {
+    return [this, name](EncoderThreadAllocation allocation) {
+      EXPECT_EQ(allocation.slices, allocation.threads);
+      told_[name].push_back(allocation.threads);
+    };
+  }
+
+  std::vector<int> Told(char name) { return told_[name]; }
+
+ private:
+  std::map<char, std::vector<int>> told_;
+};
+
+std::vector<int> Threads(const EncoderThreadBudget& budget) {
+  std::vector<int> threads;
+  for (const auto& share : budget.GetStats().encoders) {
+    threads.push_back(share.threads);
+  }
+  return threads;
+}
+
+}  // namespace
+
+TEST(EncoderThreadBudgetTest, GivesEveryEncoderOneThreadWhenOversubscribed) {
+  EncoderThreadBudget budget(4);
+  for (int i = 0; i < 6; ++i) {
+    budget.AddEncoder(Request(1920, 1080), nullptr);
+  }
+  EXPECT_EQ(Threads(budget), (std::vector<int>{1, 1, 1, 1, 1, 1}));
+  const auto stats = budget.GetStats();
+  EXPECT_EQ(stats.total_threads, 4);
+  EXPECT_EQ(stats.allocated_threads, 6);
+}
+
+TEST(EncoderThreadBudgetTest, SharesTheRestByPixelRateTimesPriority) {
+  // A quarter of the pixels per frame gets about a quarter of the threads
+  EncoderThreadBudget sizes(10);
+  sizes.AddEncoder(Request(1920, 1080), nullptr);
+  sizes.AddEncoder(Request(960, 540), nullptr);
+  EXPECT_EQ(Threads(sizes), (std::vector<int>{8, 2}));
+
+  // And so does a quarter of the frame rate
+  EncoderThreadBudget rates(10);
+  rates.AddEncoder(Request(1920, 1080, 1, 15.0), nullptr);
+  rates.AddEncoder(Request(1920, 1080, 1, 60.0), nullptr);
+  EXPECT_EQ(Threads(rates), (std::vector<int>{2, 8}));
+
+  // Priority scales the weight the same way, whichever was added first
+  EncoderThreadBudget priorities(8);
+  priorities.AddEncoder(Request(1920, 1080), nullptr);
+  priorities.AddEncoder(Request(1920, 1080, 3), nullptr);
+  EXPECT_EQ(Threads(priorities), (std::vector<int>{2, 6}));
+  const auto stats = priorities.GetStats();
+  EXPECT_EQ(stats.encoders[0].priority, 1);
+  EXPECT_EQ(stats.encoders[1].priority, 3);
+
+  // Equal weights split evenly; a priority under 1 counts as 1
+  EncoderThreadBudget equal(8);
+  equal.AddEncoder(Request(1280, 720, 0), nullptr);
+  equal.AddEncoder(Request(1280, 720), nullptr);
+  EXPECT_EQ(Threads(equal), (std::vector<int>{4, 4}));
+  EXPECT_EQ(equal.GetStats().encoders[0].priority, 1);
+}
+
+TEST(EncoderThreadBudgetTest, CapsThreadsByPictureHeight) {
+  // One thread per kRowsPerThread lines: 144p takes two however many are spare
+  EncoderThreadBudget budget(32);
+  budget.AddEncoder(Request(256, 144), nullptr);
+  EXPECT_EQ(Threads(budget), (std::vector<int>{2}));
+  EXPECT_EQ(budget.GetStats().allocated_threads, 2);
+
+  // Under one row-band still gets its one thread, and nothing takes more
+  // than kMaxThreads
+  budget.AddEncoder(Request(64, 32), nullptr);
+  budget.AddEncoder(Request(3840, 2160), nullptr);
+  EXPECT_EQ(Threads(budget), (std::vector<int>{2, 1, EncoderThreadBudget::kMaxThreads}));
+  EXPECT_EQ(budget.GetStats().allocated_threads, 2 + 1 + EncoderThreadBudget::kMaxThreads);
+
+  // A capped encoder's share goes to the others instead
+  EncoderThreadBudget shared(12);
+  shared.AddEncoder(Request(256, 144, 10), nullptr);
+  shared.AddEncoder(Request(1280, 720), nullptr);
+  EXPECT_EQ(Threads(shared), (std::vector<int>{2, 10}));
+}
+
+TEST(EncoderThreadBudgetTest, TellsOnlyTheEncodersWhoseThreadsChanged) {
+  EncoderThreadBudget budget(4);
+  Allocations told;
+  const uint64_t a = budget.AddEncoder(Request(1920, 1080), told.For('a'));
+  EXPECT_EQ(told.Told('a'), (std::vector<int>{4}));
+
+  const uint64_t b = budget.AddEncoder(Request(1920, 1080), told.For('b'));
+  EXPECT_EQ(told.Told('a'), (std::vector<int>{4, 2}));
+  EXPECT_EQ(told.Told('b'), (std::vector<int>{2}));
+
+  // The spare thread stays with a (first added wins a tie): a is not told
+  const uint64_t c = budget.AddEncoder(Request(256, 144), told.For('c'));
+  EXPECT_EQ(Threads(budget), (std::vector<int>{2, 1, 1}));
+  EXPECT_EQ(told.Told('a'), (std::vector<int>{4, 2}));
+  EXPECT_EQ(told.Told('b'), (std::vector<int>{2, 1}));
+  EXPECT_EQ(told.Told('c'), (std::vector<int>{1}));
+
+  // Removing a gives its threads to b; c, still at one, hears nothing
+  budget.RemoveEncoder(a);
+  EXPECT_EQ(Threads(budget), (std::vector<int>{3, 1}));
+  EXPECT_EQ(told.Told('a'), (std::vector<int>{4, 2}));
+  EXPECT_EQ(told.Told('b'), (std::vector<int>{2, 1, 3}));
+  EXPECT_EQ(told.Told('c'), (std::vector<int>{1}));
+
+  // An unknown or already removed id changes nothing
+  budget.RemoveEncoder(a);
+  budget.RemoveEncoder(99);
+  EXPECT_EQ(told.Told('b'), (std::vector<int>{2, 1, 3}));
+
+  budget.RemoveEncoder(b);
+  EXPECT_EQ(told.Told('c'), (std::vector<int>{1, 2}));  // Its cap
+  budget.RemoveEncoder(c);
+
+  const auto stats = budget.GetStats();
+  EXPECT_EQ(stats.rebalances, 6u);     // Three adds, three removes
+  EXPECT_EQ(stats.reallocations, 7u);  // Every callback above
+  EXPECT_EQ(stats.allocated_threads, 0);
+  EXPECT_TRUE(stats.encoders.empty());
+}
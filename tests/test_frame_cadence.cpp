@@ -0,0 +1,211 @@
+// Repository: Retrovue-playout
+// Component: Frame Cadence Unit Tests
+// Purpose: Tests the repeat/drop patterns of common source rates on the 29.97 fps grid.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/FrameCadence.hpp"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::FrameCadence;
+
+namespace {
+
+constexpr double kNtsc = 30000.0 / 1001;
+constexpr int64_t kStartPts = 1'000'000;
+
+// Source frames at fps, PTS rounded to microseconds as decoders give them
+std::deque<int64_t> Frames(double fps, int count, int64_t start = kStartPts) {
+  std::deque<int64_t> frames;
+  for (int i = 0; i < count; ++i) {
+    frames.push_back(start + std::llround(i * 1'000'000.0 / fps));
+  }
+  return frames;
+}
+
+// Runs ticks ticks over frames the way the sink's pacing loop does, and
+// returns what each tick did: 's' showed the front frame, 'R' repeated the
+// last one; each 'd' is a frame dropped first
+std::string Pace(FrameCadence& cadence, std::deque<int64_t>& frames, int ticks,
+                bool* have_last, std::vector<int64_t>* shown = nullptr) {
+  std::string pattern;
+  for (int tick = 0; tick < ticks && !frames.empty(); ++tick) {
+    cadence.Tick(frames.front());
+    while (!frames.empty()) {
+      const int64_t* next = frames.size() > 1 ? &frames[1] : nullptr;
+      const FrameCadence::Action action = cadence.Decide(frames.front(), next, *have_last);
+      if (action == FrameCadence::Action::kDrop) {
+        frames.pop_front();
+        cadence.Dropped();
+        pattern += 'd';
+        continue;
+      }
+      if (action == FrameCadence::Action::kRepeat) {
+        cadence.Repeated();
+        pattern += 'R';
+      } else {
+        cadence.Shown(frames.front());
+        if (shown) {
+          shown->push_back(frames.front());
+        }
+        frames.pop_front();
+        *have_last = true;
+        pattern += 's';
+      }
+      break;
+    }
+  }
+  return pattern;
+}
+
+// Ticks between consecutive occurrences of c in pattern (ticks only: drops
+// are not counted)
+std::vector<size_t> Spacing(const std::string& pattern, char c) {
+  std::vector<size_t> spacing;
+  size_t ticks = 0;
+  size_t last = 0;
+  bool seen = false;
+  for (char event : pattern) {
+    if (event == 'd') {
+      continue;
+    }
+    if (event == c) {
+      if (seen) {
+        spacing.push_back(ticks - last);
+      }
+      last = ticks;
+      seen = true;
+    }
+    ++ticks;
+  }
+  return spacing;
+}
+
+}  // namespace
+
+TEST(FrameCadenceTest, FilmGetsThreeTwoPulldown) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(24000.0 / 1001, 400);
+  bool have_last = false;
+  const std::string pattern = Pace(cadence, frames, 300, &have_last);
+
+  // Four frames over five ticks: every fifth tick repeats, nothing drops
+  const auto stats = cadence.GetStats();
+  EXPECT_EQ(stats.ticks, 300u);
+  EXPECT_EQ(stats.repeats, 60u);
+  EXPECT_EQ(stats.drops, 0u);
+  for (size_t spacing : Spacing(pattern, 'R')) {
+    EXPECT_EQ(spacing, 5u) << pattern;
+  }
+  // Whole frames, each within half a tick of its slot
+  EXPECT_LE(stats.max_error_us, std::llround(1'000'000 / kNtsc / 2) + 1);
+}
+
+TEST(FrameCadenceTest, PalRepeatsOneTickInSix) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(25, 400);
+  bool have_last = false;
+  const std::string pattern = Pace(cadence, frames, 300, &have_last);
+
+  const auto stats = cadence.GetStats();
+  EXPECT_EQ(stats.ticks, 300u);
+  EXPECT_EQ(stats.repeats, 50u);
+  EXPECT_EQ(stats.drops, 0u);
+  // Six ticks apart, seven now and then: 29.97 over 25 is a little under 6/5
+  for (size_t spacing : Spacing(pattern, 'R')) {
+    EXPECT_TRUE(spacing == 6 || spacing == 7) << pattern;
+  }
+}
+
+TEST(FrameCadenceTest, DoubleRateDropsEveryOtherFrame) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(60000.0 / 1001, 700);
+  bool have_last = false;
+  std::vector<int64_t> shown;
+  const std::string pattern = Pace(cadence, frames, 300, &have_last, &shown);
+
+  const auto stats = cadence.GetStats();
+  EXPECT_EQ(stats.ticks, 300u);
+  EXPECT_EQ(stats.repeats, 0u);
+  EXPECT_EQ(stats.drops, 299u);  // Frames 1, 3, 5...
+  EXPECT_EQ(pattern.substr(0, 8), "sdsdsdsd");
+  const auto all = Frames(60000.0 / 1001, 700);
+  for (size_t i = 0; i < shown.size(); ++i) {
+    ASSERT_EQ(shown[i], all[2 * i]);
+  }
+  EXPECT_LE(stats.max_error_us, 1);
+}
+
+TEST(FrameCadenceTest, FiftyDropsTwoFramesInFive) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(50, 700);
+  bool have_last = false;
+  const std::string pattern = Pace(cadence, frames, 300, &have_last);
+
+  // 50 fps is five frames per three ticks, not two per tick: two of every
+  // five are dropped, and the output rate holds with no repeats
+  const auto stats = cadence.GetStats();
+  EXPECT_EQ(stats.ticks, 300u);
+  EXPECT_EQ(stats.repeats, 0u);
+  EXPECT_EQ(stats.drops, 200u);
+  for (size_t spacing : Spacing(pattern, 'd')) {
+    EXPECT_TRUE(spacing == 1 || spacing == 2) << pattern;
+  }
+}
+
+TEST(FrameCadenceTest, MatchingRateShowsEveryFrameOnItsTick) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(kNtsc, 400);
+  bool have_last = false;
+  const std::string pattern = Pace(cadence, frames, 300, &have_last);
+  EXPECT_EQ(pattern, std::string(300, 's'));
+  EXPECT_EQ(cadence.GetStats().max_error_us, 0);
+}
+
+TEST(FrameCadenceTest, RepeatsWhileTheNextFrameIsLate) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(kNtsc, 10);
+  bool have_last = false;
+  Pace(cadence, frames, 10, &have_last);
+
+  // A frame two ticks past its slot: the two ticks before it repeat
+  const int64_t late = kStartPts + std::llround(12 * 1'000'000.0 / kNtsc);
+  frames.push_back(late);
+  EXPECT_EQ(Pace(cadence, frames, 3, &have_last), "RRs");
+  EXPECT_EQ(cadence.GetStats().repeats, 2u);
+}
+
+TEST(FrameCadenceTest, ReanchorsOnATimelineJump) {
+  FrameCadence cadence(kNtsc);
+  auto frames = Frames(kNtsc, 30);
+  bool have_last = false;
+  ASSERT_EQ(Pace(cadence, frames, 30, &have_last), std::string(30, 's'));
+
+  // Ten seconds on: the grid restarts at the new frame instead of
+  // repeating for ten seconds
+  const int64_t jumped = kStartPts + 11'000'000;
+  frames = Frames(kNtsc, 30, jumped);
+  EXPECT_EQ(cadence.Tick(jumped), jumped);
+  EXPECT_EQ(Pace(cadence, frames, 30, &have_last), std::string(30, 's'));
+
+  // And back, past kReanchorTicks
+  frames = Frames(kNtsc, 30, kStartPts);
+  EXPECT_EQ(Pace(cadence, frames, 30, &have_last), std::string(30, 's'));
+
+  const auto stats = cadence.GetStats();
+  EXPECT_EQ(stats.reanchors, 2u);
+  EXPECT_EQ(stats.repeats, 0u);
+  EXPECT_EQ(stats.drops, 0u);
+  EXPECT_EQ(stats.max_error_us, 0);
+
+  // Within kReanchorTicks the grid holds, and the frame waits its turn
+  const int64_t slot = kStartPts + std::llround(30 * 1'000'000.0 / kNtsc);
+  const int64_t near_jump = slot + std::llround(3 * 1'000'000.0 / kNtsc);
+  EXPECT_EQ(cadence.Tick(near_jump), slot);
+  EXPECT_EQ(cadence.GetStats().reanchors, 2u);
+}
@@ -0,0 +1,364 @@
+// Repository: Retrovue-playout
+// Component: Producer Unit Tests
+// Purpose: Tests the raw clip format, RawFileProducer, PlaylistProducer and SyntheticProducer.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/producers/playlist/PlaylistProducer.h"
+#include "retrovue/producers/raw_file/RawFileProducer.h"
+#include "retrovue/producers/synthetic/SyntheticProducer.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace retrovue::buffer;
+using namespace retrovue::producers::playlist;
+using namespace retrovue::producers::raw_file;
+using namespace retrovue::producers::synthetic;
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 36;
+
+// Writes a 30 fps clip whose frame i is filled with byte i, plus stereo
+// 48 kHz audio where every sample holds its sample index.
+std::filesystem::path WriteTestClip(const std::string& name, int frames) {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+  RawClipWriter writer;
+  EXPECT_TRUE(writer.Open(path.string(), kWidth, kHeight, 30, 1, 48000, 2));
+  for (int i = 0; i < frames; ++i) {
+    Frame frame;
+    frame.width = kWidth;
+    frame.height = kHeight;
+    frame.data.assign(kWidth * kHeight * 3 / 2, static_cast<uint8_t>(i));
+    EXPECT_TRUE(writer.AppendFrame(frame));
+  }
+  std::vector<int16_t> pcm(static_cast<size_t>(frames) * 1600 * 2);
+  for (size_t i = 0; i < pcm.size(); ++i) {
+    pcm[i] = static_cast<int16_t>(i / 2);
+  }
+  writer.AppendAudio(pcm.data(), pcm.size() / 2);
+  EXPECT_TRUE(writer.Finish());
+  return path;
+}
+
+bool WaitForSize(const FrameRingBuffer& buffer, size_t size) {
+  for (int i = 0; i < 200 && buffer.Size() < size; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return buffer.Size() >= size;
+}
+
+// Plays every playlist item as a RawFileProducer writing into buffer.
+PlaylistItemFactory RawItemFactory(FrameRingBuffer& buffer) {
+  return [&buffer](const std::string& asset_uri, PlaylistEventCallback on_event)
+             -> std::unique_ptr<retrovue::producers::ISwitchableProducer> {
+    RawProducerConfig config;
+    config.asset_uri = asset_uri;
+    return std::make_unique<RawFileProducer>(config, buffer, std::move(on_event));
+  };
+}
+
+}  // namespace
+
+// Test a written clip plays back every frame, in order, with its audio
+TEST(RawFileProducerTest, PlaysClipFromMapping) {
+  const auto path = WriteTestClip("retrovue_raw_producer_test.rvraw", 4);
+  EXPECT_TRUE(IsRawClip(path.string()));
+
+  FrameRingBuffer buffer(8);
+  RawProducerConfig config;
+  config.asset_uri = path.string();
+  std::atomic<bool> eof{false};
+  RawFileProducer producer(config, buffer, [&](const std::string& event, const std::string&) {
+    if (event == "eof") {
+      eof = true;
+    }
+  });
+  ASSERT_TRUE(producer.start());
+  EXPECT_EQ(producer.GetClipHeader().frame_count, 4u);
+  ASSERT_TRUE(WaitForSize(buffer, 4));
+
+  for (int i = 0; i < 4; ++i) {
+    FrameHandle frame;
+    ASSERT_TRUE(buffer.Pop(frame));
+    EXPECT_EQ(frame->width, kWidth);
+    EXPECT_EQ(frame->height, kHeight);
+    EXPECT_EQ(frame->metadata.pts, i * 1'000'000 / 30);
+    ASSERT_EQ(frame->data.size(), static_cast<size_t>(kWidth * kHeight * 3 / 2));
+    EXPECT_EQ(frame->data.front(), i);
+    EXPECT_EQ(frame->data.back(), i);
+
+    AudioFrame audio;
+    ASSERT_TRUE(buffer.PopAudioFrame(audio));
+    EXPECT_EQ(audio.nb_samples, 1600);
+    EXPECT_EQ(audio.channels, 2);
+    EXPECT_EQ(reinterpret_cast<const int16_t*>(audio.data.data())[0], i * 1600);
+  }
+
+  producer.stop();
+  EXPECT_EQ(producer.GetFramesProduced(), 4u);
+  EXPECT_TRUE(eof);
+  std::filesystem::remove(path);
+}
+
+// Test shadow mode holds delivery until the switch and honours AlignPTS
+TEST(RawFileProducerTest, ShadowModeHoldsUntilSwitch) {
+  const auto path = WriteTestClip("retrovue_raw_producer_shadow_test.rvraw", 3);
+
+  FrameRingBuffer buffer(8);
+  RawProducerConfig config;
+  config.asset_uri = path.string();
+  RawFileProducer producer(config, buffer);
+  producer.SetShadowDecodeMode(true);
+  ASSERT_TRUE(producer.start());
+  EXPECT_TRUE(producer.IsShadowDecodeReady());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(buffer.IsEmpty());
+
+  producer.AlignPTS(5'000'000);
+  EXPECT_EQ(producer.GetNextPTS(), 5'000'000);
+  producer.SetShadowDecodeMode(false);
+  ASSERT_TRUE(WaitForSize(buffer, 3));
+
+  FrameHandle frame;
+  ASSERT_TRUE(buffer.Pop(frame));
+  EXPECT_EQ(frame->metadata.pts, 5'000'000);
+  ASSERT_TRUE(buffer.Pop(frame));
+  EXPECT_EQ(frame->metadata.pts, 5'000'000 + 1'000'000 / 30);
+
+  producer.stop();
+  std::filesystem::remove(path);
+}
+
+// Test files that are not complete raw clips are rejected at start()
+TEST(RawFileProducerTest, RejectsInvalidClip) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "retrovue_raw_producer_invalid.rvraw";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "not a raw clip, just some bytes padding the header out to size....";
+  }
+  EXPECT_FALSE(IsRawClip(path.string()));
+
+  FrameRingBuffer buffer(8);
+  RawProducerConfig config;
+  config.asset_uri = path.string();
+  RawFileProducer producer(config, buffer);
+  EXPECT_FALSE(producer.start());
+  EXPECT_FALSE(producer.isRunning());
+
+  // A valid header whose frames were truncated away
+  const auto clip = WriteTestClip("retrovue_raw_producer_truncated.rvraw", 2);
+  std::filesystem::resize_file(clip, std::filesystem::file_size(clip) / 2);
+  config.asset_uri = clip.string();
+  RawFileProducer truncated(config, buffer);
+  EXPECT_FALSE(truncated.start());
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(clip);
+}
+
+// Test items play back to back with continuous PTS across each boundary
+TEST(PlaylistProducerTest, PlaysItemsGaplessly) {
+  const std::vector<std::filesystem::path> clips = {
+      WriteTestClip("retrovue_playlist_a.rvraw", 3),
+      WriteTestClip("retrovue_playlist_b.rvraw", 2),
+      WriteTestClip("retrovue_playlist_c.rvraw", 4)};
+
+  FrameRingBuffer buffer(16);
+  PlaylistConfig config;
+  for (const auto& clip : clips) {
+    config.asset_uris.push_back(clip.string());
+  }
+  std::atomic<int> items_started{0};
+  std::atomic<bool> eof{false};
+  PlaylistProducer playlist(config, RawItemFactory(buffer),
+                            [&](const std::string& event, const std::string&) {
+                              if (event == "item_started") {
+                                ++items_started;
+                              } else if (event == "eof") {
+                                eof = true;
+                              }
+                            });
+  ASSERT_TRUE(playlist.start());
+  ASSERT_TRUE(WaitForSize(buffer, 9));
+  for (int i = 0; i < 200 && !eof; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_TRUE(eof);
+  EXPECT_FALSE(playlist.isRunning());
+  EXPECT_EQ(playlist.GetTransitionCount(), 2u);
+  EXPECT_EQ(playlist.GetCurrentIndex(), 2u);
+  EXPECT_EQ(items_started, 3);
+
+  // Frame rate rounding may move a boundary frame by 1 us, never by a frame
+  const std::vector<uint8_t> expected_fill = {0, 1, 2, 0, 1, 0, 1, 2, 3};
+  int64_t last_pts = -1;
+  for (size_t i = 0; i < expected_fill.size(); ++i) {
+    FrameHandle frame;
+    ASSERT_TRUE(buffer.Pop(frame));
+    EXPECT_EQ(frame->data.front(), expected_fill[i]) << "frame " << i;
+    if (i == 0) {
+      EXPECT_EQ(frame->metadata.pts, 0);
+    } else {
+      EXPECT_NEAR(frame->metadata.pts - last_pts, 1'000'000 / 30, 1) << "frame " << i;
+    }
+    last_pts = frame->metadata.pts;
+  }
+  EXPECT_TRUE(buffer.IsEmpty());
+
+  playlist.stop();
+  for (const auto& clip : clips) {
+    std::filesystem::remove(clip);
+  }
+}
+
+// Test unplayable items are skipped and a playlist in shadow mode holds
+TEST(PlaylistProducerTest, SkipsUnplayableItemsAndHonoursShadowMode) {
+  const auto first = WriteTestClip("retrovue_playlist_skip_a.rvraw", 2);
+  const auto last = WriteTestClip("retrovue_playlist_skip_b.rvraw", 2);
+
+  FrameRingBuffer buffer(16);
+  PlaylistConfig config;
+  config.asset_uris = {"/nonexistent/retrovue_missing.rvraw", first.string(),
+                       "/nonexistent/retrovue_missing_too.rvraw", last.string()};
+  std::atomic<int> errors{0};
+  PlaylistProducer playlist(config, RawItemFactory(buffer),
+                            [&](const std::string& event, const std::string&) {
+                              if (event == "error") {
+                                ++errors;
+                              }
+                            });
+  playlist.SetShadowDecodeMode(true);
+  ASSERT_TRUE(playlist.start());
+  EXPECT_EQ(playlist.GetCurrentIndex(), 1u);
+  EXPECT_TRUE(playlist.IsShadowDecodeReady());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(buffer.IsEmpty());
+
+  playlist.AlignPTS(2'000'000);
+  playlist.SetShadowDecodeMode(false);
+  ASSERT_TRUE(WaitForSize(buffer, 4));
+  for (int i = 0; i < 200 && playlist.isRunning(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(playlist.GetCurrentIndex(), 3u);
+  EXPECT_EQ(playlist.GetTransitionCount(), 1u);
+  EXPECT_EQ(errors, 2);
+
+  FrameHandle frame;
+  ASSERT_TRUE(buffer.Pop(frame));
+  EXPECT_EQ(frame->metadata.pts, 2'000'000);
+  int64_t last_pts = frame->metadata.pts;
+  while (buffer.Pop(frame)) {
+    EXPECT_NEAR(frame->metadata.pts - last_pts, 1'000'000 / 30, 1);
+    last_pts = frame->metadata.pts;
+  }
+
+  playlist.stop();
+  std::filesystem::remove(first);
+  std::filesystem::remove(last);
+}
+
+// Test start() fails when nothing in the playlist can be opened
+TEST(PlaylistProducerTest, FailsWithoutPlayableItems) {
+  FrameRingBuffer buffer(8);
+  PlaylistConfig config;
+  config.asset_uris = {"/nonexistent/retrovue_missing.rvraw"};
+  PlaylistProducer playlist(config, RawItemFactory(buffer));
+  EXPECT_FALSE(playlist.start());
+  EXPECT_FALSE(playlist.isRunning());
+
+  PlaylistProducer empty(PlaylistConfig{}, RawItemFactory(buffer));
+  EXPECT_FALSE(empty.start());
+}
+
+// Test the pattern moves, repeats after template_count frames and ends at
+// frame_limit with contiguous PTS
+TEST(SyntheticProducerTest, LoopsTemplatesUpToFrameLimit) {
+  FrameRingBuffer buffer(16);
+  SyntheticProducerConfig config;
+  config.width = kWidth;
+  config.height = kHeight;
+  config.template_count = 4;
+  config.frame_limit = 10;
+  config.realtime = false;
+  std::atomic<bool> eof{false};
+  SyntheticProducer producer(config, buffer, [&](const std::string& event, const std::string&) {
+    if (event == "eof") {
+      eof = true;
+    }
+  });
+  ASSERT_TRUE(producer.start());
+  ASSERT_TRUE(WaitForSize(buffer, 10));
+  for (int i = 0; i < 200 && !eof; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_TRUE(eof);
+  EXPECT_EQ(producer.GetFramesProduced(), 10u);
+
+  std::vector<std::vector<uint8_t>> payloads;
+  for (int i = 0; i < 10; ++i) {
+    FrameHandle frame;
+    ASSERT_TRUE(buffer.Pop(frame));
+    EXPECT_EQ(frame->width, kWidth);
+    EXPECT_EQ(frame->height, kHeight);
+    EXPECT_EQ(frame->metadata.pts, (i * 1'000'000 + 15) / 30);
+    ASSERT_EQ(frame->data.size(), static_cast<size_t>(kWidth * kHeight * 3 / 2));
+    payloads.emplace_back(frame->data.begin(), frame->data.end());
+  }
+  EXPECT_NE(payloads[0], payloads[1]);
+  EXPECT_EQ(payloads[0], payloads[4]);
+  EXPECT_EQ(payloads[3], payloads[7]);
+
+  producer.stop();
+
+  // A second producer on the same profile shares the rendered templates
+  const auto templates = GetSyntheticTemplates(config);
+  ASSERT_NE(templates, nullptr);
+  EXPECT_EQ(templates, GetSyntheticTemplates(config));
+  EXPECT_EQ(templates->frames.size(), 4u);
+}
+
+// Test realtime pacing, shadow hold and AlignPTS
+TEST(SyntheticProducerTest, RealtimeShadowModeHoldsUntilSwitch) {
+  FrameRingBuffer buffer(16);
+  SyntheticProducerConfig config;
+  config.width = kWidth;
+  config.height = kHeight;
+  config.complexity = SyntheticComplexity::kNoise;
+  config.target_fps = 100.0;
+  SyntheticProducer producer(config, buffer);
+  producer.SetShadowDecodeMode(true);
+  ASSERT_TRUE(producer.start());
+  EXPECT_TRUE(producer.IsShadowDecodeReady());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(buffer.IsEmpty());
+
+  producer.AlignPTS(3'000'000);
+  const auto switched = std::chrono::steady_clock::now();
+  producer.SetShadowDecodeMode(false);
+  ASSERT_TRUE(WaitForSize(buffer, 5));
+  // Five frames at 100 fps are due over 40 ms, not all at once
+  EXPECT_GE(std::chrono::steady_clock::now() - switched, std::chrono::milliseconds(35));
+  producer.stop();
+
+  FrameHandle frame;
+  ASSERT_TRUE(buffer.Pop(frame));
+  EXPECT_EQ(frame->metadata.pts, 3'000'000);
+  ASSERT_TRUE(buffer.Pop(frame));
+  EXPECT_EQ(frame->metadata.pts, 3'010'000);
+
+  SyntheticProducerConfig invalid;
+  invalid.width = 33;
+  SyntheticProducer rejected(invalid, buffer);
+  EXPECT_FALSE(rejected.start());
+}
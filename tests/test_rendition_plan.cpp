@@ -0,0 +1,164 @@
+// Repository: Retrovue-playout
+// Component: Rendition Plan Unit Tests
+// Purpose: Tests the rung sizes, bitrates and scale cascade resolved against the source.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/RenditionPlan.hpp"
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::kMinRenditionBitrate;
+using retrovue::playout_sinks::mpegts::PlanRenditionLadder;
+using retrovue::playout_sinks::mpegts::RenditionConfig;
+using retrovue::playout_sinks::mpegts::RenditionRung;
+
+namespace {
+
+RenditionConfig Rendition(int width, int height, int bitrate = 1'000'000) {
+  RenditionConfig config;
+  config.width = width;
+  config.height = height;
+  config.bitrate = bitrate;
+  return config;
+}
+
+struct SizeCase {
+  const char* name;
+  int width;            // Configured
+  int height;
+  int source_width;
+  int source_height;
+  int expected_width;
+  int expected_height;
+  bool clamped;
+};
+
+struct BitrateCase {
+  const char* name;
+  int width;            // Configured
+  int height;
+  int bitrate;          // Configured (0 = derived)
+  int source_width;
+  int source_height;
+  int source_bitrate;
+  int expected;
+  bool clamped;
+};
+
+struct ExpectedRung {
+  size_t index;
+  int width;
+  int height;
+  int source;
+};
+
+struct LadderCase {
+  const char* name;
+  std::vector<RenditionConfig> renditions;
+  int source_width;
+  int source_height;
+  std::vector<ExpectedRung> expected;  // Largest first
+};
+
+}  // namespace
+
+TEST(RenditionPlanTest, ShrinksRungsToFitTheSource) {
+  const SizeCase cases[] = {
+      {"smaller than the source", 1280, 720, 1920, 1080, 1280, 720, false},
+      {"the source size", 1920, 1080, 1920, 1080, 1920, 1080, false},
+      {"larger than the source", 1920, 1080, 1280, 720, 1280, 720, true},
+      // Bound by the height, width kept in proportion and rounded to even
+      {"portrait rung", 1080, 1920, 1280, 720, 404, 720, true},
+      // Only the height overshoots (576-line anamorphic source)
+      {"taller than the source", 1280, 720, 1440, 576, 1024, 576, true},
+      // Odd source dimensions round down to even
+      {"odd source", 1920, 1080, 1279, 719, 1278, 718, true},
+      // Never below 2x2
+      {"sliver", 4000, 2, 100, 100, 100, 2, true},
+      // Before the first frame sizes are kept
+      {"source unknown", 3840, 2160, 0, 0, 3840, 2160, false},
+  };
+  for (const SizeCase& c : cases) {
+    SCOPED_TRACE(c.name);
+    const std::vector<RenditionRung> rungs =
+        PlanRenditionLadder({Rendition(c.width, c.height)}, c.source_width, c.source_height,
+                            5'000'000);
+    ASSERT_EQ(rungs.size(), 1u);
+    EXPECT_EQ(rungs[0].width, c.expected_width);
+    EXPECT_EQ(rungs[0].height, c.expected_height);
+    EXPECT_EQ(rungs[0].bitrate, 1'000'000);
+    EXPECT_EQ(rungs[0].clamped, c.clamped);
+  }
+}
+
+TEST(RenditionPlanTest, DerivesBitratesFromTheSourceAndCapsThem) {
+  const BitrateCase cases[] = {
+      {"configured", 1280, 720, 3'000'000, 1920, 1080, 5'000'000, 3'000'000, false},
+      {"above the source", 1280, 720, 8'000'000, 1920, 1080, 5'000'000, 5'000'000, true},
+      // 720p carries 4/9 of the 1080p pixels, 360p 1/9
+      {"derived 720p", 1280, 720, 0, 1920, 1080, 4'500'000, 2'000'000, false},
+      {"derived 360p", 640, 360, 0, 1920, 1080, 9'000'000, 1'000'000, false},
+      {"derived below the floor", 320, 180, 0, 1920, 1080, 1'000'000, kMinRenditionBitrate,
+       false},
+      {"floor above the source", 320, 180, 0, 1920, 1080, 150'000, 150'000, true},
+      // Shrunk to the source first, so it takes the whole source bitrate
+      {"derived after shrinking", 3840, 2160, 0, 1920, 1080, 5'000'000, 5'000'000, true},
+      // Before the first frame the largest rung stands in for the source
+      {"source unknown", 1280, 720, 0, 0, 0, 4'000'000, 4'000'000, false},
+  };
+  for (const BitrateCase& c : cases) {
+    SCOPED_TRACE(c.name);
+    const std::vector<RenditionRung> rungs = PlanRenditionLadder(
+        {Rendition(c.width, c.height, c.bitrate)}, c.source_width, c.source_height,
+        c.source_bitrate);
+    ASSERT_EQ(rungs.size(), 1u);
+    EXPECT_EQ(rungs[0].bitrate, c.expected);
+    EXPECT_EQ(rungs[0].clamped, c.clamped);
+  }
+}
+
+TEST(RenditionPlanTest, OrdersLargestFirstAndCascadesWithin2To1) {
+  const LadderCase cases[] = {
+      // Each step scales from the one above
+      {"1080p ladder",
+       {Rendition(640, 360), Rendition(1920, 1080), Rendition(1280, 720), Rendition(320, 180),
+        Rendition(960, 540)},
+       1920,
+       1080,
+       {{1, 1920, 1080, -1}, {2, 1280, 720, 0}, {4, 960, 540, 1}, {0, 640, 360, 2},
+        {3, 320, 180, 3}}},
+      // Beyond 2:1 from every larger rung: scaled from the source frame
+      {"steep ladder",
+       {Rendition(1920, 1080), Rendition(480, 270)},
+       1920,
+       1080,
+       {{0, 1920, 1080, -1}, {1, 480, 270, -1}}},
+      // Equal sizes keep their configured order, the second copying the first
+      {"tie",
+       {Rendition(1280, 720), Rendition(640, 360), Rendition(1280, 720)},
+       1920,
+       1080,
+       {{0, 1280, 720, -1}, {2, 1280, 720, 0}, {1, 640, 360, 1}}},
+      // A rung shrunk to the source size still feeds the cascade
+      {"720p source",
+       {Rendition(1280, 720), Rendition(1920, 1080)},
+       1280,
+       720,
+       {{1, 1280, 720, -1}, {0, 1280, 720, 0}}},
+  };
+  for (const LadderCase& c : cases) {
+    SCOPED_TRACE(c.name);
+    const std::vector<RenditionRung> rungs =
+        PlanRenditionLadder(c.renditions, c.source_width, c.source_height, 5'000'000);
+    ASSERT_EQ(rungs.size(), c.expected.size());
+    for (size_t i = 0; i < rungs.size(); ++i) {
+      SCOPED_TRACE(i);
+      EXPECT_EQ(rungs[i].index, c.expected[i].index);
+      EXPECT_EQ(rungs[i].width, c.expected[i].width);
+      EXPECT_EQ(rungs[i].height, c.expected[i].height);
+      EXPECT_EQ(rungs[i].source, c.expected[i].source);
+    }
+  }
+}
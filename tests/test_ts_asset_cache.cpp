@@ -0,0 +1,194 @@
+// Repository: Retrovue-playout
+// Component: TS Asset Cache Unit Tests
+// Purpose: Tests lookups keyed by asset and profile, LRU eviction and the cache directory.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsAssetCache.hpp"
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::MuxerConfig;
+using retrovue::playout_sinks::mpegts::TsAssetCache;
+using retrovue::playout_sinks::mpegts::TsFillerClip;
+using retrovue::playout_sinks::mpegts::TSMuxer;
+using retrovue::playout_sinks::mpegts::TsStream;
+
+namespace {
+
+const std::string kProfile = "h264 1280x720@30 4000000bps gop30 fixed";
+const std::string kOtherProfile = "h264 1920x1080@30 4000000bps gop30 fixed";
+
+int Collect(void* opaque, uint8_t* buf, int buf_size) {
+  auto* out = static_cast<std::vector<uint8_t>*>(opaque);
+  out->insert(out->end(), buf, buf + buf_size);
+  return buf_size;
+}
+
+// A clip of frames video frames from PTS 0, as TSMuxer lays it out
+std::shared_ptr<const TsFillerClip> Clip(int frames) {
+  std::vector<uint8_t> ts;
+  TSMuxer muxer;
+  EXPECT_TRUE(muxer.Initialize(MuxerConfig{}, &ts, &Collect));
+  for (int i = 0; i < frames; ++i) {
+    const uint8_t nal_type = i == 0 ? 0x65 : 0x41;
+    std::vector<uint8_t> au = {0x00, 0x00, 0x00, 0x01, nal_type};
+    au.resize(i == 0 ? 3000 : 600, 0x5A);
+    EXPECT_TRUE(
+        muxer.MuxFrame(TsStream::kVideo, au.data(), au.size(), i * 3000, i * 3000, i == 0));
+  }
+  EXPECT_TRUE(muxer.Flush());
+  auto clip = std::make_shared<TsFillerClip>();
+  EXPECT_TRUE(clip->Load(ts));
+  return clip;
+}
+
+// A scratch directory, removed again
+class TempDir {
+ public:
+  explicit TempDir(const std::string& name)
+      : path_(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(path_);
+    std::filesystem::create_directories(path_);
+  }
+  ~TempDir() { std::filesystem::remove_all(path_); }
+
+  std::string Path(const std::string& name) const { return (path_ / name).string(); }
+
+ private:
+  std::filesystem::path path_;
+};
+
+}  // namespace
+
+TEST(TsAssetCacheTest, HitsOnlyForTheProfileAnAiringWasEncodedWith) {
+  TsAssetCache cache;
+  const auto clip = Clip(5);
+  EXPECT_EQ(cache.Find("promo.mp4", kProfile), nullptr);
+  cache.Insert("promo.mp4", kProfile, clip);
+
+  EXPECT_EQ(cache.Find("promo.mp4", kProfile), clip);
+  EXPECT_EQ(cache.Find("promo.mp4", kOtherProfile), nullptr);  // Other resolution
+  EXPECT_EQ(cache.Find("bumper.mp4", kProfile), nullptr);
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 3u);
+  EXPECT_EQ(stats.inserts, 1u);
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_EQ(stats.size_bytes, clip->size_bytes());
+
+  // Each profile gets its own entry (and its own file name)
+  const auto other = Clip(6);
+  cache.Insert("promo.mp4", kOtherProfile, other);
+  EXPECT_EQ(cache.Find("promo.mp4", kOtherProfile), other);
+  EXPECT_EQ(cache.Find("promo.mp4", kProfile), clip);
+  EXPECT_NE(TsAssetCache::FileName("promo.mp4", kProfile),
+            TsAssetCache::FileName("promo.mp4", kOtherProfile));
+
+  // Inserting again replaces the entry
+  const auto newer = Clip(7);
+  cache.Insert("promo.mp4", kProfile, newer);
+  EXPECT_EQ(cache.Find("promo.mp4", kProfile), newer);
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.entries, 2u);
+  EXPECT_EQ(stats.size_bytes, other->size_bytes() + newer->size_bytes());
+
+  cache.Clear();
+  EXPECT_EQ(cache.Find("promo.mp4", kProfile), nullptr);
+  EXPECT_EQ(cache.GetStats().size_bytes, 0u);
+}
+
+TEST(TsAssetCacheTest, EvictsTheLeastRecentlyUsedPastTheByteLimit) {
+  const auto a = Clip(5);
+  const auto b = Clip(5);
+  const auto c = Clip(5);
+  const size_t clip_bytes = a->size_bytes();
+  TsAssetCache cache(clip_bytes * 5 / 2);  // Room for two
+
+  cache.Insert("a.mp4", kProfile, a);
+  cache.Insert("b.mp4", kProfile, b);
+  EXPECT_EQ(cache.GetStats().evictions, 0u);
+
+  // a was used last, so b goes when c comes in
+  EXPECT_EQ(cache.Find("a.mp4", kProfile), a);
+  cache.Insert("c.mp4", kProfile, c);
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.entries, 2u);
+  EXPECT_EQ(stats.size_bytes, 2 * clip_bytes);
+  EXPECT_LE(stats.size_bytes, cache.capacity_bytes());
+  EXPECT_EQ(cache.Find("b.mp4", kProfile), nullptr);
+  EXPECT_EQ(cache.Find("a.mp4", kProfile), a);
+  EXPECT_EQ(cache.Find("c.mp4", kProfile), c);
+
+  // An evicted clip still being emitted lives on through its reference
+  EXPECT_EQ(b->frame_count(), 5u);
+
+  // A clip larger than the whole cache is not kept, and evicts nothing
+  cache.Insert("long.mp4", kProfile, Clip(40));
+  EXPECT_EQ(cache.Find("long.mp4", kProfile), nullptr);
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.inserts, 3u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.entries, 2u);
+
+  // Nor is an empty one
+  cache.Insert("empty.mp4", kProfile, std::make_shared<TsFillerClip>());
+  cache.Insert("null.mp4", kProfile, nullptr);
+  EXPECT_EQ(cache.GetStats().inserts, 3u);
+}
+
+TEST(TsAssetCacheTest, LoadsOnlyTheMatchingProfilesFileFromItsDirectory) {
+  TempDir dir("retrovue_ts_asset_cache_test");
+  const std::string asset = dir.Path("promo.mp4");
+  { std::ofstream(asset) << "the asset"; }
+  const auto clip = Clip(5);
+  {
+    TsAssetCache recorder(TsAssetCache::kDefaultCapacityBytes, dir.Path("cache"));
+    recorder.Insert(asset, kProfile, clip);
+  }
+  ASSERT_TRUE(
+      std::filesystem::exists(dir.Path("cache/" + TsAssetCache::FileName(asset, kProfile))));
+
+  // A restarted cache finds the airing on disk for its profile only
+  TsAssetCache cache(TsAssetCache::kDefaultCapacityBytes, dir.Path("cache"));
+  EXPECT_EQ(cache.Find(asset, kOtherProfile), nullptr);
+  const auto loaded = cache.Find(asset, kProfile);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(loaded->bytes(), clip->bytes());
+  EXPECT_EQ(loaded->frame_count(), clip->frame_count());
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.disk_loads, 1u);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(cache.Find(asset, kProfile), loaded);  // Now from memory
+  EXPECT_EQ(cache.GetStats().disk_loads, 1u);
+
+  // A replaced asset file is a different key: the old airing does not match
+  { std::ofstream(asset) << "the asset, re-edited"; }
+  EXPECT_EQ(cache.Find(asset, kProfile), nullptr);
+
+  // A file in the cache directory that holds no video frame (null packets
+  // here) is ignored
+  const std::string bumper = dir.Path("bumper.mp4");
+  { std::ofstream(bumper) << "bumper"; }
+  {
+    std::ofstream bad(dir.Path("cache/" + TsAssetCache::FileName(bumper, kProfile)),
+                      std::ios::binary);
+    std::vector<char> nulls(188 * 4, static_cast<char>(0xFF));
+    for (size_t offset = 0; offset < nulls.size(); offset += 188) {
+      nulls[offset] = 0x47;
+      nulls[offset + 1] = 0x1F;
+      nulls[offset + 3] = 0x10;
+    }
+    bad.write(nulls.data(), static_cast<std::streamsize>(nulls.size()));
+  }
+  EXPECT_EQ(cache.Find(bumper, kProfile), nullptr);
+  EXPECT_EQ(cache.GetStats().disk_loads, 1u);
+}
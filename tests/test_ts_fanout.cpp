@@ -0,0 +1,382 @@
+// Repository: Retrovue-playout
+// Component: TS Fanout Unit Tests
+// Purpose: Tests per-client queues and the slow-client policies over socketpairs and pipes.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::SlowClientPolicy;
+using retrovue::playout_sinks::mpegts::TsFanout;
+
+namespace {
+
+constexpr size_t kPacket = 188;
+constexpr size_t kSequenceOffset = 184;  // Packet sequence number, in the payload
+
+// Packets numbered from first, on PID 0x100; with pat, a PAT packet
+// numbered first comes before them, and with keyframe, the start of a video
+// keyframe (random access indicator, PES start) after that
+std::vector<uint8_t> Chunk(uint32_t first, size_t packets, bool pat = false,
+                           bool keyframe = false) {
+  std::vector<uint8_t> bytes(packets * kPacket, 0xAA);
+  for (size_t i = 0; i < packets; ++i) {
+    uint8_t* packet = bytes.data() + i * kPacket;
+    const bool table = pat && i == 0;
+    packet[0] = 0x47;
+    packet[1] = table ? 0x40 : 0x01;
+    packet[2] = 0x00;
+    packet[3] = 0x10;
+    if (keyframe && i == (pat ? 1u : 0u)) {
+      const uint8_t start[] = {0x41, 0x00, 0x30, 0x01, 0x40, 0x00, 0x00, 0x01, 0xE0};
+      std::copy(start, start + sizeof(start), packet + 1);
+    }
+    const uint32_t sequence = first + static_cast<uint32_t>(i);
+    packet[kSequenceOffset] = static_cast<uint8_t>(sequence >> 24);
+    packet[kSequenceOffset + 1] = static_cast<uint8_t>(sequence >> 16);
+    packet[kSequenceOffset + 2] = static_cast<uint8_t>(sequence >> 8);
+    packet[kSequenceOffset + 3] = static_cast<uint8_t>(sequence);
+  }
+  return bytes;
+}
+
+std::vector<uint32_t> Sequences(const std::vector<uint8_t>& bytes) {
+  EXPECT_EQ(bytes.size() % kPacket, 0u);
+  std::vector<uint32_t> sequences;
+  for (size_t offset = 0; offset + kPacket <= bytes.size(); offset += kPacket) {
+    const uint8_t* p = bytes.data() + offset + kSequenceOffset;
+    sequences.push_back((static_cast<uint32_t>(p[0]) << 24) |
+                        (static_cast<uint32_t>(p[1]) << 16) |
+                        (static_cast<uint32_t>(p[2]) << 8) | p[3]);
+  }
+  return sequences;
+}
+
+bool KeyframeStart(const uint8_t* packet) {
+  return TsFanout::KeyframeOffset(packet, kPacket) == 0;
+}
+
+// A socketpair: the fanout's end, and the client's. A slow client's
+// buffers are as small as the kernel allows, so its sender blocks early.
+struct Client {
+  explicit Client(bool slow = false) {
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    if (slow) {
+      const int size = 1;  // Rounded up to the minimum
+      setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+      setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+  }
+
+  ~Client() {
+    if (reader.joinable()) {
+      reader.join();
+    }
+    close(fds[1]);
+  }
+
+  // Reads on a thread from now until the fanout closes its end
+  void StartReading() {
+    reader = std::thread([this] {
+      uint8_t buf[16384];
+      ssize_t n;
+      while ((n = read(fds[1], buf, sizeof(buf))) > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bytes.insert(bytes.end(), buf, buf + n);
+      }
+    });
+  }
+
+  size_t Received() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes.size();
+  }
+
+  // Waits for the reader to have size bytes
+  bool WaitFor(size_t size) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (Received() < size) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  // The bytes received, once the reader has seen the end of the stream
+  std::vector<uint8_t> Finish() {
+    if (reader.joinable()) {
+      reader.join();
+    }
+    return bytes;
+  }
+
+  int fds[2] = {-1, -1};
+  std::thread reader;
+  std::mutex mutex;
+  std::vector<uint8_t> bytes;
+};
+
+bool WaitUntil(const std::function<bool()>& done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(TsFanoutTest, EvictsASlowReaderWithoutHoldingUpAFastOne) {
+  constexpr size_t kChunks = 200;
+  constexpr size_t kChunkPackets = 20;
+  TsFanout fanout(4, 64 * 1024, SlowClientPolicy::EVICT);
+  Client fast;
+  Client slow(/*slow=*/true);
+  ASSERT_TRUE(fanout.AddSubscriber(fast.fds[0], "fast"));
+  ASSERT_TRUE(fanout.AddSubscriber(slow.fds[0], "slow"));
+  fast.StartReading();
+
+  // The fast reader takes each chunk before the next; the slow one reads
+  // nothing until its queue passes queue_bytes
+  for (uint32_t i = 0; i < kChunks; ++i) {
+    const auto chunk = Chunk(i * kChunkPackets, kChunkPackets, i == 0);
+    fanout.Publish(chunk.data(), chunk.size());
+    ASSERT_TRUE(fast.WaitFor((i + 1) * chunk.size())) << "chunk " << i;
+  }
+  auto stats = fanout.GetStats();
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.lag_evictions, 0u);
+  EXPECT_EQ(stats.chunks_dropped, 0u);
+  EXPECT_TRUE(WaitUntil([&] { return fanout.SubscriberCount() == 1; }));
+
+  // The evicted reader sees what reached its socket, then the end of the
+  // stream; the fast one every packet, in order
+  slow.StartReading();
+  fanout.CloseAll(nullptr, 0, 1000);
+  const auto slow_sequences = Sequences(slow.Finish());
+  EXPECT_LT(slow_sequences.size(), kChunks * kChunkPackets);
+  for (size_t i = 0; i < slow_sequences.size(); ++i) {
+    ASSERT_EQ(slow_sequences[i], i);
+  }
+  const auto fast_sequences = Sequences(fast.Finish());
+  ASSERT_EQ(fast_sequences.size(), kChunks * kChunkPackets);
+  for (size_t i = 0; i < fast_sequences.size(); ++i) {
+    ASSERT_EQ(fast_sequences[i], i);
+  }
+  stats = fanout.GetStats();
+  EXPECT_EQ(stats.send_failures, 0u);
+  EXPECT_EQ(stats.bytes_published, kChunks * kChunkPackets * kPacket);
+}
+
+TEST(TsFanoutTest, JoinsMidStreamAtTheNextPat) {
+  TsFanout fanout(1, 64 * 1024, SlowClientPolicy::EVICT);
+  Client client;
+  ASSERT_TRUE(fanout.AddSubscriber(client.fds[0], "late"));
+  client.StartReading();
+  const auto before = Chunk(0, 5);
+  fanout.Publish(before.data(), before.size());
+  const auto from_pat = Chunk(5, 5, /*pat=*/true);
+  fanout.Publish(from_pat.data(), from_pat.size());
+
+  // One subscriber at most
+  Client extra;
+  EXPECT_FALSE(fanout.AddSubscriber(extra.fds[0], "extra"));
+
+  fanout.CloseAll(nullptr, 0, 1000);
+  EXPECT_EQ(client.Finish(), from_pat);
+  EXPECT_EQ(fanout.GetStats().rejected, 1u);
+}
+
+TEST(TsFanoutTest, EvictsAReaderLaggingPastMaxLag) {
+  constexpr size_t kChunkPackets = 20;
+  // Far more queue_bytes than the test publishes: only the lag limit applies
+  TsFanout fanout(4, 64 * 1024 * 1024, SlowClientPolicy::EVICT, 0, 256 * 1024, 0,
+                  /*max_lag_ms=*/100);
+  Client fast;
+  Client slow(/*slow=*/true);
+  ASSERT_TRUE(fanout.AddSubscriber(fast.fds[0], "fast"));
+  ASSERT_TRUE(fanout.AddSubscriber(slow.fds[0], "slow"));
+  fast.StartReading();
+
+  // Enough to fill the slow client's socket and leave chunks queued
+  uint32_t sequence = 0;
+  auto publish = [&] {
+    const auto chunk = Chunk(sequence, kChunkPackets, sequence == 0);
+    sequence += kChunkPackets;
+    fanout.Publish(chunk.data(), chunk.size());
+    return fast.WaitFor(sequence * kPacket);
+  };
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_TRUE(publish());
+  }
+  EXPECT_EQ(fanout.GetStats().evictions, 0u);
+  EXPECT_GT(fanout.GetStats().max_queued_bytes, 0u);
+
+  // The oldest queued chunk outlives max_lag_ms: the next publish evicts
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  ASSERT_TRUE(publish());
+  auto stats = fanout.GetStats();
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.lag_evictions, 1u);
+  EXPECT_TRUE(WaitUntil([&] { return fanout.SubscriberCount() == 1; }));
+
+  // The fast reader was never behind by that much, and carries on
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(publish());
+  }
+  slow.StartReading();
+  fanout.CloseAll(nullptr, 0, 1000);
+  slow.Finish();
+  const auto fast_sequences = Sequences(fast.Finish());
+  ASSERT_EQ(fast_sequences.size(), sequence);
+  for (size_t i = 0; i < fast_sequences.size(); ++i) {
+    ASSERT_EQ(fast_sequences[i], i);
+  }
+  stats = fanout.GetStats();
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.send_failures, 0u);
+}
+
+TEST(TsFanoutTest, HoldsAPipeSubscribersChunksUntilTheReaderIsPastThem) {
+  TsFanout fanout(1, 64 * 1024, SlowClientPolicy::EVICT);
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+  ASSERT_TRUE(fanout.AddSubscriber(pipe_fds[1], "pipe", /*pipe=*/true));
+
+  // Two chunks spliced into the pipe and left unread
+  const auto first = Chunk(0, 20, /*pat=*/true);
+  const auto second = Chunk(20, 20);
+  fanout.Publish(first.data(), first.size());
+  fanout.Publish(second.data(), second.size());
+  const size_t total = first.size() + second.size();
+  ASSERT_TRUE(WaitUntil([&] {
+    int unread = 0;
+    return ioctl(pipe_fds[0], FIONREAD, &unread) == 0 && static_cast<size_t>(unread) == total;
+  }));
+
+  // Closed with the pipe unread: the subscriber drains instead of freeing
+  // memory the pipe still points at, and its write end stays open
+  fanout.CloseAll(nullptr, 0, 1000);
+  const auto write_end_open = [&] {
+    struct pollfd pfd = {pipe_fds[0], POLLIN, 0};
+    return poll(&pfd, 1, 0) >= 0 && (pfd.revents & POLLHUP) == 0;
+  };
+  EXPECT_EQ(fanout.GetStats().draining, 1u);
+  EXPECT_TRUE(write_end_open());
+
+  // Read into the second chunk: still held, and bytes intact
+  std::vector<uint8_t> read_bytes(total);
+  const size_t part = first.size() + kPacket;
+  ASSERT_EQ(read(pipe_fds[0], read_bytes.data(), part), static_cast<ssize_t>(part));
+  const auto reap = Chunk(0, 1);  // Any publish reaps the drained subscribers
+  fanout.Publish(reap.data(), reap.size());
+  EXPECT_EQ(fanout.GetStats().draining, 1u);
+  EXPECT_TRUE(write_end_open());
+
+  // Read past the end: released, and the write end closed
+  ASSERT_EQ(read(pipe_fds[0], read_bytes.data() + part, total - part),
+            static_cast<ssize_t>(total - part));
+  fanout.Publish(reap.data(), reap.size());
+  EXPECT_EQ(fanout.GetStats().draining, 0u);
+  EXPECT_FALSE(write_end_open());
+  uint8_t byte;
+  EXPECT_EQ(read(pipe_fds[0], &byte, 1), 0);
+
+  std::vector<uint8_t> expected = first;
+  expected.insert(expected.end(), second.begin(), second.end());
+  EXPECT_EQ(read_bytes, expected);
+  close(pipe_fds[0]);
+}
+
+TEST(TsFanoutTest, ReleasesAPipeWhoseReaderHasClosed) {
+  TsFanout fanout(1, 64 * 1024, SlowClientPolicy::EVICT);
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+  ASSERT_TRUE(fanout.AddSubscriber(pipe_fds[1], "pipe", /*pipe=*/true));
+  const auto chunk = Chunk(0, 20, /*pat=*/true);
+  fanout.Publish(chunk.data(), chunk.size());
+  ASSERT_TRUE(WaitUntil([&] {
+    int unread = 0;
+    return ioctl(pipe_fds[0], FIONREAD, &unread) == 0 && unread > 0;
+  }));
+  fanout.CloseAll(nullptr, 0, 1000);
+  EXPECT_EQ(fanout.GetStats().draining, 1u);
+
+  close(pipe_fds[0]);
+  fanout.Publish(chunk.data(), chunk.size());
+  EXPECT_EQ(fanout.GetStats().draining, 0u);
+}
+
+TEST(TsFanoutTest, DropOldestResumesASlowReaderOnAKeyframe) {
+  constexpr size_t kChunkPackets = 10;
+  constexpr size_t kGopChunks = 6;
+  constexpr size_t kGops = 30;
+  TsFanout fanout(4, 10 * kChunkPackets * kPacket, SlowClientPolicy::DROP_OLDEST);
+  Client fast;
+  Client slow(/*slow=*/true);
+  ASSERT_TRUE(fanout.AddSubscriber(fast.fds[0], "fast"));
+  ASSERT_TRUE(fanout.AddSubscriber(slow.fds[0], "slow"));
+  fast.StartReading();
+
+  // GOPs of six chunks, each opening with PAT and a keyframe
+  uint32_t sequence = 0;
+  for (size_t gop = 0; gop < kGops; ++gop) {
+    for (size_t i = 0; i < kGopChunks; ++i) {
+      const auto chunk = Chunk(sequence, kChunkPackets, i == 0, i == 0);
+      sequence += kChunkPackets;
+      fanout.Publish(chunk.data(), chunk.size());
+      ASSERT_TRUE(fast.WaitFor(sequence * kPacket));
+    }
+  }
+  auto stats = fanout.GetStats();
+  EXPECT_EQ(stats.evictions, 0u);
+  EXPECT_GT(stats.gop_resyncs, 0u);
+  EXPECT_GT(stats.chunks_dropped, 0u);
+  EXPECT_EQ(fanout.SubscriberCount(), 2u);
+
+  slow.StartReading();
+  fanout.CloseAll(nullptr, 0, 2000);
+  const auto slow_bytes = slow.Finish();
+  const auto slow_sequences = Sequences(slow_bytes);
+  ASSERT_FALSE(slow_sequences.empty());
+  EXPECT_EQ(slow_sequences.front(), 0u);
+  EXPECT_EQ(slow_sequences.back(), sequence - 1);
+
+  // Every cut lands on a keyframe, never mid-GOP
+  size_t gaps = 0;
+  for (size_t i = 1; i < slow_sequences.size(); ++i) {
+    ASSERT_GT(slow_sequences[i], slow_sequences[i - 1]);
+    if (slow_sequences[i] != slow_sequences[i - 1] + 1) {
+      ++gaps;
+      EXPECT_TRUE(KeyframeStart(slow_bytes.data() + i * kPacket))
+          << "resumed at packet " << slow_sequences[i];
+    }
+  }
+  EXPECT_GT(gaps, 0u);
+  EXPECT_LE(gaps, stats.gop_resyncs);
+
+  const auto fast_sequences = Sequences(fast.Finish());
+  ASSERT_EQ(fast_sequences.size(), sequence);
+  for (size_t i = 0; i < fast_sequences.size(); ++i) {
+    ASSERT_EQ(fast_sequences[i], i);
+  }
+}
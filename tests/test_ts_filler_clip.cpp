@@ -0,0 +1,213 @@
+// Repository: Retrovue-playout
+// Component: TS Filler Clip Unit Tests
+// Purpose: Loops a muxed clip into a live stream and checks PTS, DTS, PCR and CC stay continuous.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsFillerClip.hpp"
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+#include "retrovue/playout_sinks/mpegts/TsPacketInspector.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::MuxerConfig;
+using retrovue::playout_sinks::mpegts::TsFillerClip;
+using retrovue::playout_sinks::mpegts::TSMuxer;
+using retrovue::playout_sinks::mpegts::TsPacketInspector;
+using retrovue::playout_sinks::mpegts::TsStream;
+
+namespace {
+
+constexpr size_t kPacket = 188;
+constexpr int64_t kFrame90k = 3000;  // 30 fps
+constexpr size_t kClipFrames = 10;
+
+int Collect(void* opaque, uint8_t* buf, int buf_size) {
+  auto* out = static_cast<std::vector<uint8_t>*>(opaque);
+  out->insert(out->end(), buf, buf + buf_size);
+  return buf_size;
+}
+
+std::vector<uint8_t> AccessUnit(size_t size, uint8_t nal_type, uint8_t fill) {
+  std::vector<uint8_t> au = {0x00, 0x00, 0x00, 0x01, nal_type};
+  au.resize(size, fill);
+  return au;
+}
+
+// Video frame n (an IDR at 0) and its audio, at n * kFrame90k
+bool MuxFrame(TSMuxer& muxer, int n, int64_t pts90k, uint8_t fill) {
+  const bool keyframe = n == 0;
+  const auto au = AccessUnit(keyframe ? 2500 : 300 + n * 40, keyframe ? 0x65 : 0x41, fill);
+  const std::vector<uint8_t> aac(150, fill);
+  return muxer.MuxFrame(TsStream::kVideo, au.data(), au.size(), pts90k, pts90k, keyframe) &&
+         muxer.MuxFrame(TsStream::kAudio, aac.data(), aac.size(), pts90k + kFrame90k / 2,
+                        pts90k + kFrame90k / 2, false);
+}
+
+MuxerConfig Config() {
+  MuxerConfig config;
+  config.enable_audio = true;
+  config.audio_specific_config = {0x11, 0x90};  // AAC-LC, 48 kHz, stereo
+  return config;
+}
+
+// The clip as EncoderPipeline encodes it: from PTS 0, on its own muxer
+TsFillerClip Clip() {
+  std::vector<uint8_t> ts;
+  TSMuxer muxer;
+  EXPECT_TRUE(muxer.Initialize(Config(), &ts, &Collect));
+  for (size_t n = 0; n < kClipFrames; ++n) {
+    EXPECT_TRUE(MuxFrame(muxer, static_cast<int>(n), static_cast<int64_t>(n) * kFrame90k, 0x33));
+  }
+  EXPECT_TRUE(muxer.Flush());
+  TsFillerClip clip;
+  EXPECT_TRUE(clip.Load(ts));
+  return clip;
+}
+
+int64_t ReadTimestamp(const uint8_t* p) {
+  return (static_cast<int64_t>(p[0] & 0x0E) << 29) | (static_cast<int64_t>(p[1]) << 22) |
+         (static_cast<int64_t>(p[2] & 0xFE) << 14) | (static_cast<int64_t>(p[3]) << 7) |
+         (p[4] >> 1);
+}
+
+struct Timeline {
+  std::vector<int64_t> video_pts;
+  std::vector<int64_t> video_dts;
+  std::vector<int64_t> audio_pts;
+  std::vector<int64_t> pcr;
+  size_t cc_errors = 0;
+};
+
+// PES times per stream, PCRs, and counters that do not follow on their PID
+Timeline Read(const std::vector<uint8_t>& ts, const MuxerConfig& config) {
+  Timeline timeline;
+  std::map<uint16_t, uint8_t> last_cc;
+  for (size_t offset = 0; offset + kPacket <= ts.size(); offset += kPacket) {
+    const uint8_t* p = ts.data() + offset;
+    EXPECT_EQ(p[0], 0x47);
+    const uint16_t pid = static_cast<uint16_t>(((p[1] & 0x1F) << 8) | p[2]);
+    const bool has_payload = (p[3] & 0x10) != 0;
+    const uint8_t cc = p[3] & 0x0F;
+    const auto last = last_cc.find(pid);
+    if (last != last_cc.end() && cc != (has_payload ? (last->second + 1) & 0x0F : last->second)) {
+      timeline.cc_errors++;
+    }
+    last_cc[pid] = cc;
+
+    size_t payload = 4;
+    if (p[3] & 0x20) {
+      if (p[4] > 0 && (p[5] & 0x10)) {
+        timeline.pcr.push_back((static_cast<int64_t>(p[6]) << 25) |
+                               (static_cast<int64_t>(p[7]) << 17) |
+                               (static_cast<int64_t>(p[8]) << 9) |
+                               (static_cast<int64_t>(p[9]) << 1) | (p[10] >> 7));
+      }
+      payload += 1 + p[4];
+    }
+    if (!(p[1] & 0x40) || !has_payload || payload + 19 > kPacket) {
+      continue;
+    }
+    const uint8_t* pes = p + payload;
+    if (pes[0] != 0 || pes[1] != 0 || pes[2] != 1 || !(pes[7] & 0x80)) {
+      continue;
+    }
+    const int64_t pts = ReadTimestamp(pes + 9);
+    if (pid == config.video_pid) {
+      timeline.video_pts.push_back(pts);
+      timeline.video_dts.push_back(pes[7] & 0x40 ? ReadTimestamp(pes + 14) : pts);
+    } else if (pid == config.audio_pid) {
+      timeline.audio_pts.push_back(pts);
+    }
+  }
+  return timeline;
+}
+
+void ExpectStep(const std::vector<int64_t>& times, int64_t step, const char* what) {
+  for (size_t i = 1; i < times.size(); ++i) {
+    EXPECT_EQ(times[i] - times[i - 1], step) << what << " " << i;
+  }
+}
+
+}  // namespace
+
+TEST(TsFillerClipTest, SplitsTheClipIntoFramesFromItsLeadingTables) {
+  const TsFillerClip clip = Clip();
+  ASSERT_EQ(clip.frame_count(), kClipFrames);
+  for (size_t i = 0; i < kClipFrames; ++i) {
+    EXPECT_EQ(clip.FrameOffset90k(i), static_cast<int64_t>(i) * kFrame90k) << i;
+  }
+  EXPECT_EQ(clip.FindFrame(4 * kFrame90k + 10, 0), 4u);
+  EXPECT_EQ(clip.FindFrame(5 * kFrame90k - 10, 20), 5u);
+  EXPECT_EQ(clip.FindFrame(9 * kFrame90k + 100, 90), kClipFrames);  // Past the end
+
+  // The first frame starts with PAT/PMT
+  std::vector<uint8_t> first;
+  clip.AppendFrame(0, 0, &first);
+  ASSERT_GE(first.size(), 3 * kPacket);
+  EXPECT_EQ(((first[1] & 0x1F) << 8) | first[2], 0);
+  EXPECT_EQ(((first[kPacket + 1] & 0x1F) << 8) | first[kPacket + 2], Config().pmt_pid);
+}
+
+TEST(TsFillerClipTest, RestampsTwoLoopsToContinueTheLiveStream) {
+  const MuxerConfig config = Config();
+  const TsFillerClip clip = Clip();
+  ASSERT_EQ(clip.frame_count(), kClipFrames);
+
+  // Five live frames, the clip twice through WriteMuxed() as the encoder
+  // pipeline splices filler, then live again
+  std::vector<uint8_t> out;
+  TSMuxer muxer;
+  ASSERT_TRUE(muxer.Initialize(config, &out, &Collect));
+  int frame = 0;
+  for (; frame < 5; ++frame) {
+    ASSERT_TRUE(MuxFrame(muxer, frame, frame * kFrame90k, 0x55));
+  }
+  std::vector<uint8_t> filler;
+  for (size_t loop = 0; loop < 2; ++loop) {
+    for (size_t i = 0; i < clip.frame_count(); ++i, ++frame) {
+      std::vector<uint8_t> buffer;
+      const int64_t pts90k = frame * kFrame90k;
+      EXPECT_EQ(clip.AppendFrame(i, pts90k, &buffer), pts90k);  // DTS, input timeline
+      filler.insert(filler.end(), buffer.begin(), buffer.end());
+      ASSERT_TRUE(muxer.WriteMuxed(buffer.data(), buffer.size()));
+    }
+  }
+  for (const int end = frame + 3; frame < end; ++frame) {
+    ASSERT_TRUE(MuxFrame(muxer, frame, frame * kFrame90k, 0x77));
+  }
+  ASSERT_TRUE(muxer.Flush());
+
+  // Video and audio step one frame at a time through both loop joins, at
+  // the muxer's delay; every PID's counter follows on
+  const Timeline timeline = Read(out, config);
+  ASSERT_EQ(timeline.video_pts.size(), static_cast<size_t>(frame));
+  const int64_t delay_90k = config.mux_delay_us * 9 / 100;
+  EXPECT_EQ(timeline.video_pts.front(), delay_90k);
+  ExpectStep(timeline.video_pts, kFrame90k, "video PTS");
+  ExpectStep(timeline.video_dts, kFrame90k, "video DTS");
+  ExpectStep(timeline.audio_pts, kFrame90k, "audio PTS");
+  EXPECT_EQ(timeline.cc_errors, 0u);
+
+  // PCRs climb through the joins and never fall further behind than the
+  // muxer's PCR interval plus a frame
+  ASSERT_GT(timeline.pcr.size(), 10u);
+  const int64_t max_gap_90k = config.pcr_interval_us * 9 / 100 + kFrame90k;
+  for (size_t i = 1; i < timeline.pcr.size(); ++i) {
+    EXPECT_GT(timeline.pcr[i], timeline.pcr[i - 1]) << "PCR " << i;
+    EXPECT_LE(timeline.pcr[i] - timeline.pcr[i - 1], max_gap_90k) << "PCR " << i;
+  }
+
+  // Without the native muxer the inspector repairs the counters instead:
+  // the two loops alone, restamped back to back, come out continuous
+  const Timeline raw = Read(filler, config);
+  EXPECT_GT(raw.cc_errors, 0u);  // The second loop restarts the clip's counters
+  TsPacketInspector inspector;
+  inspector.Process(filler.data(), filler.size());
+  const Timeline repaired = Read(filler, config);
+  EXPECT_EQ(repaired.cc_errors, 0u);
+  ExpectStep(repaired.video_pts, kFrame90k, "filler video PTS");
+  EXPECT_EQ(repaired.video_pts.front(), 5 * kFrame90k + delay_90k);
+}
@@ -0,0 +1,240 @@
+// Repository: Retrovue-playout
+// Component: TS HLS Segmenter Unit Tests
+// Purpose: Feeds hand-built TS to the segmenter: IDR cuts, the playlist window and PSI heads.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsHlsSegmenter.hpp"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::HlsSegmenterConfig;
+using retrovue::playout_sinks::mpegts::TsHlsSegmenter;
+using retrovue::telemetry::HttpRequest;
+using retrovue::telemetry::HttpResponse;
+
+namespace {
+
+constexpr size_t kPacket = TsHlsSegmenter::kPacketSize;
+constexpr uint16_t kPmtPid = 0x1000;
+constexpr uint16_t kVideoPid = 0x100;
+constexpr int64_t kFrame90k = 3000;  // 30 fps
+
+std::vector<uint8_t> Header(uint16_t pid, bool unit_start) {
+  std::vector<uint8_t> packet(kPacket, 0xFF);
+  packet[0] = 0x47;
+  packet[1] = static_cast<uint8_t>((unit_start ? 0x40 : 0x00) | (pid >> 8));
+  packet[2] = static_cast<uint8_t>(pid & 0xFF);
+  packet[3] = 0x10;  // Payload only, CC 0
+  return packet;
+}
+
+// PAT with one program on kPmtPid (the segmenter does not check CRCs)
+std::vector<uint8_t> Pat() {
+  std::vector<uint8_t> packet = Header(0, true);
+  const uint8_t section[] = {0x00, 0x00, 0xB0, 13,   0x00, 0x01, 0xC1, 0x00, 0x00,
+                             0x00, 0x01, 0xF0, 0x00, 0,    0,    0,    0};
+  std::copy(std::begin(section), std::end(section), packet.begin() + 4);
+  return packet;
+}
+
+// PMT with one H.264 stream on kVideoPid
+std::vector<uint8_t> Pmt() {
+  std::vector<uint8_t> packet = Header(kPmtPid, true);
+  const uint8_t section[] = {0x00, 0x02, 0xB0, 18,   0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x00,
+                             0xF0, 0x00, 0x1B, 0xE1, 0x00, 0xF0, 0x00, 0,    0,    0,    0};
+  std::copy(std::begin(section), std::end(section), packet.begin() + 4);
+  return packet;
+}
+
+// First packet of a video PES with a PTS; an IDR sets the random access indicator
+std::vector<uint8_t> Frame(int64_t pts, bool idr) {
+  std::vector<uint8_t> packet = Header(kVideoPid, true);
+  size_t offset = 4;
+  if (idr) {
+    packet[3] = 0x30;
+    packet[4] = 1;
+    packet[5] = 0x40;
+    offset = 6;
+  }
+  const uint8_t pes[] = {0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x80, 0x05,
+                         static_cast<uint8_t>(0x21 | ((pts >> 29) & 0x0E)),
+                         static_cast<uint8_t>(pts >> 22),
+                         static_cast<uint8_t>(((pts >> 14) & 0xFE) | 0x01),
+                         static_cast<uint8_t>(pts >> 7),
+                         static_cast<uint8_t>(((pts << 1) & 0xFE) | 0x01)};
+  std::copy(std::begin(pes), std::end(pes), packet.begin() + offset);
+  return packet;
+}
+
+// Writes video frames at 30 fps, one packet each, an IDR every idr_interval
+class Stream {
+ public:
+  Stream(TsHlsSegmenter& segmenter, int idr_interval)
+      : segmenter_(segmenter), idr_interval_(idr_interval) {}
+
+  void Psi() {
+    Write(Pat());
+    Write(Pmt());
+  }
+
+  void Frames(int count) {
+    for (int i = 0; i < count; ++i, ++frame_) {
+      Write(Frame(90000 + frame_ * kFrame90k, frame_ % idr_interval_ == 0));
+    }
+  }
+
+  void Write(const std::vector<uint8_t>& packet) {
+    segmenter_.Write(packet.data(), packet.size());
+  }
+
+ private:
+  TsHlsSegmenter& segmenter_;
+  const int idr_interval_;
+  int64_t frame_ = 0;
+};
+
+HlsSegmenterConfig Config(int64_t segment_ms, size_t window_segments = 6) {
+  HlsSegmenterConfig config;
+  config.segment_ms = segment_ms;
+  config.part_ms = 0;
+  config.window_segments = window_segments;
+  return config;
+}
+
+// The body served for name, or empty if the segmenter does not serve it
+std::string Get(TsHlsSegmenter& segmenter, const std::string& name) {
+  HttpRequest request;
+  request.path = "/hls/" + name;
+  HttpResponse response;
+  if (!segmenter.HandleRequest(request, response) || response.status != 200 || !response.body) {
+    return {};
+  }
+  return *response.body;
+}
+
+uint16_t PidAt(const std::string& ts, size_t index) {
+  const auto* packet = reinterpret_cast<const uint8_t*>(ts.data()) + index * kPacket;
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+bool IdrAt(const std::string& ts, size_t index) {
+  const auto* packet = reinterpret_cast<const uint8_t*>(ts.data()) + index * kPacket;
+  return PidAt(ts, index) == kVideoPid && (packet[3] & 0x20) != 0 && packet[4] > 0 &&
+         (packet[5] & 0x40) != 0;
+}
+
+}  // namespace
+
+TEST(TsHlsSegmenterTest, CutsOnlyAtAnIdrAfterTheTargetDuration) {
+  // 1 s segments over a 20-frame GOP: the IDR at 0.67 s is too early and the
+  // plain frame at 1 s is no IDR, so each segment runs to the IDR at 1.33 s
+  TsHlsSegmenter segmenter(Config(1000));
+  Stream stream(segmenter, 20);
+  stream.Psi();
+  stream.Frames(20 * 7);
+
+  const auto stats = segmenter.GetStats();
+  EXPECT_EQ(stats.segments, 3u);  // Cut at frames 40, 80 and 120
+  const std::string playlist = Get(segmenter, "index.m3u8");
+  EXPECT_NE(playlist.find("#EXT-X-TARGETDURATION:2\n"), std::string::npos) << playlist;
+  EXPECT_NE(playlist.find("#EXTINF:1.33333,\nseg0.ts\n#EXTINF:1.33333,\nseg1.ts\n"
+                          "#EXTINF:1.33333,\nseg2.ts\n"),
+            std::string::npos)
+      << playlist;
+  EXPECT_EQ(playlist.find("seg3.ts"), std::string::npos);  // Still being cut
+
+  // Each segment holds its 40 frames behind PAT/PMT
+  for (const char* name : {"seg0.ts", "seg1.ts", "seg2.ts"}) {
+    const std::string segment = Get(segmenter, name);
+    ASSERT_EQ(segment.size(), (2 + 40) * kPacket) << name;
+    EXPECT_TRUE(IdrAt(segment, 2)) << name;
+  }
+  EXPECT_TRUE(Get(segmenter, "seg3.ts").empty());
+}
+
+TEST(TsHlsSegmenterTest, StartsAtTheFirstIdr) {
+  // Frames ahead of the first IDR (and ahead of PSI) are dropped
+  TsHlsSegmenter segmenter(Config(1000));
+  Stream stream(segmenter, 30);
+  stream.Write(Frame(0, true));  // No PAT/PMT yet
+  stream.Psi();
+  stream.Write(Frame(3000, false));
+  stream.Write(Frame(6000, false));
+  stream.Frames(30 * 2);
+
+  EXPECT_EQ(segmenter.GetStats().segments, 1u);
+  const std::string segment = Get(segmenter, "seg0.ts");
+  ASSERT_EQ(segment.size(), (2 + 30) * kPacket);
+  EXPECT_EQ(PidAt(segment, 0), 0);
+  EXPECT_EQ(PidAt(segment, 1), kPmtPid);
+  EXPECT_TRUE(IdrAt(segment, 2));
+}
+
+TEST(TsHlsSegmenterTest, SlidesTheWindowAndAdvancesTheMediaSequence) {
+  TsHlsSegmenter segmenter(Config(1000, 3));
+  Stream stream(segmenter, 30);
+  stream.Psi();
+  stream.Frames(30 * 6 + 1);  // Six segments and the IDR that closes the last
+
+  const auto stats = segmenter.GetStats();
+  EXPECT_EQ(stats.segments, 6u);
+  EXPECT_EQ(stats.media_sequence, 3u);
+  const std::string playlist = Get(segmenter, "index.m3u8");
+  EXPECT_NE(playlist.find("#EXT-X-VERSION:3\n"), std::string::npos) << playlist;
+  EXPECT_NE(playlist.find("#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:3\n"
+                          "#EXTINF:1.00000,\nseg3.ts\n#EXTINF:1.00000,\nseg4.ts\n"
+                          "#EXTINF:1.00000,\nseg5.ts\n"),
+            std::string::npos)
+      << playlist;
+  EXPECT_EQ(playlist.find("seg2.ts"), std::string::npos);
+  EXPECT_EQ(playlist.find("seg6.ts"), std::string::npos);
+  EXPECT_EQ(playlist.find("#EXT-X-PART"), std::string::npos);  // Plain HLS
+
+  // Segments that left the window are gone, and so are their bytes
+  EXPECT_TRUE(Get(segmenter, "seg2.ts").empty());
+  size_t listed_bytes = 0;
+  for (const char* name : {"seg3.ts", "seg4.ts", "seg5.ts"}) {
+    const std::string segment = Get(segmenter, name);
+    EXPECT_EQ(segment.size(), (2 + 30) * kPacket) << name;
+    listed_bytes += segment.size();
+  }
+  EXPECT_EQ(segmenter.GetStats().stored_bytes, listed_bytes);
+}
+
+TEST(TsHlsSegmenterTest, StartsEverySegmentWithPatAndPmt) {
+  TsHlsSegmenter segmenter(Config(1000));
+  Stream stream(segmenter, 30);
+
+  // PSI only once: later segments open with the stored PAT/PMT
+  stream.Psi();
+  stream.Frames(30 * 2);
+
+  // PSI just ahead of an IDR opens that segment, once
+  stream.Psi();
+  stream.Frames(30);
+
+  // PSI between frames stays where the muxer put it
+  stream.Frames(10);
+  stream.Psi();
+  stream.Frames(21);
+
+  ASSERT_EQ(segmenter.GetStats().segments, 4u);
+  for (const char* name : {"seg0.ts", "seg1.ts", "seg2.ts", "seg3.ts"}) {
+    const std::string segment = Get(segmenter, name);
+    ASSERT_GE(segment.size(), 3 * kPacket) << name;
+    EXPECT_EQ(PidAt(segment, 0), 0) << name;
+    EXPECT_EQ(PidAt(segment, 1), kPmtPid) << name;
+    EXPECT_TRUE(IdrAt(segment, 2)) << name;
+    EXPECT_NE(PidAt(segment, 3), 0) << name;
+  }
+  const std::string segment = Get(segmenter, "seg3.ts");
+  ASSERT_EQ(segment.size(), (2 + 30 + 2) * kPacket);
+  EXPECT_EQ(PidAt(segment, 2 + 10), 0);
+  EXPECT_EQ(PidAt(segment, 2 + 11), kPmtPid);
+  EXPECT_EQ(Get(segmenter, "seg2.ts").size(), (2 + 30) * kPacket);
+}
@@ -0,0 +1,371 @@
+// Repository: Retrovue-playout
+// Component: TS MPTS Multiplexer Unit Tests
+// Purpose: Tests the statmux bitrate allocation and the combined stream's PAT, PCR and CC.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsMptsMux.hpp"
+#include "timing/TestMasterClock.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::MptsConfig;
+using retrovue::playout_sinks::mpegts::MptsPidsForProgram;
+using retrovue::playout_sinks::mpegts::MptsProgramConfig;
+using retrovue::playout_sinks::mpegts::TsMptsMux;
+using retrovue::timing::TestMasterClock;
+
+namespace {
+
+constexpr size_t kPacket = 188;
+constexpr int64_t kStartUs = 1'000'000'000;
+constexpr int64_t kPatRateBps = kPacket * 8 * 10;  // One PAT every kPatIntervalUs
+
+std::shared_ptr<TestMasterClock> Clock() {
+  return std::make_shared<TestMasterClock>(kStartUs, TestMasterClock::Mode::Deterministic);
+}
+
+MptsProgramConfig Program(uint16_t number, int64_t min_bps, int64_t max_bps,
+                          int64_t overhead_bps) {
+  MptsProgramConfig program;
+  program.program_number = number;
+  program.min_video_bps = min_bps;
+  program.max_video_bps = max_bps;
+  program.overhead_bps = overhead_bps;
+  return program;
+}
+
+// Every rate each program was told, by program number
+class Rates {
+ public:
+  TsMptsMux::BitrateCallback For(uint16_t program) {
+    return [this, program](int64_t bps) { told_[program].push_back(bps); };
+  }
+
+  std::vector<int64_t> Told(uint16_t program) { return told_[program]; }
+
+ private:
+  std::map<uint16_t, std::vector<int64_t>> told_;
+};
+
+std::vector<int64_t> Allocations(const TsMptsMux& mux) {
+  std::vector<int64_t> allocations;
+  for (const auto& program : mux.GetStats().programs) {
+    allocations.push_back(program.video_bps);
+  }
+  return allocations;
+}
+
+std::vector<uint8_t> Packet(uint16_t pid, uint8_t cc, int64_t pcr_27m = -1) {
+  std::vector<uint8_t> packet(kPacket, 0xAA);
+  packet[0] = 0x47;
+  packet[1] = static_cast<uint8_t>(pid >> 8);
+  packet[2] = static_cast<uint8_t>(pid);
+  packet[3] = static_cast<uint8_t>(0x10 | (cc & 0x0F));
+  if (pcr_27m >= 0) {
+    const int64_t base = pcr_27m / 300;
+    const int64_t extension = pcr_27m % 300;
+    packet[3] |= 0x20;
+    packet[4] = 7;
+    packet[5] = 0x10;
+    packet[6] = static_cast<uint8_t>(base >> 25);
+    packet[7] = static_cast<uint8_t>(base >> 17);
+    packet[8] = static_cast<uint8_t>(base >> 9);
+    packet[9] = static_cast<uint8_t>(base >> 1);
+    packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E | (extension >> 8));
+    packet[11] = static_cast<uint8_t>(extension);
+  }
+  return packet;
+}
+
+uint16_t Pid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+int64_t Pcr27m(const uint8_t* packet) {
+  const int64_t base = (static_cast<int64_t>(packet[6]) << 25) |
+                       (static_cast<int64_t>(packet[7]) << 17) |
+                       (static_cast<int64_t>(packet[8]) << 9) |
+                       (static_cast<int64_t>(packet[9]) << 1) | (packet[10] >> 7);
+  return base * 300 + (((packet[10] & 0x01) << 8) | packet[11]);
+}
+
+bool HasPcr(const uint8_t* packet) {
+  return (packet[3] & 0x20) && packet[4] > 0 && (packet[5] & 0x10);
+}
+
+// A loopback UDP socket the MPTS is sent to
+class Receiver {
+ public:
+  Receiver() {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t length = sizeof(addr);
+    getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+    timeval timeout{0, 20'000};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  ~Receiver() { close(fd_); }
+
+  int port() const { return port_; }
+
+  // Reads datagrams until packets have arrived, or for 20 ms
+  size_t ReadUntil(size_t packets) {
+    uint8_t datagram[7 * kPacket];
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    while (bytes_.size() / kPacket < packets && std::chrono::steady_clock::now() < deadline) {
+      const ssize_t n = recv(fd_, datagram, sizeof(datagram), 0);
+      if (n > 0) {
+        bytes_.insert(bytes_.end(), datagram, datagram + n);
+      }
+    }
+    return bytes_.size() / kPacket;
+  }
+
+  const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+ private:
+  int fd_ = -1;
+  int port_ = 0;
+  std::vector<uint8_t> bytes_;
+};
+
+}  // namespace
+
+TEST(TsMptsMuxTest, SharesTheVideoBudgetByGopComplexity) {
+  MptsConfig config;
+  config.total_rate_bps = 10'000'000;
+  TsMptsMux mux(config, Clock());
+  Rates rates;
+  ASSERT_TRUE(mux.AddProgram(Program(1, 1'000'000, 6'000'000, 200'000), rates.For(1)));
+  ASSERT_TRUE(mux.AddProgram(Program(3, 1'000'000, 6'000'000, 200'000), rates.For(3)));
+  ASSERT_TRUE(mux.AddProgram(Program(2, 1'000'000, 6'000'000, 200'000), rates.For(2)));
+
+  // The total less 5% for headers, the PAT and each program's audio and PSI
+  const int64_t budget = 10'000'000 * 95 / 100 - kPatRateBps - 3 * 200'000;
+  EXPECT_EQ(mux.GetStats().video_budget_bps, budget);
+
+  // Before any report every program weighs the same
+  const int64_t even = 1'000'000 + (budget - 3'000'000) / 3;
+  EXPECT_EQ(Allocations(mux), (std::vector<int64_t>{even, even, even}));
+  EXPECT_EQ(rates.Told(1).back(), even);
+
+  // One GOP each, complexities 1:2:5: the floors, and the rest in proportion
+  mux.ReportComplexity(1, 1e6);
+  mux.ReportComplexity(2, 2e6);
+  mux.ReportComplexity(3, 5e6);
+  const int64_t rest = budget - 3'000'000;
+  const std::vector<int64_t> expected = {1'000'000 + rest * 1 / 8, 1'000'000 + rest * 2 / 8,
+                                         1'000'000 + rest * 5 / 8};
+  const auto allocations = Allocations(mux);
+  int64_t total = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(allocations[i], expected[i], 1) << "program " << i + 1;
+    total += allocations[i];
+  }
+  EXPECT_LE(total, budget);
+  EXPECT_GE(total, budget - 3);
+  EXPECT_EQ(rates.Told(3).back(), allocations[2]);
+
+  // Smoothed: program 1's next GOP at 3e6 counts as 2e6, so 1 and 2 even out
+  mux.ReportComplexity(1, 3e6);
+  const auto stats = mux.GetStats();
+  EXPECT_DOUBLE_EQ(stats.programs[0].complexity, 2e6);
+  EXPECT_EQ(stats.programs[0].gops, 2u);
+  EXPECT_EQ(stats.allocations, 4u);
+  EXPECT_NEAR(stats.programs[0].video_bps, stats.programs[1].video_bps, 1);
+  EXPECT_NEAR(stats.programs[0].video_bps, 1'000'000 + rest * 2 / 9, 1);
+}
+
+TEST(TsMptsMuxTest, CapsAProgramAndSharesTheExcess) {
+  MptsConfig config;
+  config.total_rate_bps = 10'000'000;
+  TsMptsMux mux(config, Clock());
+  ASSERT_TRUE(mux.AddProgram(Program(1, 1'000'000, 3'000'000, 200'000), nullptr));
+  ASSERT_TRUE(mux.AddProgram(Program(2, 1'000'000, 8'000'000, 200'000), nullptr));
+  ASSERT_TRUE(mux.AddProgram(Program(3, 1'000'000, 8'000'000, 200'000), nullptr));
+  const int64_t budget = mux.GetStats().video_budget_bps;
+
+  // Program 1 is far the most complex but stops at its ceiling; programs 2
+  // and 3 share what it leaves by their own complexity
+  mux.ReportComplexity(1, 50e6);
+  mux.ReportComplexity(2, 1e6);
+  mux.ReportComplexity(3, 3e6);
+  const auto allocations = Allocations(mux);
+  EXPECT_EQ(allocations[0], 3'000'000);
+  const int64_t rest = budget - 3'000'000 - 2'000'000;
+  EXPECT_NEAR(allocations[1], 1'000'000 + rest / 4, 1);
+  EXPECT_NEAR(allocations[2], 1'000'000 + rest * 3 / 4, 1);
+  EXPECT_LE(allocations[0] + allocations[1] + allocations[2], budget);
+}
+
+TEST(TsMptsMuxTest, TellsAProgramOnlyOfChangesOverMinChange) {
+  MptsConfig config;
+  config.total_rate_bps = 10'000'000;
+  TsMptsMux mux(config, Clock());
+  Rates rates;
+  ASSERT_TRUE(mux.AddProgram(Program(1, 1'000'000, 8'000'000, 200'000), rates.For(1)));
+  ASSERT_TRUE(mux.AddProgram(Program(2, 1'000'000, 8'000'000, 200'000), rates.For(2)));
+  mux.ReportComplexity(1, 1e6);
+  mux.ReportComplexity(2, 1e6);
+  const auto told_1 = rates.Told(1).size();
+  const auto told_2 = rates.Told(2).size();
+
+  // A GOP 2% more complex (1% once smoothed) moves the rates by less than
+  // kMinChangePercent: nobody is told
+  mux.ReportComplexity(1, 1.02e6);
+  EXPECT_EQ(rates.Told(1).size(), told_1);
+  EXPECT_EQ(rates.Told(2).size(), told_2);
+
+  // Twice as complex is worth a reconfigure for both
+  mux.ReportComplexity(1, 4e6);
+  EXPECT_EQ(rates.Told(1).size(), told_1 + 1);
+  EXPECT_EQ(rates.Told(2).size(), told_2 + 1);
+  EXPECT_GT(rates.Told(1).back(), rates.Told(2).back());
+}
+
+TEST(TsMptsMuxTest, RefusesProgramsThatDoNotFit) {
+  MptsConfig config;
+  config.total_rate_bps = 4'000'000;
+  TsMptsMux mux(config, Clock());
+  ASSERT_TRUE(mux.AddProgram(Program(1, 1'500'000, 3'000'000, 200'000), nullptr));
+  EXPECT_FALSE(mux.AddProgram(Program(1, 100'000, 200'000, 0), nullptr));    // Taken
+  EXPECT_FALSE(mux.AddProgram(Program(0, 100'000, 200'000, 0), nullptr));    // Out of range
+  EXPECT_FALSE(mux.AddProgram(Program(2, 300'000, 200'000, 0), nullptr));    // Ceiling < floor
+  EXPECT_FALSE(mux.AddProgram(Program(2, 2'000'000, 3'000'000, 200'000), nullptr));
+  EXPECT_TRUE(mux.AddProgram(Program(2, 1'500'000, 3'000'000, 200'000), nullptr));
+  EXPECT_EQ(mux.GetStats().programs.size(), 2u);
+}
+
+TEST(TsMptsMuxTest, KeepsEachProgramsPcrAndContinuityAcrossTheSharedStream) {
+  // One packet per millisecond
+  constexpr int64_t kSlotUs = 1000;
+  constexpr size_t kBurst = 7;
+  Receiver receiver;
+  MptsConfig config;
+  config.total_rate_bps = 1000 * kPacket * 8;
+  config.burst_packets = kBurst;
+  config.transport_stream_id = 0x0042;
+  config.udp.host = "127.0.0.1";
+  config.udp.port = receiver.port();
+  auto clock = Clock();
+  TsMptsMux mux(config, clock);
+  ASSERT_TRUE(mux.AddProgram(Program(1, 100'000, 600'000, 50'000), nullptr));
+  ASSERT_TRUE(mux.AddProgram(Program(2, 100'000, 600'000, 50'000), nullptr));
+  ASSERT_TRUE(mux.Start());
+
+  // Each channel muxes its own program: its own PAT, its PMT, and video
+  // (with PCRs on clocks far apart) and audio, each PID counting from 0
+  std::map<uint16_t, uint8_t> next_cc;
+  const int64_t origin_27m[] = {0, int64_t{5'000'000} * 27, int64_t{90'000'000} * 27};
+  size_t pushed = 0;
+  for (int round = 0; round < 8; ++round) {
+    for (uint16_t number = 1; number <= 2; ++number) {
+      const auto pids = MptsPidsForProgram(number);
+      std::vector<uint8_t> muxed;
+      auto add = [&](uint16_t pid, int64_t pcr_27m) {
+        const auto packet = Packet(pid, next_cc[pid]++, pcr_27m);
+        muxed.insert(muxed.end(), packet.begin(), packet.end());
+      };
+      add(0, -1);  // The channel's own PAT, replaced by the MPTS's
+      add(pids.pmt_pid, -1);
+      add(pids.video_pid, origin_27m[number] + int64_t{round} * 12 * kSlotUs * 27);
+      add(pids.video_pid, -1);
+      add(pids.video_pid, -1);
+      add(pids.audio_pid, -1);
+      // Program 2's output arrives split mid-packet
+      const size_t split = number == 2 ? 100 : muxed.size();
+      mux.Push(number, muxed.data(), split);
+      mux.Push(number, muxed.data() + split, muxed.size() - split);
+      pushed += 5;
+    }
+  }
+
+  // Paced out on the test clock: the MPTS's PAT, the programs, then stuffing
+  const size_t expected = 1 + pushed + kBurst;
+  for (int i = 0; i < 1000 && receiver.ReadUntil(expected) < expected; ++i) {
+    clock->AdvanceMicroseconds(kBurst * kSlotUs);
+  }
+  mux.RemoveProgram(2);
+  for (int i = 0; i < 100 && receiver.ReadUntil(expected + kBurst) < expected + kBurst; ++i) {
+    clock->AdvanceMicroseconds(kBurst * kSlotUs);
+  }
+  mux.Stop();
+  ASSERT_GE(receiver.bytes().size() / kPacket, expected);
+
+  const std::vector<uint8_t>& stream = receiver.bytes();
+  std::map<uint16_t, int> last_cc;
+  std::map<uint16_t, std::pair<size_t, int64_t>> first_pcr;  // Slot, PCR
+  std::vector<std::vector<uint16_t>> pats;
+  size_t pcrs = 0;
+  for (size_t slot = 0; slot < stream.size() / kPacket; ++slot) {
+    const uint8_t* packet = stream.data() + slot * kPacket;
+    ASSERT_EQ(packet[0], 0x47) << "slot " << slot;
+    const uint16_t pid = Pid(packet);
+    if (pid == 0x1FFF) {
+      continue;
+    }
+    // One continuity counter per PID, the MPTS's PAT included, with no gap
+    // where the channels' PATs were dropped
+    const int cc = packet[3] & 0x0F;
+    if (last_cc.count(pid)) {
+      EXPECT_EQ(cc, (last_cc[pid] + 1) & 0x0F) << "PID " << pid << " slot " << slot;
+    }
+    last_cc[pid] = cc;
+    if (pid == 0) {
+      const uint8_t* section = packet + 5;
+      EXPECT_EQ((section[3] << 8) | section[4], 0x0042);  // Never a channel's PAT
+      std::vector<uint16_t> programs;
+      const size_t entries = (((section[1] & 0x0F) << 8 | section[2]) - 9) / 4;
+      for (size_t i = 0; i < entries; ++i) {
+        const uint8_t* entry = section + 8 + 4 * i;
+        programs.push_back(static_cast<uint16_t>(entry[0] << 8 | entry[1]));
+        EXPECT_EQ(((entry[2] & 0x1F) << 8) | entry[3],
+                  MptsPidsForProgram(programs.back()).pmt_pid);
+      }
+      pats.push_back(programs);
+    }
+    // Each program's PCRs restamped on its own line, advancing with the
+    // shared send schedule
+    if (HasPcr(packet)) {
+      ++pcrs;
+      EXPECT_EQ(packet[5] & 0x80, 0) << "slot " << slot;  // No discontinuity
+      if (!first_pcr.count(pid)) {
+        first_pcr[pid] = {slot, Pcr27m(packet)};
+      } else {
+        const auto [first_slot, first_27m] = first_pcr[pid];
+        EXPECT_EQ(Pcr27m(packet) - first_27m,
+                  static_cast<int64_t>(slot - first_slot) * kSlotUs * 27)
+            << "PID " << pid << " slot " << slot;
+      }
+    }
+  }
+  EXPECT_EQ(pcrs, 16u);
+  EXPECT_EQ(first_pcr.size(), 2u);
+  ASSERT_EQ(pats.size(), 2u);
+  EXPECT_EQ(pats[0], (std::vector<uint16_t>{1, 2}));
+  EXPECT_EQ(pats[1], (std::vector<uint16_t>{1}));  // At once when a program leaves
+  for (uint16_t number = 1; number <= 2; ++number) {
+    EXPECT_EQ(last_cc[MptsPidsForProgram(number).video_pid], (3 * 8 - 1) & 0x0F);
+  }
+
+  const auto stats = mux.GetStats();
+  EXPECT_EQ(stats.pat_packets, 2u);
+  EXPECT_EQ(stats.pacer.pcr_restamps, 16u);
+  EXPECT_EQ(stats.pacer.pcr_discontinuities, 0u);
+}
@@ -0,0 +1,392 @@
+// Repository: Retrovue-playout
+// Component: MPEG-TS Muxer Unit Tests
+// Purpose: Parses the native muxer's output: framing, continuity, PSI CRCs, PCR and PES.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace retrovue::playout_sinks::mpegts;
+
+namespace {
+
+constexpr size_t kPacket = TSMuxer::kPacketSize;
+
+int Collect(void* opaque, uint8_t* buf, int buf_size) {
+  auto* out = static_cast<std::vector<uint8_t>*>(opaque);
+  out->insert(out->end(), buf, buf + buf_size);
+  return buf_size;
+}
+
+struct TsPacket {
+  uint16_t pid = 0;
+  bool unit_start = false;
+  bool has_payload = false;
+  uint8_t cc = 0;
+  bool random_access = false;
+  bool has_pcr = false;
+  int64_t pcr = 0;
+  std::vector<uint8_t> payload;
+};
+
+std::vector<TsPacket> Parse(const std::vector<uint8_t>& ts) {
+  EXPECT_EQ(ts.size() % kPacket, 0u);
+  std::vector<TsPacket> packets;
+  for (size_t offset = 0; offset + kPacket <= ts.size(); offset += kPacket) {
+    const uint8_t* p = ts.data() + offset;
+    EXPECT_EQ(p[0], 0x47) << "sync byte at " << offset;
+    TsPacket packet;
+    packet.pid = static_cast<uint16_t>(((p[1] & 0x1F) << 8) | p[2]);
+    packet.unit_start = (p[1] & 0x40) != 0;
+    const uint8_t afc = (p[3] >> 4) & 0x03;
+    packet.has_payload = (afc & 0x01) != 0;
+    packet.cc = p[3] & 0x0F;
+    size_t payload_start = 4;
+    if (afc & 0x02) {
+      const size_t af_length = p[4];
+      EXPECT_LE(af_length, 183u);
+      if (af_length > 0) {
+        packet.random_access = (p[5] & 0x40) != 0;
+        packet.has_pcr = (p[5] & 0x10) != 0;
+        if (packet.has_pcr) {
+          packet.pcr = (static_cast<int64_t>(p[6]) << 25) | (static_cast<int64_t>(p[7]) << 17) |
+                       (static_cast<int64_t>(p[8]) << 9) | (static_cast<int64_t>(p[9]) << 1) |
+                       (p[10] >> 7);
+        }
+      }
+      payload_start = 5 + af_length;
+    }
+    if (packet.has_payload) {
+      packet.payload.assign(p + payload_start, p + kPacket);
+    }
+    packets.push_back(std::move(packet));
+  }
+  return packets;
+}
+
+// Every PID's counter advances by one per packet with payload and stays put
+// on adaptation-only packets
+void ExpectContinuity(const std::vector<TsPacket>& packets) {
+  std::map<uint16_t, uint8_t> last;
+  for (size_t i = 0; i < packets.size(); ++i) {
+    const TsPacket& packet = packets[i];
+    const auto it = last.find(packet.pid);
+    if (it != last.end()) {
+      const uint8_t expected = packet.has_payload ? (it->second + 1) & 0x0F : it->second;
+      EXPECT_EQ(packet.cc, expected) << "PID 0x" << std::hex << packet.pid << std::dec
+                                     << " packet " << i;
+    }
+    last[packet.pid] = packet.cc;
+  }
+}
+
+// PSI section behind the pointer field, CRC checked
+std::vector<uint8_t> Section(const TsPacket& packet) {
+  EXPECT_TRUE(packet.unit_start);
+  EXPECT_EQ(packet.payload.at(0), 0x00);  // pointer_field
+  const size_t length = ((packet.payload[2] & 0x0F) << 8) | packet.payload[3];
+  std::vector<uint8_t> section(packet.payload.begin() + 1,
+                               packet.payload.begin() + 1 + 3 + length);
+  const size_t body = section.size() - 4;
+  const uint32_t stored = (static_cast<uint32_t>(section[body]) << 24) |
+                          (static_cast<uint32_t>(section[body + 1]) << 16) |
+                          (static_cast<uint32_t>(section[body + 2]) << 8) | section[body + 3];
+  EXPECT_EQ(Crc32Mpeg(section.data(), body), stored);
+  EXPECT_EQ(Crc32Mpeg(section.data(), section.size()), 0u);  // A valid section's residue
+  return section;
+}
+
+int64_t ReadTimestamp(const uint8_t* p) {
+  return (static_cast<int64_t>(p[0] & 0x0E) << 29) | (static_cast<int64_t>(p[1]) << 22) |
+         (static_cast<int64_t>(p[2] & 0xFE) << 14) | (static_cast<int64_t>(p[3]) << 7) |
+         (p[4] >> 1);
+}
+
+struct Pes {
+  uint8_t stream_id = 0;
+  int64_t pts = -1;
+  int64_t dts = -1;
+  std::vector<uint8_t> data;  // After the PES header
+};
+
+// Reassembles the PES packets of pid
+std::vector<Pes> Reassemble(const std::vector<TsPacket>& packets, uint16_t pid) {
+  std::vector<std::vector<uint8_t>> raw;
+  for (const TsPacket& packet : packets) {
+    if (packet.pid != pid || !packet.has_payload) {
+      continue;
+    }
+    if (packet.unit_start) {
+      raw.emplace_back();
+    }
+    if (!raw.empty()) {
+      raw.back().insert(raw.back().end(), packet.payload.begin(), packet.payload.end());
+    }
+  }
+  std::vector<Pes> out;
+  for (const auto& bytes : raw) {
+    Pes pes;
+    EXPECT_GE(bytes.size(), 14u);
+    EXPECT_EQ(bytes[0], 0x00);
+    EXPECT_EQ(bytes[1], 0x00);
+    EXPECT_EQ(bytes[2], 0x01);
+    pes.stream_id = bytes[3];
+    const uint8_t flags = bytes[7];
+    const size_t header_length = bytes[8];
+    if (flags & 0x80) {
+      pes.pts = ReadTimestamp(bytes.data() + 9);
+    }
+    if (flags & 0x40) {
+      pes.dts = ReadTimestamp(bytes.data() + 14);
+    }
+    const size_t length = (static_cast<size_t>(bytes[4]) << 8) | bytes[5];
+    const auto begin = bytes.begin() + 9 + header_length;
+    const auto end = length > 0 ? bytes.begin() + 6 + length : bytes.end();
+    pes.data.assign(begin, end);
+    out.push_back(std::move(pes));
+  }
+  return out;
+}
+
+std::vector<uint8_t> AccessUnit(size_t size, uint8_t nal_type, uint8_t fill) {
+  std::vector<uint8_t> au = {0x00, 0x00, 0x00, 0x01, nal_type};
+  au.resize(size, fill);
+  return au;
+}
+
+class TSMuxerTest : public ::testing::Test {
+ protected:
+  void Init(bool audio) {
+    config_.enable_audio = audio;
+    config_.audio_specific_config = {0x11, 0x90};  // AAC-LC, 48 kHz, stereo
+    ASSERT_TRUE(muxer_.Initialize(config_, &out_, &Collect));
+  }
+
+  MuxerConfig config_;
+  TSMuxer muxer_;
+  std::vector<uint8_t> out_;
+};
+
+}  // namespace
+
+TEST(TsCrcTest, MatchesTheMpeg2CheckValue) {
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  EXPECT_EQ(Crc32Mpeg(check, sizeof(check)), 0x0376E6E7u);
+}
+
+TEST_F(TSMuxerTest, WritesTablesWithValidCrcs) {
+  Init(/*audio=*/true);
+  const auto idr = AccessUnit(600, 0x65, 0xAB);
+  ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, idr.data(), idr.size(), 0, 0, true));
+  ASSERT_TRUE(muxer_.Flush());
+
+  const auto packets = Parse(out_);
+  ASSERT_GE(packets.size(), 3u);
+  ASSERT_EQ(packets[0].pid, 0);
+  ASSERT_EQ(packets[1].pid, config_.pmt_pid);
+
+  const auto pat = Section(packets[0]);
+  EXPECT_EQ(pat[0], 0x00);  // table_id
+  EXPECT_EQ((pat[3] << 8) | pat[4], config_.transport_stream_id);
+  EXPECT_EQ((pat[8] << 8) | pat[9], config_.program_number);
+  EXPECT_EQ(((pat[10] & 0x1F) << 8) | pat[11], config_.pmt_pid);
+
+  const auto pmt = Section(packets[1]);
+  EXPECT_EQ(pmt[0], 0x02);
+  EXPECT_EQ(((pmt[8] & 0x1F) << 8) | pmt[9], config_.video_pid);  // PCR PID
+  EXPECT_EQ(pmt[12], kTsStreamTypeH264);
+  EXPECT_EQ(((pmt[13] & 0x1F) << 8) | pmt[14], config_.video_pid);
+  EXPECT_EQ(pmt[17], kTsStreamTypeAac);
+  EXPECT_EQ(((pmt[18] & 0x1F) << 8) | pmt[19], config_.audio_pid);
+
+  // The keyframe's first packet: random access and the first PCR
+  EXPECT_EQ(packets[2].pid, config_.video_pid);
+  EXPECT_TRUE(packets[2].unit_start);
+  EXPECT_TRUE(packets[2].random_access);
+  EXPECT_TRUE(packets[2].has_pcr);
+  EXPECT_EQ(packets[2].pcr, 0);
+}
+
+TEST_F(TSMuxerTest, KeepsContinuityAndPcrCadenceOverAStream) {
+  Init(/*audio=*/true);
+  // 100 fps video interleaved with audio halfway between: an access unit
+  // every 5 ms, each PID's counter wrapping many times
+  for (int i = 0; i < 300; ++i) {
+    const int64_t video_90k = i * 900;
+    const bool keyframe = i % 50 == 0;
+    const auto au = AccessUnit(keyframe ? 4000 : 300 + (i * 37) % 900, keyframe ? 0x65 : 0x41,
+                               static_cast<uint8_t>(i));
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, au.data(), au.size(), video_90k, video_90k,
+                                keyframe));
+    const std::vector<uint8_t> aac(200 + i % 50, static_cast<uint8_t>(i));
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kAudio, aac.data(), aac.size(), video_90k + 450,
+                                video_90k + 450, false));
+  }
+  ASSERT_TRUE(muxer_.Flush());
+
+  const auto packets = Parse(out_);
+  ExpectContinuity(packets);
+
+  // PCRs only on the video PID, increasing, never further apart than the
+  // configured interval
+  const int64_t interval_90k = config_.pcr_interval_us * 9 / 100;
+  int64_t last_pcr = -1;
+  size_t pcrs = 0;
+  for (const TsPacket& packet : packets) {
+    if (!packet.has_pcr) {
+      continue;
+    }
+    EXPECT_EQ(packet.pid, config_.video_pid);
+    if (last_pcr >= 0) {
+      EXPECT_GT(packet.pcr, last_pcr);
+      EXPECT_LE(packet.pcr - last_pcr, interval_90k);
+    }
+    last_pcr = packet.pcr;
+    ++pcrs;
+  }
+  EXPECT_GE(pcrs, 299u * 900 / static_cast<size_t>(interval_90k));
+
+  // Tables before every keyframe, with valid CRCs each time
+  size_t pats = 0;
+  for (size_t i = 0; i < packets.size(); ++i) {
+    if (packets[i].pid == 0) {
+      Section(packets[i]);
+      Section(packets[i + 1]);
+      ++pats;
+    }
+    if (packets[i].random_access) {
+      ASSERT_GE(i, 2u);
+      EXPECT_EQ(packets[i - 2].pid, 0);
+      EXPECT_EQ(packets[i - 1].pid, config_.pmt_pid);
+    }
+  }
+  EXPECT_GE(pats, 6u);
+}
+
+TEST_F(TSMuxerTest, WritesPesStartCodesTimestampsAndPayloads) {
+  Init(/*audio=*/true);
+  const int64_t delay_90k = config_.mux_delay_us * 9 / 100;
+  std::vector<std::vector<uint8_t>> video;
+  std::vector<std::vector<uint8_t>> audio;
+  for (int i = 0; i < 20; ++i) {
+    video.push_back(AccessUnit(i == 0 ? 3000 : 100 + 150 * i, i == 0 ? 0x65 : 0x41,
+                               static_cast<uint8_t>(0x10 + i)));
+    // PTS ahead of DTS, as with reordered pictures
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, video.back().data(), video.back().size(),
+                                i * 3000 + 3000, i * 3000, i == 0));
+    audio.emplace_back(50 + i, static_cast<uint8_t>(0x80 + i));
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kAudio, audio.back().data(), audio.back().size(),
+                                i * 3000 + 100, i * 3000 + 100, false));
+  }
+  ASSERT_TRUE(muxer_.Flush());
+  const auto packets = Parse(out_);
+
+  const auto video_pes = Reassemble(packets, config_.video_pid);
+  ASSERT_EQ(video_pes.size(), video.size());
+  for (size_t i = 0; i < video_pes.size(); ++i) {
+    const Pes& pes = video_pes[i];
+    EXPECT_EQ(pes.stream_id, 0xE0);
+    EXPECT_EQ(pes.pts, static_cast<int64_t>(i) * 3000 + 3000 + delay_90k);
+    EXPECT_EQ(pes.dts, static_cast<int64_t>(i) * 3000 + delay_90k);
+    // An access unit delimiter ahead of the access unit, then its bytes
+    const std::vector<uint8_t> aud = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0};
+    ASSERT_GE(pes.data.size(), aud.size() + video[i].size());
+    EXPECT_TRUE(std::equal(aud.begin(), aud.end(), pes.data.begin()));
+    EXPECT_TRUE(std::equal(video[i].begin(), video[i].end(), pes.data.begin() + aud.size()));
+    EXPECT_EQ(pes.data.size(), aud.size() + video[i].size());
+  }
+
+  const auto audio_pes = Reassemble(packets, config_.audio_pid);
+  ASSERT_EQ(audio_pes.size(), audio.size());
+  for (size_t i = 0; i < audio_pes.size(); ++i) {
+    const Pes& pes = audio_pes[i];
+    EXPECT_EQ(pes.stream_id, 0xC0);
+    EXPECT_EQ(pes.pts, static_cast<int64_t>(i) * 3000 + 100 + delay_90k);
+    EXPECT_EQ(pes.dts, -1);  // PTS only when they match
+    // ADTS header built from the AudioSpecificConfig, then the raw frame
+    ASSERT_EQ(pes.data.size(), 7 + audio[i].size());
+    EXPECT_EQ(pes.data[0], 0xFF);
+    EXPECT_EQ(pes.data[1] & 0xF0, 0xF0);
+    const size_t frame_length =
+        ((pes.data[3] & 0x03) << 11) | (pes.data[4] << 3) | (pes.data[5] >> 5);
+    EXPECT_EQ(frame_length, pes.data.size());
+    EXPECT_TRUE(std::equal(audio[i].begin(), audio[i].end(), pes.data.begin() + 7));
+  }
+}
+
+TEST_F(TSMuxerTest, KeepsAnExistingAccessUnitDelimiter) {
+  Init(/*audio=*/false);
+  const auto au = AccessUnit(40, 0x09, 0xF0);
+  ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, au.data(), au.size(), 0, 0, true));
+  ASSERT_TRUE(muxer_.Flush());
+  const auto pes = Reassemble(Parse(out_), config_.video_pid);
+  ASSERT_EQ(pes.size(), 1u);
+  EXPECT_EQ(pes[0].data, au);
+}
+
+TEST_F(TSMuxerTest, WriteMuxedRewritesCountersToContinueTheStream) {
+  Init(/*audio=*/true);
+  // Filler from a second muxer of the same configuration, with its own
+  // counters, starting on a keyframe
+  std::vector<uint8_t> filler;
+  {
+    TSMuxer filler_muxer;
+    ASSERT_TRUE(filler_muxer.Initialize(config_, &filler, &Collect));
+    for (int i = 0; i < 7; ++i) {
+      const auto au = AccessUnit(i == 0 ? 2500 : 400, i == 0 ? 0x65 : 0x41, 0x33);
+      ASSERT_TRUE(filler_muxer.MuxFrame(TsStream::kVideo, au.data(), au.size(), i * 3000,
+                                        i * 3000, i == 0));
+      const std::vector<uint8_t> aac(120, 0x44);
+      ASSERT_TRUE(
+          filler_muxer.MuxFrame(TsStream::kAudio, aac.data(), aac.size(), i * 3000, i * 3000,
+                                false));
+    }
+    ASSERT_TRUE(filler_muxer.Flush());
+  }
+
+  // Live frames leave the counters mid-cycle, then the filler is spliced in
+  // and live muxing resumes
+  for (int i = 0; i < 5; ++i) {
+    const auto au = AccessUnit(i == 0 ? 3100 : 700, i == 0 ? 0x65 : 0x41, 0x55);
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, au.data(), au.size(), i * 3000, i * 3000,
+                                i == 0));
+    const std::vector<uint8_t> aac(90, 0x66);
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kAudio, aac.data(), aac.size(), i * 3000, i * 3000,
+                                false));
+  }
+  const size_t live_bytes_before = out_.size();
+  std::vector<uint8_t> splice = filler;
+  splice.push_back(0x47);  // A trailing partial packet is dropped
+  ASSERT_TRUE(muxer_.WriteMuxed(splice.data(), splice.size()));
+  for (int i = 5; i < 10; ++i) {
+    const auto au = AccessUnit(700, 0x41, 0x77);
+    ASSERT_TRUE(muxer_.MuxFrame(TsStream::kVideo, au.data(), au.size(), i * 3000, i * 3000,
+                                false));
+  }
+  ASSERT_TRUE(muxer_.Flush());
+  EXPECT_GT(out_.size(), live_bytes_before);
+
+  const auto packets = Parse(out_);
+  ExpectContinuity(packets);
+
+  // The filler's packets went through whole, counters aside, and those
+  // counters did need rewriting
+  const auto filler_packets = Parse(filler);
+  size_t matched = 0;
+  size_t rewritten = 0;
+  for (const TsPacket& packet : packets) {
+    if (matched < filler_packets.size() && packet.pid == filler_packets[matched].pid &&
+        packet.payload == filler_packets[matched].payload &&
+        packet.has_pcr == filler_packets[matched].has_pcr) {
+      rewritten += packet.cc != filler_packets[matched].cc;
+      ++matched;
+    }
+  }
+  EXPECT_EQ(matched, filler_packets.size());
+  EXPECT_GT(rewritten, 0u);
+}
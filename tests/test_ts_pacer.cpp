@@ -0,0 +1,236 @@
+// Repository: Retrovue-playout
+// Component: TS Pacer Unit Tests
+// Purpose: Tests the paced output rate, null stuffing and PCR restamping on a test clock.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsPacer.hpp"
+#include "timing/TestMasterClock.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::TsPacer;
+using retrovue::timing::TestMasterClock;
+
+namespace {
+
+constexpr size_t kPacket = TsPacer::kPacketSize;
+// One packet per millisecond
+constexpr int64_t kRateBps = 1000 * kPacket * 8;
+constexpr int64_t kSlotUs = 1000;
+constexpr size_t kBurst = 7;
+constexpr int64_t kStartUs = 1'000'000'000;
+
+struct Output {
+  std::mutex mutex;
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> writes;  // Packets per write
+
+  size_t Packets() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes.size() / kPacket;
+  }
+};
+
+int Collect(void* opaque, uint8_t* buf, int buf_size) {
+  auto* out = static_cast<Output*>(opaque);
+  std::lock_guard<std::mutex> lock(out->mutex);
+  out->bytes.insert(out->bytes.end(), buf, buf + buf_size);
+  out->writes.push_back(static_cast<size_t>(buf_size) / kPacket);
+  return buf_size;
+}
+
+std::vector<uint8_t> Packet(uint16_t pid, uint8_t cc, int64_t pcr_27m = -1) {
+  std::vector<uint8_t> packet(kPacket, 0xAA);
+  packet[0] = 0x47;
+  packet[1] = static_cast<uint8_t>(pid >> 8);
+  packet[2] = static_cast<uint8_t>(pid);
+  packet[3] = static_cast<uint8_t>(0x10 | (cc & 0x0F));
+  if (pcr_27m >= 0) {
+    const int64_t base = pcr_27m / 300;
+    const int64_t extension = pcr_27m % 300;
+    packet[3] |= 0x20;
+    packet[4] = 7;
+    packet[5] = 0x10;
+    packet[6] = static_cast<uint8_t>(base >> 25);
+    packet[7] = static_cast<uint8_t>(base >> 17);
+    packet[8] = static_cast<uint8_t>(base >> 9);
+    packet[9] = static_cast<uint8_t>(base >> 1);
+    packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E | (extension >> 8));
+    packet[11] = static_cast<uint8_t>(extension);
+  }
+  return packet;
+}
+
+uint16_t Pid(const uint8_t* packet) {
+  return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
+int64_t Pcr27m(const uint8_t* packet) {
+  const int64_t base = (static_cast<int64_t>(packet[6]) << 25) |
+                       (static_cast<int64_t>(packet[7]) << 17) |
+                       (static_cast<int64_t>(packet[8]) << 9) |
+                       (static_cast<int64_t>(packet[9]) << 1) | (packet[10] >> 7);
+  return base * 300 + (((packet[10] & 0x01) << 8) | packet[11]);
+}
+
+bool WaitForPackets(Output& out, size_t count) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (out.Packets() < count) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+class TsPacerTest : public ::testing::Test {
+ protected:
+  void Open(int64_t max_queue_ms = 1000) {
+    pacer_ = std::make_unique<TsPacer>(clock_, kRateBps, kBurst, max_queue_ms, &out_, &Collect);
+    ASSERT_TRUE(pacer_->Start());
+  }
+
+  void Push(const std::vector<uint8_t>& bytes) { pacer_->Push(bytes.data(), bytes.size()); }
+
+  // The schedule starts on the test clock whenever the pacing thread sees
+  // the first packet: burst-long steps until the first write, which is then
+  // in step with the clock
+  void AdvanceToFirstWrite() {
+    for (int i = 0; i < 1000 && out_.Packets() == 0; ++i) {
+      clock_->AdvanceMicroseconds(kBurst * kSlotUs);
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+      while (out_.Packets() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    ASSERT_GT(out_.Packets(), 0u);
+  }
+
+  // One burst's worth of clock, and its packets
+  void Step() {
+    const size_t before = out_.Packets();
+    clock_->AdvanceMicroseconds(kBurst * kSlotUs);
+    ASSERT_TRUE(WaitForPackets(out_, before + kBurst));
+  }
+
+  std::shared_ptr<TestMasterClock> clock_ =
+      std::make_shared<TestMasterClock>(kStartUs, TestMasterClock::Mode::Deterministic);
+  Output out_;
+  std::unique_ptr<TsPacer> pacer_;
+};
+
+}  // namespace
+
+TEST_F(TsPacerTest, HoldsTheRateWithNullPackets) {
+  Open();
+  std::vector<uint8_t> muxed;
+  for (uint8_t i = 0; i < 3; ++i) {
+    const auto packet = Packet(0x100, i);
+    muxed.insert(muxed.end(), packet.begin(), packet.end());
+  }
+  Push(muxed);
+  AdvanceToFirstWrite();
+  // A simulated second: all 1000 slots filled, nothing more
+  for (int i = 1; i < 1000 / static_cast<int>(kBurst); ++i) {
+    Step();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const size_t sent = (1000 / kBurst) * kBurst;
+  ASSERT_EQ(out_.Packets(), sent);
+  pacer_->Stop();
+
+  std::lock_guard<std::mutex> lock(out_.mutex);
+  for (size_t size : out_.writes) {
+    EXPECT_EQ(size, kBurst);
+  }
+  // The muxed packets first, untouched, then stuffing
+  EXPECT_TRUE(std::equal(muxed.begin(), muxed.end(), out_.bytes.begin()));
+  for (size_t i = 3; i < sent; ++i) {
+    const uint8_t* packet = out_.bytes.data() + i * kPacket;
+    ASSERT_EQ(packet[0], 0x47);
+    EXPECT_EQ(Pid(packet), 0x1FFF);
+    EXPECT_EQ(packet[3], 0x10);  // Payload only
+    EXPECT_EQ(packet[kPacket - 1], 0xFF);
+  }
+  const auto stats = pacer_->GetStats();
+  EXPECT_EQ(stats.packets_sent, 3u);
+  EXPECT_EQ(stats.null_packets, sent - 3);
+  EXPECT_EQ(stats.overrun_packets, 0u);
+  EXPECT_EQ(stats.max_burst_packets, kBurst);
+}
+
+TEST_F(TsPacerTest, SendsABacklogBeyondTheLimitAtOnce) {
+  Open(/*max_queue_ms=*/10);  // Ten packets
+  std::vector<uint8_t> muxed;
+  for (uint8_t i = 0; i < 40; ++i) {
+    const auto packet = Packet(0x100, i);
+    muxed.insert(muxed.end(), packet.begin(), packet.end());
+  }
+  Push(muxed);
+  AdvanceToFirstWrite();
+  Step();  // The ten left go at the rate, then stuffing
+  Step();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const auto stats = pacer_->GetStats();
+  EXPECT_EQ(stats.overrun_packets, 40u - 10 - kBurst);
+  EXPECT_EQ(stats.max_burst_packets, 40u - 10);
+  std::lock_guard<std::mutex> lock(out_.mutex);
+  ASSERT_EQ(out_.writes.size(), 3u);
+  EXPECT_EQ(out_.writes[0], 40u - 10);
+  EXPECT_EQ(out_.writes[1], kBurst);
+  EXPECT_TRUE(std::equal(muxed.begin(), muxed.end(), out_.bytes.begin()));
+}
+
+TEST_F(TsPacerTest, RestampsPcrsOnTheSendSchedule) {
+  Open();
+  // Bursty muxer output: a PCR packet every fourth, jittered up to 3 ms off
+  // where its send slot will put it, then a jump past the re-anchor limit
+  const int64_t origin_27m = int64_t{5'000'000} * 27;
+  const int64_t jitter_us[] = {0, 2000, -3000, 1500, -500, 3000, -2500, 700};
+  std::vector<uint8_t> muxed;
+  for (size_t i = 0; i < 32; ++i) {
+    const bool pcr = i % 4 == 0;
+    const int64_t muxed_27m =
+        origin_27m + (static_cast<int64_t>(i) * kSlotUs + jitter_us[i / 4]) * 27;
+    const auto packet = Packet(pcr ? 0x100 : 0x101, static_cast<uint8_t>(i),
+                               pcr ? muxed_27m : -1);
+    muxed.insert(muxed.end(), packet.begin(), packet.end());
+  }
+  const int64_t jumped_27m = origin_27m + int64_t{10'000'000} * 27;
+  const auto jump = Packet(0x100, 0, jumped_27m);
+  muxed.insert(muxed.end(), jump.begin(), jump.end());
+  Push(muxed);
+  AdvanceToFirstWrite();
+  while (out_.Packets() < 33) {
+    Step();
+  }
+  pacer_->Stop();
+
+  std::lock_guard<std::mutex> lock(out_.mutex);
+  // Slot n goes out n ms into the schedule: each restamped PCR is the
+  // first one plus its slot's offset, the muxer's jitter gone
+  for (size_t i = 0; i < 32; i += 4) {
+    const uint8_t* packet = out_.bytes.data() + i * kPacket;
+    ASSERT_EQ(Pid(packet), 0x100);
+    EXPECT_EQ(Pcr27m(packet), origin_27m + static_cast<int64_t>(i) * kSlotUs * 27)
+        << "packet " << i;
+    EXPECT_EQ(packet[5] & 0x80, 0) << "packet " << i;
+  }
+  // The jump is taken as is and flagged
+  const uint8_t* jumped = out_.bytes.data() + 32 * kPacket;
+  EXPECT_EQ(Pcr27m(jumped), jumped_27m);
+  EXPECT_EQ(jumped[5] & 0x80, 0x80);
+
+  const auto stats = pacer_->GetStats();
+  EXPECT_EQ(stats.pcr_restamps, 9u);
+  EXPECT_EQ(stats.pcr_discontinuities, 1u);
+}
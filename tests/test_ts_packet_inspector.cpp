@@ -0,0 +1,237 @@
+// Repository: Retrovue-playout
+// Component: TS Packet Inspector Unit Tests
+// Purpose: Feeds hand-built packets through CC repair, raw gap counts, PCR cadence and sampling.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsPacketInspector.hpp"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::TsPacketInspector;
+using retrovue::telemetry::EncoderTelemetry;
+
+namespace {
+
+constexpr size_t kPacket = TsPacketInspector::kPacketSize;
+constexpr uint16_t kPid = 0x100;
+
+struct PacketSpec {
+  uint16_t pid = kPid;
+  uint8_t cc = 0;
+  bool payload = true;
+  bool discontinuity = false;
+  int64_t pcr_90k = -1;  // -1 = no PCR
+};
+
+std::vector<uint8_t> Packet(const PacketSpec& spec) {
+  std::vector<uint8_t> packet(kPacket, 0xFF);
+  packet[0] = 0x47;
+  packet[1] = static_cast<uint8_t>(spec.pid >> 8);
+  packet[2] = static_cast<uint8_t>(spec.pid & 0xFF);
+  const bool adaptation = spec.discontinuity || spec.pcr_90k >= 0 || !spec.payload;
+  packet[3] = static_cast<uint8_t>((adaptation ? 0x20 : 0x00) | (spec.payload ? 0x10 : 0x00) |
+                                   (spec.cc & 0x0F));
+  if (adaptation) {
+    packet[4] = spec.payload ? 7 : 183;
+    packet[5] = static_cast<uint8_t>((spec.discontinuity ? 0x80 : 0x00) |
+                                     (spec.pcr_90k >= 0 ? 0x10 : 0x00));
+    if (spec.pcr_90k >= 0) {
+      const int64_t base = spec.pcr_90k;
+      packet[6] = static_cast<uint8_t>(base >> 25);
+      packet[7] = static_cast<uint8_t>(base >> 17);
+      packet[8] = static_cast<uint8_t>(base >> 9);
+      packet[9] = static_cast<uint8_t>(base >> 1);
+      packet[10] = static_cast<uint8_t>(((base & 0x01) << 7) | 0x7E);
+      packet[11] = 0;
+    }
+  }
+  return packet;
+}
+
+// Payload packets on kPid with the given continuity counters
+std::vector<uint8_t> Buffer(std::initializer_list<int> ccs) {
+  std::vector<uint8_t> buffer;
+  for (int cc : ccs) {
+    PacketSpec spec;
+    spec.cc = static_cast<uint8_t>(cc);
+    const auto packet = Packet(spec);
+    buffer.insert(buffer.end(), packet.begin(), packet.end());
+  }
+  return buffer;
+}
+
+std::vector<int> Ccs(const std::vector<uint8_t>& buffer) {
+  std::vector<int> ccs;
+  for (size_t offset = 0; offset + kPacket <= buffer.size(); offset += kPacket) {
+    ccs.push_back(buffer[offset + 3] & 0x0F);
+  }
+  return ccs;
+}
+
+void Process(TsPacketInspector& inspector, std::vector<uint8_t> buffer) {
+  inspector.Process(buffer.data(), buffer.size());
+}
+
+}  // namespace
+
+TEST(TsPacketInspectorTest, RepairsContinuityAndCountsTheRawGaps) {
+  TsPacketInspector inspector;
+  auto buffer = Buffer({0, 1, 2, 5, 6, 7});
+  inspector.Process(buffer.data(), buffer.size());
+
+  // One raw gap (2 -> 5); the repair renumbers everything after it
+  EXPECT_EQ(Ccs(buffer), (std::vector<int>{0, 1, 2, 3, 4, 5}));
+  auto stats = inspector.GetStats();
+  EXPECT_EQ(stats.packets, 6u);
+  EXPECT_EQ(stats.continuity_mismatches, 1u);
+  EXPECT_EQ(stats.continuity_corrections, 3u);
+  EXPECT_EQ(inspector.GetPidPackets(kPid), 6u);
+  EXPECT_EQ(inspector.GetPidMismatches(kPid), 1u);
+
+  // The counter wraps at 15, adaptation-only packets repeat it, and a
+  // discontinuity indicator restarts the PID wherever it says
+  std::vector<uint8_t> more;
+  for (const PacketSpec& spec :
+       {PacketSpec{kPid, 14}, PacketSpec{kPid, 15}, PacketSpec{kPid, 0},
+        PacketSpec{kPid, 3, false}, PacketSpec{kPid, 1}, PacketSpec{kPid, 9, true, true},
+        PacketSpec{kPid, 10}, PacketSpec{TsPacketInspector::kNullPid, 4}}) {
+    const auto packet = Packet(spec);
+    more.insert(more.end(), packet.begin(), packet.end());
+  }
+  inspector.Process(more.data(), more.size());
+  EXPECT_EQ(Ccs(more), (std::vector<int>{6, 7, 8, 8, 9, 9, 10, 4}));
+  stats = inspector.GetStats();
+  EXPECT_EQ(stats.continuity_corrections, 3u + 5u);  // 14, 15, 0, 3 (repeat) and 1
+  // Raw gaps: 7 -> 14, 0 -> 3, 3 -> 1, 1 -> 9 (the null PID is on its own)
+  EXPECT_EQ(stats.continuity_mismatches, 1u + 4u);
+  EXPECT_EQ(inspector.GetPidMismatches(kPid), 5u);
+  EXPECT_EQ(inspector.GetPidMismatches(TsPacketInspector::kNullPid), 0u);
+
+  // Reset() forgets PID state and counters
+  inspector.Reset();
+  auto fresh = Buffer({11, 12});
+  inspector.Process(fresh.data(), fresh.size());
+  EXPECT_EQ(Ccs(fresh), (std::vector<int>{11, 12}));
+  EXPECT_EQ(inspector.GetStats().continuity_corrections, 0u);
+  EXPECT_EQ(inspector.GetPidPackets(kPid), 2u);
+}
+
+TEST(TsPacketInspectorTest, ResyncsPastBytesThatAreNotPackets) {
+  TsPacketInspector inspector;
+  auto buffer = Buffer({0, 1});
+  buffer.insert(buffer.begin() + kPacket, {0x00, 0x11, 0x22});
+  buffer.resize(buffer.size() + 3 * kPacket, 0x00);  // No sync byte anywhere
+  inspector.Process(buffer.data(), buffer.size());
+  const auto stats = inspector.GetStats();
+  EXPECT_EQ(stats.packets, 2u);
+  EXPECT_EQ(stats.sync_errors, 3u + 3 * kPacket - kPacket + 1);
+  EXPECT_EQ(stats.continuity_mismatches, 0u);
+
+  EXPECT_TRUE(TsPacketInspector::SyncBytesValid(Buffer({0, 1, 2, 3, 4}).data(), 5 * kPacket));
+  EXPECT_FALSE(TsPacketInspector::SyncBytesValid(Buffer({0, 1}).data(), 2 * kPacket - 1));
+}
+
+TEST(TsPacketInspectorTest, ValidatesOnlySampledBuffers) {
+  TsPacketInspector inspector(3);
+
+  // Buffers 0 and 3 are validated; the gap between buffer 0's last packet
+  // and buffer 3's first is the skipped buffers, not a raw gap
+  for (int buffer = 0; buffer < 6; ++buffer) {
+    const int cc = buffer * 4;
+    Process(inspector, Buffer({cc & 15, (cc + 1) & 15, (cc + 2) & 15, (cc + 3) & 15}));
+  }
+  auto stats = inspector.GetStats();
+  EXPECT_EQ(stats.packets, 24u);
+  EXPECT_EQ(stats.validated_packets, 8u);
+  EXPECT_EQ(stats.continuity_mismatches, 0u);
+  EXPECT_EQ(inspector.GetPidPackets(kPid), 8u);
+
+  // A gap in a skipped buffer is still repaired but not counted as raw;
+  // one in a sampled buffer is both
+  Process(inspector, Buffer({8, 9, 0, 1}));   // Buffer 6: sampled
+  Process(inspector, Buffer({2, 3, 7, 8}));   // Buffer 7: skipped
+  stats = inspector.GetStats();
+  EXPECT_EQ(stats.validated_packets, 12u);
+  EXPECT_EQ(stats.continuity_mismatches, 1u);
+  EXPECT_EQ(stats.continuity_corrections, 2u + 4u);
+
+  // Interval 0 repairs everything and validates nothing
+  TsPacketInspector unsampled(0);
+  auto buffer = Buffer({0, 4});
+  unsampled.Process(buffer.data(), buffer.size());
+  EXPECT_EQ(Ccs(buffer), (std::vector<int>{0, 1}));
+  EXPECT_EQ(unsampled.GetStats().validated_packets, 0u);
+  EXPECT_EQ(unsampled.GetStats().continuity_mismatches, 0u);
+  EXPECT_EQ(unsampled.GetPidPackets(kPid), 0u);
+}
+
+TEST(TsPacketInspectorTest, ExtractsThe33BitPcrBase) {
+  int64_t pcr_90k = 0;
+  const int64_t base = (int64_t{1} << 33) - 12345;
+  EXPECT_TRUE(
+      TsPacketInspector::ExtractPCR(Packet({kPid, 0, true, false, base}).data(), pcr_90k));
+  EXPECT_EQ(pcr_90k, base);
+  EXPECT_TRUE(TsPacketInspector::ExtractPCR(Packet({kPid, 0, true, false, 1}).data(), pcr_90k));
+  EXPECT_EQ(pcr_90k, 1);
+  EXPECT_FALSE(TsPacketInspector::ExtractPCR(Packet({kPid, 0, true, true}).data(), pcr_90k));
+  EXPECT_FALSE(TsPacketInspector::ExtractPCR(Packet({kPid}).data(), pcr_90k));
+}
+
+TEST(TsPacketInspectorTest, MeasuresPcrJitterAndFlagsOutOfRangeSpacing) {
+  EncoderTelemetry telemetry;
+  TsPacketInspector inspector;
+  inspector.SetTelemetry(&telemetry);
+  const auto start = std::chrono::steady_clock::now();
+  const int64_t first = 900'000;
+  Process(inspector, Packet({kPid, 0, true, false, first}));
+
+  // A PCR that advanced with the wall clock: in range, with little jitter
+  std::this_thread::sleep_for(std::chrono::milliseconds(40));
+  const int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+  const int64_t second = first + elapsed_us * 90 / 1000;
+  Process(inspector, Packet({kPid, 1, true, false, second}));
+  EXPECT_EQ(inspector.GetStats().pcr_cadence_warnings, 0u);
+  auto snapshot = telemetry.Snapshot();
+  ASSERT_EQ(snapshot.pcr_interval_us.Count(), 1u);
+  EXPECT_GE(snapshot.pcr_interval_us.Max(), 39'000);
+  EXPECT_EQ(snapshot.pcr_jitter_us.Count(), 1u);
+  EXPECT_LT(snapshot.pcr_jitter_us.Max(), 20'000);
+
+  // Half a second of PCR in a few ms of wall time, then a step back: both
+  // out of the 20-60 ms per 40 ms window
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  Process(inspector, Packet({kPid, 2, true, false, second + 45'000}));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  Process(inspector, Packet({kPid, 3, true, false, second}));
+  EXPECT_EQ(inspector.GetStats().pcr_cadence_warnings, 2u);
+  snapshot = telemetry.Snapshot();
+  EXPECT_EQ(snapshot.pcr_interval_us.Count(), 2u);  // A negative interval is not one
+  EXPECT_EQ(snapshot.pcr_jitter_us.Count(), 3u);
+  EXPECT_GE(snapshot.pcr_jitter_us.Max(), 400'000);
+
+  // Packets without a PCR do not touch the cadence
+  Process(inspector, Buffer({4, 5, 6}));
+  EXPECT_EQ(telemetry.Snapshot().pcr_jitter_us.Count(), 3u);
+}
+
+TEST(TsPacketInspectorTest, ReportsOnlyJitterWhenSampled) {
+  // Skipped buffers hide PCRs, so spacing is not reported; jitter still
+  // compares PCR and wall time across the gap
+  EncoderTelemetry telemetry;
+  TsPacketInspector inspector(2);
+  inspector.SetTelemetry(&telemetry);
+  for (int i = 0; i < 6; ++i) {
+    Process(inspector, Packet({kPid, static_cast<uint8_t>(i), true, false, 900'000 + i * 90}));
+  }
+  const auto snapshot = telemetry.Snapshot();
+  EXPECT_EQ(snapshot.pcr_interval_us.Count(), 0u);
+  EXPECT_EQ(snapshot.pcr_jitter_us.Count(), 2u);  // Buffers 2 and 4 against 0 and 2
+  EXPECT_EQ(inspector.GetStats().validated_packets, 3u);
+}
@@ -0,0 +1,210 @@
+// Repository: Retrovue-playout
+// Component: TS Rate Adapter Unit Tests
+// Purpose: Tests the bitrate the adapter derives from synthetic fanout samples.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsRateAdapter.hpp"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::TsFanoutStats;
+using retrovue::playout_sinks::mpegts::TsRateAdapter;
+
+namespace {
+
+constexpr int64_t kMaxBps = 4'000'000;
+constexpr int64_t kMinBps = 500'000;
+constexpr int64_t kOverheadBps = 200'000;
+constexpr int64_t kSecondUs = 1'000'000;
+constexpr double kMuxOverhead = 1.03;  // TsRateAdapter.cpp's TS/PES allowance
+
+// The video rate Sample() aims for when the slowest client is congested,
+// over a one-second sample
+int64_t CongestedRate(int64_t published, int64_t growth, int64_t backlog) {
+  const double throughput_bps = static_cast<double>(published - growth) * 8;
+  const double total_bps = TsRateAdapter::kHeadroom * throughput_bps -
+                           static_cast<double>(backlog) * 8 * 1000 / TsRateAdapter::kDrainMs;
+  return std::clamp(static_cast<int64_t>(total_bps / kMuxOverhead) - kOverheadBps, kMinBps,
+                    kMaxBps);
+}
+
+// Cumulative fanout counters, advanced one sample at a time
+class Feed {
+ public:
+  explicit Feed(TsRateAdapter& adapter) : adapter_(adapter) { adapter_.Sample(stats_, 0); }
+
+  // One second in which published bytes went out, the longest queue ended
+  // at queued bytes, and losses chunks were dropped
+  int64_t Second(int64_t published, size_t queued, double send_buffer_ratio,
+                 uint64_t losses = 0) {
+    stats_.bytes_published += static_cast<uint64_t>(published);
+    stats_.max_queued_bytes = queued;
+    stats_.send_buffer_ratio = send_buffer_ratio;
+    stats_.chunks_dropped += losses;
+    return adapter_.Sample(stats_, kSecondUs);
+  }
+
+  TsFanoutStats& stats() { return stats_; }
+
+ private:
+  TsRateAdapter& adapter_;
+  TsFanoutStats stats_;
+};
+
+struct CongestionCase {
+  const char* name;
+  int64_t published;      // Bytes over the second
+  size_t queued_before;   // Longest queue at the baseline
+  size_t queued;          // And at the sample
+  double send_buffer_ratio;
+  int64_t expected;       // Returned rate (0 = unchanged)
+};
+
+}  // namespace
+
+TEST(TsRateAdapterTest, LowersTheRateOnlyForACongestedClient) {
+  const CongestionCase cases[] = {
+      // 4.4 Mbps published, 200 kB (364 ms) piled up behind a full socket
+      {"congested", 550'000, 0, 200'000, 0.95, CongestedRate(550'000, 200'000, 200'000)},
+      // A standing backlog that barely grew still drains at the cost of the rate
+      {"standing backlog", 550'000, 150'000, 151'000, 0.95,
+       CongestedRate(550'000, 1'000, 151'000)},
+      // The client took almost nothing: the floor
+      {"stalled", 550'000, 0, 540'000, 1.0, kMinBps},
+      // The socket is still taking data: queueing in the sender, not the path
+      {"send buffer not full", 550'000, 0, 200'000, 0.5, 0},
+      // Under kBacklogMs of stream queued
+      {"short backlog", 550'000, 0, 100'000, 0.95, 0},
+      // Backlogged but not growing
+      {"backlog shrinking", 550'000, 250'000, 200'000, 0.95, 0},
+  };
+  for (const CongestionCase& c : cases) {
+    SCOPED_TRACE(c.name);
+    TsRateAdapter adapter(kMaxBps, kMinBps, kOverheadBps);
+    TsFanoutStats stats;
+    stats.max_queued_bytes = c.queued_before;
+    EXPECT_EQ(adapter.Sample(stats, kSecondUs), 0);  // Baseline
+    stats.bytes_published += static_cast<uint64_t>(c.published);
+    stats.max_queued_bytes = c.queued;
+    stats.send_buffer_ratio = c.send_buffer_ratio;
+    EXPECT_EQ(adapter.Sample(stats, kSecondUs), c.expected);
+
+    const auto adapter_stats = adapter.GetStats();
+    EXPECT_EQ(adapter_stats.video_bps, c.expected > 0 ? c.expected : kMaxBps);
+    EXPECT_EQ(adapter_stats.decreases, c.expected > 0 ? 1u : 0u);
+    if (c.expected > 0) {
+      EXPECT_EQ(adapter_stats.throughput_bps,
+                static_cast<int64_t>(c.published - (c.queued - c.queued_before)) * 8);
+    }
+  }
+}
+
+TEST(TsRateAdapterTest, LossCutsTheRateTo70Percent) {
+  // Every kind of loss, with the queue's own estimate far above the cut
+  const char* kinds[] = {"chunks_dropped", "gop_resyncs", "evictions"};
+  for (int kind = 0; kind < 3; ++kind) {
+    SCOPED_TRACE(kinds[kind]);
+    TsRateAdapter adapter(kMaxBps, kMinBps, kOverheadBps);
+    TsFanoutStats stats;
+    adapter.Sample(stats, kSecondUs);
+    stats.bytes_published += 550'000;
+    uint64_t* counter = kind == 0 ? &stats.chunks_dropped
+                        : kind == 1 ? &stats.gop_resyncs
+                                   : &stats.evictions;
+    ++*counter;
+    ASSERT_GT(CongestedRate(550'000, 0, 0), 2'800'000);
+    EXPECT_EQ(adapter.Sample(stats, kSecondUs), 2'800'000);  // 0.7 of 4 Mbps
+
+    // Each further loss cuts again, down to the floor
+    stats.bytes_published += 550'000;
+    ++*counter;
+    EXPECT_EQ(adapter.Sample(stats, kSecondUs), 1'960'000);
+    for (int i = 0; i < 10; ++i) {
+      stats.bytes_published += 550'000;
+      ++*counter;
+      adapter.Sample(stats, kSecondUs);
+    }
+    EXPECT_EQ(adapter.GetStats().video_bps, kMinBps);
+  }
+}
+
+TEST(TsRateAdapterTest, StepsUpAfterClearSamples) {
+  TsRateAdapter adapter(kMaxBps, kMinBps, kOverheadBps);
+  Feed feed(adapter);
+  const int64_t lowered = feed.Second(550'000, 0, 0.0, /*losses=*/1);
+  ASSERT_EQ(lowered, 2'800'000);
+
+  // Clear seconds: each kRecoverSamples-th steps up by kStepUp, the last
+  // step landing on max_bps
+  int64_t rate = lowered;
+  std::vector<int64_t> steps;
+  for (int second = 1; second <= 40; ++second) {
+    const int64_t applied = feed.Second(550'000, 0, 0.0);
+    if (second % TsRateAdapter::kRecoverSamples != 0) {
+      EXPECT_EQ(applied, 0) << "second " << second;
+      continue;
+    }
+    if (rate == kMaxBps) {
+      EXPECT_EQ(applied, 0);
+      continue;
+    }
+    const int64_t expected =
+        std::min<int64_t>(kMaxBps, std::llround(rate * TsRateAdapter::kStepUp));
+    EXPECT_EQ(applied, expected) << "second " << second;
+    rate = expected;
+    steps.push_back(applied);
+  }
+  EXPECT_EQ(rate, kMaxBps);
+  EXPECT_EQ(steps, (std::vector<int64_t>{3'080'000, 3'388'000, 3'726'800, kMaxBps}));
+  EXPECT_EQ(adapter.GetStats().increases, 4u);
+
+  // A backlog, congested or not, restarts the count
+  const int64_t lower = feed.Second(550'000, 0, 0.0, /*losses=*/1);
+  ASSERT_GT(lower, 0);
+  for (int i = 0; i < TsRateAdapter::kRecoverSamples - 1; ++i) {
+    EXPECT_EQ(feed.Second(550'000, 0, 0.0), 0);
+  }
+  EXPECT_EQ(feed.Second(550'000, 200'000, 0.0), 0);  // 200 kB: 364 ms of stream
+  for (int i = 0; i < TsRateAdapter::kRecoverSamples - 1; ++i) {
+    EXPECT_EQ(feed.Second(550'000, 0, 0.0), 0);
+  }
+  EXPECT_EQ(feed.Second(550'000, 0, 0.0), std::llround(lower * TsRateAdapter::kStepUp));
+}
+
+TEST(TsRateAdapterTest, IgnoresChangesUnderMinChange) {
+  TsRateAdapter adapter(kMaxBps, kMinBps, kOverheadBps);
+  Feed feed(adapter);
+  const int64_t first = feed.Second(550'000, 200'000, 0.95);
+  ASSERT_EQ(first, CongestedRate(550'000, 200'000, 200'000));
+
+  // Still congested, aiming 3% lower: not worth reopening the encoder for
+  const int64_t target = CongestedRate(345'500, 1'000, 201'000);
+  ASSERT_LT(target, first);
+  ASSERT_LT(first - target, first * TsRateAdapter::kMinChange);
+  EXPECT_EQ(feed.Second(345'500, 201'000, 0.95), 0);
+  EXPECT_EQ(adapter.GetStats().video_bps, first);
+  EXPECT_EQ(adapter.GetStats().decreases, 1u);
+  EXPECT_EQ(adapter.GetStats().congested_samples, 2u);
+}
+
+TEST(TsRateAdapterTest, ResetRestoresTheConfiguredRate) {
+  TsRateAdapter adapter(kMaxBps, kMinBps, kOverheadBps);
+  EXPECT_EQ(adapter.Reset(), 0);  // Nothing to restore
+
+  Feed feed(adapter);
+  ASSERT_GT(feed.Second(550'000, 200'000, 0.95), 0);
+  EXPECT_EQ(adapter.Reset(), kMaxBps);
+  EXPECT_EQ(adapter.GetStats().video_bps, kMaxBps);
+
+  // The next sample is a new baseline, however congested it looks
+  TsFanoutStats& stats = feed.stats();
+  stats.bytes_published += 550'000;
+  stats.max_queued_bytes = 400'000;
+  stats.chunks_dropped += 3;
+  EXPECT_EQ(adapter.Sample(stats, kSecondUs), 0);
+  EXPECT_EQ(adapter.Reset(), 0);
+}
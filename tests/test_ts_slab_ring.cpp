@@ -0,0 +1,200 @@
+// Repository: Retrovue-playout
+// Component: TS Slab Ring Unit Tests
+// Purpose: Tests slab splitting, wraparound, full/empty limits and cross-thread handoff.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsSlabRing.hpp"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::TsSlabRing;
+
+namespace {
+
+constexpr size_t kPacket = TsSlabRing::kPacketSize;
+
+// Packets whose bytes encode (seed, offset), so any reordering or stale
+// slab shows up as a mismatch
+std::vector<uint8_t> Packets(size_t count, uint32_t seed) {
+  std::vector<uint8_t> bytes(count * kPacket);
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<uint8_t>(seed * 31 + i);
+  }
+  return bytes;
+}
+
+std::vector<uint8_t> Drain(TsSlabRing& ring) {
+  std::vector<uint8_t> out;
+  while (const TsSlabRing::Slab* slab = ring.Front()) {
+    out.insert(out.end(), slab->data, slab->data + slab->size);
+    ring.Pop();
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(TsSlabRingTest, RoundsSlabsToWholePackets) {
+  TsSlabRing ring(1000, 10 * kPacket);
+  EXPECT_EQ(ring.slab_bytes(), 5 * kPacket);
+  EXPECT_EQ(ring.GetStats().capacity_bytes, 10 * kPacket);
+
+  TsSlabRing tiny(10, 0);  // At least one packet per slab and two slabs
+  EXPECT_EQ(tiny.slab_bytes(), kPacket);
+  EXPECT_EQ(tiny.GetStats().capacity_bytes, 2 * kPacket);
+}
+
+TEST(TsSlabRingTest, SplitsWritesOverSlabsAndEndsTheLast) {
+  TsSlabRing ring(2 * kPacket, 8 * kPacket);
+  const std::vector<uint8_t> bytes = Packets(5, 1);
+  ASSERT_TRUE(ring.Write(bytes.data(), bytes.size()));
+
+  const TsSlabRing::Slab* slabs[8];
+  ASSERT_EQ(ring.Peek(slabs, 8), 3u);
+  EXPECT_EQ(slabs[0]->size, 2 * kPacket);
+  EXPECT_EQ(slabs[1]->size, 2 * kPacket);
+  EXPECT_EQ(slabs[2]->size, kPacket);  // Not held back for more data
+  EXPECT_EQ(ring.QueuedBytes(), bytes.size());
+
+  EXPECT_EQ(Drain(ring), bytes);
+  EXPECT_EQ(ring.QueuedBytes(), 0u);
+  EXPECT_EQ(ring.Front(), nullptr);
+}
+
+TEST(TsSlabRingTest, WrapsAroundAndRecyclesSlabs) {
+  TsSlabRing ring(kPacket, 4 * kPacket);
+  // Many times the ring's size through the same four slabs
+  for (uint32_t round = 0; round < 50; ++round) {
+    const std::vector<uint8_t> bytes = Packets(3, round);
+    ASSERT_TRUE(ring.Write(bytes.data(), bytes.size())) << "round " << round;
+    EXPECT_EQ(Drain(ring), bytes) << "round " << round;
+  }
+  const auto stats = ring.GetStats();
+  EXPECT_EQ(stats.bytes_written, 50u * 3 * kPacket);
+  EXPECT_EQ(stats.writes_dropped, 0u);
+  EXPECT_EQ(ring.BytesConsumed(), stats.bytes_written);
+}
+
+TEST(TsSlabRingTest, WriteSpanningTheEndWrapsToTheStart) {
+  TsSlabRing ring(kPacket, 4 * kPacket);
+  const std::vector<uint8_t> first = Packets(3, 7);
+  ASSERT_TRUE(ring.Write(first.data(), first.size()));
+  ring.Pop(2);  // Slabs 0 and 1 free; slab 2 still queued
+
+  // Slabs 3, 0 and 1
+  const std::vector<uint8_t> second = Packets(3, 8);
+  ASSERT_TRUE(ring.Write(second.data(), second.size()));
+
+  std::vector<uint8_t> expected(first.end() - kPacket, first.end());
+  expected.insert(expected.end(), second.begin(), second.end());
+  EXPECT_EQ(Drain(ring), expected);
+}
+
+TEST(TsSlabRingTest, DropsAWriteThatDoesNotFitWhole) {
+  TsSlabRing ring(kPacket, 4 * kPacket);
+  const std::vector<uint8_t> three = Packets(3, 2);
+  ASSERT_TRUE(ring.Write(three.data(), three.size()));
+
+  // Two packets with one slab free: nothing of it is queued
+  const std::vector<uint8_t> two = Packets(2, 3);
+  EXPECT_FALSE(ring.Write(two.data(), two.size()));
+  EXPECT_EQ(ring.QueuedBytes(), three.size());
+
+  // Exactly the free slab fills the ring
+  const std::vector<uint8_t> one = Packets(1, 4);
+  ASSERT_TRUE(ring.Write(one.data(), one.size()));
+  EXPECT_EQ(ring.QueuedBytes(), 4 * kPacket);
+  EXPECT_FALSE(ring.Write(one.data(), one.size()));
+
+  auto stats = ring.GetStats();
+  EXPECT_EQ(stats.queued_bytes, stats.capacity_bytes);
+  EXPECT_EQ(stats.peak_queued_bytes, stats.capacity_bytes);
+  EXPECT_EQ(stats.writes_dropped, 2u);
+  EXPECT_EQ(stats.bytes_dropped, 3 * kPacket);
+
+  // Popping one slab makes room for one packet again
+  ring.Pop();
+  EXPECT_TRUE(ring.Write(one.data(), one.size()));
+  ring.Discard();
+  stats = ring.GetStats();
+  EXPECT_EQ(stats.queued_bytes, 0u);
+  EXPECT_EQ(stats.peak_queued_bytes, stats.capacity_bytes);
+  EXPECT_EQ(ring.Front(), nullptr);
+}
+
+TEST(TsSlabRingTest, WriteLargerThanTheRingIsDropped) {
+  TsSlabRing ring(kPacket, 2 * kPacket);
+  const std::vector<uint8_t> bytes = Packets(3, 5);
+  EXPECT_FALSE(ring.Write(bytes.data(), bytes.size()));
+  EXPECT_EQ(ring.Front(), nullptr);
+  EXPECT_TRUE(ring.Write(bytes.data(), 0));  // Empty writes are accepted
+  EXPECT_EQ(ring.Front(), nullptr);
+}
+
+TEST(TsSlabRingTest, WakeReleasesAnEmptyWait) {
+  TsSlabRing ring(kPacket, 4 * kPacket);
+  std::atomic<bool> woken{false};
+  std::thread consumer([&] {
+    ring.Wait();
+    woken.store(true);
+  });
+  // Again until it returns, in case the first Wake() came before the Wait()
+  while (!woken.load()) {
+    ring.Wake();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  consumer.join();
+  EXPECT_EQ(ring.Front(), nullptr);
+}
+
+// Run under ThreadSanitizer: the producer writes variable-sized bursts
+// while the consumer gathers and pops, with the ring full much of the time
+TEST(TsSlabRingTest, ProducerConsumerStress) {
+  constexpr uint32_t kWrites = 20000;
+  TsSlabRing ring(7 * kPacket, 64 * kPacket);
+  std::vector<uint8_t> written;
+  std::vector<uint8_t> read;
+  written.reserve(kWrites * 4 * kPacket);
+  read.reserve(kWrites * 4 * kPacket);
+
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < kWrites; ++i) {
+      const std::vector<uint8_t> bytes = Packets(1 + i % 12, i);
+      while (!ring.Write(bytes.data(), bytes.size())) {
+        std::this_thread::yield();  // Full: retry until the consumer frees slabs
+      }
+      written.insert(written.end(), bytes.begin(), bytes.end());
+    }
+    ring.Wake();
+  });
+
+  const size_t expected_bytes = [] {
+    size_t total = 0;
+    for (uint32_t i = 0; i < kWrites; ++i) {
+      total += (1 + i % 12) * kPacket;
+    }
+    return total;
+  }();
+  while (read.size() < expected_bytes) {
+    const TsSlabRing::Slab* slabs[16];
+    const size_t count = ring.Peek(slabs, 16);
+    if (count == 0) {
+      ring.Wait();
+      continue;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      read.insert(read.end(), slabs[i]->data, slabs[i]->data + slabs[i]->size);
+    }
+    ring.Pop(count);
+  }
+  producer.join();
+
+  EXPECT_EQ(read, written);
+  EXPECT_EQ(ring.QueuedBytes(), 0u);
+  EXPECT_EQ(ring.BytesConsumed(), expected_bytes);
+}
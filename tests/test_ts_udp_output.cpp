@@ -0,0 +1,521 @@
+// Repository: Retrovue-playout
+// Component: TS UDP Output Unit Tests
+// Purpose: Receives the RTP output on loopback: headers, sequence wrap, FEC and launch times.
+// Copyright (c) 2025 RetroVue
+
+#include "retrovue/playout_sinks/mpegts/TsUdpOutput.hpp"
+#include "timing/TestMasterClock.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using retrovue::playout_sinks::mpegts::TsUdpOutput;
+using retrovue::playout_sinks::mpegts::UdpOutputConfig;
+using retrovue::timing::TestMasterClock;
+
+namespace {
+
+// What the sendmmsg() below saw of each datagram's control messages
+struct SentControl {
+  int64_t launch_ns = -1;  // SCM_TXTIME; -1 = none
+  bool timestamped = false;  // Asked for a transmit timestamp
+};
+
+std::atomic<bool> g_refuse_txtime{false};
+std::atomic<bool> g_record_control{false};
+std::mutex g_control_mutex;
+std::vector<SentControl> g_control;
+
+}  // namespace
+
+// The output's socket calls resolve here first: setsockopt() can refuse
+// SO_TXTIME as a kernel without it would, and sendmmsg() records the
+// launch times it is handed
+extern "C" int setsockopt(int fd, int level, int name, const void* value,
+                          socklen_t length) noexcept {
+  using Real = int (*)(int, int, int, const void*, socklen_t);
+  static const auto real = reinterpret_cast<Real>(dlsym(RTLD_NEXT, "setsockopt"));
+  if (g_refuse_txtime && level == SOL_SOCKET && name == SO_TXTIME) {
+    errno = ENOPROTOOPT;
+    return -1;
+  }
+  return real(fd, level, name, value, length);
+}
+
+extern "C" int sendmmsg(int fd, struct mmsghdr* messages, unsigned int count, int flags) {
+  using Real = int (*)(int, struct mmsghdr*, unsigned int, int);
+  static const auto real = reinterpret_cast<Real>(dlsym(RTLD_NEXT, "sendmmsg"));
+  if (g_record_control) {
+    std::lock_guard<std::mutex> lock(g_control_mutex);
+    for (unsigned int i = 0; i < count; ++i) {
+      SentControl sent;
+      struct msghdr& message = messages[i].msg_hdr;
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TXTIME) {
+          uint64_t launch_ns = 0;
+          std::memcpy(&launch_ns, CMSG_DATA(cmsg), sizeof(launch_ns));
+          sent.launch_ns = static_cast<int64_t>(launch_ns);
+        } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING) {
+          sent.timestamped = true;
+        }
+      }
+      g_control.push_back(sent);
+    }
+  }
+  return real(fd, messages, count, flags);
+}
+
+namespace {
+
+constexpr size_t kPacket = TsUdpOutput::kPacketSize;
+constexpr size_t kRtpHeader = 12;
+constexpr size_t kFecHeader = 16;
+constexpr int64_t kStartUs = 1'000'000'000;
+
+std::shared_ptr<TestMasterClock> Clock(int64_t start_us = kStartUs) {
+  return std::make_shared<TestMasterClock>(start_us, TestMasterClock::Mode::Deterministic);
+}
+
+// count TS packets, each with its own payload bytes
+std::vector<uint8_t> Packets(size_t count, uint8_t seed = 0) {
+  std::vector<uint8_t> ts(count * kPacket);
+  for (size_t i = 0; i < ts.size(); ++i) {
+    ts[i] = static_cast<uint8_t>(seed + i * 7 + i / kPacket);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ts[i * kPacket] = 0x47;
+  }
+  return ts;
+}
+
+uint16_t Be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+uint32_t Be32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Loopback UDP socket that hands back one datagram at a time
+class Receiver {
+ public:
+  // Binds port, or an ephemeral one with 0; port() is 0 if the bind failed
+  explicit Receiver(uint16_t port = 0) {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+      socklen_t length = sizeof(addr);
+      getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &length);
+      port_ = ntohs(addr.sin_port);
+    }
+    const int buffer = 4 * 1024 * 1024;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUFFORCE, &buffer, sizeof(buffer));
+    timeval timeout{0, 20'000};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  ~Receiver() { close(fd_); }
+
+  uint16_t port() const { return port_; }
+
+  // The next datagram, or empty after 20 ms without one
+  std::vector<uint8_t> Read() {
+    std::vector<uint8_t> datagram(kRtpHeader + kFecHeader + 7 * kPacket);
+    const ssize_t n = recv(fd_, datagram.data(), datagram.size(), 0);
+    datagram.resize(n > 0 ? static_cast<size_t>(n) : 0);
+    return datagram;
+  }
+
+  std::vector<std::vector<uint8_t>> ReadAll() {
+    std::vector<std::vector<uint8_t>> datagrams;
+    for (auto datagram = Read(); !datagram.empty(); datagram = Read()) {
+      datagrams.push_back(std::move(datagram));
+    }
+    return datagrams;
+  }
+
+ private:
+  int fd_ = -1;
+  uint16_t port_ = 0;
+};
+
+// Receivers on the media port and the column (+2) and row (+4) FEC ports
+struct FecReceivers {
+  FecReceivers() {
+    for (int attempt = 0; attempt < 20 && column == nullptr; ++attempt) {
+      media = std::make_unique<Receiver>();
+      auto column_port = std::make_unique<Receiver>(media->port() + 2);
+      auto row_port = std::make_unique<Receiver>(media->port() + 4);
+      if (media->port() != 0 && column_port->port() != 0 && row_port->port() != 0) {
+        column = std::move(column_port);
+        row = std::move(row_port);
+      }
+    }
+  }
+
+  std::unique_ptr<Receiver> media;
+  std::unique_ptr<Receiver> column;
+  std::unique_ptr<Receiver> row;
+};
+
+// Records the control messages of every datagram sent in its lifetime
+class ControlRecorder {
+ public:
+  ControlRecorder() {
+    std::lock_guard<std::mutex> lock(g_control_mutex);
+    g_control.clear();
+    g_record_control = true;
+  }
+  ~ControlRecorder() {
+    g_record_control = false;
+    g_refuse_txtime = false;
+  }
+
+  std::vector<SentControl> Sent() {
+    std::lock_guard<std::mutex> lock(g_control_mutex);
+    return g_control;
+  }
+};
+
+int64_t MonotonicNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+UdpOutputConfig RtpConfig(uint16_t port) {
+  UdpOutputConfig config;
+  config.host = "127.0.0.1";
+  config.port = port;
+  config.rtp = true;
+  return config;
+}
+
+// XORs the recovery fields and payloads of the received media packets
+// under fec, whose lost one is missing from media: the lost packet's
+// payload type, timestamp and payload
+struct Recovered {
+  uint8_t payload_type = 0;
+  uint32_t timestamp = 0;
+  std::vector<uint8_t> payload;
+};
+
+Recovered Recover(const std::vector<uint8_t>& fec,
+                  const std::vector<const std::vector<uint8_t>*>& media) {
+  const uint8_t* header = fec.data() + kRtpHeader;
+  uint16_t length = Be16(header + 2);
+  Recovered lost;
+  lost.payload_type = header[4] & 0x7F;
+  lost.timestamp = Be32(header + 8);
+  lost.payload.assign(header + kFecHeader, fec.data() + fec.size());
+  for (const std::vector<uint8_t>* packet : media) {
+    const size_t size = packet->size() - kRtpHeader;
+    length ^= static_cast<uint16_t>(size);
+    lost.payload_type ^= (*packet)[1] & 0x7F;
+    lost.timestamp ^= Be32(packet->data() + 4);
+    for (size_t i = 0; i < size; ++i) {
+      lost.payload[i] ^= (*packet)[kRtpHeader + i];
+    }
+  }
+  lost.payload.resize(length);
+  return lost;
+}
+
+}  // namespace
+
+TEST(TsUdpOutputTest, NumbersAndTimestampsRtpDatagrams) {
+  Receiver receiver;
+  ASSERT_NE(receiver.port(), 0);
+  auto clock = Clock();
+  TsUdpOutput output(RtpConfig(receiver.port()), clock);
+  ASSERT_TRUE(output.Open());
+
+  // Untimed: every datagram of a call carries the clock's time at 90 kHz
+  const auto ts = Packets(7 * 2 + 3);
+  ASSERT_TRUE(output.Send(ts.data(), ts.size()));
+  clock->AdvanceMicroseconds(10'000);
+  ASSERT_TRUE(output.Send(ts.data(), 7 * kPacket));
+
+  // Timed: each datagram takes its first packet's time
+  std::vector<int64_t> times(14);
+  for (size_t i = 0; i < times.size(); ++i) {
+    times[i] = kStartUs + 20'000 + static_cast<int64_t>(i) * 1000;
+  }
+  ASSERT_TRUE(output.Send(ts.data(), times.size() * kPacket, times.data()));
+
+  const auto datagrams = receiver.ReadAll();
+  ASSERT_EQ(datagrams.size(), 6u);
+  const std::vector<size_t> sizes = {7, 7, 3, 7, 7, 7};
+  const std::vector<int64_t> stamps = {kStartUs,          kStartUs,          kStartUs,
+                                       kStartUs + 10'000, kStartUs + 20'000, kStartUs + 27'000};
+  const uint16_t first_seq = Be16(datagrams[0].data() + 2);
+  const uint32_t ssrc = Be32(datagrams[0].data() + 8);
+  for (size_t i = 0; i < datagrams.size(); ++i) {
+    const uint8_t* header = datagrams[i].data();
+    EXPECT_EQ(datagrams[i].size(), kRtpHeader + sizes[i] * kPacket) << i;
+    EXPECT_EQ(header[0], 0x80) << i;  // V=2, no padding, extension or CSRCs
+    EXPECT_EQ(header[1], 33) << i;    // MP2T, no marker
+    EXPECT_EQ(Be16(header + 2), static_cast<uint16_t>(first_seq + i)) << i;
+    EXPECT_EQ(Be32(header + 4), static_cast<uint32_t>(stamps[i] * 9 / 100)) << i;
+    EXPECT_EQ(Be32(header + 8), ssrc) << i;
+    EXPECT_EQ(header[12], 0x47) << i;
+  }
+  EXPECT_EQ(output.GetStats().datagrams_sent, 6u);
+  EXPECT_EQ(output.GetStats().bytes_sent, (7 * 2 + 3 + 7 + 14) * kPacket);
+}
+
+TEST(TsUdpOutputTest, WrapsTheTimestampAt32Bits) {
+  Receiver receiver;
+  ASSERT_NE(receiver.port(), 0);
+  // 2^32 ticks of 90 kHz are about 13.25 hours: start just short of that
+  const int64_t wrap_us = (int64_t{1} << 32) * 100 / 9;
+  TsUdpOutput output(RtpConfig(receiver.port()), Clock(wrap_us - 1000));
+  ASSERT_TRUE(output.Open());
+  const auto ts = Packets(7 * 2);
+  const int64_t times[14] = {wrap_us - 1000, 0, 0, 0, 0, 0, 0, wrap_us + 1000};
+  ASSERT_TRUE(output.Send(ts.data(), ts.size(), times));
+
+  const auto datagrams = receiver.ReadAll();
+  ASSERT_EQ(datagrams.size(), 2u);
+  EXPECT_EQ(Be32(datagrams[0].data() + 4), static_cast<uint32_t>((wrap_us - 1000) * 9 / 100));
+  EXPECT_EQ(Be32(datagrams[1].data() + 4), static_cast<uint32_t>((wrap_us + 1000) * 9 / 100));
+  EXPECT_LT(Be32(datagrams[1].data() + 4), 100u);  // Past the wrap
+}
+
+TEST(TsUdpOutputTest, WrapsTheSequenceNumber) {
+  Receiver receiver;
+  ASSERT_NE(receiver.port(), 0);
+  TsUdpOutput output(RtpConfig(receiver.port()), Clock());
+  ASSERT_TRUE(output.Open());
+
+  // One-packet datagrams, a batch per call, until the random first
+  // sequence number has gone round past 65535
+  const auto ts = Packets(1);
+  std::vector<struct iovec> parts(TsUdpOutput::kMaxBatch);
+  for (struct iovec& part : parts) {
+    part.iov_base = const_cast<uint8_t*>(ts.data());
+    part.iov_len = ts.size();
+  }
+  bool wrapped = false;
+  uint32_t received = 0;
+  int32_t last = -1;
+  for (int call = 0; call < 65536 / 64 + 2 && !wrapped; ++call) {
+    ASSERT_TRUE(output.Send(parts.data(), parts.size()));
+    for (size_t i = 0; i < parts.size(); ++i) {
+      const auto datagram = receiver.Read();
+      ASSERT_EQ(datagram.size(), kRtpHeader + kPacket) << "datagram " << received;
+      const uint16_t seq = Be16(datagram.data() + 2);
+      if (last >= 0) {
+        ASSERT_EQ(seq, static_cast<uint16_t>(last + 1)) << "datagram " << received;
+        wrapped = wrapped || (last == 65535 && seq == 0);
+      }
+      last = seq;
+      received++;
+    }
+  }
+  EXPECT_TRUE(wrapped);
+  EXPECT_EQ(output.GetStats().datagrams_sent, received);
+  EXPECT_EQ(output.GetStats().send_syscalls, received / TsUdpOutput::kMaxBatch);
+}
+
+TEST(TsUdpOutputTest, RejectsFecItCannotSend) {
+  const auto config = [](bool rtp, int columns, int rows) {
+    UdpOutputConfig udp = RtpConfig(5000);
+    udp.rtp = rtp;
+    udp.fec_columns = columns;
+    udp.fec_rows = rows;
+    return udp;
+  };
+  EXPECT_FALSE(TsUdpOutput(config(false, 4, 4), Clock()).Open());  // Needs RTP
+  EXPECT_FALSE(TsUdpOutput(config(true, 21, 4), Clock()).Open());
+  EXPECT_FALSE(TsUdpOutput(config(true, 4, 3), Clock()).Open());
+  EXPECT_FALSE(TsUdpOutput(config(true, 20, 20), Clock()).Open());  // L x D > 100
+  EXPECT_TRUE(TsUdpOutput(config(true, 10, 10), Clock()).Open());
+}
+
+TEST(TsUdpOutputTest, RecoversALostPacketFromColumnOrRowFec) {
+  FecReceivers receivers;
+  ASSERT_NE(receivers.column, nullptr) << "No free port triple";
+  UdpOutputConfig config = RtpConfig(receivers.media->port());
+  config.fec_columns = 4;  // L
+  config.fec_rows = 4;     // D
+  config.fec_row = true;
+  TsUdpOutput output(config, Clock());
+  ASSERT_TRUE(output.Open());
+
+  // One 4x4 matrix: datagram 6 (column 2, row 1) is the short one of its call
+  std::vector<std::vector<uint8_t>> sent;
+  int64_t time_us = kStartUs;
+  for (size_t packets : {7 * 6, 3, 7 * 9}) {
+    const auto ts = Packets(packets, static_cast<uint8_t>(sent.size()));
+    std::vector<int64_t> times(packets);
+    for (int64_t& time : times) {
+      time = time_us += 150;
+    }
+    ASSERT_TRUE(output.Send(ts.data(), ts.size(), times.data()));
+    for (size_t offset = 0; offset < ts.size(); offset += 7 * kPacket) {
+      const size_t size = std::min(ts.size() - offset, 7 * kPacket);
+      sent.emplace_back(ts.begin() + offset, ts.begin() + offset + size);
+    }
+  }
+  ASSERT_EQ(sent.size(), 16u);
+
+  const auto media = receivers.media->ReadAll();
+  const auto columns = receivers.column->ReadAll();
+  const auto rows = receivers.row->ReadAll();
+  ASSERT_EQ(media.size(), 16u);
+  ASSERT_EQ(columns.size(), 4u);
+  ASSERT_EQ(rows.size(), 4u);
+  EXPECT_EQ(output.GetStats().fec_packets_sent, 8u);
+  const uint16_t base = Be16(media[0].data() + 2);
+
+  // Column c protects c, c + L, ...; row r protects r * L .. r * L + L - 1
+  for (size_t c = 0; c < columns.size(); ++c) {
+    const uint8_t* rtp = columns[c].data();
+    const uint8_t* fec = rtp + kRtpHeader;
+    EXPECT_EQ(rtp[1], 96) << c;
+    EXPECT_EQ(Be16(rtp + 2), c) << c;
+    EXPECT_EQ(Be16(fec), static_cast<uint16_t>(base + c)) << c;
+    EXPECT_EQ(fec[4] & 0x80, 0x80) << c;  // E
+    EXPECT_EQ(fec[12], 0x00) << c;         // Column stream, XOR
+    EXPECT_EQ(fec[13], 4) << c;            // Offset: L
+    EXPECT_EQ(fec[14], 4) << c;            // NA: D
+  }
+  for (size_t r = 0; r < rows.size(); ++r) {
+    const uint8_t* fec = rows[r].data() + kRtpHeader;
+    EXPECT_EQ(Be16(rows[r].data() + 2), r) << r;
+    EXPECT_EQ(Be16(fec), static_cast<uint16_t>(base + 4 * r)) << r;
+    EXPECT_EQ(fec[12], 0x40) << r;  // Row stream
+    EXPECT_EQ(fec[13], 1) << r;     // Offset: 1
+    EXPECT_EQ(fec[14], 4) << r;     // NA: L
+  }
+
+  // Lose datagram 6: its column's or its row's FEC rebuilds it
+  constexpr size_t kLost = 6;
+  std::vector<const std::vector<uint8_t>*> column_peers;
+  std::vector<const std::vector<uint8_t>*> row_peers;
+  for (size_t i = 0; i < media.size(); ++i) {
+    if (i != kLost && i % 4 == kLost % 4) {
+      column_peers.push_back(&media[i]);
+    }
+    if (i != kLost && i / 4 == kLost / 4) {
+      row_peers.push_back(&media[i]);
+    }
+  }
+  for (const auto& recovered :
+       {Recover(columns[kLost % 4], column_peers), Recover(rows[kLost / 4], row_peers)}) {
+    EXPECT_EQ(recovered.payload_type, 33);
+    EXPECT_EQ(recovered.timestamp, Be32(media[kLost].data() + 4));
+    ASSERT_EQ(recovered.payload.size(), 3 * kPacket);
+    EXPECT_EQ(recovered.payload, sent[kLost]);
+  }
+}
+
+TEST(TsUdpOutputTest, FallsBackToUserSpacePacingWhenSoTxtimeIsRefused) {
+  Receiver receiver;
+  ASSERT_NE(receiver.port(), 0);
+  ControlRecorder recorder;
+  g_refuse_txtime = true;
+  UdpOutputConfig config = RtpConfig(receiver.port());
+  config.txtime = true;
+  auto clock = Clock();
+  TsUdpOutput output(config, clock);
+
+  // Open() still succeeds, with launch times off: callers check
+  // TxTimeActive() and write on schedule themselves
+  ASSERT_TRUE(output.Open());
+  EXPECT_FALSE(output.TxTimeActive());
+  EXPECT_FALSE(output.GetStats().txtime_active);
+
+  // Timed sends go out at once, without launch times, still stamped with
+  // the packets' times
+  const auto ts = Packets(7 * 3);
+  std::vector<int64_t> times(7 * 3);
+  for (size_t i = 0; i < times.size(); ++i) {
+    times[i] = kStartUs + 5000 + static_cast<int64_t>(i) * 100;
+  }
+  ASSERT_TRUE(output.Send(ts.data(), ts.size(), times.data()));
+  const auto sent = recorder.Sent();
+  ASSERT_EQ(sent.size(), 3u);
+  for (const SentControl& datagram : sent) {
+    EXPECT_EQ(datagram.launch_ns, -1);
+    EXPECT_FALSE(datagram.timestamped);
+  }
+  const auto datagrams = receiver.ReadAll();
+  ASSERT_EQ(datagrams.size(), 3u);
+  for (size_t i = 0; i < datagrams.size(); ++i) {
+    EXPECT_EQ(Be32(datagrams[i].data() + 4), static_cast<uint32_t>(times[7 * i] * 9 / 100));
+  }
+  EXPECT_EQ(output.GetStats().txtime_samples, 0u);
+}
+
+TEST(TsUdpOutputTest, GivesEachDatagramItsFirstPacketsLaunchTime) {
+  Receiver receiver;
+  ASSERT_NE(receiver.port(), 0);
+  ControlRecorder recorder;
+  UdpOutputConfig config = RtpConfig(receiver.port());
+  config.txtime = true;
+  config.txtime_monotonic = true;  // No CAP_NET_ADMIN needed, unlike CLOCK_TAI
+  auto clock = Clock();
+  TsUdpOutput output(config, clock);
+  ASSERT_TRUE(output.Open());
+  ASSERT_TRUE(output.TxTimeActive());
+
+  // 70 datagrams due from 5 ms on, a packet every 100 us and every other
+  // datagram 40 us later still
+  constexpr size_t kDatagrams = 70;
+  const auto ts = Packets(7 * kDatagrams);
+  std::vector<int64_t> times(ts.size() / kPacket);
+  for (size_t i = 0; i < times.size(); ++i) {
+    times[i] = kStartUs + 5000 + static_cast<int64_t>(i) * 100 + (i / 7 % 2) * 40;
+  }
+  const int64_t before_ns = MonotonicNs();
+  output.Send(ts.data(), ts.size(), times.data());
+  const int64_t after_ns = MonotonicNs();
+
+  // The MasterClock is mapped onto CLOCK_MONOTONIC once per Send(): the
+  // launch times keep the packets' spacing exactly
+  const auto sent = recorder.Sent();
+  ASSERT_EQ(sent.size(), kDatagrams);
+  const int64_t first_ns = sent[0].launch_ns;
+  EXPECT_GE(first_ns, before_ns + 5000 * 1000);
+  EXPECT_LE(first_ns, after_ns + 5000 * 1000);
+  for (size_t d = 0; d < kDatagrams; ++d) {
+    EXPECT_EQ(sent[d].launch_ns - first_ns, (times[7 * d] - times[0]) * 1000) << d;
+    // Every kTimestampInterval-th datagram asks for its transmit timestamp
+    EXPECT_EQ(sent[d].timestamped, d % TsUdpOutput::kTimestampInterval == 0) << d;
+  }
+
+  // A later Send() maps the clock afresh: with the MasterClock 1 ms on, a
+  // packet due 1 ms after the first launches with it (give or take the
+  // real time between the two calls)
+  clock->AdvanceMicroseconds(1000);
+  const int64_t again[7] = {times[0] + 1000};
+  output.Send(ts.data(), 7 * kPacket, again);
+  const int64_t resent_ns = MonotonicNs();
+  const auto resent = recorder.Sent();
+  ASSERT_EQ(resent.size(), kDatagrams + 1);
+  EXPECT_GE(resent.back().launch_ns, first_ns);
+  EXPECT_LE(resent.back().launch_ns, first_ns + (resent_ns - before_ns));
+
+  // Untimed sends carry no launch time
+  output.Send(ts.data(), 7 * kPacket);
+  EXPECT_EQ(recorder.Sent().back().launch_ns, -1);
+  EXPECT_EQ(receiver.ReadAll().size(), kDatagrams + 2);
+}
@@ -0,0 +1,376 @@
+// Repository: Retrovue-playout
+// Component: Buffer Benchmarks
+// Purpose: Google Benchmark suite for FrameRingBuffer push/pop, cross-core handoff
+//          latency and index cache-line layout.
+// Copyright (c) 2025 RetroVue
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "retrovue/buffer/FramePool.h"
+#include "retrovue/buffer/FrameRingBuffer.h"
+
+namespace {
+
+using retrovue::buffer::Frame;
+using retrovue::buffer::FrameHandle;
+using retrovue::buffer::FramePool;
+using retrovue::buffer::FrameRingBuffer;
+
+constexpr size_t kRingCapacity = 60;   // Matches the producer default
+constexpr int64_t kBatchFrames = 240;  // Frames per cross-thread iteration
+
+// Core pair for cross-core runs. Pinning is best effort: on hosts with one
+// core (or outside Linux) threads float and results include scheduler noise.
+constexpr int kProducerCore = 0;
+constexpr int kConsumerCore = 1;
+
+void PinToCore(int core) {
+#if defined(__linux__)
+  if (static_cast<unsigned>(core) >= std::thread::hardware_concurrency()) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)core;
+#endif
+}
+
+// Busy-wait step for spin loops. Spinning keeps handoff latency honest on
+// multi-core hosts; yielding periodically stops a single-core host from
+// livelocking while the peer thread is descheduled.
+inline void SpinWait(uint32_t& spins) {
+  if (++spins % 64 == 0) {
+    std::this_thread::yield();
+  }
+}
+
+size_t Yuv420Bytes(int64_t width, int64_t height) {
+  return static_cast<size_t>(width * height * 3 / 2);
+}
+
+Frame MakeFrame(int64_t width, int64_t height) {
+  Frame frame;
+  frame.width = static_cast<int>(width);
+  frame.height = static_cast<int>(height);
+  frame.data.assign(Yuv420Bytes(width, height), 0x80);
+  return frame;
+}
+
+// Acquires a pooled frame sized for width x height, spinning while the
+// consumer still holds every slot.
+FrameHandle AcquireFrame(FramePool& pool, int64_t width, int64_t height) {
+  FrameHandle handle;
+  while (!(handle = pool.Acquire())) {
+    std::this_thread::yield();
+  }
+  handle->width = static_cast<int>(width);
+  handle->height = static_cast<int>(height);
+  handle->data.resize(Yuv420Bytes(width, height));
+  return handle;
+}
+
+void SetFrameCounters(benchmark::State& state, int64_t frames, size_t frame_bytes) {
+  state.SetItemsProcessed(frames);
+  state.SetBytesProcessed(frames * static_cast<int64_t>(frame_bytes));
+}
+
+// 480p (NTSC SD), 720p and 1080p.
+void Resolutions(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"w", "h"});
+  bench->Args({720, 480});
+  bench->Args({1280, 720});
+  bench->Args({1920, 1080});
+}
+
+// ---------------------------------------------------------------------------
+// Single-thread push/pop cost
+// ---------------------------------------------------------------------------
+
+// By-value path: one payload copy in Push(const Frame&); Pop(Frame&) swaps.
+void BM_PushPopCopy(benchmark::State& state) {
+  const Frame frame = MakeFrame(state.range(0), state.range(1));
+  FrameRingBuffer ring(kRingCapacity);
+  Frame popped;
+
+  for (auto _ : state) {
+    ring.Push(frame);
+    ring.Pop(popped);
+    benchmark::DoNotOptimize(popped.data.data());
+  }
+  SetFrameCounters(state, state.iterations(), frame.data.size());
+}
+BENCHMARK(BM_PushPopCopy)->Apply(Resolutions);
+
+// Pooled path: only the handle moves through the ring.
+void BM_PushPopPooled(benchmark::State& state) {
+  const int64_t width = state.range(0);
+  const int64_t height = state.range(1);
+  auto pool = FramePool::Create(kRingCapacity + 2, Yuv420Bytes(width, height));
+  FrameRingBuffer ring(kRingCapacity);
+  FrameHandle popped;
+
+  for (auto _ : state) {
+    ring.Push(AcquireFrame(*pool, width, height));
+    ring.Pop(popped);
+    benchmark::DoNotOptimize(popped.get());
+    popped.Reset();
+  }
+  SetFrameCounters(state, state.iterations(), Yuv420Bytes(width, height));
+}
+BENCHMARK(BM_PushPopPooled)->Apply(Resolutions);
+
+// ---------------------------------------------------------------------------
+// Cross-core throughput: producer and consumer on different cores
+// ---------------------------------------------------------------------------
+
+template <bool kPooled>
+void BM_CrossCoreThroughput(benchmark::State& state) {
+  const int64_t width = state.range(0);
+  const int64_t height = state.range(1);
+  const Frame frame = MakeFrame(width, height);
+  auto pool = FramePool::Create(kRingCapacity + 2, Yuv420Bytes(width, height));
+  FrameRingBuffer ring(kRingCapacity);
+  PinToCore(kConsumerCore);
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      PinToCore(kProducerCore);
+      for (int64_t i = 0; i < kBatchFrames; ++i) {
+        if constexpr (kPooled) {
+          FrameHandle handle = AcquireFrame(*pool, width, height);
+          while (!ring.Push(std::move(handle))) {
+            std::this_thread::yield();
+          }
+        } else {
+          while (!ring.Push(frame)) {
+            std::this_thread::yield();
+          }
+        }
+      }
+    });
+
+    FrameHandle popped_handle;
+    Frame popped_frame;
+    uint32_t spins = 0;
+    for (int64_t received = 0; received < kBatchFrames;) {
+      if constexpr (kPooled) {
+        if (!ring.Pop(popped_handle)) {
+          SpinWait(spins);
+          continue;
+        }
+        benchmark::DoNotOptimize(popped_handle->data.data());
+        popped_handle.Reset();
+      } else {
+        if (!ring.Pop(popped_frame)) {
+          SpinWait(spins);
+          continue;
+        }
+        benchmark::DoNotOptimize(popped_frame.data.data());
+      }
+      ++received;
+    }
+    producer.join();
+  }
+  SetFrameCounters(state, state.iterations() * kBatchFrames, frame.data.size());
+}
+BENCHMARK_TEMPLATE(BM_CrossCoreThroughput, false)->Apply(Resolutions)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CrossCoreThroughput, true)->Apply(Resolutions)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Cross-core latency: one frame ping-pongs between two rings; the reported
+// time per iteration is a full round trip (two handoffs).
+// ---------------------------------------------------------------------------
+
+template <bool kPooled>
+void BM_CrossCoreLatency(benchmark::State& state) {
+  const int64_t width = state.range(0);
+  const int64_t height = state.range(1);
+  FrameRingBuffer ping(kRingCapacity);
+  FrameRingBuffer pong(kRingCapacity);
+  std::atomic<bool> done{false};
+  PinToCore(kProducerCore);
+
+  // Echo thread: bounces whatever arrives on ping back on pong.
+  std::thread echo([&]() {
+    PinToCore(kConsumerCore);
+    FrameHandle handle;
+    Frame frame;
+    uint32_t spins = 0;
+    while (!done.load(std::memory_order_acquire)) {
+      SpinWait(spins);
+      if constexpr (kPooled) {
+        if (ping.Pop(handle)) {
+          while (!pong.Push(std::move(handle))) {
+            SpinWait(spins);
+          }
+        }
+      } else {
+        if (ping.Pop(frame)) {
+          while (!pong.Push(frame)) {
+            SpinWait(spins);
+          }
+        }
+      }
+    }
+  });
+
+  auto pool = FramePool::Create(2, Yuv420Bytes(width, height));
+  FrameHandle handle = AcquireFrame(*pool, width, height);
+  Frame frame = MakeFrame(width, height);
+  uint32_t spins = 0;
+
+  for (auto _ : state) {
+    if constexpr (kPooled) {
+      ping.Push(std::move(handle));
+      while (!pong.Pop(handle)) {
+        SpinWait(spins);
+      }
+    } else {
+      ping.Push(frame);
+      while (!pong.Pop(frame)) {
+        SpinWait(spins);
+      }
+    }
+  }
+
+  done.store(true, std::memory_order_release);
+  echo.join();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_CrossCoreLatency, false)->Apply(Resolutions)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_CrossCoreLatency, true)->Args({1920, 1080})->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Index layout: the same SPSC protocol as FrameRingBuffer over a trivial
+// payload, with the two indices either adjacent (as FrameRingBuffer lays
+// them out today) or on separate cache lines. The gap between the two is the
+// false-sharing cost a layout change in FrameRingBuffer would recover.
+// ---------------------------------------------------------------------------
+
+struct PackedIndices {
+  std::atomic<uint32_t> write_index{0};
+  std::atomic<uint32_t> read_index{0};
+};
+
+struct PaddedIndices {
+  alignas(64) std::atomic<uint32_t> write_index{0};
+  alignas(64) std::atomic<uint32_t> read_index{0};
+};
+
+template <typename Indices>
+class IndexLayoutRing {
+ public:
+  bool Push(uint64_t value) {
+    const uint32_t write = indices_.write_index.load(std::memory_order_relaxed);
+    const uint32_t next = (write + 1) % kSlots;
+    if (next == indices_.read_index.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots_[write] = value;
+    indices_.write_index.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool Pop(uint64_t& value) {
+    const uint32_t read = indices_.read_index.load(std::memory_order_relaxed);
+    if (read == indices_.write_index.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = slots_[read];
+    indices_.read_index.store((read + 1) % kSlots, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr uint32_t kSlots = kRingCapacity + 1;
+  Indices indices_;
+  alignas(64) uint64_t slots_[kSlots] = {};
+};
+
+template <typename Indices>
+void BM_IndexLayout(benchmark::State& state) {
+  constexpr int64_t kOps = 1 << 16;
+  IndexLayoutRing<Indices> ring;
+  PinToCore(kConsumerCore);
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      PinToCore(kProducerCore);
+      uint32_t spins = 0;
+      for (int64_t i = 0; i < kOps; ++i) {
+        while (!ring.Push(static_cast<uint64_t>(i))) {
+          SpinWait(spins);
+        }
+      }
+    });
+
+    uint64_t value = 0;
+    uint32_t spins = 0;
+    for (int64_t received = 0; received < kOps;) {
+      if (ring.Pop(value)) {
+        ++received;
+      } else {
+        SpinWait(spins);
+      }
+    }
+    benchmark::DoNotOptimize(value);
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * kOps);
+}
+BENCHMARK_TEMPLATE(BM_IndexLayout, PackedIndices)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_IndexLayout, PaddedIndices)->UseRealTime();
+
+// The real FrameRingBuffer with metadata-only frames, so index traffic
+// dominates; compare against BM_IndexLayout to track layout changes.
+void BM_FrameRingBufferIndexTraffic(benchmark::State& state) {
+  constexpr int64_t kOps = 1 << 14;
+  FrameRingBuffer ring(kRingCapacity);
+  PinToCore(kConsumerCore);
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      PinToCore(kProducerCore);
+      Frame frame;
+      uint32_t spins = 0;
+      for (int64_t i = 0; i < kOps; ++i) {
+        frame.metadata.pts = i;
+        while (!ring.Push(frame)) {
+          SpinWait(spins);
+        }
+      }
+    });
+
+    Frame popped;
+    uint32_t spins = 0;
+    for (int64_t received = 0; received < kOps;) {
+      if (ring.Pop(popped)) {
+        ++received;
+      } else {
+        SpinWait(spins);
+      }
+    }
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * kOps);
+}
+BENCHMARK(BM_FrameRingBufferIndexTraffic)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,443 @@
+// Repository: Retrovue-playout
+// Component: Pipeline Benchmarks
+// Purpose: Google Benchmark suite for per-codec decode+scale, encode per preset, overlay
+//          compositing, and TS mux and send cost, over a fixed corpus, for comparison
+//          across commits.
+// Copyright (c) 2025 RetroVue
+
+#include <benchmark/benchmark.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "retrovue/buffer/Frame.h"
+#include "retrovue/buffer/FrameRingBuffer.h"
+#include "retrovue/decode/OverlayCompositor.h"
+#include "retrovue/playout_sinks/mpegts/EncoderPipeline.hpp"
+#include "retrovue/playout_sinks/mpegts/EncoderThreadBudget.hpp"
+#include "retrovue/playout_sinks/mpegts/MpegTSPlayoutSinkConfig.hpp"
+#include "retrovue/playout_sinks/mpegts/TSMuxer.h"
+#include "retrovue/playout_sinks/mpegts/TsFanout.hpp"
+#include "retrovue/producers/video_file/VideoFileProducer.h"
+
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+extern "C" {
+#include <libavcodec/version.h>
+}
+#endif
+
+#ifndef RETROVUE_GIT_REVISION
+#define RETROVUE_GIT_REVISION "unknown"
+#endif
+
+namespace {
+
+using retrovue::buffer::Frame;
+using retrovue::buffer::FrameRingBuffer;
+using retrovue::decode::OverlayCompositor;
+using retrovue::decode::OverlayImage;
+using retrovue::decode::OverlaySet;
+using retrovue::playout_sinks::mpegts::EncoderPipeline;
+using retrovue::playout_sinks::mpegts::EncoderThreadBudget;
+using retrovue::playout_sinks::mpegts::MpegTSPlayoutSinkConfig;
+using retrovue::playout_sinks::mpegts::MuxerConfig;
+using retrovue::playout_sinks::mpegts::TSMuxer;
+using retrovue::playout_sinks::mpegts::TsFanout;
+using retrovue::playout_sinks::mpegts::TsStream;
+using retrovue::playout_sinks::mpegts::VideoCodec;
+using retrovue::producers::video_file::VideoFileProducer;
+
+constexpr int kFps = 30;
+constexpr int64_t kFrame90k = 90000 / kFps;
+constexpr int kGopFrames = kFps;
+constexpr size_t kDecodeRingFrames = 8;
+constexpr auto kDecodeTimeout = std::chrono::seconds(120);
+
+// The corpus sizes: NTSC SD, 1080p HD and UHD 4K. Files are
+// <codec>_<size>.ts, 10 s at 30 fps (scripts/generate_bench_corpus.sh).
+struct Resolution {
+  const char* name;
+  int width;
+  int height;
+  int bitrate;       // Encode target, and a typical coded frame size for mux runs
+};
+
+constexpr std::array<Resolution, 3> kResolutions = {{
+    {"sd", 720, 480, 2'500'000},
+    {"hd", 1920, 1080, 8'000'000},
+    {"4k", 3840, 2160, 25'000'000},
+}};
+
+constexpr std::array<const char*, 3> kCorpusCodecs = {"h264", "hevc", "mpeg2"};
+constexpr std::array<const char*, 3> kPresets = {"ultrafast", "veryfast", "medium"};
+
+std::filesystem::path CorpusDir() {
+  const char* dir = std::getenv("RETROVUE_BENCH_CORPUS");
+  return dir && *dir ? dir : "bench_corpus";
+}
+
+// Deterministic YUV420 pictures with motion and texture, so encoders do
+// real work: a diagonal gradient that moves each frame, over noise.
+std::vector<Frame> MakeSourceFrames(const Resolution& resolution, int count) {
+  std::vector<Frame> frames(static_cast<size_t>(count));
+  uint32_t seed = 0x2545F491;
+  for (int i = 0; i < count; ++i) {
+    Frame& frame = frames[static_cast<size_t>(i)];
+    frame.width = resolution.width;
+    frame.height = resolution.height;
+    frame.metadata.duration = 1.0 / kFps;
+    const size_t luma = static_cast<size_t>(resolution.width) * resolution.height;
+    frame.data.resize(luma * 3 / 2);
+    for (int y = 0; y < resolution.height; ++y) {
+      uint8_t* row = frame.data.data() + static_cast<size_t>(y) * resolution.width;
+      for (int x = 0; x < resolution.width; ++x) {
+        seed = seed * 1664525u + 1013904223u;
+        row[x] = static_cast<uint8_t>(((x + y + i * 8) & 0xFF) / 2 + (seed >> 27));
+      }
+    }
+    for (size_t c = luma; c < frame.data.size(); ++c) {
+      frame.data[c] = static_cast<uint8_t>(128 + ((c + static_cast<size_t>(i)) & 0x0F));
+    }
+  }
+  return frames;
+}
+
+struct ByteCounter {
+  uint64_t bytes = 0;
+};
+
+int CountBytes(void* opaque, uint8_t* /*buf*/, int buf_size) {
+  static_cast<ByteCounter*>(opaque)->bytes += static_cast<uint64_t>(buf_size);
+  return buf_size;
+}
+
+// ---------------------------------------------------------------------------
+// Decode + scale: VideoFileProducer over a corpus file, unpaced
+// ---------------------------------------------------------------------------
+
+// Decodes the whole file per iteration and scales it to 1080p (the channel
+// default), so SD and 4K include an upscale and downscale. The benchmark
+// thread drains the ring as a renderer would.
+void BM_DecodeScale(benchmark::State& state, std::string codec, Resolution resolution) {
+#ifndef RETROVUE_FFMPEG_AVAILABLE
+  state.SkipWithError("built without FFmpeg");
+  return;
+#endif
+  const std::filesystem::path path =
+      CorpusDir() / (codec + "_" + resolution.name + ".ts");
+  if (!std::filesystem::exists(path)) {
+    state.SkipWithError(("missing corpus file " + path.string()).c_str());
+    return;
+  }
+
+  uint64_t frames = 0;
+  for (auto _ : state) {
+    retrovue::producers::video_file::ProducerConfig config;
+    config.asset_uri = path.string();
+    config.target_width = 1920;
+    config.target_height = 1080;
+    config.target_fps = kFps;
+    config.audio_enabled = false;
+    config.keyframe_index_enabled = false;
+    config.trace_sample_interval = 0;
+
+    FrameRingBuffer ring(kDecodeRingFrames);
+    std::atomic<bool> finished{false};
+    VideoFileProducer producer(config, ring, nullptr,
+                               [&finished](const std::string& event, const std::string&) {
+                                 if (event == "decode_loop_exited") {
+                                   finished.store(true, std::memory_order_release);
+                                 }
+                               });
+    if (!producer.start()) {
+      state.SkipWithError("producer failed to start");
+      return;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    Frame frame;
+    uint64_t popped = 0;
+    while (!finished.load(std::memory_order_acquire) || !ring.IsEmpty()) {
+      if (ring.Pop(frame)) {
+        ++popped;
+        benchmark::DoNotOptimize(frame.data.data());
+      } else {
+        ring.WaitForFrame(std::chrono::steady_clock::now() + std::chrono::milliseconds(5));
+      }
+      if (std::chrono::steady_clock::now() - started > kDecodeTimeout) {
+        break;
+      }
+    }
+    producer.stop();
+    if (producer.GetDecodeErrors() > 0 || popped == 0) {
+      state.SkipWithError("decode failed");
+      return;
+    }
+    frames += popped;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(frames));
+  state.counters["fps"] = benchmark::Counter(static_cast<double>(frames), benchmark::Counter::kIsRate);
+  state.SetLabel(path.filename().string());
+}
+
+// ---------------------------------------------------------------------------
+// Encode: EncoderPipeline per codec and software preset
+// ---------------------------------------------------------------------------
+
+// The process's software encoder threads, shared by every encode run as
+// by the channels of a playout process.
+std::shared_ptr<EncoderThreadBudget> EncoderThreads() {
+  static const auto budget = std::make_shared<EncoderThreadBudget>();
+  return budget;
+}
+
+// One frame per iteration through the encoder and its muxer (output
+// discarded), at the resolution's bitrate with a 1 s GOP, no audio and no
+// filler clip, on the threads the shared budget gives it.
+void BM_Encode(benchmark::State& state, VideoCodec codec, std::string preset,
+               Resolution resolution) {
+#ifndef RETROVUE_FFMPEG_AVAILABLE
+  state.SkipWithError("built without FFmpeg");
+  return;
+#endif
+  MpegTSPlayoutSinkConfig config;
+  config.video_codec = codec;
+  config.encoder_preset = preset;
+  config.target_fps = kFps;
+  config.gop_size = kGopFrames;
+  config.bitrate = resolution.bitrate;
+  config.underflow_policy = retrovue::playout_sinks::mpegts::UnderflowPolicy::SKIP;
+  config.encoder_threads = EncoderThreads();
+
+  const std::vector<Frame> source = MakeSourceFrames(resolution, 8);
+  ByteCounter output;
+  EncoderPipeline pipeline(config);
+  if (!pipeline.open(config, &output, &CountBytes)) {
+    state.SkipWithError("encoder failed to open");
+    return;
+  }
+  // The encoder opens on the first frame
+  int64_t pts90k = 0;
+  if (!pipeline.encodeFrame(source[0], pts90k)) {
+    state.SkipWithError("encoder unavailable");
+    pipeline.close();
+    return;
+  }
+
+  size_t next = 1;
+  for (auto _ : state) {
+    pts90k += kFrame90k;
+    if (!pipeline.encodeFrame(source[next], pts90k)) {
+      state.SkipWithError("encode failed");
+      break;
+    }
+    next = (next + 1) % source.size();
+  }
+  pipeline.close();
+  state.SetItemsProcessed(state.iterations());
+  state.counters["fps"] =
+      benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+  state.counters["output_bps"] = benchmark::Counter(
+      static_cast<double>(output.bytes) * 8.0 * kFps /
+          static_cast<double>(std::max<int64_t>(state.iterations() + 1, 1)));
+}
+
+// ---------------------------------------------------------------------------
+// Mux: TSMuxer packaging coded frames, no encode
+// ---------------------------------------------------------------------------
+
+// Coded-frame stand-ins sized for the resolution's bitrate: a GOP of one
+// IDR at 8x the size of each P-frame, as Annex B with an AUD.
+std::vector<std::vector<uint8_t>> MakeAccessUnits(const Resolution& resolution) {
+  const size_t gop_bytes = static_cast<size_t>(resolution.bitrate / 8);
+  const size_t p_bytes = gop_bytes / (kGopFrames - 1 + 8);
+  std::vector<std::vector<uint8_t>> units(kGopFrames);
+  for (int i = 0; i < kGopFrames; ++i) {
+    std::vector<uint8_t>& unit = units[static_cast<size_t>(i)];
+    unit.assign(i == 0 ? p_bytes * 8 : p_bytes, static_cast<uint8_t>(0x5A + i));
+    const uint8_t nal = i == 0 ? 0x65 : 0x41;  // IDR slice, non-IDR slice
+    const uint8_t header[] = {0, 0, 0, 1, 0x09, 0xF0, 0, 0, 0, 1, nal};
+    std::copy(std::begin(header), std::end(header), unit.begin());
+  }
+  return units;
+}
+
+// One frame per iteration, PCR and PSI included; bytes are the TS output.
+void BM_Mux(benchmark::State& state, Resolution resolution) {
+  const std::vector<std::vector<uint8_t>> units = MakeAccessUnits(resolution);
+  ByteCounter output;
+  TSMuxer muxer;
+  if (!muxer.Initialize(MuxerConfig{}, &output, &CountBytes)) {
+    state.SkipWithError("muxer failed to initialize");
+    return;
+  }
+  int64_t pts90k = 0;
+  size_t next = 0;
+  for (auto _ : state) {
+    const std::vector<uint8_t>& unit = units[next];
+    muxer.MuxFrame(TsStream::kVideo, unit.data(), unit.size(), pts90k, pts90k, next == 0);
+    pts90k += kFrame90k;
+    next = (next + 1) % units.size();
+  }
+  muxer.Flush();
+  muxer.Cleanup();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(output.bytes));
+}
+
+// ---------------------------------------------------------------------------
+// Overlay: OverlayCompositor blending a station bug
+// ---------------------------------------------------------------------------
+
+// One frame per iteration: a 320x120 bug with a soft edge in the
+// lower-right corner, as a channel airs it.
+void BM_Overlay(benchmark::State& state, Resolution resolution) {
+  constexpr int kBugWidth = 320;
+  constexpr int kBugHeight = 120;
+  std::vector<uint8_t> rgba(static_cast<size_t>(kBugWidth) * kBugHeight * 4);
+  for (int y = 0; y < kBugHeight; ++y) {
+    for (int x = 0; x < kBugWidth; ++x) {
+      uint8_t* px = rgba.data() + (static_cast<size_t>(y) * kBugWidth + x) * 4;
+      const uint8_t alpha = static_cast<uint8_t>(std::min({x, y, 32}) * 6);
+      px[0] = px[1] = px[2] = static_cast<uint8_t>(alpha * 15 / 16);
+      px[3] = alpha;
+    }
+  }
+  auto image = std::make_shared<OverlayImage>();
+  retrovue::decode::OverlayFromPremultipliedRgba(rgba.data(), kBugWidth * 4, kBugWidth,
+                                                 kBugHeight, image.get());
+  OverlayCompositor compositor;
+  compositor.AddSet(OverlaySet{
+      "bug",
+      {{image, resolution.width - kBugWidth - 64, resolution.height - kBugHeight - 48}}});
+  compositor.Schedule(0, "bug");
+  const std::shared_ptr<const OverlaySet> set = compositor.ActiveAt(1);
+
+  std::vector<Frame> frames = MakeSourceFrames(resolution, 1);
+  for (auto _ : state) {
+    compositor.Composite(*set, &frames[0]);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// ---------------------------------------------------------------------------
+// Send: TsFanout to local socket clients
+// ---------------------------------------------------------------------------
+
+constexpr size_t kSendChunkBytes = 7 * 188 * 16;  // A typical muxer write
+constexpr int kSendChunksPerIteration = 256;
+
+// Publishes a batch of chunks per iteration and waits until every client's
+// sender has written them, so the time covers the copy, the queueing and
+// the send syscalls. Reader threads drain the peer sockets.
+void BM_Send(benchmark::State& state) {
+  const size_t clients = static_cast<size_t>(state.range(0));
+  TsFanout fanout(clients, 64 * 1024 * 1024,
+                  retrovue::playout_sinks::mpegts::SlowClientPolicy::EVICT);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < clients; ++i) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      state.SkipWithError("socketpair failed");
+      return;
+    }
+    fanout.AddSubscriber(fds[0], "bench" + std::to_string(i));
+    readers.emplace_back([fd = fds[1]]() {
+      std::vector<uint8_t> sink(256 * 1024);
+      while (read(fd, sink.data(), sink.size()) > 0) {
+      }
+      close(fd);
+    });
+  }
+
+  std::vector<uint8_t> chunk(kSendChunkBytes, 0xFF);
+  for (size_t offset = 0; offset < chunk.size(); offset += 188) {
+    chunk[offset] = 0x47;
+    chunk[offset + 1] = 0x1F;  // Null PID
+  }
+  // Subscribers join at a PAT
+  chunk[1] = 0x40;
+  chunk[2] = 0x00;
+  uint64_t expected = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kSendChunksPerIteration; ++i) {
+      fanout.Publish(chunk.data(), chunk.size());
+    }
+    expected += static_cast<uint64_t>(kSendChunksPerIteration) * chunk.size() * clients;
+    while (fanout.GetStats().bytes_sent < expected) {
+      std::this_thread::yield();
+    }
+  }
+  const auto stats = fanout.GetStats();
+  fanout.CloseAll(nullptr, 0, 1000);
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(stats.bytes_sent));
+  state.counters["syscalls_per_mb"] = benchmark::Counter(
+      stats.bytes_sent > 0 ? static_cast<double>(stats.send_syscalls) * 1e6 /
+                                 static_cast<double>(stats.bytes_sent)
+                           : 0.0);
+}
+BENCHMARK(BM_Send)->ArgName("clients")->Arg(1)->Arg(4)->UseRealTime();
+
+void RegisterPipelineBenchmarks() {
+  for (const Resolution& resolution : kResolutions) {
+    for (const char* codec : kCorpusCodecs) {
+      benchmark::RegisterBenchmark(
+          (std::string("BM_DecodeScale/") + codec + "_" + resolution.name).c_str(),
+          BM_DecodeScale, std::string(codec), resolution)
+          ->Unit(benchmark::kMillisecond)
+          ->UseRealTime();
+    }
+    for (const VideoCodec codec : {VideoCodec::H264, VideoCodec::HEVC}) {
+      for (const char* preset : kPresets) {
+        benchmark::RegisterBenchmark(
+            (std::string("BM_Encode/") + (codec == VideoCodec::H264 ? "h264" : "hevc") + "_" +
+             preset + "_" + resolution.name)
+                .c_str(),
+            BM_Encode, codec, std::string(preset), resolution)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+      }
+    }
+    benchmark::RegisterBenchmark((std::string("BM_Mux/") + resolution.name).c_str(), BM_Mux,
+                                 resolution);
+    benchmark::RegisterBenchmark((std::string("BM_Overlay/") + resolution.name).c_str(),
+                                 BM_Overlay, resolution)
+        ->Unit(benchmark::kMicrosecond);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  // Carried in the JSON context so results can be matched to a build
+  benchmark::AddCustomContext("retrovue_revision", RETROVUE_GIT_REVISION);
+  benchmark::AddCustomContext("corpus", CorpusDir().string());
+#ifdef RETROVUE_FFMPEG_AVAILABLE
+  benchmark::AddCustomContext("libavcodec", LIBAVCODEC_IDENT);
+#endif
+  RegisterPipelineBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -2,35 +2,69 @@
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <ctime>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <numeric>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
-#include "retrovue/buffer/FrameRingBuffer.h"
-#include "retrovue/decode/FrameProducer.h"
-#include "retrovue/renderer/FrameRenderer.h"
+#include "retrovue/runtime/ChannelPlacement.h"
+#include "retrovue/runtime/PlayoutEngine.h"
+#include "retrovue/runtime/TaskExecutor.h"
+#include "retrovue/telemetry/HdrHistogram.h"
 #include "retrovue/telemetry/MetricsExporter.h"
-#include "playout_service.h"
+#include "retrovue/timing/DeadlineScheduler.h"
 #include "retrovue/timing/MasterClock.h"
 
+// timing_soak: multi-channel capacity harness.
+//
+// Starts N channels, each through its own PlayoutEngine and MasterClock as
+// the playout process runs them (stub frames unless --asset names a real
+// file), lets them settle, then records every rendered frame's
+// pacing error (render start vs. MasterClock deadline) and latency (ring
+// push to render done) as HDR histograms, with the CPU time of each
+// channel's pacing threads and of the whole process. With --ramp-step the
+// channel count grows stage by stage until a stage misses the SLO, which
+// answers "how many channels does this host sustain at p99.9 < X ms".
+//
+// Every stage is printed; --report writes the full result as JSON.
+
 namespace
 {
   constexpr int kDefaultDurationSeconds = 300;
-  constexpr double kMaxGapP95Ms = 6.0;
-  constexpr double kMaxCorrectionsPerSec = 1.0;
-  constexpr int kWindowSeconds = 60;
+  constexpr int kDefaultWarmupSeconds = 5;
+  constexpr double kDefaultSloP999Ms = 2.0;
+  constexpr double kNominalFps = 30.0;           // PlayoutEngine channels render at 30 fps
+  constexpr double kMinFrameRatio = 0.98;        // Share of nominal frames a passing channel renders
+  constexpr int kProgressIntervalSeconds = 10;
+  constexpr int32_t kDefaultChannelBase = 9001;
+  // A channel's schedule starts this far after its producer, so the ring
+  // holds a few frames of lead as in steady-state playout
+  constexpr int64_t kScheduleLeadUs = 150'000;
 
   struct ParsedArgs
   {
-    int32_t channel_id = 9001;
+    int32_t channel_base = kDefaultChannelBase;
+    int channels = 1;
+    int ramp_step = 0;                  // 0 = one stage of `channels`
     std::string asset_uri = "timing://soak/default";
     int duration_seconds = kDefaultDurationSeconds;
+    int warmup_seconds = kDefaultWarmupSeconds;
     double cpu_load = 0.0;
     int metrics_port = 0;
+    int timer_threads = 2;
+    int executor_threads = 0;           // 0 = a thread per component, -1 = one per core
+    bool numa_pack = false;             // Spread channels round-robin over NUMA nodes
+    int pacing_priority = 0;            // SCHED_FIFO priority of render threads
+    int buffer_latency_ms = 0;          // Channel buffer depth as time (0 = engine default)
+    double slo_p999_ms = kDefaultSloP999Ms;
+    std::string report_path;
   };
 
   ParsedArgs ParseArgs(int argc, char **argv)
@@ -41,7 +75,15 @@ namespace
       const std::string_view arg(argv[i]);
       if (arg == "--channel-id" && i + 1 < argc)
       {
-        args.channel_id = std::stoi(argv[++i]);
+        args.channel_base = std::stoi(argv[++i]);
+      }
+      else if (arg == "--channels" && i + 1 < argc)
+      {
+        args.channels = std::max(1, std::stoi(argv[++i]));
+      }
+      else if (arg == "--ramp-step" && i + 1 < argc)
+      {
+        args.ramp_step = std::max(0, std::stoi(argv[++i]));
       }
       else if (arg == "--asset" && i + 1 < argc)
       {
@@ -49,7 +91,11 @@ namespace
       }
       else if (arg == "--duration-seconds" && i + 1 < argc)
       {
-        args.duration_seconds = std::stoi(argv[++i]);
+        args.duration_seconds = std::max(1, std::stoi(argv[++i]));
+      }
+      else if (arg == "--warmup-seconds" && i + 1 < argc)
+      {
+        args.warmup_seconds = std::max(0, std::stoi(argv[++i]));
       }
       else if (arg == "--cpu-load" && i + 1 < argc)
       {
@@ -59,30 +105,59 @@ namespace
       {
         args.metrics_port = std::stoi(argv[++i]);
       }
+      else if (arg == "--timer-threads" && i + 1 < argc)
+      {
+        args.timer_threads = std::max(0, std::stoi(argv[++i]));
+      }
+      else if (arg == "--executor-threads" && i + 1 < argc)
+      {
+        args.executor_threads = std::max(-1, std::stoi(argv[++i]));
+      }
+      else if (arg == "--numa-pack")
+      {
+        args.numa_pack = true;
+      }
+      else if (arg == "--pacing-priority" && i + 1 < argc)
+      {
+        args.pacing_priority = std::max(0, std::stoi(argv[++i]));
+      }
+      else if (arg == "--buffer-latency-ms" && i + 1 < argc)
+      {
+        args.buffer_latency_ms = std::max(0, std::stoi(argv[++i]));
+      }
+      else if (arg == "--slo-p999-ms" && i + 1 < argc)
+      {
+        args.slo_p999_ms = std::stod(argv[++i]);
+      }
+      else if (arg == "--report" && i + 1 < argc)
+      {
+        args.report_path = argv[++i];
+      }
+      else if (arg == "--help" || arg == "-h")
+      {
+        std::cout << "Usage: timing_soak [OPTIONS]\n\n"
+                  << "  --channels N           Channels to run (ramp: the most to try; default 1)\n"
+                  << "  --ramp-step K          Run stages of K, 2K, ... channels until one fails\n"
+                  << "  --asset URI            Asset each channel plays (default: stub frames)\n"
+                  << "  --duration-seconds S   Measured time per stage (default 300)\n"
+                  << "  --warmup-seconds S     Unmeasured settle time per stage (default 5)\n"
+                  << "  --slo-p999-ms MS       Pacing error p99.9 a stage must stay under (default 2)\n"
+                  << "  --cpu-load PCT         Background CPU stressor (default 0)\n"
+                  << "  --timer-threads N      Shared deadline scheduler threads (default 2)\n"
+                  << "  --executor-threads N   Run components as tasks on N shared workers\n"
+                  << "                         (-1 = one per core; default 0 = thread each)\n"
+                  << "  --numa-pack            Pin channels round-robin to NUMA nodes\n"
+                  << "  --pacing-priority P    SCHED_FIFO priority of render threads (default 0)\n"
+                  << "  --buffer-latency-ms MS Channel buffer depth as time (default: engine's)\n"
+                  << "  --channel-id ID        First channel id (default 9001)\n"
+                  << "  --metrics-port PORT    Serve Prometheus metrics while soaking\n"
+                  << "  --report PATH          Write the results as JSON\n";
+        std::exit(EXIT_SUCCESS);
+      }
     }
     return args;
   }
 
-  double Mean(const std::vector<double> &values)
-  {
-    if (values.empty())
-      return 0.0;
-    return std::accumulate(values.begin(), values.end(), 0.0) /
-           static_cast<double>(values.size());
-  }
-
-  double P95(std::vector<double> values)
-  {
-    if (values.empty())
-      return 0.0;
-    std::sort(values.begin(), values.end());
-    const double rank = 0.95 * static_cast<double>(values.size() - 1);
-    const auto lo = static_cast<size_t>(std::floor(rank));
-    const auto hi = static_cast<size_t>(std::ceil(rank));
-    const double fraction = rank - static_cast<double>(lo);
-    return values[lo] + (values[hi] - values[lo]) * fraction;
-  }
-
   void SpinCpu(double load_percent)
   {
     if (load_percent <= 0.0)
@@ -106,6 +181,209 @@ namespace
     }
   }
 
+  double ProcessCpuSeconds()
+  {
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+  }
+
+  // Percentile summary of a histogram of microseconds, in milliseconds.
+  struct Distribution
+  {
+    uint64_t count = 0;
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double p999_ms = 0.0;
+    double max_ms = 0.0;
+  };
+
+  Distribution Summarize(const retrovue::telemetry::HdrHistogram &histogram)
+  {
+    Distribution d;
+    d.count = histogram.Count();
+    d.mean_ms = histogram.Mean() / 1'000.0;
+    d.p50_ms = static_cast<double>(histogram.ValueAtPercentile(50.0)) / 1'000.0;
+    d.p90_ms = static_cast<double>(histogram.ValueAtPercentile(90.0)) / 1'000.0;
+    d.p99_ms = static_cast<double>(histogram.ValueAtPercentile(99.0)) / 1'000.0;
+    d.p999_ms = static_cast<double>(histogram.ValueAtPercentile(99.9)) / 1'000.0;
+    d.max_ms = static_cast<double>(histogram.Max()) / 1'000.0;
+    return d;
+  }
+
+  struct ChannelResult
+  {
+    int32_t channel_id = 0;
+    double frame_ratio = 0.0;          // Rendered frames / nominal frames
+    Distribution pacing;
+    Distribution latency;
+    double pacing_cpu_percent = 0.0;   // Producer + renderer threads, % of one core
+  };
+
+  struct StageResult
+  {
+    int channels = 0;
+    bool started = true;
+    bool pass = false;
+    Distribution pacing;
+    Distribution latency;
+    double process_cpu_percent = 0.0;  // Whole process, % of one core
+    double min_frame_ratio = 0.0;
+    std::vector<ChannelResult> detail;
+  };
+
+  void WriteDistribution(std::ostream &out, const char *name, const Distribution &d)
+  {
+    out << "\"" << name << "\":{\"count\":" << d.count << ",\"mean_ms\":" << d.mean_ms
+        << ",\"p50_ms\":" << d.p50_ms << ",\"p90_ms\":" << d.p90_ms << ",\"p99_ms\":" << d.p99_ms
+        << ",\"p999_ms\":" << d.p999_ms << ",\"max_ms\":" << d.max_ms << "}";
+  }
+
+  std::string JsonString(const std::string &value)
+  {
+    std::string quoted = "\"";
+    for (const char c : value)
+    {
+      if (c == '"' || c == '\\')
+      {
+        quoted += '\\';
+      }
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  void WriteReport(std::ostream &out, const ParsedArgs &args,
+                   const std::vector<StageResult> &stages, int max_sustained)
+  {
+    out << std::setprecision(6);
+    out << "{\"tool\":\"timing_soak\",\"asset\":" << JsonString(args.asset_uri)
+        << ",\"duration_seconds\":" << args.duration_seconds
+        << ",\"warmup_seconds\":" << args.warmup_seconds
+        << ",\"slo_pacing_p999_ms\":" << args.slo_p999_ms
+        << ",\"cpu_load_percent\":" << args.cpu_load
+        << ",\"timer_threads\":" << args.timer_threads
+        << ",\"executor_threads\":" << args.executor_threads
+        << ",\"numa_pack\":" << (args.numa_pack ? "true" : "false")
+        << ",\"pacing_priority\":" << args.pacing_priority
+        << ",\"buffer_latency_ms\":" << args.buffer_latency_ms
+        << ",\"hardware_threads\":" << std::thread::hardware_concurrency()
+        << ",\"max_sustained_channels\":" << max_sustained << ",\"stages\":[";
+    for (size_t s = 0; s < stages.size(); ++s)
+    {
+      const StageResult &stage = stages[s];
+      out << (s ? "," : "") << "{\"channels\":" << stage.channels
+          << ",\"started\":" << (stage.started ? "true" : "false")
+          << ",\"pass\":" << (stage.pass ? "true" : "false") << ",";
+      WriteDistribution(out, "pacing_error", stage.pacing);
+      out << ",";
+      WriteDistribution(out, "latency", stage.latency);
+      out << ",\"process_cpu_percent\":" << stage.process_cpu_percent
+          << ",\"min_frame_ratio\":" << stage.min_frame_ratio << ",\"channel_detail\":[";
+      for (size_t c = 0; c < stage.detail.size(); ++c)
+      {
+        const ChannelResult &channel = stage.detail[c];
+        out << (c ? "," : "") << "{\"channel_id\":" << channel.channel_id
+            << ",\"frame_ratio\":" << channel.frame_ratio
+            << ",\"pacing_cpu_percent\":" << channel.pacing_cpu_percent << ",";
+        WriteDistribution(out, "pacing_error", channel.pacing);
+        out << ",";
+        WriteDistribution(out, "latency", channel.latency);
+        out << "}";
+      }
+      out << "]}";
+    }
+    out << "]}\n";
+  }
+
+  // One channel: its clock epoch is its own start time.
+  struct SoakChannel
+  {
+    int32_t id = 0;
+    std::unique_ptr<retrovue::runtime::PlayoutEngine> engine;
+  };
+
+  // Snapshot of every running channel at the start of a measurement.
+  struct Baseline
+  {
+    std::vector<retrovue::runtime::ChannelTimingReport> channels;
+    double process_cpu_s = 0.0;
+    std::chrono::steady_clock::time_point at;
+  };
+
+  Baseline TakeBaseline(const std::vector<SoakChannel> &channels)
+  {
+    Baseline baseline;
+    for (const SoakChannel &channel : channels)
+    {
+      retrovue::runtime::ChannelTimingReport report;
+      channel.engine->GetChannelTiming(channel.id, report);
+      baseline.channels.push_back(std::move(report));
+    }
+    baseline.process_cpu_s = ProcessCpuSeconds();
+    baseline.at = std::chrono::steady_clock::now();
+    return baseline;
+  }
+
+  StageResult Measure(const std::vector<SoakChannel> &channels, const Baseline &baseline,
+                      double slo_p999_ms)
+  {
+    StageResult stage;
+    stage.channels = static_cast<int>(channels.size());
+    const double elapsed_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - baseline.at).count();
+    stage.process_cpu_percent =
+        elapsed_s > 0.0 ? (ProcessCpuSeconds() - baseline.process_cpu_s) / elapsed_s * 100.0 : 0.0;
+
+    retrovue::telemetry::HdrHistogram pacing;
+    retrovue::telemetry::HdrHistogram latency;
+    stage.min_frame_ratio = channels.empty() ? 0.0 : 1e9;
+    for (size_t i = 0; i < channels.size(); ++i)
+    {
+      retrovue::runtime::ChannelTimingReport now;
+      if (!channels[i].engine->GetChannelTiming(channels[i].id, now))
+      {
+        stage.min_frame_ratio = 0.0;
+        continue;
+      }
+      const auto &before = baseline.channels[i];
+      now.render.pacing_error_us.Subtract(before.render.pacing_error_us);
+      now.render.latency_us.Subtract(before.render.latency_us);
+      pacing.Add(now.render.pacing_error_us);
+      latency.Add(now.render.latency_us);
+
+      ChannelResult channel;
+      channel.channel_id = channels[i].id;
+      channel.pacing = Summarize(now.render.pacing_error_us);
+      channel.latency = Summarize(now.render.latency_us);
+      channel.frame_ratio =
+          static_cast<double>(now.render.latency_us.Count()) / (elapsed_s * kNominalFps);
+      const uint64_t cpu_ns = (now.render.render_cpu_ns - before.render.render_cpu_ns) +
+                              (now.producer_cpu_ns - before.producer_cpu_ns);
+      channel.pacing_cpu_percent =
+          elapsed_s > 0.0 ? static_cast<double>(cpu_ns) / 1e9 / elapsed_s * 100.0 : 0.0;
+      stage.min_frame_ratio = std::min(stage.min_frame_ratio, channel.frame_ratio);
+      stage.detail.push_back(channel);
+    }
+    stage.pacing = Summarize(pacing);
+    stage.latency = Summarize(latency);
+    stage.pass = stage.pacing.count > 0 && stage.pacing.p999_ms < slo_p999_ms &&
+                 stage.min_frame_ratio >= kMinFrameRatio;
+    return stage;
+  }
+
+  void PrintStage(const StageResult &stage)
+  {
+    std::cout << "[timing_soak] channels=" << stage.channels
+              << " pacing_p99_ms=" << stage.pacing.p99_ms
+              << " pacing_p999_ms=" << stage.pacing.p999_ms
+              << " pacing_max_ms=" << stage.pacing.max_ms
+              << " latency_p99_ms=" << stage.latency.p99_ms
+              << " process_cpu_pct=" << stage.process_cpu_percent
+              << " min_frame_ratio=" << stage.min_frame_ratio
+              << (stage.pass ? " PASS" : " FAIL") << std::endl;
+  }
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -113,13 +391,33 @@ int main(int argc, char **argv)
   using namespace retrovue;
   const ParsedArgs args = ParseArgs(argc, argv);
   auto metrics = std::make_shared<telemetry::MetricsExporter>(args.metrics_port);
-  const auto epoch_us = std::chrono::duration_cast<std::chrono::microseconds>(
-                            std::chrono::system_clock::now().time_since_epoch())
-                            .count();
-  auto clock = timing::MakeSystemMasterClock(epoch_us, 0.0);
-
-  playout::PlayoutControlImpl service(metrics, clock);
+  if (args.metrics_port > 0 && !metrics->Start())
+  {
+    std::cerr << "[timing_soak] cannot serve metrics on port " << args.metrics_port << std::endl;
+  }
 
+  std::shared_ptr<timing::DeadlineScheduler> scheduler;
+  if (args.timer_threads > 0)
+  {
+    timing::DeadlineScheduler::Config timer_config;
+    timer_config.threads = static_cast<size_t>(args.timer_threads);
+    scheduler = std::make_shared<timing::DeadlineScheduler>(timer_config);
+    scheduler->Start();
+  }
+  std::shared_ptr<runtime::TaskExecutor> executor;
+  if (args.executor_threads != 0)
+  {
+    if (!scheduler)
+    {
+      std::cerr << "[timing_soak] --executor-threads needs --timer-threads > 0" << std::endl;
+      return EXIT_FAILURE;
+    }
+    runtime::TaskExecutor::Config executor_config;
+    executor_config.workers =
+        args.executor_threads > 0 ? static_cast<size_t>(args.executor_threads) : 0;
+    executor = std::make_shared<runtime::TaskExecutor>(executor_config, scheduler);
+    executor->Start();
+  }
   // Spin CPU stressor if requested.
   std::atomic<bool> stop_stress{false};
   std::thread stress_thread;
@@ -132,94 +430,120 @@ int main(int argc, char **argv)
       } });
   }
 
-  // Start channel using the public gRPC implementation.
-  grpc::ServerContext ctx;
-  playout::StartChannelRequest req;
-  playout::StartChannelResponse resp;
-  req.set_channel_id(args.channel_id);
-  req.set_plan_handle(args.asset_uri);
-  req.set_port(0);
-  auto status = service.StartChannel(&ctx, &req, &resp);
-  if (!status.ok())
+  std::vector<int> stage_sizes;
+  if (args.ramp_step > 0)
+  {
+    for (int n = args.ramp_step; n <= args.channels; n += args.ramp_step)
+    {
+      stage_sizes.push_back(n);
+    }
+  }
+  if (stage_sizes.empty())
   {
-    std::cerr << "Failed to start channel: " << status.error_message() << std::endl;
-    stop_stress.store(true);
-    if (stress_thread.joinable())
-      stress_thread.join();
-    return EXIT_FAILURE;
+    stage_sizes.push_back(args.channels);
   }
 
-  std::vector<double> window_gaps;
-  window_gaps.reserve(kWindowSeconds * 60);
-  std::vector<uint64_t> correction_samples;
-  correction_samples.reserve(kWindowSeconds);
-
-  const auto start_time = std::chrono::steady_clock::now();
-  auto last_sample = start_time;
-
-  while (std::chrono::steady_clock::now() - start_time <
-         std::chrono::seconds(args.duration_seconds))
+  std::vector<SoakChannel> running;
+  const size_t numa_nodes = runtime::NumaNodeCpus().size();
+  std::vector<StageResult> stages;
+  int max_sustained = 0;
+  for (const int target : stage_sizes)
   {
-    telemetry::ChannelMetrics metrics_snapshot{};
-    if (!metrics->GetChannelMetrics(args.channel_id, metrics_snapshot))
+    StageResult stage;
+    stage.channels = target;
+    while (static_cast<int>(running.size()) < target)
     {
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
-      continue;
+      const auto epoch_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count() +
+                            kScheduleLeadUs;
+      SoakChannel channel;
+      channel.id = args.channel_base + static_cast<int32_t>(running.size());
+      channel.engine = std::make_unique<runtime::PlayoutEngine>(
+          metrics,
+          timing::MakeSystemMasterClock(epoch_us, 0.0, timing::kDefaultWaitSpinUs, scheduler),
+          runtime::DecodeThreadBudget(), 0, executor);
+      const int32_t id = channel.id;
+      // Each channel has its own engine, so pack here rather than by policy
+      runtime::ChannelPlacement placement;
+      placement.pacing_priority = args.pacing_priority;
+      if (args.numa_pack)
+      {
+        placement.numa_node = static_cast<int>(running.size() % numa_nodes);
+      }
+      runtime::ChannelBufferOptions buffer;
+      buffer.latency_ms = args.buffer_latency_ms;
+      const auto result =
+          channel.engine->StartChannel(id, args.asset_uri, 0, std::nullopt, placement, buffer);
+      if (!result.success)
+      {
+        std::cerr << "[timing_soak] failed to start channel " << id << ": " << result.message
+                  << std::endl;
+        stage.started = false;
+        break;
+      }
+      running.push_back(std::move(channel));
+    }
+    if (!stage.started)
+    {
+      stages.push_back(stage);
+      break;
     }
 
-    window_gaps.push_back(std::abs(metrics_snapshot.frame_gap_seconds * 1'000.0));
-    correction_samples.push_back(metrics_snapshot.corrections_total);
-
-    if (window_gaps.size() > static_cast<size_t>(kWindowSeconds * 60))
+    std::this_thread::sleep_for(std::chrono::seconds(args.warmup_seconds));
+    const Baseline baseline = TakeBaseline(running);
+    for (int elapsed = 0; elapsed < args.duration_seconds;)
     {
-      window_gaps.erase(window_gaps.begin());
+      const int step = std::min(kProgressIntervalSeconds, args.duration_seconds - elapsed);
+      std::this_thread::sleep_for(std::chrono::seconds(step));
+      elapsed += step;
+      if (elapsed < args.duration_seconds)
+      {
+        const StageResult progress = Measure(running, baseline, args.slo_p999_ms);
+        std::cout << "[timing_soak] channels=" << target << " t=" << elapsed
+                  << "s pacing_p999_ms=" << progress.pacing.p999_ms
+                  << " process_cpu_pct=" << progress.process_cpu_percent << std::endl;
+      }
     }
-    if (correction_samples.size() > static_cast<size_t>(kWindowSeconds))
+    stage = Measure(running, baseline, args.slo_p999_ms);
+    PrintStage(stage);
+    stages.push_back(stage);
+    if (!stage.pass)
     {
-      correction_samples.erase(correction_samples.begin());
+      break;
     }
+    max_sustained = target;
+  }
 
-    const double mean_gap = Mean(window_gaps);
-    const double p95_gap = P95(window_gaps);
-    const double corrections_per_sec =
-        (correction_samples.size() > 1)
-            ? static_cast<double>(correction_samples.back() -
-                                  correction_samples.front()) /
-                  static_cast<double>(correction_samples.size() - 1)
-            : 0.0;
-
-    std::cout << "[timing_soak] mean_gap_ms=" << mean_gap
-              << " p95_gap_ms=" << p95_gap
-              << " corrections_recent_per_sec=" << corrections_per_sec << std::endl;
+  stop_stress.store(true);
+  if (stress_thread.joinable())
+    stress_thread.join();
+  for (SoakChannel &channel : running)
+  {
+    channel.engine->StopChannel(channel.id);
+  }
+  running.clear();
+  if (executor)
+    executor->Stop();
+  if (scheduler)
+    scheduler->Stop();
+  if (args.metrics_port > 0)
+    metrics->Stop();
 
-    if (p95_gap > kMaxGapP95Ms || corrections_per_sec > kMaxCorrectionsPerSec)
+  if (!args.report_path.empty())
+  {
+    std::ofstream report(args.report_path);
+    if (!report)
     {
-      std::cerr << "[timing_soak] threshold exceeded, aborting" << std::endl;
-      stop_stress.store(true);
-      if (stress_thread.joinable())
-        stress_thread.join();
-      grpc::ServerContext stop_ctx;
-      playout::StopChannelRequest stop_req;
-      playout::StopChannelResponse stop_resp;
-      stop_req.set_channel_id(args.channel_id);
-      service.StopChannel(&stop_ctx, &stop_req, &stop_resp);
-
+      std::cerr << "[timing_soak] cannot write report to " << args.report_path << std::endl;
       return EXIT_FAILURE;
     }
-
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    last_sample = std::chrono::steady_clock::now();
+    WriteReport(report, args, stages, max_sustained);
   }
 
-  stop_stress.store(true);
-  if (stress_thread.joinable())
-    stress_thread.join();
-  grpc::ServerContext stop_ctx;
-  playout::StopChannelRequest stop_req;
-  playout::StopChannelResponse stop_resp;
-  stop_req.set_channel_id(args.channel_id);
-  service.StopChannel(&stop_ctx, &stop_req, &stop_resp);
-
-  std::cout << "[timing_soak] completed successfully" << std::endl;
-  return EXIT_SUCCESS;
+  std::cout << "[timing_soak] max_sustained_channels=" << max_sustained << std::endl;
+  // A ramp succeeds once any stage passed; a fixed run must pass its stage
+  const bool ok = args.ramp_step > 0 ? max_sustained > 0 : (!stages.empty() && stages.back().pass);
+  std::cout << "[timing_soak] " << (ok ? "completed successfully" : "SLO not met") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }